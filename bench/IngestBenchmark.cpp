@@ -0,0 +1,718 @@
+#include "IngestBenchmark.h"
+#include "SyntheticCorpus.h"
+#include "core/ExifToolDaemon.h"
+#include "core/FilterCriteria.h"
+#include "core/LibraryScanner.h"
+#include "core/MetadataIndex.h"
+#include "core/MetadataService.h"
+#include "core/PhotoDatabase.h"
+#include "core/ThumbnailCache.h"
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSysInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sys/resource.h>
+
+namespace PhotoGuru {
+
+namespace {
+
+const QStringList HEIF_EXTENSIONS = {"heic", "heif"};
+const QStringList RAW_EXTENSIONS = {"cr2", "nef", "arw", "dng"};
+
+double elapsedMs(const QElapsedTimer& timer) {
+    return timer.nsecsElapsed() / 1e6;
+}
+
+// Little-endian TIFF with IFD0 (camera), the EXIF IFD and a GPS IFD,
+// enough for ExifFastReader and ExifTool to fill what
+// SyntheticCorpus::photos() generated. Tags are written in ascending order.
+class ExifBlock {
+public:
+    void ascii(quint16 tag, const QByteArray& text) { add(tag, 2, text.size() + 1, text + '\0'); }
+    void shortValue(quint16 tag, quint16 v) { add(tag, 3, 1, u16(v)); }
+    void rational(quint16 tag, double v, quint32 den = 1000, bool isSigned = false) {
+        add(tag, isSigned ? 10 : 5, 1, u32(quint32(qint32(std::lround(v * den)))) + u32(den));
+    }
+    void degrees(quint16 tag, double v) {
+        const double a = std::abs(v);
+        const double minutes = (a - std::floor(a)) * 60.0;
+        add(tag, 5, 3, u32(quint32(a)) + u32(1) + u32(quint32(minutes)) + u32(1) +
+                       u32(quint32(std::lround((minutes - std::floor(minutes)) * 60000))) + u32(1000));
+    }
+
+    // Starts the next IFD (EXIF, then GPS)
+    void nextIfd() { m_ifds.append(QVector<Tag>()); }
+
+    QByteArray build() const {
+        auto ifdSize = [](int entries) { return quint32(2 + 12 * entries + 4); };
+        // IFD0 gets pointers to the EXIF and GPS IFDs
+        QVector<Tag> ifd0 = m_ifds[0];
+        const quint32 exifAt = 8 + ifdSize(ifd0.size() + 2);
+        const quint32 gpsAt = exifAt + ifdSize(m_ifds[1].size());
+        const quint32 dataAt = gpsAt + ifdSize(m_ifds[2].size());
+        ifd0.append({0x8769, 4, 1, u32(exifAt)});
+        ifd0.append({0x8825, 4, 1, u32(gpsAt)});
+
+        QByteArray out("II*\0", 4);
+        out += u32(8);
+        QByteArray data;
+        for (const QVector<Tag>& tags : {ifd0, m_ifds[1], m_ifds[2]}) {
+            out += u16(quint16(tags.size()));
+            for (const Tag& t : tags) {
+                out += u16(t.tag) + u16(t.type) + u32(t.count);
+                if (t.value.size() <= 4) {
+                    out += t.value + QByteArray(4 - t.value.size(), '\0');
+                } else {
+                    out += u32(dataAt + quint32(data.size()));
+                    data += t.value;
+                    if (data.size() % 2) data += '\0';
+                }
+            }
+            out += u32(0);
+        }
+        return out + data;
+    }
+
+private:
+    struct Tag {
+        quint16 tag;
+        quint16 type;
+        quint32 count;
+        QByteArray value;
+    };
+
+    static QByteArray u16(quint16 v) { QByteArray b(2, '\0'); qToLittleEndian(v, b.data()); return b; }
+    static QByteArray u32(quint32 v) { QByteArray b(4, '\0'); qToLittleEndian(v, b.data()); return b; }
+
+    void add(quint16 tag, quint16 type, int count, const QByteArray& value) {
+        m_ifds.last().append({tag, type, quint32(count), value});
+    }
+
+    QVector<QVector<Tag>> m_ifds{QVector<Tag>()};
+};
+
+QByteArray exifFor(const PhotoMetadata& photo) {
+    ExifBlock exif;
+    exif.ascii(0x010F, photo.camera_make.toUtf8());
+    exif.ascii(0x0110, photo.camera_model.toUtf8());
+
+    exif.nextIfd();
+    exif.rational(0x829D, photo.aperture, 10);
+    exif.shortValue(0x8827, quint16(photo.iso));
+    exif.ascii(0x9003, photo.datetime_original.toString("yyyy:MM:dd hh:mm:ss").toLatin1());
+    exif.rational(0x9201, -std::log2(photo.shutter_speed), 1000, true);  // APEX
+    exif.rational(0x920A, photo.focal_length, 1);
+
+    exif.nextIfd();
+    if (photo.gps_lat != 0.0 || photo.gps_lon != 0.0) {
+        exif.ascii(0x0001, photo.gps_lat < 0 ? "S" : "N");
+        exif.degrees(0x0002, photo.gps_lat);
+        exif.ascii(0x0003, photo.gps_lon < 0 ? "W" : "E");
+        exif.degrees(0x0004, photo.gps_lon);
+    }
+    return exif.build();
+}
+
+QByteArray xmpFor(const PhotoMetadata& photo) {
+    auto escaped = [](const QString& text) { return text.toHtmlEscaped().toUtf8(); };
+    QByteArray subjects;
+    for (const QString& keyword : photo.llm_keywords) {
+        subjects += "<rdf:li>" + escaped(keyword) + "</rdf:li>";
+    }
+    return "<?xpacket begin=\"\xEF\xBB\xBF\" id=\"W5M0MpCehiHzreSzNTczkc9d\"?>"
+           "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+           "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+           "<rdf:Description rdf:about=\"\" xmlns:xmp=\"http://ns.adobe.com/xap/1.0/\""
+           " xmlns:dc=\"http://purl.org/dc/elements/1.1/\""
+           " xmlns:photoshop=\"http://ns.adobe.com/photoshop/1.0/\""
+           " xmp:Rating=\"" + QByteArray::number(photo.rating) + "\""
+           " photoshop:City=\"" + escaped(photo.location_name) + "\">"
+           "<photoshop:Category>" + escaped(photo.llm_category) + "</photoshop:Category>"
+           "<dc:title><rdf:Alt><rdf:li xml:lang=\"x-default\">" + escaped(photo.llm_title) +
+           "</rdf:li></rdf:Alt></dc:title>"
+           "<dc:subject><rdf:Bag>" + subjects + "</rdf:Bag></dc:subject>"
+           "</rdf:Description></rdf:RDF></x:xmpmeta>"
+           "<?xpacket end=\"w\"?>";
+}
+
+QByteArray app1(const QByteArray& signature, const QByteArray& payload) {
+    QByteArray length(2, '\0');
+    qToBigEndian(quint16(signature.size() + payload.size() + 2), length.data());
+    return QByteArray("\xFF\xE1", 2) + length + signature + payload;
+}
+
+// `frame` (a JPEG from QImage) with the photo's EXIF and XMP after its APP0
+QByteArray jpegFor(const QByteArray& frame, const PhotoMetadata& photo) {
+    int insertAt = 2;
+    if (frame.size() > 6 && uchar(frame[2]) == 0xFF && uchar(frame[3]) == 0xE0) {
+        insertAt = 4 + qFromBigEndian<quint16>(frame.constData() + 4);
+    }
+    return frame.left(insertAt) +
+           app1(QByteArray("Exif\0\0", 6), exifFor(photo)) +
+           app1(QByteArray("http://ns.adobe.com/xap/1.0/\0", 29), xmpFor(photo)) +
+           frame.mid(insertAt);
+}
+
+// Copies of one original must not share FileFingerprint::quick() (which
+// samples the tail), or caches would reuse each other's work. Decoders
+// ignore bytes past the end of a JPEG or TIFF; BMFF gets a free box.
+QByteArray uniqueTrailer(const QString& extension, int index) {
+    QByteArray tag = "photoguru-ingest-bench " + QByteArray::number(index);
+    if (!HEIF_EXTENSIONS.contains(extension)) return tag;
+    QByteArray size(4, '\0');
+    qToBigEndian(quint32(tag.size() + 8), size.data());
+    return size + "free" + tag;
+}
+
+QList<FilterCriteria> filterQueries() {
+    QList<FilterCriteria> queries;
+    FilterCriteria rated;
+    rated.minRating = 3;
+    queries << rated;
+
+    FilterCriteria text;
+    text.searchText = "sunset";
+    queries << text;
+
+    FilterCriteria camera;
+    camera.cameras = {"Canon EOS R5"};
+    queries << camera;
+
+    FilterCriteria year;
+    year.startDate = QDateTime(QDate(2019, 1, 1), QTime(0, 0));
+    year.endDate = QDateTime(QDate(2019, 12, 31), QTime(23, 59));
+    queries << year;
+
+    FilterCriteria nearby;
+    nearby.geoRadius = GeoCircle{38.72, -9.14, 25000.0};
+    queries << nearby;
+
+    FilterCriteria combined;
+    combined.minRating = 2;
+    combined.keywords = {"beach"};
+    combined.maxISO = 800;
+    queries << combined;
+    return queries;
+}
+
+QJsonObject findByName(const QJsonArray& array, const QString& name) {
+    for (const QJsonValue& value : array) {
+        if (value.toObject()["name"].toString() == name) return value.toObject();
+    }
+    return QJsonObject();
+}
+
+} // namespace
+
+double IngestBenchmark::Stage::imagesPerSecond() const {
+    return wallMs > 0.0 ? images * 1000.0 / wallMs : 0.0;
+}
+
+double IngestBenchmark::Stage::percentile(double p) const {
+    if (samplesMs.isEmpty()) return 0.0;
+    QVector<double> sorted = samplesMs;
+    const int rank = qBound(0, int(std::ceil(p / 100.0 * sorted.size())) - 1, int(sorted.size()) - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+QJsonObject IngestBenchmark::Stage::toJson() const {
+    return QJsonObject{
+        {"name", name},
+        {"images", images},
+        {"failed", failed},
+        {"wall_ms", wallMs},
+        {"images_per_second", imagesPerSecond()},
+        {"samples", int(samplesMs.size())},
+        {"p50_ms", percentile(50)},
+        {"p99_ms", percentile(99)}
+    };
+}
+
+std::optional<IngestBenchmark::Options> IngestBenchmark::parseArguments(const QStringList& arguments,
+                                                                        QString* message,
+                                                                        bool* helpRequested) {
+    if (helpRequested) *helpRequested = false;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Folder-open benchmark: scan, metadata preload, thumbnails and filter over a fixed corpus.");
+    QCommandLineOption helpOption = parser.addHelpOption();
+
+    QCommandLineOption corpusOption("corpus", "Corpus directory, reused across runs "
+        "(default: <temp>/photoguru-ingest-<mix>-<count>).", "dir");
+    QCommandLineOption countOption("count", "Files in the corpus (default: 1000).", "n");
+    QCommandLineOption mixOption("mix", "jpeg, or mixed: 60% JPEG, 40% HEIC/raw copies from --samples "
+        "(default: jpeg).", "mix");
+    QCommandLineOption samplesOption("samples", "HEIC and CR2/NEF/ARW/DNG originals for --mix mixed.", "dir");
+    QCommandLineOption passesOption("passes", "1 = cold only, 2 = cold then warm reopen (default: 2).", "n");
+    QCommandLineOption thumbnailOption("thumbnail-size", "Thumbnail edge in pixels (default: 150).", "px");
+    QCommandLineOption outputOption({"o", "output"}, "Write the JSON report here (default: stdout).", "file");
+    QCommandLineOption baselineOption("baseline", "Earlier report to compare against; "
+        "exit code 2 on regression.", "file");
+    QCommandLineOption toleranceOption("tolerance", "Allowed relative change against the baseline "
+        "(default: 0.10).", "fraction");
+    parser.addOptions({corpusOption, countOption, mixOption, samplesOption, passesOption,
+                       thumbnailOption, outputOption, baselineOption, toleranceOption});
+
+    if (!parser.parse(arguments)) {
+        *message = parser.errorText();
+        return std::nullopt;
+    }
+    if (parser.isSet(helpOption)) {
+        *message = parser.helpText();
+        if (helpRequested) *helpRequested = true;
+        return std::nullopt;
+    }
+
+    Options options;
+    auto positive = [&](const QCommandLineOption& option, int minimum, int* value) {
+        if (!parser.isSet(option)) return true;
+        bool ok = false;
+        *value = parser.value(option).toInt(&ok);
+        if (!ok || *value < minimum) {
+            *message = QString("--%1 expects a number of at least %2").arg(option.names().last()).arg(minimum);
+            return false;
+        }
+        return true;
+    };
+    if (!positive(countOption, 1, &options.count) ||
+        !positive(passesOption, 1, &options.passes) ||
+        !positive(thumbnailOption, 16, &options.thumbnailSize)) {
+        return std::nullopt;
+    }
+    if (options.passes > 2) {
+        *message = "--passes is 1 or 2";
+        return std::nullopt;
+    }
+
+    options.mix = parser.value(mixOption).isEmpty() ? options.mix : parser.value(mixOption).toLower();
+    if (options.mix != "jpeg" && options.mix != "mixed") {
+        *message = "--mix is jpeg or mixed";
+        return std::nullopt;
+    }
+    options.samplesDir = parser.value(samplesOption);
+    if (options.mix == "mixed" && options.samplesDir.isEmpty()) {
+        *message = "--mix mixed needs --samples";
+        return std::nullopt;
+    }
+
+    if (parser.isSet(toleranceOption)) {
+        bool ok = false;
+        options.tolerance = parser.value(toleranceOption).toDouble(&ok);
+        if (!ok || options.tolerance < 0.0) {
+            *message = "--tolerance expects a non-negative fraction";
+            return std::nullopt;
+        }
+    }
+
+    options.corpusDir = parser.value(corpusOption);
+    options.outputPath = parser.value(outputOption);
+    options.baselinePath = parser.value(baselineOption);
+    return options;
+}
+
+IngestBenchmark::IngestBenchmark(const Options& options)
+    : m_options(options)
+    , m_log(stderr)
+{
+}
+
+QString IngestBenchmark::corpusDir() const {
+    if (!m_options.corpusDir.isEmpty()) return QDir(m_options.corpusDir).absolutePath();
+    return QDir::temp().filePath(QString("photoguru-ingest-%1-%2").arg(m_options.mix).arg(m_options.count));
+}
+
+QJsonObject IngestBenchmark::manifest() const {
+    QJsonArray samples;
+    if (m_options.mix == "mixed") {
+        QStringList names = QDir(m_options.samplesDir).entryList(QDir::Files, QDir::Name);
+        for (const QString& name : names) samples << name;
+    }
+    return QJsonObject{
+        {"version", CORPUS_VERSION},
+        {"count", m_options.count},
+        {"mix", m_options.mix},
+        {"frame", QString("%1x%2").arg(frameSize().width()).arg(frameSize().height())},
+        {"samples", samples}
+    };
+}
+
+bool IngestBenchmark::prepareCorpus(QString* error) {
+    const QDir dir(corpusDir());
+    const QJsonObject expected = manifest();
+
+    QFile manifestFile(dir.filePath("corpus.json"));
+    if (manifestFile.open(QIODevice::ReadOnly) &&
+        QJsonDocument::fromJson(manifestFile.readAll()).object() == expected) {
+        return true;
+    }
+    manifestFile.close();
+
+    // HEIC and raw originals, split so both kinds appear in a mixed corpus
+    QStringList heifSamples;
+    QStringList rawSamples;
+    if (m_options.mix == "mixed") {
+        const QDir samples(m_options.samplesDir);
+        for (const QString& name : samples.entryList(QDir::Files, QDir::Name)) {
+            const QString extension = QFileInfo(name).suffix().toLower();
+            if (HEIF_EXTENSIONS.contains(extension)) heifSamples << samples.filePath(name);
+            if (RAW_EXTENSIONS.contains(extension)) rawSamples << samples.filePath(name);
+        }
+        if (heifSamples.isEmpty() && rawSamples.isEmpty()) {
+            *error = "No HEIC or CR2/NEF/ARW/DNG files in " + m_options.samplesDir;
+            return false;
+        }
+        if (heifSamples.isEmpty()) heifSamples = rawSamples;
+        if (rawSamples.isEmpty()) rawSamples = heifSamples;
+    }
+
+    m_log << "corpus: writing " << m_options.count << " files to " << dir.path() << Qt::endl;
+    QDir(dir.filePath("DCIM")).removeRecursively();
+    if (!dir.mkpath("DCIM")) {
+        *error = "Cannot create " + dir.filePath("DCIM");
+        return false;
+    }
+
+    QVector<QByteArray> frames;
+    for (int variant = 0; variant < FRAME_VARIANTS; variant++) {
+        QByteArray bytes;
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::WriteOnly);
+        SyntheticCorpus::pattern(frameSize(), variant).save(&buffer, "JPEG", 90);
+        frames << bytes;
+    }
+
+    const QList<PhotoMetadata> photos = SyntheticCorpus::photos(m_options.count);
+    for (int i = 0; i < m_options.count; i++) {
+        const QString folder = QString("DCIM/%1PHOTO").arg(100 + i / FILES_PER_FOLDER);
+        dir.mkpath(folder);
+
+        // Mixed: two files in five are HEIC/raw originals
+        const QStringList* samples = nullptr;
+        if (m_options.mix == "mixed" && i % 5 == 3) samples = &heifSamples;
+        if (m_options.mix == "mixed" && i % 5 == 4) samples = &rawSamples;
+
+        QByteArray bytes;
+        QString extension = "jpg";
+        if (samples) {
+            const QString source = (*samples)[(i / 5) % samples->size()];
+            QFile original(source);
+            if (!original.open(QIODevice::ReadOnly)) {
+                *error = "Cannot read " + source;
+                return false;
+            }
+            extension = QFileInfo(source).suffix().toLower();
+            bytes = original.readAll() + uniqueTrailer(extension, i);
+        } else {
+            bytes = jpegFor(frames[i % FRAME_VARIANTS], photos[i]);
+        }
+
+        QFile file(dir.filePath(QString("%1/IMG_%2.%3").arg(folder).arg(i, 6, 10, QChar('0')).arg(extension.toUpper())));
+        if (!file.open(QIODevice::WriteOnly) || file.write(bytes) != bytes.size()) {
+            *error = "Cannot write " + file.fileName();
+            return false;
+        }
+    }
+
+    // Written last: an interrupted run regenerates
+    if (!manifestFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        *error = "Cannot write " + manifestFile.fileName();
+        return false;
+    }
+    manifestFile.write(QJsonDocument(expected).toJson());
+    return true;
+}
+
+int IngestBenchmark::run() {
+    QString error;
+    if (!prepareCorpus(&error)) {
+        m_log << "corpus: " << error << Qt::endl;
+        return 1;
+    }
+
+    // Cold start: stores from an earlier run would serve this one
+    const QDir dir(corpusDir());
+    QFile::remove(dir.filePath("catalog.db"));
+    QFile::remove(dir.filePath("thumbnails.pack"));
+    if (!PhotoDatabase::instance().initialize(dir.filePath("catalog.db"))) {
+        m_log << "catalog: cannot open " << dir.filePath("catalog.db") << Qt::endl;
+        return 1;
+    }
+    // Running before the folder opens, as in the viewer
+    if (!ExifToolDaemon::instance().start()) {
+        m_log << "exiftool: not available, files the fast reader can't parse will fail" << Qt::endl;
+    }
+
+    QJsonArray passes;
+    const QStringList passNames = {"cold", "warm"};
+    for (int pass = 0; pass < m_options.passes; pass++) {
+        QElapsedTimer timer;
+        timer.start();
+        const QVector<Stage> stages = runPass(passNames[pass]);
+        const double wallMs = elapsedMs(timer);
+
+        QJsonArray stageArray;
+        for (const Stage& stage : stages) stageArray << stage.toJson();
+        const int images = stages.isEmpty() ? 0 : stages.first().images;
+        passes << QJsonObject{
+            {"name", passNames[pass]},
+            {"images", images},
+            {"wall_ms", wallMs},
+            {"images_per_second", wallMs > 0.0 ? images * 1000.0 / wallMs : 0.0},
+            {"stages", stageArray}
+        };
+    }
+
+    m_report = QJsonObject{
+        {"corpus", manifest()},
+        {"machine", QJsonObject{
+            {"os", QSysInfo::prettyProductName()},
+            {"cpu", QSysInfo::currentCpuArchitecture()},
+            {"threads", QThread::idealThreadCount()}
+        }},
+        {"passes", passes},
+        {"peak_rss_bytes", double(peakRssBytes())}
+    };
+
+    const QByteArray json = QJsonDocument(m_report).toJson();
+    if (m_options.outputPath.isEmpty()) {
+        QTextStream(stdout) << json;
+    } else {
+        QFile output(m_options.outputPath);
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate) || output.write(json) != json.size()) {
+            m_log << "report: cannot write " << m_options.outputPath << Qt::endl;
+            return 1;
+        }
+    }
+
+    if (m_options.baselinePath.isEmpty()) return 0;
+    QFile baselineFile(m_options.baselinePath);
+    if (!baselineFile.open(QIODevice::ReadOnly)) {
+        m_log << "baseline: cannot read " << m_options.baselinePath << Qt::endl;
+        return 1;
+    }
+    const QStringList found = regressions(m_report, QJsonDocument::fromJson(baselineFile.readAll()).object(),
+                                          m_options.tolerance);
+    for (const QString& line : found) m_log << "regression: " << line << Qt::endl;
+    return found.isEmpty() ? 0 : 2;
+}
+
+QVector<IngestBenchmark::Stage> IngestBenchmark::runPass(const QString& name) {
+    // Reopening the pack drops the memory tier, like a fresh viewer
+    ThumbnailCache::instance().setDiskLocation(QDir(corpusDir()).filePath("thumbnails.pack"));
+    MetadataService service;
+
+    QVector<Stage> stages;
+    QStringList files;
+    stages << scan(&files);
+    stages << metadata(service, files);
+    stages << thumbnails(files);
+    stages << filter(service, files);
+
+    for (const Stage& stage : stages) {
+        m_log << name << "/" << stage.name << ": " << stage.images << " images, "
+              << qRound(stage.imagesPerSecond()) << " images/s, p50 " << stage.percentile(50)
+              << " ms, p99 " << stage.percentile(99) << " ms";
+        if (stage.failed > 0) m_log << ", " << stage.failed << " failed";
+        m_log << Qt::endl;
+    }
+    return stages;
+}
+
+IngestBenchmark::Stage IngestBenchmark::scan(QStringList* files) {
+    Stage stage;
+    stage.name = "scan";
+
+    LibraryScanner scanner;
+    QEventLoop loop;
+    QElapsedTimer timer;
+    double lastChunk = 0.0;
+    QObject::connect(&scanner, &LibraryScanner::filesFound, &loop, [&](const QStringList& paths) {
+        const double now = elapsedMs(timer);
+        stage.samplesMs << now - lastChunk;
+        lastChunk = now;
+        *files << paths;
+    });
+    QObject::connect(&scanner, &LibraryScanner::finished, &loop, &QEventLoop::quit);
+
+    timer.start();
+    scanner.start({QDir(corpusDir()).filePath("DCIM")});
+    loop.exec();
+    stage.wallMs = elapsedMs(timer);
+
+    // In folder order, as the grid shows them
+    files->sort();
+    stage.images = int(files->size());
+    return stage;
+}
+
+IngestBenchmark::Stage IngestBenchmark::metadata(MetadataService& service, const QStringList& files) {
+    Stage stage;
+    stage.name = "metadata";
+    stage.images = int(files.size());
+
+    QFutureWatcher<void> watcher;
+    QEventLoop loop;
+    QElapsedTimer timer;
+    double lastStep = 0.0;
+    int lastValue = 0;
+    // Progress arrives per chunk (and is throttled); each image of a step
+    // gets the step's time per image
+    QObject::connect(&watcher, &QFutureWatcher<void>::progressValueChanged, &loop, [&](int value) {
+        if (value <= lastValue) return;
+        const double now = elapsedMs(timer);
+        const double perImage = (now - lastStep) / (value - lastValue);
+        for (int i = lastValue; i < value; i++) stage.samplesMs << perImage;
+        lastStep = now;
+        lastValue = value;
+    });
+    QObject::connect(&watcher, &QFutureWatcher<void>::finished, &loop, &QEventLoop::quit);
+
+    timer.start();
+    watcher.setFuture(service.preload(files));
+    loop.exec();
+    stage.wallMs = elapsedMs(timer);
+    stage.failed = stage.images - service.count();
+    return stage;
+}
+
+IngestBenchmark::Stage IngestBenchmark::thumbnails(const QStringList& files) {
+    Stage stage;
+    stage.name = "thumbnails";
+    stage.images = int(files.size());
+    stage.samplesMs.resize(files.size());
+
+    const QSize size(m_options.thumbnailSize, m_options.thumbnailSize);
+    QVector<int> indices(files.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    QAtomicInt failed{0};
+
+    double* samples = stage.samplesMs.data();  // One slot per image, no detach in the workers
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(THUMBNAIL_THREADS);
+    QElapsedTimer timer;
+    timer.start();
+    QtConcurrent::blockingMap(&pool, indices, [&](const int& index) {
+        QElapsedTimer one;
+        one.start();
+        if (ThumbnailCache::instance().thumbnailImage(files[index], size).isNull()) {
+            failed.fetchAndAddRelaxed(1);
+        }
+        samples[index] = elapsedMs(one);
+    });
+    stage.wallMs = elapsedMs(timer);
+    stage.failed = failed.loadRelaxed();
+    return stage;
+}
+
+IngestBenchmark::Stage IngestBenchmark::filter(const MetadataService& service, const QStringList& files) {
+    Stage stage;
+    stage.name = "filter";
+    stage.images = int(files.size());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // What MainWindow::rebuildMetadataIndex() does once the preload is in
+    const QHash<QString, PhotoHandle> snapshot = service.snapshot();
+    MetadataIndex index;
+    index.reserve(int(snapshot.size()));
+    for (auto it = snapshot.cbegin(); it != snapshot.cend(); ++it) {
+        index.upsert(*it.value());
+    }
+
+    for (const FilterCriteria& criteria : filterQueries()) {
+        for (int repeat = 0; repeat < FILTER_REPEATS; repeat++) {
+            QElapsedTimer one;
+            one.start();
+            const QStringList matched = index.filter(criteria, files);
+            stage.samplesMs << elapsedMs(one);
+        }
+    }
+    stage.wallMs = elapsedMs(timer);
+    stage.failed = stage.images - index.size();  // Files without metadata can't be filtered
+    return stage;
+}
+
+QStringList IngestBenchmark::regressions(const QJsonObject& current, const QJsonObject& baseline,
+                                         double tolerance) {
+    QStringList found;
+    if (current["corpus"] != baseline["corpus"]) {
+        found << "baseline ran on a different corpus; results are not comparable";
+        return found;
+    }
+
+    auto percent = [](double now, double before) {
+        return QString("%1%2%").arg(QString(now >= before ? "+" : "")).arg(qRound((now / before - 1.0) * 100.0));
+    };
+
+    const QJsonArray currentPasses = current["passes"].toArray();
+    for (const QJsonValue& passValue : baseline["passes"].toArray()) {
+        const QJsonObject basePass = passValue.toObject();
+        const QString passName = basePass["name"].toString();
+        const QJsonObject pass = findByName(currentPasses, passName);
+        if (pass.isEmpty()) continue;  // Fewer --passes this time
+
+        for (const QJsonValue& stageValue : basePass["stages"].toArray()) {
+            const QJsonObject baseStage = stageValue.toObject();
+            const QString name = passName + "/" + baseStage["name"].toString();
+            const QJsonObject stage = findByName(pass["stages"].toArray(), baseStage["name"].toString());
+            if (stage.isEmpty()) {
+                found << name + ": missing";
+                continue;
+            }
+
+            const double rate = stage["images_per_second"].toDouble();
+            const double baseRate = baseStage["images_per_second"].toDouble();
+            if (baseRate > 0.0 && rate < baseRate * (1.0 - tolerance)) {
+                found << QString("%1: %2 images/s, baseline %3 (%4)")
+                             .arg(name).arg(qRound(rate)).arg(qRound(baseRate)).arg(percent(rate, baseRate));
+            }
+
+            const double p99 = stage["p99_ms"].toDouble();
+            const double baseP99 = baseStage["p99_ms"].toDouble();
+            if (baseP99 > 0.0 && p99 > baseP99 * (1.0 + tolerance) && p99 - baseP99 > P99_SLACK_MS) {
+                found << QString("%1: p99 %2 ms, baseline %3 ms (%4)")
+                             .arg(name).arg(p99, 0, 'f', 2).arg(baseP99, 0, 'f', 2).arg(percent(p99, baseP99));
+            }
+        }
+    }
+
+    const double rss = current["peak_rss_bytes"].toDouble();
+    const double baseRss = baseline["peak_rss_bytes"].toDouble();
+    if (baseRss > 0.0 && rss > baseRss * (1.0 + tolerance)) {
+        found << QString("peak RSS %1 MB, baseline %2 MB (%3)")
+                     .arg(qRound(rss / 1048576)).arg(qRound(baseRss / 1048576)).arg(percent(rss, baseRss));
+    }
+    return found;
+}
+
+qint64 IngestBenchmark::peakRssBytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef Q_OS_MACOS
+    return qint64(usage.ru_maxrss);         // Bytes
+#else
+    return qint64(usage.ru_maxrss) * 1024;  // Kilobytes
+#endif
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <optional>
+
+namespace PhotoGuru {
+
+class MetadataService;
+
+/**
+ * @brief End-to-end folder-open benchmark (PhotoGuruIngestBench)
+ *
+ * Drives the core classes behind MainWindow::loadDirectory() over a
+ * fixed corpus, stage by stage:
+ *   scan       - LibraryScanner over the corpus tree
+ *   metadata   - MetadataService::preload() (catalog, then readCommon)
+ *   thumbnails - ThumbnailCache::thumbnailImage() on THUMBNAIL_THREADS
+ *   filter     - MetadataIndex built from the cache, then FILTER_QUERIES
+ *
+ * The corpus is written once into a directory and reused while its
+ * manifest matches, so runs on one machine compare across commits.
+ * "jpeg" generates every file (SyntheticCorpus frames with per-file EXIF
+ * and XMP); "mixed" makes 40% of it copies of the HEIC and CR2/NEF/ARW/DNG
+ * originals in --samples, each made unique so fingerprint reuse can't
+ * skip work. Catalog and thumbnail pack live in the corpus directory.
+ *
+ * The first pass runs cold (empty catalog and pack), a second one
+ * reopens the folder warm. Each stage reports images/s and p50/p99
+ * of its latency samples: per chunk for scan, per image within each
+ * progress step for metadata, per image for thumbnails, per query for
+ * filter. The report is JSON; against a baseline report, throughput
+ * drops and p99/peak RSS growth beyond the tolerance are regressions.
+ */
+class IngestBenchmark {
+public:
+    struct Options {
+        QString corpusDir;          // Empty = <temp>/photoguru-ingest-<mix>-<count>
+        int count = 1000;
+        QString mix = "jpeg";       // "jpeg" or "mixed"
+        QString samplesDir;         // HEIC and raw originals for "mixed"
+        int passes = 2;             // Cold, then warm
+        int thumbnailSize = 150;    // ThumbnailGrid's default cell
+        QString outputPath;         // Empty = stdout
+        QString baselinePath;
+        double tolerance = 0.10;
+    };
+
+    struct Stage {
+        QString name;
+        int images = 0;
+        int failed = 0;
+        double wallMs = 0.0;
+        QVector<double> samplesMs;
+
+        double imagesPerSecond() const;
+        double percentile(double p) const;  // Nearest rank, p in [0, 100]
+        QJsonObject toJson() const;
+    };
+
+    static std::optional<Options> parseArguments(const QStringList& arguments, QString* message,
+                                                 bool* helpRequested = nullptr);
+
+    explicit IngestBenchmark(const Options& options);
+
+    // Exit code: 0 done (and within the baseline), 1 couldn't run, 2 regressed
+    int run();
+
+    // Writes the corpus unless the directory already holds this one
+    bool prepareCorpus(QString* error);
+    QJsonObject report() const { return m_report; }
+
+    // Human-readable regressions of `current` against `baseline`; empty if none
+    static QStringList regressions(const QJsonObject& current, const QJsonObject& baseline,
+                                   double tolerance);
+
+    // Peak resident set size of this process so far
+    static qint64 peakRssBytes();
+
+    static QSize frameSize() { return QSize(1600, 1200); }  // Generated JPEGs
+
+    static constexpr int CORPUS_VERSION = 1;
+    static constexpr int FRAME_VARIANTS = 16;     // Distinct frames behind the generated JPEGs
+    static constexpr int FILES_PER_FOLDER = 250;  // Like a camera's DCIM folders
+    static constexpr int THUMBNAIL_THREADS = 4;   // Width of ThumbnailCache's pool
+    static constexpr int FILTER_REPEATS = 5;      // Runs of each filter query
+    static constexpr double P99_SLACK_MS = 1.0;   // p99 growth below this is noise
+
+private:
+    QVector<Stage> runPass(const QString& name);
+    Stage scan(QStringList* files);
+    Stage metadata(MetadataService& service, const QStringList& files);
+    Stage thumbnails(const QStringList& files);
+    Stage filter(const MetadataService& service, const QStringList& files);
+
+    QString corpusDir() const;
+    QJsonObject manifest() const;
+
+    Options m_options;
+    QJsonObject m_report;
+    QTextStream m_log;
+};
+
+} // namespace PhotoGuru
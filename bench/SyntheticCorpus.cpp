@@ -0,0 +1,193 @@
+#include "SyntheticCorpus.h"
+#include <QDebug>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace PhotoGuru {
+
+namespace {
+
+constexpr uint32_t SEED = 20240601;
+
+// std::mt19937's sequence is fixed by the standard; the float mapping is
+// done here so results don't depend on the library's distributions
+class Rng {
+public:
+    explicit Rng(uint32_t seed) : m_gen(seed) {}
+
+    // [0, 1) with 24 bits of precision
+    float uniform() { return float(m_gen() >> 8) * (1.0f / 16777216.0f); }
+    float uniform(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+    int below(int n) { return int(m_gen() % uint32_t(n)); }
+
+private:
+    std::mt19937 m_gen;
+};
+
+const QStringList CAMERAS = {
+    "Canon|Canon EOS R5", "Sony|ILCE-7M4", "NIKON CORPORATION|NIKON Z 6_2",
+    "FUJIFILM|X-T5", "Apple|iPhone 15 Pro", "Google|Pixel 8"
+};
+
+const QStringList KEYWORDS = {
+    "beach", "sunset", "family", "portrait", "mountain", "city", "night",
+    "food", "dog", "cat", "wedding", "snow", "forest", "street", "car",
+    "architecture", "concert", "birthday", "flowers", "lake"
+};
+
+const QStringList CATEGORIES = {"landscape", "portrait", "event", "street", "nature", "food"};
+
+const struct { const char* name; double lat; double lon; } PLACES[] = {
+    {"São Paulo", -23.55, -46.63}, {"Lisboa", 38.72, -9.14}, {"New York", 40.71, -74.01},
+    {"Tokyo", 35.68, 139.69}, {"Cape Town", -33.92, 18.42}, {"Reykjavík", 64.15, -21.94}
+};
+
+} // namespace
+
+SyntheticCorpus& SyntheticCorpus::instance() {
+    static SyntheticCorpus corpus;
+    return corpus;
+}
+
+QString SyntheticCorpus::image(const QString& format, const QSize& size) {
+    const QString key = QString("%1x%2.%3").arg(size.width()).arg(size.height()).arg(format);
+
+    QMutexLocker lock(&m_mutex);
+    auto it = m_images.constFind(key);
+    if (it != m_images.constEnd()) return it.value();
+
+    const QString path = QDir(m_dir.path()).filePath("corpus_" + key);
+    QString result;
+    if (m_dir.isValid() && pattern(size).save(path, nullptr, 90)) {
+        result = path;
+    } else {
+        qWarning() << "[SyntheticCorpus] Could not write" << path;
+    }
+    m_images.insert(key, result);
+    return result;
+}
+
+QImage SyntheticCorpus::pattern(const QSize& size, int variant) {
+    QImage image(size, QImage::Format_RGB32);
+    Rng rng(SEED + uint32_t(variant));
+    const int w = size.width();
+    const int h = size.height();
+
+    for (int y = 0; y < h; y++) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < w; x++) {
+            const int noise = rng.below(33) - 16;
+            const int r = x * 255 / w + noise;
+            const int g = y * 255 / h + noise;
+            const int b = int(127.5 + 127.5 * std::sin((x + y + 97 * variant) * 0.01)) + noise;
+            line[x] = qRgb(std::clamp(r, 0, 255), std::clamp(g, 0, 255), std::clamp(b, 0, 255));
+        }
+    }
+    return image;
+}
+
+QList<PhotoMetadata> SyntheticCorpus::photos(int count) {
+    QList<PhotoMetadata> result;
+    result.reserve(count);
+    Rng rng(SEED);
+    const QDateTime first(QDate(2015, 1, 1), QTime(0, 0));
+
+    for (int i = 0; i < count; i++) {
+        PhotoMetadata photo;
+        photo.filepath = QString("/corpus/%1/IMG_%2.jpg").arg(2015 + i % 10).arg(i, 6, 10, QChar('0'));
+        photo.filename = QString("IMG_%1.jpg").arg(i, 6, 10, QChar('0'));
+        photo.datetime_original = first.addSecs(qint64(rng.uniform() * 10 * 365 * 86400));
+
+        const QStringList camera = CAMERAS[rng.below(CAMERAS.size())].split('|');
+        photo.camera_make = camera[0];
+        photo.camera_model = camera[1];
+        photo.aperture = 1.4 * std::pow(1.4142, rng.below(8));
+        photo.shutter_speed = 1.0 / (30 << rng.below(7));
+        photo.iso = 100 << rng.below(7);
+        photo.focal_length = 16 + rng.below(185);
+
+        // Most photos geotagged, clustered around a few places
+        if (rng.uniform() < 0.7f) {
+            const auto& place = PLACES[rng.below(int(std::size(PLACES)))];
+            photo.gps_lat = place.lat + rng.uniform(-0.2f, 0.2f);
+            photo.gps_lon = place.lon + rng.uniform(-0.2f, 0.2f);
+            photo.location_name = place.name;
+        }
+
+        photo.rating = rng.below(6);
+        photo.llm_category = CATEGORIES[rng.below(CATEGORIES.size())];
+        photo.llm_title = QString("%1 %2").arg(photo.llm_category).arg(i);
+        for (int k = rng.below(6); k > 0; k--) {
+            photo.llm_keywords << KEYWORDS[rng.below(KEYWORDS.size())];
+        }
+
+        photo.technical.sharpness_score = rng.uniform();
+        photo.technical.exposure_quality = rng.uniform();
+        photo.technical.aesthetic_score = rng.uniform();
+        photo.technical.overall_quality = rng.uniform();
+        photo.technical.face_count = rng.below(4);
+        photo.technical.blur_detected = photo.technical.sharpness_score < 0.2;
+        result << photo;
+    }
+    return result;
+}
+
+std::vector<std::vector<float>> SyntheticCorpus::embeddings(int count, int dim) {
+    std::vector<std::vector<float>> result(count, std::vector<float>(dim));
+    Rng rng(SEED);
+    for (auto& embedding : result) {
+        float norm = 0.0f;
+        for (float& value : embedding) {
+            value = rng.uniform(-1.0f, 1.0f);
+            norm += value * value;
+        }
+        norm = std::sqrt(norm);
+        for (float& value : embedding) value /= norm;
+    }
+    return result;
+}
+
+QString SyntheticCorpus::exifToolJson(int keywords) {
+    QJsonArray subjects;
+    for (int i = 0; i < keywords; i++) subjects << KEYWORDS[i % KEYWORDS.size()];
+
+    QJsonObject technical{
+        {"sharp", 0.82}, {"expo", 0.71}, {"aesth", 0.64}, {"qual", 0.75},
+        {"dup", QJsonValue::Null}, {"burst", "B0001"}, {"burst_pos", 2},
+        {"burst_best", true}, {"faces", 3}, {"blur", false},
+        {"hi_clip", false}, {"lo_clip", true}
+    };
+
+    QJsonObject obj{
+        {"SourceFile", "/corpus/2023/IMG_000042.jpg"},
+        {"FileName", "IMG_000042.jpg"},
+        {"DateTimeOriginal", "2023:07:14 10:00:00"},
+        {"SubSecTimeOriginal", "250"},
+        {"Make", "Canon"},
+        {"Model", "Canon EOS R5"},
+        {"FNumber", 2.8},
+        {"ShutterSpeedValue", 0.004},
+        {"ISO", 400},
+        {"FocalLength", 50},
+        {"SequenceNumber", 3},
+        {"GPSLatitude", 38.7223},
+        {"GPSLongitude", -9.1393},
+        {"Rating", 4},
+        {"Title", "Morning at the beach"},
+        {"Description", "Waves at low tide under a clear sky"},
+        {"Subject", subjects},
+        {"Category", "landscape"},
+        {"City", "Lisboa"},
+        {"UserComment", "PhotoGuru:" + QString::fromUtf8(QJsonDocument(technical).toJson(QJsonDocument::Compact))}
+    };
+    return QString::fromUtf8(QJsonDocument(QJsonArray{obj}).toJson(QJsonDocument::Compact));
+}
+
+} // namespace PhotoGuru
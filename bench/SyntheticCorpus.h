@@ -0,0 +1,66 @@
+#pragma once
+
+#include "core/PhotoMetadata.h"
+#include <QString>
+#include <QSize>
+#include <QImage>
+#include <QHash>
+#include <QMutex>
+#include <QTemporaryDir>
+#include <cstdint>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Deterministic inputs for PhotoGuruBench
+ *
+ * Everything is generated from a fixed seed with a generator whose output
+ * the standard pins down (std::mt19937, mapped to floats by hand rather
+ * than through std distributions, which differ between standard
+ * libraries), so two machines or two commits benchmark the same bytes.
+ *
+ * Images are written once per run into a temporary directory and removed
+ * on exit; metadata, embeddings and ExifTool output live in memory.
+ */
+class SyntheticCorpus {
+public:
+    static SyntheticCorpus& instance();
+
+    // Standard sizes the image benchmarks run at
+    static QSize small() { return QSize(640, 480); }
+    static QSize medium() { return QSize(1920, 1080); }
+    static QSize large() { return QSize(4032, 3024); }
+
+    // Path of the corpus image with extension `format` ("jpg", "png",
+    // "tif") at `size`, written on first use. Empty if Qt can't encode it.
+    QString image(const QString& format, const QSize& size);
+
+    // Gradients plus seeded noise: compresses like a photo, not like a
+    // flat fill. Each `variant` is a different frame.
+    static QImage pattern(const QSize& size, int variant = 0);
+
+    // `count` photos with dates, cameras, exposure, GPS, ratings, keywords
+    // and technical scores spread like a real library
+    static QList<PhotoMetadata> photos(int count);
+
+    // `count` unit-length embeddings of `dim` floats
+    static std::vector<std::vector<float>> embeddings(int count, int dim = 512);
+
+    // One `exiftool -json -s -n` result as MetadataReader receives it,
+    // with `keywords` XMP subjects and a PhotoGuru UserComment block
+    static QString exifToolJson(int keywords = 8);
+
+    QString directory() const { return m_dir.path(); }
+
+private:
+    SyntheticCorpus() = default;
+    SyntheticCorpus(const SyntheticCorpus&) = delete;
+    SyntheticCorpus& operator=(const SyntheticCorpus&) = delete;
+
+    QTemporaryDir m_dir;
+    QHash<QString, QString> m_images;
+    QMutex m_mutex;
+};
+
+} // namespace PhotoGuru
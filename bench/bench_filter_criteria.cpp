@@ -0,0 +1,54 @@
+#include <benchmark/benchmark.h>
+#include "SyntheticCorpus.h"
+#include "core/FilterCriteria.h"
+
+using namespace PhotoGuru;
+
+namespace {
+
+FilterCriteria ratingAndExposure() {
+    FilterCriteria criteria;
+    criteria.minRating = 3;
+    criteria.minISO = 200;
+    criteria.maxAperture = 8.0;
+    return criteria;
+}
+
+FilterCriteria textSearch() {
+    FilterCriteria criteria;
+    criteria.searchText = "sunset";
+    return criteria;
+}
+
+FilterCriteria keywordsAndPlace() {
+    FilterCriteria criteria;
+    criteria.keywords = {"beach", "family"};
+    criteria.cameras = {"Canon EOS R5", "ILCE-7M4"};
+    criteria.geoRadius = GeoCircle{38.72, -9.14, 25000.0};
+    return criteria;
+}
+
+} // namespace
+
+// One full filter pass over a library of state.range(0) photos
+static void BM_FilterCriteriaMatches(benchmark::State& state, FilterCriteria (*make)()) {
+    const QList<PhotoMetadata> photos = SyntheticCorpus::photos(int(state.range(0)));
+    const FilterCriteria criteria = make();
+    int matched = 0;
+    for (auto _ : state) {
+        matched = 0;
+        for (const PhotoMetadata& photo : photos) {
+            matched += criteria.matches(photo);
+        }
+        benchmark::DoNotOptimize(matched);
+    }
+    state.SetItemsProcessed(state.iterations() * photos.size());
+    state.counters["matched"] = matched;
+}
+
+BENCHMARK_CAPTURE(BM_FilterCriteriaMatches, rating_exposure, ratingAndExposure)
+    ->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_FilterCriteriaMatches, text_search, textSearch)
+    ->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_FilterCriteriaMatches, keywords_place, keywordsAndPlace)
+    ->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMicrosecond);
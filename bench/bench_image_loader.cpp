@@ -0,0 +1,42 @@
+#include <benchmark/benchmark.h>
+#include "SyntheticCorpus.h"
+#include "core/ImageLoader.h"
+#include <QFileInfo>
+
+using namespace PhotoGuru;
+
+// ImageLoader::load per format and corpus size; maxSize > 0 bounds the
+// decode the way thumbnails and previews do
+static void BM_ImageLoaderLoad(benchmark::State& state, const char* format, QSize size, int maxSize) {
+    const QString path = SyntheticCorpus::instance().image(format, size);
+    if (path.isEmpty()) {
+        state.SkipWithError("Qt has no encoder for this format");
+        return;
+    }
+    const QSize bound = maxSize > 0 ? QSize(maxSize, maxSize) : QSize();
+
+    for (auto _ : state) {
+        auto image = ImageLoader::instance().load(path, bound);
+        if (!image) {
+            state.SkipWithError("ImageLoader::load failed");
+            return;
+        }
+        benchmark::DoNotOptimize(image->constBits());
+    }
+
+    state.SetBytesProcessed(state.iterations() * QFileInfo(path).size());
+    state.counters["Mpix"] = benchmark::Counter(
+        state.iterations() * double(size.width()) * size.height() / 1e6,
+        benchmark::Counter::kIsRate);
+}
+
+BENCHMARK_CAPTURE(BM_ImageLoaderLoad, jpg_small, "jpg", SyntheticCorpus::small(), 0)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ImageLoaderLoad, jpg_medium, "jpg", SyntheticCorpus::medium(), 0)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ImageLoaderLoad, jpg_large, "jpg", SyntheticCorpus::large(), 0)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ImageLoaderLoad, jpg_large_bounded, "jpg", SyntheticCorpus::large(), 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ImageLoaderLoad, png_small, "png", SyntheticCorpus::small(), 0)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ImageLoaderLoad, png_medium, "png", SyntheticCorpus::medium(), 0)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ImageLoaderLoad, png_large, "png", SyntheticCorpus::large(), 0)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ImageLoaderLoad, tif_small, "tif", SyntheticCorpus::small(), 0)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ImageLoaderLoad, tif_medium, "tif", SyntheticCorpus::medium(), 0)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ImageLoaderLoad, tif_large, "tif", SyntheticCorpus::large(), 0)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,61 @@
+#include <benchmark/benchmark.h>
+#include "SyntheticCorpus.h"
+#include "core/ExifToolDaemon.h"
+#include "core/PhotoMetadata.h"
+#include <QProcess>
+#include <QStandardPaths>
+
+using namespace PhotoGuru;
+
+// Smallest daemon round trip: one -ver through a warm process
+static void BM_ExifToolDaemonRoundTrip(benchmark::State& state) {
+    if (!ExifToolDaemon::instance().start()) {
+        state.SkipWithError("exiftool not available");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ExifToolDaemon::instance().executeCommand({"-ver"}));
+    }
+}
+BENCHMARK(BM_ExifToolDaemonRoundTrip)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// What every MetadataService read sends: the FilterSet tags of one file
+static void BM_ExifToolDaemonReadFile(benchmark::State& state) {
+    const QString path = SyntheticCorpus::instance().image("jpg", SyntheticCorpus::small());
+    if (path.isEmpty() || !ExifToolDaemon::instance().start()) {
+        state.SkipWithError("exiftool or corpus image not available");
+        return;
+    }
+    QStringList args = MetadataReader::tagArguments(MetadataReader::FilterSet);
+    args << path;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ExifToolDaemon::instance().executeCommand(args));
+    }
+}
+BENCHMARK(BM_ExifToolDaemonReadFile)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// Baseline the daemon replaces: a fresh exiftool process per command
+static void BM_ExifToolProcessPerCommand(benchmark::State& state) {
+    const QString exifTool = QStandardPaths::findExecutable("exiftool");
+    if (exifTool.isEmpty()) {
+        state.SkipWithError("exiftool not on PATH");
+        return;
+    }
+    for (auto _ : state) {
+        QProcess process;
+        process.start(exifTool, {"-ver"});
+        process.waitForFinished();
+        benchmark::DoNotOptimize(process.readAllStandardOutput());
+    }
+}
+BENCHMARK(BM_ExifToolProcessPerCommand)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// JSON to PhotoMetadata for one file, by number of XMP keywords
+static void BM_ParseExifToolOutput(benchmark::State& state) {
+    const QString output = SyntheticCorpus::exifToolJson(int(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MetadataReader::instance().parseExifToolOutput(output, MetadataReader::FilterSet));
+    }
+    state.SetBytesProcessed(state.iterations() * output.toUtf8().size());
+}
+BENCHMARK(BM_ParseExifToolOutput)->Arg(0)->Arg(8)->Arg(64)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+#include "SyntheticCorpus.h"
+#include "ml/ONNXInference.h"
+#include "ml/CLIPAnalyzer.h"
+#include <QDebug>
+#include <QtGlobal>
+
+using namespace PhotoGuru;
+
+namespace {
+
+// Vision model the ONNX benchmarks run; PHOTOGURU_BENCH_MODEL overrides
+// the default location next to the build directory. CPU only, so numbers
+// compare across machines with and without an accelerator.
+ONNXInference* benchModel() {
+    static ONNXInference* model = [] {
+        QString path = qEnvironmentVariable("PHOTOGURU_BENCH_MODEL",
+                                            "../models/clip-vit-base-patch32.onnx");
+        auto* inference = new ONNXInference();
+        if (!inference->loadModel(path, false)) {
+            qWarning() << "[PhotoGuruBench] No model at" << path << "- ONNX benchmarks skipped";
+            delete inference;
+            return static_cast<ONNXInference*>(nullptr);
+        }
+        return inference;
+    }();
+    return model;
+}
+
+} // namespace
+
+// Resize, normalize and HWC->CHW of a decoded photo
+static void BM_ONNXPreprocessImage(benchmark::State& state, QSize size) {
+    ONNXInference* model = benchModel();
+    if (!model) {
+        state.SkipWithError("model not loaded (set PHOTOGURU_BENCH_MODEL)");
+        return;
+    }
+    const QImage image = SyntheticCorpus::pattern(size);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(model->preprocessImage(image));
+    }
+}
+BENCHMARK_CAPTURE(BM_ONNXPreprocessImage, small, SyntheticCorpus::small())->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ONNXPreprocessImage, medium, SyntheticCorpus::medium())->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ONNXPreprocessImage, large, SyntheticCorpus::large())->Unit(benchmark::kMillisecond);
+
+// One session run on an already preprocessed tensor
+static void BM_ONNXRunInference(benchmark::State& state) {
+    ONNXInference* model = benchModel();
+    if (!model) {
+        state.SkipWithError("model not loaded (set PHOTOGURU_BENCH_MODEL)");
+        return;
+    }
+    const std::vector<float> input = model->preprocessImage(SyntheticCorpus::pattern(SyntheticCorpus::small()));
+    for (auto _ : state) {
+        auto output = model->runInference(input);
+        if (!output) {
+            state.SkipWithError("runInference failed");
+            return;
+        }
+        benchmark::DoNotOptimize(output->data());
+    }
+}
+BENCHMARK(BM_ONNXRunInference)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Exact top-10 over state.range(0) CLIP-sized embeddings
+static void BM_CLIPFindMostSimilar(benchmark::State& state) {
+    const int count = int(state.range(0));
+    const auto database = SyntheticCorpus::embeddings(count);
+    const std::vector<float> query = database[count / 2];
+    CLIPAnalyzer analyzer;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(analyzer.findMostSimilar(query, database, 10));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_CLIPFindMostSimilar)->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMicrosecond);
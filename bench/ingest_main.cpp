@@ -0,0 +1,39 @@
+#include "IngestBenchmark.h"
+#include "core/ExifToolDaemon.h"
+#include "core/Trace.h"
+#include <QCoreApplication>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace PhotoGuru;
+
+// Stage results and the report are the output; per-file logging is not
+void ingestMessageHandler(QtMsgType type, const QMessageLogContext&, const QString& msg) {
+    if (type == QtDebugMsg || type == QtInfoMsg) {
+        return;
+    }
+    std::fprintf(stderr, "%s\n", qPrintable(msg));
+    if (type == QtFatalMsg) {
+        std::abort();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    // No GUI: runs on CI machines without a display server
+    QCoreApplication app(argc, argv);
+    qInstallMessageHandler(ingestMessageHandler);
+    Trace::configureFromEnvironment();
+
+    QString message;
+    bool helpRequested = false;
+    auto options = IngestBenchmark::parseArguments(app.arguments(), &message, &helpRequested);
+    if (!options) {
+        std::fprintf(helpRequested ? stdout : stderr, "%s\n", qPrintable(message));
+        return helpRequested ? 0 : 1;
+    }
+
+    int exitCode = IngestBenchmark(*options).run();
+
+    ExifToolDaemon::instance().stop();
+    return exitCode;
+}
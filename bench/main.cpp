@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+#include "core/ExifToolDaemon.h"
+#include "ml/ONNXInference.h"
+#include <QCoreApplication>
+#include <cstdio>
+#include <cstdlib>
+
+// Readers and loaders log per call; only warnings and errors reach the
+// console so they don't interleave with the result table
+void benchMessageHandler(QtMsgType type, const QMessageLogContext&, const QString& msg) {
+    if (type == QtDebugMsg || type == QtInfoMsg) {
+        return;
+    }
+    std::fprintf(stderr, "%s\n", qPrintable(msg));
+    if (type == QtFatalMsg) {
+        std::abort();
+    }
+}
+
+int main(int argc, char** argv) {
+    // No GUI: QImage codecs and the ExifTool daemon only need the event loop's thread
+    QCoreApplication app(argc, argv);
+    qInstallMessageHandler(benchMessageHandler);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    PhotoGuru::ONNXInference::shutdownEnvironment();
+    PhotoGuru::ExifToolDaemon::instance().stop();
+    return 0;
+}
@@ -0,0 +1,713 @@
+#include "BatchIngest.h"
+#include "core/ImageLoader.h"
+#include "core/PhotoMetadata.h"
+#include "core/PhotoDatabase.h"
+#include "core/ThumbnailCache.h"
+#include "core/EmbeddingStore.h"
+#include "core/CatalogServer.h"
+#include "core/CatalogSync.h"
+#include "core/ExifToolDaemon.h"
+#include "core/GoogleTakeoutParser.h"
+#include "core/GoogleTakeoutImporter.h"
+#include "ml/CLIPAnalyzer.h"
+#include "ml/LlamaVLM.h"
+#include "ml/AnalysisPipeline.h"
+#include "ml/QualityAnalyzer.h"
+#include "ml/FaceAnalyzer.h"
+#include "ml/FaceIndexer.h"
+#include "ml/InferenceBackend.h"
+#include "ml/InferenceServer.h"
+#include "ml/RemoteInference.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QThread>
+#include <QThreadPool>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QUrl>
+#include <QtConcurrent>
+#include <cstdio>
+#include <memory>
+
+namespace PhotoGuru {
+
+namespace {
+
+const QStringList STEP_NAMES = {"takeout", "catalog", "thumbnails", "embeddings", "captions", "quality", "faces"};
+
+// Progress line every this many files in the per-file steps
+constexpr int PROGRESS_INTERVAL = 100;
+
+// The viewer's embedding store
+QString embeddingsDirectory() {
+    return QDir::homePath() + "/.photoguru/embeddings";
+}
+
+// A port number (1-65535), or 0
+int portNumber(const QString& value) {
+    bool ok = false;
+    const int port = value.toInt(&ok);
+    return ok && port >= 1 && port <= 65535 ? port : 0;
+}
+
+// An http(s) URL with a host
+bool isServerUrl(const QUrl& url) {
+    return url.isValid() && (url.scheme() == "http" || url.scheme() == "https") && !url.host().isEmpty();
+}
+
+} // namespace
+
+std::optional<BatchIngest::Options> BatchIngest::parseArguments(const QStringList& arguments,
+                                                                QString* message,
+                                                                bool* helpRequested) {
+    if (helpRequested) *helpRequested = false;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Headless PhotoGuru ingest: catalog, thumbnails, CLIP embeddings, VLM captions, quality scores and people.");
+    QCommandLineOption helpOption = parser.addHelpOption();
+    parser.addPositionalArgument("paths", "Image files or folders to ingest.", "<path>...");
+
+    QCommandLineOption jobsOption({"j", "jobs"},
+        "Worker threads and ExifTool processes (default: number of cores).", "n");
+    QCommandLineOption stepsOption("steps",
+        "Comma-separated steps: takeout, catalog, thumbnails, embeddings, captions, quality, faces "
+        "(default: all except takeout).", "list");
+    QCommandLineOption recursiveOption({"r", "recursive"}, "Descend into subfolders.");
+    QCommandLineOption thumbnailOption("thumbnail-size", "Thumbnail edge in pixels (default: 150).", "px");
+    QCommandLineOption modelsOption("models", "Models directory (default: next to the executable).", "dir");
+    QCommandLineOption catalogOption("catalog", "Catalog database (default: the viewer's catalog).", "file");
+    QCommandLineOption remoteOption("remote",
+        "Compute embeddings and captions on an inference server, e.g. http://gpu-box:8765.", "url");
+    QCommandLineOption tokenOption("token", "Token the servers require (given or served).", "token");
+    QCommandLineOption serveOption("serve",
+        "Serve CLIP and the VLM to other machines on this port instead of ingesting.", "port");
+    QCommandLineOption gpuLayersOption("gpu-layers",
+        "VLM layers offloaded to the GPU (default: 5, all with --serve).", "n");
+    QCommandLineOption syncOption("sync",
+        "Pull the catalog, thumbnails and embeddings from a catalog server first, e.g. http://nas:8766.", "url");
+    QCommandLineOption pathMapOption("path-map",
+        "Library root on the catalog server and here, when the share is mounted elsewhere.", "server=local");
+    QCommandLineOption serveCatalogOption("serve-catalog",
+        "Serve this catalog, its thumbnails and embeddings to other machines on this port.", "port");
+    parser.addOptions({jobsOption, stepsOption, recursiveOption, thumbnailOption, modelsOption, catalogOption,
+                       remoteOption, tokenOption, serveOption, gpuLayersOption,
+                       syncOption, pathMapOption, serveCatalogOption});
+
+    if (!parser.parse(arguments)) {
+        *message = parser.errorText();
+        return std::nullopt;
+    }
+    if (parser.isSet(helpOption)) {
+        *message = parser.helpText();
+        if (helpRequested) *helpRequested = true;
+        return std::nullopt;
+    }
+
+    Options options;
+    options.inputs = parser.positionalArguments();
+    if (parser.isSet(serveOption)) {
+        options.servePort = portNumber(parser.value(serveOption));
+        if (options.servePort == 0) {
+            *message = "--serve expects a port number";
+            return std::nullopt;
+        }
+    }
+    if (parser.isSet(serveCatalogOption)) {
+        options.catalogPort = portNumber(parser.value(serveCatalogOption));
+        if (options.catalogPort == 0 || options.catalogPort == options.servePort) {
+            *message = "--serve-catalog expects a port number (not the --serve one)";
+            return std::nullopt;
+        }
+    }
+    if (parser.isSet(syncOption)) {
+        QUrl url(parser.value(syncOption));
+        if (!isServerUrl(url)) {
+            *message = "--sync expects an http(s) URL";
+            return std::nullopt;
+        }
+        options.syncFrom = url.toString();
+    }
+    if (parser.isSet(pathMapOption)) {
+        const QStringList roots = parser.value(pathMapOption).split('=');
+        if (roots.size() != 2 || !QDir::isAbsolutePath(roots[0]) || !QDir::isAbsolutePath(roots[1])) {
+            *message = "--path-map expects <server-root>=<local-root>, both absolute";
+            return std::nullopt;
+        }
+        options.serverRoot = roots[0];
+        options.localRoot = roots[1];
+    }
+    if (options.inputs.isEmpty() && options.servePort == 0 && options.catalogPort == 0 && options.syncFrom.isEmpty()) {
+        *message = "No input paths given (see --help)";
+        return std::nullopt;
+    }
+
+    if (parser.isSet(jobsOption)) {
+        bool ok = false;
+        options.jobs = parser.value(jobsOption).toInt(&ok);
+        if (!ok || options.jobs < 1) {
+            *message = "--jobs expects a positive number";
+            return std::nullopt;
+        }
+    }
+
+    if (parser.isSet(stepsOption)) {
+        options.steps = 0;
+        for (const QString& name : parser.value(stepsOption).split(',', Qt::SkipEmptyParts)) {
+            int index = STEP_NAMES.indexOf(name.trimmed().toLower());
+            if (index < 0) {
+                *message = "Unknown step: " + name.trimmed();
+                return std::nullopt;
+            }
+            options.steps |= 1 << index;
+        }
+        if (options.steps == 0) {
+            *message = "--steps is empty";
+            return std::nullopt;
+        }
+    }
+
+    if (parser.isSet(gpuLayersOption)) {
+        bool ok = false;
+        options.gpuLayers = parser.value(gpuLayersOption).toInt(&ok);
+        if (!ok || options.gpuLayers < 0) {
+            *message = "--gpu-layers expects a number of layers (0 or more)";
+            return std::nullopt;
+        }
+    }
+
+    if (parser.isSet(remoteOption)) {
+        QUrl url(parser.value(remoteOption));
+        if (!isServerUrl(url)) {
+            *message = "--remote expects an http(s) URL";
+            return std::nullopt;
+        }
+        options.remote = url.toString();
+    }
+    options.token = parser.value(tokenOption);
+
+    if (parser.isSet(thumbnailOption)) {
+        bool ok = false;
+        options.thumbnailSize = parser.value(thumbnailOption).toInt(&ok);
+        if (!ok || options.thumbnailSize < 16) {
+            *message = "--thumbnail-size expects a number of pixels (16 or more)";
+            return std::nullopt;
+        }
+    }
+
+    options.recursive = parser.isSet(recursiveOption);
+    options.modelsDir = parser.value(modelsOption);
+    options.catalogPath = parser.value(catalogOption);
+    return options;
+}
+
+QStringList BatchIngest::collectFiles(const QStringList& inputs, bool recursive) {
+    ImageLoader& loader = ImageLoader::instance();
+    QSet<QString> seen;
+    QStringList files;
+
+    auto add = [&](const QFileInfo& info) {
+        QString path = info.absoluteFilePath();
+        if (loader.isSupported(path) && !seen.contains(path)) {
+            seen.insert(path);
+            files << path;
+        }
+    };
+
+    for (const QString& input : inputs) {
+        QFileInfo info(input);
+        if (info.isFile()) {
+            add(info);
+        } else if (info.isDir()) {
+            QDirIterator it(info.absoluteFilePath(), QDir::Files | QDir::Readable,
+                            recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+            while (it.hasNext()) {
+                it.next();
+                add(it.fileInfo());
+            }
+        }
+    }
+
+    files.sort();
+    return files;
+}
+
+BatchIngest::BatchIngest(const Options& options)
+    : m_options(options)
+    , m_out(stdout)
+{
+    if (m_options.jobs <= 0) {
+        m_options.jobs = QThread::idealThreadCount();
+    }
+}
+
+BatchIngest::~BatchIngest() = default;
+
+int BatchIngest::run() {
+    if (m_options.servePort > 0 || m_options.catalogPort > 0) {
+        return runServer();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    ExifToolDaemon::instance().setPoolSize(m_options.jobs);
+
+    int failed = 0;
+    if (!m_options.syncFrom.isEmpty()) {
+        // Whatever didn't arrive is computed here, as without a server
+        if (!runSync()) ++failed;
+        if (m_options.inputs.isEmpty()) return failed > 0 ? 1 : 0;
+    }
+    if (m_options.steps & Takeout) {
+        failed += runTakeout();
+    }
+
+    QStringList files = collectFiles(m_options.inputs, m_options.recursive);
+    if (files.isEmpty()) {
+        m_out << "No supported images found" << Qt::endl;
+        return 1;
+    }
+    m_out << "Ingesting " << files.size() << " images with " << m_options.jobs << " jobs" << Qt::endl;
+
+    if (m_options.steps & Catalog) {
+        failed += runCatalog(files);
+    }
+    if (m_options.steps & Thumbnails) {
+        failed += runThumbnails(files);
+    }
+    if (m_options.steps & (Embeddings | Captions)) {
+        int result = runAnalysis(files);
+        if (result < 0) return 1;
+        failed += result;
+    }
+    if (m_options.steps & Quality) {
+        failed += runQuality(files);
+    }
+    if (m_options.steps & Faces) {
+        failed += runFaces(files);
+    }
+
+    m_out << "Done in " << timer.elapsed() / 1000 << "s, " << failed << " failures" << Qt::endl;
+    return failed > 0 ? 2 : 0;
+}
+
+int BatchIngest::runTakeout() {
+    QStringList directories;
+    for (const QString& input : m_options.inputs) {
+        QFileInfo info(input);
+        if (!info.isDir()) continue;
+        directories << info.absoluteFilePath();
+        if (m_options.recursive) {
+            QDirIterator it(info.absoluteFilePath(), QDir::Dirs | QDir::NoDotAndDotDot,
+                            QDirIterator::Subdirectories);
+            while (it.hasNext()) directories << it.next();
+        }
+    }
+
+    int errors = 0;
+    GoogleTakeoutImporter::ImportOptions importOptions;
+    importOptions.progress = [this](int done, int total) {
+        m_out << "takeout: " << done << "/" << total << Qt::endl;
+        return true;
+    };
+    for (const QString& directory : directories) {
+        if (!GoogleTakeoutParser::isGoogleTakeoutDirectory(directory)) continue;
+        GoogleTakeoutImporter::ImportResult result =
+            GoogleTakeoutImporter::importDirectory(directory, importOptions);
+        m_out << "takeout: " << directory << " - " << result.summary() << Qt::endl;
+        errors += result.errors;
+    }
+    return errors;
+}
+
+bool BatchIngest::openCatalog() {
+    QString catalogPath = m_options.catalogPath;
+    if (catalogPath.isEmpty()) {
+        catalogPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/catalog.db";
+    }
+    if (!PhotoDatabase::instance().initialize(catalogPath)) {
+        m_out << "catalog: cannot open " << catalogPath << Qt::endl;
+        return false;
+    }
+    return true;
+}
+
+bool BatchIngest::runSync() {
+    if (!openCatalog()) return false;
+
+    CatalogSync sync(QUrl(m_options.syncFrom), m_options.token);
+    if (!m_options.serverRoot.isEmpty()) {
+        sync.setPathMapping(m_options.serverRoot, m_options.localRoot);
+    }
+    sync.setThumbnailSizes({QSize(m_options.thumbnailSize, m_options.thumbnailSize)});
+
+    // The store as it is here; none yet takes the server's model
+    EmbeddingStore store;
+    QString modelVersion;
+    int dimension = 0;
+    if (EmbeddingStore::describe(embeddingsDirectory(), &modelVersion, &dimension)) {
+        store.open(embeddingsDirectory(), modelVersion, dimension);
+    }
+    sync.setEmbeddingStore(&store, embeddingsDirectory());
+
+    m_out << "sync: pulling from " << m_options.syncFrom << Qt::endl;
+    std::optional<CatalogSync::Result> result = sync.sync();
+    if (!result) {
+        m_out << "sync: " << sync.lastError() << Qt::endl;
+        return false;
+    }
+    m_out << "sync: " << result->records << " entries (" << result->removed << " removed), "
+          << result->thumbnails << " thumbnails, " << result->embeddings << " embeddings" << Qt::endl;
+    return true;
+}
+
+int BatchIngest::runCatalog(const QStringList& files) {
+    if (!openCatalog()) {
+        return files.size();
+    }
+    PhotoDatabase& database = PhotoDatabase::instance();
+
+    // Unchanged files are already cataloged; only the rest go to ExifTool
+    QHash<QString, PhotoMetadata> fresh = database.loadFreshMetadata(files);
+    QStringList remaining;
+    for (const QString& path : files) {
+        if (!fresh.contains(path)) remaining << path;
+    }
+    m_out << "catalog: " << fresh.size() << " up to date, reading " << remaining.size() << Qt::endl;
+
+    QList<QStringList> chunks;
+    const int chunkSize = qBound(1, int((remaining.size() + m_options.jobs - 1) / m_options.jobs),
+                                 MetadataReader::READ_MANY_CHUNK_SIZE);
+    for (int i = 0; i < remaining.size(); i += chunkSize) {
+        chunks << remaining.mid(i, chunkSize);
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(m_options.jobs);
+    QAtomicInt read{0};
+    QAtomicInt failed{0};
+    QMutex outputMutex;
+    QtConcurrent::blockingMap(&pool, chunks, [&](const QStringList& chunk) {
+        std::vector<PhotoMetadata> metas = MetadataReader::instance().readCommon(chunk);
+        database.storeReadMetadata(QList<PhotoMetadata>(metas.begin(), metas.end()));
+
+        failed.fetchAndAddRelaxed(int(chunk.size() - qsizetype(metas.size())));
+        int done = read.fetchAndAddRelaxed(int(chunk.size())) + int(chunk.size());
+        QMutexLocker locker(&outputMutex);
+        m_out << "catalog: " << done << "/" << remaining.size() << Qt::endl;
+    });
+
+    if (failed.loadRelaxed() > 0) {
+        m_out << "catalog: " << failed.loadRelaxed() << " files unreadable" << Qt::endl;
+    }
+    return failed.loadRelaxed();
+}
+
+int BatchIngest::runThumbnails(const QStringList& files) {
+    const QSize size(m_options.thumbnailSize, m_options.thumbnailSize);
+    QThreadPool pool;
+    pool.setMaxThreadCount(m_options.jobs);
+    QAtomicInt done{0};
+    QAtomicInt failed{0};
+    QMutex outputMutex;
+
+    // Blocking lookups store every decode in the disk tier the viewer reads
+    QtConcurrent::blockingMap(&pool, files, [&](const QString& path) {
+        if (ThumbnailCache::instance().thumbnailImage(path, size).isNull()) {
+            failed.fetchAndAddRelaxed(1);
+        }
+        int count = done.fetchAndAddRelaxed(1) + 1;
+        if (count % PROGRESS_INTERVAL == 0 || count == files.size()) {
+            QMutexLocker locker(&outputMutex);
+            m_out << "thumbnails: " << count << "/" << files.size() << Qt::endl;
+        }
+    });
+    return failed.loadRelaxed();
+}
+
+int BatchIngest::runAnalysis(const QStringList& files) {
+    const QString dir = modelsDir();
+
+    // Embeddings and captions come from the server, or from the viewer's model files here
+    std::unique_ptr<RemoteInference> remote;
+    std::unique_ptr<CLIPAnalyzer> clip;
+    std::unique_ptr<LlamaVLM> vlm;
+    std::unique_ptr<LocalInference> local;
+    InferenceBackend* backend = nullptr;
+    if (!m_options.remote.isEmpty()) {
+        remote = std::make_unique<RemoteInference>(QUrl(m_options.remote), m_options.token);
+        if (!remote->connectToServer()) {
+            m_out << "analysis: inference server unavailable: " << remote->lastError() << Qt::endl;
+            return -1;
+        }
+        backend = remote.get();
+    } else {
+        clip = std::make_unique<CLIPAnalyzer>();
+        if (!clip->initialize(dir + "/clip-vit-base-patch32.onnx", true)) {
+            m_out << "embeddings: CLIP unavailable in " << dir << ": " << clip->lastError() << Qt::endl;
+            return -1;
+        }
+        if (m_options.steps & Captions) {
+            vlm = loadVlm();
+        }
+        local = std::make_unique<LocalInference>(clip.get(), vlm.get());
+        backend = local.get();
+    }
+
+    const InferenceBackend::Info info = backend->info();
+    const bool captions = (m_options.steps & Captions) && !info.vlmId.isEmpty();
+    if (remote && (m_options.steps & Captions) && !captions) {
+        m_out << "captions: the server has no VLM, skipping" << Qt::endl;
+    }
+
+    EmbeddingStore store;
+    if (!store.open(embeddingsDirectory(), info.clipVersion, info.embeddingDim)) {
+        m_out << "embeddings: store unavailable, embeddings will not persist" << Qt::endl;
+    }
+
+    // The analysis decode scores quality and finds faces too, when those steps are wanted
+    AnalysisPipeline::Stages stages = AnalysisPipeline::defaultStages(
+        backend, store.isOpen() ? &store : nullptr,
+        (m_options.steps & Faces) ? faceAnalyzer() : nullptr);
+    if (!(m_options.steps & Quality)) {
+        stages.score = nullptr;
+    }
+    if (!captions) {
+        stages.caption = nullptr;
+        stages.captionBatch = nullptr;
+    }
+    AnalysisPipeline pipeline(stages);
+    pipeline.setBatchSize(info.batchSize);
+    pipeline.setDecodeThreads(m_options.jobs);
+    if (captions) {
+        pipeline.setCaptionBatchSize(info.captionBatchSize);
+    }
+
+    QEventLoop loop;
+    int failedCount = 0;
+    QObject::connect(&pipeline, &AnalysisPipeline::log, &loop, [this](const QString& message) {
+        m_out << message << Qt::endl;
+    });
+    QObject::connect(&pipeline, &AnalysisPipeline::finished, &loop,
+                     [this, &loop, &failedCount](int succeeded, int failed, bool) {
+        m_out << "analysis: " << succeeded << " succeeded, " << failed << " failed" << Qt::endl;
+        failedCount = failed;
+        loop.quit();
+    });
+
+    m_out << (captions ? "analysis: embeddings + captions" : "analysis: embeddings")
+          << (remote ? " on " + remote->server().toString() : QString()) << Qt::endl;
+    pipeline.start(files);
+    loop.exec();
+    pipeline.wait();
+    return failedCount;
+}
+
+int BatchIngest::runQuality(const QStringList& allFiles) {
+    // Whatever the analysis step (or an earlier ingest) already scored is cataloged
+    QHash<QString, PhotoMetadata> known = PhotoDatabase::instance().loadFreshMetadata(allFiles);
+    QStringList files;
+    for (const QString& path : allFiles) {
+        auto it = known.constFind(path);
+        if (it == known.constEnd() || !QualityAnalyzer::Scores::fromTechnical(it->technical)) {
+            files << path;
+        }
+    }
+    if (files.isEmpty()) {
+        m_out << "quality: all " << allFiles.size() << " already scored" << Qt::endl;
+        return 0;
+    }
+
+    QualityAnalyzer analyzer(QualityAnalyzer::defaultStages());
+    analyzer.setThreads(m_options.jobs);
+
+    QEventLoop loop;
+    int failedCount = 0;
+    QObject::connect(&analyzer, &QualityAnalyzer::log, &loop, [this](const QString& message) {
+        m_out << message << Qt::endl;
+    });
+    QObject::connect(&analyzer, &QualityAnalyzer::progress, &loop,
+                     [this](int current, int total, const QString&) {
+        if (current % PROGRESS_INTERVAL == 0 || current == total) {
+            m_out << "quality: " << current << "/" << total << Qt::endl;
+        }
+    });
+    QObject::connect(&analyzer, &QualityAnalyzer::finished, &loop,
+                     [this, &loop, &failedCount](int analyzed, int failed, bool) {
+        m_out << "quality: " << analyzed << " scored, " << failed << " failed" << Qt::endl;
+        failedCount = failed;
+        loop.quit();
+    });
+
+    analyzer.start(files);
+    loop.exec();
+    analyzer.wait();
+    return failedCount;
+}
+
+int BatchIngest::runFaces(const QStringList& files) {
+    FaceAnalyzer* faces = faceAnalyzer();
+    if (!faces) return 0;
+
+    // Files the analysis step (or an earlier ingest) scanned are only clustered
+    FaceIndexer indexer(FaceIndexer::defaultStages(faces));
+    indexer.setBatchSize(faces->batchSize());
+    indexer.setDecodeThreads(m_options.jobs);
+
+    QEventLoop loop;
+    QObject::connect(&indexer, &FaceIndexer::log, &loop, [this](const QString& message) {
+        m_out << message << Qt::endl;
+    });
+    QObject::connect(&indexer, &FaceIndexer::progress, &loop,
+                     [this](int current, int total, const QString&) {
+        if (current % PROGRESS_INTERVAL == 0 || current == total) {
+            m_out << "faces: " << current << "/" << total << Qt::endl;
+        }
+    });
+    QObject::connect(&indexer, &FaceIndexer::finished, &loop,
+                     [this, &loop](int scanned, int found, int updated, bool) {
+        m_out << "faces: " << scanned << " scanned, " << found << " faces, "
+              << updated << " photos with new people" << Qt::endl;
+        loop.quit();
+    });
+
+    indexer.start(files);
+    loop.exec();
+    indexer.wait();
+
+    // Unscanned files are picked up by the next run; count them as failed
+    QHash<QString, int> scanned = PhotoDatabase::instance().freshFaceCounts(files);
+    return int(files.size() - scanned.size());
+}
+
+int BatchIngest::runServer() {
+    // Queued to this thread: the servers' workers would otherwise share m_out
+    auto print = [this](const QString& message) { m_out << message << Qt::endl; };
+
+    std::unique_ptr<CLIPAnalyzer> clip;
+    std::unique_ptr<LlamaVLM> vlm;
+    std::unique_ptr<LocalInference> backend;
+    std::unique_ptr<InferenceServer> inference;
+    if (m_options.servePort > 0) {
+        const QString dir = modelsDir();
+        clip = std::make_unique<CLIPAnalyzer>();
+        if (!clip->initialize(dir + "/clip-vit-base-patch32.onnx", true)) {
+            m_out << "serve: CLIP unavailable in " << dir << ": " << clip->lastError() << Qt::endl;
+            return 1;
+        }
+        vlm = loadVlm();
+
+        backend = std::make_unique<LocalInference>(clip.get(), vlm.get());
+        inference = std::make_unique<InferenceServer>(backend.get());
+        inference->setToken(m_options.token);
+        QObject::connect(inference.get(), &InferenceServer::log, inference.get(), print);
+        if (!inference->listen(QHostAddress::Any, quint16(m_options.servePort))) {
+            m_out << "serve: cannot listen on port " << m_options.servePort << ": " << inference->errorString()
+                  << Qt::endl;
+            return 1;
+        }
+        m_out << "Serving " << (vlm ? "CLIP + VLM" : "CLIP") << " on port " << inference->port() << Qt::endl;
+    }
+
+    // The store as it is: opening it under another model would discard it
+    EmbeddingStore store;
+    std::unique_ptr<CatalogServer> catalog;
+    if (m_options.catalogPort > 0) {
+        if (!openCatalog()) return 1;
+        QString modelVersion;
+        int dimension = 0;
+        if (EmbeddingStore::describe(embeddingsDirectory(), &modelVersion, &dimension)) {
+            store.open(embeddingsDirectory(), modelVersion, dimension);
+        }
+
+        catalog = std::make_unique<CatalogServer>(store.isOpen() ? &store : nullptr);
+        catalog->setToken(m_options.token);
+        QObject::connect(catalog.get(), &CatalogServer::log, catalog.get(), print);
+        if (!catalog->listen(QHostAddress::Any, quint16(m_options.catalogPort))) {
+            m_out << "serve: cannot listen on port " << m_options.catalogPort << ": " << catalog->errorString()
+                  << Qt::endl;
+            return 1;
+        }
+        m_out << "Serving the catalog (" << PhotoDatabase::instance().photoCount() << " photos"
+              << (store.isOpen() ? QString(", %1 embeddings").arg(store.liveCount()) : QString())
+              << ") on port " << catalog->port() << Qt::endl;
+    }
+
+    if (m_options.token.isEmpty()) {
+        m_out << "serve: no --token, anyone who can reach the port can use it" << Qt::endl;
+    }
+    QEventLoop loop;
+    loop.exec();  // Until the process is stopped
+    return 0;
+}
+
+std::unique_ptr<LlamaVLM> BatchIngest::loadVlm() {
+    const LlamaVLM::ModelConfig config = vlmConfig();
+    if (!QFileInfo::exists(config.modelPath) || !QFileInfo::exists(config.mmprojPath)) {
+        m_out << "captions: VLM models not found in " << modelsDir() << ", skipping" << Qt::endl;
+        return nullptr;
+    }
+    auto vlm = std::make_unique<LlamaVLM>();
+    if (!vlm->initialize(config)) {
+        m_out << "captions: VLM initialization failed: " << vlm->lastError() << Qt::endl;
+        return nullptr;
+    }
+    return vlm;
+}
+
+LlamaVLM::ModelConfig BatchIngest::vlmConfig() const {
+    // Same model files the viewer's AnalysisPanel loads
+    const QString dir = modelsDir();
+    LlamaVLM::ModelConfig config;
+    config.modelPath = dir + "/Qwen3VL-4B-Instruct-Q4_K_M.gguf";
+    config.mmprojPath = dir + "/mmproj-Qwen3VL-4B-Instruct-Q8_0.gguf";
+    config.contextSize = 2048;
+    if (m_options.gpuLayers >= 0) {
+        config.nGPULayers = m_options.gpuLayers;
+    } else if (m_options.servePort > 0) {
+        config.nGPULayers = ALL_GPU_LAYERS;  // A server's GPU is there for the models
+    }
+    return config;
+}
+
+FaceAnalyzer* BatchIngest::faceAnalyzer() {
+    if (m_facesLoaded) return m_faces.get();
+    m_facesLoaded = true;
+
+    // Same model files the viewer's AnalysisPanel loads
+    const QString dir = modelsDir();
+    const QString detectorPath = dir + "/yolov8n-face.onnx";
+    const QString embedderPath = dir + "/arcface-w600k-r50.onnx";
+    if (!QFileInfo::exists(detectorPath) || !QFileInfo::exists(embedderPath)) {
+        m_out << "faces: face models not found in " << dir << ", skipping" << Qt::endl;
+        return nullptr;
+    }
+    m_faces = std::make_unique<FaceAnalyzer>();
+    if (!m_faces->initialize(detectorPath, embedderPath, true)) {
+        m_out << "faces: initialization failed: " << m_faces->lastError() << Qt::endl;
+        m_faces.reset();
+    }
+    return m_faces.get();
+}
+
+QString BatchIngest::modelsDir() const {
+    if (!m_options.modelsDir.isEmpty()) {
+        return m_options.modelsDir;
+    }
+    const QString appDir = QCoreApplication::applicationDirPath();
+    for (const QString& candidate : {appDir + "/models", appDir + "/../models", appDir + "/../Resources/models"}) {
+        if (QDir(candidate).exists()) {
+            return QDir(candidate).canonicalPath();
+        }
+    }
+    return appDir + "/models";
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <memory>
+#include <optional>
+#include "ml/LlamaVLM.h"
+
+namespace PhotoGuru {
+
+class FaceAnalyzer;
+
+/**
+ * @brief Headless ingest of photo folders (photoguru-cli)
+ *
+ * Runs the same work the GUI does when a folder is opened and analysed,
+ * without a display server:
+ *   takeout    - apply Google Takeout JSON sidecars (opt-in)
+ *   catalog    - ExifTool metadata into the PhotoDatabase catalog
+ *   thumbnails - fill the ThumbnailCache disk tier
+ *   embeddings - CLIP embeddings into the EmbeddingStore
+ *   captions   - VLM titles written to the files (implies embeddings)
+ *   quality    - sharpness/exposure into technical metadata and the catalog
+ *   faces      - faces into the catalog, grouped into people (person keys)
+ *
+ * Catalog, thumbnail store and embedding store are the ones the GUI
+ * reads, so a folder ingested overnight opens warm. --jobs sizes the
+ * ExifTool daemon pool and every worker pool.
+ *
+ * --remote sends embeddings and captions to an InferenceServer, which
+ * --serve runs: CLIP and the VLM on this machine's GPU for clients on
+ * the network, every VLM layer offloaded unless --gpu-layers says otherwise.
+ *
+ * --serve-catalog shares this machine's catalog, thumbnails and embeddings
+ * (CatalogServer); --sync pulls what changed in one before the steps run,
+ * so they find the library already indexed. --path-map translates paths
+ * when the share is mounted elsewhere here. Without inputs, --sync only pulls.
+ */
+class BatchIngest {
+public:
+    enum Step {
+        Takeout    = 1 << 0,
+        Catalog    = 1 << 1,
+        Thumbnails = 1 << 2,
+        Embeddings = 1 << 3,
+        Captions   = 1 << 4,
+        Quality    = 1 << 5,
+        Faces      = 1 << 6,
+    };
+
+    struct Options {
+        QStringList inputs;         // Files and/or directories
+        int steps = Catalog | Thumbnails | Embeddings | Captions | Quality | Faces;
+        int jobs = 0;               // 0 = QThread::idealThreadCount()
+        bool recursive = false;
+        int thumbnailSize = 150;    // ThumbnailGrid's default cell
+        QString modelsDir;          // Empty = next to the executable
+        QString catalogPath;        // Empty = the GUI's catalog
+        QString remote;             // InferenceServer URL; empty = models in-process
+        QString token;              // Shared with the server, if it has one
+        int servePort = 0;          // Serve the models instead of ingesting (0 = ingest)
+        int gpuLayers = -1;         // VLM layers on the GPU; -1 = the viewer's default (all with --serve)
+        QString syncFrom;           // CatalogServer URL pulled from before the steps; empty = none
+        QString serverRoot;         // --path-map: the library's root on the server...
+        QString localRoot;          // ...and here
+        int catalogPort = 0;        // Serve the catalog instead of ingesting (0 = ingest)
+    };
+
+    /**
+     * @brief Parse command-line arguments (arguments[0] is the program)
+     * @param message Receives help text or the error
+     * @param helpRequested Set when --help was given (not an error)
+     */
+    static std::optional<Options> parseArguments(const QStringList& arguments, QString* message,
+                                                 bool* helpRequested = nullptr);
+
+    // Supported images among inputs, directories expanded, sorted, no duplicates
+    static QStringList collectFiles(const QStringList& inputs, bool recursive);
+
+    explicit BatchIngest(const Options& options);
+    ~BatchIngest();
+
+    // Exit code: 0 all good, 1 nothing could run, 2 some files failed
+    int run();
+
+    // VLM layers that cover any model: llama.cpp stops at the ones it has
+    static constexpr int ALL_GPU_LAYERS = 999;
+
+private:
+    int runTakeout();
+    int runCatalog(const QStringList& files);
+    int runThumbnails(const QStringList& files);
+    int runAnalysis(const QStringList& files);
+    int runQuality(const QStringList& files);
+    int runFaces(const QStringList& files);
+    // Inference and/or catalog server, until the process is stopped
+    int runServer();
+    bool runSync();
+
+    bool openCatalog();
+
+    QString modelsDir() const;
+    LlamaVLM::ModelConfig vlmConfig() const;
+    // Null (and says why) when the VLM files are missing or fail to load
+    std::unique_ptr<LlamaVLM> loadVlm();
+    // Loaded on first use, shared by the analysis and faces steps; null if unavailable
+    FaceAnalyzer* faceAnalyzer();
+
+    Options m_options;
+    QTextStream m_out;
+    std::unique_ptr<FaceAnalyzer> m_faces;
+    bool m_facesLoaded = false;
+};
+
+} // namespace PhotoGuru
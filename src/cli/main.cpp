@@ -0,0 +1,34 @@
+#include "cli/BatchIngest.h"
+#include "core/ExifToolDaemon.h"
+#include "core/Trace.h"
+#include "ml/ONNXInference.h"
+#include <QCoreApplication>
+#include <cstdio>
+
+using namespace PhotoGuru;
+
+int main(int argc, char *argv[]) {
+    // No GUI: runs on machines without a display server
+    QCoreApplication app(argc, argv);
+
+    // Same names as the viewer, so catalog, logs and caches are shared
+    app.setOrganizationName("PhotoGuru");
+    app.setOrganizationDomain("photoguru.ai");
+    app.setApplicationName("PhotoGuru Viewer");
+    app.setApplicationVersion("1.0.0");
+    Trace::configureFromEnvironment();
+
+    QString message;
+    bool helpRequested = false;
+    auto options = BatchIngest::parseArguments(app.arguments(), &message, &helpRequested);
+    if (!options) {
+        std::fprintf(helpRequested ? stdout : stderr, "%s\n", qPrintable(message));
+        return helpRequested ? 0 : 1;
+    }
+
+    int exitCode = BatchIngest(*options).run();
+
+    ONNXInference::shutdownEnvironment();
+    ExifToolDaemon::instance().stop();
+    return exitCode;
+}
@@ -0,0 +1,157 @@
+#include "BackupJournal.h"
+#include "FileClone.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QDebug>
+
+namespace PhotoGuru {
+
+BackupJournal& BackupJournal::instance() {
+    static BackupJournal journal(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/backups");
+    return journal;
+}
+
+BackupJournal::BackupJournal(const QString& directory, qint64 maxBytes, int maxEntries)
+    : m_directory(directory)
+    , m_maxBytes(maxBytes)
+    , m_maxEntries(qMax(1, maxEntries))
+{
+    load();
+}
+
+QString BackupJournal::indexPath() const {
+    return m_directory + "/journal";
+}
+
+bool BackupJournal::record(const QString& filePath) {
+    QMutexLocker locker(&m_mutex);
+    if (!QDir().mkpath(m_directory)) {
+        qWarning() << "[BackupJournal] Cannot create" << m_directory;
+        return false;
+    }
+
+    Entry entry;
+    entry.id = m_nextId++;
+    entry.path = filePath;
+    QFileInfo info(filePath);
+    if (info.exists()) {
+        // Named by id alone: versions of one file, and files of one name, stay apart
+        entry.stored = info.suffix().isEmpty() ? QString::number(entry.id)
+                                               : QString("%1.%2").arg(entry.id).arg(info.suffix());
+        entry.size = info.size();
+        if (!FileClone::copy(filePath, m_directory + '/' + entry.stored)) {
+            qWarning() << "[BackupJournal] Cannot back up" << filePath;
+            return false;
+        }
+    }
+
+    m_entries.append(entry);
+    m_totalBytes += entry.size;
+    evict();
+    save();
+    return true;
+}
+
+bool BackupJournal::restore(const QString& filePath) {
+    QMutexLocker locker(&m_mutex);
+    const Entry* entry = latest(filePath);
+    if (!entry) {
+        qWarning() << "[BackupJournal] No backup of" << filePath;
+        return false;
+    }
+    if (entry->stored.isEmpty()) {
+        return !QFileInfo::exists(filePath) || QFile::remove(filePath);
+    }
+
+    // Next to the target first, so a failed copy leaves the current file alone
+    const QString staged = filePath + ".restoring";
+    QFile::remove(staged);
+    if (!FileClone::copy(m_directory + '/' + entry->stored, staged)) {
+        return false;
+    }
+    if (QFileInfo::exists(filePath) && !QFile::remove(filePath)) {
+        qWarning() << "[BackupJournal] Cannot replace" << filePath;
+        QFile::remove(staged);
+        return false;
+    }
+    return QFile::rename(staged, filePath);
+}
+
+bool BackupJournal::hasBackup(const QString& filePath) const {
+    QMutexLocker locker(&m_mutex);
+    return latest(filePath) != nullptr;
+}
+
+int BackupJournal::count() const {
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+qint64 BackupJournal::totalBytes() const {
+    QMutexLocker locker(&m_mutex);
+    return m_totalBytes;
+}
+
+const BackupJournal::Entry* BackupJournal::latest(const QString& filePath) const {
+    for (auto it = m_entries.crbegin(); it != m_entries.crend(); ++it) {
+        if (it->path == filePath) return &*it;
+    }
+    return nullptr;
+}
+
+void BackupJournal::evict() {
+    // The newest version always stays, however large
+    while (m_entries.size() > 1 && (m_entries.size() > m_maxEntries || m_totalBytes > m_maxBytes)) {
+        const Entry oldest = m_entries.takeFirst();
+        m_totalBytes -= oldest.size;
+        if (!oldest.stored.isEmpty()) {
+            QFile::remove(m_directory + '/' + oldest.stored);
+        }
+    }
+}
+
+void BackupJournal::load() {
+    QFile file(indexPath());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return;
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QStringList fields = in.readLine().split('\t');
+        if (fields.size() < 4) continue;
+        Entry entry;
+        bool idOk = false;
+        bool sizeOk = false;
+        entry.id = fields[0].toULongLong(&idOk);
+        entry.stored = fields[1];
+        entry.size = fields[2].toLongLong(&sizeOk);
+        entry.path = fields.mid(3).join('\t');
+        // A copy deleted behind our back is no backup
+        if (!idOk || !sizeOk || (!entry.stored.isEmpty() && !QFileInfo::exists(m_directory + '/' + entry.stored))) {
+            continue;
+        }
+        m_entries.append(entry);
+        m_totalBytes += entry.size;
+        m_nextId = qMax(m_nextId, entry.id + 1);
+    }
+}
+
+void BackupJournal::save() const {
+    QSaveFile file(indexPath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "[BackupJournal] Cannot write" << indexPath();
+        return;
+    }
+    QTextStream out(&file);
+    for (const Entry& entry : m_entries) {
+        out << entry.id << '\t' << entry.stored << '\t' << entry.size << '\t' << entry.path << '\n';
+    }
+    out.flush();
+    file.commit();
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <QMutex>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Versions of files taken before metadata writes, kept within a budget
+ *
+ * record() stores the file as it is now in one journal directory;
+ * restore() puts the newest stored version of it back. Copies go through
+ * FileClone, so on APFS, Btrfs or XFS a backup is a clone that costs no
+ * space until the original is rewritten. Recording a file that doesn't
+ * exist is remembered too, so restoring it removes what was created
+ * later (a new XMP sidecar).
+ *
+ * The journal keeps at most maxEntries versions and maxBytes of file
+ * data (apparent sizes, clones counted in full); the oldest go first.
+ * Its index is a text file next to the copies: "<id>\t<stored>\t<size>\t<path>"
+ * per version, oldest first, stored empty when the file didn't exist.
+ *
+ * Thread-safe.
+ */
+class BackupJournal {
+public:
+    static BackupJournal& instance();  // AppDataLocation/backups
+
+    explicit BackupJournal(const QString& directory, qint64 maxBytes = DEFAULT_MAX_BYTES,
+                           int maxEntries = DEFAULT_MAX_ENTRIES);
+
+    bool record(const QString& filePath);
+    // Newest recorded version back in place; it stays in the journal
+    bool restore(const QString& filePath);
+    bool hasBackup(const QString& filePath) const;
+
+    int count() const;
+    qint64 totalBytes() const;
+
+    static constexpr qint64 DEFAULT_MAX_BYTES = 4LL * 1024 * 1024 * 1024;
+    static constexpr int DEFAULT_MAX_ENTRIES = 1000;
+
+private:
+    struct Entry {
+        quint64 id = 0;
+        QString stored;  // File name in the directory; empty: there was no file
+        qint64 size = 0;
+        QString path;
+    };
+
+    void load();
+    void save() const;
+    void evict();
+    const Entry* latest(const QString& filePath) const;
+    QString indexPath() const;
+
+    QString m_directory;
+    qint64 m_maxBytes;
+    int m_maxEntries;
+
+    mutable QMutex m_mutex;  // Guards everything below
+    QList<Entry> m_entries;  // Oldest first
+    qint64 m_totalBytes = 0;
+    quint64 m_nextId = 1;
+};
+
+} // namespace PhotoGuru
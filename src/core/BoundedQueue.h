@@ -0,0 +1,100 @@
+#pragma once
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <deque>
+#include <optional>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Blocking FIFO with a capacity, for handing work between pipeline stages
+ *
+ * push() blocks while the queue is full, so a fast producer can't run ahead
+ * of a slow consumer and pile up decoded images. close() lets consumers
+ * drain what is left and then see end-of-stream; abort() drops it.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(int capacity) : m_capacity(capacity > 0 ? capacity : 1) {}
+
+    // false if the queue was closed (item is dropped)
+    bool push(T item) {
+        QMutexLocker lock(&m_mutex);
+        while (!m_closed && int(m_items.size()) >= m_capacity) {
+            m_notFull.wait(&m_mutex);
+        }
+        if (m_closed) return false;
+
+        m_items.push_back(std::move(item));
+        m_notEmpty.wakeOne();
+        return true;
+    }
+
+    // nullopt once the queue is closed and empty
+    std::optional<T> pop() {
+        QMutexLocker lock(&m_mutex);
+        while (!m_closed && m_items.empty()) {
+            m_notEmpty.wait(&m_mutex);
+        }
+        if (m_items.empty()) return std::nullopt;
+
+        T item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.wakeOne();
+        return item;
+    }
+
+    // Non-blocking pop: nullopt when nothing is queued right now
+    std::optional<T> tryPop() {
+        QMutexLocker lock(&m_mutex);
+        if (m_items.empty()) return std::nullopt;
+
+        T item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.wakeOne();
+        return item;
+    }
+
+    // No more pushes; consumers drain the remaining items
+    void close() {
+        QMutexLocker lock(&m_mutex);
+        m_closed = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+    // Close and drop whatever is still queued
+    void abort() {
+        QMutexLocker lock(&m_mutex);
+        m_closed = true;
+        m_items.clear();
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+    void reset() {
+        QMutexLocker lock(&m_mutex);
+        m_closed = false;
+        m_items.clear();
+    }
+
+    int size() const {
+        QMutexLocker lock(&m_mutex);
+        return int(m_items.size());
+    }
+
+    int capacity() const { return m_capacity; }
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    std::deque<T> m_items;
+    const int m_capacity;
+    bool m_closed = false;
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,106 @@
+#include "CatalogProtocol.h"
+#include <QBuffer>
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QtEndian>
+
+namespace PhotoGuru {
+
+QJsonObject CatalogProtocol::recordToJson(const PhotoDatabase::CatalogRecord& record) {
+    QJsonObject json{{"seq", record.seq}, {"path", record.path}};
+    if (!record.metadata.isEmpty()) {
+        json["mtime"] = record.mtime;
+        json["size"] = record.size;
+        json["metadata"] = QJsonDocument::fromJson(record.metadata).object();
+    }
+    if (record.removed) json["removed"] = true;
+    if (record.fingerprint) {
+        QJsonObject fingerprint{
+            {"mtime", record.fingerprint->mtime},
+            {"size", record.fingerprint->size},
+            {"quick", QString::fromLatin1(record.fingerprint->quick.toBase64())},
+        };
+        if (!record.fingerprint->full.isEmpty()) {
+            fingerprint["full"] = QString::fromLatin1(record.fingerprint->full.toBase64());
+        }
+        json["fingerprint"] = fingerprint;
+    }
+    if (record.perceptualHash) {
+        json["phash"] = QJsonObject{
+            {"mtime", record.perceptualHash->mtime},
+            {"size", record.perceptualHash->size},
+            {"hash", QString::number(record.perceptualHash->hash)},
+        };
+    }
+    return json;
+}
+
+PhotoDatabase::CatalogRecord CatalogProtocol::recordFromJson(const QJsonObject& json) {
+    PhotoDatabase::CatalogRecord record;
+    record.seq = json.value("seq").toInteger();
+    record.path = json.value("path").toString();
+    record.removed = json.value("removed").toBool();
+
+    const QJsonObject metadata = json.value("metadata").toObject();
+    if (!metadata.isEmpty()) {
+        record.mtime = json.value("mtime").toInteger();
+        record.size = json.value("size").toInteger();
+        record.metadata = QJsonDocument(metadata).toJson(QJsonDocument::Compact);
+    }
+
+    const QJsonObject fingerprint = json.value("fingerprint").toObject();
+    const QByteArray quick = QByteArray::fromBase64(fingerprint.value("quick").toString().toLatin1());
+    if (!quick.isEmpty()) {
+        record.fingerprint = PhotoDatabase::Fingerprint{
+            record.path, fingerprint.value("mtime").toInteger(), fingerprint.value("size").toInteger(), quick,
+            QByteArray::fromBase64(fingerprint.value("full").toString().toLatin1())};
+    }
+
+    const QJsonObject hash = json.value("phash").toObject();
+    bool ok = false;
+    const quint64 value = hash.value("hash").toString().toULongLong(&ok);
+    if (ok) {
+        record.perceptualHash = PhotoDatabase::PerceptualHashRecord{
+            hash.value("mtime").toInteger(), hash.value("size").toInteger(), value};
+    }
+    return record;
+}
+
+QString CatalogProtocol::encodeEmbedding(const float* values, int dimension) {
+    QByteArray bytes(int(dimension * sizeof(float)), Qt::Uninitialized);
+    for (int i = 0; i < dimension; ++i) {
+        qToLittleEndian(values[i], bytes.data() + i * sizeof(float));
+    }
+    return QString::fromLatin1(bytes.toBase64());
+}
+
+std::vector<float> CatalogProtocol::decodeEmbedding(const QString& encoded) {
+    const QByteArray bytes = QByteArray::fromBase64(encoded.toLatin1());
+    if (bytes.isEmpty() || bytes.size() % int(sizeof(float)) != 0) return {};
+
+    std::vector<float> values(size_t(bytes.size()) / sizeof(float));
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = qFromLittleEndian<float>(bytes.constData() + i * sizeof(float));
+    }
+    return values;
+}
+
+QJsonValue CatalogProtocol::encodeImage(const QImage& image) {
+    if (image.isNull()) return QJsonValue::Null;
+
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    if (!image.save(&buffer, "JPEG", JPEG_QUALITY)) return QJsonValue::Null;
+    return QString::fromLatin1(jpeg.toBase64());
+}
+
+QImage CatalogProtocol::decodeImage(const QJsonValue& value) {
+    QImage image;
+    if (value.isString()) {
+        image.loadFromData(QByteArray::fromBase64(value.toString().toLatin1()), "JPEG");
+    }
+    return image;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "PhotoDatabase.h"
+#include <QImage>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QString>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Wire format between CatalogSync and CatalogServer
+ *
+ * JSON over HTTP/1.1, paged by what the client already has:
+ *   GET  /v1/catalog                              -> {id, seq, photos, embeddings: {model, dim, store, rows}}
+ *   GET  /v1/catalog/changes?since=seq&limit=n    -> {records: [...], seq, more}
+ *   GET  /v1/catalog/embeddings?since=row&limit=n -> {store, rows: [{path, mtime, size, embedding}], next, more}
+ *   POST /v1/catalog/thumbnails {width, height, files: [{path, mtime, size}]} -> {thumbnails: [...]}
+ *
+ * A record is a PhotoDatabase::CatalogRecord: the metadata as the catalog
+ * stores it (absent for a path that isn't a cataloged photo, with
+ * "removed": true once the photo is gone), plus the fingerprint and
+ * perceptual hash with the file versions they were taken from. 64-bit
+ * values that JSON numbers can't hold exactly (hashes, store ids) travel
+ * as decimal strings, embeddings as base64 little-endian float32 and
+ * thumbnails as base64 JPEG; null for a thumbnail the server doesn't have.
+ */
+class CatalogProtocol {
+public:
+    static constexpr const char* INFO_PATH = "/v1/catalog";
+    static constexpr const char* CHANGES_PATH = "/v1/catalog/changes";
+    static constexpr const char* EMBEDDINGS_PATH = "/v1/catalog/embeddings";
+    static constexpr const char* THUMBNAILS_PATH = "/v1/catalog/thumbnails";
+    static constexpr int JPEG_QUALITY = 90;
+
+    // Page sizes; the server clamps what clients ask for to these
+    static constexpr int MAX_CHANGES = 2000;
+    static constexpr int MAX_EMBEDDINGS = 2000;
+    static constexpr int MAX_THUMBNAILS = 256;
+
+    static QJsonObject recordToJson(const PhotoDatabase::CatalogRecord& record);
+    static PhotoDatabase::CatalogRecord recordFromJson(const QJsonObject& json);
+
+    static QString encodeEmbedding(const float* values, int dimension);
+    static std::vector<float> decodeEmbedding(const QString& encoded);  // Empty if malformed
+
+    static QJsonValue encodeImage(const QImage& image);  // Null for a null image
+    static QImage decodeImage(const QJsonValue& value);
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,156 @@
+#include "CatalogServer.h"
+#include "CatalogProtocol.h"
+#include "EmbeddingStore.h"
+#include "PhotoDatabase.h"
+#include "ThumbnailCache.h"
+#include "Trace.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <algorithm>
+
+namespace PhotoGuru {
+
+namespace {
+
+// `name` from the query as a count no larger than `max`; `max` when absent
+int pageSize(const QUrlQuery& query, const char* name, int max) {
+    bool ok = false;
+    const int value = query.queryItemValue(name).toInt(&ok);
+    return ok ? std::clamp(value, 1, max) : max;
+}
+
+qint64 position(const QUrlQuery& query, const char* name) {
+    return std::max<qint64>(0, query.queryItemValue(name).toLongLong());
+}
+
+} // namespace
+
+CatalogServer::CatalogServer(EmbeddingStore* embeddings, QObject* parent)
+    : QObject(parent)
+    , m_embeddings(embeddings)
+    , m_http("CatalogServer")
+{
+    m_tasks.setMaxConcurrency(THREADS);
+
+    auto handler = [this](QJsonObject (CatalogServer::*method)(const JsonHttpServer::Request&, int*)) {
+        return [this, method](const JsonHttpServer::Request& request, int* status) {
+            return (this->*method)(request, status);
+        };
+    };
+    m_http.route("GET", CatalogProtocol::INFO_PATH, handler(&CatalogServer::info), &m_tasks);
+    m_http.route("GET", CatalogProtocol::CHANGES_PATH, handler(&CatalogServer::changes), &m_tasks);
+    m_http.route("GET", CatalogProtocol::EMBEDDINGS_PATH, handler(&CatalogServer::embeddings), &m_tasks);
+    m_http.route("POST", CatalogProtocol::THUMBNAILS_PATH, handler(&CatalogServer::thumbnails), &m_tasks);
+}
+
+CatalogServer::~CatalogServer() {
+    m_http.close();
+    m_tasks.waitForDone();
+}
+
+bool CatalogServer::listen(const QHostAddress& address, quint16 port) {
+    return m_http.listen(address, port);
+}
+
+QJsonObject CatalogServer::info(const JsonHttpServer::Request& request, int* status) {
+    PhotoDatabase& catalog = PhotoDatabase::instance();
+    const QString id = catalog.catalogId();
+    if (id.isEmpty()) {
+        *status = 500;
+        return JsonHttpServer::error("Catalog unavailable");
+    }
+
+    QJsonObject json{{"id", id}, {"seq", catalog.changeSequence()}, {"photos", catalog.photoCount()}};
+    if (m_embeddings && m_embeddings->isOpen()) {
+        json["embeddings"] = QJsonObject{
+            {"model", m_embeddings->modelVersion()},
+            {"dim", m_embeddings->dimension()},
+            {"store", QString::number(m_embeddings->storeId())},
+            {"rows", m_embeddings->rowCount()},
+        };
+    }
+    emit log(QString("info for %1").arg(request.peer));
+    return json;
+}
+
+QJsonObject CatalogServer::changes(const JsonHttpServer::Request& request, int*) {
+    const qint64 since = position(request.query, "since");
+    const int limit = pageSize(request.query, "limit", CatalogProtocol::MAX_CHANGES);
+
+    TRACE_SCOPE("catalog_server.changes");
+    std::vector<PhotoDatabase::CatalogRecord> records = PhotoDatabase::instance().changesSince(since, limit + 1);
+    const bool more = int(records.size()) > limit;
+    if (more) records.pop_back();
+
+    QJsonArray array;
+    for (const PhotoDatabase::CatalogRecord& record : records) {
+        array.append(CatalogProtocol::recordToJson(record));
+    }
+    const qint64 last = records.empty() ? since : records.back().seq;
+    if (!records.empty()) {
+        emit log(QString("changes: %1 after %2 for %3").arg(records.size()).arg(since).arg(request.peer));
+    }
+    return QJsonObject{{"records", array}, {"seq", last}, {"more", more}};
+}
+
+QJsonObject CatalogServer::embeddings(const JsonHttpServer::Request& request, int* status) {
+    if (!m_embeddings || !m_embeddings->isOpen()) {
+        *status = 404;
+        return JsonHttpServer::error("This server has no embeddings");
+    }
+    const int since = int(std::min<qint64>(position(request.query, "since"), m_embeddings->rowCount()));
+    const int limit = pageSize(request.query, "limit", CatalogProtocol::MAX_EMBEDDINGS);
+
+    TRACE_SCOPE("catalog_server.embeddings");
+    const int dimension = m_embeddings->dimension();
+    const EmbeddingStore::Matrix matrix = m_embeddings->matrix();
+    const int end = std::min(matrix.rows, since + limit);
+    QJsonArray rows;
+    for (int id = since; id < end; ++id) {
+        // Superseded rows are skipped: the newer row comes later in the store
+        if (!m_embeddings->isLive(id)) continue;
+        const float* values = matrix.row(id);
+        const EmbeddingStore::Key key = m_embeddings->keyOf(id);
+        rows.append(QJsonObject{
+            {"path", m_embeddings->pathOf(id)},
+            {"mtime", key.mtime},
+            {"size", key.fileSize},
+            {"embedding", CatalogProtocol::encodeEmbedding(values, dimension)},
+        });
+    }
+    if (!rows.isEmpty()) {
+        emit log(QString("embeddings: %1 from row %2 for %3").arg(rows.size()).arg(since).arg(request.peer));
+    }
+    return QJsonObject{
+        {"store", QString::number(m_embeddings->storeId())},
+        {"rows", rows},
+        {"next", end},
+        {"more", end < m_embeddings->rowCount()},
+    };
+}
+
+QJsonObject CatalogServer::thumbnails(const JsonHttpServer::Request& request, int* status) {
+    const QJsonObject json = QJsonDocument::fromJson(request.body).object();
+    const QSize size(json.value("width").toInt(), json.value("height").toInt());
+    const QJsonArray files = json.value("files").toArray();
+    if (size.isEmpty() || files.isEmpty() || files.size() > CatalogProtocol::MAX_THUMBNAILS) {
+        *status = files.size() > CatalogProtocol::MAX_THUMBNAILS ? 413 : 400;
+        return JsonHttpServer::error(QString("Expected a size and 1-%1 files").arg(CatalogProtocol::MAX_THUMBNAILS));
+    }
+
+    TRACE_SCOPE("catalog_server.thumbnails");
+    ThumbnailCache& cache = ThumbnailCache::instance();
+    QJsonArray thumbnails;
+    int found = 0;
+    for (const QJsonValue& value : files) {
+        const QJsonObject file = value.toObject();
+        const QImage thumbnail = cache.storedThumbnail(file.value("path").toString(), file.value("mtime").toInteger(),
+                                                       file.value("size").toInteger(), size);
+        if (!thumbnail.isNull()) ++found;
+        thumbnails.append(CatalogProtocol::encodeImage(thumbnail));
+    }
+    emit log(QString("thumbnails: %1 of %2 for %3").arg(found).arg(files.size()).arg(request.peer));
+    return QJsonObject{{"thumbnails", thumbnails}};
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "JsonHttpServer.h"
+#include "TaskScheduler.h"
+#include <QObject>
+#include <QHostAddress>
+#include <QJsonObject>
+
+namespace PhotoGuru {
+
+class EmbeddingStore;
+
+/**
+ * @brief Serves this machine's catalog to CatalogSync clients over HTTP
+ *
+ * Run where the library was indexed (photoguru-cli --serve-catalog), so
+ * other workstations pull the metadata, fingerprints, perceptual hashes,
+ * thumbnails and embeddings instead of computing them again. Clients page
+ * through the change log by sequence number and through the embedding
+ * store by row, so each sync moves only what changed (CatalogProtocol).
+ *
+ * Thumbnails come from the ThumbnailCache disk tier and are never decoded
+ * here: a file the server has no thumbnail for gets null, and the client
+ * makes its own. Requests run on TaskScheduler workers at Ingest
+ * priority, THREADS at a time, each worker on its own catalog connection;
+ * HTTP and the token check are JsonHttpServer's. log() is emitted from
+ * the workers.
+ */
+class CatalogServer : public QObject {
+    Q_OBJECT
+
+public:
+    // Serves PhotoDatabase::instance() and ThumbnailCache::instance();
+    // embeddings may be null (none served) and must outlive the server
+    explicit CatalogServer(EmbeddingStore* embeddings = nullptr, QObject* parent = nullptr);
+    ~CatalogServer();
+
+    void setToken(const QString& token) { m_http.setToken(token); }
+
+    bool listen(const QHostAddress& address = QHostAddress::Any, quint16 port = DEFAULT_PORT);
+    void close() { m_http.close(); }
+    quint16 port() const { return m_http.port(); }
+    QString errorString() const { return m_http.errorString(); }
+
+    static constexpr quint16 DEFAULT_PORT = 8766;
+    static constexpr int THREADS = 2;
+
+signals:
+    void log(const QString& message);
+
+private:
+    QJsonObject info(const JsonHttpServer::Request& request, int* status);
+    QJsonObject changes(const JsonHttpServer::Request& request, int* status);
+    QJsonObject embeddings(const JsonHttpServer::Request& request, int* status);
+    QJsonObject thumbnails(const JsonHttpServer::Request& request, int* status);
+
+    EmbeddingStore* m_embeddings;
+    JsonHttpServer m_http;
+    TaskGroup m_tasks{TaskScheduler::Ingest};  // Last: waits for handlers before the rest goes
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,209 @@
+#include "CatalogSync.h"
+#include "CatalogProtocol.h"
+#include "EmbeddingStore.h"
+#include "JsonHttpClient.h"
+#include "ThumbnailCache.h"
+#include "Trace.h"
+#include <QDir>
+#include <QJsonArray>
+#include <QDebug>
+#include <algorithm>
+
+namespace PhotoGuru {
+
+CatalogSync::CatalogSync(const QUrl& server, const QString& token)
+    : m_server(server)
+    , m_token(token)
+{
+}
+
+void CatalogSync::setPathMapping(const QString& serverRoot, const QString& localRoot) {
+    m_serverRoot = QDir::cleanPath(serverRoot);
+    m_localRoot = QDir::cleanPath(localRoot);
+}
+
+QString CatalogSync::localPath(const QString& serverPath) const {
+    if (m_serverRoot.isEmpty()) return serverPath;
+    if (serverPath == m_serverRoot) return m_localRoot;
+
+    // "/" as the root is its own prefix
+    const QString prefix = m_serverRoot.endsWith('/') ? m_serverRoot : m_serverRoot + '/';
+    if (!serverPath.startsWith(prefix)) return QString();
+    return QDir::cleanPath(m_localRoot + '/' + serverPath.mid(prefix.size()));
+}
+
+std::optional<CatalogSync::Result> CatalogSync::sync(const QAtomicInt* cancel) {
+    m_lastError.clear();
+    if (!PhotoDatabase::instance().isInitialized()) {
+        m_lastError = "Local catalog is not open";
+        return std::nullopt;
+    }
+
+    std::optional<QJsonObject> info = request(CatalogProtocol::INFO_PATH, QUrlQuery());
+    if (!info) return std::nullopt;
+    const QString catalogId = info->value("id").toString();
+    if (catalogId.isEmpty()) {
+        m_lastError = m_server.toString() + ": no catalog id";
+        return std::nullopt;
+    }
+    // Without a mapping that would only rewrite every entry as it is
+    if (m_serverRoot.isEmpty() && catalogId == PhotoDatabase::instance().catalogId()) {
+        m_lastError = m_server.toString() + " serves this catalog";
+        return std::nullopt;
+    }
+
+    Result result;
+    if (!pullChanges(catalogId, result, cancel)) return std::nullopt;
+    if (!pullEmbeddings(*info, result, cancel)) return std::nullopt;
+    qDebug() << "[CatalogSync]" << m_server.toString() << "-" << result.records << "records,"
+             << result.thumbnails << "thumbnails," << result.embeddings << "embeddings";
+    return result;
+}
+
+bool CatalogSync::pullChanges(const QString& catalogId, Result& result, const QAtomicInt* cancel) {
+    PhotoDatabase& catalog = PhotoDatabase::instance();
+    const QString name = cursorName("changes");
+    std::optional<PhotoDatabase::SyncCursor> cursor = catalog.syncCursor(name);
+    qint64 since = cursor && cursor->origin == catalogId ? cursor->position : 0;
+
+    bool more = true;
+    while (more && !(cancel && cancel->loadRelaxed())) {
+        QUrlQuery query;
+        query.addQueryItem("since", QString::number(since));
+        query.addQueryItem("limit", QString::number(CatalogProtocol::MAX_CHANGES));
+        std::optional<QJsonObject> page = request(CatalogProtocol::CHANGES_PATH, query);
+        if (!page) return false;
+
+        std::vector<PhotoDatabase::CatalogRecord> served;
+        std::vector<PhotoDatabase::CatalogRecord> local;
+        for (const QJsonValue& value : page->value("records").toArray()) {
+            PhotoDatabase::CatalogRecord record = CatalogProtocol::recordFromJson(value.toObject());
+            const QString path = localPath(record.path);
+            if (record.path.isEmpty() || path.isEmpty()) continue;
+            served.push_back(record);
+            record.path = path;
+            if (record.fingerprint) record.fingerprint->path = path;
+            if (record.removed) ++result.removed;
+            local.push_back(std::move(record));
+        }
+
+        {
+            TRACE_SCOPE("catalog_sync.apply");
+            if (!catalog.applyChanges(local)) {
+                m_lastError = "Could not store the server's records";
+                return false;
+            }
+        }
+        result.records += int(local.size());
+        if (!pullThumbnails(served, result)) return false;
+
+        // Only once the page is stored: a sync cut short repeats it, harmlessly
+        since = std::max(since, page->value("seq").toInteger());
+        more = page->value("more").toBool();
+        catalog.setSyncCursor(name, PhotoDatabase::SyncCursor{catalogId, since});
+    }
+    return true;
+}
+
+bool CatalogSync::pullThumbnails(const std::vector<PhotoDatabase::CatalogRecord>& records, Result& result) {
+    std::vector<const PhotoDatabase::CatalogRecord*> present;
+    for (const PhotoDatabase::CatalogRecord& record : records) {
+        if (!record.metadata.isEmpty()) present.push_back(&record);
+    }
+
+    ThumbnailCache& cache = ThumbnailCache::instance();
+    for (const QSize& size : m_thumbnailSizes) {
+        for (size_t start = 0; start < present.size(); start += CatalogProtocol::MAX_THUMBNAILS) {
+            const size_t end = std::min(present.size(), start + CatalogProtocol::MAX_THUMBNAILS);
+            QJsonArray files;
+            for (size_t i = start; i < end; ++i) {
+                files.append(QJsonObject{
+                    {"path", present[i]->path}, {"mtime", present[i]->mtime}, {"size", present[i]->size}});
+            }
+            QJsonObject body{{"width", size.width()}, {"height", size.height()}, {"files", files}};
+            std::optional<QJsonObject> reply = request(CatalogProtocol::THUMBNAILS_PATH, QUrlQuery(), body);
+            if (!reply) return false;
+
+            const QJsonArray thumbnails = reply->value("thumbnails").toArray();
+            for (size_t i = start; i < end && int(i - start) < thumbnails.size(); ++i) {
+                const QImage thumbnail = CatalogProtocol::decodeImage(thumbnails[int(i - start)]);
+                if (thumbnail.isNull()) continue;
+                const PhotoDatabase::CatalogRecord& record = *present[i];
+                if (cache.storeThumbnail(localPath(record.path), record.mtime, record.size, size, thumbnail)) {
+                    ++result.thumbnails;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool CatalogSync::pullEmbeddings(const QJsonObject& info, Result& result, const QAtomicInt* cancel) {
+    const QJsonObject served = info.value("embeddings").toObject();
+    if (!m_embeddings || served.isEmpty()) return true;
+    if (!m_embeddings->isOpen() &&
+        (m_embeddingDirectory.isEmpty() ||
+         !m_embeddings->open(m_embeddingDirectory, served.value("model").toString(), served.value("dim").toInt()))) {
+        return true;
+    }
+    if (served.value("model").toString() != m_embeddings->modelVersion() ||
+        served.value("dim").toInt() != m_embeddings->dimension()) {
+        qDebug() << "[CatalogSync] Server embeddings are from" << served.value("model").toString()
+                 << "- not" << m_embeddings->modelVersion() << ", skipping them";
+        return true;
+    }
+
+    // Rows count within one store; a recreated one is pulled from the start
+    const QString origin = served.value("model").toString() + '/' + served.value("store").toString();
+    const QString name = cursorName("embeddings");
+    std::optional<PhotoDatabase::SyncCursor> cursor = PhotoDatabase::instance().syncCursor(name);
+    qint64 since = cursor && cursor->origin == origin ? cursor->position : 0;
+
+    bool more = since < served.value("rows").toInteger();
+    while (more && !(cancel && cancel->loadRelaxed())) {
+        QUrlQuery query;
+        query.addQueryItem("since", QString::number(since));
+        query.addQueryItem("limit", QString::number(CatalogProtocol::MAX_EMBEDDINGS));
+        std::optional<QJsonObject> page = request(CatalogProtocol::EMBEDDINGS_PATH, query);
+        if (!page) return false;
+        if (page->value("store").toString() != served.value("store").toString()) {
+            m_lastError = "The server's embedding store was recreated during the sync";
+            return false;
+        }
+
+        TRACE_SCOPE("catalog_sync.embeddings");
+        for (const QJsonValue& value : page->value("rows").toArray()) {
+            const QJsonObject row = value.toObject();
+            const QString path = localPath(row.value("path").toString());
+            if (path.isEmpty()) continue;
+            if (m_embeddings->insert(path, row.value("mtime").toInteger(), row.value("size").toInteger(),
+                                     CatalogProtocol::decodeEmbedding(row.value("embedding").toString()))) {
+                ++result.embeddings;
+            }
+        }
+
+        since = std::max(since, page->value("next").toInteger());
+        more = page->value("more").toBool();
+        PhotoDatabase::instance().setSyncCursor(name, PhotoDatabase::SyncCursor{origin, since});
+    }
+    return true;
+}
+
+std::optional<QJsonObject> CatalogSync::request(const QString& path, const QUrlQuery& query,
+                                                const std::optional<QJsonObject>& body) {
+    QString error;
+    std::optional<QJsonObject> reply =
+        JsonHttpClient::request(m_server, m_token, path, query, body, m_requestTimeoutMs, &error);
+    if (!reply) {
+        qWarning() << "[CatalogSync]" << error;
+        m_lastError = error;
+    }
+    return reply;
+}
+
+QString CatalogSync::cursorName(const QString& kind) const {
+    // One cursor per server and mapping: another mapping takes other records
+    return QString("%1 %2 %3>%4").arg(kind, m_server.toString(), m_serverRoot, m_localRoot);
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "PhotoDatabase.h"
+#include <QAtomicInt>
+#include <QJsonObject>
+#include <QList>
+#include <QSize>
+#include <QString>
+#include <QUrl>
+#include <QUrlQuery>
+#include <optional>
+#include <vector>
+
+namespace PhotoGuru {
+
+class EmbeddingStore;
+
+/**
+ * @brief Pulls another machine's catalog from its CatalogServer
+ *
+ * Records changed since the last sync go into PhotoDatabase::instance(),
+ * their thumbnails into the ThumbnailCache disk tier and, with a store
+ * given, embeddings into it. How far each got is kept as a sync cursor in
+ * the local catalog, after the page it covers is stored, so an interrupted
+ * sync resumes and a finished one costs a request per kind. A server
+ * whose catalog (or embedding store) was recreated is pulled from the
+ * start again.
+ *
+ * Entries keep the file versions (mtime + size) the server recorded, so
+ * they count only where the files read the same here: the same share,
+ * mounted under another root if need be (setPathMapping). Files that
+ * differ are re-read locally as always. Faces and people stay per catalog.
+ *
+ * Blocks the calling thread; not thread-safe.
+ */
+class CatalogSync {
+public:
+    struct Result {
+        int records = 0;     // Catalog entries stored (removals included)
+        int removed = 0;
+        int thumbnails = 0;
+        int embeddings = 0;
+    };
+
+    explicit CatalogSync(const QUrl& server, const QString& token = QString());
+
+    // Server paths under serverRoot are under localRoot here; others are skipped
+    void setPathMapping(const QString& serverRoot, const QString& localRoot);
+    // A closed store is opened in `directory` with the server's model; an
+    // open one of another model or dimension than the server's is left alone
+    void setEmbeddingStore(EmbeddingStore* store, const QString& directory = QString()) {
+        m_embeddings = store;
+        m_embeddingDirectory = directory;
+    }
+    // Thumbnail sizes pulled with each record; empty pulls none
+    void setThumbnailSizes(const QList<QSize>& sizes) { m_thumbnailSizes = sizes; }
+    void setRequestTimeout(int ms) { m_requestTimeoutMs = ms; }
+
+    // Everything new since the last sync; stops after the page in progress on cancel
+    std::optional<Result> sync(const QAtomicInt* cancel = nullptr);
+    QString lastError() const { return m_lastError; }
+
+    // The local path of a server path; empty if outside the mapping
+    QString localPath(const QString& serverPath) const;
+
+    static constexpr int REQUEST_TIMEOUT_MS = 60 * 1000;
+    static constexpr int DEFAULT_THUMBNAIL_EDGE = 150;  // ThumbnailGrid's default cell
+
+private:
+    bool pullChanges(const QString& catalogId, Result& result, const QAtomicInt* cancel);
+    bool pullThumbnails(const std::vector<PhotoDatabase::CatalogRecord>& records, Result& result);
+    bool pullEmbeddings(const QJsonObject& info, Result& result, const QAtomicInt* cancel);
+    std::optional<QJsonObject> request(const QString& path, const QUrlQuery& query,
+                                       const std::optional<QJsonObject>& body = std::nullopt);
+    QString cursorName(const QString& kind) const;
+
+    QUrl m_server;
+    QString m_token;
+    QString m_serverRoot;
+    QString m_localRoot;
+    EmbeddingStore* m_embeddings = nullptr;
+    QString m_embeddingDirectory;
+    QList<QSize> m_thumbnailSizes{QSize(DEFAULT_THUMBNAIL_EDGE, DEFAULT_THUMBNAIL_EDGE)};
+    int m_requestTimeoutMs = REQUEST_TIMEOUT_MS;
+    QString m_lastError;
+};
+
+} // namespace PhotoGuru
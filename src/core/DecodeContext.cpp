@@ -0,0 +1,129 @@
+#include "DecodeContext.h"
+#include "ImageLoader.h"
+#include "PixelBuffer.h"
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace PhotoGuru {
+
+struct DecodeContext::State {
+    QString path;
+    int maxEdge = 0;
+
+    QMutex mutex;
+    bool decoded = false;
+    QImage image;
+    QHash<qint64, QImage> views;  // (edge << 2) | kind
+
+    // Caller holds mutex
+    const QImage& decode() {
+        if (!decoded) {
+            QSize bound = maxEdge > 0 ? QSize(maxEdge, maxEdge) : QSize();
+            auto loaded = ImageLoader::instance().load(path, bound);
+            image = loaded ? *loaded : QImage();
+            if (maxEdge > 0 && std::max(image.width(), image.height()) > maxEdge) {
+                // Formats without a scaled decode (RAW demosaic, HEIF without thumbnail)
+                image = image.scaled(maxEdge, maxEdge, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            }
+            decoded = true;
+        }
+        return image;
+    }
+};
+
+DecodeContext::DecodeContext(const QString& path, int maxEdge)
+    : m_state(std::make_shared<State>())
+{
+    m_state->path = path;
+    m_state->maxEdge = std::max(0, maxEdge);
+}
+
+DecodeContext DecodeContext::fromImage(const QString& path, const QImage& image) {
+    DecodeContext context(path);
+    context.m_state->image = image;
+    context.m_state->decoded = true;
+    return context;
+}
+
+QString DecodeContext::path() const {
+    return m_state ? m_state->path : QString();
+}
+
+int DecodeContext::maxEdge() const {
+    return m_state ? m_state->maxEdge : 0;
+}
+
+void DecodeContext::require(int edge) {
+    if (!m_state) return;
+    QMutexLocker lock(&m_state->mutex);
+    if (m_state->decoded || m_state->maxEdge == 0) return;
+    m_state->maxEdge = edge <= 0 ? 0 : std::max(m_state->maxEdge, edge);
+}
+
+QImage DecodeContext::image() const {
+    if (!m_state) return QImage();
+    QMutexLocker lock(&m_state->mutex);
+    return m_state->decode();
+}
+
+bool DecodeContext::isDecoded() const {
+    if (!m_state) return false;
+    QMutexLocker lock(&m_state->mutex);
+    return m_state->decoded;
+}
+
+QImage DecodeContext::fitted(int edge) const {
+    return view(View::Fitted, edge);
+}
+
+QImage DecodeContext::squared(int edge) const {
+    return view(View::Squared, edge);
+}
+
+QImage DecodeContext::rgb888(int edge) const {
+    return view(View::Rgb888, edge);
+}
+
+void DecodeContext::release() {
+    if (!m_state) return;
+    QMutexLocker lock(&m_state->mutex);
+    m_state->image = QImage();
+    m_state->views.clear();
+    m_state->decoded = false;
+}
+
+QImage DecodeContext::view(View kind, int edge) const {
+    if (!m_state || edge <= 0) return QImage();
+    QMutexLocker lock(&m_state->mutex);
+    const QImage& source = m_state->decode();
+    if (source.isNull()) return QImage();
+
+    const qint64 key = (qint64(edge) << 2) | qint64(kind);
+    auto cached = m_state->views.constFind(key);
+    if (cached != m_state->views.constEnd()) return *cached;
+
+    auto fit = [&source, edge]() {
+        return std::max(source.width(), source.height()) <= edge
+            ? source
+            : source.scaled(edge, edge, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    };
+    QImage result;
+    switch (kind) {
+        case View::Fitted:
+            result = fit();
+            break;
+        case View::Squared:
+            result = source.scaled(edge, edge, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            break;
+        case View::Rgb888:
+            // Packed rows: llama.cpp bitmaps take width * 3 bytes per row
+            result = PixelBuffer(fit()).converted(QImage::Format_RGB888).packed().image();
+            break;
+    }
+    m_state->views.insert(key, result);
+    return result;
+}
+
+} // namespace PhotoGuru
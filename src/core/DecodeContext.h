@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QImage>
+#include <QString>
+#include <memory>
+
+namespace PhotoGuru {
+
+/**
+ * @brief One file's pixels, decoded once for every consumer that needs them
+ *
+ * The first call that wants pixels decodes the file through ImageLoader,
+ * so RAW and HEIF work for every consumer, bounded to the largest edge
+ * any of them asked for. Consumers then take views of that decode:
+ *   fitted(edge)  - aspect kept, never upscaled (quality, thumbnails)
+ *   squared(edge) - stretched to a model input (CLIP)
+ *   rgb888(edge)  - fitted, packed RGB888 as llama.cpp bitmaps take it (VLM)
+ * Views are cached per size, so a second consumer of the same view gets
+ * it for free.
+ *
+ * Copies share the decode and may be used from different threads; the
+ * first decode blocks the others instead of starting a second one.
+ * Pixels are freed with the last copy, or earlier by release().
+ */
+class DecodeContext {
+public:
+    DecodeContext() = default;
+
+    // maxEdge bounds the decode's longest edge (0: full resolution)
+    explicit DecodeContext(const QString& path, int maxEdge = 0);
+
+    // Already-decoded pixels (e.g. the image on screen), served as views
+    static DecodeContext fromImage(const QString& path, const QImage& image);
+
+    QString path() const;
+    int maxEdge() const;
+
+    // Raises the bound for a consumer that needs more; no effect once decoded
+    void require(int edge);
+
+    // Decodes on first use; null if the file can't be decoded
+    QImage image() const;
+    bool isNull() const { return image().isNull(); }
+    bool isDecoded() const;
+
+    QImage fitted(int edge) const;
+    QImage squared(int edge) const;
+    QImage rgb888(int edge) const;
+
+    // Drops the decode and its views; a later call decodes again
+    void release();
+
+private:
+    enum class View { Fitted, Squared, Rgb888 };
+    struct State;
+
+    QImage view(View kind, int edge) const;
+
+    std::shared_ptr<State> m_state;
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,301 @@
+#include "DecodedImageCache.h"
+#include "ImageLoader.h"
+#include "Trace.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <QRunnable>
+#include <QDebug>
+#include <climits>
+#include <memory>
+
+namespace PhotoGuru {
+
+DecodedImageCache::DecodedImageCache(QObject* parent)
+    : QObject(parent)
+{
+    setMaxBytes(DEFAULT_MAX_BYTES);
+    // Neighbours shouldn't take every core from the thumbnails on screen
+    m_prefetchTasks.setMaxConcurrency(PREFETCH_THREADS);
+}
+
+DecodedImageCache::~DecodedImageCache() {
+    m_prefetchTasks.clear();
+    m_tasks.clear();
+    m_prefetchTasks.waitForDone();
+    m_tasks.waitForDone();
+}
+
+bool DecodedImageCache::tryTake(QRunnable* task) {
+    return m_prefetchTasks.tryTake(task) || m_tasks.tryTake(task);
+}
+
+QString DecodedImageCache::cacheKey(const QString& path, Kind kind) {
+    QString key = path + '|' + QString::number(QFileInfo(path).lastModified().toMSecsSinceEpoch());
+    switch (kind) {
+        case Kind::Preview: return "p|" + key;
+        case Kind::Developed: return "d|" + key;
+        default: return key;
+    }
+}
+
+QString DecodedImageCache::taskId(const QString& path, Kind kind) {
+    return (kind == Kind::Preview ? "P:" : kind == Kind::Developed ? "D:" : "F:") + path;
+}
+
+QImage DecodedImageCache::findKind(const QString& path, Kind kind) const {
+    QImage* image = m_images.object(cacheKey(path, kind));
+    return image ? *image : QImage();
+}
+
+void DecodedImageCache::insertKind(const QString& key, const QImage& image) {
+    if (image.isNull()) return;
+    int cost = int(qBound<qint64>(1, image.sizeInBytes() / 1024, INT_MAX));
+    m_images.insert(key, new QImage(image), cost);
+}
+
+QImage DecodedImageCache::find(const QString& path) const {
+    QImage full = findKind(path, Kind::Full);
+    return full.isNull() ? findKind(path, Kind::Developed) : full;
+}
+
+QImage DecodedImageCache::findPreview(const QString& path) const {
+    QImage preview = findKind(path, Kind::Preview);
+    return preview.isNull() ? find(path) : preview;
+}
+
+void DecodedImageCache::insert(const QString& path, const QImage& image) {
+    insertKind(cacheKey(path, Kind::Full), image);
+}
+
+void DecodedImageCache::request(const QString& path) {
+    QImage cached = find(path);
+    if (!cached.isNull()) {
+        TRACE_COUNT("decoded_cache.hit", 1);
+        emit decoded(path, cached);
+        return;
+    }
+    TRACE_COUNT("decoded_cache.miss", 1);
+    requestKind(path, Kind::Full);
+}
+
+void DecodedImageCache::requestPreview(const QString& path) {
+    QImage cached = findPreview(path);
+    if (!cached.isNull()) {
+        TRACE_COUNT("decoded_cache.preview.hit", 1);
+        emit previewDecoded(path, cached);
+        return;
+    }
+    TRACE_COUNT("decoded_cache.preview.miss", 1);
+    requestKind(path, Kind::Preview);
+}
+
+void DecodedImageCache::requestKind(const QString& path, Kind kind) {
+    const QString id = taskId(path, kind);
+    m_requested.insert(id);
+    if (m_pending.contains(id)) {
+        // Queued as a prefetch: move it ahead. Already running: just wait.
+        QMutexLocker locker(&m_queueMutex);
+        QRunnable* task = m_queued.value(id);
+        if (!task || !tryTake(task)) {
+            return;
+        }
+        m_queued.remove(id);
+        delete task;
+        m_pending.remove(id);
+    }
+    startDecode(path, kind, TaskScheduler::Interactive);
+}
+
+void DecodedImageCache::prefetch(const QStringList& paths) {
+    QSet<QString> wanted;
+    for (const QString& path : paths) {
+        wanted.insert(taskId(path, Kind::Preview));
+    }
+
+    // Drop queued prefetches the user moved away from
+    {
+        QMutexLocker locker(&m_queueMutex);
+        for (auto it = m_queued.begin(); it != m_queued.end();) {
+            if (wanted.contains(it.key()) || m_requested.contains(it.key())) {
+                ++it;
+                continue;
+            }
+            if (m_prefetchTasks.tryTake(it.value())) {
+                delete it.value();
+                m_pending.remove(it.key());
+                it = m_queued.erase(it);
+            } else {
+                ++it;  // Started meanwhile; it removes itself
+            }
+        }
+    }
+
+    for (const QString& path : paths) {
+        if (!m_pending.contains(taskId(path, Kind::Preview)) && findPreview(path).isNull()) {
+            startDecode(path, Kind::Preview, TaskScheduler::Prefetch);
+        }
+    }
+}
+
+void DecodedImageCache::requestRegion(const QString& path, const QRect& region) {
+    // Every pixel already in memory: the worker only cuts. A RAW's full
+    // decode doesn't count, it was demosaiced for the screen (PPG)
+    QImage frame = findKind(path, Kind::Developed);
+    if (frame.isNull() && ImageLoader::instance().detectFormat(path) != ImageFormat::RAW) {
+        QImage full = findKind(path, Kind::Full);
+        if (!full.isNull() && full.size() == sourceSize(path)) frame = full;
+    }
+    if (frame.isNull()) {
+        TRACE_COUNT("decoded_cache.region.miss", 1);
+    } else {
+        TRACE_COUNT("decoded_cache.region.hit", 1);
+    }
+
+    auto self = std::make_shared<QRunnable*>(nullptr);
+    QRunnable* task = QRunnable::create([this, self, path, region, frame]() {
+        {
+            QMutexLocker locker(&m_queueMutex);
+            if (m_queuedRegion == *self) m_queuedRegion = nullptr;
+        }
+
+        QImage developed;
+        QImage image = decodeRegion(path, region, frame, &developed);
+        QMetaObject::invokeMethod(this, [this, path, region, image, developed]() {
+            if (!developed.isNull()) onDeveloped(path, developed);
+            if (image.isNull()) {
+                qWarning() << "[DecodedImageCache] Failed to decode region of:" << path;
+            }
+            emit regionDecoded(path, region, image);
+        }, Qt::QueuedConnection);
+    });
+
+    // The view moved on: the last region asked for is the only one wanted
+    QMutexLocker locker(&m_queueMutex);
+    if (m_queuedRegion && m_tasks.tryTake(m_queuedRegion)) {
+        delete m_queuedRegion;
+    }
+    *self = task;
+    m_queuedRegion = task;
+    m_tasks.start(task);
+}
+
+QImage DecodedImageCache::decodeRegion(const QString& path, const QRect& region,
+                                       const QImage& frame, QImage* developed) {
+    ImageLoader& loader = ImageLoader::instance();
+    ImageFormat format = loader.detectFormat(path);
+    const bool whole = format == ImageFormat::RAW || format == ImageFormat::HEIF;
+    QMutexLocker locker(&m_regionMutex);
+    if (!whole) {
+        m_regionSource = QImage();
+        m_regionSourceKey.clear();
+        locker.unlock();
+        if (!frame.isNull()) {
+            QRect clipped = region.intersected(frame.rect());
+            return clipped.isEmpty() ? QImage() : frame.copy(clipped);
+        }
+        std::optional<QImage> image = loader.loadRegion(path, region);
+        return image ? *image : QImage();
+    }
+
+    const QString key = cacheKey(path, Kind::Full);
+    if (!frame.isNull()) {
+        m_regionSource = frame;
+        m_regionSourceKey = key;
+    } else if (m_regionSourceKey != key) {
+        m_regionSource = QImage();  // Free the last file's frame before decoding this one
+        std::optional<QImage> full = loader.load(path);
+        m_regionSource = full ? *full : QImage();
+        m_regionSourceKey = key;
+        *developed = m_regionSource;
+    }
+    QRect clipped = region.intersected(m_regionSource.rect());
+    return clipped.isEmpty() ? QImage() : m_regionSource.copy(clipped);
+}
+
+void DecodedImageCache::onDeveloped(const QString& path, const QImage& frame) {
+    // Same picture as the full decode, every pixel of it: that one goes
+    m_images.remove(cacheKey(path, Kind::Full));
+    insertKind(cacheKey(path, Kind::Developed), frame);
+    m_sourceSizes.insert(cacheKey(path, Kind::Full), frame.size());
+}
+
+QSize DecodedImageCache::sourceSize(const QString& path) const {
+    return m_sourceSizes.value(cacheKey(path, Kind::Full));
+}
+
+bool DecodedImageCache::isPending(const QString& path) const {
+    return m_pending.contains(taskId(path, Kind::Full)) ||
+           m_pending.contains(taskId(path, Kind::Preview));
+}
+
+void DecodedImageCache::setMaxBytes(qint64 bytes) {
+    m_maxBytes = bytes;
+    m_images.setMaxCost(int(qBound<qint64>(1, bytes / 1024, INT_MAX)));
+}
+
+void DecodedImageCache::clear() {
+    m_images.clear();
+    m_sourceSizes.clear();
+}
+
+void DecodedImageCache::startDecode(const QString& path, Kind kind, TaskScheduler::Priority priority) {
+    const QString id = taskId(path, kind);
+    const QString key = cacheKey(path, kind);
+    const QSize size = kind == Kind::Preview ? m_previewSize : m_decodeSize;
+
+    QRunnable* task = QRunnable::create([this, path, kind, id, key, size]() {
+        {
+            QMutexLocker locker(&m_queueMutex);
+            m_queued.remove(id);
+        }
+
+        ImageLoader& loader = ImageLoader::instance();
+        std::optional<QImage> image;
+        bool isFull = false;
+        if (kind == Kind::Preview) {
+            image = loader.loadPreview(path, size, &isFull);
+        } else {
+            image = loader.load(path, size);
+        }
+        QImage result = image ? *image : QImage();
+        QSize sourceSize = isFull ? result.size() : loader.getImageDimensions(path);
+        QMetaObject::invokeMethod(this, [this, path, kind, key, result, isFull, sourceSize]() {
+            onDecoded(path, kind, key, result, isFull, sourceSize);
+        }, Qt::QueuedConnection);
+    });
+
+    m_pending.insert(id);
+    TRACE_GAUGE("decoded_cache.pending", m_pending.size());
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_queued.insert(id, task);
+    }
+    (priority == TaskScheduler::Prefetch ? m_prefetchTasks : m_tasks).start(task);
+}
+
+void DecodedImageCache::onDecoded(const QString& path, Kind kind, const QString& key,
+                                  const QImage& image, bool isFull, const QSize& sourceSize) {
+    const QString id = taskId(path, kind);
+    m_pending.remove(id);
+    m_requested.remove(id);
+    if (sourceSize.isValid()) {
+        m_sourceSizes.insert(cacheKey(path, Kind::Full), sourceSize);
+    }
+
+    if (image.isNull()) {
+        qWarning() << "[DecodedImageCache] Failed to decode:" << path;
+    } else if (kind == Kind::Preview && isFull) {
+        // Nothing more to decode: store once, as the full image
+        insert(path, image);
+    } else {
+        insertKind(key, image);
+    }
+
+    if (kind == Kind::Preview) {
+        emit previewDecoded(path, image);
+    } else {
+        emit decoded(path, image);
+    }
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QImage>
+#include <QSize>
+#include <QRect>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include "TaskScheduler.h"
+
+class QRunnable;
+
+namespace PhotoGuru {
+
+/**
+ * @brief Decodes for the viewer, preview first, with neighbour prefetch
+ *
+ * Two kinds of images share one LRU bounded in bytes, keyed by path +
+ * mtime so an edited file is decoded again:
+ *   preview - ImageLoader::loadPreview at previewSize(): RAW embedded
+ *             JPEG, HEIF thumbnail, JPEG decoded at screen size. Tens of
+ *             milliseconds; enough to show the image fitted.
+ *   full    - ImageLoader::load at decodeSize(), for zooming in. When a
+ *             preview already holds every pixel it is stored as both.
+ *
+ * Neither holds every pixel of a large frame, so 1:1 inspection goes
+ * through requestRegion(): the visible part at full resolution, only
+ * the latest request kept. Regions themselves aren't cached, but their
+ * source is when it had to be developed whole:
+ *   developed - the unbounded load() of a RAW (AHD) or HEIF, which has
+ *               no region decode. It replaces that file's full decode,
+ *               so returning to a RAW inspected recently finds every
+ *               pixel without another demosaic.
+ * Regions are cut from a developed frame, or from a full decode that
+ * already has the source size, whenever one is cached.
+ *
+ * requestPreview()/request() decode the image being shown ahead of
+ * everything else; prefetch() queues previews of the files around it so
+ * arrow-key navigation finds them ready. A new prefetch() drops queued
+ * prefetches that are no longer wanted (decodes already running finish
+ * and are cached).
+ *
+ * GUI thread only; decodes run on the TaskScheduler (requests in the
+ * Interactive class, prefetches in Prefetch, at most PREFETCH_THREADS
+ * of them at once) and the signals are emitted on the owner's thread.
+ */
+class DecodedImageCache : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DecodedImageCache(QObject* parent = nullptr);
+    ~DecodedImageCache();
+
+    // Full decode (or the developed frame); null if not decoded (or the file changed since)
+    QImage find(const QString& path) const;
+    void insert(const QString& path, const QImage& image);
+    
+    // Preview, or the full decode if that is all there is
+    QImage findPreview(const QString& path) const;
+
+    // Full decode ahead of any prefetch; decoded() follows (right away if cached)
+    void request(const QString& path);
+    
+    // Preview ahead of any prefetch; previewDecoded() follows (right away if cached)
+    void requestPreview(const QString& path);
+
+    // Full-resolution pixels of `region` (ImageLoader::loadRegion
+    // coordinates); replaces a region request that hasn't started yet
+    void requestRegion(const QString& path, const QRect& region);
+    
+    // Size load() gives without a bound; invalid until a decode of `path` finished
+    QSize sourceSize(const QString& path) const;
+
+    // Replaces the prefetch queue with previews of `paths`, most wanted first
+    void prefetch(const QStringList& paths);
+
+    bool isPending(const QString& path) const;  // Either kind queued or running
+
+    void setMaxBytes(qint64 bytes);
+    qint64 maxBytes() const { return m_maxBytes; }
+    qint64 usedBytes() const { return qint64(m_images.totalCost()) * 1024; }
+
+    // Bounds of full decodes and of previews
+    void setDecodeSize(const QSize& size) { m_decodeSize = size; }
+    QSize decodeSize() const { return m_decodeSize; }
+    void setPreviewSize(const QSize& size) { m_previewSize = size; }
+    QSize previewSize() const { return m_previewSize; }
+
+    void clear();
+    int count() const { return m_images.count(); }
+
+    static constexpr qint64 DEFAULT_MAX_BYTES = qint64(512) * 1024 * 1024;
+    static constexpr int PREFETCH_THREADS = 2;
+
+signals:
+    void decoded(const QString& path, const QImage& image);  // Null image: decode failed
+    void previewDecoded(const QString& path, const QImage& image);
+    void regionDecoded(const QString& path, const QRect& region, const QImage& image);
+
+private:
+    enum class Kind { Full, Preview, Developed };
+
+    static QString cacheKey(const QString& path, Kind kind);
+    static QString taskId(const QString& path, Kind kind);
+    QImage findKind(const QString& path, Kind kind) const;
+    void insertKind(const QString& key, const QImage& image);
+    void requestKind(const QString& path, Kind kind);
+    void startDecode(const QString& path, Kind kind, TaskScheduler::Priority priority);
+    bool tryTake(QRunnable* task);  // From whichever group queued it
+    void onDecoded(const QString& path, Kind kind, const QString& key,
+                   const QImage& image, bool isFull, const QSize& sourceSize);
+    // `frame`: a cached full-resolution frame to cut from (may be null).
+    // *developed is set to the frame when one had to be developed.
+    QImage decodeRegion(const QString& path, const QRect& region, const QImage& frame, QImage* developed);
+    void onDeveloped(const QString& path, const QImage& frame);
+
+    // Cost is KB so multi-GB budgets fit QCache's int
+    QCache<QString, QImage> m_images;
+    qint64 m_maxBytes = DEFAULT_MAX_BYTES;
+    QSize m_decodeSize{4000, 4000};
+    QSize m_previewSize{2560, 2560};
+
+    // Keyed by taskId()
+    QSet<QString> m_pending;             // Queued or running
+    QSet<QString> m_requested;           // Asked for by request*(), not a prefetch
+    QHash<QString, QRunnable*> m_queued; // Not started yet; guarded by m_queueMutex
+    QRunnable* m_queuedRegion = nullptr; // Likewise
+    QMutex m_queueMutex;
+    QHash<QString, QSize> m_sourceSizes; // By cacheKey(path, Kind::Full)
+
+    // RAW/HEIF can't decode a region: one full frame is kept for the
+    // file being inspected, until the developed frame is in the LRU too
+    // (shared, not copied). Worker side only, guarded by m_regionMutex.
+    QString m_regionSourceKey;
+    QImage m_regionSource;
+    QMutex m_regionMutex;
+
+    // Last: they wait for running decodes before the rest goes
+    TaskGroup m_tasks{TaskScheduler::Interactive};
+    TaskGroup m_prefetchTasks{TaskScheduler::Prefetch};
+};
+
+} // namespace PhotoGuru
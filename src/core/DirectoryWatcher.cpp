@@ -0,0 +1,146 @@
+#include "DirectoryWatcher.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDebug>
+
+namespace PhotoGuru {
+
+DirectoryWatcher::DirectoryWatcher(QObject* parent)
+    : QObject(parent)
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(DEBOUNCE_MS);
+    connect(&m_debounce, &QTimer::timeout, this, &DirectoryWatcher::startScan);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged,
+            this, &DirectoryWatcher::onDirectoryChanged);
+}
+
+void DirectoryWatcher::watch(const QString& directory, const QStringList& nameFilters) {
+    stop();
+    m_directory = directory;
+    m_nameFilters = nameFilters;
+    if (!m_watcher.addPath(directory)) {
+        qWarning() << "[DirectoryWatcher] Cannot watch:" << directory;
+    }
+    startScan();  // Baseline
+}
+
+void DirectoryWatcher::watch(const QString& directory, const QStringList& nameFilters, const Listing& baseline) {
+    stop();
+    m_directory = directory;
+    m_nameFilters = nameFilters;
+    if (!m_watcher.addPath(directory)) {
+        qWarning() << "[DirectoryWatcher] Cannot watch:" << directory;
+    }
+    m_listing = baseline;
+    m_haveListing = true;
+    startScan();
+}
+
+void DirectoryWatcher::stop() {
+    if (!m_watcher.directories().isEmpty()) {
+        m_watcher.removePaths(m_watcher.directories());
+    }
+    m_debounce.stop();
+    m_directory.clear();
+    m_listing.clear();
+    m_haveListing = false;
+    m_scanning = false;
+    m_rescanQueued = false;
+    m_firstPending.invalidate();
+    ++m_generation;
+}
+
+void DirectoryWatcher::rescan() {
+    if (m_directory.isEmpty()) return;
+    m_debounce.stop();
+    startScan();
+}
+
+void DirectoryWatcher::onDirectoryChanged() {
+    if (!m_firstPending.isValid()) m_firstPending.start();
+
+    // Quiet for DEBOUNCE_MS, or a long burst has waited MAX_DELAY_MS
+    int wait = qBound(0, int(MAX_DELAY_MS - m_firstPending.elapsed()), DEBOUNCE_MS);
+    m_debounce.start(wait);
+}
+
+void DirectoryWatcher::startScan() {
+    if (m_scanning) {
+        m_rescanQueued = true;
+        return;
+    }
+    m_scanning = true;
+    m_rescanQueued = false;
+    m_firstPending.invalidate();
+
+    const quint64 generation = m_generation;
+    const QString directory = m_directory;
+    const QStringList filters = m_nameFilters;
+    QFuture<QPair<Listing, QStringList>> scan = m_tasks.run(TaskScheduler::Prefetch, [directory, filters]() {
+        QStringList files;
+        Listing listing = list(directory, filters, &files);
+        return qMakePair(listing, files);
+    });
+
+    scan.then(this, [this, generation](const QPair<Listing, QStringList>& result) {
+        if (generation != m_generation) return;
+        m_scanning = false;
+
+        // listing() is already the new one when changed() goes out
+        Changes changes;
+        if (m_haveListing) {
+            changes = diff(m_listing, result.first);
+            changes.files = result.second;
+        }
+        m_listing = result.first;
+        m_haveListing = true;
+        if (!changes.isEmpty()) {
+            emit changed(changes);
+        }
+
+        // Some platforms drop the watch when the directory is replaced
+        if (!m_directory.isEmpty() && m_watcher.directories().isEmpty() && QFileInfo::exists(m_directory)) {
+            m_watcher.addPath(m_directory);
+        }
+        if (m_rescanQueued) {
+            startScan();
+        }
+    });
+}
+
+DirectoryWatcher::Listing DirectoryWatcher::list(const QString& directory, const QStringList& nameFilters,
+                                                 QStringList* files) {
+    Listing listing;
+    QDir dir(directory);
+    const QFileInfoList infos = dir.entryInfoList(nameFilters, QDir::Files, QDir::Name);
+    listing.reserve(infos.size());
+    for (const QFileInfo& info : infos) {
+        const QString path = dir.filePath(info.fileName());  // Same form as the caller's paths
+        listing.insert(path, Entry{info.lastModified().toMSecsSinceEpoch(), info.size()});
+        if (files) files->append(path);
+    }
+    return listing;
+}
+
+DirectoryWatcher::Changes DirectoryWatcher::diff(const Listing& before, const Listing& after) {
+    Changes changes;
+    for (auto it = after.cbegin(); it != after.cend(); ++it) {
+        auto old = before.constFind(it.key());
+        if (old == before.cend()) {
+            changes.added << it.key();
+        } else if (!(*old == it.value())) {
+            changes.modified << it.key();
+        }
+    }
+    for (auto it = before.cbegin(); it != before.cend(); ++it) {
+        if (!after.contains(it.key())) changes.removed << it.key();
+    }
+    changes.added.sort();
+    changes.removed.sort();
+    changes.modified.sort();
+    return changes;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "TaskScheduler.h"
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QFileSystemWatcher>
+#include <QElapsedTimer>
+#include <QTimer>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Reports files added to, removed from or changed in one directory
+ *
+ * QFileSystemWatcher (inotify, FSEvents, ReadDirectoryChangesW) only says
+ * that the directory changed, so each notification schedules a rescan:
+ * the directory is listed on a TaskScheduler worker (Prefetch: ahead of
+ * bulk work, it is the folder on screen) and compared with the last
+ * listing by name, mtime and size. Notifications are debounced: a card
+ * import dropping thousands of files causes a rescan every
+ * MAX_DELAY_MS at most, not one per file.
+ *
+ * Changes are relative to the listing taken when watch() was called;
+ * the first scan itself reports nothing. Given a baseline listing
+ * instead (a restored session), the first scan reports what changed
+ * since it was taken. GUI thread only.
+ */
+class DirectoryWatcher : public QObject {
+    Q_OBJECT
+
+public:
+    struct Entry {
+        qint64 mtime = 0;  // ms since epoch
+        qint64 size = 0;
+        bool operator==(const Entry& other) const { return mtime == other.mtime && size == other.size; }
+    };
+    using Listing = QHash<QString, Entry>;  // Absolute path -> entry
+
+    struct Changes {
+        QStringList files;     // Whole directory after the change, by name
+        QStringList added;
+        QStringList removed;
+        QStringList modified;
+        bool isEmpty() const { return added.isEmpty() && removed.isEmpty() && modified.isEmpty(); }
+    };
+
+    explicit DirectoryWatcher(QObject* parent = nullptr);
+
+    // nameFilters as for QDir::entryList, e.g. "*.jpg"
+    void watch(const QString& directory, const QStringList& nameFilters);
+    // As above, but the first scan is compared with `baseline`
+    void watch(const QString& directory, const QStringList& nameFilters, const Listing& baseline);
+    void stop();
+    QString directory() const { return m_directory; }
+    // The last scan (or the baseline until one finishes); already the
+    // scan being reported while changed() is delivered
+    const Listing& listing() const { return m_listing; }
+    bool hasListing() const { return m_haveListing; }
+
+    // Rescan now instead of waiting for a notification
+    void rescan();
+
+    static Listing list(const QString& directory, const QStringList& nameFilters, QStringList* files = nullptr);
+    static Changes diff(const Listing& before, const Listing& after);
+
+    static constexpr int DEBOUNCE_MS = 300;
+    static constexpr int MAX_DELAY_MS = 2000;
+
+signals:
+    void changed(const DirectoryWatcher::Changes& changes);
+
+private:
+    void onDirectoryChanged();
+    void startScan();
+
+    QFileSystemWatcher m_watcher;
+    QString m_directory;
+    QStringList m_nameFilters;
+    Listing m_listing;
+    bool m_haveListing = false;
+    quint64 m_generation = 0;  // Drops scans of a directory no longer watched
+    bool m_scanning = false;
+    bool m_rescanQueued = false;  // Changed again while scanning
+    QTimer m_debounce;
+    QElapsedTimer m_firstPending;  // When the oldest unscanned notification came in
+    TaskGroup m_tasks{TaskScheduler::Prefetch};  // Last: waits for the scan before the rest goes
+};
+
+} // namespace PhotoGuru
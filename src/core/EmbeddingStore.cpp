@@ -0,0 +1,554 @@
+#include "EmbeddingStore.h"
+#include "FileFingerprint.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+
+namespace PhotoGuru {
+
+namespace {
+
+constexpr char MATRIX_MAGIC[8] = {'P', 'G', 'E', 'M', 'B', 'E', 'D', 'S'};
+constexpr char TABLE_MAGIC[8] = {'P', 'G', 'E', 'M', 'B', 'I', 'D', 'S'};
+constexpr quint32 STORE_VERSION = 2;
+constexpr quint32 ROW_MAGIC = 0x44494550;  // "PEID"
+constexpr quint32 MAX_PATH_BYTES = 16 * 1024;
+constexpr int MAX_DIMENSION = 8192;
+constexpr qint64 ALIGNMENT = 8;
+
+// Native endianness - a local cache like the thumbnail pack
+struct MatrixHeader {
+    char magic[8];
+    quint32 version;
+    quint32 dimension;
+    char modelVersion[40];  // NUL-padded UTF-8
+    quint64 storeId;        // Random per reset, lets derived indexes detect a rebuilt store
+};
+
+struct TableHeader {
+    char magic[8];
+    quint32 version;
+    quint32 storeTag;  // Low half of the matrix's storeId; 0 in stores written before compaction
+};
+
+struct TableRecord {
+    quint32 magic;
+    quint32 pathBytes;
+    quint64 pathHash;
+    qint64 mtime;
+    qint64 fileSize;
+};
+
+// 64-byte header keeps rows 16-byte aligned whenever dim % 4 == 0
+static_assert(sizeof(MatrixHeader) == 64, "matrix header must keep rows aligned");
+static_assert(sizeof(TableRecord) % ALIGNMENT == 0, "table record must keep paths aligned");
+
+qint64 alignUp(qint64 value) {
+    return (value + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+QByteArray modelTag(const QString& modelVersion) {
+    return modelVersion.toUtf8().left(int(sizeof(MatrixHeader::modelVersion)) - 1);
+}
+
+// Table record for a row: header, then the path padded to ALIGNMENT
+QByteArray tableRecord(const QByteArray& pathBytes, const EmbeddingStore::Key& key) {
+    TableRecord header = {};
+    header.magic = ROW_MAGIC;
+    header.pathBytes = quint32(pathBytes.size());
+    header.pathHash = key.pathHash;
+    header.mtime = key.mtime;
+    header.fileSize = key.fileSize;
+
+    QByteArray record(int(sizeof(header) + alignUp(pathBytes.size())), '\0');
+    std::memcpy(record.data(), &header, sizeof(header));
+    std::memcpy(record.data() + sizeof(header), pathBytes.constData(), size_t(pathBytes.size()));
+    return record;
+}
+
+} // namespace
+
+// One read-only mapping of the matrix, on a handle of its own so that it
+// stays valid whatever the store does next
+struct EmbeddingStore::Mapping {
+    QFile file;      // Unmaps on destruction
+    uchar* data = nullptr;
+    qint64 size = 0;
+};
+
+EmbeddingStore::~EmbeddingStore() {
+    close();
+}
+
+bool EmbeddingStore::open(const QString& directory, const QString& modelVersion, int dimension) {
+    close();
+
+    if (dimension <= 0 || dimension > MAX_DIMENSION) {
+        qWarning() << "[EmbeddingStore] Invalid dimension:" << dimension;
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!QDir().mkpath(directory)) {
+        qWarning() << "[EmbeddingStore] Cannot create directory:" << directory;
+        return false;
+    }
+
+    m_modelVersion = modelVersion;
+    m_dimension = dimension;
+
+    m_matrixFile.setFileName(QDir(directory).filePath("embeddings.f32"));
+    m_tableFile.setFileName(QDir(directory).filePath("embeddings.ids"));
+    if (!m_matrixFile.open(QIODevice::ReadWrite) || !m_tableFile.open(QIODevice::ReadWrite)) {
+        qWarning() << "[EmbeddingStore] Cannot open store in" << directory
+                   << m_matrixFile.errorString() << m_tableFile.errorString();
+        m_matrixFile.close();
+        m_tableFile.close();
+        return false;
+    }
+
+    m_matrixSize = m_matrixFile.size();
+    m_tableSize = m_tableFile.size();
+
+    bool valid = m_matrixSize >= qint64(sizeof(MatrixHeader)) &&
+                 m_tableSize >= qint64(sizeof(TableHeader));
+    if (valid) {
+        MatrixHeader matrixHeader;
+        TableHeader tableHeader;
+        QByteArray tag = modelTag(modelVersion);
+        valid = m_matrixFile.read(reinterpret_cast<char*>(&matrixHeader), sizeof(matrixHeader)) == sizeof(matrixHeader) &&
+                m_tableFile.read(reinterpret_cast<char*>(&tableHeader), sizeof(tableHeader)) == sizeof(tableHeader) &&
+                std::memcmp(matrixHeader.magic, MATRIX_MAGIC, sizeof(MATRIX_MAGIC)) == 0 &&
+                std::memcmp(tableHeader.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC)) == 0 &&
+                matrixHeader.version == STORE_VERSION && tableHeader.version == STORE_VERSION &&
+                (tableHeader.storeTag == 0 || tableHeader.storeTag == quint32(matrixHeader.storeId)) &&
+                matrixHeader.dimension == quint32(dimension) &&
+                QByteArray(matrixHeader.modelVersion,
+                           int(qstrnlen(matrixHeader.modelVersion, sizeof(matrixHeader.modelVersion)))) == tag;
+        m_storeId = matrixHeader.storeId;
+        if (!valid) {
+            qDebug() << "[EmbeddingStore] Model or format changed, discarding stored embeddings";
+        }
+    }
+
+    if (!valid && !resetFiles()) {
+        m_matrixFile.close();
+        m_tableFile.close();
+        return false;
+    }
+
+    loadTable();
+    m_matrixCapacity = m_matrixSize;
+
+    // Mostly superseded rows: keep only the live ones
+    const int stale = m_paths.size() - m_current.size();
+    if (stale >= COMPACT_MIN_STALE_ROWS && stale > m_current.size()) {
+        std::vector<int> live;
+        live.reserve(size_t(m_current.size()));
+        for (int id = 0; id < m_paths.size(); ++id) {
+            if (m_current.value(m_paths[id]) == id) live.push_back(id);
+        }
+        qDebug() << "[EmbeddingStore] Compacting away" << stale << "superseded rows";
+        rewrite(live);  // On failure the store goes on as it was
+    }
+
+    if (!m_matrixFile.isOpen() || !m_tableFile.isOpen() || !remap()) {
+        locker.unlock();
+        close();
+        return false;
+    }
+
+    qDebug() << "[EmbeddingStore] Opened" << directory << "-" << m_current.size()
+             << "embeddings," << m_paths.size() << "rows," << m_matrixSize / 1024 << "KB";
+    return true;
+}
+
+bool EmbeddingStore::describe(const QString& directory, QString* modelVersion, int* dimension) {
+    QFile file(QDir(directory).filePath("embeddings.f32"));
+    MatrixHeader header;
+    if (!file.open(QIODevice::ReadOnly) ||
+        file.read(reinterpret_cast<char*>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+        std::memcmp(header.magic, MATRIX_MAGIC, sizeof(MATRIX_MAGIC)) != 0 || header.version != STORE_VERSION ||
+        header.dimension == 0 || header.dimension > quint32(MAX_DIMENSION)) {
+        return false;
+    }
+    *modelVersion = QString::fromUtf8(header.modelVersion, int(qstrnlen(header.modelVersion, sizeof(header.modelVersion))));
+    *dimension = int(header.dimension);
+    return true;
+}
+
+void EmbeddingStore::close() {
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_matrixFile.isOpen()) {
+        return;
+    }
+
+    // A Matrix still on the mapping keeps it; nothing is unmapped under it
+    m_map.reset();
+    if (m_matrixCapacity > m_matrixSize) {
+        m_matrixFile.resize(m_matrixSize);
+    }
+    m_storeId = 0;
+    m_matrixSize = 0;
+    m_matrixCapacity = 0;
+    m_tableSize = 0;
+    m_paths.clear();
+    m_keys.clear();
+    m_current.clear();
+    m_matrixFile.close();
+    m_tableFile.close();
+}
+
+bool EmbeddingStore::isOpen() const {
+    QMutexLocker locker(&m_mutex);
+    return m_matrixFile.isOpen();
+}
+
+EmbeddingStore::Key EmbeddingStore::makeKey(const QString& filepath) {
+    QFileInfo fi(filepath);
+    return makeKey(fi.absoluteFilePath(), fi.lastModified().toMSecsSinceEpoch(), fi.size());
+}
+
+EmbeddingStore::Key EmbeddingStore::makeKey(const QString& filepath, qint64 mtime, qint64 fileSize) {
+    Key key;
+    QByteArray digest = QCryptographicHash::hash(QFileInfo(filepath).absoluteFilePath().toUtf8(),
+                                                 QCryptographicHash::Sha1);
+    std::memcpy(&key.pathHash, digest.constData(), sizeof(key.pathHash));
+    key.mtime = mtime;
+    key.fileSize = fileSize;
+    return key;
+}
+
+std::optional<std::vector<float>> EmbeddingStore::find(const QString& filepath) const {
+    QString absolutePath = QFileInfo(filepath).absoluteFilePath();
+    return findKeyed(absolutePath, makeKey(absolutePath));
+}
+
+std::optional<std::vector<float>> EmbeddingStore::findOrAdopt(const QString& filepath) {
+    if (std::optional<std::vector<float>> embedding = find(filepath)) {
+        return embedding;
+    }
+    for (const PhotoDatabase::Fingerprint& seen : FileFingerprint::instance().sameContent(filepath)) {
+        std::optional<std::vector<float>> embedding =
+            findKeyed(seen.path, makeKey(seen.path, seen.mtime, seen.size));
+        if (embedding) {
+            insert(filepath, *embedding);
+            return embedding;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::vector<float>> EmbeddingStore::findKeyed(const QString& absolutePath, const Key& key) const {
+    QMutexLocker locker(&m_mutex);
+
+    int id = m_current.value(absolutePath, -1);
+    if (id < 0 || m_keys[size_t(id)] != key) {
+        return std::nullopt;
+    }
+
+    const float* data = rowLocked(id);
+    if (!data) {
+        return std::nullopt;
+    }
+    return std::vector<float>(data, data + m_dimension);
+}
+
+QStringList EmbeddingStore::missing(const QStringList& filepaths) const {
+    // Stat outside the lock - that is the slow part
+    std::vector<std::pair<QString, Key>> keys;
+    keys.reserve(size_t(filepaths.size()));
+    for (const QString& path : filepaths) {
+        QString absolutePath = QFileInfo(path).absoluteFilePath();
+        keys.emplace_back(absolutePath, makeKey(absolutePath));
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    QStringList result;
+    for (int i = 0; i < filepaths.size(); ++i) {
+        int id = m_current.value(keys[size_t(i)].first, -1);
+        if (id < 0 || m_keys[size_t(id)] != keys[size_t(i)].second) {
+            result.append(filepaths[i]);
+        }
+    }
+    return result;
+}
+
+bool EmbeddingStore::insert(const QString& filepath, const std::vector<float>& embedding) {
+    QString absolutePath = QFileInfo(filepath).absoluteFilePath();
+    return insertKeyed(absolutePath, makeKey(absolutePath), embedding);
+}
+
+bool EmbeddingStore::insert(const QString& filepath, qint64 mtime, qint64 fileSize,
+                            const std::vector<float>& embedding) {
+    QString absolutePath = QFileInfo(filepath).absoluteFilePath();
+    return insertKeyed(absolutePath, makeKey(absolutePath, mtime, fileSize), embedding);
+}
+
+bool EmbeddingStore::insertKeyed(const QString& absolutePath, const Key& key, const std::vector<float>& embedding) {
+    if (int(embedding.size()) != m_dimension || m_dimension <= 0) {
+        return false;
+    }
+
+    QByteArray pathBytes = absolutePath.toUtf8();
+    if (pathBytes.size() > int(MAX_PATH_BYTES)) {
+        return false;
+    }
+
+    const QByteArray record = tableRecord(pathBytes, key);
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_matrixFile.isOpen()) {
+        return false;
+    }
+    int existing = m_current.value(absolutePath, -1);
+    if (existing >= 0 && m_keys[size_t(existing)] == key) {
+        return true;  // Another thread stored it first
+    }
+
+    // Matrix row first: a row without its table record is dropped on open
+    qint64 matrixOffset = m_matrixSize;
+    qint64 tableOffset = m_tableSize;
+    if (matrixOffset + rowBytes() > m_matrixCapacity) {
+        // Reserve ahead (zeroes, which open() trims like rows without a record)
+        qint64 capacity = std::max(matrixOffset + rowBytes(),
+                                   m_matrixCapacity + std::min(m_matrixCapacity, MAX_RESERVE_BYTES));
+        if (!m_matrixFile.resize(capacity)) {
+            qWarning() << "[EmbeddingStore] Cannot grow matrix:" << m_matrixFile.errorString();
+            return false;
+        }
+        m_matrixCapacity = capacity;
+    }
+    const char* row = reinterpret_cast<const char*>(embedding.data());
+    bool ok = m_matrixFile.seek(matrixOffset) &&
+              m_matrixFile.write(row, rowBytes()) == rowBytes() && m_matrixFile.flush() &&
+              m_tableFile.seek(tableOffset) &&
+              m_tableFile.write(record) == record.size() && m_tableFile.flush();
+    if (!ok) {
+        qWarning() << "[EmbeddingStore] Write failed:" << m_matrixFile.errorString()
+                   << m_tableFile.errorString();
+        // A partial row is in the reserve, which the next insert overwrites
+        m_tableFile.resize(tableOffset);
+        return false;
+    }
+
+    m_matrixSize = matrixOffset + rowBytes();
+    m_tableSize = tableOffset + record.size();
+    m_paths.append(absolutePath);
+    m_keys.push_back(key);
+    m_current.insert(absolutePath, m_paths.size() - 1);
+    return true;
+}
+
+int EmbeddingStore::rowCount() const {
+    QMutexLocker locker(&m_mutex);
+    return m_paths.size();
+}
+
+EmbeddingStore::Matrix EmbeddingStore::matrix() const {
+    QMutexLocker locker(&m_mutex);
+
+    Matrix matrix;
+    const int rows = m_paths.size();
+    if (rows == 0 || !rowLocked(rows - 1)) {
+        return matrix;
+    }
+    // rowLocked() mapped through the last row, so one base covers them all
+    matrix.data = reinterpret_cast<const float*>(m_map->data + sizeof(MatrixHeader));
+    matrix.rows = rows;
+    matrix.dimension = m_dimension;
+    matrix.mapping = m_map;
+    return matrix;
+}
+
+QString EmbeddingStore::pathOf(int id) const {
+    QMutexLocker locker(&m_mutex);
+    return id >= 0 && id < m_paths.size() ? m_paths[id] : QString();
+}
+
+EmbeddingStore::Key EmbeddingStore::keyOf(int id) const {
+    QMutexLocker locker(&m_mutex);
+    return id >= 0 && id < m_paths.size() ? m_keys[size_t(id)] : Key();
+}
+
+bool EmbeddingStore::isLive(int id) const {
+    QMutexLocker locker(&m_mutex);
+    return id >= 0 && id < m_paths.size() && m_current.value(m_paths[id], -1) == id;
+}
+
+int EmbeddingStore::liveCount() const {
+    QMutexLocker locker(&m_mutex);
+    return m_current.size();
+}
+
+int EmbeddingStore::idOf(const QString& filepath) const {
+    QString absolutePath = QFileInfo(filepath).absoluteFilePath();
+    QMutexLocker locker(&m_mutex);
+    return m_current.value(absolutePath, -1);
+}
+
+const float* EmbeddingStore::rowLocked(int id) const {
+    if (id < 0 || id >= m_paths.size()) {
+        return nullptr;
+    }
+
+    qint64 offset = qint64(sizeof(MatrixHeader)) + qint64(id) * rowBytes();
+
+    // Appended past the reserve the last mapping covers - map the grown file
+    if ((!m_map || offset + rowBytes() > m_map->size) && !remap()) {
+        return nullptr;
+    }
+    return reinterpret_cast<const float*>(m_map->data + offset);
+}
+
+bool EmbeddingStore::rewrite(const std::vector<int>& keep) {
+    // The table carries the low half as a tag, so never let it be 0
+    quint64 storeId = 0;
+    while (quint32(storeId) == 0) {
+        storeId = QRandomGenerator::global()->generate64();
+    }
+
+    MatrixHeader matrixHeader = {};
+    std::memcpy(matrixHeader.magic, MATRIX_MAGIC, sizeof(MATRIX_MAGIC));
+    matrixHeader.version = STORE_VERSION;
+    matrixHeader.dimension = quint32(m_dimension);
+    QByteArray tag = modelTag(m_modelVersion);
+    std::memcpy(matrixHeader.modelVersion, tag.constData(), size_t(tag.size()));
+    matrixHeader.storeId = storeId;
+
+    TableHeader tableHeader = {};
+    std::memcpy(tableHeader.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    tableHeader.version = STORE_VERSION;
+    tableHeader.storeTag = quint32(storeId);
+
+    // Written aside and renamed over the old files, so mappings of those
+    // stay valid; never truncated in place
+    QSaveFile matrix(m_matrixFile.fileName());
+    QSaveFile table(m_tableFile.fileName());
+    bool ok = matrix.open(QIODevice::WriteOnly) && table.open(QIODevice::WriteOnly) &&
+              matrix.write(reinterpret_cast<const char*>(&matrixHeader), sizeof(matrixHeader)) == sizeof(matrixHeader) &&
+              table.write(reinterpret_cast<const char*>(&tableHeader), sizeof(tableHeader)) == sizeof(tableHeader);
+
+    QStringList paths;
+    std::vector<Key> keys;
+    keys.reserve(keep.size());
+    QByteArray row(int(rowBytes()), Qt::Uninitialized);
+    for (size_t i = 0; ok && i < keep.size(); ++i) {
+        const int id = keep[i];
+        const QByteArray record = tableRecord(m_paths[id].toUtf8(), m_keys[size_t(id)]);
+        ok = m_matrixFile.seek(qint64(sizeof(MatrixHeader)) + qint64(id) * rowBytes()) &&
+             m_matrixFile.read(row.data(), row.size()) == row.size() &&
+             matrix.write(row) == row.size() && table.write(record) == record.size();
+        paths.append(m_paths[id]);
+        keys.push_back(m_keys[size_t(id)]);
+    }
+
+    // Table first: torn between the two, the tags disagree and open()
+    // discards the store rather than pair rows with the wrong paths
+    ok = ok && table.commit() && matrix.commit();
+    if (!ok) {
+        qWarning() << "[EmbeddingStore] Cannot write store:" << matrix.errorString() << table.errorString();
+        return false;
+    }
+
+    m_matrixFile.close();
+    m_tableFile.close();
+    if (!m_matrixFile.open(QIODevice::ReadWrite) || !m_tableFile.open(QIODevice::ReadWrite)) {
+        qWarning() << "[EmbeddingStore] Cannot reopen store:"
+                   << m_matrixFile.errorString() << m_tableFile.errorString();
+        m_matrixFile.close();
+        m_tableFile.close();
+        m_paths.clear();
+        m_keys.clear();
+        m_current.clear();
+        return false;
+    }
+
+    m_paths = paths;
+    m_keys = std::move(keys);
+    m_current.clear();
+    for (int id = 0; id < m_paths.size(); ++id) {
+        m_current.insert(m_paths[id], id);
+    }
+    m_matrixSize = m_matrixFile.size();
+    m_matrixCapacity = m_matrixSize;
+    m_tableSize = m_tableFile.size();
+    m_storeId = storeId;
+    m_map.reset();
+    return true;
+}
+
+bool EmbeddingStore::remap() const {
+    auto map = std::make_shared<Mapping>();
+    map->file.setFileName(m_matrixFile.fileName());
+    if (map->file.open(QIODevice::ReadOnly)) {
+        map->data = map->file.map(0, m_matrixCapacity);
+    }
+    if (!map->data) {
+        qWarning() << "[EmbeddingStore] mmap failed:" << map->file.errorString();
+        return false;
+    }
+    map->size = m_matrixCapacity;
+
+    // The older mapping goes with the last Matrix that points into it
+    m_map = std::move(map);
+    return true;
+}
+
+void EmbeddingStore::loadTable() {
+    const qint64 matrixRows = (m_matrixSize - qint64(sizeof(MatrixHeader))) / rowBytes();
+
+    // Table is small next to the matrix (one path per row); read it whole
+    m_tableFile.seek(0);
+    QByteArray table = m_tableFile.readAll();
+    qint64 offset = sizeof(TableHeader);
+
+    while (m_paths.size() < matrixRows && offset + qint64(sizeof(TableRecord)) <= table.size()) {
+        TableRecord header;
+        std::memcpy(&header, table.constData() + offset, sizeof(header));
+
+        qint64 next = offset + qint64(sizeof(header)) + alignUp(header.pathBytes);
+        if (header.magic != ROW_MAGIC || header.pathBytes == 0 ||
+            header.pathBytes > MAX_PATH_BYTES || next > table.size()) {
+            break;
+        }
+
+        QString path = QString::fromUtf8(table.constData() + offset + sizeof(header), int(header.pathBytes));
+        Key key;
+        key.pathHash = header.pathHash;
+        key.mtime = header.mtime;
+        key.fileSize = header.fileSize;
+
+        m_paths.append(path);
+        m_keys.push_back(key);
+        m_current.insert(path, m_paths.size() - 1);  // Later rows supersede earlier ones
+
+        offset = next;
+    }
+
+    // Either file may have a torn tail, or rows the other file never got;
+    // cut both back to the rows they agree on
+    qint64 matrixEnd = qint64(sizeof(MatrixHeader)) + qint64(m_paths.size()) * rowBytes();
+    if (offset < m_tableSize || matrixEnd < m_matrixSize) {
+        qWarning() << "[EmbeddingStore] Truncating incomplete rows:"
+                   << (m_tableSize - offset) << "table bytes," << (m_matrixSize - matrixEnd) << "matrix bytes";
+        if (m_tableFile.resize(offset)) {
+            m_tableSize = offset;
+        }
+        if (m_matrixFile.resize(matrixEnd)) {
+            m_matrixSize = matrixEnd;
+        }
+    }
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QtGlobal>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Persistent image embeddings as one memory-mapped float32 matrix
+ *
+ * Two append-only files in a directory:
+ *   embeddings.f32 - header (model version, dimension) + N x dim floats
+ *   embeddings.ids - one record per row: source path, mtime and size
+ *
+ * Row i of the matrix belongs to record i of the table, so a full scan for
+ * similarity search walks contiguous memory. A row is live while its path
+ * has not been re-embedded; a changed file appends a new row and the old
+ * one goes stale. Opening with a different model version or dimension
+ * discards the store (embeddings from another model aren't comparable).
+ * A torn tail in either file is truncated on open().
+ *
+ * The matrix file is grown ahead of the appends, doubling, so matrix()
+ * maps again once per doubling rather than after every insert; close()
+ * trims the reserve. A Matrix holds the mapping it points into, which is
+ * unmapped when the store and the last Matrix on it let go. Superseded
+ * rows are reclaimed on open() once they outnumber the live ones (and
+ * are at least COMPACT_MIN_STALE_ROWS): the store is rewritten with the
+ * live rows only, under a new storeId since row numbers change.
+ *
+ * Thread-safe.
+ */
+class EmbeddingStore {
+public:
+    struct Key {
+        quint64 pathHash = 0;
+        qint64 mtime = 0;      // ms since epoch
+        qint64 fileSize = 0;
+
+        bool operator==(const Key& other) const {
+            return pathHash == other.pathHash && mtime == other.mtime &&
+                   fileSize == other.fileSize;
+        }
+        bool operator!=(const Key& other) const { return !(*this == other); }
+    };
+
+    // Rows [0, rows) as one row-major block. Holds its mapping, so it stays
+    // valid while the store grows, compacts or closes; rows appended later
+    // need a new one.
+    struct Matrix {
+        const float* data = nullptr;
+        int rows = 0;
+        int dimension = 0;
+        std::shared_ptr<const void> mapping;
+
+        const float* row(int id) const { return data + size_t(id) * size_t(dimension); }
+        explicit operator bool() const { return data != nullptr; }
+    };
+
+    EmbeddingStore() = default;
+    ~EmbeddingStore();
+
+    bool open(const QString& directory, const QString& modelVersion, int dimension);
+    // Model version and dimension of the store in `directory`, without opening
+    // it; false if there is none
+    static bool describe(const QString& directory, QString* modelVersion, int* dimension);
+    void close();
+    bool isOpen() const;
+
+    // Stats the file; key changes whenever the file does
+    static Key makeKey(const QString& filepath);
+    // For a file version recorded earlier (no stat)
+    static Key makeKey(const QString& filepath, qint64 mtime, qint64 fileSize);
+
+    // Stored embedding for the file's current contents, if any
+    std::optional<std::vector<float>> find(const QString& filepath) const;
+
+    // find(), else the embedding stored for the same contents under another
+    // path (a moved or renamed file), which is then stored for this one too
+    std::optional<std::vector<float>> findOrAdopt(const QString& filepath);
+
+    // Files in `filepaths` that are new or changed since they were stored
+    QStringList missing(const QStringList& filepaths) const;
+
+    bool insert(const QString& filepath, const std::vector<float>& embedding);
+    // For a file version recorded elsewhere (no stat), e.g. another store's row
+    bool insert(const QString& filepath, qint64 mtime, qint64 fileSize, const std::vector<float>& embedding);
+
+    // Row access for bulk scans / index building
+    int rowCount() const;
+    int dimension() const { return m_dimension; }
+    Matrix matrix() const;  // Every row so far; empty when there are none
+    QString pathOf(int id) const;
+    Key keyOf(int id) const;
+    bool isLive(int id) const;
+    int liveCount() const;
+    int idOf(const QString& filepath) const;  // Live row, or -1
+
+    QString modelVersion() const { return m_modelVersion; }
+
+    // Changes whenever the store is discarded, recreated or compacted
+    quint64 storeId() const { return m_storeId; }
+
+    static constexpr int COMPACT_MIN_STALE_ROWS = 4096;
+    static constexpr qint64 MAX_RESERVE_BYTES = qint64(64) * 1024 * 1024;  // Growth step cap
+
+private:
+    EmbeddingStore(const EmbeddingStore&) = delete;
+    EmbeddingStore& operator=(const EmbeddingStore&) = delete;
+
+    struct Mapping;
+
+    bool resetFiles() { return rewrite({}); }
+    // Replaces both files with `keep`'s rows under a new store id
+    bool rewrite(const std::vector<int>& keep);
+    bool remap() const;
+    const float* rowLocked(int id) const;
+    std::optional<std::vector<float>> findKeyed(const QString& absolutePath, const Key& key) const;
+    bool insertKeyed(const QString& absolutePath, const Key& key, const std::vector<float>& embedding);
+    void loadTable();
+    qint64 rowBytes() const { return qint64(m_dimension) * qint64(sizeof(float)); }
+
+    QFile m_matrixFile;
+    QFile m_tableFile;
+    QString m_modelVersion;
+    int m_dimension = 0;
+    quint64 m_storeId = 0;
+
+    QStringList m_paths;                  // Per row (absolute)
+    std::vector<Key> m_keys;              // Per row
+    QHash<QString, int> m_current;        // Path -> newest row
+    qint64 m_matrixSize = 0;              // End of the rows
+    qint64 m_matrixCapacity = 0;          // Size on disk: the rows, then zeroes reserved for appends
+    qint64 m_tableSize = 0;
+
+    mutable std::shared_ptr<Mapping> m_map;  // Latest; older ones live while a Matrix uses them
+    mutable QMutex m_mutex;
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,617 @@
+#include "ExifFastReader.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QXmlStreamReader>
+#include <QtMath>
+#include <cstring>
+#include <vector>
+
+namespace PhotoGuru {
+
+namespace {
+
+// Bounds-checked view of the file; callers check has() before reading
+struct Bytes {
+    const uchar* data = nullptr;
+    qint64 size = 0;
+
+    bool has(qint64 offset, qint64 length) const {
+        return offset >= 0 && length >= 0 && offset <= size && length <= size - offset;
+    }
+    Bytes mid(qint64 offset, qint64 length) const {
+        return has(offset, length) ? Bytes{data + offset, length} : Bytes{};
+    }
+    Bytes from(qint64 offset) const { return mid(offset, size - offset); }
+    bool startsWith(const char* prefix, qint64 length) const {
+        return has(0, length) && memcmp(data, prefix, size_t(length)) == 0;
+    }
+    QByteArray toByteArray() const { return QByteArray(reinterpret_cast<const char*>(data), int(size)); }
+
+    quint16 be16(qint64 o) const { return quint16(data[o] << 8 | data[o + 1]); }
+    quint32 be32(qint64 o) const {
+        return quint32(data[o]) << 24 | quint32(data[o + 1]) << 16 | quint32(data[o + 2]) << 8 | data[o + 3];
+    }
+    quint64 be64(qint64 o) const { return quint64(be32(o)) << 32 | be32(o + 4); }
+};
+
+constexpr quint32 fourcc(const char (&s)[5]) {
+    return quint32(uchar(s[0])) << 24 | quint32(uchar(s[1])) << 16 | quint32(uchar(s[2])) << 8 | uchar(s[3]);
+}
+
+// More entries than any real IFD has: the offset points at garbage
+constexpr int MAX_IFD_ENTRIES = 1024;
+
+enum TiffType : quint16 {
+    TIFF_BYTE = 1, TIFF_ASCII = 2, TIFF_SHORT = 3, TIFF_LONG = 4, TIFF_RATIONAL = 5,
+    TIFF_SBYTE = 6, TIFF_UNDEFINED = 7, TIFF_SSHORT = 8, TIFF_SLONG = 9, TIFF_SRATIONAL = 10,
+    TIFF_FLOAT = 11, TIFF_DOUBLE = 12, TIFF_IFD = 13
+};
+
+enum Tag : quint16 {
+    TAG_MAKE = 0x010F,
+    TAG_MODEL = 0x0110,
+    TAG_XMP = 0x02BC,
+    TAG_RATING = 0x4746,
+    TAG_EXIF_IFD = 0x8769,
+    TAG_GPS_IFD = 0x8825,
+    TAG_FNUMBER = 0x829D,
+    TAG_ISO = 0x8827,
+    TAG_DATETIME_ORIGINAL = 0x9003,
+    TAG_SHUTTER_SPEED = 0x9201,
+    TAG_FOCAL_LENGTH = 0x920A,
+    TAG_USER_COMMENT = 0x9286,
+    TAG_SUBSEC_ORIGINAL = 0x9291,
+    GPS_LATITUDE_REF = 1,
+    GPS_LATITUDE = 2,
+    GPS_LONGITUDE_REF = 3,
+    GPS_LONGITUDE = 4
+};
+
+class Tiff {
+public:
+    struct Entry {
+        quint16 tag = 0;
+        quint16 type = 0;
+        quint32 count = 0;
+        Bytes value;
+    };
+
+    bool open(Bytes bytes) {
+        m_bytes = bytes;
+        if (bytes.startsWith("II*\0", 4)) m_little = true;
+        else if (bytes.startsWith("MM\0*", 4)) m_little = false;
+        else return false;
+        return m_bytes.has(0, 8);
+    }
+
+    quint32 firstIfd() const { return u32(4); }
+
+    // Entries of the IFD at `offset`; false if it runs past the data
+    bool ifd(quint32 offset, std::vector<Entry>& entries) const {
+        entries.clear();
+        if (!m_bytes.has(offset, 2)) return false;
+        const int count = u16(offset);
+        if (count > MAX_IFD_ENTRIES || !m_bytes.has(offset + 2, 12 * qint64(count))) return false;
+
+        for (int i = 0; i < count; ++i) {
+            const qint64 at = offset + 2 + 12 * qint64(i);
+            Entry entry;
+            entry.tag = u16(at);
+            entry.type = u16(at + 2);
+            entry.count = u32(at + 4);
+            const qint64 length = qint64(entry.count) * typeSize(entry.type);
+            if (length == 0) continue;  // Unknown type
+            // Values of up to four bytes sit in the entry itself
+            entry.value = length <= 4 ? m_bytes.mid(at + 8, length) : m_bytes.mid(u32(at + 8), length);
+            if (entry.value.data) entries.push_back(entry);
+        }
+        return true;
+    }
+
+    QString ascii(const Entry& entry) const {
+        const char* text = reinterpret_cast<const char*>(entry.value.data);
+        return QString::fromUtf8(text, int(qstrnlen(text, uint(entry.value.size)))).trimmed();
+    }
+
+    quint32 integer(const Entry& entry) const {
+        switch (entry.type) {
+            case TIFF_BYTE: return entry.value.data[0];
+            case TIFF_SHORT: return u16(entry.value, 0);
+            case TIFF_LONG:
+            case TIFF_SLONG:
+            case TIFF_IFD: return u32(entry.value, 0);
+            default: return 0;
+        }
+    }
+
+    // Zero for a zero denominator, like an unset value
+    double rational(const Entry& entry, int index = 0) const {
+        if (entry.type != TIFF_RATIONAL && entry.type != TIFF_SRATIONAL) return double(integer(entry));
+        if (quint32(index) >= entry.count) return 0.0;
+        const quint32 num = u32(entry.value, 8 * index);
+        const quint32 den = u32(entry.value, 8 * index + 4);
+        if (den == 0) return 0.0;
+        if (entry.type == TIFF_SRATIONAL) return double(qint32(num)) / double(qint32(den));
+        return double(num) / double(den);
+    }
+
+    bool littleEndian() const { return m_little; }
+
+private:
+    static qint64 typeSize(quint16 type) {
+        switch (type) {
+            case TIFF_BYTE: case TIFF_ASCII: case TIFF_SBYTE: case TIFF_UNDEFINED: return 1;
+            case TIFF_SHORT: case TIFF_SSHORT: return 2;
+            case TIFF_LONG: case TIFF_SLONG: case TIFF_FLOAT: case TIFF_IFD: return 4;
+            case TIFF_RATIONAL: case TIFF_SRATIONAL: case TIFF_DOUBLE: return 8;
+            default: return 0;
+        }
+    }
+
+    quint16 u16(qint64 o) const { return u16(m_bytes, o); }
+    quint32 u32(qint64 o) const { return u32(m_bytes, o); }
+    quint16 u16(const Bytes& b, qint64 o) const {
+        return m_little ? quint16(b.data[o] | b.data[o + 1] << 8) : b.be16(o);
+    }
+    quint32 u32(const Bytes& b, qint64 o) const {
+        if (!m_little) return b.be32(o);
+        return quint32(b.data[o]) | quint32(b.data[o + 1]) << 8 | quint32(b.data[o + 2]) << 16 |
+               quint32(b.data[o + 3]) << 24;
+    }
+
+    Bytes m_bytes;
+    bool m_little = true;
+};
+
+// What the packets held; assembled into PhotoMetadata at the end
+struct Fields {
+    QString dateTime;
+    QString subSec;
+    QString latRef;
+    QString lonRef;
+    double lat = 0.0;
+    double lon = 0.0;
+    int exifRating = 0;
+    bool hasXmpRating = false;
+    QString userComment;
+    QString city;
+    QString state;
+    QString country;
+    QByteArray xmp;
+};
+
+double degrees(const Tiff& tiff, const Tiff::Entry& entry) {
+    return tiff.rational(entry, 0) + tiff.rational(entry, 1) / 60.0 + tiff.rational(entry, 2) / 3600.0;
+}
+
+QString userComment(const Tiff& tiff, const Tiff::Entry& entry) {
+    // Eight bytes of character code, then the text
+    const Bytes text = entry.value.from(8);
+    if (!text.data) return QString();
+    if (entry.value.startsWith("UNICODE", 7)) {
+        QString result;
+        for (qint64 i = 0; i + 1 < text.size; i += 2) {
+            const char16_t c = tiff.littleEndian() ? char16_t(text.data[i] | text.data[i + 1] << 8)
+                                                   : char16_t(text.be16(i));
+            if (c == 0) break;
+            result += QChar(c);
+        }
+        return result.trimmed();
+    }
+    const char* chars = reinterpret_cast<const char*>(text.data);
+    return QString::fromUtf8(chars, int(qstrnlen(chars, uint(text.size)))).trimmed();
+}
+
+// IFD0, then the EXIF and GPS IFDs it points at
+bool parseTiff(Bytes bytes, PhotoMetadata& meta, Fields& fields) {
+    Tiff tiff;
+    if (!tiff.open(bytes)) return false;
+
+    std::vector<Tiff::Entry> entries;
+    if (!tiff.ifd(tiff.firstIfd(), entries)) return false;
+
+    quint32 exifIfd = 0;
+    quint32 gpsIfd = 0;
+    for (const Tiff::Entry& e : entries) {
+        switch (e.tag) {
+            case TAG_MAKE: meta.camera_make = tiff.ascii(e); break;
+            case TAG_MODEL: meta.camera_model = tiff.ascii(e); break;
+            case TAG_EXIF_IFD: exifIfd = tiff.integer(e); break;
+            case TAG_GPS_IFD: gpsIfd = tiff.integer(e); break;
+            case TAG_RATING: fields.exifRating = int(tiff.integer(e)); break;
+            case TAG_XMP: if (fields.xmp.isEmpty()) fields.xmp = e.value.toByteArray(); break;
+            default: break;
+        }
+    }
+
+    if (exifIfd != 0) {
+        if (!tiff.ifd(exifIfd, entries)) return false;
+        for (const Tiff::Entry& e : entries) {
+            switch (e.tag) {
+                case TAG_DATETIME_ORIGINAL: fields.dateTime = tiff.ascii(e); break;
+                case TAG_SUBSEC_ORIGINAL: fields.subSec = tiff.ascii(e); break;
+                case TAG_FNUMBER: meta.aperture = tiff.rational(e); break;
+                case TAG_ISO: meta.iso = int(tiff.integer(e)); break;
+                case TAG_FOCAL_LENGTH: meta.focal_length = tiff.rational(e); break;
+                case TAG_USER_COMMENT: fields.userComment = userComment(tiff, e); break;
+                case TAG_SHUTTER_SPEED: {
+                    // APEX to seconds, as ExifTool converts it
+                    const double apex = tiff.rational(e);
+                    meta.shutter_speed = qAbs(apex) < 100.0 ? qPow(2.0, -apex) : 0.0;
+                    break;
+                }
+                default: break;
+            }
+        }
+    }
+
+    if (gpsIfd != 0) {
+        if (!tiff.ifd(gpsIfd, entries)) return false;
+        for (const Tiff::Entry& e : entries) {
+            switch (e.tag) {
+                case GPS_LATITUDE_REF: fields.latRef = tiff.ascii(e); break;
+                case GPS_LATITUDE: fields.lat = degrees(tiff, e); break;
+                case GPS_LONGITUDE_REF: fields.lonRef = tiff.ascii(e); break;
+                case GPS_LONGITUDE: fields.lon = degrees(tiff, e); break;
+                default: break;
+            }
+        }
+    }
+    return true;
+}
+
+// APP1 Exif and XMP segments, up to the image data
+bool parseJpeg(Bytes file, PhotoMetadata& meta, Fields& fields) {
+    static const char EXIF_HEADER[] = "Exif\0\0";
+    static const char XMP_HEADER[] = "http://ns.adobe.com/xap/1.0/";  // Then a NUL
+    static const char IPTC_HEADER[] = "Photoshop 3.0";
+    bool iptc = false;
+
+    qint64 o = 2;
+    while (file.has(o, 4)) {
+        if (file.data[o] != 0xFF) return false;
+        const uchar marker = file.data[o + 1];
+        if (marker == 0xFF) { ++o; continue; }                   // Fill byte
+        if (marker == 0xDA || marker == 0xD9) break;             // Image data: no metadata after it
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) { o += 2; continue; }
+
+        const quint16 length = file.be16(o + 2);
+        if (length < 2 || !file.has(o + 2, length)) return false;
+        const Bytes segment = file.mid(o + 4, length - 2);
+
+        if (marker == 0xE1 && segment.startsWith(EXIF_HEADER, 6)) {
+            if (!parseTiff(segment.from(6), meta, fields)) return false;
+        } else if (marker == 0xE1 && segment.startsWith(XMP_HEADER, sizeof(XMP_HEADER))) {
+            fields.xmp = segment.from(sizeof(XMP_HEADER)).toByteArray();
+        } else if (marker == 0xED && segment.startsWith(IPTC_HEADER, sizeof(IPTC_HEADER))) {
+            iptc = true;
+        }
+        o += 2 + length;
+    }
+
+    // Keywords, captions and places written only to IPTC are ExifTool's to read
+    return !iptc || !fields.xmp.isEmpty();
+}
+
+struct Box {
+    quint32 type = 0;
+    Bytes body;
+};
+
+// Boxes one after another in `bytes`, up to the first malformed one
+std::vector<Box> boxes(Bytes bytes) {
+    std::vector<Box> result;
+    qint64 o = 0;
+    while (bytes.has(o, 8)) {
+        quint64 size = bytes.be32(o);
+        const quint32 type = bytes.be32(o + 4);
+        qint64 header = 8;
+        if (size == 1) {
+            if (!bytes.has(o + 8, 8)) break;
+            size = bytes.be64(o + 8);
+            header = 16;
+        } else if (size == 0) {
+            size = quint64(bytes.size - o);  // To the end of the file
+        }
+        if (size < quint64(header) || size > quint64(bytes.size - o)) break;
+        result.push_back({type, bytes.mid(o + header, qint64(size) - header)});
+        o += qint64(size);
+    }
+    return result;
+}
+
+// Fixed-size field of the iloc box: 0, 4 or 8 bytes
+bool ilocField(Bytes b, qint64& o, int size, quint64& value) {
+    if (size == 0) { value = 0; return true; }
+    if ((size != 4 && size != 8) || !b.has(o, size)) return false;
+    value = size == 4 ? b.be32(o) : b.be64(o);
+    o += size;
+    return true;
+}
+
+// The Exif and XMP items of the primary meta box, found through iinf and iloc
+bool parseHeif(Bytes file, const std::vector<Box>& top, PhotoMetadata& meta, Fields& fields) {
+    const Box* metaBox = nullptr;
+    for (const Box& box : top) {
+        if (box.type == fourcc("meta")) metaBox = &box;
+    }
+    if (!metaBox) return true;  // No metadata at all, e.g. a screenshot
+
+    quint32 exifItem = 0;
+    quint32 xmpItem = 0;
+    struct Extent { quint32 item; quint64 offset; quint64 length; };
+    std::vector<Extent> extents;
+
+    for (const Box& child : boxes(metaBox->body.from(4))) {  // Past version and flags
+        const Bytes b = child.body;
+        if (!b.has(0, 4)) continue;
+        const int version = b.data[0];
+
+        if (child.type == fourcc("iinf")) {
+            const qint64 start = version == 0 ? 6 : 8;
+            for (const Box& infe : boxes(b.from(start))) {
+                const Bytes e = infe.body;
+                if (infe.type != fourcc("infe") || !e.has(0, 4) || e.data[0] < 2) continue;
+                qint64 o = 4;
+                quint32 id = 0;
+                if (e.data[0] == 2) {
+                    if (!e.has(o, 2)) continue;
+                    id = e.be16(o);
+                    o += 2;
+                } else {
+                    if (!e.has(o, 4)) continue;
+                    id = e.be32(o);
+                    o += 4;
+                }
+                o += 2;  // Protection index
+                if (!e.has(o, 4)) continue;
+                const quint32 type = e.be32(o);
+                o += 4;
+                if (type == fourcc("Exif")) {
+                    exifItem = id;
+                } else if (type == fourcc("mime")) {
+                    // Item name, then content type, both NUL-terminated
+                    const Bytes names = e.from(o);
+                    const char* name = reinterpret_cast<const char*>(names.data);
+                    const qint64 nameLength = qint64(qstrnlen(name, uint(names.size)));
+                    const Bytes contentType = names.from(nameLength + 1);
+                    if (contentType.startsWith("application/rdf+xml", 19)) xmpItem = id;
+                }
+            }
+        } else if (child.type == fourcc("iloc")) {
+            if (!b.has(4, 2)) continue;
+            const int offsetSize = b.data[4] >> 4;
+            const int lengthSize = b.data[4] & 0xF;
+            const int baseOffsetSize = b.data[5] >> 4;
+            const int indexSize = (version == 1 || version == 2) ? (b.data[5] & 0xF) : 0;
+            qint64 o = 6;
+            quint64 count = 0;
+            if (version < 2) {
+                if (!b.has(o, 2)) continue;
+                count = b.be16(o);
+                o += 2;
+            } else if (!ilocField(b, o, 4, count)) {
+                continue;
+            }
+            for (quint64 i = 0; i < count; ++i) {
+                quint64 id = 0;
+                if (version < 2) {
+                    if (!b.has(o, 2)) break;
+                    id = b.be16(o);
+                    o += 2;
+                } else if (!ilocField(b, o, 4, id)) {
+                    break;
+                }
+                int method = 0;
+                if (version == 1 || version == 2) {
+                    if (!b.has(o, 2)) break;
+                    method = b.be16(o) & 0xF;
+                    o += 2;
+                }
+                o += 2;  // Data reference index
+                quint64 base = 0;
+                if (!ilocField(b, o, baseOffsetSize, base) || !b.has(o, 2)) break;
+                const int extentCount = b.be16(o);
+                o += 2;
+                bool ok = true;
+                for (int x = 0; x < extentCount && ok; ++x) {
+                    quint64 index = 0;
+                    quint64 offset = 0;
+                    quint64 length = 0;
+                    ok = (indexSize == 0 || ilocField(b, o, indexSize, index)) &&
+                         ilocField(b, o, offsetSize, offset) && ilocField(b, o, lengthSize, length);
+                    // File offsets only; one extent is enough for these small items
+                    if (ok && x == 0 && method == 0) extents.push_back({quint32(id), base + offset, length});
+                }
+                if (!ok) break;
+            }
+        }
+    }
+
+    auto itemData = [&](quint32 item) {
+        for (const Extent& extent : extents) {
+            if (extent.item != item || extent.offset > quint64(file.size)) continue;
+            // A zero length runs to the end of the file
+            const qint64 offset = qint64(extent.offset);
+            return file.mid(offset, extent.length == 0 ? file.size - offset : qint64(extent.length));
+        }
+        return Bytes();
+    };
+
+    if (exifItem != 0) {
+        // Four bytes of offset to the TIFF header (past any "Exif\0\0")
+        const Bytes exif = itemData(exifItem);
+        if (!exif.has(0, 4)) return false;
+        if (!parseTiff(exif.from(4 + qint64(exif.be32(0))), meta, fields)) return false;
+    }
+    if (xmpItem != 0) {
+        const Bytes xmp = itemData(xmpItem);
+        if (xmp.data) fields.xmp = xmp.toByteArray();
+    }
+    return true;
+}
+
+bool isHeifBrand(quint32 brand) {
+    for (quint32 known : {fourcc("heic"), fourcc("heix"), fourcc("heim"), fourcc("heis"),
+                          fourcc("hevc"), fourcc("hevx"), fourcc("mif1"), fourcc("msf1")}) {
+        if (brand == known) return true;
+    }
+    return false;
+}
+
+bool isHeif(const std::vector<Box>& top) {
+    if (top.empty() || top.front().type != fourcc("ftyp")) return false;
+    const Bytes ftyp = top.front().body;
+    if (!ftyp.has(0, 4)) return false;
+    if (isHeifBrand(ftyp.be32(0))) return true;
+    // Compatible brands follow the major brand and its version
+    for (qint64 o = 8; ftyp.has(o, 4); o += 4) {
+        if (isHeifBrand(ftyp.be32(o))) return true;
+    }
+    return false;
+}
+
+constexpr QLatin1String RDF_NS("http://www.w3.org/1999/02/22-rdf-syntax-ns#");
+constexpr QLatin1String XMP_NS("http://ns.adobe.com/xap/1.0/");
+constexpr QLatin1String DC_NS("http://purl.org/dc/elements/1.1/");
+constexpr QLatin1String PHOTOSHOP_NS("http://ns.adobe.com/photoshop/1.0/");
+
+// The XMP properties parseExifToolObject() reads, as attributes of
+// rdf:Description or as elements
+void parseXmp(const QByteArray& packet, PhotoMetadata& meta, Fields& fields) {
+    auto simple = [&](QStringView ns, QStringView name, const QString& value) {
+        if (ns == XMP_NS && name == u"Rating") {
+            meta.rating = value.trimmed().toInt();
+            fields.hasXmpRating = true;
+        } else if (ns == PHOTOSHOP_NS) {
+            if (name == u"Category") meta.llm_category = value;
+            else if (name == u"City") fields.city = value;
+            else if (name == u"State") fields.state = value;
+            else if (name == u"Country") fields.country = value;
+        }
+    };
+
+    enum class List { None, Title, Description, Subject };
+    List list = List::None;
+    bool titleDefault = false;
+    bool descriptionDefault = false;
+
+    QXmlStreamReader xml(packet);
+    while (!xml.atEnd() && !xml.hasError()) {
+        xml.readNext();
+        if (xml.isEndElement()) {
+            if (xml.namespaceUri() == DC_NS) list = List::None;
+            continue;
+        }
+        if (!xml.isStartElement()) continue;
+
+        const QStringView ns = xml.namespaceUri();
+        const QStringView name = xml.name();
+        if (ns == RDF_NS && name == u"Description") {
+            for (const QXmlStreamAttribute& attribute : xml.attributes()) {
+                simple(attribute.namespaceUri(), attribute.name(), attribute.value().toString());
+            }
+        } else if (ns == RDF_NS && name == u"li" && list != List::None) {
+            // Language alternatives: x-default wins, else the first
+            const bool isDefault = xml.attributes().value(QLatin1String("xml:lang")) == u"x-default";
+            const QString text = xml.readElementText(QXmlStreamReader::SkipChildElements);
+            if (list == List::Subject) {
+                meta.llm_keywords << text;
+            } else if (list == List::Title && (meta.llm_title.isEmpty() || (isDefault && !titleDefault))) {
+                meta.llm_title = text;
+                titleDefault = isDefault;
+            } else if (list == List::Description &&
+                       (meta.llm_description.isEmpty() || (isDefault && !descriptionDefault))) {
+                meta.llm_description = text;
+                descriptionDefault = isDefault;
+            }
+        } else if (ns == DC_NS) {
+            if (name == u"title") list = List::Title;
+            else if (name == u"description") list = List::Description;
+            else if (name == u"subject") list = List::Subject;
+        } else if (ns == XMP_NS || ns == PHOTOSHOP_NS) {
+            simple(ns, name, xml.readElementText(QXmlStreamReader::SkipChildElements));
+        }
+    }
+}
+
+void assemble(Fields& fields, PhotoMetadata& meta) {
+    if (!fields.xmp.isEmpty()) parseXmp(fields.xmp, meta, fields);
+    if (!fields.hasXmpRating) meta.rating = fields.exifRating;
+
+    if (!fields.dateTime.isEmpty()) {
+        meta.datetime_original = QDateTime::fromString(fields.dateTime, "yyyy:MM:dd hh:mm:ss");
+        bool ok = false;
+        double fraction = ("0." + fields.subSec.trimmed()).toDouble(&ok);
+        if (ok && meta.datetime_original.isValid()) {
+            meta.datetime_original = meta.datetime_original.addMSecs(qRound(fraction * 1000.0));
+        }
+    }
+
+    meta.gps_lat = fields.latRef.startsWith('S') ? -fields.lat : fields.lat;
+    meta.gps_lon = fields.lonRef.startsWith('W') ? -fields.lon : fields.lon;
+
+    meta.location_name = fields.city;
+    if (!fields.state.isEmpty()) {
+        meta.location_name += ", " + fields.state;
+    }
+    if (!fields.country.isEmpty()) {
+        if (!meta.location_name.isEmpty()) meta.location_name += ", ";
+        meta.location_name += fields.country;
+    }
+
+    if (fields.userComment.startsWith("PhotoGuru:")) {
+        int jsonStart = fields.userComment.indexOf('{');
+        QJsonDocument doc = jsonStart < 0 ? QJsonDocument()
+                                          : QJsonDocument::fromJson(fields.userComment.mid(jsonStart).toUtf8());
+        if (doc.isObject()) meta.technical = TechnicalMetadata::fromJson(doc.object());
+    }
+}
+
+std::optional<PhotoMetadata> parseBytes(Bytes file, const QString& filePath) {
+    PhotoMetadata meta;
+    meta.filepath = filePath;
+    meta.filename = QFileInfo(filePath).fileName();
+    Fields fields;
+
+    bool parsed = false;
+    if (file.has(0, 3) && file.data[0] == 0xFF && file.data[1] == 0xD8 && file.data[2] == 0xFF) {
+        parsed = parseJpeg(file, meta, fields);
+    } else if (file.startsWith("II*\0", 4) || file.startsWith("MM\0*", 4)) {
+        parsed = parseTiff(file, meta, fields);
+    } else {
+        const std::vector<Box> top = boxes(file);
+        parsed = isHeif(top) && parseHeif(file, top, meta, fields);
+    }
+    if (!parsed) return std::nullopt;
+
+    assemble(fields, meta);
+    return meta;
+}
+
+} // namespace
+
+std::optional<PhotoMetadata> ExifFastReader::read(const QString& filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+
+    // Mapped, so a raw's image data is never paged in
+    const qint64 size = file.size();
+    if (uchar* mapped = file.map(0, size)) {
+        std::optional<PhotoMetadata> meta = parseBytes(Bytes{mapped, size}, filePath);
+        file.unmap(mapped);
+        return meta;
+    }
+    return parse(file.readAll(), filePath);
+}
+
+std::optional<PhotoMetadata> ExifFastReader::parse(const QByteArray& data, const QString& filePath) {
+    return parseBytes(Bytes{reinterpret_cast<const uchar*>(data.constData()), data.size()}, filePath);
+}
+
+} // namespace PhotoGuru
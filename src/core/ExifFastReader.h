@@ -0,0 +1,36 @@
+#pragma once
+
+#include "PhotoMetadata.h"
+#include <QString>
+#include <QByteArray>
+#include <optional>
+
+namespace PhotoGuru {
+
+/**
+ * @brief In-process reader for the metadata fields filters and views use
+ *
+ * Parses the EXIF (TIFF) and XMP packets straight out of a memory-mapped
+ * file, with no ExifTool round trip: JPEG (APP1 segments), TIFF-based
+ * raws such as DNG, CR2, NEF and ARW, and HEIC/HEIF (Exif and XMP items
+ * of the meta box). Only the pages holding those packets are touched.
+ *
+ * Fills what parseExifToolObject() reads from the same tags, with the same
+ * conversions: capture time with sub-seconds, camera, exposure, signed
+ * GPS, rating, title, description, keywords, category, location and the
+ * PhotoGuru technical block. MakerNotes fields (sequence_number,
+ * burst_id) and the scene stay empty.
+ *
+ * Returns nullopt when the container isn't one of the above, a packet is
+ * malformed, or the fields live where only ExifTool looks (IPTC without
+ * XMP); the caller reads those with ExifTool. Thread-safe.
+ */
+class ExifFastReader {
+public:
+    static std::optional<PhotoMetadata> read(const QString& filePath);
+
+    // Same over a file's bytes already in memory
+    static std::optional<PhotoMetadata> parse(const QByteArray& data, const QString& filePath);
+};
+
+} // namespace PhotoGuru
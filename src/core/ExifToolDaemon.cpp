@@ -1,7 +1,10 @@
 #include "ExifToolDaemon.h"
+#include "Trace.h"
 #include <QFileInfo>
 #include <QDebug>
 #include <QThread>
+#include <QDeadlineTimer>
+#include <QVector>
 
 namespace PhotoGuru {
 
@@ -11,7 +14,8 @@ ExifToolDaemon& ExifToolDaemon::instance() {
 }
 
 ExifToolDaemon::ExifToolDaemon() {
-    // Auto-start on first use
+    // Auto-start on first use; one process per core, capped
+    m_maxWorkers = qBound(1, QThread::idealThreadCount(), MAX_POOL_SIZE);
 }
 
 ExifToolDaemon::~ExifToolDaemon() {
@@ -24,82 +28,124 @@ QString ExifToolDaemon::findExifToolPath() const {
         "/usr/local/bin/exiftool",
         "/usr/bin/exiftool"
     };
-    
+
     for (const QString& path : locations) {
         if (QFileInfo::exists(path)) {
             return path;
         }
     }
-    
+
     return "exiftool"; // Try PATH
 }
 
-bool ExifToolDaemon::start() {
-    QMutexLocker locker(&m_mutex);
-    
-    if (m_running) {
-        return true;
-    }
-    
+QProcess* ExifToolDaemon::spawnProcess() {
     QString exifToolPath = findExifToolPath();
-    
-    m_process = new QProcess();
-    m_process->setProgram(exifToolPath);
+
+    QProcess* process = new QProcess();
+    process->setProgram(exifToolPath);
     // NÃO merge channels - precisamos ler stdout separadamente para evitar deadlock
-    m_process->setProcessChannelMode(QProcess::SeparateChannels);
-    
+    process->setProcessChannelMode(QProcess::SeparateChannels);
+
     // Stay-open mode: process stays alive, reads commands from stdin
     QStringList args = {
         "-stay_open", "True",
         "-@", "-"              // Read args from stdin
     };
-    
-    m_process->setArguments(args);
-    m_process->start();
-    
-    if (!m_process->waitForStarted(3000)) {
+
+    process->setArguments(args);
+    process->start();
+
+    if (!process->waitForStarted(3000)) {
         qCritical() << "Failed to start ExifTool daemon at:" << exifToolPath;
-        delete m_process;
-        m_process = nullptr;
+        delete process;
+        return nullptr;
+    }
+
+    return process;
+}
+
+void ExifToolDaemon::terminateProcess(QProcess* process) {
+    if (!process) {
+        return;
+    }
+
+    if (process->state() != QProcess::NotRunning) {
+        // Send exit command
+        process->write("-stay_open\nFalse\n");
+        process->closeWriteChannel();
+
+        // Wait for graceful exit
+        if (!process->waitForFinished(2000)) {
+            qWarning() << "ExifTool did not exit gracefully, terminating...";
+            process->terminate();
+
+            // Force kill if terminate doesn't work
+            if (!process->waitForFinished(1000)) {
+                qWarning() << "Force killing ExifTool process";
+                process->kill();
+                process->waitForFinished(500);
+            }
+        }
+    }
+
+    delete process;
+}
+
+bool ExifToolDaemon::start() {
+    QMutexLocker locker(&m_mutex);
+
+    if (m_running) {
+        return true;
+    }
+
+    // Start one process eagerly; the rest spawn on demand under load
+    QProcess* process = spawnProcess();
+    if (!process) {
         return false;
     }
-    
+
+    Worker* worker = new Worker;
+    worker->process = process;
+    m_workers.append(worker);
+
     m_running = true;
-    qDebug() << "ExifTool daemon started (stay-open mode)";
-    
+    qDebug() << "ExifTool daemon started (stay-open mode, pool up to" << m_maxWorkers << "processes)";
+
     return true;
 }
 
 void ExifToolDaemon::stop() {
     QMutexLocker locker(&m_mutex);
-    
-    if (!m_running || !m_process) {
+
+    if (!m_running) {
         return;
     }
-    
+
     qDebug() << "Stopping ExifTool daemon...";
-    
-    // Send exit command
-    m_process->write("-stay_open\nFalse\n");
-    m_process->closeWriteChannel();
-    
-    // Wait for graceful exit
-    if (!m_process->waitForFinished(2000)) {
-        qWarning() << "ExifTool did not exit gracefully, terminating...";
-        m_process->terminate();
-        
-        // Force kill if terminate doesn't work
-        if (!m_process->waitForFinished(1000)) {
-            qWarning() << "Force killing ExifTool process";
-            m_process->kill();
-            m_process->waitForFinished(500);
+
+    // Refuse new work, then let in-flight commands finish
+    // (readResponse has its own timeout so this is bounded)
+    m_running = false;
+    auto anyBusy = [this]() {
+        if (m_spawning > 0) return true;
+        for (const Worker* worker : m_workers) {
+            if (worker->busy) return true;
         }
+        return false;
+    };
+    while (anyBusy()) {
+        m_workerAvailable.wait(&m_mutex);
     }
-    
-    delete m_process;
-    m_process = nullptr;
-    m_running = false;
-    
+
+    for (Worker* worker : m_workers) {
+        terminateProcess(worker->process);
+        delete worker;
+    }
+    m_workers.clear();
+
+    // Wake anyone blocked in acquireWorker so they can bail out
+    m_workerAvailable.wakeAll();
+
     qDebug() << "ExifTool daemon stopped";
 }
 
@@ -108,102 +154,209 @@ bool ExifToolDaemon::isRunning() const {
     return m_running;
 }
 
-QString ExifToolDaemon::executeCommand(const QStringList& args) {
-    // Lock ONCE for entire operation
+int ExifToolDaemon::poolSize() const {
     QMutexLocker locker(&m_mutex);
-    
-    // Start if needed (already holding lock)
-    if (!m_running) {
-        locker.unlock();  // Temporarily unlock for start()
-        if (!const_cast<ExifToolDaemon*>(this)->start()) {
-            qWarning() << "[ExifToolDaemon] Failed to start";
-            return QString();
+    return m_maxWorkers;
+}
+
+void ExifToolDaemon::setPoolSize(int size) {
+    QMutexLocker locker(&m_mutex);
+    m_maxWorkers = qBound(1, size, MAX_POOL_SIZE);
+}
+
+ExifToolDaemon::Worker* ExifToolDaemon::acquireWorker() {
+    // Start if needed
+    if (!isRunning() && !start()) {
+        qWarning() << "[ExifToolDaemon] Failed to start";
+        return nullptr;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    while (m_running) {
+        for (Worker* worker : m_workers) {
+            if (!worker->busy) {
+                worker->busy = true;
+                return worker;
+            }
+        }
+
+        // All busy - grow the pool if allowed. The slot is ours once
+        // counted; the start (up to 3 s) runs unlocked, so callers that
+        // a busy worker frees meanwhile aren't held up behind it
+        if (m_workers.size() + m_spawning < m_maxWorkers) {
+            m_spawning++;
+            locker.unlock();
+            QProcess* process = spawnProcess();
+            locker.relock();
+            m_spawning--;
+            if (process && !m_running) {
+                // stop() came meanwhile; it waited for us to finish
+                m_workerAvailable.wakeAll();
+                locker.unlock();
+                terminateProcess(process);
+                return nullptr;
+            }
+            if (process) {
+                Worker* worker = new Worker;
+                worker->process = process;
+                worker->busy = true;
+                m_workers.append(worker);
+                return worker;
+            }
+            m_workerAvailable.wakeAll();  // The slot is free again
+            if (m_workers.isEmpty() && m_spawning == 0) {
+                return nullptr;
+            }
         }
-        locker.relock();  // Re-acquire lock
+
+        TRACE_GAUGE("exiftool.waiting", m_waiting + 1);
+        m_waiting++;
+        m_workerAvailable.wait(&m_mutex);
+        m_waiting--;
+        TRACE_GAUGE("exiftool.waiting", m_waiting);
     }
-    
-    if (!m_process) {
-        return QString();
+
+    return nullptr;
+}
+
+void ExifToolDaemon::releaseWorker(Worker* worker) {
+    QMutexLocker locker(&m_mutex);
+
+    // Dead process (crash or killed) - drop it so the pool respawns on demand
+    if (worker->process->state() == QProcess::NotRunning) {
+        qWarning() << "[ExifToolDaemon] Process exited unexpectedly, removing from pool";
+        m_workers.removeOne(worker);
+        delete worker->process;
+        delete worker;
+    } else {
+        worker->busy = false;
     }
-    
-    // Write each argument on separate line
-    for (const QString& arg : args) {
-        m_process->write(arg.toUtf8());
-        m_process->write("\n");
+
+    m_workerAvailable.wakeAll();
+}
+
+QString ExifToolDaemon::executeCommand(const QStringList& args, bool* timedOut) {
+    TRACE_SCOPE("exiftool.roundtrip");
+    Worker* worker = acquireWorker();
+    if (!worker) {
+        return QString();
     }
-    // Send execute marker
-    m_process->write("-execute\n");
-    m_process->waitForBytesWritten(3000);
-    
-    // Read response (mutex still held)
-    return readResponse();
+
+    quint32 sequence = writeCommand(worker, args);
+
+    // Read response (worker held exclusively)
+    QString response = readResponse(worker, sequence, timedOut);
+    releaseWorker(worker);
+    return response;
 }
 
 QStringList ExifToolDaemon::executeBatch(const QStringList& commands) {
-    // Lock ONCE for entire batch operation
-    QMutexLocker locker(&m_mutex);
-    
-    // Start if needed (already holding lock)
-    if (!m_running) {
-        locker.unlock();  // Temporarily unlock for start()
-        if (!const_cast<ExifToolDaemon*>(this)->start()) {
-            qWarning() << "Failed to start ExifTool daemon";
-            return QStringList();
-        }
-        locker.relock();  // Re-acquire lock
-    }
-    
-    if (!m_process) {
+    // Hold one worker for the entire batch
+    Worker* worker = acquireWorker();
+    if (!worker) {
+        qWarning() << "Failed to start ExifTool daemon";
         return QStringList();
     }
-    
-    QStringList results;
-    
-    // Execute all commands
+
+    // Pipeline: queue every command first, then collect responses in order.
+    // Exiftool processes them back to back without waiting on our reads.
+    QVector<quint32> sequences;
+    sequences.reserve(commands.size());
     for (const QString& cmd : commands) {
-        m_process->write(cmd.toUtf8() + "\n");
-        m_process->write(EXECUTE_MARKER);
-        m_process->waitForBytesWritten(1000);
-        
-        QString response = readResponse();
-        results.append(response);
-    }
-    
+        sequences.append(writeCommand(worker, cmd.split('\n')));
+    }
+
+    QStringList results;
+    for (quint32 sequence : sequences) {
+        results.append(readResponse(worker, sequence));
+    }
+
+    releaseWorker(worker);
     return results;
 }
 
-QString ExifToolDaemon::readResponse() {
-    // Read until we see {ready} marker
-    QByteArray buffer;
-    
-    const int timeout = 10000; // 10 seconds  
-    const int pollInterval = 50; // 50ms
-    int elapsed = 0;
-    
-    while (elapsed < timeout) {
-        // Espera dados ficarem disponíveis
-        if (m_process->waitForReadyRead(pollInterval)) {
-            // Lê TODOS os dados disponíveis imediatamente
-            QByteArray data = m_process->readAllStandardOutput();
-            buffer.append(data);
-            
-            // Check for ready marker
-            if (buffer.contains(READY_MARKER)) {
-                // Extract response (everything before {ready})
-                int markerPos = buffer.indexOf(READY_MARKER);
-                QString output = QString::fromUtf8(buffer.left(markerPos));
-                return output.trimmed();
+quint32 ExifToolDaemon::writeCommand(Worker* worker, const QStringList& args) {
+    quint32 sequence = worker->nextSequence++;
+
+    // Each argument on its own line, then -executeNNN so the response
+    // ends with a {readyNNN} marker we can match exactly
+    QByteArray payload;
+    for (const QString& arg : args) {
+        payload += arg.toUtf8();
+        payload += '\n';
+    }
+    payload += EXECUTE_MARKER;
+    payload += QByteArray::number(sequence);
+    payload += '\n';
+
+    worker->process->write(payload);
+    return sequence;
+}
+
+QString ExifToolDaemon::readResponse(Worker* worker, quint32 sequence, bool* timedOut) {
+    if (timedOut) *timedOut = false;
+    QProcess* process = worker->process;
+    QByteArray& buffer = worker->buffer;
+
+    QByteArray marker = READY_MARKER + QByteArray::number(sequence) + '}';
+    QDeadlineTimer deadline(RESPONSE_TIMEOUT_MS);
+
+    while (true) {
+        // Only scan bytes that arrived since the last pass, keeping enough
+        // overlap to catch a marker split across two reads
+        int from = qMax(0, worker->scanned - int(marker.size()) + 1);
+        int markerPos = buffer.indexOf(marker, from);
+
+        if (markerPos >= 0) {
+            // Payload is everything before {readyNNN}
+            QString output = QString::fromUtf8(buffer.constData(), markerPos).trimmed();
+
+            int end = markerPos + marker.size();
+            if (end < buffer.size() && buffer.at(end) == '\n') {
+                end++;
+            }
+            buffer.remove(0, end);
+            worker->scanned = 0;
+
+            // Keep stderr drained so exiftool never blocks on a full pipe
+            QByteArray errors = process->readAllStandardError();
+            if (!errors.isEmpty()) {
+                qDebug() << "[ExifToolDaemon] stderr:" << errors.trimmed();
             }
+
+            return output;
+        }
+
+        worker->scanned = buffer.size();
+
+        if (deadline.hasExpired() || process->state() == QProcess::NotRunning) {
+            break;
+        }
+
+        // Block until data arrives (no fixed polling interval). Output
+        // means progress: 200 RAWs on a share may take far longer in all
+        if (process->waitForReadyRead(int(deadline.remainingTime()))) {
+            buffer += process->readAllStandardOutput();
+            deadline.setRemainingTime(RESPONSE_TIMEOUT_MS);
         }
-        
-        elapsed += pollInterval;
     }
-    
+
     // Timeout - loga erro e retorna o que temos
-    qWarning() << "[ExifToolDaemon] Response timeout after" << timeout << "ms";
+    qWarning() << "[ExifToolDaemon] No response for" << RESPONSE_TIMEOUT_MS << "ms";
+    if (timedOut) *timedOut = true;
     qWarning() << "[ExifToolDaemon] Buffer contents:" << buffer;
-    
-    return QString::fromUtf8(buffer).trimmed();
+
+    QString output = QString::fromUtf8(buffer).trimmed();
+    buffer.clear();
+    worker->scanned = 0;
+
+    // A late {readyNNN} would desync this process; kill it so
+    // releaseWorker drops it and the pool respawns a clean one
+    process->kill();
+    process->waitForFinished(500);
+
+    return output;
 }
 
 } // namespace PhotoGuru
@@ -11,9 +11,14 @@ namespace PhotoGuru {
 /**
  * @brief Daemon ExifTool usando stay-open mode para performance
  * 
- * Mantém processo ExifTool vivo entre chamadas, eliminando fork/exec overhead.
+ * Mantém processos ExifTool vivos entre chamadas, eliminando fork/exec overhead.
  * Performance: 5-10x mais rápido que spawn por chamada.
- * Thread-safe com mutex interno.
+ * 
+ * Thread-safe: keeps a pool of stay-open processes (sized by core count,
+ * started lazily) so commands from several threads run concurrently.
+ * Each command holds one process exclusively until its {ready} marker.
+ * Commands are tagged -executeNNN so responses are matched by sequence
+ * number, which also lets executeBatch pipeline every command up front.
  */
 class ExifToolDaemon : public QObject {
     Q_OBJECT
@@ -26,10 +31,15 @@ public:
     void stop();
     bool isRunning() const;
     
-    // Commands (thread-safe)
-    QString executeCommand(const QStringList& args);
+    // Pool sizing (takes effect for processes spawned after the call)
+    int poolSize() const;
+    void setPoolSize(int size);
+    
+    // Commands (thread-safe). *timedOut is set when exiftool went quiet
+    // for RESPONSE_TIMEOUT_MS before answering (the output is then partial)
+    QString executeCommand(const QStringList& args, bool* timedOut = nullptr);
     
-    // Batch operations (mais eficiente)
+    // Batch operations (mais eficiente) - all commands run on one process
     QStringList executeBatch(const QStringList& commands);
     
 private:
@@ -38,15 +48,35 @@ private:
     ExifToolDaemon(const ExifToolDaemon&) = delete;
     ExifToolDaemon& operator=(const ExifToolDaemon&) = delete;
     
+    struct Worker {
+        QProcess* process = nullptr;
+        bool busy = false;
+        QByteArray buffer;        // Unconsumed stdout
+        int scanned = 0;          // Bytes of buffer already searched for a marker
+        quint32 nextSequence = 1; // Tag for -executeNNN / {readyNNN}
+    };
+    
     QString findExifToolPath() const;
-    QString readResponse();
+    QProcess* spawnProcess();
+    void terminateProcess(QProcess* process);
+    Worker* acquireWorker();
+    void releaseWorker(Worker* worker);
+    quint32 writeCommand(Worker* worker, const QStringList& args);
+    QString readResponse(Worker* worker, quint32 sequence, bool* timedOut = nullptr);
     
-    QProcess* m_process = nullptr;
+    QList<Worker*> m_workers;
+    int m_maxWorkers = 1;
     mutable QMutex m_mutex;  // mutable para permitir lock() em métodos const
+    QWaitCondition m_workerAvailable;
+    int m_waiting = 0;       // Callers blocked in acquireWorker()
+    int m_spawning = 0;      // Pool slots whose process is starting outside the lock
     bool m_running = false;
     
-    static constexpr const char* EXECUTE_MARKER = "-execute\n";
-    static constexpr const char* READY_MARKER = "{ready}";
+    static constexpr int MAX_POOL_SIZE = 8;
+    // Without a byte of output; a long command that keeps writing keeps going
+    static constexpr int RESPONSE_TIMEOUT_MS = 10000;
+    static constexpr const char* EXECUTE_MARKER = "-execute";
+    static constexpr const char* READY_MARKER = "{ready";
 };
 
 } // namespace PhotoGuru
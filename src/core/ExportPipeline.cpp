@@ -0,0 +1,183 @@
+#include "ExportPipeline.h"
+#include "ExifToolDaemon.h"
+#include "ImageLoader.h"
+#include "Trace.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QSet>
+
+namespace PhotoGuru {
+
+ExportPipeline::Stages ExportPipeline::defaultStages() {
+    Stages stages;
+    stages.decode = [](const QString& path, const QSize& bound) {
+        ImageLoader& loader = ImageLoader::instance();
+        // Most cameras embed a full-size JPEG: worth trying at any edge before a demosaic
+        if (bound.isValid() && loader.detectFormat(path) == ImageFormat::RAW) {
+            if (auto preview = loader.loadRAWPreview(path, bound)) return *preview;
+        }
+        return loader.load(path, bound).value_or(QImage());
+    };
+    stages.encode = [](const QImage& image, const QString& target, const Options& options) {
+        QSaveFile file(target);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << "[ExportPipeline] Cannot write" << target << file.errorString();
+            return false;
+        }
+        QImageWriter writer(&file, options.format);
+        writer.setQuality(options.quality);
+        if (options.format == "jpg") {
+            writer.setOptimizedWrite(true);
+            writer.setProgressiveScanWrite(true);  // Web delivery: shows coarse first
+        }
+        if (!writer.write(image)) {
+            qWarning() << "[ExportPipeline] Encoding" << target << "failed:" << writer.errorString();
+            file.cancelWriting();
+            return false;
+        }
+        return file.commit();
+    };
+    stages.copyMetadata = [](const QString& source, const QString& target) {
+        // The pixels are upright already, and the source's previews don't belong
+        const QString output = ExifToolDaemon::instance().executeCommand({
+            "-tagsFromFile", source, "-all:all", "--Orientation", "--ThumbnailImage", "--PreviewImage",
+            "-overwrite_original", target});
+        if (output.contains("Error:", Qt::CaseInsensitive) || !output.contains("1 image files updated")) {
+            qWarning() << "[ExportPipeline] Metadata copy to" << target << "failed:" << output;
+            return false;
+        }
+        return true;
+    };
+    return stages;
+}
+
+ExportPipeline::ExportPipeline(Stages stages, QObject* parent)
+    : QObject(parent)
+    , m_stages(std::move(stages))
+{
+}
+
+ExportPipeline::~ExportPipeline() {
+    cancel();
+    wait();
+}
+
+bool ExportPipeline::start(const QStringList& files, const Options& options) {
+    if (isRunning() || files.isEmpty()) return false;
+    if (options.directory.isEmpty() || !supportedFormats().contains(options.format)) {
+        qWarning() << "[ExportPipeline] Cannot export as" << options.format << "to" << options.directory;
+        return false;
+    }
+    if (!QDir().mkpath(options.directory)) {
+        qWarning() << "[ExportPipeline] Cannot create" << options.directory;
+        return false;
+    }
+    wait();  // Previous run may still be unwinding after cancel
+
+    const QStringList targets = targetPaths(files, options.directory, options.format);
+    m_total = int(files.size());
+    m_finished.storeRelaxed(0);
+    m_exported.storeRelaxed(0);
+    m_failed.storeRelaxed(0);
+    m_cancelled.storeRelaxed(0);
+    m_running.storeRelease(1);
+
+    // Each running file holds one decoded frame: the cap bounds memory too
+    m_tasks.setMaxConcurrency(std::max(0, options.jobs));
+    for (int i = 0; i < files.size(); ++i) {
+        m_tasks.start([this, source = files[i], target = targets[i], options]() {
+            exportFile(source, target, options);
+        });
+    }
+    return true;
+}
+
+void ExportPipeline::cancel() {
+    m_cancelled.storeRelaxed(1);
+}
+
+void ExportPipeline::wait() {
+    m_tasks.waitForDone();
+}
+
+void ExportPipeline::exportFile(const QString& source, const QString& target, const Options& options) {
+    // Dropped files still report, so finished() always comes
+    if (m_cancelled.loadRelaxed()) {
+        fileDone(Outcome::Skipped, source);
+        return;
+    }
+    TRACE_SCOPE("export.file");
+
+    const QSize bound = options.longEdge > 0 ? QSize(options.longEdge, options.longEdge) : QSize();
+    QImage image = m_stages.decode(source, bound);
+    if (image.isNull()) {
+        qWarning() << "[ExportPipeline] Cannot decode" << source;
+        fileDone(Outcome::Failed, source);
+        return;
+    }
+    image = resize(image, options.longEdge);
+
+    if (!m_stages.encode(image, target, options)) {
+        fileDone(Outcome::Failed, source);
+        return;
+    }
+    // Pixels are out: a file whose tags didn't follow is still delivered
+    if (options.copyMetadata && m_stages.copyMetadata) {
+        m_stages.copyMetadata(source, target);
+    }
+    fileDone(Outcome::Exported, source);
+}
+
+void ExportPipeline::fileDone(Outcome outcome, const QString& source) {
+    if (outcome == Outcome::Exported) m_exported.fetchAndAddRelaxed(1);
+    if (outcome == Outcome::Failed) m_failed.fetchAndAddRelaxed(1);
+
+    const int finished = m_finished.fetchAndAddAcqRel(1) + 1;
+    if (outcome != Outcome::Skipped) {
+        emit progress(finished, m_total, QFileInfo(source).fileName());
+    }
+    if (finished == m_total) {
+        const bool cancelled = m_cancelled.loadRelaxed() != 0;
+        const int exported = m_exported.loadRelaxed();
+        const int failed = m_failed.loadRelaxed();
+        m_running.storeRelease(0);
+        emit finished(exported, failed, cancelled);
+    }
+}
+
+QImage ExportPipeline::resize(const QImage& image, int longEdge) {
+    if (longEdge <= 0 || (image.width() <= longEdge && image.height() <= longEdge)) return image;
+    return image.scaled(longEdge, longEdge, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+QStringList ExportPipeline::targetPaths(const QStringList& files, const QString& directory,
+                                        const QByteArray& format) {
+    const QDir dir(directory);
+    const QString suffix = QString::fromLatin1(format);
+    QSet<QString> taken;  // Lower case: the target may be case-insensitive
+    QStringList targets;
+    for (const QString& file : files) {
+        const QString base = QFileInfo(file).completeBaseName();
+        QString target = dir.filePath(base + '.' + suffix);
+        for (int n = 1; taken.contains(target.toLower()) || QFileInfo::exists(target); ++n) {
+            target = dir.filePath(QString("%1-%2.%3").arg(base).arg(n).arg(suffix));
+        }
+        taken.insert(target.toLower());
+        targets << target;
+    }
+    return targets;
+}
+
+QList<QByteArray> ExportPipeline::supportedFormats() {
+    const QList<QByteArray> writable = QImageWriter::supportedImageFormats();
+    QList<QByteArray> formats;
+    for (const QByteArray& format : {QByteArray("jpg"), QByteArray("webp"), QByteArray("png")}) {
+        if (writable.contains(format)) formats << format;
+    }
+    return formats;
+}
+
+} // namespace PhotoGuru
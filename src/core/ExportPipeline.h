@@ -0,0 +1,107 @@
+#pragma once
+
+#include "TaskScheduler.h"
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QImage>
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Exports a selection as resized JPEG/WebP/PNG files, in parallel
+ *
+ *   file -> decode (bounded) -> resize -> encode -> metadata copy
+ *
+ * One task per file on the TaskScheduler's Ingest class, at most
+ * Options::jobs at once. Only the tasks running hold pixels, so memory
+ * stays at jobs decoded frames however large the selection; the
+ * tasks queued hold a path.
+ *
+ * Decoding takes the cheapest source that still covers the long edge:
+ * a RAW's embedded preview, a HEIF's thumbnail, a JPEG scaled in the
+ * DCT domain (ImageLoader does the last two), and only then the full
+ * frame. The resize is Qt's smooth (area-averaging, SIMD) scale down to
+ * the edge; nothing is upscaled. Outputs are written through QSaveFile,
+ * so a failed or cancelled file leaves nothing behind, then get the
+ * source's metadata through the ExifTool pool (minus orientation,
+ * since the pixels are already upright, and the embedded previews).
+ *
+ * Target names are chosen up front: the source's base name with the
+ * format's suffix, numbered when that name is taken on disk or within
+ * the selection. cancel() drops the files not started. Signals are
+ * emitted from worker threads.
+ */
+class ExportPipeline : public QObject {
+    Q_OBJECT
+
+public:
+    struct Options {
+        QString directory;
+        int longEdge = DEFAULT_LONG_EDGE;  // 0 = full resolution
+        QByteArray format = "jpg";         // jpg, webp, png (supportedFormats())
+        int quality = DEFAULT_QUALITY;     // 0-100
+        bool copyMetadata = true;
+        int jobs = 0;                      // Files at once; 0 = the Ingest class limit
+    };
+
+    // Stage implementations; defaultStages() wires ImageLoader/QImageWriter/ExifToolDaemon.
+    // copyMetadata may be empty.
+    struct Stages {
+        // At least `bound` on its long edge when the source is (invalid bound: full resolution)
+        std::function<QImage(const QString& path, const QSize& bound)> decode;
+        std::function<bool(const QImage& image, const QString& target, const Options& options)> encode;
+        std::function<bool(const QString& source, const QString& target)> copyMetadata;
+    };
+
+    static Stages defaultStages();
+
+    explicit ExportPipeline(Stages stages = defaultStages(), QObject* parent = nullptr);
+    ~ExportPipeline();
+
+    // Starts in the background; false while a run is active, without
+    // files, or for options it can't honour (no directory, unknown format)
+    bool start(const QStringList& files, const Options& options);
+    void cancel();
+    void wait();
+    bool isRunning() const { return m_running.loadAcquire() != 0; }
+
+    // Scaled down to fit longEdge x longEdge; as is when it already fits
+    static QImage resize(const QImage& image, int longEdge);
+
+    // Where each file goes in `directory`, in order
+    static QStringList targetPaths(const QStringList& files, const QString& directory, const QByteArray& format);
+
+    // Of jpg, webp and png, the ones this Qt can write
+    static QList<QByteArray> supportedFormats();
+
+    static constexpr int DEFAULT_LONG_EDGE = 2048;
+    static constexpr int DEFAULT_QUALITY = 85;
+
+signals:
+    void progress(int current, int total, const QString& message);
+    void finished(int exported, int failed, bool cancelled);
+
+private:
+    enum class Outcome { Exported, Failed, Skipped };
+
+    void exportFile(const QString& source, const QString& target, const Options& options);
+    void fileDone(Outcome outcome, const QString& source);
+
+    Stages m_stages;
+
+    int m_total = 0;
+    QAtomicInt m_finished{0};  // Files done, whatever their outcome
+    QAtomicInt m_exported{0};
+    QAtomicInt m_failed{0};
+    QAtomicInt m_cancelled{0};
+    QAtomicInt m_running{0};
+
+    TaskGroup m_tasks{TaskScheduler::Ingest};  // Last: waits for tasks before the rest goes
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,125 @@
+#include "FileClone.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+
+#if defined(Q_OS_UNIX)
+#include <cerrno>
+#include <cstdio>
+#endif
+#if defined(Q_OS_MACOS)
+#include <sys/attr.h>
+#include <sys/clonefile.h>
+#elif defined(Q_OS_LINUX)
+#include <algorithm>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace PhotoGuru {
+
+namespace {
+
+#if defined(Q_OS_LINUX)
+constexpr size_t COPY_RANGE_CHUNK = 64 * 1024 * 1024;
+
+// Clone or kernel copy into a new file; empty if neither applies here
+std::optional<FileClone::Method> copyInKernel(const QByteArray& source, const QByteArray& destination) {
+    const int in = ::open(source.constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return std::nullopt;
+    struct stat info;
+    if (::fstat(in, &info) != 0) {
+        ::close(in);
+        return std::nullopt;
+    }
+    const int out = ::open(destination.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, info.st_mode & 07777);
+    if (out < 0) {
+        ::close(in);
+        return std::nullopt;
+    }
+
+    std::optional<FileClone::Method> method;
+    if (::ioctl(out, FICLONE, in) == 0) {
+        method = FileClone::Method::Clone;
+    } else {
+        off_t remaining = info.st_size;
+        bool ok = true;
+        while (remaining > 0) {
+            const ssize_t copied = ::copy_file_range(in, nullptr, out, nullptr,
+                                                     std::min<size_t>(size_t(remaining), COPY_RANGE_CHUNK), 0);
+            if (copied < 0 && errno == EINTR) continue;
+            if (copied <= 0) {
+                ok = false;  // EXDEV on older kernels, ENOSYS, EINVAL on some filesystems
+                break;
+            }
+            remaining -= copied;
+        }
+        if (ok) method = FileClone::Method::Kernel;
+    }
+
+    ::close(in);
+    if (::close(out) != 0) method.reset();
+    if (!method) ::unlink(destination.constData());  // The byte copy starts afresh
+    return method;
+}
+#endif
+
+} // namespace
+
+std::optional<FileClone::Method> FileClone::copy(const QString& source, const QString& destination) {
+    if (QFileInfo::exists(destination)) {
+        return std::nullopt;
+    }
+
+#if defined(Q_OS_MACOS)
+    // Fails with ENOTSUP off APFS and EXDEV across volumes
+    if (::clonefile(QFile::encodeName(source).constData(), QFile::encodeName(destination).constData(), 0) == 0) {
+        return Method::Clone;
+    }
+#elif defined(Q_OS_LINUX)
+    if (auto method = copyInKernel(QFile::encodeName(source), QFile::encodeName(destination))) {
+        return method;
+    }
+#endif
+
+    QFile file(source);
+    if (!file.copy(destination)) {
+        qWarning() << "[FileClone] Cannot copy" << source << "to" << destination << file.errorString();
+        return std::nullopt;
+    }
+    return Method::Bytes;
+}
+
+bool FileClone::move(const QString& source, const QString& destination) {
+    if (QFileInfo::exists(destination)) {
+        return false;
+    }
+#if defined(Q_OS_UNIX)
+    // Not QFile::rename: across filesystems it falls back to a byte copy of its own
+    if (::rename(QFile::encodeName(source).constData(), QFile::encodeName(destination).constData()) == 0) {
+        return true;
+    }
+    if (errno != EXDEV) {
+        qWarning() << "[FileClone] Cannot move" << source << "to" << destination;
+        return false;
+    }
+
+    // Another filesystem: the data has to travel
+    if (!copy(source, destination)) {
+        return false;
+    }
+    if (!QFile::remove(source)) {
+        qWarning() << "[FileClone] Copied but cannot remove" << source;
+        QFile::remove(destination);
+        return false;
+    }
+    return true;
+#else
+    return QFile::rename(source, destination);
+#endif
+}
+
+} // namespace PhotoGuru
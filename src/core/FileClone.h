@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QString>
+#include <optional>
+
+namespace PhotoGuru {
+
+/**
+ * @brief File copies that let the filesystem share blocks where it can
+ *
+ * A byte copy of a 60 MB RAW file reads and writes 60 MB. APFS
+ * (clonefile), Btrfs and XFS (FICLONE) can instead make a copy-on-write
+ * clone that shares the original's blocks at no cost until either side
+ * changes. copy() tries, in order:
+ *   - a clone (macOS clonefile, Linux FICLONE);
+ *   - an in-kernel copy (Linux copy_file_range), which skips user space
+ *     and is a server-side copy on NFS 4.2 and SMB shares;
+ *   - a byte copy through QFile.
+ *
+ * Like QFile::copy, the destination must not exist. Thread-safe.
+ */
+class FileClone {
+public:
+    enum class Method { Clone, Kernel, Bytes };
+
+    // How the copy was made; empty if it failed
+    static std::optional<Method> copy(const QString& source, const QString& destination);
+
+    // Rename, or copy and remove across filesystems
+    static bool move(const QString& source, const QString& destination);
+
+private:
+    FileClone() = delete;
+};
+
+} // namespace PhotoGuru
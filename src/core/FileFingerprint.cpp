@@ -0,0 +1,142 @@
+#include "FileFingerprint.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QHash>
+
+namespace PhotoGuru {
+
+namespace {
+
+// QCryptographicHash rather than a new dependency: at these sizes the
+// read, not the hash, is what costs
+constexpr QCryptographicHash::Algorithm HASH = QCryptographicHash::Sha1;
+
+} // namespace
+
+FileFingerprint& FileFingerprint::instance() {
+    static FileFingerprint fingerprint;
+    return fingerprint;
+}
+
+QByteArray FileFingerprint::computeQuick(const QString& filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    const qint64 size = file.size();
+    QCryptographicHash hash(HASH);
+    hash.addData(QByteArray::number(size));
+
+    // Small files are hashed whole; otherwise head and tail
+    if (size <= 2 * SAMPLE_BYTES) {
+        hash.addData(file.readAll());
+    } else {
+        hash.addData(file.read(SAMPLE_BYTES));
+        file.seek(size - SAMPLE_BYTES);
+        hash.addData(file.read(SAMPLE_BYTES));
+    }
+    return hash.result();
+}
+
+QByteArray FileFingerprint::computeFull(const QString& filePath) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(HASH);
+    if (!hash.addData(&file)) {
+        return QByteArray();
+    }
+    return hash.result();
+}
+
+PhotoDatabase::Fingerprint FileFingerprint::record(const QString& filePath, bool withFull) {
+    PhotoDatabase& catalog = PhotoDatabase::instance();
+    std::optional<PhotoDatabase::Fingerprint> stored = catalog.freshFingerprint(filePath);
+    if (stored && (!withFull || !stored->full.isEmpty())) {
+        return *stored;
+    }
+
+    PhotoDatabase::Fingerprint fingerprint;
+    if (stored) {
+        fingerprint = *stored;
+    } else {
+        QFileInfo info(filePath);
+        fingerprint.path = info.absoluteFilePath();
+        fingerprint.mtime = info.lastModified().toMSecsSinceEpoch();
+        fingerprint.size = info.size();
+        fingerprint.quick = computeQuick(filePath);
+    }
+    if (withFull) {
+        fingerprint.full = computeFull(filePath);
+    }
+
+    if (!fingerprint.quick.isEmpty()) {
+        catalog.storeFingerprint(fingerprint);
+    }
+    return fingerprint;
+}
+
+QByteArray FileFingerprint::quick(const QString& filePath) {
+    return record(filePath, false).quick;
+}
+
+QByteArray FileFingerprint::full(const QString& filePath) {
+    return record(filePath, true).full;
+}
+
+QList<PhotoDatabase::Fingerprint> FileFingerprint::sameContent(const QString& filePath) {
+    QList<PhotoDatabase::Fingerprint> matches;
+    if (!PhotoDatabase::instance().isInitialized()) {
+        return matches;  // Nothing recorded to match against
+    }
+    PhotoDatabase::Fingerprint self = record(filePath, false);
+    if (self.quick.isEmpty()) {
+        return matches;
+    }
+    for (const PhotoDatabase::Fingerprint& other : PhotoDatabase::instance().fingerprintsMatching(self.quick)) {
+        if (other.path != self.path && other.size == self.size) {
+            matches << other;
+        }
+    }
+    return matches;
+}
+
+QList<QStringList> FileFingerprint::exactDuplicates(const QStringList& filePaths) {
+    // Size first: a stat, no reads
+    QHash<qint64, QStringList> bySize;
+    for (const QString& path : filePaths) {
+        QFileInfo info(path);
+        if (info.isFile()) bySize[info.size()] << path;
+    }
+
+    QList<QStringList> groups;
+    for (const QStringList& sameSize : std::as_const(bySize)) {
+        if (sameSize.size() < 2) continue;
+
+        QHash<QByteArray, QStringList> byQuick;
+        for (const QString& path : sameSize) {
+            QByteArray hash = quick(path);
+            if (!hash.isEmpty()) byQuick[hash] << path;
+        }
+        for (const QStringList& sameQuick : std::as_const(byQuick)) {
+            if (sameQuick.size() < 2) continue;
+
+            // Files can differ only in the middle (e.g. edited in place)
+            QHash<QByteArray, QStringList> byFull;
+            for (const QString& path : sameQuick) {
+                QByteArray hash = full(path);
+                if (!hash.isEmpty()) byFull[hash] << path;
+            }
+            for (const QStringList& identical : std::as_const(byFull)) {
+                if (identical.size() >= 2) groups << identical;
+            }
+        }
+    }
+    return groups;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "PhotoDatabase.h"
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Content fingerprints that follow a file when it is moved or renamed
+ *
+ * quick() hashes the size plus the first and last SAMPLE_BYTES of the
+ * file: identical files always match, and for camera files (unique
+ * headers, entropy-coded bodies) different ones practically never do.
+ * full() hashes every byte, for when a match must be exact.
+ *
+ * Both are computed once per file version and kept in the catalog, keyed
+ * by path + mtime + size like metadata. So a file that shows up under a
+ * new path can be matched with where its contents were seen before
+ * (sameContent()), and caches keyed by path can reuse what they stored
+ * there.
+ *
+ * Thread-safe. Without a catalog everything is recomputed on each call.
+ */
+class FileFingerprint {
+public:
+    static FileFingerprint& instance();
+
+    // Empty if the file can't be read
+    QByteArray quick(const QString& filePath);
+    QByteArray full(const QString& filePath);
+
+    // Earlier recorded locations of the same contents (not filePath itself);
+    // they may no longer exist
+    QList<PhotoDatabase::Fingerprint> sameContent(const QString& filePath);
+
+    // Byte-identical files among `filePaths`, two or more per group.
+    // Compares size, then quick(), and hashes whole files only for those
+    // still matching.
+    QList<QStringList> exactDuplicates(const QStringList& filePaths);
+
+    static QByteArray computeQuick(const QString& filePath);
+    static QByteArray computeFull(const QString& filePath);
+
+    static constexpr qint64 SAMPLE_BYTES = 64 * 1024;
+
+private:
+    FileFingerprint() = default;
+    FileFingerprint(const FileFingerprint&) = delete;
+    FileFingerprint& operator=(const FileFingerprint&) = delete;
+
+    // Catalog record for the file's current version, computing what's missing
+    PhotoDatabase::Fingerprint record(const QString& filePath, bool withFull);
+};
+
+} // namespace PhotoGuru
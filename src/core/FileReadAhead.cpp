@@ -0,0 +1,265 @@
+#include "FileReadAhead.h"
+#include "Trace.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStorageInfo>
+#include <algorithm>
+#include <climits>
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
+#include <fcntl.h>
+#endif
+
+namespace PhotoGuru {
+
+FileReadAhead& FileReadAhead::instance() {
+    static FileReadAhead instance;
+    return instance;
+}
+
+FileReadAhead::FileReadAhead() {
+    setMaxBytes(DEFAULT_MAX_BYTES);
+    m_pool.setMaxThreadCount(IO_THREADS);
+    Trace::watchThreadPool("readahead", &m_pool);
+}
+
+FileReadAhead::~FileReadAhead() {
+    cancel();
+    m_pool.waitForDone();
+    Trace::unwatchThreadPool(&m_pool);
+}
+
+QString FileReadAhead::cacheKey(const QString& path, const QFileInfo& info) {
+    return path + '|' + QString::number(info.lastModified().toMSecsSinceEpoch()) + '|' +
+           QString::number(info.size());
+}
+
+bool FileReadAhead::buffers(const QFileInfo& info) {
+    Mode mode;
+    qint64 maxFileBytes;
+    {
+        QMutexLocker locker(&m_mutex);
+        mode = m_mode;
+        maxFileBytes = m_maxFileBytes;
+    }
+    if (mode == Mode::Off || !info.isFile()) return false;
+    if (info.size() <= 0 || info.size() > maxFileBytes) return false;
+    return mode == Mode::Always || isNetworkPath(info.filePath());
+}
+
+QByteArray FileReadAhead::read(const QString& path) {
+    const QFileInfo info(path);
+    if (!buffers(info)) return QByteArray();
+    const QString key = cacheKey(path, info);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        // Being read ahead: the rest of it is closer than a new read
+        while (m_reading.contains(key)) {
+            m_readDone.wait(&m_mutex);
+        }
+        if (QByteArray* data = m_buffers.object(key)) {
+            TRACE_COUNT("readahead.hit", 1);
+            return *data;
+        }
+        TRACE_COUNT("readahead.miss", 1);
+        m_reading.insert(key);
+    }
+
+    const QByteArray data = readFile(path, info.size());
+
+    QMutexLocker locker(&m_mutex);
+    m_reading.remove(key);
+    insertBuffer(key, data);
+    m_readDone.wakeAll();
+    return data;
+}
+
+QByteArray FileReadAhead::buffered(const QString& path) {
+    const QFileInfo info(path);
+    const QString key = cacheKey(path, info);
+    QMutexLocker locker(&m_mutex);
+    if (QByteArray* data = m_buffers.object(key)) return *data;
+    return QByteArray();
+}
+
+QByteArray FileReadAhead::readFile(const QString& path, qint64 size) {
+    TRACE_SCOPE("io.read");
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        qWarning() << "[FileReadAhead] Cannot open" << path << file.errorString();
+        return QByteArray();
+    }
+    // Front to back, once: let the kernel (and the NFS/SMB client) read ahead too
+#if defined(Q_OS_LINUX)
+    posix_fadvise(file.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined(Q_OS_MACOS)
+    fcntl(file.handle(), F_RDAHEAD, 1);
+#endif
+
+    QByteArray data(size, Qt::Uninitialized);
+    qint64 done = 0;
+    while (done < size) {
+        const qint64 count = file.read(data.data() + done, std::min(BLOCK_SIZE, size - done));
+        if (count <= 0) break;
+        done += count;
+    }
+    if (done != size) {
+        // Truncated or replaced while being read: the decoder takes the path
+        qWarning() << "[FileReadAhead] Short read of" << path << done << "of" << size << "bytes";
+        return QByteArray();
+    }
+    return data;
+}
+
+void FileReadAhead::insertBuffer(const QString& key, const QByteArray& data) {
+    if (data.isNull()) return;
+    int cost = int(qBound<qint64>(1, data.size() / 1024, INT_MAX));
+    m_buffers.insert(key, new QByteArray(data), cost);
+}
+
+void FileReadAhead::setUpcoming(const QStringList& paths, std::function<bool(const QString& path)> wanted) {
+    QMutexLocker locker(&m_mutex);
+    if (m_mode == Mode::Off) return;
+    m_queue = paths.mid(0, m_depth);
+    m_wanted = std::move(wanted);
+    m_aheadBytes = 0;
+    while (m_readers < IO_THREADS && m_readers < m_queue.size()) {
+        ++m_readers;
+        m_pool.start([this]() { runReader(); });
+    }
+}
+
+void FileReadAhead::cancel() {
+    QMutexLocker locker(&m_mutex);
+    m_queue.clear();
+    m_wanted = nullptr;
+}
+
+void FileReadAhead::runReader() {
+    for (;;) {
+        QString path;
+        std::function<bool(const QString&)> wanted;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue.isEmpty()) {
+                --m_readers;
+                return;
+            }
+            path = m_queue.takeFirst();
+            wanted = m_wanted;
+        }
+        const QFileInfo info(path);
+        if (!buffers(info)) continue;
+        if (wanted && !wanted(path)) continue;
+        const QString key = cacheKey(path, info);
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_reading.contains(key) || m_buffers.contains(key)) continue;
+            // Past half the budget it would evict its own reads before they are used
+            if (m_aheadBytes + info.size() > qint64(m_buffers.maxCost()) * 1024 / 2) {
+                m_queue.clear();
+                continue;
+            }
+            m_aheadBytes += info.size();
+            m_reading.insert(key);
+        }
+
+        const QByteArray data = readFile(path, info.size());
+        TRACE_COUNT("readahead.bytes", data.size());
+
+        QMutexLocker locker(&m_mutex);
+        m_reading.remove(key);
+        insertBuffer(key, data);
+        m_readDone.wakeAll();
+    }
+}
+
+bool FileReadAhead::isBuffered(const QString& path) const {
+    const QFileInfo info(path);
+    QMutexLocker locker(&m_mutex);
+    return m_buffers.contains(cacheKey(path, info));
+}
+
+void FileReadAhead::setMode(Mode mode) {
+    QMutexLocker locker(&m_mutex);
+    m_mode = mode;
+    if (mode == Mode::Off) {
+        m_queue.clear();
+        m_buffers.clear();
+    }
+}
+
+FileReadAhead::Mode FileReadAhead::mode() const {
+    QMutexLocker locker(&m_mutex);
+    return m_mode;
+}
+
+void FileReadAhead::setDepth(int files) {
+    QMutexLocker locker(&m_mutex);
+    m_depth = qMax(0, files);
+}
+
+int FileReadAhead::depth() const {
+    QMutexLocker locker(&m_mutex);
+    return m_depth;
+}
+
+void FileReadAhead::setMaxBytes(qint64 bytes) {
+    QMutexLocker locker(&m_mutex);
+    m_buffers.setMaxCost(int(qBound<qint64>(1, bytes / 1024, INT_MAX)));
+}
+
+qint64 FileReadAhead::maxBytes() const {
+    QMutexLocker locker(&m_mutex);
+    return qint64(m_buffers.maxCost()) * 1024;
+}
+
+qint64 FileReadAhead::usedBytes() const {
+    QMutexLocker locker(&m_mutex);
+    return qint64(m_buffers.totalCost()) * 1024;
+}
+
+void FileReadAhead::setMaxFileBytes(qint64 bytes) {
+    QMutexLocker locker(&m_mutex);
+    m_maxFileBytes = bytes;
+}
+
+qint64 FileReadAhead::maxFileBytes() const {
+    QMutexLocker locker(&m_mutex);
+    return m_maxFileBytes;
+}
+
+void FileReadAhead::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_queue.clear();
+    m_buffers.clear();
+}
+
+bool FileReadAhead::isNetworkPath(const QString& path) {
+    const QString directory = QFileInfo(path).absolutePath();
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_networkDirs.constFind(directory);
+        if (it != m_networkDirs.constEnd()) return it.value();
+    }
+    const bool network = isNetworkFileSystem(QStorageInfo(directory).fileSystemType());
+
+    QMutexLocker locker(&m_mutex);
+    m_networkDirs.insert(directory, network);
+    return network;
+}
+
+bool FileReadAhead::isNetworkFileSystem(const QByteArray& type) {
+    // Linux mount types and macOS f_fstypename
+    static const QSet<QByteArray> types = {
+        "cifs", "smb3", "smbfs", "nfs", "nfs4", "afpfs", "webdav", "davfs",
+        "9p", "afs", "ncpfs", "fuse.sshfs", "fuse.rclone"
+    };
+    return types.contains(type.toLower());
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <functional>
+
+class QFileInfo;
+
+namespace PhotoGuru {
+
+/**
+ * @brief Whole-file reads in large blocks, ahead of the decoders
+ *
+ * On an SMB/NFS share every small read and seek a decoder makes is a
+ * round trip: QImageReader's buffered reads, LibRaw's seeks through the
+ * TIFF structure, libheif walking its boxes. read() hands the decoders
+ * the whole file instead (QBuffer, LibRaw::open_buffer,
+ * heif_context_read_from_memory), read sequentially in BLOCK_SIZE
+ * requests, and setUpcoming() reads the next depth() files of a list on
+ * IO_THREADS threads of its own while the current ones decode, so the
+ * link stays busy.
+ *
+ * Buffers are kept in an LRU bounded in bytes, keyed by path + mtime +
+ * size, so the preview and the full decode of a file share one read.
+ * Read-ahead stops once it has read half the budget since the last
+ * setUpcoming(), rather than evict what it read before it is used.
+ *
+ * Auto mode buffers only files on network file systems; local disks are
+ * faster read in place. Files larger than maxFileBytes() are never
+ * buffered. read() returns a null array for those, and the caller opens
+ * the path as before.
+ *
+ * Thread-safe.
+ *
+ * Exempt from the TaskScheduler by design: the readers spend nearly all
+ * their time blocked on the network, and on the scheduler's one-per-core
+ * workers every such wait would idle a core the decoders need. They run
+ * on a private pool of IO_THREADS instead, which does no CPU work beyond
+ * the `wanted` check and shows in the Performance dock as "readahead".
+ */
+class FileReadAhead {
+public:
+    enum class Mode {
+        Auto,    // Network file systems
+        Always,  // Every file
+        Off
+    };
+
+    static FileReadAhead& instance();
+
+    FileReadAhead();
+    ~FileReadAhead();  // Drops the queue, waits for reads running
+
+    FileReadAhead(const FileReadAhead&) = delete;
+    FileReadAhead& operator=(const FileReadAhead&) = delete;
+
+    // The whole file: buffered, being read ahead (waits), or read now.
+    // Null when the file isn't buffered in this mode or can't be read.
+    QByteArray read(const QString& path);
+    // The whole file if it is buffered already, else null; never reads.
+    // For callers that only need a small part of a file (RAW previews)
+    QByteArray buffered(const QString& path);
+
+    // Replaces the read-ahead queue with the first depth() of `paths`,
+    // most wanted first; `wanted`, if set, runs on an I/O thread before
+    // each read (e.g. to skip files whose thumbnail is stored)
+    void setUpcoming(const QStringList& paths, std::function<bool(const QString& path)> wanted = {});
+    void cancel();  // Reads already running finish
+
+    bool isBuffered(const QString& path) const;
+
+    void setMode(Mode mode);
+    Mode mode() const;
+    void setDepth(int files);
+    int depth() const;
+    void setMaxBytes(qint64 bytes);
+    qint64 maxBytes() const;
+    qint64 usedBytes() const;
+    void setMaxFileBytes(qint64 bytes);
+    qint64 maxFileBytes() const;
+
+    void clear();
+
+    // Mount of `path` is SMB, NFS, AFP, WebDAV or the like (cached per directory)
+    bool isNetworkPath(const QString& path);
+    static bool isNetworkFileSystem(const QByteArray& type);
+
+    static constexpr int DEFAULT_DEPTH = 8;
+    static constexpr int IO_THREADS = 4;
+    static constexpr qint64 BLOCK_SIZE = qint64(4) * 1024 * 1024;
+    static constexpr qint64 DEFAULT_MAX_BYTES = qint64(256) * 1024 * 1024;
+    static constexpr qint64 DEFAULT_MAX_FILE_BYTES = qint64(128) * 1024 * 1024;
+
+private:
+    static QString cacheKey(const QString& path, const QFileInfo& info);
+    static QByteArray readFile(const QString& path, qint64 size);
+    bool buffers(const QFileInfo& info);
+    void insertBuffer(const QString& key, const QByteArray& data);
+    void runReader();
+
+    mutable QMutex m_mutex;  // Guards the members below
+    QCache<QString, QByteArray> m_buffers;  // Cost in KB
+    QSet<QString> m_reading;                // Keys being read
+    QWaitCondition m_readDone;
+    QStringList m_queue;
+    std::function<bool(const QString&)> m_wanted;
+    qint64 m_aheadBytes = 0;  // Read ahead since the last setUpcoming()
+    int m_readers = 0;        // Reader tasks started on m_pool
+    Mode m_mode = Mode::Auto;
+    int m_depth = DEFAULT_DEPTH;
+    qint64 m_maxFileBytes = DEFAULT_MAX_FILE_BYTES;
+    QHash<QString, bool> m_networkDirs;
+
+    // I/O only, so not a TaskGroup (see the class comment).
+    // Last: waits for readers before the rest goes
+    QThreadPool m_pool;
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,326 @@
+#include "FilterCriteria.h"
+#include <QJsonArray>
+
+namespace PhotoGuru {
+
+bool FilterCriteria::matchesSearch(const PhotoMetadata& photo) const {
+    if (searchText.isEmpty()) return true;
+    
+    // Split search into multiple terms (space-separated)
+    QStringList searchTerms = searchText.split(' ', Qt::SkipEmptyParts);
+    if (searchTerms.isEmpty()) return true;
+    
+    // Helper to check if text contains ALL search terms (AND logic)
+    auto containsAllTerms = [&](const QString& text) -> bool {
+        if (text.isEmpty()) return false;
+        QString target = searchCaseSensitive ? text : text.toLower();
+        for (const QString& term : searchTerms) {
+            QString searchTerm = searchCaseSensitive ? term : term.toLower();
+            if (!target.contains(searchTerm)) {
+                return false;  // If any term is missing, return false
+            }
+        }
+        return true;  // All terms found
+    };
+    
+    // Search in various metadata fields (OR logic between fields)
+    // LLM-generated content (highest priority)
+    if (containsAllTerms(photo.llm_title)) return true;
+    if (containsAllTerms(photo.llm_description)) return true;
+    if (containsAllTerms(photo.llm_category)) return true;
+    if (containsAllTerms(photo.llm_scene)) return true;
+    if (containsAllTerms(photo.llm_mood)) return true;
+    
+    // Keywords (check each keyword)
+    for (const QString& kw : photo.llm_keywords) {
+        if (containsAllTerms(kw)) return true;
+    }
+    
+    // Location data
+    if (containsAllTerms(photo.location_name)) return true;
+    
+    // Camera info
+    QString cameraInfo = photo.camera_make + " " + photo.camera_model;
+    if (containsAllTerms(cameraInfo)) return true;
+    
+    // Filename (without path)
+    QString filename = photo.filename;
+    if (filename.contains('/')) {
+        filename = filename.mid(filename.lastIndexOf('/') + 1);
+    }
+    if (containsAllTerms(filename)) return true;
+    
+    return false;
+}
+
+bool FilterCriteria::matchesLocation(double lat, double lon) const {
+    bool hasGPS = lat != 0.0 && lon != 0.0;
+    if (onlyWithGPS && !hasGPS) return false;
+    if (!geoBox && !geoRadius) return true;
+    if (!hasGPS) return false;
+    if (geoBox && !geoBox->contains(lat, lon)) return false;
+    if (geoRadius && !geoRadius->contains(lat, lon)) return false;
+    return true;
+}
+
+bool FilterCriteria::matches(const PhotoMetadata& photo) const {
+    // Text search first
+    if (!matchesSearch(photo)) return false;
+    
+    // Quality filters
+    if (photo.technical.overall_quality < minQuality) return false;
+    if (photo.technical.sharpness_score < minSharpness) return false;
+    if (photo.technical.aesthetic_score < minAesthetic) return false;
+    
+    // Rating filter
+    if (photo.rating < minRating || photo.rating > maxRating) return false;
+    
+    // Content filters
+    if (onlyWithFaces && photo.face_count == 0) return false;
+    if (onlyBestInBurst && !photo.technical.is_best_in_burst) return false;
+    if (excludeDuplicates && !photo.technical.duplicate_group.isEmpty()) return false;
+    if (excludeBlurry && photo.technical.blur_detected) return false;
+    
+    // GPS filter
+    if (!matchesLocation(photo.gps_lat, photo.gps_lon)) return false;
+    
+    // Camera filter
+    if (!cameras.isEmpty()) {
+        QString fullCamera = photo.camera_make + " " + photo.camera_model;
+        bool found = false;
+        for (const QString& cam : cameras) {
+            if (fullCamera.contains(cam, Qt::CaseInsensitive)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) return false;
+    }
+    
+    // ISO filter
+    if (photo.iso > 0 && (photo.iso < minISO || photo.iso > maxISO)) return false;
+    
+    // Aperture filter
+    if (photo.aperture > 0.0 && (photo.aperture < minAperture || photo.aperture > maxAperture)) return false;
+    
+    // Focal length filter
+    if (photo.focal_length > 0.0 && (photo.focal_length < minFocalLength || photo.focal_length > maxFocalLength)) return false;
+    
+    // Keywords filter
+    if (!keywords.isEmpty()) {
+        bool found = false;
+        for (const QString& filterKw : keywords) {
+            for (const QString& photoKw : photo.llm_keywords) {
+                if (photoKw.contains(filterKw, Qt::CaseInsensitive)) {
+                    found = true;
+                    break;
+                }
+            }
+            if (found) break;
+        }
+        if (!found) return false;
+    }
+    
+    // Category filter
+    if (!categories.isEmpty() && !categories.contains(photo.llm_category)) return false;
+    if (!scenes.isEmpty() && !scenes.contains(photo.llm_scene)) return false;
+    
+    // Date range
+    if (startDate.isValid() && photo.datetime_original < startDate) return false;
+    if (endDate.isValid() && photo.datetime_original > endDate) return false;
+    
+    return true;
+}
+
+namespace {
+
+// Any-of substring filters (cameras, keywords): narrower when each of our
+// values contains one of theirs, since a photo matching ours then matches theirs
+bool anySubstringNarrower(const QStringList& narrow, const QStringList& wide) {
+    if (wide.isEmpty()) return true;
+    if (narrow.isEmpty()) return false;
+    for (const QString& value : narrow) {
+        bool covered = false;
+        for (const QString& other : wide) {
+            if (value.contains(other, Qt::CaseInsensitive)) {
+                covered = true;
+                break;
+            }
+        }
+        if (!covered) return false;
+    }
+    return true;
+}
+
+// Exact-membership filters (categories, scenes)
+bool subsetNarrower(const QStringList& narrow, const QStringList& wide) {
+    if (wide.isEmpty()) return true;
+    if (narrow.isEmpty()) return false;
+    for (const QString& value : narrow) {
+        if (!wide.contains(value)) return false;
+    }
+    return true;
+}
+
+// Our region has to fit inside theirs. A box inside a circle isn't
+// checked (not provable cheaply), so that case counts as not narrower.
+bool locationNarrower(const FilterCriteria& narrow, const FilterCriteria& wide) {
+    const bool regioned = narrow.geoBox || narrow.geoRadius;
+    if (wide.onlyWithGPS && !narrow.onlyWithGPS && !regioned) return false;
+
+    if (wide.geoBox) {
+        bool inside = (narrow.geoBox && wide.geoBox->contains(*narrow.geoBox)) ||
+                      (narrow.geoRadius && wide.geoBox->contains(narrow.geoRadius->boundingBox()));
+        if (!inside) return false;
+    }
+    if (wide.geoRadius) {
+        if (!narrow.geoRadius || !wide.geoRadius->contains(*narrow.geoRadius)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool FilterCriteria::isNarrowerThan(const FilterCriteria& wider) const {
+    if (minQuality < wider.minQuality) return false;
+    if (minSharpness < wider.minSharpness) return false;
+    if (minAesthetic < wider.minAesthetic) return false;
+    
+    if (minRating < wider.minRating || maxRating > wider.maxRating) return false;
+    
+    if (wider.onlyWithFaces && !onlyWithFaces) return false;
+    if (wider.onlyBestInBurst && !onlyBestInBurst) return false;
+    if (wider.excludeDuplicates && !excludeDuplicates) return false;
+    if (wider.excludeBlurry && !excludeBlurry) return false;
+    if (!locationNarrower(*this, wider)) return false;
+    
+    if (minISO < wider.minISO || maxISO > wider.maxISO) return false;
+    if (minAperture < wider.minAperture || maxAperture > wider.maxAperture) return false;
+    if (minFocalLength < wider.minFocalLength || maxFocalLength > wider.maxFocalLength) return false;
+    
+    if (!anySubstringNarrower(cameras, wider.cameras)) return false;
+    if (!anySubstringNarrower(keywords, wider.keywords)) return false;
+    if (!subsetNarrower(categories, wider.categories)) return false;
+    if (!subsetNarrower(scenes, wider.scenes)) return false;
+    
+    if (wider.startDate.isValid() && (!startDate.isValid() || startDate < wider.startDate)) return false;
+    if (wider.endDate.isValid() && (!endDate.isValid() || endDate > wider.endDate)) return false;
+    
+    // Text: AND of terms within one field. Each of their terms must be a
+    // substring of one of ours (a field holding ours then holds theirs).
+    QStringList wideTerms = wider.searchText.split(' ', Qt::SkipEmptyParts);
+    if (!wideTerms.isEmpty()) {
+        if (wider.searchCaseSensitive && !searchCaseSensitive) return false;
+        Qt::CaseSensitivity cs = wider.searchCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+        
+        QStringList terms = searchText.split(' ', Qt::SkipEmptyParts);
+        for (const QString& wideTerm : wideTerms) {
+            bool covered = false;
+            for (const QString& term : terms) {
+                if (term.contains(wideTerm, cs)) {
+                    covered = true;
+                    break;
+                }
+            }
+            if (!covered) return false;
+        }
+    }
+    
+    return true;
+}
+
+QJsonObject FilterCriteria::toJson() const {
+    QJsonObject json{
+        {"minQuality", minQuality},
+        {"minSharpness", minSharpness},
+        {"minAesthetic", minAesthetic},
+        {"onlyWithFaces", onlyWithFaces},
+        {"onlyBestInBurst", onlyBestInBurst},
+        {"excludeDuplicates", excludeDuplicates},
+        {"excludeBlurry", excludeBlurry},
+        {"minRating", minRating},
+        {"maxRating", maxRating},
+        {"cameras", QJsonArray::fromStringList(cameras)},
+        {"lenses", QJsonArray::fromStringList(lenses)},
+        {"minISO", minISO},
+        {"maxISO", maxISO},
+        {"minAperture", minAperture},
+        {"maxAperture", maxAperture},
+        {"minFocalLength", minFocalLength},
+        {"maxFocalLength", maxFocalLength},
+        {"minShutterSpeed", minShutterSpeed},
+        {"maxShutterSpeed", maxShutterSpeed},
+        {"categories", QJsonArray::fromStringList(categories)},
+        {"scenes", QJsonArray::fromStringList(scenes)},
+        {"keywords", QJsonArray::fromStringList(keywords)},
+        {"onlyWithGPS", onlyWithGPS},
+        {"searchText", searchText},
+        {"searchCaseSensitive", searchCaseSensitive},
+    };
+    if (startDate.isValid()) json["startDate"] = startDate.toString(Qt::ISODateWithMs);
+    if (endDate.isValid()) json["endDate"] = endDate.toString(Qt::ISODateWithMs);
+    if (geoBox) {
+        json["geoBox"] = QJsonObject{
+            {"south", geoBox->south}, {"west", geoBox->west}, {"north", geoBox->north}, {"east", geoBox->east}};
+    }
+    if (geoRadius) {
+        json["geoRadius"] = QJsonObject{
+            {"lat", geoRadius->lat}, {"lon", geoRadius->lon}, {"radiusMeters", geoRadius->radiusMeters}};
+    }
+    return json;
+}
+
+FilterCriteria FilterCriteria::fromJson(const QJsonObject& json) {
+    FilterCriteria criteria;
+    auto strings = [&json](const char* key) {
+        QStringList values;
+        for (const QJsonValue& value : json.value(key).toArray()) values << value.toString();
+        return values;
+    };
+    
+    criteria.minQuality = json.value("minQuality").toDouble(criteria.minQuality);
+    criteria.minSharpness = json.value("minSharpness").toDouble(criteria.minSharpness);
+    criteria.minAesthetic = json.value("minAesthetic").toDouble(criteria.minAesthetic);
+    criteria.onlyWithFaces = json.value("onlyWithFaces").toBool(criteria.onlyWithFaces);
+    criteria.onlyBestInBurst = json.value("onlyBestInBurst").toBool(criteria.onlyBestInBurst);
+    criteria.excludeDuplicates = json.value("excludeDuplicates").toBool(criteria.excludeDuplicates);
+    criteria.excludeBlurry = json.value("excludeBlurry").toBool(criteria.excludeBlurry);
+    criteria.minRating = json.value("minRating").toInt(criteria.minRating);
+    criteria.maxRating = json.value("maxRating").toInt(criteria.maxRating);
+    criteria.cameras = strings("cameras");
+    criteria.lenses = strings("lenses");
+    criteria.minISO = json.value("minISO").toInt(criteria.minISO);
+    criteria.maxISO = json.value("maxISO").toInt(criteria.maxISO);
+    criteria.minAperture = json.value("minAperture").toDouble(criteria.minAperture);
+    criteria.maxAperture = json.value("maxAperture").toDouble(criteria.maxAperture);
+    criteria.minFocalLength = json.value("minFocalLength").toDouble(criteria.minFocalLength);
+    criteria.maxFocalLength = json.value("maxFocalLength").toDouble(criteria.maxFocalLength);
+    criteria.minShutterSpeed = json.value("minShutterSpeed").toDouble(criteria.minShutterSpeed);
+    criteria.maxShutterSpeed = json.value("maxShutterSpeed").toDouble(criteria.maxShutterSpeed);
+    criteria.categories = strings("categories");
+    criteria.scenes = strings("scenes");
+    criteria.keywords = strings("keywords");
+    criteria.onlyWithGPS = json.value("onlyWithGPS").toBool(criteria.onlyWithGPS);
+    criteria.searchText = json.value("searchText").toString();
+    criteria.searchCaseSensitive = json.value("searchCaseSensitive").toBool(criteria.searchCaseSensitive);
+    
+    if (json.contains("startDate")) {
+        criteria.startDate = QDateTime::fromString(json.value("startDate").toString(), Qt::ISODateWithMs);
+    }
+    if (json.contains("endDate")) {
+        criteria.endDate = QDateTime::fromString(json.value("endDate").toString(), Qt::ISODateWithMs);
+    }
+    if (json.contains("geoBox")) {
+        const QJsonObject box = json.value("geoBox").toObject();
+        criteria.geoBox = GeoBox{box.value("south").toDouble(), box.value("west").toDouble(),
+                                 box.value("north").toDouble(), box.value("east").toDouble()};
+    }
+    if (json.contains("geoRadius")) {
+        const QJsonObject circle = json.value("geoRadius").toObject();
+        criteria.geoRadius = GeoCircle{circle.value("lat").toDouble(), circle.value("lon").toDouble(),
+                                       circle.value("radiusMeters").toDouble()};
+    }
+    return criteria;
+}
+
+} // namespace PhotoGuru
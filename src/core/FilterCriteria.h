@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QJsonObject>
+#include <optional>
+#include "PhotoMetadata.h"
+#include "GeoRegion.h"
+
+namespace PhotoGuru {
+
+struct FilterCriteria {
+    // Quality filters
+    double minQuality = 0.0;
+    double minSharpness = 0.0;
+    double minAesthetic = 0.0;
+    
+    // Content filters
+    bool onlyWithFaces = false;
+    bool onlyBestInBurst = false;
+    bool excludeDuplicates = false;
+    bool excludeBlurry = false;
+    
+    // Rating filter
+    int minRating = 0;  // 0-5 stars
+    int maxRating = 5;
+    
+    // Camera/Lens filters
+    QStringList cameras;  // Camera make/model
+    QStringList lenses;   // Lens model
+    
+    // Technical filters
+    int minISO = 0;
+    int maxISO = 102400;
+    double minAperture = 0.0;  // f-stop
+    double maxAperture = 32.0;
+    double minFocalLength = 0.0;
+    double maxFocalLength = 1000.0;
+    double minShutterSpeed = 0.0;
+    double maxShutterSpeed = 10000.0;
+    
+    // Category filters
+    QStringList categories;
+    QStringList scenes;
+    QStringList keywords;  // Filter by keywords/tags
+    
+    // Date range
+    QDateTime startDate;
+    QDateTime endDate;
+    
+    // Location. A region only matches geotagged photos; with both set,
+    // a photo has to be in both.
+    bool onlyWithGPS = false;
+    std::optional<GeoBox> geoBox;
+    std::optional<GeoCircle> geoRadius;
+    
+    // Text search (searches in title, description, keywords, location, camera)
+    QString searchText;
+    bool searchCaseSensitive = false;
+    
+    bool matches(const PhotoMetadata& photo) const;
+    bool matchesSearch(const PhotoMetadata& photo) const;
+    bool matchesLocation(double lat, double lon) const;
+    
+    // True if every photo matching these criteria also matches `wider`, so
+    // a refined filter only has to re-check the previous result. Conservative:
+    // false just means "not provably narrower".
+    bool isNarrowerThan(const FilterCriteria& wider) const;
+    
+    // As saved with a smart album; fields missing from `json` keep their defaults
+    QJsonObject toJson() const;
+    static FilterCriteria fromJson(const QJsonObject& json);
+};
+
+} // namespace PhotoGuru
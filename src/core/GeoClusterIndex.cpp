@@ -0,0 +1,273 @@
+#include "GeoClusterIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace PhotoGuru {
+
+namespace {
+constexpr quint32 KEY_CELLS = 1u << GeoClusterIndex::KEY_LEVEL;
+constexpr double PI = 3.14159265358979323846;
+constexpr int SCAN_RANGE = 16;                 // Test points one by one below this many
+constexpr double FIRST_RADIUS_METERS = 1000.0;
+constexpr double HALF_WORLD_METERS = 2.0038e7; // Beyond this a circle holds every point
+}
+
+quint32 GeoClusterIndex::mercatorX(double lon) {
+    double x = (std::clamp(lon, -180.0, 180.0) + 180.0) / 360.0;
+    return std::min(quint32(x * KEY_CELLS), KEY_CELLS - 1);
+}
+
+quint32 GeoClusterIndex::mercatorY(double lat) {
+    // North is y = 0, as in map tiles
+    double s = std::sin(std::clamp(lat, -MAX_LATITUDE, MAX_LATITUDE) * PI / 180.0);
+    double y = 0.5 - std::log((1.0 + s) / (1.0 - s)) / (4.0 * PI);
+    return std::min(quint32(std::clamp(y, 0.0, 1.0) * KEY_CELLS), KEY_CELLS - 1);
+}
+
+quint64 GeoClusterIndex::interleave(quint32 x, quint32 y) {
+    quint64 key = 0;
+    for (int bit = 0; bit < KEY_LEVEL; ++bit) {
+        key |= quint64((x >> bit) & 1u) << (2 * bit);
+        key |= quint64((y >> bit) & 1u) << (2 * bit + 1);
+    }
+    return key;
+}
+
+void GeoClusterIndex::build(const std::vector<Point>& points) {
+    clear();
+
+    std::vector<std::pair<quint64, int>> keyed;
+    keyed.reserve(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        const Point& p = points[i];
+        bool valid = std::abs(p.lat) <= 90.0 && std::abs(p.lon) <= 180.0 &&
+                     !(p.lat == 0.0 && p.lon == 0.0);
+        if (valid) keyed.emplace_back(interleave(mercatorX(p.lon), mercatorY(p.lat)), int(i));
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    m_keys.reserve(keyed.size());
+    m_order.reserve(keyed.size());
+    m_points.reserve(keyed.size());
+    for (const auto& [key, index] : keyed) {
+        m_keys.push_back(key);
+        m_order.push_back(index);
+        m_points.push_back(points[size_t(index)]);
+    }
+    setVisible({});
+}
+
+void GeoClusterIndex::clear() {
+    m_keys.clear();
+    m_order.clear();
+    m_points.clear();
+    m_visible.clear();
+    m_visibleBefore.assign(1, 0);
+    m_latBefore.assign(1, 0.0);
+    m_lonBefore.assign(1, 0.0);
+    m_nextVisible.assign(1, 0);
+}
+
+void GeoClusterIndex::setVisible(const std::vector<bool>& visible) {
+    const size_t n = m_order.size();
+    m_visible.resize(n);
+    m_visibleBefore.assign(n + 1, 0);
+    m_latBefore.assign(n + 1, 0.0);
+    m_lonBefore.assign(n + 1, 0.0);
+    m_nextVisible.assign(n + 1, int(n));
+
+    for (size_t i = 0; i < n; ++i) {
+        const size_t input = size_t(m_order[i]);
+        m_visible[i] = input >= visible.size() || visible[input];
+        const bool shown = m_visible[i];
+        m_visibleBefore[i + 1] = m_visibleBefore[i] + (shown ? 1 : 0);
+        m_latBefore[i + 1] = m_latBefore[i] + (shown ? m_points[i].lat : 0.0);
+        m_lonBefore[i + 1] = m_lonBefore[i] + (shown ? m_points[i].lon : 0.0);
+    }
+    for (size_t i = n; i-- > 0;) {
+        m_nextVisible[i] = m_visible[i] ? int(i) : m_nextVisible[i + 1];
+    }
+}
+
+int GeoClusterIndex::lowerBound(quint64 key) const {
+    return int(std::lower_bound(m_keys.begin(), m_keys.end(), key) - m_keys.begin());
+}
+
+std::vector<GeoClusterIndex::Cluster> GeoClusterIndex::query(double south, double west,
+                                                             double north, double east,
+                                                             int zoom) const {
+    std::vector<Cluster> clusters;
+    if (visibleCount() == 0 || south > north) return clusters;
+
+    // Leaflet reports wrapped longitudes past +-180 when panned; such a view covers both edges
+    if (east - west >= 360.0 || west < -180.0 || east > 180.0) {
+        west = -180.0;
+        east = 180.0;
+    }
+    if (west > east) return clusters;
+
+    const int target = std::clamp(zoom, 0, MAX_ZOOM) + CELL_SHIFT;
+    collect(0, 0, target, mercatorX(west), mercatorY(north), mercatorX(east), mercatorY(south), clusters);
+    return clusters;
+}
+
+void GeoClusterIndex::collect(quint64 cellXY, int level, int targetLevel,
+                              quint32 x0, quint32 y0, quint32 x1, quint32 y1,
+                              std::vector<Cluster>& out) const {
+    // cellXY packs the cell's column and row at this level
+    const quint32 cx = quint32(cellXY >> 32);
+    const quint32 cy = quint32(cellXY & 0xffffffffu);
+    const int span = KEY_LEVEL - level;
+    const quint64 cellX0 = quint64(cx) << span;
+    const quint64 cellY0 = quint64(cy) << span;
+    const quint64 cellSize = quint64(1) << span;
+    if (cellX0 > x1 || cellX0 + cellSize <= x0 || cellY0 > y1 || cellY0 + cellSize <= y0) return;
+
+    const quint64 prefix = interleave(cx, cy);
+    const int begin = lowerBound(prefix << (2 * span));
+    const int end = lowerBound((prefix + 1) << (2 * span));
+    const int count = m_visibleBefore[size_t(end)] - m_visibleBefore[size_t(begin)];
+    if (count == 0) return;
+
+    // A lone photo is its own cluster at any finer level
+    if (level == targetLevel || count == 1) {
+        Cluster cluster;
+        cluster.count = count;
+        cluster.lat = (m_latBefore[size_t(end)] - m_latBefore[size_t(begin)]) / count;
+        cluster.lon = (m_lonBefore[size_t(end)] - m_lonBefore[size_t(begin)]) / count;
+        cluster.first = m_order[size_t(m_nextVisible[size_t(begin)])];
+        cluster.cell = prefix;
+        cluster.level = level;
+        cluster.begin = begin;
+        cluster.end = end;
+        out.push_back(cluster);
+        return;
+    }
+
+    for (quint32 dy = 0; dy < 2; ++dy) {
+        for (quint32 dx = 0; dx < 2; ++dx) {
+            quint64 child = (quint64(2 * cx + dx) << 32) | quint64(2 * cy + dy);
+            collect(child, level + 1, targetLevel, x0, y0, x1, y1, out);
+        }
+    }
+}
+
+std::vector<int> GeoClusterIndex::members(const Cluster& cluster, int limit) const {
+    std::vector<int> result;
+    const int end = std::min(cluster.end, size());
+    for (int i = std::max(cluster.begin, 0); i < end && int(result.size()) < limit; ++i) {
+        if (m_visible[size_t(i)]) result.push_back(m_order[size_t(i)]);
+    }
+    return result;
+}
+
+bool GeoClusterIndex::bounds(double* south, double* west, double* north, double* east) const {
+    bool any = false;
+    for (size_t i = 0; i < m_points.size(); ++i) {
+        if (!m_visible[i]) continue;
+        const Point& p = m_points[i];
+        if (!any) {
+            *south = *north = p.lat;
+            *west = *east = p.lon;
+            any = true;
+            continue;
+        }
+        *south = std::min(*south, p.lat);
+        *north = std::max(*north, p.lat);
+        *west = std::min(*west, p.lon);
+        *east = std::max(*east, p.lon);
+    }
+    return any;
+}
+
+std::vector<int> GeoClusterIndex::inBox(const GeoBox& box) const {
+    std::vector<int> result = positionsInBox(box);
+    for (int& position : result) position = m_order[size_t(position)];
+    return result;
+}
+
+std::vector<int> GeoClusterIndex::withinRadius(const GeoCircle& circle) const {
+    std::vector<int> result;
+    if (!circle.isValid()) return result;
+    for (int position : positionsInBox(circle.boundingBox())) {
+        const Point& p = m_points[size_t(position)];
+        if (circle.contains(p.lat, p.lon)) result.push_back(m_order[size_t(position)]);
+    }
+    return result;
+}
+
+int GeoClusterIndex::nearest(double lat, double lon, double maxMeters) const {
+    if (visibleCount() == 0 || maxMeters <= 0.0 || std::abs(lat) > 90.0) return -1;
+    lon = std::remainder(lon, 360.0);  // Clicks on a wrapped world copy
+
+    // Growing circles: the closest point in the first non-empty one is the closest overall
+    const double limit = std::min(maxMeters, HALF_WORLD_METERS);
+    for (double radius = std::min(FIRST_RADIUS_METERS, limit);; radius = std::min(radius * 8.0, limit)) {
+        GeoCircle circle{lat, lon, radius};
+        int best = -1;
+        double bestMeters = radius;
+        for (int position : positionsInBox(circle.boundingBox())) {
+            const Point& p = m_points[size_t(position)];
+            double meters = geoDistanceMeters(lat, lon, p.lat, p.lon);
+            if (meters <= bestMeters) {
+                bestMeters = meters;
+                best = m_order[size_t(position)];
+            }
+        }
+        if (best >= 0 || radius >= limit) return best;
+    }
+}
+
+std::vector<int> GeoClusterIndex::positionsInBox(const GeoBox& box) const {
+    std::vector<int> out;
+    if (visibleCount() == 0 || !box.isValid()) return out;
+
+    const GeoBox b = box.normalized();
+    const quint32 y0 = mercatorY(b.north);
+    const quint32 y1 = mercatorY(b.south);
+    if (b.west <= b.east) {
+        gather(0, 0, mercatorX(b.west), y0, mercatorX(b.east), y1, b, out);
+    } else {
+        // Across the antimeridian: one walk per side, each with its own box so no point is found twice
+        gather(0, 0, mercatorX(b.west), y0, KEY_CELLS - 1, y1, GeoBox{b.south, b.west, b.north, 180.0}, out);
+        gather(0, 0, 0, y0, mercatorX(b.east), y1, GeoBox{b.south, -180.0, b.north, b.east}, out);
+    }
+    return out;
+}
+
+void GeoClusterIndex::gather(quint64 cellXY, int level, quint32 x0, quint32 y0, quint32 x1, quint32 y1,
+                             const GeoBox& box, std::vector<int>& out) const {
+    const quint32 cx = quint32(cellXY >> 32);
+    const quint32 cy = quint32(cellXY & 0xffffffffu);
+    const int span = KEY_LEVEL - level;
+    const quint64 cellX0 = quint64(cx) << span;
+    const quint64 cellY0 = quint64(cy) << span;
+    const quint64 cellSize = quint64(1) << span;
+    if (cellX0 > x1 || cellX0 + cellSize <= x0 || cellY0 > y1 || cellY0 + cellSize <= y0) return;
+
+    const quint64 prefix = interleave(cx, cy);
+    const int begin = lowerBound(prefix << (2 * span));
+    const int end = lowerBound((prefix + 1) << (2 * span));
+    if (m_visibleBefore[size_t(end)] == m_visibleBefore[size_t(begin)]) return;
+
+    // Keys are quantized, so even a cell inside the rectangle gets the exact test
+    const bool inside = cellX0 >= x0 && cellX0 + cellSize - 1 <= x1 &&
+                        cellY0 >= y0 && cellY0 + cellSize - 1 <= y1;
+    if (inside || level == KEY_LEVEL || end - begin <= SCAN_RANGE) {
+        for (int i = begin; i < end; ++i) {
+            const Point& p = m_points[size_t(i)];
+            if (m_visible[size_t(i)] && box.contains(p.lat, p.lon)) out.push_back(i);
+        }
+        return;
+    }
+
+    for (quint32 dy = 0; dy < 2; ++dy) {
+        for (quint32 dx = 0; dx < 2; ++dx) {
+            quint64 child = (quint64(2 * cx + dx) << 32) | quint64(2 * cy + dy);
+            gather(child, level + 1, x0, y0, x1, y1, box, out);
+        }
+    }
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <QtGlobal>
+#include <vector>
+#include "GeoRegion.h"
+
+namespace PhotoGuru {
+
+/**
+ * @brief Viewport clustering of geotagged photos, for any zoom level
+ *
+ * Points are projected to Web Mercator and keyed by a quadtree (Morton)
+ * code at KEY_LEVEL, then sorted once. Every quadtree cell, at every
+ * level, is then a contiguous range of the sorted keys, so one sorted
+ * array serves all zoom levels. Prefix sums over the visible points give
+ * any cell's count and centroid in O(1).
+ *
+ * query() walks the quadtree down to the cell size for the zoom. It
+ * prunes cells that are empty or outside the viewport, so the cost
+ * follows the clusters returned, not the photos indexed. setVisible()
+ * re-masks the points in O(N) without sorting again; a filter change
+ * never rebuilds the index.
+ *
+ * inBox(), withinRadius() and nearest() use the same tree: cells outside
+ * the region are skipped whole, and only points in the cells along its
+ * edge are tested one by one.
+ *
+ * Not thread-safe; owned by one view.
+ */
+class GeoClusterIndex {
+public:
+    struct Point {
+        double lat = 0.0;
+        double lon = 0.0;
+    };
+
+    struct Cluster {
+        double lat = 0.0;        // Centroid of the visible members
+        double lon = 0.0;
+        int count = 0;
+        int first = -1;          // A visible member (input index)
+        quint64 cell = 0;        // Quadtree prefix at `level`; stable across queries
+        int level = 0;
+        int begin = 0;           // Members, as a range of the sorted order
+        int end = 0;
+    };
+
+    // Points outside valid coordinates (and the 0,0 "no GPS" value) are not indexed
+    void build(const std::vector<Point>& points);
+    void clear();
+
+    // One flag per input point; points not given stay visible
+    void setVisible(const std::vector<bool>& visible);
+
+    int size() const { return int(m_order.size()); }
+    int visibleCount() const { return m_visibleBefore.empty() ? 0 : m_visibleBefore.back(); }
+
+    // Clusters of visible points intersecting the viewport, at the cell size for `zoom`
+    std::vector<Cluster> query(double south, double west, double north, double east, int zoom) const;
+
+    // Visible members of a cluster (input indices), at most `limit`
+    std::vector<int> members(const Cluster& cluster, int limit) const;
+
+    // Box around the visible points; false if there are none
+    bool bounds(double* south, double* west, double* north, double* east) const;
+
+    // Visible points (input indices) inside the region, in no particular order
+    std::vector<int> inBox(const GeoBox& box) const;
+    std::vector<int> withinRadius(const GeoCircle& circle) const;
+
+    // Visible point closest to (lat, lon) and at most maxMeters away, or -1
+    int nearest(double lat, double lon, double maxMeters) const;
+
+    static constexpr int KEY_LEVEL = 24;        // ~2 m cells at the equator
+    static constexpr int CELL_SHIFT = 2;        // 64 px cells on 256 px tiles
+    static constexpr int MAX_ZOOM = KEY_LEVEL - CELL_SHIFT;
+    static constexpr double MAX_LATITUDE = 85.05112878;  // Web Mercator limit
+
+private:
+    static quint32 mercatorX(double lon);
+    static quint32 mercatorY(double lat);
+    static quint64 interleave(quint32 x, quint32 y);
+
+    int lowerBound(quint64 key) const;
+    void collect(quint64 cellXY, int level, int targetLevel,
+                 quint32 x0, quint32 y0, quint32 x1, quint32 y1,
+                 std::vector<Cluster>& out) const;
+    // Sorted positions of visible points in `box`, within the key-space rectangle
+    void gather(quint64 cellXY, int level, quint32 x0, quint32 y0, quint32 x1, quint32 y1,
+                const GeoBox& box, std::vector<int>& out) const;
+    std::vector<int> positionsInBox(const GeoBox& box) const;
+
+    std::vector<quint64> m_keys;         // Sorted
+    std::vector<int> m_order;            // Input index of each sorted key
+    std::vector<Point> m_points;         // In sorted order
+    std::vector<bool> m_visible;         // In sorted order
+
+    // Prefix sums over sorted order, visible points only; size() + 1 entries
+    std::vector<int> m_visibleBefore;
+    std::vector<double> m_latBefore;
+    std::vector<double> m_lonBefore;
+    std::vector<int> m_nextVisible;      // First visible position >= i, or size()
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,93 @@
+#include "GeoRegion.h"
+#include <algorithm>
+#include <cmath>
+
+namespace PhotoGuru {
+
+namespace {
+constexpr double PI = 3.14159265358979323846;
+constexpr double EARTH_RADIUS_METERS = 6371008.8;
+constexpr double RADIANS = PI / 180.0;
+
+// Degrees of longitude from west to east, going east
+double lonSpan(double west, double east) {
+    return west <= east ? east - west : east + 360.0 - west;
+}
+}
+
+double geoDistanceMeters(double lat1, double lon1, double lat2, double lon2) {
+    double dLat = (lat2 - lat1) * RADIANS;
+    double dLon = (lon2 - lon1) * RADIANS;
+    double a = std::sin(dLat / 2) * std::sin(dLat / 2) +
+               std::cos(lat1 * RADIANS) * std::cos(lat2 * RADIANS) *
+               std::sin(dLon / 2) * std::sin(dLon / 2);
+    return 2.0 * EARTH_RADIUS_METERS * std::asin(std::sqrt(std::min(a, 1.0)));
+}
+
+bool GeoBox::isValid() const {
+    return south <= north && south >= -90.0 && north <= 90.0 &&
+           std::isfinite(west) && std::isfinite(east);
+}
+
+bool GeoBox::contains(double lat, double lon) const {
+    if (lat < south || lat > north) return false;
+    if (west <= east) return lon >= west && lon <= east;
+    return lon >= west || lon <= east;
+}
+
+bool GeoBox::contains(const GeoBox& other) const {
+    if (other.south < south || other.north > north) return false;
+
+    const double span = lonSpan(west, east);
+    if (span >= 360.0) return true;
+    double offset = std::fmod(other.west - west, 360.0);
+    if (offset < 0.0) offset += 360.0;
+    return offset + lonSpan(other.west, other.east) <= span;
+}
+
+GeoBox GeoBox::normalized() const {
+    GeoBox box = *this;
+    if (east - west >= 360.0) {
+        box.west = -180.0;
+        box.east = 180.0;
+        return box;
+    }
+    box.west = std::remainder(west, 360.0);
+    box.east = std::remainder(east, 360.0);
+    return box;
+}
+
+bool GeoCircle::isValid() const {
+    return radiusMeters > 0.0 && std::abs(lat) <= 90.0 && std::abs(lon) <= 180.0;
+}
+
+bool GeoCircle::contains(double pointLat, double pointLon) const {
+    return isValid() && geoDistanceMeters(lat, lon, pointLat, pointLon) <= radiusMeters;
+}
+
+bool GeoCircle::contains(const GeoCircle& other) const {
+    return geoDistanceMeters(lat, lon, other.lat, other.lon) + other.radiusMeters <= radiusMeters;
+}
+
+GeoBox GeoCircle::boundingBox() const {
+    const double angle = radiusMeters / EARTH_RADIUS_METERS;
+    const double dLat = angle / RADIANS;
+
+    GeoBox box{lat - dLat, -180.0, lat + dLat, 180.0};
+    if (box.south <= -90.0 || box.north >= 90.0) {
+        // Holds a pole: every longitude
+        box.south = std::max(box.south, -90.0);
+        box.north = std::min(box.north, 90.0);
+        return box;
+    }
+
+    // Widest point of the circle is not at the center latitude, hence asin
+    double s = std::sin(angle) / std::cos(lat * RADIANS);
+    if (s >= 1.0) return box;
+    double dLon = std::asin(s) / RADIANS;
+    box.west = lon - dLon;
+    box.east = lon + dLon;
+    return box.normalized();
+}
+
+} // namespace PhotoGuru
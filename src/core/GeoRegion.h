@@ -0,0 +1,46 @@
+#pragma once
+
+namespace PhotoGuru {
+
+// Great-circle distance in meters (haversine, mean Earth radius)
+double geoDistanceMeters(double lat1, double lon1, double lat2, double lon2);
+
+/**
+ * @brief Latitude/longitude box, in degrees
+ *
+ * west > east means the box crosses the antimeridian. Longitudes are
+ * taken as given; use normalized() for ones a map reports past +-180.
+ */
+struct GeoBox {
+    double south = 0.0;
+    double west = 0.0;
+    double north = 0.0;
+    double east = 0.0;
+
+    bool isValid() const;
+    bool contains(double lat, double lon) const;
+
+    // True if every point in `other` is in this box
+    bool contains(const GeoBox& other) const;
+
+    // Longitudes wrapped into [-180, 180]; a span of 360 or more becomes the whole range
+    GeoBox normalized() const;
+};
+
+/**
+ * @brief Points within radiusMeters of a center, in degrees and meters
+ */
+struct GeoCircle {
+    double lat = 0.0;
+    double lon = 0.0;
+    double radiusMeters = 0.0;
+
+    bool isValid() const;
+    bool contains(double lat, double lon) const;
+    bool contains(const GeoCircle& other) const;
+
+    // Smallest GeoBox holding the circle; the whole longitude range over a pole
+    GeoBox boundingBox() const;
+};
+
+} // namespace PhotoGuru
@@ -1,19 +1,32 @@
 #include "GoogleTakeoutImporter.h"
 #include "GoogleTakeoutParser.h"
+#include "ExifToolDaemon.h"
 #include "MetadataWriter.h"
 #include "Logger.h"
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
-#include <QProcess>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <vector>
 
 namespace PhotoGuru {
 
 QString GoogleTakeoutImporter::ImportResult::summary() const {
-    return QString("Google Takeout Import: %1 images processed, %2 with JSON, %3 metadata applied, %4 errors")
+    QString text = QString("Google Takeout Import: %1 images processed, %2 with JSON, %3 metadata applied, %4 errors")
         .arg(totalImages)
         .arg(withJson)
         .arg(metadataApplied)
         .arg(errors);
+    if (skipped > 0) {
+        text += QString(", %1 already imported").arg(skipped);
+    }
+    if (cancelled) {
+        text += " (cancelled)";
+    }
+    return text;
 }
 
 GoogleTakeoutImporter::ImportResult GoogleTakeoutImporter::importDirectory(
@@ -33,48 +46,132 @@ GoogleTakeoutImporter::ImportResult GoogleTakeoutImporter::importDirectory(
         return result;
     }
     
-    // Find all images
+    // Find all images, and every sidecar with one more listing
     QStringList images = findImagesInDirectory(directoryPath);
+    const GoogleTakeoutParser::SidecarIndex sidecars(directoryPath);
     result.totalImages = images.size();
     
-    LOG_INFO("GoogleTakeoutImporter", QString("Found %1 images").arg(images.size()));
+    LOG_INFO("GoogleTakeoutImporter", QString("Found %1 images, %2 JSON sidecars")
+        .arg(images.size()).arg(sidecars.size()));
     
-    // Process each image
-    for (const QString& imagePath : images) {
-        // Find JSON sidecar
-        QString jsonPath = GoogleTakeoutParser::findJsonForImage(imagePath);
-        
-        if (jsonPath.isEmpty()) {
-            LOG_DEBUG("GoogleTakeoutImporter", "No JSON found for: " + QFileInfo(imagePath).fileName());
-            continue;
+    // Resume: drop images an earlier run finished
+    QFile journal(QDir(directoryPath).filePath(JOURNAL_FILE));
+    if (options.resume && journal.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QSet<QString> done;
+        while (!journal.atEnd()) {
+            QString name = QString::fromUtf8(journal.readLine());
+            if (name.endsWith('\n')) name.chop(1);
+            done.insert(name);
         }
+        journal.close();
         
-        result.withJson++;
-        
-        // Parse JSON
-        auto metadata = GoogleTakeoutParser::parseJsonFile(jsonPath);
+        QStringList pending;
+        for (const QString& imagePath : images) {
+            if (!done.contains(QFileInfo(imagePath).fileName())) pending.append(imagePath);
+        }
+        result.skipped = images.size() - pending.size();
+        images = pending;
+        if (result.skipped > 0) {
+            LOG_INFO("GoogleTakeoutImporter", QString("Resuming: %1 images already imported").arg(result.skipped));
+        }
+    }
+    QIODevice::OpenMode journalMode = QIODevice::WriteOnly | QIODevice::Text |
+        (options.resume ? QIODevice::Append : QIODevice::Truncate);
+    if (!journal.open(journalMode)) {
+        LOG_WARNING("GoogleTakeoutImporter", "Cannot write journal, import will not be resumable: " + journal.fileName());
+    }
+    
+    // One wave keeps every daemon process busy with a full batch
+    const int writers = ExifToolDaemon::instance().poolSize();
+    const int waveSize = writers * WRITE_BATCH_SIZE;
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(writers, QThread::idealThreadCount()));
+    
+    struct Job {
+        QString imagePath;
+        MetadataWriter::Transaction transaction;  // Empty: nothing to write
+        QString error;
+        bool hasJson = false;
+        bool applied = false;
+    };
+    
+    for (int offset = 0; offset < images.size(); offset += waveSize) {
+        // Stage 1: parse this wave's sidecars in parallel
+        QStringList wave = images.mid(offset, waveSize);
+        std::vector<Job> jobs = QtConcurrent::blockingMapped<std::vector<Job>>(&pool, wave,
+            [&sidecars, &options](const QString& imagePath) {
+            Job job;
+            job.imagePath = imagePath;
+            
+            QString jsonPath = sidecars.findJsonForImage(imagePath);
+            if (jsonPath.isEmpty()) {
+                return job;
+            }
+            job.hasJson = true;
+            
+            auto metadata = GoogleTakeoutParser::parseJsonFile(jsonPath);
+            if (!metadata.isValid) {
+                job.error = "Invalid JSON: " + jsonPath;
+            } else if (metadata.hasMetadataToApply()) {
+                job.transaction = buildTransaction(imagePath, metadata, options);
+            }
+            return job;
+        });
         
-        if (!metadata.isValid) {
-            LOG_WARNING("GoogleTakeoutImporter", "Invalid JSON: " + jsonPath);
-            result.errorMessages.append("Invalid JSON: " + jsonPath);
-            result.errors++;
-            continue;
+        // Stage 2: one command per image, WRITE_BATCH_SIZE commands per daemon round trip
+        QList<QPair<int, int>> batches;  // [first, end) into jobs
+        int batchStart = -1;
+        int batchCount = 0;
+        for (int i = 0; i < int(jobs.size()); ++i) {
+            if (jobs[i].transaction.isEmpty()) continue;
+            if (batchStart < 0) batchStart = i;
+            if (++batchCount == WRITE_BATCH_SIZE) {
+                batches.append({batchStart, i + 1});
+                batchStart = -1;
+                batchCount = 0;
+            }
         }
+        if (batchStart >= 0) batches.append({batchStart, int(jobs.size())});
         
-        // Check if has metadata to apply
-        if (!metadata.hasMetadataToApply()) {
-            LOG_DEBUG("GoogleTakeoutImporter", "No useful metadata in JSON for: " + QFileInfo(imagePath).fileName());
-            continue;
+        QtConcurrent::blockingMap(&pool, batches, [&jobs](const QPair<int, int>& batch) {
+            QList<MetadataWriter::Transaction> transactions;
+            QVector<int> indices;
+            for (int i = batch.first; i < batch.second; ++i) {
+                if (jobs[i].transaction.isEmpty()) continue;
+                transactions.append(jobs[i].transaction);
+                indices.append(i);
+            }
+            
+            std::vector<bool> written = MetadataWriter::instance().commitBatch(transactions);
+            for (int k = 0; k < indices.size(); ++k) {
+                Job& job = jobs[indices[k]];
+                job.applied = written[k];
+                if (!job.applied) job.error = "Failed to apply metadata: " + job.imagePath;
+            }
+        });
+        
+        // Record the wave; failed images stay out of the journal and are retried next run
+        for (const Job& job : jobs) {
+            if (job.hasJson) result.withJson++;
+            if (job.applied) result.metadataApplied++;
+            if (!job.error.isEmpty()) {
+                result.errors++;
+                result.errorMessages.append(job.error);
+                LOG_WARNING("GoogleTakeoutImporter", job.error);
+                continue;
+            }
+            if (journal.isOpen()) {
+                journal.write(QFileInfo(job.imagePath).fileName().toUtf8() + '\n');
+            }
         }
+        journal.flush();
         
-        // Apply metadata
-        if (applyMetadataToImage(imagePath, metadata, options)) {
-            result.metadataApplied++;
-            LOG_INFO("GoogleTakeoutImporter", QString("✅ Applied metadata to: %1").arg(QFileInfo(imagePath).fileName()));
-        } else {
-            result.errors++;
-            result.errorMessages.append("Failed to apply metadata: " + imagePath);
-            LOG_ERROR("GoogleTakeoutImporter", "Failed to apply metadata to: " + imagePath);
+        const int done = offset + wave.size();
+        LOG_INFO("GoogleTakeoutImporter", QString("Progress: %1/%2 images").arg(done).arg(images.size()));
+        if (options.progress && !options.progress(result.skipped + done, result.totalImages)) {
+            LOG_INFO("GoogleTakeoutImporter", "Import cancelled, run again to resume");
+            result.cancelled = true;
+            break;
         }
     }
     
@@ -112,75 +209,69 @@ bool GoogleTakeoutImporter::applyMetadataToImage(
     const GoogleTakeoutParser::TakeoutMetadata& metadata,
     const ImportOptions& options)
 {
-    MetadataWriter& writer = MetadataWriter::instance();
-    
     LOG_DEBUG("GoogleTakeoutImporter", QString("Applying metadata to: %1").arg(imagePath));
     
-    bool hasChanges = false;
-    bool overallSuccess = true;
+    MetadataWriter::Transaction transaction = buildTransaction(imagePath, metadata, options);
+    if (transaction.isEmpty()) {
+        return false;
+    }
+    
+    if (!MetadataWriter::instance().commit(transaction)) {
+        LOG_WARNING("GoogleTakeoutImporter", "Failed to apply metadata to: " + imagePath);
+        return false;
+    }
+    
+    LOG_INFO("GoogleTakeoutImporter", QString("✅ Metadata applied to: %1").arg(QFileInfo(imagePath).fileName()));
+    return true;
+}
+
+MetadataWriter::Transaction GoogleTakeoutImporter::buildTransaction(
+    const QString& imagePath,
+    const GoogleTakeoutParser::TakeoutMetadata& metadata,
+    const ImportOptions& options)
+{
+    // The daemon takes one argument per line, so values can't span lines
+    auto value = [](QString text) {
+        text.replace("\r\n", " ");
+        text.replace('\n', ' ');
+        return text;
+    };
+    
+    MetadataWriter::Transaction transaction(imagePath);
     
     // 1. Description/Caption
     if (options.applyDescription && !metadata.description.isEmpty()) {
-        if (writer.updateDescription(imagePath, metadata.description)) {
-            LOG_DEBUG("GoogleTakeoutImporter", QString("  Description: %1 chars").arg(metadata.description.length()));
-            hasChanges = true;
-        } else {
-            LOG_WARNING("GoogleTakeoutImporter", "  Failed to update description");
-            overallSuccess = false;
-        }
+        transaction.setDescription(value(metadata.description));
     }
     
-    // 2. Prepare keywords (people + albums)
+    // 2. Keywords (people + albums), replacing the existing ones
     QStringList keywords;
-    
-    if (options.applyPeopleAsKeywords && !metadata.people.isEmpty()) {
-        keywords.append(metadata.people);
-        LOG_DEBUG("GoogleTakeoutImporter", QString("  People: %1").arg(metadata.people.join(", ")));
+    if (options.applyPeopleAsKeywords) {
+        for (const QString& person : metadata.people) {
+            keywords.append(value(person));
+        }
     }
-    
-    if (options.applyAlbumsAsKeywords && !metadata.albumNames.isEmpty()) {
+    if (options.applyAlbumsAsKeywords) {
         for (const QString& album : metadata.albumNames) {
-            keywords.append("Album: " + album);
+            keywords.append("Album: " + value(album));
         }
-        LOG_DEBUG("GoogleTakeoutImporter", QString("  Albums: %1").arg(metadata.albumNames.join(", ")));
     }
-    
-    // Apply keywords
     if (!keywords.isEmpty()) {
-        if (writer.updateKeywords(imagePath, keywords)) {
-            hasChanges = true;
-        } else {
-            LOG_WARNING("GoogleTakeoutImporter", "  Failed to update keywords");
-            overallSuccess = false;
-        }
+        transaction.setKeywords(keywords);
     }
     
     // 3. Location (GPS coordinates)
     if (options.applyLocation && metadata.geoData.has_value()) {
-        QGeoCoordinate coord = *metadata.geoData;
-        
-        if (writer.updateGPS(imagePath, coord.latitude(), coord.longitude())) {
-            LOG_DEBUG("GoogleTakeoutImporter", QString("  GPS: %1, %2")
-                .arg(coord.latitude(), 0, 'f', 6)
-                .arg(coord.longitude(), 0, 'f', 6));
-            hasChanges = true;
-        } else {
-            LOG_WARNING("GoogleTakeoutImporter", "  Failed to update GPS");
-            overallSuccess = false;
-        }
+        transaction.setGPS(metadata.geoData->latitude(), metadata.geoData->longitude());
     }
     
-    // 4. Location name (textual)
+    // 4. Location name, usually "City, State, Country" or "City, Country"
     if (options.applyLocation && !metadata.locationName.isEmpty()) {
-        // Parse location name into parts if possible
-        // Format is usually: "City, State, Country" or "City, Country"
-        QStringList parts = metadata.locationName.split(",");
-        
+        QStringList parts = value(metadata.locationName).split(",");
         QString city, state, country;
         
         if (parts.size() >= 2) {
             city = parts[0].trimmed();
-            
             if (parts.size() >= 3) {
                 state = parts[1].trimmed();
                 country = parts[2].trimmed();
@@ -188,48 +279,18 @@ bool GoogleTakeoutImporter::applyMetadataToImage(
                 country = parts[1].trimmed();
             }
         } else {
-            city = metadata.locationName;
+            city = parts[0];
         }
         
-        if (writer.updateLocation(imagePath, city, state, country)) {
-            LOG_DEBUG("GoogleTakeoutImporter", QString("  Location: %1").arg(metadata.locationName));
-            hasChanges = true;
-        } else {
-            LOG_WARNING("GoogleTakeoutImporter", "  Failed to update location");
-            overallSuccess = false;
-        }
+        transaction.setLocation(city, state, country);
     }
     
     // 5. Date/Time
-    // Note: MetadataWriter doesn't have a direct updateDateTime method,
-    // so we'll use ExifTool directly for this
     if (options.applyDateTime && metadata.photoTakenTime.isValid()) {
-        QString dateTimeStr = metadata.photoTakenTime.toString("yyyy:MM:dd HH:mm:ss");
-        
-        QProcess process;
-        process.start("exiftool", {
-            "-DateTimeOriginal=" + dateTimeStr,
-            "-CreateDate=" + dateTimeStr,
-            "-overwrite_original",
-            imagePath
-        });
-        
-        if (process.waitForFinished(5000) && process.exitCode() == 0) {
-            LOG_DEBUG("GoogleTakeoutImporter", QString("  DateTime: %1").arg(dateTimeStr));
-            hasChanges = true;
-        } else {
-            LOG_WARNING("GoogleTakeoutImporter", "  Failed to update datetime");
-            overallSuccess = false;
-        }
-    }
-    
-    if (hasChanges && overallSuccess) {
-        LOG_INFO("GoogleTakeoutImporter", QString("✅ Metadata applied to: %1").arg(QFileInfo(imagePath).fileName()));
-    } else if (hasChanges) {
-        LOG_WARNING("GoogleTakeoutImporter", QString("⚠️  Partial metadata applied to: %1").arg(QFileInfo(imagePath).fileName()));
+        transaction.setDateTime(metadata.photoTakenTime);
     }
     
-    return hasChanges && overallSuccess;
+    return transaction;
 }
 
 QStringList GoogleTakeoutImporter::findImagesInDirectory(const QString& directoryPath) {
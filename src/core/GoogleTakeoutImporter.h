@@ -1,13 +1,13 @@
 #pragma once
 
 #include "GoogleTakeoutParser.h"
+#include "MetadataWriter.h"
 #include <QString>
 #include <QStringList>
+#include <functional>
 
 namespace PhotoGuru {
 
-class MetadataWriter;
-
 /**
  * @brief Importer for Google Takeout photo exports
  * 
@@ -20,6 +20,13 @@ class MetadataWriter;
  * This allows seamless import of Google Photos libraries with
  * all enriched metadata (descriptions, people, albums, locations)
  * preserved in standard formats.
+ *
+ * importDirectory() is built for exports of 100k+ files. A SidecarIndex
+ * lists the JSON sidecars once, then images go in waves: each wave's
+ * JSONs are parsed in parallel and every image gets
+ * one combined ExifTool command, sent in batches across the daemon pool.
+ * Finished images are appended to a journal in the directory, so an
+ * interrupted import resumes where it stopped.
  */
 class GoogleTakeoutImporter {
 public:
@@ -31,6 +38,10 @@ public:
         bool applyDateTime = true;         // Update capture date/time
         bool overwriteExisting = false;    // Overwrite existing metadata fields
         bool createBackup = true;          // Backup original files before writing
+        bool resume = true;                // Skip images the journal lists as done
+        
+        // Called on the importing thread after each wave; return false to cancel
+        std::function<bool(int done, int total)> progress;
     };
     
     struct ImportResult {
@@ -38,6 +49,8 @@ public:
         int withJson = 0;                  // Images with JSON sidecars found
         int metadataApplied = 0;           // Images where metadata was written
         int errors = 0;                    // Errors encountered
+        int skipped = 0;                   // Already done in an earlier run (journal)
+        bool cancelled = false;            // progress callback stopped the import
         QStringList errorMessages;         // Detailed error messages
         
         QString summary() const;
@@ -69,7 +82,7 @@ public:
                                   const ImportOptions& options);
     
     /**
-     * @brief Apply Takeout metadata to image using MetadataWriter
+     * @brief Apply Takeout metadata to image in one ExifTool write
      * 
      * Maps Google Takeout metadata to standard EXIF/IPTC/XMP fields:
      * - Description → EXIF:ImageDescription, IPTC:Caption-Abstract, XMP:Description
@@ -86,6 +99,21 @@ public:
     static bool applyMetadataToImage(const QString& imagePath,
                                     const GoogleTakeoutParser::TakeoutMetadata& metadata,
                                     const ImportOptions& options);
+    
+    /**
+     * @brief Everything applyMetadataToImage writes, as one transaction
+     * 
+     * Empty when the options leave nothing to write.
+     */
+    static MetadataWriter::Transaction buildTransaction(const QString& imagePath,
+                                                        const GoogleTakeoutParser::TakeoutMetadata& metadata,
+                                                        const ImportOptions& options);
+    
+    // Journal of finished images inside an imported directory
+    static constexpr const char* JOURNAL_FILE = ".photoguru-takeout-import";
+    
+    // ExifTool commands per executeBatch call
+    static constexpr int WRITE_BATCH_SIZE = 50;
 
 private:
     // Helper to scan directory for images
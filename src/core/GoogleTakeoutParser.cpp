@@ -6,6 +6,7 @@
 #include <QJsonObject>
 #include <QDir>
 #include <QFileInfo>
+#include <QRegularExpression>
 #include <QTimeZone>
 
 namespace PhotoGuru {
@@ -70,25 +71,69 @@ bool GoogleTakeoutParser::isGoogleTakeoutDirectory(const QString& directoryPath)
 }
 
 QString GoogleTakeoutParser::findJsonForImage(const QString& imagePath) {
-    // Google Takeout naming: image.jpg → image.jpg.json
-    QString jsonPath = imagePath + ".json";
+    return SidecarIndex(QFileInfo(imagePath).path()).findJsonForImage(imagePath);
+}
+
+GoogleTakeoutParser::SidecarIndex::SidecarIndex(const QString& directoryPath)
+    : m_directory(directoryPath)
+{
+    const QStringList names = QDir(directoryPath).entryList({"*.json"}, QDir::Files);
+    m_names = QSet<QString>(names.begin(), names.end());
+}
+
+QString GoogleTakeoutParser::SidecarIndex::findJsonForImage(const QString& imagePath) const {
+    if (m_names.isEmpty()) {
+        return QString();
+    }
+    
+    for (const QString& name : candidateNames(QFileInfo(imagePath).fileName())) {
+        if (m_names.contains(name)) {
+            return QDir(m_directory).filePath(name);
+        }
+    }
+    return QString(); // Not found
+}
+
+QStringList GoogleTakeoutParser::SidecarIndex::candidateNames(const QString& imageFileName) {
+    // Duplicate names: "IMG(1).jpg" keeps its counter after the extension, "IMG.jpg(1).json"
+    static const QRegularExpression counterPattern(R"(^(.*)(\(\d+\))(\.[^.]*)$)");
+    static const QRegularExpression editedPattern(R"(-edited(\.[^.]*)$)",
+                                                  QRegularExpression::CaseInsensitiveOption);
     
-    if (QFileInfo::exists(jsonPath)) {
-        return jsonPath;
+    // (name, counter) pairs to try; a literal "(1)" in the original name is kept as a fallback
+    QList<QPair<QString, QString>> variants;
+    QRegularExpressionMatch match = counterPattern.match(imageFileName);
+    if (match.hasMatch()) {
+        variants.append({match.captured(1) + match.captured(3), match.captured(2)});
+    }
+    variants.append({imageFileName, QString()});
+    
+    // Edited copies have no sidecar of their own
+    for (int i = 0, n = variants.size(); i < n; ++i) {
+        QString original = variants[i].first;
+        original.replace(editedPattern, "\\1");
+        if (original != variants[i].first) {
+            variants.append({original, variants[i].second});
+        }
     }
     
-    // Some exports might use alternative naming
-    QFileInfo info(imagePath);
-    QString baseName = info.completeBaseName();
-    QString dir = info.path();
+    QStringList candidates;
+    auto add = [&candidates](const QString& candidate) {
+        if (!candidates.contains(candidate)) candidates << candidate;
+    };
     
-    // Try: image.json (without extension duplication)
-    QString altJsonPath = dir + "/" + baseName + ".json";
-    if (QFileInfo::exists(altJsonPath)) {
-        return altJsonPath;
+    for (const auto& [name, counter] : variants) {
+        for (const char* suffix : {"", ".supplemental-metadata"}) {
+            add((name + suffix).left(MAX_SIDECAR_STEM) + counter + ".json");
+        }
     }
     
-    return QString(); // Not found
+    // Some exports drop the image extension: image.json
+    for (const auto& [name, counter] : variants) {
+        add(QFileInfo(name).completeBaseName() + counter + ".json");
+    }
+    
+    return candidates;
 }
 
 GoogleTakeoutParser::TakeoutMetadata GoogleTakeoutParser::parseJsonFile(const QString& jsonPath) {
@@ -4,6 +4,8 @@
 #include <QJsonObject>
 #include <QDateTime>
 #include <QGeoCoordinate>
+#include <QSet>
+#include <QStringList>
 #include <optional>
 #include <vector>
 
@@ -85,10 +87,46 @@ public:
      */
     static TakeoutMetadata parseJsonFile(const QString& jsonPath);
     
+    /**
+     * @brief JSON sidecars of one directory, listed once
+     * 
+     * Resolves images to sidecars in memory with Takeout's naming rules
+     * (see candidateNames), so a folder costs one readdir instead of
+     * several stat calls per image.
+     */
+    class SidecarIndex {
+    public:
+        explicit SidecarIndex(const QString& directoryPath);
+        
+        // Path of the image's sidecar in this directory, empty if none
+        QString findJsonForImage(const QString& imagePath) const;
+        
+        int size() const { return m_names.size(); }
+        
+        /**
+         * @brief Sidecar names Takeout may have used, most likely first
+         * 
+         * IMG_0001.jpg → IMG_0001.jpg.json, IMG_0001.jpg.supplemental-metadata.json,
+         * with the name before ".json" cut at MAX_SIDECAR_STEM characters;
+         * IMG_0001(1).jpg → IMG_0001.jpg(1).json; IMG_0001-edited.jpg uses
+         * the original's sidecar; IMG_0001.json last.
+         */
+        static QStringList candidateNames(const QString& imageFileName);
+        
+    private:
+        QString m_directory;
+        QSet<QString> m_names;
+    };
+    
+    // Takeout cuts sidecar names to this many characters before ".json"
+    static constexpr int MAX_SIDECAR_STEM = 46;
+    
     /**
      * @brief Find corresponding JSON file for an image
      * 
-     * Google Takeout naming: IMG_0001.jpg → IMG_0001.jpg.json
+     * Google Takeout naming: IMG_0001.jpg → IMG_0001.jpg.json, plus the
+     * variants SidecarIndex::candidateNames lists. Lists the directory;
+     * use a SidecarIndex when resolving many images of one folder.
      * 
      * @param imagePath Path to image file
      * @return Path to JSON file if exists, empty string otherwise
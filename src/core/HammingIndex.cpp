@@ -0,0 +1,50 @@
+#include "HammingIndex.h"
+#include "PerceptualHash.h"
+#include <cstdlib>
+
+namespace PhotoGuru {
+
+void HammingIndex::add(quint64 hash) {
+    const int id = size();
+    m_nodes.push_back(Node{hash});
+    if (id == 0) return;
+
+    int node = 0;
+    for (;;) {
+        const int distance = PerceptualHash::distance(hash, m_nodes[size_t(node)].hash);
+        int child = m_nodes[size_t(node)].firstChild;
+        while (child >= 0 && m_nodes[size_t(child)].distance != distance) {
+            child = m_nodes[size_t(child)].nextSibling;
+        }
+        if (child < 0) {
+            Node& added = m_nodes[size_t(id)];
+            added.distance = distance;
+            added.nextSibling = m_nodes[size_t(node)].firstChild;
+            m_nodes[size_t(node)].firstChild = id;
+            return;
+        }
+        node = child;
+    }
+}
+
+std::vector<HammingIndex::Hit> HammingIndex::search(quint64 hash, int maxDistance) const {
+    std::vector<Hit> hits;
+    if (m_nodes.empty()) return hits;
+
+    std::vector<int> pending{0};
+    while (!pending.empty()) {
+        const int node = pending.back();
+        pending.pop_back();
+        const int distance = PerceptualHash::distance(hash, m_nodes[size_t(node)].hash);
+        if (distance <= maxDistance) hits.push_back(Hit{node, distance});
+
+        for (int child = m_nodes[size_t(node)].firstChild; child >= 0; child = m_nodes[size_t(child)].nextSibling) {
+            if (std::abs(m_nodes[size_t(child)].distance - distance) <= maxDistance) {
+                pending.push_back(child);
+            }
+        }
+    }
+    return hits;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QtGlobal>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief BK-tree over 64-bit hashes, searched by Hamming distance
+ *
+ * Each node's children are keyed by their distance to it. By the
+ * triangle inequality a search within r of a query at distance d from a
+ * node only descends into children keyed d - r .. d + r, so a tight
+ * radius visits a small part of the tree. Ids are dense and added in
+ * order, as in HnswIndex.
+ *
+ * Not thread-safe.
+ */
+class HammingIndex {
+public:
+    struct Hit {
+        int id;
+        int distance;
+    };
+
+    void reserve(int count) { m_nodes.reserve(size_t(count)); }
+    int size() const { return int(m_nodes.size()); }
+    void clear() { m_nodes.clear(); }
+
+    // Adds `hash` with id size()
+    void add(quint64 hash);
+
+    // Every id within maxDistance of `hash`, in no particular order
+    std::vector<Hit> search(quint64 hash, int maxDistance) const;
+
+private:
+    struct Node {
+        quint64 hash;
+        int distance = 0;      // To the parent
+        int firstChild = -1;
+        int nextSibling = -1;
+    };
+
+    std::vector<Node> m_nodes;  // Root first; index is the id
+};
+
+} // namespace PhotoGuru
@@ -1,7 +1,14 @@
 #include "ImageLoader.h"
+#include "FileReadAhead.h"
+#include "PixelBuffer.h"
+#include "TaskScheduler.h"
+#include "Trace.h"
+#include <QBuffer>
 #include <QImageReader>
+#include <QTransform>
 #include <QFileInfo>
 #include <QDebug>
+#include <algorithm>
 
 #ifdef __APPLE__
 #include <libraw/libraw.h>
@@ -20,19 +27,95 @@ ImageLoader& ImageLoader::instance() {
     return loader;
 }
 
-ImageFormat ImageLoader::detectFormat(const QString& filePath) const {
-    QString ext = QFileInfo(filePath).suffix().toLower();
-    
-    // RAW formats
-    static const QStringList rawExts = {
-        "cr2", "cr3", "nef", "nrw", "arw", "srf", "sr2", 
+namespace {
+
+constexpr int RAW_BAND_ROWS = 256;  // Rows per task when widening 16-bit output
+
+// RAW formats (lower case)
+const QStringList& rawExtensions() {
+    static const QStringList exts = {
+        "cr2", "cr3", "nef", "nrw", "arw", "srf", "sr2",
         "dng", "orf", "rw2", "pef", "raf", "raw", "rwl",
         "3fr", "ari", "bay", "crw", "dcr", "erf", "fff",
         "iiq", "k25", "kdc", "mdc", "mef", "mos", "mrw",
-        "nrw", "obm", "ptx", "pxn", "r3d", "rdc", "rwz",
+        "obm", "ptx", "pxn", "r3d", "rdc", "rwz",
         "srw", "x3f"
     };
-    if (rawExts.contains(ext)) return ImageFormat::RAW;
+    return exts;
+}
+
+// The read-ahead buffer of `filePath` when there is one, the file otherwise
+void openReader(QImageReader& reader, QBuffer& buffer, const QString& filePath) {
+    const QByteArray data = FileReadAhead::instance().read(filePath);
+    if (data.isNull()) {
+        reader.setFileName(filePath);
+        return;
+    }
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    reader.setDevice(&buffer);
+}
+
+// LibRaw only reads the buffer; the cast spares a detach-copy of it
+int openRaw(LibRaw& rawProcessor, const QByteArray& contents, const QString& filePath) {
+    if (contents.isNull()) return rawProcessor.open_file(filePath.toStdString().c_str());
+    return rawProcessor.open_buffer(const_cast<char*>(contents.constData()), size_t(contents.size()));
+}
+
+// Whether a half-size develop of a `full` frame still fills `target`
+// (the frame fitted into it, never enlarged)
+bool halfSizeCovers(const QSize& full, const QSize& target) {
+    if (!full.isValid() || !target.isValid()) return false;
+    QSize shown = full;
+    if (full.width() > target.width() || full.height() > target.height()) {
+        shown = full.scaled(target, Qt::KeepAspectRatio);
+    }
+    return full.width() / 2 >= shown.width() && full.height() / 2 >= shown.height();
+}
+
+// LibRaw's 16-bit output is packed 3/4-channel; QImage has no such format.
+// Widened into RGBX64/RGBA64 in bands of RAW_BAND_ROWS on the TaskScheduler.
+// The load waiting for them runs bands itself when it is on a worker, so
+// one develop uses idle cores without taking them from other work.
+QImage packRaw16(const libraw_processed_image_t* image) {
+    const bool alpha = image->colors == 4;
+    QImage result(image->width, image->height, alpha ? QImage::Format_RGBA64 : QImage::Format_RGBX64);
+    if (result.isNull()) return result;
+
+    const int width = image->width;
+    const int height = image->height;
+    const int colors = image->colors;
+    const auto* source = reinterpret_cast<const quint16*>(image->data);
+    uchar* bits = result.bits();  // Once, here: bits() detaches
+    const qsizetype stride = result.bytesPerLine();
+    auto widen = [=](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            const quint16* in = source + qsizetype(y) * width * colors;
+            auto* out = reinterpret_cast<QRgba64*>(bits + y * stride);
+            for (int x = 0; x < width; ++x, in += colors) {
+                out[x] = qRgba64(in[0], in[1], in[2], alpha ? in[3] : 0xffff);
+            }
+        }
+    };
+
+    if (height <= RAW_BAND_ROWS) {
+        widen(0, height);
+        return result;
+    }
+    TaskGroup bands(TaskScheduler::Prefetch);
+    for (int first = 0; first < height; first += RAW_BAND_ROWS) {
+        bands.start([&widen, first, height]() { widen(first, std::min(height, first + RAW_BAND_ROWS)); });
+    }
+    bands.waitForDone();
+    return result;
+}
+
+} // namespace
+
+ImageFormat ImageLoader::detectFormat(const QString& filePath) const {
+    QString ext = QFileInfo(filePath).suffix().toLower();
+    
+    if (rawExtensions().contains(ext)) return ImageFormat::RAW;
     
     // HEIF/HEIC
     if (ext == "heif" || ext == "heic") return ImageFormat::HEIF;
@@ -47,38 +130,60 @@ ImageFormat ImageLoader::detectFormat(const QString& filePath) const {
 }
 
 std::optional<QImage> ImageLoader::load(const QString& filePath, const QSize& maxSize) {
+    TRACE_SCOPE("image.decode");
     ImageFormat format = detectFormat(filePath);
     
     switch (format) {
         case ImageFormat::RAW: {
+            // Thumbnails: embedded preview is 10-50x faster than demosaic
+            if (maxSize.isValid() && maxSize.width() < 2000 && maxSize.height() < 2000) {
+                if (auto preview = loadRAWPreview(filePath, maxSize)) {
+                    return preview;
+                }
+            }
+            
+            // Bounded loads are shown scaled down: PPG, or half size when that covers it
             RawLoadOptions opts;
-            opts.halfSize = maxSize.isValid() && (maxSize.width() < 2000);
+            opts.quality = maxSize.isValid() ? RawQuality::Standard : RawQuality::Fine;
+            opts.maxSize = maxSize;
             return loadRAW(filePath, opts);
         }
         case ImageFormat::HEIF:
-            return loadHEIF(filePath);
+            return loadHEIF(filePath, maxSize);
         default:
-            return loadStandard(filePath);
+            return loadStandard(filePath, maxSize);
     }
 }
 
 std::optional<QImage> ImageLoader::loadRAW(const QString& filePath, 
                                            const RawLoadOptions& options) {
     try {
+        // Outlives rawProcessor: LibRaw reads from it until recycled
+        const QByteArray contents = FileReadAhead::instance().read(filePath);
         LibRaw rawProcessor;
         
         // Open file
-        int ret = rawProcessor.open_file(filePath.toStdString().c_str());
+        int ret = openRaw(rawProcessor, contents, filePath);
         if (ret != LIBRAW_SUCCESS) {
             qWarning() << "LibRaw: Failed to open" << filePath;
             return std::nullopt;
         }
         
+        // Sizes are known once open; the output is turned upright
+        RawQuality quality = options.quality;
+        const libraw_image_sizes_t& sizes = rawProcessor.imgdata.sizes;
+        QSize full(sizes.width, sizes.height);
+        if (sizes.flip & 4) full.transpose();
+        if (quality != RawQuality::Draft && halfSizeCovers(full, options.maxSize)) {
+            quality = RawQuality::Draft;
+        }
+        
         // Configure processing
         rawProcessor.imgdata.params.use_camera_wb = options.autoWB ? 1 : 0;
         rawProcessor.imgdata.params.use_auto_wb = options.autoWB ? 1 : 0;
-        rawProcessor.imgdata.params.half_size = options.halfSize ? 1 : 0;
-        rawProcessor.imgdata.params.output_bps = options.outputBitDepth;
+        rawProcessor.imgdata.params.half_size = quality == RawQuality::Draft ? 1 : 0;
+        rawProcessor.imgdata.params.user_qual = quality == RawQuality::Fine ? 3 : 2;  // AHD : PPG
+        rawProcessor.imgdata.params.output_bps = options.outputBitDepth == 16 ? 16 : 8;
         rawProcessor.imgdata.params.no_auto_bright = 0;  // Enable auto-brightness
         rawProcessor.imgdata.params.highlight = 1;  // Clip highlights
         rawProcessor.imgdata.params.output_color = 1;  // sRGB
@@ -90,7 +195,10 @@ std::optional<QImage> ImageLoader::loadRAW(const QString& filePath,
             return std::nullopt;
         }
         
-        ret = rawProcessor.dcraw_process();
+        {
+            TRACE_SCOPE("raw.develop");
+            ret = rawProcessor.dcraw_process();
+        }
         if (ret != LIBRAW_SUCCESS) {
             qWarning() << "LibRaw: Failed to process" << filePath;
             return std::nullopt;
@@ -103,22 +211,21 @@ std::optional<QImage> ImageLoader::loadRAW(const QString& filePath,
             return std::nullopt;
         }
         
-        // Convert to QImage
+        // Adopt LibRaw's 8-bit buffer rather than copying it; freed with the last QImage
         QImage result;
-        if (image->type == LIBRAW_IMAGE_BITMAP) {
-            if (image->colors == 3) {
-                // RGB image
-                result = QImage(image->data, image->width, image->height, 
-                               image->width * 3, QImage::Format_RGB888).copy();
-            } else if (image->colors == 4) {
-                // RGBA image
-                result = QImage(image->data, image->width, image->height,
-                               image->width * 4, QImage::Format_RGBA8888).copy();
-            }
+        const bool bitmap = image->type == LIBRAW_IMAGE_BITMAP && (image->colors == 3 || image->colors == 4);
+        if (bitmap && image->bits == 16) {
+            result = packRaw16(image);
+            LibRaw::dcraw_clear_mem(image);
+        } else if (bitmap && image->bits == 8) {
+            result = PixelBuffer::wrap(image->data, image->width, image->height,
+                                       image->width * image->colors,
+                                       image->colors == 3 ? QImage::Format_RGB888 : QImage::Format_RGBA8888,
+                                       [image]() { LibRaw::dcraw_clear_mem(image); }).image();
+        } else {
+            LibRaw::dcraw_clear_mem(image);
         }
         
-        LibRaw::dcraw_clear_mem(image);
-        
         if (result.isNull()) {
             qWarning() << "Failed to convert RAW to QImage";
             return std::nullopt;
@@ -132,14 +239,127 @@ std::optional<QImage> ImageLoader::loadRAW(const QString& filePath,
     }
 }
 
-std::optional<QImage> ImageLoader::loadHEIF(const QString& filePath) {
+std::optional<QImage> ImageLoader::loadRAWPreview(const QString& filePath,
+                                                  const QSize& minSize) {
+    try {
+        // The embedded JPEG is a few percent of the file: read in place
+        // unless the full decode's buffer is here already
+        const QByteArray contents = FileReadAhead::instance().buffered(filePath);
+        LibRaw rawProcessor;
+        
+        int ret = openRaw(rawProcessor, contents, filePath);
+        if (ret != LIBRAW_SUCCESS) {
+            return std::nullopt;
+        }
+        
+        // Cheap rejection before unpacking: LibRaw knows the preview size
+        const auto& thumb = rawProcessor.imgdata.thumbnail;
+        if (minSize.isValid() && thumb.twidth > 0 && thumb.theight > 0 &&
+            thumb.twidth < minSize.width() && thumb.theight < minSize.height()) {
+            return std::nullopt;
+        }
+        
+        ret = rawProcessor.unpack_thumb();
+        if (ret != LIBRAW_SUCCESS) {
+            return std::nullopt;
+        }
+        
+        libraw_processed_image_t* image = rawProcessor.dcraw_make_mem_thumb(&ret);
+        if (!image) {
+            return std::nullopt;
+        }
+        
+        QImage result;
+        if (image->type == LIBRAW_IMAGE_BITMAP && image->colors == 3) {
+            result = PixelBuffer::wrap(image->data, image->width, image->height, image->width * 3,
+                                       QImage::Format_RGB888,
+                                       [image]() { LibRaw::dcraw_clear_mem(image); }).image();
+        } else {
+            if (image->type == LIBRAW_IMAGE_JPEG) {
+                result.loadFromData(image->data, int(image->data_size), "JPEG");
+            }
+            LibRaw::dcraw_clear_mem(image);
+        }
+        
+        if (result.isNull()) {
+            return std::nullopt;
+        }
+        
+        if (minSize.isValid() &&
+            result.width() < minSize.width() && result.height() < minSize.height()) {
+            return std::nullopt;
+        }
+        
+        // Previews are stored unrotated; apply the RAW orientation
+        // (3 = 180, 5 = 90 CCW, 6 = 90 CW)
+        QTransform rotation;
+        switch (rawProcessor.imgdata.sizes.flip) {
+            case 3: rotation.rotate(180); break;
+            case 5: rotation.rotate(-90); break;
+            case 6: rotation.rotate(90); break;
+            default: break;
+        }
+        if (!rotation.isIdentity()) {
+            result = result.transformed(rotation);
+        }
+        
+        return result;
+        
+    } catch (const std::exception& e) {
+        qWarning() << "Exception loading RAW preview:" << e.what();
+        return std::nullopt;
+    }
+}
+
+std::optional<QImage> ImageLoader::loadPreview(const QString& filePath, const QSize& maxSize,
+                                               bool* isFull) {
+    TRACE_SCOPE("image.preview");
+    if (isFull) *isFull = false;
+    
+    switch (detectFormat(filePath)) {
+        case ImageFormat::RAW: {
+            std::optional<QImage> preview = loadRAWPreview(filePath);
+            if (!preview) {
+                // No embedded preview: half-size demosaic is still 4x cheaper
+                RawLoadOptions opts;
+                opts.quality = RawQuality::Draft;
+                preview = loadRAW(filePath, opts);
+            }
+            if (preview && maxSize.isValid() &&
+                (preview->width() > maxSize.width() || preview->height() > maxSize.height())) {
+                *preview = preview->scaled(maxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            }
+            return preview;
+        }
+        case ImageFormat::HEIF:
+            return loadHEIF(filePath, maxSize, true);
+        default: {
+            std::optional<QImage> preview = loadStandard(filePath, maxSize);
+            if (preview && isFull) {
+                QBuffer buffer;
+                QImageReader reader;
+                openReader(reader, buffer, filePath);
+                QSize source = reader.size();
+                *isFull = preview->size() == source || preview->size() == source.transposed();
+            }
+            return preview;
+        }
+    }
+}
+
+std::optional<QImage> ImageLoader::loadHEIF(const QString& filePath, const QSize& maxSize,
+                                            bool anyThumbnail) {
 #ifdef HEIF_SUPPORT_ENABLED
     try {
+        // Outlives ctx, which reads from it without a copy
+        const QByteArray contents = FileReadAhead::instance().read(filePath);
         heif_context* ctx = heif_context_alloc();
         if (!ctx) return std::nullopt;
         
-        heif_error error = heif_context_read_from_file(ctx, 
-            filePath.toStdString().c_str(), nullptr);
+        heif_error error = contents.isNull()
+            ? heif_context_read_from_file(ctx, filePath.toStdString().c_str(), nullptr)
+            : heif_context_read_from_memory_without_copy(ctx, contents.constData(), size_t(contents.size()),
+                                                         nullptr);
         
         if (error.code != heif_error_Ok) {
             heif_context_free(ctx);
@@ -155,12 +375,29 @@ std::optional<QImage> ImageLoader::loadHEIF(const QString& filePath) {
             return std::nullopt;
         }
         
+        // Small target: decode the embedded thumbnail instead of the full
+        // image (iPhone HEICs carry one, avoiding a 48 MP decode)
+        heif_image_handle* decodeHandle = handle;
+        heif_image_handle* thumbHandle = nullptr;
+        if ((maxSize.isValid() || anyThumbnail) && heif_image_handle_get_number_of_thumbnails(handle) > 0) {
+            heif_item_id thumbId;
+            heif_image_handle_get_list_of_thumbnail_IDs(handle, &thumbId, 1);
+            if (heif_image_handle_get_thumbnail(handle, thumbId, &thumbHandle).code == heif_error_Ok) {
+                int tw = heif_image_handle_get_width(thumbHandle);
+                int th = heif_image_handle_get_height(thumbHandle);
+                if (anyThumbnail || tw >= maxSize.width() || th >= maxSize.height()) {
+                    decodeHandle = thumbHandle;
+                }
+            }
+        }
+        
         // Decode image
         heif_image* img;
-        error = heif_decode_image(handle, &img, heif_colorspace_RGB,
+        error = heif_decode_image(decodeHandle, &img, heif_colorspace_RGB,
                                   heif_chroma_interleaved_RGB, nullptr);
         
         if (error.code != heif_error_Ok) {
+            if (thumbHandle) heif_image_handle_release(thumbHandle);
             heif_image_handle_release(handle);
             heif_context_free(ctx);
             return std::nullopt;
@@ -174,12 +411,20 @@ std::optional<QImage> ImageLoader::loadHEIF(const QString& filePath) {
         int width = heif_image_get_width(img, heif_channel_interleaved);
         int height = heif_image_get_height(img, heif_channel_interleaved);
         
-        // Create QImage (must copy since data lifetime is limited)
-        QImage temp(data, width, height, stride, QImage::Format_RGB888);
-        QImage result = temp.copy();
+        // Scaling when bounded produces a new image at the target size;
+        // otherwise the result adopts libheif's plane, which outlives the context
+        QImage result;
+        if (maxSize.isValid() && (width > maxSize.width() || height > maxSize.height())) {
+            result = QImage(data, width, height, stride, QImage::Format_RGB888)
+                         .scaled(maxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            heif_image_release(img);
+        } else {
+            result = PixelBuffer::wrap(data, width, height, stride, QImage::Format_RGB888,
+                                       [img]() { heif_image_release(img); }).image();
+        }
         
         // Cleanup
-        heif_image_release(img);
+        if (thumbHandle) heif_image_handle_release(thumbHandle);
         heif_image_handle_release(handle);
         heif_context_free(ctx);
         
@@ -190,15 +435,35 @@ std::optional<QImage> ImageLoader::loadHEIF(const QString& filePath) {
         return std::nullopt;
     }
 #else
+    Q_UNUSED(maxSize);
+    Q_UNUSED(anyThumbnail);
     qWarning() << "HEIF support not compiled in";
     return std::nullopt;
 #endif
 }
 
-std::optional<QImage> ImageLoader::loadStandard(const QString& filePath) {
-    QImageReader reader(filePath);
+std::optional<QImage> ImageLoader::loadStandard(const QString& filePath, const QSize& maxSize) {
+    QBuffer buffer;
+    QImageReader reader;
+    openReader(reader, buffer, filePath);
     reader.setAutoTransform(true);  // Handle EXIF orientation
     
+    // Decode at reduced size: the JPEG plugin scales in the DCT domain,
+    // so a thumbnail never allocates the full-resolution frame
+    if (maxSize.isValid()) {
+        QSize sourceSize = reader.size();
+        if (sourceSize.isValid()) {
+            // Scaled size applies before the EXIF rotation
+            QSize bound = maxSize;
+            if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+                bound.transpose();
+            }
+            if (sourceSize.width() > bound.width() || sourceSize.height() > bound.height()) {
+                reader.setScaledSize(sourceSize.scaled(bound, Qt::KeepAspectRatio));
+            }
+        }
+    }
+    
     QImage image = reader.read();
     if (image.isNull()) {
         qWarning() << "Failed to load image:" << reader.errorString();
@@ -208,20 +473,99 @@ std::optional<QImage> ImageLoader::loadStandard(const QString& filePath) {
     return image;
 }
 
+std::optional<QImage> ImageLoader::loadRegion(const QString& filePath, const QRect& region) {
+    if (region.isEmpty()) return std::nullopt;
+    
+    ImageFormat format = detectFormat(filePath);
+    if (format == ImageFormat::RAW || format == ImageFormat::HEIF) {
+        std::optional<QImage> full = load(filePath);
+        if (!full) return std::nullopt;
+        QRect clipped = region.intersected(full->rect());
+        if (clipped.isEmpty()) return std::nullopt;
+        return full->copy(clipped);
+    }
+    
+    QBuffer buffer;
+    QImageReader reader;
+    openReader(reader, buffer, filePath);
+    QSize stored = reader.size();
+    if (!stored.isValid()) {
+        qWarning() << "Failed to read image size:" << reader.errorString();
+        return std::nullopt;
+    }
+    
+    // Map the region back through the EXIF orientation; Qt mirrors and
+    // flips first, then turns 90 degrees clockwise
+    QImageIOHandler::Transformations orientation = reader.transformation();
+    QTransform toOriented;
+    if (orientation & QImageIOHandler::TransformationRotate90) {
+        toOriented = QTransform(0, 1, -1, 0, stored.height(), 0);
+    }
+    if (orientation & QImageIOHandler::TransformationMirror) {
+        toOriented = QTransform(-1, 0, 0, 1, stored.width(), 0) * toOriented;
+    }
+    if (orientation & QImageIOHandler::TransformationFlip) {
+        toOriented = QTransform(1, 0, 0, -1, 0, stored.height()) * toOriented;
+    }
+    QRect storedRegion = toOriented.inverted().mapRect(QRectF(region)).toAlignedRect()
+        .intersected(QRect(QPoint(0, 0), stored));
+    if (storedRegion.isEmpty()) return std::nullopt;
+    
+    // Formats without clip support decode whole and crop inside Qt
+    reader.setAutoTransform(false);
+    reader.setClipRect(storedRegion);
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qWarning() << "Failed to load image region:" << reader.errorString();
+        return std::nullopt;
+    }
+    
+    image = image.mirrored(orientation & QImageIOHandler::TransformationMirror,
+                           orientation & QImageIOHandler::TransformationFlip);
+    if (orientation & QImageIOHandler::TransformationRotate90) {
+        image = image.transformed(QTransform().rotate(90));
+    }
+    return image;
+}
+
 QSize ImageLoader::getImageDimensions(const QString& filePath) const {
     ImageFormat format = detectFormat(filePath);
     
     if (format == ImageFormat::RAW) {
         LibRaw rawProcessor;
         if (rawProcessor.open_file(filePath.toStdString().c_str()) == LIBRAW_SUCCESS) {
-            return QSize(rawProcessor.imgdata.sizes.width, 
-                        rawProcessor.imgdata.sizes.height);
+            QSize size(rawProcessor.imgdata.sizes.width, 
+                       rawProcessor.imgdata.sizes.height);
+            // dcraw_process turns portrait frames upright
+            return (rawProcessor.imgdata.sizes.flip & 4) ? size.transposed() : size;
+        }
+        return QSize();
+    }
+    
+#ifdef HEIF_SUPPORT_ENABLED
+    if (format == ImageFormat::HEIF) {
+        QSize size;
+        heif_context* ctx = heif_context_alloc();
+        heif_image_handle* handle = nullptr;
+        if (ctx &&
+            heif_context_read_from_file(ctx, filePath.toStdString().c_str(), nullptr).code == heif_error_Ok &&
+            heif_context_get_primary_image_handle(ctx, &handle).code == heif_error_Ok) {
+            // Sizes after the file's rotation/crop, as decoded
+            size = QSize(heif_image_handle_get_width(handle), heif_image_handle_get_height(handle));
+            heif_image_handle_release(handle);
         }
+        if (ctx) heif_context_free(ctx);
+        return size;
     }
+#endif
     
     // Use QImageReader for other formats (fast, doesn't load full image)
     QImageReader reader(filePath);
-    return reader.size();
+    QSize size = reader.size();
+    if (reader.transformation() & QImageIOHandler::TransformationRotate90) {
+        size.transpose();
+    }
+    return size;
 }
 
 bool ImageLoader::isSupported(const QString& filePath) const {
@@ -229,18 +573,17 @@ bool ImageLoader::isSupported(const QString& filePath) const {
 }
 
 QStringList ImageLoader::supportedExtensions() const {
-    QStringList exts;
-    
-    // RAW formats
-    exts << "*.cr2" << "*.cr3" << "*.nef" << "*.arw" << "*.dng" 
-         << "*.orf" << "*.rw2" << "*.pef" << "*.raf" << "*.raw";
-    
-    // HEIF
-    exts << "*.heif" << "*.heic";
-    
-    // Standard
-    exts << "*.jpg" << "*.jpeg" << "*.png" << "*.tiff" << "*.tif" << "*.webp";
+    // Same set detectFormat() recognises
+    QStringList lower = rawExtensions();
+    lower << "heif" << "heic";
+    lower << "jpg" << "jpeg" << "png" << "tiff" << "tif" << "webp";
     
+    // Upper case too: name filters are case-sensitive in some consumers
+    // (file dialogs, QDir::CaseSensitive) on case-sensitive filesystems
+    QStringList exts;
+    for (const QString& ext : lower) {
+        exts << "*." + ext << "*." + ext.toUpper();
+    }
     return exts;
 }
 
@@ -3,6 +3,7 @@
 #include <QImage>
 #include <QString>
 #include <QSize>
+#include <QRect>
 #include <memory>
 #include <optional>
 
@@ -18,10 +19,20 @@ enum class ImageFormat {
     Unknown
 };
 
+// Demosaic per use: the cost of AHD only shows (and only pays) at 1:1
+enum class RawQuality {
+    Draft,     // Half size: 2x2 pixels binned, no interpolation; about 4x faster
+    Standard,  // PPG: fast full-size interpolation, fine once scaled to the screen
+    Fine       // AHD: the 1:1 view and full-size output
+};
+
 struct RawLoadOptions {
     bool autoWB = true;
-    bool halfSize = false;  // For fast preview
-    int outputBitDepth = 8;  // 8 or 16
+    RawQuality quality = RawQuality::Fine;
+    // Target the result is shown at (optional): Draft when half the
+    // sensor still covers it
+    QSize maxSize;
+    int outputBitDepth = 8;  // 8 (RGB888) or 16 (RGBX64)
 };
 
 class ImageLoader {
@@ -38,10 +49,34 @@ public:
     // Specialized loaders
     std::optional<QImage> loadRAW(const QString& filePath,
                                   const RawLoadOptions& options = {});
-    std::optional<QImage> loadHEIF(const QString& filePath);
-    std::optional<QImage> loadStandard(const QString& filePath);
     
-    // Get full resolution size without loading entire image
+    // Embedded JPEG/bitmap preview from a RAW file (no demosaic).
+    // Returns nullopt if there is no preview or it is smaller than minSize.
+    std::optional<QImage> loadRAWPreview(const QString& filePath,
+                                         const QSize& minSize = QSize());
+    // maxSize (optional) bounds the decoded size: JPEG scales during
+    // decode, HEIF uses its embedded thumbnail when large enough
+    // (anyThumbnail: whenever there is one)
+    std::optional<QImage> loadHEIF(const QString& filePath,
+                                   const QSize& maxSize = QSize(),
+                                   bool anyThumbnail = false);
+    
+    // Quickest image worth showing while load() runs: the RAW embedded
+    // preview, the HEIF thumbnail, or a JPEG/PNG decoded at maxSize.
+    // *isFull is set when the result already holds every source pixel.
+    std::optional<QImage> loadPreview(const QString& filePath, const QSize& maxSize,
+                                      bool* isFull = nullptr);
+    std::optional<QImage> loadStandard(const QString& filePath,
+                                       const QSize& maxSize = QSize());
+    
+    // Full-resolution pixels of `region`, in the coordinates of the
+    // unbounded load() (EXIF orientation applied). JPEG reads only the
+    // scanlines down to the region's bottom and keeps just the region;
+    // RAW and HEIF have no region decode, so they decode the whole frame.
+    std::optional<QImage> loadRegion(const QString& filePath, const QRect& region);
+    
+    // Get full resolution size without loading entire image, oriented
+    // as load() returns it
     QSize getImageDimensions(const QString& filePath) const;
     
     // Check if format is supported
@@ -0,0 +1,55 @@
+#include "JsonHttpClient.h"
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+namespace PhotoGuru {
+
+std::optional<QJsonObject> JsonHttpClient::request(const QUrl& server, const QString& token, const QString& path,
+                                                   const QUrlQuery& query, const std::optional<QJsonObject>& body,
+                                                   int timeoutMs, QString* error) {
+    QUrl url = server;
+    url.setPath(path);
+    if (!query.isEmpty()) url.setQuery(query);
+    QNetworkRequest request(url);
+    request.setTransferTimeout(timeoutMs);
+    if (!token.isEmpty()) request.setRawHeader("Authorization", "Bearer " + token.toUtf8());
+
+    // A manager belongs to the thread that made it
+    QNetworkAccessManager manager;
+    QNetworkReply* reply = nullptr;
+    if (body) {
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        reply = manager.post(request, QJsonDocument(*body).toJson(QJsonDocument::Compact));
+    } else {
+        reply = manager.get(request);
+    }
+
+    QEventLoop loop;
+    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    const QByteArray data = reply->readAll();
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const QNetworkReply::NetworkError networkError = reply->error();
+    const QString networkMessage = reply->errorString();
+    reply->deleteLater();
+
+    QJsonParseError parseError;
+    const QJsonObject json = QJsonDocument::fromJson(data, &parseError).object();
+    if (networkError != QNetworkReply::NoError || status != 200) {
+        const QString serverMessage = json.value("error").toString();
+        *error = QString("%1%2: %3").arg(url.toString()).arg(status ? QString(" (HTTP %1)").arg(status) : QString())
+                     .arg(serverMessage.isEmpty() ? networkMessage : serverMessage);
+        return std::nullopt;
+    }
+    if (parseError.error != QJsonParseError::NoError) {
+        *error = url.toString() + ": malformed reply: " + parseError.errorString();
+        return std::nullopt;
+    }
+    return json;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <QUrl>
+#include <QUrlQuery>
+#include <optional>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Blocking JSON requests to a JsonHttpServer
+ *
+ * Each call runs its own QNetworkAccessManager and event loop, so it may
+ * come from any thread (the pipeline's stage threads, a sync worker) and
+ * holds only that thread until the reply is in.
+ */
+class JsonHttpClient {
+public:
+    /**
+     * @brief GET (body null) or POST `path` on `server`
+     * @param token Sent as "Authorization: Bearer <token>" unless empty
+     * @return The reply's JSON object; nullopt with *error set on a network
+     *         error, a non-200 status (the server's message, if it sent one)
+     *         or a malformed reply
+     */
+    static std::optional<QJsonObject> request(const QUrl& server, const QString& token, const QString& path,
+                                              const QUrlQuery& query, const std::optional<QJsonObject>& body,
+                                              int timeoutMs, QString* error);
+};
+
+} // namespace PhotoGuru
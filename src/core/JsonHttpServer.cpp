@@ -0,0 +1,215 @@
+#include "JsonHttpServer.h"
+#include "TaskScheduler.h"
+#include <QJsonDocument>
+#include <QPointer>
+#include <QTcpSocket>
+#include <QDebug>
+
+namespace PhotoGuru {
+
+namespace {
+
+const char* reason(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        default: return "Internal Server Error";
+    }
+}
+
+} // namespace
+
+JsonHttpServer::JsonHttpServer(const QString& name, QObject* parent)
+    : QObject(parent)
+    , m_name(name)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &JsonHttpServer::onNewConnection);
+}
+
+JsonHttpServer::~JsonHttpServer() {
+    m_server.close();
+
+    // Sockets go before the table their signals update
+    const QList<QTcpSocket*> sockets = m_connections.keys();
+    m_connections.clear();
+    for (QTcpSocket* socket : sockets) {
+        socket->disconnect(this);
+        delete socket;
+    }
+}
+
+void JsonHttpServer::route(const QByteArray& method, const QByteArray& path, Handler handler, TaskGroup* tasks) {
+    m_routes.insert(path, Route{method, std::move(handler), tasks});
+}
+
+bool JsonHttpServer::listen(const QHostAddress& address, quint16 port) {
+    if (!m_server.listen(address, port)) {
+        qWarning().noquote() << QString("[%1]").arg(m_name) << "Cannot listen on" << address.toString() << port
+                             << m_server.errorString();
+        return false;
+    }
+    qDebug().noquote() << QString("[%1]").arg(m_name) << "Listening on" << address.toString() << m_server.serverPort();
+    return true;
+}
+
+void JsonHttpServer::close() {
+    m_server.close();
+    const QList<QTcpSocket*> sockets = m_connections.keys();  // Disconnects update the table
+    for (QTcpSocket* socket : sockets) {
+        socket->disconnectFromHost();
+    }
+}
+
+quint16 JsonHttpServer::port() const {
+    return m_server.serverPort();
+}
+
+QString JsonHttpServer::errorString() const {
+    return m_server.errorString();
+}
+
+QJsonObject JsonHttpServer::error(const QString& message) {
+    return QJsonObject{{"error", message}};
+}
+
+void JsonHttpServer::onNewConnection() {
+    while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+        m_connections.insert(socket, Connection());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { onReadyRead(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_connections.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void JsonHttpServer::onReadyRead(QTcpSocket* socket) {
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end()) return;
+    it->buffer.append(socket->readAll());
+
+    // Pipelined requests go in order: all that are buffered, until one is
+    // with its handler (picked up when its reply is out)
+    while (it != m_connections.end() && !it->busy) {
+        std::optional<Parsed> parsed = takeRequest(socket, *it);
+        if (!parsed) return;
+        dispatch(socket, *parsed);
+        if (!parsed->keepAlive) return;
+        it = m_connections.find(socket);  // A reply may have ended the connection
+    }
+}
+
+std::optional<JsonHttpServer::Parsed> JsonHttpServer::takeRequest(QTcpSocket* socket, Connection& connection) {
+    const int headerEnd = connection.buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (connection.buffer.size() > MAX_HEADER_BYTES) {
+            connection.buffer.clear();
+            reply(socket, 431, error("Header too large"), false);
+        }
+        return std::nullopt;
+    }
+
+    const QList<QByteArray> lines = connection.buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> start = lines.value(0).trimmed().split(' ');
+    if (start.size() != 3) {
+        connection.buffer.clear();
+        reply(socket, 400, error("Malformed request line"), false);
+        return std::nullopt;
+    }
+
+    Parsed parsed;
+    Request& request = parsed.request;
+    request.method = start[0];
+    const int queryStart = start[1].indexOf('?');
+    request.path = queryStart >= 0 ? start[1].left(queryStart) : start[1];
+    if (queryStart >= 0) request.query = QUrlQuery(QString::fromUtf8(start[1].mid(queryStart + 1)));
+    request.peer = socket->peerAddress().toString();
+    parsed.keepAlive = start[2] != "HTTP/1.0";
+    parsed.authorized = m_token.isEmpty();
+
+    qint64 length = 0;
+    for (int i = 1; i < lines.size(); ++i) {
+        const int colon = lines[i].indexOf(':');
+        if (colon <= 0) continue;
+        const QByteArray name = lines[i].left(colon).trimmed().toLower();
+        const QByteArray value = lines[i].mid(colon + 1).trimmed();
+        if (name == "content-length") {
+            length = value.toLongLong();
+        } else if (name == "connection") {
+            parsed.keepAlive = value.toLower() != "close";
+        } else if (name == "authorization" && !m_token.isEmpty()) {
+            parsed.authorized = value == "Bearer " + m_token;
+        }
+    }
+    if (length < 0 || length > MAX_REQUEST_BYTES) {
+        connection.buffer.clear();
+        reply(socket, 413, error("Request too large"), false);
+        return std::nullopt;
+    }
+
+    const qint64 total = headerEnd + 4 + length;
+    if (connection.buffer.size() < total) return std::nullopt;
+    request.body = connection.buffer.mid(headerEnd + 4, length);
+    connection.buffer.remove(0, total);
+    return parsed;
+}
+
+void JsonHttpServer::dispatch(QTcpSocket* socket, const Parsed& parsed) {
+    const Request& request = parsed.request;
+    if (!parsed.authorized) {
+        reply(socket, 401, error("Missing or wrong token"), parsed.keepAlive);
+        return;
+    }
+
+    auto route = m_routes.constFind(request.path);
+    if (route == m_routes.cend()) {
+        reply(socket, 404, error("Unknown path " + QString::fromUtf8(request.path)), parsed.keepAlive);
+        return;
+    }
+    if (request.method != route->method) {
+        reply(socket, 405, error("Use " + QString::fromLatin1(route->method)), parsed.keepAlive);
+        return;
+    }
+
+    if (!route->tasks) {
+        int status = 200;
+        QJsonObject body = route->handler(request, &status);
+        reply(socket, status, body, parsed.keepAlive);
+        return;
+    }
+
+    // The handler runs off this thread; the reply comes back to it
+    m_connections[socket].busy = true;
+    QPointer<QTcpSocket> guard(socket);
+    route->tasks->start([this, guard, handler = route->handler, request, keepAlive = parsed.keepAlive]() {
+        int status = 200;
+        QJsonObject body = handler(request, &status);
+        QMetaObject::invokeMethod(this, [this, guard, status, body, keepAlive]() {
+            if (!guard) return;
+            auto it = m_connections.find(guard.data());
+            if (it == m_connections.end()) return;
+            it->busy = false;
+            reply(guard.data(), status, body, keepAlive);
+            if (keepAlive) onReadyRead(guard.data());  // Anything the client sent meanwhile
+        }, Qt::QueuedConnection);
+    });
+}
+
+void JsonHttpServer::reply(QTcpSocket* socket, int status, const QJsonObject& body, bool keepAlive) {
+    const QByteArray payload = QJsonDocument(body).toJson(QJsonDocument::Compact);
+    QByteArray head = QString("HTTP/1.1 %1 %2\r\n"
+                              "Content-Type: application/json\r\n"
+                              "Content-Length: %3\r\n"
+                              "Connection: %4\r\n\r\n")
+        .arg(status).arg(reason(status)).arg(payload.size()).arg(keepAlive ? "keep-alive" : "close").toLatin1();
+    socket->write(head + payload);
+    if (!keepAlive) socket->disconnectFromHost();
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QHostAddress>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QTcpServer>
+#include <QUrlQuery>
+#include <functional>
+#include <optional>
+
+class QTcpSocket;
+
+namespace PhotoGuru {
+
+class TaskGroup;
+
+/**
+ * @brief Minimal HTTP/1.1 server answering JSON requests
+ *
+ * What InferenceServer and CatalogServer share: Content-Length bodies,
+ * keep-alive, one request in flight per connection, a routing table of
+ * method + path, and an optional shared token ("Authorization: Bearer
+ * <token>"; requests without it get 401). Unknown paths get 404, the
+ * wrong method 405, oversized requests 413/431.
+ *
+ * A route's handler runs in the TaskGroup it was registered with, or on the server's thread when it has none; the reply always
+ * goes out on the server's thread, which needs an event loop. Whoever
+ * owns the groups waits for them before the server goes.
+ */
+class JsonHttpServer : public QObject {
+    Q_OBJECT
+
+public:
+    struct Request {
+        QByteArray method;
+        QByteArray path;
+        QUrlQuery query;
+        QByteArray body;
+        QString peer;
+    };
+    // Sets *status (200 unless changed) alongside the reply body
+    using Handler = std::function<QJsonObject(const Request& request, int* status)>;
+
+    // name tags the log lines
+    explicit JsonHttpServer(const QString& name, QObject* parent = nullptr);
+    ~JsonHttpServer();
+
+    void setToken(const QString& token) { m_token = token.toUtf8(); }
+    void route(const QByteArray& method, const QByteArray& path, Handler handler, TaskGroup* tasks = nullptr);
+
+    bool listen(const QHostAddress& address, quint16 port);
+    void close();
+    quint16 port() const;
+    QString errorString() const;
+
+    static QJsonObject error(const QString& message);
+
+    static constexpr qint64 MAX_REQUEST_BYTES = qint64(256) * 1024 * 1024;
+    static constexpr int MAX_HEADER_BYTES = 16 * 1024;
+
+private:
+    struct Route {
+        QByteArray method;
+        Handler handler;
+        TaskGroup* tasks = nullptr;
+    };
+    struct Parsed {
+        Request request;
+        bool keepAlive = true;
+        bool authorized = false;
+    };
+    struct Connection {
+        QByteArray buffer;
+        bool busy = false;  // A request is with its handler
+    };
+
+    void onNewConnection();
+    void onReadyRead(QTcpSocket* socket);
+    // A complete request at the front of the buffer, removed from it; nullopt if more is needed
+    std::optional<Parsed> takeRequest(QTcpSocket* socket, Connection& connection);
+    void dispatch(QTcpSocket* socket, const Parsed& parsed);
+    void reply(QTcpSocket* socket, int status, const QJsonObject& body, bool keepAlive);
+
+    QString m_name;
+    QTcpServer m_server;
+    QByteArray m_token;
+    QHash<QByteArray, Route> m_routes;  // By path
+    QHash<QTcpSocket*, Connection> m_connections;
+};
+
+} // namespace PhotoGuru
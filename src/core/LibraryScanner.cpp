@@ -0,0 +1,141 @@
+#include "LibraryScanner.h"
+#include "ImageLoader.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QDebug>
+
+namespace PhotoGuru {
+
+LibraryScanner::LibraryScanner(QObject* parent)
+    : QObject(parent)
+{
+    m_tasks.setMaxConcurrency(WALK_THREADS);
+    m_flushTimer.setInterval(FLUSH_INTERVAL_MS);
+    connect(&m_flushTimer, &QTimer::timeout, this, &LibraryScanner::drain);
+}
+
+LibraryScanner::~LibraryScanner() {
+    cancel();
+    wait();
+}
+
+void LibraryScanner::start(const QStringList& roots) {
+    cancel();
+    wait();
+
+    const quint64 generation = ++m_generation;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_buffer.clear();
+        m_visited.clear();
+    }
+    m_found.storeRelaxed(0);
+    m_outstanding.storeRelaxed(0);  // Tasks dropped by cancel() never counted down
+    m_running = true;
+
+    for (const QString& root : roots) {
+        if (QFileInfo(root).isDir()) {
+            enqueue(root, generation);
+        } else {
+            qWarning() << "[LibraryScanner] Not a directory:" << root;
+        }
+    }
+    if (m_outstanding.loadAcquire() == 0) {
+        onWalkDone(generation);
+        return;
+    }
+    m_flushTimer.start();
+}
+
+void LibraryScanner::cancel() {
+    if (!m_running) return;
+    // Queued tasks see the new generation and return at once
+    ++m_generation;
+    m_tasks.clear();
+    m_running = false;
+    m_flushTimer.stop();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_buffer.clear();
+    }
+    emit finished(m_found.loadRelaxed(), true);
+}
+
+void LibraryScanner::wait() {
+    m_tasks.waitForDone();
+}
+
+void LibraryScanner::enqueue(const QString& directory, quint64 generation) {
+    const QString canonical = QFileInfo(directory).canonicalFilePath();
+    {
+        QMutexLocker locker(&m_mutex);
+        if (canonical.isEmpty() || m_visited.contains(canonical)) return;
+        m_visited.insert(canonical);
+    }
+    m_outstanding.fetchAndAddOrdered(1);
+    m_tasks.start([this, directory, generation]() {
+        walk(directory, generation);
+    });
+}
+
+void LibraryScanner::walk(const QString& directory, quint64 generation) {
+    if (generation == m_generation.loadAcquire()) {
+        ImageLoader& loader = ImageLoader::instance();
+        QStringList files;
+        QDir dir(directory);
+
+        // One level; subdirectories are walked by tasks of their own
+        QDirIterator it(directory, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::Readable);
+        while (it.hasNext()) {
+            it.next();
+            const QFileInfo info = it.fileInfo();
+            if (info.isDir()) {
+                if (!info.isSymLink()) enqueue(dir.filePath(info.fileName()), generation);
+            } else if (loader.isSupported(info.fileName())) {
+                files << dir.filePath(info.fileName());
+            }
+            if (generation != m_generation.loadAcquire()) break;
+        }
+
+        if (!files.isEmpty()) {
+            bool full = false;
+            {
+                QMutexLocker locker(&m_mutex);
+                if (generation == m_generation.loadAcquire()) {
+                    m_buffer += files;
+                    full = m_buffer.size() >= CHUNK_SIZE;
+                }
+            }
+            m_found.fetchAndAddRelaxed(files.size());
+            if (full) QMetaObject::invokeMethod(this, &LibraryScanner::drain, Qt::QueuedConnection);
+        }
+    }
+
+    // Last directory of the walk: report the end from the owner's thread
+    if (m_outstanding.fetchAndSubOrdered(1) == 1) {
+        QMetaObject::invokeMethod(this, [this, generation]() {
+            onWalkDone(generation);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void LibraryScanner::drain() {
+    QStringList chunk;
+    {
+        QMutexLocker locker(&m_mutex);
+        chunk.swap(m_buffer);
+    }
+    if (!chunk.isEmpty()) emit filesFound(chunk);
+}
+
+void LibraryScanner::onWalkDone(quint64 generation) {
+    if (generation != m_generation.loadAcquire() || !m_running) return;
+    drain();
+    m_flushTimer.stop();
+    m_running = false;
+    emit finished(m_found.loadRelaxed(), false);
+}
+
+} // namespace PhotoGuru
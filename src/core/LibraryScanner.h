@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QTimer>
+#include "TaskScheduler.h"
+
+namespace PhotoGuru {
+
+/**
+ * @brief Finds the supported images below several roots, in parallel
+ *
+ * Every directory is listed by its own task, WALK_THREADS at most at
+ * once, in the scheduler's Ingest class; subdirectories become new
+ * tasks (kept on the worker that found them, stolen by idle ones), so a wide tree on a slow
+ * network share keeps many listings in flight instead of one. Files are
+ * not collected into one list: they stream out through filesFound() in
+ * chunks, every FLUSH_INTERVAL_MS or CHUNK_SIZE files, in discovery
+ * order. Symlinked directories aren't followed and each directory is
+ * walked once even if roots overlap.
+ *
+ * Signals are emitted on the owner's thread.
+ */
+class LibraryScanner : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LibraryScanner(QObject* parent = nullptr);
+    ~LibraryScanner();
+
+    // Cancels a scan still running
+    void start(const QStringList& roots);
+    void cancel();
+    void wait();  // Until every task has stopped; signals may still be queued
+    bool isRunning() const { return m_running; }
+    int foundCount() const { return m_found.loadRelaxed(); }
+
+    static constexpr int WALK_THREADS = 8;  // Listings block on I/O, not CPU
+    static constexpr int CHUNK_SIZE = 2000;
+    static constexpr int FLUSH_INTERVAL_MS = 100;
+
+signals:
+    void filesFound(const QStringList& paths);
+    void finished(int total, bool cancelled);
+
+private:
+    void walk(const QString& directory, quint64 generation);
+    void enqueue(const QString& directory, quint64 generation);
+    void drain();
+    void onWalkDone(quint64 generation);
+
+    TaskGroup m_tasks{TaskScheduler::Ingest};
+    QTimer m_flushTimer;
+    QMutex m_mutex;           // Guards m_buffer and m_visited
+    QStringList m_buffer;
+    QSet<QString> m_visited;  // Canonical directory paths
+    QAtomicInt m_outstanding{0};  // Directory tasks queued or running
+    QAtomicInt m_found{0};
+    QAtomicInteger<quint64> m_generation{0};
+    bool m_running = false;
+};
+
+} // namespace PhotoGuru
@@ -1,7 +1,10 @@
 #include "Logger.h"
 #include <QStandardPaths>
+#include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
 #include <QMutexLocker>
+#include <cstdio>
 #include <iostream>
 
 namespace PhotoGuru {
@@ -11,52 +14,45 @@ Logger& Logger::instance() {
     return instance;
 }
 
-Logger::Logger() : m_minLevel(DEBUG) {
-    // Create logs directory
+Logger::Logger() : m_queue(QUEUE_CAPACITY) {
     QString logDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir().mkpath(logDir);
-    
-    // Open log file
     QString logPath = logDir + "/photoguru.log";
-    m_logFile.setFileName(logPath);
-    
-    if (m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-        m_stream.setDevice(&m_logFile);
+
+    bool opened = openLogFile(logPath);
+    if (!opened) {
+        std::cerr << "Failed to open log file: " << logPath.toStdString() << std::endl;
+    }
+
+    m_writer = std::thread([this]() { writerLoop(); });
+
+    if (opened) {
         log(INFO, "Logger", "=== PhotoGuru Started ===");
         log(INFO, "Logger", "Log file: " + logPath);
-    } else {
-        std::cerr << "Failed to open log file: " << logPath.toStdString() << std::endl;
     }
 }
 
 Logger::~Logger() {
-    if (m_logFile.isOpen()) {
-        log(INFO, "Logger", "=== PhotoGuru Shutdown ===");
-        m_stream.flush();
-        m_logFile.close();
+    log(INFO, "Logger", "=== PhotoGuru Shutdown ===");
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_stopping = true;
+        m_wake.wakeOne();
     }
+    m_writer.join();  // Drains the queue first
+
+    QMutexLocker locker(&m_mutex);
+    m_logFile.close();
 }
 
 void Logger::log(Level level, const QString& category, const QString& message) {
-    if (level < m_minLevel) return;
-    
-    QMutexLocker locker(&m_mutex);
-    
-    rotateLogIfNeeded();
-    
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss.zzz");
-    QString levelStr = levelToString(level);
-    QString logLine = QString("[%1] [%2] [%3] %4\n")
-        .arg(timestamp)
-        .arg(levelStr)
-        .arg(category)
-        .arg(message);
-    
-    m_stream << logLine;
-    m_stream.flush();
-    
-    // Also print to console for development
-    std::cout << logLine.toStdString();
+    if (!isEnabled(level)) return;
+
+    // Strings are shared, not copied; formatting happens on the writer
+    if (!m_queue.push(Entry{QDateTime::currentMSecsSinceEpoch(), level, category, message})) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    wakeWriter();
 }
 
 void Logger::debug(const QString& category, const QString& message) {
@@ -75,25 +71,135 @@ void Logger::error(const QString& category, const QString& message) {
     log(ERROR, category, message);
 }
 
-void Logger::rotateLogIfNeeded() {
-    if (m_logFile.size() > MAX_LOG_SIZE) {
-        m_stream.flush();
-        m_logFile.close();
-        
-        // Rename old log
-        QString oldPath = m_logFile.fileName();
-        QString backupPath = oldPath + ".old";
-        QFile::remove(backupPath);
-        QFile::rename(oldPath, backupPath);
-        
-        // Open new log
-        m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
-        m_stream.setDevice(&m_logFile);
-        log(INFO, "Logger", "Log rotated (previous log saved as .old)");
+void Logger::wakeWriter() {
+    // Pairs with the fence in writerLoop(): either the writer sees the
+    // new entry before sleeping, or this sees it idle and wakes it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!m_writerIdle.load(std::memory_order_relaxed)) return;
+
+    QMutexLocker locker(&m_wakeMutex);
+    m_wake.wakeOne();
+}
+
+void Logger::flush() {
+    const quint64 target = m_queue.claimed();
+    {
+        QMutexLocker locker(&m_wakeMutex);
+        m_wake.wakeOne();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    while (m_writtenCount < target) {
+        m_written.wait(&m_mutex, FLUSH_INTERVAL_MS);
     }
 }
 
-QString Logger::levelToString(Level level) const {
+bool Logger::setLogFile(const QString& path) {
+    flush();
+    QMutexLocker locker(&m_mutex);
+    m_logFile.close();
+    return openLogFile(path);
+}
+
+QString Logger::logFilePath() const {
+    QMutexLocker locker(&m_mutex);
+    return m_logFile.fileName();
+}
+
+void Logger::writerLoop() {
+    for (;;) {
+        writeBatch();
+
+        QMutexLocker locker(&m_wakeMutex);
+        if (m_stopping) {
+            locker.unlock();
+            writeBatch();  // Whatever raced with shutdown
+            return;
+        }
+        m_writerIdle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_queue.empty()) {
+            m_wake.wait(&m_wakeMutex, FLUSH_INTERVAL_MS);
+        }
+        m_writerIdle.store(false, std::memory_order_relaxed);
+    }
+}
+
+void Logger::writeBatch() {
+    QByteArray batch;
+    auto append = [&batch](qint64 msecs, Level level, const QString& category, const QString& message) {
+        batch += QString("[%1] [%2] [%3] %4\n")
+            .arg(QDateTime::fromMSecsSinceEpoch(msecs).toString("yyyy-MM-dd HH:mm:ss.zzz"))
+            .arg(levelToString(level))
+            .arg(category)
+            .arg(message)
+            .toUtf8();
+    };
+
+    // One write per wakeup, however much has queued up
+    for (int taken = 0; taken < QUEUE_CAPACITY; taken++) {
+        std::optional<Entry> entry = m_queue.pop();
+        if (!entry) break;
+        append(entry->msecs, entry->level, entry->category, entry->message);
+    }
+
+    const quint64 dropped = m_dropped.load(std::memory_order_relaxed);
+
+    QMutexLocker locker(&m_mutex);
+    if (dropped != m_reportedDropped) {
+        append(QDateTime::currentMSecsSinceEpoch(), WARNING, "Logger",
+               QString("%1 messages dropped (log queue full)").arg(dropped - m_reportedDropped));
+        m_reportedDropped = dropped;
+    }
+
+    if (!batch.isEmpty()) {
+        if (m_logFile.isOpen()) {
+            rotateLogIfNeeded(batch);
+            m_logFile.write(batch);
+            m_logFile.flush();
+            m_fileSize += batch.size();
+        }
+
+        // Also print to console for development
+        std::fwrite(batch.constData(), 1, size_t(batch.size()), stdout);
+        std::fflush(stdout);
+    }
+
+    m_writtenCount = m_queue.popped();
+    m_written.wakeAll();
+}
+
+bool Logger::openLogFile(const QString& path) {
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    m_logFile.setFileName(path);
+    if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        m_fileSize = 0;
+        return false;
+    }
+    m_fileSize = m_logFile.size();
+    return true;
+}
+
+void Logger::rotateLogIfNeeded(QByteArray& batch) {
+    if (m_fileSize + batch.size() <= MAX_LOG_SIZE) return;
+
+    m_logFile.close();
+
+    // Rename old log
+    QString oldPath = m_logFile.fileName();
+    QString backupPath = oldPath + ".old";
+    QFile::remove(backupPath);
+    QFile::rename(oldPath, backupPath);
+
+    // Open new log
+    openLogFile(oldPath);
+    batch.prepend(QString("[%1] [%2] [Logger] Log rotated (previous log saved as .old)\n")
+        .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss.zzz"))
+        .arg(levelToString(INFO))
+        .toUtf8());
+}
+
+const char* Logger::levelToString(Level level) {
     switch (level) {
         case DEBUG:   return "DEBUG  ";
         case INFO:    return "INFO   ";
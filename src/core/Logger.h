@@ -1,14 +1,29 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include "MpscQueue.h"
 #include <QString>
 #include <QFile>
-#include <QTextStream>
 #include <QMutex>
-#include <QDateTime>
+#include <QWaitCondition>
+#include <atomic>
+#include <thread>
 
 namespace PhotoGuru {
 
+/**
+ * @brief Application log (photoguru.log in AppDataLocation, also echoed to stdout)
+ *
+ * Callers never touch the file: log() stamps the time, copies the
+ * (implicitly shared) strings into a slot of a lock-free queue and
+ * returns. A writer thread formats what has queued up and writes it in
+ * one batch per wakeup, rotating the file past MAX_LOG_SIZE. If the
+ * queue is full the message is dropped and counted rather than
+ * blocking, and the writer notes how many were lost.
+ *
+ * The LOG_* macros check the level before building the message, so a
+ * disabled LOG_DEBUG costs one relaxed load.
+ */
 class Logger {
 public:
     enum Level {
@@ -17,39 +32,84 @@ public:
         WARNING,
         ERROR
     };
-    
+
     static Logger& instance();
-    
+
+    bool isEnabled(Level level) const { return level >= m_minLevel.load(std::memory_order_relaxed); }
+
     void log(Level level, const QString& category, const QString& message);
     void debug(const QString& category, const QString& message);
     void info(const QString& category, const QString& message);
     void warning(const QString& category, const QString& message);
     void error(const QString& category, const QString& message);
-    
-    QString logFilePath() const { return m_logFile.fileName(); }
-    void setLogLevel(Level level) { m_minLevel = level; }
-    
+
+    // Blocks until everything logged before the call is written
+    void flush();
+
+    // Switches to `path` (flushing first); false if it can't be opened
+    bool setLogFile(const QString& path);
+
+    QString logFilePath() const;
+    void setLogLevel(Level level) { m_minLevel.store(level, std::memory_order_relaxed); }
+
+    // Messages lost to a full queue since startup
+    quint64 droppedMessages() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    static constexpr int QUEUE_CAPACITY = 8192;
+    static constexpr int FLUSH_INTERVAL_MS = 200;  // Writer wakes at least this often
+
 private:
     Logger();
     ~Logger();
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
-    
-    void rotateLogIfNeeded();
-    QString levelToString(Level level) const;
-    
+
+    struct Entry {
+        qint64 msecs = 0;
+        Level level = INFO;
+        QString category;
+        QString message;
+    };
+
+    void writerLoop();
+    void writeBatch();
+    bool openLogFile(const QString& path);
+    void rotateLogIfNeeded(QByteArray& batch);
+    void wakeWriter();
+    static const char* levelToString(Level level);
+
+    MpscQueue<Entry> m_queue;
+    std::atomic<int> m_minLevel{DEBUG};
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<bool> m_writerIdle{false};
+
+    // Callers only take m_wakeMutex, and only while the writer sleeps
+    QMutex m_wakeMutex;
+    QWaitCondition m_wake;
+    bool m_stopping = false;
+
+    // Writer side: m_mutex guards the file and the counters below
+    mutable QMutex m_mutex;
+    QWaitCondition m_written;
     QFile m_logFile;
-    QTextStream m_stream;
-    QMutex m_mutex;
-    Level m_minLevel;
+    qint64 m_fileSize = 0;
+    quint64 m_writtenCount = 0;    // MpscQueue::popped() as of the last write
+    quint64 m_reportedDropped = 0;
+    std::thread m_writer;
+
     static constexpr qint64 MAX_LOG_SIZE = 10 * 1024 * 1024; // 10MB
 };
 
-// Convenience macros
-#define LOG_DEBUG(category, msg) PhotoGuru::Logger::instance().debug(category, msg)
-#define LOG_INFO(category, msg) PhotoGuru::Logger::instance().info(category, msg)
-#define LOG_WARNING(category, msg) PhotoGuru::Logger::instance().warning(category, msg)
-#define LOG_ERROR(category, msg) PhotoGuru::Logger::instance().error(category, msg)
+// Convenience macros: `msg` is only evaluated when the level is enabled
+#define PHOTOGURU_LOG_AT(level, category, msg) \
+    do { \
+        PhotoGuru::Logger& photoGuruLogger = PhotoGuru::Logger::instance(); \
+        if (photoGuruLogger.isEnabled(level)) photoGuruLogger.log(level, category, msg); \
+    } while (0)
+#define LOG_DEBUG(category, msg) PHOTOGURU_LOG_AT(PhotoGuru::Logger::DEBUG, category, msg)
+#define LOG_INFO(category, msg) PHOTOGURU_LOG_AT(PhotoGuru::Logger::INFO, category, msg)
+#define LOG_WARNING(category, msg) PHOTOGURU_LOG_AT(PhotoGuru::Logger::WARNING, category, msg)
+#define LOG_ERROR(category, msg) PHOTOGURU_LOG_AT(PhotoGuru::Logger::ERROR, category, msg)
 
 } // namespace PhotoGuru
 
@@ -0,0 +1,253 @@
+#include "MemoryBudget.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMutexLocker>
+#include <algorithm>
+#include <numeric>
+
+#if defined(Q_OS_MACOS)
+#include <sys/sysctl.h>
+#elif defined(Q_OS_LINUX)
+#include <QFile>
+#endif
+
+namespace PhotoGuru {
+
+namespace {
+
+#if defined(Q_OS_LINUX)
+// What is left of physical memory, as a fraction
+constexpr double WARNING_AVAILABLE = 0.10;
+constexpr double CRITICAL_AVAILABLE = 0.05;
+// PSI: share of the last 10 s some (or all) tasks stalled on memory, in %
+constexpr double WARNING_STALL = 10.0;
+constexpr double CRITICAL_STALL = 5.0;
+
+// /proc/meminfo value of `field`, in bytes; 0 if missing
+qint64 meminfo(const QByteArray& field) {
+    QFile file("/proc/meminfo");
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+    const QByteArray prefix = field + ':';
+    for (const QByteArray& line : file.readAll().split('\n')) {
+        if (!line.startsWith(prefix)) continue;
+        const QList<QByteArray> parts = line.mid(prefix.size()).simplified().split(' ');
+        return parts.value(0).toLongLong() * 1024;  // kB
+    }
+    return 0;
+}
+
+// avg10 of the "some" or "full" line of /proc/pressure/memory; -1 without PSI
+double stall(const QByteArray& kind) {
+    QFile file("/proc/pressure/memory");
+    if (!file.open(QIODevice::ReadOnly)) return -1.0;
+    for (const QByteArray& line : file.readAll().split('\n')) {
+        if (!line.startsWith(kind + ' ')) continue;
+        for (const QByteArray& field : line.split(' ')) {
+            if (field.startsWith("avg10=")) return field.mid(6).toDouble();
+        }
+    }
+    return -1.0;
+}
+#endif
+
+} // namespace
+
+MemoryBudget& MemoryBudget::instance() {
+    static MemoryBudget instance;
+    return instance;
+}
+
+MemoryBudget::MemoryBudget(QObject* parent)
+    : QObject(parent)
+    , m_pollTimer(this)
+{
+    // Caches may register before the window exists; the timer belongs on the GUI thread
+    if (!parent && QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+    connect(&m_pollTimer, &QTimer::timeout, this, [this]() { setPressure(probe()); });
+}
+
+int MemoryBudget::addCache(Cache cache) {
+    int id = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        id = m_nextId++;
+        m_caches.emplace(id, std::move(cache));
+    }
+    apply();  // Every share moves
+    return id;
+}
+
+void MemoryBudget::removeCache(int id) {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_caches.erase(id);
+        m_limits.erase(id);
+    }
+    apply();
+}
+
+void MemoryBudget::setTotal(qint64 bytes) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_total == bytes) return;
+        m_total = bytes;
+    }
+    qDebug() << "[MemoryBudget] Total:" << total() / (1024 * 1024) << "MB";
+    apply();
+}
+
+qint64 MemoryBudget::total() const {
+    QMutexLocker locker(&m_mutex);
+    return m_total > 0 ? m_total : defaultTotal();
+}
+
+void MemoryBudget::setPressure(Pressure pressure) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_pressure == pressure) return;
+        m_pressure = pressure;
+    }
+    qDebug() << "[MemoryBudget] Memory pressure:" << pressureName(pressure);
+    apply();
+    emit pressureChanged(pressure);
+}
+
+MemoryBudget::Pressure MemoryBudget::pressure() const {
+    QMutexLocker locker(&m_mutex);
+    return m_pressure;
+}
+
+void MemoryBudget::startMonitoring(int intervalMs) {
+    setPressure(probe());
+    m_pollTimer.start(intervalMs);
+}
+
+void MemoryBudget::stopMonitoring() {
+    m_pollTimer.stop();
+}
+
+std::vector<MemoryBudget::CacheUsage> MemoryBudget::usage() const {
+    QMutexLocker locker(&m_mutex);
+    std::vector<CacheUsage> result;
+    for (const auto& [id, cache] : m_caches) {
+        const auto limit = m_limits.find(id);
+        result.push_back(CacheUsage{cache.name, cache.usage ? cache.usage() : 0,
+                                    limit != m_limits.end() ? limit->second : 0});
+    }
+    return result;
+}
+
+void MemoryBudget::apply() {
+    std::vector<std::pair<std::function<void(qint64)>, qint64>> caps;
+    {
+        QMutexLocker locker(&m_mutex);
+        std::vector<Cache> caches;
+        std::vector<qint64> usage;
+        for (const auto& [id, cache] : m_caches) {
+            caches.push_back(cache);
+            usage.push_back(cache.usage ? cache.usage() : 0);
+        }
+        const std::vector<qint64> limits =
+            allocate(caches, usage, m_total > 0 ? m_total : defaultTotal(), m_pressure);
+
+        size_t i = 0;
+        for (const auto& [id, cache] : m_caches) {
+            m_limits[id] = limits[i];
+            if (cache.setLimit) caps.emplace_back(cache.setLimit, limits[i]);
+            ++i;
+        }
+    }
+    // Outside the lock: a cache evicting may take its own
+    for (const auto& [setLimit, bytes] : caps) setLimit(bytes);
+}
+
+std::vector<qint64> MemoryBudget::allocate(const std::vector<Cache>& caches, const std::vector<qint64>& usage,
+                                           qint64 total, Pressure pressure) {
+    std::vector<qint64> limits(caches.size(), 0);
+    double shares = 0.0;
+    for (const Cache& cache : caches) shares += std::max(0.0, cache.share);
+    if (shares <= 0.0) return limits;
+    for (size_t i = 0; i < caches.size(); ++i) {
+        limits[i] = qint64(double(total) * std::max(0.0, caches[i].share) / shares);
+    }
+    if (pressure == Pressure::Normal) return limits;
+
+    // Nobody grows; the least important give back until the rest fits
+    qint64 held = 0;
+    for (size_t i = 0; i < caches.size(); ++i) {
+        limits[i] = std::min(limits[i], i < usage.size() ? std::max<qint64>(0, usage[i]) : 0);
+        held += limits[i];
+    }
+    const double fraction = pressure == Pressure::Critical ? CRITICAL_FRACTION : WARNING_FRACTION;
+    qint64 excess = held - qint64(double(total) * fraction);
+
+    std::vector<size_t> order(caches.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(),
+                     [&caches](size_t a, size_t b) { return caches[a].priority < caches[b].priority; });
+    for (size_t i : order) {
+        if (excess <= 0) break;
+        const qint64 cut = std::min(excess, limits[i]);
+        limits[i] -= cut;
+        excess -= cut;
+    }
+    return limits;
+}
+
+MemoryBudget::Pressure MemoryBudget::probe() {
+    Pressure pressure = Pressure::Normal;
+
+#if defined(Q_OS_MACOS)
+    // 1 normal, 2 warning, 4 critical, as the kernel's memory status reports it
+    int level = 0;
+    size_t size = sizeof(level);
+    if (sysctlbyname("kern.memorystatus_vm_pressure_level", &level, &size, nullptr, 0) == 0) {
+        if (level >= 4) pressure = Pressure::Critical;
+        else if (level >= 2) pressure = Pressure::Warning;
+    }
+#elif defined(Q_OS_LINUX)
+    const qint64 physical = meminfo("MemTotal");
+    const qint64 available = meminfo("MemAvailable");
+    if (physical > 0 && available > 0) {
+        const double free = double(available) / double(physical);
+        if (free < CRITICAL_AVAILABLE) pressure = Pressure::Critical;
+        else if (free < WARNING_AVAILABLE) pressure = Pressure::Warning;
+    }
+    if (stall("full") >= CRITICAL_STALL) pressure = Pressure::Critical;
+    else if (pressure == Pressure::Normal && stall("some") >= WARNING_STALL) pressure = Pressure::Warning;
+#endif
+
+    return pressure;
+}
+
+qint64 MemoryBudget::physicalMemory() {
+#if defined(Q_OS_MACOS)
+    qint64 bytes = 0;
+    size_t size = sizeof(bytes);
+    if (sysctlbyname("hw.memsize", &bytes, &size, nullptr, 0) == 0) return bytes;
+    return 0;
+#elif defined(Q_OS_LINUX)
+    return meminfo("MemTotal");
+#else
+    return 0;
+#endif
+}
+
+qint64 MemoryBudget::defaultTotal() {
+    static const qint64 physical = physicalMemory();
+    if (physical <= 0) return FALLBACK_TOTAL;
+    return std::clamp(physical / 4, MIN_TOTAL, MAX_TOTAL);
+}
+
+QString MemoryBudget::pressureName(Pressure pressure) {
+    switch (pressure) {
+        case Pressure::Normal:   return "normal";
+        case Pressure::Warning:  return "warning";
+        case Pressure::Critical: return "critical";
+    }
+    return "normal";
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <QObject>
+#include <QMutex>
+#include <QString>
+#include <QTimer>
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief One memory budget for the in-memory caches, shrunk under pressure
+ *
+ * Each cache already caps itself in bytes; on their own the caps add up
+ * to whatever each default happens to be. Caches register here with a
+ * share and a priority instead, and the budget sets their caps:
+ *   - normally, the total split by share;
+ *   - under memory pressure, a fraction of the total (WARNING_FRACTION,
+ *     CRITICAL_FRACTION). No cache may grow past what it holds, and the
+ *     lowest priority caches give back memory first, down to nothing
+ *     if the pressure calls for it.
+ * Caps go back up once the pressure is over, and the caches refill as
+ * they are used.
+ *
+ * The total is the user's preference, or defaultTotal(): a quarter of
+ * physical memory, within MIN_TOTAL..MAX_TOTAL. Pressure is polled every
+ * POLL_INTERVAL_MS once startMonitoring() is called (Linux
+ * /proc/meminfo and PSI, macOS kern.memorystatus_vm_pressure_level).
+ *
+ * Caps are set from the budget's thread (the GUI thread), so register
+ * only caches safe to resize from there. Models are not a cache:
+ * ModelRegistry keeps its own budget; pressureChanged() lets the owner
+ * unload idle ones.
+ */
+class MemoryBudget : public QObject {
+    Q_OBJECT
+
+public:
+    enum class Pressure { Normal, Warning, Critical };
+
+    struct Cache {
+        QString name;
+        double share = 1.0;  // Of the total, relative to the other caches
+        int priority = 0;    // Under pressure, lower priorities give memory back first
+        std::function<qint64()> usage;               // Bytes held now
+        std::function<void(qint64 bytes)> setLimit;  // A lower cap evicts right away
+    };
+
+    struct CacheUsage {
+        QString name;
+        qint64 bytes = 0;
+        qint64 limit = 0;
+    };
+
+    static MemoryBudget& instance();
+
+    explicit MemoryBudget(QObject* parent = nullptr);
+
+    // Sets the cache's cap right away; the id removes it again
+    int addCache(Cache cache);
+    void removeCache(int id);
+
+    // 0 = defaultTotal()
+    void setTotal(qint64 bytes);
+    qint64 total() const;
+
+    void setPressure(Pressure pressure);
+    Pressure pressure() const;
+    static Pressure probe();  // The machine's state now; Normal where unknown
+
+    void startMonitoring(int intervalMs = POLL_INTERVAL_MS);
+    void stopMonitoring();
+
+    std::vector<CacheUsage> usage() const;
+
+    /**
+     * @brief Cap of each cache, in order
+     *
+     * `usage` holds each cache's bytes now. Normal pressure splits `total`
+     * by share; otherwise caps hold what each cache has, cut from the
+     * lowest priority up until they add up to the fraction of `total`
+     * the pressure allows (equal priorities: in order).
+     */
+    static std::vector<qint64> allocate(const std::vector<Cache>& caches, const std::vector<qint64>& usage,
+                                        qint64 total, Pressure pressure);
+
+    static qint64 physicalMemory();  // 0 where unknown
+    static qint64 defaultTotal();
+    static QString pressureName(Pressure pressure);
+
+    static constexpr qint64 MIN_TOTAL = qint64(256) * 1024 * 1024;
+    static constexpr qint64 MAX_TOTAL = qint64(16) * 1024 * 1024 * 1024;
+    static constexpr qint64 FALLBACK_TOTAL = qint64(1024) * 1024 * 1024;  // Physical memory unknown
+    static constexpr double WARNING_FRACTION = 0.5;
+    static constexpr double CRITICAL_FRACTION = 0.125;
+    static constexpr int POLL_INTERVAL_MS = 2000;
+
+signals:
+    void pressureChanged(MemoryBudget::Pressure pressure);
+
+private:
+    void apply();
+
+    mutable QMutex m_mutex;  // Guards the members below
+    std::map<int, Cache> m_caches;  // By id: registration order
+    std::map<int, qint64> m_limits;
+    int m_nextId = 1;
+    qint64 m_total = 0;  // 0 = default
+    Pressure m_pressure = Pressure::Normal;
+
+    QTimer m_pollTimer;
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,388 @@
+#include "MetadataIndex.h"
+#include "TextIndex.h"
+#include <QHash>
+#include <QSet>
+#include <QAtomicInteger>
+#include <limits>
+#include <vector>
+
+namespace PhotoGuru {
+
+namespace {
+
+enum RowFlag : quint8 {
+    HasFaces    = 1 << 0,
+    BestInBurst = 1 << 1,
+    Duplicate   = 1 << 2,
+    Blurry      = 1 << 3,
+    HasGPS      = 1 << 4
+};
+
+// Invalid dates sort before everything, matching QDateTime's ordering
+constexpr qint64 INVALID_DATE = std::numeric_limits<qint64>::min();
+
+struct StringPool {
+    QHash<QString, quint32> ids;
+    QStringList values;
+
+    quint32 intern(const QString& value) {
+        auto it = ids.constFind(value);
+        if (it != ids.constEnd()) {
+            return it.value();
+        }
+        quint32 id = quint32(values.size());
+        values.append(value);
+        ids.insert(value, id);
+        return id;
+    }
+};
+
+// Original-case text (TextIndex slots) for case-sensitive checks, plus
+// pre-lowercased keywords for the keyword filter
+struct SearchText {
+    QStringList fields;
+    QStringList lowerKeywords;
+};
+
+bool containsAll(const QString& text, const QStringList& terms) {
+    if (text.isEmpty()) return false;
+    for (const QString& term : terms) {
+        if (!text.contains(term)) return false;
+    }
+    return true;
+}
+
+// Process-wide so a cleared index never reuses an earlier revision
+quint64 nextRevision() {
+    static QAtomicInteger<quint64> counter;
+    return counter.fetchAndAddRelaxed(1) + 1;
+}
+
+} // namespace
+
+struct MetadataIndex::Data : public QSharedData {
+    quint64 revision = nextRevision();
+    QHash<QString, int> rowForPath;
+
+    // One entry per row in every column
+    std::vector<double> quality;
+    std::vector<double> sharpness;
+    std::vector<double> aesthetic;
+    std::vector<double> aperture;
+    std::vector<double> focalLength;
+    std::vector<int> rating;
+    std::vector<int> iso;
+    std::vector<qint64> date;
+    std::vector<double> lat;
+    std::vector<double> lon;
+    std::vector<quint8> flags;
+    std::vector<quint32> camera;
+    std::vector<quint32> category;
+    std::vector<quint32> scene;
+    std::vector<SearchText> text;
+    TextIndex textIndex;
+
+    StringPool cameras;      // "make model", as FilterCriteria matches it
+    StringPool categories;
+    StringPool scenes;
+
+    void setRow(int row, const PhotoMetadata& meta);
+};
+
+void MetadataIndex::Data::setRow(int row, const PhotoMetadata& meta) {
+    quality[row] = meta.technical.overall_quality;
+    sharpness[row] = meta.technical.sharpness_score;
+    aesthetic[row] = meta.technical.aesthetic_score;
+    aperture[row] = meta.aperture;
+    focalLength[row] = meta.focal_length;
+    rating[row] = meta.rating;
+    iso[row] = meta.iso;
+    date[row] = meta.datetime_original.isValid()
+        ? meta.datetime_original.toMSecsSinceEpoch() : INVALID_DATE;
+    lat[row] = meta.gps_lat;
+    lon[row] = meta.gps_lon;
+
+    quint8 f = 0;
+    if (meta.face_count != 0) f |= HasFaces;
+    if (meta.technical.is_best_in_burst) f |= BestInBurst;
+    if (!meta.technical.duplicate_group.isEmpty()) f |= Duplicate;
+    if (meta.technical.blur_detected) f |= Blurry;
+    if (meta.gps_lat != 0.0 && meta.gps_lon != 0.0) f |= HasGPS;
+    flags[row] = f;
+
+    QString cameraInfo = meta.camera_make + " " + meta.camera_model;
+    camera[row] = cameras.intern(cameraInfo);
+    category[row] = categories.intern(meta.llm_category);
+    scene[row] = scenes.intern(meta.llm_scene);
+
+    SearchText& t = text[row];
+    t.fields = TextIndex::documentFields(meta);
+    t.lowerKeywords.clear();
+    for (const QString& kw : meta.llm_keywords) {
+        t.lowerKeywords << kw.toLower();
+    }
+    textIndex.setDocument(row, t.fields);
+}
+
+MetadataIndex::MetadataIndex()
+    : d(new Data)
+{
+}
+
+MetadataIndex::MetadataIndex(const MetadataIndex& other) = default;
+MetadataIndex& MetadataIndex::operator=(const MetadataIndex& other) = default;
+MetadataIndex::~MetadataIndex() = default;
+
+void MetadataIndex::clear() {
+    d.reset(new Data);
+}
+
+void MetadataIndex::reserve(int rows) {
+    d->rowForPath.reserve(rows);
+    d->quality.reserve(rows);
+    d->sharpness.reserve(rows);
+    d->aesthetic.reserve(rows);
+    d->aperture.reserve(rows);
+    d->focalLength.reserve(rows);
+    d->rating.reserve(rows);
+    d->iso.reserve(rows);
+    d->date.reserve(rows);
+    d->lat.reserve(rows);
+    d->lon.reserve(rows);
+    d->flags.reserve(rows);
+    d->camera.reserve(rows);
+    d->category.reserve(rows);
+    d->scene.reserve(rows);
+    d->text.reserve(rows);
+}
+
+void MetadataIndex::upsert(const PhotoMetadata& meta) {
+    d->revision = nextRevision();
+
+    auto it = d->rowForPath.constFind(meta.filepath);
+    if (it != d->rowForPath.constEnd()) {
+        d->setRow(it.value(), meta);
+        return;
+    }
+
+    int row = int(d->quality.size());
+    d->rowForPath.insert(meta.filepath, row);
+
+    size_t rows = size_t(row) + 1;
+    d->quality.resize(rows);
+    d->sharpness.resize(rows);
+    d->aesthetic.resize(rows);
+    d->aperture.resize(rows);
+    d->focalLength.resize(rows);
+    d->rating.resize(rows);
+    d->iso.resize(rows);
+    d->date.resize(rows);
+    d->lat.resize(rows);
+    d->lon.resize(rows);
+    d->flags.resize(rows);
+    d->camera.resize(rows);
+    d->category.resize(rows);
+    d->scene.resize(rows);
+    d->text.resize(rows);
+
+    d->setRow(row, meta);
+}
+
+int MetadataIndex::size() const {
+    return int(d->quality.size());
+}
+
+bool MetadataIndex::contains(const QString& filepath) const {
+    return d->rowForPath.contains(filepath);
+}
+
+quint64 MetadataIndex::revision() const {
+    return d->revision;
+}
+
+QStringList MetadataIndex::filter(const FilterCriteria& criteria, const QStringList& candidates) const {
+    const Data& data = *d;
+    const int rows = int(data.quality.size());
+
+    // Per-query work: evaluate string filters once per distinct value
+    std::vector<char> cameraOk;
+    if (!criteria.cameras.isEmpty()) {
+        cameraOk.resize(data.cameras.values.size(), 0);
+        for (int id = 0; id < data.cameras.values.size(); ++id) {
+            for (const QString& cam : criteria.cameras) {
+                if (data.cameras.values[id].contains(cam, Qt::CaseInsensitive)) {
+                    cameraOk[id] = 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<char> categoryOk;
+    if (!criteria.categories.isEmpty()) {
+        categoryOk.resize(data.categories.values.size(), 0);
+        for (int id = 0; id < data.categories.values.size(); ++id) {
+            categoryOk[id] = criteria.categories.contains(data.categories.values[id]);
+        }
+    }
+
+    std::vector<char> sceneOk;
+    if (!criteria.scenes.isEmpty()) {
+        sceneOk.resize(data.scenes.values.size(), 0);
+        for (int id = 0; id < data.scenes.values.size(); ++id) {
+            sceneOk[id] = criteria.scenes.contains(data.scenes.values[id]);
+        }
+    }
+
+    QStringList filterKeywords;
+    for (const QString& kw : criteria.keywords) {
+        filterKeywords << kw.toLower();
+    }
+
+    // Text search resolves through the inverted index up front; the scan
+    // below only tests a bit per row
+    std::vector<char> textOk;
+    QStringList terms = criteria.searchText.split(' ', Qt::SkipEmptyParts);
+    if (!terms.isEmpty()) {
+        QStringList lowerTerms;
+        for (const QString& term : terms) {
+            lowerTerms << term.toLower();
+        }
+
+        textOk.resize(size_t(rows), 0);
+        for (quint64 key : data.textIndex.findAll(lowerTerms)) {
+            int row = TextIndex::rowOf(key);
+            // Index is case-insensitive; a case-sensitive search re-checks the hit
+            if (criteria.searchCaseSensitive &&
+                !containsAll(data.text[row].fields.value(TextIndex::slotOf(key)), terms)) {
+                continue;
+            }
+            textOk[row] = 1;
+        }
+    }
+
+    const qint64 startMs = criteria.startDate.isValid()
+        ? criteria.startDate.toMSecsSinceEpoch() : INVALID_DATE;
+    const qint64 endMs = criteria.endDate.isValid()
+        ? criteria.endDate.toMSecsSinceEpoch() : std::numeric_limits<qint64>::max();
+
+    // A circle is tested against its bounding box first, so the distance
+    // is only computed for rows near it
+    const bool geo = criteria.geoBox || criteria.geoRadius;
+    const GeoBox radiusBox = criteria.geoRadius ? criteria.geoRadius->boundingBox() : GeoBox();
+
+    quint8 requiredFlags = 0;
+    if (criteria.onlyWithFaces) requiredFlags |= HasFaces;
+    if (criteria.onlyBestInBurst) requiredFlags |= BestInBurst;
+    if (criteria.onlyWithGPS || geo) requiredFlags |= HasGPS;
+    quint8 rejectedFlags = 0;
+    if (criteria.excludeDuplicates) rejectedFlags |= Duplicate;
+    if (criteria.excludeBlurry) rejectedFlags |= Blurry;
+
+    // Cheap numeric columns first; text only for rows that survive
+    std::vector<char> hit(size_t(rows), 0);
+    for (int row = 0; row < rows; ++row) {
+        if (data.quality[row] < criteria.minQuality) continue;
+        if (data.sharpness[row] < criteria.minSharpness) continue;
+        if (data.aesthetic[row] < criteria.minAesthetic) continue;
+
+        int rating = data.rating[row];
+        if (rating < criteria.minRating || rating > criteria.maxRating) continue;
+
+        quint8 f = data.flags[row];
+        if ((f & requiredFlags) != requiredFlags || (f & rejectedFlags)) continue;
+
+        if (geo) {
+            const double lat = data.lat[row];
+            const double lon = data.lon[row];
+            if (criteria.geoBox && !criteria.geoBox->contains(lat, lon)) continue;
+            if (criteria.geoRadius && (!radiusBox.contains(lat, lon) ||
+                                       !criteria.geoRadius->contains(lat, lon))) continue;
+        }
+
+        int iso = data.iso[row];
+        if (iso > 0 && (iso < criteria.minISO || iso > criteria.maxISO)) continue;
+
+        double aperture = data.aperture[row];
+        if (aperture > 0.0 && (aperture < criteria.minAperture || aperture > criteria.maxAperture)) continue;
+
+        double focal = data.focalLength[row];
+        if (focal > 0.0 && (focal < criteria.minFocalLength || focal > criteria.maxFocalLength)) continue;
+
+        qint64 date = data.date[row];
+        if (criteria.startDate.isValid() && date < startMs) continue;
+        if (criteria.endDate.isValid() && date > endMs) continue;
+
+        if (!cameraOk.empty() && !cameraOk[data.camera[row]]) continue;
+        if (!categoryOk.empty() && !categoryOk[data.category[row]]) continue;
+        if (!sceneOk.empty() && !sceneOk[data.scene[row]]) continue;
+
+        if (!filterKeywords.isEmpty()) {
+            bool found = false;
+            for (const QString& photoKw : data.text[row].lowerKeywords) {
+                for (const QString& filterKw : filterKeywords) {
+                    if (photoKw.contains(filterKw)) {
+                        found = true;
+                        break;
+                    }
+                }
+                if (found) break;
+            }
+            if (!found) continue;
+        }
+
+        if (!textOk.empty() && !textOk[row]) continue;
+
+        hit[row] = 1;
+    }
+
+    QStringList result;
+    for (const QString& path : candidates) {
+        auto it = data.rowForPath.constFind(path);
+        if (it != data.rowForPath.constEnd() && hit[it.value()]) {
+            result << path;
+        }
+    }
+    return result;
+}
+
+QStringList MetadataIndex::refilter(const FilterCriteria& criteria, const QStringList& candidates,
+                                   const FilterCriteria& previousCriteria,
+                                   const QStringList& previous) const {
+    bool narrower = criteria.isNarrowerThan(previousCriteria);
+    bool wider = previousCriteria.isNarrowerThan(criteria);
+
+    if (narrower && wider) {
+        return previous;  // Equivalent criteria
+    }
+
+    if (narrower) {
+        // Subset of the previous result, already in candidate order
+        return filter(criteria, previous);
+    }
+
+    if (wider) {
+        // Superset: everything previous still matches, only check the rest
+        QSet<QString> kept(previous.cbegin(), previous.cend());
+        QStringList rest;
+        rest.reserve(candidates.size() - previous.size());
+        for (const QString& path : candidates) {
+            if (!kept.contains(path)) rest << path;
+        }
+
+        QStringList added = filter(criteria, rest);
+        if (added.isEmpty()) return previous;
+
+        kept.unite(QSet<QString>(added.cbegin(), added.cend()));
+        QStringList result;
+        result.reserve(kept.size());
+        for (const QString& path : candidates) {
+            if (kept.contains(path)) result << path;
+        }
+        return result;
+    }
+
+    return filter(criteria, candidates);
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QSharedDataPointer>
+#include "PhotoMetadata.h"
+#include "FilterCriteria.h"
+
+namespace PhotoGuru {
+
+/**
+ * @brief Columnar (struct-of-arrays) view of the loaded metadata for filtering
+ *
+ * Every FilterCriteria field maps to a flat column: numbers stay numbers,
+ * camera/category/scene strings are interned to IDs (so a camera filter is
+ * evaluated once per distinct camera, not once per photo), and search text
+ * goes into a TextIndex so a query only touches fields that contain it.
+ * A geo region is a box test on the lat/lon columns; a radius only
+ * computes distances for rows inside its bounding box.
+ *
+ * filter() gives the same answer as calling FilterCriteria::matches on each
+ * photo. Copies are implicitly shared, so handing a snapshot to a worker
+ * thread is O(1) and later upserts detach.
+ */
+class MetadataIndex {
+public:
+    MetadataIndex();
+    MetadataIndex(const MetadataIndex& other);
+    MetadataIndex& operator=(const MetadataIndex& other);
+    ~MetadataIndex();
+
+    void clear();
+    void reserve(int rows);
+
+    // Insert, or replace the row for meta.filepath
+    void upsert(const PhotoMetadata& meta);
+
+    int size() const;
+    bool contains(const QString& filepath) const;
+
+    // Changes on every upsert/clear; a cached filter result is only valid
+    // for the revision it was computed on
+    quint64 revision() const;
+
+    // Candidates that are indexed and match, in candidate order
+    QStringList filter(const FilterCriteria& criteria, const QStringList& candidates) const;
+
+    // Same answer as filter(criteria, candidates), given `previous` =
+    // filter(previousCriteria, candidates) at this revision. A narrowing
+    // change only re-checks `previous`, a widening one only the rest.
+    QStringList refilter(const FilterCriteria& criteria, const QStringList& candidates,
+                         const FilterCriteria& previousCriteria, const QStringList& previous) const;
+
+private:
+    struct Data;
+    QSharedDataPointer<Data> d;
+};
+
+} // namespace PhotoGuru
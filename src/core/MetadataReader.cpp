@@ -1,11 +1,15 @@
 #include "PhotoMetadata.h"
 #include "ExifToolDaemon.h"
-#include <QProcess>
+#include "ExifFastReader.h"
+#include "ImageLoader.h"
+#include "Trace.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QDebug>
 #include <QFileInfo>
+#include <QHash>
+#include <QDebug>
+#include <utility>
 
 namespace PhotoGuru {
 
@@ -14,12 +18,93 @@ MetadataReader& MetadataReader::instance() {
     return reader;
 }
 
-std::optional<PhotoMetadata> MetadataReader::read(const QString& filePath) {
-    qDebug() << "MetadataReader::read called for:" << filePath;
+QStringList MetadataReader::tagArguments(int fields) {
+    // -n: numeric values (GPS in signed decimal degrees, shutter speed in seconds)
+    QStringList args = {"-json", "-s", "-n"};
+    if ((fields & AllTags) == AllTags) {
+        args << "-a";
+        return args;
+    }
+    
+    args << "-FileName";
+    if (fields & Capture) {
+        args << "-DateTimeOriginal" << "-SubSecTimeOriginal" << "-SequenceNumber" << "-BurstUUID";
+    }
+    if (fields & Camera) {
+        args << "-Make" << "-Model" << "-FNumber" << "-ShutterSpeedValue" << "-ISO" << "-FocalLength";
+    }
+    if (fields & Gps) {
+        // The composite tags carry the hemisphere's sign
+        args << "-Composite:GPSLatitude" << "-Composite:GPSLongitude";
+    }
+    if (fields & Rating) {
+        args << "-Rating";
+    }
+    if (fields & Descriptive) {
+        args << "-Title" << "-Description" << "-Subject" << "-Category" << "-LocationShown";
+    }
+    if (fields & Location) {
+        args << "-City" << "-Province-State" << "-Country-PrimaryLocationName";
+    }
+    if (fields & Technical) {
+        args << "-UserComment";
+    }
+    return args;
+}
+
+namespace {
+
+using FileVersion = std::pair<qint64, qint64>;  // mtime (ms), size
+
+// Taken before the read: a write during it then shows as a newer version
+FileVersion fileVersion(const QString& path) {
+    const QFileInfo info(path);
+    if (!info.exists()) return {-1, -1};
+    return {info.lastModified().toMSecsSinceEpoch(), info.size()};
+}
+
+void stampVersion(PhotoMetadata& meta, const FileVersion& version) {
+    meta.file_mtime = version.first;
+    meta.file_size = version.second;
+}
+
+} // namespace
+
+QString MetadataReader::sidecarPath(const QString& filePath) {
+    // A RAW's JPEG twin has a sidecar of its own, never the RAW's
+    QFileInfo info(filePath);
+    if (ImageLoader::instance().detectFormat(filePath) != ImageFormat::RAW) {
+        return filePath + ".xmp";
+    }
+    return info.path() + '/' + info.completeBaseName() + ".xmp";
+}
+
+QJsonObject MetadataReader::mergeSidecar(QJsonObject image, const QJsonObject& sidecar) {
+    // XMP names of the IPTC location fields the parser reads
+    static const QHash<QString, QString> renamed = {
+        {"State", "Province-State"},
+        {"Country", "Country-PrimaryLocationName"},
+    };
+    for (auto it = sidecar.constBegin(); it != sidecar.constEnd(); ++it) {
+        const QString& key = it.key();
+        if (key == "SourceFile" || key.startsWith("File")) continue;  // About the .xmp itself
+        image.insert(renamed.value(key, key), it.value());
+    }
+    return image;
+}
+
+std::optional<PhotoMetadata> MetadataReader::read(const QString& filePath, int fields) {
+    const QString sidecar = sidecarPath(filePath);
+    if (QFileInfo::exists(sidecar)) {
+        std::vector<PhotoMetadata> read = readMany({filePath}, fields);
+        if (read.empty()) return std::nullopt;
+        return std::move(read.front());
+    }
     
     // Use ExifToolDaemon (stay-open mode) for 5x speedup
-    // -n flag: return numeric values for GPS coordinates
-    QStringList args = {"-json", "-a", "-s", "-n", filePath};
+    const FileVersion version = fileVersion(filePath);
+    QStringList args = tagArguments(fields);
+    args << filePath;
     QString output = ExifToolDaemon::instance().executeCommand(args);
     
     if (output.isEmpty()) {
@@ -27,90 +112,132 @@ std::optional<PhotoMetadata> MetadataReader::read(const QString& filePath) {
         return std::nullopt;
     }
     
-    return parseExifToolOutput(output);
-}
-
-bool MetadataReader::hasPhotoGuruData(const QString& filePath) {
-    QStringList args = {"-XMP:CreatorTool", filePath};
-    QString output = runExifTool(filePath, args);
-    return output.contains("PhotoGuru");
+    PhotoMetadata meta = parseExifToolOutput(output, fields);
+    stampVersion(meta, version);
+    return meta;
 }
 
-std::optional<TechnicalMetadata> MetadataReader::readTechnicalOnly(const QString& filePath) {
-    QStringList args = {"-EXIF:UserComment", filePath};
-    QString output = runExifTool(filePath, args);
+std::vector<PhotoMetadata> MetadataReader::readMany(const QStringList& filePaths, int fields) {
+    std::vector<PhotoMetadata> results;
+    results.reserve(filePaths.size());
     
-    if (output.isEmpty()) {
-        return std::nullopt;
+    for (int start = 0; start < filePaths.size(); start += READ_MANY_CHUNK_SIZE) {
+        readChunk(filePaths.mid(start, READ_MANY_CHUNK_SIZE), fields, results);
     }
     
-    return parseTechnicalData(output);
+    return results;
 }
 
-QString MetadataReader::runExifTool(const QString& filePath, const QStringList& args) {
-    QProcess process;
+void MetadataReader::readChunk(const QStringList& chunk, int fields, std::vector<PhotoMetadata>& results) {
+    // One -execute per chunk: exiftool returns a single JSON array
+    // with one object per readable file, sidecars included
+    QHash<QString, QString> sidecars;  // Sidecar -> its image
+    QHash<QString, FileVersion> versions;
+    for (const QString& path : chunk) {
+        const QString sidecar = sidecarPath(path);
+        if (QFileInfo::exists(sidecar)) sidecars.insert(sidecar, path);
+        versions.insert(path, fileVersion(path));
+    }
+    QStringList args = tagArguments(fields);
+    args << chunk << sidecars.keys();
+    
+    bool timedOut = false;
+    QString output = ExifToolDaemon::instance().executeCommand(args, &timedOut);
+    if (timedOut && chunk.size() > 1) {
+        // A file that hangs exiftool ends up alone; the rest still get read
+        qWarning() << "ExifTool timed out on" << chunk.size() << "files, retrying in halves";
+        const int half = int(chunk.size()) / 2;
+        readChunk(chunk.mid(0, half), fields, results);
+        readChunk(chunk.mid(half), fields, results);
+        return;
+    }
+    if (output.isEmpty()) {
+        qWarning() << "No metadata output for chunk starting at:" << chunk.first();
+        return;
+    }
     
-    // Use full path to exiftool since GUI apps don't inherit shell PATH
-    QString exifToolPath = "/opt/homebrew/bin/exiftool";
-    QFileInfo exifToolInfo(exifToolPath);
+    QJsonDocument doc = QJsonDocument::fromJson(output.toUtf8());
+    if (!doc.isArray()) {
+        qWarning() << "ExifTool batch output is not a valid JSON array";
+        return;
+    }
     
-    if (!exifToolInfo.exists()) {
-        // Fallback to searching in common locations
-        QStringList locations = {
-            "/opt/homebrew/bin/exiftool",
-            "/usr/local/bin/exiftool",
-            "/usr/bin/exiftool",
-            "exiftool"  // Try PATH as last resort
-        };
-        
-        exifToolPath = "exiftool";  // Default
-        for (const QString& loc : locations) {
-            if (QFileInfo(loc).exists()) {
-                exifToolPath = loc;
-                break;
-            }
+    const QJsonArray entries = doc.array();
+    QHash<QString, QJsonObject> sidecarTags;  // Image -> its sidecar's object
+    for (const QJsonValue& entry : entries) {
+        const QJsonObject object = entry.toObject();
+        auto image = sidecars.constFind(object["SourceFile"].toString());
+        if (image != sidecars.cend()) sidecarTags.insert(image.value(), object);
+    }
+    for (const QJsonValue& entry : entries) {
+        const QJsonObject object = entry.toObject();
+        const QString source = object["SourceFile"].toString();
+        if (sidecars.contains(source)) continue;
+        auto tags = sidecarTags.constFind(source);
+        results.push_back(parseExifToolObject(
+            tags == sidecarTags.cend() ? object : mergeSidecar(object, tags.value()), fields));
+        stampVersion(results.back(), versions.value(source, FileVersion{-1, -1}));
+    }
+}
+
+std::vector<PhotoMetadata> MetadataReader::readCommon(const QStringList& filePaths) {
+    std::vector<PhotoMetadata> results;
+    results.reserve(filePaths.size());
+    
+    QStringList fallback;
+    for (const QString& path : filePaths) {
+        // The fast reader knows nothing of sidecars
+        const FileVersion version = fileVersion(path);
+        if (QFileInfo::exists(sidecarPath(path))) {
+            fallback << path;
+        } else if (std::optional<PhotoMetadata> meta = ExifFastReader::read(path)) {
+            TRACE_COUNT("metadata.fast.hit", 1);
+            stampVersion(*meta, version);
+            results.push_back(std::move(*meta));
+        } else {
+            TRACE_COUNT("metadata.fast.miss", 1);
+            fallback << path;
         }
     }
     
-    // Debug: print the command being executed
-    qDebug() << "Running" << exifToolPath << "with args:" << args;
-    
-    process.start(exifToolPath, args);
-    
-    if (!process.waitForStarted(1000)) {
-        qWarning() << "ExifTool failed to start at:" << exifToolPath;
-        return QString();
+    if (!fallback.isEmpty()) {
+        std::vector<PhotoMetadata> read = readMany(fallback, FilterSet);
+        results.insert(results.end(), std::make_move_iterator(read.begin()),
+                       std::make_move_iterator(read.end()));
     }
-    
-    if (!process.waitForFinished(10000)) {
-        qWarning() << "ExifTool timeout for file:" << filePath;
-        process.kill();
-        return QString();
+    return results;
+}
+
+bool MetadataReader::hasPhotoGuruData(const QString& filePath) {
+    // -s3: the bare value
+    QStringList args = {"-s3", "-XMP:CreatorTool", filePath};
+    const QString sidecar = sidecarPath(filePath);
+    if (QFileInfo::exists(sidecar)) args << sidecar;
+    QString output = ExifToolDaemon::instance().executeCommand(args);
+    return output.contains("PhotoGuru");
+}
+
+std::optional<TechnicalMetadata> MetadataReader::readTechnicalOnly(const QString& filePath) {
+    // Sidecars keep it in XMP-exif:UserComment
+    const QString sidecar = sidecarPath(filePath);
+    QString output;
+    if (QFileInfo::exists(sidecar)) {
+        output = ExifToolDaemon::instance().executeCommand({"-s3", "-UserComment", sidecar});
     }
-    
-    QString stdErr = QString::fromUtf8(process.readAllStandardError());
-    QString stdOut = QString::fromUtf8(process.readAllStandardOutput());
-    
-    if (process.exitCode() != 0) {
-        qWarning() << "ExifTool error for" << filePath << ":" << stdErr;
-        return QString();
+    if (output.trimmed().isEmpty()) {
+        output = ExifToolDaemon::instance().executeCommand({"-s3", "-EXIF:UserComment", filePath});
     }
     
-    // Debug: show what we got
-    if (stdOut.isEmpty()) {
-        qWarning() << "ExifTool returned empty output for:" << filePath;
-    } else {
-        qDebug() << "ExifTool output length:" << stdOut.length() << "bytes";
+    if (output.trimmed().isEmpty()) {
+        return std::nullopt;
     }
     
-    return stdOut;
+    return parseTechnicalData(output);
 }
 
-PhotoMetadata MetadataReader::parseExifToolOutput(const QString& output) {
+PhotoMetadata MetadataReader::parseExifToolOutput(const QString& output, int fields) {
     PhotoMetadata meta;
     
-    qDebug() << "Parsing exiftool output...";
-    
     QJsonDocument doc = QJsonDocument::fromJson(output.toUtf8());
     if (!doc.isArray() || doc.array().isEmpty()) {
         qWarning() << "ExifTool output is not a valid JSON array";
@@ -118,74 +245,95 @@ PhotoMetadata MetadataReader::parseExifToolOutput(const QString& output) {
         return meta;
     }
     
-    QJsonObject obj = doc.array()[0].toObject();
-    qDebug() << "Found" << obj.keys().count() << "metadata fields";
+    return parseExifToolObject(doc.array()[0].toObject(), fields);
+}
+
+PhotoMetadata MetadataReader::parseExifToolObject(const QJsonObject& obj, int fields) {
+    PhotoMetadata meta;
     
     // File info
     meta.filepath = obj["SourceFile"].toString();
     meta.filename = obj.value("File:FileName").toString(obj["FileName"].toString());
     
     // EXIF data - support both with and without group prefixes
-    QString dateStr = obj.value("EXIF:DateTimeOriginal").toString(obj["DateTimeOriginal"].toString());
-    if (!dateStr.isEmpty()) {
-        meta.datetime_original = QDateTime::fromString(dateStr, "yyyy:MM:dd hh:mm:ss");
+    if (fields & Capture) {
+        QString dateStr = obj.value("EXIF:DateTimeOriginal").toString(obj["DateTimeOriginal"].toString());
+        if (!dateStr.isEmpty()) {
+            meta.datetime_original = QDateTime::fromString(dateStr, "yyyy:MM:dd hh:mm:ss");
+            
+            // Fractional digits of that second ("42" = 0.42 s); bursts need them
+            QString subSec = obj.value("EXIF:SubSecTimeOriginal").toVariant().toString();
+            if (subSec.isEmpty()) subSec = obj["SubSecTimeOriginal"].toVariant().toString();
+            bool ok = false;
+            double fraction = ("0." + subSec.trimmed()).toDouble(&ok);
+            if (ok && meta.datetime_original.isValid()) {
+                meta.datetime_original = meta.datetime_original.addMSecs(qRound(fraction * 1000.0));
+            }
+        }
+        
+        meta.sequence_number = obj.value("MakerNotes:SequenceNumber").toInt(obj["SequenceNumber"].toInt());
+        meta.burst_id = obj.value("MakerNotes:BurstUUID").toString(obj["BurstUUID"].toString());
     }
     
-    meta.camera_make = obj.value("EXIF:Make").toString(obj["Make"].toString());
-    meta.camera_model = obj.value("EXIF:Model").toString(obj["Model"].toString());
-    meta.aperture = obj.value("EXIF:FNumber").toDouble(obj["FNumber"].toDouble());
-    meta.shutter_speed = obj.value("EXIF:ShutterSpeedValue").toDouble(obj["ShutterSpeedValue"].toDouble());
-    meta.iso = obj.value("EXIF:ISO").toInt(obj["ISO"].toInt());
-    meta.focal_length = obj.value("EXIF:FocalLength").toDouble(obj["FocalLength"].toDouble());
+    if (fields & Camera) {
+        meta.camera_make = obj.value("EXIF:Make").toString(obj["Make"].toString());
+        meta.camera_model = obj.value("EXIF:Model").toString(obj["Model"].toString());
+        meta.aperture = obj.value("EXIF:FNumber").toDouble(obj["FNumber"].toDouble());
+        meta.shutter_speed = obj.value("EXIF:ShutterSpeedValue").toDouble(obj["ShutterSpeedValue"].toDouble());
+        meta.iso = obj.value("EXIF:ISO").toInt(obj["ISO"].toInt());
+        meta.focal_length = obj.value("EXIF:FocalLength").toDouble(obj["FocalLength"].toDouble());
+    }
     
     // GPS
-    meta.gps_lat = obj.value("EXIF:GPSLatitude").toDouble(obj["GPSLatitude"].toDouble());
-    meta.gps_lon = obj.value("EXIF:GPSLongitude").toDouble(obj["GPSLongitude"].toDouble());
+    if (fields & Gps) {
+        meta.gps_lat = obj.value("EXIF:GPSLatitude").toDouble(obj["GPSLatitude"].toDouble());
+        meta.gps_lon = obj.value("EXIF:GPSLongitude").toDouble(obj["GPSLongitude"].toDouble());
+    }
     
     // PhotoGuru AI data
-    meta.llm_title = obj.value("XMP:Title").toString(obj["Title"].toString());
-    // Description pode estar em XMP:Description ou IPTC:Caption-Abstract
-    meta.llm_description = obj.value("XMP:Description").toString(
-        obj.value("IPTC:Caption-Abstract").toString(
-        obj.value("Description").toString()));
-    
-    QJsonArray keywords = obj.value("XMP:Subject").toArray(obj["Subject"].toArray());
-    for (const QJsonValue& kw : keywords) {
-        meta.llm_keywords << kw.toString();
+    if (fields & Descriptive) {
+        meta.llm_title = obj.value("XMP:Title").toString(obj["Title"].toString());
+        // Description pode estar em XMP:Description ou IPTC:Caption-Abstract
+        meta.llm_description = obj.value("XMP:Description").toString(
+            obj.value("IPTC:Caption-Abstract").toString(
+            obj.value("Description").toString()));
+        
+        QJsonArray keywords = obj.value("XMP:Subject").toArray(obj["Subject"].toArray());
+        for (const QJsonValue& kw : keywords) {
+            meta.llm_keywords << kw.toString();
+        }
+        
+        meta.llm_category = obj.value("XMP-photoshop:Category").toString(
+            obj.value("Category").toString());
+        meta.llm_scene = obj.value("XMP:LocationShown").toString(obj["LocationShown"].toString());
     }
     
-    meta.llm_category = obj.value("XMP-photoshop:Category").toString(
-        obj.value("Category").toString());
-    meta.llm_scene = obj.value("XMP:LocationShown").toString(obj["LocationShown"].toString());
-    
     // Rating
-    meta.rating = obj.value("XMP:Rating").toInt(obj["Rating"].toInt());
+    if (fields & Rating) {
+        meta.rating = obj.value("XMP:Rating").toInt(obj["Rating"].toInt());
+    }
     
     // Location
-    meta.location_name = obj.value("IPTC:City").toString(obj["City"].toString());
-    QString state = obj.value("IPTC:Province-State").toString(obj["Province-State"].toString());
-    QString country = obj.value("IPTC:Country-PrimaryLocationName").toString(obj["Country-PrimaryLocationName"].toString());
-    
-    if (!state.isEmpty()) {
-        meta.location_name += ", " + state;
-    }
-    if (!country.isEmpty()) {
-        if (!meta.location_name.isEmpty()) meta.location_name += ", ";
-        meta.location_name += country;
+    if (fields & Location) {
+        meta.location_name = obj.value("IPTC:City").toString(obj["City"].toString());
+        QString state = obj.value("IPTC:Province-State").toString(obj["Province-State"].toString());
+        QString country = obj.value("IPTC:Country-PrimaryLocationName").toString(obj["Country-PrimaryLocationName"].toString());
+        
+        if (!state.isEmpty()) {
+            meta.location_name += ", " + state;
+        }
+        if (!country.isEmpty()) {
+            if (!meta.location_name.isEmpty()) meta.location_name += ", ";
+            meta.location_name += country;
+        }
     }
     
     // Technical metadata from UserComment
-    QString userComment = obj.value("EXIF:UserComment").toString(obj["UserComment"].toString());
-    qDebug() << "UserComment field:" << userComment;
-    
-    if (userComment.startsWith("PhotoGuru:")) {
-        qDebug() << "Found PhotoGuru metadata, parsing...";
-        meta.technical = parseTechnicalData(userComment);
-        qDebug() << "After parsing - aesthetic_score:" << meta.technical.aesthetic_score
-                 << "overall_quality:" << meta.technical.overall_quality
-                 << "sharpness:" << meta.technical.sharpness_score;
-    } else {
-        qDebug() << "No PhotoGuru metadata found in UserComment";
+    if (fields & Technical) {
+        QString userComment = obj.value("EXIF:UserComment").toString(obj["UserComment"].toString());
+        if (userComment.startsWith("PhotoGuru:")) {
+            meta.technical = parseTechnicalData(userComment);
+        }
     }
     
     return meta;
@@ -194,32 +342,20 @@ PhotoMetadata MetadataReader::parseExifToolOutput(const QString& output) {
 TechnicalMetadata TechnicalMetadata::fromJson(const QJsonObject& json) {
     TechnicalMetadata tech;
     
-    qDebug() << "JSON keys:" << json.keys();
-    qDebug() << "JSON values - sharp:" << json["sharp"] 
-             << "expo:" << json["expo"]
-             << "aesth:" << json["aesth"]
-             << "qual:" << json["qual"];
-    
     tech.sharpness_score = json["sharp"].toDouble();
     tech.exposure_quality = json["expo"].toDouble();
     tech.aesthetic_score = json["aesth"].toDouble();
     tech.overall_quality = json["qual"].toDouble();
     
-    qDebug() << "Converted to doubles - sharp:" << tech.sharpness_score
-             << "expo:" << tech.exposure_quality
-             << "aesth:" << tech.aesthetic_score
-             << "qual:" << tech.overall_quality;
-    
     // Handle null values properly
     tech.duplicate_group = json["dup"].isNull() ? QString() : json["dup"].toString();
     tech.burst_group = json["burst"].isNull() ? QString() : json["burst"].toString();
     tech.burst_position = json["burst_pos"].isNull() ? -1 : json["burst_pos"].toInt();
     tech.is_best_in_burst = json["burst_best"].toBool();
     tech.face_count = json["faces"].toInt();
-    
-    qDebug() << "Parsed technical metadata - quality:" << tech.overall_quality 
-             << "sharpness:" << tech.sharpness_score 
-             << "faces:" << tech.face_count;
+    tech.blur_detected = json["blur"].toBool();
+    tech.highlights_clipped = json["hi_clip"].toBool();
+    tech.shadows_blocked = json["lo_clip"].toBool();
     
     return tech;
 }
@@ -227,8 +363,6 @@ TechnicalMetadata TechnicalMetadata::fromJson(const QJsonObject& json) {
 TechnicalMetadata MetadataReader::parseTechnicalData(const QString& userComment) {
     TechnicalMetadata tech;
     
-    qDebug() << "Parsing UserComment:" << userComment.left(100);
-    
     // Extract JSON from "PhotoGuru:{...}" format
     int jsonStart = userComment.indexOf('{');
     if (jsonStart < 0) {
@@ -237,7 +371,6 @@ TechnicalMetadata MetadataReader::parseTechnicalData(const QString& userComment)
     }
     
     QString jsonStr = userComment.mid(jsonStart);
-    qDebug() << "JSON string:" << jsonStr;
     
     QJsonDocument doc = QJsonDocument::fromJson(jsonStr.toUtf8());
     
@@ -246,7 +379,6 @@ TechnicalMetadata MetadataReader::parseTechnicalData(const QString& userComment)
         return tech;
     }
     
-    qDebug() << "Successfully parsed UserComment JSON";
     return TechnicalMetadata::fromJson(doc.object());
 }
 
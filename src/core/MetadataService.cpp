@@ -0,0 +1,304 @@
+#include "MetadataService.h"
+#include "ExifToolDaemon.h"
+#include "PhotoDatabase.h"
+#include <QPromise>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QDebug>
+#include <memory>
+
+namespace PhotoGuru {
+
+namespace {
+
+// Catalog writes are batched into one transaction each
+constexpr int STORE_BATCH_SIZE = 100;
+
+} // namespace
+
+MetadataService::MetadataService(QObject* parent)
+    : QObject(parent)
+{
+    // One reader per ExifTool process
+    m_tasks.setMaxConcurrency(ExifToolDaemon::instance().poolSize());
+}
+
+MetadataService::~MetadataService() {
+    for (QFuture<void>& preload : m_preloads) {
+        preload.cancel();
+        preload.waitForFinished();
+    }
+    m_tasks.waitForDone();
+}
+
+MetadataService::Result MetadataService::cached(const QString& path) const {
+    if (PhotoHandle hit = handle(path)) return *hit;
+    return std::nullopt;
+}
+
+PhotoHandle MetadataService::handle(const QString& path) const {
+    return m_cache.value(path).value_or(nullptr);
+}
+
+void MetadataService::insert(PhotoMetadata metadata) {
+    store(makePhotoHandle(std::move(metadata)));
+}
+
+void MetadataService::store(const PhotoHandle& handle) {
+    {
+        QReadLocker locker(&m_clearLock);
+        m_cache.insert(handle->filepath, handle);
+    }
+    notifyChanged();
+}
+
+void MetadataService::remove(const QStringList& paths) {
+    bool removed = false;
+    for (const QString& path : paths) {
+        removed |= m_cache.remove(path);
+    }
+    if (removed) notifyChanged();
+}
+
+int MetadataService::count() const {
+    return m_cache.size();
+}
+
+QHash<QString, PhotoHandle> MetadataService::snapshot() const {
+    return m_cache.snapshot();
+}
+
+void MetadataService::clear() {
+    // Cancel first: preload chunks check it under m_clearLock before inserting
+    for (QFuture<void>& preload : m_preloads) {
+        preload.cancel();
+    }
+    {
+        QWriteLocker locker(&m_clearLock);
+        m_cache.clear();
+    }
+    notifyChanged();
+}
+
+void MetadataService::notifyChanged() {
+    // One signal per event loop pass, however many chunks landed
+    if (!m_changePosted.testAndSetRelaxed(0, 1)) return;
+    QMetaObject::invokeMethod(this, [this]() {
+        m_changePosted.storeRelaxed(0);
+        emit cacheChanged();
+    }, Qt::QueuedConnection);
+}
+
+bool MetadataService::isReading(const QString& path) const {
+    QMutexLocker locker(&m_mutex);
+    return m_reads.contains(path);
+}
+
+QFuture<MetadataService::Result> MetadataService::readyFuture(const Result& result) {
+    QPromise<Result> promise;
+    promise.start();
+    promise.addResult(result);
+    promise.finish();
+    return promise.future();
+}
+
+QFuture<MetadataService::Result> MetadataService::request(const QString& path) {
+    if (PhotoHandle hit = handle(path)) {
+        return readyFuture(*hit);
+    }
+    QMutexLocker locker(&m_mutex);
+    auto read = m_reads.constFind(path);
+    if (read != m_reads.cend()) {
+        return read->future;
+    }
+    return startRead(path, false);
+}
+
+QFuture<MetadataService::Result> MetadataService::refresh(const QString& path) {
+    QMutexLocker locker(&m_mutex);
+    // A refresh that hasn't started will see the latest write anyway
+    auto read = m_reads.constFind(path);
+    if (read != m_reads.cend() && read->refresh && !read->started) {
+        return read->future;
+    }
+    return startRead(path, true);
+}
+
+QFuture<MetadataService::Result> MetadataService::startRead(const QString& path, bool refresh) {
+    // Called with m_mutex held
+    static QAtomicInteger<quint64> nextId;
+    const quint64 id = ++nextId;
+
+    auto promise = std::make_shared<QPromise<Result>>();
+    promise->start();
+    Read read;
+    read.id = id;
+    read.future = promise->future();
+    read.refresh = refresh;
+    m_reads.insert(path, read);
+
+    m_tasks.start(QRunnable::create([this, promise, path, refresh, id]() {
+        {
+            QMutexLocker locker(&m_mutex);
+            auto it = m_reads.find(path);
+            if (it != m_reads.end() && it->id == id) it->started = true;
+        }
+
+        Result result = MetadataReader::instance().read(path, MetadataReader::FilterSet);
+        PhotoHandle stored;
+        if (result) {
+            stored = makePhotoHandle(*result);
+            store(stored);
+        }
+        {
+            QMutexLocker locker(&m_mutex);
+            // A later refresh may have taken the slot; leave it to that one
+            auto it = m_reads.find(path);
+            if (it != m_reads.end() && it->id == id) m_reads.erase(it);
+        }
+        if (stored && refresh) {
+            PhotoDatabase::instance().storeReadMetadata({*stored});
+        }
+
+        promise->addResult(std::move(result));
+        promise->finish();
+
+        if (stored) {
+            QMetaObject::invokeMethod(this, [this, stored]() {
+                emit metadataReady(*stored);
+            }, Qt::QueuedConnection);
+        } else {
+            qWarning() << "[MetadataService] Failed to read metadata:" << path;
+        }
+    }), TaskScheduler::Interactive);
+
+    return read.future;
+}
+
+QFuture<void> MetadataService::preload(const QStringList& paths) {
+    // The previous folder's chunks wind down on their own
+    for (QFuture<void>& preload : m_preloads) {
+        preload.cancel();
+    }
+    return startPreload(paths);
+}
+
+QFuture<void> MetadataService::load(const QStringList& paths) {
+    return startPreload(paths);
+}
+
+QFuture<void> MetadataService::startPreload(const QStringList& paths) {
+    m_preloads.removeIf([](const QFuture<void>& preload) { return preload.isFinished(); });
+
+    // No task waits for another: the catalog pass queues the chunks, and
+    // the last chunk to finish stores what is left and ends the run
+    struct Run {
+        QAtomicInt done;
+        QAtomicInt left;  // Chunks not finished
+        QMutex storeMutex;
+        QList<PhotoMetadata> pendingStore;
+    };
+    auto promise = std::make_shared<QPromise<void>>();
+    QFuture<void> future = promise->future();
+    promise->start();
+
+    m_tasks.start([this, promise, paths]() {
+        const int total = paths.size();
+        promise->setProgressRange(0, total);
+
+        // Fast path: serve unchanged files straight from the catalog
+        QHash<QString, PhotoHandle> cataloged;
+        {
+            QHash<QString, PhotoMetadata> fresh = PhotoDatabase::instance().loadFreshMetadata(paths);
+            cataloged.reserve(fresh.size());
+            for (auto it = fresh.begin(); it != fresh.end(); ++it) {
+                cataloged.insert(it.key(), makePhotoHandle(std::move(it.value())));
+            }
+        }
+        {
+            QReadLocker locker(&m_clearLock);
+            if (promise->isCanceled()) {
+                promise->finish();
+                return;
+            }
+            m_cache.insert(cataloged);
+        }
+        notifyChanged();
+        QStringList remaining;
+        for (const QString& path : paths) {
+            if (!cataloged.contains(path) && !m_cache.contains(path)) remaining << path;
+        }
+        promise->setProgressValue(total - int(remaining.size()));
+        if (remaining.isEmpty()) {
+            promise->finish();
+            return;
+        }
+
+        // Many files per -execute, but enough chunks to occupy every reader
+        const int readers = m_tasks.maxConcurrency();
+        const int chunkSize = qBound(1, int((remaining.size() + readers - 1) / readers),
+                                     PRELOAD_CHUNK_SIZE);
+        QList<QStringList> chunks;
+        for (int i = 0; i < remaining.size(); i += chunkSize) {
+            chunks << remaining.mid(i, chunkSize);
+        }
+
+        auto run = std::make_shared<Run>();
+        run->done.storeRelaxed(total - int(remaining.size()));
+        run->left.storeRelaxed(int(chunks.size()));
+
+        for (const QStringList& chunk : chunks) {
+            m_tasks.start([this, promise, run, chunk]() {
+                // Files requested meanwhile were read ahead of us
+                QStringList toRead;
+                if (!promise->isCanceled()) {
+                    QMutexLocker locker(&m_mutex);
+                    for (const QString& path : chunk) {
+                        if (!m_reads.contains(path) && !m_cache.contains(path)) toRead << path;
+                    }
+                }
+
+                std::vector<PhotoMetadata> metas;
+                if (!toRead.isEmpty()) {
+                    metas = MetadataReader::instance().readCommon(toRead);
+                }
+
+                QHash<QString, PhotoHandle> read;
+                for (const PhotoMetadata& meta : metas) {
+                    read.insert(meta.filepath, makePhotoHandle(meta));
+                }
+                {
+                    QReadLocker locker(&m_clearLock);
+                    if (!promise->isCanceled()) m_cache.insert(read);
+                }
+                if (!read.isEmpty()) notifyChanged();
+
+                QList<PhotoMetadata> toStore;
+                {
+                    QMutexLocker locker(&run->storeMutex);
+                    for (PhotoMetadata& meta : metas) {
+                        run->pendingStore.append(std::move(meta));
+                    }
+                    if (run->pendingStore.size() >= STORE_BATCH_SIZE) {
+                        toStore.swap(run->pendingStore);
+                    }
+                }
+                if (!toStore.isEmpty()) {
+                    PhotoDatabase::instance().storeReadMetadata(toStore);
+                }
+
+                promise->setProgressValue(run->done.fetchAndAddRelaxed(int(chunk.size())) + int(chunk.size()));
+                // The other chunks added their share before counting themselves out
+                if (run->left.fetchAndSubOrdered(1) == 1) {
+                    PhotoDatabase::instance().storeReadMetadata(run->pendingStore);
+                    promise->finish();
+                }
+            }, TaskScheduler::Ingest);
+        }
+    }, TaskScheduler::Ingest);
+
+    m_preloads.append(future);
+    return future;
+}
+
+} // namespace PhotoGuru
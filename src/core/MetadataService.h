@@ -0,0 +1,106 @@
+#pragma once
+
+#include "PhotoMetadata.h"
+#include "ShardedHash.h"
+#include "TaskScheduler.h"
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QAtomicInt>
+#include <QFuture>
+#include <optional>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Metadata for a folder, read in the background and cached
+ *
+ * The GUI never reads metadata itself: request() answers from the cache
+ * or returns a future for a read queued ahead of the folder preload, so
+ * the selected image doesn't wait behind thousands of others. Requests
+ * for a file already being read share that read. refresh() re-reads
+ * after a write and stores the result in the catalog.
+ *
+ * preload() fills the cache for a whole folder: the catalog first, then
+ * MetadataReader::readCommon() for files it doesn't have or that changed
+ * (in-process for the common fields, ExifTool for the rest), in batches
+ * in the scheduler's Ingest class, as many at once as the daemon has
+ * processes. Its future reports progress and
+ * can be cancelled.
+ *
+ * The cache is a ShardedHash of PhotoHandles, so the preload's reader
+ * threads, single reads and GUI lookups don't serialise on one lock, and
+ * snapshot() hands views the catalog's own metadata without copying it. cacheChanged() is
+ * emitted on the owner's thread after writes, at most once per event
+ * loop pass; metadataReady() likewise.
+ */
+class MetadataService : public QObject {
+    Q_OBJECT
+
+public:
+    using Result = std::optional<PhotoMetadata>;
+
+    explicit MetadataService(QObject* parent = nullptr);
+    ~MetadataService();
+
+    // Cached only; never reads
+    Result cached(const QString& path) const;
+    PhotoHandle handle(const QString& path) const;  // Null if not cached
+    void insert(PhotoMetadata metadata);
+    void remove(const QStringList& paths);
+    int count() const;
+    QHash<QString, PhotoHandle> snapshot() const;
+    quint64 revision() const { return m_cache.revision(); }  // Changes with every write
+    void clear();  // Cancels the preload too
+
+    // Ready at once if cached
+    QFuture<Result> request(const QString& path);
+    // Reads again even if cached; refreshes of one file queued together are read once
+    QFuture<Result> refresh(const QString& path);
+
+    // Progress range is [0, paths.size()]
+    QFuture<void> preload(const QStringList& paths);
+    // Same for files that appeared or changed meanwhile, without
+    // cancelling the running preload; cached files are skipped
+    QFuture<void> load(const QStringList& paths);
+
+    bool isReading(const QString& path) const;
+
+    static constexpr int PRELOAD_CHUNK_SIZE = 50;
+
+signals:
+    void metadataReady(const PhotoMetadata& metadata);  // From request()/refresh()
+    void cacheChanged();
+
+private:
+    struct Read {
+        quint64 id = 0;
+        QFuture<Result> future;
+        bool started = false;
+        bool refresh = false;
+    };
+
+    QFuture<Result> startRead(const QString& path, bool refresh);
+    static QFuture<Result> readyFuture(const Result& result);
+    void store(const PhotoHandle& handle);
+    void notifyChanged();  // Any thread
+    QFuture<void> startPreload(const QStringList& paths);
+
+    ShardedHash<QString, PhotoHandle> m_cache;
+    // Writers share it, clear() takes it exclusively: a preload chunk that
+    // saw no cancel can't land after the clear
+    QReadWriteLock m_clearLock;
+    QAtomicInt m_changePosted{0};
+
+    mutable QMutex m_mutex;  // Guards m_reads
+    QHash<QString, Read> m_reads;  // Queued or running request()/refresh() reads
+
+    QList<QFuture<void>> m_preloads;  // preload()/load() runs, finished ones pruned; GUI thread only
+    TaskGroup m_tasks{TaskScheduler::Interactive};  // Reads; preload chunks run as Ingest
+};
+
+} // namespace PhotoGuru
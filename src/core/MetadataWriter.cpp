@@ -1,12 +1,16 @@
 #include "MetadataWriter.h"
+#include "BackupJournal.h"
 #include "ExifToolDaemon.h"
+#include "FileClone.h"
+#include "ImageLoader.h"
 #include <QProcess>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QFileInfo>
-#include <QFile>
 #include <QDebug>
 #include <QDir>
+#include <QRegularExpression>
+#include <algorithm>
 
 namespace PhotoGuru {
 
@@ -15,6 +19,58 @@ MetadataWriter& MetadataWriter::instance() {
     return writer;
 }
 
+QString MetadataWriter::writeModeName(WriteMode mode) {
+    switch (mode) {
+        case WriteMode::Embedded:   return "embedded";
+        case WriteMode::RawSidecar: return "raw-sidecar";
+        case WriteMode::Sidecar:    return "sidecar";
+    }
+    return "embedded";
+}
+
+std::optional<MetadataWriter::WriteMode> MetadataWriter::writeModeFromName(const QString& name) {
+    for (WriteMode mode : {WriteMode::Embedded, WriteMode::RawSidecar, WriteMode::Sidecar}) {
+        if (writeModeName(mode) == name) return mode;
+    }
+    return std::nullopt;
+}
+
+bool MetadataWriter::usesSidecar(const QString& filePath, WriteMode mode) {
+    switch (mode) {
+        case WriteMode::Embedded:   return false;
+        case WriteMode::RawSidecar: return ImageLoader::instance().detectFormat(filePath) == ImageFormat::RAW;
+        case WriteMode::Sidecar:    return true;
+    }
+    return false;
+}
+
+QString MetadataWriter::sidecarAssignment(const QString& assignment) {
+    // "-Group:Tag=value", "-Tag+=value", "-Tag-=value"
+    const int equals = assignment.indexOf('=');
+    if (!assignment.startsWith('-') || equals < 0) {
+        return assignment;
+    }
+    QString tag = assignment.mid(1, equals - 1);
+    QString op = "=";
+    if (tag.endsWith('+') || tag.endsWith('-')) {
+        op.prepend(tag.back());
+        tag.chop(1);
+    }
+    
+    const int colon = tag.indexOf(':');
+    const QString group = colon >= 0 ? tag.left(colon) : QString();
+    const QString name = tag.mid(colon + 1);
+    if (group.startsWith("XMP", Qt::CaseInsensitive)) {
+        return assignment;
+    }
+    // IPTC fields are always written to XMP as well; XMP GPS coordinates carry their sign
+    if (group.compare("IPTC", Qt::CaseInsensitive) == 0 ||
+        (name.startsWith("GPS") && name.endsWith("Ref"))) {
+        return QString();
+    }
+    return "-XMP:" + name + op + assignment.mid(equals + 1);
+}
+
 bool MetadataWriter::verifyExifToolAvailable() const {
     QProcess process;
     process.start("exiftool", QStringList() << "-ver");
@@ -42,7 +98,7 @@ bool MetadataWriter::validateFilePath(const QString& filePath) const {
     return true;
 }
 
-QString MetadataWriter::escapeForExifTool(const QString& value) const {
+QString MetadataWriter::escapeForExifTool(const QString& value) {
     // ExifTool handles escaping internally, but we need to handle newlines
     QString escaped = value;
     escaped.replace("\r\n", "\n");
@@ -63,21 +119,9 @@ bool MetadataWriter::runExifTool(const QString& filePath, const QStringList& arg
         *output = result;
     }
     
-    // Check for errors first
-    if (result.contains("Error:", Qt::CaseInsensitive) || 
-        result.contains("Warning:", Qt::CaseInsensitive) ||
-        result.contains("weren't updated", Qt::CaseInsensitive)) {
-        qWarning() << "[MetadataWriter] ExifTool error:" << result;
-        return false;
-    }
-    
-    // Check for success indicators
-    bool success = result.contains("image files updated") || 
-                   result.contains("image files created") ||
-                   result.isEmpty(); // Stay-open mode pode retornar vazio em sucesso
-    
+    bool success = writeSucceeded(result);
     if (!success) {
-        qWarning() << "[MetadataWriter] Unexpected output:" << result;
+        qWarning() << "[MetadataWriter] ExifTool error:" << result;
     } else {
         qDebug() << "[MetadataWriter] Write successful. Output:" << result;
     }
@@ -85,104 +129,92 @@ bool MetadataWriter::runExifTool(const QString& filePath, const QStringList& arg
     return success;
 }
 
+bool MetadataWriter::writeSucceeded(const QString& rawOutput) {
+    // A new sidecar copies the file's XMP first; a file without any is no failure
+    QString output = rawOutput;
+    output.remove(QRegularExpression("^Warning: No writable tags set from[^\n]*\n?",
+                                     QRegularExpression::MultilineOption));
+    
+    // Warnings count as failures: exiftool warns when it skipped a tag
+    if (output.contains("Error:", Qt::CaseInsensitive) || 
+        output.contains("Warning:", Qt::CaseInsensitive) ||
+        output.contains("weren't updated", Qt::CaseInsensitive)) {
+        return false;
+    }
+    
+    return output.contains("image files updated") || 
+           output.contains("image files created") ||
+           output.trimmed().isEmpty(); // Stay-open mode pode retornar vazio em sucesso
+}
+
+bool MetadataWriter::commit(const Transaction& transaction) {
+    if (transaction.isEmpty()) {
+        return true;
+    }
+    return runExifTool(transaction.filePath(), transaction.arguments(writeMode()));
+}
+
+std::vector<bool> MetadataWriter::commitBatch(const QList<Transaction>& transactions) {
+    std::vector<bool> results(transactions.size(), false);
+    
+    const WriteMode mode = writeMode();
+    QStringList commands;
+    QVector<int> indices;
+    for (int i = 0; i < transactions.size(); ++i) {
+        if (transactions[i].isEmpty()) {
+            results[i] = true;
+        } else if (validateFilePath(transactions[i].filePath())) {
+            commands.append(transactions[i].arguments(mode).join('\n'));
+            indices.append(i);
+        }
+    }
+    if (commands.isEmpty()) {
+        return results;
+    }
+    
+    qDebug() << "[MetadataWriter] Committing" << commands.size() << "files in one batch";
+    QStringList outputs = ExifToolDaemon::instance().executeBatch(commands);
+    for (int k = 0; k < indices.size(); ++k) {
+        results[indices[k]] = k < outputs.size() && writeSucceeded(outputs[k]);
+        if (!results[indices[k]]) {
+            qWarning() << "[MetadataWriter] Batch write failed:" << transactions[indices[k]].filePath();
+        }
+    }
+    return results;
+}
+
 bool MetadataWriter::updateRating(const QString& filePath, int rating) {
     if (rating < 0 || rating > 5) {
         qWarning() << "Invalid rating value:" << rating;
         return false;
     }
     
-    QStringList args;
-    args << "-overwrite_original";
-    args << QString("-XMP:Rating=%1").arg(rating);
-    args << filePath;
-    
-    return runExifTool(filePath, args);
+    return commit(Transaction(filePath).setRating(rating));
 }
 
 bool MetadataWriter::updateTitle(const QString& filePath, const QString& title) {
-    QStringList args;
-    args << "-overwrite_original";
-    args << QString("-XMP:Title=%1").arg(escapeForExifTool(title));
-    args << QString("-IPTC:ObjectName=%1").arg(escapeForExifTool(title));
-    args << filePath;
-    
-    return runExifTool(filePath, args);
+    return commit(Transaction(filePath).setTitle(title));
 }
 
 bool MetadataWriter::updateDescription(const QString& filePath, const QString& description) {
-    QStringList args;
-    args << "-overwrite_original";
-    args << QString("-XMP:Description=%1").arg(escapeForExifTool(description));
-    args << QString("-IPTC:Caption-Abstract=%1").arg(escapeForExifTool(description));
-    args << filePath;
-    
-    return runExifTool(filePath, args);
+    return commit(Transaction(filePath).setDescription(description));
 }
 
 bool MetadataWriter::updateKeywords(const QString& filePath, const QStringList& keywords) {
-    QStringList args;
-    args << "-overwrite_original";
-    
-    // Clear existing keywords first
-    args << "-XMP:Subject=";
-    args << "-IPTC:Keywords=";
-    
-    // Add new keywords
-    for (const QString& keyword : keywords) {
-        args << QString("-XMP:Subject+=%1").arg(escapeForExifTool(keyword));
-        args << QString("-IPTC:Keywords+=%1").arg(escapeForExifTool(keyword));
-    }
-    
-    args << filePath;
-    
-    return runExifTool(filePath, args);
+    return commit(Transaction(filePath).setKeywords(keywords));
 }
 
 bool MetadataWriter::updateCategory(const QString& filePath, const QString& category) {
-    QStringList args;
-    args << "-overwrite_original";
-    // Use XMP-photoshop:Category (works in HEIC, JPEG, etc)
-    args << QString("-XMP-photoshop:Category=%1").arg(escapeForExifTool(category));
-    args << filePath;
-    
-    return runExifTool(filePath, args);
+    return commit(Transaction(filePath).setCategory(category));
 }
 
 bool MetadataWriter::updateLocation(const QString& filePath, const QString& city, 
                                     const QString& state, const QString& country) {
-    QStringList args;
-    args << "-overwrite_original";
-    
-    if (!city.isEmpty()) {
-        args << QString("-IPTC:City=%1").arg(escapeForExifTool(city));
-        args << QString("-XMP:City=%1").arg(escapeForExifTool(city));
-    }
-    
-    if (!state.isEmpty()) {
-        args << QString("-IPTC:Province-State=%1").arg(escapeForExifTool(state));
-        args << QString("-XMP:State=%1").arg(escapeForExifTool(state));
-    }
-    
-    if (!country.isEmpty()) {
-        args << QString("-IPTC:Country-PrimaryLocationName=%1").arg(escapeForExifTool(country));
-        args << QString("-XMP:Country=%1").arg(escapeForExifTool(country));
-    }
-    
-    args << filePath;
-    
-    return runExifTool(filePath, args);
+    return commit(Transaction(filePath).setLocation(city, state, country));
 }
 
 bool MetadataWriter::updateGPS(const QString& filePath, double lat, double lon) {
-    QStringList args;
-    args << "-overwrite_original";
-    args << QString("-GPSLatitude=%1").arg(lat, 0, 'f', 6);
-    args << QString("-GPSLongitude=%1").arg(lon, 0, 'f', 6);
-    args << "-GPSLatitudeRef=" + QString(lat >= 0 ? "N" : "S");
-    args << "-GPSLongitudeRef=" + QString(lon >= 0 ? "E" : "W");
-    args << filePath;
-    
-    return runExifTool(filePath, args);
+    return commit(Transaction(filePath).setGPS(lat, lon));
 }
 
 bool MetadataWriter::updateRatingBatch(const QStringList& filePaths, int rating) {
@@ -191,74 +223,33 @@ bool MetadataWriter::updateRatingBatch(const QStringList& filePaths, int rating)
         return false;
     }
     
-    QStringList args;
-    args << "-overwrite_original";
-    args << QString("-XMP:Rating=%1").arg(rating);
-    args << filePaths;
-    
-    // For batch operations, we need to validate all files first
+    QList<Transaction> transactions;
     for (const QString& path : filePaths) {
-        if (!validateFilePath(path)) {
-            return false;
-        }
+        transactions << Transaction(path).setRating(rating);
     }
-    
-    QProcess process;
-    process.start("exiftool", args);
-    
-    if (!process.waitForFinished(60000)) { // 60 second timeout for batch
-        qWarning() << "ExifTool batch operation timed out";
-        return false;
-    }
-    
-    return process.exitCode() == 0;
+    const std::vector<bool> results = commitBatch(transactions);
+    return std::all_of(results.begin(), results.end(), [](bool ok) { return ok; });
 }
 
 bool MetadataWriter::addKeywordsBatch(const QStringList& filePaths, const QStringList& keywords) {
-    QStringList args;
-    args << "-overwrite_original";
-    
-    for (const QString& keyword : keywords) {
-        args << QString("-XMP:Subject+=%1").arg(escapeForExifTool(keyword));
-        args << QString("-IPTC:Keywords+=%1").arg(escapeForExifTool(keyword));
-    }
-    
-    args << filePaths;
-    
-    QProcess process;
-    process.start("exiftool", args);
-    
-    if (!process.waitForFinished(60000)) {
-        qWarning() << "ExifTool batch operation timed out";
-        return false;
+    QList<Transaction> transactions;
+    for (const QString& path : filePaths) {
+        transactions << Transaction(path).addKeywords(keywords);
     }
-    
-    return process.exitCode() == 0;
+    const std::vector<bool> results = commitBatch(transactions);
+    return std::all_of(results.begin(), results.end(), [](bool ok) { return ok; });
 }
 
 bool MetadataWriter::removeKeywordsBatch(const QStringList& filePaths, const QStringList& keywords) {
-    QStringList args;
-    args << "-overwrite_original";
-    
-    for (const QString& keyword : keywords) {
-        args << QString("-XMP:Subject-=%1").arg(escapeForExifTool(keyword));
-        args << QString("-IPTC:Keywords-=%1").arg(escapeForExifTool(keyword));
-    }
-    
-    args << filePaths;
-    
-    QProcess process;
-    process.start("exiftool", args);
-    
-    if (!process.waitForFinished(60000)) {
-        qWarning() << "ExifTool batch operation timed out";
-        return false;
+    QList<Transaction> transactions;
+    for (const QString& path : filePaths) {
+        transactions << Transaction(path).removeKeywords(keywords);
     }
-    
-    return process.exitCode() == 0;
+    const std::vector<bool> results = commitBatch(transactions);
+    return std::all_of(results.begin(), results.end(), [](bool ok) { return ok; });
 }
 
-QString MetadataWriter::buildTechnicalJSON(const TechnicalMetadata& technical) const {
+QString MetadataWriter::buildTechnicalJSON(const TechnicalMetadata& technical) {
     QJsonObject json;
     json["sharp"] = technical.sharpness_score;
     json["expo"] = technical.exposure_quality;
@@ -269,106 +260,189 @@ QString MetadataWriter::buildTechnicalJSON(const TechnicalMetadata& technical) c
     json["burst_pos"] = technical.burst_position >= 0 ? technical.burst_position : QJsonValue();
     json["burst_best"] = technical.is_best_in_burst;
     json["faces"] = technical.face_count;
+    json["blur"] = technical.blur_detected;
+    json["hi_clip"] = technical.highlights_clipped;
+    json["lo_clip"] = technical.shadows_blocked;
     
     QJsonDocument doc(json);
     return "PhotoGuru:" + QString::fromUtf8(doc.toJson(QJsonDocument::Compact));
 }
 
 bool MetadataWriter::writeTechnicalMetadata(const QString& filePath, const TechnicalMetadata& technical) {
-    QString jsonData = buildTechnicalJSON(technical);
-    
-    QStringList args;
-    args << "-overwrite_original";
-    args << QString("-EXIF:UserComment=%1").arg(jsonData);
-    args << QString("-XMP:CreatorTool=PhotoGuru");
-    args << filePath;
-    
-    return runExifTool(filePath, args);
+    return commit(Transaction(filePath)
+        .setTechnical(technical)
+        .setTag("XMP:CreatorTool", "PhotoGuru"));
 }
 
 bool MetadataWriter::writeAIAnalysis(const QString& filePath, const QString& title,
                                      const QString& description, const QStringList& keywords,
                                      const QString& category, const QString& scene, const QString& mood) {
-    QStringList args;
-    args << "-overwrite_original";
-    args << QString("-XMP:CreatorTool=PhotoGuru");
+    Transaction transaction(filePath);
+    transaction.setTag("XMP:CreatorTool", "PhotoGuru");
     
-    if (!title.isEmpty()) {
-        args << QString("-XMP:Title=%1").arg(escapeForExifTool(title));
-        args << QString("-IPTC:ObjectName=%1").arg(escapeForExifTool(title));
-    }
+    if (!title.isEmpty()) transaction.setTitle(title);
+    if (!description.isEmpty()) transaction.setDescription(description);
+    if (!keywords.isEmpty()) transaction.setKeywords(keywords);
+    if (!category.isEmpty()) transaction.setCategory(category);
+    if (!scene.isEmpty()) transaction.setTag("XMP:LocationShown", scene);
+    if (!mood.isEmpty()) transaction.setTag("XMP:Mood", mood);
     
-    if (!description.isEmpty()) {
-        args << QString("-XMP:Description=%1").arg(escapeForExifTool(description));
-        args << QString("-IPTC:Caption-Abstract=%1").arg(escapeForExifTool(description));
+    return commit(transaction);
+}
+
+bool MetadataWriter::write(const QString& filePath, const PhotoMetadata& metadata) {
+    return commit(Transaction(filePath).setMetadata(metadata));
+}
+
+// ============================================================================
+// Transaction
+// ============================================================================
+
+MetadataWriter::Transaction::Transaction(const QString& filePath)
+    : m_filePath(filePath)
+{
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::set(const QString& field,
+                                                              const QStringList& args) {
+    m_fields[field] = args;
+    return *this;
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::setRating(int rating) {
+    return set("rating", {QString("-XMP:Rating=%1").arg(rating)});
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::setTitle(const QString& title) {
+    return set("title", {
+        QString("-XMP:Title=%1").arg(escapeForExifTool(title)),
+        QString("-IPTC:ObjectName=%1").arg(escapeForExifTool(title))
+    });
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::setDescription(const QString& description) {
+    return set("description", {
+        QString("-XMP:Description=%1").arg(escapeForExifTool(description)),
+        QString("-IPTC:Caption-Abstract=%1").arg(escapeForExifTool(description))
+    });
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::setKeywords(const QStringList& keywords) {
+    // Clear existing keywords first, then add the new ones
+    QStringList args{"-XMP:Subject=", "-IPTC:Keywords="};
+    for (const QString& keyword : keywords) {
+        args << QString("-XMP:Subject+=%1").arg(escapeForExifTool(keyword));
+        args << QString("-IPTC:Keywords+=%1").arg(escapeForExifTool(keyword));
     }
-    
-    // Clear and set keywords
-    if (!keywords.isEmpty()) {
-        args << "-XMP:Subject=";
-        args << "-IPTC:Keywords=";
-        for (const QString& keyword : keywords) {
-            args << QString("-XMP:Subject+=%1").arg(escapeForExifTool(keyword));
-            args << QString("-IPTC:Keywords+=%1").arg(escapeForExifTool(keyword));
-        }
+    return set("keywords", args);
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::addKeywords(const QStringList& keywords) {
+    QStringList& args = m_fields["keywords"];
+    for (const QString& keyword : keywords) {
+        args << QString("-XMP:Subject+=%1").arg(escapeForExifTool(keyword));
+        args << QString("-IPTC:Keywords+=%1").arg(escapeForExifTool(keyword));
     }
-    
-    if (!category.isEmpty()) {
-        // Use XMP-photoshop:Category for broader format support
-        args << QString("-XMP-photoshop:Category=%1").arg(escapeForExifTool(category));
+    return *this;
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::removeKeywords(const QStringList& keywords) {
+    QStringList& args = m_fields["keywords"];
+    for (const QString& keyword : keywords) {
+        args << QString("-XMP:Subject-=%1").arg(escapeForExifTool(keyword));
+        args << QString("-IPTC:Keywords-=%1").arg(escapeForExifTool(keyword));
     }
+    return *this;
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::setCategory(const QString& category) {
+    // Use XMP-photoshop:Category (works in HEIC, JPEG, etc)
+    return set("category", {QString("-XMP-photoshop:Category=%1").arg(escapeForExifTool(category))});
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::setLocation(const QString& city,
+                                                                      const QString& state,
+                                                                      const QString& country) {
+    QStringList args;
     
-    if (!scene.isEmpty()) {
-        args << QString("-XMP:LocationShown=%1").arg(escapeForExifTool(scene));
+    if (!city.isEmpty()) {
+        args << QString("-IPTC:City=%1").arg(escapeForExifTool(city));
+        args << QString("-XMP:City=%1").arg(escapeForExifTool(city));
     }
     
-    if (!mood.isEmpty()) {
-        args << QString("-XMP:Mood=%1").arg(escapeForExifTool(mood));
+    if (!state.isEmpty()) {
+        args << QString("-IPTC:Province-State=%1").arg(escapeForExifTool(state));
+        args << QString("-XMP:State=%1").arg(escapeForExifTool(state));
     }
     
-    args << filePath;
+    if (!country.isEmpty()) {
+        args << QString("-IPTC:Country-PrimaryLocationName=%1").arg(escapeForExifTool(country));
+        args << QString("-XMP:Country=%1").arg(escapeForExifTool(country));
+    }
     
-    return runExifTool(filePath, args);
+    return set("location", args);
 }
 
-QStringList MetadataWriter::buildMetadataArgs(const PhotoMetadata& metadata) const {
-    QStringList args;
-    args << "-overwrite_original";
-    args << "-XMP:CreatorTool=PhotoGuru";
+MetadataWriter::Transaction& MetadataWriter::Transaction::setGPS(double lat, double lon) {
+    return set("gps", {
+        QString("-GPSLatitude=%1").arg(lat, 0, 'f', 6),
+        QString("-GPSLongitude=%1").arg(lon, 0, 'f', 6),
+        "-GPSLatitudeRef=" + QString(lat >= 0 ? "N" : "S"),
+        "-GPSLongitudeRef=" + QString(lon >= 0 ? "E" : "W")
+    });
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::setDateTime(const QDateTime& taken) {
+    QString dateTimeStr = taken.toString("yyyy:MM:dd HH:mm:ss");
+    return set("datetime", {
+        "-DateTimeOriginal=" + dateTimeStr,
+        "-CreateDate=" + dateTimeStr
+    });
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::setTechnical(const TechnicalMetadata& technical) {
+    return set("technical", {QString("-EXIF:UserComment=%1").arg(buildTechnicalJSON(technical))});
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::setCustomField(const QString& name,
+                                                                         const QString& value) {
+    // Write to XMP custom namespace
+    return setTag("XMP-photoguru:" + name, value);
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::setTag(const QString& tag, const QString& value) {
+    return set("tag:" + tag, {QString("-%1=%2").arg(tag, escapeForExifTool(value))});
+}
+
+MetadataWriter::Transaction& MetadataWriter::Transaction::setMetadata(const PhotoMetadata& metadata) {
+    setTag("XMP:CreatorTool", "PhotoGuru");
     
     // Rating
     if (metadata.rating > 0) {
-        args << QString("-XMP:Rating=%1").arg(metadata.rating);
+        setRating(metadata.rating);
     }
     
     // AI Analysis
     if (!metadata.llm_title.isEmpty()) {
-        args << QString("-XMP:Title=%1").arg(escapeForExifTool(metadata.llm_title));
-        args << QString("-IPTC:ObjectName=%1").arg(escapeForExifTool(metadata.llm_title));
+        setTitle(metadata.llm_title);
     }
     
     if (!metadata.llm_description.isEmpty()) {
-        args << QString("-XMP:Description=%1").arg(escapeForExifTool(metadata.llm_description));
-        args << QString("-IPTC:Caption-Abstract=%1").arg(escapeForExifTool(metadata.llm_description));
+        setDescription(metadata.llm_description);
     }
     
     if (!metadata.llm_keywords.isEmpty()) {
-        args << "-XMP:Subject=";
-        args << "-IPTC:Keywords=";
-        for (const QString& keyword : metadata.llm_keywords) {
-            args << QString("-XMP:Subject+=%1").arg(escapeForExifTool(keyword));
-            args << QString("-IPTC:Keywords+=%1").arg(escapeForExifTool(keyword));
-        }
+        setKeywords(metadata.llm_keywords);
     }
     
     if (!metadata.llm_category.isEmpty()) {
-        // Use XMP-photoshop:Category for broader format support (HEIC, etc)
-        args << QString("-XMP-photoshop:Category=%1").arg(escapeForExifTool(metadata.llm_category));
+        setCategory(metadata.llm_category);
     }
     
-    // Location
+    // Location ("City, State, Country"), IPTC only as write() always did
     if (!metadata.location_name.isEmpty()) {
         QStringList parts = metadata.location_name.split(", ");
+        QStringList args;
         if (parts.size() >= 1) {
             args << QString("-IPTC:City=%1").arg(escapeForExifTool(parts[0]));
         }
@@ -378,30 +452,70 @@ QStringList MetadataWriter::buildMetadataArgs(const PhotoMetadata& metadata) con
         if (parts.size() >= 3) {
             args << QString("-IPTC:Country-PrimaryLocationName=%1").arg(escapeForExifTool(parts[2]));
         }
+        set("location", args);
     }
     
     // GPS
     if (metadata.gps_lat != 0.0 || metadata.gps_lon != 0.0) {
-        args << QString("-GPSLatitude=%1").arg(metadata.gps_lat, 0, 'f', 6);
-        args << QString("-GPSLongitude=%1").arg(metadata.gps_lon, 0, 'f', 6);
-        args << "-GPSLatitudeRef=" + QString(metadata.gps_lat >= 0 ? "N" : "S");
-        args << "-GPSLongitudeRef=" + QString(metadata.gps_lon >= 0 ? "E" : "W");
+        setGPS(metadata.gps_lat, metadata.gps_lon);
     }
     
     // Technical metadata
     if (metadata.technical.overall_quality > 0.0) {
-        QString jsonData = buildTechnicalJSON(metadata.technical);
-        args << QString("-EXIF:UserComment=%1").arg(jsonData);
+        setTechnical(metadata.technical);
     }
     
-    return args;
+    return *this;
 }
 
-bool MetadataWriter::write(const QString& filePath, const PhotoMetadata& metadata) {
-    QStringList args = buildMetadataArgs(metadata);
-    args << filePath;
+QStringList MetadataWriter::Transaction::arguments(WriteMode mode) const {
+    if (m_fields.isEmpty()) {
+        return QStringList();
+    }
     
-    return runExifTool(filePath, args);
+    QStringList args;
+    if (!usesSidecar(m_filePath, mode)) {
+        args << "-overwrite_original";
+        for (const QStringList& assignments : m_fields) {
+            args << assignments;
+        }
+        args << m_filePath;
+        return args;
+    }
+    
+    // A few KB of XMP rewritten instead of the whole image
+    const QString sidecar = MetadataReader::sidecarPath(m_filePath);
+    const bool exists = QFileInfo::exists(sidecar);
+    if (exists) {
+        args << "-overwrite_original";
+    } else {
+        args << "-tagsFromFile" << "@" << "-xmp:all";  // Start from the file's own XMP
+    }
+    for (const QStringList& assignments : m_fields) {
+        for (const QString& assignment : assignments) {
+            const QString mapped = sidecarAssignment(assignment);
+            if (!mapped.isEmpty()) args << mapped;
+        }
+    }
+    if (exists) {
+        args << sidecar;
+    } else {
+        args << "-o" << sidecar << m_filePath;
+    }
+    return args;
+}
+
+bool MetadataWriter::transferSidecar(const QString& from, const QString& to, bool move) {
+    const QString source = MetadataReader::sidecarPath(from);
+    if (!QFileInfo::exists(source)) return true;
+    const QString target = MetadataReader::sidecarPath(to);
+    if (QFileInfo::exists(target)) {
+        qWarning() << "[MetadataWriter] Sidecar already at" << target << "- left" << source;
+        return false;
+    }
+    const bool done = move ? FileClone::move(source, target) : FileClone::copy(source, target).has_value();
+    if (!done) qWarning() << "[MetadataWriter] Could not carry sidecar" << source << "to" << target;
+    return done;
 }
 
 bool MetadataWriter::createBackup(const QString& filePath) {
@@ -409,47 +523,26 @@ bool MetadataWriter::createBackup(const QString& filePath) {
         return false;
     }
     
-    QFileInfo info(filePath);
-    QString backupPath = info.path() + "/" + info.baseName() + "_backup." + info.suffix();
-    
-    // Copy entire file (not just metadata)
-    QFile source(filePath);
-    if (QFile::exists(backupPath)) {
-        QFile::remove(backupPath);
-    }
-    
-    if (!source.copy(backupPath)) {
-        qWarning() << "Failed to create backup:" << source.errorString();
+    // Sidecar edits never touch the image: the sidecar is all there is to keep.
+    // A sidecar that doesn't exist yet is recorded as absent, so restoring removes it.
+    const QString source = usesSidecar(filePath, writeMode()) ? MetadataReader::sidecarPath(filePath) : filePath;
+    if (!BackupJournal::instance().record(source)) {
+        qWarning() << "Failed to create backup:" << source;
         return false;
     }
     
-    qDebug() << "Backup created:" << backupPath;
+    qDebug() << "Backup created:" << source;
     return true;
 }
 
 bool MetadataWriter::restoreFromBackup(const QString& filePath) {
-    QFileInfo info(filePath);
-    QString backupPath = info.path() + "/" + info.baseName() + "_backup." + info.suffix();
-    
-    if (!QFileInfo::exists(backupPath)) {
-        qWarning() << "Backup file does not exist:" << backupPath;
-        return false;
-    }
-    
-    // Remove current file and copy backup
-    if (QFile::exists(filePath)) {
-        if (!QFile::remove(filePath)) {
-            qWarning() << "Failed to remove current file for restore";
-            return false;
-        }
-    }
-    
-    if (!QFile::copy(backupPath, filePath)) {
-        qWarning() << "Failed to restore from backup";
+    const QString target = usesSidecar(filePath, writeMode()) ? MetadataReader::sidecarPath(filePath) : filePath;
+    if (!BackupJournal::instance().restore(target)) {
+        qWarning() << "Failed to restore from backup:" << target;
         return false;
     }
     
-    qDebug() << "Restored from backup:" << backupPath;
+    qDebug() << "Restored from backup:" << target;
     return true;
 }
 
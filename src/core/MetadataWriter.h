@@ -3,7 +3,11 @@
 #include "PhotoMetadata.h"
 #include <QString>
 #include <QStringList>
+#include <QDateTime>
+#include <QMap>
+#include <atomic>
 #include <optional>
+#include <vector>
 
 namespace PhotoGuru {
 
@@ -12,11 +16,100 @@ namespace PhotoGuru {
  * 
  * Supports writing to XMP, IPTC, and EXIF fields with full Lightroom compatibility.
  * All write operations are atomic and preserve existing metadata.
+ *
+ * Every ExifTool write rewrites the whole file, so field changes go
+ * through a Transaction and commit() applies them all in one call:
+ *
+ *   MetadataWriter::Transaction tx(path);
+ *   tx.setTitle("Sunset").setRating(4).addKeywords({"beach"});
+ *   MetadataWriter::instance().commit(tx);
+ *
+ * The update*() helpers are one-field transactions.
+ *
+ * Rewriting a 60 MB RAW file for a star rating is most of the cost, so
+ * the write mode can send edits to an XMP sidecar next to the file
+ * instead (IMG_0001.xmp for IMG_0001.NEF, as Lightroom names them;
+ * IMG_0001.JPG.xmp for other files, see MetadataReader::sidecarPath).
+ * Sidecars hold XMP only: EXIF, GPS and date tags go to their XMP
+ * counterparts and the IPTC copies are left out. A new sidecar starts
+ * from the file's own XMP. MetadataReader reads sidecars back over the
+ * file's tags.
  */
 class MetadataWriter {
 public:
+    enum class WriteMode {
+        Embedded,    // Into the image file itself
+        RawSidecar,  // Sidecars for RAW files, the file itself otherwise
+        Sidecar      // Sidecars for every file
+    };
+    
+    /**
+     * @brief Pending field changes for one file
+     * 
+     * Setting a field again replaces the earlier value; keyword sets,
+     * additions and removals accumulate in call order. Not thread-safe.
+     */
+    class Transaction {
+    public:
+        explicit Transaction(const QString& filePath = QString());
+        
+        Transaction& setRating(int rating);
+        Transaction& setTitle(const QString& title);
+        Transaction& setDescription(const QString& description);
+        Transaction& setKeywords(const QStringList& keywords);    // Replaces existing keywords
+        Transaction& addKeywords(const QStringList& keywords);
+        Transaction& removeKeywords(const QStringList& keywords);
+        Transaction& setCategory(const QString& category);
+        Transaction& setLocation(const QString& city, const QString& state, const QString& country);
+        Transaction& setGPS(double lat, double lon);
+        Transaction& setDateTime(const QDateTime& taken);          // DateTimeOriginal + CreateDate
+        Transaction& setTechnical(const TechnicalMetadata& technical);
+        Transaction& setCustomField(const QString& name, const QString& value);  // XMP-photoguru
+        Transaction& setTag(const QString& tag, const QString& value);           // Any ExifTool tag
+        
+        // The fields write() stores, as one transaction
+        Transaction& setMetadata(const PhotoMetadata& metadata);
+        
+        const QString& filePath() const { return m_filePath; }
+        bool isEmpty() const { return m_fields.isEmpty(); }
+        QStringList fields() const { return m_fields.keys(); }
+        
+        // Full ExifTool command, ending with the file (or sidecar) path;
+        // empty if nothing changes
+        QStringList arguments(WriteMode mode = WriteMode::Embedded) const;
+        
+    private:
+        Transaction& set(const QString& field, const QStringList& args);
+        
+        QString m_filePath;
+        QMap<QString, QStringList> m_fields;  // Field -> ExifTool assignments
+    };
+    
     static MetadataWriter& instance();
     
+    void setWriteMode(WriteMode mode) { m_writeMode.store(mode, std::memory_order_relaxed); }
+    WriteMode writeMode() const { return m_writeMode.load(std::memory_order_relaxed); }
+    static QString writeModeName(WriteMode mode);  // Stable, for QSettings
+    static std::optional<WriteMode> writeModeFromName(const QString& name);
+    
+    // Edits of filePath go to its sidecar under `mode`
+    static bool usesSidecar(const QString& filePath, WriteMode mode);
+    // The assignment as written to a sidecar; empty to leave it out
+    static QString sidecarAssignment(const QString& assignment);
+    
+    // Takes the sidecar of `from`, if any, to where `to`'s goes: moved
+    // (renames, moves) or copied. False only when there was one to carry and it stayed
+    static bool transferSidecar(const QString& from, const QString& to, bool move);
+    
+    // Writes every change of the transaction in one ExifTool call
+    bool commit(const Transaction& transaction);
+    
+    // Several files through one ExifTool process; one result per transaction
+    std::vector<bool> commitBatch(const QList<Transaction>& transactions);
+    
+    // ExifTool output of a write reports success
+    static bool writeSucceeded(const QString& output);
+    
     // Write complete metadata structure
     bool write(const QString& filePath, const PhotoMetadata& metadata);
     
@@ -42,7 +135,7 @@ public:
                         const QString& description, const QStringList& keywords,
                         const QString& category, const QString& scene, const QString& mood);
     
-    // Backup/restore
+    // Backup/restore through BackupJournal; in sidecar mode only the sidecar is kept
     bool createBackup(const QString& filePath);
     bool restoreFromBackup(const QString& filePath);
     
@@ -58,10 +151,11 @@ private:
     
     // Helper methods
     bool runExifTool(const QString& filePath, const QStringList& args, QString* output = nullptr);
-    QString buildTechnicalJSON(const TechnicalMetadata& technical) const;
-    QStringList buildMetadataArgs(const PhotoMetadata& metadata) const;
+    static QString buildTechnicalJSON(const TechnicalMetadata& technical);
     bool validateFilePath(const QString& filePath) const;
-    QString escapeForExifTool(const QString& value) const;
+    static QString escapeForExifTool(const QString& value);
+    
+    std::atomic<WriteMode> m_writeMode{WriteMode::Embedded};
 };
 
 } // namespace PhotoGuru
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include <optional>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Fixed-capacity lock-free queue: many producers, one consumer
+ *
+ * Slots are allocated once up front and reused, so push() never
+ * allocates and never waits: when the queue is full it returns false
+ * and the caller decides what to drop. Each slot carries a sequence
+ * number (Vyukov's bounded queue) that tells producers whether it is
+ * free and the consumer whether it has been filled.
+ *
+ * pop() may only be called from one thread at a time.
+ */
+template <typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(int capacity)
+        : m_capacity(roundUp(capacity))
+        , m_mask(m_capacity - 1)
+        , m_slots(new Slot[m_capacity])
+    {
+        for (quint64 i = 0; i < m_capacity; i++) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // false if full (item is dropped)
+    bool push(T item) {
+        quint64 position = m_tail.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        for (;;) {
+            slot = &m_slots[position & m_mask];
+            const quint64 sequence = slot->sequence.load(std::memory_order_acquire);
+            const qint64 lag = qint64(sequence - position);
+            if (lag == 0) {
+                if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                return false;  // The consumer hasn't freed this slot yet
+            } else {
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(item);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only: nullopt when nothing is ready right now
+    std::optional<T> pop() {
+        Slot& slot = m_slots[m_head & m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != m_head + 1) {
+            return std::nullopt;
+        }
+        std::optional<T> item(std::move(slot.value));
+        slot.value = T();
+        slot.sequence.store(m_head + m_capacity, std::memory_order_release);
+        ++m_head;
+        return item;
+    }
+
+    // Consumer only
+    bool empty() const {
+        return m_slots[m_head & m_mask].sequence.load(std::memory_order_acquire) != m_head + 1;
+    }
+
+    int capacity() const { return int(m_capacity); }
+
+    // Pushes that have claimed a slot so far (some may still be filling it)
+    quint64 claimed() const { return m_tail.load(std::memory_order_acquire); }
+
+    // Consumer only: items popped so far. Once popped() reaches a value
+    // claimed() returned, every push that had claimed a slot by then is out.
+    quint64 popped() const { return m_head; }
+
+private:
+    struct Slot {
+        std::atomic<quint64> sequence{0};
+        T value{};
+    };
+
+    static quint64 roundUp(int capacity) {
+        quint64 size = 2;
+        while (size < quint64(qMax(capacity, 2))) size <<= 1;
+        return size;
+    }
+
+    const quint64 m_capacity;
+    const quint64 m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+    alignas(64) std::atomic<quint64> m_tail{0};  // Apart from the consumer's line
+    alignas(64) quint64 m_head = 0;
+};
+
+} // namespace PhotoGuru
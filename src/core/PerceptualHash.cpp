@@ -0,0 +1,140 @@
+#include "PerceptualHash.h"
+#include "ImageLoader.h"
+#include "PhotoDatabase.h"
+#include "TaskScheduler.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cmath>
+#include <vector>
+
+namespace PhotoGuru {
+
+namespace {
+
+constexpr int SAMPLES = 32;  // Edge of the reduced image
+constexpr int FREQUENCIES = 8;  // Edge of the kept low-frequency block
+constexpr double PI = 3.14159265358979323846;
+
+// cos((2x + 1) u pi / 2N) for the kept frequencies u
+const std::array<std::array<float, SAMPLES>, FREQUENCIES>& cosines() {
+    static const auto table = []() {
+        std::array<std::array<float, SAMPLES>, FREQUENCIES> result{};
+        for (int u = 0; u < FREQUENCIES; ++u) {
+            for (int x = 0; x < SAMPLES; ++x) {
+                result[u][x] = float(std::cos((2 * x + 1) * u * PI / (2 * SAMPLES)));
+            }
+        }
+        return result;
+    }();
+    return table;
+}
+
+} // namespace
+
+PerceptualHash& PerceptualHash::instance() {
+    static PerceptualHash hash;
+    return hash;
+}
+
+quint64 PerceptualHash::compute(const QImage& image) {
+    if (image.isNull()) return 0;
+    const QImage gray = image.scaled(SAMPLES, SAMPLES, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                            .convertToFormat(QImage::Format_Grayscale8);
+
+    // Separable DCT-II, only the low frequencies: rows then columns
+    const auto& cos = cosines();
+    float rows[SAMPLES][FREQUENCIES];
+    for (int y = 0; y < SAMPLES; ++y) {
+        const uchar* line = gray.constScanLine(y);
+        for (int u = 0; u < FREQUENCIES; ++u) {
+            float sum = 0.0f;
+            for (int x = 0; x < SAMPLES; ++x) sum += cos[u][x] * line[x];
+            rows[y][u] = sum;
+        }
+    }
+    std::array<float, FREQUENCIES * FREQUENCIES> coefficients;
+    for (int v = 0; v < FREQUENCIES; ++v) {
+        for (int u = 0; u < FREQUENCIES; ++u) {
+            float sum = 0.0f;
+            for (int y = 0; y < SAMPLES; ++y) sum += cos[v][y] * rows[y][u];
+            coefficients[v * FREQUENCIES + u] = sum;
+        }
+    }
+
+    // Median of the AC terms: the DC term only carries overall brightness
+    std::array<float, FREQUENCIES * FREQUENCIES - 1> ac;
+    std::copy(coefficients.begin() + 1, coefficients.end(), ac.begin());
+    std::nth_element(ac.begin(), ac.begin() + ac.size() / 2, ac.end());
+    const float median = ac[ac.size() / 2];
+
+    quint64 bits = 0;
+    for (size_t i = 0; i < coefficients.size(); ++i) {
+        if (coefficients[i] > median) bits |= quint64(1) << i;
+    }
+    return bits;
+}
+
+int PerceptualHash::distance(quint64 a, quint64 b) {
+    return int(std::bitset<64>(a ^ b).count());
+}
+
+void PerceptualHash::record(const QString& filePath, const QImage& decoded) {
+    PhotoDatabase& catalog = PhotoDatabase::instance();
+    if (decoded.isNull() || !catalog.isInitialized()) return;
+    store(filePath, compute(decoded));
+}
+
+void PerceptualHash::store(const QString& filePath, quint64 hash) {
+    QFileInfo info(filePath);
+    PhotoDatabase::instance().storePerceptualHash(filePath, info.lastModified().toMSecsSinceEpoch(),
+                                                  info.size(), hash);
+}
+
+std::optional<quint64> PerceptualHash::hash(const QString& filePath) {
+    const QHash<QString, quint64> result = hashes({filePath});
+    auto it = result.constFind(filePath);
+    if (it == result.cend()) return std::nullopt;
+    return it.value();
+}
+
+QHash<QString, quint64> PerceptualHash::hashes(const QStringList& filePaths) {
+    PhotoDatabase& catalog = PhotoDatabase::instance();
+    QHash<QString, quint64> result;
+    if (catalog.isInitialized()) {
+        result = catalog.freshPerceptualHashes(filePaths);
+    }
+
+    QStringList missing;
+    for (const QString& path : filePaths) {
+        if (!result.contains(path)) missing << path;
+    }
+
+    // The quickest small decode: RAW and HEIF previews, JPEG at 1/8 scale;
+    // several at once. Called from the duplicate pass on an AI worker, whose
+    // wait runs these too rather than blocking it.
+    const bool keep = catalog.isInitialized();
+    std::vector<std::optional<quint64>> computed(size_t(missing.size()));
+    {
+        TaskGroup tasks(TaskScheduler::AI);
+        for (int i = 0; i < missing.size(); ++i) {
+            tasks.start([&computed, &missing, keep, i]() {
+                const QString& path = missing[i];
+                auto image = ImageLoader::instance().loadPreview(path, QSize(DECODE_EDGE, DECODE_EDGE));
+                if (!image || image->isNull()) return;
+                const quint64 bits = compute(*image);
+                if (keep) store(path, bits);
+                computed[size_t(i)] = bits;
+            });
+        }
+        tasks.waitForDone();
+    }
+    for (int i = 0; i < missing.size(); ++i) {
+        if (computed[i]) result.insert(missing[i], *computed[i]);
+    }
+    return result;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <optional>
+
+namespace PhotoGuru {
+
+/**
+ * @brief 64-bit perceptual hashes, for finding duplicates without a model
+ *
+ * compute() is the DCT hash (pHash): the image shrunk to 32x32 gray, its
+ * 8x8 lowest frequencies, one bit per coefficient above their median.
+ * Resizing, recompression and small exposure or colour changes flip few
+ * bits; different photos differ in about half of them. distance() counts
+ * the differing bits.
+ *
+ * Hashes are kept in the catalog, keyed by path + mtime + size like
+ * fingerprints. record() stores one from a decode made anyway (the
+ * thumbnail's), so an ingested library needs no decodes to be searched;
+ * hashes() decodes small only what the catalog lacks.
+ *
+ * Thread-safe. Without a catalog nothing is kept.
+ */
+class PerceptualHash {
+public:
+    static PerceptualHash& instance();
+
+    // Hashes of every readable file of `filePaths`
+    QHash<QString, quint64> hashes(const QStringList& filePaths);
+    std::optional<quint64> hash(const QString& filePath);
+
+    // Stores the hash of `decoded`, the file's current pixels at any size
+    void record(const QString& filePath, const QImage& decoded);
+
+    static quint64 compute(const QImage& image);
+    static int distance(quint64 a, quint64 b);
+
+    static constexpr int DECODE_EDGE = 64;  // Enough pixels for the 32x32 reduction
+
+private:
+    PerceptualHash() = default;
+    PerceptualHash(const PerceptualHash&) = delete;
+    PerceptualHash& operator=(const PerceptualHash&) = delete;
+
+    static void store(const QString& filePath, quint64 hash);
+};
+
+} // namespace PhotoGuru
@@ -1,38 +1,1492 @@
 #include "PhotoDatabase.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QFileInfo>
+#include <QDir>
+#include <QThread>
+#include <QDateTime>
+#include <QUuid>
 #include <QDebug>
+#include <algorithm>
+#include <cstring>
 
 namespace PhotoGuru {
 
+namespace {
+
+QJsonObject semanticKeyToJson(const SemanticKeyData& key) {
+    QJsonObject obj;
+    obj["key_id"] = key.key_id;
+    obj["role"] = key.role;
+    obj["metadata"] = key.metadata;
+    return obj;
+}
+
+SemanticKeyData semanticKeyFromJson(const QJsonObject& obj) {
+    SemanticKeyData key;
+    key.key_id = obj["key_id"].toString();
+    key.role = obj["role"].toString();
+    key.metadata = obj["metadata"].toObject();
+    return key;
+}
+
+// Embeddings are stored as their raw floats
+QByteArray floatsToBlob(const std::vector<float>& values) {
+    return QByteArray(reinterpret_cast<const char*>(values.data()), qsizetype(values.size() * sizeof(float)));
+}
+
+std::vector<float> blobToFloats(const QByteArray& blob) {
+    std::vector<float> values(size_t(blob.size()) / sizeof(float));
+    std::memcpy(values.data(), blob.constData(), values.size() * sizeof(float));
+    return values;
+}
+
+QJsonObject technicalToJson(const TechnicalMetadata& tech) {
+    QJsonObject obj;
+    obj["sharpness_score"] = tech.sharpness_score;
+    obj["exposure_quality"] = tech.exposure_quality;
+    obj["aesthetic_score"] = tech.aesthetic_score;
+    obj["overall_quality"] = tech.overall_quality;
+    obj["duplicate_group"] = tech.duplicate_group;
+    obj["burst_group"] = tech.burst_group;
+    obj["burst_position"] = tech.burst_position;
+    obj["is_best_in_burst"] = tech.is_best_in_burst;
+    obj["face_count"] = tech.face_count;
+    obj["blur_detected"] = tech.blur_detected;
+    obj["highlights_clipped"] = tech.highlights_clipped;
+    obj["shadows_blocked"] = tech.shadows_blocked;
+    return obj;
+}
+
+TechnicalMetadata technicalFromJson(const QJsonObject& obj) {
+    TechnicalMetadata tech;
+    tech.sharpness_score = obj["sharpness_score"].toDouble();
+    tech.exposure_quality = obj["exposure_quality"].toDouble();
+    tech.aesthetic_score = obj["aesthetic_score"].toDouble();
+    tech.overall_quality = obj["overall_quality"].toDouble();
+    tech.duplicate_group = obj["duplicate_group"].toString();
+    tech.burst_group = obj["burst_group"].toString();
+    tech.burst_position = obj["burst_position"].toInt(-1);
+    tech.is_best_in_burst = obj["is_best_in_burst"].toBool();
+    tech.face_count = obj["face_count"].toInt();
+    tech.blur_detected = obj["blur_detected"].toBool();
+    tech.highlights_clipped = obj["highlights_clipped"].toBool();
+    tech.shadows_blocked = obj["shadows_blocked"].toBool();
+    return tech;
+}
+
+QByteArray serializeMetadata(const PhotoMetadata& meta) {
+    QJsonObject obj;
+    obj["filename"] = meta.filename;
+    if (meta.datetime_original.isValid()) {
+        obj["datetime_original"] = meta.datetime_original.toString(Qt::ISODateWithMs);
+    }
+    obj["camera_make"] = meta.camera_make;
+    obj["camera_model"] = meta.camera_model;
+    obj["gps_lat"] = meta.gps_lat;
+    obj["gps_lon"] = meta.gps_lon;
+    obj["location_name"] = meta.location_name;
+    obj["aperture"] = meta.aperture;
+    obj["shutter_speed"] = meta.shutter_speed;
+    obj["iso"] = meta.iso;
+    obj["focal_length"] = meta.focal_length;
+    obj["sequence_number"] = meta.sequence_number;
+    obj["burst_id"] = meta.burst_id;
+
+    obj["llm_title"] = meta.llm_title;
+    obj["llm_description"] = meta.llm_description;
+    obj["llm_keywords"] = QJsonArray::fromStringList(meta.llm_keywords);
+    obj["llm_category"] = meta.llm_category;
+    obj["llm_scene"] = meta.llm_scene;
+    obj["llm_mood"] = meta.llm_mood;
+
+    obj["technical"] = technicalToJson(meta.technical);
+    obj["rating"] = meta.rating;
+    obj["face_count"] = meta.face_count;
+
+    if (meta.skp_image_key) {
+        obj["skp_image_key"] = semanticKeyToJson(*meta.skp_image_key);
+    }
+    QJsonArray personKeys;
+    for (const auto& key : meta.skp_person_keys) {
+        personKeys.append(semanticKeyToJson(key));
+    }
+    obj["skp_person_keys"] = personKeys;
+    obj["skp_group_keys"] = QJsonArray::fromStringList(meta.skp_group_keys);
+    obj["skp_global_key"] = meta.skp_global_key;
+
+    obj["group_id"] = meta.group_id;
+    obj["group_context"] = meta.group_context;
+
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
+
+PhotoMetadata deserializeMetadata(const QString& filePath, const QByteArray& data) {
+    PhotoMetadata meta;
+    QJsonObject obj = QJsonDocument::fromJson(data).object();
+
+    meta.filepath = filePath;
+    meta.filename = obj["filename"].toString();
+    QString dateStr = obj["datetime_original"].toString();
+    if (!dateStr.isEmpty()) {
+        meta.datetime_original = QDateTime::fromString(dateStr, Qt::ISODateWithMs);
+    }
+    meta.camera_make = obj["camera_make"].toString();
+    meta.camera_model = obj["camera_model"].toString();
+    meta.gps_lat = obj["gps_lat"].toDouble();
+    meta.gps_lon = obj["gps_lon"].toDouble();
+    meta.location_name = obj["location_name"].toString();
+    meta.aperture = obj["aperture"].toDouble();
+    meta.shutter_speed = obj["shutter_speed"].toDouble();
+    meta.iso = obj["iso"].toInt();
+    meta.focal_length = obj["focal_length"].toDouble();
+    meta.sequence_number = obj["sequence_number"].toInt();
+    meta.burst_id = obj["burst_id"].toString();
+
+    meta.llm_title = obj["llm_title"].toString();
+    meta.llm_description = obj["llm_description"].toString();
+    for (const QJsonValue& kw : obj["llm_keywords"].toArray()) {
+        meta.llm_keywords << kw.toString();
+    }
+    meta.llm_category = obj["llm_category"].toString();
+    meta.llm_scene = obj["llm_scene"].toString();
+    meta.llm_mood = obj["llm_mood"].toString();
+
+    meta.technical = technicalFromJson(obj["technical"].toObject());
+    meta.rating = obj["rating"].toInt();
+    meta.face_count = obj["face_count"].toInt();
+
+    if (obj.contains("skp_image_key")) {
+        meta.skp_image_key = semanticKeyFromJson(obj["skp_image_key"].toObject());
+    }
+    for (const QJsonValue& key : obj["skp_person_keys"].toArray()) {
+        meta.skp_person_keys.push_back(semanticKeyFromJson(key.toObject()));
+    }
+    for (const QJsonValue& key : obj["skp_group_keys"].toArray()) {
+        meta.skp_group_keys << key.toString();
+    }
+    meta.skp_global_key = obj["skp_global_key"].toString();
+
+    meta.group_id = obj["group_id"].toString();
+    meta.group_context = obj["group_context"].toObject();
+
+    return meta;
+}
+
+} // namespace
+
 PhotoDatabase& PhotoDatabase::instance() {
     static PhotoDatabase db;
     return db;
 }
 
 bool PhotoDatabase::initialize(const QString& dbPath) {
-    if (m_initialized) return true;
-    
-    // SQLite catalog for future expansion
-    // This would store:
-    // - Image metadata cache for fast filtering
-    // - Semantic keys and embeddings
-    // - Analysis results and user ratings
-    // - Collections and smart albums
-    
-    // For now, metadata is read directly from files via exiftool
-    // which is more reliable and doesn't require sync
-    qDebug() << "PhotoDatabase: Using direct file metadata reading";
-    qDebug() << "               Catalog functionality available for future expansion";
-    
-    // Mark as initialized but don't actually use DB yet
-    m_initialized = false;  // Set to true when SQLite implementation is added
-    return true;  // Return true to not block app functionality
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_initialized) return true;
+
+        QFileInfo dbInfo(dbPath);
+        if (!QDir().mkpath(dbInfo.absolutePath())) {
+            qWarning() << "PhotoDatabase: Cannot create catalog directory" << dbInfo.absolutePath();
+            return false;
+        }
+
+        m_dbPath = dbPath;
+        m_initialized = true;
+    }
+
+    QSqlDatabase db = connection();
+    if (!db.isOpen() || !createSchema(db)) {
+        close();
+        return false;
+    }
+
+    qDebug() << "PhotoDatabase: Catalog opened at" << dbPath;
+    return true;
 }
 
 void PhotoDatabase::close() {
-    if (m_initialized) {
-        m_db.close();
-        m_initialized = false;
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_initialized) {
+        return;
+    }
+
+    for (const QString& name : m_connectionNames) {
+        {
+            QSqlDatabase db = QSqlDatabase::database(name, false);
+            if (db.isOpen()) {
+                db.close();
+            }
+        }
+        QSqlDatabase::removeDatabase(name);
+    }
+    m_connectionNames.clear();
+    m_initialized = false;
+}
+
+bool PhotoDatabase::isInitialized() const {
+    QMutexLocker locker(&m_mutex);
+    return m_initialized;
+}
+
+QSqlDatabase PhotoDatabase::connection() {
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_initialized) {
+        return QSqlDatabase();
+    }
+
+    // One connection per thread, named uniquely: pool threads expire and
+    // come back at the same address, and must not find a dead thread's one
+    thread_local QString threadConnection;
+    if (m_connectionNames.contains(threadConnection)) {
+        return QSqlDatabase::database(threadConnection);
+    }
+
+    const QString name = QString("photoguru_catalog_%1").arg(++m_connectionSerial);
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+    db.setDatabaseName(m_dbPath);
+    if (!db.open()) {
+        qWarning() << "PhotoDatabase: Failed to open" << m_dbPath << ":" << db.lastError().text();
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+        return QSqlDatabase();
+    }
+
+    // WAL lets the preload worker write while the UI thread reads
+    QSqlQuery pragma(db);
+    pragma.exec("PRAGMA journal_mode=WAL");
+    pragma.exec("PRAGMA synchronous=NORMAL");
+    pragma.exec("PRAGMA busy_timeout=5000");
+
+    m_connectionNames.insert(name);
+    threadConnection = name;
+    // Emitted on the thread itself, after its last query
+    QThread* thread = QThread::currentThread();
+    QObject::connect(thread, &QThread::finished, thread, [this, name]() {
+        removeConnection(name);
+    }, Qt::DirectConnection);
+    return db;
+}
+
+void PhotoDatabase::removeConnection(const QString& name) {
+    QMutexLocker locker(&m_mutex);
+    if (!m_connectionNames.remove(name)) return;  // Went with close()
+    {
+        QSqlDatabase db = QSqlDatabase::database(name, false);
+        if (db.isOpen()) {
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(name);
+}
+
+bool PhotoDatabase::createSchema(QSqlDatabase& db) {
+    QSqlQuery query(db);
+
+    if (!query.exec("PRAGMA user_version") || !query.next()) {
+        qWarning() << "PhotoDatabase: Cannot read schema version:" << query.lastError().text();
+        return false;
+    }
+    int version = query.value(0).toInt();
+
+    if (version > SCHEMA_VERSION) {
+        qWarning() << "PhotoDatabase: Catalog schema" << version << "is newer than supported" << SCHEMA_VERSION;
+        return false;
+    }
+
+    if (!query.exec(
+            "CREATE TABLE IF NOT EXISTS photos ("
+            "  path TEXT PRIMARY KEY,"
+            "  mtime INTEGER NOT NULL,"
+            "  size INTEGER NOT NULL,"
+            "  metadata BLOB NOT NULL,"
+            "  updated_at INTEGER NOT NULL"
+            ")")) {
+        qWarning() << "PhotoDatabase: Failed to create photos table:" << query.lastError().text();
+        return false;
+    }
+
+    if (!query.exec(
+            "CREATE TABLE IF NOT EXISTS fingerprints ("
+            "  path TEXT PRIMARY KEY,"
+            "  mtime INTEGER NOT NULL,"
+            "  size INTEGER NOT NULL,"
+            "  quick BLOB NOT NULL,"
+            "  full BLOB"
+            ")") ||
+        !query.exec("CREATE INDEX IF NOT EXISTS fingerprints_quick ON fingerprints (quick)")) {
+        qWarning() << "PhotoDatabase: Failed to create fingerprints table:" << query.lastError().text();
+        return false;
+    }
+
+    if (!query.exec(
+            "CREATE TABLE IF NOT EXISTS perceptual_hashes ("
+            "  path TEXT PRIMARY KEY,"
+            "  mtime INTEGER NOT NULL,"
+            "  size INTEGER NOT NULL,"
+            "  hash INTEGER NOT NULL"
+            ")")) {
+        qWarning() << "PhotoDatabase: Failed to create perceptual hash table:" << query.lastError().text();
+        return false;
+    }
+
+    if (!query.exec(
+            "CREATE TABLE IF NOT EXISTS face_scans ("
+            "  path TEXT PRIMARY KEY,"
+            "  mtime INTEGER NOT NULL,"
+            "  size INTEGER NOT NULL,"
+            "  faces INTEGER NOT NULL"
+            ")") ||
+        !query.exec(
+            "CREATE TABLE IF NOT EXISTS faces ("
+            "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "  path TEXT NOT NULL,"
+            "  x REAL NOT NULL,"
+            "  y REAL NOT NULL,"
+            "  width REAL NOT NULL,"
+            "  height REAL NOT NULL,"
+            "  score REAL NOT NULL,"
+            "  embedding BLOB,"
+            "  person INTEGER NOT NULL DEFAULT 0"
+            ")") ||
+        !query.exec("CREATE INDEX IF NOT EXISTS faces_path ON faces (path)") ||
+        !query.exec("CREATE INDEX IF NOT EXISTS faces_person ON faces (person)") ||
+        !query.exec(
+            "CREATE TABLE IF NOT EXISTS people ("
+            "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "  centroid BLOB NOT NULL,"
+            "  faces INTEGER NOT NULL"
+            ")")) {
+        qWarning() << "PhotoDatabase: Failed to create face tables:" << query.lastError().text();
+        return false;
+    }
+
+    if (!query.exec(
+            "CREATE TABLE IF NOT EXISTS analysis_jobs ("
+            "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "  root TEXT NOT NULL UNIQUE,"
+            "  started_at INTEGER NOT NULL,"
+            "  finished_at INTEGER"
+            ")") ||
+        !query.exec(
+            "CREATE TABLE IF NOT EXISTS analysis_job_files ("
+            "  job_id INTEGER NOT NULL,"
+            "  path TEXT NOT NULL,"
+            "  mtime INTEGER NOT NULL,"
+            "  size INTEGER NOT NULL,"
+            "  stages INTEGER NOT NULL DEFAULT 0,"
+            "  caption TEXT,"
+            "  models TEXT NOT NULL DEFAULT '',"
+            "  PRIMARY KEY (job_id, path)"
+            ")")) {
+        qWarning() << "PhotoDatabase: Failed to create analysis job tables:" << query.lastError().text();
+        return false;
+    }
+
+    // Version 3 rows predate model stamps; '' matches no model, so they are redone
+    if (version == 3 && !query.exec("ALTER TABLE analysis_job_files ADD COLUMN models TEXT NOT NULL DEFAULT ''")) {
+        qWarning() << "PhotoDatabase: Failed to add job model stamps:" << query.lastError().text();
+        return false;
+    }
+
+    if (!query.exec(
+            "CREATE TABLE IF NOT EXISTS skp_keys ("
+            "  key_id TEXT NOT NULL,"
+            "  path TEXT NOT NULL,"
+            "  kind TEXT NOT NULL,"
+            "  role TEXT NOT NULL,"
+            "  PRIMARY KEY (key_id, path, kind)"
+            ") WITHOUT ROWID") ||
+        !query.exec("CREATE INDEX IF NOT EXISTS skp_keys_path ON skp_keys (path)")) {
+        qWarning() << "PhotoDatabase: Failed to create SKP key index:" << query.lastError().text();
+        return false;
+    }
+
+    // Catalogs from before the key index: build it once from the stored metadata
+    if (version > 0 && version < 5) {
+        db.transaction();
+        QSqlQuery photos(db);
+        photos.setForwardOnly(true);
+        if (!photos.exec("SELECT path, metadata FROM photos")) {
+            qWarning() << "PhotoDatabase: Failed to read photos for the SKP key index:" << photos.lastError().text();
+            db.rollback();
+            return false;
+        }
+        while (photos.next()) {
+            const QString path = photos.value(0).toString();
+            if (!indexSemanticKeys(db, path, deserializeMetadata(path, photos.value(1).toByteArray()))) {
+                db.rollback();
+                return false;
+            }
+        }
+        db.commit();
+    }
+
+    // Change log: one row per path, moved to a new sequence number by every
+    // write. `removed` marks a deleted photo row; fingerprints and hashes
+    // are logged too, so a path without a photo row need not be one
+    if (!query.exec(
+            "CREATE TABLE IF NOT EXISTS catalog_changes ("
+            "  seq INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "  path TEXT NOT NULL UNIQUE,"
+            "  removed INTEGER NOT NULL DEFAULT 0"
+            ")") ||
+        !query.exec(
+            "CREATE TABLE IF NOT EXISTS catalog_info ("
+            "  name TEXT PRIMARY KEY,"
+            "  value TEXT NOT NULL"
+            ")") ||
+        !query.exec(
+            "CREATE TABLE IF NOT EXISTS sync_cursors ("
+            "  name TEXT PRIMARY KEY,"
+            "  origin TEXT NOT NULL,"
+            "  position INTEGER NOT NULL"
+            ")")) {
+        qWarning() << "PhotoDatabase: Failed to create change log tables:" << query.lastError().text();
+        return false;
+    }
+
+    // Catalogs logged without it: a path gone from every logged table was a
+    // removal (one whose fingerprint stayed is kept, the safe way to be
+    // wrong), and the triggers are recreated to record the flag
+    if (version >= 8 && version < 10) {
+        if (!query.exec("ALTER TABLE catalog_changes ADD COLUMN removed INTEGER NOT NULL DEFAULT 0") ||
+            !query.exec("UPDATE catalog_changes SET removed = 1 WHERE"
+                        " path NOT IN (SELECT path FROM photos) AND"
+                        " path NOT IN (SELECT path FROM fingerprints) AND"
+                        " path NOT IN (SELECT path FROM perceptual_hashes)")) {
+            qWarning() << "PhotoDatabase: Failed to add removals to the change log:" << query.lastError().text();
+            return false;
+        }
+        for (const char* trigger : {"photos_log_insert", "photos_log_update", "photos_log_delete",
+                                    "fingerprints_log_insert", "fingerprints_log_update",
+                                    "perceptual_hashes_log_insert", "perceptual_hashes_log_update"}) {
+            query.exec(QString("DROP TRIGGER IF EXISTS %1").arg(trigger));
+        }
+    }
+
+    // Photo writes set or clear `removed`; fingerprint and hash writes keep it
+    const QString logChange = "INSERT OR REPLACE INTO catalog_changes (path, removed) VALUES (%1.path, %2)";
+    const QString keepRemoved = "COALESCE((SELECT removed FROM catalog_changes WHERE path = NEW.path), 0)";
+    const QList<std::pair<QString, QString>> triggers = {
+        {"photos", "INSERT"}, {"photos", "UPDATE"}, {"photos", "DELETE"},
+        {"fingerprints", "INSERT"}, {"fingerprints", "UPDATE"},
+        {"perceptual_hashes", "INSERT"}, {"perceptual_hashes", "UPDATE"},
+    };
+    for (const auto& [table, event] : triggers) {
+        const QString log = event == "DELETE" ? logChange.arg("OLD", "1")
+                          : table == "photos" ? logChange.arg("NEW", "0")
+                                              : logChange.arg("NEW", keepRemoved);
+        const QString sql = QString("CREATE TRIGGER IF NOT EXISTS %1_log_%2 AFTER %3 ON %1 BEGIN %4; END")
+            .arg(table, event.toLower(), event, log);
+        if (!query.exec(sql)) {
+            qWarning() << "PhotoDatabase: Failed to create change log trigger:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    // Catalogs from before the change log: everything in them is one change
+    if (version > 0 && version < 8) {
+        for (const char* table : {"photos", "fingerprints", "perceptual_hashes"}) {
+            if (!query.exec(QString("INSERT OR IGNORE INTO catalog_changes (path) SELECT path FROM %1").arg(table))) {
+                qWarning() << "PhotoDatabase: Failed to seed the change log:" << query.lastError().text();
+                return false;
+            }
+        }
+    }
+
+    if (!query.exec(
+            "CREATE TABLE IF NOT EXISTS smart_albums ("
+            "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "  name TEXT NOT NULL UNIQUE,"
+            "  criteria TEXT NOT NULL,"
+            "  created_at INTEGER NOT NULL"
+            ")") ||
+        !query.exec(
+            "CREATE TABLE IF NOT EXISTS smart_album_photos ("
+            "  album_id INTEGER NOT NULL,"
+            "  path TEXT NOT NULL,"
+            "  PRIMARY KEY (album_id, path)"
+            ") WITHOUT ROWID") ||
+        !query.exec("CREATE INDEX IF NOT EXISTS smart_album_photos_path ON smart_album_photos (path)")) {
+        qWarning() << "PhotoDatabase: Failed to create smart album tables:" << query.lastError().text();
+        return false;
+    }
+
+    query.prepare("INSERT OR IGNORE INTO catalog_info (name, value) VALUES ('id', ?)");
+    query.addBindValue(QUuid::createUuid().toString(QUuid::WithoutBraces));
+    if (!query.exec()) {
+        qWarning() << "PhotoDatabase: Failed to record the catalog id:" << query.lastError().text();
+        return false;
+    }
+
+    query.exec(QString("PRAGMA user_version = %1").arg(SCHEMA_VERSION));
+    return true;
+}
+
+bool PhotoDatabase::indexSemanticKeys(QSqlDatabase& db, const QString& path, const PhotoMetadata& meta) {
+    QSqlQuery query(db);
+    query.prepare("DELETE FROM skp_keys WHERE path = ?");
+    query.addBindValue(path);
+    if (!query.exec()) {
+        qWarning() << "PhotoDatabase: Failed to clear SKP keys of" << path << ":" << query.lastError().text();
+        return false;
+    }
+
+    // Same kinds and roles SKPBrowser shows
+    QList<std::pair<QString, SemanticKeyData>> keys;
+    if (meta.skp_image_key) keys.append({"image", *meta.skp_image_key});
+    for (const SemanticKeyData& key : meta.skp_person_keys) keys.append({"person", key});
+    for (const QString& keyId : meta.skp_group_keys) keys.append({"group", SemanticKeyData{keyId, "link", {}}});
+    if (!meta.skp_global_key.isEmpty()) {
+        keys.append({"global", SemanticKeyData{meta.skp_global_key, "anchor", {}}});
+    }
+
+    query.prepare("INSERT OR IGNORE INTO skp_keys (key_id, path, kind, role) VALUES (?, ?, ?, ?)");
+    for (const auto& [kind, key] : keys) {
+        if (key.key_id.isEmpty()) continue;
+        query.addBindValue(key.key_id);
+        query.addBindValue(path);
+        query.addBindValue(kind);
+        query.addBindValue(key.role);
+        if (!query.exec()) {
+            qWarning() << "PhotoDatabase: Failed to index SKP key" << key.key_id << ":" << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<PhotoDatabase::SmartAlbum> PhotoDatabase::loadSmartAlbums(QSqlDatabase& db) {
+    std::vector<SmartAlbum> albums;
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT id, name, criteria FROM smart_albums ORDER BY name")) return albums;
+    while (query.next()) {
+        SmartAlbum album;
+        album.id = query.value(0).toLongLong();
+        album.name = query.value(1).toString();
+        album.criteria = FilterCriteria::fromJson(QJsonDocument::fromJson(query.value(2).toByteArray()).object());
+        albums.push_back(std::move(album));
+    }
+    return albums;
+}
+
+bool PhotoDatabase::indexSmartAlbums(QSqlDatabase& db, const QString& path, const PhotoMetadata& meta,
+                                     const std::vector<SmartAlbum>& albums) {
+    if (albums.empty()) return true;
+
+    QSqlQuery add(db);
+    add.prepare("INSERT OR IGNORE INTO smart_album_photos (album_id, path) VALUES (?, ?)");
+    QSqlQuery drop(db);
+    drop.prepare("DELETE FROM smart_album_photos WHERE album_id = ? AND path = ?");
+    for (const SmartAlbum& album : albums) {
+        QSqlQuery& query = album.criteria.matches(meta) ? add : drop;
+        query.addBindValue(album.id);
+        query.addBindValue(path);
+        if (!query.exec()) {
+            qWarning() << "PhotoDatabase: Failed to update smart album" << album.name << ":" << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PhotoDatabase::fillSmartAlbum(QSqlDatabase& db, const SmartAlbum& album) {
+    QSqlQuery query(db);
+    query.prepare("DELETE FROM smart_album_photos WHERE album_id = ?");
+    query.addBindValue(album.id);
+    if (!query.exec()) return false;
+
+    QSqlQuery photos(db);
+    photos.setForwardOnly(true);
+    if (!photos.exec("SELECT path, metadata FROM photos")) {
+        qWarning() << "PhotoDatabase: Failed to read photos for smart album" << album.name << ":"
+                   << photos.lastError().text();
+        return false;
+    }
+    query.prepare("INSERT INTO smart_album_photos (album_id, path) VALUES (?, ?)");
+    while (photos.next()) {
+        const QString path = photos.value(0).toString();
+        if (!album.criteria.matches(deserializeMetadata(path, photos.value(1).toByteArray()))) continue;
+        query.addBindValue(album.id);
+        query.addBindValue(path);
+        if (!query.exec()) return false;
     }
+    return true;
+}
+
+void PhotoDatabase::applyFaceScan(QSqlDatabase& db, const QString& path, qint64 mtime, qint64 size,
+                                  PhotoMetadata& meta) {
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT faces FROM face_scans WHERE path = ? AND mtime = ? AND size = ?");
+    query.addBindValue(path);
+    query.addBindValue(mtime);
+    query.addBindValue(size);
+    if (!query.exec() || !query.next()) return;
+    meta.face_count = query.value(0).toInt();
+    meta.technical.face_count = meta.face_count;
+
+    // Person keys from earlier clustering are replaced; keys from other tools stay
+    auto ours = [](const SemanticKeyData& key) { return key.metadata.value("source").toString() == "faces"; };
+    meta.skp_person_keys.erase(std::remove_if(meta.skp_person_keys.begin(), meta.skp_person_keys.end(), ours),
+                               meta.skp_person_keys.end());
+
+    query.prepare("SELECT person, COUNT(*) FROM faces WHERE path = ? AND person > 0 GROUP BY person ORDER BY person");
+    query.addBindValue(path);
+    if (!query.exec()) return;
+    while (query.next()) {
+        QJsonObject keyMetadata{{"source", "faces"}, {"faces", query.value(1).toInt()}};
+        meta.skp_person_keys.push_back(SemanticKeyData{personKey(query.value(0).toLongLong()), "anchor", keyMetadata});
+    }
+}
+
+bool PhotoDatabase::storeMetadata(const PhotoMetadata& meta) {
+    return storeMetadataBatch({meta});
+}
+
+bool PhotoDatabase::storeMetadataBatch(const QList<PhotoMetadata>& metas) {
+    return storeMetadataRows(metas, true);
+}
+
+bool PhotoDatabase::storeReadMetadata(const QList<PhotoMetadata>& metas) {
+    return storeMetadataRows(metas, false);
+}
+
+bool PhotoDatabase::storeMetadataRows(const QList<PhotoMetadata>& metas, bool statNow) {
+    if (metas.isEmpty()) return true;
+
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.prepare("INSERT OR REPLACE INTO photos (path, mtime, size, metadata, updated_at) "
+                  "VALUES (?, ?, ?, ?, ?)");
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    const std::vector<SmartAlbum> albums = loadSmartAlbums(db);
+    for (const PhotoMetadata& meta : metas) {
+        QFileInfo info(meta.filepath);
+        qint64 mtime = meta.file_mtime;
+        qint64 size = meta.file_size;
+        if (statNow) {
+            if (!info.exists()) continue;
+            mtime = info.lastModified().toMSecsSinceEpoch();
+            size = info.size();
+        } else if (size < 0) {
+            continue;
+        }
+
+        const QString path = info.absoluteFilePath();
+        PhotoMetadata stored = meta;
+        applyFaceScan(db, path, mtime, size, stored);
+
+        query.addBindValue(path);
+        query.addBindValue(mtime);
+        query.addBindValue(size);
+        query.addBindValue(serializeMetadata(stored));
+        query.addBindValue(now);
+
+        if (!query.exec()) {
+            qWarning() << "PhotoDatabase: Failed to store" << meta.filepath << ":" << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+        if (!indexSemanticKeys(db, path, stored) || !indexSmartAlbums(db, path, stored, albums)) {
+            db.rollback();
+            return false;
+        }
+    }
+
+    return db.commit();
+}
+
+std::optional<PhotoMetadata> PhotoDatabase::cachedMetadata(const QString& filePath) {
+    auto result = loadFreshMetadata({filePath});
+    auto it = result.find(filePath);
+    if (it == result.end()) {
+        return std::nullopt;
+    }
+    return it.value();
+}
+
+QHash<QString, PhotoMetadata> PhotoDatabase::loadFreshMetadata(const QStringList& filePaths) {
+    QHash<QString, PhotoMetadata> result;
+
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return result;
+
+    // Single read transaction keeps lookups on one snapshot and avoids
+    // per-statement lock churn
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT mtime, size, metadata FROM photos WHERE path = ?");
+
+    for (const QString& filePath : filePaths) {
+        QFileInfo info(filePath);
+        if (!info.exists()) continue;
+
+        query.addBindValue(info.absoluteFilePath());
+        if (!query.exec() || !query.next()) continue;
+
+        qint64 mtime = query.value(0).toLongLong();
+        qint64 size = query.value(1).toLongLong();
+
+        // Stale entry: file changed since it was cataloged
+        if (mtime != info.lastModified().toMSecsSinceEpoch() || size != info.size()) {
+            continue;
+        }
+
+        PhotoMetadata meta = deserializeMetadata(filePath, query.value(2).toByteArray());
+        meta.file_mtime = mtime;
+        meta.file_size = size;
+        result.insert(filePath, std::move(meta));
+    }
+
+    db.commit();
+    return result;
+}
+
+bool PhotoDatabase::storeFingerprint(const Fingerprint& fingerprint) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    QSqlQuery query(db);
+    query.prepare("INSERT OR REPLACE INTO fingerprints (path, mtime, size, quick, full) "
+                  "VALUES (?, ?, ?, ?, ?)");
+    query.addBindValue(QFileInfo(fingerprint.path).absoluteFilePath());
+    query.addBindValue(fingerprint.mtime);
+    query.addBindValue(fingerprint.size);
+    query.addBindValue(fingerprint.quick);
+    query.addBindValue(fingerprint.full.isEmpty() ? QVariant() : QVariant(fingerprint.full));
+    if (!query.exec()) {
+        qWarning() << "PhotoDatabase: Failed to store fingerprint of" << fingerprint.path << ":" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+std::optional<PhotoDatabase::Fingerprint> PhotoDatabase::freshFingerprint(const QString& filePath) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return std::nullopt;
+
+    QFileInfo info(filePath);
+    if (!info.exists()) return std::nullopt;
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT mtime, size, quick, full FROM fingerprints WHERE path = ?");
+    query.addBindValue(info.absoluteFilePath());
+    if (!query.exec() || !query.next()) return std::nullopt;
+
+    Fingerprint fingerprint;
+    fingerprint.path = info.absoluteFilePath();
+    fingerprint.mtime = query.value(0).toLongLong();
+    fingerprint.size = query.value(1).toLongLong();
+    if (fingerprint.mtime != info.lastModified().toMSecsSinceEpoch() || fingerprint.size != info.size()) {
+        return std::nullopt;
+    }
+    fingerprint.quick = query.value(2).toByteArray();
+    fingerprint.full = query.value(3).toByteArray();
+    return fingerprint;
+}
+
+QList<PhotoDatabase::Fingerprint> PhotoDatabase::fingerprintsMatching(const QByteArray& quick) {
+    QList<Fingerprint> result;
+    QSqlDatabase db = connection();
+    if (!db.isOpen() || quick.isEmpty()) return result;
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT path, mtime, size, full FROM fingerprints WHERE quick = ?");
+    query.addBindValue(quick);
+    if (!query.exec()) return result;
+
+    while (query.next()) {
+        Fingerprint fingerprint;
+        fingerprint.path = query.value(0).toString();
+        fingerprint.mtime = query.value(1).toLongLong();
+        fingerprint.size = query.value(2).toLongLong();
+        fingerprint.quick = quick;
+        fingerprint.full = query.value(3).toByteArray();
+        result << fingerprint;
+    }
+    return result;
+}
+
+bool PhotoDatabase::storePerceptualHash(const QString& filePath, qint64 mtime, qint64 size, quint64 hash) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    QSqlQuery query(db);
+    query.prepare("INSERT OR REPLACE INTO perceptual_hashes (path, mtime, size, hash) VALUES (?, ?, ?, ?)");
+    query.addBindValue(QFileInfo(filePath).absoluteFilePath());
+    query.addBindValue(mtime);
+    query.addBindValue(size);
+    query.addBindValue(qint64(hash));  // SQLite integers are signed; the bits round-trip
+    if (!query.exec()) {
+        qWarning() << "PhotoDatabase: Failed to store perceptual hash of" << filePath << ":" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QHash<QString, quint64> PhotoDatabase::freshPerceptualHashes(const QStringList& filePaths) {
+    QHash<QString, quint64> result;
+
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return result;
+
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT mtime, size, hash FROM perceptual_hashes WHERE path = ?");
+
+    for (const QString& filePath : filePaths) {
+        QFileInfo info(filePath);
+        if (!info.exists()) continue;
+
+        query.addBindValue(info.absoluteFilePath());
+        if (!query.exec() || !query.next()) continue;
+
+        if (query.value(0).toLongLong() != info.lastModified().toMSecsSinceEpoch() ||
+            query.value(1).toLongLong() != info.size()) {
+            continue;
+        }
+        result.insert(filePath, quint64(query.value(2).toLongLong()));
+    }
+
+    db.commit();
+    return result;
+}
+
+bool PhotoDatabase::storeFaces(const QString& filePath, qint64 mtime, qint64 size, const std::vector<Face>& faces) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    const QString path = QFileInfo(filePath).absoluteFilePath();
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.prepare("DELETE FROM faces WHERE path = ?");
+    query.addBindValue(path);
+    bool ok = query.exec();
+
+    query.prepare("INSERT INTO faces (path, x, y, width, height, score, embedding) VALUES (?, ?, ?, ?, ?, ?, ?)");
+    for (size_t i = 0; ok && i < faces.size(); ++i) {
+        const Face& face = faces[i];
+        query.addBindValue(path);
+        query.addBindValue(face.box.x());
+        query.addBindValue(face.box.y());
+        query.addBindValue(face.box.width());
+        query.addBindValue(face.box.height());
+        query.addBindValue(double(face.score));
+        query.addBindValue(face.embedding.empty() ? QVariant() : QVariant(floatsToBlob(face.embedding)));
+        ok = query.exec();
+    }
+
+    if (ok) {
+        query.prepare("INSERT OR REPLACE INTO face_scans (path, mtime, size, faces) VALUES (?, ?, ?, ?)");
+        query.addBindValue(path);
+        query.addBindValue(mtime);
+        query.addBindValue(size);
+        query.addBindValue(int(faces.size()));
+        ok = query.exec();
+    }
+    if (!ok) {
+        qWarning() << "PhotoDatabase: Failed to store faces of" << filePath << ":" << query.lastError().text();
+        db.rollback();
+        return false;
+    }
+    return db.commit();
+}
+
+QHash<QString, int> PhotoDatabase::freshFaceCounts(const QStringList& filePaths) {
+    QHash<QString, int> result;
+
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return result;
+
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT mtime, size, faces FROM face_scans WHERE path = ?");
+
+    for (const QString& filePath : filePaths) {
+        QFileInfo info(filePath);
+        if (!info.exists()) continue;
+
+        query.addBindValue(info.absoluteFilePath());
+        if (!query.exec() || !query.next()) continue;
+
+        if (query.value(0).toLongLong() != info.lastModified().toMSecsSinceEpoch() ||
+            query.value(1).toLongLong() != info.size()) {
+            continue;
+        }
+        result.insert(filePath, query.value(2).toInt());
+    }
+
+    db.commit();
+    return result;
+}
+
+bool PhotoDatabase::keepFaceScan(const QString& filePath) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    QFileInfo info(filePath);
+    if (!info.exists()) return false;
+
+    QSqlQuery query(db);
+    query.prepare("UPDATE face_scans SET mtime = ?, size = ? WHERE path = ?");
+    query.addBindValue(info.lastModified().toMSecsSinceEpoch());
+    query.addBindValue(info.size());
+    query.addBindValue(info.absoluteFilePath());
+    return query.exec() && query.numRowsAffected() > 0;
+}
+
+std::vector<PhotoDatabase::Face> PhotoDatabase::unclusteredFaces(int limit) {
+    std::vector<Face> result;
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return result;
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT id, path, x, y, width, height, score, embedding FROM faces "
+                  "WHERE person = 0 AND embedding IS NOT NULL ORDER BY id LIMIT ?");
+    query.addBindValue(limit);
+    if (!query.exec()) return result;
+
+    while (query.next()) {
+        Face face;
+        face.id = query.value(0).toLongLong();
+        face.path = query.value(1).toString();
+        face.box = QRectF(query.value(2).toDouble(), query.value(3).toDouble(),
+                          query.value(4).toDouble(), query.value(5).toDouble());
+        face.score = query.value(6).toFloat();
+        face.embedding = blobToFloats(query.value(7).toByteArray());
+        result.push_back(std::move(face));
+    }
+    return result;
+}
+
+std::vector<PhotoDatabase::Person> PhotoDatabase::people() {
+    std::vector<Person> result;
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return result;
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT id, centroid, faces FROM people ORDER BY id")) return result;
+
+    while (query.next()) {
+        result.push_back(Person{query.value(0).toLongLong(), blobToFloats(query.value(1).toByteArray()),
+                                query.value(2).toInt()});
+    }
+    return result;
+}
+
+bool PhotoDatabase::storePeople(std::vector<Person>& people, const QHash<qint64, int>& personOfFace) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    // Only the people this batch of faces touched changed
+    QSet<int> touched;
+    for (int index : personOfFace) touched.insert(index);
+    std::vector<int> ordered(touched.begin(), touched.end());
+    std::sort(ordered.begin(), ordered.end());
+
+    db.transaction();
+    QSqlQuery query(db);
+    std::vector<int> inserted;  // Their ids are undone on rollback
+    bool ok = true;
+    for (int index : ordered) {
+        if (index < 0 || index >= int(people.size())) continue;
+        Person& person = people[size_t(index)];
+        if (person.id == 0) {
+            query.prepare("INSERT INTO people (centroid, faces) VALUES (?, ?)");
+        } else {
+            query.prepare("UPDATE people SET centroid = ?, faces = ? WHERE id = ?");
+        }
+        query.addBindValue(floatsToBlob(person.centroid));
+        query.addBindValue(person.faces);
+        if (person.id != 0) query.addBindValue(person.id);
+        ok = query.exec();
+        if (!ok) break;
+        if (person.id == 0) {
+            person.id = query.lastInsertId().toLongLong();
+            inserted.push_back(index);
+        }
+    }
+
+    query.prepare("UPDATE faces SET person = ? WHERE id = ?");
+    for (auto it = personOfFace.cbegin(); ok && it != personOfFace.cend(); ++it) {
+        if (it.value() >= int(people.size())) continue;
+        query.addBindValue(it.value() < 0 ? qint64(-1) : people[size_t(it.value())].id);
+        query.addBindValue(it.key());
+        ok = query.exec();
+    }
+
+    if (!ok || !db.commit()) {
+        qWarning() << "PhotoDatabase: Failed to store people:" << query.lastError().text();
+        db.rollback();
+        for (int index : inserted) people[size_t(index)].id = 0;
+        return false;
+    }
+    return true;
+}
+
+bool PhotoDatabase::refreshFaceMetadata(const QStringList& filePaths) {
+    QHash<QString, PhotoMetadata> fresh = loadFreshMetadata(filePaths);
+    return storeMetadataBatch(fresh.values());  // Applies each file's scan
+}
+
+QString PhotoDatabase::personKey(qint64 personId) {
+    return QString("person-%1").arg(personId);
+}
+
+std::optional<PhotoDatabase::AnalysisJob> PhotoDatabase::openAnalysisJob(const QString& root,
+                                                                       const QStringList& filePaths,
+                                                                       const QString& models,
+                                                                       bool restart) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return std::nullopt;
+
+    const QString rootPath = QFileInfo(root).absoluteFilePath();
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    AnalysisJob job;
+
+    db.transaction();
+    QSqlQuery query(db);
+    query.prepare("SELECT id, finished_at FROM analysis_jobs WHERE root = ?");
+    query.addBindValue(rootPath);
+    if (query.exec() && query.next()) {
+        job.id = query.value(0).toLongLong();
+        job.resumed = query.value(1).isNull() && !restart;
+        query.finish();
+
+        query.prepare("UPDATE analysis_jobs SET started_at = ?, finished_at = NULL WHERE id = ?");
+        query.addBindValue(now);
+        query.addBindValue(job.id);
+        bool ok = query.exec();
+        if (ok && restart) {
+            query.prepare("DELETE FROM analysis_job_files WHERE job_id = ?");
+            query.addBindValue(job.id);
+            ok = query.exec();
+        }
+        if (!ok) {
+            qWarning() << "PhotoDatabase: Failed to reopen analysis job for" << rootPath << ":" << query.lastError().text();
+            db.rollback();
+            return std::nullopt;
+        }
+    } else {
+        query.prepare("INSERT INTO analysis_jobs (root, started_at) VALUES (?, ?)");
+        query.addBindValue(rootPath);
+        query.addBindValue(now);
+        if (!query.exec()) {
+            qWarning() << "PhotoDatabase: Failed to create analysis job for" << rootPath << ":" << query.lastError().text();
+            db.rollback();
+            return std::nullopt;
+        }
+        job.id = query.lastInsertId().toLongLong();
+    }
+
+    QSqlQuery select(db);
+    select.setForwardOnly(true);
+    select.prepare("SELECT mtime, size, stages, caption, models FROM analysis_job_files "
+                   "WHERE job_id = ? AND path = ?");
+    QSqlQuery upsert(db);
+    upsert.prepare("INSERT OR REPLACE INTO analysis_job_files (job_id, path, mtime, size, stages, caption, models) "
+                   "VALUES (?, ?, ?, ?, 0, NULL, ?)");
+
+    for (const QString& filePath : filePaths) {
+        QFileInfo info(filePath);
+        if (!info.exists()) continue;
+        const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+
+        select.addBindValue(job.id);
+        select.addBindValue(info.absoluteFilePath());
+        if (select.exec() && select.next() &&
+            select.value(0).toLongLong() == mtime && select.value(1).toLongLong() == info.size() &&
+            select.value(4).toString() == models) {
+            job.files.insert(filePath, JobFile{select.value(2).toInt(), select.value(3).toString()});
+            continue;
+        }
+
+        // New to the job, changed since its last checkpoint, or analyzed by other models
+        upsert.addBindValue(job.id);
+        upsert.addBindValue(info.absoluteFilePath());
+        upsert.addBindValue(mtime);
+        upsert.addBindValue(info.size());
+        upsert.addBindValue(models);
+        if (!upsert.exec()) {
+            qWarning() << "PhotoDatabase: Failed to queue" << filePath << ":" << upsert.lastError().text();
+            db.rollback();
+            return std::nullopt;
+        }
+        job.files.insert(filePath, JobFile());
+    }
+
+    if (!db.commit()) return std::nullopt;
+    return job;
+}
+
+bool PhotoDatabase::checkpointAnalysisFile(qint64 jobId, const QString& filePath, int stages,
+                                           const QString& caption) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    QFileInfo info(filePath);
+    if (!info.exists()) return false;
+
+    // Re-read the file: writing metadata changes its mtime, and the row
+    // must match the file as the next run will find it
+    QSqlQuery query(db);
+    query.prepare("UPDATE analysis_job_files SET stages = stages | ?, mtime = ?, size = ?, "
+                  "caption = COALESCE(?, caption) WHERE job_id = ? AND path = ?");
+    query.addBindValue(stages);
+    query.addBindValue(info.lastModified().toMSecsSinceEpoch());
+    query.addBindValue(info.size());
+    query.addBindValue(caption.isEmpty() ? QVariant() : QVariant(caption));
+    query.addBindValue(jobId);
+    query.addBindValue(info.absoluteFilePath());
+    if (!query.exec()) {
+        qWarning() << "PhotoDatabase: Failed to checkpoint" << filePath << ":" << query.lastError().text();
+        return false;
+    }
+    return query.numRowsAffected() > 0;
+}
+
+bool PhotoDatabase::finishAnalysisJob(qint64 jobId) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    QSqlQuery query(db);
+    query.prepare("UPDATE analysis_jobs SET finished_at = ? WHERE id = ?");
+    query.addBindValue(QDateTime::currentSecsSinceEpoch());
+    query.addBindValue(jobId);
+    return query.exec();
+}
+
+QList<PhotoDatabase::SemanticKeyRef> PhotoDatabase::photosWithKey(const QString& keyId, const QString& role) {
+    QList<SemanticKeyRef> result;
+    QSqlDatabase db = connection();
+    if (!db.isOpen() || keyId.isEmpty()) return result;
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (role.isEmpty()) {
+        query.prepare("SELECT path, kind, role FROM skp_keys WHERE key_id = ? ORDER BY path");
+        query.addBindValue(keyId);
+    } else {
+        query.prepare("SELECT path, kind, role FROM skp_keys WHERE key_id = ? AND role = ? ORDER BY path");
+        query.addBindValue(keyId);
+        query.addBindValue(role);
+    }
+    if (!query.exec()) return result;
+
+    while (query.next()) {
+        result << SemanticKeyRef{query.value(0).toString(), query.value(1).toString(), query.value(2).toString()};
+    }
+    return result;
+}
+
+bool PhotoDatabase::removePhoto(const QString& filePath) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    const QString path = QFileInfo(filePath).absoluteFilePath();
+    db.transaction();
+
+    QSqlQuery query(db);
+    query.prepare("DELETE FROM photos WHERE path = ?");
+    query.addBindValue(path);
+    if (!query.exec()) {
+        db.rollback();
+        return false;
+    }
+    for (const char* table : {"skp_keys", "faces", "face_scans", "smart_album_photos"}) {
+        query.prepare(QString("DELETE FROM %1 WHERE path = ?").arg(table));
+        query.addBindValue(path);
+        if (!query.exec()) {
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+int PhotoDatabase::photoCount() {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return 0;
+
+    QSqlQuery query(db);
+    if (query.exec("SELECT COUNT(*) FROM photos") && query.next()) {
+        return query.value(0).toInt();
+    }
+    return 0;
+}
+
+QString PhotoDatabase::catalogId() {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return QString();
+
+    QSqlQuery query(db);
+    if (query.exec("SELECT value FROM catalog_info WHERE name = 'id'") && query.next()) {
+        return query.value(0).toString();
+    }
+    return QString();
+}
+
+qint64 PhotoDatabase::changeSequence() {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return 0;
+
+    QSqlQuery query(db);
+    if (query.exec("SELECT COALESCE(MAX(seq), 0) FROM catalog_changes") && query.next()) {
+        return query.value(0).toLongLong();
+    }
+    return 0;
+}
+
+std::vector<PhotoDatabase::CatalogRecord> PhotoDatabase::changesSince(qint64 seq, int limit) {
+    std::vector<CatalogRecord> result;
+    QSqlDatabase db = connection();
+    if (!db.isOpen() || limit <= 0) return result;
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT c.seq, c.path, p.mtime, p.size, p.metadata,"
+                  "       f.mtime, f.size, f.quick, f.full, h.mtime, h.size, h.hash, c.removed "
+                  "FROM catalog_changes c "
+                  "LEFT JOIN photos p ON p.path = c.path "
+                  "LEFT JOIN fingerprints f ON f.path = c.path "
+                  "LEFT JOIN perceptual_hashes h ON h.path = c.path "
+                  "WHERE c.seq > ? ORDER BY c.seq LIMIT ?");
+    query.addBindValue(seq);
+    query.addBindValue(limit);
+    if (!query.exec()) {
+        qWarning() << "PhotoDatabase: Failed to read changes:" << query.lastError().text();
+        return result;
+    }
+
+    while (query.next()) {
+        CatalogRecord record;
+        record.seq = query.value(0).toLongLong();
+        record.path = query.value(1).toString();
+        if (!query.value(4).isNull()) {
+            record.mtime = query.value(2).toLongLong();
+            record.size = query.value(3).toLongLong();
+            record.metadata = query.value(4).toByteArray();
+        } else {
+            record.removed = query.value(12).toBool();
+        }
+        if (!query.value(7).isNull()) {
+            record.fingerprint = Fingerprint{record.path, query.value(5).toLongLong(), query.value(6).toLongLong(),
+                                             query.value(7).toByteArray(), query.value(8).toByteArray()};
+        }
+        if (!query.value(11).isNull()) {
+            record.perceptualHash = PerceptualHashRecord{query.value(9).toLongLong(), query.value(10).toLongLong(),
+                                                         quint64(query.value(11).toLongLong())};
+        }
+        result.push_back(std::move(record));
+    }
+    return result;
+}
+
+bool PhotoDatabase::applyChanges(const std::vector<CatalogRecord>& records) {
+    if (records.empty()) return true;
+
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    db.transaction();
+
+    QSqlQuery photos(db);
+    photos.prepare("INSERT OR REPLACE INTO photos (path, mtime, size, metadata, updated_at) VALUES (?, ?, ?, ?, ?)");
+    QSqlQuery fingerprints(db);
+    fingerprints.prepare("INSERT OR REPLACE INTO fingerprints (path, mtime, size, quick, full) VALUES (?, ?, ?, ?, ?)");
+    QSqlQuery hashes(db);
+    hashes.prepare("INSERT OR REPLACE INTO perceptual_hashes (path, mtime, size, hash) VALUES (?, ?, ?, ?)");
+    QSqlQuery removal(db);
+
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    const std::vector<SmartAlbum> albums = loadSmartAlbums(db);
+    for (const CatalogRecord& record : records) {
+        bool ok = true;
+        if (record.removed) {
+            // Gone from the other catalog: gone here too, as removePhoto() does it
+            for (const char* table : {"photos", "skp_keys", "faces", "face_scans", "smart_album_photos"}) {
+                removal.prepare(QString("DELETE FROM %1 WHERE path = ?").arg(table));
+                removal.addBindValue(record.path);
+                ok = ok && removal.exec();
+            }
+        } else if (!record.metadata.isEmpty()) {
+            // A scan of our own wins, as in storeMetadataBatch(): person ids are per catalog
+            PhotoMetadata meta = deserializeMetadata(record.path, record.metadata);
+            applyFaceScan(db, record.path, record.mtime, record.size, meta);
+
+            photos.addBindValue(record.path);
+            photos.addBindValue(record.mtime);
+            photos.addBindValue(record.size);
+            photos.addBindValue(serializeMetadata(meta));
+            photos.addBindValue(now);
+            ok = photos.exec() && indexSemanticKeys(db, record.path, meta) &&
+                 indexSmartAlbums(db, record.path, meta, albums);
+        }
+        if (ok && record.fingerprint) {
+            fingerprints.addBindValue(record.path);
+            fingerprints.addBindValue(record.fingerprint->mtime);
+            fingerprints.addBindValue(record.fingerprint->size);
+            fingerprints.addBindValue(record.fingerprint->quick);
+            fingerprints.addBindValue(record.fingerprint->full.isEmpty() ? QVariant() : QVariant(record.fingerprint->full));
+            ok = fingerprints.exec();
+        }
+        if (ok && record.perceptualHash) {
+            hashes.addBindValue(record.path);
+            hashes.addBindValue(record.perceptualHash->mtime);
+            hashes.addBindValue(record.perceptualHash->size);
+            hashes.addBindValue(qint64(record.perceptualHash->hash));
+            ok = hashes.exec();
+        }
+        if (!ok) {
+            qWarning() << "PhotoDatabase: Failed to apply the change of" << record.path;
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+std::optional<PhotoDatabase::SyncCursor> PhotoDatabase::syncCursor(const QString& name) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return std::nullopt;
+
+    QSqlQuery query(db);
+    query.prepare("SELECT origin, position FROM sync_cursors WHERE name = ?");
+    query.addBindValue(name);
+    if (!query.exec() || !query.next()) return std::nullopt;
+    return SyncCursor{query.value(0).toString(), query.value(1).toLongLong()};
+}
+
+bool PhotoDatabase::setSyncCursor(const QString& name, const SyncCursor& cursor) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    QSqlQuery query(db);
+    query.prepare("INSERT OR REPLACE INTO sync_cursors (name, origin, position) VALUES (?, ?, ?)");
+    query.addBindValue(name);
+    query.addBindValue(cursor.origin);
+    query.addBindValue(cursor.position);
+    if (!query.exec()) {
+        qWarning() << "PhotoDatabase: Failed to store sync cursor" << name << ":" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+std::optional<qint64> PhotoDatabase::createSmartAlbum(const QString& name, const FilterCriteria& criteria) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return std::nullopt;
+
+    db.transaction();
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO smart_albums (name, criteria, created_at) VALUES (?, ?, ?)");
+    query.addBindValue(name);
+    query.addBindValue(QJsonDocument(criteria.toJson()).toJson(QJsonDocument::Compact));
+    query.addBindValue(QDateTime::currentSecsSinceEpoch());
+    if (!query.exec()) {
+        qWarning() << "PhotoDatabase: Failed to create smart album" << name << ":" << query.lastError().text();
+        db.rollback();
+        return std::nullopt;
+    }
+
+    SmartAlbum album{query.lastInsertId().toLongLong(), name, criteria, 0};
+    if (!fillSmartAlbum(db, album) || !db.commit()) {
+        db.rollback();
+        return std::nullopt;
+    }
+    return album.id;
+}
+
+bool PhotoDatabase::updateSmartAlbum(qint64 id, const QString& name, const FilterCriteria& criteria) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    db.transaction();
+    QSqlQuery query(db);
+    query.prepare("UPDATE smart_albums SET name = ?, criteria = ? WHERE id = ?");
+    query.addBindValue(name);
+    query.addBindValue(QJsonDocument(criteria.toJson()).toJson(QJsonDocument::Compact));
+    query.addBindValue(id);
+    if (!query.exec() || query.numRowsAffected() != 1) {
+        qWarning() << "PhotoDatabase: Failed to update smart album" << id << ":" << query.lastError().text();
+        db.rollback();
+        return false;
+    }
+    if (!fillSmartAlbum(db, SmartAlbum{id, name, criteria, 0})) {
+        db.rollback();
+        return false;
+    }
+    return db.commit();
+}
+
+bool PhotoDatabase::removeSmartAlbum(qint64 id) {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return false;
+
+    db.transaction();
+    QSqlQuery query(db);
+    for (const char* sql : {"DELETE FROM smart_album_photos WHERE album_id = ?",
+                            "DELETE FROM smart_albums WHERE id = ?"}) {
+        query.prepare(sql);
+        query.addBindValue(id);
+        if (!query.exec()) {
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+std::vector<PhotoDatabase::SmartAlbum> PhotoDatabase::smartAlbums() {
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return {};
+
+    std::vector<SmartAlbum> albums = loadSmartAlbums(db);
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    QHash<qint64, int> counts;
+    if (query.exec("SELECT album_id, COUNT(*) FROM smart_album_photos GROUP BY album_id")) {
+        while (query.next()) counts.insert(query.value(0).toLongLong(), query.value(1).toInt());
+    }
+    for (SmartAlbum& album : albums) album.photos = counts.value(album.id);
+    return albums;
+}
+
+QStringList PhotoDatabase::smartAlbumPhotos(qint64 id) {
+    QStringList paths;
+    QSqlDatabase db = connection();
+    if (!db.isOpen()) return paths;
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT path FROM smart_album_photos WHERE album_id = ? ORDER BY path");
+    query.addBindValue(id);
+    if (!query.exec()) return paths;
+    while (query.next()) paths << query.value(0).toString();
+    return paths;
 }
 
 } // namespace PhotoGuru
@@ -1,31 +1,245 @@
 #pragma once
 
 #include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QRectF>
+#include <QSet>
 #include <QSqlDatabase>
+#include <optional>
+#include <vector>
+#include "FilterCriteria.h"
 #include "PhotoMetadata.h"
 
 namespace PhotoGuru {
 
+/**
+ * @brief SQLite catalog of parsed PhotoMetadata
+ *
+ * Rows are keyed by absolute path and validated against the file's
+ * mtime + size, so reopening a folder only needs ExifTool for files that
+ * changed since they were cataloged. Each thread gets its own connection
+ * (QSqlDatabase connections are not shareable across threads).
+ *
+ * Every write to a photo's row, fingerprint or perceptual hash moves the
+ * path to the next change sequence number (a trigger-kept change log), so
+ * another catalog can pull only what changed since it last synced
+ * (CatalogServer / CatalogSync).
+ *
+ * Smart albums are saved FilterCriteria whose members are kept in the
+ * catalog: every stored photo is checked against each album as it is
+ * written, so opening an album is one indexed lookup, whatever the size
+ * of the library.
+ */
 class PhotoDatabase {
 public:
+    // Content fingerprint of a file as it was when recorded (see FileFingerprint)
+    struct Fingerprint {
+        QString path;
+        qint64 mtime = 0;  // ms since epoch
+        qint64 size = 0;
+        QByteArray quick;
+        QByteArray full;   // Empty until someone needed it
+    };
+
+    // Checkpointed batch analysis: one job per folder, one row per file
+    // recording which AnalysisPipeline::Checkpoint stages it has passed
+    struct JobFile {
+        int stages = 0;   // AnalysisPipeline::Checkpoint bits
+        QString caption;  // Kept once captioned, so a resumed run skips the VLM
+    };
+    struct AnalysisJob {
+        qint64 id = 0;
+        bool resumed = false;  // The previous run over this folder did not finish
+        QHash<QString, JobFile> files;
+    };
+
+    // One Semantic Key Protocol key carried by a cataloged photo
+    struct SemanticKeyRef {
+        QString path;
+        QString kind;  // "image", "person", "group" or "global": where the photo carries it
+        QString role;  // "anchor", "gate", "link", "composite"
+    };
+
+    // A face FaceAnalyzer found, as the catalog keeps it
+    struct Face {
+        qint64 id = 0;                 // Row id, set once stored
+        QString path;
+        QRectF box;                    // Fraction of the image (0..1), whatever size was decoded
+        float score = 0.0f;
+        std::vector<float> embedding;  // L2-normalized; empty for faces too small to embed
+        qint64 person = 0;             // 0 until clustered, -1 if it can't be
+    };
+    // Faces taken to be one person; photos carry it as the SKP person key personKey(id)
+    struct Person {
+        qint64 id = 0;
+        std::vector<float> centroid;   // Mean direction of its faces' embeddings
+        int faces = 0;
+    };
+
+    // A perceptual hash as recorded, with the file version it was computed from
+    struct PerceptualHashRecord {
+        qint64 mtime = 0;
+        qint64 size = 0;
+        quint64 hash = 0;
+    };
+    // One path's current entry, as another catalog syncs it
+    struct CatalogRecord {
+        qint64 seq = 0;       // The path's newest change
+        QString path;
+        qint64 mtime = 0;     // File version the metadata describes
+        qint64 size = 0;
+        QByteArray metadata;  // As stored (compact JSON); empty: not cataloged as a photo
+        std::optional<Fingerprint> fingerprint;
+        std::optional<PerceptualHashRecord> perceptualHash;
+        bool removed = false; // The photo was removed; a path that was only fingerprinted never is
+    };
+    // How far this catalog has pulled from a source
+    struct SyncCursor {
+        QString origin;       // What `position` counts in; a new origin starts over at 0
+        qint64 position = 0;
+    };
+
+    // Saved filter; members are the cataloged photos it matches
+    struct SmartAlbum {
+        qint64 id = 0;
+        QString name;
+        FilterCriteria criteria;
+        int photos = 0;  // Members when listed
+    };
+
     static PhotoDatabase& instance();
-    
+
     bool initialize(const QString& dbPath);
     void close();
-    
-    // TODO: Implement catalog functionality
-    // bool addPhoto(const PhotoMetadata& meta);
+    bool isInitialized() const;
+
+    // Metadata cache (keyed by path + mtime + size). These key entries on the
+    // file as it is now: for tags just written to it, or made up (tests)
+    bool storeMetadata(const PhotoMetadata& meta);
+    bool storeMetadataBatch(const QList<PhotoMetadata>& metas);
+    // Keyed on the version each was read from (file_mtime/file_size): a
+    // write landing between the read and the store leaves the entry stale
+    // instead of filing the old tags under the new version. Unversioned
+    // entries are skipped.
+    bool storeReadMetadata(const QList<PhotoMetadata>& metas);
+    std::optional<PhotoMetadata> cachedMetadata(const QString& filePath);
+
+    // Returns catalog entries still matching the file on disk; files that are
+    // missing from the result need a fresh read
+    QHash<QString, PhotoMetadata> loadFreshMetadata(const QStringList& filePaths);
+
+    // Fingerprints (keyed by path + mtime + size, like metadata)
+    bool storeFingerprint(const Fingerprint& fingerprint);
+    std::optional<Fingerprint> freshFingerprint(const QString& filePath);
+    // Every path recorded with these contents, whether or not it still exists
+    QList<Fingerprint> fingerprintsMatching(const QByteArray& quick);
+
+    // Perceptual hashes (see PerceptualHash), keyed by path + mtime + size
+    bool storePerceptualHash(const QString& filePath, qint64 mtime, qint64 size, quint64 hash);
+    // Hashes still matching the files on disk; missing files need hashing
+    QHash<QString, quint64> freshPerceptualHashes(const QStringList& filePaths);
+
+    // Faces, keyed by path + mtime + size. Replaces the file's earlier faces;
+    // a scan that found none is recorded too, so the file isn't scanned again
+    bool storeFaces(const QString& filePath, qint64 mtime, qint64 size, const std::vector<Face>& faces);
+    // Face counts of files scanned since they last changed; missing files need scanning
+    QHash<QString, int> freshFaceCounts(const QStringList& filePaths);
+    // The file was rewritten without touching its pixels (a metadata write):
+    // its scan follows it to the new mtime + size
+    bool keepFaceScan(const QString& filePath);
+    // Up to `limit` embedded faces without a person, in the order they were stored
+    std::vector<Face> unclusteredFaces(int limit);
+    std::vector<Person> people();
+    // Stores the people personOfFace points at (by index into `people`;
+    // those with id 0 are inserted and get their id) and each face's person.
+    // Faces mapped to -1 are set aside and never returned as unclustered.
+    bool storePeople(std::vector<Person>& people, const QHash<qint64, int>& personOfFace);
+    // Re-stores the cataloged metadata of `filePaths`, so face counts and
+    // person keys follow the latest scan and clustering
+    bool refreshFaceMetadata(const QStringList& filePaths);
+
+    static QString personKey(qint64 personId);  // "person-<id>"
+
+    // The job over `root`, with a row for each of `filePaths`. Rows of files
+    // changed since they were checkpointed, or checkpointed with other
+    // `models` (AnalysisPipeline::modelStamp), start over; `restart` clears all.
+    std::optional<AnalysisJob> openAnalysisJob(const QString& root, const QStringList& filePaths,
+                                               const QString& models, bool restart = false);
+    // Adds `stages` to the file's row; safe from the pipeline's stage threads
+    bool checkpointAnalysisFile(qint64 jobId, const QString& filePath, int stages,
+                                const QString& caption = QString());
+    bool finishAnalysisJob(qint64 jobId);
+
+    // Every cataloged photo carrying `keyId`, optionally only in `role`.
+    // Served by the key index kept beside the photos table, so it costs
+    // the same in a library of any size.
+    QList<SemanticKeyRef> photosWithKey(const QString& keyId, const QString& role = QString());
+
+    bool removePhoto(const QString& filePath);
+    int photoCount();
+
+    // Random id given to the catalog when it was created; change sequence
+    // numbers only compare within one id
+    QString catalogId();
+    // Newest change sequence number (0 for an empty catalog)
+    qint64 changeSequence();
+    // Current entries of paths changed after `seq`, oldest change first
+    std::vector<CatalogRecord> changesSince(qint64 seq, int limit);
+    // Stores entries from another catalog as recorded there (no stat: whether
+    // they match the files is checked when they are read, as always). They
+    // enter this catalog's own change log like any other write.
+    bool applyChanges(const std::vector<CatalogRecord>& records);
+
+    std::optional<SyncCursor> syncCursor(const QString& name);
+    bool setSyncCursor(const QString& name, const SyncCursor& cursor);
+
+    // Saves the album and finds its members among the cataloged photos (the
+    // one full pass it ever needs); later writes keep them current. Names are unique.
+    std::optional<qint64> createSmartAlbum(const QString& name, const FilterCriteria& criteria);
+    // New criteria are another full pass, as in createSmartAlbum()
+    bool updateSmartAlbum(qint64 id, const QString& name, const FilterCriteria& criteria);
+    bool removeSmartAlbum(qint64 id);
+    std::vector<SmartAlbum> smartAlbums();  // By name
+    // Members as cataloged, by path; a member whose file changed since is
+    // listed until the new version is stored
+    QStringList smartAlbumPhotos(qint64 id);
+
+    // TODO: Implement catalog search functionality
     // std::vector<PhotoMetadata> searchByKeywords(const QStringList& keywords);
-    // std::vector<PhotoMetadata> searchBySKP(const QString& keyId);
-    
+
 private:
     PhotoDatabase() = default;
     ~PhotoDatabase() { close(); }
     PhotoDatabase(const PhotoDatabase&) = delete;
     PhotoDatabase& operator=(const PhotoDatabase&) = delete;
-    
-    QSqlDatabase m_db;
+
+    QSqlDatabase connection();
+    void removeConnection(const QString& name);  // When its thread finishes
+    bool createSchema(QSqlDatabase& db);
+    bool storeMetadataRows(const QList<PhotoMetadata>& metas, bool statNow);
+    static bool indexSemanticKeys(QSqlDatabase& db, const QString& path, const PhotoMetadata& meta);
+    // Albums to check each write of a transaction against (counts left 0)
+    static std::vector<SmartAlbum> loadSmartAlbums(QSqlDatabase& db);
+    // Adds the photo to the albums it matches, drops it from the others
+    static bool indexSmartAlbums(QSqlDatabase& db, const QString& path, const PhotoMetadata& meta,
+                                 const std::vector<SmartAlbum>& albums);
+    // Every cataloged photo checked against one album
+    static bool fillSmartAlbum(QSqlDatabase& db, const SmartAlbum& album);
+    // Face count and person keys from the file's scan, if it is still current;
+    // the catalog's own scan wins over counts read from the file
+    static void applyFaceScan(QSqlDatabase& db, const QString& path, qint64 mtime, qint64 size,
+                              PhotoMetadata& meta);
+
+    QString m_dbPath;
+    QSet<QString> m_connectionNames;
+    quint64 m_connectionSerial = 0;
+    mutable QMutex m_mutex;
     bool m_initialized = false;
+
+    static constexpr int SCHEMA_VERSION = 10;  // 2: fingerprints table, 3: analysis jobs, 4: job model stamps, 5: SKP key index, 6: perceptual hashes, 7: faces and people, 8: change log and sync cursors, 9: smart albums, 10: removals in the change log
 };
 
 } // namespace PhotoGuru
@@ -3,8 +3,10 @@
 #include <QString>
 #include <QDateTime>
 #include <QJsonObject>
+#include <QList>
 #include <vector>
 #include <optional>
+#include <memory>
 
 namespace PhotoGuru {
 
@@ -35,6 +37,10 @@ struct PhotoMetadata {
     // File info
     QString filepath;
     QString filename;
+    // File version the tags were read from, stat'ed before the read (ms
+    // since epoch, bytes); -1 when they weren't read from the file
+    qint64 file_mtime = -1;
+    qint64 file_size = -1;
     
     // EXIF
     QDateTime datetime_original;
@@ -47,6 +53,8 @@ struct PhotoMetadata {
     double shutter_speed = 0.0;
     int iso = 0;
     double focal_length = 0.0;
+    int sequence_number = 0;  // Frame within a continuous-drive run (MakerNotes), 0 if none
+    QString burst_id;         // Burst the camera itself recorded (Apple BurstUUID)
     
     // AI Analysis (LLM)
     QString llm_title;
@@ -80,12 +88,62 @@ struct PhotoMetadata {
     }
 };
 
+// Read-only metadata shared between the catalog and its views: copying a
+// handle bumps one refcount instead of copying every string and list in
+// the struct. An edit builds a new PhotoMetadata and replaces the handle.
+using PhotoHandle = std::shared_ptr<const PhotoMetadata>;
+
+inline PhotoHandle makePhotoHandle(PhotoMetadata meta) {
+    return std::make_shared<const PhotoMetadata>(std::move(meta));
+}
+
+// For callers holding values rather than catalog handles: one copy each
+inline QList<PhotoHandle> makePhotoHandles(const QList<PhotoMetadata>& photos) {
+    QList<PhotoHandle> handles;
+    handles.reserve(photos.size());
+    for (const PhotoMetadata& photo : photos) handles << makePhotoHandle(photo);
+    return handles;
+}
+
 class MetadataReader {
 public:
     static MetadataReader& instance();
     
-    // Read all metadata from image file (via exiftool)
-    std::optional<PhotoMetadata> read(const QString& filePath);
+    // Tag groups: ExifTool is asked for, and the JSON parsed into, only the
+    // PhotoMetadata fields a caller needs
+    enum Field {
+        Capture     = 1 << 0,  // datetime_original, sequence_number, burst_id
+        Camera      = 1 << 1,  // Make, model, aperture, shutter speed, ISO, focal length
+        Gps         = 1 << 2,
+        Rating      = 1 << 3,
+        Descriptive = 1 << 4,  // Title, description, keywords, category, scene
+        Location    = 1 << 5,  // location_name
+        Technical   = 1 << 6,  // The PhotoGuru block in UserComment
+        
+        // Every field PhotoMetadata has: what the catalog stores and filters read
+        FilterSet = Capture | Camera | Gps | Rating | Descriptive | Location | Technical,
+        // FilterSet via a dump of every tag (-a), for full inspection
+        AllTags = FilterSet | 1 << 7
+    };
+    
+    // Read metadata from image file (via the ExifTool daemon). Tags of its
+    // XMP sidecar, if there is one, win over the file's own.
+    std::optional<PhotoMetadata> read(const QString& filePath, int fields = AllTags);
+    
+    // Read many files, READ_MANY_CHUNK_SIZE paths per exiftool -execute.
+    // Files exiftool can't read are omitted from the result. A chunk that
+    // times out is read again in halves.
+    std::vector<PhotoMetadata> readMany(const QStringList& filePaths, int fields = AllTags);
+    
+    static constexpr int READ_MANY_CHUNK_SIZE = 200;
+    
+    // Like readMany(filePaths, FilterSet), parsing the fields in-process
+    // (ExifFastReader) and sending only what it can't parse to ExifTool.
+    // For catalog passes; MakerNotes fields stay empty for fast-read files.
+    std::vector<PhotoMetadata> readCommon(const QStringList& filePaths);
+    
+    // ExifTool arguments selecting `fields` (before the file paths)
+    static QStringList tagArguments(int fields);
     
     // Quick check if file has PhotoGuru metadata
     bool hasPhotoGuruData(const QString& filePath);
@@ -93,14 +151,24 @@ public:
     // Extract only technical metadata from UserComment
     std::optional<TechnicalMetadata> readTechnicalOnly(const QString& filePath);
     
+    // First object of an `exiftool -json` result (public for PhotoGuruBench)
+    PhotoMetadata parseExifToolOutput(const QString& output, int fields);
+    
+    // Sidecar of filePath: Lightroom's name for RAW files (IMG_0001.NEF ->
+    // IMG_0001.xmp), the full name otherwise (IMG_0001.JPG -> IMG_0001.JPG.xmp)
+    // so the JPEG of a RAW+JPEG pair neither reads nor writes the RAW's
+    static QString sidecarPath(const QString& filePath);
+    // `exiftool -json` object of an image with its sidecar's tags laid over it
+    static QJsonObject mergeSidecar(QJsonObject image, const QJsonObject& sidecar);
+    
 private:
     MetadataReader() = default;
     ~MetadataReader() = default;
     MetadataReader(const MetadataReader&) = delete;
     MetadataReader& operator=(const MetadataReader&) = delete;
     
-    QString runExifTool(const QString& filePath, const QStringList& args);
-    PhotoMetadata parseExifToolOutput(const QString& output);
+    PhotoMetadata parseExifToolObject(const QJsonObject& obj, int fields);
+    void readChunk(const QStringList& chunk, int fields, std::vector<PhotoMetadata>& results);
     TechnicalMetadata parseTechnicalData(const QString& userComment);
 };
 
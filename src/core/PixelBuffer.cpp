@@ -0,0 +1,78 @@
+#include "PixelBuffer.h"
+#include <QSysInfo>
+#include <cstring>
+
+namespace PhotoGuru {
+
+namespace {
+
+void runRelease(void* info) {
+    auto* release = static_cast<PixelBuffer::Release*>(info);
+    if (*release) (*release)();
+    delete release;
+}
+
+} // namespace
+
+PixelBuffer PixelBuffer::wrap(const uchar* data, int width, int height, qsizetype stride,
+                              QImage::Format format, Release release) {
+    if (!data || width <= 0 || height <= 0) {
+        if (release) release();
+        return PixelBuffer();
+    }
+    // Const data: QImage never writes to it, it detaches instead
+    return PixelBuffer(QImage(data, width, height, stride, format, runRelease, new Release(std::move(release))));
+}
+
+PixelBuffer PixelBuffer::fromMat(const cv::Mat& mat) {
+    if (mat.empty() || mat.depth() != CV_8U || mat.dims != 2) {
+        return PixelBuffer();
+    }
+    QImage::Format format = QImage::Format_Invalid;
+    switch (mat.channels()) {
+        case 1: format = QImage::Format_Grayscale8; break;
+        case 3: format = QImage::Format_BGR888; break;
+        // BGRA bytes are the native 0xAARRGGBB word on little-endian machines
+        case 4: format = QSysInfo::ByteOrder == QSysInfo::LittleEndian ? QImage::Format_ARGB32
+                                                                       : QImage::Format_Invalid; break;
+        default: break;
+    }
+    if (format == QImage::Format_Invalid) {
+        return PixelBuffer();
+    }
+    // The copied header holds a reference to the Mat's data
+    return wrap(mat.data, mat.cols, mat.rows, qsizetype(mat.step), format, [held = mat]() {});
+}
+
+bool PixelBuffer::isPacked() const {
+    return !isNull() && stride() == qsizetype(width()) * m_image.depth() / 8;
+}
+
+cv::Mat PixelBuffer::mat() const {
+    if (isNull() || m_image.depth() % 8 != 0) {
+        return cv::Mat();
+    }
+    const int channels = m_image.depth() / 8;
+    return cv::Mat(height(), width(), CV_8UC(channels), const_cast<uchar*>(constBits()), size_t(stride()));
+}
+
+PixelBuffer PixelBuffer::packed() const {
+    if (isNull() || isPacked()) {
+        return *this;
+    }
+    const qsizetype row = qsizetype(width()) * m_image.depth() / 8;
+    auto* data = new uchar[size_t(row) * height()];
+    for (int y = 0; y < height(); ++y) {
+        std::memcpy(data + y * row, m_image.constScanLine(y), size_t(row));
+    }
+    return wrap(data, width(), height(), row, format(), [data]() { delete[] data; });
+}
+
+PixelBuffer PixelBuffer::converted(QImage::Format target) const {
+    if (isNull() || format() == target) {
+        return *this;
+    }
+    return PixelBuffer(m_image.convertToFormat(target));
+}
+
+} // namespace PhotoGuru
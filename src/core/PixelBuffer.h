@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QImage>
+#include <functional>
+#include <opencv2/core.hpp>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Decoded pixels shared, not copied, between the loader, OpenCV and the models
+ *
+ * A 24 MP RGB frame is 70 MB, and each hand-over used to copy it: LibRaw
+ * and libheif output into a QImage, a cv::Mat into a QImage, a padded
+ * QImage into a llama.cpp bitmap. A PixelBuffer is one reference-counted
+ * block of pixels (a QImage underneath) with views over it:
+ *   image()  - the QImage itself, shared
+ *   mat()    - a cv::Mat header on the same bytes
+ *   packed() - rows without padding, the layout mtmd_bitmap and raw
+ *              tensors take; the same bytes when already packed
+ *
+ * wrap() adopts memory a decoder allocated and frees it through the
+ * given release function when the last view goes; fromMat() keeps the
+ * Mat's own reference instead. The pixels are read-only: writing to a
+ * QImage from one detaches, as with any shared QImage.
+ *
+ * Copies are cheap and may cross threads.
+ */
+class PixelBuffer {
+public:
+    using Release = std::function<void()>;
+
+    PixelBuffer() = default;
+    explicit PixelBuffer(const QImage& image) : m_image(image) {}
+
+    // `data` must stay valid until `release` runs
+    static PixelBuffer wrap(const uchar* data, int width, int height, qsizetype stride,
+                            QImage::Format format, Release release);
+    // 1 channel: gray; 3: BGR; 4: BGRA. Null for other types
+    static PixelBuffer fromMat(const cv::Mat& mat);
+
+    bool isNull() const { return m_image.isNull(); }
+    int width() const { return m_image.width(); }
+    int height() const { return m_image.height(); }
+    QImage::Format format() const { return m_image.format(); }
+    qsizetype stride() const { return m_image.bytesPerLine(); }
+    const uchar* constBits() const { return m_image.constBits(); }
+    bool isPacked() const;
+
+    const QImage& image() const { return m_image; }
+    // Valid while this buffer (or a view of it) lives; empty for formats
+    // that aren't whole bytes per pixel
+    cv::Mat mat() const;
+    PixelBuffer packed() const;
+    // This buffer when already in `format`
+    PixelBuffer converted(QImage::Format format) const;
+
+private:
+    QImage m_image;
+};
+
+} // namespace PhotoGuru
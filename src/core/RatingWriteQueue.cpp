@@ -0,0 +1,165 @@
+#include "RatingWriteQueue.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QDebug>
+
+namespace PhotoGuru {
+
+RatingWriteQueue::Writer RatingWriteQueue::defaultWriter() {
+    return [](const QList<MetadataWriter::Transaction>& transactions) {
+        return MetadataWriter::instance().commitBatch(transactions);
+    };
+}
+
+RatingWriteQueue::RatingWriteQueue(const QString& journalPath, Writer writer, QObject* parent)
+    : QObject(parent)
+    , m_journalPath(journalPath)
+    , m_writer(std::move(writer))
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(DEFAULT_FLUSH_DELAY_MS);
+    connect(&m_timer, &QTimer::timeout, this, &RatingWriteQueue::flush);
+    connect(&m_watcher, &QFutureWatcher<std::vector<bool>>::finished,
+            this, &RatingWriteQueue::onFlushFinished);
+
+    loadJournal();
+    if (!m_pending.isEmpty()) {
+        qDebug() << "[RatingWriteQueue] Resuming" << m_pending.size() << "unwritten ratings";
+        m_timer.start();
+    }
+}
+
+RatingWriteQueue::~RatingWriteQueue() {
+    // Whatever is left stays in the journal for next time
+    m_flush.waitForFinished();
+}
+
+void RatingWriteQueue::enqueue(const QString& path, int rating) {
+    rating = qBound(0, rating, 5);
+    m_pending.insert(path, rating);
+    appendJournal(path, rating);
+    // Restart: a burst of keypresses goes out as one batch
+    m_timer.start();
+}
+
+std::optional<int> RatingWriteQueue::pending(const QString& path) const {
+    auto it = m_pending.constFind(path);
+    if (it != m_pending.cend()) return *it;
+    it = m_inFlight.constFind(path);
+    if (it != m_inFlight.cend()) return *it;
+    return std::nullopt;
+}
+
+void RatingWriteQueue::flush() {
+    m_timer.stop();
+    // A running batch starts the next one when it finishes
+    if (m_pending.isEmpty() || !m_inFlight.isEmpty()) return;
+
+    QList<MetadataWriter::Transaction> transactions;
+    m_flushPaths.clear();
+    for (auto it = m_pending.begin(); it != m_pending.end() && transactions.size() < MAX_BATCH_SIZE;) {
+        MetadataWriter::Transaction tx(it.key());
+        tx.setRating(it.value());
+        transactions.append(tx);
+        m_flushPaths.append(it.key());
+        m_inFlight.insert(it.key(), it.value());
+        it = m_pending.erase(it);
+    }
+
+    Writer writer = m_writer;
+    m_flush = m_tasks.run(TaskScheduler::Ingest, [writer, transactions]() { return writer(transactions); });
+    m_watcher.setFuture(m_flush);
+}
+
+void RatingWriteQueue::waitForFlushed() {
+    while (pendingCount() > 0) {
+        flush();
+        m_flush.waitForFinished();
+        onFlushFinished();
+    }
+}
+
+void RatingWriteQueue::onFlushFinished() {
+    // Already handled by waitForFlushed(), or a newer batch is running
+    if (m_inFlight.isEmpty() || !m_flush.isFinished()) return;
+
+    std::vector<bool> results = m_flush.result();
+    QStringList written;
+    QStringList failed;
+    for (int i = 0; i < m_flushPaths.size(); ++i) {
+        if (i < int(results.size()) && results[i]) {
+            written << m_flushPaths[i];
+        } else {
+            failed << m_flushPaths[i];
+        }
+    }
+    m_inFlight.clear();
+    m_flushPaths.clear();
+    rewriteJournal();
+
+    if (!failed.isEmpty()) {
+        qWarning() << "[RatingWriteQueue] Failed to write" << failed.size() << "ratings";
+        emit writeFailed(failed);
+    }
+    if (!written.isEmpty()) {
+        emit written(written);
+    }
+
+    // More than one batch queued: keep going
+    if (!m_pending.isEmpty() && !m_timer.isActive()) {
+        flush();
+    }
+}
+
+void RatingWriteQueue::loadJournal() {
+    if (m_journalPath.isEmpty()) return;
+    QFile file(m_journalPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return;
+
+    // "<rating>\t<path>" per line; later lines win
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QString line = in.readLine();
+        const int tab = line.indexOf('\t');
+        bool ok = false;
+        const int rating = tab > 0 ? line.left(tab).toInt(&ok) : 0;
+        if (ok && rating >= 0 && rating <= 5 && tab + 1 < line.size()) {
+            m_pending.insert(line.mid(tab + 1), rating);
+        }
+    }
+}
+
+void RatingWriteQueue::appendJournal(const QString& path, int rating) {
+    if (m_journalPath.isEmpty()) return;
+    QFile file(m_journalPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qWarning() << "[RatingWriteQueue] Cannot open journal:" << m_journalPath;
+        return;
+    }
+    QTextStream(&file) << rating << '\t' << path << '\n';
+}
+
+void RatingWriteQueue::rewriteJournal() {
+    if (m_journalPath.isEmpty()) return;
+    if (m_pending.isEmpty() && m_inFlight.isEmpty()) {
+        QFile::remove(m_journalPath);
+        return;
+    }
+
+    QSaveFile file(m_journalPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "[RatingWriteQueue] Cannot rewrite journal:" << m_journalPath;
+        return;
+    }
+    QTextStream out(&file);
+    for (const QHash<QString, int>* edits : {&m_inFlight, &m_pending}) {
+        for (auto it = edits->cbegin(); it != edits->cend(); ++it) {
+            out << it.value() << '\t' << it.key() << '\n';
+        }
+    }
+    out.flush();
+    file.commit();
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "MetadataWriter.h"
+#include "TaskScheduler.h"
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QTimer>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Write-behind queue for star ratings
+ *
+ * enqueue() returns at once: the rating is appended to a journal file and
+ * written to the image later, together with the other ratings given in
+ * the meantime, as one ExifTool batch. Rating the same file again before
+ * the flush replaces the earlier value, so a file is written once.
+ *
+ * The journal holds every rating not yet written; a queue opened on it
+ * after a crash picks them up and writes them on its first flush. Edits
+ * whose write failed are dropped and reported through writeFailed().
+ *
+ * GUI thread only; the writes run on a TaskScheduler worker at Ingest
+ * priority.
+ */
+class RatingWriteQueue : public QObject {
+    Q_OBJECT
+
+public:
+    // One result per transaction, like MetadataWriter::commitBatch()
+    using Writer = std::function<std::vector<bool>(const QList<MetadataWriter::Transaction>&)>;
+
+    static Writer defaultWriter();
+
+    // An empty journalPath keeps the queue in memory only
+    explicit RatingWriteQueue(const QString& journalPath, Writer writer = defaultWriter(),
+                              QObject* parent = nullptr);
+    ~RatingWriteQueue();
+
+    void enqueue(const QString& path, int rating);
+
+    // Rating given but not written yet
+    std::optional<int> pending(const QString& path) const;
+    int pendingCount() const { return m_pending.size() + m_inFlight.size(); }
+
+    // Writes now instead of after the flush delay
+    void flush();
+    // Blocks until everything queued is written
+    void waitForFlushed();
+
+    void setFlushDelay(int ms) { m_timer.setInterval(ms); }
+
+    static constexpr int DEFAULT_FLUSH_DELAY_MS = 2000;
+    static constexpr int MAX_BATCH_SIZE = 200;
+
+signals:
+    void written(const QStringList& paths);
+    void writeFailed(const QStringList& paths);
+
+private:
+    void onFlushFinished();
+    void loadJournal();
+    void appendJournal(const QString& path, int rating);
+    void rewriteJournal();
+
+    QString m_journalPath;
+    Writer m_writer;
+    QHash<QString, int> m_pending;   // Path -> latest rating
+    QHash<QString, int> m_inFlight;  // Being written by m_flush
+    QFuture<std::vector<bool>> m_flush;
+    QList<QString> m_flushPaths;     // Transaction order of m_flush
+    QFutureWatcher<std::vector<bool>> m_watcher;
+    QTimer m_timer;
+    TaskGroup m_tasks{TaskScheduler::Ingest};  // Last: waits for tasks before the rest goes
+};
+
+} // namespace PhotoGuru
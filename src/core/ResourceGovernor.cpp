@@ -0,0 +1,286 @@
+#include "ResourceGovernor.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMutexLocker>
+#include <algorithm>
+
+#if defined(Q_OS_MACOS)
+#include <CoreFoundation/CoreFoundation.h>
+#include <IOKit/ps/IOPowerSources.h>
+#include <IOKit/ps/IOPSKeys.h>
+#include <IOKit/pwr_mgt/IOPMLib.h>
+#elif defined(Q_OS_LINUX)
+#include <QDir>
+#include <QFile>
+#endif
+
+namespace PhotoGuru {
+
+namespace {
+
+#if defined(Q_OS_LINUX)
+// Hottest thermal zone, in °C; sysfs trip points vary too much by vendor to rely on
+constexpr int FAIR_CELSIUS = 75;
+constexpr int SERIOUS_CELSIUS = 85;
+constexpr int CRITICAL_CELSIUS = 95;
+
+QByteArray readSysfs(const QString& path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll().trimmed() : QByteArray();
+}
+#endif
+
+} // namespace
+
+ResourceGovernor& ResourceGovernor::instance() {
+    static ResourceGovernor instance;
+    return instance;
+}
+
+ResourceGovernor::ResourceGovernor(TaskScheduler& scheduler, QObject* parent)
+    : QObject(parent)
+    , m_scheduler(scheduler)
+    , m_pollTimer(this)
+    , m_activityTimer(this)
+{
+    // The AI stages may be first to ask; timers belong on the GUI thread
+    if (!parent && QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+
+    connect(&m_pollTimer, &QTimer::timeout, this, [this]() { setPowerState(probe()); });
+    m_activityTimer.setSingleShot(true);
+    connect(&m_activityTimer, &QTimer::timeout, this, [this]() {
+        m_userActive = false;
+        update();
+    });
+    update();
+}
+
+void ResourceGovernor::setMode(Mode mode) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_mode == mode) return;
+        m_mode = mode;
+    }
+    qDebug() << "[ResourceGovernor] Mode:" << modeName(mode);
+    update();
+}
+
+ResourceGovernor::Mode ResourceGovernor::mode() const {
+    QMutexLocker locker(&m_mutex);
+    return m_mode;
+}
+
+QString ResourceGovernor::modeName(Mode mode) {
+    switch (mode) {
+        case Background:    return "background";
+        case Balanced:      return "balanced";
+        case MaxThroughput: return "max-throughput";
+    }
+    return "balanced";
+}
+
+std::optional<ResourceGovernor::Mode> ResourceGovernor::modeFromName(const QString& name) {
+    for (Mode mode : {Background, Balanced, MaxThroughput}) {
+        if (modeName(mode) == name) return mode;
+    }
+    return std::nullopt;
+}
+
+void ResourceGovernor::setPowerState(const PowerState& state) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_state.onBattery == state.onBattery && m_state.batteryPercent == state.batteryPercent &&
+            m_state.thermal == state.thermal) {
+            return;
+        }
+        m_state = state;
+    }
+    update();
+}
+
+ResourceGovernor::PowerState ResourceGovernor::powerState() const {
+    QMutexLocker locker(&m_mutex);
+    return m_state;
+}
+
+void ResourceGovernor::startMonitoring(int intervalMs) {
+    setPowerState(probe());
+    m_pollTimer.start(intervalMs);
+}
+
+void ResourceGovernor::stopMonitoring() {
+    m_pollTimer.stop();
+}
+
+void ResourceGovernor::noteUserActivity() {
+    // Called per mouse move while panning: only the first one recomputes
+    m_activityTimer.start(ACTIVITY_HOLD_MS);
+    if (m_userActive) return;
+    m_userActive = true;
+    update();
+}
+
+ResourceGovernor::Budget ResourceGovernor::budget() const {
+    QMutexLocker locker(&m_mutex);
+    return m_budget;
+}
+
+ResourceGovernor::Budget ResourceGovernor::compute(Mode mode, const PowerState& state,
+                                                   bool userActive, int workers) {
+    workers = std::max(1, workers);
+
+    // 0: nothing to save, 1: some pressure, 2: heavy
+    int pressure = 0;
+    if (state.thermal == Thermal::Critical) pressure = 2;
+    else if (state.thermal == Thermal::Serious) pressure = 1;
+    if (state.onBattery) {
+        const bool low = state.batteryPercent >= 0 && state.batteryPercent < LOW_BATTERY_PERCENT;
+        pressure = std::max(pressure, low ? 2 : 1);
+    }
+
+    switch (mode) {
+        case Background:    pressure = std::min(2, pressure + 1); break;
+        case Balanced:      break;
+        case MaxThroughput: pressure = state.thermal == Thermal::Critical ? 1 : 0; break;
+    }
+
+    Budget budget;
+    switch (pressure) {
+        case 0:
+            budget.prefetchLimit = workers;
+            budget.ingestLimit = std::max(1, workers - 1);
+            budget.aiLimit = std::max(1, mode == MaxThroughput ? workers - 1 : workers / 2);
+            budget.batchScale = 1.0;
+            break;
+        case 1:
+            budget.prefetchLimit = std::max(1, workers / 2);
+            budget.ingestLimit = std::max(1, workers / 2);
+            budget.aiLimit = std::max(1, workers / 4);
+            budget.batchScale = 0.5;
+            break;
+        default:
+            budget.prefetchLimit = std::max(1, workers / 4);
+            budget.ingestLimit = 1;
+            budget.aiLimit = 1;
+            budget.batchScale = 0.25;
+            break;
+    }
+    budget.aiPaused = pressure == 2;
+
+    // The user is looking at something: bulk work steps aside until they stop
+    if (userActive && mode != MaxThroughput) {
+        budget.ingestLimit = std::max(1, budget.ingestLimit / 2);
+        budget.aiPaused = true;
+    }
+    return budget;
+}
+
+void ResourceGovernor::update() {
+    Budget budget;
+    {
+        QMutexLocker locker(&m_mutex);
+        budget = compute(m_mode, m_state, m_userActive, m_scheduler.workerCount());
+        if (budget == m_budget) return;
+        m_budget = budget;
+    }
+
+    m_scheduler.setClassLimit(TaskScheduler::Prefetch, budget.prefetchLimit);
+    m_scheduler.setClassLimit(TaskScheduler::Ingest, budget.ingestLimit);
+    m_scheduler.setClassLimit(TaskScheduler::AI, budget.aiLimit);
+    m_batchPermille.store(int(budget.batchScale * 1000.0), std::memory_order_relaxed);
+    {
+        QMutexLocker locker(&m_pauseMutex);
+        m_aiPaused.store(budget.aiPaused, std::memory_order_relaxed);
+        if (!budget.aiPaused) m_resumed.wakeAll();
+    }
+    emit budgetChanged();
+}
+
+int ResourceGovernor::scaledBatchSize(int preferred) const {
+    const int permille = m_batchPermille.load(std::memory_order_relaxed);
+    return std::max(1, int(qint64(preferred) * permille / 1000));
+}
+
+void ResourceGovernor::waitWhileAIPaused(const QAtomicInt& cancelled) const {
+    QMutexLocker locker(&m_pauseMutex);
+    while (m_aiPaused.load(std::memory_order_relaxed) && !cancelled.loadRelaxed()) {
+        m_resumed.wait(&m_pauseMutex, PAUSE_RECHECK_MS);
+    }
+}
+
+ResourceGovernor::PowerState ResourceGovernor::probe() {
+    PowerState state;
+
+#if defined(Q_OS_MACOS)
+    if (CFTypeRef info = IOPSCopyPowerSourcesInfo()) {
+        CFStringRef source = IOPSGetProvidingPowerSourceType(info);
+        state.onBattery = source &&
+            CFStringCompare(source, CFSTR(kIOPSBatteryPowerValue), 0) == kCFCompareEqualTo;
+
+        if (CFArrayRef sources = IOPSCopyPowerSourcesList(info)) {
+            for (CFIndex i = 0; i < CFArrayGetCount(sources); i++) {
+                CFDictionaryRef description = IOPSGetPowerSourceDescription(info, CFArrayGetValueAtIndex(sources, i));
+                if (!description) continue;
+                auto currentRef = static_cast<CFNumberRef>(CFDictionaryGetValue(description, CFSTR(kIOPSCurrentCapacityKey)));
+                auto maxRef = static_cast<CFNumberRef>(CFDictionaryGetValue(description, CFSTR(kIOPSMaxCapacityKey)));
+                int current = 0;
+                int max = 0;
+                if (currentRef && maxRef && CFNumberGetValue(currentRef, kCFNumberIntType, &current) &&
+                    CFNumberGetValue(maxRef, kCFNumberIntType, &max) && max > 0) {
+                    state.batteryPercent = current * 100 / max;
+                    break;
+                }
+            }
+            CFRelease(sources);
+        }
+        CFRelease(info);
+    }
+
+    // The kernel caps CPU speed as the machine heats up
+    CFDictionaryRef status = nullptr;
+    if (IOPMCopyCPUPowerStatus(&status) == kIOReturnSuccess && status) {
+        int speed = 100;
+        auto limit = static_cast<CFNumberRef>(CFDictionaryGetValue(status, CFSTR(kIOPMCPUPowerLimitProcessorSpeedKey)));
+        if (limit && CFNumberGetValue(limit, kCFNumberIntType, &speed)) {
+            if (speed < 50) state.thermal = Thermal::Critical;
+            else if (speed < 75) state.thermal = Thermal::Serious;
+            else if (speed < 100) state.thermal = Thermal::Fair;
+        }
+        CFRelease(status);
+    }
+#elif defined(Q_OS_LINUX)
+    const QString supplies = "/sys/class/power_supply";
+    bool mainsOnline = false;
+    bool discharging = false;
+    for (const QString& name : QDir(supplies).entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        const QString dir = supplies + '/' + name;
+        const QByteArray type = readSysfs(dir + "/type");
+        if (type == "Mains" || type == "USB") {
+            mainsOnline = mainsOnline || readSysfs(dir + "/online") == "1";
+        } else if (type == "Battery") {
+            discharging = discharging || readSysfs(dir + "/status") == "Discharging";
+            bool ok = false;
+            const int capacity = readSysfs(dir + "/capacity").toInt(&ok);
+            if (ok) state.batteryPercent = capacity;
+        }
+    }
+    state.onBattery = discharging && !mainsOnline;
+
+    const QString zones = "/sys/class/thermal";
+    int hottest = 0;
+    for (const QString& name : QDir(zones).entryList({"thermal_zone*"}, QDir::Dirs)) {
+        bool ok = false;
+        const int milliCelsius = readSysfs(zones + '/' + name + "/temp").toInt(&ok);
+        if (ok) hottest = std::max(hottest, milliCelsius / 1000);
+    }
+    if (hottest >= CRITICAL_CELSIUS) state.thermal = Thermal::Critical;
+    else if (hottest >= SERIOUS_CELSIUS) state.thermal = Thermal::Serious;
+    else if (hottest >= FAIR_CELSIUS) state.thermal = Thermal::Fair;
+#endif
+
+    return state;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "TaskScheduler.h"
+#include <QObject>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QString>
+#include <QTimer>
+#include <QWaitCondition>
+#include <atomic>
+#include <optional>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Sizes background work to the power and thermal state of the machine
+ *
+ * The TaskScheduler keeps interactive work ahead of bulk work, but
+ * bulk work still runs flat out. On a laptop on battery that drains it,
+ * and a hot one throttles the viewer as well. The governor turns the
+ * mode the user picked, the power state and recent activity in the
+ * viewer into a Budget:
+ *   - class limits for Prefetch, Ingest and AI, applied to the scheduler;
+ *   - a scale for batch sizes (CLIP batches, embedding passes) and for
+ *     the thread counts of the AI stages that own their threads;
+ *   - whether AI stages are paused: while the user pans, zooms or steps
+ *     through images, and under heavy pressure.
+ *
+ * Modes: Background yields the most (one step more cautious than the
+ * machine's state asks), Balanced follows the state, MaxThroughput
+ * ignores the battery and backs off only when thermally critical.
+ *
+ * The power state is polled every POLL_INTERVAL_MS once
+ * startMonitoring() is called (Linux sysfs, macOS IOKit); without it,
+ * the machine is assumed on AC and cool. noteUserActivity() is GUI
+ * thread only; budget(), scaledBatchSize() and waitWhileAIPaused() are
+ * safe from the AI stage threads.
+ */
+class ResourceGovernor : public QObject {
+    Q_OBJECT
+
+public:
+    enum Mode { Background, Balanced, MaxThroughput };
+    enum class Thermal { Nominal, Fair, Serious, Critical };
+
+    struct PowerState {
+        bool onBattery = false;
+        int batteryPercent = -1;  // -1: unknown or no battery
+        Thermal thermal = Thermal::Nominal;
+    };
+
+    struct Budget {
+        int prefetchLimit = 1;
+        int ingestLimit = 1;
+        int aiLimit = 1;
+        double batchScale = 1.0;
+        bool aiPaused = false;
+
+        bool operator==(const Budget& other) const {
+            return prefetchLimit == other.prefetchLimit && ingestLimit == other.ingestLimit &&
+                   aiLimit == other.aiLimit && batchScale == other.batchScale &&
+                   aiPaused == other.aiPaused;
+        }
+        bool operator!=(const Budget& other) const { return !(*this == other); }
+    };
+
+    static ResourceGovernor& instance();
+
+    explicit ResourceGovernor(TaskScheduler& scheduler = TaskScheduler::instance(),
+                              QObject* parent = nullptr);
+
+    void setMode(Mode mode);
+    Mode mode() const;
+    static QString modeName(Mode mode);  // Stable, for QSettings
+    static std::optional<Mode> modeFromName(const QString& name);
+
+    void setPowerState(const PowerState& state);
+    PowerState powerState() const;
+    static PowerState probe();  // The machine's state now; defaults where unknown
+
+    void startMonitoring(int intervalMs = POLL_INTERVAL_MS);
+    void stopMonitoring();
+
+    // The user is interacting with the viewer; holds for ACTIVITY_HOLD_MS
+    void noteUserActivity();
+    bool userActive() const { return m_userActive; }
+
+    Budget budget() const;
+    static Budget compute(Mode mode, const PowerState& state, bool userActive, int workers);
+
+    // `preferred` scaled by the budget, at least 1
+    int scaledBatchSize(int preferred) const;
+    int scaledThreadCount(int preferred) const { return scaledBatchSize(preferred); }
+    bool aiPaused() const { return m_aiPaused.load(std::memory_order_relaxed); }
+
+    // Blocks while AI is paused, until resumed or `cancelled` is set
+    void waitWhileAIPaused(const QAtomicInt& cancelled) const;
+
+    static constexpr int POLL_INTERVAL_MS = 10000;
+    static constexpr int ACTIVITY_HOLD_MS = 1500;
+    static constexpr int LOW_BATTERY_PERCENT = 20;
+
+signals:
+    void budgetChanged();
+
+private:
+    void update();
+
+    TaskScheduler& m_scheduler;
+
+    mutable QMutex m_mutex;  // Guards m_mode, m_state, m_budget
+    Mode m_mode = Balanced;
+    PowerState m_state;
+    Budget m_budget;
+    bool m_userActive = false;  // GUI thread
+
+    std::atomic<bool> m_aiPaused{false};
+    std::atomic<int> m_batchPermille{1000};
+    mutable QMutex m_pauseMutex;
+    mutable QWaitCondition m_resumed;
+
+    QTimer m_pollTimer;
+    QTimer m_activityTimer;
+
+    static constexpr int PAUSE_RECHECK_MS = 100;  // How soon a paused stage notices a cancel
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,127 @@
+#include "SessionSnapshot.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+
+namespace PhotoGuru {
+
+namespace {
+
+constexpr quint32 SNAPSHOT_MAGIC = 0x53534750;  // "PGSS"
+constexpr quint32 SNAPSHOT_VERSION = 1;
+
+} // namespace
+
+QStringList SessionSnapshot::paths() const {
+    QDir dir(directory);
+    QStringList result;
+    result.reserve(files.size());
+    for (const File& file : files) {
+        result << dir.filePath(file.name);  // Same form as DirectoryWatcher::list()
+    }
+    return result;
+}
+
+DirectoryWatcher::Listing SessionSnapshot::listing() const {
+    QDir dir(directory);
+    DirectoryWatcher::Listing result;
+    result.reserve(files.size());
+    for (const File& file : files) {
+        result.insert(dir.filePath(file.name), DirectoryWatcher::Entry{file.mtime, file.size});
+    }
+    return result;
+}
+
+QList<SessionSnapshot::File> SessionSnapshot::filesOf(const QString& directory, const QStringList& paths,
+                                                      const DirectoryWatcher::Listing& listing) {
+    QDir dir(directory);
+    QList<File> result;
+    result.reserve(paths.size());
+    for (const QString& path : paths) {
+        auto entry = listing.constFind(path);
+        if (entry == listing.cend()) continue;
+        result.append(File{dir.relativeFilePath(path), entry->mtime, entry->size});
+    }
+    return result;
+}
+
+bool SessionSnapshot::save(const QString& path) const {
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        qWarning() << "[SessionSnapshot] Cannot create" << QFileInfo(path).absolutePath();
+        return false;
+    }
+
+    // Write-then-rename, so a crash on exit never leaves a torn snapshot
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[SessionSnapshot] Cannot write" << path << file.errorString();
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << SNAPSHOT_MAGIC << SNAPSHOT_VERSION;
+    out << directory << qint32(sortOrder) << qint32(thumbnailSize) << currentFile << qint32(scrollPosition);
+    out << quint32(files.size());
+    for (const File& entry : files) {
+        out << entry.name << entry.mtime << entry.size;
+    }
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "[SessionSnapshot] Write failed:" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+std::optional<SessionSnapshot> SessionSnapshot::load(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+        qWarning() << "[SessionSnapshot] Ignoring unreadable snapshot:" << path;
+        return std::nullopt;
+    }
+
+    SessionSnapshot snapshot;
+    qint32 sortOrder = 0;
+    qint32 thumbnailSize = 0;
+    qint32 scrollPosition = 0;
+    quint32 count = 0;
+    in >> snapshot.directory >> sortOrder >> thumbnailSize >> snapshot.currentFile >> scrollPosition >> count;
+    // Each entry takes at least a string length and two qint64s
+    if (in.status() != QDataStream::Ok || qint64(count) * 20 > file.size()) {
+        qWarning() << "[SessionSnapshot] Ignoring truncated snapshot:" << path;
+        return std::nullopt;
+    }
+    snapshot.sortOrder = sortOrder;
+    snapshot.thumbnailSize = thumbnailSize;
+    snapshot.scrollPosition = scrollPosition;
+
+    snapshot.files.reserve(int(count));
+    for (quint32 i = 0; i < count; i++) {
+        File entry;
+        in >> entry.name >> entry.mtime >> entry.size;
+        snapshot.files.append(entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "[SessionSnapshot] Ignoring truncated snapshot:" << path;
+        return std::nullopt;
+    }
+    return snapshot;
+}
+
+QString SessionSnapshot::defaultPath() {
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/session.bin";
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "DirectoryWatcher.h"
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <optional>
+
+namespace PhotoGuru {
+
+/**
+ * @brief The folder view the viewer closed with, to bring back at once
+ *
+ * Listing and preloading a large folder takes seconds, so the last one
+ * is snapshotted on exit: its files with their mtime and size, the sort
+ * order, thumbnail size, selected file and scroll position. At startup
+ * the grid is filled from it straight away; the DirectoryWatcher then
+ * lists the folder in the background against the snapshot's listing and
+ * reports whatever changed while the viewer was closed. Thumbnails come
+ * from the ThumbnailStore pack, metadata from the catalog, as usual.
+ *
+ * A small versioned binary file, written with write-then-rename.
+ */
+struct SessionSnapshot {
+    struct File {
+        QString name;  // Relative to directory
+        qint64 mtime = 0;
+        qint64 size = 0;
+    };
+
+    QString directory;
+    QList<File> files;  // Name order, as DirectoryWatcher lists them
+    int sortOrder = 0;  // Index of the toolbar's sort combo
+    int thumbnailSize = 150;
+    QString currentFile;  // Absolute path; empty if none
+    int scrollPosition = 0;
+
+    // Absolute paths, in order
+    QStringList paths() const;
+    // What DirectoryWatcher would have listed when the snapshot was taken
+    DirectoryWatcher::Listing listing() const;
+    // Files of `paths` that appear in `listing`, in that order
+    static QList<File> filesOf(const QString& directory, const QStringList& paths,
+                               const DirectoryWatcher::Listing& listing);
+
+    bool save(const QString& path) const;
+    // Empty if missing, unreadable or from another version
+    static std::optional<SessionSnapshot> load(const QString& path);
+
+    static QString defaultPath();  // AppDataLocation/session.bin
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QAtomicInteger>
+#include <array>
+#include <optional>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Hash map split into independently locked shards, for many threads
+ *
+ * Each key lives in one of Shards QHashes behind its own read-write lock,
+ * so writers on different shards never contend and readers only wait for
+ * a writer of the same shard. snapshot() copies each shard under a brief
+ * read lock; QHash is implicitly shared, so that costs nothing until the
+ * next write to the shard.
+ *
+ * revision() changes on every write, for cheap "anything new?" checks.
+ */
+template <typename K, typename V, int Shards = 16>
+class ShardedHash {
+public:
+    std::optional<V> value(const K& key) const {
+        const Shard& shard = shardFor(key);
+        QReadLocker lock(&shard.lock);
+        auto it = shard.items.constFind(key);
+        if (it == shard.items.cend()) return std::nullopt;
+        return *it;
+    }
+
+    bool contains(const K& key) const {
+        const Shard& shard = shardFor(key);
+        QReadLocker lock(&shard.lock);
+        return shard.items.contains(key);
+    }
+
+    void insert(const K& key, const V& value) {
+        Shard& shard = shardFor(key);
+        QWriteLocker lock(&shard.lock);
+        shard.items.insert(key, value);
+        m_revision.fetchAndAddRelaxed(1);
+    }
+
+    // One lock per shard instead of one per item
+    void insert(const QHash<K, V>& items) {
+        std::array<QHash<K, V>, Shards> split;
+        for (auto it = items.cbegin(); it != items.cend(); ++it) {
+            split[shardIndex(it.key())].insert(it.key(), it.value());
+        }
+        for (int i = 0; i < Shards; ++i) {
+            if (split[i].isEmpty()) continue;
+            QWriteLocker lock(&m_shards[i].lock);
+            m_shards[i].items.insert(split[i]);
+        }
+        if (!items.isEmpty()) m_revision.fetchAndAddRelaxed(1);
+    }
+
+    bool remove(const K& key) {
+        Shard& shard = shardFor(key);
+        QWriteLocker lock(&shard.lock);
+        if (shard.items.remove(key) == 0) return false;
+        m_revision.fetchAndAddRelaxed(1);
+        return true;
+    }
+
+    void clear() {
+        for (Shard& shard : m_shards) {
+            QWriteLocker lock(&shard.lock);
+            shard.items.clear();
+        }
+        m_revision.fetchAndAddRelaxed(1);
+    }
+
+    int size() const {
+        int total = 0;
+        for (const Shard& shard : m_shards) {
+            QReadLocker lock(&shard.lock);
+            total += shard.items.size();
+        }
+        return total;
+    }
+
+    // Not atomic across shards: writes racing with the call may be missed
+    QHash<K, V> snapshot() const {
+        std::array<QHash<K, V>, Shards> copies;
+        int total = 0;
+        for (int i = 0; i < Shards; ++i) {
+            QReadLocker lock(&m_shards[i].lock);
+            copies[i] = m_shards[i].items;
+            total += copies[i].size();
+        }
+        QHash<K, V> merged;
+        merged.reserve(total);
+        for (const QHash<K, V>& copy : copies) {
+            merged.insert(copy);
+        }
+        return merged;
+    }
+
+    quint64 revision() const { return m_revision.loadRelaxed(); }
+
+private:
+    struct Shard {
+        mutable QReadWriteLock lock;
+        QHash<K, V> items;
+    };
+
+    static int shardIndex(const K& key) { return int(qHash(key) % Shards); }
+    Shard& shardFor(const K& key) { return m_shards[shardIndex(key)]; }
+    const Shard& shardFor(const K& key) const { return m_shards[shardIndex(key)]; }
+
+    std::array<Shard, Shards> m_shards;
+    QAtomicInteger<quint64> m_revision{0};
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,149 @@
+#include "SortKeyTable.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <algorithm>
+#include <numeric>
+
+namespace PhotoGuru {
+
+void SortKeyTable::clear() {
+    m_keys.clear();
+    m_names.clear();
+    m_paths.clear();
+    m_slots.clear();
+}
+
+int SortKeyTable::slot(const QString& path) {
+    auto it = m_slots.constFind(path);
+    if (it != m_slots.cend()) return it.value();
+
+    const int row = int(m_keys.size());
+    m_keys.emplace_back();
+    m_names.append(nameKey(QFileInfo(path).fileName()));  // String work only, no stat()
+    m_paths.append(path);
+    m_slots.insert(path, row);
+    return row;
+}
+
+void SortKeyTable::setFileInfo(const QString& path, qint64 mtime, qint64 size) {
+    Key& key = m_keys[slot(path)];
+    key.modified = mtime;
+    key.size = size;
+}
+
+void SortKeyTable::setFileInfo(const DirectoryWatcher::Listing& listing) {
+    m_keys.reserve(m_keys.size() + listing.size());
+    for (auto it = listing.cbegin(); it != listing.cend(); ++it) {
+        setFileInfo(it.key(), it->mtime, it->size);
+    }
+}
+
+void SortKeyTable::setMetadata(const PhotoMetadata& meta) {
+    Key& key = m_keys[slot(meta.filepath)];
+    key.captureTime = meta.datetime_original.isValid() ? meta.datetime_original.toMSecsSinceEpoch() : 0;
+    key.rating = qint8(meta.rating);
+    key.quality = meta.technical.overall_quality > 0.0 ? float(meta.technical.overall_quality) : -1.0f;
+}
+
+void SortKeyTable::remove(const QStringList& paths) {
+    for (const QString& path : paths) {
+        auto it = m_slots.find(path);
+        if (it == m_slots.end()) continue;
+        const int row = it.value();
+        m_slots.erase(it);
+
+        // Move the last row into the hole
+        const int last = int(m_keys.size()) - 1;
+        if (row != last) {
+            m_keys[row] = m_keys[last];
+            m_names[row] = m_names[last];
+            m_paths[row] = m_paths[last];
+            m_slots[m_paths[row]] = row;
+        }
+        m_keys.pop_back();
+        m_names.removeLast();
+        m_paths.removeLast();
+    }
+}
+
+void SortKeyTable::fillFileInfo(int row) {
+    QFileInfo info(m_paths[row]);
+    m_keys[row].modified = info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0;
+    m_keys[row].size = info.exists() ? info.size() : 0;
+}
+
+void SortKeyTable::sort(QStringList& paths, SortOrder order) {
+    std::vector<int> rows(paths.size());
+    for (int i = 0; i < paths.size(); i++) {
+        rows[i] = slot(paths[i]);
+    }
+    if (order == SortOrder::ByDate || order == SortOrder::BySize || order == SortOrder::ByCaptureDate) {
+        for (int row : rows) {
+            if (m_keys[row].size < 0) fillFileInfo(row);
+        }
+    }
+
+    // Ties fall back to name order; stable for equal names
+    std::vector<int> byIndex(rows.size());
+    std::iota(byIndex.begin(), byIndex.end(), 0);
+    const Key* keys = m_keys.data();
+    auto sortBy = [&](auto field) {
+        std::stable_sort(byIndex.begin(), byIndex.end(), [&](int a, int b) {
+            const Key& left = keys[rows[a]];
+            const Key& right = keys[rows[b]];
+            if (field(left) != field(right)) return field(left) > field(right);
+            return m_names[rows[a]] < m_names[rows[b]];
+        });
+    };
+    switch (order) {
+        case SortOrder::ByName:
+            std::stable_sort(byIndex.begin(), byIndex.end(),
+                             [&](int a, int b) { return m_names[rows[a]] < m_names[rows[b]]; });
+            break;
+        case SortOrder::ByDate:
+            sortBy([](const Key& key) { return key.modified; });
+            break;
+        case SortOrder::BySize:
+            sortBy([](const Key& key) { return key.size; });
+            break;
+        case SortOrder::ByCaptureDate:
+            sortBy([](const Key& key) { return key.captureTime ? key.captureTime : key.modified; });
+            break;
+        case SortOrder::ByQuality:
+            sortBy([](const Key& key) { return key.quality; });
+            break;
+        case SortOrder::ByRating:
+            sortBy([](const Key& key) { return key.rating; });
+            break;
+    }
+
+    QStringList sorted;
+    sorted.reserve(paths.size());
+    for (int i : byIndex) sorted.append(paths[i]);
+    paths = std::move(sorted);
+}
+
+QString SortKeyTable::nameKey(const QString& fileName) {
+    const QString folded = fileName.toCaseFolded();
+    QString key;
+    key.reserve(folded.size() + DIGIT_WIDTH);
+    for (int i = 0; i < folded.size();) {
+        if (folded[i] < u'0' || folded[i] > u'9') {
+            key.append(folded[i++]);
+            continue;
+        }
+        int end = i;
+        while (end < folded.size() && folded[end] >= u'0' && folded[end] <= u'9') end++;
+        int start = i;
+        while (start < end - 1 && folded[start] == u'0') start++;  // 007 sorts as 7
+
+        // Padded to one width, numbers compare as strings compare
+        const int digits = end - start;
+        if (digits < DIGIT_WIDTH) key.append(QString(DIGIT_WIDTH - digits, u'0'));
+        key.append(QStringView(folded).mid(start, digits));
+        i = end;
+    }
+    return key;
+}
+
+} // namespace PhotoGuru
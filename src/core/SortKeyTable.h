@@ -0,0 +1,73 @@
+#pragma once
+
+#include "DirectoryWatcher.h"
+#include "PhotoMetadata.h"
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+namespace PhotoGuru {
+
+enum class SortOrder {
+    ByName,
+    ByDate,         // File modified, newest first
+    BySize,         // Largest first
+    ByCaptureDate,  // EXIF capture time, newest first; file date without one
+    ByQuality,      // Overall quality score, best first; unanalyzed last
+    ByRating        // Most stars first
+};
+
+/**
+ * @brief Sort keys of the grid's files, gathered once instead of per comparison
+ *
+ * Sorting by asking the filesystem inside the comparator costs
+ * O(N log N) stat() calls, which crawls on a network share. Here each
+ * file has one packed Key row, filled from what the viewer already has:
+ * the DirectoryWatcher listing (mtime, size) and the loaded metadata
+ * (capture time, rating, quality). A sort is then N hash lookups and a
+ * std::stable_sort over the rows, with no I/O.
+ *
+ * Names sort by nameKey(): case-folded, with digit runs compared as
+ * numbers, so IMG_2 comes before IMG_10. Ties keep name order.
+ * Files sorted by date or size before any listing reached the table
+ * are stat()ed once, not per comparison. GUI thread only.
+ */
+class SortKeyTable {
+public:
+    void clear();
+    int size() const { return int(m_keys.size()); }
+    bool contains(const QString& path) const { return m_slots.contains(path); }
+
+    void setFileInfo(const QString& path, qint64 mtime, qint64 size);
+    void setFileInfo(const DirectoryWatcher::Listing& listing);
+    // Capture time, rating and quality
+    void setMetadata(const PhotoMetadata& meta);
+    void remove(const QStringList& paths);
+
+    // Stable; files that compare equal stay in name order
+    void sort(QStringList& paths, SortOrder order);
+
+    static QString nameKey(const QString& fileName);
+
+private:
+    struct Key {
+        qint64 captureTime = 0;  // ms since epoch, 0 if unknown
+        qint64 modified = 0;     // ms since epoch
+        qint64 size = -1;        // -1: no listing or stat() yet
+        float quality = -1.0f;   // -1: not analyzed
+        qint8 rating = 0;
+    };
+
+    int slot(const QString& path);  // Adds a row for a new path
+    void fillFileInfo(int slot);
+
+    std::vector<Key> m_keys;
+    QStringList m_names;  // nameKey() per row
+    QStringList m_paths;  // Per row, for remove()
+    QHash<QString, int> m_slots;
+
+    static constexpr int DIGIT_WIDTH = 20;  // Digit runs are padded to this many characters
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,458 @@
+#include "TaskScheduler.h"
+#include "Trace.h"
+#include <QList>
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace PhotoGuru {
+
+namespace {
+
+// Which scheduler's worker the current thread is, if any
+thread_local const TaskScheduler* t_scheduler = nullptr;
+thread_local int t_worker = -1;
+
+} // namespace
+
+struct TaskScheduler::Group {
+    QMutex mutex;
+    QWaitCondition done;
+    QHash<QRunnable*, Job*> queued;  // Started, not yet running
+    int outstanding = 0;             // Queued plus running, under mutex
+    int helpers = 0;                 // Workers in waitForDone(), woken on every change
+    quint64 changes = 0;             // Bumped per start and finish, so helpers see what they missed
+    std::atomic<int> running{0};
+    std::atomic<int> max{0};
+};
+
+struct TaskScheduler::Job {
+    // Queued -> Running when a worker claims it, Queued -> Dropped when
+    // tryTake()/clear()/its token gets there first. A dropped job stays
+    // in its deque until a worker meets it and deletes it.
+    enum State { Queued, Running, Dropped };
+
+    QRunnable* runnable;
+    bool autoDelete;
+    std::shared_ptr<Group> group;
+    int priority;
+    int rank;
+    CancellationToken token;
+    std::atomic<int> state{Queued};
+};
+
+struct TaskScheduler::Worker {
+    QMutex mutex;
+    std::array<std::deque<Job*>, PRIORITY_COUNT> local;  // Subtasks this worker submitted
+};
+
+TaskScheduler& TaskScheduler::instance() {
+    // Two at least: a bulk task waiting on interactive work must not
+    // hold the only worker
+    static TaskScheduler instance(std::max(2, QThread::idealThreadCount()));
+    return instance;
+}
+
+TaskScheduler::TaskScheduler(int workers) {
+    workers = std::max(1, workers);
+
+    // Bulk classes leave cores free for what the user is waiting on
+    m_limits[Interactive] = workers;
+    m_limits[Prefetch] = workers;
+    m_limits[Ingest] = std::max(1, workers - 1);
+    m_limits[AI] = std::max(1, workers / 2);
+
+    // Workers trace; make sure the registry outlives them
+    Trace::metric("scheduler.active", TraceMetric::Gauge);
+
+    for (int i = 0; i < workers; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < workers; i++) {
+        m_threads.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    m_stopping.store(true);
+    {
+        QMutexLocker locker(&m_idleMutex);
+        m_signals++;
+        m_wake.wakeAll();
+    }
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+
+    // Nothing runs any more: drop what's left so waiting groups return
+    auto drop = [](std::deque<Job*>& queue) {
+        for (Job* job : queue) {
+            int expected = Job::Queued;
+            if (job->state.compare_exchange_strong(expected, Job::Dropped)) {
+                QMutexLocker locker(&job->group->mutex);
+                if (job->group->queued.value(job->runnable) == job) {
+                    job->group->queued.remove(job->runnable);
+                }
+                if (--job->group->outstanding == 0) job->group->done.wakeAll();
+                locker.unlock();
+                if (job->autoDelete) delete job->runnable;
+            }
+            delete job;
+        }
+        queue.clear();
+    };
+    for (auto& queue : m_shared) drop(queue);
+    for (auto& worker : m_workers) {
+        for (auto& queue : worker->local) drop(queue);
+    }
+}
+
+void TaskScheduler::setClassLimit(Priority priority, int limit) {
+    m_limits[priority].store(std::clamp(limit, 1, workerCount()));
+    signal(true);  // A raised limit may unblock several queued tasks
+}
+
+int TaskScheduler::classLimit(Priority priority) const {
+    return m_limits[priority].load();
+}
+
+int TaskScheduler::activeCount() const {
+    int active = 0;
+    for (const auto& running : m_running) active += running.load(std::memory_order_relaxed);
+    return active;
+}
+
+int TaskScheduler::activeCount(Priority priority) const {
+    return m_running[priority].load(std::memory_order_relaxed);
+}
+
+int TaskScheduler::queuedCount() const {
+    return m_queued.load(std::memory_order_relaxed);
+}
+
+bool TaskScheduler::onWorker() const {
+    return t_scheduler == this && t_worker >= 0;
+}
+
+void TaskScheduler::submit(Job* job) {
+    m_queued.fetch_add(1, std::memory_order_relaxed);
+
+    if (onWorker()) {
+        // A subtask: keep it hot on this worker, others steal if idle
+        Worker& worker = *m_workers[t_worker];
+        QMutexLocker locker(&worker.mutex);
+        worker.local[job->priority].push_back(job);
+    } else {
+        // Higher rank first, FIFO within a rank; equal ranks append in O(1)
+        QMutexLocker locker(&m_sharedMutex);
+        std::deque<Job*>& queue = m_shared[job->priority];
+        auto position = queue.end();
+        while (position != queue.begin() && (*(position - 1))->rank < job->rank) {
+            --position;
+        }
+        queue.insert(position, job);
+    }
+
+    TRACE_GAUGE("scheduler.queued", m_queued.load(std::memory_order_relaxed));
+    signal();
+}
+
+TaskScheduler::Claim TaskScheduler::claim(Job* job) {
+    if (job->state.load() != Job::Queued) return Discarded;
+
+    Group& group = *job->group;
+    if (job->token.isCancelled()) {
+        int expected = Job::Queued;
+        if (!job->state.compare_exchange_strong(expected, Job::Dropped)) return Discarded;
+        QMutexLocker locker(&group.mutex);
+        if (group.queued.value(job->runnable) == job) group.queued.remove(job->runnable);
+        if (--group.outstanding == 0) group.done.wakeAll();
+        locker.unlock();
+        if (job->autoDelete) delete job->runnable;
+        return Discarded;
+    }
+
+    // The group's own cap, like QThreadPool::maxThreadCount()
+    int running = group.running.load();
+    do {
+        const int max = group.max.load();
+        if (max > 0 && running >= max) return Ineligible;
+    } while (!group.running.compare_exchange_weak(running, running + 1));
+
+    int expected = Job::Queued;
+    if (!job->state.compare_exchange_strong(expected, Job::Running)) {
+        group.running.fetch_sub(1);  // tryTake() won
+        return Discarded;
+    }
+
+    QMutexLocker locker(&group.mutex);
+    if (group.queued.value(job->runnable) == job) group.queued.remove(job->runnable);
+    return Claimed;
+}
+
+TaskScheduler::Job* TaskScheduler::popEligible(std::deque<Job*>& queue, bool newestFirst,
+                                               const Group* group) {
+    size_t i = newestFirst ? queue.size() : 0;
+    for (;;) {
+        if (newestFirst) {
+            if (i == 0) return nullptr;
+            --i;
+        } else if (i >= queue.size()) {
+            return nullptr;
+        }
+
+        Job* job = queue[i];
+        if (group && job->group.get() != group) {
+            if (!newestFirst) ++i;
+            continue;
+        }
+        const Claim result = claim(job);
+        if (result == Ineligible) {
+            if (!newestFirst) ++i;
+            continue;  // Its group is at its cap; look further
+        }
+        queue.erase(queue.begin() + std::ptrdiff_t(i));
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        if (result == Claimed) return job;
+        delete job;
+    }
+}
+
+TaskScheduler::Job* TaskScheduler::takeJob(int self) {
+    for (int priority = 0; priority < PRIORITY_COUNT; priority++) {
+        // Reserve a slot in the class before looking, so a class never
+        // runs more than its limit however many workers race for it
+        std::atomic<int>& running = m_running[priority];
+        int current = running.load();
+        bool reserved = false;
+        while (current < m_limits[priority].load()) {
+            if (running.compare_exchange_weak(current, current + 1)) {
+                reserved = true;
+                break;
+            }
+        }
+        if (!reserved) continue;
+
+        Job* job = nullptr;
+        {
+            QMutexLocker locker(&m_workers[self]->mutex);
+            job = popEligible(m_workers[self]->local[priority], true);
+        }
+        if (!job) {
+            QMutexLocker locker(&m_sharedMutex);
+            job = popEligible(m_shared[priority], false);
+        }
+        for (int offset = 1; !job && offset < workerCount(); offset++) {
+            Worker& victim = *m_workers[(self + offset) % workerCount()];
+            QMutexLocker locker(&victim.mutex);
+            job = popEligible(victim.local[priority], false);
+        }
+        if (job) return job;
+
+        running.fetch_sub(1);
+    }
+    return nullptr;
+}
+
+bool TaskScheduler::helpWith(const Group* group) {
+    const int self = t_worker;
+    Job* job = nullptr;
+    for (int priority = 0; !job && priority < PRIORITY_COUNT; priority++) {
+        {
+            QMutexLocker locker(&m_workers[self]->mutex);
+            job = popEligible(m_workers[self]->local[priority], true, group);
+        }
+        if (!job) {
+            QMutexLocker locker(&m_sharedMutex);
+            job = popEligible(m_shared[priority], false, group);
+        }
+        for (int offset = 1; !job && offset < workerCount(); offset++) {
+            Worker& victim = *m_workers[(self + offset) % workerCount()];
+            QMutexLocker locker(&victim.mutex);
+            job = popEligible(victim.local[priority], false, group);
+        }
+    }
+    if (!job) return false;
+
+    // No class slot to reserve: the waiting task lends its own, which
+    // sits idle until the group is done. Waiting for one instead could
+    // deadlock a class whose every slot is a waiter.
+    m_running[job->priority].fetch_add(1);
+    job->runnable->run();
+    finish(job);
+    return true;
+}
+
+void TaskScheduler::finish(Job* job) {
+    if (job->autoDelete) delete job->runnable;
+
+    // Class slot first: once waitForDone() returns nothing counts as running
+    m_running[job->priority].fetch_sub(1);
+    Group& group = *job->group;
+    {
+        QMutexLocker locker(&group.mutex);
+        group.running.fetch_sub(1);
+        group.changes++;
+        // Helpers also wake for a freed group slot
+        if (--group.outstanding == 0 || group.helpers > 0) group.done.wakeAll();
+    }
+    delete job;
+
+    // A freed class or group slot may make queued work eligible; this
+    // worker takes one job itself, a woken one the other
+    if (m_queued.load(std::memory_order_relaxed) > 0) signal();
+}
+
+void TaskScheduler::workerLoop(int self) {
+    t_scheduler = this;
+    t_worker = self;
+
+    while (!m_stopping.load()) {
+        quint64 seen;
+        {
+            QMutexLocker locker(&m_idleMutex);
+            seen = m_signals;
+        }
+
+        if (Job* job = takeJob(self)) {
+            TRACE_GAUGE("scheduler.active", activeCount());
+            job->runnable->run();
+            finish(job);
+            continue;
+        }
+
+        // Sleep only if nothing was submitted or freed since we looked;
+        // until signal(): an idle scheduler wakes nobody
+        QMutexLocker locker(&m_idleMutex);
+        if (m_stopping.load() || m_signals != seen) continue;
+        m_sleeping++;
+        m_wake.wait(&m_idleMutex);
+        m_sleeping--;
+    }
+}
+
+void TaskScheduler::signal(bool everyone) {
+    QMutexLocker locker(&m_idleMutex);
+    m_signals++;
+    if (m_sleeping == 0) return;
+    if (everyone) {
+        m_wake.wakeAll();
+    } else {
+        m_wake.wakeOne();
+    }
+}
+
+// TaskGroup
+
+TaskGroup::TaskGroup(TaskScheduler::Priority priority, TaskScheduler& scheduler)
+    : m_scheduler(scheduler)
+    , m_priority(priority)
+    , m_group(std::make_shared<TaskScheduler::Group>())
+{
+}
+
+TaskGroup::~TaskGroup() {
+    clear();
+    waitForDone();
+}
+
+void TaskGroup::setMaxConcurrency(int max) {
+    m_group->max.store(std::max(0, max));
+    m_scheduler.signal(true);  // A raised cap may unblock several
+}
+
+int TaskGroup::maxConcurrency() const {
+    return m_group->max.load();
+}
+
+void TaskGroup::start(QRunnable* task, int rank, const CancellationToken& token) {
+    start(task, m_priority, rank, token);
+}
+
+void TaskGroup::start(QRunnable* task, TaskScheduler::Priority priority, int rank,
+                      const CancellationToken& token) {
+    if (!task) return;
+
+    auto* job = new TaskScheduler::Job{task, task->autoDelete(), m_group, priority, rank, token};
+    {
+        QMutexLocker locker(&m_group->mutex);
+        m_group->queued.insert(task, job);
+        m_group->outstanding++;
+        m_group->changes++;
+        if (m_group->helpers > 0) m_group->done.wakeAll();
+    }
+    m_scheduler.submit(job);
+}
+
+void TaskGroup::start(std::function<void()> function, TaskScheduler::Priority priority, int rank,
+                      const CancellationToken& token) {
+    start(QRunnable::create(std::move(function)), priority, rank, token);
+}
+
+bool TaskGroup::tryTake(QRunnable* task) {
+    QMutexLocker locker(&m_group->mutex);
+    TaskScheduler::Job* job = m_group->queued.value(task);
+    if (!job) return false;
+
+    int expected = TaskScheduler::Job::Queued;
+    if (!job->state.compare_exchange_strong(expected, TaskScheduler::Job::Dropped)) {
+        return false;  // A worker claimed it first
+    }
+    m_group->queued.remove(task);
+    if (--m_group->outstanding == 0) m_group->done.wakeAll();
+    return true;
+}
+
+void TaskGroup::clear() {
+    QList<QRunnable*> dropped;
+    {
+        QMutexLocker locker(&m_group->mutex);
+        for (auto it = m_group->queued.cbegin(); it != m_group->queued.cend(); ++it) {
+            TaskScheduler::Job* job = it.value();
+            // Read before the exchange: once dropped, a worker may delete the job
+            const bool autoDelete = job->autoDelete;
+            int expected = TaskScheduler::Job::Queued;
+            if (job->state.compare_exchange_strong(expected, TaskScheduler::Job::Dropped)) {
+                if (autoDelete) dropped << it.key();
+                m_group->outstanding--;
+            }
+        }
+        m_group->queued.clear();
+        if (m_group->outstanding == 0) m_group->done.wakeAll();
+    }
+    qDeleteAll(dropped);
+}
+
+void TaskGroup::waitForDone() {
+    QMutexLocker locker(&m_group->mutex);
+    if (!m_scheduler.onWorker()) {
+        while (m_group->outstanding > 0) {
+            m_group->done.wait(&m_group->mutex);
+        }
+        return;
+    }
+
+    // On a worker, blocking would take a core from the tasks we wait
+    // for; run them here instead, and only sleep while they all run
+    // elsewhere (or wait on the group's cap)
+    m_group->helpers++;
+    while (m_group->outstanding > 0) {
+        const quint64 seen = m_group->changes;
+        locker.unlock();
+        const bool helped = m_scheduler.helpWith(m_group.get());
+        locker.relock();
+        if (helped || m_group->changes != seen) continue;
+        m_group->done.wait(&m_group->mutex);
+    }
+    m_group->helpers--;
+}
+
+int TaskGroup::activeCount() const {
+    return m_group->running.load(std::memory_order_relaxed);
+}
+
+int TaskGroup::queuedCount() const {
+    QMutexLocker locker(&m_group->mutex);
+    return int(m_group->queued.size());
+}
+
+} // namespace PhotoGuru
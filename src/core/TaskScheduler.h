@@ -0,0 +1,202 @@
+#pragma once
+
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <QPromise>
+#include <QRunnable>
+#include <QWaitCondition>
+#include <QThread>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Shared cancellation flag for scheduled work
+ *
+ * Copies share one flag. A queued task whose token is cancelled is
+ * dropped instead of run; a running one can poll isCancelled().
+ * A default-constructed token is never cancelled.
+ */
+class CancellationToken {
+public:
+    CancellationToken() = default;
+    static CancellationToken create() {
+        CancellationToken token;
+        token.m_flag = std::make_shared<std::atomic<bool>>(false);
+        return token;
+    }
+
+    void cancel() { if (m_flag) m_flag->store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return m_flag && m_flag->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_flag;
+};
+
+class TaskGroup;
+
+/**
+ * @brief One work-stealing thread pool for the whole application
+ *
+ * Sized to the machine (QThread::idealThreadCount()) instead of a pool
+ * per subsystem, so thumbnails, decodes, metadata reads and folder
+ * ingest share the cores without oversubscribing them. Subsystems
+ * submit through a TaskGroup, which keeps QThreadPool's start/tryTake/
+ * clear/waitForDone shape plus a concurrency cap of its own.
+ *
+ * Every task has a Priority class, and within a class a rank (higher
+ * first, like QThreadPool priorities). A free worker always takes the
+ * most urgent class it may run: Interactive before Prefetch before
+ * Ingest before AI. Tasks can't be interrupted once running, so bulk
+ * classes are capped below the worker count (classLimit()); the cores
+ * left over are always free for interactive work the moment it arrives.
+ *
+ * Tasks submitted from outside go to a shared queue per class; tasks a
+ * worker submits (subtasks) go to that worker's own deque, which it runs
+ * newest first and idle workers steal from oldest first. A task that
+ * waits for a group helps instead of blocking: TaskGroup::waitForDone()
+ * on a worker runs the group's queued tasks itself, so fanning out and
+ * joining from inside a task can't starve the pool.
+ */
+class TaskScheduler {
+public:
+    enum Priority {
+        Interactive,  // What the user is looking at, now
+        Prefetch,     // Likely next: neighbours, rows just off screen
+        Ingest,       // Folder loads, metadata preload, catalog writes
+        AI,           // Embeddings, captions, quality passes
+    };
+    static constexpr int PRIORITY_COUNT = 4;
+
+    static TaskScheduler& instance();
+
+    explicit TaskScheduler(int workers = QThread::idealThreadCount());
+    ~TaskScheduler();  // Drops queued tasks, waits for running ones
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    int workerCount() const { return int(m_workers.size()); }
+
+    // Most tasks of `priority` running at once; clamped to [1, workerCount()]
+    void setClassLimit(Priority priority, int limit);
+    int classLimit(Priority priority) const;
+
+    int activeCount() const;  // Tasks running now
+    int activeCount(Priority priority) const;
+    int queuedCount() const;  // Tasks waiting, cancelled ones not yet discarded
+
+private:
+    friend class TaskGroup;
+    struct Group;
+    struct Job;
+    struct Worker;
+
+    enum Claim { Claimed, Ineligible, Discarded };
+
+    bool onWorker() const;  // The calling thread is one of this scheduler's workers
+    void submit(Job* job);
+    Job* takeJob(int self);
+    // Claims the first runnable job; only `group`'s when one is given
+    Job* popEligible(std::deque<Job*>& queue, bool newestFirst, const Group* group = nullptr);
+    bool helpWith(const Group* group);  // Runs one of its queued jobs here, if any
+    Claim claim(Job* job);
+    void finish(Job* job);
+    void workerLoop(int self);
+    // New work or a freed slot; `everyone` when it may unblock more than one task
+    void signal(bool everyone = false);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+
+    QMutex m_sharedMutex;  // Guards m_shared
+    std::array<std::deque<Job*>, PRIORITY_COUNT> m_shared;  // By rank, then FIFO
+
+    std::array<std::atomic<int>, PRIORITY_COUNT> m_running{};
+    std::array<std::atomic<int>, PRIORITY_COUNT> m_limits{};
+    std::atomic<int> m_queued{0};
+    std::atomic<bool> m_stopping{false};
+
+    QMutex m_idleMutex;
+    QWaitCondition m_wake;
+    int m_sleeping = 0;
+    quint64 m_signals = 0;  // Bumped by signal(); a worker sleeps only if it didn't move
+};
+
+/**
+ * @brief A subsystem's share of the TaskScheduler
+ *
+ * Drop-in for a private QThreadPool: start() takes a QRunnable (deleted
+ * after running if autoDelete()) or a callable; tryTake() gets back a
+ * task that hasn't started; clear() drops the group's queued tasks;
+ * waitForDone() waits for the group's own tasks only, running them
+ * on the calling thread while any are queued if that is a worker.
+ * setMaxConcurrency() caps how many of them run at once (e.g. one per
+ * ExifTool process), like QThreadPool::setMaxThreadCount().
+ *
+ * The destructor clears and waits, so tasks never outlive their owner.
+ */
+class TaskGroup {
+public:
+    explicit TaskGroup(TaskScheduler::Priority priority,
+                       TaskScheduler& scheduler = TaskScheduler::instance());
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    TaskScheduler::Priority priority() const { return m_priority; }
+
+    void setMaxConcurrency(int max);  // 0 = no cap beyond the scheduler's
+    int maxConcurrency() const;
+
+    // `rank` orders tasks within their class; higher runs first
+    void start(QRunnable* task, int rank = 0, const CancellationToken& token = {});
+    void start(QRunnable* task, TaskScheduler::Priority priority, int rank = 0,
+               const CancellationToken& token = {});
+    void start(std::function<void()> function, TaskScheduler::Priority priority, int rank = 0,
+               const CancellationToken& token = {});
+    void start(std::function<void()> function) { start(std::move(function), m_priority); }
+
+    // Runs `function` and reports its result through the future; a
+    // task dropped before it ran (clear(), token) cancels the future
+    template <typename Function>
+    auto run(TaskScheduler::Priority priority, Function function)
+        -> QFuture<std::invoke_result_t<Function>> {
+        using Result = std::invoke_result_t<Function>;
+        auto promise = std::make_shared<QPromise<Result>>();
+        QFuture<Result> future = promise->future();
+        promise->start();
+        start([promise, function = std::move(function)]() mutable {
+            if constexpr (std::is_void_v<Result>) {
+                function();
+            } else {
+                promise->addResult(function());
+            }
+            promise->finish();
+        }, priority);
+        return future;
+    }
+
+    bool tryTake(QRunnable* task);  // Ownership passes back to the caller
+    void clear();
+    void waitForDone();
+
+    int activeCount() const;
+    int queuedCount() const;
+
+private:
+    TaskScheduler& m_scheduler;
+    TaskScheduler::Priority m_priority;
+    std::shared_ptr<TaskScheduler::Group> m_group;
+};
+
+} // namespace PhotoGuru
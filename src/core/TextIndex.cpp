@@ -0,0 +1,123 @@
+#include "TextIndex.h"
+#include <algorithm>
+#include <iterator>
+
+namespace PhotoGuru {
+
+QStringList TextIndex::documentFields(const PhotoMetadata& meta) {
+    // Filename without path
+    QString filename = meta.filename;
+    if (filename.contains('/')) {
+        filename = filename.mid(filename.lastIndexOf('/') + 1);
+    }
+
+    QStringList fields = {
+        meta.llm_title,
+        meta.llm_description,
+        meta.llm_category,
+        meta.llm_scene,
+        meta.llm_mood,
+        meta.location_name,
+        meta.camera_make + " " + meta.camera_model,
+        filename
+    };
+    fields += meta.llm_keywords;
+    return fields;
+}
+
+void TextIndex::clear() {
+    m_tokenIds.clear();
+    m_tokens.clear();
+    m_postings.clear();
+    m_rowTokens.clear();
+}
+
+void TextIndex::setDocument(int row, const QStringList& fields) {
+    if (row < 0) return;
+
+    removeDocument(row);
+    if (size_t(row) >= m_rowTokens.size()) {
+        m_rowTokens.resize(size_t(row) + 1);
+    }
+
+    std::vector<quint32>& rowTokens = m_rowTokens[row];
+    int slotCount = qMin(int(fields.size()), 0xFFFF);
+    for (int slot = 0; slot < slotCount; ++slot) {
+        const QStringList tokens = fields[slot].toLower().split(' ', Qt::SkipEmptyParts);
+        quint64 key = makeKey(row, slot);
+
+        for (const QString& token : tokens) {
+            auto it = m_tokenIds.constFind(token);
+            quint32 id;
+            if (it == m_tokenIds.constEnd()) {
+                id = quint32(m_tokens.size());
+                m_tokens.append(token);
+                m_tokenIds.insert(token, id);
+                m_postings.emplace_back();
+            } else {
+                id = it.value();
+            }
+
+            // Rows mostly arrive in order, so this is usually an append
+            std::vector<quint64>& postings = m_postings[id];
+            auto pos = std::lower_bound(postings.begin(), postings.end(), key);
+            if (pos == postings.end() || *pos != key) {
+                postings.insert(pos, key);
+            }
+            rowTokens.push_back(id);
+        }
+    }
+
+    std::sort(rowTokens.begin(), rowTokens.end());
+    rowTokens.erase(std::unique(rowTokens.begin(), rowTokens.end()), rowTokens.end());
+}
+
+void TextIndex::removeDocument(int row) {
+    if (row < 0 || size_t(row) >= m_rowTokens.size()) return;
+
+    quint64 first = makeKey(row, 0);
+    quint64 last = makeKey(row + 1, 0);
+    for (quint32 id : m_rowTokens[row]) {
+        std::vector<quint64>& postings = m_postings[id];
+        auto lo = std::lower_bound(postings.begin(), postings.end(), first);
+        auto hi = std::lower_bound(lo, postings.end(), last);
+        postings.erase(lo, hi);
+    }
+    m_rowTokens[row].clear();
+}
+
+std::vector<quint64> TextIndex::findTerm(const QString& lowerTerm) const {
+    std::vector<quint64> keys;
+    for (int id = 0; id < m_tokens.size(); ++id) {
+        if (m_tokens[id].contains(lowerTerm)) {
+            const std::vector<quint64>& postings = m_postings[id];
+            keys.insert(keys.end(), postings.begin(), postings.end());
+        }
+    }
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+std::vector<quint64> TextIndex::findAll(const QStringList& lowerTerms) const {
+    if (lowerTerms.isEmpty()) return {};
+
+    // Longest terms first - they match the fewest tokens
+    QStringList terms = lowerTerms;
+    std::sort(terms.begin(), terms.end(), [](const QString& a, const QString& b) {
+        return a.size() > b.size();
+    });
+
+    std::vector<quint64> result = findTerm(terms.first());
+    for (int i = 1; i < terms.size() && !result.empty(); ++i) {
+        std::vector<quint64> keys = findTerm(terms[i]);
+        std::vector<quint64> both;
+        std::set_intersection(result.begin(), result.end(), keys.begin(), keys.end(),
+                              std::back_inserter(both));
+        result.swap(both);
+    }
+    return result;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <vector>
+#include "PhotoMetadata.h"
+
+namespace PhotoGuru {
+
+/**
+ * @brief Inverted index over the searchable text fields of a photo library
+ *
+ * Each field is lowercased and split on spaces into tokens; every distinct
+ * token keeps a sorted posting list of (row, slot) keys. A query term
+ * (no spaces - callers split on them) matches a field when it is a
+ * substring of one of its tokens, which is exactly QString::contains on the
+ * whole field. Terms are resolved against the distinct-token dictionary,
+ * which is orders of magnitude smaller than the library, and multiple terms
+ * intersect posting lists.
+ *
+ * Documents can be added or replaced one at a time, so the index grows as
+ * metadata loads.
+ */
+class TextIndex {
+public:
+    // Field positions in documentFields(); keyword i lives at FirstKeywordSlot + i
+    enum Slot : quint16 {
+        TitleSlot = 0,
+        DescriptionSlot,
+        CategorySlot,
+        SceneSlot,
+        MoodSlot,
+        LocationSlot,
+        CameraSlot,
+        FilenameSlot,
+        FirstKeywordSlot
+    };
+
+    // Searchable text of a photo, indexed by Slot
+    static QStringList documentFields(const PhotoMetadata& meta);
+
+    static quint64 makeKey(int row, int slot) { return (quint64(row) << 16) | quint16(slot); }
+    static int rowOf(quint64 key) { return int(key >> 16); }
+    static int slotOf(quint64 key) { return int(key & 0xFFFF); }
+
+    void clear();
+
+    // Insert or replace; fields are indexed by Slot
+    void setDocument(int row, const QStringList& fields);
+    void removeDocument(int row);
+
+    // Sorted keys of fields that contain every term. Terms must already be
+    // lowercase and must not contain spaces.
+    std::vector<quint64> findAll(const QStringList& lowerTerms) const;
+
+    int tokenCount() const { return m_tokens.size(); }
+
+private:
+    std::vector<quint64> findTerm(const QString& lowerTerm) const;
+
+    QHash<QString, quint32> m_tokenIds;
+    QStringList m_tokens;
+    std::vector<std::vector<quint64>> m_postings;  // Per token, sorted keys
+    std::vector<std::vector<quint32>> m_rowTokens; // Per row, token ids (for replace/remove)
+};
+
+} // namespace PhotoGuru
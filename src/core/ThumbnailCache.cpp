@@ -1,83 +1,323 @@
 #include "ThumbnailCache.h"
 #include "ImageLoader.h"
+#include "FileFingerprint.h"
+#include "PerceptualHash.h"
+#include "Trace.h"
 #include <QPainter>
-#include <QtConcurrent>
+#include <QDir>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QDebug>
 
 namespace PhotoGuru {
 
 ThumbnailCache& ThumbnailCache::instance() {
     static ThumbnailCache cache;
-    cache.m_cache.setMaxCost(500);  // Cache 500 thumbnails
     return cache;
 }
 
+ThumbnailCache::ThumbnailCache() {
+    m_cache.setMaxCost(int(DEFAULT_MEMORY_BUDGET / 1024));
+
+    // Leaves cores for the viewer's own decodes while a grid fills
+    m_tasks.setMaxConcurrency(4);
+
+    const QString packPath = defaultDiskLocation();
+    QDir().mkpath(QFileInfo(packPath).absolutePath());
+    if (!m_store.open(packPath)) {
+        qWarning() << "[ThumbnailCache] Disk tier unavailable, using memory only";
+    }
+}
+
+QString ThumbnailCache::defaultDiskLocation() {
+    return QDir::homePath() + "/.photoguru/thumbnails/thumbnails.pack";
+}
+
+bool ThumbnailCache::setDiskLocation(const QString& packPath) {
+    clear();
+    QDir().mkpath(QFileInfo(packPath).absolutePath());
+    if (!m_store.open(packPath)) {
+        qWarning() << "[ThumbnailCache] Disk tier unavailable at" << packPath << ", using memory only";
+        return false;
+    }
+    return true;
+}
+
 QPixmap ThumbnailCache::getThumbnail(const QString& filepath, const QSize& size) {
-    QString key = cacheKey(filepath, size);
-    
-    // Check cache
-    if (QPixmap* cached = m_cache.object(key)) {
+    return QPixmap::fromImage(thumbnailImage(filepath, size));
+}
+
+ThumbnailCache::~ThumbnailCache() = default;
+
+QImage ThumbnailCache::cachedImage(const QString& filepath, const QSize& size) {
+    QMutexLocker locker(&m_mutex);
+    if (QImage* cached = m_cache.object(cacheKey(filepath, size))) {
         return *cached;
     }
-    
-    // Generate thumbnail
-    QPixmap thumbnail = generateThumbnail(filepath, size);
-    
-    // Store in cache
-    m_cache.insert(key, new QPixmap(thumbnail));
-    
+    return QImage();
+}
+
+bool ThumbnailCache::hasThumbnail(const QString& filepath, const QSize& size) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_cache.contains(cacheKey(filepath, size))) return true;
+    }
+    return !m_store.find(ThumbnailStore::makeKey(filepath, size)).isNull();
+}
+
+QImage ThumbnailCache::thumbnailImage(const QString& filepath, const QSize& size) {
+    QString key = cacheKey(filepath, size);
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (!m_requestedSizes.contains(size)) {
+            m_requestedSizes << size;
+            if (m_requestedSizes.size() > MAX_REQUESTED_SIZES) m_requestedSizes.removeFirst();
+        }
+
+        // Another thread is decoding this one - wait for its result
+        while (m_inFlight.contains(key)) {
+            m_decodeFinished.wait(&m_mutex);
+        }
+
+        if (QImage* cached = m_cache.object(key)) {
+            TRACE_COUNT("thumbnail.memory.hit", 1);
+            return *cached;
+        }
+        TRACE_COUNT("thumbnail.memory.miss", 1);
+
+        m_inFlight.insert(key);
+    }
+
+    // Disk tier, then decode (outside the lock)
+    ThumbnailStore::Key diskKey = ThumbnailStore::makeKey(filepath, size);
+    QImage thumbnail = m_store.find(diskKey);
+    if (thumbnail.isNull()) {
+        // Moved or renamed: reuse what was stored under the old path. This
+        // also records the fingerprint, for when it moves again.
+        for (const PhotoDatabase::Fingerprint& seen : FileFingerprint::instance().sameContent(filepath)) {
+            thumbnail = m_store.find(ThumbnailStore::makeKey(seen.path, seen.mtime, seen.size, size));
+            if (!thumbnail.isNull()) {
+                m_store.insert(diskKey, thumbnail);
+                break;
+            }
+        }
+    }
+    bool ok = true;
+    if (thumbnail.isNull()) {
+        TRACE_COUNT("thumbnail.disk.miss", 1);
+        thumbnail = generateThumbnail(filepath, size, &ok);
+        if (ok) {
+            m_store.insert(diskKey, thumbnail);
+        }
+    } else {
+        TRACE_COUNT("thumbnail.disk.hit", 1);
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        // The placeholder isn't kept: a share not mounted yet or a file
+        // still being copied gets decoded again next time it is asked for
+        if (ok) insertMemory(key, thumbnail);
+        m_inFlight.remove(key);
+        m_decodeFinished.wakeAll();
+    }
+
     return thumbnail;
 }
 
+void ThumbnailCache::requestThumbnail(const QString& filepath, const QSize& size, int priority) {
+    enqueue(filepath, size, priority, TaskScheduler::Interactive);
+}
+
+void ThumbnailCache::enqueue(const QString& filepath, const QSize& size, int priority,
+                             TaskScheduler::Priority priorityClass) {
+    QString key = cacheKey(filepath, size);
+
+    QMutexLocker locker(&m_mutex);
+    if (QImage* cached = m_cache.object(key)) {
+        QImage image = *cached;
+        locker.unlock();
+        emit thumbnailReady(filepath, size, image);
+        return;
+    }
+
+    // Already queued - the pending task will emit for everyone. Requeue it
+    // if the caller's priority changed (e.g. it scrolled into view, or a
+    // prefetched thumbnail is now on screen). Prefetch never demotes.
+    auto queued = m_queued.find(key);
+    if (queued != m_queued.end()) {
+        if (priorityClass > queued->priorityClass) return;
+        if ((queued->priority != priority || queued->priorityClass != priorityClass)
+            && m_tasks.tryTake(queued->task)) {
+            queued->priority = priority;
+            queued->priorityClass = priorityClass;
+            m_tasks.start(queued->task, priorityClass, priority);
+        }
+        return;
+    }
+
+    QRunnable* task = QRunnable::create([this, filepath, size, key]() {
+        {
+            // Started - no longer cancellable
+            QMutexLocker locker(&m_mutex);
+            m_queued.remove(key);
+        }
+        QImage image = thumbnailImage(filepath, size);
+        // Emitted from the pool thread; receivers get it queued
+        emit thumbnailReady(filepath, size, image);
+    });
+
+    // Registered under the same lock the task takes on start, so
+    // cancelRequest never sees a task that is already running
+    m_queued.insert(key, QueuedRequest{task, priority, priorityClass});
+    TRACE_GAUGE("thumbnail.queued", m_queued.size());
+    m_tasks.start(task, priorityClass, priority);
+}
+
+bool ThumbnailCache::cancelRequest(const QString& filepath, const QSize& size) {
+    QMutexLocker locker(&m_mutex);
+
+    QRunnable* task = m_queued.take(cacheKey(filepath, size)).task;
+    if (!task) {
+        return false;
+    }
+
+    // tryTake hands ownership back only if the task never started
+    if (m_tasks.tryTake(task)) {
+        delete task;
+        return true;
+    }
+    return false;
+}
+
 void ThumbnailCache::pregenerate(const QStringList& filepaths, const QSize& size) {
     for (const QString& filepath : filepaths) {
-        QString key = cacheKey(filepath, size);
-        
-        // Skip if already cached
-        if (m_cache.contains(key)) continue;
-        
-        // Generate in background
-        QtConcurrent::run([this, filepath, size, key]() {
-            QPixmap thumbnail = generateThumbnail(filepath, size);
-            
-            // Update cache in main thread
-            QMetaObject::invokeMethod(this, [this, key, thumbnail]() {
-                m_cache.insert(key, new QPixmap(thumbnail));
-                emit thumbnailReady(QString(), thumbnail);
-            }, Qt::QueuedConnection);
-        });
+        enqueue(filepath, size, 0, TaskScheduler::Prefetch);
+    }
+}
+
+void ThumbnailCache::offer(const QString& filepath, const QImage& source) {
+    if (source.isNull()) return;
+
+    QList<QSize> sizes;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const QSize& size : m_requestedSizes) {
+            if (!m_cache.contains(cacheKey(filepath, size))) sizes << size;
+        }
     }
+
+    for (const QSize& size : sizes) {
+        if (source.width() < size.width() && source.height() < size.height()) continue;
+        ThumbnailStore::Key diskKey = ThumbnailStore::makeKey(filepath, size);
+        if (m_store.find(diskKey).isNull()) {
+            m_store.insert(diskKey, letterbox(source, size));
+        }
+    }
+}
+
+QImage ThumbnailCache::storedThumbnail(const QString& filepath, qint64 mtime, qint64 fileSize, const QSize& size) {
+    return m_store.find(ThumbnailStore::makeKey(filepath, mtime, fileSize, size));
+}
+
+bool ThumbnailCache::storeThumbnail(const QString& filepath, qint64 mtime, qint64 fileSize, const QSize& size,
+                                    const QImage& thumbnail) {
+    if (thumbnail.isNull()) return false;
+    const ThumbnailStore::Key diskKey = ThumbnailStore::makeKey(filepath, mtime, fileSize, size);
+    if (!m_store.find(diskKey).isNull()) return true;
+    return m_store.insert(diskKey, thumbnail.size() == size ? thumbnail : letterbox(thumbnail, size));
+}
+
+void ThumbnailCache::setMemoryBudget(qint64 bytes) {
+    QMutexLocker locker(&m_mutex);
+    m_cache.setMaxCost(int(qMax<qint64>(bytes / 1024, 1)));
+}
+
+qint64 ThumbnailCache::memoryBudget() const {
+    QMutexLocker locker(&m_mutex);
+    return qint64(m_cache.maxCost()) * 1024;
+}
+
+qint64 ThumbnailCache::memoryUsage() const {
+    QMutexLocker locker(&m_mutex);
+    return qint64(m_cache.totalCost()) * 1024;
 }
 
 void ThumbnailCache::clear() {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queued.clear();
+    }
+    m_tasks.clear();
+    m_tasks.waitForDone();
+
+    QMutexLocker locker(&m_mutex);
     m_cache.clear();
 }
 
-QPixmap ThumbnailCache::generateThumbnail(const QString& filepath, const QSize& size) {
-    // Load image at reduced resolution
-    auto imageOpt = ImageLoader::instance().load(filepath, 
+void ThumbnailCache::invalidate(const QStringList& filepaths) {
+    if (filepaths.isEmpty()) return;
+    QSet<QString> changed(filepaths.cbegin(), filepaths.cend());
+
+    QMutexLocker locker(&m_mutex);
+    const QList<QString> keys = m_cache.keys();
+    for (const QString& key : keys) {
+        // Keys are "<path>_<w>x<h>"
+        if (changed.contains(key.left(key.lastIndexOf('_')))) {
+            m_cache.remove(key);
+        }
+    }
+}
+
+void ThumbnailCache::insertMemory(const QString& key, const QImage& image) {
+    int cost = int(qMax<qint64>(image.sizeInBytes() / 1024, 1));
+    m_cache.insert(key, new QImage(image), cost);
+}
+
+QImage ThumbnailCache::generateThumbnail(const QString& filepath, const QSize& size, bool* ok) {
+    TRACE_SCOPE("thumbnail.generate");
+    // Load image at reduced resolution (2x for retina)
+    auto imageOpt = ImageLoader::instance().load(filepath,
         QSize(size.width() * 2, size.height() * 2));
-    
+
     if (!imageOpt) {
         // Error placeholder
-        QPixmap placeholder(size);
+        if (ok) *ok = false;
+        QImage placeholder(size, QImage::Format_RGB32);
         placeholder.fill(QColor(80, 40, 40));
         return placeholder;
     }
-    
-    QImage image = *imageOpt;
-    
+
+    if (ok) *ok = true;
+    // Duplicate search reads the hash from the catalog instead of decoding again
+    PerceptualHash::instance().record(filepath, *imageOpt);
+    return letterbox(*imageOpt, size);
+}
+
+QImage ThumbnailCache::letterbox(const QImage& source, const QSize& size) {
+    QImage image = source;
+
+    // For very large images, do a fast scale first
+    if (image.width() > size.width() * 3 || image.height() > size.height() * 3) {
+        image = image.scaled(size.width() * 2, size.height() * 2,
+            Qt::KeepAspectRatio, Qt::FastTransformation);
+    }
+
     // Scale to thumbnail size
     QImage scaled = image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    
+
     // Center in square
-    QPixmap result(size);
+    QImage result(size, QImage::Format_RGB32);
     result.fill(QColor(42, 42, 42));
-    
+
     QPainter painter(&result);
     int x = (size.width() - scaled.width()) / 2;
     int y = (size.height() - scaled.height()) / 2;
     painter.drawImage(x, y, scaled);
-    
+    painter.end();
+
     return result;
 }
 
@@ -2,40 +2,118 @@
 
 #include <QString>
 #include <QPixmap>
+#include <QImage>
 #include <QCache>
-#include <QFuture>
+#include <QSet>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
 #include <QObject>
 
+class QRunnable;
+#include "ThumbnailStore.h"
+#include "TaskScheduler.h"
+
 namespace PhotoGuru {
 
+/**
+ * @brief Shared two-tier thumbnail service (memory + disk)
+ *
+ * Used by ThumbnailGrid and TimelineView so each image is decoded at most
+ * once. The memory tier is budgeted in bytes, the disk tier is a packed,
+ * memory-mapped ThumbnailStore in ~/.photoguru/thumbnails. Thread-safe: concurrent requests for the same
+ * thumbnail wait on the first decode instead of starting another.
+ */
 class ThumbnailCache : public QObject {
     Q_OBJECT
-    
+
 public:
     static ThumbnailCache& instance();
-    
-    // Get thumbnail (from cache or generate)
+
+    // Get thumbnail (from cache or generate) - GUI thread only (QPixmap)
     QPixmap getThumbnail(const QString& filepath, const QSize& size);
-    
-    // Pre-generate thumbnails in background
+
+    // Blocking lookup: memory -> disk -> decode. Safe from any thread.
+    QImage thumbnailImage(const QString& filepath, const QSize& size);
+
+    // Memory tier only, never touches disk. Null if not cached.
+    QImage cachedImage(const QString& filepath, const QSize& size);
+
+    // Either tier has it, so a request won't decode the file. Stats the
+    // file: off the GUI thread for files on a share.
+    bool hasThumbnail(const QString& filepath, const QSize& size);
+
+    // Async: emits thumbnailReady when available. Duplicate requests are
+    // dropped, but a queued request is moved if its priority changed.
+    void requestThumbnail(const QString& filepath, const QSize& size, int priority = 0);
+
+    // Drop a request that hasn't started decoding yet (no signal is emitted)
+    bool cancelRequest(const QString& filepath, const QSize& size);
+
+    // Pre-generate thumbnails in background (Prefetch class: behind
+    // every requestThumbnail(), which is Interactive)
     void pregenerate(const QStringList& filepaths, const QSize& size);
+
+    // Seeds the disk tier from a frame another stage already decoded, in
+    // the sizes views have been asking for. Sizes the frame would have to
+    // be upscaled for, and thumbnails that already exist, are skipped.
+    void offer(const QString& filepath, const QImage& source);
+
+    // Disk tier only, for a file version recorded earlier (no stat, no
+    // decode): what CatalogServer hands out and CatalogSync takes in
+    QImage storedThumbnail(const QString& filepath, qint64 mtime, qint64 fileSize, const QSize& size);
+    bool storeThumbnail(const QString& filepath, qint64 mtime, qint64 fileSize, const QSize& size,
+                        const QImage& thumbnail);
+
+    // Disk tier pack file; the default is ~/.photoguru/thumbnails/thumbnails.pack.
+    // Clears the memory tier; no lookup may be running during the switch.
+    bool setDiskLocation(const QString& packPath);
+    static QString defaultDiskLocation();
     
-    // Clear cache
+    // Memory tier budget in bytes
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() const;
+    qint64 memoryUsage() const;  // Bytes the memory tier holds
+
+    // Clear memory tier (cancels queued requests, waits for running ones)
     void clear();
-    
+
+    // Drop memory-tier thumbnails of files that changed on disk (all sizes);
+    // the disk tier notices by itself
+    void invalidate(const QStringList& filepaths);
+
 signals:
-    void thumbnailReady(const QString& filepath, const QPixmap& thumbnail);
-    
+    void thumbnailReady(const QString& filepath, const QSize& size, const QImage& thumbnail);
+
 private:
-    ThumbnailCache() = default;
-    ~ThumbnailCache() = default;
+    ThumbnailCache();
+    ~ThumbnailCache();
     ThumbnailCache(const ThumbnailCache&) = delete;
     ThumbnailCache& operator=(const ThumbnailCache&) = delete;
-    
-    QPixmap generateThumbnail(const QString& filepath, const QSize& size);
+
+    void enqueue(const QString& filepath, const QSize& size, int priority,
+                 TaskScheduler::Priority priorityClass);
+    QImage generateThumbnail(const QString& filepath, const QSize& size, bool* ok = nullptr);
+    static QImage letterbox(const QImage& image, const QSize& size);
     QString cacheKey(const QString& filepath, const QSize& size) const;
-    
-    QCache<QString, QPixmap> m_cache;
+    void insertMemory(const QString& key, const QImage& image);
+
+    QCache<QString, QImage> m_cache;  // Cost in KB
+    QSet<QString> m_inFlight;         // Keys currently being decoded
+    struct QueuedRequest {
+        QRunnable* task = nullptr;
+        int priority = 0;
+        TaskScheduler::Priority priorityClass = TaskScheduler::Interactive;
+    };
+    QHash<QString, QueuedRequest> m_queued;  // Pending async requests, removed when they start
+    QList<QSize> m_requestedSizes;    // Most recent last, for offer()
+    mutable QMutex m_mutex;
+    QWaitCondition m_decodeFinished;
+    ThumbnailStore m_store;           // Disk tier
+    TaskGroup m_tasks{TaskScheduler::Interactive};  // Last: waits for tasks before the rest goes
+
+    static constexpr qint64 DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;  // 256 MB
+    static constexpr int MAX_REQUESTED_SIZES = 4;
 };
 
 } // namespace PhotoGuru
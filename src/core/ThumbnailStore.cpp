@@ -0,0 +1,323 @@
+#include "ThumbnailStore.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace PhotoGuru {
+
+namespace {
+
+constexpr char PACK_MAGIC[8] = {'P', 'G', 'T', 'H', 'U', 'M', 'B', 'S'};
+constexpr quint32 PACK_VERSION = 1;
+constexpr quint32 RECORD_MAGIC = 0x54485042;  // "BPHT"
+constexpr quint32 MAX_DIMENSION = 4096;
+constexpr qint64 ALIGNMENT = 16;
+
+struct FileHeader {
+    char magic[8];
+    quint32 version;
+    quint32 reserved;
+};
+
+// Native endianness - the pack is a local cache, never shared between machines
+struct RecordHeader {
+    quint32 magic;
+    quint32 width;
+    quint32 height;
+    quint32 bytesPerLine;
+    quint64 pathHash;
+    qint64 mtime;
+    qint64 fileSize;
+    quint32 reserved[2];
+};
+
+static_assert(sizeof(FileHeader) % ALIGNMENT == 0, "file header must keep records aligned");
+static_assert(sizeof(RecordHeader) % ALIGNMENT == 0, "record header must keep pixels aligned");
+
+qint64 alignUp(qint64 value) {
+    return (value + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+qint64 recordSize(const RecordHeader& header) {
+    return qint64(sizeof(RecordHeader)) +
+           alignUp(qint64(header.bytesPerLine) * header.height);
+}
+
+} // namespace
+
+// One read-only mapping of the pack, on a handle of its own so that it
+// stays valid whatever the store does next
+struct ThumbnailStore::Mapping {
+    QFile file;      // Unmaps on destruction
+    uchar* data = nullptr;
+    qint64 size = 0;
+};
+
+ThumbnailStore::~ThumbnailStore() {
+    close();
+}
+
+bool ThumbnailStore::open(const QString& packPath) {
+    close();
+
+    QMutexLocker locker(&m_mutex);
+
+    m_file.setFileName(packPath);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "[ThumbnailStore] Cannot open pack:" << packPath << m_file.errorString();
+        return false;
+    }
+
+    m_fileSize = m_file.size();
+    m_capacity = m_fileSize;
+
+    bool valid = m_fileSize >= qint64(sizeof(FileHeader));
+    if (valid) {
+        FileHeader header;
+        valid = m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) == sizeof(header) &&
+                std::memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) == 0 &&
+                header.version == PACK_VERSION;
+    }
+
+    // Unknown format, or grown too large with superseded records: start over
+    if (!valid || m_fileSize > MAX_PACK_BYTES) {
+        if (!writeFileHeader()) {
+            m_file.close();
+            return false;
+        }
+    }
+
+    if (!remap()) {
+        m_file.close();
+        return false;
+    }
+
+    scanRecords();
+
+    qDebug() << "[ThumbnailStore] Opened" << packPath << "-" << m_index.size()
+             << "thumbnails," << m_fileSize / 1024 << "KB";
+    return true;
+}
+
+void ThumbnailStore::close() {
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    // Images still on the mapping keep it; nothing is unmapped under them
+    m_map.reset();
+    if (m_capacity > m_fileSize) {
+        m_file.resize(m_fileSize);
+    }
+    m_fileSize = 0;
+    m_capacity = 0;
+    m_index.clear();
+    m_file.close();
+}
+
+bool ThumbnailStore::isOpen() const {
+    QMutexLocker locker(&m_mutex);
+    return m_file.isOpen();
+}
+
+ThumbnailStore::Key ThumbnailStore::makeKey(const QString& filepath, const QSize& size) {
+    QFileInfo fi(filepath);
+    return makeKey(fi.absoluteFilePath(), fi.lastModified().toMSecsSinceEpoch(), fi.size(), size);
+}
+
+ThumbnailStore::Key ThumbnailStore::makeKey(const QString& filepath, qint64 mtime, qint64 fileSize,
+                                            const QSize& size) {
+    QString absolutePath = QFileInfo(filepath).absoluteFilePath();
+
+    Key key;
+    QByteArray digest = QCryptographicHash::hash(absolutePath.toUtf8(), QCryptographicHash::Sha1);
+    std::memcpy(&key.pathHash, digest.constData(), sizeof(key.pathHash));
+    key.mtime = mtime;
+    key.fileSize = fileSize;
+    key.width = quint32(qMax(0, size.width()));
+    key.height = quint32(qMax(0, size.height()));
+    return key;
+}
+
+QImage ThumbnailStore::find(const Key& key) {
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_index.constFind(key);
+    if (it == m_index.constEnd()) {
+        return QImage();
+    }
+
+    qint64 offset = it.value();
+
+    // Appended past the last mapping - map the grown file
+    if (offset + qint64(sizeof(RecordHeader)) > m_map->size && !remap()) {
+        return QImage();
+    }
+
+    RecordHeader header;
+    std::memcpy(&header, m_map->data + offset, sizeof(header));
+    if (offset + recordSize(header) > m_map->size && !remap()) {
+        return QImage();
+    }
+
+    // Read-only wrapper: any write detaches into a private copy. The
+    // image holds the mapping until it (and its copies) are gone
+    const uchar* pixels = m_map->data + offset + sizeof(RecordHeader);
+    return QImage(pixels, int(header.width), int(header.height),
+                  qsizetype(header.bytesPerLine), QImage::Format_RGB32,
+                  [](void* mapping) { delete static_cast<std::shared_ptr<Mapping>*>(mapping); },
+                  new std::shared_ptr<Mapping>(m_map));
+}
+
+bool ThumbnailStore::insert(const Key& key, const QImage& image) {
+    if (image.isNull() || image.width() > int(MAX_DIMENSION) || image.height() > int(MAX_DIMENSION)) {
+        return false;
+    }
+
+    QImage pixels = image.format() == QImage::Format_RGB32
+        ? image : image.convertToFormat(QImage::Format_RGB32);
+
+    RecordHeader header = {};
+    header.magic = RECORD_MAGIC;
+    header.width = quint32(pixels.width());
+    header.height = quint32(pixels.height());
+    header.bytesPerLine = quint32(pixels.width()) * 4;
+    header.pathHash = key.pathHash;
+    header.mtime = key.mtime;
+    header.fileSize = key.fileSize;
+    // Lookup key includes the requested size, which can differ from the
+    // stored image (e.g. placeholders); keep it in the reserved slots
+    header.reserved[0] = key.width;
+    header.reserved[1] = key.height;
+
+    QByteArray record(int(recordSize(header)), '\0');
+    std::memcpy(record.data(), &header, sizeof(header));
+    char* dst = record.data() + sizeof(header);
+    for (int y = 0; y < pixels.height(); ++y) {
+        std::memcpy(dst + qint64(y) * header.bytesPerLine, pixels.constScanLine(y),
+                    header.bytesPerLine);
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    if (m_index.contains(key)) {
+        return true;  // Another thread stored it first
+    }
+
+    qint64 offset = m_fileSize;
+    qint64 end = offset + record.size();
+    if (end > m_capacity) {
+        // Reserve ahead (zeroes, which open() trims like a torn tail after a crash)
+        qint64 capacity = std::max(end, m_capacity + std::min(m_capacity, MAX_RESERVE_BYTES));
+        if (!m_file.resize(capacity)) {
+            qWarning() << "[ThumbnailStore] Cannot grow pack:" << m_file.errorString();
+            return false;
+        }
+        m_capacity = capacity;
+    }
+    if (!m_file.seek(offset) || m_file.write(record) != record.size() || !m_file.flush()) {
+        qWarning() << "[ThumbnailStore] Write failed:" << m_file.errorString();
+        // Drop a partial tail so the next record starts aligned
+        if (m_file.resize(offset)) {
+            m_capacity = offset;
+        }
+        return false;
+    }
+
+    m_fileSize = offset + record.size();
+    m_index.insert(key, offset);
+    return true;
+}
+
+int ThumbnailStore::count() const {
+    QMutexLocker locker(&m_mutex);
+    return m_index.size();
+}
+
+qint64 ThumbnailStore::packSize() const {
+    QMutexLocker locker(&m_mutex);
+    return m_fileSize;
+}
+
+bool ThumbnailStore::writeFileHeader() {
+    FileHeader header = {};
+    std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = PACK_VERSION;
+
+    if (!m_file.resize(0) || !m_file.seek(0) ||
+        m_file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header) ||
+        !m_file.flush()) {
+        qWarning() << "[ThumbnailStore] Cannot initialize pack:" << m_file.errorString();
+        return false;
+    }
+
+    m_fileSize = sizeof(header);
+    m_capacity = m_fileSize;
+    return true;
+}
+
+bool ThumbnailStore::remap() {
+    auto map = std::make_shared<Mapping>();
+    map->file.setFileName(m_file.fileName());
+    if (map->file.open(QIODevice::ReadOnly)) {
+        map->data = map->file.map(0, m_capacity);
+    }
+    if (!map->data) {
+        qWarning() << "[ThumbnailStore] mmap failed:" << map->file.errorString();
+        return false;
+    }
+    map->size = m_capacity;
+
+    // The older mapping goes with the last image that points into it
+    m_map = std::move(map);
+    return true;
+}
+
+void ThumbnailStore::scanRecords() {
+    qint64 offset = sizeof(FileHeader);
+
+    while (offset + qint64(sizeof(RecordHeader)) <= m_fileSize) {
+        RecordHeader header;
+        std::memcpy(&header, m_map->data + offset, sizeof(header));
+
+        if (header.magic != RECORD_MAGIC ||
+            header.width == 0 || header.width > MAX_DIMENSION ||
+            header.height == 0 || header.height > MAX_DIMENSION ||
+            header.bytesPerLine != header.width * 4 ||
+            offset + recordSize(header) > m_fileSize) {
+            break;
+        }
+
+        Key key;
+        key.pathHash = header.pathHash;
+        key.mtime = header.mtime;
+        key.fileSize = header.fileSize;
+        key.width = header.reserved[0];
+        key.height = header.reserved[1];
+        m_index.insert(key, offset);
+
+        offset += recordSize(header);
+    }
+
+    // Torn or garbage tail (or a reserve not trimmed) - cut it so appends
+    // start on a record boundary. Nothing indexed lives past offset, so the
+    // mapping is never read there until appends have written it again.
+    if (offset < m_fileSize) {
+        qWarning() << "[ThumbnailStore] Truncating" << (m_fileSize - offset)
+                   << "bytes of incomplete records";
+        if (m_file.resize(offset)) {
+            m_fileSize = offset;
+            m_capacity = offset;
+        }
+    }
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QString>
+#include <QImage>
+#include <QSize>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QtGlobal>
+#include <memory>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Append-only pack of pre-decoded thumbnails, memory-mapped
+ *
+ * Replaces one-JPEG-per-thumbnail on disk. Records are raw RGB32 pixel
+ * blocks keyed by a hash of the full path + source mtime + source size +
+ * thumbnail size, so a hit costs a hash lookup and no decode. The index is
+ * rebuilt by walking record headers on open(); a torn record at the tail
+ * (crash mid-write) is truncated away.
+ *
+ * Images returned by find() point straight into the mapping and hold a
+ * reference to it: a mapping is unmapped when the store and the last image
+ * on it let go, so images outlive close() and open(). The file is grown
+ * ahead of the appends, doubling, so find() maps again once per doubling
+ * rather than after every insert; close() trims the reserve. Superseded
+ * records are not reclaimed; the pack is reset on open() once it grows
+ * past MAX_PACK_BYTES.
+ */
+class ThumbnailStore {
+public:
+    struct Key {
+        quint64 pathHash = 0;
+        qint64 mtime = 0;      // ms since epoch
+        qint64 fileSize = 0;
+        quint32 width = 0;
+        quint32 height = 0;
+
+        bool operator==(const Key& other) const {
+            return pathHash == other.pathHash && mtime == other.mtime &&
+                   fileSize == other.fileSize && width == other.width &&
+                   height == other.height;
+        }
+    };
+
+    ThumbnailStore() = default;
+    ~ThumbnailStore();
+
+    bool open(const QString& packPath);
+    void close();
+    bool isOpen() const;
+
+    // Stats the source file; key changes whenever the file does
+    static Key makeKey(const QString& filepath, const QSize& size);
+    // For a file version recorded earlier (no stat)
+    static Key makeKey(const QString& filepath, qint64 mtime, qint64 fileSize, const QSize& size);
+
+    // Null if absent. Returned image references the mapping (no copy).
+    QImage find(const Key& key);
+    bool insert(const Key& key, const QImage& image);
+
+    int count() const;
+    qint64 packSize() const;
+
+    static constexpr qint64 MAX_PACK_BYTES = qint64(4) * 1024 * 1024 * 1024;  // 4 GB
+    static constexpr qint64 MAX_RESERVE_BYTES = qint64(256) * 1024 * 1024;  // Growth step cap
+
+private:
+    ThumbnailStore(const ThumbnailStore&) = delete;
+    ThumbnailStore& operator=(const ThumbnailStore&) = delete;
+
+    bool writeFileHeader();
+    bool remap();
+    void scanRecords();
+
+    struct Mapping;
+
+    QFile m_file;
+    QHash<Key, qint64> m_index;   // Key -> record offset
+    std::shared_ptr<Mapping> m_map;  // Latest; older ones live while images use them
+    qint64 m_fileSize = 0;        // End of the records
+    qint64 m_capacity = 0;        // Size on disk: the records, then zeroes reserved for appends
+    mutable QMutex m_mutex;
+};
+
+inline size_t qHash(const ThumbnailStore::Key& key, size_t seed = 0) {
+    return qHashMulti(seed, key.pathHash, key.mtime, key.fileSize, key.width, key.height);
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,151 @@
+#include "TilePyramid.h"
+#include <QRunnable>
+#include <QDebug>
+#include <climits>
+
+namespace PhotoGuru {
+
+TilePyramid::TilePyramid(QObject* parent)
+    : QObject(parent)
+{
+    setTileCacheBytes(DEFAULT_TILE_CACHE_BYTES);
+    m_tasks.setMaxConcurrency(1);  // Each level is halved from the one before
+}
+
+void TilePyramid::setImage(const QImage& image) {
+    ++m_generation;
+    m_levelSizes.clear();
+    m_levels.clear();
+    m_tiles.clear();
+    m_builtDepth = 0;
+    m_wantedDepth = 0;
+    m_building = false;
+    m_buildTarget = 0;
+
+    if (image.isNull()) return;
+
+    QSize size = image.size();
+    m_levelSizes.push_back(size);
+    while (size.width() > TILE_SIZE || size.height() > TILE_SIZE) {
+        size = QSize(qMax(1, (size.width() + 1) / 2), qMax(1, (size.height() + 1) / 2));
+        m_levelSizes.push_back(size);
+    }
+    m_levels.resize(m_levelSizes.size());
+    m_levels[0] = image;
+}
+
+QSize TilePyramid::levelSize(int level) const {
+    if (level < 0 || level >= levelCount()) return QSize();
+    return m_levelSizes[level];
+}
+
+int TilePyramid::levelForZoom(double zoom) const {
+    if (isNull()) return 0;
+    const double fullWidth = m_levelSizes.front().width();
+    int level = 0;
+    while (level + 1 < levelCount() && m_levelSizes[level + 1].width() / fullWidth >= zoom) {
+        ++level;
+    }
+    return level;
+}
+
+bool TilePyramid::isLevelReady(int level) const {
+    return level >= 0 && level < levelCount() && !m_levels[level].isNull();
+}
+
+int TilePyramid::nearestReadyLevel(int level) const {
+    // Levels are built in order, so [0, m_builtDepth] are all ready
+    return qBound(0, level, m_builtDepth);
+}
+
+void TilePyramid::requestLevel(int level) {
+    if (level <= m_builtDepth || level >= levelCount()) return;
+    m_wantedDepth = qMax(m_wantedDepth, level);
+    if (!m_building) startBuild();
+}
+
+void TilePyramid::startBuild() {
+    m_building = true;
+    m_buildTarget = m_wantedDepth;
+    const quint64 generation = m_generation;
+    const QImage source = m_levels[m_builtDepth];
+    std::vector<QSize> sizes(m_levelSizes.begin() + m_builtDepth + 1,
+                             m_levelSizes.begin() + m_wantedDepth + 1);
+    const int firstLevel = m_builtDepth + 1;
+
+    m_tasks.start(QRunnable::create([this, generation, source, sizes, firstLevel]() {
+        QImage previous = source;
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            QImage next = previous.scaled(sizes[i], Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            const int level = firstLevel + int(i);
+            QMetaObject::invokeMethod(this, [this, generation, level, next]() {
+                onLevelBuilt(generation, level, next);
+            }, Qt::QueuedConnection);
+            previous = next;
+        }
+    }));
+}
+
+void TilePyramid::onLevelBuilt(quint64 generation, int level, const QImage& image) {
+    if (generation != m_generation) return;  // Image replaced meanwhile
+
+    if (image.isNull()) {
+        qWarning() << "[TilePyramid] Failed to build level" << level;
+        m_building = false;
+        return;
+    }
+
+    m_levels[level] = image;
+    m_builtDepth = level;
+    emit levelReady(level);
+
+    // Asked for coarser levels while this build ran: carry on from here
+    if (level == m_buildTarget) {
+        m_building = false;
+        if (m_wantedDepth > m_builtDepth) startBuild();
+    }
+}
+
+int TilePyramid::columns(int level) const {
+    return (levelSize(level).width() + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+int TilePyramid::rows(int level) const {
+    return (levelSize(level).height() + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+QRect TilePyramid::tileRect(int level, int column, int row) const {
+    return QRect(column * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE)
+        .intersected(QRect(QPoint(0, 0), levelSize(level)));
+}
+
+quint64 TilePyramid::tileKey(int level, int column, int row) {
+    return (quint64(level) << 48) | (quint64(quint32(row)) << 24) | quint64(quint32(column));
+}
+
+QImage TilePyramid::tile(int level, int column, int row) {
+    if (!isLevelReady(level)) return QImage();
+
+    const quint64 key = tileKey(level, column, row);
+    if (QImage* cached = m_tiles.object(key)) {
+        return *cached;
+    }
+
+    QRect rect = tileRect(level, column, row);
+    if (rect.isEmpty()) return QImage();
+
+    // The raster paint engine blits these two formats without converting
+    const QImage& source = m_levels[level];
+    QImage tile = source.copy(rect).convertToFormat(
+        source.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+
+    int cost = int(qBound<qint64>(1, tile.sizeInBytes() / 1024, INT_MAX));
+    m_tiles.insert(key, new QImage(tile), cost);
+    return tile;
+}
+
+void TilePyramid::setTileCacheBytes(qint64 bytes) {
+    m_tiles.setMaxCost(int(qBound<qint64>(1, bytes / 1024, INT_MAX)));
+}
+
+} // namespace PhotoGuru
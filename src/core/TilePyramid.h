@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QRect>
+#include <QCache>
+#include <vector>
+#include "TaskScheduler.h"
+
+namespace PhotoGuru {
+
+/**
+ * @brief Power-of-two downscales of one image, cut into tiles for painting
+ *
+ * Level 0 is the image itself; each further level halves both sides until
+ * the whole image fits one tile. A viewer paints only the tiles it can see
+ * from levelForZoom(), so no paint scales by more than 2x and none touches
+ * pixels that are off screen.
+ *
+ * Levels are built on demand: requestLevel() halves, in the background,
+ * from the coarsest level built so far down to the one asked for, and
+ * levelReady() follows for each. Tiles are cut from a built level when
+ * first painted and kept in a byte-bounded LRU.
+ *
+ * Builds run on a TaskScheduler worker at Interactive priority, one at
+ * a time since each level is halved from the one before. GUI thread
+ * only; levelReady() is emitted on the owner's thread.
+ */
+class TilePyramid : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TilePyramid(QObject* parent = nullptr);
+
+    // Drops every level and tile of the previous image
+    void setImage(const QImage& image);
+    void clear() { setImage(QImage()); }
+    bool isNull() const { return m_levels.empty(); }
+    QSize imageSize() const { return m_levelSizes.empty() ? QSize() : m_levelSizes.front(); }
+
+    int levelCount() const { return int(m_levelSizes.size()); }
+    QSize levelSize(int level) const;
+
+    // Coarsest level with at least `zoom` of the image's resolution
+    int levelForZoom(double zoom) const;
+
+    bool isLevelReady(int level) const;
+    // `level` if built, else the coarsest built so far (always finer)
+    int nearestReadyLevel(int level) const;
+    void requestLevel(int level);
+
+    // Tiles of a level; the last column and row may be narrower
+    int columns(int level) const;
+    int rows(int level) const;
+    QRect tileRect(int level, int column, int row) const;  // In level pixels
+    QImage tile(int level, int column, int row);            // Null unless ready
+
+    void setTileCacheBytes(qint64 bytes);
+    qint64 tileCacheUsage() const { return qint64(m_tiles.totalCost()) * 1024; }
+    int cachedTiles() const { return m_tiles.count(); }
+
+    static constexpr int TILE_SIZE = 256;
+    static constexpr qint64 DEFAULT_TILE_CACHE_BYTES = qint64(128) * 1024 * 1024;
+
+signals:
+    void levelReady(int level);
+
+private:
+    void startBuild();
+    void onLevelBuilt(quint64 generation, int level, const QImage& image);
+    static quint64 tileKey(int level, int column, int row);
+
+    std::vector<QSize> m_levelSizes;  // Every level, built or not
+    std::vector<QImage> m_levels;     // Null until built; [0] is the image
+    quint64 m_generation = 0;         // Bumped by setImage(); stale builds are dropped
+    int m_builtDepth = 0;             // Levels [0, m_builtDepth] are built
+    int m_wantedDepth = 0;
+    int m_buildTarget = 0;            // Deepest level the running build ends at
+    bool m_building = false;
+
+    // Cost is KB so large budgets fit QCache's int
+    QCache<quint64, QImage> m_tiles;
+    TaskGroup m_tasks{TaskScheduler::Interactive};  // Last: waits for the build before the rest goes
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,327 @@
+#include "TimelineIndex.h"
+#include <QSet>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace PhotoGuru {
+
+namespace {
+
+constexpr qint64 NO_DAY_MIN = std::numeric_limits<qint64>::min();
+constexpr qint64 NO_DAY_MAX = std::numeric_limits<qint64>::max();
+
+// Keys in [lo, hi] of an ordered map, newest (largest) first
+template <typename Map, typename Fn>
+void forEachDescending(const Map& map, typename Map::key_type lo, typename Map::key_type hi, Fn&& fn) {
+    if (lo > hi) return;
+    auto begin = map.lower_bound(lo);
+    auto it = map.upper_bound(hi);
+    while (it != begin) {
+        --it;
+        fn(it->first, it->second);
+    }
+}
+
+} // namespace
+
+void TimelineIndex::upsert(const PhotoMetadata& meta) {
+    Entry entry;
+    entry.dated = meta.datetime_original.isValid();
+    if (entry.dated) {
+        entry.day = meta.datetime_original.date().toJulianDay();
+        entry.time = meta.datetime_original.toMSecsSinceEpoch();
+    }
+    entry.event = meta.group_id;
+
+    auto it = m_entries.constFind(meta.filepath);
+    if (it != m_entries.constEnd()) {
+        const Entry old = it.value();
+        // Ratings, captions and the like don't move a photo
+        if (old.dated == entry.dated && old.day == entry.day &&
+            old.time == entry.time && old.event == entry.event) {
+            return;
+        }
+        entry.visible = old.visible;
+        drop(meta.filepath, old);
+    }
+
+    add(meta.filepath, entry);
+    ++m_revision;
+}
+
+void TimelineIndex::remove(const QString& filepath) {
+    auto it = m_entries.constFind(filepath);
+    if (it == m_entries.constEnd()) return;
+    drop(filepath, it.value());
+    ++m_revision;
+}
+
+void TimelineIndex::clear() {
+    m_entries.clear();
+    m_days.clear();
+    m_months.clear();
+    m_years.clear();
+    m_undated = 0;
+    ++m_revision;
+}
+
+void TimelineIndex::setVisible(const QStringList& filepaths) {
+    const QSet<QString> passing(filepaths.cbegin(), filepaths.cend());
+    bool changed = false;
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        const bool visible = passing.contains(it.key());
+        if (visible == it->visible) continue;
+        it->visible = visible;
+        if (it->dated) adjustVisible(it.value(), visible ? 1 : -1);
+        changed = true;
+    }
+    if (changed) ++m_revision;
+}
+
+void TimelineIndex::clearFilter() {
+    bool changed = false;
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->visible) continue;
+        it->visible = true;
+        if (it->dated) adjustVisible(it.value(), 1);
+        changed = true;
+    }
+    if (changed) ++m_revision;
+}
+
+void TimelineIndex::add(const QString& filepath, const Entry& entry) {
+    m_entries.insert(filepath, entry);
+    if (!entry.dated) {
+        ++m_undated;
+        return;
+    }
+
+    const QDate date = QDate::fromJulianDay(entry.day);
+    Day& day = m_days[entry.day];
+    ++day.counts.count;
+    day.events[entry.event].photos.insert({entry.time, filepath});
+    ++m_months[monthKey(date)].count;
+    ++m_years[date.year()].count;
+
+    if (entry.visible) adjustVisible(entry, 1);
+}
+
+void TimelineIndex::drop(const QString& filepath, const Entry& entry) {
+    if (!entry.dated) {
+        --m_undated;
+        m_entries.remove(filepath);
+        return;
+    }
+    if (entry.visible) adjustVisible(entry, -1);
+
+    const QDate date = QDate::fromJulianDay(entry.day);
+    auto day = m_days.find(entry.day);
+    auto event = day->second.events.find(entry.event);
+    event->second.photos.erase({entry.time, filepath});
+    if (event->second.photos.empty()) day->second.events.erase(event);
+    if (--day->second.counts.count == 0) m_days.erase(day);
+
+    auto month = m_months.find(monthKey(date));
+    if (--month->second.count == 0) m_months.erase(month);
+    auto year = m_years.find(date.year());
+    if (--year->second.count == 0) m_years.erase(year);
+
+    m_entries.remove(filepath);
+}
+
+void TimelineIndex::adjustVisible(const Entry& entry, int delta) {
+    const QDate date = QDate::fromJulianDay(entry.day);
+    Day& day = m_days[entry.day];
+    day.counts.visible += delta;
+    day.events[entry.event].visible += delta;
+    m_months[monthKey(date)].visible += delta;
+    m_years[date.year()].visible += delta;
+}
+
+bool TimelineIndex::eventRange(const Event& event, qint64* start, qint64* end) const {
+    if (event.visible == 0) return false;
+    for (auto it = event.photos.cbegin(); it != event.photos.cend(); ++it) {
+        if (m_entries.value(it->second).visible) {
+            *start = it->first;
+            break;
+        }
+    }
+    for (auto it = event.photos.crbegin(); it != event.photos.crend(); ++it) {
+        if (m_entries.value(it->second).visible) {
+            *end = it->first;
+            break;
+        }
+    }
+    return true;
+}
+
+bool TimelineIndex::dayRange(qint64 firstDay, qint64 lastDay, qint64* start, qint64* end) const {
+    // Events within a day overlap, so each end takes the extreme over its day's events
+    auto dayBounds = [this](const Day& day, qint64* lo, qint64* hi) {
+        *lo = NO_DAY_MAX;
+        *hi = NO_DAY_MIN;
+        for (const auto& [id, event] : day.events) {
+            qint64 s = 0;
+            qint64 e = 0;
+            if (!eventRange(event, &s, &e)) continue;
+            *lo = std::min(*lo, s);
+            *hi = std::max(*hi, e);
+        }
+    };
+
+    if (firstDay > lastDay) return false;
+    bool found = false;
+    for (auto it = m_days.lower_bound(firstDay); it != m_days.end() && it->first <= lastDay; ++it) {
+        if (it->second.counts.visible == 0) continue;
+        qint64 unused = 0;
+        dayBounds(it->second, start, &unused);
+        found = true;
+        break;
+    }
+    if (!found) return false;
+
+    const auto begin = m_days.lower_bound(firstDay);
+    for (auto it = m_days.upper_bound(lastDay); it != begin;) {
+        --it;
+        if (it->second.counts.visible == 0) continue;
+        qint64 unused = 0;
+        dayBounds(it->second, &unused, end);
+        break;
+    }
+    return true;
+}
+
+TimelineIndex::Bucket TimelineIndex::makeBucket(Level level, const QDate& date, const Counts& counts,
+                                                qint64 firstDay, qint64 lastDay) const {
+    Bucket bucket;
+    bucket.level = level;
+    bucket.date = date;
+    bucket.count = counts.count;
+    bucket.visible = counts.visible;
+
+    qint64 start = 0;
+    qint64 end = 0;
+    if (dayRange(firstDay, lastDay, &start, &end)) {
+        bucket.start = QDateTime::fromMSecsSinceEpoch(start);
+        bucket.end = QDateTime::fromMSecsSinceEpoch(end);
+    }
+    return bucket;
+}
+
+void TimelineIndex::collectDays(qint64 firstDay, qint64 lastDay, QVector<Bucket>& out) const {
+    forEachDescending(m_days, firstDay, lastDay, [&](qint64 key, const Day& day) {
+        if (day.counts.visible == 0) return;
+        out << makeBucket(Level::Day, QDate::fromJulianDay(key), day.counts, key, key);
+    });
+}
+
+void TimelineIndex::collectEvents(qint64 firstDay, qint64 lastDay, QVector<Bucket>& out) const {
+    forEachDescending(m_days, firstDay, lastDay, [&](qint64 key, const Day& day) {
+        if (day.counts.visible == 0) return;
+
+        // Newest first within the day too
+        QVector<Bucket> events;
+        for (const auto& [id, event] : day.events) {
+            Bucket bucket;
+            bucket.level = Level::Event;
+            bucket.date = QDate::fromJulianDay(key);
+            bucket.event = id;
+            bucket.count = int(event.photos.size());
+            bucket.visible = event.visible;
+            qint64 start = 0;
+            qint64 end = 0;
+            if (!eventRange(event, &start, &end)) continue;
+            bucket.start = QDateTime::fromMSecsSinceEpoch(start);
+            bucket.end = QDateTime::fromMSecsSinceEpoch(end);
+            events << bucket;
+        }
+        std::sort(events.begin(), events.end(), [](const Bucket& a, const Bucket& b) {
+            if (a.start != b.start) return a.start > b.start;
+            return a.event < b.event;
+        });
+        out << events;
+    });
+}
+
+QVector<TimelineIndex::Bucket> TimelineIndex::buckets(Level level, const QDate& from, const QDate& to) const {
+    QVector<Bucket> out;
+    const qint64 firstDay = from.isValid() ? from.toJulianDay() : NO_DAY_MIN;
+    const qint64 lastDay = to.isValid() ? to.toJulianDay() : NO_DAY_MAX;
+
+    switch (level) {
+        case Level::Year: {
+            const int lo = from.isValid() ? from.year() : std::numeric_limits<int>::min();
+            const int hi = to.isValid() ? to.year() : std::numeric_limits<int>::max();
+            forEachDescending(m_years, lo, hi, [&](int year, const Counts& counts) {
+                if (counts.visible == 0) return;
+                QDate first(year, 1, 1);
+                out << makeBucket(Level::Year, first, counts,
+                                  first.toJulianDay(), QDate(year, 12, 31).toJulianDay());
+            });
+            break;
+        }
+        case Level::Month: {
+            const int lo = from.isValid() ? monthKey(from) : std::numeric_limits<int>::min();
+            const int hi = to.isValid() ? monthKey(to) : std::numeric_limits<int>::max();
+            forEachDescending(m_months, lo, hi, [&](int key, const Counts& counts) {
+                if (counts.visible == 0) return;
+                QDate first(key / 12, key % 12 + 1, 1);
+                out << makeBucket(Level::Month, first, counts,
+                                  first.toJulianDay(), first.addMonths(1).toJulianDay() - 1);
+            });
+            break;
+        }
+        case Level::Day:
+            collectDays(firstDay, lastDay, out);
+            break;
+        case Level::Event:
+            collectEvents(firstDay, lastDay, out);
+            break;
+    }
+    return out;
+}
+
+QVector<TimelineIndex::Bucket> TimelineIndex::children(const Bucket& bucket) const {
+    switch (bucket.level) {
+        case Level::Year:
+            return buckets(Level::Month, bucket.date, QDate(bucket.date.year(), 12, 31));
+        case Level::Month:
+            return buckets(Level::Day, bucket.date, bucket.date.addMonths(1).addDays(-1));
+        case Level::Day:
+            return buckets(Level::Event, bucket.date, bucket.date);
+        case Level::Event:
+            break;
+    }
+    return {};
+}
+
+QStringList TimelineIndex::photos(const Bucket& bucket) const {
+    QStringList result;
+    if (!bucket.date.isValid()) return result;
+
+    QDate last = bucket.date;
+    switch (bucket.level) {
+        case Level::Year: last = QDate(bucket.date.year(), 12, 31); break;
+        case Level::Month: last = bucket.date.addMonths(1).addDays(-1); break;
+        case Level::Day:
+        case Level::Event: break;
+    }
+
+    std::vector<std::pair<qint64, QString>> dayPhotos;
+    for (auto it = m_days.lower_bound(bucket.date.toJulianDay());
+         it != m_days.end() && it->first <= last.toJulianDay(); ++it) {
+        dayPhotos.clear();
+        for (const auto& [id, event] : it->second.events) {
+            if (bucket.level == Level::Event && id != bucket.event) continue;
+            dayPhotos.insert(dayPhotos.end(), event.photos.cbegin(), event.photos.cend());
+        }
+        std::sort(dayPhotos.begin(), dayPhotos.end());
+        for (const auto& [time, path] : dayPhotos) {
+            if (m_entries.value(path).visible) result << path;
+        }
+    }
+    return result;
+}
+
+} // namespace PhotoGuru
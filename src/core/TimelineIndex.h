@@ -0,0 +1,117 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QHash>
+#include <QVector>
+#include <map>
+#include <set>
+#include <utility>
+#include "PhotoMetadata.h"
+
+namespace PhotoGuru {
+
+/**
+ * @brief Capture-time buckets (year, month, day, event) kept up to date per photo
+ *
+ * Every dated photo sits in one event: its group_id within its capture
+ * day, with ungrouped photos forming one event per day. Days, months and
+ * years keep their counts as photos are upserted, removed or re-filtered,
+ * so a change touches four counters instead of regrouping the library.
+ *
+ * buckets() answers a date range from the ordered maps, so rendering or
+ * scrubbing a timeline costs the buckets returned, not the photos behind
+ * them. Time ranges are computed from a bucket's first and last visible
+ * photo when asked for.
+ *
+ * Photos without a capture date are counted, not bucketed. Not
+ * thread-safe; owned by one view.
+ */
+class TimelineIndex {
+public:
+    enum class Level { Year, Month, Day, Event };
+
+    struct Bucket {
+        Level level = Level::Day;
+        QDate date;           // First day covered (January 1st for a year, the 1st for a month)
+        QString event;        // Event level: the photos' group_id, empty when ungrouped
+        int count = 0;        // Photos in the bucket
+        int visible = 0;      // Of those, ones the filter passes
+        QDateTime start;      // Capture times of the first and last visible photo
+        QDateTime end;
+    };
+
+    // Insert, or move meta.filepath to its new bucket
+    void upsert(const PhotoMetadata& meta);
+    void remove(const QString& filepath);
+    void clear();
+
+    // Only `filepaths` pass the filter from now on; photos upserted later
+    // are visible until the next call. Only photos whose visibility changed
+    // touch the counters.
+    void setVisible(const QStringList& filepaths);
+    void clearFilter();
+
+    int size() const { return int(m_entries.size()); }
+    int undatedCount() const { return m_undated; }
+    quint64 revision() const { return m_revision; }
+
+    // Buckets at `level` with visible photos that overlap [from, to] (an
+    // invalid date leaves that end open), newest first
+    QVector<Bucket> buckets(Level level, const QDate& from = QDate(), const QDate& to = QDate()) const;
+
+    // Buckets one level down with visible photos, newest first
+    QVector<Bucket> children(const Bucket& bucket) const;
+
+    // Visible photos of a bucket, oldest first
+    QStringList photos(const Bucket& bucket) const;
+
+private:
+    struct Entry {
+        qint64 day = 0;       // Julian day
+        qint64 time = 0;      // ms since epoch
+        QString event;
+        bool dated = false;
+        bool visible = true;
+    };
+
+    struct Counts {
+        int count = 0;
+        int visible = 0;
+    };
+
+    struct Event {
+        std::set<std::pair<qint64, QString>> photos;  // By capture time
+        int visible = 0;
+    };
+
+    struct Day {
+        Counts counts;
+        std::map<QString, Event> events;
+    };
+
+    static int monthKey(const QDate& date) { return date.year() * 12 + date.month() - 1; }
+
+    void add(const QString& filepath, const Entry& entry);
+    void drop(const QString& filepath, const Entry& entry);
+    void adjustVisible(const Entry& entry, int delta);
+
+    // Time range of the visible photos of days [firstDay, lastDay]
+    bool dayRange(qint64 firstDay, qint64 lastDay, qint64* start, qint64* end) const;
+    bool eventRange(const Event& event, qint64* start, qint64* end) const;
+
+    Bucket makeBucket(Level level, const QDate& date, const Counts& counts,
+                      qint64 firstDay, qint64 lastDay) const;
+    void collectDays(qint64 firstDay, qint64 lastDay, QVector<Bucket>& out) const;
+    void collectEvents(qint64 firstDay, qint64 lastDay, QVector<Bucket>& out) const;
+
+    QHash<QString, Entry> m_entries;
+    std::map<qint64, Day> m_days;
+    std::map<int, Counts> m_months;   // year * 12 + month - 1
+    std::map<int, Counts> m_years;
+    int m_undated = 0;
+    quint64 m_revision = 0;
+};
+
+} // namespace PhotoGuru
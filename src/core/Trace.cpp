@@ -0,0 +1,358 @@
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace PhotoGuru {
+
+std::atomic<bool> Trace::s_enabled{false};
+
+namespace {
+
+struct Event {
+    TraceMetric* metric = nullptr;
+    qint64 start = 0;
+    qint64 value = 0;  // Timer: duration; gauge: the new value
+};
+
+// Written by its thread, read by chromeTrace(); the mutex is uncontended
+// except while a trace is being exported
+struct ThreadBuffer {
+    QMutex mutex;
+    std::vector<Event> events;
+    quint64 written = 0;
+    int tid = 0;
+    QString name;
+};
+
+struct Registry {
+    QMutex mutex;
+    std::deque<TraceMetric> metrics;  // Stable addresses
+    QHash<QByteArray, TraceMetric*> byName;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;  // Outlive their threads
+    std::vector<std::pair<const char*, QThreadPool*>> pools;
+    int nextTid = 1;
+    qint64 epoch = Trace::now();
+    QString outputPath;  // PHOTOGURU_TRACE
+};
+
+// Never destroyed: thread-local buffers and late spans may outlive statics
+Registry& registry() {
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+ThreadBuffer& localBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        auto created = std::make_shared<ThreadBuffer>();
+        created->events.resize(Trace::RING_CAPACITY);
+        QThread* thread = QThread::currentThread();
+        created->name = thread ? thread->objectName() : QString();
+
+        Registry& r = registry();
+        QMutexLocker locker(&r.mutex);
+        created->tid = r.nextTid++;
+        if (created->name.isEmpty()) {
+            created->name = (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+                ? QString("Main") : QString("Thread %1").arg(created->tid);
+        }
+        r.buffers.push_back(created);
+        buffer = std::move(created);
+    }
+    return *buffer;
+}
+
+void push(TraceMetric& metric, qint64 start, qint64 value) {
+    ThreadBuffer& buffer = localBuffer();
+    QMutexLocker locker(&buffer.mutex);
+    buffer.events[buffer.written % Trace::RING_CAPACITY] = {&metric, start, value};
+    ++buffer.written;
+}
+
+void updateMax(std::atomic<qint64>& max, qint64 value) {
+    qint64 seen = max.load(std::memory_order_relaxed);
+    while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+#ifdef PHOTOGURU_TRACING
+void writeAtExit() {
+    const QString path = registry().outputPath;
+    if (path.isEmpty()) return;
+    if (Trace::writeChromeTrace(path)) {
+        qInfo() << "[Trace] Wrote" << path;
+    }
+}
+#endif
+
+} // namespace
+
+void TraceMetric::record(qint64 nanoseconds) {
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_value.fetch_add(nanoseconds, std::memory_order_relaxed);
+    updateMax(m_max, nanoseconds);
+    m_buckets[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void TraceMetric::set(qint64 value) {
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_value.store(value, std::memory_order_relaxed);
+    updateMax(m_max, value);
+}
+
+int TraceMetric::bucketOf(qint64 nanoseconds) {
+    if (nanoseconds < 4) return int(qMax<qint64>(nanoseconds, 0));
+    // Four linear buckets between consecutive powers of two
+    const int msb = 63 - int(qCountLeadingZeroBits(quint64(nanoseconds)));
+    const int sub = int((nanoseconds >> (msb - 2)) & 3);
+    return qMin((msb - 1) * 4 + sub, BUCKETS - 1);
+}
+
+double TraceMetric::bucketMidpoint(int bucket) {
+    if (bucket < 4) return bucket;
+    const int msb = bucket / 4 + 1;
+    const double width = double(quint64(1) << (msb - 2));
+    return (4 + bucket % 4) * width + width / 2;
+}
+
+double TraceMetric::percentileMs(double p) const {
+    qint64 total = 0;
+    for (const auto& bucket : m_buckets) total += bucket.load(std::memory_order_relaxed);
+    if (total == 0) return 0.0;
+
+    const qint64 rank = qMax<qint64>(1, qint64(std::ceil(p / 100.0 * total)));
+    qint64 seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) return bucketMidpoint(i) / 1e6;
+    }
+    return bucketMidpoint(BUCKETS - 1) / 1e6;
+}
+
+QJsonObject TraceMetric::toJson() const {
+    switch (m_kind) {
+    case Timer: {
+        const qint64 n = count();
+        return QJsonObject{
+            {"kind", "timer"},
+            {"count", double(n)},
+            {"total_ms", value() / 1e6},
+            {"mean_ms", n > 0 ? value() / 1e6 / n : 0.0},
+            {"p50_ms", percentileMs(50)},
+            {"p99_ms", percentileMs(99)},
+            {"max_ms", m_max.load(std::memory_order_relaxed) / 1e6}
+        };
+    }
+    case Counter:
+        return QJsonObject{{"kind", "counter"}, {"value", double(value())}};
+    case Gauge:
+        return QJsonObject{
+            {"kind", "gauge"},
+            {"value", double(value())},
+            {"max", double(m_max.load(std::memory_order_relaxed))}
+        };
+    }
+    return QJsonObject();
+}
+
+void TraceMetric::reset() {
+    m_count.store(0, std::memory_order_relaxed);
+    m_value.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+    for (auto& bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+}
+
+void Trace::setEnabled(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+TraceMetric& Trace::metric(const char* name, TraceMetric::Kind kind) {
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    const QByteArray key(name);
+    if (TraceMetric* existing = r.byName.value(key)) {
+        if (existing->kind() != kind) {
+            qWarning() << "[Trace] Metric" << name << "used with two kinds";
+        }
+        return *existing;
+    }
+    r.metrics.emplace_back(name, kind);
+    r.byName.insert(key, &r.metrics.back());
+    return r.metrics.back();
+}
+
+void Trace::span(TraceMetric& metric, qint64 start, qint64 duration) {
+    metric.record(duration);
+    push(metric, start, duration);
+}
+
+void Trace::gauge(TraceMetric& metric, qint64 value) {
+    metric.set(value);
+    push(metric, now(), value);
+}
+
+void Trace::watchThreadPool(const char* name, QThreadPool* pool) {
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    for (const auto& watched : r.pools) {
+        if (watched.second == pool) return;
+    }
+    r.pools.emplace_back(name, pool);
+}
+
+void Trace::unwatchThreadPool(QThreadPool* pool) {
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    r.pools.erase(std::remove_if(r.pools.begin(), r.pools.end(),
+                                 [pool](const auto& watched) { return watched.second == pool; }),
+                  r.pools.end());
+}
+
+QJsonObject Trace::metrics() {
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+
+    QJsonObject result;
+    // Read under the mutex, so an owner can't destroy a pool mid-read
+    QHash<QString, QPair<int, int>> pools;
+    for (const auto& watched : r.pools) {
+        QPair<int, int>& usage = pools[QString("pool.%1").arg(watched.first)];
+        usage.first += watched.second->activeThreadCount();
+        usage.second += watched.second->maxThreadCount();
+    }
+    for (auto it = pools.constBegin(); it != pools.constEnd(); ++it) {
+        result.insert(it.key(), QJsonObject{
+            {"kind", "pool"}, {"active", it.value().first}, {"max", it.value().second}
+        });
+    }
+
+    for (const TraceMetric& metric : r.metrics) {
+        result.insert(metric.name(), metric.toJson());
+
+        const QByteArray name(metric.name());
+        if (metric.kind() != TraceMetric::Counter || !name.endsWith(".hit")) continue;
+        const QByteArray prefix = name.left(name.size() - 4);
+        if (TraceMetric* miss = r.byName.value(prefix + ".miss")) {
+            const double total = double(metric.value() + miss->value());
+            result.insert(QString::fromUtf8(prefix + ".hit_ratio"), total > 0 ? metric.value() / total : 0.0);
+        }
+    }
+    return result;
+}
+
+QByteArray Trace::chromeTrace() {
+    Registry& r = registry();
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    qint64 epoch = 0;
+    {
+        QMutexLocker locker(&r.mutex);
+        buffers = r.buffers;
+        epoch = r.epoch;
+    }
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QByteArray out;
+    out.reserve(1 << 20);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&]() {
+        if (!first) out += ",\n";
+        first = false;
+    };
+
+    for (const auto& buffer : buffers) {
+        std::vector<Event> events;
+        QString threadName;
+        int tid = 0;
+        {
+            QMutexLocker locker(&buffer->mutex);
+            const quint64 kept = qMin<quint64>(buffer->written, RING_CAPACITY);
+            events.reserve(kept);
+            for (quint64 i = buffer->written - kept; i < buffer->written; i++) {
+                events.push_back(buffer->events[i % RING_CAPACITY]);
+            }
+            threadName = buffer->name;
+            tid = buffer->tid;
+        }
+        if (events.empty()) continue;
+
+        separator();
+        out += QJsonDocument(QJsonObject{
+            {"name", "thread_name"}, {"ph", "M"}, {"pid", double(pid)}, {"tid", tid},
+            {"args", QJsonObject{{"name", threadName}}}
+        }).toJson(QJsonDocument::Compact);
+
+        for (const Event& event : events) {
+            const QByteArray name(event.metric->name());
+            const double ts = (event.start - epoch) / 1000.0;  // Microseconds
+            separator();
+            if (event.metric->kind() == TraceMetric::Timer) {
+                const int dot = name.indexOf('.');
+                out += "{\"name\":\"" + name + "\",\"cat\":\"" + (dot > 0 ? name.left(dot) : name) +
+                       "\",\"ph\":\"X\",\"ts\":" + QByteArray::number(ts, 'f', 3) +
+                       ",\"dur\":" + QByteArray::number(event.value / 1000.0, 'f', 3) +
+                       ",\"pid\":" + QByteArray::number(pid) + ",\"tid\":" + QByteArray::number(tid) + "}";
+            } else {
+                out += "{\"name\":\"" + name + "\",\"ph\":\"C\",\"ts\":" + QByteArray::number(ts, 'f', 3) +
+                       ",\"pid\":" + QByteArray::number(pid) +
+                       ",\"args\":{\"value\":" + QByteArray::number(event.value) + "}}";
+            }
+        }
+    }
+
+    out += "],\n\"metrics\":" + QJsonDocument(metrics()).toJson(QJsonDocument::Compact) + "}\n";
+    return out;
+}
+
+bool Trace::writeChromeTrace(const QString& path) {
+    QFile file(path);
+    const QByteArray json = chromeTrace();
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+        qWarning() << "[Trace] Cannot write" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void Trace::clear() {
+    Registry& r = registry();
+    QMutexLocker locker(&r.mutex);
+    for (const auto& buffer : r.buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        buffer->written = 0;
+    }
+    for (TraceMetric& metric : r.metrics) metric.reset();
+    r.epoch = now();
+}
+
+void Trace::configureFromEnvironment() {
+    const QString path = qEnvironmentVariable("PHOTOGURU_TRACE");
+    if (path.isEmpty()) return;
+#ifdef PHOTOGURU_TRACING
+    {
+        Registry& r = registry();
+        QMutexLocker locker(&r.mutex);
+        r.outputPath = path;
+    }
+    setEnabled(true);
+    // Runs while QCoreApplication is destroyed, after the event loop
+    qAddPostRoutine(writeAtExit);
+#else
+    qWarning() << "[Trace] PHOTOGURU_TRACE is set but tracing was compiled out (ENABLE_TRACING=OFF)";
+#endif
+}
+
+} // namespace PhotoGuru
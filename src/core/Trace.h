@@ -0,0 +1,168 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <chrono>
+
+class QThreadPool;
+
+namespace PhotoGuru {
+
+/**
+ * @brief One named hot-path measurement: a timer, counter or gauge
+ *
+ * Created once per name by Trace::metric() and never freed, so call sites
+ * keep a reference in a function-local static (the TRACE_* macros do).
+ * Updates are relaxed atomics.
+ *
+ * Timers keep a log-linear histogram (four buckets per power of two, so
+ * percentiles are within 12.5%). Counters only add up. Gauges (queue
+ * depths) keep the last value and the high-water mark.
+ */
+class TraceMetric {
+public:
+    enum Kind { Timer, Counter, Gauge };
+
+    TraceMetric(const char* name, Kind kind) : m_name(name), m_kind(kind) {}
+
+    const char* name() const { return m_name; }
+    Kind kind() const { return m_kind; }
+
+    void record(qint64 nanoseconds);
+    void add(qint64 delta) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+    void set(qint64 value);
+
+    qint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+    double percentileMs(double p) const;
+
+    QJsonObject toJson() const;
+    void reset();
+
+    static constexpr int BUCKETS = 256;
+
+private:
+    static int bucketOf(qint64 nanoseconds);
+    static double bucketMidpoint(int bucket);
+
+    const char* m_name;
+    Kind m_kind;
+    std::atomic<qint64> m_count{0};
+    std::atomic<qint64> m_value{0};  // Timer: total ns; counter: sum; gauge: last
+    std::atomic<qint64> m_max{0};
+    std::atomic<qint64> m_buckets[BUCKETS] = {};
+};
+
+/**
+ * @brief Low-overhead tracing of hot paths, off unless asked for
+ *
+ * Instrumented code uses TRACE_SCOPE("stage.name") for durations,
+ * TRACE_COUNT for events such as cache hits and TRACE_GAUGE for queue
+ * depths. Disabled, a scope costs one relaxed load; built without
+ * PHOTOGURU_TRACING (cmake -DENABLE_TRACING=OFF) the macros are empty.
+ *
+ * Enabled, each span also lands in a ring buffer owned by its thread
+ * (RING_CAPACITY events, oldest overwritten), so recording never
+ * contends with other threads. chromeTrace() merges the buffers into
+ * Chrome trace event JSON, which chrome://tracing and ui.perfetto.dev
+ * open, with metrics() summarised alongside.
+ *
+ * PHOTOGURU_TRACE=<file> enables tracing from startup and writes the
+ * trace there when the application exits (configureFromEnvironment()).
+ */
+class Trace {
+public:
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+
+    // The metric called `name` (a string literal), created on first use
+    static TraceMetric& metric(const char* name, TraceMetric::Kind kind);
+
+    // Nanoseconds on a monotonic clock
+    static qint64 now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void span(TraceMetric& metric, qint64 start, qint64 duration);
+    static void gauge(TraceMetric& metric, qint64 value);
+
+    // Reports `pool` as "pool.<name>" (pools sharing a name add up) until
+    // unwatched; owners unwatch before the pool is destroyed. Works with
+    // tracing off too: it costs nothing until metrics() reads the pool.
+    static void watchThreadPool(const char* name, QThreadPool* pool);
+    static void unwatchThreadPool(QThreadPool* pool);
+
+    // {name: summary} of every metric, plus "<prefix>.hit_ratio" for each
+    // "<prefix>.hit"/"<prefix>.miss" counter pair and "pool.<name>"
+    // {active, max} for watched thread pools
+    static QJsonObject metrics();
+
+    // Buffered spans and gauge changes as Chrome trace event JSON
+    static QByteArray chromeTrace();
+    static bool writeChromeTrace(const QString& path);
+
+    // Drops buffered events and zeroes every metric
+    static void clear();
+
+    // Once from main(): honours PHOTOGURU_TRACE
+    static void configureFromEnvironment();
+
+    static constexpr int RING_CAPACITY = 1 << 14;  // Events kept per thread
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+// Times the enclosing scope into a TraceMetric::Timer
+class TraceScope {
+public:
+    explicit TraceScope(TraceMetric& metric)
+        : m_metric(Trace::enabled() ? &metric : nullptr)
+        , m_start(m_metric ? Trace::now() : 0)
+    {
+    }
+    ~TraceScope() {
+        if (m_metric) Trace::span(*m_metric, m_start, Trace::now() - m_start);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceMetric* m_metric;
+    qint64 m_start;
+};
+
+} // namespace PhotoGuru
+
+#ifdef PHOTOGURU_TRACING
+#define PHOTOGURU_TRACE_CONCAT_(a, b) a##b
+#define PHOTOGURU_TRACE_CONCAT(a, b) PHOTOGURU_TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) \
+    static PhotoGuru::TraceMetric& PHOTOGURU_TRACE_CONCAT(traceMetric_, __LINE__) = \
+        PhotoGuru::Trace::metric(name, PhotoGuru::TraceMetric::Timer); \
+    PhotoGuru::TraceScope PHOTOGURU_TRACE_CONCAT(traceScope_, __LINE__)(PHOTOGURU_TRACE_CONCAT(traceMetric_, __LINE__))
+#define TRACE_COUNT(name, delta) \
+    do { \
+        if (PhotoGuru::Trace::enabled()) { \
+            static PhotoGuru::TraceMetric& traceMetric = \
+                PhotoGuru::Trace::metric(name, PhotoGuru::TraceMetric::Counter); \
+            traceMetric.add(delta); \
+        } \
+    } while (0)
+#define TRACE_GAUGE(name, value) \
+    do { \
+        if (PhotoGuru::Trace::enabled()) { \
+            static PhotoGuru::TraceMetric& traceMetric = \
+                PhotoGuru::Trace::metric(name, PhotoGuru::TraceMetric::Gauge); \
+            PhotoGuru::Trace::gauge(traceMetric, value); \
+        } \
+    } while (0)
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_COUNT(name, delta) do {} while (0)
+#define TRACE_GAUGE(name, value) do {} while (0)
+#endif
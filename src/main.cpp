@@ -1,5 +1,6 @@
 #include "ui/MainWindow.h"
 #include "ui/DarkTheme.h"
+#include "core/Trace.h"
 #include <QApplication>
 #include <QDebug>
 #include <QFileInfo>
@@ -16,6 +17,9 @@ int main(int argc, char *argv[]) {
     app.setApplicationName("PhotoGuru Viewer");
     app.setApplicationVersion("1.0.0");
     
+    // PHOTOGURU_TRACE=<file>: record hot-path timings, written on exit
+    Trace::configureFromEnvironment();
+    
     // Apply dark theme
     DarkTheme::apply(app);
     
@@ -0,0 +1,428 @@
+#include "AnalysisPipeline.h"
+#include "CLIPAnalyzer.h"
+#include "FaceIndexer.h"
+#include "LlamaVLM.h"
+#include "core/MetadataWriter.h"
+#include "core/EmbeddingStore.h"
+#include "core/PhotoDatabase.h"
+#include "core/ResourceGovernor.h"
+#include "core/ThumbnailCache.h"
+#include "core/Trace.h"
+#include <QFileInfo>
+#include <QThread>
+#include <algorithm>
+
+namespace PhotoGuru {
+
+AnalysisPipeline::Stages AnalysisPipeline::defaultStages(CLIPAnalyzer* clip, LlamaVLM* vlm,
+                                                         EmbeddingStore* store, FaceAnalyzer* faces) {
+    return stagesFor(std::make_shared<LocalInference>(clip, vlm), store, faces);
+}
+
+AnalysisPipeline::Stages AnalysisPipeline::defaultStages(InferenceBackend* backend, EmbeddingStore* store,
+                                                         FaceAnalyzer* faces) {
+    // Not owned: the caller keeps it alive for the run
+    return stagesFor(std::shared_ptr<InferenceBackend>(backend, [](InferenceBackend*) {}), store, faces);
+}
+
+AnalysisPipeline::Stages AnalysisPipeline::stagesFor(std::shared_ptr<InferenceBackend> backend,
+                                                     EmbeddingStore* store, FaceAnalyzer* faces) {
+    Stages stages;
+    const InferenceBackend::Info info = backend->info();
+    const bool captions = !info.vlmId.isEmpty();
+    const int clipSize = info.clipInputSize;
+    stages.frameEdge = std::max({clipSize, int(QualityAnalyzer::ANALYSIS_SIZE),
+                                 captions ? int(LlamaVLM::MAX_IMAGE_EDGE) : 0,
+                                 faces ? int(FaceAnalyzer::ANALYSIS_EDGE) : 0});
+
+    stages.decode = [clipSize](const DecodeContext& frame) {
+        return frame.squared(clipSize);
+    };
+
+    stages.embed = [backend](const std::vector<QImage>& images) {
+        return backend->embed(images);
+    };
+
+    if (store && store->isOpen()) {
+        stages.cached = [store](const QString& path) { return store->findOrAdopt(path); };
+        stages.store = [store](const QString& path, const std::vector<float>& embedding) {
+            store->insert(path, embedding);
+        };
+    }
+
+    stages.score = [](const DecodeContext& frame) -> std::optional<Scores> {
+        QImage image = frame.fitted(QualityAnalyzer::ANALYSIS_SIZE);
+        if (image.isNull()) return std::nullopt;
+        return QualityAnalyzer::measure(image);
+    };
+
+    // The grid would otherwise decode every file again for its thumbnail
+    stages.thumbnail = [](const DecodeContext& frame) {
+        ThumbnailCache::instance().offer(frame.path(), frame.image());
+    };
+
+    // FaceIndexer would otherwise decode every file again; files it already scanned are left alone
+    if (faces) {
+        stages.faces = [faces](const std::vector<DecodeContext>& frames) {
+            QStringList paths;
+            for (const DecodeContext& frame : frames) paths << frame.path();
+            const QHash<QString, int> scanned = PhotoDatabase::instance().freshFaceCounts(paths);
+
+            std::vector<const DecodeContext*> pending;
+            std::vector<QImage> images;
+            for (const DecodeContext& frame : frames) {
+                if (scanned.contains(frame.path()) || !frame.isDecoded()) continue;
+                pending.push_back(&frame);
+                images.push_back(frame.fitted(FaceAnalyzer::ANALYSIS_EDGE));
+            }
+            if (images.empty()) return;
+
+            std::vector<std::vector<FaceAnalyzer::Face>> found = faces->analyze(images);
+            for (size_t i = 0; i < pending.size() && i < found.size(); ++i) {
+                FaceIndexer::storeFaces(pending[i]->path(), found[i]);
+            }
+        };
+    }
+
+    if (captions) {
+        // Captions become titles: stop at the first line break and bound each image
+        LlamaVLM::GenerationOptions titleOptions;
+        titleOptions.maxTokens = TITLE_MAX_TOKENS;
+        titleOptions.stopSequences = {"\n"};
+
+        stages.caption = [backend, titleOptions](const DecodeContext& frame) -> std::optional<QString> {
+            std::vector<std::optional<QString>> captions =
+                backend->caption({frame.rgb888(LlamaVLM::MAX_IMAGE_EDGE)}, titleOptions);
+            return captions.empty() ? std::nullopt : captions.front();
+        };
+        stages.captionBatch = [backend, titleOptions](const std::vector<DecodeContext>& frames) {
+            std::vector<QImage> images;
+            for (const DecodeContext& frame : frames) images.push_back(frame.rgb888(LlamaVLM::MAX_IMAGE_EDGE));
+            return backend->caption(images, titleOptions);
+        };
+    }
+
+    stages.write = [](const QString& path, const QString& caption, const std::optional<Scores>& scores) {
+        PhotoMetadata metadata;
+        metadata.llm_title = caption;
+        MetadataWriter::Transaction transaction(path);
+        transaction.setMetadata(metadata);
+
+        // The technical JSON is written whole: start from what the file has
+        std::optional<PhotoMetadata> known;
+        if (scores) {
+            PhotoDatabase& catalog = PhotoDatabase::instance();
+            QHash<QString, PhotoMetadata> fresh = catalog.loadFreshMetadata({path});
+            known = fresh.contains(path) ? std::optional<PhotoMetadata>(fresh.value(path))
+                                         : MetadataReader::instance().read(path, MetadataReader::FilterSet);
+            if (known) {
+                scores->applyTo(known->technical);
+                transaction.setTechnical(known->technical);
+            }
+        }
+
+        // The write changes the file's mtime, not its faces
+        const bool facesScanned = !PhotoDatabase::instance().freshFaceCounts({path}).isEmpty();
+        if (!MetadataWriter::instance().commit(transaction)) return false;
+        if (facesScanned) PhotoDatabase::instance().keepFaceScan(path);
+        if (known) {
+            if (!caption.isEmpty()) known->llm_title = caption;
+            PhotoDatabase::instance().storeMetadataBatch({*known});  // After the write: keyed on the new mtime
+        }
+        return true;
+    };
+
+    return stages;
+}
+
+QString AnalysisPipeline::modelStamp(const CLIPAnalyzer* clip, const LlamaVLM* vlm) {
+    return modelStamp(LocalInference::describe(clip, vlm));
+}
+
+QString AnalysisPipeline::modelStamp(const InferenceBackend::Info& info) {
+    QStringList parts;
+    if (!info.clipVersion.isEmpty()) parts << "clip:" + info.clipVersion;
+    if (!info.vlmId.isEmpty()) parts << "vlm:" + info.vlmId;
+    return parts.join(' ');
+}
+
+AnalysisPipeline::AnalysisPipeline(Stages stages, QObject* parent)
+    : QObject(parent)
+    , m_stages(std::move(stages))
+    , m_decoded(2 * CLIPAnalyzer::MAX_BATCH_SIZE)
+    , m_embedded(STAGE_QUEUE_CAPACITY)
+    , m_captioned(STAGE_QUEUE_CAPACITY)
+{
+    m_decodeThreads = std::max(2, QThread::idealThreadCount() / 2);
+    Trace::watchThreadPool("analysis", &m_pool);
+}
+
+AnalysisPipeline::~AnalysisPipeline() {
+    Trace::unwatchThreadPool(&m_pool);
+    cancel();
+    wait();
+}
+
+void AnalysisPipeline::setBatchSize(int batchSize) {
+    m_batchSize = std::clamp(batchSize, 1, CLIPAnalyzer::MAX_BATCH_SIZE);
+}
+
+void AnalysisPipeline::setDecodeThreads(int threads) {
+    m_decodeThreads = std::max(1, threads);
+}
+
+void AnalysisPipeline::setCaptionBatchSize(int batchSize) {
+    m_captionBatchSize = std::clamp(batchSize, 1, STAGE_QUEUE_CAPACITY);
+}
+
+void AnalysisPipeline::start(const QStringList& filePaths) {
+    if (isRunning()) return;
+    wait();  // Previous run may still be unwinding after cancel
+
+    m_files = filePaths;
+    m_nextFile.storeRelaxed(0);
+    m_done.storeRelaxed(0);
+    m_succeeded.storeRelaxed(0);
+    m_failed.storeRelaxed(0);
+    m_cancelled.storeRelaxed(0);
+    m_decoded.reset();
+    m_embedded.reset();
+    m_captioned.reset();
+
+    if (m_files.isEmpty()) {
+        emit finished(0, 0, false);
+        return;
+    }
+
+    // Fewer decoders on battery or when hot; the rest of the budget is
+    // applied per batch
+    const int decoders = ResourceGovernor::instance().scaledThreadCount(m_decodeThreads);
+    m_running.storeRelease(1);
+    m_activeDecoders.storeRelaxed(decoders);
+
+    // One thread per stage plus the decoders
+    m_pool.setMaxThreadCount(decoders + 3);
+    for (int i = 0; i < decoders; ++i) {
+        m_pool.start([this]() { runDecoder(); });
+    }
+    m_pool.start([this]() { runEmbedder(); });
+    m_pool.start([this]() { runCaptioner(); });
+    m_pool.start([this]() { runWriter(); });
+}
+
+void AnalysisPipeline::cancel() {
+    m_cancelled.storeRelaxed(1);
+    m_decoded.abort();
+    m_embedded.abort();
+    m_captioned.abort();
+}
+
+void AnalysisPipeline::wait() {
+    m_pool.waitForDone();
+}
+
+void AnalysisPipeline::fileDone(const QString& path, bool ok, const QString& message) {
+    (ok ? m_succeeded : m_failed).fetchAndAddRelaxed(1);
+    int done = m_done.fetchAndAddRelaxed(1) + 1;
+
+    emit log(message);
+    emit progress(done, m_files.size(), QFileInfo(path).fileName());
+}
+
+void AnalysisPipeline::runDecoder() {
+    const ResourceGovernor& governor = ResourceGovernor::instance();
+    while (!m_cancelled.loadRelaxed()) {
+        // Held while the user pans the viewer; the stages behind drain
+        governor.waitWhileAIPaused(m_cancelled);
+        if (m_cancelled.loadRelaxed()) break;
+        int index = m_nextFile.fetchAndAddRelaxed(1);
+        if (index >= m_files.size()) break;
+
+        const QString& path = m_files[index];
+        DecodeContext frame(path, m_stages.frameEdge);
+
+        // Only face detection and the captioner view the frame after this thread
+        const bool captioned = m_stages.caption || m_stages.captionBatch;
+        const bool keepFrame = captioned || m_stages.faces;
+
+        // Unchanged since it was last embedded - straight to the captioner,
+        // which decodes it only if the VLM needs the pixels
+        if (m_stages.cached) {
+            if (auto embedding = m_stages.cached(path)) {
+                Analyzed item{path, captioned ? frame : DecodeContext(), std::move(*embedding), QString(), std::nullopt};
+                if (!m_embedded.push(std::move(item))) break;
+                continue;
+            }
+        }
+
+        QImage image;
+        {
+            TRACE_SCOPE("analysis.decode");
+            image = m_stages.decode(frame);
+        }
+        if (image.isNull()) {
+            fileDone(path, false, QString("⚠️ Failed to load: %1").arg(QFileInfo(path).fileName()));
+            continue;
+        }
+        std::optional<Scores> scores = viewFrame(frame);
+        if (!m_decoded.push(Decoded{path, keepFrame ? frame : DecodeContext(), std::move(image), scores})) break;
+    }
+
+    // Last decoder out ends the stream for CLIP. The embedder closes
+    // m_embedded only after this, so cache hits pushed above are never lost.
+    if (m_activeDecoders.fetchAndAddOrdered(-1) == 1) {
+        m_decoded.close();
+    }
+}
+
+std::optional<AnalysisPipeline::Scores> AnalysisPipeline::viewFrame(const DecodeContext& frame) {
+    std::optional<Scores> scores = m_stages.score ? m_stages.score(frame) : std::nullopt;
+    if (m_stages.thumbnail) m_stages.thumbnail(frame);
+    return scores;
+}
+
+void AnalysisPipeline::runEmbedder() {
+    std::vector<Decoded> items;
+    std::vector<QImage> images;
+
+    auto flush = [&]() {
+        if (images.empty() || m_cancelled.loadRelaxed()) return;
+
+        std::vector<std::optional<std::vector<float>>> embeddings;
+        {
+            TRACE_SCOPE("analysis.embed_batch");
+            embeddings = m_stages.embed(images);
+        }
+        if (m_stages.faces) {
+            std::vector<DecodeContext> frames;
+            frames.reserve(items.size());
+            for (const Decoded& item : items) frames.push_back(item.frame);
+            {
+                TRACE_SCOPE("analysis.faces_batch");
+                m_stages.faces(frames);
+            }
+            // Without a captioner, the last viewer
+            if (!(m_stages.caption || m_stages.captionBatch)) {
+                for (Decoded& item : items) item.frame = DecodeContext();
+            }
+        }
+        for (size_t i = 0; i < items.size(); ++i) {
+            const QString& path = items[i].path;
+            bool ok = i < embeddings.size() && embeddings[i] && !embeddings[i]->empty();
+            if (!ok) {
+                fileDone(path, false, QString("❌ CLIP failed: %1").arg(QFileInfo(path).fileName()));
+                continue;
+            }
+            if (m_stages.store) {
+                m_stages.store(path, *embeddings[i]);
+            }
+            if (m_stages.checkpoint) {
+                m_stages.checkpoint(path, Embedded, QString());
+            }
+            m_embedded.push(Analyzed{path, std::move(items[i].frame), std::move(*embeddings[i]),
+                                     QString(), items[i].scores});
+        }
+        items.clear();
+        images.clear();
+    };
+
+    const ResourceGovernor& governor = ResourceGovernor::instance();
+    while (auto item = m_decoded.pop()) {
+        TRACE_GAUGE("analysis.decoded.queued", m_decoded.size());
+        images.push_back(std::move(item->clipImage));
+        items.push_back(std::move(*item));
+        if (int(images.size()) >= governor.scaledBatchSize(m_batchSize)) {
+            flush();
+        }
+    }
+    flush();
+    m_embedded.close();
+}
+
+void AnalysisPipeline::runCaptioner() {
+    while (auto first = m_embedded.pop()) {
+        TRACE_GAUGE("analysis.embedded.queued", m_embedded.size());
+        // Take whatever else is already queued, without waiting for a full batch
+        std::vector<Analyzed> items;
+        items.push_back(std::move(*first));
+        const int batchSize = m_stages.captionBatch ? m_captionBatchSize : 1;
+        while (int(items.size()) < batchSize) {
+            auto next = m_embedded.tryPop();
+            if (!next) break;
+            items.push_back(std::move(*next));
+        }
+
+        // Cache hits arrive undecoded
+        std::vector<bool> wasDecoded;
+        for (const Analyzed& item : items) wasDecoded.push_back(item.frame.isDecoded());
+
+        // Captioned by an interrupted run: only the write is left
+        std::vector<size_t> uncaptioned;
+        for (size_t i = 0; i < items.size(); ++i) {
+            std::optional<QString> cached = m_stages.cachedCaption ? m_stages.cachedCaption(items[i].path)
+                                                                   : std::nullopt;
+            if (cached) items[i].caption = *cached;
+            else uncaptioned.push_back(i);
+        }
+
+        if (!m_cancelled.loadRelaxed() && !uncaptioned.empty()) {
+            TRACE_SCOPE("analysis.caption");
+            if (m_stages.captionBatch && uncaptioned.size() > 1) {
+                std::vector<DecodeContext> frames;
+                for (size_t i : uncaptioned) frames.push_back(items[i].frame);
+                auto captions = m_stages.captionBatch(frames);
+                for (size_t k = 0; k < uncaptioned.size() && k < captions.size(); ++k) {
+                    if (captions[k]) items[uncaptioned[k]].caption = *captions[k];
+                }
+            } else if (m_stages.caption) {
+                for (size_t i : uncaptioned) {
+                    if (auto caption = m_stages.caption(items[i].frame)) {
+                        items[i].caption = *caption;
+                    }
+                }
+            }
+            if (m_stages.checkpoint) {
+                for (size_t i : uncaptioned) {
+                    if (!items[i].caption.isEmpty()) m_stages.checkpoint(items[i].path, Captioned, items[i].caption);
+                }
+            }
+        }
+        for (size_t i = 0; i < items.size(); ++i) {
+            Analyzed& item = items[i];
+            // Decoded just now for the VLM: the other views come free
+            if (!wasDecoded[i] && item.frame.isDecoded()) {
+                item.scores = viewFrame(item.frame);
+            }
+            item.frame = DecodeContext();  // Last viewer; frees the pixels
+            m_captioned.push(std::move(item));
+        }
+    }
+    m_captioned.close();
+}
+
+void AnalysisPipeline::runWriter() {
+    while (auto item = m_captioned.pop()) {
+        TRACE_GAUGE("analysis.captioned.queued", m_captioned.size());
+        TRACE_SCOPE("analysis.write");
+        QString filename = QFileInfo(item->path).fileName();
+        bool ok = true;
+        if (item->caption.isEmpty() && !item->scores) {
+            fileDone(item->path, true, QString("✅ %1 (CLIP only)").arg(filename));
+        } else if (m_stages.write && m_stages.write(item->path, item->caption, item->scores)) {
+            fileDone(item->path, true, QString("✅ %1").arg(filename));
+        } else {
+            fileDone(item->path, false, QString("⚠️ Write failed: %1").arg(filename));
+            ok = false;
+        }
+        if (ok && m_stages.checkpoint) {
+            m_stages.checkpoint(item->path, Written, QString());
+        }
+    }
+
+    // Writer is the last stage to drain, so it reports the run
+    bool cancelled = m_cancelled.loadRelaxed() != 0;
+    m_running.storeRelease(0);
+    emit finished(m_succeeded.loadRelaxed(), m_failed.loadRelaxed(), cancelled);
+}
+
+} // namespace PhotoGuru
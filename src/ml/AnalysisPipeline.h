@@ -0,0 +1,171 @@
+#pragma once
+
+#include <QObject>
+#include <QImage>
+#include <QStringList>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "core/BoundedQueue.h"
+#include "core/DecodeContext.h"
+#include "InferenceBackend.h"
+#include "QualityAnalyzer.h"
+
+namespace PhotoGuru {
+
+class CLIPAnalyzer;
+class FaceAnalyzer;
+class LlamaVLM;
+class EmbeddingStore;
+
+/**
+ * @brief Staged, off-UI-thread batch analysis of a set of images
+ *
+ *   decode pool -> [queue] -> batched CLIP -> [queue] -> VLM -> [queue] -> metadata writer
+ *
+ * Each stage runs on its own thread, the decoders on several, and stages
+ * are joined by bounded queues so decoding, inference and ExifTool writes
+ * overlap without unbounded memory.
+ *
+ * Embeddings and captions come from an InferenceBackend: the models in
+ * this process, or a server's.
+ *
+ * Every file is decoded once, into a DecodeContext bounded to
+ * Stages::frameEdge, and each stage takes its own view of it: CLIP a copy
+ * stretched to the model input, quality scoring and the thumbnail tier a
+ * fitted one, the VLM an RGB888 one, face detection a fitted one per
+ * CLIP batch. The frame travels with the file to the captioner and is
+ * released there, so queued files hold at most frameEdge-sized pixels. Files with a cached embedding skip CLIP, and
+ * are decoded only if the VLM asks for pixels.
+ *
+ * Signals are emitted from worker threads; connect with the default
+ * (auto) connection to receive them on the GUI thread.
+ */
+class AnalysisPipeline : public QObject {
+    Q_OBJECT
+
+public:
+    using Scores = QualityAnalyzer::Scores;
+
+    // Per-file progress reported through Stages::checkpoint, as bits
+    enum Checkpoint { Embedded = 1, Captioned = 2, Written = 4 };
+
+    // Stage implementations; defaultStages() wires CLIP/VLM/QualityAnalyzer/ThumbnailCache/MetadataWriter.
+    // caption, captionBatch, cached, store, score, thumbnail, faces, cachedCaption
+    // and checkpoint may be empty.
+    // captionBatch, when set, is used instead of caption for whatever is queued.
+    // decode returns the CLIP input (null: the file failed to decode).
+    // faces is handed each CLIP batch's frames, on the CLIP thread.
+    // cachedCaption returns a caption an interrupted run already paid the VLM for;
+    // checkpoint is told, from the stage threads, as each file passes a stage.
+    struct Stages {
+        int frameEdge = 0;  // Largest edge any stage views (0: full resolution)
+        std::function<QImage(const DecodeContext& frame)> decode;
+        std::function<std::vector<std::optional<std::vector<float>>>(const std::vector<QImage>&)> embed;
+        std::function<std::optional<std::vector<float>>(const QString& path)> cached;
+        std::function<void(const QString& path, const std::vector<float>& embedding)> store;
+        std::function<std::optional<Scores>(const DecodeContext& frame)> score;
+        std::function<void(const DecodeContext& frame)> thumbnail;
+        std::function<void(const std::vector<DecodeContext>& frames)> faces;
+        std::function<std::optional<QString>(const DecodeContext& frame)> caption;
+        std::function<std::vector<std::optional<QString>>(const std::vector<DecodeContext>& frames)> captionBatch;
+        std::function<bool(const QString& path, const QString& caption, const std::optional<Scores>& scores)> write;
+        std::function<std::optional<QString>(const QString& path)> cachedCaption;
+        std::function<void(const QString& path, Checkpoint reached, const QString& caption)> checkpoint;
+    };
+
+    // clip, vlm, store and faces must outlive the pipeline run; all but clip may be null
+    static Stages defaultStages(CLIPAnalyzer* clip, LlamaVLM* vlm, EmbeddingStore* store = nullptr,
+                                FaceAnalyzer* faces = nullptr);
+
+    // Embeddings and captions from backend (e.g. a RemoteInference); the
+    // other stages stay in this process. Same lifetimes as above.
+    static Stages defaultStages(InferenceBackend* backend, EmbeddingStore* store = nullptr,
+                                FaceAnalyzer* faces = nullptr);
+
+    // Identifies the models whose results defaultStages() writes, so a
+    // catalog job (PhotoDatabase::openAnalysisJob) redoes files analyzed by others
+    static QString modelStamp(const CLIPAnalyzer* clip, const LlamaVLM* vlm);
+    static QString modelStamp(const InferenceBackend::Info& info);
+
+    explicit AnalysisPipeline(Stages stages, QObject* parent = nullptr);
+    ~AnalysisPipeline();
+
+    void setBatchSize(int batchSize);
+    void setDecodeThreads(int threads);
+    
+    // Most images handed to captionBatch at once (e.g. the VLM's parallel sequences)
+    void setCaptionBatchSize(int batchSize);
+
+    // Starts processing in the background; ignored while a run is active
+    void start(const QStringList& filePaths);
+
+    // Drops queued work; stages stop after their current item
+    void cancel();
+
+    // Blocks until the current run has fully stopped
+    void wait();
+
+    bool isRunning() const { return m_running.loadAcquire() != 0; }
+
+signals:
+    void progress(int current, int total, const QString& message);
+    void log(const QString& message);
+    void finished(int succeeded, int failed, bool cancelled);
+
+private:
+    struct Decoded {
+        QString path;
+        DecodeContext frame;  // Empty when no later stage views it
+        QImage clipImage;
+        std::optional<Scores> scores;
+    };
+    struct Analyzed {
+        QString path;
+        DecodeContext frame;
+        std::vector<float> embedding;
+        QString caption;
+        std::optional<Scores> scores;
+    };
+
+    static Stages stagesFor(std::shared_ptr<InferenceBackend> backend, EmbeddingStore* store,
+                            FaceAnalyzer* faces);
+
+    void runDecoder();
+    void runEmbedder();
+    void runCaptioner();
+    void runWriter();
+
+    void fileDone(const QString& path, bool ok, const QString& message);
+
+    // Views besides CLIP's: quality scores and the thumbnail tier
+    std::optional<Scores> viewFrame(const DecodeContext& frame);
+
+    Stages m_stages;
+    QThreadPool m_pool;
+
+    QStringList m_files;
+    QAtomicInt m_nextFile{0};
+    QAtomicInt m_activeDecoders{0};
+    QAtomicInt m_done{0};
+    QAtomicInt m_succeeded{0};
+    QAtomicInt m_failed{0};
+    QAtomicInt m_cancelled{0};
+    QAtomicInt m_running{0};
+
+    BoundedQueue<Decoded> m_decoded;
+    BoundedQueue<Analyzed> m_embedded;
+    BoundedQueue<Analyzed> m_captioned;
+
+    int m_batchSize = 16;
+    int m_decodeThreads = 2;
+    int m_captionBatchSize = 1;
+
+    static constexpr int STAGE_QUEUE_CAPACITY = 64;
+    static constexpr int TITLE_MAX_TOKENS = 96;
+};
+
+} // namespace PhotoGuru
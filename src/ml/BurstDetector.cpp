@@ -0,0 +1,239 @@
+#include "BurstDetector.h"
+#include "VectorSearch.h"
+#include "core/EmbeddingStore.h"
+#include "core/MetadataWriter.h"
+#include "core/PhotoDatabase.h"
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QHash>
+#include <algorithm>
+
+namespace PhotoGuru {
+
+namespace {
+
+// Whether `b` continues the run ending in `a` (already sorted, same camera)
+bool continues(const BurstDetector::Shot& a, const BurstDetector::Shot& b, bool* sequenced) {
+    *sequenced = a.sequence > 0 && b.sequence == a.sequence + 1;
+    if (!a.burstId.isEmpty() && a.burstId == b.burstId) return true;
+    if (!a.burstId.isEmpty() && !b.burstId.isEmpty()) return false;  // Two different bursts
+    if (a.sequence > 0 && b.sequence == 1) return false;            // Camera started a new run
+    return *sequenced || a.captured.msecsTo(b.captured) <= BurstDetector::MAX_GAP_MS;
+}
+
+} // namespace
+
+BurstDetector::Stages BurstDetector::defaultStages(EmbeddingStore* store) {
+    Stages stages;
+
+    // Catalog first; what it lacks is read once and cataloged for next time
+    stages.metadata = [](const QStringList& paths) {
+        PhotoDatabase& catalog = PhotoDatabase::instance();
+        QHash<QString, PhotoMetadata> known = catalog.loadFreshMetadata(paths);
+        QStringList unknown;
+        for (const QString& path : paths) {
+            if (!known.contains(path)) unknown << path;
+        }
+
+        QList<PhotoMetadata> result = known.values();
+        if (!unknown.isEmpty()) {
+            std::vector<PhotoMetadata> read = MetadataReader::instance().readMany(unknown, MetadataReader::FilterSet);
+            QList<PhotoMetadata> fresh(read.begin(), read.end());
+            catalog.storeReadMetadata(fresh);
+            result += fresh;
+        }
+        return result;
+    };
+
+    if (store && store->isOpen()) {
+        stages.embedding = [store](const QString& path) { return store->find(path); };
+    }
+
+    stages.write = [](const QList<PhotoMetadata>& changed) {
+        QList<MetadataWriter::Transaction> transactions;
+        for (const PhotoMetadata& meta : changed) {
+            transactions << MetadataWriter::Transaction(meta.filepath).setTechnical(meta.technical);
+        }
+        std::vector<bool> written = MetadataWriter::instance().commitBatch(transactions);
+
+        QList<PhotoMetadata> stored;
+        for (int i = 0; i < changed.size(); ++i) {
+            if (size_t(i) < written.size() && written[size_t(i)]) stored << changed[i];
+        }
+        PhotoDatabase::instance().storeMetadataBatch(stored);  // After the write: keyed on the new mtime
+        return written;
+    };
+
+    return stages;
+}
+
+BurstDetector::BurstDetector(Stages stages, QObject* parent)
+    : QObject(parent)
+    , m_stages(std::move(stages))
+{
+}
+
+BurstDetector::~BurstDetector() {
+    cancel();
+    wait();
+}
+
+void BurstDetector::start(const QStringList& filePaths) {
+    if (isRunning()) return;
+    wait();  // Previous run may still be unwinding after cancel
+
+    m_files = filePaths;
+    m_cancelled.storeRelaxed(0);
+    m_running.storeRelease(1);
+    m_tasks.start([this]() { run(); });
+}
+
+void BurstDetector::cancel() {
+    m_cancelled.storeRelaxed(1);
+}
+
+void BurstDetector::wait() {
+    m_tasks.waitForDone();
+}
+
+BurstDetector::Shot BurstDetector::shotOf(const PhotoMetadata& metadata) {
+    Shot shot;
+    shot.path = metadata.filepath;
+    shot.captured = metadata.datetime_original;
+    shot.camera = (metadata.camera_make + ' ' + metadata.camera_model).trimmed();
+    shot.sequence = metadata.sequence_number;
+    shot.burstId = metadata.burst_id;
+
+    // Focus is what usually differs between frames; exposure breaks ties
+    const TechnicalMetadata& technical = metadata.technical;
+    shot.quality = technical.sharpness_score > 0.0
+        ? technical.sharpness_score + 0.1 * technical.exposure_quality
+        : technical.overall_quality;
+    return shot;
+}
+
+QList<QList<int>> BurstDetector::group(const QList<Shot>& shots,
+                                       const std::function<bool(int a, int b)>& similar) {
+    std::vector<int> order;
+    order.reserve(size_t(shots.size()));
+    for (int i = 0; i < shots.size(); ++i) {
+        if (shots[i].captured.isValid()) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&shots](int a, int b) {
+        const Shot& x = shots[a];
+        const Shot& y = shots[b];
+        if (x.camera != y.camera) return x.camera < y.camera;
+        if (x.captured != y.captured) return x.captured < y.captured;
+        if (x.sequence != y.sequence) return x.sequence < y.sequence;
+        return x.path < y.path;
+    });
+
+    QList<QList<int>> bursts;
+    QList<int> run;
+    auto flush = [&]() {
+        if (run.size() >= MIN_BURST_SIZE) bursts << run;
+        run.clear();
+    };
+
+    for (int index : order) {
+        if (!run.isEmpty()) {
+            const int previous = run.last();
+            bool sequenced = false;
+            bool joins = shots[previous].camera == shots[index].camera &&
+                         continues(shots[previous], shots[index], &sequenced);
+            // The camera's own numbering outranks how the frames look
+            if (joins && !sequenced && similar && !similar(previous, index)) joins = false;
+            if (!joins) flush();
+        }
+        run << index;
+    }
+    flush();
+    return bursts;
+}
+
+QString BurstDetector::groupId(const QString& firstPath) {
+    QByteArray digest = QCryptographicHash::hash(firstPath.toUtf8(), QCryptographicHash::Sha1);
+    return "burst-" + QString::fromLatin1(digest.toHex().left(10));
+}
+
+void BurstDetector::run() {
+    // 1. Capture metadata, from the catalog where it's fresh
+    emit progress(0, 0, "Reading capture times...");
+    QList<PhotoMetadata> metas = m_stages.metadata(m_files);
+    QList<Shot> shots;
+    shots.reserve(metas.size());
+    for (const PhotoMetadata& meta : metas) shots << shotOf(meta);
+
+    // 2. Runs of close frames; embeddings only for frames that are close
+    std::vector<std::optional<std::optional<std::vector<float>>>> embeddings(size_t(shots.size()));
+    auto embeddingOf = [&](int i) -> const std::optional<std::vector<float>>& {
+        if (!embeddings[size_t(i)]) embeddings[size_t(i)] = m_stages.embedding(shots[i].path);
+        return *embeddings[size_t(i)];
+    };
+    std::function<bool(int, int)> similar;
+    if (m_stages.embedding) {
+        similar = [&](int a, int b) {
+            const auto& x = embeddingOf(a);
+            const auto& y = embeddingOf(b);
+            if (!x || !y || x->size() != y->size() || x->empty()) return true;
+            return VectorSearch::dot(x->data(), y->data(), int(x->size())) >= m_continuity;
+        };
+    }
+
+    emit progress(0, 0, "Grouping bursts...");
+    QList<QList<int>> bursts = group(shots, similar);
+
+    std::vector<Assignment> assignments(size_t(shots.size()));
+    int frames = 0;
+    for (const QList<int>& burst : bursts) {
+        const QString id = groupId(shots[burst.first()].path);
+        int best = burst.first();
+        for (int i = 0; i < burst.size(); ++i) {
+            Assignment& assignment = assignments[size_t(burst[i])];
+            assignment.group = id;
+            assignment.position = i;
+            if (shots[burst[i]].quality > shots[best].quality) best = burst[i];
+        }
+        assignments[size_t(best)].best = true;
+        frames += burst.size();
+
+        QStringList names;
+        for (int index : burst) names << QFileInfo(shots[index].path).fileName();
+        emit log(QString("📸 %1 (%2 frames): %3").arg(id).arg(burst.size()).arg(names.join(", ")));
+    }
+
+    // 3. Write only what changed, including files that left a burst
+    QList<PhotoMetadata> changed;
+    for (int i = 0; i < metas.size(); ++i) {
+        const TechnicalMetadata& technical = metas[i].technical;
+        Assignment stored{technical.burst_group, technical.burst_position, technical.is_best_in_burst};
+        if (stored.group.isEmpty()) stored = Assignment();
+        if (stored == assignments[size_t(i)]) continue;
+
+        PhotoMetadata meta = metas[i];
+        meta.technical.burst_group = assignments[size_t(i)].group;
+        meta.technical.burst_position = assignments[size_t(i)].position;
+        meta.technical.is_best_in_burst = assignments[size_t(i)].best;
+        changed << meta;
+    }
+
+    int written = 0;
+    for (int start = 0; start < changed.size() && !m_cancelled.loadRelaxed(); start += WRITE_BATCH_SIZE) {
+        QList<PhotoMetadata> batch = changed.mid(start, WRITE_BATCH_SIZE);
+        std::vector<bool> results = m_stages.write ? m_stages.write(batch) : std::vector<bool>();
+        for (int i = 0; i < batch.size(); ++i) {
+            if (size_t(i) < results.size() && results[size_t(i)]) {
+                ++written;
+            } else {
+                emit log(QString("⚠️ Write failed: %1").arg(QFileInfo(batch[i].filepath).fileName()));
+            }
+        }
+        emit progress(start + batch.size(), changed.size(), "Writing burst groups");
+    }
+
+    bool cancelled = m_cancelled.loadRelaxed() != 0;
+    m_running.storeRelease(0);
+    emit finished(bursts.size(), frames, written, cancelled);
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "core/PhotoMetadata.h"
+#include "core/TaskScheduler.h"
+#include <QObject>
+#include <QDateTime>
+#include <QStringList>
+#include <QList>
+#include <QAtomicInt>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace PhotoGuru {
+
+class EmbeddingStore;
+
+/**
+ * @brief Background burst grouping from capture metadata
+ *
+ *   catalog metadata -> per camera, sorted by capture time -> runs of close frames -> burst_group
+ *
+ * Capture time is DateTimeOriginal with SubSecTimeOriginal, never the
+ * file's own dates, which change on every copy. Consecutive frames of a
+ * camera join a burst when they are at most MAX_GAP_MS apart, or share
+ * the camera's burst id or follow its sequence numbering. A sequence
+ * restarting at 1 starts a new burst, and where both frames have a
+ * stored embedding, a dot product below the continuity threshold splits
+ * them (the camera turned to something else). Runs of MIN_BURST_SIZE or
+ * more become bursts; the sharpest frame is marked best.
+ *
+ * One sort per camera, so N log N, and only files whose burst fields
+ * actually change are written: adding a folder's new imports rewrites
+ * just the bursts they join. Burst ids depend on the first frame only,
+ * so they stay stable as later frames are added. Signals are emitted
+ * from the worker thread.
+ */
+class BurstDetector : public QObject {
+    Q_OBJECT
+
+public:
+    struct Shot {
+        QString path;
+        QDateTime captured;      // With milliseconds
+        QString camera;          // Make + model; frames of different bodies never mix
+        int sequence = 0;        // 0 if unknown
+        QString burstId;         // Camera-recorded burst, empty if none
+        double quality = 0.0;    // Picks the best frame
+    };
+
+    struct Assignment {
+        QString group;           // Empty: not in a burst
+        int position = -1;
+        bool best = false;
+
+        bool operator==(const Assignment& other) const {
+            return group == other.group && position == other.position && best == other.best;
+        }
+    };
+
+    // Stage implementations; defaultStages() wires PhotoDatabase/MetadataReader/EmbeddingStore/MetadataWriter.
+    // embedding may be empty (no continuity check).
+    struct Stages {
+        // Readable files only, in any order
+        std::function<QList<PhotoMetadata>(const QStringList& paths)> metadata;
+        std::function<std::optional<std::vector<float>>(const QString& path)> embedding;
+        // One result per file, in order
+        std::function<std::vector<bool>(const QList<PhotoMetadata>& changed)> write;
+    };
+
+    // store must outlive the run; may be null
+    static Stages defaultStages(EmbeddingStore* store);
+
+    explicit BurstDetector(Stages stages, QObject* parent = nullptr);
+    ~BurstDetector();
+
+    void setContinuityThreshold(float threshold) { m_continuity = threshold; }
+
+    // Starts in the background; ignored while a run is active
+    void start(const QStringList& filePaths);
+    void cancel();
+    void wait();
+    bool isRunning() const { return m_running.loadAcquire() != 0; }
+
+    static Shot shotOf(const PhotoMetadata& metadata);
+
+    /**
+     * @brief Bursts among `shots`, as frame indices in shooting order
+     * @param similar Whether two frames look continuous; may be empty
+     */
+    static QList<QList<int>> group(const QList<Shot>& shots,
+                                   const std::function<bool(int a, int b)>& similar = {});
+
+    // Stable id for a burst: its first frame's path
+    static QString groupId(const QString& firstPath);
+
+    static constexpr qint64 MAX_GAP_MS = 2000;  // Tolerates second-only timestamps
+    static constexpr int MIN_BURST_SIZE = 3;
+    static constexpr float DEFAULT_CONTINUITY = 0.80f;
+    static constexpr int WRITE_BATCH_SIZE = 50;
+
+signals:
+    void progress(int current, int total, const QString& message);
+    void log(const QString& message);
+    void finished(int bursts, int frames, int written, bool cancelled);
+
+private:
+    void run();
+
+    Stages m_stages;
+    TaskGroup m_tasks{TaskScheduler::AI};
+    QStringList m_files;
+    float m_continuity = DEFAULT_CONTINUITY;
+
+    QAtomicInt m_cancelled{0};
+    QAtomicInt m_running{0};
+};
+
+} // namespace PhotoGuru
@@ -1,13 +1,17 @@
 #include "CLIPAnalyzer.h"
+#include "VectorSearch.h"
+#include "core/PixelBuffer.h"
 #include <QImage>
 #include <QDebug>
 #include <cmath>
 #include <algorithm>
+#include <numeric>
 
 namespace PhotoGuru {
 
 CLIPAnalyzer::CLIPAnalyzer() 
     : m_visionModel(std::make_unique<ONNXInference>())
+    , m_textModel(std::make_unique<ONNXInference>())
 {
 }
 
@@ -25,7 +29,7 @@ bool CLIPAnalyzer::initialize(const QString& visionModelPath, bool useGPU) {
     // Set model info
     m_modelInfo.embeddingDim = 512; // CLIP ViT-B/32
     m_modelInfo.inputSize = 224;
-    m_modelInfo.gpuAccelerated = useGPU;
+    m_modelInfo.gpuAccelerated = m_visionModel->provider() != ONNXInference::Provider::CPU;
     m_modelInfo.modelVersion = "ViT-B/32";
     
     auto outputShape = m_visionModel->getOutputShape();
@@ -43,6 +47,69 @@ bool CLIPAnalyzer::initialize(const QString& visionModelPath, bool useGPU) {
     return true;
 }
 
+bool CLIPAnalyzer::initializeText(const QString& textModelPath, const QString& vocabPath,
+                                  const QString& mergesPath, bool useGPU) {
+    qDebug() << "[CLIP] Initializing text tower with model:" << textModelPath;
+    m_textInitialized = false;
+    m_textCache.clear();
+    
+    if (!m_initialized) {
+        m_lastError = "Vision model must be initialized before the text model";
+        qWarning() << "[CLIP]" << m_lastError;
+        return false;
+    }
+    if (!m_tokenizer.load(vocabPath, mergesPath)) {
+        m_lastError = "Failed to load tokenizer: " + m_tokenizer.lastError();
+        qWarning() << "[CLIP]" << m_lastError;
+        return false;
+    }
+    if (!m_textModel->loadModel(textModelPath, useGPU)) {
+        m_lastError = "Failed to load text model: " + m_textModel->lastError();
+        qWarning() << "[CLIP]" << m_lastError;
+        return false;
+    }
+    
+    // Probe once: the text projection has to land in the image embedding space
+    m_textInitialized = true;
+    auto probe = computeTextEmbedding("a photo");
+    if (!probe || static_cast<int>(probe->size()) != m_modelInfo.embeddingDim) {
+        m_lastError = QString("Text embedding dimension %1 does not match image dimension %2")
+                      .arg(probe ? static_cast<int>(probe->size()) : 0).arg(m_modelInfo.embeddingDim);
+        qWarning() << "[CLIP]" << m_lastError;
+        m_textInitialized = false;
+        m_textCache.clear();
+        return false;
+    }
+    
+    qDebug() << "[CLIP] Text tower initialized," << m_tokenizer.vocabSize() << "tokens";
+    return true;
+}
+
+std::optional<std::vector<float>> CLIPAnalyzer::computeTextEmbedding(const QString& text) {
+    if (!m_textInitialized) {
+        m_lastError = "CLIP text model not initialized";
+        return std::nullopt;
+    }
+    
+    const QString key = text.simplified().toLower();
+    if (const std::vector<float>* cached = m_textCache.object(key)) {
+        return *cached;
+    }
+    
+    std::vector<int64_t> mask;
+    std::vector<int64_t> ids = m_tokenizer.encode(key, &mask);
+    auto output = m_textModel->runTokens(ids, mask, 1);
+    if (!output || output->empty()) {
+        m_lastError = "Text inference failed: " + m_textModel->lastError();
+        return std::nullopt;
+    }
+    
+    std::vector<float> embedding = std::move(*output);
+    normalizeEmbedding(embedding);
+    m_textCache.insert(key, new std::vector<float>(embedding));
+    return embedding;
+}
+
 std::optional<std::vector<float>> CLIPAnalyzer::computeEmbedding(const QImage& image) {
     if (!m_initialized) {
         m_lastError = "CLIP analyzer not initialized";
@@ -73,49 +140,104 @@ std::optional<std::vector<float>> CLIPAnalyzer::computeEmbedding(const QImage& i
     }
     
     // Normalize embedding to unit length
-    std::vector<float> embedding = output.value();
+    std::vector<float> embedding = std::move(output.value());
     normalizeEmbedding(embedding);
     
-    qDebug() << "[CLIP] Computed embedding: dim=" << embedding.size() 
-             << ", norm=" << std::sqrt(std::inner_product(
-                 embedding.begin(), embedding.end(), embedding.begin(), 0.0f));
-    
     return embedding;
 }
 
-std::vector<float> CLIPAnalyzer::computeEmbedding(const cv::Mat& image) {
-    qDebug() << "[CLIP] Computing embedding from cv::Mat:" << image.cols << "x" << image.rows 
-             << "channels=" << image.channels();
+std::vector<std::optional<std::vector<float>>> CLIPAnalyzer::computeEmbeddings(
+    const std::vector<QImage>& images
+) {
+    std::vector<std::optional<std::vector<float>>> results(images.size());
+    if (!m_initialized) {
+        m_lastError = "CLIP analyzer not initialized";
+        return results;
+    }
+    
+    // CLIP preprocessing: mean=[0.48145466, 0.4578275, 0.40821073], std=[0.26862954, 0.26130258, 0.27577711]
+    std::vector<float> mean = {0.48145466f, 0.4578275f, 0.40821073f};
+    std::vector<float> std = {0.26862954f, 0.26130258f, 0.27577711f};
+    
+    const size_t sampleSize = m_visionModel->sampleSize();
+    std::vector<float> batch;
+    std::vector<size_t> batchIndices;
+    batch.reserve(sampleSize * m_batchSize);
+    batchIndices.reserve(m_batchSize);
     
-    // Convert cv::Mat to QImage
-    QImage qImage;
+    auto flush = [&]() {
+        if (batchIndices.empty()) return;
+        
+        int count = static_cast<int>(batchIndices.size());
+        size_t dim = m_visionModel->outputSampleSize();
+        bool ok = false;
+        if (dim > 0) {
+            // Model writes straight into the reused buffer
+            m_outputBuffer.resize(dim * count);
+            ok = m_visionModel->runInto(batch.data(), count, m_outputBuffer.data(), m_outputBuffer.size());
+        } else if (auto output = m_visionModel->runBatch(batch, count)) {
+            m_outputBuffer = std::move(*output);
+            dim = m_outputBuffer.size() / count;
+            ok = true;
+        }
+        
+        if (!ok) {
+            m_lastError = "Inference failed: " + m_visionModel->lastError();
+        } else {
+            for (int i = 0; i < count; ++i) {
+                std::vector<float> embedding(m_outputBuffer.begin() + i * dim,
+                                             m_outputBuffer.begin() + (i + 1) * dim);
+                normalizeEmbedding(embedding);
+                results[batchIndices[i]] = std::move(embedding);
+            }
+        }
+        
+        batch.clear();
+        batchIndices.clear();
+    };
+    
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (images[i].isNull()) continue;
+        
+        // Preprocess straight into this image's slot of the batch tensor
+        size_t offset = batch.size();
+        batch.resize(offset + sampleSize);
+        if (!m_visionModel->preprocessImageInto(images[i], batch.data() + offset, mean, std)) {
+            batch.resize(offset);
+            continue;
+        }
+        batchIndices.push_back(i);
+        if (static_cast<int>(batchIndices.size()) == m_batchSize) {
+            flush();
+        }
+    }
+    flush();
     
+    return results;
+}
+
+void CLIPAnalyzer::setBatchSize(int batchSize) {
+    m_batchSize = std::clamp(batchSize, MIN_BATCH_SIZE, MAX_BATCH_SIZE);
+}
+
+std::vector<float> CLIPAnalyzer::computeEmbedding(const cv::Mat& image) {
     if (image.empty()) {
         m_lastError = "Empty image";
         qDebug() << "[CLIP] Error:" << m_lastError;
         return {};
     }
     
-    if (image.channels() == 3) {
-        // BGR to RGB
-        cv::Mat rgb;
-        cv::cvtColor(image, rgb, cv::COLOR_BGR2RGB);
-        qImage = QImage(rgb.data, rgb.cols, rgb.rows, 
-                       rgb.step, QImage::Format_RGB888).copy();
-    } else if (image.channels() == 1) {
-        qImage = QImage(image.data, image.cols, image.rows,
-                       image.step, QImage::Format_Grayscale8).copy();
-    } else {
+    // A BGR (or gray) QImage over the Mat's own pixels; preprocessing
+    // scales to the model input before it reorders any channels
+    QImage qImage = PixelBuffer::fromMat(image).image();
+    if (qImage.isNull()) {
         m_lastError = "Unsupported image format: " + QString::number(image.channels()) + " channels";
         qDebug() << "[CLIP] Error:" << m_lastError;
         return {};
     }
     
-    qDebug() << "[CLIP] Converted to QImage:" << qImage.width() << "x" << qImage.height();
-    
     auto result = computeEmbedding(qImage);
     if (result.has_value()) {
-        qDebug() << "[CLIP] Embedding computed successfully from cv::Mat";
         return result.value();
     }
     qDebug() << "[CLIP] Failed to compute embedding:" << m_lastError;
@@ -142,9 +264,7 @@ float CLIPAnalyzer::cosineSimilarity(
     }
     
     // Compute dot product (embeddings should already be normalized)
-    float dotProduct = std::inner_product(emb1.begin(), emb1.end(), emb2.begin(), 0.0f);
-    
-    return dotProduct;
+    return VectorSearch::dot(emb1.data(), emb2.data(), static_cast<int>(emb1.size()));
 }
 
 std::vector<int> CLIPAnalyzer::findMostSimilar(
@@ -156,28 +276,21 @@ std::vector<int> CLIPAnalyzer::findMostSimilar(
         return {};
     }
     
-    // Calculate similarities
-    std::vector<std::pair<float, int>> similarities;
-    similarities.reserve(databaseEmbeddings.size());
-    
+    // SIMD dot products, then keep only the top k instead of sorting all N
+    const int dim = static_cast<int>(queryEmbedding.size());
+    std::vector<float> similarities(databaseEmbeddings.size());
     for (size_t i = 0; i < databaseEmbeddings.size(); ++i) {
-        float sim = cosineSimilarity(queryEmbedding, databaseEmbeddings[i]);
-        similarities.emplace_back(sim, static_cast<int>(i));
+        const auto& candidate = databaseEmbeddings[i];
+        similarities[i] = static_cast<int>(candidate.size()) == dim
+            ? VectorSearch::dot(queryEmbedding.data(), candidate.data(), dim)
+            : 0.0f;
     }
     
-    // Sort by similarity (descending)
-    std::sort(similarities.begin(), similarities.end(),
-             [](const auto& a, const auto& b) { return a.first > b.first; });
-    
-    // Return top k indices
-    int numResults = std::min(k, static_cast<int>(similarities.size()));
     std::vector<int> result;
-    result.reserve(numResults);
-    
-    for (int i = 0; i < numResults; ++i) {
-        result.push_back(similarities[i].second);
+    for (const auto& hit : VectorSearch::topK(similarities.data(),
+                                              static_cast<int>(similarities.size()), k)) {
+        result.push_back(hit.id);
     }
-    
     return result;
 }
 
@@ -200,6 +313,20 @@ std::vector<std::pair<QString, float>> CLIPAnalyzer::zeroShotClassification(
     return results;
 }
 
+std::vector<std::pair<QString, float>> CLIPAnalyzer::zeroShotClassification(
+    const std::vector<float>& imageEmbedding,
+    const QStringList& labels
+) {
+    std::vector<std::pair<QString, std::vector<float>>> textEmbeddings;
+    textEmbeddings.reserve(labels.size());
+    for (const QString& label : labels) {
+        if (auto embedding = computeTextEmbedding(label)) {
+            textEmbeddings.emplace_back(label, std::move(*embedding));
+        }
+    }
+    return zeroShotClassification(imageEmbedding, textEmbeddings);
+}
+
 void CLIPAnalyzer::normalizeEmbedding(std::vector<float>& embedding) const {
     float norm = std::sqrt(std::inner_product(
         embedding.begin(), embedding.end(), embedding.begin(), 0.0f));
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "ONNXInference.h"
+#include "CLIPTokenizer.h"
 #include <QString>
+#include <QStringList>
 #include <QImage>
+#include <QCache>
 #include <vector>
 #include <optional>
 #include <opencv2/opencv.hpp>
@@ -14,6 +17,7 @@ namespace PhotoGuru {
  * 
  * Uses ONNX Runtime to run CLIP vision model locally:
  * - Generates 512-dimensional image embeddings
+ * - Optional text tower: query-text embeddings in the same space
  * - Enables semantic image search
  * - Zero-shot image classification
  * - Image similarity comparison
@@ -27,6 +31,9 @@ namespace PhotoGuru {
  *   clip.initialize("models/clip_vision.onnx");
  *   auto embedding = clip.computeEmbedding(image);
  *   float similarity = clip.cosineSimilarity(emb1, emb2);
+ *
+ *   clip.initializeText("models/clip_text.onnx", "vocab.json", "merges.txt");
+ *   auto query = clip.computeTextEmbedding("sunset at the beach");
  */
 class CLIPAnalyzer {
 public:
@@ -48,6 +55,24 @@ public:
         return initialize(modelPath, useGPU);
     }
     
+    /**
+     * @brief Load the CLIP text tower and its BPE tokenizer
+     * 
+     * The text model must project into the vision model's embedding space,
+     * so call initialize() first; a dimension mismatch is rejected.
+     * 
+     * @param textModelPath Path to clip_text.onnx (input_ids [+ attention_mask])
+     * @param vocabPath Tokenizer vocab.json
+     * @param mergesPath Tokenizer merges.txt
+     */
+    bool initializeText(const QString& textModelPath, const QString& vocabPath,
+                        const QString& mergesPath, bool useGPU = true);
+    
+    /**
+     * @brief Check if the text tower is ready for computeTextEmbedding
+     */
+    bool isTextInitialized() const { return m_textInitialized; }
+    
     /**
      * @brief Check if model is ready
      */
@@ -78,6 +103,42 @@ public:
      */
     std::optional<std::vector<float>> computeEmbedding(const QString& imagePath);
     
+    /**
+     * @brief Compute CLIP embeddings for many images, batchSize() per run
+     * 
+     * Uses the model's dynamic batch axis so CoreML/CUDA get a full batch
+     * instead of one image at a time.
+     * 
+     * @param images Input images (any size); null images yield nullopt
+     * @return One entry per input image, in the same order
+     */
+    std::vector<std::optional<std::vector<float>>> computeEmbeddings(
+        const std::vector<QImage>& images
+    );
+    
+    /**
+     * @brief Compute CLIP embedding for a text query
+     * 
+     * Queries are cached (LRU, textCacheSize() entries) by their
+     * whitespace-collapsed, lowercase form - the tokenizer's view of them -
+     * so repeated searches skip the text forward pass.
+     * 
+     * @return Unit-length embedding comparable with image embeddings
+     */
+    std::optional<std::vector<float>> computeTextEmbedding(const QString& text);
+    
+    /**
+     * @brief Maximum number of cached query embeddings
+     */
+    void setTextCacheSize(int entries) { m_textCache.setMaxCost(entries); }
+    int textCacheSize() const { return static_cast<int>(m_textCache.maxCost()); }
+    
+    /**
+     * @brief Images per inference run for computeEmbeddings (clamped to 8-64)
+     */
+    void setBatchSize(int batchSize);
+    int batchSize() const { return m_batchSize; }
+    
     /**
      * @brief Calculate cosine similarity between two embeddings
      * @param emb1 First embedding (must be normalized)
@@ -91,6 +152,9 @@ public:
     
     /**
      * @brief Find most similar images from a set
+     *
+     * Exact scan with partial top-k selection. For the whole library use
+     * SimilarityIndex, which switches to an HNSW graph on large stores.
      * @param queryEmbedding Query image embedding
      * @param databaseEmbeddings List of candidate embeddings
      * @param k Number of results to return
@@ -113,6 +177,15 @@ public:
         const std::vector<std::pair<QString, std::vector<float>>>& textEmbeddings
     ) const;
     
+    /**
+     * @brief Zero-shot classification against labels embedded by the text tower
+     * @param labels Prompts such as "a photo of a dog"; labels that fail to embed are skipped
+     */
+    std::vector<std::pair<QString, float>> zeroShotClassification(
+        const std::vector<float>& imageEmbedding,
+        const QStringList& labels
+    );
+    
     /**
      * @brief Get last error message
      */
@@ -128,12 +201,25 @@ public:
         bool gpuAccelerated = false;
     };
     ModelInfo getModelInfo() const { return m_modelInfo; }
+    
+    static constexpr int MIN_BATCH_SIZE = 8;
+    static constexpr int MAX_BATCH_SIZE = 64;
+    static constexpr int DEFAULT_BATCH_SIZE = 16;
+    static constexpr int DEFAULT_TEXT_CACHE_SIZE = 256;
 
 private:
     std::unique_ptr<ONNXInference> m_visionModel;
     bool m_initialized = false;
     QString m_lastError;
     ModelInfo m_modelInfo;
+    int m_batchSize = DEFAULT_BATCH_SIZE;
+    std::vector<float> m_outputBuffer;  // Batch output, reused across computeEmbeddings calls
+    
+    // Text tower
+    std::unique_ptr<ONNXInference> m_textModel;
+    CLIPTokenizer m_tokenizer;
+    bool m_textInitialized = false;
+    QCache<QString, std::vector<float>> m_textCache{DEFAULT_TEXT_CACHE_SIZE};
     
     // Normalize embedding to unit length
     void normalizeEmbedding(std::vector<float>& embedding) const;
@@ -0,0 +1,180 @@
+#include "CLIPTokenizer.h"
+#include <QFile>
+#include <QTextStream>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QDebug>
+#include <algorithm>
+#include <climits>
+
+namespace PhotoGuru {
+
+namespace {
+const QString START_OF_TEXT = QStringLiteral("<|startoftext|>");
+const QString END_OF_TEXT = QStringLiteral("<|endoftext|>");
+const QString END_OF_WORD = QStringLiteral("</w>");
+}
+
+CLIPTokenizer::CLIPTokenizer()
+    : m_wordPattern(R"(<\|startoftext\|>|<\|endoftext\|>|'s|'t|'re|'ve|'m|'ll|'d|[\p{L}]+|[\p{N}]|[^\s\p{L}\p{N}]+)",
+                    QRegularExpression::CaseInsensitiveOption | QRegularExpression::UseUnicodePropertiesOption)
+{
+    // GPT-2 byte encoder: printable bytes map to themselves, the rest to 256+n
+    int next = 0;
+    for (int b = 0; b < 256; ++b) {
+        bool printable = (b >= '!' && b <= '~') || (b >= 0xA1 && b <= 0xAC) || (b >= 0xAE && b <= 0xFF);
+        m_byteToUnicode[b] = printable ? QChar(b) : QChar(256 + next++);
+    }
+}
+
+bool CLIPTokenizer::load(const QString& vocabPath, const QString& mergesPath) {
+    m_vocab.clear();
+    m_mergeRanks.clear();
+    m_cache.clear();
+    m_startToken = -1;
+    m_endToken = -1;
+
+    QFile vocabFile(vocabPath);
+    if (!vocabFile.open(QIODevice::ReadOnly)) {
+        m_lastError = "Cannot open vocabulary: " + vocabPath;
+        qWarning() << "[CLIPTokenizer]" << m_lastError;
+        return false;
+    }
+    QJsonParseError parseError;
+    QJsonDocument vocab = QJsonDocument::fromJson(vocabFile.readAll(), &parseError);
+    if (!vocab.isObject()) {
+        m_lastError = "Invalid vocabulary: " + parseError.errorString();
+        qWarning() << "[CLIPTokenizer]" << m_lastError;
+        return false;
+    }
+    const QJsonObject tokens = vocab.object();
+    m_vocab.reserve(tokens.size());
+    for (auto it = tokens.constBegin(); it != tokens.constEnd(); ++it) {
+        m_vocab.insert(it.key(), it.value().toInt());
+    }
+
+    QFile mergesFile(mergesPath);
+    if (!mergesFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        m_lastError = "Cannot open merges: " + mergesPath;
+        qWarning() << "[CLIPTokenizer]" << m_lastError;
+        m_vocab.clear();
+        return false;
+    }
+    QTextStream merges(&mergesFile);
+    merges.setEncoding(QStringConverter::Utf8);
+    int rank = 0;
+    while (!merges.atEnd()) {
+        QString line = merges.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith("#version")) continue;
+        m_mergeRanks.insert(line, rank++);
+    }
+
+    m_startToken = m_vocab.value(START_OF_TEXT, -1);
+    m_endToken = m_vocab.value(END_OF_TEXT, -1);
+    if (!isLoaded()) {
+        m_lastError = "Vocabulary has no start/end of text tokens";
+        qWarning() << "[CLIPTokenizer]" << m_lastError;
+        return false;
+    }
+
+    qDebug() << "[CLIPTokenizer] Loaded" << m_vocab.size() << "tokens," << rank << "merges";
+    return true;
+}
+
+std::vector<int> CLIPTokenizer::bpe(const QString& word) const {
+    auto cached = m_cache.constFind(word);
+    if (cached != m_cache.constEnd()) {
+        return cached.value();
+    }
+
+    QStringList symbols;
+    const QByteArray utf8 = word.toUtf8();
+    for (char byte : utf8) {
+        symbols << QString(m_byteToUnicode[static_cast<unsigned char>(byte)]);
+    }
+    if (symbols.isEmpty()) return {};
+    symbols.last() += END_OF_WORD;
+
+    // Repeatedly merge the lowest-ranked adjacent pair
+    while (symbols.size() > 1) {
+        int bestRank = INT_MAX;
+        int best = -1;
+        for (int i = 0; i + 1 < symbols.size(); ++i) {
+            int rank = m_mergeRanks.value(symbols[i] + ' ' + symbols[i + 1], INT_MAX);
+            if (rank < bestRank) {
+                bestRank = rank;
+                best = i;
+            }
+        }
+        if (best < 0) break;
+
+        const QString left = symbols[best];
+        const QString right = symbols[best + 1];
+        QStringList merged;
+        for (int i = 0; i < symbols.size();) {
+            if (i + 1 < symbols.size() && symbols[i] == left && symbols[i + 1] == right) {
+                merged << left + right;
+                i += 2;
+            } else {
+                merged << symbols[i++];
+            }
+        }
+        symbols = merged;
+    }
+
+    std::vector<int> ids;
+    ids.reserve(size_t(symbols.size()));
+    for (const QString& symbol : symbols) {
+        auto id = m_vocab.constFind(symbol);
+        if (id != m_vocab.constEnd()) {
+            ids.push_back(id.value());
+        }
+    }
+
+    if (m_cache.size() >= MAX_CACHED_WORDS) {
+        m_cache.clear();
+    }
+    m_cache.insert(word, ids);
+    return ids;
+}
+
+std::vector<int> CLIPTokenizer::tokenize(const QString& text) const {
+    std::vector<int> ids;
+    if (!isLoaded()) return ids;
+
+    const QString cleaned = text.simplified().toLower();
+    auto words = m_wordPattern.globalMatch(cleaned);
+    while (words.hasNext()) {
+        const QString word = words.next().captured();
+        if (word == START_OF_TEXT || word == END_OF_TEXT) {
+            ids.push_back(m_vocab.value(word));
+            continue;
+        }
+        std::vector<int> pieces = bpe(word);
+        ids.insert(ids.end(), pieces.begin(), pieces.end());
+    }
+    return ids;
+}
+
+std::vector<int64_t> CLIPTokenizer::encode(const QString& text, std::vector<int64_t>* attentionMask) const {
+    std::vector<int64_t> ids(CONTEXT_LENGTH, 0);
+    if (attentionMask) attentionMask->assign(CONTEXT_LENGTH, 0);
+    if (!isLoaded()) return ids;
+
+    std::vector<int> tokens = tokenize(text);
+    const size_t kept = std::min(tokens.size(), size_t(CONTEXT_LENGTH - 2));
+
+    ids[0] = m_startToken;
+    for (size_t i = 0; i < kept; ++i) {
+        ids[i + 1] = tokens[i];
+    }
+    ids[kept + 1] = m_endToken;  // Always present, even when truncated
+
+    if (attentionMask) {
+        std::fill(attentionMask->begin(), attentionMask->begin() + kept + 2, 1);
+    }
+    return ids;
+}
+
+} // namespace PhotoGuru
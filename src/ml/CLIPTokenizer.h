@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QString>
+#include <QHash>
+#include <QRegularExpression>
+#include <vector>
+#include <cstdint>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Byte-level BPE tokenizer for the CLIP text encoder
+ *
+ * Reads the Hugging Face tokenizer files (vocab.json + merges.txt) and
+ * reproduces OpenAI's simple_tokenizer: lowercase, collapse whitespace,
+ * split into words, map UTF-8 bytes to printable code points, mark the
+ * end of each word with "</w>" and apply merges by rank.
+ *
+ * encode() frames the tokens as <|startoftext|> ... <|endoftext|> and pads
+ * with 0 to CONTEXT_LENGTH, which both the OpenAI and HF exports accept.
+ *
+ * Not thread-safe (per-word BPE results are cached).
+ */
+class CLIPTokenizer {
+public:
+    CLIPTokenizer();
+
+    bool load(const QString& vocabPath, const QString& mergesPath);
+    bool isLoaded() const { return m_startToken >= 0 && m_endToken >= 0; }
+
+    /**
+     * @brief BPE token ids for text, without start/end tokens or padding
+     */
+    std::vector<int> tokenize(const QString& text) const;
+
+    /**
+     * @brief Model input: start + tokens + end, truncated/padded to CONTEXT_LENGTH
+     * @param attentionMask If given, receives 1 for real tokens and 0 for padding
+     */
+    std::vector<int64_t> encode(const QString& text, std::vector<int64_t>* attentionMask = nullptr) const;
+
+    int startToken() const { return m_startToken; }
+    int endToken() const { return m_endToken; }
+    int vocabSize() const { return m_vocab.size(); }
+    QString lastError() const { return m_lastError; }
+
+    static constexpr int CONTEXT_LENGTH = 77;
+
+private:
+    std::vector<int> bpe(const QString& word) const;
+
+    QHash<QString, int> m_vocab;
+    QHash<QString, int> m_mergeRanks;  // "left right" -> rank
+    QChar m_byteToUnicode[256];
+    QRegularExpression m_wordPattern;
+    int m_startToken = -1;
+    int m_endToken = -1;
+    QString m_lastError;
+
+    mutable QHash<QString, std::vector<int>> m_cache;
+    static constexpr int MAX_CACHED_WORDS = 8192;
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,440 @@
+#include "DuplicateFinder.h"
+#include "CLIPAnalyzer.h"
+#include "HnswIndex.h"
+#include "VectorSearch.h"
+#include "core/EmbeddingStore.h"
+#include "core/FileFingerprint.h"
+#include "core/HammingIndex.h"
+#include "core/PerceptualHash.h"
+#include "core/ResourceGovernor.h"
+#include "core/MetadataWriter.h"
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <algorithm>
+#include <numeric>
+
+namespace PhotoGuru {
+
+namespace {
+
+class UnionFind {
+public:
+    explicit UnionFind(int count) : m_parent(size_t(count)), m_size(size_t(count), 1) {
+        std::iota(m_parent.begin(), m_parent.end(), 0);
+    }
+
+    int find(int x) {
+        while (m_parent[size_t(x)] != x) {
+            m_parent[size_t(x)] = m_parent[size_t(m_parent[size_t(x)])];  // Path halving
+            x = m_parent[size_t(x)];
+        }
+        return x;
+    }
+
+    void unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return;
+        if (m_size[size_t(a)] < m_size[size_t(b)]) std::swap(a, b);
+        m_parent[size_t(b)] = a;
+        m_size[size_t(a)] += m_size[size_t(b)];
+    }
+
+    int setSize(int x) { return m_size[size_t(find(x))]; }
+
+private:
+    std::vector<int> m_parent;
+    std::vector<int> m_size;
+};
+
+bool isCancelled(const QAtomicInt* cancel) {
+    return cancel && cancel->loadRelaxed() != 0;
+}
+
+// Group index per element of a set with another member, in order of first member
+std::vector<int> compactGroups(UnionFind& sets, int rows) {
+    std::vector<int> groups(size_t(rows), -1);
+    std::vector<int> rootGroup(size_t(rows), -1);
+    int nextGroup = 0;
+    for (int r = 0; r < rows; ++r) {
+        if (sets.setSize(r) < 2) continue;
+        int root = sets.find(r);
+        if (rootGroup[size_t(root)] < 0) {
+            rootGroup[size_t(root)] = nextGroup++;
+        }
+        groups[size_t(r)] = rootGroup[size_t(root)];
+    }
+    return groups;
+}
+
+} // namespace
+
+DuplicateFinder::Stages DuplicateFinder::defaultStages(CLIPAnalyzer* clip, EmbeddingStore* store) {
+    Stages stages;
+    const int clipSize = clip ? clip->getModelInfo().inputSize : 224;
+
+    stages.decode = [clipSize](const QString& path) -> QImage {
+        QImage image(path);
+        if (image.isNull()) return QImage();
+        return image.scaled(clipSize, clipSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    };
+
+    if (clip) {
+        stages.embed = [clip](const std::vector<QImage>& images) {
+            return clip->computeEmbeddings(images);
+        };
+    }
+
+    if (store && store->isOpen()) {
+        stages.cached = [store](const QString& path) { return store->findOrAdopt(path); };
+        stages.store = [store](const QString& path, const std::vector<float>& embedding) {
+            store->insert(path, embedding);
+        };
+    }
+
+    stages.exactGroups = [](const QStringList& paths) {
+        return FileFingerprint::instance().exactDuplicates(paths);
+    };
+
+    stages.perceptualHashes = [](const QStringList& paths) {
+        return PerceptualHash::instance().hashes(paths);
+    };
+
+    // Only touch files whose group actually changes; keeps the other technical fields
+    stages.write = [](const QString& path, const QString& group) {
+        auto existing = MetadataReader::instance().readTechnicalOnly(path);
+        if (existing ? existing->duplicate_group == group : group.isEmpty()) {
+            return true;
+        }
+        TechnicalMetadata technical = existing.value_or(TechnicalMetadata());
+        technical.duplicate_group = group;
+        return MetadataWriter::instance().writeTechnicalMetadata(path, technical);
+    };
+
+    return stages;
+}
+
+DuplicateFinder::DuplicateFinder(Stages stages, QObject* parent)
+    : QObject(parent)
+    , m_stages(std::move(stages))
+{
+}
+
+DuplicateFinder::~DuplicateFinder() {
+    cancel();
+    wait();
+}
+
+void DuplicateFinder::setBatchSize(int batchSize) {
+    m_batchSize = std::clamp(batchSize, 1, CLIPAnalyzer::MAX_BATCH_SIZE);
+}
+
+void DuplicateFinder::start(const QStringList& filePaths) {
+    if (isRunning()) return;
+    wait();  // Previous run may still be unwinding after cancel
+
+    m_files = filePaths;
+    m_cancelled.storeRelaxed(0);
+    m_running.storeRelease(1);
+    m_tasks.start([this]() { run(); });
+}
+
+void DuplicateFinder::cancel() {
+    m_cancelled.storeRelaxed(1);
+}
+
+void DuplicateFinder::wait() {
+    m_tasks.waitForDone();
+}
+
+std::vector<int> DuplicateFinder::groupRows(const float* matrix, int rows, int dim, float threshold,
+                                            const QAtomicInt* cancel) {
+    UnionFind sets(rows);
+    auto row = [matrix, dim](int r) { return matrix + size_t(r) * size_t(dim); };
+
+    if (rows <= EXACT_TILE_LIMIT) {
+        // Upper triangle in TILE_ROWS x TILE_ROWS blocks: the j tile stays
+        // in cache while every row of the i tile is scored against it
+        for (int i0 = 0; i0 < rows; i0 += TILE_ROWS) {
+            if (isCancelled(cancel)) return {};
+            const int i1 = std::min(i0 + TILE_ROWS, rows);
+            for (int j0 = i0; j0 < rows; j0 += TILE_ROWS) {
+                const int j1 = std::min(j0 + TILE_ROWS, rows);
+                for (int i = i0; i < i1; ++i) {
+                    for (int j = std::max(j0, i + 1); j < j1; ++j) {
+                        if (VectorSearch::dot(row(i), row(j), dim) >= threshold) {
+                            sets.unite(i, j);
+                        }
+                    }
+                }
+            }
+        }
+    } else {
+        HnswIndex graph(dim, row);
+        for (int r = 0; r < rows; ++r) {
+            if (r % 256 == 0 && isCancelled(cancel)) return {};
+            graph.add();
+        }
+        graph.setEfSearch(std::max(HnswIndex::DEFAULT_EF_SEARCH, 2 * ANN_NEIGHBORS));
+
+        for (int r = 0; r < rows; ++r) {
+            if (r % 256 == 0 && isCancelled(cancel)) return {};
+            for (const VectorSearch::Hit& hit : graph.search(row(r), ANN_NEIGHBORS)) {
+                if (hit.score < threshold) break;  // Best first
+                if (hit.id != r) sets.unite(r, hit.id);
+            }
+        }
+    }
+
+    return compactGroups(sets, rows);
+}
+
+std::vector<DuplicateFinder::HashPair> DuplicateFinder::hashPairs(const std::vector<quint64>& hashes,
+                                                                  int maxDistance, const QAtomicInt* cancel) {
+    HammingIndex index;
+    index.reserve(int(hashes.size()));
+    for (quint64 hash : hashes) index.add(hash);
+
+    std::vector<HashPair> pairs;
+    for (int a = 0; a < int(hashes.size()); ++a) {
+        if (a % 1024 == 0 && isCancelled(cancel)) return {};
+        for (const HammingIndex::Hit& hit : index.search(hashes[size_t(a)], maxDistance)) {
+            if (hit.id > a) pairs.push_back(HashPair{a, hit.id, hit.distance});
+        }
+    }
+    return pairs;
+}
+
+QString DuplicateFinder::groupId(const QStringList& memberPaths) {
+    if (memberPaths.isEmpty()) return QString();
+    const QString& anchor = *std::min_element(memberPaths.begin(), memberPaths.end());
+    QByteArray digest = QCryptographicHash::hash(anchor.toUtf8(), QCryptographicHash::Sha1);
+    return "dup-" + QString::fromLatin1(digest.toHex().left(10));
+}
+
+void DuplicateFinder::run() {
+    QStringList paths;
+    std::vector<int> groups;
+    if (m_stages.perceptualHashes) {
+        groupByHash(paths, groups);
+    } else {
+        groupByEmbedding(paths, groups);
+    }
+
+    int groupCount = 0;
+    int duplicates = 0;
+    if (!m_cancelled.loadRelaxed() && int(groups.size()) == paths.size()) {
+        groupCount = writeGroups(paths, groups, &duplicates);
+    }
+
+    bool cancelled = m_cancelled.loadRelaxed() != 0;
+    m_running.storeRelease(0);
+    emit finished(groupCount, duplicates, cancelled);
+}
+
+void DuplicateFinder::groupByHash(QStringList& paths, std::vector<int>& groups) {
+    const int total = m_files.size();
+
+    // 1. Hashes, mostly from the catalog: ingest stored them with the thumbnails
+    std::vector<quint64> hashes;
+    hashes.reserve(size_t(total));
+    for (int start = 0; start < total && !m_cancelled.loadRelaxed(); start += HASH_CHUNK) {
+        const QStringList chunk = m_files.mid(start, HASH_CHUNK);
+        const QHash<QString, quint64> hashed = m_stages.perceptualHashes(chunk);
+        for (const QString& path : chunk) {
+            auto it = hashed.constFind(path);
+            if (it == hashed.cend()) {
+                emit log(QString("⚠️ Failed to load: %1").arg(QFileInfo(path).fileName()));
+                continue;
+            }
+            paths << path;
+            hashes.push_back(it.value());
+        }
+        emit progress(std::min(start + HASH_CHUNK, total), total, "Hashing images");
+    }
+    if (m_cancelled.loadRelaxed()) return;
+
+    // 2. Near-exact pairs join at once; the rest of the close ones are candidates
+    emit log(QString("Comparing %1 image hashes...").arg(paths.size()));
+    emit progress(0, 0, "Grouping near-duplicates...");
+    UnionFind sets(paths.size());
+    std::vector<HashPair> ambiguous;
+    for (const HashPair& pair : hashPairs(hashes, HASH_CANDIDATE_DISTANCE, &m_cancelled)) {
+        if (pair.distance <= HASH_DUPLICATE_DISTANCE) {
+            sets.unite(pair.a, pair.b);
+        } else {
+            ambiguous.push_back(pair);
+        }
+    }
+    if (m_cancelled.loadRelaxed()) return;
+
+    // 3. CLIP only for candidates the hashes didn't already put together
+    ambiguous.erase(std::remove_if(ambiguous.begin(), ambiguous.end(), [&sets](const HashPair& pair) {
+        return sets.find(pair.a) == sets.find(pair.b);
+    }), ambiguous.end());
+    if (!ambiguous.empty() && !m_stages.embed) {
+        emit log(QString("%1 similar pairs left unconfirmed (CLIP not loaded)").arg(ambiguous.size()));
+    } else if (!ambiguous.empty()) {
+        QSet<int> rows;
+        for (const HashPair& pair : ambiguous) {
+            rows.insert(pair.a);
+            rows.insert(pair.b);
+        }
+        QStringList candidates;
+        for (int row : std::as_const(rows)) candidates << paths[row];
+
+        QStringList embeddedPaths;
+        std::vector<std::vector<float>> embeddings;
+        embed(candidates, embeddedPaths, embeddings);
+        if (m_cancelled.loadRelaxed()) return;
+
+        QHash<QString, int> embeddingOf;
+        for (int i = 0; i < embeddedPaths.size(); ++i) embeddingOf.insert(embeddedPaths[i], i);
+        int confirmed = 0;
+        for (const HashPair& pair : ambiguous) {
+            const int a = embeddingOf.value(paths[pair.a], -1);
+            const int b = embeddingOf.value(paths[pair.b], -1);
+            if (a < 0 || b < 0 || embeddings[size_t(a)].size() != embeddings[size_t(b)].size()) continue;
+            if (VectorSearch::dot(embeddings[size_t(a)].data(), embeddings[size_t(b)].data(),
+                                  int(embeddings[size_t(a)].size())) >= m_threshold) {
+                sets.unite(pair.a, pair.b);
+                confirmed++;
+            }
+        }
+        emit log(QString("CLIP confirmed %1 of %2 similar pairs").arg(confirmed).arg(ambiguous.size()));
+    }
+
+    groups = compactGroups(sets, paths.size());
+}
+
+void DuplicateFinder::groupByEmbedding(QStringList& paths, std::vector<int>& groups) {
+    std::vector<std::vector<float>> embeddings;
+    embed(m_files, paths, embeddings);
+
+    // Neighbours above the threshold, merged into groups
+    if (!m_cancelled.loadRelaxed() && !embeddings.empty()) {
+        const int dim = int(embeddings.front().size());
+        std::vector<float> matrix;
+        matrix.reserve(embeddings.size() * size_t(dim));
+        QStringList rowPaths;
+        for (int i = 0; i < int(embeddings.size()); ++i) {
+            if (int(embeddings[size_t(i)].size()) != dim) continue;
+            matrix.insert(matrix.end(), embeddings[size_t(i)].begin(), embeddings[size_t(i)].end());
+            rowPaths << paths[i];
+        }
+        paths = rowPaths;
+        embeddings.clear();
+
+        emit log(QString("Grouping %1 images (similarity ≥ %2)...").arg(paths.size()).arg(m_threshold));
+        emit progress(0, 0, "Grouping near-duplicates...");
+        groups = groupRows(matrix.data(), paths.size(), dim, m_threshold, &m_cancelled);
+    }
+}
+
+void DuplicateFinder::embed(const QStringList& files, QStringList& paths,
+                            std::vector<std::vector<float>>& embeddings) {
+    const int total = files.size();
+
+    // Stored embeddings first, CLIP only for new or changed files
+    QStringList toCompute;
+    for (const QString& path : files) {
+        if (m_stages.cached) {
+            if (auto embedding = m_stages.cached(path)) {
+                paths << path;
+                embeddings.push_back(std::move(*embedding));
+                continue;
+            }
+        }
+        toCompute << path;
+    }
+
+    // Copies of one file need one CLIP pass between them
+    QHash<QString, QStringList> copiesOf;
+    if (m_stages.exactGroups && toCompute.size() > 1) {
+        for (const QStringList& identical : m_stages.exactGroups(toCompute)) {
+            for (int i = 1; i < identical.size(); ++i) {
+                copiesOf[identical.first()] << identical[i];
+                toCompute.removeOne(identical[i]);
+            }
+        }
+    }
+    emit log(QString("Computing embeddings for %1 images (%2 cached)...")
+        .arg(toCompute.size()).arg(paths.size()));
+
+    const ResourceGovernor& governor = ResourceGovernor::instance();
+    for (int start = 0, end = 0; start < toCompute.size() && !m_cancelled.loadRelaxed(); start = end) {
+        governor.waitWhileAIPaused(m_cancelled);
+        if (m_cancelled.loadRelaxed()) break;
+        QStringList batchPaths;
+        std::vector<QImage> images;
+        end = std::min<int>(start + governor.scaledBatchSize(m_batchSize), toCompute.size());
+        for (int i = start; i < end; ++i) {
+            QImage image = m_stages.decode(toCompute[i]);
+            if (image.isNull()) {
+                emit log(QString("⚠️ Failed to load: %1").arg(QFileInfo(toCompute[i]).fileName()));
+                continue;
+            }
+            batchPaths << toCompute[i];
+            images.push_back(std::move(image));
+        }
+
+        std::vector<std::optional<std::vector<float>>> batch;
+        if (!images.empty()) {
+            batch = m_stages.embed(images);
+        }
+        for (int i = 0; i < batchPaths.size(); ++i) {
+            if (size_t(i) >= batch.size() || !batch[size_t(i)] || batch[size_t(i)]->empty()) {
+                emit log(QString("❌ CLIP failed: %1").arg(QFileInfo(batchPaths[i]).fileName()));
+                continue;
+            }
+            for (const QString& copy : copiesOf.value(batchPaths[i])) {
+                if (m_stages.store) {
+                    m_stages.store(copy, *batch[size_t(i)]);
+                }
+                paths << copy;
+                embeddings.push_back(*batch[size_t(i)]);
+            }
+            if (m_stages.store) {
+                m_stages.store(batchPaths[i], *batch[size_t(i)]);
+            }
+            paths << batchPaths[i];
+            embeddings.push_back(std::move(*batch[size_t(i)]));
+        }
+        emit progress(paths.size(), total, "Computing embeddings");
+    }
+}
+
+int DuplicateFinder::writeGroups(const QStringList& paths, const std::vector<int>& groups, int* duplicates) {
+    int groupCount = 0;
+    for (int group : groups) {
+        groupCount = std::max(groupCount, group + 1);
+    }
+    std::vector<QStringList> members(static_cast<size_t>(groupCount));
+    for (int i = 0; i < paths.size(); ++i) {
+        if (groups[size_t(i)] >= 0) members[size_t(groups[size_t(i)])] << paths[i];
+    }
+
+    *duplicates = 0;
+    QStringList ids;
+    for (const QStringList& group : members) {
+        ids << groupId(group);
+        *duplicates += group.size();
+
+        QStringList names;
+        for (const QString& path : group) names << QFileInfo(path).fileName();
+        emit log(QString("🔗 %1 (%2 images): %3").arg(ids.last()).arg(group.size()).arg(names.join(", ")));
+    }
+
+    for (int i = 0; i < paths.size() && !m_cancelled.loadRelaxed(); ++i) {
+        QString group = groups[size_t(i)] >= 0 ? ids[groups[size_t(i)]] : QString();
+        if (m_stages.write && !m_stages.write(paths[i], group)) {
+            emit log(QString("⚠️ Write failed: %1").arg(QFileInfo(paths[i]).fileName()));
+        }
+        emit progress(i + 1, paths.size(), "Writing duplicate groups");
+    }
+    return groupCount;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "core/TaskScheduler.h"
+#include <QObject>
+#include <QImage>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QAtomicInt>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace PhotoGuru {
+
+class CLIPAnalyzer;
+class EmbeddingStore;
+
+/**
+ * @brief Background near-duplicate grouping: perceptual hashes first, CLIP to confirm
+ *
+ *   hashes (catalog, else small decode) -> BK-tree pairs -> union-find -> duplicate_group
+ *                                            \-> ambiguous pairs -> CLIP >= threshold
+ *
+ * With a perceptualHashes stage, pairs whose hashes differ in at most
+ * HASH_DUPLICATE_DISTANCE bits are duplicates outright: copies, resized
+ * or recompressed versions. Pairs up to HASH_CANDIDATE_DISTANCE apart
+ * are ambiguous; only their files are embedded, and a pair joins when its
+ * embeddings agree. Without an embed stage (CLIP not loaded) ambiguous
+ * pairs are left apart, so exact and near-exact duplicates need no model.
+ *
+ * Without a perceptualHashes stage every file is embedded:
+ *
+ *   embeddings (store, else CLIP) -> neighbours >= threshold -> union-find -> duplicate_group
+ *
+ * Up to EXACT_TILE_LIMIT images every pair is compared in cache-sized
+ * tiles of SIMD dot products; past that each image only queries its
+ * ANN_NEIGHBORS nearest neighbours from a temporary HNSW graph, so the
+ * cost grows ~N log N instead of N^2. Neighbour pairs are merged with
+ * union-find, so chains of near-duplicates end up in one group.
+ *
+ * Every compared file's TechnicalMetadata::duplicate_group is brought up to date,
+ * including clearing stale groups. cancel() stops at the next tile, query
+ * or file. Signals are emitted from the worker thread.
+ */
+class DuplicateFinder : public QObject {
+    Q_OBJECT
+
+public:
+    // Stage implementations; defaultStages() wires CLIP/EmbeddingStore/MetadataWriter/FileFingerprint/
+    // PerceptualHash. cached and store may be empty (no embedding store), embed too (hashes only).
+    struct Stages {
+        std::function<QImage(const QString& path)> decode;
+        std::function<std::vector<std::optional<std::vector<float>>>(const std::vector<QImage>&)> embed;
+        std::function<std::optional<std::vector<float>>(const QString& path)> cached;
+        std::function<void(const QString& path, const std::vector<float>& embedding)> store;
+        // group is empty for files that are no longer duplicates
+        std::function<bool(const QString& path, const QString& group)> write;
+        // Byte-identical files among those to embed (optional); each group
+        // is embedded once and the others share the result
+        std::function<QList<QStringList>(const QStringList& paths)> exactGroups;
+        // 64-bit perceptual hashes of the readable files among `paths` (optional);
+        // called with HASH_CHUNK paths at a time
+        std::function<QHash<QString, quint64>(const QStringList& paths)> perceptualHashes;
+    };
+
+    // clip and store must outlive the run; either may be null
+    static Stages defaultStages(CLIPAnalyzer* clip, EmbeddingStore* store);
+
+    explicit DuplicateFinder(Stages stages, QObject* parent = nullptr);
+    ~DuplicateFinder();
+
+    void setThreshold(float threshold) { m_threshold = threshold; }
+    float threshold() const { return m_threshold; }
+    void setBatchSize(int batchSize);
+
+    // Starts in the background; ignored while a run is active
+    void start(const QStringList& filePaths);
+    void cancel();
+    void wait();
+    bool isRunning() const { return m_running.loadAcquire() != 0; }
+
+    /**
+     * @brief Group rows whose dot product is >= threshold (transitively)
+     * @param matrix Row-major, L2-normalized embeddings
+     * @param cancel Polled between tiles / queries; may be null
+     * @return Group index per row, -1 for rows without a duplicate
+     */
+    static std::vector<int> groupRows(const float* matrix, int rows, int dim, float threshold,
+                                      const QAtomicInt* cancel = nullptr);
+
+    struct HashPair {
+        int a;  // a < b
+        int b;
+        int distance;
+    };
+    // Pairs of rows whose hashes differ in at most maxDistance bits
+    static std::vector<HashPair> hashPairs(const std::vector<quint64>& hashes, int maxDistance,
+                                           const QAtomicInt* cancel = nullptr);
+
+    // Stable id for a group: independent of run order and file count
+    static QString groupId(const QStringList& memberPaths);
+
+    static constexpr float DEFAULT_THRESHOLD = 0.95f;
+    static constexpr int EXACT_TILE_LIMIT = 4096;
+    static constexpr int TILE_ROWS = 64;
+    static constexpr int ANN_NEIGHBORS = 32;
+    static constexpr int HASH_DUPLICATE_DISTANCE = 6;
+    static constexpr int HASH_CANDIDATE_DISTANCE = 12;
+    static constexpr int HASH_CHUNK = 256;
+
+signals:
+    void progress(int current, int total, const QString& message);
+    void log(const QString& message);
+    void finished(int groups, int duplicates, bool cancelled);
+
+private:
+    void run();
+    // Rows compared and their group index (-1: none), as groupRows() returns
+    void groupByHash(QStringList& paths, std::vector<int>& groups);
+    void groupByEmbedding(QStringList& paths, std::vector<int>& groups);
+    // Embeddings of `files`, from the store or CLIP, in `paths` order
+    void embed(const QStringList& files, QStringList& paths, std::vector<std::vector<float>>& embeddings);
+    // Writes every path's group (-1: none); returns the number of groups
+    int writeGroups(const QStringList& paths, const std::vector<int>& groups, int* duplicates);
+
+    Stages m_stages;
+    TaskGroup m_tasks{TaskScheduler::AI};
+    QStringList m_files;
+    float m_threshold = DEFAULT_THRESHOLD;
+    int m_batchSize = 16;
+
+    QAtomicInt m_cancelled{0};
+    QAtomicInt m_running{0};
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,310 @@
+#include "FaceAnalyzer.h"
+#include "core/Trace.h"
+#include <QPainter>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace PhotoGuru {
+
+namespace {
+
+// Where ArcFace's training crops put the five landmarks, in EMBEDDER_SIZE pixels
+constexpr double ARCFACE_TEMPLATE[5][2] = {
+    {38.2946, 51.6963}, {73.5318, 51.5014}, {56.0252, 71.7366}, {41.5493, 92.3655}, {70.7299, 92.2041},
+};
+
+constexpr int LETTERBOX_GRAY = 114;  // The padding YOLO models are trained with
+
+float overlap(const QRectF& a, const QRectF& b) {
+    const QRectF both = a.intersected(b);
+    const double shared = both.width() * both.height();
+    const double total = a.width() * a.height() + b.width() * b.height() - shared;
+    return total > 0.0 ? float(shared / total) : 0.0f;
+}
+
+void normalize(std::vector<float>& v) {
+    float norm = 0.0f;
+    for (float x : v) norm += x * x;
+    norm = std::sqrt(norm);
+    if (norm > 0.0f) {
+        for (float& x : v) x /= norm;
+    }
+}
+
+} // namespace
+
+FaceAnalyzer::FaceAnalyzer()
+    : m_detector(std::make_unique<ONNXInference>())
+    , m_embedder(std::make_unique<ONNXInference>())
+{
+}
+
+FaceAnalyzer::~FaceAnalyzer() = default;
+
+bool FaceAnalyzer::initialize(const QString& detectorPath, const QString& embedderPath, bool useGPU) {
+    qDebug() << "[Faces] Initializing with models:" << detectorPath << embedderPath;
+    m_initialized = false;
+
+    if (!m_detector->loadModel(detectorPath, useGPU)) {
+        m_lastError = "Failed to load face detector: " + m_detector->lastError();
+        qWarning() << "[Faces]" << m_lastError;
+        return false;
+    }
+    if (!m_embedder->loadModel(embedderPath, useGPU)) {
+        m_lastError = "Failed to load face embedder: " + m_embedder->lastError();
+        qWarning() << "[Faces]" << m_lastError;
+        return false;
+    }
+
+    // Letterboxing needs a fixed square input
+    std::vector<int64_t> input = m_detector->getInputShape();
+    if (input.size() < 4 || input[2] <= 0 || input[2] != input[3]) {
+        m_lastError = "Face detector needs a fixed square input";
+        qWarning() << "[Faces]" << m_lastError;
+        return false;
+    }
+    std::vector<int64_t> crop = m_embedder->getInputShape();
+    if (crop.size() < 4 || crop[2] != EMBEDDER_SIZE || crop[3] != EMBEDDER_SIZE) {
+        m_lastError = QString("Face embedder needs %1x%1 input").arg(EMBEDDER_SIZE);
+        qWarning() << "[Faces]" << m_lastError;
+        return false;
+    }
+
+    m_initialized = true;
+    qDebug() << "[Faces] Initialized, detector input" << input[2] << "x" << input[3];
+    return true;
+}
+
+void FaceAnalyzer::setBatchSize(int batchSize) {
+    m_batchSize = std::clamp(batchSize, 1, MAX_BATCH_SIZE);
+}
+
+std::vector<std::vector<FaceAnalyzer::Face>> FaceAnalyzer::analyze(const std::vector<QImage>& images) {
+    if (!m_initialized) {
+        m_lastError = "Face analyzer not initialized";
+        return {};
+    }
+    std::vector<std::vector<Face>> faces(images.size());
+    if (!detect(images, faces)) return {};
+
+    // Every face big enough to recognize, aligned onto the template
+    struct Ref { size_t image; size_t face; };
+    std::vector<Ref> refs;
+    std::vector<QImage> crops;
+    {
+        TRACE_SCOPE("faces.align");
+        for (size_t i = 0; i < images.size(); ++i) {
+            for (size_t j = 0; j < faces[i].size(); ++j) {
+                const Face& face = faces[i][j];
+                if (std::min(face.box.width(), face.box.height()) < MIN_FACE_EDGE) continue;
+
+                QImage crop(EMBEDDER_SIZE, EMBEDDER_SIZE, QImage::Format_RGB32);
+                crop.fill(Qt::black);
+                QPainter painter(&crop);
+                painter.setRenderHint(QPainter::SmoothPixmapTransform);
+                painter.setTransform(alignment(face.landmarks, face.box));
+                painter.drawImage(0, 0, images[i]);
+                painter.end();
+
+                refs.push_back({i, j});
+                crops.push_back(std::move(crop));
+            }
+        }
+    }
+
+    std::vector<std::vector<float>> embeddings;
+    if (!crops.empty() && embed(crops, embeddings)) {
+        for (size_t k = 0; k < refs.size() && k < embeddings.size(); ++k) {
+            faces[refs[k].image][refs[k].face].embedding = std::move(embeddings[k]);
+        }
+    }
+
+    // Image pixels -> fractions, so the caller's decode size doesn't matter
+    for (size_t i = 0; i < images.size(); ++i) {
+        const double width = images[i].width();
+        const double height = images[i].height();
+        for (Face& face : faces[i]) {
+            face.box = QRectF(face.box.x() / width, face.box.y() / height,
+                              face.box.width() / width, face.box.height() / height);
+            for (QPointF& point : face.landmarks) point = QPointF(point.x() / width, point.y() / height);
+        }
+    }
+    return faces;
+}
+
+bool FaceAnalyzer::detect(const std::vector<QImage>& images, std::vector<std::vector<Face>>& faces) {
+    const int size = int(m_detector->getInputShape()[2]);
+    const size_t sampleSize = m_detector->sampleSize();
+
+    std::vector<float> batch;
+    std::vector<size_t> indices;
+    std::vector<double> scales;  // Detector pixels per image pixel
+    batch.reserve(sampleSize * size_t(m_batchSize));
+
+    auto flush = [&]() -> bool {
+        if (indices.empty()) return true;
+        const int count = int(indices.size());
+        std::optional<std::vector<float>> output;
+        {
+            TRACE_SCOPE("faces.detect_batch");
+            output = m_detector->runBatch(batch, count);
+        }
+        if (!output || output->size() % (size_t(count) * DETECTOR_CHANNELS) != 0) {
+            m_lastError = "Face detection failed: " + m_detector->lastError();
+            qWarning() << "[Faces]" << m_lastError;
+            return false;
+        }
+        const size_t perImage = output->size() / size_t(count);
+        const int anchors = int(perImage / DETECTOR_CHANNELS);
+        for (int k = 0; k < count; ++k) {
+            std::vector<Face> found = suppress(
+                decodeDetections(output->data() + size_t(k) * perImage, anchors, SCORE_THRESHOLD),
+                NMS_IOU, MAX_FACES);
+            const double scale = scales[size_t(k)];
+            for (Face& face : found) {
+                face.box = QRectF(face.box.topLeft() / scale, face.box.size() / scale);
+                for (QPointF& point : face.landmarks) point /= scale;
+            }
+            faces[indices[size_t(k)]] = std::move(found);
+        }
+        batch.clear();
+        indices.clear();
+        scales.clear();
+        return true;
+    };
+
+    for (size_t i = 0; i < images.size(); ++i) {
+        const QImage& image = images[i];
+        if (image.isNull()) continue;
+
+        // Letterboxed into the top-left corner, so mapping back is a scale
+        const double scale = double(size) / std::max(image.width(), image.height());
+        QImage input(size, size, QImage::Format_RGB32);
+        input.fill(QColor(LETTERBOX_GRAY, LETTERBOX_GRAY, LETTERBOX_GRAY));
+        {
+            QPainter painter(&input);
+            painter.setRenderHint(QPainter::SmoothPixmapTransform);
+            painter.drawImage(QRectF(0, 0, image.width() * scale, image.height() * scale), image);
+        }
+
+        const size_t offset = batch.size();
+        batch.resize(offset + sampleSize);
+        if (!m_detector->preprocessImageInto(input, batch.data() + offset, {}, {})) {
+            batch.resize(offset);
+            continue;
+        }
+        indices.push_back(i);
+        scales.push_back(scale);
+        if (int(indices.size()) == m_batchSize && !flush()) return false;
+    }
+    return flush();
+}
+
+bool FaceAnalyzer::embed(const std::vector<QImage>& crops, std::vector<std::vector<float>>& embeddings) {
+    const std::vector<float> mean = {0.5f, 0.5f, 0.5f};
+    const std::vector<float> std = {0.5f, 0.5f, 0.5f};
+    const size_t sampleSize = m_embedder->sampleSize();
+
+    std::vector<float> batch;
+    batch.reserve(sampleSize * size_t(m_batchSize));
+    for (size_t start = 0; start < crops.size(); start += size_t(m_batchSize)) {
+        const size_t end = std::min(crops.size(), start + size_t(m_batchSize));
+        batch.assign(sampleSize * (end - start), 0.0f);
+        for (size_t i = start; i < end; ++i) {
+            m_embedder->preprocessImageInto(crops[i], batch.data() + (i - start) * sampleSize, mean, std);
+        }
+
+        std::optional<std::vector<float>> output;
+        {
+            TRACE_SCOPE("faces.embed_batch");
+            output = m_embedder->runBatch(batch, int(end - start));
+        }
+        if (!output || output->empty() || output->size() % (end - start) != 0) {
+            m_lastError = "Face embedding failed: " + m_embedder->lastError();
+            qWarning() << "[Faces]" << m_lastError;
+            return false;
+        }
+        const size_t dim = output->size() / (end - start);
+        for (size_t i = 0; i < end - start; ++i) {
+            std::vector<float> embedding(output->begin() + i * dim, output->begin() + (i + 1) * dim);
+            normalize(embedding);
+            embeddings.push_back(std::move(embedding));
+        }
+    }
+    return true;
+}
+
+std::vector<FaceAnalyzer::Face> FaceAnalyzer::decodeDetections(const float* output, int anchors,
+                                                               float scoreThreshold) {
+    std::vector<Face> faces;
+    auto value = [output, anchors](int channel, int anchor) { return output[size_t(channel) * anchors + anchor]; };
+    for (int a = 0; a < anchors; ++a) {
+        const float score = value(4, a);
+        if (score < scoreThreshold) continue;
+
+        Face face;
+        const float width = value(2, a);
+        const float height = value(3, a);
+        face.box = QRectF(value(0, a) - width / 2, value(1, a) - height / 2, width, height);
+        face.score = score;
+        for (int k = 0; k < 5; ++k) {
+            face.landmarks[size_t(k)] = QPointF(value(5 + 3 * k, a), value(6 + 3 * k, a));
+        }
+        faces.push_back(std::move(face));
+    }
+    std::sort(faces.begin(), faces.end(), [](const Face& a, const Face& b) { return a.score > b.score; });
+    return faces;
+}
+
+std::vector<FaceAnalyzer::Face> FaceAnalyzer::suppress(std::vector<Face> faces, float iouThreshold, int maxFaces) {
+    std::sort(faces.begin(), faces.end(), [](const Face& a, const Face& b) { return a.score > b.score; });
+    std::vector<Face> kept;
+    for (Face& face : faces) {
+        if (int(kept.size()) >= maxFaces) break;
+        bool covered = std::any_of(kept.begin(), kept.end(), [&face, iouThreshold](const Face& better) {
+            return overlap(face.box, better.box) > iouThreshold;
+        });
+        if (!covered) kept.push_back(std::move(face));
+    }
+    return kept;
+}
+
+QTransform FaceAnalyzer::alignment(const std::array<QPointF, 5>& landmarks, const QRectF& box) {
+    // Least-squares similarity (scale, rotation, shift) taking the landmarks onto the template
+    QPointF from;
+    QPointF to;
+    for (size_t k = 0; k < 5; ++k) {
+        from += landmarks[k];
+        to += QPointF(ARCFACE_TEMPLATE[k][0], ARCFACE_TEMPLATE[k][1]);
+    }
+    from /= 5.0;
+    to /= 5.0;
+
+    double spread = 0.0;
+    double a = 0.0;
+    double b = 0.0;
+    for (size_t k = 0; k < 5; ++k) {
+        const QPointF p = landmarks[k] - from;
+        const QPointF q = QPointF(ARCFACE_TEMPLATE[k][0], ARCFACE_TEMPLATE[k][1]) - to;
+        spread += p.x() * p.x() + p.y() * p.y();
+        a += p.x() * q.x() + p.y() * q.y();
+        b += p.x() * q.y() - p.y() * q.x();
+    }
+
+    // No usable landmarks: the box's centred square fills the crop
+    if (spread < 1.0) {
+        const double scale = EMBEDDER_SIZE / std::max(1.0, std::max(box.width(), box.height()));
+        const QPointF centre = box.center() * scale;
+        return QTransform(scale, 0, 0, scale, EMBEDDER_SIZE / 2.0 - centre.x(), EMBEDDER_SIZE / 2.0 - centre.y());
+    }
+
+    a /= spread;
+    b /= spread;
+    // x' = a x - b y + dx, y' = b x + a y + dy
+    const double dx = to.x() - (a * from.x() - b * from.y());
+    const double dy = to.y() - (b * from.x() + a * from.y());
+    return QTransform(a, b, -b, a, dx, dy);
+}
+
+} // namespace PhotoGuru
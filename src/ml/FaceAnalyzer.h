@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ONNXInference.h"
+#include <QImage>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QTransform>
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Face detection and face embeddings on ONNX Runtime
+ *
+ * Two models, both run in batches through ONNXInference:
+ *   detector - YOLOv8-face: a letterboxed RGB square (640x640 as usually
+ *              exported; the size is read from the model) in [0, 1]; output
+ *              [batch, 5 + 15, anchors] holding per anchor the box centre
+ *              and size, a score, and five landmarks (x, y, visibility)
+ *   embedder - ArcFace: a 112x112 RGB crop, (x - 127.5) / 127.5; a
+ *              512-d identity embedding
+ *
+ * Each face is warped onto ArcFace's landmark template with a similarity
+ * transform before it is embedded, so embeddings of one person compare
+ * across pose and scale. Faces under MIN_FACE_EDGE pixels in the analyzed
+ * image are counted but not embedded: too few pixels to tell people apart.
+ *
+ * Give analyze() an image bounded to ANALYSIS_EDGE; the detector sees
+ * it scaled to its input, the crops come from the image itself.
+ * Not thread-safe; callers serialize, as with CLIPAnalyzer.
+ */
+class FaceAnalyzer {
+public:
+    struct Face {
+        QRectF box;                        // Fraction of the image (0..1), whatever size was decoded
+        float score = 0.0f;
+        std::array<QPointF, 5> landmarks;  // Same units: eyes, nose tip, mouth corners
+        std::vector<float> embedding;      // L2-normalized; empty for faces too small to embed
+    };
+
+    FaceAnalyzer();
+    ~FaceAnalyzer();
+
+    /**
+     * @brief Load both models
+     * @param detectorPath YOLOv8-face .onnx
+     * @param embedderPath ArcFace .onnx
+     */
+    bool initialize(const QString& detectorPath, const QString& embedderPath, bool useGPU = true);
+    bool isInitialized() const { return m_initialized; }
+    QString lastError() const { return m_lastError; }
+
+    /**
+     * @brief Faces in each image, batchSize() images per detector run
+     *
+     * Crops of every image's faces are then embedded batchSize() at a time.
+     * @return One list per image, in order (none for null images); empty on error
+     */
+    std::vector<std::vector<Face>> analyze(const std::vector<QImage>& images);
+
+    // Images per detector run, crops per embedder run (clamped to 1-MAX_BATCH_SIZE)
+    void setBatchSize(int batchSize);
+    int batchSize() const { return m_batchSize; }
+
+    /**
+     * @brief Faces from one image's detector output, in input pixels
+     * @param output (5 + 15) x anchors floats, channel-major
+     * @return Faces scoring at least scoreThreshold, best first, overlaps not yet removed
+     */
+    static std::vector<Face> decodeDetections(const float* output, int anchors, float scoreThreshold);
+
+    // Drops faces overlapping a better one by more than iouThreshold; keeps at most maxFaces
+    static std::vector<Face> suppress(std::vector<Face> faces, float iouThreshold, int maxFaces);
+
+    // Image pixels -> the EMBEDDER_SIZE crop ArcFace expects, fitted to the landmarks
+    static QTransform alignment(const std::array<QPointF, 5>& landmarks, const QRectF& box);
+
+    static constexpr int ANALYSIS_EDGE = 1280;
+    static constexpr int EMBEDDER_SIZE = 112;
+    static constexpr float SCORE_THRESHOLD = 0.5f;
+    static constexpr float NMS_IOU = 0.4f;
+    static constexpr int MAX_FACES = 32;       // Per image
+    static constexpr int MIN_FACE_EDGE = 24;
+    static constexpr int DEFAULT_BATCH_SIZE = 8;
+    static constexpr int MAX_BATCH_SIZE = 32;
+
+private:
+    // Detections of `images` in image pixels
+    bool detect(const std::vector<QImage>& images, std::vector<std::vector<Face>>& faces);
+    bool embed(const std::vector<QImage>& crops, std::vector<std::vector<float>>& embeddings);
+
+    std::unique_ptr<ONNXInference> m_detector;
+    std::unique_ptr<ONNXInference> m_embedder;
+    bool m_initialized = false;
+    QString m_lastError;
+    int m_batchSize = DEFAULT_BATCH_SIZE;
+
+    static constexpr int DETECTOR_CHANNELS = 5 + 15;
+};
+
+} // namespace PhotoGuru
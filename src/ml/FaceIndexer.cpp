@@ -0,0 +1,338 @@
+#include "FaceIndexer.h"
+#include "HnswIndex.h"
+#include "VectorSearch.h"
+#include "core/DecodeContext.h"
+#include "core/ResourceGovernor.h"
+#include "core/Trace.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+
+namespace PhotoGuru {
+
+FaceIndexer::Stages FaceIndexer::defaultStages(FaceAnalyzer* faces) {
+    Stages stages;
+
+    stages.decode = [](const QString& path) {
+        return DecodeContext(path, FaceAnalyzer::ANALYSIS_EDGE).fitted(FaceAnalyzer::ANALYSIS_EDGE);
+    };
+
+    stages.analyze = [faces](const std::vector<QImage>& images) {
+        return faces->analyze(images);
+    };
+
+    stages.scanned = [](const QStringList& paths) {
+        const QHash<QString, int> counts = PhotoDatabase::instance().freshFaceCounts(paths);
+        QSet<QString> result;
+        for (auto it = counts.cbegin(); it != counts.cend(); ++it) result.insert(it.key());
+        return result;
+    };
+
+    stages.store = &FaceIndexer::storeFaces;
+
+    stages.cluster = []() {
+        return clusterCatalog(PhotoDatabase::instance(), PERSON_THRESHOLD);
+    };
+
+    stages.write = [](const QStringList& paths) {
+        PhotoDatabase::instance().refreshFaceMetadata(paths);
+    };
+
+    return stages;
+}
+
+bool FaceIndexer::storeFaces(const QString& path, const std::vector<FaceAnalyzer::Face>& found) {
+    QFileInfo info(path);
+    if (!info.exists()) return false;
+
+    std::vector<PhotoDatabase::Face> faces;
+    faces.reserve(found.size());
+    for (const FaceAnalyzer::Face& face : found) {
+        PhotoDatabase::Face stored;
+        stored.path = path;
+        stored.box = face.box;
+        stored.score = face.score;
+        stored.embedding = face.embedding;
+        faces.push_back(std::move(stored));
+    }
+    return PhotoDatabase::instance().storeFaces(path, info.lastModified().toMSecsSinceEpoch(), info.size(), faces);
+}
+
+FaceIndexer::FaceIndexer(Stages stages, QObject* parent)
+    : QObject(parent)
+    , m_stages(std::move(stages))
+    , m_decoded(2 * FaceAnalyzer::MAX_BATCH_SIZE)
+{
+    m_decodeThreads = std::max(2, QThread::idealThreadCount() / 2);
+}
+
+FaceIndexer::~FaceIndexer() {
+    cancel();
+    wait();
+}
+
+void FaceIndexer::setBatchSize(int batchSize) {
+    m_batchSize = std::clamp(batchSize, 1, FaceAnalyzer::MAX_BATCH_SIZE);
+}
+
+void FaceIndexer::setDecodeThreads(int threads) {
+    m_decodeThreads = std::max(1, threads);
+}
+
+void FaceIndexer::start(const QStringList& filePaths) {
+    if (isRunning()) return;
+    wait();  // Previous run may still be unwinding after cancel
+
+    m_cancelled.storeRelaxed(0);
+    m_failed.storeRelaxed(0);
+    m_decoded.reset();
+    m_running.storeRelease(1);
+
+    // The run itself plus the decoders it starts
+    const int decoders = ResourceGovernor::instance().scaledThreadCount(m_decodeThreads);
+    m_tasks.setMaxConcurrency(decoders + 1);
+    m_tasks.start([this, filePaths]() { run(filePaths); });
+}
+
+void FaceIndexer::cancel() {
+    m_cancelled.storeRelaxed(1);
+    m_decoded.abort();
+}
+
+void FaceIndexer::wait() {
+    m_tasks.waitForDone();
+}
+
+void FaceIndexer::run(QStringList filePaths) {
+    // Only files changed or added since their last scan are decoded
+    QStringList pending;
+    if (m_stages.scanned) {
+        for (int start = 0; start < filePaths.size() && !m_cancelled.loadRelaxed(); start += SCAN_LOOKUP_CHUNK) {
+            const QStringList chunk = filePaths.mid(start, SCAN_LOOKUP_CHUNK);
+            const QSet<QString> scanned = m_stages.scanned(chunk);
+            for (const QString& path : chunk) {
+                if (!scanned.contains(path)) pending << path;
+            }
+        }
+    } else {
+        pending = filePaths;
+    }
+    emit log(QString("Scanning %1 images for faces (%2 already scanned)...")
+        .arg(pending.size()).arg(filePaths.size() - pending.size()));
+
+    m_files = pending;
+    m_nextFile.storeRelaxed(0);
+    const int decoders = std::min<int>(m_tasks.maxConcurrency() - 1, std::max<int>(1, pending.size()));
+    if (pending.isEmpty() || m_cancelled.loadRelaxed()) {
+        m_decoded.close();
+    } else {
+        for (int i = 0; i < decoders; ++i) {
+            m_tasks.start([this]() { runDecoder(); });
+        }
+    }
+
+    int scanned = 0;
+    int faces = 0;
+    runAnalyzer(&scanned, &faces);
+
+    // New faces join people; the photos they are in carry the result
+    QStringList changed;
+    if (!m_cancelled.loadRelaxed() && m_stages.cluster) {
+        emit log("Grouping faces into people...");
+        TRACE_SCOPE("faces.cluster");
+        changed = m_stages.cluster();
+        if (m_stages.write && !changed.isEmpty()) m_stages.write(changed);
+    }
+
+    bool cancelled = m_cancelled.loadRelaxed() != 0;
+    m_running.storeRelease(0);
+    emit finished(scanned, faces, changed.size(), cancelled);
+}
+
+std::optional<FaceIndexer::Decoded> FaceIndexer::decodeNext(bool* exhausted) {
+    *exhausted = false;
+    ResourceGovernor::instance().waitWhileAIPaused(m_cancelled);
+    const int index = m_cancelled.loadRelaxed() ? m_files.size() : m_nextFile.fetchAndAddRelaxed(1);
+    if (index >= m_files.size()) {
+        *exhausted = true;
+        return std::nullopt;
+    }
+
+    const QString& path = m_files[index];
+    QImage image;
+    {
+        TRACE_SCOPE("faces.decode");
+        image = m_stages.decode(path);
+    }
+    if (image.isNull()) {
+        m_failed.fetchAndAddRelaxed(1);
+        emit log(QString("⚠️ Failed to load: %1").arg(QFileInfo(path).fileName()));
+        return std::nullopt;
+    }
+    return Decoded{path, std::move(image)};
+}
+
+void FaceIndexer::runDecoder() {
+    // Counted before taking a file, so a zero count with every file
+    // taken means none is still being decoded
+    {
+        QMutexLocker locker(&m_decoderMutex);
+        ++m_activeDecoders;
+    }
+    for (;;) {
+        bool exhausted = false;
+        std::optional<Decoded> item = decodeNext(&exhausted);
+        if (exhausted) break;
+        if (item && !m_decoded.push(std::move(*item))) break;
+    }
+
+    // Last decoder out ends the stream
+    QMutexLocker locker(&m_decoderMutex);
+    if (--m_activeDecoders == 0) m_decoded.close();
+}
+
+void FaceIndexer::runAnalyzer(int* scanned, int* faces) {
+    std::vector<Decoded> items;
+    std::vector<QImage> images;
+    const int total = m_files.size();
+
+    auto flush = [&]() {
+        if (images.empty() || m_cancelled.loadRelaxed()) return;
+
+        std::vector<std::vector<FaceAnalyzer::Face>> found = m_stages.analyze(images);
+        for (size_t i = 0; i < items.size(); ++i) {
+            // A short result is a failed batch: those files stay unscanned
+            if (i >= found.size()) {
+                m_failed.fetchAndAddRelaxed(1);
+                continue;
+            }
+            if (m_stages.store && !m_stages.store(items[i].path, found[i])) {
+                emit log(QString("⚠️ Could not store faces of %1").arg(QFileInfo(items[i].path).fileName()));
+                m_failed.fetchAndAddRelaxed(1);
+                continue;
+            }
+            ++*scanned;
+            *faces += int(found[i].size());
+        }
+        emit progress(*scanned + m_failed.loadRelaxed(), total, "Finding faces");
+        items.clear();
+        images.clear();
+    };
+
+    const ResourceGovernor& governor = ResourceGovernor::instance();
+    for (;;) {
+        std::optional<Decoded> item = m_decoded.tryPop();
+        if (!item) {
+            // Nothing ready: decode here rather than wait on a decoder
+            // that may still be queued behind other work
+            bool exhausted = false;
+            item = decodeNext(&exhausted);
+            if (!item && !exhausted) continue;
+        }
+        if (!item) {
+            // Every file is taken; only running decoders can add more
+            {
+                QMutexLocker locker(&m_decoderMutex);
+                if (m_activeDecoders == 0) m_decoded.close();
+            }
+            item = m_decoded.pop();
+            if (!item) break;
+        }
+        images.push_back(item->image);
+        items.push_back(std::move(*item));
+        if (int(images.size()) >= governor.scaledBatchSize(m_batchSize)) {
+            flush();
+        }
+    }
+    flush();
+}
+
+std::vector<int> FaceIndexer::assignPeople(std::vector<PhotoDatabase::Person>& people,
+                                           const std::vector<std::vector<float>>& embeddings, float threshold) {
+    std::vector<int> assigned(embeddings.size(), -1);
+
+    int dim = 0;
+    for (const PhotoDatabase::Person& person : people) {
+        if (!person.centroid.empty()) {
+            dim = int(person.centroid.size());
+            break;
+        }
+    }
+    for (size_t i = 0; dim == 0 && i < embeddings.size(); ++i) dim = int(embeddings[i].size());
+    if (dim == 0) return assigned;
+
+    // Graph ids are nodes; people of another dimension never become one
+    std::vector<int> personOfNode;
+    HnswIndex index(dim, [&people, &personOfNode](int node) {
+        return people[size_t(personOfNode[size_t(node)])].centroid.data();
+    });
+    for (int p = 0; p < int(people.size()); ++p) {
+        if (int(people[size_t(p)].centroid.size()) != dim) continue;
+        personOfNode.push_back(p);
+        index.add();
+    }
+
+    for (size_t i = 0; i < embeddings.size(); ++i) {
+        const std::vector<float>& embedding = embeddings[i];
+        if (int(embedding.size()) != dim) continue;
+
+        std::vector<VectorSearch::Hit> nearest = index.search(embedding.data(), 1);
+        if (!nearest.empty() && nearest.front().score >= threshold) {
+            const int p = personOfNode[size_t(nearest.front().id)];
+            PhotoDatabase::Person& person = people[size_t(p)];
+
+            // Running mean of the faces' directions, kept at unit length
+            float norm = 0.0f;
+            for (int d = 0; d < dim; ++d) {
+                float& value = person.centroid[size_t(d)];
+                value = value * float(person.faces) + embedding[size_t(d)];
+                norm += value * value;
+            }
+            norm = std::sqrt(norm);
+            if (norm > 0.0f) {
+                for (float& value : person.centroid) value /= norm;
+            }
+            ++person.faces;
+            assigned[i] = p;
+            continue;
+        }
+
+        people.push_back(PhotoDatabase::Person{0, embedding, 1});
+        personOfNode.push_back(int(people.size()) - 1);
+        index.add();
+        assigned[i] = int(people.size()) - 1;
+    }
+    return assigned;
+}
+
+QStringList FaceIndexer::clusterCatalog(PhotoDatabase& catalog, float threshold, const QAtomicInt* cancel) {
+    std::vector<PhotoDatabase::Person> people = catalog.people();
+    QSet<QString> changed;
+    QStringList order;
+
+    while (!(cancel && cancel->loadRelaxed())) {
+        std::vector<PhotoDatabase::Face> faces = catalog.unclusteredFaces(CLUSTER_CHUNK);
+        if (faces.empty()) break;
+
+        std::vector<std::vector<float>> embeddings;
+        embeddings.reserve(faces.size());
+        for (const PhotoDatabase::Face& face : faces) embeddings.push_back(face.embedding);
+        std::vector<int> assigned = assignPeople(people, embeddings, threshold);
+
+        // Faces that can't join anyone (-1) are set aside, so the next chunk moves on
+        QHash<qint64, int> personOfFace;
+        for (size_t i = 0; i < faces.size(); ++i) {
+            personOfFace.insert(faces[i].id, assigned[i]);
+            if (assigned[i] >= 0 && !changed.contains(faces[i].path)) {
+                changed.insert(faces[i].path);
+                order << faces[i].path;
+            }
+        }
+        if (!catalog.storePeople(people, personOfFace)) break;
+    }
+    return order;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "FaceAnalyzer.h"
+#include "core/BoundedQueue.h"
+#include "core/PhotoDatabase.h"
+#include "core/TaskScheduler.h"
+#include <QObject>
+#include <QImage>
+#include <QStringList>
+#include <QSet>
+#include <QMutex>
+#include <QAtomicInt>
+#include <functional>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Background, incremental face scan: faces into the catalog, then people
+ *
+ *   unscanned files -> decode pool -> [queue] -> batched detect + embed -> catalog
+ *   unclustered faces -> nearest person (HNSW over centroids) -> catalog -> person keys
+ *
+ * Only files without a current scan in the catalog are decoded, so a
+ * second run over a 100k-image library costs one catalog lookup per file;
+ * AnalysisPipeline records scans too, from the decode it already has.
+ * Clustering likewise takes only faces no person has yet, CLUSTER_CHUNK
+ * at a time: each joins the person whose centroid is nearest if they are
+ * at least PERSON_THRESHOLD alike, and starts a new person otherwise.
+ * Photos then carry their people as SKP person keys, and their face
+ * count, in the catalog. The files themselves are not written: that would
+ * change their mtime and make every scan stale.
+ *
+ * The run and its decoders are AI tasks on the TaskScheduler. Nothing
+ * waits on a decoder that hasn't got a worker: when the queue is empty
+ * the run decodes the next file itself, and once every file is taken it
+ * waits only on decoders that are running.
+ *
+ * Decoding is held while the ResourceGovernor pauses AI work. cancel()
+ * stops after the batch in progress; scans already stored are kept.
+ * Signals are emitted from worker threads.
+ */
+class FaceIndexer : public QObject {
+    Q_OBJECT
+
+public:
+    // Stage implementations; defaultStages() wires ImageLoader/FaceAnalyzer/PhotoDatabase.
+    // scanned, cluster and write may be empty.
+    struct Stages {
+        // Bounded to FaceAnalyzer::ANALYSIS_EDGE (null: the file failed to decode)
+        std::function<QImage(const QString& path)> decode;
+        std::function<std::vector<std::vector<FaceAnalyzer::Face>>(const std::vector<QImage>&)> analyze;
+        // Files among `paths` whose scan is still current
+        std::function<QSet<QString>(const QStringList& paths)> scanned;
+        std::function<bool(const QString& path, const std::vector<FaceAnalyzer::Face>& faces)> store;
+        // Assigns unclustered faces to people; returns the photos whose people changed
+        std::function<QStringList()> cluster;
+        // Brings the photos' face counts and person keys up to date
+        std::function<void(const QStringList& paths)> write;
+    };
+
+    // faces must outlive the run
+    static Stages defaultStages(FaceAnalyzer* faces);
+
+    explicit FaceIndexer(Stages stages, QObject* parent = nullptr);
+    ~FaceIndexer();
+
+    void setBatchSize(int batchSize);
+    void setDecodeThreads(int threads);
+
+    // Starts in the background; ignored while a run is active
+    void start(const QStringList& filePaths);
+    void cancel();
+    void wait();
+    bool isRunning() const { return m_running.loadAcquire() != 0; }
+
+    /**
+     * @brief Index into `people` of the person each embedding joins
+     *
+     * Embeddings are taken in order: one at least `threshold` alike to its
+     * nearest centroid joins that person and moves the centroid towards
+     * it; otherwise it starts a new person (id 0), appended to `people`.
+     * -1 for embeddings of another dimension than the centroids.
+     */
+    static std::vector<int> assignPeople(std::vector<PhotoDatabase::Person>& people,
+                                         const std::vector<std::vector<float>>& embeddings, float threshold);
+
+    // Records a scan of the file as it is on disk now, in the catalog
+    static bool storeFaces(const QString& path, const std::vector<FaceAnalyzer::Face>& faces);
+
+    // Clusters the catalog's unclustered faces; the photos whose people changed
+    static QStringList clusterCatalog(PhotoDatabase& catalog, float threshold, const QAtomicInt* cancel = nullptr);
+
+    static constexpr float PERSON_THRESHOLD = 0.5f;  // ArcFace cosine similarity
+    static constexpr int CLUSTER_CHUNK = 4096;
+    static constexpr int SCAN_LOOKUP_CHUNK = 1024;
+
+signals:
+    void progress(int current, int total, const QString& message);
+    void log(const QString& message);
+    void finished(int scanned, int faces, int photosUpdated, bool cancelled);
+
+private:
+    struct Decoded {
+        QString path;
+        QImage image;
+    };
+
+    void run(QStringList filePaths);
+    void runDecoder();
+    // Next file decoded; nullopt with `exhausted` set once none are left (or cancelled)
+    std::optional<Decoded> decodeNext(bool* exhausted);
+    // Batches decoded files through analyze and store
+    void runAnalyzer(int* scanned, int* faces);
+
+    Stages m_stages;
+
+    QStringList m_files;  // Without a current scan
+    QAtomicInt m_nextFile{0};
+    QMutex m_decoderMutex;
+    int m_activeDecoders = 0;  // Running, not just queued; under m_decoderMutex
+    QAtomicInt m_failed{0};
+    QAtomicInt m_cancelled{0};
+    QAtomicInt m_running{0};
+
+    BoundedQueue<Decoded> m_decoded;
+
+    int m_batchSize = FaceAnalyzer::DEFAULT_BATCH_SIZE;
+    int m_decodeThreads = 2;
+
+    TaskGroup m_tasks{TaskScheduler::AI};  // Last: waits for the run before the rest goes
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,370 @@
+#include "HnswIndex.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <queue>
+
+namespace PhotoGuru {
+
+namespace {
+
+constexpr char INDEX_MAGIC[8] = {'P', 'G', 'H', 'N', 'S', 'W', '0', '1'};
+constexpr quint32 INDEX_VERSION = 1;
+
+struct IndexHeader {
+    char magic[8];
+    quint32 version;
+    quint32 dimension;
+    quint32 M;
+    quint32 efConstruction;
+    quint32 count;
+    qint32 entryPoint;
+    qint32 maxLevel;
+    quint64 tag;
+};
+
+template <typename T>
+void appendValue(QByteArray& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readValue(const QByteArray& in, qint64& offset, T& value) {
+    if (offset + qint64(sizeof(T)) > in.size()) return false;
+    std::memcpy(&value, in.constData() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+bool byScoreDesc(const std::pair<float, int>& a, const std::pair<float, int>& b) {
+    return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+} // namespace
+
+HnswIndex::HnswIndex(int dimension, VectorSource source)
+    : HnswIndex(dimension, std::move(source), Params())
+{
+}
+
+HnswIndex::HnswIndex(int dimension, VectorSource source, Params params)
+    : m_dimension(dimension)
+    , m_source(std::move(source))
+    , m_params(params)
+{
+    m_params.M = std::max(2, m_params.M);
+    m_params.efConstruction = std::max(m_params.M, m_params.efConstruction);
+    m_levelScale = 1.0 / std::log(double(m_params.M));
+}
+
+void HnswIndex::setEfSearch(int ef) {
+    m_efSearch = std::max(1, ef);
+}
+
+void HnswIndex::clear() {
+    m_levels.clear();
+    m_baseLinks.clear();
+    m_upperLinks.clear();
+    m_visited.clear();
+    m_entryPoint = -1;
+    m_maxLevel = -1;
+}
+
+float HnswIndex::similarity(const float* query, int id) const {
+    return VectorSearch::dot(query, m_source(id), m_dimension);
+}
+
+std::vector<int>& HnswIndex::links(int id, int layer) {
+    return layer == 0 ? m_baseLinks[size_t(id)] : m_upperLinks[size_t(id)][size_t(layer - 1)];
+}
+
+const std::vector<int>& HnswIndex::links(int id, int layer) const {
+    return layer == 0 ? m_baseLinks[size_t(id)] : m_upperLinks[size_t(id)][size_t(layer - 1)];
+}
+
+int HnswIndex::randomLevel() {
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    double level = -std::log(1.0 - uniform(m_rng)) * m_levelScale;
+    return std::min(MAX_LEVEL, int(level));
+}
+
+int HnswIndex::greedyDescend(const float* query, int entry, int fromLayer, int toLayer) const {
+    int current = entry;
+    float best = similarity(query, current);
+
+    for (int layer = fromLayer; layer > toLayer; --layer) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (int neighbor : links(current, layer)) {
+                float score = similarity(query, neighbor);
+                if (score > best) {
+                    best = score;
+                    current = neighbor;
+                    changed = true;
+                }
+            }
+        }
+    }
+    return current;
+}
+
+std::vector<HnswIndex::Scored> HnswIndex::searchLayer(const float* query, int entry,
+                                                      int ef, int layer) const {
+    if (m_visited.size() < m_levels.size()) {
+        m_visited.resize(m_levels.size(), 0);
+    }
+    if (++m_visitEpoch == 0) {
+        std::fill(m_visited.begin(), m_visited.end(), 0);
+        m_visitEpoch = 1;
+    }
+
+    // candidates: best first; results: worst first, capped at ef
+    std::priority_queue<Scored> candidates;
+    std::priority_queue<Scored, std::vector<Scored>, std::greater<Scored>> results;
+
+    float entryScore = similarity(query, entry);
+    m_visited[size_t(entry)] = m_visitEpoch;
+    candidates.emplace(entryScore, entry);
+    results.emplace(entryScore, entry);
+
+    while (!candidates.empty()) {
+        Scored current = candidates.top();
+        if (int(results.size()) >= ef && current.first < results.top().first) {
+            break;  // Nothing left can improve the result set
+        }
+        candidates.pop();
+
+        for (int neighbor : links(current.second, layer)) {
+            if (m_visited[size_t(neighbor)] == m_visitEpoch) continue;
+            m_visited[size_t(neighbor)] = m_visitEpoch;
+
+            float score = similarity(query, neighbor);
+            if (int(results.size()) < ef || score > results.top().first) {
+                candidates.emplace(score, neighbor);
+                results.emplace(score, neighbor);
+                if (int(results.size()) > ef) {
+                    results.pop();
+                }
+            }
+        }
+    }
+
+    std::vector<Scored> found;
+    found.reserve(results.size());
+    while (!results.empty()) {
+        found.push_back(results.top());
+        results.pop();
+    }
+    std::reverse(found.begin(), found.end());
+    return found;
+}
+
+std::vector<int> HnswIndex::selectNeighbors(std::vector<Scored> candidates, int maxCount) const {
+    std::sort(candidates.begin(), candidates.end(), byScoreDesc);
+
+    // Keep a candidate only if it is closer to the base than to every
+    // neighbour already kept - spreads links across directions
+    std::vector<int> selected;
+    std::vector<int> pruned;
+    selected.reserve(size_t(maxCount));
+    for (const Scored& candidate : candidates) {
+        if (int(selected.size()) >= maxCount) break;
+
+        const float* vector = m_source(candidate.second);
+        bool diverse = true;
+        for (int kept : selected) {
+            if (VectorSearch::dot(vector, m_source(kept), m_dimension) > candidate.first) {
+                diverse = false;
+                break;
+            }
+        }
+        (diverse ? selected : pruned).push_back(candidate.second);
+    }
+
+    // Tight clusters (near-duplicates) prune almost everything; top up so
+    // those nodes stay well connected
+    for (int id : pruned) {
+        if (int(selected.size()) >= maxCount) break;
+        selected.push_back(id);
+    }
+    return selected;
+}
+
+void HnswIndex::add() {
+    const int id = size();
+    const int level = randomLevel();
+
+    m_levels.push_back(level);
+    m_baseLinks.emplace_back();
+    m_upperLinks.emplace_back(size_t(level));
+
+    if (m_entryPoint < 0) {
+        m_entryPoint = id;
+        m_maxLevel = level;
+        return;
+    }
+
+    const float* query = m_source(id);
+    int entry = greedyDescend(query, m_entryPoint, m_maxLevel, level);
+
+    for (int layer = std::min(level, m_maxLevel); layer >= 0; --layer) {
+        std::vector<Scored> found = searchLayer(query, entry, m_params.efConstruction, layer);
+        entry = found.front().second;
+
+        std::vector<int> neighbors = selectNeighbors(found, m_params.M);
+        links(id, layer) = neighbors;
+
+        for (int neighbor : neighbors) {
+            std::vector<int>& back = links(neighbor, layer);
+            back.push_back(id);
+            if (int(back.size()) <= maxLinks(layer)) continue;
+
+            // Over capacity: re-pick this node's links from scratch
+            const float* base = m_source(neighbor);
+            std::vector<Scored> candidates;
+            candidates.reserve(back.size());
+            for (int linked : back) {
+                candidates.emplace_back(VectorSearch::dot(base, m_source(linked), m_dimension), linked);
+            }
+            back = selectNeighbors(std::move(candidates), maxLinks(layer));
+        }
+    }
+
+    if (level > m_maxLevel) {
+        m_maxLevel = level;
+        m_entryPoint = id;
+    }
+}
+
+std::vector<VectorSearch::Hit> HnswIndex::search(const float* query, int k,
+                                                 const std::function<bool(int id)>& accept) const {
+    std::vector<VectorSearch::Hit> hits;
+    if (m_entryPoint < 0 || k <= 0) {
+        return hits;
+    }
+
+    int entry = greedyDescend(query, m_entryPoint, m_maxLevel, 0);
+    std::vector<Scored> found = searchLayer(query, entry, std::max(m_efSearch, k), 0);
+
+    for (const Scored& candidate : found) {
+        if (accept && !accept(candidate.second)) continue;
+        hits.push_back(VectorSearch::Hit{candidate.second, candidate.first});
+        if (int(hits.size()) == k) break;
+    }
+    return hits;
+}
+
+bool HnswIndex::save(const QString& path, quint64 tag) const {
+    QByteArray out;
+    IndexHeader header = {};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.dimension = quint32(m_dimension);
+    header.M = quint32(m_params.M);
+    header.efConstruction = quint32(m_params.efConstruction);
+    header.count = quint32(size());
+    header.entryPoint = m_entryPoint;
+    header.maxLevel = m_maxLevel;
+    header.tag = tag;
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (int id = 0; id < size(); ++id) {
+        appendValue(out, quint32(m_levels[size_t(id)]));
+        for (int layer = 0; layer <= m_levels[size_t(id)]; ++layer) {
+            const std::vector<int>& neighbors = links(id, layer);
+            appendValue(out, quint32(neighbors.size()));
+            out.append(reinterpret_cast<const char*>(neighbors.data()),
+                       qsizetype(neighbors.size() * sizeof(int)));
+        }
+    }
+
+    // Write-then-rename so a crash never leaves a half-written graph
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(out) != out.size() || !file.commit()) {
+        qWarning() << "[HnswIndex] Cannot save index:" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool HnswIndex::load(const QString& path, quint64 tag) {
+    clear();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray in = file.readAll();
+
+    qint64 offset = 0;
+    IndexHeader header;
+    if (!readValue(in, offset, header) ||
+        std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        header.version != INDEX_VERSION || header.dimension != quint32(m_dimension) ||
+        header.tag != tag ||
+        header.M < 2 || header.maxLevel > MAX_LEVEL ||
+        header.entryPoint >= qint32(header.count)) {
+        qDebug() << "[HnswIndex] Ignoring incompatible index:" << path;
+        return false;
+    }
+
+    const int count = int(header.count);
+    m_levels.reserve(size_t(count));
+    m_baseLinks.reserve(size_t(count));
+    m_upperLinks.reserve(size_t(count));
+
+    for (int id = 0; id < count; ++id) {
+        quint32 level = 0;
+        if (!readValue(in, offset, level) || level > quint32(MAX_LEVEL)) {
+            clear();
+            return false;
+        }
+        m_levels.push_back(int(level));
+        m_baseLinks.emplace_back();
+        m_upperLinks.emplace_back(size_t(level));
+
+        for (int layer = 0; layer <= int(level); ++layer) {
+            quint32 n = 0;
+            if (!readValue(in, offset, n) || offset + qint64(n) * qint64(sizeof(int)) > in.size()) {
+                clear();
+                return false;
+            }
+            std::vector<int>& neighbors = links(id, layer);
+            neighbors.resize(n);
+            std::memcpy(neighbors.data(), in.constData() + offset, n * sizeof(int));
+            offset += qint64(n) * qint64(sizeof(int));
+        }
+    }
+
+    // Every link on layer L must point at a node that reaches layer L
+    bool valid = (count == 0) == (header.entryPoint < 0) &&
+                 (count == 0 || m_levels[size_t(header.entryPoint)] == header.maxLevel);
+    for (int id = 0; valid && id < count; ++id) {
+        for (int layer = 0; valid && layer <= m_levels[size_t(id)]; ++layer) {
+            for (int neighbor : links(id, layer)) {
+                if (neighbor < 0 || neighbor >= count || m_levels[size_t(neighbor)] < layer) {
+                    valid = false;
+                    break;
+                }
+            }
+        }
+    }
+    if (!valid) {
+        qWarning() << "[HnswIndex] Corrupt index, rebuilding:" << path;
+        clear();
+        return false;
+    }
+
+    m_params.M = int(header.M);
+    m_params.efConstruction = int(header.efConstruction);
+    m_levelScale = 1.0 / std::log(double(m_params.M));
+    m_entryPoint = header.entryPoint;
+    m_maxLevel = header.maxLevel;
+    return true;
+}
+
+} // namespace PhotoGuru
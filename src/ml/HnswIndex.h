@@ -0,0 +1,92 @@
+#pragma once
+
+#include "VectorSearch.h"
+#include <QString>
+#include <QtGlobal>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief HNSW graph for approximate nearest-neighbour search by dot product
+ *
+ * Hierarchical navigable small world graph (Malkov & Yashunin) over dense
+ * ids 0..size()-1. The index stores only links; vectors are read through
+ * the VectorSource, so it can sit on top of EmbeddingStore's mapping
+ * without copying the matrix. Vectors must be L2-normalized.
+ *
+ * efSearch is the recall/latency knob: larger explores more of the graph.
+ *
+ * Not thread-safe: search() reuses an internal visited set, so callers
+ * serialize all access (SimilarityIndex does).
+ */
+class HnswIndex {
+public:
+    using VectorSource = std::function<const float*(int id)>;
+
+    struct Params {
+        int M = 16;                // Links per node above layer 0 (2*M on layer 0)
+        int efConstruction = 100;  // Candidate list size while inserting
+    };
+
+    static constexpr int DEFAULT_EF_SEARCH = 64;
+
+    HnswIndex(int dimension, VectorSource source);
+    HnswIndex(int dimension, VectorSource source, Params params);
+
+    int dimension() const { return m_dimension; }
+    int size() const { return int(m_levels.size()); }
+    Params params() const { return m_params; }
+
+    // Links the vector with id size(); ids are dense and added in order
+    void add();
+
+    std::vector<VectorSearch::Hit> search(const float* query, int k,
+                                          const std::function<bool(int id)>& accept = {}) const;
+
+    void setEfSearch(int ef);
+    int efSearch() const { return m_efSearch; }
+
+    void clear();
+
+    // Graph only. `tag` identifies the vector source (e.g. EmbeddingStore::storeId);
+    // load() fails if the file was saved with another tag or dimension.
+    bool save(const QString& path, quint64 tag) const;
+    bool load(const QString& path, quint64 tag);
+
+private:
+    using Scored = std::pair<float, int>;  // similarity, id
+
+    float similarity(const float* query, int id) const;
+    int greedyDescend(const float* query, int entry, int fromLayer, int toLayer) const;
+    std::vector<Scored> searchLayer(const float* query, int entry, int ef, int layer) const;
+    std::vector<int> selectNeighbors(std::vector<Scored> candidates, int maxCount) const;
+    std::vector<int>& links(int id, int layer);
+    const std::vector<int>& links(int id, int layer) const;
+    int maxLinks(int layer) const { return layer == 0 ? 2 * m_params.M : m_params.M; }
+    int randomLevel();
+
+    int m_dimension;
+    VectorSource m_source;
+    Params m_params;
+    int m_efSearch = DEFAULT_EF_SEARCH;
+    double m_levelScale;
+
+    // Layer 0 links for every node; upper layers only for nodes that reach them
+    std::vector<int> m_levels;
+    std::vector<std::vector<int>> m_baseLinks;
+    std::vector<std::vector<std::vector<int>>> m_upperLinks;  // [id][layer - 1]
+    int m_entryPoint = -1;
+    int m_maxLevel = -1;
+
+    std::mt19937 m_rng{0x5eed};
+
+    mutable std::vector<quint32> m_visited;
+    mutable quint32 m_visitEpoch = 0;
+
+    static constexpr int MAX_LEVEL = 16;
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,147 @@
+#include "ImagePreprocessor.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PG_PREPROCESS_NEON 1
+#if defined(__aarch64__)
+#define PG_NEON_FMA vfmaq_f32
+#else
+#define PG_NEON_FMA vmlaq_f32
+#endif
+#elif defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define PG_PREPROCESS_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PG_PREPROCESS_SSE2 1
+#endif
+
+namespace PhotoGuru {
+
+namespace {
+
+// QRgb is 0xAARRGGBB in a native uint32, independent of byte order
+inline void splitRowScalar(const quint32* px, int begin, int end,
+                           float* r, float* g, float* b,
+                           const float scale[3], const float bias[3]) {
+    for (int x = begin; x < end; ++x) {
+        quint32 p = px[x];
+        r[x] = float((p >> 16) & 0xff) * scale[0] + bias[0];
+        g[x] = float((p >> 8) & 0xff) * scale[1] + bias[1];
+        b[x] = float(p & 0xff) * scale[2] + bias[2];
+    }
+}
+
+void splitRow(const quint32* px, int width, float* r, float* g, float* b,
+              const float scale[3], const float bias[3]) {
+    int x = 0;
+
+#if defined(PG_PREPROCESS_NEON)
+    const uint32x4_t mask = vdupq_n_u32(0xff);
+    const float32x4_t sr = vdupq_n_f32(scale[0]), br = vdupq_n_f32(bias[0]);
+    const float32x4_t sg = vdupq_n_f32(scale[1]), bg = vdupq_n_f32(bias[1]);
+    const float32x4_t sb = vdupq_n_f32(scale[2]), bb = vdupq_n_f32(bias[2]);
+    for (; x + 4 <= width; x += 4) {
+        uint32x4_t p = vld1q_u32(px + x);
+        float32x4_t fr = vcvtq_f32_u32(vandq_u32(vshrq_n_u32(p, 16), mask));
+        float32x4_t fg = vcvtq_f32_u32(vandq_u32(vshrq_n_u32(p, 8), mask));
+        float32x4_t fb = vcvtq_f32_u32(vandq_u32(p, mask));
+        vst1q_f32(r + x, PG_NEON_FMA(br, fr, sr));
+        vst1q_f32(g + x, PG_NEON_FMA(bg, fg, sg));
+        vst1q_f32(b + x, PG_NEON_FMA(bb, fb, sb));
+    }
+#elif defined(PG_PREPROCESS_AVX2)
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    const __m256 sr = _mm256_set1_ps(scale[0]), br = _mm256_set1_ps(bias[0]);
+    const __m256 sg = _mm256_set1_ps(scale[1]), bg = _mm256_set1_ps(bias[1]);
+    const __m256 sb = _mm256_set1_ps(scale[2]), bb = _mm256_set1_ps(bias[2]);
+    for (; x + 8 <= width; x += 8) {
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px + x));
+        __m256 fr = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 16), mask));
+        __m256 fg = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 8), mask));
+        __m256 fb = _mm256_cvtepi32_ps(_mm256_and_si256(p, mask));
+        _mm256_storeu_ps(r + x, _mm256_fmadd_ps(fr, sr, br));
+        _mm256_storeu_ps(g + x, _mm256_fmadd_ps(fg, sg, bg));
+        _mm256_storeu_ps(b + x, _mm256_fmadd_ps(fb, sb, bb));
+    }
+#elif defined(PG_PREPROCESS_SSE2)
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128 sr = _mm_set1_ps(scale[0]), br = _mm_set1_ps(bias[0]);
+    const __m128 sg = _mm_set1_ps(scale[1]), bg = _mm_set1_ps(bias[1]);
+    const __m128 sb = _mm_set1_ps(scale[2]), bb = _mm_set1_ps(bias[2]);
+    for (; x + 4 <= width; x += 4) {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px + x));
+        __m128 fr = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), mask));
+        __m128 fg = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), mask));
+        __m128 fb = _mm_cvtepi32_ps(_mm_and_si128(p, mask));
+        _mm_storeu_ps(r + x, _mm_add_ps(_mm_mul_ps(fr, sr), br));
+        _mm_storeu_ps(g + x, _mm_add_ps(_mm_mul_ps(fg, sg), bg));
+        _mm_storeu_ps(b + x, _mm_add_ps(_mm_mul_ps(fb, sb), bb));
+    }
+#endif
+
+    // Tail (and the whole row without SIMD)
+    splitRowScalar(px, x, width, r, g, b, scale, bias);
+}
+
+} // namespace
+
+bool ImagePreprocessor::toNormalizedCHW(const QImage& image, int width, int height,
+                                        const float* mean, const float* std, float* dst) {
+    if (image.isNull() || width <= 0 || height <= 0 || !dst) {
+        return false;
+    }
+
+    QImage resized = image.scaled(width, height,
+                                  Qt::IgnoreAspectRatio,
+                                  Qt::SmoothTransformation);
+
+    // One native 0xAARRGGBB word per pixel for the kernel
+    if (resized.format() != QImage::Format_RGB32 && resized.format() != QImage::Format_ARGB32) {
+        resized = resized.convertToFormat(QImage::Format_RGB32);
+    }
+
+    // (x / 255 - mean) / std  ==  x * (1 / (255 * std)) + (-mean / std)
+    float scale[3];
+    float bias[3];
+    for (int c = 0; c < 3; ++c) {
+        if (mean && std) {
+            scale[c] = 1.0f / (255.0f * std[c]);
+            bias[c] = -mean[c] / std[c];
+        } else {
+            scale[c] = 1.0f / 255.0f;
+            bias[c] = 0.0f;
+        }
+    }
+
+    splitChannels(resized, scale, bias, dst);
+    return true;
+}
+
+void ImagePreprocessor::splitChannels(const QImage& rgb32, const float scale[3],
+                                      const float bias[3], float* dst) {
+    const int width = rgb32.width();
+    const int height = rgb32.height();
+    const size_t plane = size_t(width) * height;
+
+    for (int y = 0; y < height; ++y) {
+        const quint32* px = reinterpret_cast<const quint32*>(rgb32.constScanLine(y));
+        size_t row = size_t(y) * width;
+        splitRow(px, width, dst + row, dst + plane + row, dst + 2 * plane + row, scale, bias);
+    }
+}
+
+void ImagePreprocessor::splitChannelsScalar(const QImage& rgb32, const float scale[3],
+                                            const float bias[3], float* dst) {
+    const int width = rgb32.width();
+    const int height = rgb32.height();
+    const size_t plane = size_t(width) * height;
+
+    for (int y = 0; y < height; ++y) {
+        const quint32* px = reinterpret_cast<const quint32*>(rgb32.constScanLine(y));
+        size_t row = size_t(y) * width;
+        splitRowScalar(px, 0, width, dst + row, dst + plane + row, dst + 2 * plane + row, scale, bias);
+    }
+}
+
+} // namespace PhotoGuru
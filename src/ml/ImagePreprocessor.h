@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QImage>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Resize + HWC->CHW + normalize for 3-channel model inputs
+ *
+ * Normalization (x / 255 - mean) / std is folded into one multiply-add per
+ * value (x * scale + bias) and the channel split runs 4-8 pixels at a time
+ * with NEON, AVX2+FMA or SSE2, whichever the build targets. Output goes
+ * straight into the caller's tensor buffer, so batching callers can fill a
+ * batch without intermediate vectors.
+ */
+class ImagePreprocessor {
+public:
+    /**
+     * @brief Resize `image` to width x height and write CHW floats to `dst`
+     * @param mean Per-channel means, or nullptr for plain x / 255
+     * @param std Per-channel standard deviations (ignored if mean is nullptr)
+     * @param dst 3 * width * height floats
+     * @return false if the image is null or the size is invalid
+     */
+    static bool toNormalizedCHW(const QImage& image, int width, int height,
+                                const float* mean, const float* std, float* dst);
+
+    /**
+     * @brief Split an RGB32/ARGB32 image into scaled planes: plane[c] = x * scale[c] + bias[c]
+     *
+     * Vectorized kernel used by toNormalizedCHW; the image must already be
+     * at the target size.
+     */
+    static void splitChannels(const QImage& rgb32, const float scale[3], const float bias[3], float* dst);
+
+    // Portable reference for splitChannels (tests, and builds without SIMD)
+    static void splitChannelsScalar(const QImage& rgb32, const float scale[3], const float bias[3], float* dst);
+};
+
+} // namespace PhotoGuru
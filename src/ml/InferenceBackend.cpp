@@ -0,0 +1,53 @@
+#include "InferenceBackend.h"
+#include "CLIPAnalyzer.h"
+#include "VisionEmbeddingCache.h"
+
+namespace PhotoGuru {
+
+LocalInference::LocalInference(CLIPAnalyzer* clip, LlamaVLM* vlm)
+    : m_clip(clip)
+    , m_vlm(vlm)
+{
+}
+
+InferenceBackend::Info LocalInference::describe(const CLIPAnalyzer* clip, const LlamaVLM* vlm) {
+    Info info;
+    if (clip) {
+        const CLIPAnalyzer::ModelInfo model = clip->getModelInfo();
+        info.clipVersion = model.modelVersion;
+        info.embeddingDim = model.embeddingDim;
+        info.clipInputSize = model.inputSize;
+        info.batchSize = clip->batchSize();
+    }
+    // Path + size + mtime, as the vision cache does: hashing gigabytes of
+    // weights on every run would cost more than the skip saves
+    if (vlm) {
+        info.vlmId = VisionEmbeddingCache::modelId(vlm->config().modelPath) +
+                     "/" + VisionEmbeddingCache::modelId(vlm->config().mmprojPath);
+        info.captionBatchSize = vlm->config().parallelSequences;
+    }
+    return info;
+}
+
+InferenceBackend::Info LocalInference::info() const {
+    return describe(m_clip, m_vlm);
+}
+
+std::vector<std::optional<std::vector<float>>> LocalInference::embed(const std::vector<QImage>& images) {
+    if (!m_clip) return std::vector<std::optional<std::vector<float>>>(images.size());
+    return m_clip->computeEmbeddings(images);
+}
+
+std::vector<std::optional<QString>> LocalInference::caption(const std::vector<QImage>& images,
+                                                            const LlamaVLM::GenerationOptions& options) {
+    if (!m_vlm) return std::vector<std::optional<QString>>(images.size());
+    if (images.size() == 1) return {m_vlm->generateCaption(images.front(), options)};
+    return m_vlm->generateCaptions(images, options);
+}
+
+QString LocalInference::lastError() const {
+    if (m_vlm && !m_vlm->lastError().isEmpty()) return m_vlm->lastError();
+    return m_clip ? m_clip->lastError() : QString();
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "LlamaVLM.h"
+#include <QImage>
+#include <QString>
+#include <optional>
+#include <vector>
+
+namespace PhotoGuru {
+
+class CLIPAnalyzer;
+
+/**
+ * @brief Where batched image embeddings and captions are computed
+ *
+ * LocalInference runs CLIPAnalyzer and LlamaVLM in this process;
+ * RemoteInference hands the images to an InferenceServer, typically
+ * one shared GPU machine serving several workstations.
+ * AnalysisPipeline::defaultStages takes either.
+ *
+ * embed and caption may be called from different threads at once (the
+ * pipeline's CLIP and VLM stages); calls to one of them are serialized
+ * by the caller.
+ */
+class InferenceBackend {
+public:
+    struct Info {
+        QString clipVersion;       // Embedding space, as the EmbeddingStore keys it
+        int embeddingDim = 0;      // 0: no embeddings
+        int clipInputSize = 224;   // Edge of the square images embed expects
+        int batchSize = 16;        // Images per embed call that keep the device busy
+        QString vlmId;             // Empty: no captions
+        int captionBatchSize = 1;  // Images per caption call generated together
+    };
+
+    virtual ~InferenceBackend() = default;
+
+    virtual Info info() const = 0;
+
+    // One entry per image, in order; nullopt for null images and on error
+    virtual std::vector<std::optional<std::vector<float>>> embed(const std::vector<QImage>& images) = 0;
+
+    // As embed; only maxTokens and stopSequences of options reach a remote model
+    virtual std::vector<std::optional<QString>> caption(const std::vector<QImage>& images,
+                                                        const LlamaVLM::GenerationOptions& options) = 0;
+
+    virtual QString lastError() const = 0;
+};
+
+/**
+ * @brief Models loaded in this process
+ *
+ * clip and vlm must outlive the backend; vlm may be null (no captions).
+ */
+class LocalInference : public InferenceBackend {
+public:
+    LocalInference(CLIPAnalyzer* clip, LlamaVLM* vlm);
+
+    // What clip and vlm compute, without a backend around them
+    static Info describe(const CLIPAnalyzer* clip, const LlamaVLM* vlm);
+
+    Info info() const override;
+    std::vector<std::optional<std::vector<float>>> embed(const std::vector<QImage>& images) override;
+    std::vector<std::optional<QString>> caption(const std::vector<QImage>& images,
+                                                const LlamaVLM::GenerationOptions& options) override;
+    QString lastError() const override;
+
+private:
+    CLIPAnalyzer* m_clip;
+    LlamaVLM* m_vlm;
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,140 @@
+#include "InferenceProtocol.h"
+#include <QBuffer>
+#include <QByteArray>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace PhotoGuru {
+
+QJsonObject InferenceProtocol::infoToJson(const InferenceBackend::Info& info) {
+    QJsonObject json;
+    if (info.embeddingDim > 0) {
+        json["clip"] = QJsonObject{
+            {"version", info.clipVersion},
+            {"dim", info.embeddingDim},
+            {"inputSize", info.clipInputSize},
+            {"batchSize", info.batchSize},
+        };
+    }
+    if (!info.vlmId.isEmpty()) {
+        json["vlm"] = QJsonObject{{"id", info.vlmId}, {"batchSize", info.captionBatchSize}};
+    }
+    return json;
+}
+
+InferenceBackend::Info InferenceProtocol::infoFromJson(const QJsonObject& json) {
+    InferenceBackend::Info info;
+    const QJsonObject clip = json.value("clip").toObject();
+    if (!clip.isEmpty()) {
+        info.clipVersion = clip.value("version").toString();
+        info.embeddingDim = clip.value("dim").toInt();
+        info.clipInputSize = clip.value("inputSize").toInt(info.clipInputSize);
+        info.batchSize = std::max(1, clip.value("batchSize").toInt(info.batchSize));
+    }
+    const QJsonObject vlm = json.value("vlm").toObject();
+    if (!vlm.isEmpty()) {
+        info.vlmId = vlm.value("id").toString();
+        info.captionBatchSize = std::max(1, vlm.value("batchSize").toInt(info.captionBatchSize));
+    }
+    return info;
+}
+
+QJsonArray InferenceProtocol::encodeImages(const std::vector<QImage>& images) {
+    QJsonArray array;
+    for (const QImage& image : images) {
+        if (image.isNull()) {
+            array.append(QJsonValue::Null);
+            continue;
+        }
+        QByteArray jpeg;
+        QBuffer buffer(&jpeg);
+        buffer.open(QIODevice::WriteOnly);
+        if (!image.save(&buffer, "JPEG", JPEG_QUALITY)) {
+            array.append(QJsonValue::Null);
+            continue;
+        }
+        array.append(QString::fromLatin1(jpeg.toBase64()));
+    }
+    return array;
+}
+
+std::vector<QImage> InferenceProtocol::decodeImages(const QJsonArray& images) {
+    std::vector<QImage> result;
+    result.reserve(size_t(images.size()));
+    for (const QJsonValue& value : images) {
+        QImage image;
+        if (value.isString()) {
+            image.loadFromData(QByteArray::fromBase64(value.toString().toLatin1()), "JPEG");
+        }
+        result.push_back(std::move(image));  // Null when missing or undecodable
+    }
+    return result;
+}
+
+QJsonArray InferenceProtocol::encodeEmbeddings(const std::vector<std::optional<std::vector<float>>>& embeddings) {
+    QJsonArray array;
+    for (const auto& embedding : embeddings) {
+        if (!embedding || embedding->empty()) {
+            array.append(QJsonValue::Null);
+            continue;
+        }
+        QByteArray bytes(int(embedding->size() * sizeof(float)), Qt::Uninitialized);
+        for (size_t i = 0; i < embedding->size(); ++i) {
+            qToLittleEndian((*embedding)[i], bytes.data() + i * sizeof(float));
+        }
+        array.append(QString::fromLatin1(bytes.toBase64()));
+    }
+    return array;
+}
+
+std::vector<std::optional<std::vector<float>>> InferenceProtocol::decodeEmbeddings(const QJsonArray& embeddings) {
+    std::vector<std::optional<std::vector<float>>> result;
+    result.reserve(size_t(embeddings.size()));
+    for (const QJsonValue& value : embeddings) {
+        const QByteArray bytes = value.isString() ? QByteArray::fromBase64(value.toString().toLatin1()) : QByteArray();
+        if (bytes.isEmpty() || bytes.size() % int(sizeof(float)) != 0) {
+            result.emplace_back(std::nullopt);
+            continue;
+        }
+        std::vector<float> embedding(size_t(bytes.size()) / sizeof(float));
+        for (size_t i = 0; i < embedding.size(); ++i) {
+            embedding[i] = qFromLittleEndian<float>(bytes.constData() + i * sizeof(float));
+        }
+        result.emplace_back(std::move(embedding));
+    }
+    return result;
+}
+
+QJsonArray InferenceProtocol::encodeCaptions(const std::vector<std::optional<QString>>& captions) {
+    QJsonArray array;
+    for (const auto& caption : captions) {
+        array.append(caption ? QJsonValue(*caption) : QJsonValue(QJsonValue::Null));
+    }
+    return array;
+}
+
+std::vector<std::optional<QString>> InferenceProtocol::decodeCaptions(const QJsonArray& captions) {
+    std::vector<std::optional<QString>> result;
+    result.reserve(size_t(captions.size()));
+    for (const QJsonValue& value : captions) {
+        result.push_back(value.isString() ? std::optional<QString>(value.toString()) : std::nullopt);
+    }
+    return result;
+}
+
+void InferenceProtocol::optionsToJson(const LlamaVLM::GenerationOptions& options, QJsonObject& request) {
+    if (options.maxTokens > 0) request["maxTokens"] = options.maxTokens;
+    if (!options.stopSequences.isEmpty()) request["stop"] = QJsonArray::fromStringList(options.stopSequences);
+}
+
+LlamaVLM::GenerationOptions InferenceProtocol::optionsFromJson(const QJsonObject& request) {
+    LlamaVLM::GenerationOptions options;
+    options.maxTokens = std::max(0, request.value("maxTokens").toInt());
+    for (const QJsonValue& stop : request.value("stop").toArray()) {
+        if (stop.isString() && !stop.toString().isEmpty()) options.stopSequences << stop.toString();
+    }
+    return options;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "InferenceBackend.h"
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <optional>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Wire format between RemoteInference and InferenceServer
+ *
+ * JSON over HTTP/1.1 (keep-alive):
+ *   GET  /v1/info    -> {"clip": {version, dim, inputSize, batchSize}, "vlm": {id, batchSize}}
+ *   POST /v1/embed   {"images": [...]} -> {"embeddings": [...]}
+ *   POST /v1/caption {"images": [...], "maxTokens": n, "stop": [...]} -> {"captions": [...]}
+ *
+ * Images travel as base64 JPEG, already scaled to what the model views
+ * (CLIP's square, the VLM's bounded edge), so a batch is a few hundred
+ * KB rather than the originals. Embeddings travel as base64 little-endian
+ * float32. A null entry stands for a null image or a failed result, in
+ * either direction. Errors are {"error": message} with a 4xx/5xx status.
+ */
+class InferenceProtocol {
+public:
+    static constexpr const char* INFO_PATH = "/v1/info";
+    static constexpr const char* EMBED_PATH = "/v1/embed";
+    static constexpr const char* CAPTION_PATH = "/v1/caption";
+    static constexpr int JPEG_QUALITY = 90;
+
+    static QJsonObject infoToJson(const InferenceBackend::Info& info);
+    static InferenceBackend::Info infoFromJson(const QJsonObject& json);
+
+    static QJsonArray encodeImages(const std::vector<QImage>& images);
+    static std::vector<QImage> decodeImages(const QJsonArray& images);
+
+    static QJsonArray encodeEmbeddings(const std::vector<std::optional<std::vector<float>>>& embeddings);
+    static std::vector<std::optional<std::vector<float>>> decodeEmbeddings(const QJsonArray& embeddings);
+
+    static QJsonArray encodeCaptions(const std::vector<std::optional<QString>>& captions);
+    static std::vector<std::optional<QString>> decodeCaptions(const QJsonArray& captions);
+
+    // maxTokens and stopSequences; callbacks and cancel stay on the caller's side
+    static void optionsToJson(const LlamaVLM::GenerationOptions& options, QJsonObject& request);
+    static LlamaVLM::GenerationOptions optionsFromJson(const QJsonObject& request);
+};
+
+} // namespace PhotoGuru
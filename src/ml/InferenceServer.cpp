@@ -0,0 +1,89 @@
+#include "InferenceServer.h"
+#include "InferenceProtocol.h"
+#include "core/Trace.h"
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+namespace PhotoGuru {
+
+InferenceServer::InferenceServer(InferenceBackend* backend, QObject* parent)
+    : QObject(parent)
+    , m_backend(backend)
+    , m_info(backend->info())
+    , m_http("InferenceServer")
+{
+    // The models take one batch at a time; more threads would only contend for the device
+    m_embedTasks.setMaxConcurrency(1);
+    m_captionTasks.setMaxConcurrency(1);
+
+    m_http.route("GET", InferenceProtocol::INFO_PATH, [this](const JsonHttpServer::Request&, int*) {
+        return InferenceProtocol::infoToJson(m_info);
+    });
+    m_http.route("POST", InferenceProtocol::EMBED_PATH, logged("embed", &InferenceServer::embed), &m_embedTasks);
+    m_http.route("POST", InferenceProtocol::CAPTION_PATH, logged("caption", &InferenceServer::caption),
+                 &m_captionTasks);
+}
+
+InferenceServer::~InferenceServer() {
+    m_http.close();
+    m_embedTasks.waitForDone();
+    m_captionTasks.waitForDone();
+}
+
+bool InferenceServer::listen(const QHostAddress& address, quint16 port) {
+    return m_http.listen(address, port);
+}
+
+JsonHttpServer::Handler InferenceServer::logged(
+    const QString& what, QJsonObject (InferenceServer::*handler)(const JsonHttpServer::Request&, int*)) {
+    return [this, what, handler](const JsonHttpServer::Request& request, int* status) {
+        QElapsedTimer timer;
+        timer.start();
+        QJsonObject body = (this->*handler)(request, status);
+        if (*status == 200) {
+            emit log(QString("%1: %2 images for %3 in %4 ms")
+                .arg(what).arg(body.constBegin().value().toArray().size()).arg(request.peer).arg(timer.elapsed()));
+        } else {
+            emit log(QString("%1: %2 for %3 (%4)")
+                .arg(what).arg(*status).arg(request.peer).arg(body.value("error").toString()));
+        }
+        return body;
+    };
+}
+
+QJsonObject InferenceServer::embed(const JsonHttpServer::Request& request, int* status) {
+    if (m_info.embeddingDim <= 0) {
+        *status = 404;
+        return JsonHttpServer::error("This server has no CLIP model");
+    }
+    const QJsonArray images = QJsonDocument::fromJson(request.body).object().value("images").toArray();
+    if (images.isEmpty() || images.size() > MAX_BATCH_IMAGES) {
+        *status = images.isEmpty() ? 400 : 413;
+        return JsonHttpServer::error(QString("Expected 1-%1 images").arg(MAX_BATCH_IMAGES));
+    }
+
+    TRACE_SCOPE("server.embed_batch");
+    auto embeddings = m_backend->embed(InferenceProtocol::decodeImages(images));
+    return QJsonObject{{"embeddings", InferenceProtocol::encodeEmbeddings(embeddings)}};
+}
+
+QJsonObject InferenceServer::caption(const JsonHttpServer::Request& request, int* status) {
+    if (m_info.vlmId.isEmpty()) {
+        *status = 404;
+        return JsonHttpServer::error("This server has no captioning model");
+    }
+    const QJsonObject json = QJsonDocument::fromJson(request.body).object();
+    const QJsonArray images = json.value("images").toArray();
+    if (images.isEmpty() || images.size() > MAX_BATCH_IMAGES) {
+        *status = images.isEmpty() ? 400 : 413;
+        return JsonHttpServer::error(QString("Expected 1-%1 images").arg(MAX_BATCH_IMAGES));
+    }
+
+    TRACE_SCOPE("server.caption_batch");
+    auto captions = m_backend->caption(InferenceProtocol::decodeImages(images),
+                                       InferenceProtocol::optionsFromJson(json));
+    return QJsonObject{{"captions", InferenceProtocol::encodeCaptions(captions)}};
+}
+
+} // namespace PhotoGuru
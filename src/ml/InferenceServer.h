@@ -0,0 +1,61 @@
+#pragma once
+
+#include "InferenceBackend.h"
+#include "core/JsonHttpServer.h"
+#include "core/TaskScheduler.h"
+#include <QObject>
+#include <QHostAddress>
+#include <QJsonObject>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Serves an InferenceBackend to RemoteInference clients over HTTP
+ *
+ * Run on the machine with the GPU (photoguru-cli --serve), usually over a
+ * LocalInference with every layer offloaded. Requests from all clients
+ * queue for the models: embedding batches and caption batches each run
+ * one at a time on the TaskScheduler (AI), in groups of their own so a
+ * slow caption never holds up CLIP. Replies go out on
+ * the thread the server lives on, which needs an event loop.
+ *
+ * HTTP and the token check are JsonHttpServer's. log() is emitted from
+ * the worker threads.
+ */
+class InferenceServer : public QObject {
+    Q_OBJECT
+
+public:
+    // backend must outlive the server
+    explicit InferenceServer(InferenceBackend* backend, QObject* parent = nullptr);
+    ~InferenceServer();
+
+    void setToken(const QString& token) { m_http.setToken(token); }
+
+    bool listen(const QHostAddress& address = QHostAddress::Any, quint16 port = DEFAULT_PORT);
+    void close() { m_http.close(); }
+    quint16 port() const { return m_http.port(); }
+    QString errorString() const { return m_http.errorString(); }
+
+    static constexpr quint16 DEFAULT_PORT = 8765;
+    static constexpr int MAX_BATCH_IMAGES = 256;
+
+signals:
+    void log(const QString& message);
+
+private:
+    // Run on scheduler workers; set *status alongside the reply body
+    QJsonObject embed(const JsonHttpServer::Request& request, int* status);
+    QJsonObject caption(const JsonHttpServer::Request& request, int* status);
+    // Times a handler and logs its outcome
+    JsonHttpServer::Handler logged(const QString& what,
+                                   QJsonObject (InferenceServer::*handler)(const JsonHttpServer::Request&, int*));
+
+    InferenceBackend* m_backend;
+    const InferenceBackend::Info m_info;  // Taken once; the models don't change under a server
+    JsonHttpServer m_http;
+    TaskGroup m_embedTasks{TaskScheduler::AI};  // Last: wait for handlers before the rest goes
+    TaskGroup m_captionTasks{TaskScheduler::AI};
+};
+
+} // namespace PhotoGuru
@@ -1,16 +1,95 @@
 #include "LlamaVLM.h"
+#include "VisionEmbeddingCache.h"
 #include "llama.h"
 #include "mtmd.h"
 #include "mtmd-helper.h"
 #include "common.h"
 #include "../core/Logger.h"
+#include "../core/PixelBuffer.h"
 #include <QImage>
 #include <QDebug>
 #include <QFileInfo>
+#include <algorithm>
 #include <vector>
 
 namespace PhotoGuru {
 
+namespace {
+
+const QString CAPTION_PROMPT = QStringLiteral("Describe this image in one sentence.");
+
+// Largest end <= `end` that does not split a UTF-8 character
+size_t utf8Boundary(const std::string& text, size_t end) {
+    size_t start = end;
+    while (start > 0 && (static_cast<unsigned char>(text[start - 1]) & 0xC0) == 0x80) {
+        --start;
+    }
+    if (start == 0) return end;
+    
+    const unsigned char lead = static_cast<unsigned char>(text[start - 1]);
+    size_t length = 1;
+    if ((lead & 0xE0) == 0xC0) length = 2;
+    else if ((lead & 0xF0) == 0xE0) length = 3;
+    else if ((lead & 0xF8) == 0xF0) length = 4;
+    return end - (start - 1) >= length ? end : start - 1;
+}
+
+} // namespace
+
+LlamaVLM::TokenStream::TokenStream(const GenerationOptions& options)
+    : m_options(options)
+{
+    for (const QString& stop : options.stopSequences) {
+        if (stop.isEmpty()) continue;
+        m_stops.push_back(stop.toStdString());
+        m_holdBack = std::max(m_holdBack, m_stops.back().size() - 1);
+    }
+}
+
+bool LlamaVLM::TokenStream::append(const std::string& piece) {
+    if (m_stopped) return false;
+    if (m_options.cancel && m_options.cancel->loadRelaxed()) {
+        m_stopped = true;
+        return false;
+    }
+    
+    // Only the tail that includes the new piece can complete a stop sequence
+    const size_t before = m_text.size();
+    m_text += piece;
+    for (const std::string& stop : m_stops) {
+        size_t from = before >= stop.size() ? before - stop.size() + 1 : 0;
+        size_t pos = m_text.find(stop, from);
+        if (pos != std::string::npos) {
+            m_text.resize(pos);
+            m_stopped = true;
+            return false;
+        }
+    }
+    
+    if (m_text.size() > m_holdBack) {
+        emitUpTo(m_text.size() - m_holdBack);
+    }
+    return !m_stopped;
+}
+
+void LlamaVLM::TokenStream::finish() {
+    emitUpTo(m_text.size());  // Text before a stop sequence still reaches onToken
+    m_stopped = true;
+}
+
+void LlamaVLM::TokenStream::emitUpTo(size_t end) {
+    end = utf8Boundary(m_text, end);
+    if (end <= m_emitted) return;
+    
+    QString piece = QString::fromUtf8(m_text.data() + m_emitted, static_cast<int>(end - m_emitted));
+    m_emitted = end;
+    if (m_options.onToken && !m_declined && !m_options.onToken(piece)) {
+        m_declined = true;
+        m_stopped = true;
+    }
+}
+
+
 LlamaVLM::LlamaVLM() = default;
 
 LlamaVLM::~LlamaVLM() {
@@ -69,7 +148,10 @@ bool LlamaVLM::initialize(const ModelConfig& config) {
         
         // Create context
         llama_context_params ctx_params = llama_context_default_params();
-        ctx_params.n_ctx = config.contextSize;
+        // contextSize per sequence so batched captions get the same room as single ones
+        const int sequences = std::max(1, config.parallelSequences);
+        ctx_params.n_ctx = config.contextSize * sequences;
+        ctx_params.n_seq_max = sequences;
         ctx_params.n_threads = config.nThreads;
         ctx_params.n_threads_batch = config.nThreads;
         
@@ -83,7 +165,7 @@ bool LlamaVLM::initialize(const ModelConfig& config) {
             return false;
         }
         
-        qDebug() << "[LlamaVLM] Context created with" << config.contextSize << "tokens";
+        qDebug() << "[LlamaVLM] Context created with" << config.contextSize << "tokens x" << sequences << "sequences";
         
         // Load vision projector (mmproj) using mtmd
         std::string mmprojPath = config.mmprojPath.toStdString();
@@ -105,6 +187,10 @@ bool LlamaVLM::initialize(const ModelConfig& config) {
         
         qDebug() << "[LlamaVLM] Vision projector loaded:" << config.mmprojPath;
         
+        m_visionCache = std::make_unique<VisionEmbeddingCache>(config.visionCacheBytes);
+        m_visionCache->setModelId(VisionEmbeddingCache::modelId(config.mmprojPath));
+        m_visionCache->setDiskDirectory(config.visionCacheDir);
+        
         m_initialized = true;
         qDebug() << "[LlamaVLM] ✅ Initialization complete";
         return true;
@@ -116,24 +202,55 @@ bool LlamaVLM::initialize(const ModelConfig& config) {
     }
 }
 
+void LlamaVLM::memoryUsage(qint64* ramBytes, qint64* vramBytes) const {
+    *ramBytes = 0;
+    *vramBytes = 0;
+    if (!m_model) {
+        return;
+    }
+    
+    const qint64 weights = static_cast<qint64>(llama_model_size(m_model));
+    const int layers = std::max(1, static_cast<int>(llama_model_n_layer(m_model)));
+    const double offloaded = std::clamp(static_cast<double>(m_config.nGPULayers) / layers, 0.0, 1.0);
+    *vramBytes = static_cast<qint64>(weights * offloaded);
+    *ramBytes = weights - *vramBytes;
+    
+    const qint64 projector = QFileInfo(m_config.mmprojPath).size();
+    if (m_config.nGPULayers > 0) {
+        *vramBytes += projector;
+    } else {
+        *ramBytes += projector;
+    }
+}
+
 std::optional<QString> LlamaVLM::generateCaption(const QImage& image) {
-    return runInference(image, "Describe this image in one sentence.");
+    return generateCaption(image, GenerationOptions());
+}
+
+std::optional<QString> LlamaVLM::generateCaption(const QImage& image, const GenerationOptions& options) {
+    return runInference(image, CAPTION_PROMPT, options);
 }
 
 std::optional<QString> LlamaVLM::answerQuestion(const QImage& image, const QString& question) {
     QString prompt = QString("Question: %1\nAnswer:").arg(question);
-    return runInference(image, prompt);
+    return runInference(image, prompt, GenerationOptions());
 }
 
 std::optional<QString> LlamaVLM::analyzeImage(const QImage& image, bool includeKeywords) {
+    return analyzeImage(image, includeKeywords, GenerationOptions());
+}
+
+std::optional<QString> LlamaVLM::analyzeImage(const QImage& image, bool includeKeywords,
+                                              const GenerationOptions& options) {
     QString prompt = includeKeywords 
         ? "Provide a detailed description of this image including key objects, colors, composition, and mood. Also list 5-10 relevant keywords."
         : "Provide a detailed description of this image including key objects, colors, composition, and mood.";
     
-    return runInference(image, prompt);
+    return runInference(image, prompt, options);
 }
 
-std::optional<QString> LlamaVLM::runInference(const QImage& image, const QString& prompt) {
+std::optional<QString> LlamaVLM::runInference(const QImage& image, const QString& prompt,
+                                              const GenerationOptions& options) {
     if (!m_initialized) {
         m_lastError = "Model not initialized";
         qWarning() << "[LlamaVLM] ERROR:" << m_lastError;
@@ -150,92 +267,23 @@ std::optional<QString> LlamaVLM::runInference(const QImage& image, const QString
     qDebug() << "[LlamaVLM] Image size:" << image.size() << "format:" << image.format();
     
     try {
-        // Resize image if too large (prevents OOM on Mac M4)
-        QImage processedImage = image;
-        const int MAX_DIM = 512;
-        if (image.width() > MAX_DIM || image.height() > MAX_DIM) {
-            qDebug() << "[LlamaVLM] Resizing image from" << image.size() << "to max" << MAX_DIM;
-            processedImage = image.scaled(MAX_DIM, MAX_DIM, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        }
-        
-        // Convert QImage to RGB format for mtmd_bitmap
-        QImage rgbImage = processedImage.convertToFormat(QImage::Format_RGB888);
-        
-        // Create mtmd_bitmap from image data
-        mtmd_bitmap * bitmap = mtmd_bitmap_init(
-            rgbImage.width(),
-            rgbImage.height(),
-            rgbImage.constBits()
-        );
-        
+        QByteArray imageKey;
+        mtmd_bitmap * bitmap = makeBitmap(image, &imageKey);
         if (!bitmap) {
             m_lastError = "Failed to create bitmap";
             qWarning() << "[LlamaVLM] ERROR:" << m_lastError;
             return std::nullopt;
         }
         
-        qDebug() << "[LlamaVLM] Bitmap created:" << rgbImage.width() << "x" << rgbImage.height();
-        
-        // Create prompt with image marker
-        QString fullPrompt = QString("<__media__> ") + prompt;
-        std::string promptStr = fullPrompt.toStdString();
-        
-        qDebug() << "[LlamaVLM] Full prompt:" << fullPrompt;
-        
-        // Prepare input text
-        mtmd_input_text input_text;
-        input_text.text = promptStr.c_str();
-        input_text.add_special = true;
-        input_text.parse_special = true;
-        
-        // Tokenize prompt with image
-        mtmd_input_chunks * chunks = mtmd_input_chunks_init();
-        const mtmd_bitmap * bitmaps[] = {bitmap};
-        
-        qDebug() << "[LlamaVLM] Starting tokenization...";
-        int32_t tokenize_result = mtmd_tokenize(m_mtmdCtx, chunks, &input_text, bitmaps, 1);
-        
-        if (tokenize_result != 0) {
-            m_lastError = QString("Tokenization failed with code: %1").arg(tokenize_result);
-            qWarning() << "[LlamaVLM] ERROR:" << m_lastError;
-            mtmd_bitmap_free(bitmap);
-            mtmd_input_chunks_free(chunks);
-            return std::nullopt;
-        }
-        
-        qDebug() << "[LlamaVLM] Tokenized" << mtmd_input_chunks_size(chunks) << "chunks";
-        
-        // CRITICAL: Clear memory/KV cache before new inference to prevent context overflow
-        llama_memory_t mem = llama_get_memory(m_ctx);
-        llama_memory_clear(mem, true);  // true = also clear data tensors
-        qDebug() << "[LlamaVLM] Memory cache cleared for new inference";
-        
-        // Use mtmd_helper to evaluate all chunks (handles both text and image)
+        // Fixed chat prefix is decoded once; only image + instruction are new
+        auto [prefix, tail] = formatPrompt(prompt);
         llama_pos n_past = 0;
-        llama_pos new_n_past = 0;
-        
-        int32_t eval_result = mtmd_helper_eval_chunks(
-            m_mtmdCtx,
-            m_ctx,
-            chunks,
-            n_past,           // starting position
-            0,                // sequence id
-            m_config.contextSize,  // batch size
-            true,             // get logits for last token
-            &new_n_past
-        );
-        
-        if (eval_result != 0) {
-            m_lastError = QString("Failed to evaluate chunks: error code %1").arg(eval_result);
-            qWarning() << "[LlamaVLM] ERROR:" << m_lastError;
-            mtmd_bitmap_free(bitmap);
-            mtmd_input_chunks_free(chunks);
+        bool ok = preparePrefix(prefix) && evalImagePrompt(bitmap, imageKey, tail, 0, &n_past);
+        mtmd_bitmap_free(bitmap);
+        if (!ok) {
             return std::nullopt;
         }
         
-        n_past = new_n_past;
-        qDebug() << "[LlamaVLM] Chunks evaluated, n_past:" << n_past;
-        
         qDebug() << "[LlamaVLM] Prompt processed, generating response...";
         
         // Create sampler for greedy decoding
@@ -245,30 +293,29 @@ std::optional<QString> LlamaVLM::runInference(const QImage& image, const QString
         // Create batch for generation
         llama_batch batch = llama_batch_init(m_config.contextSize, 0, 1);
         
-        qDebug() << "[LlamaVLM] Starting token generation (max:" << m_config.maxTokens << ")";
+        const int max_gen = options.maxTokens > 0 ? options.maxTokens : m_config.maxTokens;
+        qDebug() << "[LlamaVLM] Starting token generation (max:" << max_gen << ")";
         
         // Generate tokens
-        QString response;
+        TokenStream stream(options);
         int n_generated = 0;
-        const int max_gen = m_config.maxTokens;
         
         while (n_generated < max_gen) {
             // Sample next token using modern API - use -1 for last token in context
             llama_token new_token = llama_sampler_sample(sampler, m_ctx, -1);
             
-            qDebug() << "[LlamaVLM] Generated token #" << n_generated << ":" << new_token;
-            
             // Check for EOS using vocab
             if (llama_vocab_is_eog(vocab, new_token)) {
                 qDebug() << "[LlamaVLM] EOS token encountered, stopping generation";
                 break;
             }
             
-            // Convert token to text using vocab
+            // Convert token to text using vocab; stop sequences, callback and cancel end early
             char buf[256];
             int n = llama_token_to_piece(vocab, new_token, buf, sizeof(buf), 0, false);
-            if (n > 0) {
-                response.append(QString::fromUtf8(buf, n));
+            if (!stream.append(std::string(buf, n > 0 ? n : 0))) {
+                qDebug() << "[LlamaVLM] Stopped early after" << n_generated + 1 << "tokens";
+                break;
             }
             
             // Prepare next iteration
@@ -282,11 +329,11 @@ std::optional<QString> LlamaVLM::runInference(const QImage& image, const QString
             
             n_generated++;
         }
+        stream.finish();
+        QString response = stream.text();
         
         llama_sampler_free(sampler);
         llama_batch_free(batch);
-        mtmd_bitmap_free(bitmap);
-        mtmd_input_chunks_free(chunks);
         
         qDebug() << "[LlamaVLM] Generated" << n_generated << "tokens";
         
@@ -299,6 +346,325 @@ std::optional<QString> LlamaVLM::runInference(const QImage& image, const QString
     }
 }
 
+std::vector<std::optional<QString>> LlamaVLM::generateCaptions(const std::vector<QImage>& images) {
+    return generateCaptions(images, GenerationOptions());
+}
+
+std::vector<std::optional<QString>> LlamaVLM::generateCaptions(const std::vector<QImage>& images,
+                                                               const GenerationOptions& options) {
+    std::vector<std::optional<QString>> results;
+    results.reserve(images.size());
+    
+    const size_t group = static_cast<size_t>(std::max(1, m_config.parallelSequences));
+    for (size_t start = 0; start < images.size(); start += group) {
+        std::vector<QImage> chunk(images.begin() + start,
+                                  images.begin() + std::min(images.size(), start + group));
+        for (auto& caption : runBatchInference(chunk, CAPTION_PROMPT, options)) {
+            results.push_back(std::move(caption));
+        }
+    }
+    return results;
+}
+
+std::vector<std::optional<QString>> LlamaVLM::runBatchInference(const std::vector<QImage>& images,
+                                                                const QString& prompt,
+                                                                const GenerationOptions& options) {
+    const int count = std::min(static_cast<int>(images.size()), std::max(1, m_config.parallelSequences));
+    std::vector<std::optional<QString>> results(images.size());
+    if (!m_initialized) {
+        m_lastError = "Model not initialized";
+        qWarning() << "[LlamaVLM] ERROR:" << m_lastError;
+        return results;
+    }
+    if (count == 0) {
+        return results;
+    }
+    if (count == 1) {
+        results[0] = runInference(images[0], prompt, options);
+        return results;
+    }
+    
+    try {
+        auto [prefix, tail] = formatPrompt(prompt);
+        if (!preparePrefix(prefix)) {
+            return results;
+        }
+        
+        llama_memory_t mem = llama_get_memory(m_ctx);
+        llama_sampler * sampler = llama_sampler_init_greedy();  // Stateless: safe to share across sequences
+        const llama_vocab * vocab = llama_model_get_vocab(m_model);
+        
+        struct Sequence {
+            int image = -1;
+            llama_pos n_past = 0;
+            llama_token next = 0;
+            int batchIndex = -1;
+            int generated = 0;
+            std::unique_ptr<TokenStream> stream;
+        };
+        std::vector<Sequence> active;
+        
+        // Pieces of different images interleave, so nothing is streamed from here
+        GenerationOptions sequenceOptions = options;
+        sequenceOptions.onToken = nullptr;
+        const int max_gen = options.maxTokens > 0 ? options.maxTokens : m_config.maxTokens;
+        
+        // Every sequence starts from a copy of the prefix positions of sequence 0; the image
+        // chunk overwrites the logits, so each first token is sampled right away
+        for (int i = 0; i < count; ++i) {
+            const int seq = i;
+            if (seq > 0) {
+                llama_memory_seq_rm(mem, seq, -1, -1);
+                llama_memory_seq_cp(mem, 0, seq, 0, m_prefixLength);
+            }
+            
+            QByteArray imageKey;
+            mtmd_bitmap * bitmap = images[i].isNull() ? nullptr : makeBitmap(images[i], &imageKey);
+            llama_pos n_past = 0;
+            bool ok = bitmap && evalImagePrompt(bitmap, imageKey, tail, seq, &n_past);
+            if (bitmap) mtmd_bitmap_free(bitmap);
+            if (!ok) {
+                qWarning() << "[LlamaVLM] Skipping image" << i << "in batch:" << m_lastError;
+                if (seq > 0) llama_memory_seq_rm(mem, seq, -1, -1);
+                continue;
+            }
+            
+            Sequence s;
+            s.image = i;
+            s.n_past = n_past;
+            s.next = llama_sampler_sample(sampler, m_ctx, -1);
+            s.stream = std::make_unique<TokenStream>(sequenceOptions);
+            active.push_back(std::move(s));
+        }
+        
+        // One decode per step carries the next token of every unfinished sequence
+        llama_batch batch = llama_batch_init(count, 0, 1);
+        while (!active.empty()) {
+            common_batch_clear(batch);
+            for (auto it = active.begin(); it != active.end();) {
+                bool done = llama_vocab_is_eog(vocab, it->next) || it->generated >= max_gen;
+                if (!done) {
+                    char buf[256];
+                    int n = llama_token_to_piece(vocab, it->next, buf, sizeof(buf), 0, false);
+                    done = !it->stream->append(std::string(buf, n > 0 ? n : 0));
+                }
+                if (done) {
+                    it->stream->finish();
+                    results[it->image] = it->stream->text().trimmed();
+                    it = active.erase(it);
+                    continue;
+                }
+                
+                it->batchIndex = batch.n_tokens;
+                common_batch_add(batch, it->next, it->n_past++, {it->image}, true);
+                it->generated++;
+                ++it;
+            }
+            if (active.empty()) break;
+            
+            if (llama_decode(m_ctx, batch) != 0) {
+                qWarning() << "[LlamaVLM] Batched decode failed with" << active.size() << "sequences";
+                for (const Sequence& s : active) {
+                    s.stream->finish();
+                    results[s.image] = s.stream->text().trimmed();
+                }
+                break;
+            }
+            for (Sequence& s : active) {
+                s.next = llama_sampler_sample(sampler, m_ctx, s.batchIndex);
+            }
+        }
+        
+        llama_batch_free(batch);
+        llama_sampler_free(sampler);
+        
+        // Only sequence 0 (the prefix) is kept between calls
+        for (int seq = 1; seq < count; ++seq) {
+            llama_memory_seq_rm(mem, seq, -1, -1);
+        }
+        
+        qDebug() << "[LlamaVLM] Batched" << count << "captions";
+        return results;
+        
+    } catch (const std::exception& e) {
+        m_lastError = QString("Inference error: %1").arg(e.what());
+        qWarning() << "[LlamaVLM]" << m_lastError;
+        return results;
+    }
+}
+
+mtmd_bitmap* LlamaVLM::makeBitmap(const QImage& image, QByteArray* key) const {
+    // Resize image if too large (prevents OOM on Mac M4)
+    QImage processedImage = image;
+    if (image.width() > MAX_IMAGE_EDGE || image.height() > MAX_IMAGE_EDGE) {
+        processedImage = image.scaled(MAX_IMAGE_EDGE, MAX_IMAGE_EDGE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    
+    // mtmd_bitmap wants packed RGB888 rows; shared, not converted, when
+    // the caller passed DecodeContext::rgb888
+    const PixelBuffer rgb = PixelBuffer(processedImage).converted(QImage::Format_RGB888).packed();
+    *key = VisionEmbeddingCache::imageKey(rgb.image());
+    return mtmd_bitmap_init(rgb.width(), rgb.height(), rgb.constBits());
+}
+
+bool LlamaVLM::evalImagePrompt(mtmd_bitmap* bitmap, const QByteArray& imageKey,
+                               const std::string& tail, int seqId, int32_t* nPast) {
+    // Prepare input text (BOS/special tokens already sit in the prefix)
+    mtmd_input_text input_text;
+    input_text.text = tail.c_str();
+    input_text.add_special = false;
+    input_text.parse_special = true;
+    
+    // Tokenize prompt with image
+    mtmd_input_chunks * chunks = mtmd_input_chunks_init();
+    const mtmd_bitmap * bitmaps[] = {bitmap};
+    
+    int32_t tokenize_result = mtmd_tokenize(m_mtmdCtx, chunks, &input_text, bitmaps, 1);
+    if (tokenize_result != 0) {
+        m_lastError = QString("Tokenization failed with code: %1").arg(tokenize_result);
+        qWarning() << "[LlamaVLM] ERROR:" << m_lastError;
+        mtmd_input_chunks_free(chunks);
+        return false;
+    }
+    
+    // Chunk by chunk rather than mtmd_helper_eval_chunks, so the image chunk
+    // can be decoded from cached projector output instead of re-encoded
+    llama_pos n_past = m_prefixLength;  // continue after the cached prefix
+    const size_t n_chunks = mtmd_input_chunks_size(chunks);
+    int32_t eval_result = 0;
+    bool cacheHit = false;
+    for (size_t i = 0; i < n_chunks && eval_result == 0; ++i) {
+        const mtmd_input_chunk * chunk = mtmd_input_chunks_get(chunks, i);
+        const bool last = i + 1 == n_chunks;
+        
+        if (mtmd_input_chunk_get_type(chunk) != MTMD_INPUT_CHUNK_TYPE_IMAGE) {
+            eval_result = mtmd_helper_eval_chunk_single(m_mtmdCtx, m_ctx, chunk, n_past, seqId,
+                                                        m_config.contextSize, last, &n_past);
+            continue;
+        }
+        
+        std::optional<std::vector<float>> embedding = m_visionCache->find(imageKey);
+        cacheHit = embedding.has_value();
+        if (!embedding) {
+            eval_result = mtmd_encode_chunk(m_mtmdCtx, chunk);
+            if (eval_result != 0) break;
+            // n_embd_inp: models with deepstack layers (Qwen3-VL) project wider than n_embd
+            const size_t size = mtmd_input_chunk_get_n_tokens(chunk) *
+                                static_cast<size_t>(llama_model_n_embd_inp(m_model));
+            const float * output = mtmd_get_output_embd(m_mtmdCtx);
+            embedding.emplace(output, output + size);
+            m_visionCache->insert(imageKey, *embedding);
+        }
+        eval_result = mtmd_helper_decode_image_chunk(m_mtmdCtx, m_ctx, chunk, embedding->data(),
+                                                     n_past, seqId, m_config.contextSize, &n_past);
+    }
+    mtmd_input_chunks_free(chunks);
+    
+    if (eval_result != 0) {
+        m_lastError = QString("Failed to evaluate chunks: error code %1").arg(eval_result);
+        qWarning() << "[LlamaVLM] ERROR:" << m_lastError;
+        return false;
+    }
+    
+    *nPast = n_past;
+    qDebug() << "[LlamaVLM] Chunks evaluated for sequence" << seqId << ", n_past:" << n_past
+             << (cacheHit ? "(cached image embedding)" : "");
+    return true;
+}
+
+std::pair<std::string, std::string> LlamaVLM::formatPrompt(const QString& prompt) const {
+    const std::string marker = mtmd_default_marker();
+    const std::string system = m_config.systemPrompt.toStdString();
+    const std::string user = marker + " " + prompt.toStdString();
+    
+    std::string formatted;
+    if (const char* tmpl = llama_model_chat_template(m_model, nullptr)) {
+        std::vector<llama_chat_message> messages;
+        if (!system.empty()) {
+            messages.push_back({"system", system.c_str()});
+        }
+        messages.push_back({"user", user.c_str()});
+        
+        std::vector<char> buf(1024 + system.size() + user.size());
+        int32_t n = llama_chat_apply_template(tmpl, messages.data(), messages.size(), true,
+                                              buf.data(), static_cast<int32_t>(buf.size()));
+        if (n > static_cast<int32_t>(buf.size())) {
+            buf.resize(n);
+            n = llama_chat_apply_template(tmpl, messages.data(), messages.size(), true,
+                                          buf.data(), static_cast<int32_t>(buf.size()));
+        }
+        if (n > 0) {
+            formatted.assign(buf.data(), n);
+        }
+    }
+    
+    size_t split = formatted.find(marker);
+    if (split == std::string::npos) {
+        // No usable template: bare prompt, prefix is just the special tokens
+        return {std::string(), user};
+    }
+    return {formatted.substr(0, split), formatted.substr(split)};
+}
+
+bool LlamaVLM::preparePrefix(const std::string& prefix) {
+    llama_memory_t mem = llama_get_memory(m_ctx);
+    
+    if (m_prefixLength >= 0 && prefix == m_prefixText) {
+        // Drop the previous image and answer; the prefix stays decoded
+        if (llama_memory_seq_rm(mem, 0, m_prefixLength, -1)) {
+            return true;
+        }
+        // Partial removal unsupported (e.g. recurrent memory): restore the snapshot
+        llama_memory_clear(mem, true);
+        if (!m_prefixState.empty() &&
+            llama_state_seq_set_data(m_ctx, m_prefixState.data(), m_prefixState.size(), 0) > 0) {
+            return true;
+        }
+        qDebug() << "[LlamaVLM] Prefix snapshot restore failed, decoding again";
+    }
+    
+    // New prefix: decode it into an empty cache and snapshot it
+    m_prefixLength = -1;
+    m_prefixState.clear();
+    llama_memory_clear(mem, true);
+    
+    std::vector<llama_token> tokens = common_tokenize(m_ctx, prefix, true, true);
+    if (static_cast<int>(tokens.size()) >= m_config.contextSize) {
+        m_lastError = QString("Prompt prefix of %1 tokens exceeds context").arg(tokens.size());
+        qWarning() << "[LlamaVLM] ERROR:" << m_lastError;
+        return false;
+    }
+    
+    const int batchSize = static_cast<int>(llama_n_batch(m_ctx));
+    llama_batch batch = llama_batch_init(batchSize, 0, 1);
+    for (size_t start = 0; start < tokens.size(); start += batchSize) {
+        common_batch_clear(batch);
+        const size_t end = std::min(tokens.size(), start + batchSize);
+        for (size_t i = start; i < end; ++i) {
+            common_batch_add(batch, tokens[i], static_cast<llama_pos>(i), {0}, false);
+        }
+        if (llama_decode(m_ctx, batch) != 0) {
+            llama_batch_free(batch);
+            m_lastError = "Failed to decode prompt prefix";
+            qWarning() << "[LlamaVLM] ERROR:" << m_lastError;
+            llama_memory_clear(mem, true);
+            return false;
+        }
+    }
+    llama_batch_free(batch);
+    
+    m_prefixState.resize(llama_state_seq_get_size(m_ctx, 0));
+    if (!m_prefixState.empty()) {
+        m_prefixState.resize(llama_state_seq_get_data(m_ctx, m_prefixState.data(), m_prefixState.size(), 0));
+    }
+    
+    m_prefixText = prefix;
+    m_prefixLength = static_cast<int32_t>(tokens.size());
+    qDebug() << "[LlamaVLM] Prompt prefix cached:" << m_prefixLength << "tokens,"
+             << m_prefixState.size() / 1024 << "KB state";
+    return true;
+}
+
 bool LlamaVLM::encodeImage(const QImage& image) {
     // This method is no longer used with mtmd API
     // Image encoding is now handled in runInference via mtmd_tokenize
@@ -1,18 +1,28 @@
 #pragma once
 
 #include <QString>
+#include <QStringList>
+#include <QByteArray>
 #include <QImage>
+#include <QAtomicInt>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
+#include <cstdint>
 
 // Forward declarations
 struct llama_model;
 struct llama_context;
 struct mtmd_context;
+struct mtmd_bitmap;
 
 namespace PhotoGuru {
 
+class VisionEmbeddingCache;
+
 /**
  * @brief Wrapper for llama.cpp Vision-Language Model
  * 
@@ -22,6 +32,20 @@ namespace PhotoGuru {
  * - Detailed scene description
  * 
  * Uses llama.cpp for inference with Metal (GPU) acceleration.
+ * 
+ * Prompts go through the model's chat template with the image first in
+ * the user turn, so everything before it (system prompt, turn header) is
+ * the same for every image. That prefix is decoded once; later calls
+ * trim the KV cache back to it - or restore its saved sequence state -
+ * and only decode the image and the instruction tail.
+ * 
+ * generateCaptions() decodes several images at once as parallel
+ * sequences of one context (n_seq_max = parallelSequences), each starting
+ * from a copy of the cached prefix.
+ * 
+ * The vision projector's output is cached per image (VisionEmbeddingCache),
+ * so a second prompt about the same photo skips image encoding and only
+ * decodes the stored embeddings.
  */
 class LlamaVLM {
 public:
@@ -33,8 +57,61 @@ public:
         int nGPULayers = 5;     // GPU layers (5 optimal for Mac M4)
         float temperature = 0.7f;
         int maxTokens = 512;    // Max tokens to generate
+        QString systemPrompt = "You are a helpful assistant that describes photos accurately.";
+        int parallelSequences = 4;  // Images decoded together by generateCaptions (contextSize each)
+        qint64 visionCacheBytes = qint64(256) * 1024 * 1024;  // Projector outputs kept in memory
+        QString visionCacheDir;     // Also persist them here; empty = memory only
+    };
+    
+    /**
+     * @brief Per-call generation controls
+     * 
+     * onToken receives text as it is sampled (never a partial UTF-8
+     * character or the start of a stop sequence); returning false stops
+     * generation like cancel does. The stop sequence itself is not part
+     * of the result.
+     */
+    struct GenerationOptions {
+        int maxTokens = 0;                          // 0 = ModelConfig::maxTokens
+        QStringList stopSequences;
+        std::function<bool(const QString& piece)> onToken;
+        const QAtomicInt* cancel = nullptr;         // Polled before every token
+    };
+    
+    /**
+     * @brief Collects sampled pieces, applies stop sequences and feeds onToken
+     * 
+     * Text that could still turn into a stop sequence, or that ends in an
+     * incomplete UTF-8 character, is held back until the next piece.
+     */
+    class TokenStream {
+    public:
+        explicit TokenStream(const GenerationOptions& options);
+        
+        // false once generation should stop (stop sequence, callback or cancel)
+        bool append(const std::string& piece);
+        
+        // Flushes held-back text to onToken
+        void finish();
+        
+        QString text() const { return QString::fromUtf8(m_text.data(), static_cast<int>(m_text.size())); }
+        bool stopped() const { return m_stopped; }
+        
+    private:
+        void emitUpTo(size_t end);
+        
+        const GenerationOptions& m_options;
+        std::vector<std::string> m_stops;
+        size_t m_holdBack = 0;
+        std::string m_text;
+        size_t m_emitted = 0;
+        bool m_stopped = false;
+        bool m_declined = false;  // onToken returned false; deliver nothing more
     };
     
+    // Longest image edge handed to the projector; larger images are scaled first
+    static constexpr int MAX_IMAGE_EDGE = 512;
+    
     explicit LlamaVLM();
     ~LlamaVLM();
     
@@ -62,6 +139,23 @@ public:
      * @return Generated caption or nullopt on error
      */
     std::optional<QString> generateCaption(const QImage& image);
+    std::optional<QString> generateCaption(const QImage& image, const GenerationOptions& options);
+    
+    /**
+     * @brief Caption several images in parallel sequences of one context
+     * 
+     * Images are encoded one by one, then up to parallelSequences captions
+     * are generated together: each decode step carries one token per
+     * unfinished sequence, so the GPU sees a batch instead of one token.
+     * 
+     * options.onToken is not used here (pieces of different images interleave);
+     * maxTokens, stopSequences and cancel apply to every sequence.
+     * 
+     * @return One caption per image, in order; nullopt for images that failed
+     */
+    std::vector<std::optional<QString>> generateCaptions(const std::vector<QImage>& images);
+    std::vector<std::optional<QString>> generateCaptions(const std::vector<QImage>& images,
+                                                         const GenerationOptions& options);
     
     /**
      * @brief Ask a question about an image
@@ -78,6 +172,8 @@ public:
      * @return Description or nullopt on error
      */
     std::optional<QString> analyzeImage(const QImage& image, bool includeKeywords = true);
+    std::optional<QString> analyzeImage(const QImage& image, bool includeKeywords,
+                                        const GenerationOptions& options);
     
     /**
      * @brief Get last error message
@@ -89,11 +185,49 @@ public:
      */
     const ModelConfig& config() const { return m_config; }
     
+    /**
+     * @brief Cached vision projector outputs; null until initialize() succeeds
+     */
+    VisionEmbeddingCache* visionCache() const { return m_visionCache.get(); }
+    
+    /**
+     * @brief Resident weight bytes, split by the layers offloaded to the GPU
+     * 
+     * The vision projector counts towards VRAM when it runs on the GPU.
+     * KV cache and compute buffers are not included.
+     */
+    void memoryUsage(qint64* ramBytes, qint64* vramBytes) const;
+    
 private:
     /**
      * @brief Run inference with image and text prompt
      */
-    std::optional<QString> runInference(const QImage& image, const QString& prompt);
+    std::optional<QString> runInference(const QImage& image, const QString& prompt,
+                                        const GenerationOptions& options);
+    
+    /**
+     * @brief runInference for up to parallelSequences images, one sequence each
+     */
+    std::vector<std::optional<QString>> runBatchInference(const std::vector<QImage>& images,
+                                                          const QString& prompt,
+                                                          const GenerationOptions& options);
+    
+    /**
+     * @brief Downscaled RGB bitmap for mtmd; caller frees with mtmd_bitmap_free
+     * @param key Receives the VisionEmbeddingCache key of the bitmap's pixels
+     */
+    mtmd_bitmap* makeBitmap(const QImage& image, QByteArray* key) const;
+    
+    /**
+     * @brief Tokenize image + tail and append them to sequence seqId after the prefix
+     * 
+     * The image chunk is decoded from the cached projector output for
+     * imageKey when there is one; otherwise it is encoded and cached.
+     * 
+     * @param nPast Receives the position after the last evaluated token
+     */
+    bool evalImagePrompt(mtmd_bitmap* bitmap, const QByteArray& imageKey,
+                         const std::string& tail, int seqId, int32_t* nPast);
     
     /**
      * @brief Encode image through vision projector
@@ -105,6 +239,20 @@ private:
      */
     std::string sampleTokens(int maxTokens);
     
+    /**
+     * @brief Chat-formatted prompt split at the image marker
+     * @return {prefix before the image, image marker + instruction tail}
+     */
+    std::pair<std::string, std::string> formatPrompt(const QString& prompt) const;
+    
+    /**
+     * @brief Leave exactly the decoded prefix in sequence 0 of the KV cache
+     * 
+     * Reuses the cached prefix when unchanged, otherwise decodes it and
+     * snapshots its sequence state.
+     */
+    bool preparePrefix(const std::string& prefix);
+    
     bool m_initialized = false;
     ModelConfig m_config;
     QString m_lastError;
@@ -113,6 +261,13 @@ private:
     llama_model* m_model = nullptr;
     llama_context* m_ctx = nullptr;
     mtmd_context* m_mtmdCtx = nullptr;
+    
+    // Decoded prompt prefix shared by every image (see preparePrefix)
+    std::string m_prefixText;
+    int32_t m_prefixLength = -1;          // Tokens in the prefix, -1 if not decoded
+    std::vector<uint8_t> m_prefixState;   // llama_state_seq snapshot of the prefix
+    
+    std::unique_ptr<VisionEmbeddingCache> m_visionCache;
 };
 
 } // namespace PhotoGuru
@@ -0,0 +1,361 @@
+#include "ModelRegistry.h"
+#include "ONNXInference.h"
+#include <QtConcurrent>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+#include <exception>
+
+namespace PhotoGuru {
+
+namespace {
+
+bool overBudget(const ModelRegistry::Footprint& resident, const ModelRegistry::Footprint& budget) {
+    return (budget.ramBytes > 0 && resident.ramBytes > budget.ramBytes) ||
+           (budget.vramBytes > 0 && resident.vramBytes > budget.vramBytes);
+}
+
+qint64 megabytes(qint64 bytes) {
+    return bytes / (1024 * 1024);
+}
+
+} // namespace
+
+ModelRegistry& ModelRegistry::instance() {
+    static ModelRegistry registry;
+    return registry;
+}
+
+ModelRegistry::ModelRegistry(QObject* parent)
+    : QObject(parent)
+{
+    m_clock.start();
+    m_loadPool.setMaxThreadCount(1);  // One multi-GB load at a time
+
+    m_idleTimer = new QTimer(this);
+    connect(m_idleTimer, &QTimer::timeout, this, [this]() { unloadIdle(); });
+    setIdleTimeout(DEFAULT_IDLE_TIMEOUT_MS);
+}
+
+ModelRegistry::~ModelRegistry() {
+    m_loadPool.waitForDone();
+}
+
+void ModelRegistry::registerLoader(const QString& name, AnyLoader loader) {
+    QFuture<void> pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(name);
+        if (it != m_entries.end()) {
+            pending = it->loading;
+        }
+    }
+    pending.waitForFinished();  // A load in flight would store the old loader's model
+
+    std::shared_ptr<void> replaced;
+    {
+        QMutexLocker locker(&m_mutex);
+        Entry& entry = m_entries[name];
+        replaced = std::move(entry.model);
+        entry = Entry();
+        entry.loader = std::move(loader);
+    }
+    if (replaced) {
+        emit modelUnloaded(name);
+    }
+}
+
+bool ModelRegistry::contains(const QString& name) const {
+    QMutexLocker locker(&m_mutex);
+    return m_entries.contains(name);
+}
+
+bool ModelRegistry::isLoaded(const QString& name) const {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.constFind(name);
+    return it != m_entries.constEnd() && it->model != nullptr;
+}
+
+QStringList ModelRegistry::loadedModels() const {
+    QMutexLocker locker(&m_mutex);
+    QStringList names;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        if (it->model) names << it.key();
+    }
+    names.sort();
+    return names;
+}
+
+QFuture<void> ModelRegistry::preload(const QString& name) {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(name);
+    if (it == m_entries.end() || it->model) {
+        return QFuture<void>();
+    }
+    return startLoad(name);
+}
+
+QFuture<void> ModelRegistry::startLoad(const QString& name) {
+    Entry& entry = m_entries[name];
+    if (!entry.loading.isFinished()) {
+        return entry.loading;
+    }
+    entry.error.clear();
+    entry.loading = QtConcurrent::run(&m_loadPool, [this, name]() { load(name); });
+    return entry.loading;
+}
+
+std::shared_ptr<void> ModelRegistry::acquireModel(const QString& name) {
+    QFuture<void> pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(name);
+        if (it == m_entries.end()) {
+            return nullptr;
+        }
+        if (it->model) {
+            it->lastUsed = m_clock.elapsed();
+            return it->model;
+        }
+        pending = startLoad(name);
+    }
+
+    pending.waitForFinished();
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(name);
+    if (it == m_entries.end() || !it->model) {
+        return nullptr;
+    }
+    it->lastUsed = m_clock.elapsed();
+    return it->model;
+}
+
+void ModelRegistry::load(const QString& name) {
+    AnyLoader loader;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(name);
+        if (it == m_entries.end() || it->model) {
+            return;
+        }
+        loader = it->loader;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    Footprint footprint;
+    QString error;
+    std::shared_ptr<void> model;
+    try {
+        model = loader(&footprint, &error);
+    } catch (const std::exception& e) {
+        error = QString("Load error: %1").arg(e.what());
+    }
+
+    std::vector<std::shared_ptr<void>> evicted;
+    QStringList evictedNames;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(name);
+        if (it == m_entries.end()) {
+            return;
+        }
+        if (model) {
+            it->model = model;
+            it->footprint = footprint;
+            it->lastUsed = m_clock.elapsed();
+            evictForBudget(name, &evicted, &evictedNames);
+        } else {
+            it->error = error.isEmpty() ? QString("Failed to load %1").arg(name) : error;
+            error = it->error;
+        }
+    }
+    evicted.clear();  // Model destructors run outside the lock
+
+    if (model) {
+        qDebug() << "[ModelRegistry] Loaded" << name << "in" << timer.elapsed() << "ms -"
+                 << megabytes(footprint.ramBytes) << "MB RAM," << megabytes(footprint.vramBytes) << "MB VRAM";
+    } else {
+        qWarning() << "[ModelRegistry] Failed to load" << name << ":" << error;
+    }
+    for (const QString& evictedName : evictedNames) {
+        emit modelUnloaded(evictedName);
+    }
+    emit modelLoaded(name, model != nullptr);
+}
+
+void ModelRegistry::evictForBudget(const QString& keep, std::vector<std::shared_ptr<void>>* evicted,
+                                   QStringList* names) {
+    Footprint total;
+    for (const Entry& entry : m_entries) {
+        if (entry.model) {
+            total.ramBytes += entry.footprint.ramBytes;
+            total.vramBytes += entry.footprint.vramBytes;
+        }
+    }
+
+    while (overBudget(total, m_budget)) {
+        // Least recently used model nobody holds
+        auto victim = m_entries.end();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it.key() == keep || !it->model || it->model.use_count() > 1) continue;
+            if (victim == m_entries.end() || it->lastUsed < victim->lastUsed) {
+                victim = it;
+            }
+        }
+        if (victim == m_entries.end()) {
+            qWarning() << "[ModelRegistry] Over budget with every other model in use:"
+                       << megabytes(total.ramBytes) << "MB RAM," << megabytes(total.vramBytes) << "MB VRAM";
+            return;
+        }
+
+        total.ramBytes -= victim->footprint.ramBytes;
+        total.vramBytes -= victim->footprint.vramBytes;
+        evicted->push_back(std::move(victim->model));
+        victim->footprint = Footprint();
+        names->append(victim.key());
+        qDebug() << "[ModelRegistry] Unloading" << victim.key() << "to stay within budget";
+    }
+}
+
+bool ModelRegistry::unload(const QString& name) {
+    std::shared_ptr<void> model;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(name);
+        if (it == m_entries.end() || !it->model || it->model.use_count() > 1) {
+            return false;
+        }
+        model = std::move(it->model);
+        it->footprint = Footprint();
+    }
+    model.reset();
+    qDebug() << "[ModelRegistry] Unloaded" << name;
+    emit modelUnloaded(name);
+    return true;
+}
+
+void ModelRegistry::unloadAll() {
+    QStringList names;
+    QList<QFuture<void>> pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        names = m_entries.keys();
+        for (const Entry& entry : m_entries) {
+            pending << entry.loading;
+        }
+    }
+    for (QFuture<void>& future : pending) {
+        future.waitForFinished();
+    }
+    for (const QString& name : names) {
+        unload(name);
+    }
+}
+
+void ModelRegistry::shutdown() {
+    unloadAll();
+    m_loadPool.waitForDone();
+
+    QStringList held = loadedModels();
+    if (!held.isEmpty()) {
+        qWarning() << "[ModelRegistry] Still in use at shutdown:" << held;
+    }
+    ONNXInference::shutdownEnvironment();
+}
+
+void ModelRegistry::setBudget(const Footprint& budget) {
+    std::vector<std::shared_ptr<void>> evicted;
+    QStringList names;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_budget = budget;
+        evictForBudget(QString(), &evicted, &names);
+    }
+    evicted.clear();
+    for (const QString& name : names) {
+        emit modelUnloaded(name);
+    }
+}
+
+ModelRegistry::Footprint ModelRegistry::budget() const {
+    QMutexLocker locker(&m_mutex);
+    return m_budget;
+}
+
+void ModelRegistry::setIdleTimeout(int msec) {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_idleTimeout = std::max(0, msec);
+    }
+    // The timer lives on the registry's thread
+    QMetaObject::invokeMethod(this, [this, msec]() {
+        if (msec > 0) {
+            m_idleTimer->start(std::clamp(msec / 4, 1000, 60 * 1000));
+        } else {
+            m_idleTimer->stop();
+        }
+    });
+}
+
+int ModelRegistry::idleTimeout() const {
+    QMutexLocker locker(&m_mutex);
+    return m_idleTimeout;
+}
+
+ModelRegistry::Footprint ModelRegistry::resident() const {
+    QMutexLocker locker(&m_mutex);
+    Footprint total;
+    for (const Entry& entry : m_entries) {
+        if (entry.model) {
+            total.ramBytes += entry.footprint.ramBytes;
+            total.vramBytes += entry.footprint.vramBytes;
+        }
+    }
+    return total;
+}
+
+ModelRegistry::Footprint ModelRegistry::footprint(const QString& name) const {
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.constFind(name);
+    return it != m_entries.constEnd() && it->model ? it->footprint : Footprint();
+}
+
+QString ModelRegistry::lastError(const QString& name) const {
+    QMutexLocker locker(&m_mutex);
+    return m_entries.value(name).error;
+}
+
+int ModelRegistry::unloadIdle() {
+    std::vector<std::shared_ptr<void>> idle;
+    QStringList names;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_idleTimeout <= 0) {
+            return 0;
+        }
+        const qint64 now = m_clock.elapsed();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (!it->model) continue;
+            if (it->model.use_count() > 1) {
+                it->lastUsed = now;  // Idle time starts when the last handle goes
+                continue;
+            }
+            if (now - it->lastUsed >= m_idleTimeout) {
+                idle.push_back(std::move(it->model));
+                it->footprint = Footprint();
+                names << it.key();
+            }
+        }
+    }
+    idle.clear();
+
+    for (const QString& name : names) {
+        qDebug() << "[ModelRegistry] Unloaded idle model" << name;
+        emit modelUnloaded(name);
+    }
+    return names.size();
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMutex>
+#include <QFuture>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QTimer;
+
+namespace PhotoGuru {
+
+/**
+ * @brief Process-wide owner of the ML models, loaded on first use
+ *
+ * Models are registered by name with a loader and nothing is read from
+ * disk until someone needs them: preload() loads in the background,
+ * acquire() waits for (or starts) the load and returns a shared handle.
+ * Background loads run one at a time on the registry's own pool, so two
+ * multi-GB models don't initialise concurrently. Loaders must not call
+ * acquire() themselves.
+ *
+ * A model is in use while a handle from acquire() is alive; only models
+ * nobody holds are unloaded. Unloading happens when
+ *   - a load pushes resident memory over the RAM or VRAM budget
+ *     (least recently used first), or
+ *   - a model has been idle longer than the idle timeout.
+ * A later acquire() loads it again.
+ *
+ * ONNX models share the one Ort::Env that ONNXInference keeps per process;
+ * shutdown() unloads everything and then releases that environment.
+ *
+ * Thread-safe. Signals are emitted from the loading thread.
+ */
+class ModelRegistry : public QObject {
+    Q_OBJECT
+
+public:
+    // Bytes a model keeps resident once loaded
+    struct Footprint {
+        qint64 ramBytes = 0;
+        qint64 vramBytes = 0;
+    };
+
+    // Returns the loaded model, or null with *error set; fills *footprint
+    template <typename T>
+    using Loader = std::function<std::unique_ptr<T>(Footprint* footprint, QString* error)>;
+
+    static ModelRegistry& instance();
+
+    explicit ModelRegistry(QObject* parent = nullptr);
+    ~ModelRegistry();
+
+    // Replaces an existing registration of the same name (unloading it)
+    template <typename T>
+    void registerModel(const QString& name, Loader<T> loader) {
+        registerLoader(name, [loader](Footprint* footprint, QString* error) -> std::shared_ptr<void> {
+            return std::shared_ptr<T>(loader(footprint, error));
+        });
+    }
+
+    bool contains(const QString& name) const;
+    bool isLoaded(const QString& name) const;
+    QStringList loadedModels() const;
+
+    // Starts loading in the background if the model isn't loaded or loading
+    QFuture<void> preload(const QString& name);
+
+    // Loaded model, loading it first if needed (blocks); null if unknown or the load failed
+    template <typename T>
+    std::shared_ptr<T> acquire(const QString& name) {
+        return std::static_pointer_cast<T>(acquireModel(name));
+    }
+
+    // false while a handle is held
+    bool unload(const QString& name);
+
+    // Unloads every model nobody holds after their load finished
+    void unloadAll();
+
+    // Unloads all models, then the shared ONNX Runtime environment
+    void shutdown();
+
+    // 0 = no limit for that kind of memory
+    void setBudget(const Footprint& budget);
+    Footprint budget() const;
+
+    // Models unused this long are unloaded; 0 disables
+    void setIdleTimeout(int msec);
+    int idleTimeout() const;
+
+    Footprint resident() const;
+    Footprint footprint(const QString& name) const;  // Zero unless loaded
+    QString lastError(const QString& name) const;
+
+    // Unloads models idle past the timeout; run periodically by a timer
+    int unloadIdle();
+
+    static constexpr int DEFAULT_IDLE_TIMEOUT_MS = 10 * 60 * 1000;
+
+signals:
+    void modelLoaded(const QString& name, bool ok);
+    void modelUnloaded(const QString& name);
+
+private:
+    using AnyLoader = std::function<std::shared_ptr<void>(Footprint*, QString*)>;
+
+    struct Entry {
+        AnyLoader loader;
+        std::shared_ptr<void> model;
+        Footprint footprint;
+        QFuture<void> loading;
+        qint64 lastUsed = 0;  // m_clock ms
+        QString error;
+    };
+
+    void registerLoader(const QString& name, AnyLoader loader);
+    std::shared_ptr<void> acquireModel(const QString& name);
+    QFuture<void> startLoad(const QString& name);  // Caller holds m_mutex
+    void load(const QString& name);
+
+    // Detaches models to unload until `resident` fits the budget; caller holds m_mutex
+    void evictForBudget(const QString& keep, std::vector<std::shared_ptr<void>>* evicted,
+                        QStringList* names);
+
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    Footprint m_budget;
+    int m_idleTimeout = DEFAULT_IDLE_TIMEOUT_MS;
+    QElapsedTimer m_clock;
+    QThreadPool m_loadPool;
+    QTimer* m_idleTimer = nullptr;
+};
+
+} // namespace PhotoGuru
@@ -1,14 +1,38 @@
 #include "ONNXInference.h"
+#include "ImagePreprocessor.h"
+#include "Trace.h"
 #include <onnxruntime/onnxruntime_cxx_api.h>
 #include <QImage>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
 #include <cmath>
+#include <unordered_map>
 
 namespace PhotoGuru {
 
 // ONNX Runtime environment (singleton)
 static std::unique_ptr<Ort::Env> g_ort_env = nullptr;
 static std::mutex g_env_mutex;
+static ONNXInference::SessionConfig g_default_config;  // Guarded by g_env_mutex
+
+namespace {
+
+// Session paths are wide on Windows
+std::basic_string<ORTCHAR_T> ortPath(const QString& path) {
+#ifdef _WIN32
+    return path.toStdWString();
+#else
+    return path.toStdString();
+#endif
+}
+
+} // namespace
 
 ONNXInference::ONNXInference() {
     initializeEnvironment();
@@ -39,116 +63,345 @@ void ONNXInference::shutdownEnvironment() {
     }
 }
 
+void ONNXInference::setDefaultConfig(const SessionConfig& config) {
+    std::lock_guard<std::mutex> lock(g_env_mutex);
+    g_default_config = config;
+}
+
+ONNXInference::SessionConfig ONNXInference::defaultConfig() {
+    std::lock_guard<std::mutex> lock(g_env_mutex);
+    return g_default_config;
+}
+
+QString ONNXInference::providerName(Provider provider) {
+    switch (provider) {
+        case Provider::Auto:   return "auto";
+        case Provider::CPU:    return "cpu";
+        case Provider::CoreML: return "coreml";
+        case Provider::CUDA:   return "cuda";
+    }
+    return "auto";
+}
+
+std::optional<ONNXInference::Provider> ONNXInference::providerFromName(const QString& name) {
+    for (Provider provider : {Provider::Auto, Provider::CPU, Provider::CoreML, Provider::CUDA}) {
+        if (providerName(provider) == name) return provider;
+    }
+    return std::nullopt;
+}
+
+std::vector<ONNXInference::Provider> ONNXInference::availableProviders() {
+    // GPU providers first: without a benchmark, Auto takes the first one
+    std::vector<Provider> providers;
+    const std::vector<std::string> built = Ort::GetAvailableProviders();
+    auto has = [&built](const char* name) {
+        return std::find(built.begin(), built.end(), name) != built.end();
+    };
+#ifdef __APPLE__
+    if (has("CoreMLExecutionProvider")) providers.push_back(Provider::CoreML);
+#else
+    if (has("CUDAExecutionProvider")) providers.push_back(Provider::CUDA);
+#endif
+    providers.push_back(Provider::CPU);
+    return providers;
+}
+
 bool ONNXInference::loadModel(const QString& modelPath, bool useGPU) {
+    SessionConfig config = defaultConfig();
+    if (!useGPU) config.provider = Provider::CPU;
+    return loadModel(modelPath, config);
+}
+
+bool ONNXInference::loadModel(const QString& modelPath, const SessionConfig& config) {
     if (!g_ort_env) {
         m_lastError = "ONNX Runtime environment not initialized";
         return false;
     }
     
+    QElapsedTimer timer;
+    timer.start();
+    m_session.reset();
+    m_loaded = false;
+    
+    // One cache entry per model file and runtime: either changing invalidates it
+    QString cacheDir;
+    if (!config.cacheDirectory.isEmpty()) {
+        QFileInfo info(modelPath);
+        QByteArray identity = info.absoluteFilePath().toUtf8();
+        identity += '|' + QByteArray::number(info.size());
+        identity += '|' + QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+        identity += '|' + QByteArray(OrtGetApiBase()->GetVersionString());
+        cacheDir = config.cacheDirectory + "/" + QString::fromLatin1(
+            QCryptographicHash::hash(identity, QCryptographicHash::Sha1).toHex().left(16));
+        if (!QDir().mkpath(cacheDir)) {
+            qWarning() << "[ONNX] Cannot create model cache" << cacheDir << "- loading uncached";
+            cacheDir.clear();
+        }
+    }
+    
     try {
-        // Create session options
-        Ort::SessionOptions sessionOptions;
-        sessionOptions.SetIntraOpNumThreads(4);
-        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        std::vector<Provider> candidates = availableProviders();
+        Provider provider = config.provider;
         
-        // Try to use CoreML on macOS for GPU acceleration
-        if (useGPU) {
-#ifdef __APPLE__
-            try {
-                // CoreML provider - simplified approach without explicit options
-                uint32_t coreml_flags = 0;
-                sessionOptions.AppendExecutionProvider("CoreML", {{"CoreMLFlags", std::to_string(coreml_flags)}});
-                qDebug() << "[ONNX] Using CoreML execution provider (GPU accelerated)";
-            } catch (const Ort::Exception& e) {
-                qWarning() << "[ONNX] CoreML provider not available, using CPU:" << e.what();
-            }
-#else
-            // Try CUDA on other platforms
-            try {
-                sessionOptions.AppendExecutionProvider("CUDA", {});
-                qDebug() << "[ONNX] Using CUDA execution provider";
-            } catch (const Ort::Exception&) {
-                qDebug() << "[ONNX] CUDA not available, using CPU";
+        if (provider == Provider::Auto && candidates.size() == 1) {
+            provider = candidates.front();
+        } else if (provider == Provider::Auto && cacheDir.isEmpty()) {
+            provider = candidates.front();  // Nowhere to remember a benchmark
+        } else if (provider == Provider::Auto) {
+            QFile choice(cacheDir + "/provider");
+            std::optional<Provider> picked;
+            if (choice.open(QIODevice::ReadOnly)) {
+                picked = providerFromName(QString::fromLatin1(choice.readAll().trimmed()));
+                choice.close();
             }
-#endif
-        }
-        
-        // Load the model
-        std::string modelPathStr = modelPath.toStdString();
-        m_session = std::make_unique<Ort::Session>(*g_ort_env, modelPathStr.c_str(), sessionOptions);
-        
-        // Store session options
-        m_sessionOptions = std::make_unique<Ort::SessionOptions>(std::move(sessionOptions));
-        
-        // Get input info
-        Ort::AllocatorWithDefaultOptions allocator;
-        size_t num_input_nodes = m_session->GetInputCount();
-        if (num_input_nodes > 0) {
-            Ort::TypeInfo input_type_info = m_session->GetInputTypeInfo(0);
-            auto tensor_info = input_type_info.GetTensorTypeAndShapeInfo();
-            m_inputShape = tensor_info.GetShape();
             
-            // Handle fully dynamic shapes (CLIP models often have all -1)
-            // Assume standard CLIP input: [batch=1, channels=3, height=224, width=224]
-            bool has_dynamic_dims = false;
-            for (auto dim : m_inputShape) {
-                if (dim < 0) {
-                    has_dynamic_dims = true;
-                    break;
+            if (picked && std::find(candidates.begin(), candidates.end(), *picked) != candidates.end()) {
+                provider = *picked;
+            } else {
+                // First run on this machine: time each provider at our batch size
+                double best = -1.0;
+                provider = Provider::CPU;
+                for (Provider candidate : candidates) {
+                    try {
+                        createSession(modelPath, candidate, config, cacheDir);
+                    } catch (const Ort::Exception& e) {
+                        qWarning() << "[ONNX]" << providerName(candidate) << "unavailable:" << e.what();
+                        continue;
+                    }
+                    const int batch = m_dynamicBatch ? std::max(1, config.benchmarkBatch) : 1;
+                    const double ms = benchmark(batch);
+                    qDebug() << "[ONNX] Benchmark" << providerName(candidate) << ":" << ms << "ms at batch" << batch;
+                    if (ms >= 0.0 && (best < 0.0 || ms < best)) {
+                        best = ms;
+                        provider = candidate;
+                    }
+                }
+                if (choice.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                    choice.write(providerName(provider).toLatin1());
                 }
             }
-            
-            if (has_dynamic_dims || m_inputShape.empty()) {
-                qDebug() << "[ONNX] Model has dynamic input shape, using CLIP defaults [1, 3, 224, 224]";
-                m_inputShape = {1, 3, 224, 224};
-            } else if (m_inputShape.size() > 0 && m_inputShape[0] < 0) {
-                // Only batch size is dynamic
-                m_inputShape[0] = 1;
-            }
-            
-            qDebug() << "[ONNX] Model loaded:" << modelPath;
-            qDebug() << "[ONNX] Input shape: [" 
-                     << (m_inputShape.size() > 0 ? m_inputShape[0] : 0) << ","
-                     << (m_inputShape.size() > 1 ? m_inputShape[1] : 0) << ","
-                     << (m_inputShape.size() > 2 ? m_inputShape[2] : 0) << ","
-                     << (m_inputShape.size() > 3 ? m_inputShape[3] : 0) << "]";
         }
         
-        // Get output info
-        size_t num_output_nodes = m_session->GetOutputCount();
-        if (num_output_nodes > 0) {
-            Ort::TypeInfo output_type_info = m_session->GetOutputTypeInfo(0);
-            auto tensor_info = output_type_info.GetTensorTypeAndShapeInfo();
-            m_outputShape = tensor_info.GetShape();
-            
-            qDebug() << "[ONNX] Output shape: [" 
-                     << (m_outputShape.size() > 0 ? m_outputShape[0] : 0) << ","
-                     << (m_outputShape.size() > 1 ? m_outputShape[1] : 0) << "]";
+        // The benchmark may have left the winner loaded already
+        if (!m_loaded || m_provider != provider) {
+            try {
+                createSession(modelPath, provider, config, cacheDir);
+            } catch (const Ort::Exception& e) {
+                if (provider == Provider::CPU) throw;
+                qWarning() << "[ONNX]" << providerName(provider) << "provider not available, using CPU:" << e.what();
+                createSession(modelPath, Provider::CPU, config, cacheDir);
+            }
         }
         
-        // Create memory info for CPU
-        m_memoryInfo = std::make_unique<Ort::MemoryInfo>(
-            Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)
-        );
-        
-        m_loaded = true;
+        qDebug() << "[ONNX] Model ready in" << timer.elapsed() << "ms on" << providerName(m_provider);
         return true;
         
     } catch (const Ort::Exception& e) {
+        m_session.reset();
+        m_loaded = false;
         m_lastError = QString("Failed to load model: %1").arg(e.what());
         qWarning() << "[ONNX]" << m_lastError;
         return false;
     }
 }
 
+void ONNXInference::createSession(const QString& modelPath, Provider provider,
+                                  const SessionConfig& config, const QString& cacheDir) {
+    m_session.reset();
+    m_loaded = false;
+    
+    Ort::SessionOptions sessionOptions;
+    sessionOptions.SetIntraOpNumThreads(config.intraOpThreads);
+    sessionOptions.SetInterOpNumThreads(config.interOpThreads);
+    sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+    
+    // CoreML compiles its partitions, which can't be saved in an ONNX graph:
+    // it keeps the compiled model in its own cache directory instead
+    QString optimizedPath;
+    if (provider == Provider::CoreML) {
+        std::unordered_map<std::string, std::string> options;
+        if (!cacheDir.isEmpty()) {
+            QDir().mkpath(cacheDir + "/coreml");
+            options["ModelCacheDirectory"] = (cacheDir + "/coreml").toStdString();
+        }
+        sessionOptions.AppendExecutionProvider("CoreML", options);
+    } else {
+        if (provider == Provider::CUDA) {
+            OrtCUDAProviderOptions cudaOptions;
+            sessionOptions.AppendExecutionProvider_CUDA(cudaOptions);
+        }
+        if (!cacheDir.isEmpty()) {
+            optimizedPath = cacheDir + "/" + providerName(provider) + ".onnx";
+        }
+    }
+    
+    // Saved by an earlier load: already optimized for this provider and machine
+    QString sourcePath = modelPath;
+    if (!optimizedPath.isEmpty() && QFileInfo::exists(optimizedPath)) {
+        sourcePath = optimizedPath;
+        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+    } else if (!optimizedPath.isEmpty()) {
+        const std::basic_string<ORTCHAR_T> target = ortPath(optimizedPath);
+        sessionOptions.SetOptimizedModelFilePath(target.c_str());
+    }
+    
+    const std::basic_string<ORTCHAR_T> source = ortPath(sourcePath);
+    try {
+        m_session = std::make_unique<Ort::Session>(*g_ort_env, source.c_str(), sessionOptions);
+    } catch (const Ort::Exception& e) {
+        if (sourcePath == modelPath) throw;
+        
+        // A cached graph the runtime no longer takes: drop it and start over
+        qWarning() << "[ONNX] Discarding cached graph" << optimizedPath << ":" << e.what();
+        QFile::remove(optimizedPath);
+        createSession(modelPath, provider, config, cacheDir);
+        return;
+    }
+    
+    m_sessionOptions = std::make_unique<Ort::SessionOptions>(std::move(sessionOptions));
+    m_provider = provider;
+    readModelInfo(modelPath);
+    
+    qDebug() << "[ONNX] Using" << providerName(provider) << "execution provider"
+             << (sourcePath == modelPath ? "" : "(cached graph)");
+}
+
+void ONNXInference::readModelInfo(const QString& modelPath) {
+    // Get input info
+    Ort::AllocatorWithDefaultOptions allocator;
+    size_t num_input_nodes = m_session->GetInputCount();
+    if (num_input_nodes > 0) {
+        // Names are looked up once here, not on every run
+        m_inputName = m_session->GetInputNameAllocated(0, allocator).get();
+
+        m_inputNames.clear();
+        m_inputTypes.clear();
+        for (size_t i = 0; i < num_input_nodes; ++i) {
+            m_inputNames.push_back(m_session->GetInputNameAllocated(i, allocator).get());
+            m_inputTypes.push_back(static_cast<int>(
+                m_session->GetInputTypeInfo(i).GetTensorTypeAndShapeInfo().GetElementType()));
+        }
+
+        Ort::TypeInfo input_type_info = m_session->GetInputTypeInfo(0);
+        auto tensor_info = input_type_info.GetTensorTypeAndShapeInfo();
+        m_inputShape = tensor_info.GetShape();
+        
+        // Handle fully dynamic shapes (CLIP models often have all -1)
+        // Assume standard CLIP input: [batch=1, channels=3, height=224, width=224]
+        bool has_dynamic_dims = false;
+        for (auto dim : m_inputShape) {
+            if (dim < 0) {
+                has_dynamic_dims = true;
+                break;
+            }
+        }
+        
+        // Batch axis is re-set per run when the model leaves it open
+        m_dynamicBatch = m_inputShape.empty() || m_inputShape[0] < 0;
+        
+        if (has_dynamic_dims || m_inputShape.empty()) {
+            qDebug() << "[ONNX] Model has dynamic input shape, using CLIP defaults [1, 3, 224, 224]";
+            m_inputShape = {1, 3, 224, 224};
+        } else if (m_inputShape.size() > 0 && m_inputShape[0] < 0) {
+            // Only batch size is dynamic
+            m_inputShape[0] = 1;
+        }
+        
+        qDebug() << "[ONNX] Model loaded:" << modelPath;
+        qDebug() << "[ONNX] Input shape: [" 
+                 << (m_inputShape.size() > 0 ? m_inputShape[0] : 0) << ","
+                 << (m_inputShape.size() > 1 ? m_inputShape[1] : 0) << ","
+                 << (m_inputShape.size() > 2 ? m_inputShape[2] : 0) << ","
+                 << (m_inputShape.size() > 3 ? m_inputShape[3] : 0) << "]";
+    }
+    
+    // Get output info
+    size_t num_output_nodes = m_session->GetOutputCount();
+    if (num_output_nodes > 0) {
+        m_outputName = m_session->GetOutputNameAllocated(0, allocator).get();
+
+        // HF text exports put last_hidden_state first; the pooled projection is text_embeds
+        m_tokenOutputName = m_outputName;
+        for (size_t i = 0; i < num_output_nodes; ++i) {
+            std::string name = m_session->GetOutputNameAllocated(i, allocator).get();
+            if (name == "text_embeds") {
+                m_tokenOutputName = name;
+                break;
+            }
+        }
+
+        Ort::TypeInfo output_type_info = m_session->GetOutputTypeInfo(0);
+        auto tensor_info = output_type_info.GetTensorTypeAndShapeInfo();
+        m_outputShape = tensor_info.GetShape();
+        
+        qDebug() << "[ONNX] Output shape: [" 
+                 << (m_outputShape.size() > 0 ? m_outputShape[0] : 0) << ","
+                 << (m_outputShape.size() > 1 ? m_outputShape[1] : 0) << "]";
+    }
+    
+    // Create memory info for CPU
+    m_memoryInfo = std::make_unique<Ort::MemoryInfo>(
+        Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)
+    );
+    
+    m_loaded = true;
+}
+
+double ONNXInference::benchmark(int batchSize) {
+    // Token models (CLIP text) take ids; everything else a float image batch
+    const bool tokens = !m_inputTypes.empty() &&
+                        m_inputTypes[0] != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+    std::vector<float> images;
+    std::vector<int64_t> ids;
+    std::vector<int64_t> mask;
+    if (tokens) {
+        ids.assign(static_cast<size_t>(batchSize) * BENCHMARK_SEQUENCE, 0);
+        mask.assign(ids.size(), 1);
+    } else {
+        images.assign(sampleSize() * static_cast<size_t>(batchSize), 0.0f);
+    }
+    
+    auto once = [&]() {
+        return tokens ? runTokens(ids, mask, batchSize).has_value()
+                      : runBatch(images, batchSize).has_value();
+    };
+    
+    // The first run pays for allocation and any lazy compilation
+    if (!once()) return -1.0;
+    
+    double best = -1.0;
+    for (int i = 0; i < BENCHMARK_RUNS; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!once()) return -1.0;
+        const double ms = timer.nsecsElapsed() / 1e6;
+        if (best < 0.0 || ms < best) best = ms;
+    }
+    return best;
+}
+
 std::vector<float> ONNXInference::preprocessImage(
     const QImage& image,
     const std::vector<float>& mean,
     const std::vector<float>& std
 ) const {
+    std::vector<float> tensor(sampleSize());
+    if (tensor.empty() || !preprocessImageInto(image, tensor.data(), mean, std)) {
+        return {};
+    }
+    return tensor;
+}
+
+bool ONNXInference::preprocessImageInto(
+    const QImage& image,
+    float* dst,
+    const std::vector<float>& mean,
+    const std::vector<float>& std
+) const {
+    TRACE_SCOPE("onnx.preprocess");
     if (m_inputShape.size() < 4) {
         qWarning() << "[ONNX] Invalid input shape";
-        return {};
+        return false;
     }
     
     // Get target dimensions (assume NCHW format)
@@ -156,144 +409,266 @@ std::vector<float> ONNXInference::preprocessImage(
     int target_width = m_inputShape[3];
     int channels = m_inputShape[1];
     
-    // Resize image
-    QImage resized = image.scaled(target_width, target_height, 
-                                  Qt::IgnoreAspectRatio, 
-                                  Qt::SmoothTransformation);
+    if (channels != 3) {
+        qWarning() << "[ONNX] Unsupported input channels:" << channels;
+        return false;
+    }
+    
+    // Mean/std only apply when given for every channel
+    bool normalize = mean.size() >= 3 && std.size() >= 3;
+    return ImagePreprocessor::toNormalizedCHW(image, target_width, target_height,
+                                              normalize ? mean.data() : nullptr,
+                                              normalize ? std.data() : nullptr,
+                                              dst);
+}
+
+size_t ONNXInference::sampleSize() const {
+    size_t size = 1;
+    for (size_t i = 1; i < m_inputShape.size(); ++i) {
+        size *= static_cast<size_t>(m_inputShape[i]);
+    }
+    return m_inputShape.empty() ? 0 : size;
+}
+
+std::optional<std::vector<float>> ONNXInference::runInference(
+    const std::vector<float>& inputTensor
+) {
+    return runBatch(inputTensor, 1);
+}
+
+size_t ONNXInference::outputSampleSize() const {
+    if (m_outputShape.size() < 2) return 0;
     
-    // Convert to RGB if needed
-    if (resized.format() != QImage::Format_RGB888) {
-        resized = resized.convertToFormat(QImage::Format_RGB888);
+    size_t size = 1;
+    for (size_t i = 1; i < m_outputShape.size(); ++i) {
+        if (m_outputShape[i] < 0) return 0;  // Only known after a run
+        size *= static_cast<size_t>(m_outputShape[i]);
+    }
+    return size;
+}
+
+std::optional<std::vector<float>> ONNXInference::runBatch(
+    const std::vector<float>& inputTensor,
+    int batchSize
+) {
+    size_t sample_size = sampleSize();
+    if (batchSize < 1 || inputTensor.size() != sample_size * static_cast<size_t>(batchSize)) {
+        m_lastError = QString("Tensor size mismatch: got %1, expected %2 x %3")
+                      .arg(inputTensor.size()).arg(batchSize).arg(sample_size);
+        qWarning() << "[ONNX]" << m_lastError;
+        return std::nullopt;
     }
     
-    // Allocate tensor (NCHW format)
-    std::vector<float> tensor(channels * target_height * target_width);
+    // Known output shape: size the result once and let the model write into it
+    size_t output_sample = outputSampleSize();
+    if (output_sample > 0) {
+        std::vector<float> result(output_sample * static_cast<size_t>(batchSize));
+        if (!runInto(inputTensor.data(), batchSize, result.data(), result.size())) {
+            return std::nullopt;
+        }
+        return result;
+    }
     
-    // Convert HWC (QImage) to CHW (ONNX) and normalize
-    for (int h = 0; h < target_height; ++h) {
-        const uchar* line = resized.constScanLine(h);
-        for (int w = 0; w < target_width; ++w) {
-            for (int c = 0; c < channels; ++c) {
-                float pixel = line[w * channels + c] / 255.0f;
-                
-                // Normalize with mean and std
-                if (c < static_cast<int>(mean.size()) && c < static_cast<int>(std.size())) {
-                    pixel = (pixel - mean[c]) / std[c];
-                }
-                
-                // CHW format: channel * height * width + height * width + width
-                int idx = c * target_height * target_width + h * target_width + w;
-                tensor[idx] = pixel;
+    if (batchSize > 1 && !m_dynamicBatch) {
+        std::vector<float> result;
+        for (int i = 0; i < batchSize; ++i) {
+            std::vector<float> sample(inputTensor.begin() + i * sample_size,
+                                      inputTensor.begin() + (i + 1) * sample_size);
+            auto output = runBatch(sample, 1);
+            if (!output) {
+                return std::nullopt;
             }
+            result.insert(result.end(), output->begin(), output->end());
         }
+        return result;
     }
     
-    return tensor;
+    std::vector<float> result;
+    if (!run(inputTensor.data(), batchSize, nullptr, 0, &result)) {
+        return std::nullopt;
+    }
+    return result;
 }
 
-std::optional<std::vector<float>> ONNXInference::runInference(
-    const std::vector<float>& inputTensor
-) {
+bool ONNXInference::runInto(const float* input, int batchSize, float* output, size_t outputSize) {
+    size_t output_sample = outputSampleSize();
+    if (batchSize < 1 || output_sample == 0 ||
+        outputSize != output_sample * static_cast<size_t>(batchSize)) {
+        m_lastError = QString("Output buffer size mismatch: got %1, expected %2 x %3")
+                      .arg(outputSize).arg(batchSize).arg(output_sample);
+        qWarning() << "[ONNX]" << m_lastError;
+        return false;
+    }
+    
+    // Fixed batch-1 model: run the samples one by one, still in place
+    if (batchSize > 1 && !m_dynamicBatch) {
+        size_t sample_size = sampleSize();
+        for (int i = 0; i < batchSize; ++i) {
+            if (!run(input + i * sample_size, 1, output + i * output_sample, output_sample, nullptr)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    return run(input, batchSize, output, outputSize, nullptr);
+}
+
+bool ONNXInference::run(const float* input, int batchSize,
+                        float* output, size_t outputSize,
+                        std::vector<float>* allocatedOutput) {
+    TRACE_SCOPE("onnx.run");
     if (!m_loaded || !m_session || !m_memoryInfo) {
         m_lastError = "Model not loaded";
-        return std::nullopt;
+        return false;
     }
     
     try {
-        // Debug: print shapes
-        qDebug() << "[ONNX] Input tensor size:" << inputTensor.size();
-        qDebug() << "[ONNX] Expected shape:" << m_inputShape[0] << "x" << m_inputShape[1] 
-                 << "x" << m_inputShape[2] << "x" << m_inputShape[3];
+        const char* input_names[] = {m_inputName.c_str()};
+        const char* output_names[] = {m_outputName.c_str()};
         
-        size_t expected_size = 1;
-        for (auto dim : m_inputShape) {
-            expected_size *= dim;
-        }
-        qDebug() << "[ONNX] Expected size:" << expected_size;
-        
-        if (inputTensor.size() != expected_size) {
-            m_lastError = QString("Tensor size mismatch: got %1, expected %2")
-                          .arg(inputTensor.size()).arg(expected_size);
-            qWarning() << "[ONNX]" << m_lastError;
-            return std::nullopt;
-        }
-        
-        qDebug() << "[ONNX] Creating tensor...";
-        
-        // Get input/output names
-        Ort::AllocatorWithDefaultOptions allocator;
-        Ort::AllocatedStringPtr input_name_ptr = m_session->GetInputNameAllocated(0, allocator);
-        Ort::AllocatedStringPtr output_name_ptr = m_session->GetOutputNameAllocated(0, allocator);
-        
-        const char* input_names[] = {input_name_ptr.get()};
-        const char* output_names[] = {output_name_ptr.get()};
-        
-        // Create a mutable copy of input tensor for ONNX Runtime
-        std::vector<float> mutable_input(inputTensor.begin(), inputTensor.end());
-        
-        // Create input tensor with proper shape
-        std::vector<int64_t> input_shape_int64(m_inputShape.begin(), m_inputShape.end());
+        // Batch on the first axis; the rest is fixed at load time
+        m_runInputShape.assign(m_inputShape.begin(), m_inputShape.end());
+        m_runInputShape[0] = batchSize;
         
+        // Wraps the caller's buffer - ONNX Runtime only reads inputs
         auto input_tensor = Ort::Value::CreateTensor<float>(
             *m_memoryInfo,
-            mutable_input.data(),
-            mutable_input.size(),
-            input_shape_int64.data(),
-            input_shape_int64.size()
+            const_cast<float*>(input),
+            sampleSize() * static_cast<size_t>(batchSize),
+            m_runInputShape.data(),
+            m_runInputShape.size()
         );
         
-        qDebug() << "[ONNX] Running inference with input tensor size:" << mutable_input.size();
-        qDebug() << "[ONNX] Input names:" << input_names[0];
-        qDebug() << "[ONNX] Output names:" << output_names[0];
+        if (output) {
+            // Model writes straight into the caller-owned span
+            m_runOutputShape.assign(m_outputShape.begin(), m_outputShape.end());
+            m_runOutputShape[0] = batchSize;
+            
+            auto output_tensor = Ort::Value::CreateTensor<float>(
+                *m_memoryInfo,
+                output,
+                outputSize,
+                m_runOutputShape.data(),
+                m_runOutputShape.size()
+            );
+            
+            m_session->Run(Ort::RunOptions{nullptr},
+                           input_names, &input_tensor, 1,
+                           output_names, &output_tensor, 1);
+            return true;
+        }
         
-        // Run inference
-        qDebug() << "[ONNX] Calling session->Run()...";
+        // Output shape only known after the run: copy from the allocated tensor
         auto output_tensors = m_session->Run(
             Ort::RunOptions{nullptr},
             input_names, &input_tensor, 1,
             output_names, 1
         );
-        qDebug() << "[ONNX] Inference completed successfully";
         
-        // Extract output
-        qDebug() << "[ONNX] Extracting output tensors...";
         if (output_tensors.size() == 0) {
             m_lastError = "No output tensors from model";
             qWarning() << "[ONNX]" << m_lastError;
-            return std::nullopt;
+            return false;
         }
         
-        qDebug() << "[ONNX] Number of output tensors:" << output_tensors.size();
+        size_t output_size = output_tensors[0].GetTensorTypeAndShapeInfo().GetElementCount();
+        const float* output_data = output_tensors[0].GetTensorData<float>();
+        if (!output_data) {
+            m_lastError = "Failed to get output data pointer";
+            qWarning() << "[ONNX]" << m_lastError;
+            return false;
+        }
+        
+        if (output_size % static_cast<size_t>(batchSize) != 0) {
+            m_lastError = QString("Output size %1 not divisible by batch %2")
+                          .arg(output_size).arg(batchSize);
+            qWarning() << "[ONNX]" << m_lastError;
+            return false;
+        }
         
-        // Get tensor info
-        Ort::TensorTypeAndShapeInfo type_info = output_tensors[0].GetTensorTypeAndShapeInfo();
-        size_t output_size = type_info.GetElementCount();
-        auto shape = type_info.GetShape();
+        allocatedOutput->assign(output_data, output_data + output_size);
+        return true;
         
-        qDebug() << "[ONNX] Output element count:" << output_size;
-        qDebug() << "[ONNX] Output shape dimensions:" << shape.size();
-        for (size_t i = 0; i < shape.size(); ++i) {
-            qDebug() << "[ONNX]   Dim" << i << ":" << shape[i];
+    } catch (const Ort::Exception& e) {
+        m_lastError = QString("ONNX Runtime exception: %1").arg(e.what());
+        qWarning() << "[ONNX]" << m_lastError;
+        return false;
+    } catch (const std::exception& e) {
+        m_lastError = QString("Standard exception: %1").arg(e.what());
+        qWarning() << "[ONNX]" << m_lastError;
+        return false;
+    } catch (...) {
+        m_lastError = "Unknown exception during inference";
+        qWarning() << "[ONNX]" << m_lastError;
+        return false;
+    }
+}
+
+
+std::optional<std::vector<float>> ONNXInference::runTokens(
+    const std::vector<int64_t>& tokenIds,
+    const std::vector<int64_t>& attentionMask,
+    int batchSize
+) {
+    TRACE_SCOPE("onnx.run_tokens");
+    if (!m_loaded || !m_session || !m_memoryInfo) {
+        m_lastError = "Model not loaded";
+        return std::nullopt;
+    }
+    if (batchSize < 1 || tokenIds.empty() || tokenIds.size() % static_cast<size_t>(batchSize) != 0 ||
+        attentionMask.size() != tokenIds.size()) {
+        m_lastError = QString("Token tensor size mismatch: %1 ids, %2 mask, batch %3")
+                      .arg(tokenIds.size()).arg(attentionMask.size()).arg(batchSize);
+        qWarning() << "[ONNX]" << m_lastError;
+        return std::nullopt;
+    }
+    
+    try {
+        const int64_t shape[] = {batchSize, static_cast<int64_t>(tokenIds.size() / batchSize)};
+        
+        std::vector<const char*> input_names;
+        std::vector<Ort::Value> input_tensors;
+        std::vector<std::vector<int32_t>> narrowed;  // Keeps int32 copies alive through Run()
+        narrowed.reserve(m_inputNames.size());
+        
+        for (size_t i = 0; i < m_inputNames.size(); ++i) {
+            const bool isMask = m_inputNames[i].find("mask") != std::string::npos;
+            const std::vector<int64_t>& data = isMask ? attentionMask : tokenIds;
+            
+            if (m_inputTypes[i] == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32) {
+                narrowed.emplace_back(data.begin(), data.end());
+                input_tensors.push_back(Ort::Value::CreateTensor<int32_t>(
+                    *m_memoryInfo, narrowed.back().data(), narrowed.back().size(), shape, 2));
+            } else {
+                input_tensors.push_back(Ort::Value::CreateTensor<int64_t>(
+                    *m_memoryInfo, const_cast<int64_t*>(data.data()), data.size(), shape, 2));
+            }
+            input_names.push_back(m_inputNames[i].c_str());
         }
         
-        // Get pointer to output data
-        qDebug() << "[ONNX] Getting output data pointer...";
-        float* output_data = output_tensors[0].GetTensorMutableData<float>();
-        if (!output_data) {
-            m_lastError = "Failed to get output data pointer";
+        const char* output_names[] = {m_tokenOutputName.c_str()};
+        auto output_tensors = m_session->Run(
+            Ort::RunOptions{nullptr},
+            input_names.data(), input_tensors.data(), input_tensors.size(),
+            output_names, 1
+        );
+        
+        if (output_tensors.empty()) {
+            m_lastError = "No output tensors from model";
             qWarning() << "[ONNX]" << m_lastError;
             return std::nullopt;
         }
         
-        qDebug() << "[ONNX] Creating result vector of size:" << output_size;
-        std::vector<float> result;
-        result.reserve(output_size);
-        for (size_t i = 0; i < output_size; ++i) {
-            result.push_back(output_data[i]);
+        size_t output_size = output_tensors[0].GetTensorTypeAndShapeInfo().GetElementCount();
+        const float* output_data = output_tensors[0].GetTensorData<float>();
+        if (!output_data || output_size % static_cast<size_t>(batchSize) != 0) {
+            m_lastError = QString("Unexpected token model output of %1 floats").arg(output_size);
+            qWarning() << "[ONNX]" << m_lastError;
+            return std::nullopt;
         }
         
-        qDebug() << "[ONNX] Successfully created result vector with" << result.size() << "elements";
-        return result;
+        return std::vector<float>(output_data, output_data + output_size);
         
     } catch (const Ort::Exception& e) {
         m_lastError = QString("ONNX Runtime exception: %1").arg(e.what());
@@ -303,10 +678,6 @@ std::optional<std::vector<float>> ONNXInference::runInference(
         m_lastError = QString("Standard exception: %1").arg(e.what());
         qWarning() << "[ONNX]" << m_lastError;
         return std::nullopt;
-    } catch (...) {
-        m_lastError = "Unknown exception during inference";
-        qWarning() << "[ONNX]" << m_lastError;
-        return std::nullopt;
     }
 }
 
@@ -2,6 +2,7 @@
 
 #include <QString>
 #include <QImage>
+#include <string>
 #include <vector>
 #include <memory>
 #include <optional>
@@ -24,9 +25,25 @@ namespace PhotoGuru {
  * - Image preprocessing (resize, normalize, CHW format)
  * - Tensor management
  * - Thread-safe execution
+ *
+ * With a cache directory, startup after the first run skips most of the
+ * load: the graph ONNX Runtime optimized is saved and loaded back as is
+ * (CoreML keeps its compiled model there instead), and the provider the
+ * Auto benchmark picked for this machine is remembered. Entries are keyed
+ * by the model file and the ONNX Runtime version.
  */
 class ONNXInference {
 public:
+    enum class Provider { Auto, CPU, CoreML, CUDA };
+    
+    struct SessionConfig {
+        int intraOpThreads = 4;   // 0: one per physical core
+        int interOpThreads = 1;   // Only used between independent graph branches
+        Provider provider = Provider::Auto;  // Auto: the fastest at benchmarkBatch, timed once
+        QString cacheDirectory;   // Empty: optimize and pick on every load
+        int benchmarkBatch = 16;  // CLIPAnalyzer's default batch
+    };
+    
     explicit ONNXInference();
     virtual ~ONNXInference();
     
@@ -42,13 +59,28 @@ public:
      */
     static void shutdownEnvironment();
     
+    /**
+     * @brief Config every loadModel(path, useGPU) uses (set once at startup)
+     */
+    static void setDefaultConfig(const SessionConfig& config);
+    static SessionConfig defaultConfig();
+    
+    static QString providerName(Provider provider);  // Stable, for QSettings
+    static std::optional<Provider> providerFromName(const QString& name);
+    
     /**
      * @brief Load ONNX model from file
      * @param modelPath Absolute path to .onnx file
-     * @param useGPU Try to use GPU acceleration (CoreML on Mac, CUDA on others)
+     * @param useGPU Allow GPU providers (CoreML on Mac, CUDA on others); false = CPU
      * @return true if loaded successfully
      */
     bool loadModel(const QString& modelPath, bool useGPU = true);
+    bool loadModel(const QString& modelPath, const SessionConfig& config);
+    
+    /**
+     * @brief Provider the loaded session runs on
+     */
+    Provider provider() const { return m_provider; }
     
     /**
      * @brief Check if model is loaded and ready
@@ -85,6 +117,18 @@ public:
         const std::vector<float>& std = {0.229f, 0.224f, 0.225f}
     ) const;
     
+    /**
+     * @brief preprocessImage writing into a caller-owned buffer
+     * @param dst sampleSize() floats (e.g. one slot of a batch tensor)
+     * @return false if the image or model input shape is unusable
+     */
+    bool preprocessImageInto(
+        const QImage& image,
+        float* dst,
+        const std::vector<float>& mean = {0.485f, 0.456f, 0.406f},
+        const std::vector<float>& std = {0.229f, 0.224f, 0.225f}
+    ) const;
+    
     /**
      * @brief Run inference with preprocessed tensor
      * @param inputTensor Input data (already preprocessed)
@@ -94,6 +138,66 @@ public:
         const std::vector<float>& inputTensor
     );
     
+    /**
+     * @brief Run inference on a batch of preprocessed samples
+     * 
+     * Samples are concatenated (batchSize x one preprocessImage() tensor).
+     * Models with a dynamic batch axis run in a single session->Run();
+     * fixed-batch models fall back to one run per sample.
+     * 
+     * @return Outputs concatenated in sample order, or empty if error
+     */
+    std::optional<std::vector<float>> runBatch(
+        const std::vector<float>& inputTensor,
+        int batchSize
+    );
+    
+    /**
+     * @brief Run a batch writing the output into a caller-owned buffer
+     * 
+     * No per-call allocation: the input is wrapped in place and the model
+     * writes directly into `output`, which must hold
+     * batchSize x outputSampleSize() floats. Requires a model whose
+     * non-batch output dims are known at load time.
+     * 
+     * @param input batchSize x sampleSize() floats
+     * @return false on error (see lastError())
+     */
+    bool runInto(const float* input, int batchSize, float* output, size_t outputSize);
+    
+    /**
+     * @brief Run a token-id model such as a CLIP text encoder
+     *
+     * Inputs are [batchSize, sequenceLength]. Inputs whose name contains
+     * "mask" receive attentionMask, every other input the token ids;
+     * int32 inputs get a narrowed copy. Reads the "text_embeds" output
+     * when the model has one, otherwise the first output.
+     *
+     * @param tokenIds batchSize x sequenceLength ids, row-major
+     * @param attentionMask Same layout as tokenIds (1 = token, 0 = padding)
+     * @return Outputs concatenated in sample order, or empty if error
+     */
+    std::optional<std::vector<float>> runTokens(
+        const std::vector<int64_t>& tokenIds,
+        const std::vector<int64_t>& attentionMask,
+        int batchSize
+    );
+
+    /**
+     * @brief Number of floats one sample produces, or 0 if the output shape is dynamic
+     */
+    size_t outputSampleSize() const;
+    
+    /**
+     * @brief Whether the model's first input axis is dynamic (accepts any batch)
+     */
+    bool supportsDynamicBatch() const { return m_dynamicBatch; }
+    
+    /**
+     * @brief Number of floats in one preprocessed sample (C x H x W)
+     */
+    size_t sampleSize() const;
+    
     /**
      * @brief Get error message from last operation
      */
@@ -116,11 +220,45 @@ private:
     // Model metadata
     std::vector<int64_t> m_inputShape;
     std::vector<int64_t> m_outputShape;
+    bool m_dynamicBatch = false;
     bool m_loaded = false;
+    Provider m_provider = Provider::CPU;
     QString m_lastError;
     
+    // Cached at load time so a run does no name lookups
+    std::string m_inputName;
+    std::string m_outputName;
+
+    // All inputs, for models fed more than one tensor (runTokens)
+    std::vector<std::string> m_inputNames;
+    std::vector<int> m_inputTypes;  // ONNXTensorElementDataType
+    std::string m_tokenOutputName;
+
+    // Per-run shapes, reused so runs don't allocate
+    std::vector<int64_t> m_runInputShape;
+    std::vector<int64_t> m_runOutputShape;
+    
+    // One session->Run on `input`; writes into `output` when given,
+    // otherwise copies the runtime-allocated result into *allocatedOutput
+    bool run(const float* input, int batchSize,
+             float* output, size_t outputSize,
+             std::vector<float>* allocatedOutput);
+    
     // Initialize ONNX Runtime environment (called once)
     void initializeEnvironment();
+    
+    // New session on `provider`, through the cache in `cacheDir` when given;
+    // throws Ort::Exception
+    void createSession(const QString& modelPath, Provider provider,
+                       const SessionConfig& config, const QString& cacheDir);
+    void readModelInfo(const QString& modelPath);
+    
+    // Best of a few timed runs at `batchSize`, in ms; negative if a run failed
+    double benchmark(int batchSize);
+    static std::vector<Provider> availableProviders();
+    
+    static constexpr int BENCHMARK_RUNS = 3;
+    static constexpr int BENCHMARK_SEQUENCE = 77;  // CLIP text context length
 };
 
 } // namespace PhotoGuru
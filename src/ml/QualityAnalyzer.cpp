@@ -0,0 +1,267 @@
+#include "QualityAnalyzer.h"
+#include "core/ImageLoader.h"
+#include "core/MetadataWriter.h"
+#include "core/PhotoDatabase.h"
+#include "core/PhotoMetadata.h"
+#include "core/PixelBuffer.h"
+#include "core/ResourceGovernor.h"
+#include "core/Trace.h"
+#include <QFileInfo>
+#include <QHash>
+#include <QThread>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace PhotoGuru {
+
+namespace {
+
+constexpr int HIGHLIGHT_LEVEL = 250;  // 8-bit luminance at or above: blown
+constexpr int SHADOW_LEVEL = 5;       // At or below: blocked
+
+} // namespace
+
+void QualityAnalyzer::Scores::applyTo(TechnicalMetadata& technical) const {
+    technical.sharpness_score = sharpness;
+    technical.exposure_quality = exposure;
+    technical.blur_detected = blurry;
+    technical.highlights_clipped = highlightsClipped;
+    technical.shadows_blocked = shadowsBlocked;
+}
+
+std::optional<QualityAnalyzer::Scores> QualityAnalyzer::Scores::fromTechnical(const TechnicalMetadata& technical) {
+    if (technical.sharpness_score <= 0.0) return std::nullopt;
+    Scores scores;
+    scores.sharpness = technical.sharpness_score;
+    scores.exposure = technical.exposure_quality;
+    scores.blurry = technical.blur_detected;
+    scores.highlightsClipped = technical.highlights_clipped;
+    scores.shadowsBlocked = technical.shadows_blocked;
+    return scores;
+}
+
+QualityAnalyzer::Stages QualityAnalyzer::defaultStages() {
+    Stages stages;
+
+    // Bounded decode: JPEG scales while decoding, RAW/HEIF use their previews
+    stages.decode = [](const QString& path) -> QImage {
+        const QSize bound(ANALYSIS_SIZE, ANALYSIS_SIZE);
+        auto image = ImageLoader::instance().load(path, bound);
+        if (!image || image->isNull()) return QImage();
+        if (image->width() > ANALYSIS_SIZE || image->height() > ANALYSIS_SIZE) {
+            return image->scaled(bound, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+        return *image;
+    };
+
+    // Catalog entries are kept whole, so files it doesn't know yet are read
+    // first; then one ExifTool call writes the batch and the catalog follows
+    stages.write = [](const QList<Result>& results) {
+        PhotoDatabase& catalog = PhotoDatabase::instance();
+        QStringList paths;
+        for (const Result& result : results) paths << result.path;
+
+        QHash<QString, PhotoMetadata> known = catalog.loadFreshMetadata(paths);
+        QStringList unknown;
+        for (const QString& path : paths) {
+            if (!known.contains(path)) unknown << path;
+        }
+        if (!unknown.isEmpty()) {
+            for (PhotoMetadata& meta : MetadataReader::instance().readMany(unknown, MetadataReader::FilterSet)) {
+                known.insert(meta.filepath, std::move(meta));
+            }
+        }
+
+        std::vector<bool> ok(size_t(results.size()), false);
+        QList<int> indices;
+        QList<MetadataWriter::Transaction> transactions;
+        QList<PhotoMetadata> metas;
+        for (int i = 0; i < results.size(); ++i) {
+            auto it = known.find(results[i].path);
+            if (it == known.end()) continue;
+            results[i].scores.applyTo(it->technical);
+            transactions << MetadataWriter::Transaction(results[i].path).setTechnical(it->technical);
+            metas << *it;
+            indices << i;
+        }
+
+        std::vector<bool> written = MetadataWriter::instance().commitBatch(transactions);
+        QList<PhotoMetadata> stored;
+        for (int i = 0; i < indices.size(); ++i) {
+            if (size_t(i) < written.size() && written[size_t(i)]) {
+                ok[size_t(indices[i])] = true;
+                stored << metas[i];
+            }
+        }
+        catalog.storeMetadataBatch(stored);  // After the write: keyed on the new mtime
+        return ok;
+    };
+
+    return stages;
+}
+
+QualityAnalyzer::QualityAnalyzer(Stages stages, QObject* parent)
+    : QObject(parent)
+    , m_stages(std::move(stages))
+{
+    m_threads = std::max(1, QThread::idealThreadCount());
+    Trace::watchThreadPool("quality", &m_pool);
+}
+
+QualityAnalyzer::~QualityAnalyzer() {
+    Trace::unwatchThreadPool(&m_pool);
+    cancel();
+    wait();
+}
+
+void QualityAnalyzer::setThreads(int threads) {
+    m_threads = std::max(1, threads);
+}
+
+void QualityAnalyzer::start(const QStringList& filePaths) {
+    if (isRunning()) return;
+    wait();  // Previous run may still be unwinding after cancel
+
+    m_files = filePaths;
+    m_nextFile.storeRelaxed(0);
+    m_done.storeRelaxed(0);
+    m_succeeded.storeRelaxed(0);
+    m_failed.storeRelaxed(0);
+    m_cancelled.storeRelaxed(0);
+    m_batch.clear();
+
+    if (m_files.isEmpty()) {
+        emit finished(0, 0, false);
+        return;
+    }
+
+    const int threads = std::min<int>(ResourceGovernor::instance().scaledThreadCount(m_threads),
+                                      m_files.size());
+    m_running.storeRelease(1);
+    m_activeWorkers.storeRelaxed(threads);
+    m_pool.setMaxThreadCount(threads);
+    for (int i = 0; i < threads; ++i) {
+        m_pool.start([this]() { runWorker(); });
+    }
+}
+
+void QualityAnalyzer::cancel() {
+    m_cancelled.storeRelaxed(1);
+}
+
+void QualityAnalyzer::wait() {
+    m_pool.waitForDone();
+}
+
+QualityAnalyzer::Scores QualityAnalyzer::measure(const QImage& image) {
+    Scores scores;
+    if (image.isNull()) return scores;
+
+    const PixelBuffer gray = PixelBuffer(image).converted(QImage::Format_Grayscale8);
+    const cv::Mat luminance = gray.mat();
+
+    // Sharpness: in-focus edges give a wide spread of second derivatives
+    cv::Mat laplacian;
+    cv::Laplacian(luminance, laplacian, CV_16S, 3);
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(laplacian, mean, stddev);
+    scores.laplacianVariance = stddev[0] * stddev[0];
+    scores.sharpness = scores.laplacianVariance / (scores.laplacianVariance + BLUR_VARIANCE);
+    scores.blurry = scores.laplacianVariance < BLUR_VARIANCE;
+
+    // Exposure: luminance histogram
+    cv::Mat histogram;
+    const int channels[] = {0};
+    const int bins[] = {256};
+    const float range[] = {0.0f, 256.0f};
+    const float* ranges[] = {range};
+    cv::calcHist(&luminance, 1, channels, cv::Mat(), histogram, 1, bins, ranges);
+
+    const double pixels = double(luminance.total());
+    double highlights = 0.0;
+    double shadows = 0.0;
+    double sum = 0.0;
+    for (int level = 0; level < 256; ++level) {
+        const double count = histogram.at<float>(level);
+        sum += count * level;
+        if (level >= HIGHLIGHT_LEVEL) highlights += count;
+        if (level <= SHADOW_LEVEL) shadows += count;
+    }
+    scores.highlightFraction = highlights / pixels;
+    scores.shadowFraction = shadows / pixels;
+    scores.highlightsClipped = scores.highlightFraction > CLIPPED_FRACTION;
+    scores.shadowsBlocked = scores.shadowFraction > CLIPPED_FRACTION;
+
+    const double brightness = sum / pixels / 255.0;
+    const double balance = 1.0 - std::abs(brightness - 0.5) * 2.0;
+    const double clipped = scores.highlightFraction + scores.shadowFraction;
+    scores.exposure = std::clamp(balance * (1.0 - clipped), 0.0, 1.0);
+    return scores;
+}
+
+void QualityAnalyzer::runWorker() {
+    const ResourceGovernor& governor = ResourceGovernor::instance();
+    while (!m_cancelled.loadRelaxed()) {
+        governor.waitWhileAIPaused(m_cancelled);
+        if (m_cancelled.loadRelaxed()) break;
+        int index = m_nextFile.fetchAndAddRelaxed(1);
+        if (index >= m_files.size()) break;
+
+        const QString& path = m_files[index];
+        QImage image = m_stages.decode(path);
+        if (image.isNull()) {
+            m_failed.fetchAndAddRelaxed(1);
+            emit log(QString("⚠️ Failed to load: %1").arg(QFileInfo(path).fileName()));
+        } else {
+            Result result{path, measure(image)};
+            emit analyzed(path, result.scores);
+
+            QList<Result> full;
+            {
+                QMutexLocker locker(&m_batchMutex);
+                m_batch << result;
+                if (m_batch.size() >= WRITE_BATCH_SIZE) full.swap(m_batch);
+            }
+            if (!full.isEmpty()) flush(std::move(full));
+        }
+
+        int done = m_done.fetchAndAddRelaxed(1) + 1;
+        emit progress(done, m_files.size(), QFileInfo(path).fileName());
+    }
+
+    // Last worker out writes the remainder and reports the run
+    if (m_activeWorkers.fetchAndAddOrdered(-1) == 1) {
+        QList<Result> rest;
+        {
+            QMutexLocker locker(&m_batchMutex);
+            rest.swap(m_batch);
+        }
+        bool cancelled = m_cancelled.loadRelaxed() != 0;
+        if (!cancelled) flush(std::move(rest));
+
+        m_running.storeRelease(0);
+        emit finished(m_succeeded.loadRelaxed(), m_failed.loadRelaxed(), cancelled);
+    }
+}
+
+void QualityAnalyzer::flush(QList<Result> batch) {
+    if (batch.isEmpty()) return;
+
+    std::vector<bool> written;
+    if (m_stages.write) {
+        written = m_stages.write(batch);
+    } else {
+        written.assign(size_t(batch.size()), true);
+    }
+    for (int i = 0; i < batch.size(); ++i) {
+        if (size_t(i) < written.size() && written[size_t(i)]) {
+            m_succeeded.fetchAndAddRelaxed(1);
+        } else {
+            m_failed.fetchAndAddRelaxed(1);
+            emit log(QString("⚠️ Write failed: %1").arg(QFileInfo(batch[i].path).fileName()));
+        }
+    }
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <QObject>
+#include <QImage>
+#include <QStringList>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace PhotoGuru {
+
+struct TechnicalMetadata;
+
+/**
+ * @brief Background technical-quality scoring into TechnicalMetadata
+ *
+ *   reduced decode (ANALYSIS_SIZE) -> sharpness + exposure -> batched write
+ *
+ * Sharpness is the variance of the Laplacian of the luminance, exposure
+ * comes from its histogram: mean brightness, and the share of pixels
+ * pinned at either end (blown highlights, blocked shadows). Both run on
+ * a decode bounded to ANALYSIS_SIZE, never on the full image, with
+ * OpenCV's vectorised kernels; files are spread over every core.
+ *
+ * Results are written WRITE_BATCH_SIZE files at a time, to the files'
+ * technical metadata and to the catalog, so quality filters have them
+ * without another read. cancel() stops after the files in progress and
+ * drops results not yet written.
+ * Signals are emitted from worker threads.
+ */
+class QualityAnalyzer : public QObject {
+    Q_OBJECT
+
+public:
+    struct Scores {
+        double sharpness = 0.0;       // 0..1, 0.5 at the blur threshold
+        double exposure = 0.0;        // 0..1, 1 = mid-tone mean, nothing clipped
+        double laplacianVariance = 0.0;
+        double highlightFraction = 0.0;
+        double shadowFraction = 0.0;
+        bool blurry = false;
+        bool highlightsClipped = false;
+        bool shadowsBlocked = false;
+
+        // Overwrites the fields above that TechnicalMetadata has
+        void applyTo(TechnicalMetadata& technical) const;
+
+        // What an earlier run stored (the raw measurements aren't); nullopt if never scored
+        static std::optional<Scores> fromTechnical(const TechnicalMetadata& technical);
+    };
+
+    struct Result {
+        QString path;
+        Scores scores;
+    };
+
+    // Stage implementations; defaultStages() wires ImageLoader/MetadataWriter/PhotoDatabase.
+    struct Stages {
+        std::function<QImage(const QString& path)> decode;
+        // One result per file, in order
+        std::function<std::vector<bool>(const QList<Result>& results)> write;
+    };
+
+    static Stages defaultStages();
+
+    explicit QualityAnalyzer(Stages stages, QObject* parent = nullptr);
+    ~QualityAnalyzer();
+
+    void setThreads(int threads);
+
+    // Starts in the background; ignored while a run is active
+    void start(const QStringList& filePaths);
+    void cancel();
+    void wait();
+    bool isRunning() const { return m_running.loadAcquire() != 0; }
+
+    // Null image: all zero
+    static Scores measure(const QImage& image);
+
+    static constexpr int ANALYSIS_SIZE = 512;
+    static constexpr double BLUR_VARIANCE = 60.0;     // Laplacian variance at ANALYSIS_SIZE
+    static constexpr double CLIPPED_FRACTION = 0.02;  // Share of pixels at 250+ / 5-
+    static constexpr int WRITE_BATCH_SIZE = 50;
+
+signals:
+    void progress(int current, int total, const QString& message);
+    void log(const QString& message);
+    void analyzed(const QString& path, const QualityAnalyzer::Scores& scores);
+    void finished(int analyzed, int failed, bool cancelled);
+
+private:
+    void runWorker();
+    void flush(QList<Result> batch);
+
+    Stages m_stages;
+    QThreadPool m_pool;
+    int m_threads = 1;
+
+    QStringList m_files;
+    QAtomicInt m_nextFile{0};
+    QAtomicInt m_activeWorkers{0};
+    QAtomicInt m_done{0};
+    QAtomicInt m_succeeded{0};
+    QAtomicInt m_failed{0};
+    QAtomicInt m_cancelled{0};
+    QAtomicInt m_running{0};
+
+    QMutex m_batchMutex;      // Guards m_batch
+    QList<Result> m_batch;    // Measured, not yet written
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,97 @@
+#include "RemoteInference.h"
+#include "InferenceProtocol.h"
+#include "core/JsonHttpClient.h"
+#include "core/Trace.h"
+#include <QJsonArray>
+#include <QDebug>
+
+namespace PhotoGuru {
+
+RemoteInference::RemoteInference(const QUrl& server, const QString& token)
+    : m_server(server)
+    , m_token(token)
+{
+}
+
+bool RemoteInference::connectToServer(int timeoutMs) {
+    std::optional<QJsonObject> reply = request(InferenceProtocol::INFO_PATH, std::nullopt, timeoutMs);
+    if (!reply) return false;
+
+    Info info = InferenceProtocol::infoFromJson(*reply);
+    if (info.embeddingDim <= 0) {
+        setError("Server has no CLIP model");
+        return false;
+    }
+    QMutexLocker lock(&m_mutex);
+    m_info = info;
+    m_connected = true;
+    qDebug() << "[RemoteInference] Connected to" << m_server.toString() << "- clip" << info.clipVersion
+             << (info.vlmId.isEmpty() ? "without captions" : "with captions");
+    return true;
+}
+
+bool RemoteInference::isConnected() const {
+    QMutexLocker lock(&m_mutex);
+    return m_connected;
+}
+
+InferenceBackend::Info RemoteInference::info() const {
+    QMutexLocker lock(&m_mutex);
+    return m_info;
+}
+
+std::vector<std::optional<std::vector<float>>> RemoteInference::embed(const std::vector<QImage>& images) {
+    std::vector<std::optional<std::vector<float>>> result(images.size());
+    QJsonObject body{{"images", InferenceProtocol::encodeImages(images)}};
+
+    std::optional<QJsonObject> reply;
+    {
+        TRACE_SCOPE("remote.embed_batch");
+        reply = request(InferenceProtocol::EMBED_PATH, body, m_requestTimeoutMs);
+    }
+    if (!reply) return result;
+
+    auto embeddings = InferenceProtocol::decodeEmbeddings(reply->value("embeddings").toArray());
+    for (size_t i = 0; i < result.size() && i < embeddings.size(); ++i) result[i] = std::move(embeddings[i]);
+    return result;
+}
+
+std::vector<std::optional<QString>> RemoteInference::caption(const std::vector<QImage>& images,
+                                                             const LlamaVLM::GenerationOptions& options) {
+    std::vector<std::optional<QString>> result(images.size());
+    QJsonObject body{{"images", InferenceProtocol::encodeImages(images)}};
+    InferenceProtocol::optionsToJson(options, body);
+
+    std::optional<QJsonObject> reply;
+    {
+        TRACE_SCOPE("remote.caption_batch");
+        reply = request(InferenceProtocol::CAPTION_PATH, body, m_requestTimeoutMs);
+    }
+    if (!reply) return result;
+
+    auto captions = InferenceProtocol::decodeCaptions(reply->value("captions").toArray());
+    for (size_t i = 0; i < result.size() && i < captions.size(); ++i) result[i] = std::move(captions[i]);
+    return result;
+}
+
+QString RemoteInference::lastError() const {
+    QMutexLocker lock(&m_mutex);
+    return m_lastError;
+}
+
+std::optional<QJsonObject> RemoteInference::request(const QString& path, const std::optional<QJsonObject>& body,
+                                                    int timeoutMs) {
+    QString error;
+    std::optional<QJsonObject> reply =
+        JsonHttpClient::request(m_server, m_token, path, QUrlQuery(), body, timeoutMs, &error);
+    if (!reply) setError(error);
+    return reply;
+}
+
+void RemoteInference::setError(const QString& error) {
+    qWarning() << "[RemoteInference]" << error;
+    QMutexLocker lock(&m_mutex);
+    m_lastError = error;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "InferenceBackend.h"
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <QUrl>
+#include <optional>
+
+namespace PhotoGuru {
+
+/**
+ * @brief InferenceBackend served by an InferenceServer over HTTP
+ *
+ * For workstations without the GPU (or the memory) for the models: the
+ * pipeline decodes and scales locally, and only the views the models
+ * look at cross the network, one request per batch (InferenceProtocol).
+ * Embeddings land in the local EmbeddingStore, keyed by the server's CLIP
+ * version, so local text search over them needs the same CLIP model.
+ *
+ * Calls block their thread until the server answers, and may come from
+ * several threads at once; each runs its own request.
+ */
+class RemoteInference : public InferenceBackend {
+public:
+    // token, when the server has one, goes out as "Authorization: Bearer <token>"
+    explicit RemoteInference(const QUrl& server, const QString& token = QString());
+
+    // Asks the server what it runs; info() is empty until this succeeds
+    bool connectToServer(int timeoutMs = CONNECT_TIMEOUT_MS);
+    bool isConnected() const;
+    QUrl server() const { return m_server; }
+
+    // Longest wait for one batch (captioning a batch on a busy server is slow)
+    void setRequestTimeout(int ms) { m_requestTimeoutMs = ms; }
+
+    Info info() const override;
+    std::vector<std::optional<std::vector<float>>> embed(const std::vector<QImage>& images) override;
+    std::vector<std::optional<QString>> caption(const std::vector<QImage>& images,
+                                                const LlamaVLM::GenerationOptions& options) override;
+    QString lastError() const override;
+
+    static constexpr int CONNECT_TIMEOUT_MS = 5000;
+    static constexpr int REQUEST_TIMEOUT_MS = 10 * 60 * 1000;
+
+private:
+    // GET when body is null; the reply's JSON, or nullopt with lastError set
+    std::optional<QJsonObject> request(const QString& path, const std::optional<QJsonObject>& body, int timeoutMs);
+    void setError(const QString& error);
+
+    QUrl m_server;
+    QString m_token;
+    int m_requestTimeoutMs = REQUEST_TIMEOUT_MS;
+
+    mutable QMutex m_mutex;  // Guards m_info, m_connected and m_lastError
+    Info m_info;
+    bool m_connected = false;
+    QString m_lastError;
+};
+
+} // namespace PhotoGuru
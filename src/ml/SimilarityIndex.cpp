@@ -0,0 +1,163 @@
+#include "SimilarityIndex.h"
+#include "core/EmbeddingStore.h"
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+namespace PhotoGuru {
+
+SimilarityIndex::SimilarityIndex(const EmbeddingStore* store)
+    : m_store(store)
+    , m_dimension(store->dimension())
+    , m_graph(m_dimension, [this](int id) { return vector(id); })
+{
+}
+
+bool SimilarityIndex::load(const QString& indexPath) {
+    QMutexLocker locker(&m_mutex);
+
+    m_path = indexPath;
+    m_matrix = m_store->matrix();
+    if (!m_graph.load(indexPath, m_store->storeId())) {
+        return false;
+    }
+
+    // Store was truncated (torn tail) below what the graph covers
+    if (m_graph.size() > m_matrix.rows) {
+        qDebug() << "[SimilarityIndex] Graph is ahead of the store, rebuilding";
+        m_graph.clear();
+        return false;
+    }
+
+    qDebug() << "[SimilarityIndex] Loaded graph with" << m_graph.size() << "of" << m_matrix.rows << "rows";
+    return true;
+}
+
+bool SimilarityIndex::save() const {
+    QMutexLocker locker(&m_mutex);
+    if (m_path.isEmpty() || m_graph.size() == 0) {
+        return false;
+    }
+    return m_graph.save(m_path, m_store->storeId());
+}
+
+int SimilarityIndex::sync() {
+    QMutexLocker locker(&m_mutex);
+
+    m_matrix = m_store->matrix();
+    quantizeNewRows();
+
+    // Below the limit every search is an exact scan; don't pay for a graph yet
+    if (m_matrix.rows < EXACT_SEARCH_LIMIT && m_graph.size() == 0) {
+        return 0;
+    }
+
+    int added = 0;
+    while (m_graph.size() < m_matrix.rows) {
+        m_graph.add();
+        ++added;
+    }
+    return added;
+}
+
+std::vector<VectorSearch::Hit> SimilarityIndex::search(const float* query, int k) const {
+    QMutexLocker locker(&m_mutex);
+
+    if (m_graph.size() == 0 || m_store->liveCount() < EXACT_SEARCH_LIMIT) {
+        return exactSearch(query, k);
+    }
+
+    const EmbeddingStore* store = m_store;
+    return m_graph.search(query, k, [store](int id) { return store->isLive(id); });
+}
+
+std::vector<QPair<QString, float>> SimilarityIndex::findSimilar(const std::vector<float>& query, int k) const {
+    std::vector<QPair<QString, float>> matches;
+    if (int(query.size()) != m_dimension) {
+        return matches;
+    }
+
+    for (const VectorSearch::Hit& hit : search(query.data(), k)) {
+        matches.emplace_back(m_store->pathOf(hit.id), hit.score);
+    }
+    return matches;
+}
+
+void SimilarityIndex::setEfSearch(int ef) {
+    QMutexLocker locker(&m_mutex);
+    m_graph.setEfSearch(ef);
+}
+
+int SimilarityIndex::efSearch() const {
+    QMutexLocker locker(&m_mutex);
+    return m_graph.efSearch();
+}
+
+int SimilarityIndex::indexedCount() const {
+    QMutexLocker locker(&m_mutex);
+    return m_graph.size();
+}
+
+void SimilarityIndex::quantizeNewRows() {
+    // A recreated or truncated store invalidates every code
+    const int rows = m_matrix.rows;
+    if (m_codedStoreId != m_store->storeId() || int(m_scales.size()) > rows) {
+        m_codes.clear();
+        m_scales.clear();
+        m_codedStoreId = m_store->storeId();
+    }
+
+    const int coded = int(m_scales.size());
+    if (!m_matrix || coded == rows) {
+        return;
+    }
+    m_codes.resize(size_t(rows) * size_t(m_dimension));
+    m_scales.resize(size_t(rows));
+    for (int id = coded; id < rows; ++id) {
+        m_scales[size_t(id)] = VectorSearch::quantize(vector(id), m_dimension,
+                                                      m_codes.data() + size_t(id) * size_t(m_dimension));
+    }
+}
+
+std::vector<VectorSearch::Hit> SimilarityIndex::exactSearch(const float* query, int k) const {
+    // Held for the scan: rows appended meanwhile may move the store to a new mapping
+    const EmbeddingStore::Matrix current = m_store->matrix();
+    if (!current) {
+        return {};
+    }
+    const float* matrix = current.data;
+    const int rows = current.rows;
+
+    std::vector<float> scores(static_cast<size_t>(rows));
+    const int coded = m_codedStoreId == m_store->storeId() ? std::min(rows, int(m_scales.size())) : 0;
+    if (coded > 0) {
+        std::vector<int8_t> queryCodes(static_cast<size_t>(m_dimension));
+        const float queryScale = VectorSearch::quantize(query, m_dimension, queryCodes.data());
+        VectorSearch::dotRowsInt8(queryCodes.data(), queryScale, m_codes.data(), m_scales.data(),
+                                  coded, m_dimension, scores.data());
+    }
+    // Rows appended since the last sync have no codes yet
+    VectorSearch::dotRows(query, matrix + size_t(coded) * size_t(m_dimension), rows - coded,
+                          m_dimension, scores.data() + coded);
+
+    // Superseded rows sink below any real cosine score
+    constexpr float STALE = -std::numeric_limits<float>::max();
+    for (int id = 0; id < rows; ++id) {
+        if (!m_store->isLive(id)) {
+            scores[size_t(id)] = STALE;
+        }
+    }
+
+    // Approximate scores only pick the candidates; float rows decide the order
+    const int candidates = coded > 0 ? k * RESCORE_FACTOR : k;
+    std::vector<VectorSearch::Hit> hits = VectorSearch::topK(scores.data(), rows, candidates);
+    while (!hits.empty() && hits.back().score == STALE) {
+        hits.pop_back();
+    }
+    if (coded > 0) {
+        hits = VectorSearch::rescore(query, matrix, m_dimension, std::move(hits), k);
+    }
+    return hits;
+}
+
+} // namespace PhotoGuru
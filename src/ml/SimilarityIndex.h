@@ -0,0 +1,73 @@
+#pragma once
+
+#include "HnswIndex.h"
+#include "VectorSearch.h"
+#include "core/EmbeddingStore.h"
+#include <QString>
+#include <QPair>
+#include <QMutex>
+#include <cstdint>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Nearest-neighbour search over the persistent EmbeddingStore
+ *
+ * Small stores are scanned exactly (SIMD dot products + partial top-k);
+ * past EXACT_SEARCH_LIMIT live rows an HNSW graph takes over. The scan
+ * reads an int8 copy of the rows, kept in memory by sync() at a quarter
+ * of the float32 size, and rescores the best RESCORE_FACTOR x k of them
+ * against the store's float rows, which stay on disk until touched. The graph is
+ * grown incrementally by sync() as rows are appended to the store and is
+ * saved next to it, tagged with the store id so a discarded store never
+ * reuses a stale graph. Rows superseded by a re-embedded file are skipped.
+ *
+ * Thread-safe; the store must be open and outlive the index.
+ */
+class SimilarityIndex {
+public:
+    explicit SimilarityIndex(const EmbeddingStore* store);
+
+    // Loads the graph saved at indexPath, if it still matches the store
+    bool load(const QString& indexPath);
+    bool save() const;
+
+    // Links rows the store gained since the last sync; returns how many
+    int sync();
+
+    // Best k live rows for a normalized query, best first
+    std::vector<VectorSearch::Hit> search(const float* query, int k) const;
+    std::vector<QPair<QString, float>> findSimilar(const std::vector<float>& query, int k) const;
+
+    // Recall/latency knob for the graph search (HnswIndex::efSearch)
+    void setEfSearch(int ef);
+    int efSearch() const;
+
+    int indexedCount() const;
+
+    static constexpr int EXACT_SEARCH_LIMIT = 10000;
+    static constexpr int RESCORE_FACTOR = 4;  // Candidates per result taken from the int8 scan
+
+private:
+    const float* vector(int id) const { return m_matrix.row(id); }
+    std::vector<VectorSearch::Hit> exactSearch(const float* query, int k) const;
+    void quantizeNewRows();
+
+    const EmbeddingStore* m_store;
+    int m_dimension;
+    HnswIndex m_graph;
+    QString m_path;
+
+    // Store rows as of the last sync; covers every row in the graph
+    EmbeddingStore::Matrix m_matrix;
+
+    // int8 codes and scales for rows [0, m_scales.size()) of store m_codedStoreId
+    std::vector<int8_t> m_codes;
+    std::vector<float> m_scales;
+    quint64 m_codedStoreId = 0;
+
+    mutable QMutex m_mutex;
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,306 @@
+#include "VectorSearch.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PG_DOT_NEON 1
+#if defined(__aarch64__)
+#define PG_NEON_FMA vfmaq_f32
+#else
+#define PG_NEON_FMA vmlaq_f32
+#endif
+#elif defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define PG_DOT_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PG_DOT_SSE2 1
+#endif
+
+namespace PhotoGuru {
+
+namespace {
+
+// Heap ordered by betterHit keeps the weakest of the current top k at the front
+bool betterHit(const VectorSearch::Hit& a, const VectorSearch::Hit& b) {
+    return a.score > b.score || (a.score == b.score && a.id < b.id);
+}
+
+constexpr int INT8_BLOCK = 4;  // Rows per dotRowsInt8 pass
+
+#if defined(PG_DOT_NEON)
+// 16 products into the int32 lanes; each pair of int8 products fits int16
+inline int32x4_t accumulateInt8(int32x4_t acc, int8x16_t a, int8x16_t b) {
+#if defined(__ARM_FEATURE_DOTPROD)
+    return vdotq_s32(acc, a, b);
+#else
+    int16x8_t products = vmull_s8(vget_low_s8(a), vget_low_s8(b));
+    products = vmlal_s8(products, vget_high_s8(a), vget_high_s8(b));
+    return vpadalq_s16(acc, products);
+#endif
+}
+
+inline int32_t sumLanes(int32x4_t acc) {
+#if defined(__aarch64__)
+    return vaddvq_s32(acc);
+#else
+    int32_t lanes[4];
+    vst1q_s32(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+}
+#elif defined(PG_DOT_AVX2)
+// maddubs multiplies unsigned by signed bytes: move a's sign onto b. Codes
+// stop at -127, so |a| fits, and a pair of products fits int16.
+inline __m256i accumulateInt8(__m256i acc, __m256i aAbs, __m256i a, __m256i b) {
+    const __m256i pairs = _mm256_maddubs_epi16(aAbs, _mm256_sign_epi8(b, a));
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, _mm256_set1_epi16(1)));
+}
+
+inline int32_t sumLanes(__m256i acc) {
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+#elif defined(PG_DOT_SSE2)
+// No byte multiply before SSSE3: widen to int16 and use madd
+inline __m128i accumulateInt8(__m128i acc, __m128i a, __m128i b) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i aSign = _mm_cmpgt_epi8(zero, a);
+    const __m128i bSign = _mm_cmpgt_epi8(zero, b);
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi8(a, aSign), _mm_unpacklo_epi8(b, bSign)));
+    return _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpackhi_epi8(a, aSign), _mm_unpackhi_epi8(b, bSign)));
+}
+
+inline int32_t sumLanes(__m128i acc) {
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(acc);
+}
+#endif
+
+// Four rows against one query; out[j] = dot(query, rows[j])
+void dotBlockInt8(const int8_t* query, const int8_t* const* rows, int dim, int32_t* out) {
+    int i = 0;
+#if defined(PG_DOT_NEON)
+    int32x4_t acc[INT8_BLOCK] = {vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0)};
+    for (; i + 16 <= dim; i += 16) {
+        const int8x16_t q = vld1q_s8(query + i);
+        for (int j = 0; j < INT8_BLOCK; ++j) {
+            acc[j] = accumulateInt8(acc[j], q, vld1q_s8(rows[j] + i));
+        }
+    }
+    for (int j = 0; j < INT8_BLOCK; ++j) out[j] = sumLanes(acc[j]);
+#elif defined(PG_DOT_AVX2)
+    __m256i acc[INT8_BLOCK] = {_mm256_setzero_si256(), _mm256_setzero_si256(),
+                               _mm256_setzero_si256(), _mm256_setzero_si256()};
+    for (; i + 32 <= dim; i += 32) {
+        const __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(query + i));
+        const __m256i qAbs = _mm256_abs_epi8(q);
+        for (int j = 0; j < INT8_BLOCK; ++j) {
+            const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[j] + i));
+            acc[j] = accumulateInt8(acc[j], qAbs, q, r);
+        }
+    }
+    for (int j = 0; j < INT8_BLOCK; ++j) out[j] = sumLanes(acc[j]);
+#elif defined(PG_DOT_SSE2)
+    __m128i acc[INT8_BLOCK] = {_mm_setzero_si128(), _mm_setzero_si128(),
+                               _mm_setzero_si128(), _mm_setzero_si128()};
+    for (; i + 16 <= dim; i += 16) {
+        const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(query + i));
+        for (int j = 0; j < INT8_BLOCK; ++j) {
+            acc[j] = accumulateInt8(acc[j], q, _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[j] + i)));
+        }
+    }
+    for (int j = 0; j < INT8_BLOCK; ++j) out[j] = sumLanes(acc[j]);
+#else
+    for (int j = 0; j < INT8_BLOCK; ++j) out[j] = 0;
+#endif
+
+    for (int j = 0; j < INT8_BLOCK; ++j) {
+        out[j] += VectorSearch::dotInt8Scalar(query + i, rows[j] + i, dim - i);
+    }
+}
+
+} // namespace
+
+float VectorSearch::dotScalar(const float* a, const float* b, int dim) {
+    float sum = 0.0f;
+    for (int i = 0; i < dim; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+float VectorSearch::dot(const float* a, const float* b, int dim) {
+    int i = 0;
+    float sum = 0.0f;
+
+    // Four independent accumulators hide the add latency
+#if defined(PG_DOT_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    for (; i + 16 <= dim; i += 16) {
+        acc0 = PG_NEON_FMA(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = PG_NEON_FMA(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        acc2 = PG_NEON_FMA(acc2, vld1q_f32(a + i + 8), vld1q_f32(b + i + 8));
+        acc3 = PG_NEON_FMA(acc3, vld1q_f32(a + i + 12), vld1q_f32(b + i + 12));
+    }
+    float32x4_t acc = vaddq_f32(vaddq_f32(acc0, acc1), vaddq_f32(acc2, acc3));
+    float lanes[4];
+    vst1q_f32(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(PG_DOT_AVX2)
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    for (; i + 32 <= dim; i += 32) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+    }
+    __m256 acc = _mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3));
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc);
+    sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) +
+          ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+#elif defined(PG_DOT_SSE2)
+    __m128 acc0 = _mm_setzero_ps(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    for (; i + 16 <= dim; i += 16) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(a + i + 8), _mm_loadu_ps(b + i + 8)));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(a + i + 12), _mm_loadu_ps(b + i + 12)));
+    }
+    __m128 acc = _mm_add_ps(_mm_add_ps(acc0, acc1), _mm_add_ps(acc2, acc3));
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+
+    for (; i < dim; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void VectorSearch::dotRows(const float* query, const float* matrix, int rows, int dim, float* scores) {
+    for (int r = 0; r < rows; ++r) {
+        scores[r] = dot(query, matrix + size_t(r) * size_t(dim), dim);
+    }
+}
+
+std::vector<VectorSearch::Hit> VectorSearch::topK(const float* scores, int count, int k) {
+    k = std::min(k, count);
+    std::vector<Hit> heap;
+    if (k <= 0) {
+        return heap;
+    }
+    heap.reserve(size_t(k));
+
+    for (int i = 0; i < count; ++i) {
+        Hit hit{i, scores[i]};
+        if (int(heap.size()) < k) {
+            heap.push_back(hit);
+            std::push_heap(heap.begin(), heap.end(), betterHit);
+        } else if (betterHit(hit, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), betterHit);
+            heap.back() = hit;
+            std::push_heap(heap.begin(), heap.end(), betterHit);
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), betterHit);
+    return heap;
+}
+
+std::vector<VectorSearch::Hit> VectorSearch::exactSearch(const float* query, const float* matrix,
+                                                         int rows, int dim, int k) {
+    std::vector<float> scores(size_t(std::max(0, rows)));
+    dotRows(query, matrix, rows, dim, scores.data());
+    return topK(scores.data(), rows, k);
+}
+
+float VectorSearch::quantize(const float* row, int dim, int8_t* codes) {
+    float peak = 0.0f;
+    for (int i = 0; i < dim; ++i) {
+        peak = std::max(peak, std::abs(row[i]));
+    }
+    if (peak == 0.0f) {
+        std::fill(codes, codes + dim, int8_t(0));
+        return 0.0f;
+    }
+
+    const float inverse = 127.0f / peak;
+    for (int i = 0; i < dim; ++i) {
+        codes[i] = int8_t(std::clamp(std::lrint(row[i] * inverse), -127L, 127L));
+    }
+    return peak / 127.0f;
+}
+
+int32_t VectorSearch::dotInt8Scalar(const int8_t* a, const int8_t* b, int dim) {
+    int32_t sum = 0;
+    for (int i = 0; i < dim; ++i) {
+        sum += int32_t(a[i]) * int32_t(b[i]);
+    }
+    return sum;
+}
+
+int32_t VectorSearch::dotInt8(const int8_t* a, const int8_t* b, int dim) {
+    int i = 0;
+    int32_t sum = 0;
+#if defined(PG_DOT_NEON)
+    int32x4_t acc = vdupq_n_s32(0);
+    for (; i + 16 <= dim; i += 16) {
+        acc = accumulateInt8(acc, vld1q_s8(a + i), vld1q_s8(b + i));
+    }
+    sum = sumLanes(acc);
+#elif defined(PG_DOT_AVX2)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 32 <= dim; i += 32) {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        acc = accumulateInt8(acc, _mm256_abs_epi8(va), va, vb);
+    }
+    sum = sumLanes(acc);
+#elif defined(PG_DOT_SSE2)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= dim; i += 16) {
+        acc = accumulateInt8(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+    }
+    sum = sumLanes(acc);
+#endif
+    return sum + dotInt8Scalar(a + i, b + i, dim - i);
+}
+
+void VectorSearch::dotRowsInt8(const int8_t* query, float queryScale, const int8_t* codes,
+                               const float* scales, int rows, int dim, float* scores) {
+    int r = 0;
+    for (; r + INT8_BLOCK <= rows; r += INT8_BLOCK) {
+        const int8_t* block[INT8_BLOCK];
+        for (int j = 0; j < INT8_BLOCK; ++j) block[j] = codes + size_t(r + j) * size_t(dim);
+        int32_t dots[INT8_BLOCK];
+        dotBlockInt8(query, block, dim, dots);
+        for (int j = 0; j < INT8_BLOCK; ++j) {
+            scores[r + j] = queryScale * scales[r + j] * float(dots[j]);
+        }
+    }
+    for (; r < rows; ++r) {
+        scores[r] = queryScale * scales[r] * float(dotInt8(query, codes + size_t(r) * size_t(dim), dim));
+    }
+}
+
+std::vector<VectorSearch::Hit> VectorSearch::rescore(const float* query, const float* matrix, int dim,
+                                                     std::vector<Hit> hits, int k) {
+    for (Hit& hit : hits) {
+        hit.score = dot(query, matrix + size_t(hit.id) * size_t(dim), dim);
+    }
+    std::sort(hits.begin(), hits.end(), betterHit);
+    if (int(hits.size()) > k) {
+        hits.resize(size_t(std::max(0, k)));
+    }
+    return hits;
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Exact similarity search over L2-normalized embeddings
+ *
+ * Dot products run with NEON, AVX2+FMA or SSE2 (whichever the build
+ * targets) and top-k uses a bounded heap, O(N log k), instead of sorting
+ * all N scores. Used directly for small sets and as the ground truth /
+ * fallback for HnswIndex.
+ *
+ * Rows can also be scanned as int8 codes (quantize, dotRowsInt8): a
+ * quarter of the bytes of float32, so a scan that is bound by memory
+ * bandwidth runs up to 4x faster. Codes are symmetric per row, in
+ * [-127, 127], and their scores are approximate; rescore() puts the
+ * candidates back in exact order from the float rows.
+ */
+class VectorSearch {
+public:
+    struct Hit {
+        int id = -1;
+        float score = 0.0f;
+    };
+
+    static float dot(const float* a, const float* b, int dim);
+
+    // Portable reference for dot (tests, and builds without SIMD)
+    static float dotScalar(const float* a, const float* b, int dim);
+
+    // scores[i] = dot(query, row i) for a contiguous rows x dim matrix
+    static void dotRows(const float* query, const float* matrix, int rows, int dim, float* scores);
+
+    // k best of scores[0..count), best first; ties keep the lower id first
+    static std::vector<Hit> topK(const float* scores, int count, int k);
+
+    static std::vector<Hit> exactSearch(const float* query, const float* matrix,
+                                        int rows, int dim, int k);
+
+    // Writes dim codes, row[i] ~= scale * codes[i]; returns the scale
+    static float quantize(const float* row, int dim, int8_t* codes);
+
+    static int32_t dotInt8(const int8_t* a, const int8_t* b, int dim);
+    static int32_t dotInt8Scalar(const int8_t* a, const int8_t* b, int dim);
+
+    // scores[i] ~= dot(query, row i) from codes; rows are scored in blocks
+    // of four so each load of the query serves all of them
+    static void dotRowsInt8(const int8_t* query, float queryScale, const int8_t* codes,
+                            const float* scales, int rows, int dim, float* scores);
+
+    // Exact scores of `hits` against the float matrix, best first, at most k
+    static std::vector<Hit> rescore(const float* query, const float* matrix, int dim,
+                                    std::vector<Hit> hits, int k);
+};
+
+} // namespace PhotoGuru
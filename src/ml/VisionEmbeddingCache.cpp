@@ -0,0 +1,171 @@
+#include "VisionEmbeddingCache.h"
+#include "core/Trace.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDebug>
+#include <climits>
+
+namespace PhotoGuru {
+
+namespace {
+
+constexpr quint32 ENTRY_MAGIC = 0x45565047;  // "GPVE"
+constexpr quint32 ENTRY_VERSION = 1;
+
+// Native endianness - local cache, never shared between machines
+struct EntryHeader {
+    quint32 magic;
+    quint32 version;
+    quint64 count;
+};
+
+int costOf(const std::vector<float>& embedding) {
+    return int(qMax<qint64>(1, qint64(embedding.size() * sizeof(float)) / 1024));
+}
+
+} // namespace
+
+VisionEmbeddingCache::VisionEmbeddingCache(qint64 maxMemoryBytes) {
+    setMaxMemoryBytes(maxMemoryBytes);
+}
+
+QString VisionEmbeddingCache::modelId(const QString& modelPath) {
+    QFileInfo fi(modelPath);
+    QByteArray identity = fi.absoluteFilePath().toUtf8();
+    identity += '|' + QByteArray::number(fi.size());
+    identity += '|' + QByteArray::number(fi.lastModified().toMSecsSinceEpoch());
+    return QString::fromLatin1(QCryptographicHash::hash(identity, QCryptographicHash::Sha1).toHex().left(16));
+}
+
+QByteArray VisionEmbeddingCache::imageKey(const QImage& image) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const qint32 header[3] = {image.width(), image.height(), qint32(image.format())};
+    hash.addData(QByteArrayView(reinterpret_cast<const char*>(header), sizeof(header)));
+
+    // Row by row: bytesPerLine may include padding that isn't image content
+    const qsizetype rowBytes = (qsizetype(image.width()) * image.depth() + 7) / 8;
+    for (int y = 0; y < image.height(); ++y) {
+        hash.addData(QByteArrayView(reinterpret_cast<const char*>(image.constScanLine(y)), rowBytes));
+    }
+    return hash.result().toHex();
+}
+
+void VisionEmbeddingCache::setModelId(const QString& id) {
+    QMutexLocker locker(&m_mutex);
+    if (id != m_modelId) {
+        m_memory.clear();
+        m_modelId = id;
+    }
+}
+
+QString VisionEmbeddingCache::currentModelId() const {
+    QMutexLocker locker(&m_mutex);
+    return m_modelId;
+}
+
+void VisionEmbeddingCache::setDiskDirectory(const QString& directory) {
+    QMutexLocker locker(&m_mutex);
+    m_directory = directory;
+}
+
+void VisionEmbeddingCache::setMaxMemoryBytes(qint64 bytes) {
+    QMutexLocker locker(&m_mutex);
+    m_memory.setMaxCost(int(qBound<qint64>(0, bytes / 1024, INT_MAX)));
+}
+
+std::optional<std::vector<float>> VisionEmbeddingCache::find(const QByteArray& key) {
+    QMutexLocker locker(&m_mutex);
+    if (const std::vector<float>* hit = m_memory.object(key)) {
+        TRACE_COUNT("embedding.memory.hit", 1);
+        return *hit;
+    }
+    TRACE_COUNT("embedding.memory.miss", 1);
+    if (m_directory.isEmpty()) {
+        return std::nullopt;
+    }
+
+    auto stored = readDisk(key);
+    if (stored) {
+        TRACE_COUNT("embedding.disk.hit", 1);
+        m_memory.insert(key, new std::vector<float>(*stored), costOf(*stored));
+    } else {
+        TRACE_COUNT("embedding.disk.miss", 1);
+    }
+    return stored;
+}
+
+void VisionEmbeddingCache::insert(const QByteArray& key, const std::vector<float>& embedding) {
+    if (key.isEmpty() || embedding.empty()) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_memory.insert(key, new std::vector<float>(embedding), costOf(embedding));
+    if (!m_directory.isEmpty()) {
+        writeDisk(key, embedding);
+    }
+}
+
+void VisionEmbeddingCache::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_memory.clear();
+}
+
+int VisionEmbeddingCache::count() const {
+    QMutexLocker locker(&m_mutex);
+    return int(m_memory.count());
+}
+
+QString VisionEmbeddingCache::diskPath(const QByteArray& key) const {
+    const QString model = m_modelId.isEmpty() ? QStringLiteral("default") : m_modelId;
+    return m_directory + '/' + model + '/' + QString::fromLatin1(key) + ".emb";
+}
+
+std::optional<std::vector<float>> VisionEmbeddingCache::readDisk(const QByteArray& key) const {
+    QFile file(diskPath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+
+    EntryHeader header;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+        header.magic != ENTRY_MAGIC || header.version != ENTRY_VERSION ||
+        file.size() != qint64(sizeof(header) + header.count * sizeof(float))) {
+        qWarning() << "[VisionEmbeddingCache] Discarding unreadable entry:" << file.fileName();
+        file.remove();
+        return std::nullopt;
+    }
+
+    std::vector<float> embedding(header.count);
+    const qint64 bytes = qint64(embedding.size() * sizeof(float));
+    if (file.read(reinterpret_cast<char*>(embedding.data()), bytes) != bytes) {
+        return std::nullopt;
+    }
+    return embedding;
+}
+
+void VisionEmbeddingCache::writeDisk(const QByteArray& key, const std::vector<float>& embedding) const {
+    const QString path = diskPath(key);
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        qWarning() << "[VisionEmbeddingCache] Cannot create" << QFileInfo(path).absolutePath();
+        return;
+    }
+
+    // Write-then-rename, so a crash never leaves a torn entry behind
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[VisionEmbeddingCache] Cannot write" << path << file.errorString();
+        return;
+    }
+    EntryHeader header = {ENTRY_MAGIC, ENTRY_VERSION, quint64(embedding.size())};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(embedding.data()), qint64(embedding.size() * sizeof(float)));
+    if (!file.commit()) {
+        qWarning() << "[VisionEmbeddingCache] Write failed:" << path << file.errorString();
+    }
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QImage>
+#include <QCache>
+#include <QMutex>
+#include <optional>
+#include <vector>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Vision projector output per image, so an image is encoded once
+ *
+ * Entries are keyed by a hash of the exact pixels fed to the projector;
+ * the cache itself belongs to one projector (setModelId), and switching
+ * models drops the memory tier. Memory is an LRU bounded in bytes. With a
+ * disk directory set, entries are also written to
+ * <directory>/<modelId>/<key>.emb and read back on a memory miss, so they
+ * survive restarts.
+ *
+ * Thread-safe.
+ */
+class VisionEmbeddingCache {
+public:
+    explicit VisionEmbeddingCache(qint64 maxMemoryBytes = DEFAULT_MEMORY_BYTES);
+
+    // Identifies a model file by path + size + mtime; here, the mmproj file
+    static QString modelId(const QString& modelPath);
+
+    // Hash of dimensions + pixels; image should be the projector input
+    static QByteArray imageKey(const QImage& image);
+
+    void setModelId(const QString& id);
+    QString currentModelId() const;
+
+    // Empty disables the disk tier
+    void setDiskDirectory(const QString& directory);
+
+    void setMaxMemoryBytes(qint64 bytes);
+
+    std::optional<std::vector<float>> find(const QByteArray& key);
+    void insert(const QByteArray& key, const std::vector<float>& embedding);
+
+    void clear();  // Memory tier only
+    int count() const;
+
+    static constexpr qint64 DEFAULT_MEMORY_BYTES = qint64(256) * 1024 * 1024;
+
+private:
+    QString diskPath(const QByteArray& key) const;
+    std::optional<std::vector<float>> readDisk(const QByteArray& key) const;
+    void writeDisk(const QByteArray& key, const std::vector<float>& embedding) const;
+
+    // Cost is KB so multi-GB budgets fit QCache's int
+    QCache<QByteArray, std::vector<float>> m_memory;
+    QString m_modelId;
+    QString m_directory;
+    mutable QMutex m_mutex;
+};
+
+} // namespace PhotoGuru
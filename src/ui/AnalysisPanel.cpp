@@ -2,7 +2,21 @@
 #include "DarkTheme.h"
 #include "../ml/CLIPAnalyzer.h"
 #include "../ml/LlamaVLM.h"
+#include "../ml/AnalysisPipeline.h"
+#include "../ml/DuplicateFinder.h"
+#include "../ml/QualityAnalyzer.h"
+#include "../ml/BurstDetector.h"
+#include "../ml/FaceAnalyzer.h"
+#include "../ml/FaceIndexer.h"
+#include "../ml/SimilarityIndex.h"
+#include "../ml/ModelRegistry.h"
+#include "../ml/RemoteInference.h"
 #include "../core/MetadataWriter.h"
+#include "../core/EmbeddingStore.h"
+#include "../core/DecodeContext.h"
+#include "../core/ImageLoader.h"
+#include "../core/PhotoDatabase.h"
+#include "../core/ThumbnailCache.h"
 #include "../core/Logger.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -19,9 +33,18 @@
 #include <QApplication>
 #include <QDesktopServices>
 #include <QUrl>
+#include <QTextCursor>
+#include <QSettings>
+#include <algorithm>
 
 namespace PhotoGuru {
 
+namespace {
+const QString CLIP_MODEL = QStringLiteral("clip");
+const QString VLM_MODEL = QStringLiteral("vlm");
+const QString FACE_MODEL = QStringLiteral("faces");
+}
+
 AnalysisPanel::AnalysisPanel(QWidget* parent, bool shouldInitializeAI)
     : QWidget(parent)
     , m_isAnalyzing(false)
@@ -37,7 +60,11 @@ AnalysisPanel::AnalysisPanel(QWidget* parent, bool shouldInitializeAI)
     }
 }
 
-AnalysisPanel::~AnalysisPanel() = default;
+AnalysisPanel::~AnalysisPanel() {
+    if (m_similarityIndex) {
+        m_similarityIndex->save();
+    }
+}
 
 void AnalysisPanel::setupUI() {
     QVBoxLayout* mainLayout = new QVBoxLayout(this);
@@ -89,6 +116,11 @@ void AnalysisPanel::setupUI() {
     connect(m_detectBurstsBtn, &QPushButton::clicked, this, &AnalysisPanel::onDetectBursts);
     batchLayout->addWidget(m_detectBurstsBtn);
     
+    m_findPeopleBtn = new QPushButton("👤 Find People");
+    m_findPeopleBtn->setToolTip("Detect faces and group them into people");
+    connect(m_findPeopleBtn, &QPushButton::clicked, this, &AnalysisPanel::onFindPeople);
+    batchLayout->addWidget(m_findPeopleBtn);
+    
     m_generateReportBtn = new QPushButton("📊 Generate Quality Report");
     m_generateReportBtn->setToolTip("Create a detailed quality analysis report");
     connect(m_generateReportBtn, &QPushButton::clicked, this, &AnalysisPanel::onGenerateReport);
@@ -160,6 +192,41 @@ void AnalysisPanel::setupUI() {
     mainLayout->addStretch();
 }
 
+std::vector<QPair<QString, float>> AnalysisPanel::searchByText(const QString& query, int k) {
+    std::shared_ptr<CLIPAnalyzer> clip = acquireClip();
+    if (!clip || !clip->isTextInitialized() || !m_similarityIndex) {
+        return {};
+    }
+    
+    auto embedding = clip->computeTextEmbedding(query);
+    if (!embedding) {
+        LOG_WARNING("AnalysisPanel", "Text embedding failed: " + clip->lastError());
+        return {};
+    }
+    
+    m_similarityIndex->sync();  // Pick up rows embedded since the last search
+    return m_similarityIndex->findSimilar(*embedding, k);
+}
+
+std::shared_ptr<FaceAnalyzer> AnalysisPanel::acquireFaces() {
+    ModelRegistry& registry = ModelRegistry::instance();
+    if (!registry.contains(FACE_MODEL)) {
+        return nullptr;
+    }
+    if (!registry.isLoaded(FACE_MODEL)) {
+        m_statusLabel->setText("Loading face models...");
+        QCoreApplication::processEvents();
+    }
+    
+    std::shared_ptr<FaceAnalyzer> faces = registry.acquire<FaceAnalyzer>(FACE_MODEL);
+    if (!faces) {
+        QString error = registry.lastError(FACE_MODEL);
+        LOG_ERROR("AnalysisPanel", "Face models failed to load: " + error);
+        m_logOutput->append("❌ Face models failed to load: " + error);
+    }
+    return faces;
+}
+
 void AnalysisPanel::setCurrentImage(const QString& filepath) {
     m_currentImage = filepath;
     
@@ -197,6 +264,7 @@ void AnalysisPanel::setCurrentDirectory(const QString& dirpath) {
     m_analyzeDirBtn->setEnabled(hasDir && !m_isAnalyzing);
     m_findDuplicatesBtn->setEnabled(hasDir && !m_isAnalyzing);
     m_detectBurstsBtn->setEnabled(hasDir && !m_isAnalyzing);
+    m_findPeopleBtn->setEnabled(hasDir && !m_isAnalyzing);
     m_generateReportBtn->setEnabled(hasDir && !m_isAnalyzing);
 }
 
@@ -207,6 +275,7 @@ void AnalysisPanel::updateButtonStates(bool analyzing) {
     m_analyzeDirBtn->setEnabled(!analyzing && !m_currentDirectory.isEmpty());
     m_findDuplicatesBtn->setEnabled(!analyzing && !m_currentDirectory.isEmpty());
     m_detectBurstsBtn->setEnabled(!analyzing && !m_currentDirectory.isEmpty());
+    m_findPeopleBtn->setEnabled(!analyzing && !m_currentDirectory.isEmpty());
     m_generateReportBtn->setEnabled(!analyzing && !m_currentDirectory.isEmpty());
     
     m_cancelBtn->setEnabled(analyzing);
@@ -254,22 +323,70 @@ void AnalysisPanel::initializeAI() {
         }
     }
     
-    // Initialize CLIP
-    m_clipAnalyzer = std::make_unique<CLIPAnalyzer>();
+    // Models load on first use through the shared registry; CLIP is small
+    // and needed for search, so it starts loading in the background now
+    ModelRegistry& registry = ModelRegistry::instance();
+    QSettings settings("PhotoGuru", "Viewer");
+    const qint64 MB = 1024 * 1024;
+    ModelRegistry::Footprint budget;
+    budget.ramBytes = settings.value("models/ramBudgetMB", 0).toLongLong() * MB;
+    budget.vramBytes = settings.value("models/vramBudgetMB", 0).toLongLong() * MB;
+    registry.setBudget(budget);
+    registry.setIdleTimeout(settings.value("models/idleTimeoutMinutes", 10).toInt() * 60 * 1000);
+    
+    // ONNX sessions: after the first run, the optimized graph and the
+    // provider picked for this machine come from the cache
+    ONNXInference::SessionConfig onnx;
+    onnx.intraOpThreads = settings.value("models/onnxIntraOpThreads", onnx.intraOpThreads).toInt();
+    onnx.interOpThreads = settings.value("models/onnxInterOpThreads", onnx.interOpThreads).toInt();
+    onnx.provider = ONNXInference::providerFromName(settings.value("models/onnxProvider").toString())
+                        .value_or(ONNXInference::Provider::Auto);
+    onnx.cacheDirectory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/onnx";
+    ONNXInference::setDefaultConfig(onnx);
+    
     QString clipModelPath = modelsDir + "/clip-vit-base-patch32.onnx";
-    LOG_INFO("AnalysisPanel", "Loading CLIP from: " + clipModelPath);
-    m_logOutput->append("🔍 Loading CLIP from: " + clipModelPath);
-    if (m_clipAnalyzer->initialize(clipModelPath, true)) {
-        LOG_INFO("AnalysisPanel", "CLIP initialized successfully");
-        m_logOutput->append("✅ CLIP initialized successfully");
+    LOG_INFO("AnalysisPanel", "CLIP model: " + clipModelPath);
+    if (QFileInfo::exists(clipModelPath)) {
+        registry.registerModel<CLIPAnalyzer>(CLIP_MODEL,
+            [modelsDir, clipModelPath](ModelRegistry::Footprint* footprint, QString* error) {
+            auto clip = std::make_unique<CLIPAnalyzer>();
+            if (!clip->initialize(clipModelPath, true)) {
+                *error = clip->lastError();
+                return std::unique_ptr<CLIPAnalyzer>();
+            }
+            footprint->ramBytes = QFileInfo(clipModelPath).size();
+            
+            // Optional text tower for natural-language search
+            QString textModelPath = modelsDir + "/clip-vit-base-patch32-text.onnx";
+            if (QFileInfo::exists(textModelPath) &&
+                clip->initializeText(textModelPath, modelsDir + "/clip-vocab.json",
+                                     modelsDir + "/clip-merges.txt", true)) {
+                footprint->ramBytes += QFileInfo(textModelPath).size();
+            } else {
+                LOG_WARNING("AnalysisPanel", "CLIP text model unavailable - search uses keywords");
+            }
+            return clip;
+        });
+        
+        connect(&registry, &ModelRegistry::modelLoaded, this, [this](const QString& name, bool ok) {
+            if (name != CLIP_MODEL) return;
+            if (ok) {
+                m_logOutput->append("✅ CLIP loaded");
+                if (auto clip = ModelRegistry::instance().acquire<CLIPAnalyzer>(CLIP_MODEL)) {
+                    openEmbeddingStore(*clip);
+                }
+            } else {
+                LOG_ERROR("AnalysisPanel", "CLIP initialization failed: " + ModelRegistry::instance().lastError(CLIP_MODEL));
+                m_logOutput->append("❌ CLIP initialization failed");
+            }
+        });
+        registry.preload(CLIP_MODEL);
+        m_logOutput->append("🔄 Loading CLIP in the background...");
     } else {
-        LOG_ERROR("AnalysisPanel", "CLIP initialization failed");
-        m_logOutput->append("❌ CLIP initialization failed");
-        m_clipAnalyzer.reset();
+        LOG_ERROR("AnalysisPanel", "CLIP model not found: " + clipModelPath);
+        m_logOutput->append("❌ CLIP model not found: " + clipModelPath);
     }
     
-    // Initialize VLM
-    m_llamaVLM = std::make_unique<LlamaVLM>();
     LlamaVLM::ModelConfig config;
     config.modelPath = modelsDir + "/Qwen3VL-4B-Instruct-Q4_K_M.gguf";
     config.mmprojPath = modelsDir + "/mmproj-Qwen3VL-4B-Instruct-Q8_0.gguf";
@@ -281,29 +398,50 @@ void AnalysisPanel::initializeAI() {
     LOG_DEBUG("AnalysisPanel", "MMProj path: " + config.mmprojPath);
     
     if (QFileInfo::exists(config.modelPath) && QFileInfo::exists(config.mmprojPath)) {
-        LOG_INFO("AnalysisPanel", "VLM models found, starting initialization (this may take 30-60s)...");
-        m_logOutput->append("🔄 Loading VLM (this may take 30-60s)...");
-        if (m_llamaVLM->initialize(config)) {
-            LOG_INFO("AnalysisPanel", "VLM initialized successfully");
-            m_logOutput->append("✅ VLM initialized: Qwen3-VL 4B");
-        } else {
-            QString error = m_llamaVLM->lastError();
-            LOG_ERROR("AnalysisPanel", "VLM initialization failed: " + error);
-            m_logOutput->append("❌ VLM initialization failed: " + error);
-            m_llamaVLM.reset();
-        }
+        // Multi-GB: loaded when something first captions, unloaded again when idle
+        registry.registerModel<LlamaVLM>(VLM_MODEL,
+            [config](ModelRegistry::Footprint* footprint, QString* error) {
+            auto vlm = std::make_unique<LlamaVLM>();
+            if (!vlm->initialize(config)) {
+                *error = vlm->lastError();
+                return std::unique_ptr<LlamaVLM>();
+            }
+            vlm->memoryUsage(&footprint->ramBytes, &footprint->vramBytes);
+            return vlm;
+        });
+        LOG_INFO("AnalysisPanel", "VLM registered, loads on first use");
+        m_logOutput->append("✅ VLM available: Qwen3-VL 4B (loads on first use)");
     } else {
         LOG_WARNING("AnalysisPanel", "VLM models not found - skipping");
         LOG_DEBUG("AnalysisPanel", "Model exists: " + QString::number(QFileInfo::exists(config.modelPath)));
         LOG_DEBUG("AnalysisPanel", "MMProj exists: " + QString::number(QFileInfo::exists(config.mmprojPath)));
         m_logOutput->append("⚠️ VLM models not found - skipping");
-        m_llamaVLM.reset();
     }
     
-    m_aiInitialized = (m_clipAnalyzer != nullptr);
+    // Face detector + embedder: small, loaded with the first folder run that uses them
+    const QString faceDetectorPath = modelsDir + "/yolov8n-face.onnx";
+    const QString faceEmbedderPath = modelsDir + "/arcface-w600k-r50.onnx";
+    if (QFileInfo::exists(faceDetectorPath) && QFileInfo::exists(faceEmbedderPath)) {
+        registry.registerModel<FaceAnalyzer>(FACE_MODEL,
+            [faceDetectorPath, faceEmbedderPath](ModelRegistry::Footprint* footprint, QString* error) {
+            auto faces = std::make_unique<FaceAnalyzer>();
+            if (!faces->initialize(faceDetectorPath, faceEmbedderPath, true)) {
+                *error = faces->lastError();
+                return std::unique_ptr<FaceAnalyzer>();
+            }
+            footprint->ramBytes = QFileInfo(faceDetectorPath).size() + QFileInfo(faceEmbedderPath).size();
+            return faces;
+        });
+        m_logOutput->append("✅ Face models available (load on first use)");
+    } else {
+        LOG_WARNING("AnalysisPanel", "Face models not found - people disabled");
+        m_logOutput->append("⚠️ Face models not found - skipping");
+    }
+    
+    m_aiInitialized = registry.contains(CLIP_MODEL);
     
     if (m_aiInitialized) {
-        LOG_INFO("AnalysisPanel", "AI initialization complete - CLIP ready");
+        LOG_INFO("AnalysisPanel", "AI initialization complete - CLIP registered");
         m_logOutput->append("✅ AI initialization complete");
     } else {
         LOG_WARNING("AnalysisPanel", "AI initialization incomplete - some features disabled");
@@ -313,6 +451,68 @@ void AnalysisPanel::initializeAI() {
     LOG_INFO("AnalysisPanel", "=== AI Initialization Finished ===");
 }
 
+std::shared_ptr<CLIPAnalyzer> AnalysisPanel::acquireClip() {
+    ModelRegistry& registry = ModelRegistry::instance();
+    if (!m_aiInitialized || !registry.contains(CLIP_MODEL)) {
+        return nullptr;
+    }
+    if (!registry.isLoaded(CLIP_MODEL)) {
+        m_statusLabel->setText("Loading CLIP...");
+        QCoreApplication::processEvents();
+    }
+    
+    std::shared_ptr<CLIPAnalyzer> clip = registry.acquire<CLIPAnalyzer>(CLIP_MODEL);
+    if (clip) {
+        openEmbeddingStore(*clip);
+    }
+    return clip;
+}
+
+std::shared_ptr<LlamaVLM> AnalysisPanel::acquireVlm() {
+    ModelRegistry& registry = ModelRegistry::instance();
+    if (!registry.contains(VLM_MODEL)) {
+        return nullptr;
+    }
+    if (!registry.isLoaded(VLM_MODEL)) {
+        LOG_INFO("AnalysisPanel", "Loading VLM (this may take 30-60s)...");
+        m_logOutput->append("🔄 Loading VLM (this may take 30-60s)...");
+        m_statusLabel->setText("Loading VLM...");
+        QCoreApplication::processEvents();
+    }
+    
+    std::shared_ptr<LlamaVLM> vlm = registry.acquire<LlamaVLM>(VLM_MODEL);
+    if (!vlm) {
+        QString error = registry.lastError(VLM_MODEL);
+        LOG_ERROR("AnalysisPanel", "VLM initialization failed: " + error);
+        m_logOutput->append("❌ VLM initialization failed: " + error);
+    }
+    return vlm;
+}
+
+void AnalysisPanel::openEmbeddingStore(const CLIPAnalyzer& clip) {
+    CLIPAnalyzer::ModelInfo info = clip.getModelInfo();
+    openEmbeddingStore(info.modelVersion, info.embeddingDim);
+}
+
+void AnalysisPanel::openEmbeddingStore(const QString& modelVersion, int embeddingDim) {
+    if (m_embeddingStore) {
+        return;
+    }
+    
+    // Reuse embeddings of unchanged files from earlier runs
+    m_embeddingStore = std::make_unique<EmbeddingStore>();
+    if (m_embeddingStore->open(QDir::homePath() + "/.photoguru/embeddings",
+                               modelVersion, embeddingDim)) {
+        m_logOutput->append(QString("✅ Embedding store: %1 cached")
+            .arg(m_embeddingStore->liveCount()));
+        m_similarityIndex = std::make_unique<SimilarityIndex>(m_embeddingStore.get());
+        m_similarityIndex->load(QDir::homePath() + "/.photoguru/embeddings/similarity.hnsw");
+    } else {
+        LOG_WARNING("AnalysisPanel", "Embedding store unavailable, embeddings will not persist");
+        m_embeddingStore.reset();
+    }
+}
+
 void AnalysisPanel::onAnalyzeCurrentImage() {
     LOG_INFO("AnalysisPanel", "=== Analyze Current Image - CLICKED ===");
     
@@ -323,7 +523,8 @@ void AnalysisPanel::onAnalyzeCurrentImage() {
     
     LOG_INFO("AnalysisPanel", "Analyzing: " + m_currentImage);
     
-    if (!m_aiInitialized || !m_clipAnalyzer) {
+    std::shared_ptr<CLIPAnalyzer> clip = acquireClip();
+    if (!clip) {
         LOG_ERROR("AnalysisPanel", "AI not initialized");
         return;
     }
@@ -332,9 +533,12 @@ void AnalysisPanel::onAnalyzeCurrentImage() {
     m_statusLabel->setText("Analyzing image...");
     m_logOutput->append("\n🔍 Analyzing: " + QFileInfo(m_currentImage).fileName());
     
-    // Load image
-    QImage image(m_currentImage);
-    if (image.isNull()) {
+    // One decode, bounded to what the largest consumer needs; each step
+    // below takes its own view of it
+    const int clipSize = clip->getModelInfo().inputSize;
+    DecodeContext frame(m_currentImage, std::max({clipSize, int(LlamaVLM::MAX_IMAGE_EDGE),
+                                                  int(QualityAnalyzer::ANALYSIS_SIZE)}));
+    if (frame.isNull()) {
         m_logOutput->append("❌ Failed to load image");
         m_statusLabel->setText("Analysis failed");
         updateButtonStates(false);
@@ -345,7 +549,7 @@ void AnalysisPanel::onAnalyzeCurrentImage() {
     LOG_INFO("AnalysisPanel", "Computing CLIP embeddings...");
     m_statusLabel->setText("Computing CLIP embeddings...");
     auto startTime = QDateTime::currentDateTime();
-    auto embedding = m_clipAnalyzer->computeEmbedding(image);
+    auto embedding = clip->computeEmbedding(frame.squared(clipSize));
     auto elapsed = startTime.msecsTo(QDateTime::currentDateTime());
     
     if (embedding && !embedding->empty()) {
@@ -361,19 +565,40 @@ void AnalysisPanel::onAnalyzeCurrentImage() {
         return;
     }
     
+    // Sharpness and exposure from the same decode; the grid's thumbnail too
+    QualityAnalyzer::Scores quality = QualityAnalyzer::measure(frame.fitted(QualityAnalyzer::ANALYSIS_SIZE));
+    m_logOutput->append(QString("📊 Sharpness %1, exposure %2%3")
+        .arg(quality.sharpness, 0, 'f', 2).arg(quality.exposure, 0, 'f', 2)
+        .arg(quality.blurry ? " (blurry)" : ""));
+    ThumbnailCache::instance().offer(m_currentImage, frame.image());
+    
     // 2. VLM Caption (if available)
     QString caption;
     QString description;
     
-    if (m_llamaVLM) {
+    std::shared_ptr<LlamaVLM> vlm = acquireVlm();
+    if (vlm) {
         LOG_INFO("AnalysisPanel", "Generating VLM caption...");
         m_statusLabel->setText("Generating caption with VLM...");
         m_logOutput->append("🤖 Generating VLM caption (may take 10-30s)...");
+        QImage image = frame.rgb888(LlamaVLM::MAX_IMAGE_EDGE);
         m_logOutput->append(QString("🖼️  Image: %1x%2, format: %3")
             .arg(image.width()).arg(image.height()).arg(image.format()));
         
+        // Stream the caption into the log as it is generated; Cancel stops it
+        m_vlmCancel.storeRelaxed(0);
+        LlamaVLM::GenerationOptions streaming;
+        streaming.cancel = &m_vlmCancel;
+        streaming.onToken = [this](const QString& piece) {
+            m_logOutput->moveCursor(QTextCursor::End);
+            m_logOutput->insertPlainText(piece);
+            QCoreApplication::processEvents();
+            return true;
+        };
+        m_logOutput->append("📝 ");
+        
         auto vlmStart = QDateTime::currentDateTime();
-        auto captionResult = m_llamaVLM->generateCaption(image);
+        auto captionResult = vlm->generateCaption(image, streaming);
         auto vlmElapsed = vlmStart.msecsTo(QDateTime::currentDateTime());
         
         if (captionResult) {
@@ -388,13 +613,17 @@ void AnalysisPanel::onAnalyzeCurrentImage() {
                 // Caption will be saved to metadata below
             }
         } else {
-            QString error = m_llamaVLM->lastError();
+            QString error = vlm->lastError();
             LOG_ERROR("AnalysisPanel", QString("VLM failed after %1ms: %2").arg(vlmElapsed).arg(error));
             m_logOutput->append("⚠️ VLM caption generation failed: " + error);
         }
         
         // Detailed description
-        auto descResult = m_llamaVLM->analyzeImage(image);
+        std::optional<QString> descResult;
+        if (!m_vlmCancel.loadRelaxed()) {
+            m_logOutput->append("📝 ");
+            descResult = vlm->analyzeImage(image, true, streaming);
+        }
         
         if (descResult) {
             description = *descResult;
@@ -438,7 +667,10 @@ void AnalysisPanel::onAnalyzeDirectory() {
     
     LOG_INFO("AnalysisPanel", "Batch analyzing: " + m_currentDirectory);
     
-    if (!m_aiInitialized || !m_clipAnalyzer) {
+    // A configured inference server takes embeddings and captions off this machine
+    QSettings settings("PhotoGuru", "Viewer");
+    const QString server = settings.value("inference/server").toString();
+    if (!m_aiInitialized && server.isEmpty()) {
         LOG_ERROR("AnalysisPanel", "AI not initialized");
         return;
     }
@@ -446,12 +678,9 @@ void AnalysisPanel::onAnalyzeDirectory() {
     updateButtonStates(true);
     m_logOutput->append("\n📁 Batch analyzing directory: " + m_currentDirectory);
     
-    // Get all image files
+    // Get all image files; frames decode through ImageLoader, so RAW too
     QDir dir(m_currentDirectory);
-    QStringList filters;
-    filters << "*.jpg" << "*.jpeg" << "*.JPG" << "*.JPEG"
-            << "*.heic" << "*.HEIC" << "*.png" << "*.PNG";
-    QStringList imageFiles = dir.entryList(filters, QDir::Files);
+    QStringList imageFiles = dir.entryList(ImageLoader::instance().supportedExtensions(), QDir::Files);
     
     if (imageFiles.isEmpty()) {
         m_logOutput->append("⚠️ No images found in directory");
@@ -461,78 +690,133 @@ void AnalysisPanel::onAnalyzeDirectory() {
     }
     
     m_logOutput->append(QString("Found %1 images to analyze").arg(imageFiles.size()));
-    m_progressBar->setMaximum(imageFiles.size());
-    
-    int processed = 0;
-    int succeeded = 0;
-    int failed = 0;
+    m_progressBar->setMaximum(100);
     
+    QStringList filePaths;
     for (const QString& filename : imageFiles) {
-        QString filepath = dir.absoluteFilePath(filename);
-        processed++;
-        
-        m_progressBar->setValue(processed);
-        m_statusLabel->setText(QString("Processing %1/%2: %3")
-            .arg(processed).arg(imageFiles.size()).arg(filename));
-        
-        // Skip if already has metadata and skip option is checked
-        if (m_skipExistingCheckbox->isChecked()) {
-            // TODO: Check if metadata exists
-            // For now, process all
+        filePaths << dir.absoluteFilePath(filename);
+    }
+    
+    if (!server.isEmpty()) {
+        m_remote = std::make_unique<RemoteInference>(QUrl(server), settings.value("inference/token").toString());
+        m_statusLabel->setText("Connecting to " + server + "...");
+        QCoreApplication::processEvents();
+        if (m_remote->connectToServer()) {
+            m_logOutput->append("🌐 Embeddings and captions on " + server);
+        } else {
+            LOG_WARNING("AnalysisPanel", "Inference server unavailable: " + m_remote->lastError());
+            m_logOutput->append("⚠️ Inference server unavailable, using local models: " + m_remote->lastError());
+            m_remote.reset();
         }
-        
-        QImage image(filepath);
-        if (image.isNull()) {
-            m_logOutput->append(QString("⚠️ Failed to load: %1").arg(filename));
-            failed++;
-            continue;
+    }
+    
+    // The run keeps the models it uses loaded until it finishes
+    InferenceBackend::Info models;
+    if (m_remote) {
+        models = m_remote->info();
+        openEmbeddingStore(models.clipVersion, models.embeddingDim);
+        if (m_embeddingStore && m_embeddingStore->modelVersion() != models.clipVersion) {
+            m_logOutput->append("⚠️ The server's CLIP differs from this machine's; embeddings will not be kept");
         }
-        
-        // CLIP embedding
-        auto embedding = m_clipAnalyzer->computeEmbedding(image);
-        if (!embedding || embedding->empty()) {
-            m_logOutput->append(QString("❌ CLIP failed: %1").arg(filename));
-            failed++;
-            continue;
+    } else {
+        m_runClip = acquireClip();
+        if (!m_runClip) {
+            m_logOutput->append("❌ CLIP unavailable: " + ModelRegistry::instance().lastError(CLIP_MODEL));
+            updateButtonStates(false);
+            return;
         }
-        
-        // VLM caption (optional)
-        QString caption;
-        if (m_llamaVLM) {
-            auto captionResult = m_llamaVLM->generateCaption(image);
-            if (captionResult) {
-                caption = *captionResult;
-            }
+        m_runVlm = acquireVlm();
+        models = LocalInference::describe(m_runClip.get(), m_runVlm.get());
+    }
+    m_runFaces = acquireFaces();  // Faces come from the same decode, if the models are there
+    
+    // Progress is checkpointed per file in the catalog, so a cancelled or
+    // crashed run picks up where it stopped. Skipping existing keeps what
+    // earlier runs wrote with these models - no ExifTool call per file to
+    // find out; otherwise the folder starts over.
+    const bool skipExisting = m_skipExistingCheckbox->isChecked();
+    std::optional<PhotoDatabase::AnalysisJob> job = PhotoDatabase::instance().openAnalysisJob(
+        m_currentDirectory, filePaths, AnalysisPipeline::modelStamp(models),
+        !skipExisting);
+    QHash<QString, QString> resumedCaptions;
+    if (job) {
+        QStringList pending;
+        for (const QString& path : filePaths) {
+            const PhotoDatabase::JobFile file = job->files.value(path);
+            if (file.stages & AnalysisPipeline::Written) continue;
+            if (file.stages & AnalysisPipeline::Captioned) resumedCaptions.insert(path, file.caption);
+            pending << path;
         }
-        
-        // Write metadata
-        if (!caption.isEmpty()) {
-            PhotoMetadata metadata;
-            metadata.llm_title = caption;
-            if (MetadataWriter::instance().write(filepath, metadata)) {
-                succeeded++;
-                m_logOutput->append(QString("✅ %1").arg(filename));
-            } else {
-                failed++;
-                m_logOutput->append(QString("⚠️ Write failed: %1").arg(filename));
-            }
-        } else {
-            succeeded++;
-            m_logOutput->append(QString("✅ %1 (CLIP only)").arg(filename));
+        if (pending.size() < filePaths.size()) {
+            m_logOutput->append(QString("%1 %2 of %3 images already analyzed")
+                .arg(job->resumed ? "⏯ Resuming:" : "⏭ Skipping:")
+                .arg(filePaths.size() - pending.size()).arg(filePaths.size()));
         }
-        
-        // Process events to keep UI responsive
-        QCoreApplication::processEvents();
+        filePaths = pending;
+    } else {
+        LOG_WARNING("AnalysisPanel", "Catalog unavailable - this run will not be resumable");
     }
     
-    LOG_INFO("AnalysisPanel", QString("Batch complete: %1 succeeded, %2 failed out of %3 total")
-        .arg(succeeded).arg(failed).arg(processed));
-    m_logOutput->append(QString("\n✅ Batch complete: %1 succeeded, %2 failed")
-        .arg(succeeded).arg(failed));
-    m_statusLabel->setText("Batch analysis complete");
-    m_progressBar->setValue(0);
-    updateButtonStates(false);
-    LOG_INFO("AnalysisPanel", "=== Analyze Directory - COMPLETE ===");
+    // Decode, CLIP, VLM and ExifTool writes run as overlapping stages off
+    // the UI thread; results come back through signals
+    EmbeddingStore* store = m_embeddingStore && m_embeddingStore->modelVersion() == models.clipVersion
+                                ? m_embeddingStore.get() : nullptr;
+    AnalysisPipeline::Stages stages = m_remote
+        ? AnalysisPipeline::defaultStages(m_remote.get(), store, m_runFaces.get())
+        : AnalysisPipeline::defaultStages(m_runClip.get(), m_runVlm.get(), store, m_runFaces.get());
+    if (job) {
+        const qint64 jobId = job->id;
+        stages.cachedCaption = [resumedCaptions](const QString& path) -> std::optional<QString> {
+            auto it = resumedCaptions.constFind(path);
+            if (it == resumedCaptions.constEnd()) return std::nullopt;
+            return it.value();
+        };
+        stages.checkpoint = [jobId](const QString& path, AnalysisPipeline::Checkpoint reached,
+                                    const QString& caption) {
+            PhotoDatabase::instance().checkpointAnalysisFile(jobId, path, reached, caption);
+        };
+    }
+    m_pipeline = std::make_unique<AnalysisPipeline>(std::move(stages));
+    m_pipeline->setBatchSize(models.batchSize);
+    if (!models.vlmId.isEmpty()) {
+        m_pipeline->setCaptionBatchSize(models.captionBatchSize);
+    }
+    
+    connect(m_pipeline.get(), &AnalysisPipeline::progress,
+            this, &AnalysisPanel::onAnalysisProgress);
+    connect(m_pipeline.get(), &AnalysisPipeline::log,
+            this, &AnalysisPanel::onAnalysisLog);
+    connect(m_pipeline.get(), &AnalysisPipeline::finished,
+            this, [this, jobId = job ? std::optional<qint64>(job->id) : std::nullopt]
+                  (int succeeded, int failed, bool cancelled) {
+        int processed = succeeded + failed;
+        LOG_INFO("AnalysisPanel", QString("Batch complete: %1 succeeded, %2 failed out of %3 total")
+            .arg(succeeded).arg(failed).arg(processed));
+        m_logOutput->append(QString("\n%1 Batch %2: %3 succeeded, %4 failed")
+            .arg(cancelled ? "⚠" : "✅")
+            .arg(cancelled ? "cancelled" : "complete")
+            .arg(succeeded).arg(failed));
+        // Failed files stay unwritten in the job and are retried next run
+        if (jobId && !cancelled) {
+            PhotoDatabase::instance().finishAnalysisJob(*jobId);
+        }
+        const bool groupPeople = m_runFaces && !cancelled;
+        m_runClip.reset();
+        m_runVlm.reset();
+        m_runFaces.reset();
+        m_remote.reset();
+        updateButtonStates(false);
+        m_statusLabel->setText(cancelled ? "Batch analysis cancelled" : "Batch analysis complete");
+        LOG_INFO("AnalysisPanel", "=== Analyze Directory - COMPLETE ===");
+        emit directoryAnalysisCompleted();
+        
+        // The run stored the faces it saw; grouping them is what's left
+        if (groupPeople) {
+            onFindPeople();
+        }
+    });
+    
+    m_pipeline->start(filePaths);
 }
 
 void AnalysisPanel::onFindDuplicates() {
@@ -545,11 +829,6 @@ void AnalysisPanel::onFindDuplicates() {
     
     LOG_INFO("AnalysisPanel", "Finding duplicates in: " + m_currentDirectory);
     
-    if (!m_aiInitialized || !m_clipAnalyzer) {
-        LOG_ERROR("AnalysisPanel", "CLIP not initialized");
-        return;
-    }
-    
     updateButtonStates(true);
     m_logOutput->append("\n🔍 Finding duplicates in: " + m_currentDirectory);
     
@@ -566,62 +845,54 @@ void AnalysisPanel::onFindDuplicates() {
         return;
     }
     
-    m_logOutput->append(QString("Computing embeddings for %1 images...").arg(imageFiles.size()));
-    m_progressBar->setMaximum(imageFiles.size());
-    
-    // Compute embeddings for all images
-    QList<QPair<QString, std::vector<float>>> embeddings;
-    for (int i = 0; i < imageFiles.size(); i++) {
-        QString filepath = dir.absoluteFilePath(imageFiles[i]);
-        m_progressBar->setValue(i + 1);
-        m_statusLabel->setText(QString("Computing: %1/%2").arg(i+1).arg(imageFiles.size()));
-        
-        auto embedding = m_clipAnalyzer->computeEmbedding(filepath);
-        if (embedding && !embedding->empty()) {
-            embeddings.append(qMakePair(filepath, *embedding));
-        }
-        
-        QCoreApplication::processEvents();
+    QStringList filePaths;
+    for (const QString& filename : imageFiles) {
+        filePaths << dir.absoluteFilePath(filename);
     }
     
-    m_logOutput->append(QString("✅ Computed %1 embeddings").arg(embeddings.size()));
-    m_logOutput->append("\nSearching for similar pairs (threshold > 0.95)...");
-    
-    // Compare all pairs
-    int duplicatesFound = 0;
-    const float threshold = 0.95f;
-    
-    for (int i = 0; i < embeddings.size(); i++) {
-        for (int j = i + 1; j < embeddings.size(); j++) {
-            float similarity = m_clipAnalyzer->cosineSimilarity(
-                embeddings[i].second, 
-                embeddings[j].second
-            );
-            
-            if (similarity > threshold) {
-                duplicatesFound++;
-                QFileInfo file1(embeddings[i].first);
-                QFileInfo file2(embeddings[j].first);
-                m_logOutput->append(QString("🔗 Similar (%1%%): %2 ↔ %3")
-                    .arg(similarity * 100, 0, 'f', 1)
-                    .arg(file1.fileName())
-                    .arg(file2.fileName()));
-            }
-        }
+    // Perceptual hashes find copies and near-exact versions; CLIP, when
+    // available, only settles the pairs they can't
+    m_runClip = acquireClip();
+    if (!m_runClip) {
+        m_logOutput->append("⚠️ CLIP unavailable, finding exact and near-exact duplicates only");
     }
     
-    if (duplicatesFound == 0) {
-        LOG_INFO("AnalysisPanel", QString("No duplicates found (checked %1 images)").arg(embeddings.size()));
-        m_logOutput->append("\n✅ No duplicates found");
-    } else {
-        LOG_INFO("AnalysisPanel", QString("Found %1 duplicate pairs").arg(duplicatesFound));
-        m_logOutput->append(QString("\n✅ Found %1 duplicate pairs").arg(duplicatesFound));
+    // Hashing, neighbour search and metadata writes run off the UI thread;
+    // only new or changed files are hashed or go through CLIP
+    m_duplicateFinder = std::make_unique<DuplicateFinder>(
+        DuplicateFinder::defaultStages(m_runClip.get(), m_embeddingStore.get()));
+    if (m_runClip) {
+        m_duplicateFinder->setBatchSize(m_runClip->batchSize());
     }
+    m_progressBar->setMaximum(100);
     
-    m_statusLabel->setText("Duplicate search complete");
-    m_progressBar->setValue(0);
-    updateButtonStates(false);
-    LOG_INFO("AnalysisPanel", "=== Find Duplicates - COMPLETE ===");
+    connect(m_duplicateFinder.get(), &DuplicateFinder::progress,
+            this, &AnalysisPanel::onAnalysisProgress);
+    connect(m_duplicateFinder.get(), &DuplicateFinder::log,
+            this, &AnalysisPanel::onAnalysisLog);
+    connect(m_duplicateFinder.get(), &DuplicateFinder::finished,
+            this, [this](int groups, int duplicates, bool cancelled) {
+        if (cancelled) {
+            m_logOutput->append("\n⚠ Duplicate search cancelled");
+        } else if (groups == 0) {
+            LOG_INFO("AnalysisPanel", "No duplicates found");
+            m_logOutput->append("\n✅ No duplicates found");
+        } else {
+            LOG_INFO("AnalysisPanel", QString("Found %1 duplicate groups (%2 images)").arg(groups).arg(duplicates));
+            m_logOutput->append(QString("\n✅ Found %1 duplicate groups (%2 images)").arg(groups).arg(duplicates));
+        }
+        
+        m_runClip.reset();
+        m_statusLabel->setText(cancelled ? "Duplicate search cancelled" : "Duplicate search complete");
+        m_progressBar->setValue(0);
+        updateButtonStates(false);
+        LOG_INFO("AnalysisPanel", "=== Find Duplicates - COMPLETE ===");
+        if (!cancelled) {
+            emit directoryAnalysisCompleted();  // duplicate_group changed on disk
+        }
+    });
+    
+    m_duplicateFinder->start(filePaths);
 }
 
 void AnalysisPanel::onDetectBursts() {
@@ -649,65 +920,115 @@ void AnalysisPanel::onDetectBursts() {
         return;
     }
     
-    // Get file creation times (proxy for capture time)
-    QList<QPair<QString, QDateTime>> imageTimestamps;
+    QStringList filePaths;
     for (const QString& filename : imageFiles) {
-        QString filepath = dir.absoluteFilePath(filename);
-        QFileInfo fileInfo(filepath);
-        imageTimestamps.append(qMakePair(filepath, fileInfo.birthTime()));
+        filePaths << dir.absoluteFilePath(filename);
     }
     
-    // Sort by timestamp
-    std::sort(imageTimestamps.begin(), imageTimestamps.end(),
-        [](const auto& a, const auto& b) { return a.second < b.second; });
-    
-    m_logOutput->append(QString("Analyzing %1 images...").arg(imageTimestamps.size()));
-    
-    // Detect bursts (photos within 5 seconds)
-    const int maxSeconds = 5;
-    const int minPhotos = 3;
-    QList<QStringList> bursts;
-    QStringList currentBurst;
-    currentBurst.append(imageTimestamps[0].first);
+    // Capture times come from the catalog (EXIF, to the millisecond);
+    // stored embeddings split frames that don't look continuous
+    m_logOutput->append(QString("Analyzing %1 images...").arg(filePaths.size()));
+    m_progressBar->setMaximum(100);
     
-    for (int i = 1; i < imageTimestamps.size(); i++) {
-        qint64 deltaSeconds = imageTimestamps[i-1].second.secsTo(imageTimestamps[i].second);
-        
-        if (deltaSeconds <= maxSeconds) {
-            currentBurst.append(imageTimestamps[i].first);
+    m_burstDetector = std::make_unique<BurstDetector>(
+        BurstDetector::defaultStages(m_embeddingStore.get()));
+    connect(m_burstDetector.get(), &BurstDetector::progress,
+            this, &AnalysisPanel::onAnalysisProgress);
+    connect(m_burstDetector.get(), &BurstDetector::log,
+            this, &AnalysisPanel::onAnalysisLog);
+    connect(m_burstDetector.get(), &BurstDetector::finished,
+            this, [this](int bursts, int frames, int written, bool cancelled) {
+        if (cancelled) {
+            m_logOutput->append("\n⚠ Burst detection cancelled");
+        } else if (bursts == 0) {
+            LOG_INFO("AnalysisPanel", "No bursts detected");
+            m_logOutput->append(QString("\n✅ No bursts detected (need %1+ frames within %2s)")
+                .arg(BurstDetector::MIN_BURST_SIZE).arg(BurstDetector::MAX_GAP_MS / 1000));
         } else {
-            if (currentBurst.size() >= minPhotos) {
-                bursts.append(currentBurst);
-            }
-            currentBurst.clear();
-            currentBurst.append(imageTimestamps[i].first);
+            LOG_INFO("AnalysisPanel", QString("Found %1 bursts (%2 frames)").arg(bursts).arg(frames));
+            m_logOutput->append(QString("\n📸 Found %1 bursts (%2 frames), %3 files updated")
+                .arg(bursts).arg(frames).arg(written));
         }
+        
+        m_statusLabel->setText(cancelled ? "Burst detection cancelled" : "Burst detection complete");
+        m_progressBar->setValue(0);
+        updateButtonStates(false);
+        LOG_INFO("AnalysisPanel", "=== Detect Bursts - COMPLETE ===");
+        if (!cancelled && written > 0) {
+            emit directoryAnalysisCompleted();  // burst_group changed on disk
+        }
+    });
+    
+    m_burstDetector->start(filePaths);
+}
+
+void AnalysisPanel::onFindPeople() {
+    LOG_INFO("AnalysisPanel", "=== Find People - CLICKED ===");
+    
+    if (m_currentDirectory.isEmpty()) {
+        LOG_WARNING("AnalysisPanel", "No directory selected");
+        return;
     }
     
-    // Check last burst
-    if (currentBurst.size() >= minPhotos) {
-        bursts.append(currentBurst);
+    updateButtonStates(true);
+    m_logOutput->append("\n👤 Finding people in: " + m_currentDirectory);
+    
+    QDir dir(m_currentDirectory);
+    QStringList filters;
+    filters << "*.jpg" << "*.jpeg" << "*.JPG" << "*.JPEG"
+            << "*.heic" << "*.HEIC" << "*.png" << "*.PNG";
+    QStringList imageFiles = dir.entryList(filters, QDir::Files);
+    
+    if (imageFiles.isEmpty()) {
+        m_logOutput->append("⚠️ No images found");
+        updateButtonStates(false);
+        return;
     }
     
-    if (bursts.isEmpty()) {
-        LOG_INFO("AnalysisPanel", QString("No bursts detected (checked %1 images)").arg(imageTimestamps.size()));
-        m_logOutput->append("\n✅ No bursts detected (need 3+ photos within 5s)");
-    } else {
-        LOG_INFO("AnalysisPanel", QString("Found %1 bursts").arg(bursts.size()));
-        m_logOutput->append(QString("\n📸 Found %1 bursts:").arg(bursts.size()));
-        for (int i = 0; i < bursts.size(); i++) {
-            m_logOutput->append(QString("\nBurst %1 (%2 photos):")
-                .arg(i+1).arg(bursts[i].size()));
-            for (const QString& filepath : bursts[i]) {
-                QFileInfo info(filepath);
-                m_logOutput->append(QString("  • %1").arg(info.fileName()));
-            }
-        }
+    QStringList filePaths;
+    for (const QString& filename : imageFiles) {
+        filePaths << dir.absoluteFilePath(filename);
     }
     
-    m_statusLabel->setText("Burst detection complete");
-    updateButtonStates(false);
-    LOG_INFO("AnalysisPanel", "=== Detect Bursts - COMPLETE ===");
+    m_runFaces = acquireFaces();
+    if (!m_runFaces) {
+        m_logOutput->append("❌ Face models unavailable");
+        updateButtonStates(false);
+        return;
+    }
+    
+    // Files scanned before (here or by a folder analysis) are not decoded
+    // again; new faces join the people the catalog already has
+    m_faceIndexer = std::make_unique<FaceIndexer>(FaceIndexer::defaultStages(m_runFaces.get()));
+    m_faceIndexer->setBatchSize(m_runFaces->batchSize());
+    m_progressBar->setMaximum(100);
+    
+    connect(m_faceIndexer.get(), &FaceIndexer::progress,
+            this, &AnalysisPanel::onAnalysisProgress);
+    connect(m_faceIndexer.get(), &FaceIndexer::log,
+            this, &AnalysisPanel::onAnalysisLog);
+    connect(m_faceIndexer.get(), &FaceIndexer::finished,
+            this, [this](int scanned, int faces, int photosUpdated, bool cancelled) {
+        if (cancelled) {
+            m_logOutput->append("\n⚠ Face search cancelled");
+        } else {
+            LOG_INFO("AnalysisPanel", QString("Faces: %1 images scanned, %2 faces, %3 photos updated")
+                .arg(scanned).arg(faces).arg(photosUpdated));
+            m_logOutput->append(QString("\n👤 %1 images scanned, %2 faces found, %3 photos with new people")
+                .arg(scanned).arg(faces).arg(photosUpdated));
+        }
+        
+        m_runFaces.reset();
+        m_statusLabel->setText(cancelled ? "Face search cancelled" : "Face search complete");
+        m_progressBar->setValue(0);
+        updateButtonStates(false);
+        LOG_INFO("AnalysisPanel", "=== Find People - COMPLETE ===");
+        if (!cancelled && photosUpdated > 0) {
+            emit directoryAnalysisCompleted();  // person keys changed in the catalog
+        }
+    });
+    
+    m_faceIndexer->start(filePaths);
 }
 
 void AnalysisPanel::onGenerateReport() {
@@ -735,84 +1056,132 @@ void AnalysisPanel::onGenerateReport() {
         return;
     }
     
-    m_logOutput->append(QString("Analyzing %1 images...").arg(imageFiles.size()));
-    m_progressBar->setMaximum(imageFiles.size());
-    
-    // Analyze each image
-    struct ImageQuality {
-        QString filename;
-        qint64 filesize;
-        int width;
-        int height;
-        double score;
-    };
+    QStringList filePaths;
+    for (const QString& filename : imageFiles) {
+        filePaths << dir.absoluteFilePath(filename);
+    }
     
-    QList<ImageQuality> qualities;
+    // Files a full analysis already scored keep their cataloged scores;
+    // the rest are measured on reduced decodes across all cores and
+    // written to the files and the catalog as they go
+    m_qualityResults.clear();
+    QHash<QString, PhotoMetadata> known = PhotoDatabase::instance().loadFreshMetadata(filePaths);
+    QStringList toAnalyze;
+    for (const QString& path : filePaths) {
+        auto it = known.constFind(path);
+        auto stored = it != known.constEnd() ? QualityAnalyzer::Scores::fromTechnical(it->technical)
+                                             : std::nullopt;
+        if (stored) {
+            m_qualityResults.append(QualityAnalyzer::Result{path, *stored});
+        } else {
+            toAnalyze << path;
+        }
+    }
+    if (toAnalyze.isEmpty()) {
+        reportQuality();
+        m_statusLabel->setText("Report complete");
+        updateButtonStates(false);
+        LOG_INFO("AnalysisPanel", "=== Generate Report - COMPLETE ===");
+        return;
+    }
+    m_logOutput->append(QString("Analyzing %1 images (%2 already scored)...")
+        .arg(toAnalyze.size()).arg(m_qualityResults.size()));
+    m_progressBar->setMaximum(100);
     
-    for (int i = 0; i < imageFiles.size(); i++) {
-        QString filepath = dir.absoluteFilePath(imageFiles[i]);
-        m_progressBar->setValue(i + 1);
-        m_statusLabel->setText(QString("Analyzing: %1/%2").arg(i+1).arg(imageFiles.size()));
-        
-        QFileInfo fileInfo(filepath);
-        QImage image(filepath);
-        
-        if (image.isNull()) continue;
-        
-        ImageQuality quality;
-        quality.filename = imageFiles[i];
-        quality.filesize = fileInfo.size();
-        quality.width = image.width();
-        quality.height = image.height();
-        
-        // Simple quality heuristic: resolution + filesize
-        double resolutionScore = (image.width() * image.height()) / 1000000.0; // MP
-        double filesizeScore = fileInfo.size() / (1024.0 * 1024.0); // MB
-        quality.score = resolutionScore * 0.7 + filesizeScore * 0.3;
+    m_qualityAnalyzer = std::make_unique<QualityAnalyzer>(QualityAnalyzer::defaultStages());
+    connect(m_qualityAnalyzer.get(), &QualityAnalyzer::progress,
+            this, &AnalysisPanel::onAnalysisProgress);
+    connect(m_qualityAnalyzer.get(), &QualityAnalyzer::log,
+            this, &AnalysisPanel::onAnalysisLog);
+    connect(m_qualityAnalyzer.get(), &QualityAnalyzer::analyzed,
+            this, [this](const QString& path, const QualityAnalyzer::Scores& scores) {
+        m_qualityResults.append(QualityAnalyzer::Result{path, scores});
+    });
+    connect(m_qualityAnalyzer.get(), &QualityAnalyzer::finished,
+            this, [this](int analyzed, int failed, bool cancelled) {
+        if (cancelled) {
+            m_logOutput->append("\n⚠ Quality report cancelled");
+        } else {
+            reportQuality();
+        }
         
-        qualities.append(quality);
-        QCoreApplication::processEvents();
-    }
+        LOG_INFO("AnalysisPanel", QString("Report generated: %1 images analyzed, %2 failed")
+            .arg(analyzed).arg(failed));
+        m_statusLabel->setText(cancelled ? "Report cancelled" : "Report complete");
+        m_progressBar->setValue(0);
+        updateButtonStates(false);
+        LOG_INFO("AnalysisPanel", "=== Generate Report - COMPLETE ===");
+        if (!cancelled) {
+            emit directoryAnalysisCompleted();  // Technical metadata changed on disk
+        }
+    });
     
-    // Sort by score
-    std::sort(qualities.begin(), qualities.end(),
-        [](const ImageQuality& a, const ImageQuality& b) { return a.score > b.score; });
+    m_qualityAnalyzer->start(toAnalyze);
+}
+
+void AnalysisPanel::reportQuality() {
+    // A soft photo can't be rescued; exposure often can
+    auto score = [](const QualityAnalyzer::Scores& scores) {
+        return scores.sharpness * 0.6 + scores.exposure * 0.4;
+    };
+    std::sort(m_qualityResults.begin(), m_qualityResults.end(),
+        [&score](const QualityAnalyzer::Result& a, const QualityAnalyzer::Result& b) {
+            return score(a.scores) > score(b.scores);
+        });
+    
+    int blurry = 0;
+    int clipped = 0;
+    for (const QualityAnalyzer::Result& result : m_qualityResults) {
+        if (result.scores.blurry) ++blurry;
+        if (result.scores.highlightsClipped || result.scores.shadowsBlocked) ++clipped;
+    }
     
-    // Generate report
     m_logOutput->append("\n📊 Quality Report (sorted by score):");
     m_logOutput->append("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━");
     
-    for (int i = 0; i < qMin(20, qualities.size()); i++) {
-        const auto& q = qualities[i];
+    for (int i = 0; i < qMin(20, m_qualityResults.size()); i++) {
+        const QualityAnalyzer::Result& result = m_qualityResults[i];
+        QStringList flags;
+        if (result.scores.blurry) flags << "blurry";
+        if (result.scores.highlightsClipped) flags << "highlights clipped";
+        if (result.scores.shadowsBlocked) flags << "shadows blocked";
+        
         m_logOutput->append(QString("%1. %2")
             .arg(i+1, 2)
-            .arg(q.filename));
-        m_logOutput->append(QString("   Score: %1 | %2x%3 | %4 MB")
-            .arg(q.score, 0, 'f', 2)
-            .arg(q.width)
-            .arg(q.height)
-            .arg(q.filesize / (1024.0 * 1024.0), 0, 'f', 1));
+            .arg(QFileInfo(result.path).fileName()));
+        m_logOutput->append(QString("   Score: %1 | Sharpness: %2 | Exposure: %3%4")
+            .arg(score(result.scores), 0, 'f', 2)
+            .arg(result.scores.sharpness, 0, 'f', 2)
+            .arg(result.scores.exposure, 0, 'f', 2)
+            .arg(flags.isEmpty() ? QString() : " | " + flags.join(", ")));
     }
     
     m_logOutput->append("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━");
-    m_logOutput->append(QString("Total: %1 images analyzed").arg(qualities.size()));
-    
-    LOG_INFO("AnalysisPanel", QString("Report generated: %1 images analyzed, top %2 shown")
-        .arg(qualities.size()).arg(qMin(20, qualities.size())));
-    m_statusLabel->setText("Report complete");
-    m_progressBar->setValue(0);
-    updateButtonStates(false);
-    LOG_INFO("AnalysisPanel", "=== Generate Report - COMPLETE ===");
+    m_logOutput->append(QString("Total: %1 images analyzed, %2 blurry, %3 with clipping")
+        .arg(m_qualityResults.size()).arg(blurry).arg(clipped));
 }
 
 void AnalysisPanel::onCancelAnalysis() {
     LOG_INFO("AnalysisPanel", "User clicked: Cancel button");
     m_logOutput->append("⚠ Cancelling analysis...");
     m_statusLabel->setText("Cancelling...");
-    updateButtonStates(false);
     
-    // Note: Workers are in separate threads and will clean up automatically
-    // For a production app, would need to track worker references and call cancel()
+    // Pipeline / duplicate finder report through finished(), which resets the buttons
+    if (m_pipeline && m_pipeline->isRunning()) {
+        m_pipeline->cancel();
+    } else if (m_duplicateFinder && m_duplicateFinder->isRunning()) {
+        m_duplicateFinder->cancel();
+    } else if (m_qualityAnalyzer && m_qualityAnalyzer->isRunning()) {
+        m_qualityAnalyzer->cancel();
+    } else if (m_burstDetector && m_burstDetector->isRunning()) {
+        m_burstDetector->cancel();
+    } else if (m_faceIndexer && m_faceIndexer->isRunning()) {
+        m_faceIndexer->cancel();
+    } else {
+        m_vlmCancel.storeRelaxed(1);  // Single-image caption in progress, if any
+        updateButtonStates(false);
+    }
+    
     LOG_INFO("AnalysisPanel", "Analysis cancellation requested");
     m_logOutput->append("Analysis operations will terminate shortly");
 }
@@ -10,12 +10,25 @@
 #include <QCheckBox>
 #include <QString>
 #include <QVBoxLayout>
+#include <QPair>
+#include <QList>
+#include <QAtomicInt>
 #include <memory>
+#include <vector>
+#include "../ml/QualityAnalyzer.h"
 
 namespace PhotoGuru {
 
 class CLIPAnalyzer;
+class FaceAnalyzer;
+class FaceIndexer;
 class LlamaVLM;
+class RemoteInference;
+class AnalysisPipeline;
+class DuplicateFinder;
+class BurstDetector;
+class EmbeddingStore;
+class SimilarityIndex;
 class MetadataWriter;
 
 class AnalysisPanel : public QWidget {
@@ -29,6 +42,10 @@ public:
     void setCurrentDirectory(const QString& dirpath);
     bool isOverwriteEnabled() const;
     
+    // Natural-language search over stored image embeddings (CLIP text tower);
+    // empty when the text model or embedding store is unavailable
+    std::vector<QPair<QString, float>> searchByText(const QString& query, int k);
+    
 signals:
     void overwriteModeChanged(bool enabled);
     void analysisStarted();
@@ -41,6 +58,7 @@ public slots:
     void onAnalyzeDirectory();
     void onFindDuplicates();
     void onDetectBursts();
+    void onFindPeople();
     void onGenerateReport();
     void onCancelAnalysis();
 
@@ -54,16 +72,40 @@ private:
     void updateButtonStates(bool analyzing);
     void initializeAI();
     
+    // Models come from ModelRegistry, loading on first use; null if unavailable
+    std::shared_ptr<CLIPAnalyzer> acquireClip();
+    std::shared_ptr<LlamaVLM> acquireVlm();
+    std::shared_ptr<FaceAnalyzer> acquireFaces();
+    void openEmbeddingStore(const CLIPAnalyzer& clip);
+    void openEmbeddingStore(const QString& modelVersion, int embeddingDim);
+    void reportQuality();  // Log the finished quality run, best first
+    
     // Current context
     QString m_currentImage;
     QString m_currentDirectory;
     bool m_isAnalyzing;
     QString m_lastGeneratedCaption;  // Store last caption for reuse
+    QAtomicInt m_vlmCancel{0};       // Set by Cancel while a single-image caption streams
+    
+    // AI Components, held only while a background run uses them so the
+    // registry can unload idle models
+    std::shared_ptr<CLIPAnalyzer> m_runClip;
+    std::shared_ptr<LlamaVLM> m_runVlm;
+    std::shared_ptr<FaceAnalyzer> m_runFaces;
+    std::unique_ptr<RemoteInference> m_remote;  // Settings' inference/server, while a run uses it
+    bool m_aiInitialized;  // CLIP is registered
+    
+    // CLIP embeddings persisted across runs (~/.photoguru/embeddings)
+    std::unique_ptr<EmbeddingStore> m_embeddingStore;
+    std::unique_ptr<SimilarityIndex> m_similarityIndex;  // Over m_embeddingStore
     
-    // AI Components
-    std::unique_ptr<CLIPAnalyzer> m_clipAnalyzer;
-    std::unique_ptr<LlamaVLM> m_llamaVLM;
-    bool m_aiInitialized;
+    // Background runs; declared after the models and store so they stop first
+    std::unique_ptr<AnalysisPipeline> m_pipeline;
+    std::unique_ptr<DuplicateFinder> m_duplicateFinder;
+    std::unique_ptr<QualityAnalyzer> m_qualityAnalyzer;
+    std::unique_ptr<BurstDetector> m_burstDetector;
+    std::unique_ptr<FaceIndexer> m_faceIndexer;
+    QList<QualityAnalyzer::Result> m_qualityResults;  // Of the running report
     
     // UI Components - Single Image Analysis
     QGroupBox* m_singleImageGroup;
@@ -75,6 +117,7 @@ private:
     QPushButton* m_analyzeDirBtn;
     QPushButton* m_findDuplicatesBtn;
     QPushButton* m_detectBurstsBtn;
+    QPushButton* m_findPeopleBtn;
     QPushButton* m_generateReportBtn;
     QCheckBox* m_overwriteCheckbox;
     QCheckBox* m_skipExistingCheckbox;
@@ -9,125 +9,6 @@
 
 namespace PhotoGuru {
 
-bool FilterCriteria::matchesSearch(const PhotoMetadata& photo) const {
-    if (searchText.isEmpty()) return true;
-    
-    // Split search into multiple terms (space-separated)
-    QStringList searchTerms = searchText.split(' ', Qt::SkipEmptyParts);
-    if (searchTerms.isEmpty()) return true;
-    
-    // Helper to check if text contains ALL search terms (AND logic)
-    auto containsAllTerms = [&](const QString& text) -> bool {
-        if (text.isEmpty()) return false;
-        QString target = searchCaseSensitive ? text : text.toLower();
-        for (const QString& term : searchTerms) {
-            QString searchTerm = searchCaseSensitive ? term : term.toLower();
-            if (!target.contains(searchTerm)) {
-                return false;  // If any term is missing, return false
-            }
-        }
-        return true;  // All terms found
-    };
-    
-    // Search in various metadata fields (OR logic between fields)
-    // LLM-generated content (highest priority)
-    if (containsAllTerms(photo.llm_title)) return true;
-    if (containsAllTerms(photo.llm_description)) return true;
-    if (containsAllTerms(photo.llm_category)) return true;
-    if (containsAllTerms(photo.llm_scene)) return true;
-    if (containsAllTerms(photo.llm_mood)) return true;
-    
-    // Keywords (check each keyword)
-    for (const QString& kw : photo.llm_keywords) {
-        if (containsAllTerms(kw)) return true;
-    }
-    
-    // Location data
-    if (containsAllTerms(photo.location_name)) return true;
-    
-    // Camera info
-    QString cameraInfo = photo.camera_make + " " + photo.camera_model;
-    if (containsAllTerms(cameraInfo)) return true;
-    
-    // Filename (without path)
-    QString filename = photo.filename;
-    if (filename.contains('/')) {
-        filename = filename.mid(filename.lastIndexOf('/') + 1);
-    }
-    if (containsAllTerms(filename)) return true;
-    
-    return false;
-}
-
-bool FilterCriteria::matches(const PhotoMetadata& photo) const {
-    // Text search first
-    if (!matchesSearch(photo)) return false;
-    
-    // Quality filters
-    if (photo.technical.overall_quality < minQuality) return false;
-    if (photo.technical.sharpness_score < minSharpness) return false;
-    if (photo.technical.aesthetic_score < minAesthetic) return false;
-    
-    // Rating filter
-    if (photo.rating < minRating || photo.rating > maxRating) return false;
-    
-    // Content filters
-    if (onlyWithFaces && photo.face_count == 0) return false;
-    if (onlyBestInBurst && !photo.technical.is_best_in_burst) return false;
-    if (excludeDuplicates && !photo.technical.duplicate_group.isEmpty()) return false;
-    if (excludeBlurry && photo.technical.blur_detected) return false;
-    
-    // GPS filter
-    if (onlyWithGPS && (photo.gps_lat == 0.0 || photo.gps_lon == 0.0)) return false;
-    
-    // Camera filter
-    if (!cameras.isEmpty()) {
-        QString fullCamera = photo.camera_make + " " + photo.camera_model;
-        bool found = false;
-        for (const QString& cam : cameras) {
-            if (fullCamera.contains(cam, Qt::CaseInsensitive)) {
-                found = true;
-                break;
-            }
-        }
-        if (!found) return false;
-    }
-    
-    // ISO filter
-    if (photo.iso > 0 && (photo.iso < minISO || photo.iso > maxISO)) return false;
-    
-    // Aperture filter
-    if (photo.aperture > 0.0 && (photo.aperture < minAperture || photo.aperture > maxAperture)) return false;
-    
-    // Focal length filter
-    if (photo.focal_length > 0.0 && (photo.focal_length < minFocalLength || photo.focal_length > maxFocalLength)) return false;
-    
-    // Keywords filter
-    if (!keywords.isEmpty()) {
-        bool found = false;
-        for (const QString& filterKw : keywords) {
-            for (const QString& photoKw : photo.llm_keywords) {
-                if (photoKw.contains(filterKw, Qt::CaseInsensitive)) {
-                    found = true;
-                    break;
-                }
-            }
-            if (found) break;
-        }
-        if (!found) return false;
-    }
-    
-    // Category filter
-    if (!categories.isEmpty() && !categories.contains(photo.llm_category)) return false;
-    if (!scenes.isEmpty() && !scenes.contains(photo.llm_scene)) return false;
-    
-    // Date range
-    if (startDate.isValid() && photo.datetime_original < startDate) return false;
-    if (endDate.isValid() && photo.datetime_original > endDate) return false;
-    
-    return true;
-}
-
 FilterPanel::FilterPanel(QWidget* parent)
     : QWidget(parent)
 {// Create debounce timer for search (300ms delay)
@@ -7,60 +7,10 @@
 #include <QLineEdit>
 #include <QGroupBox>
 #include <QLabel>
-#include "core/PhotoMetadata.h"
+#include "core/FilterCriteria.h"
 
 namespace PhotoGuru {
 
-struct FilterCriteria {
-    // Quality filters
-    double minQuality = 0.0;
-    double minSharpness = 0.0;
-    double minAesthetic = 0.0;
-    
-    // Content filters
-    bool onlyWithFaces = false;
-    bool onlyBestInBurst = false;
-    bool excludeDuplicates = false;
-    bool excludeBlurry = false;
-    
-    // Rating filter
-    int minRating = 0;  // 0-5 stars
-    int maxRating = 5;
-    
-    // Camera/Lens filters
-    QStringList cameras;  // Camera make/model
-    QStringList lenses;   // Lens model
-    
-    // Technical filters
-    int minISO = 0;
-    int maxISO = 102400;
-    double minAperture = 0.0;  // f-stop
-    double maxAperture = 32.0;
-    double minFocalLength = 0.0;
-    double maxFocalLength = 1000.0;
-    double minShutterSpeed = 0.0;
-    double maxShutterSpeed = 10000.0;
-    
-    // Category filters
-    QStringList categories;
-    QStringList scenes;
-    QStringList keywords;  // Filter by keywords/tags
-    
-    // Date range
-    QDateTime startDate;
-    QDateTime endDate;
-    
-    // Location
-    bool onlyWithGPS = false;
-    
-    // Text search (searches in title, description, keywords, location, camera)
-    QString searchText;
-    bool searchCaseSensitive = false;
-    
-    bool matches(const PhotoMetadata& photo) const;
-    bool matchesSearch(const PhotoMetadata& photo) const;
-};
-
 class FilterPanel : public QWidget {
     Q_OBJECT
     
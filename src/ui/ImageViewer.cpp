@@ -1,12 +1,14 @@
 #include "ImageViewer.h"
-#include "../core/ImageLoader.h"
+#include "../core/DecodedImageCache.h"
+#include "../core/FileReadAhead.h"
+#include "../core/MemoryBudget.h"
+#include "../core/ResourceGovernor.h"
+#include "../core/TilePyramid.h"
 #include <QPainter>
 #include <QWheelEvent>
 #include <QMouseEvent>
 #include <QKeyEvent>
 #include <QTimer>
-#include <QtConcurrent>
-#include <QFutureWatcher>
 #include <cmath>
 
 namespace PhotoGuru {
@@ -28,70 +30,168 @@ ImageViewer::ImageViewer(QWidget* parent)
         if (m_autoFit) {
             zoomToFit();
         }
-        m_pixmapCacheDirty = true;
         update();
     });
+    
+    m_decodeCache = new DecodedImageCache(this);
+    connect(m_decodeCache, &DecodedImageCache::previewDecoded, this, &ImageViewer::onPreviewDecoded);
+    connect(m_decodeCache, &DecodedImageCache::decoded, this, &ImageViewer::onImageDecoded);
+    
+    m_pyramid = new TilePyramid(this);
+    connect(m_pyramid, &TilePyramid::levelReady, this, [this]() { update(); });
+    
+    // Full-resolution detail once zoom/pan settles
+    connect(m_decodeCache, &DecodedImageCache::regionDecoded, this, &ImageViewer::onRegionDecoded);
+    m_detailTimer = new QTimer(this);
+    m_detailTimer->setSingleShot(true);
+    m_detailTimer->setInterval(120);
+    connect(m_detailTimer, &QTimer::timeout, this, &ImageViewer::requestDetail);
+    
+    // Prefetched decodes are the first to go under pressure, the tiles on screen later
+    MemoryBudget& budget = MemoryBudget::instance();
+    m_decodeBudgetId = budget.addCache(MemoryBudget::Cache{
+        "decoded images", DECODE_BUDGET_SHARE, 0,
+        [cache = m_decodeCache]() { return cache->usedBytes(); },
+        [cache = m_decodeCache](qint64 bytes) { cache->setMaxBytes(bytes); }});
+    m_tileBudgetId = budget.addCache(MemoryBudget::Cache{
+        "image tiles", TILE_BUDGET_SHARE, 1,
+        [pyramid = m_pyramid]() { return pyramid->tileCacheUsage(); },
+        [pyramid = m_pyramid](qint64 bytes) { pyramid->setTileCacheBytes(bytes); }});
+}
+
+ImageViewer::~ImageViewer() {
+    MemoryBudget::instance().removeCache(m_decodeBudgetId);
+    MemoryBudget::instance().removeCache(m_tileBudgetId);
 }
 
 void ImageViewer::loadImage(const QString& filepath) {
-    // Cancel any pending load
-    if (m_imageWatcher && m_imageWatcher->isRunning()) {
-        m_imageWatcher->cancel();
-        m_imageWatcher->waitForFinished();
+    m_pendingFilepath = filepath;
+    
+    // Prefetched or recently shown: no spinner, no decode
+    QImage cached = m_decodeCache->find(filepath);
+    if (!cached.isNull()) {
+        m_isLoading = false;
+        showImage(cached, filepath);
+        return;
+    }
+    QImage preview = m_decodeCache->findPreview(filepath);
+    if (!preview.isNull()) {
+        m_isLoading = false;
+        showPreview(preview, filepath);
+        return;
     }
     
     // Set loading state and show spinner immediately
     m_isLoading = true;
-    m_pendingFilepath = filepath;
     update();  // Force repaint to show loading spinner
     
-    // Load image asynchronously
-    QFuture<std::optional<QImage>> future = QtConcurrent::run([filepath]() {
-        return ImageLoader::instance().load(filepath, QSize(4000, 4000));
-    });
+    m_decodeCache->requestPreview(filepath);
+}
+
+void ImageViewer::prefetchNeighbours(const QStringList& files, int index) {
+    // Forward first: culling mostly moves to the next image. On a share
+    // the files are read ahead further than they are decoded.
+    QStringList order;
+    QStringList reads;
+    const int reach = qMax(m_prefetchRadius, FileReadAhead::instance().depth());
+    for (int distance = 1; distance <= reach; ++distance) {
+        QStringList ring;
+        if (index + distance < files.size()) ring << files[index + distance];
+        if (index - distance >= 0) ring << files[index - distance];
+        if (distance <= m_prefetchRadius) order << ring;
+        reads << ring;
+    }
+    m_decodeCache->prefetch(order);
+    FileReadAhead::instance().setUpcoming(reads);
+}
+
+void ImageViewer::onPreviewDecoded(const QString& filepath, const QImage& image) {
+    if (!m_isLoading || filepath != m_pendingFilepath) return;
     
-    // Create or reuse watcher
-    if (!m_imageWatcher) {
-        m_imageWatcher = new QFutureWatcher<std::optional<QImage>>(this);
-        connect(m_imageWatcher, &QFutureWatcher<std::optional<QImage>>::finished,
-                this, &ImageViewer::onImageLoadComplete);
+    if (image.isNull()) {
+        // No preview to be had: wait for the full decode instead
+        m_decodeCache->request(filepath);
+        return;
     }
     
-    m_imageWatcher->setFuture(future);
+    m_isLoading = false;
+    showPreview(image, filepath);
 }
 
-void ImageViewer::onImageLoadComplete() {
-    m_isLoading = false;
+void ImageViewer::onImageDecoded(const QString& filepath, const QImage& image) {
+    // Swap the full image in under the preview being shown
+    if (m_showingPreview && filepath == m_filepath) {
+        m_showingPreview = false;
+        if (image.isNull()) return;  // Keep the preview
+        
+        // Same on-screen size: the preview's zoom, in full-image pixels
+        m_zoom *= double(m_image.width()) / image.width();
+        m_image = image;
+        m_pyramid->setImage(image);
+        updateSourceSize();
+        if (m_autoFit) {
+            zoomToFit();
+        } else {
+            emit zoomChanged(m_zoom);
+            update();
+        }
+        return;
+    }
     
-    if (!m_imageWatcher) return;
+    // Prefetches and superseded loads only fill the cache
+    if (!m_isLoading || filepath != m_pendingFilepath) return;
     
-    auto imageOpt = m_imageWatcher->result();
+    m_isLoading = false;
     
-    if (!imageOpt) {
+    if (image.isNull()) {
         m_image = QImage();
-        m_pixmapCache = QPixmap();
+        m_pyramid->clear();
         m_filepath.clear();
+        clearDetail();
         update();
         return;
     }
     
-    m_image = *imageOpt;
-    m_filepath = m_pendingFilepath;
+    showImage(image, filepath);
+}
+
+void ImageViewer::showImage(const QImage& image, const QString& filepath) {
+    m_image = image;
+    m_pyramid->setImage(image);
+    m_filepath = filepath;
+    m_showingPreview = false;
+    m_fullRequested = false;
+    clearDetail();
+    updateSourceSize();
     
     // Always fit new images to window
     m_autoFit = true;
     zoomToFit();
     
-    // PERFORMANCE: Create pixmap cache
-    updatePixmapCache();
-    
     update();
     emit imageLoaded(m_filepath);
 }
 
+void ImageViewer::showPreview(const QImage& image, const QString& filepath) {
+    showImage(image, filepath);
+    m_showingPreview = true;
+    requestFullIfZoomed();
+}
+
+void ImageViewer::requestFullIfZoomed() {
+    // Fitted, the preview has all the pixels the screen shows; past 1:1 it doesn't
+    if (!m_showingPreview || m_fullRequested || m_zoom <= 1.0) return;
+    
+    m_fullRequested = true;
+    m_decodeCache->request(m_filepath);
+}
+
 void ImageViewer::clear() {
     m_image = QImage();
+    m_pyramid->clear();
     m_filepath.clear();
+    m_showingPreview = false;
+    clearDetail();
     update();
 }
 
@@ -115,46 +215,25 @@ void ImageViewer::zoomToFit() {
     m_zoom = std::min(widthRatio, heightRatio);
     
     centerImage();
+    requestFullIfZoomed();
     emit zoomChanged(m_zoom);
     update();
 }
 
 void ImageViewer::zoomActual() {
     m_autoFit = false;
-    setZoom(1.0);
+    setZoom(sourceScale());  // One screen pixel per file pixel, not per decoded pixel
 }
 
 void ImageViewer::setZoom(double factor) {
     m_zoom = std::clamp(factor, 0.01, 20.0);
-    m_pixmapCacheDirty = true;
     updateTransform();
+    requestFullIfZoomed();
+    m_detailTimer->start();
     emit zoomChanged(m_zoom);
     update();
 }
 
-void ImageViewer::updatePixmapCache() {
-    if (m_image.isNull()) {
-        m_pixmapCache = QPixmap();
-        m_pixmapCacheDirty = false;
-        return;
-    }
-    
-    // PERFORMANCE: Create scaled pixmap cache for current zoom level
-    QSize scaledSize = m_image.size() * m_zoom;
-    
-    // Only cache if reasonably sized (avoid huge pixmaps)
-    if (scaledSize.width() <= 4000 && scaledSize.height() <= 4000) {
-        QImage scaled = m_image.scaled(scaledSize, Qt::KeepAspectRatio, 
-            Qt::SmoothTransformation);
-        m_pixmapCache = QPixmap::fromImage(scaled);
-    } else {
-        // For very large zoom, render directly from QImage
-        m_pixmapCache = QPixmap();
-    }
-    
-    m_pixmapCacheDirty = false;
-}
-
 void ImageViewer::updateTransform() {
     if (m_image.isNull()) return;
     centerImage();
@@ -199,29 +278,103 @@ void ImageViewer::paintEvent(QPaintEvent* event) {
         return;
     }
     
-    // PERFORMANCE: Update pixmap cache if needed
-    if (m_pixmapCacheDirty) {
-        updatePixmapCache();
+    drawTiles(painter, event->rect());
+    
+    // Full-resolution pixels over the upscaled decode
+    if (!m_detail.isNull() && m_zoom > 1.0) {
+        const double scale = m_zoom / sourceScale();
+        QRectF target(m_offset.x() + m_detailRect.x() * scale, m_offset.y() + m_detailRect.y() * scale,
+                      m_detailRect.width() * scale, m_detailRect.height() * scale);
+        painter.drawImage(target, m_detail);
+    }
+}
+
+double ImageViewer::sourceScale() const {
+    if (m_image.isNull() || !m_sourceSize.isValid()) return 1.0;
+    return double(m_sourceSize.width()) / m_image.width();
+}
+
+void ImageViewer::updateSourceSize() {
+    m_sourceSize = m_decodeCache->sourceSize(m_filepath);
+    if (!m_sourceSize.isValid() || m_sourceSize.width() < m_image.width()) {
+        m_sourceSize = m_image.size();
+    }
+}
+
+void ImageViewer::requestDetail() {
+    // Only when the screen shows more pixels than the decode holds
+    if (m_image.isNull() || m_zoom <= 1.0 || m_sourceSize.width() <= m_image.width()) {
+        return;
     }
     
-    // Draw image
-    int scaledWidth = int(m_image.width() * m_zoom);
-    int scaledHeight = int(m_image.height() * m_zoom);
+    // Visible area in file pixels, padded so short pans stay covered
+    const double scale = sourceScale() / m_zoom;  // File pixels per screen pixel
+    QRectF visible(-m_offset.x() * scale, -m_offset.y() * scale, width() * scale, height() * scale);
+    QRect region = visible.adjusted(-visible.width() / 4, -visible.height() / 4,
+                                    visible.width() / 4, visible.height() / 4)
+        .toAlignedRect().intersected(QRect(QPoint(0, 0), m_sourceSize));
+    QRect needed = visible.toAlignedRect().intersected(QRect(QPoint(0, 0), m_sourceSize));
+    if (needed.isEmpty() || (!m_detail.isNull() && m_detailRect.contains(needed))) {
+        return;
+    }
     
-    QRect targetRect(m_offset.x(), m_offset.y(), scaledWidth, scaledHeight);
+    m_decodeCache->requestRegion(m_filepath, region);
+}
+
+void ImageViewer::onRegionDecoded(const QString& filepath, const QRect& region, const QImage& image) {
+    if (filepath != m_filepath || image.isNull()) return;
     
-    // PERFORMANCE: Use cached pixmap if available, otherwise draw from QImage
-    if (!m_pixmapCache.isNull()) {
-        painter.drawPixmap(targetRect, m_pixmapCache);
-    } else {
-        // Fallback for very large images
-        painter.drawImage(targetRect, m_image);
+    // One region at a time keeps inspection at a fixed memory cost
+    m_detail = image;
+    m_detailRect = QRect(region.topLeft(), image.size());
+    update();
+}
+
+void ImageViewer::clearDetail() {
+    m_detail = QImage();
+    m_detailRect = QRect();
+    if (m_detailTimer) m_detailTimer->stop();
+}
+
+void ImageViewer::drawTiles(QPainter& painter, const QRect& area) {
+    // PERFORMANCE: Nearest pyramid level, visible tiles only; a level
+    // still being built is stood in for by the finer one before it
+    const int wanted = m_pyramid->levelForZoom(m_zoom);
+    m_pyramid->requestLevel(wanted);
+    const int level = m_pyramid->nearestReadyLevel(wanted);
+    
+    // Level pixels -> widget pixels
+    const QSize levelSize = m_pyramid->levelSize(level);
+    const double scaleX = m_zoom * m_image.width() / levelSize.width();
+    const double scaleY = m_zoom * m_image.height() / levelSize.height();
+    
+    const QRect visible = area.translated(-m_offset);
+    const int tile = TilePyramid::TILE_SIZE;
+    const int firstColumn = std::max(0, int(std::floor(visible.left() / scaleX / tile)));
+    const int lastColumn = std::min(m_pyramid->columns(level) - 1, int(std::floor(visible.right() / scaleX / tile)));
+    const int firstRow = std::max(0, int(std::floor(visible.top() / scaleY / tile)));
+    const int lastRow = std::min(m_pyramid->rows(level) - 1, int(std::floor(visible.bottom() / scaleY / tile)));
+    
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            QRect source = m_pyramid->tileRect(level, column, row);
+            
+            // Rounded per edge so neighbouring tiles meet without gaps
+            int left = m_offset.x() + int(std::lround(source.left() * scaleX));
+            int top = m_offset.y() + int(std::lround(source.top() * scaleY));
+            int right = m_offset.x() + int(std::lround((source.right() + 1) * scaleX));
+            int bottom = m_offset.y() + int(std::lround((source.bottom() + 1) * scaleY));
+            
+            painter.drawImage(QRect(left, top, right - left, bottom - top),
+                              m_pyramid->tile(level, column, row));
+        }
     }
 }
 
 void ImageViewer::wheelEvent(QWheelEvent* event) {
     if (m_image.isNull()) return;
     
+    ResourceGovernor::instance().noteUserActivity();
     m_autoFit = false;
     
     // Zoom factor
@@ -236,6 +389,8 @@ void ImageViewer::wheelEvent(QWheelEvent* event) {
     
     // Adjust offset to keep point under mouse stationary
     m_offset = mousePos - imagePos * (m_zoom / oldZoom);
+    requestFullIfZoomed();
+    m_detailTimer->start();
     
     emit zoomChanged(m_zoom);
     update();
@@ -251,10 +406,12 @@ void ImageViewer::mousePressEvent(QMouseEvent* event) {
 
 void ImageViewer::mouseMoveEvent(QMouseEvent* event) {
     if (m_isPanning) {
+        ResourceGovernor::instance().noteUserActivity();  // AI waits until the pan settles
         QPoint delta = event->pos() - m_lastPanPos;
         m_offset += delta;
         m_lastPanPos = event->pos();
         m_autoFit = false;
+        m_detailTimer->start();
         update();
     }
 }
@@ -267,6 +424,7 @@ void ImageViewer::mouseReleaseEvent(QMouseEvent* event) {
 }
 
 void ImageViewer::keyPressEvent(QKeyEvent* event) {
+    ResourceGovernor::instance().noteUserActivity();
     switch (event->key()) {
         case Qt::Key_Left:
         case Qt::Key_Up:
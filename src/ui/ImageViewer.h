@@ -2,23 +2,39 @@
 
 #include <QWidget>
 #include <QImage>
-#include <QPixmap>
 #include <QString>
 #include <QPoint>
-#include <QFutureWatcher>
-#include <optional>
+#include <QRect>
+#include <QSize>
+#include <QStringList>
 
 namespace PhotoGuru {
 
+class DecodedImageCache;
+class TilePyramid;
+
 class ImageViewer : public QWidget {
     Q_OBJECT
     
 public:
     explicit ImageViewer(QWidget* parent = nullptr);
+    ~ImageViewer() override;
     
+    // Shows the file's preview right away, the full decode once zoomed in
     void loadImage(const QString& filepath);
     void clear();
     
+    // Decodes previews of the files around `index` in the background, nearest first
+    void prefetchNeighbours(const QStringList& files, int index);
+    void setPrefetchRadius(int radius) { m_prefetchRadius = radius; }
+    int prefetchRadius() const { return m_prefetchRadius; }
+    DecodedImageCache* decodeCache() const { return m_decodeCache; }
+    
+    static constexpr int DEFAULT_PREFETCH_RADIUS = 2;
+    // Of the MemoryBudget total; ThumbnailCache takes the rest
+    static constexpr double DECODE_BUDGET_SHARE = 0.6;
+    static constexpr double TILE_BUDGET_SHARE = 0.15;
+    
     // Zoom controls
     void zoomIn();
     void zoomOut();
@@ -26,6 +42,8 @@ public:
     void zoomActual();
     void setZoom(double factor);
     double zoom() const { return m_zoom; }
+    // Screen pixels per file pixel; zoom() counts decoded pixels
+    double actualZoom() const { return m_zoom / sourceScale(); }
     
     // Navigation
     void nextImage();
@@ -54,11 +72,20 @@ private:
     void updateTransform();
     void centerImage();
     void drawLoadingIndicator(QPainter& painter);
-    void onImageLoadComplete();
-    void updatePixmapCache();
+    void onPreviewDecoded(const QString& filepath, const QImage& image);
+    void onImageDecoded(const QString& filepath, const QImage& image);
+    void showImage(const QImage& image, const QString& filepath);
+    void showPreview(const QImage& image, const QString& filepath);
+    void requestFullIfZoomed();
+    void drawTiles(QPainter& painter, const QRect& area);
+    double sourceScale() const;  // File pixels per m_image pixel
+    void updateSourceSize();
+    void requestDetail();
+    void onRegionDecoded(const QString& filepath, const QRect& region, const QImage& image);
+    void clearDetail();
     
     QImage m_image;
-    QPixmap m_pixmapCache;  // PERFORMANCE: Cached pixmap for fast rendering
+    TilePyramid* m_pyramid = nullptr;  // PERFORMANCE: m_image as zoom levels of tiles
     QString m_filepath;
     
     // Transform
@@ -74,12 +101,28 @@ private:
     
     // Loading state
     bool m_isLoading = false;
-    QFutureWatcher<std::optional<QImage>>* m_imageWatcher = nullptr;
     QString m_pendingFilepath;
     
+    // m_image is a preview; the full decode is asked for once zoomed past it
+    bool m_showingPreview = false;
+    bool m_fullRequested = false;
+    
+    // Full-resolution size of the file, and the latest region of it at that size
+    QSize m_sourceSize;
+    QImage m_detail;
+    QRect m_detailRect;  // In file pixels
+    QTimer* m_detailTimer = nullptr;
+    
+    // Decoded images + neighbour prefetch (owned, child QObject)
+    DecodedImageCache* m_decodeCache = nullptr;
+    int m_prefetchRadius = DEFAULT_PREFETCH_RADIUS;
+    
+    // Both caches are sized by the MemoryBudget
+    int m_decodeBudgetId = 0;
+    int m_tileBudgetId = 0;
+    
     // PERFORMANCE: Debouncing for resize
     QTimer* m_resizeTimer = nullptr;
-    bool m_pixmapCacheDirty = true;
 };
 
 } // namespace PhotoGuru
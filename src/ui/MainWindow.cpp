@@ -8,6 +8,7 @@
 #include "SemanticSearch.h"
 #include "FilterPanel.h"
 #include "AnalysisPanel.h"
+#include "PerformancePanel.h"
 #include "DarkTheme.h"
 #include "PhotoMetadata.h"
 #include "ImageLoader.h"
@@ -16,11 +17,22 @@
 #include "core/GoogleTakeoutImporter.h"
 #include "core/Logger.h"
 #include "core/ExifToolDaemon.h"
-#include "ml/ONNXInference.h"
+#include "core/ExportPipeline.h"
+#include "core/CatalogSync.h"
+#include "core/FileClone.h"
+#include "core/FileReadAhead.h"
+#include "core/MemoryBudget.h"
+#include "core/MetadataWriter.h"
+#include "core/PhotoDatabase.h"
+#include "core/ResourceGovernor.h"
+#include "core/SessionSnapshot.h"
+#include "core/ThumbnailCache.h"
+#include "ml/ModelRegistry.h"
 
 #include <QMenuBar>
 #include <QMenu>
 #include <QAction>
+#include <QActionGroup>
 #include <QFileDialog>
 #include <QSettings>
 #include <QLabel>
@@ -38,7 +50,8 @@
 #include <QProcess>
 #include <QProgressDialog>
 #include <QTimer>
-#include <QtConcurrent>
+#include <QStandardPaths>
+#include <algorithm>
 
 namespace PhotoGuru {
 
@@ -46,6 +59,12 @@ MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
     , m_filterWatcher(new QFutureWatcher<QStringList>(this))
     , m_metadataLoader(new QFutureWatcher<void>(this))
+    , m_metadataService(new MetadataService(this))
+    , m_ratingQueue(new RatingWriteQueue(
+          QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/pending_ratings.journal",
+          RatingWriteQueue::defaultWriter(), this))
+    , m_directoryWatcher(new DirectoryWatcher(this))
+    , m_libraryScanner(new LibraryScanner(this))
 {
     setWindowTitle("PhotoGuru Viewer");
     resize(1600, 1000);
@@ -54,9 +73,19 @@ MainWindow::MainWindow(QWidget* parent)
     // Initialize notification system
     NotificationManager::instance().setParentWidget(this);
     
+    // Open metadata catalog (app keeps working without it, just slower)
+    QString catalogPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/catalog.db";
+    if (!PhotoDatabase::instance().initialize(catalogPath)) {
+        LOG_WARNING("MainWindow", "Metadata catalog unavailable, falling back to ExifTool reads");
+    }
+    
     setupUI();
     loadSettings();
     
+    // The grid comes up first; the AI models start loading once it has
+    QTimer::singleShot(DEFERRED_PANEL_DELAY_MS, this, &MainWindow::ensureAnalysisPanel);
+    QTimer::singleShot(DEFERRED_PANEL_DELAY_MS, this, &MainWindow::startCatalogSync);
+    
     // Connect filter watcher
     connect(m_filterWatcher, &QFutureWatcher<QStringList>::finished, 
             this, &MainWindow::onFilterFinished);
@@ -64,6 +93,77 @@ MainWindow::MainWindow(QWidget* parent)
     // Connect metadata loader
     connect(m_metadataLoader, &QFutureWatcher<void>::finished,
             this, &MainWindow::onMetadataLoadFinished);
+    connect(m_metadataLoader, &QFutureWatcher<void>::progressValueChanged,
+            this, [this](int count) {
+                m_cacheLoadedCount.storeRelaxed(count);
+                statusBar()->showMessage(
+                    QString("Loading metadata... %1/%2 files").arg(count).arg(m_metadataLoader->progressMaximum()));
+            });
+    
+    // Preload batches mark the filter index for a rebuild
+    connect(m_metadataService, &MetadataService::cacheChanged,
+            this, [this]() { m_metadataIndexDirty.storeRelaxed(1); });
+    
+    // Files added, removed or changed in the open folder, by us or anyone else
+    connect(m_directoryWatcher, &DirectoryWatcher::changed,
+            this, &MainWindow::onDirectoryChanged);
+    
+    // Library scans stream files in as directories are listed
+    connect(m_libraryScanner, &LibraryScanner::filesFound,
+            this, &MainWindow::onLibraryFilesFound);
+    connect(m_libraryScanner, &LibraryScanner::finished,
+            this, &MainWindow::onLibraryScanFinished);
+    
+    // Single reads go straight into the filter index
+    connect(m_metadataService, &MetadataService::metadataReady,
+            this, [this](const PhotoMetadata& read) {
+                PhotoMetadata metadata = read;
+                if (m_ratingQueue->pending(metadata.filepath)) {
+                    applyPendingRating(metadata);
+                    m_metadataService->insert(metadata);
+                }
+                m_metadataIndex.upsert(metadata);
+                m_timelineIndex.upsert(metadata);
+                m_thumbnailGrid->sortKeys().setMetadata(metadata);
+            });
+    
+    // Written ratings: bring the catalog entries up to the new file mtime
+    connect(m_ratingQueue, &RatingWriteQueue::written,
+            this, [this](const QStringList& paths) {
+                QList<PhotoMetadata> metas;
+                for (const QString& path : paths) {
+                    if (auto meta = m_metadataService->cached(path)) metas << *meta;
+                }
+                if (!metas.isEmpty()) {
+                    m_tasks.start([metas]() { PhotoDatabase::instance().storeMetadataBatch(metas); },
+                                  TaskScheduler::Ingest);
+                }
+            });
+    connect(m_ratingQueue, &RatingWriteQueue::writeFailed,
+            this, [this](const QStringList& paths) {
+                NotificationManager::instance().showWarning(
+                    QString("Could not save the rating of %1 file(s)").arg(paths.size()));
+                // Show what the files really hold
+                for (const QString& path : paths) {
+                    if (!m_ratingQueue->pending(path)) refreshMetadata(path, false);
+                }
+            });
+    
+    // Thumbnails are what the grid shows: kept longest under memory pressure
+    m_thumbnailBudgetId = MemoryBudget::instance().addCache(MemoryBudget::Cache{
+        "thumbnails", THUMBNAIL_BUDGET_SHARE, 2,
+        []() { return ThumbnailCache::instance().memoryUsage(); },
+        [](qint64 bytes) { ThumbnailCache::instance().setMemoryBudget(bytes); }});
+    // Files read from a share: cheap to drop, slow to read again
+    m_readAheadBudgetId = MemoryBudget::instance().addCache(MemoryBudget::Cache{
+        "file read-ahead", READ_AHEAD_BUDGET_SHARE, 0,
+        []() { return FileReadAhead::instance().usedBytes(); },
+        [](qint64 bytes) { FileReadAhead::instance().setMaxBytes(bytes); }});
+    // Caches give back first; at critical, models nobody is using go too
+    connect(&MemoryBudget::instance(), &MemoryBudget::pressureChanged, this,
+            [](MemoryBudget::Pressure pressure) {
+                if (pressure == MemoryBudget::Pressure::Critical) ModelRegistry::instance().unloadAll();
+            });
     
     // Force Metadata tab to be active (using QTimer to ensure event loop processed everything)
     QTimer::singleShot(0, this, [this]() {
@@ -72,8 +172,10 @@ MainWindow::MainWindow(QWidget* parent)
         }
     });
     
-    // Initialize with welcome state
-    statusBar()->showMessage("Ready - Open a directory or drop images here");
+    // Bring back the folder the last session closed with, or the welcome state
+    if (!restoreSession()) {
+        statusBar()->showMessage("Ready - Open a directory or drop images here");
+    }
 }
 
 MainWindow::~MainWindow() {
@@ -85,6 +187,24 @@ MainWindow::~MainWindow() {
         m_filterWatcher->waitForFinished();
     }
     
+    // Stop a copy or move between files; the one under way completes
+    if (m_transferWatcher) {
+        *m_transferCancelled = true;
+        m_transferWatcher->waitForFinished();
+    }
+    
+    // An export stops after the files it is encoding
+    if (m_exporter) {
+        m_exporter->cancel();
+        m_exporter->wait();
+    }
+    
+    // A catalog sync stops after the page it is storing
+    if (m_catalogSyncWatcher) {
+        m_catalogSyncCancelled->storeRelaxed(1);
+        m_catalogSyncWatcher->waitForFinished();
+    }
+    
     // Cancel metadata loading
     if (m_metadataLoader->isRunning()) {
         m_metadataLoader->cancel();
@@ -100,11 +220,13 @@ MainWindow::~MainWindow() {
     }
     
     saveSettings();
+    MemoryBudget::instance().removeCache(m_thumbnailBudgetId);
+    MemoryBudget::instance().removeCache(m_readAheadBudgetId);
     
     // CRITICAL: Shutdown ML backends before exit to prevent crash
-    // ONNX Runtime has static globals that must be cleaned up explicitly
+    // Models first, then the ONNX Runtime globals they were created from
     qDebug() << "[MainWindow] Shutting down ML backends...";
-    ONNXInference::shutdownEnvironment();
+    ModelRegistry::instance().shutdown();
     
     // Stop ExifTool daemon to prevent zombie process
     qDebug() << "[MainWindow] Stopping ExifTool daemon...";
@@ -145,8 +267,9 @@ void MainWindow::setupUI() {
     connect(m_thumbnailGrid, &ThumbnailGrid::selectionCountChanged,
             this, &MainWindow::onThumbnailSelectionChanged);
     connect(m_imageViewer, &ImageViewer::zoomChanged,
-            [this](double zoom) {
-                m_statusBar->showMessage(QString("Zoom: %1%").arg(int(zoom * 100)));
+            [this](double) {
+                // Relative to the file, not the bounded decode on screen
+                m_statusBar->showMessage(QString("Zoom: %1%").arg(int(m_imageViewer->actualZoom() * 100)));
             });
     
     // Connect new ImageViewer signals
@@ -173,6 +296,10 @@ void MainWindow::createMenuBar() {
     openDirAction->setShortcut(QKeySequence("Ctrl+Shift+O"));
     connect(openDirAction, &QAction::triggered, this, &MainWindow::onOpenDirectory);
     
+    QAction* openLibraryAction = fileMenu->addAction("Open &Library (with Subfolders)...");
+    openLibraryAction->setShortcut(QKeySequence("Ctrl+Shift+L"));
+    connect(openLibraryAction, &QAction::triggered, this, &MainWindow::onOpenLibrary);
+    
     QAction* openFilesAction = fileMenu->addAction("&Open Files...");
     openFilesAction->setShortcut(QKeySequence::Open);
     connect(openFilesAction, &QAction::triggered, this, &MainWindow::onOpenFiles);
@@ -198,6 +325,10 @@ void MainWindow::createMenuBar() {
     moveAction->setShortcut(QKeySequence("Ctrl+Shift+M"));
     connect(moveAction, &QAction::triggered, this, &MainWindow::onMoveFiles);
     
+    QAction* exportAction = editMenu->addAction("E&xport...");
+    exportAction->setShortcut(QKeySequence("Ctrl+Shift+E"));
+    connect(exportAction, &QAction::triggered, this, &MainWindow::onExportFiles);
+    
     QAction* deleteAction = editMenu->addAction("&Delete");
     deleteAction->setShortcut(QKeySequence::Delete);
     connect(deleteAction, &QAction::triggered, this, &MainWindow::onDeleteFiles);
@@ -212,6 +343,13 @@ void MainWindow::createMenuBar() {
     openWithAction->setShortcut(QKeySequence("Ctrl+W"));
     connect(openWithAction, &QAction::triggered, this, &MainWindow::onOpenWithExternal);
     
+    editMenu->addSeparator();
+    
+    QAction* preferencesAction = editMenu->addAction("&Preferences...");
+    preferencesAction->setShortcut(QKeySequence::Preferences);
+    preferencesAction->setMenuRole(QAction::PreferencesRole);
+    connect(preferencesAction, &QAction::triggered, this, &MainWindow::onPreferences);
+    
     // View menu
     QMenu* viewMenu = menuBar->addMenu("&View");
     
@@ -243,6 +381,7 @@ void MainWindow::createMenuBar() {
     viewMenu->addAction(m_skpDock->toggleViewAction());
     viewMenu->addAction(m_analysisDock->toggleViewAction());
     viewMenu->addAction(m_filterDock->toggleViewAction());
+    viewMenu->addAction(m_performanceDock->toggleViewAction());
     
     // Metadata menu
     QMenu* metadataMenu = menuBar->addMenu("Meta&data");
@@ -257,6 +396,28 @@ void MainWindow::createMenuBar() {
         }
     });
     
+    // Sidecars spare rewriting a whole RAW file for each edit
+    QMenu* writeModeMenu = metadataMenu->addMenu("Save Edits &To");
+    QActionGroup* writeModes = new QActionGroup(writeModeMenu);
+    const QList<QPair<MetadataWriter::WriteMode, QString>> writeModeChoices = {
+        {MetadataWriter::WriteMode::Embedded, "Image Files"},
+        {MetadataWriter::WriteMode::RawSidecar, "XMP Sidecars for RAW Files"},
+        {MetadataWriter::WriteMode::Sidecar, "XMP Sidecars for All Files"},
+    };
+    for (const auto& [mode, label] : writeModeChoices) {
+        QAction* action = writeModeMenu->addAction(label);
+        action->setCheckable(true);
+        action->setActionGroup(writeModes);
+        connect(action, &QAction::triggered, this, [mode = mode]() {
+            MetadataWriter::instance().setWriteMode(mode);
+            QSettings settings("PhotoGuru", "Viewer");
+            settings.setValue("metadata/writeMode", MetadataWriter::writeModeName(mode));
+        });
+        connect(writeModeMenu, &QMenu::aboutToShow, action, [action, mode = mode]() {
+            action->setChecked(MetadataWriter::instance().writeMode() == mode);
+        });
+    }
+    
     metadataMenu->addSeparator();
     
     QAction* importTakeoutAction = metadataMenu->addAction("Import &Google Takeout...");
@@ -281,6 +442,15 @@ void MainWindow::createMenuBar() {
         }
     });
     
+    metadataMenu->addSeparator();
+    
+    QAction* saveAlbumAction = metadataMenu->addAction("Save Filter as Smart &Album...");
+    connect(saveAlbumAction, &QAction::triggered, this, &MainWindow::saveSmartAlbum);
+    
+    // Listed afresh each time: member counts follow every catalog write
+    QMenu* albumsMenu = metadataMenu->addMenu("Smart A&lbums");
+    connect(albumsMenu, &QMenu::aboutToShow, this, [this, albumsMenu]() { populateSmartAlbumMenu(albumsMenu); });
+    
     // Photo menu (rating and organization)
     QMenu* photoMenu = menuBar->addMenu("&Photo");
     
@@ -412,27 +582,30 @@ void MainWindow::createToolBar() {
     
     // Thumbnail size control
     m_toolbar->addWidget(new QLabel(" Size: "));
-    QSlider* sizeSlider = new QSlider(Qt::Horizontal);
-    sizeSlider->setMinimum(80);
-    sizeSlider->setMaximum(300);
-    sizeSlider->setValue(150);
-    sizeSlider->setFixedWidth(100);
-    sizeSlider->setToolTip("Adjust thumbnail size");
-    connect(sizeSlider, &QSlider::valueChanged, this, &MainWindow::onThumbnailSizeChanged);
-    m_toolbar->addWidget(sizeSlider);
+    m_sizeSlider = new QSlider(Qt::Horizontal);
+    m_sizeSlider->setMinimum(80);
+    m_sizeSlider->setMaximum(300);
+    m_sizeSlider->setValue(150);
+    m_sizeSlider->setFixedWidth(100);
+    m_sizeSlider->setToolTip("Adjust thumbnail size");
+    connect(m_sizeSlider, &QSlider::valueChanged, this, &MainWindow::onThumbnailSizeChanged);
+    m_toolbar->addWidget(m_sizeSlider);
     
     m_toolbar->addSeparator();
     
     // Sort order control
     m_toolbar->addWidget(new QLabel(" Sort: "));
-    QComboBox* sortCombo = new QComboBox();
-    sortCombo->addItem("Name");
-    sortCombo->addItem("Date");
-    sortCombo->addItem("Size");
-    sortCombo->setToolTip("Sort images by");
-    connect(sortCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), 
+    m_sortCombo = new QComboBox();
+    m_sortCombo->addItem("Name");
+    m_sortCombo->addItem("Date");
+    m_sortCombo->addItem("Size");
+    m_sortCombo->addItem("Capture Date");
+    m_sortCombo->addItem("Quality");
+    m_sortCombo->addItem("Rating");
+    m_sortCombo->setToolTip("Sort images by");
+    connect(m_sortCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), 
             this, &MainWindow::onSortOrderChanged);
-    m_toolbar->addWidget(sortCombo);
+    m_toolbar->addWidget(m_sortCombo);
 }
 
 void MainWindow::createDockPanels() {
@@ -462,20 +635,19 @@ void MainWindow::createDockPanels() {
     m_metadataDock->setMinimumWidth(280);
     addDockWidget(Qt::RightDockWidgetArea, m_metadataDock);
     
-    // Analysis Panel (right - SECOND TAB)
+    // Analysis Panel (right - SECOND TAB). Built on first show, or once
+    // startup is over (see ensureAnalysisPanel), since it sets up the AI models
     m_analysisDock = new QDockWidget("AI Analysis", this);
     m_analysisDock->setAllowedAreas(Qt::RightDockWidgetArea | Qt::LeftDockWidgetArea);
     m_analysisDock->setFeatures(QDockWidget::DockWidgetMovable | QDockWidget::DockWidgetClosable | QDockWidget::DockWidgetFloatable);
-    m_analysisPanel = new AnalysisPanel(this);
-    m_analysisDock->setWidget(m_analysisPanel);
     m_analysisDock->setMinimumWidth(280);
     addDockWidget(Qt::RightDockWidgetArea, m_analysisDock);
+    connect(m_analysisDock, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+        if (visible) ensureAnalysisPanel();
+    });
     
-    // Connect overwrite mode to metadata panel
-    connect(m_analysisPanel, &AnalysisPanel::overwriteModeChanged,
-            m_metadataPanel, &MetadataPanel::setAutoSaveMode);
-    // Initialize with current state
-    m_metadataPanel->setAutoSaveMode(m_analysisPanel->isOverwriteEnabled());
+    // Until the panel exists its overwrite box is unchecked: pending mode
+    m_metadataPanel->setAutoSaveMode(false);
     
     // SKP Browser (right - THIRD/LAST TAB)
     m_skpDock = new QDockWidget("Semantic Keys", this);
@@ -486,69 +658,33 @@ void MainWindow::createDockPanels() {
     m_skpDock->setMinimumWidth(280);
     addDockWidget(Qt::RightDockWidgetArea, m_skpDock);
     
+    // Performance (right - LAST TAB): live stage timings, queues, caches
+    m_performanceDock = new QDockWidget("Performance", this);
+    m_performanceDock->setAllowedAreas(Qt::RightDockWidgetArea | Qt::LeftDockWidgetArea | Qt::BottomDockWidgetArea);
+    m_performanceDock->setFeatures(QDockWidget::DockWidgetMovable | QDockWidget::DockWidgetClosable | QDockWidget::DockWidgetFloatable);
+    m_performanceDock->setMinimumWidth(280);
+    addDockWidget(Qt::RightDockWidgetArea, m_performanceDock);
+    connect(m_performanceDock, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+        if (visible) ensurePerformancePanel();
+    });
+    
     // Tabify all right panels together
     // First tab Analysis to Metadata (creates tab group with Metadata first, Analysis second)
     tabifyDockWidget(m_metadataDock, m_analysisDock);
     // Then tab SKP to Analysis (adds SKP as third tab)
     tabifyDockWidget(m_analysisDock, m_skpDock);
+    tabifyDockWidget(m_skpDock, m_performanceDock);
     
     // Ensure Metadata tab is visible by default
     m_metadataDock->show();
     m_metadataDock->raise();
     
-    // Connect analysis panel signals
-    connect(m_analysisPanel, &AnalysisPanel::metadataUpdated, 
-            this, [this](const QString& filepath) {
-                // Update cache with fresh metadata - run in thread pool to avoid UI blocking
-                QPointer<MainWindow> safeThis(this);
-                QtConcurrent::run([safeThis, filepath]() {
-                    if (!safeThis) return;  // MainWindow destroyed
-                    auto metaOpt = MetadataReader::instance().read(filepath);
-                    if (metaOpt) {
-                        // Update cache
-                        safeThis->m_metadataCache[filepath] = metaOpt.value();
-                        
-                        // Re-apply current filter to update search results (on UI thread)
-                        QMetaObject::invokeMethod(safeThis, [safeThis]() {
-                            if (!safeThis || !safeThis->m_filterPanel) return;
-                            safeThis->m_filterPanel->triggerFilterUpdate();
-                        }, Qt::QueuedConnection);
-                    }
-                });
-                
-                // Reload metadata for updated image
-                if (m_currentIndex >= 0 && filepath == m_imageFiles[m_currentIndex]) {
-                    // Use cache if available
-                    auto it = m_metadataCache.find(filepath);
-                    if (it != m_metadataCache.end()) {
-                        m_metadataPanel->loadMetadata(filepath, it.value());
-                    } else {
-                        m_metadataPanel->loadMetadata(filepath);
-                    }
-                    // Thumbnail will auto-refresh when metadata changes
-                }
-            });
-    
     // Connect metadata panel signals
     connect(m_metadataPanel, &MetadataPanel::metadataChanged,
             this, [this](const QString& filepath) {
                 // Update cache with fresh metadata - wait for ExifTool write, then load async
-                QPointer<MainWindow> safeThis(this);
-                QTimer::singleShot(100, this, [safeThis, filepath]() {
-                    if (!safeThis) return;  // MainWindow destroyed
-                    QtConcurrent::run([safeThis, filepath]() {
-                        if (!safeThis) return;  // Double-check
-                        auto metaOpt = MetadataReader::instance().read(filepath);
-                        if (metaOpt) {
-                            safeThis->m_metadataCache[filepath] = metaOpt.value();
-                            
-                            // Re-apply current filter to update search results (on UI thread)
-                            QMetaObject::invokeMethod(safeThis, [safeThis]() {
-                                if (!safeThis || !safeThis->m_filterPanel) return;
-                                safeThis->m_filterPanel->triggerFilterUpdate();
-                            }, Qt::QueuedConnection);
-                        }
-                    });
+                QTimer::singleShot(100, this, [this, filepath]() {
+                    refreshMetadata(filepath, false);
                 });
                 
                 // Don't reload - panel already has the saved data in memory
@@ -567,6 +703,42 @@ void MainWindow::createDockPanels() {
     // Connect filter panel signals
     connect(m_filterPanel, &FilterPanel::filterChanged,
             this, &MainWindow::onFilterChanged);
+    
+    connect(m_skpBrowser, &SKPBrowser::searchByKey, this, &MainWindow::onSearchByKey);
+}
+
+void MainWindow::ensureAnalysisPanel() {
+    if (m_analysisPanel) return;
+    
+    m_analysisPanel = new AnalysisPanel(this);
+    m_analysisDock->setWidget(m_analysisPanel);
+    
+    // Connect overwrite mode to metadata panel
+    connect(m_analysisPanel, &AnalysisPanel::overwriteModeChanged,
+            m_metadataPanel, &MetadataPanel::setAutoSaveMode);
+    m_metadataPanel->setAutoSaveMode(m_analysisPanel->isOverwriteEnabled());
+    
+    // Connect analysis panel signals
+    connect(m_analysisPanel, &AnalysisPanel::metadataUpdated, 
+            this, [this](const QString& filepath) {
+                // Re-read in the background, then show it if still selected
+                refreshMetadata(filepath, true);
+                // Thumbnail will auto-refresh when metadata changes
+            });
+    
+    // Catch up on what was opened and selected before it existed
+    if (!m_imageFiles.isEmpty()) {
+        m_analysisPanel->setCurrentDirectory(m_currentDirectory);
+    }
+    if (m_currentIndex >= 0 && m_currentIndex < m_imageFiles.size()) {
+        m_analysisPanel->setCurrentImage(m_imageFiles[m_currentIndex]);
+    }
+}
+
+void MainWindow::ensurePerformancePanel() {
+    if (m_performancePanel) return;
+    m_performancePanel = new PerformancePanel(this);
+    m_performanceDock->setWidget(m_performancePanel);
 }
 
 void MainWindow::createStatusBar() {
@@ -584,6 +756,17 @@ void MainWindow::onOpenDirectory() {
     }
 }
 
+void MainWindow::onOpenLibrary() {
+    QString dir = QFileDialog::getExistingDirectory(this,
+        "Open Library",
+        QDir::homePath(),
+        QFileDialog::ShowDirsOnly);
+    
+    if (!dir.isEmpty()) {
+        loadLibrary({dir});
+    }
+}
+
 void MainWindow::onOpenFiles() {
     QStringList filters = ImageLoader::instance().supportedExtensions();
     QString filter = QString("Images (%1)").arg(filters.join(" "));
@@ -594,6 +777,8 @@ void MainWindow::onOpenFiles() {
         filter);
     
     if (!files.isEmpty()) {
+        m_libraryScanner->cancel();
+        m_directoryWatcher->stop();  // Not a folder listing
         m_imageFiles = files;
         m_thumbnailGrid->setImages(files);
         m_currentIndex = 0;
@@ -602,28 +787,34 @@ void MainWindow::onOpenFiles() {
 }
 
 void MainWindow::loadDirectory(const QString& path) {
+    m_libraryScanner->cancel();
     m_currentDirectory = path;
     
     // Check if this is a Google Takeout directory
     checkAndOfferGoogleTakeoutImport(path);
     
-    // Find all supported images
-    QDir dir(path);
+    // Find all supported images; the listing's mtimes and sizes are the
+    // watcher's baseline and the grid's sort keys
     QStringList filters = ImageLoader::instance().supportedExtensions();
-    QStringList files = dir.entryList(filters, QDir::Files, QDir::Name);
-    
     m_imageFiles.clear();
-    for (const QString& file : files) {
-        m_imageFiles << dir.filePath(file);
-    }
+    const DirectoryWatcher::Listing listing = DirectoryWatcher::list(path, filters, &m_imageFiles);
     
     if (m_imageFiles.isEmpty()) {
         NotificationManager::instance().showInfo("No supported images found in this directory.");
         return;
     }
-    
-    // Clear metadata cache
-    m_metadataCache.clear();
+    m_directoryWatcher->watch(path, filters, listing);
+    showDirectory(path, 0);
+}
+
+void MainWindow::showDirectory(const QString& path, int currentIndex) {
+    // Clear metadata cache (and stop the previous folder's preload)
+    m_metadataService->clear();
+    m_metadataIndex.clear();
+    m_timelineIndex.clear();
+    m_metadataIndexDirty.storeRelaxed(1);
+    m_thumbnailGrid->sortKeys().clear();
+    m_thumbnailGrid->sortKeys().setFileInfo(m_directoryWatcher->listing());
     
     // Clear pending changes when loading new directory
     if (m_metadataPanel) {
@@ -633,12 +824,13 @@ void MainWindow::loadDirectory(const QString& path) {
     // Load into thumbnail grid
     m_thumbnailGrid->setImages(m_imageFiles);
     
-    // Select first image
-    m_currentIndex = 0;
-    onImageSelected(m_imageFiles[0]);
+    m_currentIndex = qBound(0, currentIndex, int(m_imageFiles.size()) - 1);
+    onImageSelected(m_imageFiles[m_currentIndex]);
     
     // Update analysis panel with directory
-    m_analysisPanel->setCurrentDirectory(path);
+    if (m_analysisPanel) {
+        m_analysisPanel->setCurrentDirectory(path);
+    }
     
     // Ensure Metadata panel remains visible after loading
     if (m_metadataDock) {
@@ -651,49 +843,101 @@ void MainWindow::loadDirectory(const QString& path) {
             .arg(QFileInfo(path).fileName())
     );
     
-    // Pre-load metadata in background - SERIAL to avoid ExifToolDaemon contention
-    // Using single worker thread instead of thread pool to prevent deadlock
-    QStringList filesCopy = m_imageFiles;
-    QMap<QString, PhotoMetadata>* cachePtr = &m_metadataCache;
-    QAtomicInt* progressPtr = &m_cacheLoadedCount;
+    // Pre-load metadata in background - parallel across the ExifTool daemon pool;
+    // progress arrives through m_metadataLoader
     m_cacheLoadedCount.storeRelaxed(0);
     m_cacheLoadingComplete = false;
+    QFuture<void> future = m_metadataService->preload(m_imageFiles);
+    m_metadataLoader->setFuture(future);
+}
+
+void MainWindow::loadLibrary(const QStringList& roots) {
+    m_directoryWatcher->stop();  // Watches one folder, not a tree
+    m_currentDirectory = roots.value(0);
     
-    // Use QPointer to safely check if MainWindow still exists in worker thread
-    QPointer<MainWindow> safeThis(this);
-    
-    QFuture<void> future = QtConcurrent::run([safeThis, filesCopy, cachePtr, progressPtr]() {
-        // Process files SEQUENTIALLY in this single worker thread
-        // No parallel access to ExifToolDaemon = no contention, no deadlock
-        int count = 0;
-        for (const QString& filepath : filesCopy) {
-            // Check if MainWindow still exists before accessing members
-            if (!safeThis) {
-                qDebug() << "[MainWindow] Cache loader: MainWindow destroyed, aborting";
-                return;  // MainWindow was destroyed, stop loading
-            }
-            
-            auto metaOpt = MetadataReader::instance().read(filepath);
-            if (metaOpt) {
-                cachePtr->insert(filepath, metaOpt.value());
-            }
-            
-            count++;
-            progressPtr->storeRelaxed(count);
-            
-            // Update UI progress every 10 files
-            if (count % 10 == 0 || count == filesCopy.size()) {
-                QMetaObject::invokeMethod(safeThis, [safeThis, count, total = filesCopy.size()]() {
-                    if (!safeThis) return;  // Double-check before UI access
-                    safeThis->statusBar()->showMessage(
-                        QString("Loading metadata... %1/%2 files").arg(count).arg(total)
-                    );
-                }, Qt::QueuedConnection);
-            }
-        }
+    m_imageFiles.clear();
+    m_currentIndex = -1;
+    m_thumbnailGrid->setImages(m_imageFiles);
+    
+    // Clear metadata cache (and stop the previous folder's preload)
+    m_metadataService->clear();
+    m_metadataIndex.clear();
+    m_timelineIndex.clear();
+    m_metadataIndexDirty.storeRelaxed(1);
+    m_thumbnailGrid->sortKeys().clear();
+    if (m_metadataPanel) {
+        m_metadataPanel->clearPendingChanges();
+    }
+    
+    m_cacheLoadedCount.storeRelaxed(0);
+    m_cacheLoadingComplete = false;
+    m_libraryLoadsPending = 0;
+    ++m_libraryGeneration;
+    
+    if (m_analysisPanel) {
+        m_analysisPanel->setCurrentDirectory(m_currentDirectory);
+    }
+    statusBar()->showMessage("Scanning library...");
+    m_libraryScanner->start(roots);
+}
+
+void MainWindow::onLibraryFilesFound(const QStringList& paths) {
+    m_imageFiles += paths;
+    m_thumbnailGrid->appendImages(paths);
+    if (m_currentIndex < 0) {
+        onImageSelected(m_imageFiles[0]);
+    }
+    
+    // Catalog first, ExifTool for the rest, chunk by chunk as they arrive
+    ++m_libraryLoadsPending;
+    const quint64 generation = m_libraryGeneration;
+    const int count = paths.size();
+    m_metadataService->load(paths).then(this, [this, generation, count]() {
+        if (generation != m_libraryGeneration) return;
+        m_cacheLoadedCount.fetchAndAddRelaxed(count);
+        --m_libraryLoadsPending;
+        finishLibraryLoadIfDone();
     });
     
-    m_metadataLoader->setFuture(future);
+    statusBar()->showMessage(QString("Scanning library... %1 images found").arg(m_imageFiles.size()));
+}
+
+void MainWindow::onLibraryScanFinished(int total, bool cancelled) {
+    if (cancelled) return;
+    
+    if (total == 0) {
+        NotificationManager::instance().showInfo("No supported images found in this library.");
+        statusBar()->clearMessage();
+        return;
+    }
+    
+    // Rows came in discovery order; sort once, now that the list is whole
+    const QString current = m_imageFiles.value(m_currentIndex);
+    m_imageFiles.sort();
+    m_currentIndex = m_imageFiles.indexOf(current);
+    if (m_filterPanel) {
+        m_filterPanel->triggerFilterUpdate();
+    } else {
+        m_thumbnailGrid->updateImages(m_imageFiles);
+    }
+    
+    statusBar()->showMessage(QString("Found %1 images - Loading metadata...").arg(total));
+    finishLibraryLoadIfDone();
+}
+
+void MainWindow::finishLibraryLoadIfDone() {
+    if (m_libraryScanner->isRunning() || m_libraryLoadsPending > 0 || m_cacheLoadingComplete) return;
+    
+    m_cacheLoadingComplete = true;
+    m_metadataIndexDirty.storeRelaxed(1);
+    statusBar()->showMessage(
+        QString("Ready - %1 images (%2 with metadata)")
+            .arg(m_imageFiles.size())
+            .arg(m_metadataService->count())
+    );
+    if (m_filterPanel) {
+        m_filterPanel->triggerFilterUpdate();
+    }
 }
 
 void MainWindow::onImageSelected(const QString& filepath) {
@@ -710,26 +954,27 @@ void MainWindow::onImageSelected(const QString& filepath) {
         return;
     }
     
-    // Load image (force repaint)
+    // Load image (force repaint), then decode its neighbours for arrow keys
     m_imageViewer->loadImage(filepath);
+    m_imageViewer->prefetchNeighbours(m_imageFiles, m_currentIndex);
     m_imageViewer->update();
     
-    // Update metadata panel - use cache if available to avoid blocking
-    auto it = m_metadataCache.find(filepath);
-    if (it != m_metadataCache.end()) {
-        // Fast path: use cached metadata (no I/O, no deadlock risk)
-        m_metadataPanel->loadMetadata(filepath, it.value());
+    // Update metadata panel without blocking: cached, or a read queued
+    // ahead of the folder preload (user clicked before it got here)
+    // The SKP browser reads the same cache: no ExifTool round trip per selection
+    if (auto cached = m_metadataService->cached(filepath)) {
+        m_metadataPanel->loadMetadata(filepath, *cached);
+        m_skpBrowser->loadImageKeys(filepath, *cached);
     } else {
-        // Slow path: load from disk (may block briefly if cache not ready)
-        // This happens when user clicks before background loading finishes
-        m_metadataPanel->loadMetadata(filepath);
+        m_metadataPanel->clear();
+        m_skpBrowser->clear();
+        showMetadataWhenReady(filepath, m_metadataService->request(filepath));
     }
     
-    // Update SKP browser
-    m_skpBrowser->loadImageKeys(filepath);
-    
     // Update analysis panel with current image
-    m_analysisPanel->setCurrentImage(filepath);
+    if (m_analysisPanel) {
+        m_analysisPanel->setCurrentImage(filepath);
+    }
     
     // Update thumbnail selection and highlight
     m_thumbnailGrid->selectImage(m_currentIndex);
@@ -790,7 +1035,7 @@ void MainWindow::onRunAnalysis() {
     }
     
     // Switch to Analysis Panel and set current image
-    if (m_analysisDock && m_analysisPanel) {
+    if (m_analysisDock) {
         m_analysisDock->show();
         m_analysisDock->raise();
         
@@ -801,8 +1046,51 @@ void MainWindow::onRunAnalysis() {
 }
 
 void MainWindow::onPreferences() {
-    NotificationManager::instance().showInfo(
-        "Settings: Auto-fit images, smooth zoom (1.25x), C++ ML integration", 4000);
+    // How hard folder loads, thumbnailing and AI runs may push the machine
+    const QList<ResourceGovernor::Mode> modes = {
+        ResourceGovernor::Background, ResourceGovernor::Balanced, ResourceGovernor::MaxThroughput};
+    const QStringList labels = {
+        "Background - stay out of the way, slowest",
+        "Balanced - ease off on battery or when hot",
+        "Max throughput - run flat out, even on battery",
+    };
+    
+    ResourceGovernor& governor = ResourceGovernor::instance();
+    bool ok = false;
+    const QString choice = QInputDialog::getItem(this, "Preferences", "Background work:", labels,
+                                                 int(modes.indexOf(governor.mode())), false, &ok);
+    if (!ok) return;
+    
+    const ResourceGovernor::Mode mode = modes[int(labels.indexOf(choice))];
+    governor.setMode(mode);
+    QSettings settings("PhotoGuru", "Viewer");
+    settings.setValue("backgroundWork", ResourceGovernor::modeName(mode));
+    
+    // What thumbnails, decoded images and tiles may hold together
+    const qint64 MB = 1024 * 1024;
+    const int megabytes = QInputDialog::getInt(this, "Preferences",
+        QString("Image cache memory in MB (0 = automatic, %1 MB on this machine):")
+            .arg(MemoryBudget::defaultTotal() / MB),
+        settings.value("memory/cacheBudgetMB", 0).toInt(), 0,
+        int(std::max(MemoryBudget::physicalMemory(), MemoryBudget::MAX_TOTAL) / MB), 256, &ok);
+    if (!ok) return;
+    MemoryBudget::instance().setTotal(qint64(megabytes) * MB);
+    settings.setValue("memory/cacheBudgetMB", megabytes);
+    
+    // Only files on network shares are read ahead
+    const int depth = QInputDialog::getInt(this, "Preferences",
+        "Files to read ahead on network shares (0 = off):",
+        settings.value("io/readAheadDepth", FileReadAhead::DEFAULT_DEPTH).toInt(), 0,
+        MAX_READ_AHEAD_DEPTH, 1, &ok);
+    if (!ok) return;
+    setReadAheadDepth(depth);
+    settings.setValue("io/readAheadDepth", depth);
+}
+
+void MainWindow::setReadAheadDepth(int depth) {
+    FileReadAhead& readAhead = FileReadAhead::instance();
+    readAhead.setMode(depth > 0 ? FileReadAhead::Mode::Auto : FileReadAhead::Mode::Off);
+    readAhead.setDepth(depth);
 }
 
 void MainWindow::onAbout() {
@@ -812,6 +1100,7 @@ void MainWindow::onAbout() {
 
 void MainWindow::closeEvent(QCloseEvent* event) {
     saveSettings();
+    m_ratingQueue->waitForFlushed();
     QMainWindow::closeEvent(event);
 }
 
@@ -829,13 +1118,21 @@ void MainWindow::dropEvent(QDropEvent* event) {
             QString path = urls[0].toLocalFile();
             QFileInfo info(path);
             
-            if (info.isDir()) {
+            if (info.isDir() && urls.size() > 1) {
+                QStringList roots;
+                for (const QUrl& url : urls) {
+                    if (QFileInfo(url.toLocalFile()).isDir()) roots << url.toLocalFile();
+                }
+                loadLibrary(roots);
+            } else if (info.isDir()) {
                 loadDirectory(path);
             } else if (info.isFile()) {
                 QStringList files;
                 for (const QUrl& url : urls) {
                     files << url.toLocalFile();
                 }
+                m_libraryScanner->cancel();
+                m_directoryWatcher->stop();
                 m_imageFiles = files;
                 m_thumbnailGrid->setImages(files);
                 m_currentIndex = 0;
@@ -853,6 +1150,21 @@ void MainWindow::loadSettings() {
     restoreGeometry(settings.value("geometry").toByteArray());
     
     m_currentDirectory = settings.value("lastDirectory", QDir::homePath()).toString();
+    
+    MetadataWriter::instance().setWriteMode(
+        MetadataWriter::writeModeFromName(settings.value("metadata/writeMode").toString())
+            .value_or(MetadataWriter::WriteMode::Embedded));
+    
+    ResourceGovernor& governor = ResourceGovernor::instance();
+    governor.setMode(ResourceGovernor::modeFromName(settings.value("backgroundWork").toString())
+                         .value_or(ResourceGovernor::Balanced));
+    governor.startMonitoring();
+    
+    MemoryBudget& memory = MemoryBudget::instance();
+    memory.setTotal(settings.value("memory/cacheBudgetMB", 0).toLongLong() * 1024 * 1024);
+    memory.startMonitoring();
+    
+    setReadAheadDepth(settings.value("io/readAheadDepth", FileReadAhead::DEFAULT_DEPTH).toInt());
 }
 
 void MainWindow::saveSettings() {
@@ -862,6 +1174,48 @@ void MainWindow::saveSettings() {
     // This ensures tab order remains consistent across sessions
     settings.setValue("geometry", saveGeometry());
     settings.setValue("lastDirectory", m_currentDirectory);
+    
+    // Only a watched folder has a listing to check the snapshot against later
+    const QString snapshotPath = SessionSnapshot::defaultPath();
+    if (m_currentDirectory.isEmpty() || m_directoryWatcher->directory() != m_currentDirectory ||
+        !m_directoryWatcher->hasListing() || m_imageFiles.isEmpty()) {
+        QFile::remove(snapshotPath);
+        return;
+    }
+    SessionSnapshot snapshot;
+    snapshot.directory = m_currentDirectory;
+    snapshot.files = SessionSnapshot::filesOf(m_currentDirectory, m_imageFiles, m_directoryWatcher->listing());
+    snapshot.sortOrder = m_sortCombo->currentIndex();
+    snapshot.thumbnailSize = m_sizeSlider->value();
+    snapshot.currentFile = m_imageFiles.value(m_currentIndex);
+    snapshot.scrollPosition = m_thumbnailGrid->scrollPosition();
+    snapshot.save(snapshotPath);
+}
+
+bool MainWindow::restoreSession() {
+    std::optional<SessionSnapshot> snapshot = SessionSnapshot::load(SessionSnapshot::defaultPath());
+    if (!snapshot || snapshot->files.isEmpty() || snapshot->directory != m_currentDirectory ||
+        !QFileInfo(snapshot->directory).isDir()) {
+        return false;
+    }
+    
+    // View settings first, so the grid is laid out once
+    m_sortCombo->setCurrentIndex(snapshot->sortOrder);
+    m_sizeSlider->setValue(snapshot->thumbnailSize);
+    
+    // Shown as it was; the watcher lists the folder in the background and
+    // onDirectoryChanged() applies whatever changed while we were closed
+    m_imageFiles = snapshot->paths();
+    m_directoryWatcher->watch(snapshot->directory, ImageLoader::instance().supportedExtensions(),
+                              snapshot->listing());
+    showDirectory(snapshot->directory, int(m_imageFiles.indexOf(snapshot->currentFile)));  // -1: first
+    
+    const int scrollPosition = snapshot->scrollPosition;
+    QTimer::singleShot(0, this, [this, scrollPosition]() {
+        m_thumbnailGrid->setScrollPosition(scrollPosition);
+    });
+    qDebug() << "[MainWindow] Restored session:" << snapshot->directory << m_imageFiles.size() << "files";
+    return true;
 }
 
 void MainWindow::updateStatusBar() {
@@ -901,29 +1255,9 @@ void MainWindow::updateStatusBar() {
 }
 
 void MainWindow::onMetadataUpdated(const QString& filepath) {
-    // Update cache with fresh metadata - run in thread pool to avoid UI blocking
-    QPointer<MainWindow> safeThis(this);
-    QtConcurrent::run([safeThis, filepath]() {
-        if (!safeThis) return;  // MainWindow destroyed
-        auto metaOpt = MetadataReader::instance().read(filepath);
-        if (metaOpt) {
-            safeThis->m_metadataCache[filepath] = metaOpt.value();
-            
-            // Re-apply current filter to update search results (on UI thread)
-            QMetaObject::invokeMethod(safeThis, [safeThis]() {
-                if (!safeThis || !safeThis->m_filterPanel) return;
-                safeThis->m_filterPanel->triggerFilterUpdate();
-            }, Qt::QueuedConnection);
-        }
-    });
-    
-    // Handle metadata update signal
-    // Don't reload the metadata panel - it already has the updated data
-    // Just update other components like SKP browser
-    if (m_currentIndex >= 0 && m_currentIndex < m_imageFiles.size() && 
-        m_imageFiles[m_currentIndex] == filepath) {
-        m_skpBrowser->loadImageKeys(filepath);
-    }
+    // Update cache with fresh metadata in the background. The metadata
+    // panel already has the updated data; the SKP browser follows the re-read.
+    refreshMetadata(filepath, false);
 }
 
 void MainWindow::onFilterChanged(const FilterCriteria& criteria) {
@@ -948,32 +1282,57 @@ void MainWindow::onFilterChanged(const FilterCriteria& criteria) {
     // Create a copy of image files list for thread safety
     QStringList imageFilesCopy = m_imageFiles;
     
-    // Use metadata cache (no I/O!)
-    const QMap<QString, PhotoMetadata>* cachePtr = &m_metadataCache;
+    // Bring the columnar index up to date after bulk loads, then hand the
+    // worker an implicitly shared snapshot (no copy, no I/O)
+    if (m_metadataIndexDirty.fetchAndStoreRelaxed(0)) {
+        rebuildMetadataIndex();
+    }
+    MetadataIndex index = m_metadataIndex;
+    
+    // Same files and same index revision: refine the previous result
+    // (narrowing re-checks only it, widening only what it excluded)
+    FilterRun previous;
+    if (m_lastFilter.valid && m_lastFilter.indexRevision == index.revision() &&
+        m_lastFilter.files == imageFilesCopy) {
+        previous = m_lastFilter;
+    }
+    
+    m_runningFilter = FilterRun();
+    m_runningFilter.files = imageFilesCopy;
+    m_runningFilter.criteria = criteria;
+    m_runningFilter.indexRevision = index.revision();
     
-    // Run filtering in background thread
-    QFuture<QStringList> future = QtConcurrent::run([imageFilesCopy, criteria, cachePtr]() -> QStringList {
-        QStringList filteredFiles;
-        
-        for (const QString& filepath : imageFilesCopy) {
-            // Fast: lookup in memory cache, no disk I/O
-            auto it = cachePtr->find(filepath);
-            if (it == cachePtr->end()) continue;
-            
-            const PhotoMetadata& meta = it.value();
-            
-            // Use the comprehensive matching function from FilterCriteria
-            if (criteria.matches(meta)) {
-                filteredFiles << filepath;
-            }
+    // Run filtering in background thread, ahead of any bulk work
+    QFuture<QStringList> future = m_tasks.run(TaskScheduler::Interactive,
+                                              [imageFilesCopy, criteria, index, previous]() -> QStringList {
+        if (previous.valid) {
+            return index.refilter(criteria, imageFilesCopy, previous.criteria, previous.result);
         }
-        
-        return filteredFiles;
+        return index.filter(criteria, imageFilesCopy);
     });
     
     m_filterWatcher->setFuture(future);
 }
 
+void MainWindow::rebuildMetadataIndex() {
+    const QHash<QString, PhotoHandle> cache = m_metadataService->snapshot();
+    m_metadataIndex.clear();
+    m_metadataIndex.reserve(cache.size());
+    for (auto it = cache.cbegin(); it != cache.cend(); ++it) {
+        m_metadataIndex.upsert(*it.value());
+        m_timelineIndex.upsert(*it.value());  // No-op for photos that didn't move
+        m_thumbnailGrid->sortKeys().setMetadata(*it.value());
+    }
+    
+    // Every cached photo was upserted, so a larger index means some were removed
+    if (m_timelineIndex.size() != cache.size()) {
+        m_timelineIndex.clear();
+        for (auto it = cache.cbegin(); it != cache.cend(); ++it) {
+            m_timelineIndex.upsert(*it.value());
+        }
+    }
+}
+
 void MainWindow::onFilterFinished() {
     if (m_filterWatcher->isCanceled()) {
         return;  // Filter was cancelled, don't update UI
@@ -983,8 +1342,13 @@ void MainWindow::onFilterFinished() {
     int totalCount = m_imageFiles.size();
     int loadedCount = m_cacheLoadedCount.loadRelaxed();
     
-    // Update display with filtered results
-    m_thumbnailGrid->setImages(filteredFiles);
+    m_lastFilter = m_runningFilter;
+    m_lastFilter.result = filteredFiles;
+    m_lastFilter.valid = true;
+    
+    // Grid gets row inserts/removes, not a full reload
+    m_thumbnailGrid->updateImages(filteredFiles);
+    m_timelineIndex.setVisible(filteredFiles);
     
     // Update status bar with filter stats
     QString statusMsg;
@@ -1008,8 +1372,9 @@ void MainWindow::onMetadataLoadFinished() {
     }
     
     m_cacheLoadingComplete = true;
+    m_metadataIndexDirty.storeRelaxed(1);
     
-    int loadedCount = m_metadataCache.size();
+    int loadedCount = m_metadataService->count();
     int totalCount = m_imageFiles.size();
     
     statusBar()->showMessage(
@@ -1024,6 +1389,86 @@ void MainWindow::onMetadataLoadFinished() {
     }
 }
 
+void MainWindow::onDirectoryChanged(const DirectoryWatcher::Changes& changes) {
+    const QString current = m_imageFiles.value(m_currentIndex);
+    m_imageFiles = changes.files;
+    
+    // Only the files that changed are read again; the rest keep their metadata
+    m_metadataService->remove(changes.removed + changes.modified);
+    SortKeyTable& sortKeys = m_thumbnailGrid->sortKeys();
+    sortKeys.remove(changes.removed);
+    for (const QString& path : changes.added + changes.modified) {
+        const DirectoryWatcher::Entry entry = m_directoryWatcher->listing().value(path);
+        sortKeys.setFileInfo(path, entry.mtime, entry.size);
+    }
+    QStringList toLoad = changes.added + changes.modified;
+    if (!toLoad.isEmpty()) {
+        m_metadataService->load(toLoad).then(this, [this]() {
+            if (m_filterPanel) m_filterPanel->triggerFilterUpdate();
+        });
+    }
+    m_thumbnailGrid->refreshThumbnails(changes.modified);
+    
+    // The filter result becomes the grid's list
+    if (m_filterPanel) {
+        m_filterPanel->triggerFilterUpdate();
+    } else {
+        m_thumbnailGrid->updateImages(m_imageFiles);
+    }
+    
+    if (m_imageFiles.isEmpty()) {
+        m_currentIndex = -1;
+    } else if (m_imageFiles.contains(current)) {
+        m_currentIndex = m_imageFiles.indexOf(current);
+        if (changes.modified.contains(current)) {
+            m_imageViewer->loadImage(current);
+            showMetadataWhenReady(current, m_metadataService->request(current));
+        }
+    } else {
+        // The shown image went away: show its neighbour
+        m_currentIndex = qBound(0, m_currentIndex, int(m_imageFiles.size()) - 1);
+        onImageSelected(m_imageFiles[m_currentIndex]);
+    }
+    
+    statusBar()->showMessage(QString("Folder changed: %1 added, %2 removed, %3 modified")
+        .arg(changes.added.size()).arg(changes.removed.size()).arg(changes.modified.size()), 3000);
+}
+
+void MainWindow::showMetadataWhenReady(const QString& filepath, QFuture<MetadataService::Result> future) {
+    future.then(this, [this, filepath](const MetadataService::Result& metaOpt) {
+        showMetadata(filepath, metaOpt, true);
+    });
+}
+
+void MainWindow::showMetadata(const QString& filepath, const MetadataService::Result& metaOpt, bool reloadPanel) {
+    // Moved on meanwhile: the read still filled the cache
+    if (m_currentIndex < 0 || m_imageFiles.value(m_currentIndex) != filepath) return;
+    
+    if (!metaOpt) {
+        if (reloadPanel) m_metadataPanel->clear();
+        m_skpBrowser->clear();
+        return;
+    }
+    
+    PhotoMetadata metadata = *metaOpt;
+    applyPendingRating(metadata);
+    if (reloadPanel) m_metadataPanel->loadMetadata(filepath, metadata);
+    m_skpBrowser->loadImageKeys(filepath, metadata);
+}
+
+void MainWindow::refreshMetadata(const QString& filepath, bool reloadPanel) {
+    QFuture<MetadataService::Result> future = m_metadataService->refresh(filepath);
+    
+    // One continuation for everything: a QFuture runs only the last one attached
+    future.then(this, [this, filepath, reloadPanel](const MetadataService::Result& metaOpt) {
+        // Re-apply current filter to update search results
+        if (metaOpt && m_filterPanel) {
+            m_filterPanel->triggerFilterUpdate();
+        }
+        showMetadata(filepath, metaOpt, reloadPanel);
+    });
+}
+
 void MainWindow::onViewModeChanged(int index) {
     // Switch between different view modes
     // 0 = Grid view (default)
@@ -1047,7 +1492,9 @@ void MainWindow::onViewModeChanged(int index) {
             
         case 2:
             // Timeline view
-            statusBar()->showMessage("Timeline view - showing images chronologically");
+            statusBar()->showMessage(QString("Timeline view - %1 days, %2 undated images")
+                .arg(m_timelineIndex.buckets(TimelineIndex::Level::Day).size())
+                .arg(m_timelineIndex.undatedCount()));
             // Would show m_timelineView if it was in central tabs
             break;
             
@@ -1061,6 +1508,115 @@ void MainWindow::onSemanticSearchResult(const QString& filepath) {
     onImageSelected(filepath);
 }
 
+void MainWindow::onSearchByKey(const QString& keyId) {
+    if (!PhotoDatabase::instance().isInitialized()) {
+        statusBar()->showMessage("Semantic key search needs the photo catalog");
+        return;
+    }
+    
+    // One indexed lookup, instead of reading the keys of every file
+    QSet<QString> carriers;
+    for (const PhotoDatabase::SemanticKeyRef& ref : PhotoDatabase::instance().photosWithKey(keyId)) {
+        carriers.insert(ref.path);
+    }
+    
+    QStringList matches;
+    for (const QString& file : m_imageFiles) {
+        if (carriers.contains(file)) matches << file;
+    }
+    m_thumbnailGrid->updateImages(matches);
+    m_timelineIndex.setVisible(matches);
+    
+    statusBar()->showMessage(QString("%1 of %2 images carry key %3 (%4 in the catalog)")
+        .arg(matches.size()).arg(m_imageFiles.size()).arg(keyId).arg(carriers.size()));
+}
+
+void MainWindow::saveSmartAlbum() {
+    if (!PhotoDatabase::instance().isInitialized()) {
+        statusBar()->showMessage("Smart albums need the photo catalog");
+        return;
+    }
+    
+    bool ok = false;
+    const QString name = QInputDialog::getText(this, "Save Smart Album",
+        "Album name (its photos are the cataloged ones matching the current filters):",
+        QLineEdit::Normal, QString(), &ok).trimmed();
+    if (!ok || name.isEmpty()) return;
+    
+    // Finding the first members reads the whole catalog once; later writes only check themselves
+    statusBar()->showMessage(QString("Saving smart album \"%1\"...").arg(name));
+    const FilterCriteria criteria = m_currentFilterCriteria;
+    auto* watcher = new QFutureWatcher<std::optional<qint64>>(this);
+    connect(watcher, &QFutureWatcher<std::optional<qint64>>::finished, this, [this, watcher, name]() {
+        watcher->deleteLater();
+        if (watcher->isCanceled() || !watcher->result()) {
+            NotificationManager::instance().showWarning(
+                QString("Could not save smart album \"%1\" (is the name taken?)").arg(name));
+            return;
+        }
+        const qint64 id = *watcher->result();
+        openSmartAlbum(id, name);
+    });
+    watcher->setFuture(m_tasks.run(TaskScheduler::Ingest, [name, criteria]() {
+        return PhotoDatabase::instance().createSmartAlbum(name, criteria);
+    }));
+}
+
+void MainWindow::populateSmartAlbumMenu(QMenu* menu) {
+    menu->clear();
+    if (!PhotoDatabase::instance().isInitialized()) {
+        menu->addAction("Photo catalog not open")->setEnabled(false);
+        return;
+    }
+    
+    const std::vector<PhotoDatabase::SmartAlbum> albums = PhotoDatabase::instance().smartAlbums();
+    if (albums.empty()) {
+        menu->addAction("No smart albums saved")->setEnabled(false);
+        return;
+    }
+    for (const PhotoDatabase::SmartAlbum& album : albums) {
+        QAction* action = menu->addAction(QString("%1 (%2)").arg(album.name).arg(album.photos));
+        const qint64 id = album.id;
+        const QString name = album.name;
+        connect(action, &QAction::triggered, this, [this, id, name]() { openSmartAlbum(id, name); });
+    }
+    
+    menu->addSeparator();
+    QMenu* deleteMenu = menu->addMenu("&Delete");
+    for (const PhotoDatabase::SmartAlbum& album : albums) {
+        QAction* action = deleteMenu->addAction(album.name);
+        const qint64 id = album.id;
+        const QString name = album.name;
+        // Only the saved filter goes; the photos are not touched
+        connect(action, &QAction::triggered, this, [this, id, name]() {
+            if (PhotoDatabase::instance().removeSmartAlbum(id)) {
+                statusBar()->showMessage(QString("Deleted smart album \"%1\"").arg(name));
+            } else {
+                NotificationManager::instance().showWarning(QString("Could not delete smart album \"%1\"").arg(name));
+            }
+        });
+    }
+}
+
+void MainWindow::openSmartAlbum(qint64 id, const QString& name) {
+    // One indexed lookup: the members were kept current as the catalog was written
+    const QStringList files = PhotoDatabase::instance().smartAlbumPhotos(id);
+    if (files.isEmpty()) {
+        statusBar()->showMessage(QString("Smart album \"%1\" has no photos").arg(name));
+        return;
+    }
+    
+    // Across folders, like a set of opened files
+    m_libraryScanner->cancel();
+    m_directoryWatcher->stop();
+    m_imageFiles = files;
+    m_thumbnailGrid->setImages(files);
+    m_currentIndex = 0;
+    onImageSelected(files[0]);
+    statusBar()->showMessage(QString("Smart album \"%1\": %2 photos").arg(name).arg(files.size()));
+    LOG_INFO("MainWindow", QString("Opened smart album %1 (%2 photos)").arg(name).arg(files.size()));
+}
+
 void MainWindow::onThumbnailSelectionChanged(int count) {
     if (count == 0) {
         updateStatusBar();
@@ -1091,13 +1647,8 @@ void MainWindow::refreshViews() {
     if (m_currentIndex >= 0 && m_currentIndex < m_imageFiles.count()) {
         QString currentFile = m_imageFiles[m_currentIndex];
         
-        // Reload current image metadata
-        auto metaOpt = MetadataReader::instance().read(currentFile);
-        if (!metaOpt) return;  // Skip if metadata can't be read
-        
-        // Update all panels
-        m_metadataPanel->loadMetadata(currentFile);
-        m_skpBrowser->loadImageKeys(currentFile);
+        // Reload current image metadata; the panel and SKP browser follow once it's read
+        refreshMetadata(currentFile, true);
         
         // Update thumbnail to reflect any metadata changes
         m_thumbnailGrid->setImages(m_imageFiles);
@@ -1120,34 +1671,7 @@ void MainWindow::onCopyFiles() {
     QString dest = QFileDialog::getExistingDirectory(this, "Copy to Directory");
     if (dest.isEmpty()) return;
     
-    // Progress dialog with cancel button
-    QProgressDialog progress("Copying files...", "Cancel", 0, selected.size(), this);
-    progress.setWindowModality(Qt::WindowModal);
-    progress.setMinimumDuration(500);  // Show after 500ms
-    
-    int copied = 0;
-    for (int i = 0; i < selected.size(); i++) {
-        progress.setValue(i);
-        
-        // Check for cancellation
-        if (progress.wasCanceled()) {
-            statusBar()->showMessage(QString("Copy cancelled. %1 of %2 files copied")
-                .arg(copied).arg(selected.size()));
-            return;
-        }
-        
-        const QString& file = selected[i];
-        QFileInfo fi(file);
-        progress.setLabelText(QString("Copying %1...").arg(fi.fileName()));
-        
-        QString destFile = dest + "/" + fi.fileName();
-        if (QFile::copy(file, destFile)) {
-            copied++;
-        }
-    }
-    
-    progress.setValue(selected.size());
-    statusBar()->showMessage(QString("Copied %1 file(s)").arg(copied));
+    transferFiles(selected, dest, false);
 }
 
 void MainWindow::onMoveFiles() {
@@ -1164,53 +1688,178 @@ void MainWindow::onMoveFiles() {
     QString dest = QFileDialog::getExistingDirectory(this, "Move to Directory");
     if (dest.isEmpty()) return;
     
-    // Progress dialog with cancel button
-    QProgressDialog progress("Moving files...", "Cancel", 0, selected.size(), this);
-    progress.setWindowModality(Qt::WindowModal);
-    progress.setMinimumDuration(500);  // Show after 500ms
+    transferFiles(selected, dest, true);
+}
+
+void MainWindow::onExportFiles() {
+    if (m_exporter && m_exporter->isRunning()) {
+        NotificationManager::instance().showInfo("Another export is still running");
+        return;
+    }
+    QStringList selected = m_thumbnailGrid->selectedFiles();
+    if (selected.isEmpty() && m_currentIndex >= 0) {
+        selected << m_imageFiles[m_currentIndex];
+    }
+    if (selected.isEmpty()) {
+        NotificationManager::instance().showInfo("No images selected");
+        return;
+    }
     
-    int moved = 0;
-    QStringList movedFiles;  // Track for later removal
+    QSettings settings("PhotoGuru", "Viewer");
+    ExportPipeline::Options options;
+    options.directory = QFileDialog::getExistingDirectory(this, "Export to Directory",
+                                                          settings.value("export/directory").toString());
+    if (options.directory.isEmpty()) return;
+    
+    QStringList formats;
+    for (const QByteArray& format : ExportPipeline::supportedFormats()) formats << QString::fromLatin1(format).toUpper();
+    bool ok = false;
+    const QString format = QInputDialog::getItem(this, "Export", "Format:", formats,
+        std::max(0, int(formats.indexOf(settings.value("export/format", "JPG").toString()))), false, &ok);
+    if (!ok) return;
+    options.format = format.toLower().toLatin1();
+    options.longEdge = QInputDialog::getInt(this, "Export", "Long edge in pixels (0 = full size):",
+        settings.value("export/longEdge", ExportPipeline::DEFAULT_LONG_EDGE).toInt(), 0, 65535, 256, &ok);
+    if (!ok) return;
+    if (options.format != "png") {
+        options.quality = QInputDialog::getInt(this, "Export", "Quality (0-100):",
+            settings.value("export/quality", ExportPipeline::DEFAULT_QUALITY).toInt(), 0, 100, 5, &ok);
+        if (!ok) return;
+    }
+    settings.setValue("export/directory", options.directory);
+    settings.setValue("export/format", format);
+    settings.setValue("export/longEdge", options.longEdge);
+    settings.setValue("export/quality", options.quality);
     
-    for (int i = 0; i < selected.size(); i++) {
-        progress.setValue(i);
+    if (!m_exporter) {
+        m_exporter = new ExportPipeline(ExportPipeline::defaultStages(), this);
+    }
+    auto* progress = new QProgressDialog(QString("Exporting %1 file(s)...").arg(selected.size()), "Cancel",
+                                         0, int(selected.size()), this);
+    progress->setWindowModality(Qt::NonModal);  // Browsing goes on meanwhile
+    progress->setMinimumDuration(500);
+    connect(progress, &QProgressDialog::canceled, m_exporter, &ExportPipeline::cancel);
+    connect(m_exporter, &ExportPipeline::progress, progress,
+            [this, progress](int current, int total, const QString& file) {
+        progress->setValue(current);
+        statusBar()->showMessage(QString("Exporting... %1 of %2 (%3)").arg(current).arg(total).arg(file));
+    });
+    connect(m_exporter, &ExportPipeline::finished, progress,
+            [this, progress, directory = options.directory](int exported, int failed, bool cancelled) {
+        progress->deleteLater();
+        QString summary = QString("Exported %1 file(s) to %2").arg(exported).arg(directory);
+        if (failed > 0) summary += QString(", %1 failed").arg(failed);
+        if (cancelled) summary = "Export cancelled. " + summary;
+        LOG_INFO("MainWindow", summary);
+        statusBar()->showMessage(summary, 5000);
+        if (failed > 0) NotificationManager::instance().showWarning(summary);
+    });
+    
+    if (!m_exporter->start(selected, options)) {
+        progress->deleteLater();
+        NotificationManager::instance().showWarning("Could not export to " + options.directory);
+    }
+}
+
+void MainWindow::startCatalogSync() {
+    QSettings settings("PhotoGuru", "Viewer");
+    const QUrl server(settings.value("catalog/server").toString());
+    if (server.isEmpty() || m_catalogSyncWatcher || !PhotoDatabase::instance().isInitialized()) return;
+    
+    // Embeddings are left to photoguru-cli --sync: the AnalysisPanel's store
+    // is open here and must not be written from a second instance
+    auto sync = std::make_shared<CatalogSync>(server, settings.value("catalog/token").toString());
+    const QString serverRoot = settings.value("catalog/serverRoot").toString();
+    if (!serverRoot.isEmpty()) sync->setPathMapping(serverRoot, settings.value("catalog/localRoot").toString());
+    
+    auto cancelled = std::make_shared<QAtomicInt>(0);
+    m_catalogSyncCancelled = cancelled;
+    m_catalogSyncWatcher = new QFutureWatcher<QString>(this);
+    connect(m_catalogSyncWatcher, &QFutureWatcher<QString>::finished, this, [this]() {
+        const QString summary = m_catalogSyncWatcher->future().result();
+        m_catalogSyncWatcher->deleteLater();
+        m_catalogSyncWatcher = nullptr;
+        m_catalogSyncCancelled.reset();
+        LOG_INFO("MainWindow", summary);
+        statusBar()->showMessage(summary, 5000);
+    });
+    m_catalogSyncWatcher->setFuture(m_tasks.run(TaskScheduler::Ingest, [sync, cancelled, server]() {
+        std::optional<CatalogSync::Result> result = sync->sync(cancelled.get());
+        if (!result) return "Catalog sync failed: " + sync->lastError();
+        return QString("Catalog synced from %1: %2 entries, %3 thumbnails")
+            .arg(server.host()).arg(result->records).arg(result->thumbnails);
+    }));
+}
+
+void MainWindow::transferFiles(const QStringList& files, const QString& destination, bool move) {
+    if (m_transferWatcher) {
+        NotificationManager::instance().showInfo("Another copy or move is still running");
+        return;
+    }
+    
+    const QString verb = move ? "Moving" : "Copying";
+    auto* progress = new QProgressDialog(QString("%1 %2 file(s)...").arg(verb).arg(files.size()), "Cancel",
+                                         0, files.size(), this);
+    progress->setWindowModality(Qt::NonModal);  // Browsing goes on meanwhile
+    progress->setMinimumDuration(500);  // Show after 500ms
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    connect(progress, &QProgressDialog::canceled, this, [cancelled]() { *cancelled = true; });
+    
+    // Off the GUI thread with the other bulk work: clones and renames are
+    // instant, but a byte copy to another disk or a share can take minutes.
+    // The dialog outlives the task: it goes only once the future finishes
+    QFuture<QStringList> future = m_tasks.run(TaskScheduler::Ingest,
+                                              [this, files, destination, move, cancelled, progress, verb]() {
+        const QDir dir(destination);
+        QStringList done;
+        for (int i = 0; i < files.size() && !*cancelled; i++) {
+            const QString target = dir.filePath(QFileInfo(files[i]).fileName());
+            if (move ? FileClone::move(files[i], target) : FileClone::copy(files[i], target).has_value()) {
+                // Edits kept in its sidecar go with the file
+                MetadataWriter::transferSidecar(files[i], target, move);
+                done << files[i];
+            }
+            QMetaObject::invokeMethod(progress, [this, progress, verb, value = i + 1, total = files.size()]() {
+                progress->setValue(value);
+                statusBar()->showMessage(QString("%1 files... %2 of %3").arg(verb).arg(value).arg(total));
+            });
+        }
+        return done;
+    });
+    
+    m_transferCancelled = cancelled;
+    m_transferWatcher = new QFutureWatcher<QStringList>(this);
+    connect(m_transferWatcher, &QFutureWatcher<QStringList>::finished, this,
+            [this, progress, move, cancelled, total = files.size()]() {
+        const QStringList done = m_transferWatcher->future().result();
+        m_transferWatcher->deleteLater();
+        m_transferWatcher = nullptr;
+        m_transferCancelled.reset();
+        progress->deleteLater();
         
-        // Check for cancellation
-        if (progress.wasCanceled()) {
-            // Remove already moved files from list
-            for (const QString& file : movedFiles) {
+        if (move && !done.isEmpty()) {
+            // Remove moved files from list
+            for (const QString& file : done) {
                 m_imageFiles.removeAll(file);
             }
-            m_thumbnailGrid->setImages(m_imageFiles);
-            statusBar()->showMessage(QString("Move cancelled. %1 of %2 files moved")
-                .arg(moved).arg(selected.size()));
-            return;
+            m_metadataService->remove(done);
+            m_thumbnailGrid->sortKeys().remove(done);
+            m_thumbnailGrid->updateImages(m_imageFiles);
+            
+            if (m_currentIndex >= m_imageFiles.count()) {
+                m_currentIndex = m_imageFiles.count() - 1;
+            }
         }
         
-        const QString& file = selected[i];
-        QFileInfo fi(file);
-        progress.setLabelText(QString("Moving %1...").arg(fi.fileName()));
-        
-        QString destFile = dest + "/" + fi.fileName();
-        if (QFile::rename(file, destFile)) {
-            moved++;
-            movedFiles << file;
+        const QString verbed = move ? "Moved" : "Copied";
+        if (*cancelled) {
+            statusBar()->showMessage(QString("%1 cancelled. %2 of %3 files %4")
+                .arg(move ? "Move" : "Copy").arg(done.size()).arg(total).arg(verbed.toLower()));
+        } else {
+            statusBar()->showMessage(QString("%1 %2 file(s)").arg(verbed).arg(done.size()));
         }
-    }
-    
-    // Remove moved files from list
-    for (const QString& file : movedFiles) {
-        m_imageFiles.removeAll(file);
-    }
-    
-    progress.setValue(selected.size());
-    m_thumbnailGrid->setImages(m_imageFiles);
-    
-    if (m_currentIndex >= m_imageFiles.count()) {
-        m_currentIndex = m_imageFiles.count() - 1;
-    }
-    
-    statusBar()->showMessage(QString("Moved %1 file(s)").arg(moved));
+    });
+    m_transferWatcher->setFuture(future);
 }
 
 void MainWindow::onRenameFile() {
@@ -1235,8 +1884,18 @@ void MainWindow::onRenameFile() {
     }
     
     if (QFile::rename(currentFile, newPath)) {
+        if (!MetadataWriter::transferSidecar(currentFile, newPath, true)) {
+            NotificationManager::instance().showWarning("File renamed, but its XMP sidecar kept the old name");
+        }
         m_imageFiles[m_currentIndex] = newPath;
-        m_thumbnailGrid->setImages(m_imageFiles);
+        // Same file under a new name: keep its metadata instead of reading it again
+        if (auto meta = m_metadataService->cached(currentFile)) {
+            PhotoMetadata renamed = *meta;
+            renamed.filepath = newPath;
+            m_metadataService->insert(renamed);
+        }
+        m_metadataService->remove({currentFile});
+        m_thumbnailGrid->updateImages(m_imageFiles);
         m_imageViewer->loadImage(newPath);
         statusBar()->showMessage("File renamed");
     } else {
@@ -1331,12 +1990,14 @@ void MainWindow::onSortOrderChanged(int index) {
         case 0: order = SortOrder::ByName; break;
         case 1: order = SortOrder::ByDate; break;
         case 2: order = SortOrder::BySize; break;
+        case 3: order = SortOrder::ByCaptureDate; break;
+        case 4: order = SortOrder::ByQuality; break;
+        case 5: order = SortOrder::ByRating; break;
         default: return;
     }
     
     m_thumbnailGrid->setSortOrder(order);
-    statusBar()->showMessage(QString("Sorted by: %1").arg(
-        index == 0 ? "Name" : index == 1 ? "Date" : "Size"), 1000);
+    statusBar()->showMessage(QString("Sorted by: %1").arg(m_sortCombo->itemText(index)), 1000);
 }
 
 // Rating implementation
@@ -1357,70 +2018,66 @@ void MainWindow::onSetRating(int stars) {
         statusBar()->showMessage(QString("Rating: %1").arg(starStr), 2000);
     }
     
-    // Refresh metadata panel to show new rating
-    m_metadataPanel->loadMetadata(filepath);
+    // The panel and filter show the new rating before it is written
+    if (auto metaOpt = m_metadataService->cached(filepath)) {
+        m_metadataPanel->loadMetadata(filepath, *metaOpt);
+    } else {
+        showMetadataWhenReady(filepath, m_metadataService->request(filepath));
+    }
+    if (m_filterPanel) {
+        m_filterPanel->triggerFilterUpdate();
+    }
 }
 
 void MainWindow::onIncreaseRating() {
-    if (m_currentIndex < 0 || m_currentIndex >= m_imageFiles.count()) {
-        return;
-    }
-    
-    QString filepath = m_imageFiles[m_currentIndex];
-    auto metaOpt = MetadataReader::instance().read(filepath);
-    if (!metaOpt) return;
-    
-    int currentRating = metaOpt->rating;
-    int newRating = qMin(5, currentRating + 1);
-    
-    if (newRating != currentRating) {
-        onSetRating(newRating);
-    }
+    adjustRating(+1);
 }
 
 void MainWindow::onDecreaseRating() {
+    adjustRating(-1);
+}
+
+void MainWindow::adjustRating(int delta) {
     if (m_currentIndex < 0 || m_currentIndex >= m_imageFiles.count()) {
         return;
     }
     
+    // Current rating from the cache, or once the read finishes
     QString filepath = m_imageFiles[m_currentIndex];
-    auto metaOpt = MetadataReader::instance().read(filepath);
-    if (!metaOpt) return;
-    
-    int currentRating = metaOpt->rating;
-    int newRating = qMax(0, currentRating - 1);
-    
-    if (newRating != currentRating) {
-        onSetRating(newRating);
-    }
+    m_metadataService->request(filepath).then(this, [this, filepath, delta](const MetadataService::Result& metaOpt) {
+        if (!metaOpt) return;
+        if (m_currentIndex < 0 || m_imageFiles.value(m_currentIndex) != filepath) return;
+        
+        int currentRating = m_ratingQueue->pending(filepath).value_or(metaOpt->rating);
+        int newRating = qBound(0, currentRating + delta, 5);
+        
+        if (newRating != currentRating) {
+            onSetRating(newRating);
+        }
+    });
 }
 
 void MainWindow::setImageRating(const QString& filepath, int stars) {
     // Clamp rating to 0-5
     stars = qMax(0, qMin(5, stars));
     
-    // Use ExifTool to write rating to XMP metadata
-    // XMP:Rating is standard tag supported by Lightroom, Bridge, etc.
-    QProcess process;
-    process.start("exiftool", {
-        "-XMP:Rating=" + QString::number(stars),
-        "-overwrite_original",
-        filepath
-    });
-    
-    bool finished = process.waitForFinished(3000);  // 3 second timeout
-    
-    if (finished && process.exitCode() == 0) {
-        // Success - update in-memory metadata cache
-        auto metaOpt = MetadataReader::instance().read(filepath);
-        if (metaOpt) {
-            PhotoMetadata meta = *metaOpt;
-            meta.rating = stars;
-            // Note: MetadataReader cache would need to be updated here
-            // For now, next read will pick up the new rating
-        }
-    } else {
-        qWarning() << "Failed to set rating for" << filepath;
+    // XMP:Rating is written in the background, batched with other ratings
+    m_ratingQueue->enqueue(filepath, stars);
+    
+    // Update in-memory metadata now so rating keys stack up
+    if (auto metaOpt = m_metadataService->cached(filepath)) {
+        PhotoMetadata meta = *metaOpt;
+        meta.rating = stars;
+        m_metadataService->insert(meta);
+        m_metadataIndex.upsert(meta);
+        m_timelineIndex.upsert(meta);
+        m_thumbnailGrid->sortKeys().setMetadata(meta);
+    }
+}
+
+void MainWindow::applyPendingRating(PhotoMetadata& metadata) const {
+    if (auto rating = m_ratingQueue->pending(metadata.filepath)) {
+        metadata.rating = *rating;
     }
 }
 
@@ -1466,6 +2123,11 @@ void MainWindow::onImportGoogleTakeout() {
     options.applyDateTime = true;
     options.overwriteExisting = true;  // Overwrite existing metadata
     options.createBackup = false;  // Don't create backups (exiftool does this)
+    options.progress = [&progress](int done, int total) {
+        progress.setMaximum(total);
+        progress.setValue(done);
+        return !progress.wasCanceled();
+    };
     
     // Run import
     GoogleTakeoutImporter importer;
@@ -1500,7 +2162,7 @@ void MainWindow::onImportGoogleTakeout() {
         
         // Refresh current image to show updated metadata
         if (m_currentIndex >= 0 && m_currentIndex < m_imageFiles.size()) {
-            m_metadataPanel->loadMetadata(m_imageFiles[m_currentIndex]);
+            refreshMetadata(m_imageFiles[m_currentIndex], true);
         }
     } else if (result.withJson == 0) {
         NotificationManager::instance().showWarning(
@@ -7,10 +7,22 @@
 #include <QSplitter>
 #include <QTabWidget>
 #include <QFutureWatcher>
+#include <atomic>
 #include <memory>
 #include "core/PhotoMetadata.h"
+#include "core/MetadataIndex.h"
+#include "core/TimelineIndex.h"
+#include "core/MetadataService.h"
+#include "core/RatingWriteQueue.h"
+#include "core/DirectoryWatcher.h"
+#include "core/LibraryScanner.h"
+#include "core/TaskScheduler.h"
 #include "FilterPanel.h"  // For FilterCriteria
 
+class QSlider;
+class QComboBox;
+class QMenu;
+
 namespace PhotoGuru {
 
 class ImageViewer;
@@ -22,6 +34,8 @@ class TimelineView;
 class SemanticSearch;
 class FilterPanel;
 class AnalysisPanel;
+class PerformancePanel;
+class ExportPipeline;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -32,6 +46,8 @@ public:
     
     // Load images from directory
     void loadDirectory(const QString& path);
+    // Every image below the roots; the grid fills while they're found
+    void loadLibrary(const QStringList& roots);
     
 protected:
     void closeEvent(QCloseEvent* event) override;
@@ -40,6 +56,7 @@ protected:
     
 private slots:
     void onOpenDirectory();
+    void onOpenLibrary();
     void onOpenFiles();
     void onPreviousImage();
     void onNextImage();
@@ -58,11 +75,13 @@ private slots:
     void onFilterChanged(const FilterCriteria& criteria);
     void onViewModeChanged(int index);
     void onSemanticSearchResult(const QString& filepath);
+    void onSearchByKey(const QString& keyId);  // From the catalog's SKP key index
     void onThumbnailSelectionChanged(int count);
     
     // New MVP features
     void onCopyFiles();
     void onMoveFiles();
+    void onExportFiles();
     void onRenameFile();
     void onDeleteFiles();
     void onRevealInFinder();
@@ -83,17 +102,35 @@ private:
     void createMenuBar();
     void createToolBar();
     void createDockPanels();
+    void ensureAnalysisPanel();
+    void ensurePerformancePanel();
     void createStatusBar();
     void loadSettings();
     void saveSettings();
+    void setReadAheadDepth(int depth);  // 0 = off
+    // The last session's folder, from its snapshot; false if there is none to show
+    bool restoreSession();
+    // Fills the views with m_imageFiles of `path` and starts the metadata preload
+    void showDirectory(const QString& path, int currentIndex);
+    // Copies or moves `files` into `destination` in the background
+    void transferFiles(const QStringList& files, const QString& destination, bool move);
+    // Pulls what the catalog server in the settings has that this catalog doesn't
+    void startCatalogSync();
+    // Smart albums (saved filters kept current by the catalog)
+    void saveSmartAlbum();
+    void populateSmartAlbumMenu(QMenu* menu);
+    void openSmartAlbum(qint64 id, const QString& name);
     void applyFilters();
     void refreshViews();
     void updateStatusBar();
     void setImageRating(const QString& filepath, int stars);
     void checkAndOfferGoogleTakeoutImport(const QString& directoryPath);
+    void rebuildMetadataIndex();
     
     // UI Components
     QToolBar* m_toolbar;
+    QSlider* m_sizeSlider = nullptr;
+    QComboBox* m_sortCombo = nullptr;
     QStatusBar* m_statusBar;
     
     // Central view modes (tabs)
@@ -118,28 +155,97 @@ private:
     FilterPanel* m_filterPanel;
     
     QDockWidget* m_analysisDock;
-    AnalysisPanel* m_analysisPanel;
+    AnalysisPanel* m_analysisPanel = nullptr;  // Built by ensureAnalysisPanel()
+    
+    QDockWidget* m_performanceDock;
+    PerformancePanel* m_performancePanel = nullptr;  // Built when its dock first shows
     
+    // Filter runs (Interactive) and catalog writes (Ingest)
+    TaskGroup m_tasks{TaskScheduler::Interactive};
+
     // Async filtering
     QFutureWatcher<QStringList>* m_filterWatcher;
     QFutureWatcher<void>* m_metadataLoader;
     FilterCriteria m_currentFilterCriteria;
     
-    // Metadata cache (filepath -> metadata)
-    QMap<QString, PhotoMetadata> m_metadataCache;
+    // The copy or move under way, if any; the flag stops it between files
+    QFutureWatcher<QStringList>* m_transferWatcher = nullptr;
+    std::shared_ptr<std::atomic<bool>> m_transferCancelled;
+    
+    ExportPipeline* m_exporter = nullptr;  // Resized copies of a selection; created on first use
+    
+    // Background pull from settings' catalog/server; the flag stops it between pages
+    QFutureWatcher<QString>* m_catalogSyncWatcher = nullptr;
+    std::shared_ptr<QAtomicInt> m_catalogSyncCancelled;
+    
+    int m_thumbnailBudgetId = 0;  // ThumbnailCache's memory tier in the MemoryBudget
+    int m_readAheadBudgetId = 0;  // FileReadAhead's buffers, likewise
+    
+    // Inputs and output of a filter run; the last finished one lets the
+    // next change refine its result instead of rescanning everything
+    struct FilterRun {
+        QStringList files;
+        FilterCriteria criteria;
+        quint64 indexRevision = 0;
+        QStringList result;
+        bool valid = false;
+    };
+    FilterRun m_runningFilter;
+    FilterRun m_lastFilter;
+    
+    // Metadata of the folder, read in the background (owned, child QObject)
+    MetadataService* m_metadataService = nullptr;
     QAtomicInt m_cacheLoadedCount;  // Tracks how many files loaded
+    
+    // Ratings are shown at once and written to the files in batches (owned, child QObject)
+    RatingWriteQueue* m_ratingQueue = nullptr;
+    
+    // Columnar copy of the service's cache used by filtering (GUI thread only).
+    // Bulk loads mark it dirty; single re-reads upsert directly.
+    MetadataIndex m_metadataIndex;
+    QAtomicInt m_metadataIndexDirty{1};
+    // Capture-time buckets of the same photos, kept in step with m_metadataIndex
+    // and masked by the last filter result
+    TimelineIndex m_timelineIndex;
     bool m_cacheLoadingComplete = false;
     
     // Current state
     QString m_currentDirectory;
+    DirectoryWatcher* m_directoryWatcher = nullptr;  // Keeps m_imageFiles in step with the disk
+    LibraryScanner* m_libraryScanner = nullptr;      // Recursive multi-root loads
+    int m_libraryLoadsPending = 0;                   // Metadata loads of streamed chunks
+    quint64 m_libraryGeneration = 0;                 // Drops loads of a library no longer shown
     QStringList m_imageFiles;
-    QList<PhotoMetadata> m_allPhotos;
-    QList<PhotoMetadata> m_filteredPhotos;
+    QList<PhotoHandle> m_allPhotos;
+    QList<PhotoHandle> m_filteredPhotos;
     int m_currentIndex = -1;
     
 private slots:
     void onFilterFinished();
     void onMetadataLoadFinished();
+    void onDirectoryChanged(const DirectoryWatcher::Changes& changes);
+    void onLibraryFilesFound(const QStringList& paths);
+    void onLibraryScanFinished(int total, bool cancelled);
+    
+private:
+    // Panel and SKP browser show `filepath` once its read finishes, if it is still selected
+    void showMetadataWhenReady(const QString& filepath, QFuture<MetadataService::Result> future);
+    void showMetadata(const QString& filepath, const MetadataService::Result& metaOpt, bool reloadPanel);
+    // Re-read after a write; the filter picks the new values up
+    void refreshMetadata(const QString& filepath, bool reloadPanel);
+    void adjustRating(int delta);
+    // Scan and its chunks' metadata loads are both done
+    void finishLibraryLoadIfDone();
+    // A read of a file with an unwritten rating still has the old one
+    void applyPendingRating(PhotoMetadata& metadata) const;
+    
+    // When the analysis panel, and with it the AI models, gets built if not shown before
+    static constexpr int DEFERRED_PANEL_DELAY_MS = 2000;
+    
+    // Of the MemoryBudget total; ImageViewer's caches take the rest
+    static constexpr double THUMBNAIL_BUDGET_SHARE = 0.25;
+    static constexpr double READ_AHEAD_BUDGET_SHARE = 0.1;
+    static constexpr int MAX_READ_AHEAD_DEPTH = 64;
 };
 
 } // namespace PhotoGuru
@@ -3,33 +3,27 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QWebChannel>
+#include <QWebEngineSettings>
+#include <algorithm>
+#include <cmath>
 
 namespace PhotoGuru {
 
-MapView::MapView(QWidget* parent)
-    : QWidget(parent)
-{
-    setupUI();
-}
+namespace {
 
-void MapView::setupUI() {
-    QVBoxLayout* layout = new QVBoxLayout(this);
-    layout->setContentsMargins(0, 0, 0, 0);
-    
-    m_webView = new QWebEngineView(this);
-    layout->addWidget(m_webView);
-    
-    // Load initial empty map
-    clearMap();
+bool hasGPS(const PhotoMetadata& photo) {
+    return photo.gps_lat != 0.0 || photo.gps_lon != 0.0;
 }
 
-void MapView::loadPhotos(const QList<PhotoMetadata>& photos) {
-    m_photos = photos;
-    generateMapHTML(photos);
+// Ground size of one 256 px tile pixel, as Leaflet's default CRS draws it
+double metersPerPixel(double lat, int zoom) {
+    constexpr double EQUATOR_METERS_PER_PIXEL = 156543.03392;
+    return EQUATOR_METERS_PER_PIXEL * std::cos(lat * 3.14159265358979323846 / 180.0) /
+           std::ldexp(1.0, std::max(zoom, 0));
 }
 
-void MapView::clearMap() {
-    QString html = R"(
+// Loaded once; everything after that goes through the "bridge" channel object
+const char* MAP_PAGE = R"HTML(
 <!DOCTYPE html>
 <html>
 <head>
@@ -37,84 +31,14 @@ void MapView::clearMap() {
     <title>Photo Map</title>
     <link rel="stylesheet" href="https://unpkg.com/leaflet@1.9.4/dist/leaflet.css" />
     <script src="https://unpkg.com/leaflet@1.9.4/dist/leaflet.js"></script>
-    <style>
-        body { margin: 0; padding: 0; }
-        #map { height: 100vh; width: 100vw; }
-    </style>
-</head>
-<body>
-    <div id="map"></div>
-    <script>
-        const map = L.map('map').setView([0, 0], 2);
-        L.tileLayer('https://{s}.tile.openstreetmap.org/{z}/{x}/{y}.png', {
-            maxZoom: 19,
-            attribution: '© OpenStreetMap contributors'
-        }).addTo(map);
-    </script>
-</body>
-</html>
-    )";
-    
-    m_webView->setHtml(html);
-}
-
-void MapView::generateMapHTML(const QList<PhotoMetadata>& photos) {
-    // Filter photos with GPS coordinates
-    QList<PhotoMetadata> photosWithGPS;
-    for (const auto& photo : photos) {
-        if (photo.gps_lat != 0.0 && photo.gps_lon != 0.0) {
-            photosWithGPS.append(photo);
-        }
-    }
-    
-    if (photosWithGPS.isEmpty()) {
-        clearMap();
-        return;
-    }
-    
-    // Build markers JSON
-    QJsonArray markers;
-    for (const auto& photo : photosWithGPS) {
-        QJsonObject marker;
-        marker["lat"] = photo.gps_lat;
-        marker["lng"] = photo.gps_lon;
-        marker["title"] = photo.llm_title.isEmpty() ? photo.filename : photo.llm_title;
-        marker["filepath"] = photo.filepath;
-        marker["location"] = photo.location_name;
-        marker["quality"] = photo.technical.overall_quality;
-        markers.append(marker);
-    }
-    
-    QJsonDocument doc(markers);
-    QString markersJson = QString::fromUtf8(doc.toJson(QJsonDocument::Compact));
-    
-    // Calculate center
-    double centerLat = 0, centerLng = 0;
-    for (const auto& photo : photosWithGPS) {
-        centerLat += photo.gps_lat;
-        centerLng += photo.gps_lon;
-    }
-    centerLat /= photosWithGPS.size();
-    centerLng /= photosWithGPS.size();
-    
-    QString html = QString(R"(
-<!DOCTYPE html>
-<html>
-<head>
-    <meta charset="utf-8">
-    <title>Photo Map</title>
-    <link rel="stylesheet" href="https://unpkg.com/leaflet@1.9.4/dist/leaflet.css" />
-    <script src="https://unpkg.com/leaflet@1.9.4/dist/leaflet.js"></script>
-    <link rel="stylesheet" href="https://unpkg.com/leaflet.markercluster@1.5.3/dist/MarkerCluster.css" />
-    <link rel="stylesheet" href="https://unpkg.com/leaflet.markercluster@1.5.3/dist/MarkerCluster.Default.css" />
-    <script src="https://unpkg.com/leaflet.markercluster@1.5.3/dist/leaflet.markercluster.js"></script>
+    <script src="qrc:///qtwebchannel/qwebchannel.js"></script>
     <style>
         body { margin: 0; padding: 0; background: #1e1e1e; }
         #map { height: 100vh; width: 100vw; }
         .photo-popup { min-width: 200px; }
         .photo-popup h3 { margin: 0 0 8px 0; color: #2c3e50; }
         .photo-popup p { margin: 4px 0; font-size: 12px; color: #555; }
-        .quality-badge { 
+        .quality-badge {
             display: inline-block;
             padding: 2px 8px;
             border-radius: 3px;
@@ -124,65 +48,277 @@ void MapView::generateMapHTML(const QList<PhotoMetadata>& photos) {
         .quality-high { background: #51cf66; color: white; }
         .quality-medium { background: #ffa500; color: white; }
         .quality-low { background: #ff6b6b; color: white; }
+        .photo-cluster div {
+            width: 100%; height: 100%;
+            border-radius: 50%;
+            background: rgba(74, 158, 255, 0.85);
+            border: 2px solid rgba(255, 255, 255, 0.9);
+            box-sizing: border-box;
+            display: flex; align-items: center; justify-content: center;
+            color: white; font: bold 12px sans-serif;
+        }
     </style>
 </head>
 <body>
     <div id="map"></div>
     <script>
-        const map = L.map('map').setView([%1, %2], 13);
-        
+        const map = L.map('map', { worldCopyJump: true }).setView([20, 0], 2);
         L.tileLayer('https://{s}.tile.openstreetmap.org/{z}/{x}/{y}.png', {
             maxZoom: 19,
             attribution: '© OpenStreetMap contributors'
         }).addTo(map);
-        
-        const markers = %3;
-        const markerCluster = L.markerClusterGroup({
-            maxClusterRadius: 50,
-            spiderfyOnMaxZoom: true
-        });
-        
-        markers.forEach(m => {
-            const qualityClass = m.quality > 0.7 ? 'quality-high' : 
-                                 m.quality > 0.4 ? 'quality-medium' : 'quality-low';
-            const qualityText = Math.round(m.quality * 100);
-            
+
+        const layer = L.layerGroup().addTo(map);
+        let bridge = null;
+        let request = 0;
+
+        function escapeHtml(text) {
+            const div = document.createElement('div');
+            div.textContent = text || '';
+            return div.innerHTML;
+        }
+
+        function photoMarker(c) {
+            const qualityClass = c.quality > 0.7 ? 'quality-high' :
+                                 c.quality > 0.4 ? 'quality-medium' : 'quality-low';
             const popup = `
                 <div class="photo-popup">
-                    <h3>${m.title}</h3>
-                    <p><strong>Location:</strong> ${m.location || 'Unknown'}</p>
-                    <p><strong>Quality:</strong> <span class="${qualityClass} quality-badge">${qualityText}/100</span></p>
+                    <h3>${escapeHtml(c.title)}</h3>
+                    <p><strong>Location:</strong> ${escapeHtml(c.location) || 'Unknown'}</p>
+                    <p><strong>Quality:</strong> <span class="${qualityClass} quality-badge">${Math.round(c.quality * 100)}/100</span></p>
                 </div>
             `;
-            
-            const marker = L.marker([m.lat, m.lng])
-                .bindPopup(popup);
-            markerCluster.addLayer(marker);
-        });
-        
-        map.addLayer(markerCluster);
-        
-        if (markers.length > 0) {
-            const bounds = L.latLngBounds(markers.map(m => [m.lat, m.lng]));
-            map.fitBounds(bounds, { padding: [50, 50] });
+            return L.marker([c.lat, c.lng], { title: c.title })
+                .bindPopup(popup)
+                .on('click', () => bridge.photoClicked(c.filepath));
         }
+
+        function clusterMarker(c) {
+            const size = c.count < 10 ? 30 : c.count < 100 ? 36 : c.count < 1000 ? 42 : 48;
+            const icon = L.divIcon({
+                html: `<div>${c.count}</div>`,
+                className: 'photo-cluster',
+                iconSize: [size, size]
+            });
+            return L.marker([c.lat, c.lng], { icon: icon })
+                .on('click', () => map.setView([c.lat, c.lng], Math.min(map.getZoom() + 2, map.getMaxZoom())));
+        }
+
+        function render(id, json) {
+            if (id !== request) return;  // A newer viewport is already on its way
+            layer.clearLayers();
+            JSON.parse(json).forEach(c => layer.addLayer(c.count === 1 ? photoMarker(c) : clusterMarker(c)));
+        }
+
+        function reportViewport() {
+            const b = map.getBounds();
+            request += 1;
+            bridge.viewportChanged(request, b.getSouth(), b.getWest(), b.getNorth(), b.getEast(), map.getZoom());
+        }
+
+        new QWebChannel(qt.webChannelTransport, channel => {
+            bridge = channel.objects.bridge;
+            bridge.clustersReady.connect(render);
+            bridge.fitBounds.connect((south, west, north, east) => {
+                if (south === north && west === east) {
+                    map.setView([south, west], 13);
+                } else {
+                    map.fitBounds([[south, west], [north, east]], { padding: [50, 50] });
+                }
+            });
+            bridge.focus.connect((lat, lng, zoom) => map.setView([lat, lng], zoom));
+            map.on('moveend', reportViewport);
+            map.on('click', e => bridge.mapClicked(e.latlng.lat, e.latlng.lng, map.getZoom()));
+            bridge.ready();
+            reportViewport();
+        });
     </script>
 </body>
 </html>
-    )").arg(centerLat).arg(centerLng).arg(markersJson);
-    
-    m_webView->setHtml(html);
+)HTML";
+
+} // namespace
+
+MapBridge::MapBridge(MapView* view)
+    : QObject(view)
+    , m_view(view)
+{
+}
+
+void MapBridge::ready() {
+    m_view->onPageReady();
+}
+
+void MapBridge::viewportChanged(int request, double south, double west,
+                                double north, double east, int zoom) {
+    m_view->onViewportChanged(request, MapView::Viewport{south, west, north, east, zoom});
+}
+
+void MapBridge::photoClicked(const QString& filepath) {
+    emit m_view->photoSelected(filepath);
+}
+
+void MapBridge::mapClicked(double lat, double lng, int zoom) {
+    m_view->onMapClicked(lat, lng, zoom);
+}
+
+MapView::MapView(QWidget* parent)
+    : QWidget(parent)
+{
+    setupUI();
+}
+
+void MapView::setupUI() {
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    m_webView = new QWebEngineView(this);
+    layout->addWidget(m_webView);
+
+    m_bridge = new MapBridge(this);
+    QWebChannel* channel = new QWebChannel(this);
+    channel->registerObject("bridge", m_bridge);
+    m_webView->page()->setWebChannel(channel);
+
+    // qrc base for qwebchannel.js; Leaflet and the tiles are remote
+    m_webView->settings()->setAttribute(QWebEngineSettings::LocalContentCanAccessRemoteUrls, true);
+    m_webView->setHtml(QString::fromUtf8(MAP_PAGE), QUrl("qrc:///"));
+}
+
+void MapView::loadPhotos(const QList<PhotoHandle>& photos) {
+    m_photos = photos;
+    m_photoForPath.clear();
+    m_photoForPath.reserve(photos.size());
+
+    std::vector<GeoClusterIndex::Point> points;
+    points.reserve(size_t(photos.size()));
+    for (int i = 0; i < photos.size(); ++i) {
+        points.push_back({photos[i]->gps_lat, photos[i]->gps_lon});
+        m_photoForPath.insert(photos[i]->filepath, i);
+    }
+    m_index.build(points);
+    m_visible.assign(size_t(photos.size()), true);
+
+    // The filter in effect applies to the new photos too
+    if (m_filtered) {
+        for (int i = 0; i < m_photos.size(); ++i) {
+            if (hasGPS(*m_photos[i])) m_visible[size_t(i)] = m_criteria.matches(*m_photos[i]);
+        }
+        m_index.setVisible(m_visible);
+    }
+
+    fitToPhotos();
+    sendClusters();  // In case the fit doesn't move the map
+}
+
+void MapView::clearMap() {
+    m_photos.clear();
+    m_photoForPath.clear();
+    m_index.clear();
+    m_visible.clear();
+    sendClusters();
+}
+
+void MapView::applyFilter(const FilterCriteria& criteria) {
+    // A narrower filter can only hide more: re-check just what is shown
+    const bool narrower = m_filtered && criteria.isNarrowerThan(m_criteria);
+    for (int i = 0; i < m_photos.size(); ++i) {
+        if (!hasGPS(*m_photos[i]) || (narrower && !m_visible[size_t(i)])) continue;
+        m_visible[size_t(i)] = criteria.matches(*m_photos[i]);
+    }
+    m_criteria = criteria;
+    m_filtered = true;
+
+    m_index.setVisible(m_visible);
+    sendClusters();
 }
 
 void MapView::focusOnPhoto(const QString& filepath) {
-    // Find photo and center map on it
-    for (const auto& photo : m_photos) {
-        if (photo.filepath == filepath && photo.gps_lat != 0.0) {
-            QString js = QString("map.setView([%1, %2], 16);")
-                .arg(photo.gps_lat).arg(photo.gps_lon);
-            m_webView->page()->runJavaScript(js);
-            break;
+    if (!m_pageReady) return;
+    auto it = m_photoForPath.constFind(filepath);
+    if (it == m_photoForPath.constEnd()) return;
+    const PhotoMetadata& photo = *m_photos[it.value()];
+    if (hasGPS(photo)) {
+        emit m_bridge->focus(photo.gps_lat, photo.gps_lon, FOCUS_ZOOM);
+    }
+}
+
+QStringList MapView::photosInBox(const GeoBox& box) const {
+    return pathsOf(m_index.inBox(box));
+}
+
+QStringList MapView::photosWithinRadius(const GeoCircle& circle) const {
+    return pathsOf(m_index.withinRadius(circle));
+}
+
+QString MapView::nearestPhoto(double lat, double lon, double maxMeters) const {
+    int photo = m_index.nearest(lat, lon, maxMeters);
+    return photo >= 0 ? m_photos[photo]->filepath : QString();
+}
+
+QStringList MapView::pathsOf(const std::vector<int>& photos) const {
+    QStringList paths;
+    paths.reserve(int(photos.size()));
+    for (int photo : photos) paths << m_photos[photo]->filepath;
+    return paths;
+}
+
+QString MapView::clustersJson(double south, double west, double north, double east, int zoom) const {
+    QJsonArray clusters;
+    for (const GeoClusterIndex::Cluster& cluster : m_index.query(south, west, north, east, zoom)) {
+        QJsonObject object;
+        object["lat"] = cluster.lat;
+        object["lng"] = cluster.lon;
+        object["count"] = cluster.count;
+        if (cluster.count == 1) {
+            const PhotoMetadata& photo = *m_photos[cluster.first];
+            object["filepath"] = photo.filepath;
+            object["title"] = photo.llm_title.isEmpty() ? photo.filename : photo.llm_title;
+            object["location"] = photo.location_name;
+            object["quality"] = photo.technical.overall_quality;
         }
+        clusters.append(object);
+    }
+    return QString::fromUtf8(QJsonDocument(clusters).toJson(QJsonDocument::Compact));
+}
+
+void MapView::onPageReady() {
+    m_pageReady = true;
+    if (m_fitPending) {
+        fitToPhotos();
+    }
+}
+
+void MapView::onViewportChanged(int request, const Viewport& viewport) {
+    m_lastRequest = request;
+    m_viewport = viewport;
+    sendClusters();
+}
+
+void MapView::onMapClicked(double lat, double lon, int zoom) {
+    QString filepath = nearestPhoto(lat, lon, CLICK_TOLERANCE_PX * metersPerPixel(lat, zoom));
+    if (!filepath.isEmpty()) {
+        emit photoSelected(filepath);
+    }
+}
+
+void MapView::sendClusters() {
+    if (!m_pageReady) return;
+    emit m_bridge->clustersReady(m_lastRequest, clustersJson(m_viewport.south, m_viewport.west,
+                                                             m_viewport.north, m_viewport.east,
+                                                             m_viewport.zoom));
+}
+
+void MapView::fitToPhotos() {
+    if (!m_pageReady) {
+        m_fitPending = true;
+        return;
+    }
+    m_fitPending = false;
+
+    double south, west, north, east;
+    if (m_index.bounds(&south, &west, &north, &east)) {
+        emit m_bridge->fitBounds(south, west, north, east);
     }
 }
 
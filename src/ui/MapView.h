@@ -3,29 +3,113 @@
 #include <QWidget>
 #include <QWebEngineView>
 #include <QVBoxLayout>
+#include <QHash>
 #include "core/PhotoMetadata.h"
+#include "core/FilterCriteria.h"
+#include "core/GeoClusterIndex.h"
 
 namespace PhotoGuru {
 
+class MapView;
+
+// The page's end of the QWebChannel: viewport changes in, clusters out
+class MapBridge : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MapBridge(MapView* view);
+
+    Q_INVOKABLE void ready();
+    Q_INVOKABLE void viewportChanged(int request, double south, double west,
+                                     double north, double east, int zoom);
+    Q_INVOKABLE void photoClicked(const QString& filepath);
+    Q_INVOKABLE void mapClicked(double lat, double lng, int zoom);
+
+signals:
+    // JSON array of {lat, lng, count, filepath, title, location, quality}
+    void clustersReady(int request, const QString& clusters);
+    void fitBounds(double south, double west, double north, double east);
+    void focus(double lat, double lng, int zoom);
+
+private:
+    MapView* m_view;
+};
+
+/**
+ * @brief Map of geotagged photos, clustered in C++
+ *
+ * The Leaflet page is loaded once. It reports its viewport over
+ * QWebChannel, and the view answers with just the clusters inside it,
+ * from a GeoClusterIndex built when photos are loaded. Loading photos or
+ * changing the filter re-sends the current viewport's clusters, and the
+ * page is never rebuilt. A filter change re-masks the index without
+ * rebuilding it, and a narrower filter re-checks only the photos still
+ * shown. A click on the map between markers selects the nearest shown
+ * photo within a few pixels, found through the same index. Photos are
+ * held as the catalog's PhotoHandles, not copies.
+ */
 class MapView : public QWidget {
     Q_OBJECT
-    
+
 public:
     explicit MapView(QWidget* parent = nullptr);
-    
-    void loadPhotos(const QList<PhotoMetadata>& photos);
+
+    void loadPhotos(const QList<PhotoHandle>& photos);
+    void loadPhotos(const QList<PhotoMetadata>& photos) { loadPhotos(makePhotoHandles(photos)); }
     void clearMap();
     void focusOnPhoto(const QString& filepath);
-    
+
+    // Shows only photos matching `criteria`; the page keeps its viewport
+    void applyFilter(const FilterCriteria& criteria);
+
+    int photoCount() const { return m_index.size(); }
+    int visiblePhotoCount() const { return m_index.visibleCount(); }
+
+    // Shown photos in a region, and the one closest to a point (empty if none within maxMeters)
+    QStringList photosInBox(const GeoBox& box) const;
+    QStringList photosWithinRadius(const GeoCircle& circle) const;
+    QString nearestPhoto(double lat, double lon, double maxMeters) const;
+
+    // JSON the page gets for a viewport (what clustersReady carries)
+    QString clustersJson(double south, double west, double north, double east, int zoom) const;
+
 signals:
     void photoSelected(const QString& filepath);
-    
+
 private:
+    friend class MapBridge;
+
+    struct Viewport {
+        double south = -90.0;
+        double west = -180.0;
+        double north = 90.0;
+        double east = 180.0;
+        int zoom = 2;
+    };
+
     void setupUI();
-    void generateMapHTML(const QList<PhotoMetadata>& photos);
-    
+    void onPageReady();
+    void onViewportChanged(int request, const Viewport& viewport);
+    void onMapClicked(double lat, double lon, int zoom);
+    QStringList pathsOf(const std::vector<int>& photos) const;
+    void sendClusters();
+    void fitToPhotos();
+
     QWebEngineView* m_webView;
-    QList<PhotoMetadata> m_photos;
+    MapBridge* m_bridge;
+    QList<PhotoHandle> m_photos;
+    QHash<QString, int> m_photoForPath;
+    GeoClusterIndex m_index;
+    std::vector<bool> m_visible;       // Per photo, the current filter's result
+    FilterCriteria m_criteria;
+    bool m_filtered = false;
+    bool m_pageReady = false;
+    bool m_fitPending = false;
+    Viewport m_viewport;
+    int m_lastRequest = 0;
+
+    static constexpr int FOCUS_ZOOM = 16;
+    static constexpr int CLICK_TOLERANCE_PX = 24;
 };
 
 } // namespace PhotoGuru
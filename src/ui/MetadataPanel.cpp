@@ -11,6 +11,7 @@
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QFrame>
+#include <QSignalBlocker>
 
 namespace PhotoGuru {
 
@@ -71,6 +72,7 @@ void CollapsibleGroupBox::toggleExpanded() {
         buttonText.replace("▼", "▶");
     }
     m_toggleButton->setText(buttonText);
+    emit expandedChanged(m_expanded);
 }
 
 // ========== MetadataFieldWidget Implementation ==========
@@ -80,43 +82,27 @@ MetadataFieldWidget::MetadataFieldWidget(const QString& key, const QString& valu
     : QWidget(parent)
     , m_key(key)
     , m_originalValue(value)
+    , m_keyLabel(nullptr)
     , m_valueEdit(nullptr)
     , m_textEdit(nullptr)
     , m_removeButton(nullptr)
+    , m_multiline(false)
     , m_modified(false)
 {
     QHBoxLayout* layout = new QHBoxLayout(this);
     layout->setContentsMargins(0, 2, 0, 2);
     
     // Key label (fixed width for alignment)
-    QLabel* keyLabel = new QLabel(key + ":", this);
-    keyLabel->setStyleSheet("color: #aaa; font-weight: bold;");
-    keyLabel->setMinimumWidth(150);
-    keyLabel->setMaximumWidth(150);
-    layout->addWidget(keyLabel);
+    m_keyLabel = new QLabel(key + ":", this);
+    m_keyLabel->setStyleSheet("color: #aaa; font-weight: bold;");
+    m_keyLabel->setMinimumWidth(150);
+    m_keyLabel->setMaximumWidth(150);
+    layout->addWidget(m_keyLabel);
     
     // Determine if we need multiline edit
-    m_multiline = value.length() > 100 || value.contains('\n');
-    
-    if (m_multiline) {
-        m_textEdit = new QTextEdit(this);
-        m_textEdit->setPlainText(value);
-        m_textEdit->setReadOnly(!editable);
-        m_textEdit->setMaximumHeight(80);
-        connect(m_textEdit, &QTextEdit::textChanged, this, [this]() {
-            m_modified = true;
-            emit valueChanged(m_key, m_textEdit->toPlainText());
-        });
-        layout->addWidget(m_textEdit);
-    } else {
-        m_valueEdit = new QLineEdit(value, this);
-        m_valueEdit->setReadOnly(!editable);
-        connect(m_valueEdit, &QLineEdit::textChanged, this, [this](const QString& text) {
-            m_modified = true;
-            emit valueChanged(m_key, text);
-        });
-        layout->addWidget(m_valueEdit);
-    }
+    setMultiline(value.length() > 100 || value.contains('\n'));
+    setValue(value);
+    setEditable(editable);
     
     // Remove button (only for custom fields in edit mode)
     if (editable && key.startsWith("Custom:")) {
@@ -131,18 +117,13 @@ MetadataFieldWidget::MetadataFieldWidget(const QString& key, const QString& valu
 }
 
 QString MetadataFieldWidget::value() const {
-    if (m_textEdit) {
-        return m_textEdit->toPlainText();
-    } else if (m_valueEdit) {
-        return m_valueEdit->text();
-    }
-    return QString();
+    return m_multiline ? m_textEdit->toPlainText() : m_valueEdit->text();
 }
 
 void MetadataFieldWidget::setValue(const QString& value) {
-    if (m_textEdit) {
+    if (m_multiline) {
         m_textEdit->setPlainText(value);
-    } else if (m_valueEdit) {
+    } else {
         m_valueEdit->setText(value);
     }
     m_originalValue = value;
@@ -150,9 +131,9 @@ void MetadataFieldWidget::setValue(const QString& value) {
 }
 
 void MetadataFieldWidget::setEditable(bool editable) {
-    if (m_textEdit) {
+    if (m_multiline) {
         m_textEdit->setReadOnly(!editable);
-    } else if (m_valueEdit) {
+    } else {
         m_valueEdit->setReadOnly(!editable);
     }
     
@@ -161,6 +142,43 @@ void MetadataFieldWidget::setEditable(bool editable) {
     }
 }
 
+void MetadataFieldWidget::setMultiline(bool multiline) {
+    m_multiline = multiline;
+    auto* layout = static_cast<QHBoxLayout*>(this->layout());
+    
+    if (multiline && !m_textEdit) {
+        m_textEdit = new QTextEdit(this);
+        m_textEdit->setMaximumHeight(80);
+        connect(m_textEdit, &QTextEdit::textChanged, this, [this]() {
+            m_modified = true;
+            emit valueChanged(m_key, m_textEdit->toPlainText());
+        });
+        layout->insertWidget(1, m_textEdit);
+    } else if (!multiline && !m_valueEdit) {
+        m_valueEdit = new QLineEdit(this);
+        connect(m_valueEdit, &QLineEdit::textChanged, this, [this](const QString& text) {
+            m_modified = true;
+            emit valueChanged(m_key, text);
+        });
+        layout->insertWidget(1, m_valueEdit);
+    }
+    
+    if (m_textEdit) m_textEdit->setVisible(multiline);
+    if (m_valueEdit) m_valueEdit->setVisible(!multiline);
+}
+
+void MetadataFieldWidget::reset(const QString& key, const QString& value, bool editable) {
+    m_key = key;
+    m_keyLabel->setText(key + ":");
+    setMultiline(value.length() > 100 || value.contains('\n'));
+    {
+        // Refilling a row is not an edit
+        const QSignalBlocker blocker(this);
+        setValue(value);
+    }
+    setEditable(editable);
+}
+
 // ========== MetadataPanel Implementation ==========
 
 MetadataPanel::MetadataPanel(QWidget* parent)
@@ -170,6 +188,14 @@ MetadataPanel::MetadataPanel(QWidget* parent)
 {
     setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Expanding);
     setupUI();
+    
+    m_allMetadataWatcher = new QFutureWatcher<QJsonObject>(this);
+    connect(m_allMetadataWatcher, &QFutureWatcher<QJsonObject>::finished, this, [this]() {
+        // Superseded by another image meanwhile: its own read follows
+        if (m_allMetadataWatcher->isCanceled() || m_allMetadataPath != m_currentFilepath) return;
+        m_allMetadata = m_allMetadataWatcher->result();
+        displayAllMetadata(m_allMetadata);
+    });
 }
 
 void MetadataPanel::setupUI() {
@@ -394,6 +420,26 @@ void MetadataPanel::setupMetadataTab() {
     m_customSection = new CollapsibleGroupBox("Custom Fields", this);
     m_metadataLayout->addWidget(m_customSection);
     
+    // These four show the full tag dump; nobody pays for it until one opens
+    for (CollapsibleGroupBox* box : {m_exifSection, m_iptcSection, m_xmpSection, m_fileSection}) {
+        TagSection section;
+        section.box = box;
+        section.layout = new QVBoxLayout();
+        section.emptyLabel = new QLabel("No data available");
+        section.emptyLabel->setStyleSheet("color: #888; font-style: italic; padding: 8px;");
+        section.layout->addWidget(section.emptyLabel);
+        section.layout->addStretch();
+        box->setContentLayout(section.layout);
+        
+        const int index = m_tagSections.size();
+        m_tagSections.append(section);
+        connect(box, &CollapsibleGroupBox::expandedChanged, this, [this, index](bool expanded) {
+            if (!expanded) return;
+            requestAllMetadata();
+            if (!m_tagSections[index].populated) populateMetadataSection(m_tagSections[index]);
+        });
+    }
+    
     m_metadataLayout->addStretch();
     
     m_metadataScrollArea->setWidget(m_metadataContent);
@@ -414,15 +460,7 @@ void MetadataPanel::loadMetadata(const QString& filepath) {
         return;
     }
     
-    m_currentMetadata = *metaOpt;
-    
-    // Read all metadata (including all EXIF/IPTC/XMP fields)
-    m_allMetadata = readAllMetadata(filepath);
-    
-    displayMetadata(m_currentMetadata);
-    displayAllMetadata(m_allMetadata);
-    
-    m_editButton->setEnabled(true);
+    loadMetadata(filepath, *metaOpt);
 }
 
 void MetadataPanel::loadMetadata(const QString& filepath, const PhotoMetadata& metadata) {
@@ -431,16 +469,33 @@ void MetadataPanel::loadMetadata(const QString& filepath, const PhotoMetadata& m
     m_currentFilepath = filepath;
     m_currentMetadata = metadata;
     
-    // Read all metadata (including all EXIF/IPTC/XMP fields) 
-    // This is still needed for the "All Metadata" tab
-    m_allMetadata = readAllMetadata(filepath);
-    
     displayMetadata(m_currentMetadata);
+    
+    // All EXIF/IPTC/XMP fields arrive off the GUI thread, and only if one
+    // of their sections is open; the quick-edit fields above don't wait
+    m_allMetadata = QJsonObject();
     displayAllMetadata(m_allMetadata);
+    m_allMetadataPath.clear();
+    requestAllMetadata();
     
     m_editButton->setEnabled(true);
 }
 
+void MetadataPanel::requestAllMetadata() {
+    const bool shown = m_exifSection->isExpanded() || m_iptcSection->isExpanded() ||
+                       m_xmpSection->isExpanded() || m_fileSection->isExpanded();
+    if (!shown || m_currentFilepath.isEmpty() || m_allMetadataPath == m_currentFilepath) {
+        return;
+    }
+    
+    // Stepping through images: a dump still queued for one already left is dropped
+    m_tasks.clear();
+    const QString filepath = m_currentFilepath;
+    m_allMetadataPath = filepath;
+    m_allMetadataWatcher->setFuture(m_tasks.run(TaskScheduler::Interactive,
+                                                [filepath]() { return readAllMetadata(filepath); }));
+}
+
 QJsonObject MetadataPanel::readAllMetadata(const QString& filepath) {
     // Use ExifTool to get ALL metadata fields
     QStringList args = {"-json", "-a", "-G", filepath};
@@ -489,33 +544,29 @@ void MetadataPanel::displayAllMetadata(const QJsonObject& allMetadata) {
     // Clear existing field widgets
     m_fieldWidgets.clear();
     
-    // Separate metadata by group
-    QStringList exifKeys, iptcKeys, xmpKeys, fileKeys;
-    
+    // Separate metadata by group: EXIF, IPTC, XMP, File, as in m_tagSections
+    for (TagSection& section : m_tagSections) {
+        section.keys.clear();
+        section.populated = false;
+    }
     for (auto it = allMetadata.begin(); it != allMetadata.end(); ++it) {
         QString key = it.key();
         if (key.startsWith("EXIF:")) {
-            exifKeys << key;
+            m_tagSections[0].keys << key;
         } else if (key.startsWith("IPTC:")) {
-            iptcKeys << key;
+            m_tagSections[1].keys << key;
         } else if (key.startsWith("XMP") || key.startsWith("XMP-")) {
-            xmpKeys << key;
+            m_tagSections[2].keys << key;
         } else if (key.startsWith("File:")) {
-            fileKeys << key;
+            m_tagSections[3].keys << key;
         }
     }
     
-    // Sort keys alphabetically
-    exifKeys.sort();
-    iptcKeys.sort();
-    xmpKeys.sort();
-    fileKeys.sort();
-    
-    // Populate sections
-    populateMetadataSection(m_exifSection, exifKeys, allMetadata, false);
-    populateMetadataSection(m_iptcSection, iptcKeys, allMetadata, false);
-    populateMetadataSection(m_xmpSection, xmpKeys, allMetadata, false);
-    populateMetadataSection(m_fileSection, fileKeys, allMetadata, false);
+    // Sort keys alphabetically; closed sections fill when opened
+    for (TagSection& section : m_tagSections) {
+        section.keys.sort();
+        if (section.box->isExpanded()) populateMetadataSection(section);
+    }
     
     // Populate custom fields section
     QVBoxLayout* customLayout = new QVBoxLayout();
@@ -535,42 +586,44 @@ void MetadataPanel::displayAllMetadata(const QJsonObject& allMetadata) {
     m_customSection->setContentLayout(customLayout);
 }
 
-void MetadataPanel::populateMetadataSection(CollapsibleGroupBox* section, 
-                                            const QStringList& keys, 
-                                            const QJsonObject& metadata,
-                                            bool editable) {
-    QVBoxLayout* layout = new QVBoxLayout();
-    
-    if (keys.isEmpty()) {
-        QLabel* emptyLabel = new QLabel("No data available");
-        emptyLabel->setStyleSheet("color: #888; font-style: italic; padding: 8px;");
-        layout->addWidget(emptyLabel);
-    } else {
-        for (const QString& key : keys) {
-            QJsonValue value = metadata[key];
-            QString valueStr;
-            
-            if (value.isArray()) {
-                QJsonArray arr = value.toArray();
-                QStringList items;
-                for (const QJsonValue& v : arr) {
-                    items << v.toString();
-                }
-                valueStr = items.join(", ");
-            } else {
-                valueStr = value.toString();
-            }
-            
-            if (!valueStr.isEmpty()) {
-                MetadataFieldWidget* widget = new MetadataFieldWidget(key, valueStr, editable, this);
-                m_fieldWidgets[key] = widget;
-                layout->addWidget(widget);
+void MetadataPanel::populateMetadataSection(TagSection& section) {
+    int shown = 0;
+    for (const QString& key : section.keys) {
+        QJsonValue value = m_allMetadata[key];
+        QString valueStr;
+        
+        if (value.isArray()) {
+            QJsonArray arr = value.toArray();
+            QStringList items;
+            for (const QJsonValue& v : arr) {
+                items << v.toString();
             }
+            valueStr = items.join(", ");
+        } else {
+            valueStr = value.toString();
         }
+        
+        if (valueStr.isEmpty()) continue;
+        
+        MetadataFieldWidget* widget;
+        if (shown < section.rows.size()) {
+            widget = section.rows[shown];
+            widget->reset(key, valueStr, false);
+            widget->setVisible(true);
+        } else {
+            widget = new MetadataFieldWidget(key, valueStr, false, this);
+            section.layout->insertWidget(section.layout->count() - 1, widget);  // Above the stretch
+            section.rows.append(widget);
+        }
+        m_fieldWidgets[key] = widget;
+        shown++;
     }
     
-    layout->addStretch();
-    section->setContentLayout(layout);
+    for (int i = shown; i < section.rows.size(); i++) {
+        section.rows[i]->setVisible(false);
+    }
+    section.emptyLabel->setVisible(section.keys.isEmpty());
+    section.populated = true;
 }
 
 QString MetadataPanel::formatExifInfo(const PhotoMetadata& meta) {
@@ -716,30 +769,7 @@ void MetadataPanel::removeField(const QString& key) {
     }
 }
 
-void MetadataPanel::saveMetadata() {
-    if (m_currentFilepath.isEmpty()) {
-        return;
-    }
-    
-    // Check if in pending mode (not auto-save)
-    if (!m_autoSaveMode) {
-        // Mark as pending change
-        m_pendingChanges[m_currentFilepath] = "modified";
-        
-        // Highlight edited fields
-        QString highlightStyle = "background-color: #fffacd; border: 1px solid #ffa500;";
-        m_titleEdit->setStyleSheet(highlightStyle);
-        m_descriptionEdit->setStyleSheet(highlightStyle);
-        m_keywordsEdit->setStyleSheet(highlightStyle);
-        m_categoryEdit->setStyleSheet(highlightStyle);
-        m_locationEdit->setStyleSheet(highlightStyle);
-        
-        updatePendingUI();
-        NotificationManager::instance().showInfo("Changes marked as pending. Use 'Commit' to save.");
-        return;
-    }
-    
-    // Auto-save mode: save immediately
+MetadataWriter::Transaction MetadataPanel::editedTransaction() {
     // Update current metadata with edited values
     m_currentMetadata.rating = m_ratingSlider->value();
     m_currentMetadata.llm_title = m_titleEdit->text().trimmed();
@@ -758,25 +788,41 @@ void MetadataPanel::saveMetadata() {
     m_currentMetadata.llm_category = m_categoryEdit->text().trimmed();
     m_currentMetadata.location_name = m_locationEdit->text().trimmed();
     
-    // Save using MetadataWriter
-    bool success = MetadataWriter::instance().write(m_currentFilepath, m_currentMetadata);
+    // Quick-edit fields and custom fields in one file rewrite
+    MetadataWriter::Transaction transaction(m_currentFilepath);
+    transaction.setMetadata(m_currentMetadata);
+    for (auto it = m_customFields.begin(); it != m_customFields.end(); ++it) {
+        transaction.setCustomField(it.key().mid(7), it.value());  // Remove "Custom:" prefix
+    }
+    return transaction;
+}
+
+void MetadataPanel::saveMetadata() {
+    if (m_currentFilepath.isEmpty()) {
+        return;
+    }
     
-    // Also save custom fields using ExifTool directly
-    if (success && !m_customFields.isEmpty()) {
-        QStringList args;
-        args << "-overwrite_original";
+    // Check if in pending mode (not auto-save)
+    if (!m_autoSaveMode) {
+        // Queue the edits; committing writes each file once
+        m_pendingChanges[m_currentFilepath] = editedTransaction();
         
-        for (auto it = m_customFields.begin(); it != m_customFields.end(); ++it) {
-            QString fieldName = it.key().mid(7);  // Remove "Custom:" prefix
-            QString value = it.value();
-            // Write to XMP custom namespace
-            args << QString("-XMP-photoguru:%1=%2").arg(fieldName).arg(value);
-        }
+        // Highlight edited fields
+        QString highlightStyle = "background-color: #fffacd; border: 1px solid #ffa500;";
+        m_titleEdit->setStyleSheet(highlightStyle);
+        m_descriptionEdit->setStyleSheet(highlightStyle);
+        m_keywordsEdit->setStyleSheet(highlightStyle);
+        m_categoryEdit->setStyleSheet(highlightStyle);
+        m_locationEdit->setStyleSheet(highlightStyle);
         
-        args << m_currentFilepath;
-        ExifToolDaemon::instance().executeCommand(args);
+        updatePendingUI();
+        NotificationManager::instance().showInfo("Changes marked as pending. Use 'Commit' to save.");
+        return;
     }
     
+    // Auto-save mode: save immediately
+    bool success = MetadataWriter::instance().commit(editedTransaction());
+    
     if (success) {
         setEditable(false);
         emit metadataChanged(m_currentFilepath);
@@ -806,6 +852,7 @@ void MetadataPanel::updateRatingDisplay(int rating) {
 
 void MetadataPanel::clear() {
     m_currentFilepath.clear();
+    m_allMetadataPath.clear();
     m_allMetadata = QJsonObject();
     m_fieldWidgets.clear();
     m_customFields.clear();
@@ -835,16 +882,29 @@ void MetadataPanel::clearPendingChanges() {
 void MetadataPanel::onCommitChanges() {
     if (m_pendingChanges.isEmpty()) return;
     
-    // Save all pending changes
-    int count = m_pendingChanges.size();
+    // One ExifTool write per file, all through one daemon batch
+    QList<MetadataWriter::Transaction> transactions = m_pendingChanges.values();
     m_pendingChanges.clear();
-    
-    // Trigger actual save
-    saveMetadata();
+    std::vector<bool> written = MetadataWriter::instance().commitBatch(transactions);
+    
+    int failed = 0;
+    for (int i = 0; i < transactions.size(); ++i) {
+        if (written[i]) {
+            emit metadataChanged(transactions[i].filePath());
+        } else {
+            failed++;
+        }
+    }
+    setEditable(false);
     
     updatePendingUI();
-    NotificationManager::instance().showSuccess(
-        QString("Committed %1 pending change(s)").arg(count));
+    if (failed == 0) {
+        NotificationManager::instance().showSuccess(
+            QString("Committed %1 pending change(s)").arg(transactions.size()));
+    } else {
+        NotificationManager::instance().showError(
+            QString("Failed to save %1 of %2 pending change(s)").arg(failed).arg(transactions.size()));
+    }
 }
 
 void MetadataPanel::onDiscardChanges() {
@@ -2,6 +2,7 @@
 
 #include "../core/PhotoMetadata.h"
 #include "../core/MetadataWriter.h"
+#include "../core/TaskScheduler.h"
 #include <QWidget>
 #include <QLabel>
 #include <QLineEdit>
@@ -14,6 +15,7 @@
 #include <QMap>
 #include <QScrollArea>
 #include <QJsonObject>
+#include <QFutureWatcher>
 
 namespace PhotoGuru {
 
@@ -25,6 +27,9 @@ public:
     void setContentLayout(QLayout* layout);
     bool isExpanded() const { return m_expanded; }
     
+signals:
+    void expandedChanged(bool expanded);
+    
 private slots:
     void toggleExpanded();
     
@@ -46,13 +51,19 @@ public:
     void setEditable(bool editable);
     bool isModified() const { return m_modified; }
     
+    // Shows another field in this row, so sections reuse rows across images
+    void reset(const QString& key, const QString& value, bool editable);
+    
 signals:
     void valueChanged(const QString& key, const QString& value);
     void removeRequested(const QString& key);
     
 private:
+    void setMultiline(bool multiline);  // Creates the editor on first use
+    
     QString m_key;
     QString m_originalValue;
+    QLabel* m_keyLabel;
     QLineEdit* m_valueEdit;
     QTextEdit* m_textEdit;
     QPushButton* m_removeButton;
@@ -83,18 +94,18 @@ private:
     void setupMetadataTab();
     void displayMetadata(const PhotoMetadata& metadata);
     void displayAllMetadata(const QJsonObject& allMetadata);
-    void populateMetadataSection(CollapsibleGroupBox* section, 
-                                 const QStringList& keys, 
-                                 const QJsonObject& metadata,
-                                 bool editable);
+    struct TagSection;
+    void populateMetadataSection(TagSection& section);
     QString formatExifInfo(const PhotoMetadata& meta);
     QString formatTechnicalInfo(const TechnicalMetadata& tech);
+    MetadataWriter::Transaction editedTransaction();  // Reads the editors into m_currentMetadata
     void saveMetadata();
     void cancelEdit();
     void updateRatingDisplay(int rating);
     void addNewField();
     void removeField(const QString& key);
-    QJsonObject readAllMetadata(const QString& filepath);
+    static QJsonObject readAllMetadata(const QString& filepath);  // Any thread
+    void requestAllMetadata();  // Once per image, and only while a tag section is open
     
     // Metadata content widgets
     QScrollArea* m_metadataScrollArea;
@@ -119,6 +130,19 @@ private:
     CollapsibleGroupBox* m_technicalSection;
     CollapsibleGroupBox* m_customSection;
     
+    // The EXIF, IPTC, XMP and File sections hold hundreds of tags. Their
+    // rows are kept and refilled on the next image, and a section is only
+    // filled while it is open.
+    struct TagSection {
+        CollapsibleGroupBox* box = nullptr;
+        QVBoxLayout* layout = nullptr;
+        QLabel* emptyLabel = nullptr;
+        QList<MetadataFieldWidget*> rows;  // Past the shown ones: hidden, kept for reuse
+        QStringList keys;                  // Of m_allMetadata, sorted
+        bool populated = false;
+    };
+    QList<TagSection> m_tagSections;
+    
     // Control buttons
     QPushButton* m_saveButton;
     QPushButton* m_cancelButton;
@@ -129,12 +153,15 @@ private:
     QString m_currentFilepath;
     PhotoMetadata m_currentMetadata;
     QJsonObject m_allMetadata;
+    QFutureWatcher<QJsonObject>* m_allMetadataWatcher = nullptr;
+    QString m_allMetadataPath;  // File m_allMetadataWatcher reads
+    TaskGroup m_tasks{TaskScheduler::Interactive};
     QMap<QString, MetadataFieldWidget*> m_fieldWidgets;
     QMap<QString, QString> m_customFields;  // New custom fields added by user
     bool m_isEditing;
     
     // Pending changes system
-    QMap<QString, QString> m_pendingChanges;  // filepath -> changed fields (for display)
+    QMap<QString, MetadataWriter::Transaction> m_pendingChanges;  // filepath -> uncommitted edits
     bool m_autoSaveMode;  // true = save immediately, false = accumulate pending
     QPushButton* m_commitButton;
     QPushButton* m_discardButton;
@@ -0,0 +1,310 @@
+#include "PerformancePanel.h"
+#include "core/MemoryBudget.h"
+#include "core/ResourceGovernor.h"
+#include "core/TaskScheduler.h"
+#include "core/Trace.h"
+#include "ml/ModelRegistry.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QSignalBlocker>
+#include <QJsonObject>
+#include <QMessageBox>
+#include <QThreadPool>
+#include <QVBoxLayout>
+
+#if defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#elif defined(Q_OS_LINUX)
+#include <QFile>
+#include <unistd.h>
+#endif
+
+namespace PhotoGuru {
+
+namespace {
+
+enum Column { NameColumn, RateColumn, ValueColumn, DetailColumn };
+
+QString formatMs(double ms) {
+    return ms < 1.0 ? QString("%1 µs").arg(ms * 1000.0, 0, 'f', 0)
+                    : QString("%1 ms").arg(ms, 0, 'f', ms < 10.0 ? 2 : 1);
+}
+
+} // namespace
+
+PerformancePanel::PerformancePanel(QWidget* parent)
+    : QWidget(parent)
+{
+    // What still runs on Qt's shared pool (folder listings, model loads)
+    Trace::watchThreadPool("global", QThreadPool::globalInstance());
+
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setInterval(REFRESH_INTERVAL_MS);
+    connect(m_refreshTimer, &QTimer::timeout, this, &PerformancePanel::refresh);
+
+    setupUI();
+}
+
+void PerformancePanel::setupUI() {
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(8, 8, 8, 8);
+    layout->setSpacing(6);
+
+    QHBoxLayout* controls = new QHBoxLayout();
+    m_recordCheckbox = new QCheckBox("Record", this);
+    m_recordCheckbox->setToolTip("Collect stage timings and cache counters (small overhead)");
+    m_recordCheckbox->setChecked(Trace::enabled());
+    connect(m_recordCheckbox, &QCheckBox::toggled, this, &PerformancePanel::onRecordToggled);
+    controls->addWidget(m_recordCheckbox);
+    controls->addStretch();
+
+    m_resetButton = new QPushButton("Reset", this);
+    m_resetButton->setToolTip("Zero all counters and drop recorded events");
+    connect(m_resetButton, &QPushButton::clicked, this, &PerformancePanel::onReset);
+    controls->addWidget(m_resetButton);
+
+    m_saveButton = new QPushButton("Save Trace...", this);
+    m_saveButton->setToolTip("Write a Chrome trace (chrome://tracing, ui.perfetto.dev) for a bug report");
+    connect(m_saveButton, &QPushButton::clicked, this, &PerformancePanel::onSaveTrace);
+    controls->addWidget(m_saveButton);
+    layout->addLayout(controls);
+
+    m_hintLabel = new QLabel("Recording is off: stage timings and cache hit rates stay empty.", this);
+    m_hintLabel->setWordWrap(true);
+    m_hintLabel->setStyleSheet("color: #888;");
+    m_hintLabel->setVisible(!Trace::enabled());
+    layout->addWidget(m_hintLabel);
+
+    m_tree = new QTreeWidget(this);
+    m_tree->setColumnCount(4);
+    m_tree->setHeaderLabels({"Metric", "Rate", "p50 / Now", "p99 / Peak"});
+    m_tree->setRootIsDecorated(true);
+    m_tree->setUniformRowHeights(true);
+    m_tree->header()->setSectionResizeMode(NameColumn, QHeaderView::Stretch);
+    for (int column = RateColumn; column <= DetailColumn; column++) {
+        m_tree->header()->setSectionResizeMode(column, QHeaderView::ResizeToContents);
+    }
+
+    auto group = [this](const QString& title) {
+        QTreeWidgetItem* item = new QTreeWidgetItem(m_tree, {title});
+        QFont font = item->font(NameColumn);
+        font.setBold(true);
+        item->setFont(NameColumn, font);
+        item->setFirstColumnSpanned(true);
+        item->setExpanded(true);
+        return item;
+    };
+    m_stagesGroup = group("Stages");
+    m_queuesGroup = group("Queues");
+    m_cachesGroup = group("Caches");
+    m_poolsGroup = group("Thread pools");
+    m_memoryGroup = group("Memory");
+    layout->addWidget(m_tree);
+}
+
+void PerformancePanel::showEvent(QShowEvent* event) {
+    QWidget::showEvent(event);
+    refresh();
+    m_refreshTimer->start();
+}
+
+void PerformancePanel::hideEvent(QHideEvent* event) {
+    QWidget::hideEvent(event);
+    m_refreshTimer->stop();
+}
+
+void PerformancePanel::refresh() {
+    const QJsonObject metrics = Trace::metrics();
+    const double seconds = m_sinceRefresh.isValid() ? m_sinceRefresh.restart() / 1000.0 : 0.0;
+    if (!m_sinceRefresh.isValid()) m_sinceRefresh.start();
+
+    QSet<QString> stages, queues, caches, pools;
+    for (auto it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+        const QString name = it.key();
+
+        if (name.endsWith(".hit_ratio")) {
+            const QString prefix = name.chopped(10);
+            const qint64 hits = qint64(metrics[prefix + ".hit"].toObject()["value"].toDouble());
+            const qint64 misses = qint64(metrics[prefix + ".miss"].toObject()["value"].toDouble());
+            setRow(m_cachesGroup, prefix, QString(),
+                   QString("%1%").arg(it.value().toDouble() * 100.0, 0, 'f', 1),
+                   QString("%1 / %2").arg(hits).arg(hits + misses));
+            caches << prefix;
+            continue;
+        }
+
+        const QJsonObject metric = it.value().toObject();
+        const QString kind = metric["kind"].toString();
+        if (kind == "timer") {
+            const qint64 count = qint64(metric["count"].toDouble());
+            if (count == 0) continue;
+            const qint64 previous = m_lastCounts.value(name, count);
+            m_lastCounts[name] = count;
+            const QString rate = seconds > 0.0
+                ? QString("%1/s").arg((count - previous) / seconds, 0, 'f', 1) : QString();
+            setRow(m_stagesGroup, name, rate, formatMs(metric["p50_ms"].toDouble()),
+                   formatMs(metric["p99_ms"].toDouble()));
+            row(m_stagesGroup, name)->setToolTip(NameColumn,
+                QString("%1 calls, %2 total, max %3").arg(count)
+                    .arg(formatMs(metric["total_ms"].toDouble()))
+                    .arg(formatMs(metric["max_ms"].toDouble())));
+            stages << name;
+        } else if (kind == "gauge") {
+            setRow(m_queuesGroup, name, QString(), QString::number(qint64(metric["value"].toDouble())),
+                   QString::number(qint64(metric["max"].toDouble())));
+            queues << name;
+        } else if (kind == "pool") {
+            const int active = metric["active"].toInt();
+            const int max = metric["max"].toInt();
+            setRow(m_poolsGroup, name.mid(5), QString(),
+                   QString("%1 / %2").arg(active).arg(max),
+                   max > 0 ? QString("%1%").arg(100 * active / max) : QString());
+            pools << name.mid(5);
+        }
+    }
+    // The scheduler's workers, then how many each class holds of its limit
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    const int workers = scheduler.workerCount();
+    setRow(m_poolsGroup, "scheduler", QString(),
+           QString("%1 / %2").arg(scheduler.activeCount()).arg(workers),
+           QString("%1 queued").arg(scheduler.queuedCount()));
+    pools << "scheduler";
+    static const char* const classNames[TaskScheduler::PRIORITY_COUNT] = {
+        "interactive", "prefetch", "ingest", "ai"};
+    for (int i = 0; i < TaskScheduler::PRIORITY_COUNT; i++) {
+        const auto priority = TaskScheduler::Priority(i);
+        const QString name = QString("scheduler.") + classNames[i];
+        setRow(m_poolsGroup, name, QString(),
+               QString("%1 / %2").arg(scheduler.activeCount(priority)).arg(scheduler.classLimit(priority)),
+               QString());
+        pools << name;
+    }
+    const ResourceGovernor& governor = ResourceGovernor::instance();
+    const ResourceGovernor::Budget budget = governor.budget();
+    setRow(m_poolsGroup, "governor", QString(), ResourceGovernor::modeName(governor.mode()),
+           budget.aiPaused ? QString("AI paused")
+                           : QString("batch x%1").arg(budget.batchScale, 0, 'f', 2));
+    pools << "governor";
+
+    removeStaleRows(m_stagesGroup, stages);
+    removeStaleRows(m_queuesGroup, queues);
+    removeStaleRows(m_cachesGroup, caches);
+    removeStaleRows(m_poolsGroup, pools);
+
+    QSet<QString> memory{"Process"};
+    setRow(m_memoryGroup, "Process", QString(), formatBytes(residentBytes()), QString());
+    // The caches against their share of the budget, and the pressure shrinking it
+    const MemoryBudget& memoryBudget = MemoryBudget::instance();
+    qint64 cached = 0;
+    for (const MemoryBudget::CacheUsage& cache : memoryBudget.usage()) {
+        setRow(m_memoryGroup, cache.name, QString(), formatBytes(cache.bytes), "of " + formatBytes(cache.limit));
+        memory << cache.name;
+        cached += cache.bytes;
+    }
+    setRow(m_memoryGroup, "Caches", QString(), formatBytes(cached),
+           QString("of %1, pressure %2").arg(formatBytes(memoryBudget.total()),
+                                             MemoryBudget::pressureName(memoryBudget.pressure())));
+    memory << "Caches";
+    ModelRegistry& registry = ModelRegistry::instance();
+    for (const QString& model : registry.loadedModels()) {
+        const ModelRegistry::Footprint footprint = registry.footprint(model);
+        setRow(m_memoryGroup, model, QString(), formatBytes(footprint.ramBytes),
+               footprint.vramBytes > 0 ? formatBytes(footprint.vramBytes) + " VRAM" : QString());
+        memory << model;
+    }
+    removeStaleRows(m_memoryGroup, memory);
+
+    // PHOTOGURU_TRACE or another caller may have switched it
+    if (m_recordCheckbox->isChecked() != Trace::enabled()) {
+        QSignalBlocker blocker(m_recordCheckbox);
+        m_recordCheckbox->setChecked(Trace::enabled());
+    }
+    m_hintLabel->setVisible(!Trace::enabled());
+}
+
+void PerformancePanel::onRecordToggled(bool enabled) {
+    Trace::setEnabled(enabled);
+    m_hintLabel->setVisible(!enabled);
+}
+
+void PerformancePanel::onReset() {
+    Trace::clear();
+    m_lastCounts.clear();
+    m_sinceRefresh.invalidate();
+    refresh();
+}
+
+void PerformancePanel::onSaveTrace() {
+    const QString suggested = QDir::home().filePath(
+        QString("photoguru-trace-%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss")));
+    const QString path = QFileDialog::getSaveFileName(this, "Save Trace", suggested,
+                                                      "Chrome trace (*.json)");
+    if (path.isEmpty()) return;
+    if (!Trace::writeChromeTrace(path)) {
+        QMessageBox::warning(this, "Save Trace", "Could not write " + path);
+    }
+}
+
+QTreeWidgetItem* PerformancePanel::row(QTreeWidgetItem* group, const QString& name) {
+    for (int i = 0; i < group->childCount(); i++) {
+        if (group->child(i)->text(NameColumn) == name) return group->child(i);
+    }
+    // Kept sorted by name so rows don't jump between refreshes
+    int position = 0;
+    while (position < group->childCount() && group->child(position)->text(NameColumn) < name) {
+        position++;
+    }
+    QTreeWidgetItem* item = new QTreeWidgetItem({name});
+    for (int column = RateColumn; column <= DetailColumn; column++) {
+        item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+    }
+    group->insertChild(position, item);
+    return item;
+}
+
+void PerformancePanel::setRow(QTreeWidgetItem* group, const QString& name, const QString& rate,
+                              const QString& value, const QString& detail) {
+    QTreeWidgetItem* item = row(group, name);
+    item->setText(RateColumn, rate);
+    item->setText(ValueColumn, value);
+    item->setText(DetailColumn, detail);
+}
+
+void PerformancePanel::removeStaleRows(QTreeWidgetItem* group, const QSet<QString>& live) {
+    for (int i = group->childCount() - 1; i >= 0; i--) {
+        if (!live.contains(group->child(i)->text(NameColumn))) {
+            delete group->takeChild(i);
+        }
+    }
+}
+
+QString PerformancePanel::formatBytes(qint64 bytes) {
+    if (bytes <= 0) return "-";
+    if (bytes < 1024 * 1024) return QString("%1 KB").arg(bytes / 1024);
+    if (bytes < 1024LL * 1024 * 1024) return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 0);
+    return QString("%1 GB").arg(bytes / (1024.0 * 1024.0 * 1024.0), 0, 'f', 2);
+}
+
+qint64 PerformancePanel::residentBytes() {
+#if defined(Q_OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return qint64(info.resident_size);
+#elif defined(Q_OS_LINUX)
+    // statm: total and resident size, in pages
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) return 0;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields[1].toLongLong() * sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
+
+} // namespace PhotoGuru
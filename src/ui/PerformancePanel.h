@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QWidget>
+#include <QCheckBox>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QLabel>
+#include <QPushButton>
+#include <QSet>
+#include <QTimer>
+#include <QTreeWidget>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Live view of the Trace metrics (dock next to Metadata/AI Analysis)
+ *
+ * Refreshes once a second while visible:
+ *   Stages       - every TRACE_SCOPE timer: calls/s since the last
+ *                  refresh, p50 and p99 (ExifTool round trip, decode,
+ *                  inference, analysis stages...)
+ *   Queues       - TRACE_GAUGE depths, current and high-water mark
+ *   Caches       - hit rate of each .hit/.miss counter pair
+ *   Thread pools - TaskScheduler workers busy, each class against its
+ *                  limit, the ResourceGovernor's mode, and the pools
+ *                  Trace watches
+ *   Memory       - process resident set and each loaded model's footprint
+ *
+ * Timers and counters only move while tracing is enabled; "Record"
+ * turns it on without restarting under PHOTOGURU_TRACE. "Save Trace..."
+ * writes the Chrome trace for attaching to a bug report.
+ */
+class PerformancePanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit PerformancePanel(QWidget* parent = nullptr);
+
+    // Process resident set size now; 0 where the platform doesn't say
+    static qint64 residentBytes();
+
+    static constexpr int REFRESH_INTERVAL_MS = 1000;
+
+public slots:
+    void refresh();
+
+protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
+private:
+    void setupUI();
+    void onRecordToggled(bool enabled);
+    void onReset();
+    void onSaveTrace();
+
+    // Row `name` under `group`, created on first use
+    QTreeWidgetItem* row(QTreeWidgetItem* group, const QString& name);
+    void setRow(QTreeWidgetItem* group, const QString& name, const QString& rate,
+                const QString& value, const QString& detail);
+    void removeStaleRows(QTreeWidgetItem* group, const QSet<QString>& live);
+    static QString formatBytes(qint64 bytes);
+
+    QCheckBox* m_recordCheckbox;
+    QPushButton* m_resetButton;
+    QPushButton* m_saveButton;
+    QLabel* m_hintLabel;
+    QTreeWidget* m_tree;
+
+    QTreeWidgetItem* m_stagesGroup;
+    QTreeWidgetItem* m_queuesGroup;
+    QTreeWidgetItem* m_cachesGroup;
+    QTreeWidgetItem* m_poolsGroup;
+    QTreeWidgetItem* m_memoryGroup;
+
+    QTimer* m_refreshTimer;
+    QElapsedTimer m_sinceRefresh;
+    QHash<QString, qint64> m_lastCounts;  // Timer counts at the previous refresh
+};
+
+} // namespace PhotoGuru
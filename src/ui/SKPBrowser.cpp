@@ -68,6 +68,7 @@ void SKPBrowser::loadImageKeys(const QString& filepath) {
     m_currentFilepath = filepath;
     clear();
     
+    // Blocks on ExifTool; selection goes through the cached overload
     auto metaOpt = MetadataReader::instance().read(filepath);
     if (!metaOpt) {
         m_infoLabel->setText("No semantic keys found");
@@ -77,6 +78,12 @@ void SKPBrowser::loadImageKeys(const QString& filepath) {
     displayKeys(*metaOpt);
 }
 
+void SKPBrowser::loadImageKeys(const QString& filepath, const PhotoMetadata& metadata) {
+    m_currentFilepath = filepath;
+    clear();
+    displayKeys(metadata);
+}
+
 void SKPBrowser::displayKeys(const PhotoMetadata& metadata) {
     m_keyTree->clear();
     
@@ -15,6 +15,7 @@ public:
     explicit SKPBrowser(QWidget* parent = nullptr);
     
     void loadImageKeys(const QString& filepath);
+    void loadImageKeys(const QString& filepath, const PhotoMetadata& metadata);  // From cache
     void clear();
     
 signals:
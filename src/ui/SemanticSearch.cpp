@@ -2,6 +2,7 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QListWidgetItem>
+#include <QMap>
 #include <algorithm>
 
 namespace PhotoGuru {
@@ -87,8 +88,16 @@ void SemanticSearch::setupUI() {
     });
 }
 
-void SemanticSearch::setPhotos(const QList<PhotoMetadata>& photos) {
+void SemanticSearch::setPhotos(const QList<PhotoHandle>& photos) {
     m_photos = photos;
+    
+    m_textIndex.clear();
+    m_rowByPath.clear();
+    for (int row = 0; row < m_photos.size(); ++row) {
+        m_textIndex.setDocument(row, TextIndex::documentFields(*m_photos[row]));
+        m_rowByPath.insert(m_photos[row]->filepath, row);
+    }
+    
     m_statusLabel->setText(QString("Ready to search %1 photos").arg(photos.size()));
 }
 
@@ -109,73 +118,98 @@ void SemanticSearch::performSearch(const QString& query) {
     m_statusLabel->setText("Searching...");
     m_resultsList->clear();
     
-    // Use CLIP embeddings for semantic search
-    QList<QPair<PhotoMetadata, double>> results;
+    // One CLIP text forward pass + index lookup; keywords when unavailable
+    QList<QPair<int, double>> results = embeddingResults(query);
+    if (results.isEmpty()) {
+        results = keywordResults(query);
+    }
     
-    // Implement actual semantic search using CLIP embeddings
-    // For production: use CLIPAnalyzer to get CLIP embeddings of query
-    // and compare with image embeddings using cosine similarity
-    QString queryLower = query.toLower();
+    // Take top 50 results
+    if (results.size() > MAX_RESULTS) {
+        results = results.mid(0, MAX_RESULTS);
+    }
     
-    for (const auto& photo : m_photos) {
-        double score = 0.0;
-        
-        // Semantic search strategy:
-        // 1. Match against LLM-generated title and description (high weight)
-        // 2. Match against keywords (medium weight)
-        // 3. Match against technical metadata (low weight)
-        
-        // Search in title (weight: 3.0)
-        if (!photo.llm_title.isEmpty() && 
-            photo.llm_title.toLower().contains(queryLower)) {
-            score += 0.5;
-        }
+    displayResults(results);
+    
+    m_searchButton->setEnabled(true);
+    m_statusLabel->setText(QString("Found %1 matching photos").arg(results.size()));
+    emit searchCompleted(results.size());
+}
+
+QList<QPair<int, double>> SemanticSearch::embeddingResults(const QString& query) const {
+    QList<QPair<int, double>> results;
+    if (!m_embeddingSearch || query.trimmed().isEmpty()) {
+        return results;
+    }
+    
+    // The store covers every analysed file; keep only photos in the current set
+    for (const auto& [path, score] : m_embeddingSearch(query, MAX_RESULTS * 4)) {
+        auto row = m_rowByPath.constFind(path);
+        if (row == m_rowByPath.constEnd()) continue;
+        results.append(qMakePair(row.value(), double(score)));
+        if (results.size() == MAX_RESULTS) break;
+    }
+    return results;
+}
+
+QList<QPair<int, double>> SemanticSearch::keywordResults(const QString& query) const {
+    QList<QPair<int, double>> results;
+    
+    QString queryLower = query.toLower();
+    QStringList parts = queryLower.split(' ', Qt::SkipEmptyParts);
+    
+    // Semantic search strategy:
+    // 1. Match against LLM-generated title and description (high weight)
+    // 2. Match against keywords (medium weight)
+    // 3. Match against technical metadata (low weight)
+    // Candidate fields come from the text index; a multi-word query must
+    // still appear as a whole phrase in the field.
+    QMap<int, int> matchedGroups;  // row -> bitmask of weighted groups, in library order
+    enum { TitleHit = 1, DescriptionHit = 2, KeywordHit = 4, ContextHit = 8 };
+    
+    for (quint64 key : m_textIndex.findAll(parts)) {
+        int row = TextIndex::rowOf(key);
+        int slot = TextIndex::slotOf(key);
         
-        // Search in description
-        if (!photo.llm_description.isEmpty() && 
-            photo.llm_description.toLower().contains(queryLower)) {
-            score += 0.3;
-        }
+        int group = 0;
+        if (slot == TextIndex::TitleSlot) group = TitleHit;
+        else if (slot == TextIndex::DescriptionSlot) group = DescriptionHit;
+        else if (slot >= TextIndex::FirstKeywordSlot) group = KeywordHit;
+        else if (slot == TextIndex::CategorySlot || slot == TextIndex::SceneSlot ||
+                 slot == TextIndex::MoodSlot) group = ContextHit;
+        if (group == 0 || (matchedGroups.value(row) & group)) continue;
         
-        // Search in keywords
-        for (const QString& keyword : photo.llm_keywords) {
-            if (keyword.toLower().contains(queryLower)) {
-                score += 0.2;
-                break;
-            }
+        if (queryLower.contains(' ')) {
+            QString field = TextIndex::documentFields(*m_photos[row]).value(slot);
+            if (!field.toLower().contains(queryLower)) continue;
         }
+        matchedGroups[row] |= group;
+    }
+    
+    for (auto it = matchedGroups.cbegin(); it != matchedGroups.cend(); ++it) {
+        int groups = it.value();
         
-        // Search in category/scene/mood
-        if (photo.llm_category.toLower().contains(queryLower) ||
-            photo.llm_scene.toLower().contains(queryLower) ||
-            photo.llm_mood.toLower().contains(queryLower)) {
-            score += 0.2;
-        }
+        double score = 0.0;
+        if (groups & TitleHit) score += 0.5;
+        if (groups & DescriptionHit) score += 0.3;
+        if (groups & KeywordHit) score += 0.2;
+        if (groups & ContextHit) score += 0.2;
         
         if (score > 0.0) {
-            results.append(qMakePair(photo, score));
+            results.append(qMakePair(it.key(), score));
         }
     }
     
     // Sort by score (descending)
     std::sort(results.begin(), results.end(), 
-              [](const QPair<PhotoMetadata, double>& a, const QPair<PhotoMetadata, double>& b) {
+              [](const QPair<int, double>& a, const QPair<int, double>& b) {
         return a.second > b.second;
     });
     
-    // Take top 50 results
-    if (results.size() > 50) {
-        results = results.mid(0, 50);
-    }
-    
-    displayResults(results);
-    
-    m_searchButton->setEnabled(true);
-    m_statusLabel->setText(QString("Found %1 matching photos").arg(results.size()));
-    emit searchCompleted(results.size());
+    return results;
 }
 
-void SemanticSearch::displayResults(const QList<QPair<PhotoMetadata, double>>& results) {
+void SemanticSearch::displayResults(const QList<QPair<int, double>>& results) {
     m_resultsList->clear();
     
     if (results.isEmpty()) {
@@ -186,7 +220,7 @@ void SemanticSearch::displayResults(const QList<QPair<PhotoMetadata, double>>& r
     }
     
     for (const auto& result : results) {
-        const PhotoMetadata& photo = result.first;
+        const PhotoMetadata& photo = *m_photos[result.first];
         double score = result.second;
         
         QString title = photo.llm_title.isEmpty() ? photo.filename : photo.llm_title;
@@ -5,7 +5,11 @@
 #include <QPushButton>
 #include <QListWidget>
 #include <QLabel>
+#include <QHash>
+#include <functional>
+#include <vector>
 #include "core/PhotoMetadata.h"
+#include "core/TextIndex.h"
 
 namespace PhotoGuru {
 
@@ -13,9 +17,19 @@ class SemanticSearch : public QWidget {
     Q_OBJECT
     
 public:
+    // Query text -> best k (filepath, similarity) from the image embeddings
+    using EmbeddingSearch = std::function<std::vector<QPair<QString, float>>(const QString& query, int k)>;
+    
     explicit SemanticSearch(QWidget* parent = nullptr);
     
-    void setPhotos(const QList<PhotoMetadata>& photos);
+    void setPhotos(const QList<PhotoHandle>& photos);
+    void setPhotos(const QList<PhotoMetadata>& photos) { setPhotos(makePhotoHandles(photos)); }
+    
+    // Rank by CLIP text/image similarity; the keyword scan stays as fallback
+    // when the search is unset or returns nothing
+    void setEmbeddingSearch(EmbeddingSearch search) { m_embeddingSearch = std::move(search); }
+    
+    static constexpr int MAX_RESULTS = 50;
     void performSearch(const QString& query);
     
 signals:
@@ -26,13 +40,19 @@ signals:
 private:
     void setupUI();
     void onSearchClicked();
-    void displayResults(const QList<QPair<PhotoMetadata, double>>& results);
+    // Results are (row in m_photos, score)
+    void displayResults(const QList<QPair<int, double>>& results);
+    QList<QPair<int, double>> embeddingResults(const QString& query) const;
+    QList<QPair<int, double>> keywordResults(const QString& query) const;
     
     QLineEdit* m_searchInput;
     QPushButton* m_searchButton;
     QListWidget* m_resultsList;
     QLabel* m_statusLabel;
-    QList<PhotoMetadata> m_photos;
+    QList<PhotoHandle> m_photos;
+    TextIndex m_textIndex;
+    QHash<QString, int> m_rowByPath;
+    EmbeddingSearch m_embeddingSearch;
 };
 
 } // namespace PhotoGuru
@@ -1,327 +1,223 @@
 #include "ThumbnailGrid.h"
-#include "ImageLoader.h"
-#include <QListWidgetItem>
-#include <QFileInfo>
-#include <QtConcurrent>
-#include <QApplication>
-#include <QPainter>
-#include <QDateTime>
-#include <QThreadPool>
-#include <QPointer>
+#include "ThumbnailModel.h"
+#include "ThumbnailScheduler.h"
+#include "ThumbnailCache.h"
+#include <QItemSelectionModel>
+#include <QScrollBar>
+#include <algorithm>
 
 namespace PhotoGuru {
 
 ThumbnailGrid::ThumbnailGrid(QWidget* parent)
-    : QListWidget(parent)
+    : QListView(parent)
+    , m_model(new ThumbnailModel(this))
+    , m_delegate(new ThumbnailDelegate(this))
+    , m_scheduler(new ThumbnailScheduler(m_model))
+    , m_rangeTimer(new QTimer(this))
 {
-    setViewMode(QListView::IconMode);
-    setIconSize(QSize(m_thumbnailSize, m_thumbnailSize));
+    // ListMode + wrapping + uniform sizes keeps layout O(1) per row with no
+    // per-item objects, so 100k+ rows stay cheap
+    setViewMode(QListView::ListMode);
+    setFlow(QListView::LeftToRight);
+    setWrapping(true);
     setResizeMode(QListView::Adjust);
     setMovement(QListView::Static);
-    setSpacing(10);
     setUniformItemSizes(true);
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
     setMinimumHeight(80);
     
+    setModel(m_model);
+    setItemDelegate(m_delegate);
+    applyThumbnailSize();
+    
     // Enable multi-selection
     setSelectionMode(QAbstractItemView::ExtendedSelection);
     
-    // PERFORMANCE: Larger memory cache
-    m_thumbnailCache.setMaxCost(1000);  // Cache up to 1000 thumbnails
+    // Only the visible range (+ prefetch) is ever requested
+    m_rangeTimer->setSingleShot(true);
+    m_rangeTimer->setInterval(RANGE_UPDATE_DELAY_MS);
+    connect(m_rangeTimer, &QTimer::timeout, this, &ThumbnailGrid::updateVisibleRange);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &ThumbnailGrid::scheduleRangeUpdate);
     
-    // PERFORMANCE: Dedicated thread pool for thumbnails
-    m_threadPool = new QThreadPool(this);
-    m_threadPool->setMaxThreadCount(4);  // 4 parallel thumbnail loads
-    
-    // PERFORMANCE: Setup disk cache directory
-    QString cacheDir = QDir::homePath() + "/.photoguru/thumbnails";
-    m_diskCacheDir = QDir(cacheDir);
-    if (!m_diskCacheDir.exists()) {
-        m_diskCacheDir.mkpath(".");
-    }
+    // Thumbnails come from the shared two-tier cache (memory + disk)
+    connect(&ThumbnailCache::instance(), &ThumbnailCache::thumbnailReady,
+            this, &ThumbnailGrid::onThumbnailReady);
     
-    connect(this, &QListWidget::itemClicked, this, &ThumbnailGrid::onItemClicked);
-    connect(this, &QListWidget::itemSelectionChanged, this, &ThumbnailGrid::onSelectionChanged);
+    connect(this, &QListView::clicked, this, &ThumbnailGrid::onItemClicked);
+    connect(selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &ThumbnailGrid::onSelectionChanged);
 }
 
 ThumbnailGrid::~ThumbnailGrid() {
-    // Cancel pending tasks and wait with timeout
-    if (m_threadPool) {
-        m_threadPool->clear();  // Cancel pending tasks
-    }
+    delete m_scheduler;  // Cancels whatever is still queued
+}
+
+void ThumbnailGrid::setImages(const QStringList& imagePaths) {
+    // Queued rows refer to the old list
+    m_scheduler->cancelAll();
     
-    // Wait for active tasks with timeout (max 2 seconds)
-    int timeout = 200;  // 2 seconds total (200 * 10ms)
-    while (m_loadingTasks.loadAcquire() > 0 && timeout-- > 0) {
-        QApplication::processEvents();
-        QThread::msleep(10);
-    }
+    QStringList paths = imagePaths;
+    sortImages(paths);
+    m_model->setPaths(paths);
     
-    if (m_loadingTasks.loadAcquire() > 0) {
-        qWarning() << "ThumbnailGrid destroyed with" << m_loadingTasks.loadAcquire() << "tasks still running";
-    }
+    scheduleRangeUpdate();
+}
+
+void ThumbnailGrid::updateImages(const QStringList& imagePaths) {
+    // Pending requests are keyed by row, and rows are about to shift
+    m_scheduler->cancelAll();
     
-    m_thumbnailCache.clear();
+    QStringList paths = imagePaths;
+    sortImages(paths);
+    m_model->updatePaths(paths);
+    
+    scheduleRangeUpdate();
 }
 
-void ThumbnailGrid::setImages(const QStringList& imagePaths) {
-    clear();
-    m_imagePaths = imagePaths;
-    sortImages();
-    loadThumbnails();
+void ThumbnailGrid::appendImages(const QStringList& imagePaths) {
+    // Rows don't shift, so pending requests stay valid
+    m_model->appendPaths(imagePaths);
+    scheduleRangeUpdate();
+}
+
+void ThumbnailGrid::refreshThumbnails(const QStringList& imagePaths) {
+    ThumbnailCache::instance().invalidate(imagePaths);
+    for (const QString& path : imagePaths) {
+        int row = m_model->rowForPath(path);
+        if (row >= 0) m_model->thumbnailUpdated(row);  // Placeholder until the new one lands
+    }
+    scheduleRangeUpdate();
 }
 
 void ThumbnailGrid::setThumbnailSize(int size) {
+    if (m_thumbnailSize == size) return;
+    
     m_thumbnailSize = size;
-    setIconSize(QSize(size, size));
+    applyThumbnailSize();
     
-    // Clear cache and reload
-    m_thumbnailCache.clear();
-    loadThumbnails();
+    scheduleRangeUpdate();
 }
 
 void ThumbnailGrid::setSortOrder(SortOrder order) {
     if (m_sortOrder == order) return;
     
     m_sortOrder = order;
-    sortImages();
-    
-    // Clear and reload
-    clear();
-    loadThumbnails();
+    setImages(m_model->paths());
 }
 
-void ThumbnailGrid::sortImages() {
-    switch (m_sortOrder) {
-        case SortOrder::ByName:
-            std::sort(m_imagePaths.begin(), m_imagePaths.end(), 
-                [](const QString& a, const QString& b) {
-                    return QFileInfo(a).fileName() < QFileInfo(b).fileName();
-                });
-            break;
-        case SortOrder::ByDate:
-            std::sort(m_imagePaths.begin(), m_imagePaths.end(),
-                [](const QString& a, const QString& b) {
-                    return QFileInfo(a).lastModified() > QFileInfo(b).lastModified();
-                });
-            break;
-        case SortOrder::BySize:
-            std::sort(m_imagePaths.begin(), m_imagePaths.end(),
-                [](const QString& a, const QString& b) {
-                    return QFileInfo(a).size() > QFileInfo(b).size();
-                });
-            break;
-    }
+int ThumbnailGrid::scrollPosition() const {
+    return verticalScrollBar()->value();
+}
+
+void ThumbnailGrid::setScrollPosition(int position) {
+    executeDelayedItemsLayout();  // The scroll range is only known once rows are laid out
+    verticalScrollBar()->setValue(position);
+}
+
+int ThumbnailGrid::count() const {
+    return m_model->rowCount();
+}
+
+int ThumbnailGrid::pendingRequestCount() const {
+    return m_scheduler->pendingCount();
+}
+
+void ThumbnailGrid::sortImages(QStringList& paths) {
+    m_sortKeys.sort(paths, m_sortOrder);
 }
 
 QStringList ThumbnailGrid::selectedFiles() const {
     QStringList files;
-    for (QListWidgetItem* item : selectedItems()) {
-        files << item->data(Qt::UserRole).toString();
+    const QModelIndexList selected = selectionModel()->selectedIndexes();
+    for (const QModelIndex& index : selected) {
+        files << index.data(ThumbnailModel::FilePathRole).toString();
     }
     return files;
 }
 
 void ThumbnailGrid::selectImage(int index) {
     if (index >= 0 && index < count()) {
-        setCurrentRow(index);
+        selectionModel()->setCurrentIndex(m_model->index(index),
+                                          QItemSelectionModel::ClearAndSelect);
     }
 }
 
 void ThumbnailGrid::setCurrentIndex(int index) {
-    // Clear previous current item special styling
-    if (m_currentIndex >= 0 && m_currentIndex < count()) {
-        QListWidgetItem* prevItem = item(m_currentIndex);
-        if (prevItem) {
-            prevItem->setData(Qt::UserRole + 2, false);  // Mark as not current
-        }
-    }
-    
-    m_currentIndex = index;
+    // Current item gets a subtle highlight from the delegate
+    m_model->setCurrentRow(index);
     
-    // Set new current item with special styling
-    if (m_currentIndex >= 0 && m_currentIndex < count()) {
-        QListWidgetItem* currentItem = item(m_currentIndex);
-        if (currentItem) {
-            currentItem->setData(Qt::UserRole + 2, true);  // Mark as current
-            
-            // Add subtle background highlight for current item
-            QColor highlightColor(31, 145, 255, 30);  // Adobe blue with low opacity
-            currentItem->setBackground(QBrush(highlightColor));
-            
-            // Ensure visible
-            scrollToItem(currentItem, QAbstractItemView::EnsureVisible);
-        }
+    if (index >= 0 && index < count()) {
+        scrollTo(m_model->index(index), QAbstractItemView::EnsureVisible);
     }
 }
 
-void ThumbnailGrid::loadThumbnails() {
-    // Add placeholder items first
-    for (const QString& path : m_imagePaths) {
-        QListWidgetItem* item = new QListWidgetItem(this);
-        item->setData(Qt::UserRole, path);
-        item->setText(QFileInfo(path).fileName());
-        
-        QString cacheKey = getCacheKey(path, m_thumbnailSize);
-        
-        // Check memory cache first
-        if (QPixmap* cached = m_thumbnailCache.object(cacheKey)) {
-            item->setIcon(QIcon(*cached));
-            continue;
-        }
-        
-        // Check disk cache
-        QPixmap diskCached = loadFromDiskCache(cacheKey);
-        if (!diskCached.isNull()) {
-            item->setIcon(QIcon(diskCached));
-            m_thumbnailCache.insert(cacheKey, new QPixmap(diskCached));
-            continue;
-        }
-        
-        // Placeholder icon for loading
-        QPixmap placeholder(m_thumbnailSize, m_thumbnailSize);
-        placeholder.fill(QColor(60, 60, 60));
-        item->setIcon(QIcon(placeholder));
-    }
-    
-    // PERFORMANCE: Load visible items first, then load rest
-    QList<int> visibleIndexes;
-    QList<int> hiddenIndexes;
-    
-    for (int i = 0; i < m_imagePaths.count(); ++i) {
-        QString cacheKey = getCacheKey(m_imagePaths[i], m_thumbnailSize);
-        if (m_thumbnailCache.contains(cacheKey)) continue;
-        
-        QListWidgetItem* item = this->item(i);
-        if (item && visualItemRect(item).intersects(viewport()->rect())) {
-            visibleIndexes.append(i);
-        } else {
-            hiddenIndexes.append(i);
-        }
-    }
-    
-    // Load visible items first with higher priority
-    for (int i : visibleIndexes) {
-        loadThumbnailAsync(i, QThread::HighPriority);
-    }
-    
-    // Load hidden items with normal priority
-    for (int i : hiddenIndexes) {
-        loadThumbnailAsync(i, QThread::NormalPriority);
-    }
+void ThumbnailGrid::resizeEvent(QResizeEvent* event) {
+    QListView::resizeEvent(event);
+    scheduleRangeUpdate();
 }
 
-void ThumbnailGrid::loadThumbnailAsync(int index, QThread::Priority priority) {
-    if (index < 0 || index >= m_imagePaths.count()) return;
-    
-    QString path = m_imagePaths[index];
-    QString cacheKey = getCacheKey(path, m_thumbnailSize);
-    
-    m_loadingTasks.fetchAndAddOrdered(1);
-    
-    QPointer<ThumbnailGrid> self(this);
-    int size = m_thumbnailSize;
-    
-    // PERFORMANCE: Use managed thread pool
-    QRunnable* task = QRunnable::create([self, path, index, cacheKey, size]() {
-        if (!self) return;
-        
-        QPixmap thumb = self->generateThumbnail(path);
-        
-        // Save to disk cache
-        self->saveToDiskCache(cacheKey, thumb);
-        
-        // Update UI in main thread
-        QMetaObject::invokeMethod(self, [self, path, index, thumb, cacheKey]() {
-            if (!self) return;
-            
-            self->m_thumbnailCache.insert(cacheKey, new QPixmap(thumb));
-            
-            if (index < self->count()) {
-                QListWidgetItem* item = self->item(index);
-                if (item && item->data(Qt::UserRole).toString() == path) {
-                    item->setIcon(QIcon(thumb));
-                }
-            }
-            
-            self->m_loadingTasks.fetchAndAddOrdered(-1);
-        }, Qt::QueuedConnection);
-    });
+void ThumbnailGrid::applyThumbnailSize() {
+    m_model->setThumbnailSize(m_thumbnailSize);
+    m_delegate->setThumbnailSize(m_thumbnailSize);
+    m_scheduler->setThumbnailSize(QSize(m_thumbnailSize, m_thumbnailSize));
+    setIconSize(QSize(m_thumbnailSize, m_thumbnailSize));
     
-    m_threadPool->start(task, priority);
+    // Fixed grid makes the visible range a pure function of the scroll offset
+    QStyleOptionViewItem option;
+    initViewItemOption(&option);
+    QSize cell = m_delegate->sizeHint(option, QModelIndex());
+    setGridSize(cell + QSize(GRID_SPACING, GRID_SPACING));
 }
 
-QPixmap ThumbnailGrid::generateThumbnail(const QString& filepath) {
-    // PERFORMANCE: Load with exact thumbnail size for faster decoding
-    // Qt and LibRaw can decode at lower resolution directly
-    auto imageOpt = ImageLoader::instance().load(filepath, 
-        QSize(m_thumbnailSize * 2, m_thumbnailSize * 2));  // 2x for retina
-    
-    if (!imageOpt) {
-        // Error placeholder
-        QPixmap placeholder(m_thumbnailSize, m_thumbnailSize);
-        placeholder.fill(QColor(80, 40, 40));
-        return placeholder;
-    }
-    
-    QImage image = *imageOpt;
-    
-    // PERFORMANCE: Fast scaling with SmoothTransformation only when needed
-    if (image.width() > m_thumbnailSize * 3 || image.height() > m_thumbnailSize * 3) {
-        // For very large images, do a fast scale first
-        image = image.scaled(m_thumbnailSize * 2, m_thumbnailSize * 2, 
-            Qt::KeepAspectRatio, Qt::FastTransformation);
+void ThumbnailGrid::scheduleRangeUpdate() {
+    // Throttle, don't debounce: a continuous drag still reprioritizes
+    // every RANGE_UPDATE_DELAY_MS instead of only when it stops
+    if (!m_rangeTimer->isActive()) {
+        m_rangeTimer->start();
     }
+}
+
+void ThumbnailGrid::visibleRows(int* first, int* last) const {
+    QSize cell = gridSize();
+    int columns = qMax(1, viewport()->width() / qMax(1, cell.width()));
+    int top = verticalScrollBar()->value();
+    int bottom = top + viewport()->height();
     
-    // Scale to thumbnail size maintaining aspect ratio
-    QImage scaled = image.scaled(m_thumbnailSize, m_thumbnailSize,
-        Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    *first = (top / qMax(1, cell.height())) * columns;
+    *last = qMin(count() - 1, (bottom / qMax(1, cell.height()) + 1) * columns - 1);
+}
+
+void ThumbnailGrid::updateVisibleRange() {
+    if (count() == 0) return;
     
-    // Center in square
-    QPixmap result(m_thumbnailSize, m_thumbnailSize);
-    result.fill(QColor(42, 42, 42));
+    int first = 0;
+    int last = 0;
+    visibleRows(&first, &last);
+    m_scheduler->updateWindow(first, last);
+}
+
+void ThumbnailGrid::onThumbnailReady(const QString& filepath, const QSize& size,
+                                     const QImage& thumbnail) {
+    Q_UNUSED(thumbnail);  // Model reads it back from the memory tier
+    if (size.width() != m_thumbnailSize) return;
     
-    QPainter painter(&result);
-    int x = (m_thumbnailSize - scaled.width()) / 2;
-    int y = (m_thumbnailSize - scaled.height()) / 2;
-    painter.drawImage(x, y, scaled);
+    int row = m_model->rowForPath(filepath);
+    if (row < 0) return;
     
-    return result;
+    m_scheduler->delivered(row);
+    m_model->thumbnailUpdated(row);
 }
 
-void ThumbnailGrid::onItemClicked(QListWidgetItem* item) {
-    QString filepath = item->data(Qt::UserRole).toString();
+void ThumbnailGrid::onItemClicked(const QModelIndex& index) {
+    QString filepath = index.data(ThumbnailModel::FilePathRole).toString();
     emit imageSelected(filepath);
 }
 
 void ThumbnailGrid::onSelectionChanged() {
     // Emit signal with selection count
-    int count = selectedItems().count();
+    int count = selectionModel()->selectedIndexes().count();
     emit selectionCountChanged(count);
 }
 
-QString ThumbnailGrid::getCacheKey(const QString& filepath, int size) {
-    QFileInfo fi(filepath);
-    return QString("%1_%2_%3")
-        .arg(fi.fileName())
-        .arg(fi.lastModified().toSecsSinceEpoch())
-        .arg(size);
-}
-
-QPixmap ThumbnailGrid::loadFromDiskCache(const QString& cacheKey) {
-    QString cachePath = m_diskCacheDir.filePath(cacheKey + ".jpg");
-    if (QFile::exists(cachePath)) {
-        QPixmap cached;
-        if (cached.load(cachePath)) {
-            return cached;
-        }
-    }
-    return QPixmap();
-}
-
-void ThumbnailGrid::saveToDiskCache(const QString& cacheKey, const QPixmap& pixmap) {
-    QString cachePath = m_diskCacheDir.filePath(cacheKey + ".jpg");
-    pixmap.save(cachePath, "JPG", 85);  // 85% quality for thumbnails
-}
-
 } // namespace PhotoGuru
@@ -1,71 +1,87 @@
 #pragma once
 
-#include <QListWidget>
+#include "core/SortKeyTable.h"
+#include <QListView>
 #include <QStringList>
-#include <QCache>
-#include <QPixmap>
-#include <QFuture>
-#include <QAtomicInt>
-#include <QThreadPool>
-#include <QDir>
+#include <QImage>
+#include <QTimer>
 
 namespace PhotoGuru {
 
-enum class SortOrder {
-    ByName,
-    ByDate,
-    BySize
-};
+class ThumbnailModel;
+class ThumbnailDelegate;
+class ThumbnailScheduler;
 
-class ThumbnailGrid : public QListWidget {
+class ThumbnailGrid : public QListView {
     Q_OBJECT
-    
+
 public:
     explicit ThumbnailGrid(QWidget* parent = nullptr);
     ~ThumbnailGrid();
-    
+
     void setImages(const QStringList& imagePaths);
+    // Same result as setImages, but rows that stay keep their selection and
+    // the view only sees the inserted/removed rows (filter changes)
+    void updateImages(const QStringList& imagePaths);
+    // Rows at the end, unsorted; existing rows don't move. setImages or
+    // updateImages sorts them in later.
+    void appendImages(const QStringList& imagePaths);
+    // Files changed on disk: decode their thumbnails again
+    void refreshThumbnails(const QStringList& imagePaths);
     void selectImage(int index);
     void setCurrentIndex(int index);
-    
+
     // Size control
     void setThumbnailSize(int size);
     int thumbnailSize() const { return m_thumbnailSize; }
-    
+
     // Sorting
     void setSortOrder(SortOrder order);
     SortOrder sortOrder() const { return m_sortOrder; }
-    
+    // Filled by the owner from listings and metadata; sorting reads only this
+    SortKeyTable& sortKeys() { return m_sortKeys; }
+
     // Selection
     QStringList selectedFiles() const;
-    
+
+    // Vertical scroll offset, for restoring a session
+    int scrollPosition() const;
+    void setScrollPosition(int position);
+
+    int count() const;
+
+    // Rows currently waiting on ThumbnailCache (visible range + prefetch)
+    int pendingRequestCount() const;
+
 signals:
     void imageSelected(const QString& filepath);
     void selectionCountChanged(int count);
-    
+
+protected:
+    void resizeEvent(QResizeEvent* event) override;
+
 private slots:
-    void onItemClicked(QListWidgetItem* item);
+    void onItemClicked(const QModelIndex& index);
     void onSelectionChanged();
-    
+    void onThumbnailReady(const QString& filepath, const QSize& size, const QImage& thumbnail);
+    void updateVisibleRange();
+
 private:
-    void loadThumbnails();
-    void loadThumbnailAsync(int index, QThread::Priority priority = QThread::NormalPriority);
-    QPixmap generateThumbnail(const QString& filepath);
-    void sortImages();
-    
-    QStringList m_imagePaths;
-    QCache<QString, QPixmap> m_thumbnailCache;
+    void applyThumbnailSize();
+    void scheduleRangeUpdate();
+    void visibleRows(int* first, int* last) const;
+    void sortImages(QStringList& paths);
+
+    ThumbnailModel* m_model;
+    ThumbnailDelegate* m_delegate;
+    ThumbnailScheduler* m_scheduler;
+    QTimer* m_rangeTimer;        // Throttles scroll/resize bursts
     int m_thumbnailSize = 150;
-    int m_currentIndex = -1;
     SortOrder m_sortOrder = SortOrder::ByName;
-    QAtomicInt m_loadingTasks{0};
-    QThreadPool* m_threadPool;
-    QDir m_diskCacheDir;
-    
-    // Performance optimization
-    QPixmap loadFromDiskCache(const QString& filepath);
-    void saveToDiskCache(const QString& filepath, const QPixmap& pixmap);
-    QString getCacheKey(const QString& filepath, int size);
+    SortKeyTable m_sortKeys;
+
+    static constexpr int RANGE_UPDATE_DELAY_MS = 30;
+    static constexpr int GRID_SPACING = 10;
 };
 
 } // namespace PhotoGuru
@@ -0,0 +1,231 @@
+#include "ThumbnailModel.h"
+#include "ThumbnailCache.h"
+#include <QPainter>
+#include <QImage>
+#include <QFileInfo>
+#include <QSet>
+#include <algorithm>
+
+namespace PhotoGuru {
+
+ThumbnailModel::ThumbnailModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int ThumbnailModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_paths.count();
+}
+
+QVariant ThumbnailModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= m_paths.count()) {
+        return QVariant();
+    }
+
+    const QString& path = m_paths[index.row()];
+
+    switch (role) {
+        case Qt::DisplayRole:
+            return QFileInfo(path).fileName();
+        case Qt::ToolTipRole:
+        case FilePathRole:
+            return path;
+        case Qt::DecorationRole: {
+            // Memory tier only - never blocks the paint on disk or decode
+            QImage cached = ThumbnailCache::instance().cachedImage(
+                path, QSize(m_thumbnailSize, m_thumbnailSize));
+            return cached.isNull() ? QVariant() : QVariant(cached);
+        }
+        case IsCurrentRole:
+            return index.row() == m_currentRow;
+        default:
+            return QVariant();
+    }
+}
+
+void ThumbnailModel::setPaths(const QStringList& paths) {
+    beginResetModel();
+    m_paths = paths;
+    rebuildRowIndex();
+    m_currentRow = -1;
+    endResetModel();
+}
+
+void ThumbnailModel::updatePaths(const QStringList& paths) {
+    QSet<QString> wanted(paths.cbegin(), paths.cend());
+
+    // Shared rows must appear in the same relative order in both lists,
+    // otherwise a diff would need moves. A diff fragmented into many runs
+    // costs the view more than a single reset, so fall back in both cases.
+    int runs = 0;
+    int next = 0;
+    bool removing = false;
+    for (const QString& path : std::as_const(m_paths)) {
+        if (!wanted.contains(path)) {
+            if (!removing) ++runs;
+            removing = true;
+            continue;
+        }
+        removing = false;
+
+        int skipped = next;
+        while (next < paths.count() && !m_rowForPath.contains(paths[next])) {
+            ++next;
+        }
+        if (next > skipped) ++runs;
+        if (next >= paths.count() || paths[next] != path || runs > MAX_DIFF_RUNS) {
+            setPaths(paths);
+            return;
+        }
+        ++next;
+    }
+    if (next < paths.count()) ++runs;
+    if (runs > MAX_DIFF_RUNS) {
+        setPaths(paths);
+        return;
+    }
+
+    QString currentPath = pathAt(m_currentRow);
+
+    // Removals, back to front so earlier row numbers stay valid
+    int row = m_paths.count() - 1;
+    while (row >= 0) {
+        if (wanted.contains(m_paths[row])) {
+            --row;
+            continue;
+        }
+        int last = row;
+        while (row >= 0 && !wanted.contains(m_paths[row])) {
+            --row;
+        }
+        beginRemoveRows(QModelIndex(), row + 1, last);
+        m_paths.erase(m_paths.begin() + row + 1, m_paths.begin() + last + 1);
+        endRemoveRows();
+    }
+    rebuildRowIndex();
+
+    // Insertions, front to back; m_paths is now a subsequence of paths
+    row = 0;
+    while (row < paths.count()) {
+        if (row < m_paths.count() && m_paths[row] == paths[row]) {
+            ++row;
+            continue;
+        }
+        int first = row;
+        while (row < paths.count() && !m_rowForPath.contains(paths[row])) {
+            ++row;
+        }
+        beginInsertRows(QModelIndex(), first, row - 1);
+        m_paths.insert(first, row - first, QString());
+        std::copy(paths.cbegin() + first, paths.cbegin() + row, m_paths.begin() + first);
+        endInsertRows();
+    }
+    rebuildRowIndex();
+
+    m_currentRow = currentPath.isEmpty() ? -1 : rowForPath(currentPath);
+}
+
+void ThumbnailModel::appendPaths(const QStringList& paths) {
+    if (paths.isEmpty()) return;
+    const int first = m_paths.count();
+    beginInsertRows(QModelIndex(), first, first + paths.count() - 1);
+    m_paths += paths;
+    for (int i = first; i < m_paths.count(); ++i) {
+        m_rowForPath.insert(m_paths[i], i);
+    }
+    endInsertRows();
+}
+
+void ThumbnailModel::rebuildRowIndex() {
+    m_rowForPath.clear();
+    m_rowForPath.reserve(m_paths.count());
+    for (int i = 0; i < m_paths.count(); ++i) {
+        m_rowForPath.insert(m_paths[i], i);
+    }
+}
+
+QString ThumbnailModel::pathAt(int row) const {
+    return (row >= 0 && row < m_paths.count()) ? m_paths[row] : QString();
+}
+
+int ThumbnailModel::rowForPath(const QString& path) const {
+    return m_rowForPath.value(path, -1);
+}
+
+void ThumbnailModel::setThumbnailSize(int size) {
+    if (m_thumbnailSize == size) return;
+
+    beginResetModel();
+    m_thumbnailSize = size;
+    endResetModel();
+}
+
+void ThumbnailModel::setCurrentRow(int row) {
+    int previous = m_currentRow;
+    m_currentRow = (row >= 0 && row < m_paths.count()) ? row : -1;
+
+    if (previous >= 0 && previous < m_paths.count()) {
+        emit dataChanged(index(previous), index(previous), {IsCurrentRole});
+    }
+    if (m_currentRow >= 0) {
+        emit dataChanged(index(m_currentRow), index(m_currentRow), {IsCurrentRole});
+    }
+}
+
+void ThumbnailModel::thumbnailUpdated(int row) {
+    if (row >= 0 && row < m_paths.count()) {
+        emit dataChanged(index(row), index(row), {Qt::DecorationRole});
+    }
+}
+
+ThumbnailDelegate::ThumbnailDelegate(QObject* parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+void ThumbnailDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
+                              const QModelIndex& index) const {
+    painter->save();
+
+    QRect cell = option.rect;
+
+    // Selection / current-item highlight
+    if (option.state & QStyle::State_Selected) {
+        painter->fillRect(cell, option.palette.highlight());
+    } else if (index.data(ThumbnailModel::IsCurrentRole).toBool()) {
+        painter->fillRect(cell, QColor(31, 145, 255, 30));  // Adobe blue with low opacity
+    }
+
+    QRect imageRect(cell.left() + (cell.width() - m_thumbnailSize) / 2,
+                    cell.top() + CELL_PADDING, m_thumbnailSize, m_thumbnailSize);
+
+    QImage thumbnail = index.data(Qt::DecorationRole).value<QImage>();
+    if (thumbnail.isNull()) {
+        // Placeholder while loading
+        painter->fillRect(imageRect, QColor(60, 60, 60));
+    } else {
+        QSize scaled = thumbnail.size().scaled(imageRect.size(), Qt::KeepAspectRatio);
+        QRect target(imageRect.left() + (imageRect.width() - scaled.width()) / 2,
+                     imageRect.top() + (imageRect.height() - scaled.height()) / 2,
+                     scaled.width(), scaled.height());
+        painter->drawImage(target, thumbnail);
+    }
+
+    // File name under the image
+    QRect textRect(cell.left() + CELL_PADDING, imageRect.bottom() + CELL_PADDING,
+                   cell.width() - 2 * CELL_PADDING, option.fontMetrics.height());
+    QString text = option.fontMetrics.elidedText(
+        index.data(Qt::DisplayRole).toString(), Qt::ElideMiddle, textRect.width());
+    painter->setPen(option.state & QStyle::State_Selected
+        ? option.palette.highlightedText().color() : option.palette.text().color());
+    painter->drawText(textRect, Qt::AlignHCenter | Qt::AlignTop, text);
+
+    painter->restore();
+}
+
+QSize ThumbnailDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex&) const {
+    return QSize(m_thumbnailSize + 2 * CELL_PADDING,
+                 m_thumbnailSize + 3 * CELL_PADDING + option.fontMetrics.height());
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QStyledItemDelegate>
+#include <QStringList>
+#include <QHash>
+
+namespace PhotoGuru {
+
+/**
+ * @brief Flat list of image paths for ThumbnailGrid
+ *
+ * Holds only the paths - pixels are looked up in ThumbnailCache's memory
+ * tier when a row is painted, so a 100k folder costs one string per row.
+ */
+class ThumbnailModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        FilePathRole = Qt::UserRole,
+        IsCurrentRole = Qt::UserRole + 2
+    };
+
+    explicit ThumbnailModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    void setPaths(const QStringList& paths);
+    // Move to `paths` with row inserts/removes when the shared rows keep
+    // their relative order (filter narrowed or widened); resets otherwise
+    void updatePaths(const QStringList& paths);
+    // New rows at the end (streamed scan results)
+    void appendPaths(const QStringList& paths);
+    const QStringList& paths() const { return m_paths; }
+    QString pathAt(int row) const;
+    int rowForPath(const QString& path) const;
+
+    void setThumbnailSize(int size);
+    int thumbnailSize() const { return m_thumbnailSize; }
+
+    void setCurrentRow(int row);
+    int currentRow() const { return m_currentRow; }
+
+    // Repaint a row whose thumbnail just landed in the cache
+    void thumbnailUpdated(int row);
+
+private:
+    void rebuildRowIndex();
+
+    QStringList m_paths;
+    QHash<QString, int> m_rowForPath;
+    int m_thumbnailSize = 150;
+    int m_currentRow = -1;
+
+    static constexpr int MAX_DIFF_RUNS = 256;
+};
+
+/**
+ * @brief Paints a thumbnail cell (image or placeholder + elided file name)
+ */
+class ThumbnailDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+
+public:
+    explicit ThumbnailDelegate(QObject* parent = nullptr);
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option,
+               const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+
+    void setThumbnailSize(int size) { m_thumbnailSize = size; }
+
+private:
+    int m_thumbnailSize = 150;
+
+    static constexpr int CELL_PADDING = 4;
+};
+
+} // namespace PhotoGuru
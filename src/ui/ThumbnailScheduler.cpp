@@ -0,0 +1,121 @@
+#include "ThumbnailScheduler.h"
+#include "ThumbnailModel.h"
+#include "ThumbnailCache.h"
+#include "FileReadAhead.h"
+#include "ImageLoader.h"
+
+namespace PhotoGuru {
+
+ThumbnailScheduler::ThumbnailScheduler(const ThumbnailModel* model)
+    : m_model(model)
+{
+}
+
+ThumbnailScheduler::~ThumbnailScheduler() {
+    cancelAll();
+}
+
+void ThumbnailScheduler::setThumbnailSize(const QSize& size) {
+    if (m_size == size) return;
+
+    cancelAll();
+    m_size = size;
+}
+
+void ThumbnailScheduler::updateWindow(int firstVisible, int lastVisible) {
+    int count = m_model->rowCount();
+    if (count == 0 || firstVisible < 0 || lastVisible < firstVisible) return;
+
+    if (m_lastFirst >= 0 && firstVisible != m_lastFirst) {
+        m_direction = firstVisible > m_lastFirst ? 1 : -1;
+    }
+    m_lastFirst = firstVisible;
+
+    int span = lastVisible - firstVisible + 1;
+    int ahead = int(span * AHEAD_SCREENS);
+    int behind = int(span * BEHIND_SCREENS);
+    if (m_direction == 0) {
+        // No direction yet - one screen each way
+        ahead = span;
+        behind = span;
+    }
+
+    int before = m_direction < 0 ? ahead : behind;
+    int after = m_direction < 0 ? behind : ahead;
+    int lo = qMax(0, firstVisible - before);
+    int hi = qMin(count - 1, lastVisible + after);
+
+    // Out of the window - cancel what hasn't started
+    ThumbnailCache& cache = ThumbnailCache::instance();
+    for (auto it = m_pending.begin(); it != m_pending.end(); ) {
+        if (it.key() < lo || it.key() > hi) {
+            cache.cancelRequest(m_model->pathAt(it.key()), m_size);
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Files the requests still wait for, in the order they were made
+    QStringList upcoming;
+    auto want = [this, &upcoming](int row, int priority) {
+        request(row, priority);
+        if (m_pending.contains(row)) upcoming << m_model->pathAt(row);
+    };
+
+    // On screen, leading edge first
+    lastVisible = qMin(lastVisible, count - 1);
+    if (m_direction < 0) {
+        for (int row = lastVisible; row >= firstVisible; --row) want(row, VisiblePriority);
+    } else {
+        for (int row = firstVisible; row <= lastVisible; ++row) want(row, VisiblePriority);
+    }
+
+    // Prefetch bands, nearest rows first
+    int belowPriority = m_direction < 0 ? BehindPriority : AheadPriority;
+    int abovePriority = m_direction > 0 ? BehindPriority : AheadPriority;
+    for (int row = lastVisible + 1; row <= hi; ++row) want(row, belowPriority);
+    for (int row = firstVisible - 1; row >= lo; --row) want(row, abovePriority);
+
+    // On a share, the files read ahead of the decodes; stored thumbnails
+    // need none, nor RAWs, whose thumbnails come from the embedded preview
+    FileReadAhead::instance().setUpcoming(upcoming, [size = m_size](const QString& path) {
+        return ImageLoader::instance().detectFormat(path) != ImageFormat::RAW &&
+               !ThumbnailCache::instance().hasThumbnail(path, size);
+    });
+}
+
+void ThumbnailScheduler::cancelAll() {
+    ThumbnailCache& cache = ThumbnailCache::instance();
+    for (auto it = m_pending.cbegin(); it != m_pending.cend(); ++it) {
+        cache.cancelRequest(m_model->pathAt(it.key()), m_size);
+    }
+    m_pending.clear();
+    m_lastFirst = -1;
+    m_direction = 0;
+}
+
+void ThumbnailScheduler::delivered(int row) {
+    m_pending.remove(row);
+}
+
+void ThumbnailScheduler::request(int row, int priority) {
+    auto it = m_pending.find(row);
+    if (it != m_pending.end()) {
+        if (it.value() == priority) return;
+
+        // Changed band - let the cache move it in the pool queue
+        it.value() = priority;
+        ThumbnailCache::instance().requestThumbnail(m_model->pathAt(row), m_size, priority);
+        return;
+    }
+
+    QString path = m_model->pathAt(row);
+    ThumbnailCache& cache = ThumbnailCache::instance();
+    if (!cache.cachedImage(path, m_size).isNull()) return;
+
+    m_pending.insert(row, priority);
+    cache.requestThumbnail(path, m_size, priority);
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QHash>
+#include <QSize>
+
+namespace PhotoGuru {
+
+class ThumbnailModel;
+
+/**
+ * @brief Decides which ThumbnailGrid rows are requested, and how urgently
+ *
+ * Fed the visible row range on every (throttled) scroll. Rows on screen go
+ * first, then a prefetch window that leans in the direction of the scroll
+ * (two screens ahead, half a screen behind). Requests that fall out of the
+ * window are cancelled and ones whose band changed are requeued at their
+ * new priority, so a fast fling never leaves the pool busy with rows the
+ * user already passed.
+ */
+class ThumbnailScheduler {
+public:
+    // ThumbnailCache pool priorities (higher runs first)
+    enum Priority {
+        BehindPriority = 1,
+        AheadPriority = 2,
+        VisiblePriority = 3
+    };
+
+    explicit ThumbnailScheduler(const ThumbnailModel* model);
+    ~ThumbnailScheduler();
+
+    // Cancels everything pending at the old size
+    void setThumbnailSize(const QSize& size);
+
+    void updateWindow(int firstVisible, int lastVisible);
+
+    // Drop all pending requests (model reset, resort, new folder)
+    void cancelAll();
+
+    // Row's thumbnail arrived
+    void delivered(int row);
+
+    int pendingCount() const { return m_pending.size(); }
+    int priorityOf(int row) const { return m_pending.value(row, -1); }
+    int scrollDirection() const { return m_direction; }
+
+private:
+    void request(int row, int priority);
+
+    const ThumbnailModel* m_model;
+    QSize m_size;
+    QHash<int, int> m_pending;   // Row -> priority it was queued with
+    int m_lastFirst = -1;
+    int m_direction = 0;         // +1 down, -1 up, 0 not scrolled yet
+
+    static constexpr double AHEAD_SCREENS = 2.0;
+    static constexpr double BEHIND_SCREENS = 0.5;
+};
+
+} // namespace PhotoGuru
@@ -0,0 +1,281 @@
+#include "TimelineModel.h"
+#include "ThumbnailCache.h"
+#include <QAbstractItemView>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QImage>
+#include <algorithm>
+
+namespace PhotoGuru {
+
+TimelineModel::TimelineModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int TimelineModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_groups.size();
+}
+
+QVariant TimelineModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= m_groups.size()) {
+        return QVariant();
+    }
+
+    const TimelineGroup& group = m_groups[index.row()];
+
+    switch (role) {
+        case Qt::DisplayRole:
+            return group.start_time.toString("MMMM d, yyyy");
+        case Qt::ToolTipRole:
+        case SummaryRole:
+            return group.summary;
+        case GroupIdRole:
+            return group.group_id;
+        case EventTypeRole:
+            return group.event_type;
+        case StatsRole:
+            return QString("%1 photos • %2 minutes")
+                .arg(group.photos.size())
+                .arg(group.duration_minutes);
+        case PhotoCountRole:
+            return int(group.photos.size());
+        case PreviewPathsRole:
+            return previewPaths(index.row());
+        case PreviewImagesRole: {
+            // Memory tier only - never blocks the paint on disk or decode
+            QVariantList images;
+            const QSize size(THUMBNAIL_SIZE, THUMBNAIL_SIZE);
+            for (const QString& path : previewPaths(index.row())) {
+                images << QVariant(ThumbnailCache::instance().cachedImage(path, size));
+            }
+            return images;
+        }
+        default:
+            return QVariant();
+    }
+}
+
+void TimelineModel::setPhotos(const QList<PhotoHandle>& photos) {
+    beginResetModel();
+    m_photos = photos;
+    m_groups.clear();
+    m_rowForPreview.clear();
+
+    QHash<QString, int> groupForId;
+    for (int i = 0; i < m_photos.size(); ++i) {
+        const QString& groupId = m_photos[i]->group_id;
+        QString id = groupId.isEmpty() ? QStringLiteral("ungrouped") : groupId;
+        auto it = groupForId.constFind(id);
+        if (it == groupForId.constEnd()) {
+            it = groupForId.insert(id, m_groups.size());
+            m_groups.append(TimelineGroup());
+            m_groups.last().group_id = id;
+        }
+        m_groups[it.value()].photos.append(i);
+    }
+
+    for (TimelineGroup& group : m_groups) {
+        std::stable_sort(group.photos.begin(), group.photos.end(), [this](int a, int b) {
+            return m_photos[a]->datetime_original < m_photos[b]->datetime_original;
+        });
+
+        // First photo with metadata gives the group context
+        for (int i : std::as_const(group.photos)) {
+            const PhotoMetadata& photo = *m_photos[i];
+            if (!photo.group_context.isEmpty()) {
+                group.event_type = photo.group_context["event_type"].toString();
+                group.summary = photo.group_context["summary"].toString();
+                break;
+            }
+        }
+
+        // Sorted, so invalid dates come first and the valid range is at the end
+        for (int i : std::as_const(group.photos)) {
+            const QDateTime& time = m_photos[i]->datetime_original;
+            if (!time.isValid()) continue;
+            if (!group.start_time.isValid()) group.start_time = time;
+            group.end_time = time;
+        }
+        if (group.start_time.isValid()) {
+            group.duration_minutes = int(group.start_time.secsTo(group.end_time) / 60);
+        }
+    }
+
+    // Newest first
+    std::sort(m_groups.begin(), m_groups.end(), [](const TimelineGroup& a, const TimelineGroup& b) {
+        if (a.start_time != b.start_time) return a.start_time > b.start_time;
+        return a.group_id < b.group_id;
+    });
+
+    for (int row = 0; row < m_groups.size(); ++row) {
+        for (const QString& path : previewPaths(row)) {
+            m_rowForPreview.insert(path, row);
+        }
+    }
+    endResetModel();
+}
+
+void TimelineModel::clear() {
+    setPhotos(QList<PhotoHandle>());
+}
+
+QStringList TimelineModel::previewPaths(int row) const {
+    QStringList paths;
+    if (row < 0 || row >= m_groups.size()) return paths;
+
+    const QVector<int>& photos = m_groups[row].photos;
+    const int count = std::min(int(photos.size()), PREVIEW_COUNT);
+    for (int i = 0; i < count; ++i) {
+        paths << m_photos[photos[i]]->filepath;
+    }
+    return paths;
+}
+
+int TimelineModel::rowForPreview(const QString& filepath) const {
+    return m_rowForPreview.value(filepath, -1);
+}
+
+void TimelineModel::thumbnailUpdated(int row) {
+    if (row < 0 || row >= m_groups.size()) return;
+    QModelIndex idx = index(row);
+    emit dataChanged(idx, idx, {PreviewImagesRole});
+}
+
+TimelineDelegate::TimelineDelegate(QObject* parent)
+    : QStyledItemDelegate(parent)
+{
+    m_dateFont.setPixelSize(18);
+    m_dateFont.setBold(true);
+    m_eventFont.setPixelSize(14);
+    m_eventFont.setBold(true);
+    m_summaryFont.setPixelSize(12);
+    m_statsFont.setPixelSize(11);
+}
+
+TimelineDelegate::Layout TimelineDelegate::layout(const QRect& rect, const QModelIndex& index) const {
+    Layout l;
+    l.card = rect.adjusted(CARD_MARGIN, CARD_SPACING / 2, -CARD_MARGIN, 0);
+
+    const int x = l.card.left() + CARD_PADDING;
+    const int width = l.card.width() - 2 * CARD_PADDING;
+    int y = l.card.top() + CARD_PADDING;
+
+    auto line = [&](const QFont& font, bool shown, int after) {
+        if (!shown) return QRect();
+        QRect r(x, y, width, QFontMetrics(font).height());
+        y += r.height() + after;
+        return r;
+    };
+    l.date = line(m_dateFont, true, LINE_SPACING);
+    l.eventType = line(m_eventFont, !index.data(TimelineModel::EventTypeRole).toString().isEmpty(), LINE_SPACING);
+    l.summary = line(m_summaryFont, !index.data(TimelineModel::SummaryRole).toString().isEmpty(), 2 * LINE_SPACING);
+    l.stats = line(m_statsFont, true, 2 * LINE_SPACING);
+
+    const int count = index.data(TimelineModel::PhotoCountRole).toInt();
+    const int previews = std::min(count, int(TimelineModel::PREVIEW_COUNT));
+    for (int i = 0; i < previews; ++i) {
+        l.thumbnails << QRect(x + (i % COLUMNS) * (CELL_SIZE + CELL_SPACING),
+                              y + (i / COLUMNS) * (CELL_SIZE + CELL_SPACING),
+                              CELL_SIZE, CELL_SIZE);
+    }
+    y += (previews + COLUMNS - 1) / COLUMNS * (CELL_SIZE + CELL_SPACING);
+
+    if (count > previews) {
+        y += LINE_SPACING;
+        l.more = QRect(x, y, width, QFontMetrics(m_statsFont).height() + 16);
+        y += l.more.height();
+    }
+
+    l.card.setBottom(y + CARD_PADDING - 1);
+    return l;
+}
+
+void TimelineDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option,
+                             const QModelIndex& index) const {
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+
+    const Layout l = layout(option.rect, index);
+
+    painter->setPen(option.state & QStyle::State_MouseOver ? QPen(QColor(81, 207, 102, 120), 1) : Qt::NoPen);
+    painter->setBrush(QColor(43, 43, 43));
+    painter->drawRoundedRect(l.card, 8, 8);
+
+    auto text = [&](const QRect& rect, const QFont& font, const QColor& color, const QString& value) {
+        if (rect.isNull()) return;
+        painter->setFont(font);
+        painter->setPen(color);
+        painter->drawText(rect, Qt::AlignLeft | Qt::AlignVCenter,
+                          QFontMetrics(font).elidedText(value, Qt::ElideRight, rect.width()));
+    };
+    text(l.date, m_dateFont, QColor(81, 207, 102), index.data(Qt::DisplayRole).toString());
+    text(l.eventType, m_eventFont, QColor(255, 165, 0), index.data(TimelineModel::EventTypeRole).toString());
+    text(l.summary, m_summaryFont, QColor(170, 170, 170), index.data(TimelineModel::SummaryRole).toString());
+    text(l.stats, m_statsFont, QColor(119, 119, 119), index.data(TimelineModel::StatsRole).toString());
+
+    const QVariantList images = index.data(TimelineModel::PreviewImagesRole).toList();
+    for (int i = 0; i < l.thumbnails.size(); ++i) {
+        const QRect& cell = l.thumbnails[i];
+        painter->setPen(QPen(QColor(51, 51, 51), 2));
+        painter->setBrush(QColor(30, 30, 30));
+        painter->drawRoundedRect(cell.adjusted(1, 1, -1, -1), 4, 4);
+
+        QImage thumbnail = images.value(i).value<QImage>();
+        if (thumbnail.isNull()) continue;  // Placeholder while loading
+        QRect imageRect = cell.adjusted(4, 4, -4, -4);
+        QSize scaled = thumbnail.size().scaled(imageRect.size(), Qt::KeepAspectRatio);
+        painter->drawImage(QRect(imageRect.left() + (imageRect.width() - scaled.width()) / 2,
+                                 imageRect.top() + (imageRect.height() - scaled.height()) / 2,
+                                 scaled.width(), scaled.height()),
+                           thumbnail);
+    }
+
+    if (!l.more.isNull()) {
+        const int hidden = index.data(TimelineModel::PhotoCountRole).toInt() - int(l.thumbnails.size());
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(QColor(51, 51, 51));
+        painter->drawRoundedRect(l.more, 4, 4);
+        painter->setFont(m_statsFont);
+        painter->setPen(QColor(81, 207, 102));
+        painter->drawText(l.more, Qt::AlignCenter, QString("+%1 more photos").arg(hidden));
+    }
+
+    painter->restore();
+}
+
+QSize TimelineDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const {
+    // Cards span the view; the grid alone sets the narrowest they get
+    int width = 2 * (CARD_MARGIN + CARD_PADDING) + COLUMNS * CELL_SIZE + (COLUMNS - 1) * CELL_SPACING;
+    if (const auto* view = qobject_cast<const QAbstractItemView*>(option.widget)) {
+        width = std::max(width, view->viewport()->width());
+    }
+
+    const Layout l = layout(QRect(0, 0, width, 0), index);
+    return QSize(width, l.card.bottom() + 1 + CARD_SPACING / 2);
+}
+
+bool TimelineDelegate::editorEvent(QEvent* event, QAbstractItemModel* model,
+                                   const QStyleOptionViewItem& option, const QModelIndex& index) {
+    if (event->type() == QEvent::MouseButtonRelease) {
+        auto* mouse = static_cast<QMouseEvent*>(event);
+        if (mouse->button() == Qt::LeftButton) {
+            const Layout l = layout(option.rect, index);
+            const QPoint pos = mouse->position().toPoint();
+
+            for (int i = 0; i < l.thumbnails.size(); ++i) {
+                if (l.thumbnails[i].contains(pos)) {
+                    emit photoClicked(index.data(TimelineModel::PreviewPathsRole).toStringList().value(i));
+                    return true;
+                }
+            }
+            if (l.more.contains(pos)) {
+                emit groupClicked(index.data(TimelineModel::GroupIdRole).toString());
+                return true;
+            }
+        }
+    }
+    return QStyledItemDelegate::editorEvent(event, model, option, index);
+}
+
+} // namespace PhotoGuru
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QStyledItemDelegate>
+#include <QFont>
+#include <QDateTime>
+#include <QHash>
+#include <QVector>
+#include "core/PhotoMetadata.h"
+
+namespace PhotoGuru {
+
+struct TimelineGroup {
+    QString group_id;
+    QString event_type;
+    QString summary;
+    QDateTime start_time;
+    QDateTime end_time;
+    QVector<int> photos;      // Indices into the model's photo list, oldest first
+    int duration_minutes = 0;
+};
+
+/**
+ * @brief One row per TimelineView group
+ *
+ * The photos are the catalog's PhotoHandles and groups refer to them by
+ * index, so grouping 100k photos copies no metadata. Only each group's first PREVIEW_COUNT photos are ever shown;
+ * their thumbnails are read from ThumbnailCache's memory tier at paint
+ * time, like ThumbnailModel does.
+ */
+class TimelineModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        GroupIdRole = Qt::UserRole,
+        EventTypeRole,
+        SummaryRole,
+        StatsRole,
+        PhotoCountRole,
+        PreviewPathsRole,     // QStringList
+        PreviewImagesRole     // QVariantList of QImage, null where not cached yet
+    };
+
+    explicit TimelineModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    // Groups by group_id (empty ones together), newest group first
+    void setPhotos(const QList<PhotoHandle>& photos);
+    void clear();
+
+    const TimelineGroup& group(int row) const { return m_groups[row]; }
+    const PhotoMetadata& photo(int index) const { return *m_photos[index]; }
+    QStringList previewPaths(int row) const;
+
+    // Row showing `filepath` as a preview, or -1
+    int rowForPreview(const QString& filepath) const;
+
+    // Repaint a row whose preview thumbnail just landed in the cache
+    void thumbnailUpdated(int row);
+
+    static constexpr int PREVIEW_COUNT = 6;
+    static constexpr int THUMBNAIL_SIZE = 72;
+
+private:
+    QList<PhotoHandle> m_photos;
+    QVector<TimelineGroup> m_groups;
+    QHash<QString, int> m_rowForPreview;
+};
+
+/**
+ * @brief Paints a timeline group as a card and turns clicks into signals
+ *
+ * Header lines, up to PREVIEW_COUNT thumbnails and a "+N more" bar, all
+ * painted; no widgets per group.
+ */
+class TimelineDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+
+public:
+    explicit TimelineDelegate(QObject* parent = nullptr);
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option,
+               const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    bool editorEvent(QEvent* event, QAbstractItemModel* model,
+                     const QStyleOptionViewItem& option, const QModelIndex& index) override;
+
+signals:
+    void photoClicked(const QString& filepath);
+    void groupClicked(const QString& groupId);
+
+private:
+    struct Layout {
+        QRect card;
+        QRect date;
+        QRect eventType;
+        QRect summary;
+        QRect stats;
+        QVector<QRect> thumbnails;
+        QRect more;               // Empty when every photo is previewed
+    };
+
+    Layout layout(const QRect& rect, const QModelIndex& index) const;
+
+    QFont m_dateFont;
+    QFont m_eventFont;
+    QFont m_summaryFont;
+    QFont m_statsFont;
+
+    static constexpr int CARD_MARGIN = 16;
+    static constexpr int CARD_SPACING = 16;
+    static constexpr int CARD_PADDING = 16;
+    static constexpr int LINE_SPACING = 4;
+    static constexpr int CELL_SIZE = 80;
+    static constexpr int CELL_SPACING = 4;
+    static constexpr int COLUMNS = 3;
+};
+
+} // namespace PhotoGuru
@@ -1,61 +1,63 @@
 #pragma once
 
 #include <QWidget>
-#include <QScrollArea>
-#include <QVBoxLayout>
+#include <QListView>
 #include <QLabel>
-#include <QPushButton>
+#include <QTimer>
+#include <QHash>
 #include "core/PhotoMetadata.h"
+#include "TimelineModel.h"
 
 namespace PhotoGuru {
 
-struct TimelineGroup {
-    QString group_id;
-    QString event_type;
-    QString summary;
-    QDateTime start_time;
-    QDateTime end_time;
-    QList<PhotoMetadata> photos;
-    int duration_minutes;
-};
-
-class TimelineGroupWidget : public QWidget {
-    Q_OBJECT
-    
-public:
-    explicit TimelineGroupWidget(const TimelineGroup& group, QWidget* parent = nullptr);
-    
-signals:
-    void photoClicked(const QString& filepath);
-    void groupClicked(const QString& groupId);
-    
-private:
-    void setupUI(const TimelineGroup& group);
-    TimelineGroup m_group;
-};
-
+/**
+ * @brief Event timeline: one card per photo group, newest first
+ *
+ * A QListView over TimelineModel, painted by TimelineDelegate, so only the
+ * cards on screen cost anything and a large library builds no widgets.
+ * Preview thumbnails are requested from ThumbnailCache for the cards on
+ * screen (plus a few ahead) as the view scrolls; requests for cards that
+ * scrolled away are cancelled.
+ */
 class TimelineView : public QWidget {
     Q_OBJECT
     
 public:
     explicit TimelineView(QWidget* parent = nullptr);
     
-    void loadPhotos(const QList<PhotoMetadata>& photos);
+    void loadPhotos(const QList<PhotoHandle>& photos);
+    void loadPhotos(const QList<PhotoMetadata>& photos) { loadPhotos(makePhotoHandles(photos)); }
     void clear();
     
+    int groupCount() const { return m_model->rowCount(); }
+    const TimelineModel* model() const { return m_model; }
+    
+    // Preview thumbnails waiting on ThumbnailCache (cards on screen + prefetch)
+    int pendingThumbnailCount() const { return m_pending.size(); }
+    
 signals:
     void photoSelected(const QString& filepath);
     void groupSelected(const QString& groupId);
     
+protected:
+    void resizeEvent(QResizeEvent* event) override;
+    
 private:
     void setupUI();
-    void buildTimeline();
-    QList<TimelineGroup> createGroups(const QList<PhotoMetadata>& photos);
-    
-    QScrollArea* m_scrollArea;
-    QWidget* m_contentWidget;
-    QVBoxLayout* m_contentLayout;
-    QList<PhotoMetadata> m_photos;
+    void scheduleRangeUpdate();
+    void updateVisibleRange();
+    void cancelPending();
+    void onThumbnailReady(const QString& filepath, const QSize& size, const QImage& thumbnail);
+    
+    TimelineModel* m_model;
+    TimelineDelegate* m_delegate;
+    QListView* m_listView;
+    QLabel* m_emptyLabel;
+    QTimer* m_rangeTimer;
+    QHash<QString, int> m_pending;   // Preview path -> priority it was queued with
+    
+    static constexpr int RANGE_UPDATE_DELAY_MS = 30;
+    static constexpr int PREFETCH_ROWS = 3;
 };
 
 } // namespace PhotoGuru
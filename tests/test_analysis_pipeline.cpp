@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QSignalSpy>
+#include <QThread>
+#include <QMutex>
+#include <QSet>
+#include <QHash>
+#include <QTemporaryDir>
+#include "ml/AnalysisPipeline.h"
+
+using namespace PhotoGuru;
+
+class AnalysisPipelineTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+    
+    // Fake stages: "bad" paths fail to decode, captions are the file path
+    AnalysisPipeline::Stages fakeStages() {
+        AnalysisPipeline::Stages stages;
+        stages.decode = [](const DecodeContext& frame) {
+            if (frame.path().contains("bad")) return QImage();
+            QImage image(4, 4, QImage::Format_RGB32);
+            image.fill(Qt::gray);
+            return image;
+        };
+        stages.embed = [this](const std::vector<QImage>& images) {
+            QMutexLocker lock(&mutex);
+            maxBatch = std::max(maxBatch, int(images.size()));
+            embedThreads.insert(QThread::currentThread());
+            return std::vector<std::optional<std::vector<float>>>(images.size(), std::vector<float>{1.0f});
+        };
+        stages.caption = [](const DecodeContext& frame) -> std::optional<QString> {
+            return frame.path();
+        };
+        stages.write = [this](const QString& path, const QString& caption,
+                              const std::optional<AnalysisPipeline::Scores>&) {
+            QMutexLocker lock(&mutex);
+            written << caption;
+            return path == caption;
+        };
+        return stages;
+    }
+    
+    QStringList files(int count) const {
+        QStringList paths;
+        for (int i = 0; i < count; ++i) {
+            paths << QString("/pipeline/%1img%2.jpg").arg(i % 10 == 0 ? "bad_" : "").arg(i);
+        }
+        return paths;
+    }
+    
+    QMutex mutex;
+    int maxBatch = 0;
+    QSet<QThread*> embedThreads;
+    QStringList written;
+};
+
+TEST_F(AnalysisPipelineTest, ProcessesEveryFileOffTheCallingThread) {
+    AnalysisPipeline pipeline(fakeStages());
+    pipeline.setBatchSize(8);
+    QSignalSpy finished(&pipeline, &AnalysisPipeline::finished);
+    QSignalSpy progress(&pipeline, &AnalysisPipeline::progress);
+    
+    pipeline.start(files(50));
+    ASSERT_TRUE(finished.wait(5000));
+    
+    QList<QVariant> args = finished.takeFirst();
+    EXPECT_EQ(args[0].toInt(), 45) << "succeeded";
+    EXPECT_EQ(args[1].toInt(), 5) << "bad_ files fail to decode";
+    EXPECT_FALSE(args[2].toBool());
+    
+    EXPECT_EQ(progress.count(), 50);
+    EXPECT_EQ(written.size(), 45);
+    EXPECT_LE(maxBatch, 8);
+    EXPECT_FALSE(embedThreads.contains(QThread::currentThread()));
+    EXPECT_FALSE(pipeline.isRunning());
+}
+
+TEST_F(AnalysisPipelineTest, CancelStopsEarly) {
+    AnalysisPipeline::Stages stages = fakeStages();
+    auto write = stages.write;
+    stages.write = [write](const QString& path, const QString& caption,
+                           const std::optional<AnalysisPipeline::Scores>& scores) {
+        QThread::msleep(5);  // Slow ExifTool
+        return write(path, caption, scores);
+    };
+    
+    AnalysisPipeline pipeline(stages);
+    QSignalSpy finished(&pipeline, &AnalysisPipeline::finished);
+    
+    pipeline.start(files(2000));
+    QThread::msleep(50);
+    pipeline.cancel();
+    
+    ASSERT_TRUE(finished.wait(5000));
+    QList<QVariant> args = finished.takeFirst();
+    EXPECT_TRUE(args[2].toBool());
+    EXPECT_LT(args[0].toInt() + args[1].toInt(), 2000);
+}
+
+TEST_F(AnalysisPipelineTest, EmptyInputFinishesImmediately) {
+    AnalysisPipeline pipeline(fakeStages());
+    QSignalSpy finished(&pipeline, &AnalysisPipeline::finished);
+    pipeline.start(QStringList());
+    EXPECT_EQ(finished.count(), 1);
+}
+
+TEST_F(AnalysisPipelineTest, CaptionBatchTakesQueuedItems) {
+    AnalysisPipeline::Stages stages = fakeStages();
+    int maxCaptionBatch = 0;
+    stages.captionBatch = [&maxCaptionBatch](const std::vector<DecodeContext>& frames) {
+        QThread::msleep(10);  // Slow VLM lets the queue fill up
+        maxCaptionBatch = std::max(maxCaptionBatch, int(frames.size()));
+        std::vector<std::optional<QString>> captions;
+        for (const DecodeContext& frame : frames) captions.push_back(frame.path());
+        return captions;
+    };
+    
+    AnalysisPipeline pipeline(stages);
+    pipeline.setCaptionBatchSize(4);
+    QSignalSpy finished(&pipeline, &AnalysisPipeline::finished);
+    
+    pipeline.start(files(40));
+    ASSERT_TRUE(finished.wait(5000));
+    EXPECT_EQ(finished.takeFirst()[0].toInt(), 36);
+    EXPECT_EQ(written.size(), 36) << "Captions stay matched to their files";
+    EXPECT_GT(maxCaptionBatch, 1);
+    EXPECT_LE(maxCaptionBatch, 4);
+}
+
+TEST_F(AnalysisPipelineTest, StagesShareOneDecode) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    QStringList paths;
+    for (int i = 0; i < 6; ++i) {
+        QImage image(400, 200, QImage::Format_RGB32);
+        image.fill(Qt::darkGray);
+        paths << dir.filePath(QString("img%1.png").arg(i));
+        ASSERT_TRUE(image.save(paths.last()));
+    }
+
+    QMutex viewsMutex;
+    QStringList undecodedCaptions;
+    QList<QSize> scoredSizes;
+    QHash<QString, bool> scoredAtWrite;
+
+    AnalysisPipeline::Stages stages = fakeStages();
+    stages.frameEdge = 100;
+    stages.decode = [](const DecodeContext& frame) { return frame.squared(8); };
+    // Cache hits for even files: they reach the captioner undecoded
+    stages.cached = [](const QString& path) -> std::optional<std::vector<float>> {
+        if (path.endsWith("0.png") || path.endsWith("2.png") || path.endsWith("4.png")) {
+            return std::vector<float>{1.0f};
+        }
+        return std::nullopt;
+    };
+    stages.score = [&](const DecodeContext& frame) -> std::optional<AnalysisPipeline::Scores> {
+        QMutexLocker lock(&viewsMutex);
+        scoredSizes << frame.fitted(QualityAnalyzer::ANALYSIS_SIZE).size();
+        return AnalysisPipeline::Scores();
+    };
+    stages.caption = [&](const DecodeContext& frame) -> std::optional<QString> {
+        QMutexLocker lock(&viewsMutex);
+        if (!frame.isDecoded()) undecodedCaptions << frame.path();
+        return frame.rgb888(50).isNull() ? std::nullopt : std::optional<QString>(frame.path());
+    };
+    stages.write = [&](const QString& path, const QString&,
+                       const std::optional<AnalysisPipeline::Scores>& scores) {
+        QMutexLocker lock(&viewsMutex);
+        scoredAtWrite.insert(path, scores.has_value());
+        return true;
+    };
+
+    AnalysisPipeline pipeline(stages);
+    QSignalSpy finished(&pipeline, &AnalysisPipeline::finished);
+    pipeline.start(paths);
+    ASSERT_TRUE(finished.wait(5000));
+    EXPECT_EQ(finished.takeFirst()[0].toInt(), 6);
+
+    EXPECT_EQ(undecodedCaptions.size(), 3) << "Only cache hits reach the VLM undecoded";
+    ASSERT_EQ(scoredSizes.size(), 6) << "Cache hits are scored once the VLM decoded them";
+    for (const QSize& size : scoredSizes) EXPECT_EQ(size, QSize(100, 50)) << "Views come from the bounded decode";
+    for (const QString& path : paths) EXPECT_TRUE(scoredAtWrite.value(path)) << path.toStdString();
+}
+
+TEST_F(AnalysisPipelineTest, CheckpointsEachStageAndReusesCaptions) {
+    QMutex checkpointMutex;
+    QHash<QString, int> reached;
+    QStringList vlmCalls;
+
+    AnalysisPipeline::Stages stages = fakeStages();
+    stages.caption = [&](const DecodeContext& frame) -> std::optional<QString> {
+        QMutexLocker lock(&checkpointMutex);
+        vlmCalls << frame.path();
+        return frame.path();
+    };
+    // Captioned before an interruption: the VLM is not asked again
+    stages.cachedCaption = [](const QString& path) -> std::optional<QString> {
+        if (path.endsWith("img1.jpg") || path.endsWith("img2.jpg")) return path;
+        return std::nullopt;
+    };
+    stages.checkpoint = [&](const QString& path, AnalysisPipeline::Checkpoint stage, const QString& caption) {
+        QMutexLocker lock(&checkpointMutex);
+        reached[path] |= stage;
+        if (stage == AnalysisPipeline::Captioned) EXPECT_EQ(caption, path);
+    };
+
+    AnalysisPipeline pipeline(stages);
+    QSignalSpy finished(&pipeline, &AnalysisPipeline::finished);
+    const QStringList paths = files(10);
+    pipeline.start(paths);
+    ASSERT_TRUE(finished.wait(5000));
+    EXPECT_EQ(finished.takeFirst()[0].toInt(), 9);
+
+    EXPECT_EQ(written.size(), 9);
+    EXPECT_EQ(vlmCalls.size(), 7);
+    EXPECT_FALSE(vlmCalls.contains(paths[1]));
+    EXPECT_FALSE(reached.contains(paths[0])) << "Failed to decode: nothing reached";
+    EXPECT_EQ(reached.value(paths[1]), AnalysisPipeline::Embedded | AnalysisPipeline::Written);
+    EXPECT_EQ(reached.value(paths[5]),
+              AnalysisPipeline::Embedded | AnalysisPipeline::Captioned | AnalysisPipeline::Written);
+}
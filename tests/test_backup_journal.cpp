@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QFileInfo>
+#include "core/BackupJournal.h"
+
+using namespace PhotoGuru;
+
+namespace {
+
+void writeFile(const QString& path, const QByteArray& data) {
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write(data);
+}
+
+QByteArray readFile(const QString& path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+} // namespace
+
+TEST(BackupJournalTest, RestoresTheNewestVersion) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString photo = dir.filePath("a.jpg");
+    BackupJournal journal(dir.filePath("backups"));
+
+    writeFile(photo, "first");
+    ASSERT_TRUE(journal.record(photo));
+    writeFile(photo, "second");
+    ASSERT_TRUE(journal.record(photo));
+    writeFile(photo, "edited");
+
+    EXPECT_TRUE(journal.hasBackup(photo));
+    EXPECT_FALSE(journal.hasBackup(dir.filePath("b.jpg")));
+    EXPECT_EQ(journal.count(), 2);
+    EXPECT_EQ(journal.totalBytes(), 11);
+
+    ASSERT_TRUE(journal.restore(photo));
+    EXPECT_EQ(readFile(photo), "second");
+    EXPECT_TRUE(journal.restore(photo)) << "The version stays in the journal";
+    EXPECT_FALSE(journal.restore(dir.filePath("b.jpg")));
+}
+
+TEST(BackupJournalTest, RestoringAnAbsentFileRemovesIt) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString sidecar = dir.filePath("a.xmp");
+    BackupJournal journal(dir.filePath("backups"));
+
+    ASSERT_TRUE(journal.record(sidecar));
+    writeFile(sidecar, "<x:xmpmeta/>");
+    ASSERT_TRUE(journal.restore(sidecar));
+    EXPECT_FALSE(QFileInfo::exists(sidecar));
+}
+
+TEST(BackupJournalTest, EvictsTheOldestBeyondItsBudget) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    BackupJournal journal(dir.filePath("backups"), 10, 3);
+
+    for (int i = 0; i < 5; i++) {
+        const QString path = dir.filePath(QString("%1.jpg").arg(i));
+        writeFile(path, "abc");
+        ASSERT_TRUE(journal.record(path));
+    }
+    EXPECT_EQ(journal.count(), 3);
+    EXPECT_EQ(journal.totalBytes(), 9);
+    EXPECT_FALSE(journal.hasBackup(dir.filePath("1.jpg")));
+    EXPECT_TRUE(journal.hasBackup(dir.filePath("2.jpg")));
+
+    // Over the byte budget on its own, the newest still stays
+    const QString large = dir.filePath("large.jpg");
+    writeFile(large, QByteArray(64, 'x'));
+    ASSERT_TRUE(journal.record(large));
+    EXPECT_EQ(journal.count(), 1);
+    EXPECT_TRUE(journal.hasBackup(large));
+}
+
+TEST(BackupJournalTest, SurvivesARestart) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString photo = dir.filePath("a b\tc.jpg");
+    writeFile(photo, "original");
+    {
+        BackupJournal journal(dir.filePath("backups"));
+        ASSERT_TRUE(journal.record(photo));
+    }
+    writeFile(photo, "edited");
+
+    BackupJournal reopened(dir.filePath("backups"));
+    EXPECT_EQ(reopened.count(), 1);
+    ASSERT_TRUE(reopened.restore(photo));
+    EXPECT_EQ(readFile(photo), "original");
+
+    // New versions don't reuse the ids of the old ones
+    ASSERT_TRUE(reopened.record(photo));
+    EXPECT_EQ(reopened.count(), 2);
+}
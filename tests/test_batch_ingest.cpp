@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include "cli/BatchIngest.h"
+
+using namespace PhotoGuru;
+
+class BatchIngestTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    std::optional<BatchIngest::Options> parse(const QStringList& arguments) {
+        return BatchIngest::parseArguments(QStringList{"photoguru-cli"} + arguments, &message, &help);
+    }
+
+    void writeImage(const QString& path) {
+        QImage image(8, 8, QImage::Format_RGB32);
+        image.fill(Qt::red);
+        ASSERT_TRUE(image.save(path));
+    }
+
+    QString message;
+    bool help = false;
+};
+
+TEST_F(BatchIngestTest, DefaultsRunEverythingButTakeout) {
+    auto options = parse({"/photos"});
+    ASSERT_TRUE(options);
+    EXPECT_EQ(options->inputs, QStringList({"/photos"}));
+    EXPECT_EQ(options->steps, BatchIngest::Catalog | BatchIngest::Thumbnails |
+                              BatchIngest::Embeddings | BatchIngest::Captions | BatchIngest::Quality |
+                              BatchIngest::Faces);
+    EXPECT_EQ(options->jobs, 0);
+    EXPECT_FALSE(options->recursive);
+}
+
+TEST_F(BatchIngestTest, ParsesStepsAndJobs) {
+    auto options = parse({"--steps", "takeout,Catalog", "-j", "6", "-r", "--thumbnail-size", "256",
+                          "a", "b"});
+    ASSERT_TRUE(options) << message.toStdString();
+    EXPECT_EQ(options->steps, BatchIngest::Takeout | BatchIngest::Catalog);
+    EXPECT_EQ(options->jobs, 6);
+    EXPECT_TRUE(options->recursive);
+    EXPECT_EQ(options->thumbnailSize, 256);
+    EXPECT_EQ(options->inputs, QStringList({"a", "b"}));
+}
+
+TEST_F(BatchIngestTest, RejectsBadArguments) {
+    EXPECT_FALSE(parse({}));
+    EXPECT_FALSE(parse({"--steps", "ocr", "a"}));
+    EXPECT_TRUE(message.contains("ocr"));
+    EXPECT_FALSE(parse({"--jobs", "0", "a"}));
+    EXPECT_FALSE(parse({"--unknown", "a"}));
+    EXPECT_FALSE(help);
+
+    EXPECT_FALSE(parse({"--help"}));
+    EXPECT_TRUE(help);
+    EXPECT_TRUE(message.contains("--steps"));
+}
+
+TEST_F(BatchIngestTest, ParsesInferenceServerOptions) {
+    auto client = parse({"--remote", "http://gpu-box:8765", "--token", "secret", "a"});
+    ASSERT_TRUE(client) << message.toStdString();
+    EXPECT_EQ(client->remote, "http://gpu-box:8765");
+    EXPECT_EQ(client->token, "secret");
+    EXPECT_EQ(client->servePort, 0);
+
+    // Serving needs no inputs
+    auto server = parse({"--serve", "9000", "--gpu-layers", "20"});
+    ASSERT_TRUE(server) << message.toStdString();
+    EXPECT_EQ(server->servePort, 9000);
+    EXPECT_EQ(server->gpuLayers, 20);
+    EXPECT_TRUE(server->inputs.isEmpty());
+
+    EXPECT_FALSE(parse({"--remote", "gpu-box", "a"}));
+    EXPECT_FALSE(parse({"--remote", "ftp://gpu-box", "a"}));
+    EXPECT_FALSE(parse({"--serve", "0"}));
+    EXPECT_FALSE(parse({"--serve", "70000"}));
+    EXPECT_FALSE(parse({"--gpu-layers", "-2", "a"}));
+}
+
+TEST_F(BatchIngestTest, ParsesCatalogSyncOptions) {
+    auto client = parse({"--sync", "http://nas:8766", "--path-map", "/srv/photos=/mnt/photos"});
+    ASSERT_TRUE(client) << message.toStdString();
+    EXPECT_EQ(client->syncFrom, "http://nas:8766");
+    EXPECT_EQ(client->serverRoot, "/srv/photos");
+    EXPECT_EQ(client->localRoot, "/mnt/photos");
+    EXPECT_TRUE(client->inputs.isEmpty());
+
+    auto server = parse({"--serve-catalog", "9001", "--serve", "9000"});
+    ASSERT_TRUE(server) << message.toStdString();
+    EXPECT_EQ(server->catalogPort, 9001);
+    EXPECT_EQ(server->servePort, 9000);
+
+    EXPECT_FALSE(parse({"--sync", "nas"}));
+    EXPECT_FALSE(parse({"--sync", "http://nas:8766", "--path-map", "/srv/photos"}));
+    EXPECT_FALSE(parse({"--sync", "http://nas:8766", "--path-map", "photos=/mnt/photos"}));
+    EXPECT_FALSE(parse({"--serve-catalog", "9000", "--serve", "9000"}));
+}
+
+TEST_F(BatchIngestTest, CollectsSupportedImages) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    QDir(dir.path()).mkdir("sub");
+    writeImage(dir.filePath("b.jpg"));
+    writeImage(dir.filePath("a.png"));
+    writeImage(dir.filePath("sub/c.jpg"));
+    QFile notes(dir.filePath("notes.txt"));
+    ASSERT_TRUE(notes.open(QIODevice::WriteOnly));
+    notes.close();
+
+    QStringList flat = BatchIngest::collectFiles({dir.path(), dir.filePath("a.png")}, false);
+    EXPECT_EQ(flat, QStringList({dir.filePath("a.png"), dir.filePath("b.jpg")}));
+
+    QStringList deep = BatchIngest::collectFiles({dir.path()}, true);
+    EXPECT_EQ(deep.size(), 3);
+    EXPECT_TRUE(deep.contains(dir.filePath("sub/c.jpg")));
+}
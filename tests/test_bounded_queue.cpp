@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include "core/BoundedQueue.h"
+#include <QThread>
+#include <QAtomicInt>
+
+using namespace PhotoGuru;
+
+TEST(BoundedQueueTest, FifoAndCloseDrains) {
+    BoundedQueue<int> queue(4);
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+    queue.close();
+    
+    EXPECT_FALSE(queue.push(3)) << "Closed queue rejects pushes";
+    EXPECT_EQ(queue.pop(), 1);
+    EXPECT_EQ(queue.pop(), 2);
+    EXPECT_FALSE(queue.pop().has_value());
+}
+
+TEST(BoundedQueueTest, AbortDropsItems) {
+    BoundedQueue<int> queue(4);
+    queue.push(1);
+    queue.abort();
+    EXPECT_FALSE(queue.pop().has_value());
+    
+    queue.reset();
+    EXPECT_TRUE(queue.push(5));
+    EXPECT_EQ(queue.pop(), 5);
+}
+
+TEST(BoundedQueueTest, TryPopDoesNotBlock) {
+    BoundedQueue<int> queue(4);
+    EXPECT_FALSE(queue.tryPop().has_value());
+    queue.push(7);
+    EXPECT_EQ(queue.tryPop(), 7);
+    EXPECT_FALSE(queue.tryPop().has_value());
+}
+
+TEST(BoundedQueueTest, PushBlocksWhileFull) {
+    BoundedQueue<int> queue(2);
+    QAtomicInt pushed{0};
+    
+    QThread* producer = QThread::create([&]() {
+        for (int i = 0; i < 10; ++i) {
+            queue.push(i);
+            pushed.fetchAndAddRelaxed(1);
+        }
+        queue.close();
+    });
+    producer->start();
+    
+    QThread::msleep(50);
+    EXPECT_LE(pushed.loadRelaxed(), 2) << "Producer must wait for the consumer";
+    
+    int expected = 0;
+    while (auto item = queue.pop()) {
+        EXPECT_EQ(*item, expected++);
+    }
+    EXPECT_EQ(expected, 10);
+    
+    producer->wait();
+    delete producer;
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QSignalSpy>
+#include <QMutex>
+#include "ml/BurstDetector.h"
+#include "core/PhotoMetadata.h"
+
+using namespace PhotoGuru;
+
+class BurstDetectorTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    static QDateTime at(qint64 msecs) {
+        return QDateTime(QDate(2026, 5, 1), QTime(10, 0)).addMSecs(msecs);
+    }
+
+    static BurstDetector::Shot shot(const QString& path, qint64 msecs, const QString& camera = "Canon R5") {
+        BurstDetector::Shot s;
+        s.path = path;
+        s.captured = at(msecs);
+        s.camera = camera;
+        return s;
+    }
+
+    static PhotoMetadata photo(const QString& path, qint64 msecs, double sharpness = 0.5) {
+        PhotoMetadata meta;
+        meta.filepath = path;
+        meta.datetime_original = at(msecs);
+        meta.camera_make = "Canon";
+        meta.camera_model = "R5";
+        meta.technical.sharpness_score = sharpness;
+        return meta;
+    }
+
+    // Serves `library` as metadata, records writes and folds them back in
+    BurstDetector::Stages fakeStages() {
+        BurstDetector::Stages stages;
+        stages.metadata = [this](const QStringList&) {
+            QMutexLocker lock(&mutex);
+            return library;
+        };
+        stages.write = [this](const QList<PhotoMetadata>& changed) {
+            QMutexLocker lock(&mutex);
+            for (const PhotoMetadata& meta : changed) {
+                written << meta;
+                for (PhotoMetadata& known : library) {
+                    if (known.filepath == meta.filepath) known = meta;
+                }
+            }
+            return std::vector<bool>(size_t(changed.size()), true);
+        };
+        return stages;
+    }
+
+    int runOnce(BurstDetector& detector) {
+        QSignalSpy finished(&detector, &BurstDetector::finished);
+        detector.start({"/d"});
+        EXPECT_TRUE(finished.wait(5000));
+        return finished.isEmpty() ? -1 : finished.takeFirst()[0].toInt();
+    }
+
+    PhotoMetadata writtenFor(const QString& path) const {
+        for (const PhotoMetadata& meta : written) {
+            if (meta.filepath == path) return meta;
+        }
+        return {};
+    }
+
+    QMutex mutex;
+    QList<PhotoMetadata> library;
+    QList<PhotoMetadata> written;
+};
+
+TEST_F(BurstDetectorTest, CloseFramesFormBurstGapSplits) {
+    QList<BurstDetector::Shot> shots = {
+        shot("/d/c.jpg", 400), shot("/d/a.jpg", 0), shot("/d/b.jpg", 200),
+        shot("/d/d.jpg", 60000), shot("/d/e.jpg", 60300), shot("/d/f.jpg", 60600),
+        shot("/d/g.jpg", 120000)
+    };
+    QList<QList<int>> bursts = BurstDetector::group(shots);
+
+    ASSERT_EQ(bursts.size(), 2);
+    EXPECT_EQ(bursts[0], (QList<int>{1, 2, 0})) << "Shooting order, not input order";
+    EXPECT_EQ(bursts[1], (QList<int>{3, 4, 5}));
+}
+
+TEST_F(BurstDetectorTest, CamerasNeverMix) {
+    QList<BurstDetector::Shot> shots = {
+        shot("/d/a.jpg", 0), shot("/d/b.jpg", 100, "iPhone 15"),
+        shot("/d/c.jpg", 200), shot("/d/d.jpg", 300, "iPhone 15")
+    };
+    EXPECT_TRUE(BurstDetector::group(shots).isEmpty()) << "Two frames per body are not a burst";
+
+    shots << shot("/d/e.jpg", 400);
+    QList<QList<int>> bursts = BurstDetector::group(shots);
+    ASSERT_EQ(bursts.size(), 1);
+    EXPECT_EQ(bursts[0], (QList<int>{0, 2, 4}));
+}
+
+TEST_F(BurstDetectorTest, CameraMetadataOutranksTiming) {
+    // Same burst id joins despite a long buffer flush
+    QList<BurstDetector::Shot> shots = {
+        shot("/d/a.jpg", 0), shot("/d/b.jpg", 5000), shot("/d/c.jpg", 10000)
+    };
+    for (BurstDetector::Shot& s : shots) s.burstId = "UUID-1";
+    EXPECT_EQ(BurstDetector::group(shots).size(), 1);
+
+    // Sequence restarting at 1 splits two bursts shot back to back
+    QList<BurstDetector::Shot> sequenced;
+    for (int i = 0; i < 6; ++i) {
+        BurstDetector::Shot s = shot(QString("/d/s%1.jpg").arg(i), i * 100);
+        s.sequence = i % 3 + 1;
+        sequenced << s;
+    }
+    QList<QList<int>> bursts = BurstDetector::group(sequenced);
+    ASSERT_EQ(bursts.size(), 2);
+    EXPECT_EQ(bursts[1], (QList<int>{3, 4, 5}));
+}
+
+TEST_F(BurstDetectorTest, DissimilarFramesSplit) {
+    QList<BurstDetector::Shot> shots;
+    for (int i = 0; i < 6; ++i) shots << shot(QString("/d/%1.jpg").arg(i), i * 100);
+
+    // Camera turns to something else between frames 2 and 3
+    auto similar = [](int a, int b) { return (a < 3) == (b < 3); };
+    QList<QList<int>> bursts = BurstDetector::group(shots, similar);
+    ASSERT_EQ(bursts.size(), 2);
+    EXPECT_EQ(bursts[0], (QList<int>{0, 1, 2}));
+
+    // Unless the camera numbered them as one run
+    for (int i = 0; i < shots.size(); ++i) shots[i].sequence = i + 1;
+    EXPECT_EQ(BurstDetector::group(shots, similar).size(), 1);
+}
+
+TEST_F(BurstDetectorTest, RunMarksSharpestAndWritesOnlyChanges) {
+    library = {
+        photo("/d/a.jpg", 0, 0.4), photo("/d/b.jpg", 300, 0.9), photo("/d/c.jpg", 600, 0.6),
+        photo("/d/lone.jpg", 90000)
+    };
+    BurstDetector detector(fakeStages());
+    EXPECT_EQ(runOnce(detector), 1);
+
+    ASSERT_EQ(written.size(), 3) << "The lone frame had nothing to change";
+    PhotoMetadata best = writtenFor("/d/b.jpg");
+    EXPECT_EQ(best.technical.burst_group, BurstDetector::groupId("/d/a.jpg"));
+    EXPECT_EQ(best.technical.burst_position, 1);
+    EXPECT_TRUE(best.technical.is_best_in_burst);
+    EXPECT_FALSE(writtenFor("/d/a.jpg").technical.is_best_in_burst);
+
+    // Same library again: nothing to write
+    written.clear();
+    EXPECT_EQ(runOnce(detector), 1);
+    EXPECT_TRUE(written.isEmpty());
+}
+
+TEST_F(BurstDetectorTest, NewImportsRewriteOnlyTheirBurst) {
+    library = {
+        photo("/d/a.jpg", 0), photo("/d/b.jpg", 300), photo("/d/c.jpg", 600),
+        photo("/d/x.jpg", 60000), photo("/d/y.jpg", 60300), photo("/d/z.jpg", 60600)
+    };
+    BurstDetector detector(fakeStages());
+    EXPECT_EQ(runOnce(detector), 2);
+
+    written.clear();
+    library << photo("/d/d.jpg", 900);
+    EXPECT_EQ(runOnce(detector), 2);
+    ASSERT_EQ(written.size(), 1) << "Earlier frames keep their id and position";
+    EXPECT_EQ(written[0].filepath, "/d/d.jpg");
+    EXPECT_EQ(written[0].technical.burst_position, 3);
+}
+
+TEST_F(BurstDetectorTest, FramesLeavingBurstAreCleared) {
+    library = { photo("/d/a.jpg", 0), photo("/d/b.jpg", 300), photo("/d/c.jpg", 600) };
+    BurstDetector detector(fakeStages());
+    EXPECT_EQ(runOnce(detector), 1);
+
+    // Corrected capture time moves one frame away; the rest are no longer a burst
+    written.clear();
+    library[2].datetime_original = at(3600000);
+    EXPECT_EQ(runOnce(detector), 0);
+    ASSERT_EQ(written.size(), 3);
+    for (const PhotoMetadata& meta : written) {
+        EXPECT_TRUE(meta.technical.burst_group.isEmpty());
+        EXPECT_EQ(meta.technical.burst_position, -1);
+        EXPECT_FALSE(meta.technical.is_best_in_burst);
+    }
+}
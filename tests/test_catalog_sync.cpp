@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QtConcurrent>
+#include "core/CatalogServer.h"
+#include "core/CatalogSync.h"
+#include "core/PhotoDatabase.h"
+#include "core/ThumbnailCache.h"
+
+using namespace PhotoGuru;
+
+// One process, one catalog: the "server" library lives under served/, the
+// client mounts the same files under mounted/ and syncs through the mapping.
+class CatalogSyncTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    void SetUp() override {
+        ASSERT_TRUE(dir.isValid());
+        ASSERT_TRUE(QDir().mkpath(served()));
+        ASSERT_TRUE(QDir().mkpath(mounted()));
+        ASSERT_TRUE(PhotoDatabase::instance().initialize(dir.filePath("catalog.db")));
+        ASSERT_TRUE(ThumbnailCache::instance().setDiskLocation(dir.filePath("thumbnails.pack")));
+    }
+
+    void TearDown() override {
+        server.reset();
+        ThumbnailCache::instance().setDiskLocation(ThumbnailCache::defaultDiskLocation());
+        PhotoDatabase::instance().close();
+    }
+
+    void serve(const QString& token = QString()) {
+        server = std::make_unique<CatalogServer>();
+        server->setToken(token);
+        ASSERT_TRUE(server->listen(QHostAddress::LocalHost, 0)) << server->errorString().toStdString();
+    }
+
+    QUrl url() const {
+        return QUrl(QString("http://127.0.0.1:%1").arg(server->port()));
+    }
+
+    QString served() const { return dir.filePath("served"); }
+    QString mounted() const { return dir.filePath("mounted"); }
+
+    // The same file under both roots, as a share mounted twice would show it
+    QString addPhoto(const QString& name, const QString& title) {
+        QImage image(64, 48, QImage::Format_RGB32);
+        image.fill(Qt::darkCyan);
+        const QString path = served() + '/' + name;
+        EXPECT_TRUE(image.save(path, "JPEG"));
+        const QString copy = mounted() + '/' + name;
+        EXPECT_TRUE(QFile::copy(path, copy));
+        QFile file(copy);
+        EXPECT_TRUE(file.open(QIODevice::ReadWrite));
+        EXPECT_TRUE(file.setFileTime(QFileInfo(path).lastModified(), QFileDevice::FileModificationTime));
+
+        PhotoMetadata meta;
+        meta.filepath = path;
+        meta.llm_title = title;
+        EXPECT_TRUE(PhotoDatabase::instance().storeMetadata(meta));
+        return path;
+    }
+
+    // The client blocks, the server answers on this thread: run the client elsewhere
+    template <typename F>
+    auto offThread(F&& call) {
+        QFutureWatcher<decltype(call())> watcher;
+        QEventLoop loop;
+        QObject::connect(&watcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit);
+        watcher.setFuture(QtConcurrent::run(std::forward<F>(call)));
+        if (!watcher.isFinished()) loop.exec();
+        return watcher.result();
+    }
+
+    CatalogSync client() const {
+        CatalogSync sync(url());
+        sync.setPathMapping(served(), mounted());
+        return sync;
+    }
+
+    QTemporaryDir dir;
+    std::unique_ptr<CatalogServer> server;
+};
+
+TEST_F(CatalogSyncTest, MapsPaths) {
+    CatalogSync sync(QUrl("http://127.0.0.1:1"));
+    EXPECT_EQ(sync.localPath("/srv/photos/a.jpg"), "/srv/photos/a.jpg");
+
+    sync.setPathMapping("/srv/photos/", "/mnt/nas");
+    EXPECT_EQ(sync.localPath("/srv/photos/2024/a.jpg"), "/mnt/nas/2024/a.jpg");
+    EXPECT_EQ(sync.localPath("/srv/photos"), "/mnt/nas");
+    EXPECT_TRUE(sync.localPath("/srv/photoshop/a.jpg").isEmpty());
+    EXPECT_TRUE(sync.localPath("/home/a.jpg").isEmpty());
+}
+
+TEST_F(CatalogSyncTest, PullsRecordsAndThumbnails) {
+    const QString path = addPhoto("beach.jpg", "Beach");
+    QFileInfo info(path);
+    const QSize size(CatalogSync::DEFAULT_THUMBNAIL_EDGE, CatalogSync::DEFAULT_THUMBNAIL_EDGE);
+    QImage thumbnail(size, QImage::Format_RGB32);
+    thumbnail.fill(Qt::yellow);
+    ASSERT_TRUE(ThumbnailCache::instance().storeThumbnail(
+        path, info.lastModified().toMSecsSinceEpoch(), info.size(), size, thumbnail));
+    serve();
+
+    CatalogSync sync = client();
+    auto result = offThread([&]() { return sync.sync(); });
+    ASSERT_TRUE(result) << sync.lastError().toStdString();
+    EXPECT_EQ(result->records, 1);
+    EXPECT_EQ(result->removed, 0);
+    EXPECT_EQ(result->thumbnails, 1);
+
+    const QString local = mounted() + "/beach.jpg";
+    auto meta = PhotoDatabase::instance().cachedMetadata(local);
+    ASSERT_TRUE(meta.has_value());
+    EXPECT_EQ(meta->llm_title, "Beach");
+    QFileInfo localInfo(local);
+    EXPECT_FALSE(ThumbnailCache::instance().storedThumbnail(
+        local, localInfo.lastModified().toMSecsSinceEpoch(), localInfo.size(), size).isNull());
+
+    // Nothing new: the cursor is past it (our own mounted/ entries are outside the mapping)
+    result = offThread([&]() { return sync.sync(); });
+    ASSERT_TRUE(result) << sync.lastError().toStdString();
+    EXPECT_EQ(result->records, 0);
+}
+
+TEST_F(CatalogSyncTest, PropagatesRemovals) {
+    const QString path = addPhoto("gone.jpg", "Gone");
+    addPhoto("kept.jpg", "Kept");
+    serve();
+
+    CatalogSync sync = client();
+    auto result = offThread([&]() { return sync.sync(); });
+    ASSERT_TRUE(result) << sync.lastError().toStdString();
+    EXPECT_EQ(result->records, 2);
+
+    ASSERT_TRUE(PhotoDatabase::instance().removePhoto(path));
+    result = offThread([&]() { return sync.sync(); });
+    ASSERT_TRUE(result) << sync.lastError().toStdString();
+    EXPECT_EQ(result->records, 1);
+    EXPECT_EQ(result->removed, 1);
+    EXPECT_FALSE(PhotoDatabase::instance().cachedMetadata(mounted() + "/gone.jpg").has_value());
+    EXPECT_TRUE(PhotoDatabase::instance().cachedMetadata(mounted() + "/kept.jpg").has_value());
+}
+
+TEST_F(CatalogSyncTest, FingerprintOnlyPathsKeepOurPhoto) {
+    // Cataloged here; the server only fingerprinted its copy (a duplicate scan)
+    QImage image(64, 48, QImage::Format_RGB32);
+    image.fill(Qt::darkRed);
+    const QString path = served() + "/twin.jpg";
+    ASSERT_TRUE(image.save(path, "JPEG"));
+    const QString local = mounted() + "/twin.jpg";
+    ASSERT_TRUE(QFile::copy(path, local));
+    QFile file(local);
+    ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+    ASSERT_TRUE(file.setFileTime(QFileInfo(path).lastModified(), QFileDevice::FileModificationTime));
+    file.close();
+
+    PhotoMetadata meta;
+    meta.filepath = local;
+    meta.llm_title = "Ours";
+    ASSERT_TRUE(PhotoDatabase::instance().storeMetadata(meta));
+    QFileInfo info(path);
+    ASSERT_TRUE(PhotoDatabase::instance().storeFingerprint(PhotoDatabase::Fingerprint{
+        path, info.lastModified().toMSecsSinceEpoch(), info.size(), "quick", {}}));
+    serve();
+
+    CatalogSync sync = client();
+    auto result = offThread([&]() { return sync.sync(); });
+    ASSERT_TRUE(result) << sync.lastError().toStdString();
+    EXPECT_EQ(result->records, 1);
+    EXPECT_EQ(result->removed, 0);
+    auto kept = PhotoDatabase::instance().cachedMetadata(local);
+    ASSERT_TRUE(kept.has_value());
+    EXPECT_EQ(kept->llm_title, "Ours");
+    auto fingerprint = PhotoDatabase::instance().freshFingerprint(local);
+    ASSERT_TRUE(fingerprint.has_value());
+    EXPECT_EQ(fingerprint->quick, QByteArray("quick"));
+}
+
+TEST_F(CatalogSyncTest, RefusesItsOwnCatalogWithoutMapping) {
+    serve();
+    CatalogSync sync(url());
+    auto result = offThread([&]() { return sync.sync(); });
+    EXPECT_FALSE(result);
+    EXPECT_FALSE(sync.lastError().isEmpty());
+}
+
+TEST_F(CatalogSyncTest, RejectsWrongToken) {
+    addPhoto("private.jpg", "Private");
+    serve("secret");
+
+    CatalogSync sync(url(), "guess");
+    sync.setPathMapping(served(), mounted());
+    auto result = offThread([&]() { return sync.sync(); });
+    EXPECT_FALSE(result);
+    EXPECT_FALSE(PhotoDatabase::instance().cachedMetadata(mounted() + "/private.jpg").has_value());
+
+    CatalogSync authorized(url(), "secret");
+    authorized.setPathMapping(served(), mounted());
+    result = offThread([&]() { return authorized.sync(); });
+    ASSERT_TRUE(result) << authorized.lastError().toStdString();
+    EXPECT_EQ(result->records, 1);
+}
+
+TEST_F(CatalogSyncTest, AnswersPipelinedRequests) {
+    serve();
+    const quint16 port = server->port();
+    const QByteArray replies = offThread([port]() {
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, port);
+        if (!socket.waitForConnected(5000)) return QByteArray();
+        // One write: the second request is already buffered when the 404 goes out
+        socket.write("GET /nowhere HTTP/1.1\r\nHost: x\r\n\r\nGET /v1/catalog HTTP/1.1\r\nHost: x\r\n\r\n");
+        QByteArray received;
+        while (received.count("HTTP/1.1 ") < 2 && socket.waitForReadyRead(5000)) received += socket.readAll();
+        return received;
+    });
+    EXPECT_EQ(replies.count("HTTP/1.1 404"), 1);
+    EXPECT_EQ(replies.count("HTTP/1.1 200"), 1);
+}
@@ -3,6 +3,7 @@
 #include "../src/core/ImageLoader.h"
 #include <opencv2/opencv.hpp>
 #include <QDebug>
+#include <QColor>
 
 using namespace PhotoGuru;
 
@@ -136,6 +137,56 @@ TEST_F(CLIPAnalyzerTest, DISABLED_DifferentImagesProduceDifferentEmbeddings) {
     EXPECT_LT(similarity, 0.99f);
 }
 
+TEST_F(CLIPAnalyzerTest, DISABLED_BatchMatchesSingleEmbeddings) {
+    // This test is disabled until model is downloaded
+    CLIPAnalyzer analyzer;
+    ASSERT_TRUE(analyzer.loadModel(modelPath));
+    analyzer.setBatchSize(8);
+    
+    // More images than one batch, with a null image in the middle
+    std::vector<QImage> images;
+    for (int i = 0; i < 11; ++i) {
+        QImage image(224, 224, QImage::Format_RGB32);
+        image.fill(QColor(i * 20, 255 - i * 20, 128));
+        images.push_back(i == 5 ? QImage() : image);
+    }
+    
+    auto batch = analyzer.computeEmbeddings(images);
+    ASSERT_EQ(batch.size(), images.size());
+    EXPECT_FALSE(batch[5].has_value());
+    
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (i == 5) continue;
+        auto single = analyzer.computeEmbedding(images[i]);
+        ASSERT_TRUE(single.has_value());
+        ASSERT_TRUE(batch[i].has_value());
+        EXPECT_GT(analyzer.cosineSimilarity(*single, *batch[i]), 0.999f);
+    }
+}
+
+TEST_F(CLIPAnalyzerTest, ComputeEmbeddingsWithoutModel) {
+    CLIPAnalyzer analyzer;
+    std::vector<QImage> images(3, QImage(16, 16, QImage::Format_RGB32));
+    
+    auto results = analyzer.computeEmbeddings(images);
+    ASSERT_EQ(results.size(), images.size()) << "One slot per input image";
+    for (const auto& result : results) {
+        EXPECT_FALSE(result.has_value());
+    }
+}
+
+TEST_F(CLIPAnalyzerTest, BatchSizeIsClamped) {
+    CLIPAnalyzer analyzer;
+    EXPECT_EQ(analyzer.batchSize(), CLIPAnalyzer::DEFAULT_BATCH_SIZE);
+    
+    analyzer.setBatchSize(1);
+    EXPECT_EQ(analyzer.batchSize(), CLIPAnalyzer::MIN_BATCH_SIZE);
+    analyzer.setBatchSize(1000);
+    EXPECT_EQ(analyzer.batchSize(), CLIPAnalyzer::MAX_BATCH_SIZE);
+    analyzer.setBatchSize(32);
+    EXPECT_EQ(analyzer.batchSize(), 32);
+}
+
 TEST_F(CLIPAnalyzerTest, CosineSimilarityIdentical) {
     CLIPAnalyzer analyzer;
     
@@ -304,3 +355,14 @@ TEST_F(CLIPAnalyzerTest, DISABLED_SemanticSearchPerformance) {
     qDebug() << "Search time (1000 vectors):" << duration.count() << "ms";
     EXPECT_LT(duration.count(), 50);
 }
+
+TEST_F(CLIPAnalyzerTest, TextEmbeddingRequiresTextModel) {
+    CLIPAnalyzer analyzer;
+    EXPECT_FALSE(analyzer.isTextInitialized());
+    EXPECT_FALSE(analyzer.computeTextEmbedding("a dog").has_value());
+    
+    // Text tower has to match an initialized vision model
+    EXPECT_FALSE(analyzer.initializeText("/invalid/text.onnx", "/invalid/vocab.json", "/invalid/merges.txt"));
+    EXPECT_FALSE(analyzer.isTextInitialized());
+    EXPECT_EQ(analyzer.textCacheSize(), CLIPAnalyzer::DEFAULT_TEXT_CACHE_SIZE);
+}
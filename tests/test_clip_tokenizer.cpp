@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include "ml/CLIPTokenizer.h"
+#include <QTemporaryDir>
+#include <QFile>
+
+using namespace PhotoGuru;
+
+class CLIPTokenizerTest : public ::testing::Test {
+protected:
+    // Tiny vocabulary in the Hugging Face layout: enough merges to spell
+    // "dog</w>", "dogs</w>" and "the</w>"
+    void SetUp() override {
+        ASSERT_TRUE(tempDir.isValid());
+        write("vocab.json", R"({
+            "d": 0, "o": 1, "g": 2, "s": 3, "t": 4, "h": 5, "e": 6, "!": 7,
+            "d</w>": 8, "o</w>": 9, "g</w>": 10, "s</w>": 11, "e</w>": 12, "!</w>": 13,
+            "do": 14, "dog</w>": 15, "dog": 16, "dogs</w>": 17, "th": 18, "the</w>": 19,
+            "<|startoftext|>": 20, "<|endoftext|>": 21
+        })");
+        write("merges.txt", "#version: 0.2\nd o\ndo g</w>\ndo g\ndog s</w>\nt h\nth e</w>\n");
+        ASSERT_TRUE(tokenizer.load(tempDir.filePath("vocab.json"), tempDir.filePath("merges.txt")));
+    }
+
+    void write(const QString& name, const QByteArray& content) {
+        QFile file(tempDir.filePath(name));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(content);
+    }
+
+    QTemporaryDir tempDir;
+    CLIPTokenizer tokenizer;
+};
+
+TEST_F(CLIPTokenizerTest, AppliesMergesByRank) {
+    EXPECT_EQ(tokenizer.tokenize("dog"), (std::vector<int>{15}));
+    EXPECT_EQ(tokenizer.tokenize("dogs"), (std::vector<int>{17}));
+    EXPECT_EQ(tokenizer.tokenize("  The   DOG! "), (std::vector<int>{19, 15, 13}))
+        << "Lowercased, whitespace collapsed, punctuation split off";
+}
+
+TEST_F(CLIPTokenizerTest, EncodeFramesAndPads) {
+    std::vector<int64_t> mask;
+    std::vector<int64_t> ids = tokenizer.encode("the dogs", &mask);
+    ASSERT_EQ(ids.size(), size_t(CLIPTokenizer::CONTEXT_LENGTH));
+    EXPECT_EQ(ids[0], 20);
+    EXPECT_EQ(ids[1], 19);
+    EXPECT_EQ(ids[2], 17);
+    EXPECT_EQ(ids[3], 21);
+    EXPECT_EQ(ids[4], 0);
+    EXPECT_EQ(mask[3], 1);
+    EXPECT_EQ(mask[4], 0);
+}
+
+TEST_F(CLIPTokenizerTest, LongTextKeepsEndToken) {
+    QString text;
+    for (int i = 0; i < 200; ++i) text += "dog ";
+    std::vector<int64_t> mask;
+    std::vector<int64_t> ids = tokenizer.encode(text, &mask);
+    ASSERT_EQ(ids.size(), size_t(CLIPTokenizer::CONTEXT_LENGTH));
+    EXPECT_EQ(ids.back(), tokenizer.endToken());
+    EXPECT_EQ(mask.back(), 1);
+}
+
+TEST_F(CLIPTokenizerTest, MissingFilesFail) {
+    CLIPTokenizer other;
+    EXPECT_FALSE(other.load("/invalid/vocab.json", "/invalid/merges.txt"));
+    EXPECT_FALSE(other.isLoaded());
+    EXPECT_FALSE(other.lastError().isEmpty());
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QThread>
+#include "core/DecodeContext.h"
+
+using namespace PhotoGuru;
+
+class DecodeContextTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_dir.isValid());
+        QImage image(800, 400, QImage::Format_RGB32);
+        image.fill(Qt::darkGreen);
+        m_path = m_dir.filePath("wide.png");
+        ASSERT_TRUE(image.save(m_path));
+    }
+
+    QTemporaryDir m_dir;
+    QString m_path;
+};
+
+TEST_F(DecodeContextTest, DecodesLazilyAtTheBound) {
+    DecodeContext frame(m_path, 200);
+    EXPECT_FALSE(frame.isDecoded());
+
+    EXPECT_EQ(frame.image().size(), QSize(200, 100));
+    EXPECT_TRUE(frame.isDecoded());
+
+    EXPECT_EQ(DecodeContext(m_path).image().size(), QSize(800, 400)) << "0 is full resolution";
+}
+
+TEST_F(DecodeContextTest, ViewsOfOneDecode) {
+    DecodeContext frame(m_path, 400);
+
+    EXPECT_EQ(frame.fitted(100).size(), QSize(100, 50));
+    EXPECT_EQ(frame.fitted(1000).size(), QSize(400, 200)) << "Never upscaled past the decode";
+    EXPECT_EQ(frame.squared(64).size(), QSize(64, 64));
+
+    QImage rgb = frame.rgb888(100);
+    EXPECT_EQ(rgb.format(), QImage::Format_RGB888);
+    EXPECT_EQ(rgb.size(), QSize(100, 50));
+    EXPECT_EQ(frame.rgb888(100).constBits(), rgb.constBits()) << "Views are cached, not rebuilt";
+}
+
+TEST_F(DecodeContextTest, CopiesShareTheDecode) {
+    DecodeContext frame(m_path, 200);
+    DecodeContext copy = frame;
+
+    QImage decoded;
+    QThread* thread = QThread::create([&copy, &decoded]() { decoded = copy.image(); });
+    thread->start();
+    thread->wait();
+    delete thread;
+
+    EXPECT_TRUE(frame.isDecoded()) << "Decoded on another thread, seen by every copy";
+    EXPECT_EQ(frame.image().constBits(), decoded.constBits());
+
+    frame.release();
+    EXPECT_FALSE(copy.isDecoded());
+}
+
+TEST_F(DecodeContextTest, RequireRaisesTheBoundUntilDecoded) {
+    DecodeContext frame(m_path, 100);
+    frame.require(300);
+    frame.require(200);
+    EXPECT_EQ(frame.maxEdge(), 300);
+    EXPECT_EQ(frame.image().width(), 300);
+
+    frame.require(600);
+    EXPECT_EQ(frame.image().width(), 300) << "Already decoded";
+}
+
+TEST_F(DecodeContextTest, UnreadableAndEmpty) {
+    DecodeContext missing(m_dir.filePath("missing.jpg"), 100);
+    EXPECT_TRUE(missing.isNull());
+    EXPECT_TRUE(missing.fitted(50).isNull());
+    EXPECT_TRUE(missing.isDecoded()) << "Not retried on every view";
+
+    DecodeContext empty;
+    EXPECT_TRUE(empty.isNull());
+    EXPECT_TRUE(empty.path().isEmpty());
+
+    QImage onScreen(60, 30, QImage::Format_RGB32);
+    onScreen.fill(Qt::white);
+    DecodeContext shown = DecodeContext::fromImage("/shown.jpg", onScreen);
+    EXPECT_TRUE(shown.isDecoded());
+    EXPECT_EQ(shown.fitted(30).size(), QSize(30, 15));
+}
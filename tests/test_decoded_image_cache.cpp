@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QRect>
+#include <QDateTime>
+#include "core/DecodedImageCache.h"
+
+using namespace PhotoGuru;
+
+class DecodedImageCacheTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    void SetUp() override {
+        ASSERT_TRUE(dir.isValid());
+        for (int i = 0; i < 4; ++i) {
+            QString path = dir.filePath(QString("img%1.png").arg(i));
+            QImage image(64, 48, QImage::Format_RGB32);
+            image.fill(QColor(i * 60, 0, 0));
+            ASSERT_TRUE(image.save(path));
+            files << path;
+        }
+    }
+
+    // Waits until `spy` has seen `path`
+    static bool waitFor(QSignalSpy& spy, const QString& path) {
+        for (int attempt = 0; attempt < 50; ++attempt) {
+            for (const QList<QVariant>& args : spy) {
+                if (args[0].toString() == path) return true;
+            }
+            spy.wait(100);
+        }
+        return false;
+    }
+
+    QTemporaryDir dir;
+    QStringList files;
+};
+
+TEST_F(DecodedImageCacheTest, RequestDecodesAndCaches) {
+    DecodedImageCache cache;
+    QSignalSpy decoded(&cache, &DecodedImageCache::decoded);
+
+    EXPECT_TRUE(cache.find(files[0]).isNull());
+    cache.request(files[0]);
+    EXPECT_TRUE(cache.isPending(files[0]));
+    ASSERT_TRUE(waitFor(decoded, files[0]));
+
+    EXPECT_FALSE(cache.isPending(files[0]));
+    EXPECT_EQ(decoded.first()[1].value<QImage>().size(), QSize(64, 48));
+    EXPECT_EQ(cache.find(files[0]).size(), QSize(64, 48));
+    EXPECT_EQ(cache.sourceSize(files[0]), QSize(64, 48));
+
+    // Cached: answered synchronously
+    decoded.clear();
+    cache.request(files[0]);
+    EXPECT_EQ(decoded.count(), 1);
+}
+
+TEST_F(DecodedImageCacheTest, PrefetchFillsNeighbours) {
+    DecodedImageCache cache;
+    QSignalSpy decoded(&cache, &DecodedImageCache::previewDecoded);
+
+    // A preview of a small PNG holds every pixel, so it lands as the full image too
+    cache.prefetch({files[1], files[2]});
+    ASSERT_TRUE(waitFor(decoded, files[1]));
+    ASSERT_TRUE(waitFor(decoded, files[2]));
+    EXPECT_FALSE(cache.find(files[1]).isNull());
+    EXPECT_FALSE(cache.find(files[2]).isNull());
+    EXPECT_TRUE(cache.find(files[3]).isNull());
+}
+
+TEST_F(DecodedImageCacheTest, PreviewIsBoundedByPreviewSize) {
+    DecodedImageCache cache;
+    cache.setPreviewSize(QSize(32, 32));
+    QSignalSpy previews(&cache, &DecodedImageCache::previewDecoded);
+
+    cache.requestPreview(files[0]);
+    ASSERT_TRUE(waitFor(previews, files[0]));
+    EXPECT_EQ(previews.first()[1].value<QImage>().size(), QSize(32, 24));
+    EXPECT_EQ(cache.findPreview(files[0]).size(), QSize(32, 24));
+
+    // Downscaled: the full image still needs its own decode
+    EXPECT_TRUE(cache.find(files[0]).isNull());
+    QSignalSpy decoded(&cache, &DecodedImageCache::decoded);
+    cache.request(files[0]);
+    ASSERT_TRUE(waitFor(decoded, files[0]));
+    EXPECT_EQ(cache.find(files[0]).size(), QSize(64, 48));
+}
+
+TEST_F(DecodedImageCacheTest, RegionIsDecodedUncached) {
+    DecodedImageCache cache;
+    QSignalSpy regions(&cache, &DecodedImageCache::regionDecoded);
+
+    cache.requestRegion(files[0], QRect(16, 8, 32, 24));
+    ASSERT_TRUE(waitFor(regions, files[0]));
+    EXPECT_EQ(regions.first()[1].toRect(), QRect(16, 8, 32, 24));
+    EXPECT_EQ(regions.first()[2].value<QImage>().size(), QSize(32, 24));
+    EXPECT_EQ(cache.count(), 0);
+}
+
+TEST_F(DecodedImageCacheTest, RegionIsCutFromACachedFullResolutionFrame) {
+    DecodedImageCache cache;
+    QSignalSpy decoded(&cache, &DecodedImageCache::decoded);
+    cache.request(files[1]);
+    ASSERT_TRUE(waitFor(decoded, files[1]));
+    ASSERT_EQ(cache.find(files[1]).size(), cache.sourceSize(files[1]));
+
+    // Different pixels on disk, same mtime: a region read from the file would show them
+    const QDateTime modified = QFileInfo(files[1]).lastModified();
+    QImage repainted(64, 48, QImage::Format_RGB32);
+    repainted.fill(Qt::white);
+    ASSERT_TRUE(repainted.save(files[1]));
+    QFile file(files[1]);
+    ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+    ASSERT_TRUE(file.setFileTime(modified, QFileDevice::FileModificationTime));
+    file.close();
+
+    QSignalSpy regions(&cache, &DecodedImageCache::regionDecoded);
+    cache.requestRegion(files[1], QRect(16, 8, 32, 24));
+    ASSERT_TRUE(waitFor(regions, files[1]));
+    const QImage region = regions.first()[2].value<QImage>();
+    ASSERT_EQ(region.size(), QSize(32, 24));
+    EXPECT_EQ(region.pixelColor(0, 0), QColor(60, 0, 0));
+    EXPECT_EQ(cache.count(), 1);
+}
+
+TEST_F(DecodedImageCacheTest, ChangedFileIsDecodedAgain) {
+    DecodedImageCache cache;
+    QImage image(8, 8, QImage::Format_RGB32);
+    image.fill(Qt::green);
+    cache.insert(files[0], image);
+    ASSERT_FALSE(cache.find(files[0]).isNull());
+
+    QFile file(files[0]);
+    ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+    ASSERT_TRUE(file.setFileTime(QDateTime::currentDateTime().addSecs(60), QFileDevice::FileModificationTime));
+    file.close();
+    EXPECT_TRUE(cache.find(files[0]).isNull());
+}
+
+TEST_F(DecodedImageCacheTest, BudgetEvictsLeastRecentlyUsed) {
+    DecodedImageCache cache;
+    QImage image(256, 256, QImage::Format_ARGB32);  // 256 KB
+    image.fill(Qt::white);
+
+    cache.setMaxBytes(600 * 1024);
+    cache.insert(files[0], image);
+    cache.insert(files[1], image);
+    cache.find(files[0]);  // files[1] is now the oldest
+    cache.insert(files[2], image);
+
+    EXPECT_EQ(cache.count(), 2);
+    EXPECT_FALSE(cache.find(files[0]).isNull());
+    EXPECT_TRUE(cache.find(files[1]).isNull());
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDir>
+#include <QTest>
+#include "core/DirectoryWatcher.h"
+
+using namespace PhotoGuru;
+
+class DirectoryWatcherTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+    
+    QString write(const QString& name, const QByteArray& data = "x") {
+        QString path = QDir(m_dir.path()).filePath(name);
+        QFile file(path);
+        file.open(QIODevice::WriteOnly);
+        file.write(data);
+        return path;
+    }
+    
+    QTemporaryDir m_dir;
+};
+
+TEST_F(DirectoryWatcherTest, DiffSortsFilesIntoAddedRemovedModified) {
+    DirectoryWatcher::Listing before;
+    before.insert("/d/same.jpg", {100, 10});
+    before.insert("/d/gone.jpg", {100, 10});
+    before.insert("/d/touched.jpg", {100, 10});
+    DirectoryWatcher::Listing after;
+    after.insert("/d/same.jpg", {100, 10});
+    after.insert("/d/touched.jpg", {200, 10});
+    after.insert("/d/new.jpg", {300, 5});
+    
+    DirectoryWatcher::Changes changes = DirectoryWatcher::diff(before, after);
+    EXPECT_EQ(changes.added, QStringList{"/d/new.jpg"});
+    EXPECT_EQ(changes.removed, QStringList{"/d/gone.jpg"});
+    EXPECT_EQ(changes.modified, QStringList{"/d/touched.jpg"});
+    EXPECT_TRUE(DirectoryWatcher::diff(after, after).isEmpty());
+}
+
+TEST_F(DirectoryWatcherTest, ListingAppliesNameFilters) {
+    QString jpg = write("a.jpg");
+    write("notes.txt");
+    
+    QStringList files;
+    DirectoryWatcher::Listing listing = DirectoryWatcher::list(m_dir.path(), {"*.jpg"}, &files);
+    EXPECT_EQ(files, QStringList{jpg});
+    ASSERT_TRUE(listing.contains(jpg));
+    EXPECT_EQ(listing.value(jpg).size, 1);
+}
+
+TEST_F(DirectoryWatcherTest, ReportsOnlyWhatChanged) {
+    QString kept = write("kept.jpg");
+    QString removed = write("removed.jpg");
+    
+    DirectoryWatcher watcher;
+    QSignalSpy spy(&watcher, &DirectoryWatcher::changed);
+    watcher.watch(m_dir.path(), {"*.jpg"});
+    QTest::qWait(200);  // Baseline scan
+    EXPECT_EQ(spy.count(), 0) << "The baseline is not a change";
+    
+    QFile::remove(removed);
+    QString added = write("added.jpg");
+    write("ignored.txt");
+    watcher.rescan();  // Don't depend on the platform's notification latency
+    ASSERT_TRUE(spy.wait(5000));
+    
+    DirectoryWatcher::Changes changes = spy.takeFirst()[0].value<DirectoryWatcher::Changes>();
+    EXPECT_EQ(changes.added, QStringList{added});
+    EXPECT_EQ(changes.removed, QStringList{removed});
+    EXPECT_TRUE(changes.modified.isEmpty());
+    EXPECT_EQ(changes.files, (QStringList{added, kept}));
+}
+
+TEST_F(DirectoryWatcherTest, BurstIsOneRescan) {
+    DirectoryWatcher watcher;
+    QSignalSpy spy(&watcher, &DirectoryWatcher::changed);
+    watcher.watch(m_dir.path(), {"*.jpg"});
+    QTest::qWait(200);
+    
+    for (int i = 0; i < 50; ++i) {
+        write(QString("burst_%1.jpg").arg(i));
+    }
+    ASSERT_TRUE(spy.wait(DirectoryWatcher::MAX_DELAY_MS + 3000));
+    QTest::qWait(DirectoryWatcher::DEBOUNCE_MS * 2);
+    
+    int added = 0;
+    for (const QList<QVariant>& signal : spy) {
+        added += signal[0].value<DirectoryWatcher::Changes>().added.size();
+    }
+    EXPECT_EQ(added, 50);
+    EXPECT_LE(spy.count(), 2) << "Notifications are debounced";
+}
+
+TEST_F(DirectoryWatcherTest, FirstScanReportsChangesSinceTheBaseline) {
+    QString kept = write("kept.jpg");
+    QString added = write("added.jpg");
+    QString gone = QDir(m_dir.path()).filePath("gone.jpg");
+    
+    // As a restored session remembers the folder
+    DirectoryWatcher::Listing baseline = DirectoryWatcher::list(m_dir.path(), {"*.jpg"});
+    baseline.remove(added);
+    baseline.insert(gone, {100, 10});
+    
+    DirectoryWatcher watcher;
+    QSignalSpy spy(&watcher, &DirectoryWatcher::changed);
+    watcher.watch(m_dir.path(), {"*.jpg"}, baseline);
+    EXPECT_TRUE(watcher.hasListing());
+    ASSERT_TRUE(spy.wait(5000));
+    
+    DirectoryWatcher::Changes changes = spy.takeFirst()[0].value<DirectoryWatcher::Changes>();
+    EXPECT_EQ(changes.added, QStringList{added});
+    EXPECT_EQ(changes.removed, QStringList{gone});
+    EXPECT_TRUE(changes.modified.isEmpty());
+    EXPECT_EQ(changes.files, (QStringList{added, kept}));
+    EXPECT_EQ(watcher.listing().size(), 2);
+}
@@ -0,0 +1,290 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QSignalSpy>
+#include <QThread>
+#include <QMutex>
+#include <QMap>
+#include <cmath>
+#include <bitset>
+#include <random>
+#include "ml/DuplicateFinder.h"
+
+using namespace PhotoGuru;
+
+class DuplicateFinderTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    static std::vector<float> unit(std::vector<float> v) {
+        float norm = 0.0f;
+        for (float x : v) norm += x * x;
+        norm = std::sqrt(norm);
+        for (float& x : v) x /= norm;
+        return v;
+    }
+
+    // Files named "<cluster>_<n>.jpg" embed near the cluster's axis; "solo" files are unique
+    DuplicateFinder::Stages fakeStages() {
+        DuplicateFinder::Stages stages;
+        stages.decode = [](const QString& path) {
+            QImage image(4, 4, QImage::Format_RGB32);
+            image.setText("path", path);
+            return image;
+        };
+        stages.embed = [this](const std::vector<QImage>& images) {
+            std::vector<std::optional<std::vector<float>>> out;
+            for (const QImage& image : images) {
+                QString name = image.text("path").section('/', -1);
+                int axis = name.section('_', 0, 0).toInt();
+                int n = name.section('_', 1, 1).section('.', 0, 0).toInt();
+                std::vector<float> v(8, 0.0f);
+                v[size_t(axis)] = 1.0f;
+                v[size_t((axis + 1) % 8)] = 0.05f * float(n);
+                out.push_back(unit(v));
+            }
+            embedThread = QThread::currentThread();
+            return out;
+        };
+        stages.write = [this](const QString& path, const QString& group) {
+            QMutexLocker lock(&mutex);
+            written.insert(path.section('/', -1), group);
+            return true;
+        };
+        return stages;
+    }
+
+    QMutex mutex;
+    QMap<QString, QString> written;
+    QThread* embedThread = nullptr;
+};
+
+TEST_F(DuplicateFinderTest, GroupRowsFollowsChains) {
+    // a~b and b~c are above threshold, a~c is not; d is unrelated
+    std::vector<float> a = unit({1.0f, 0.0f, 0.0f});
+    std::vector<float> b = unit({1.0f, 0.3f, 0.0f});
+    std::vector<float> c = unit({1.0f, 0.6f, 0.0f});
+    std::vector<float> d = unit({0.0f, 0.0f, 1.0f});
+    std::vector<float> matrix;
+    for (const auto& v : {a, b, c, d}) matrix.insert(matrix.end(), v.begin(), v.end());
+
+    auto groups = DuplicateFinder::groupRows(matrix.data(), 4, 3, 0.95f);
+    ASSERT_EQ(groups.size(), 4u);
+    EXPECT_EQ(groups[0], 0);
+    EXPECT_EQ(groups[1], 0);
+    EXPECT_EQ(groups[2], 0);
+    EXPECT_EQ(groups[3], -1);
+}
+
+TEST_F(DuplicateFinderTest, LargeSetUsesNeighbourSearch) {
+    const int rows = DuplicateFinder::EXACT_TILE_LIMIT + 1000;
+    const int dim = 32;
+    std::mt19937 rng(5);
+    std::normal_distribution<float> normal;
+
+    // Random rows, with every 10th row a near copy of the one before
+    std::vector<float> matrix(size_t(rows) * dim);
+    for (int r = 0; r < rows; ++r) {
+        std::vector<float> v(dim);
+        for (int i = 0; i < dim; ++i) {
+            v[size_t(i)] = r % 10 == 9 ? matrix[size_t(r - 1) * dim + i] + 0.01f * normal(rng) : normal(rng);
+        }
+        v = unit(v);
+        std::copy(v.begin(), v.end(), matrix.begin() + size_t(r) * dim);
+    }
+
+    auto groups = DuplicateFinder::groupRows(matrix.data(), rows, dim, 0.95f);
+    int grouped = 0;
+    for (int r = 0; r < rows; ++r) {
+        if (r % 10 == 9) {
+            EXPECT_GE(groups[size_t(r)], 0) << "row " << r;
+            EXPECT_EQ(groups[size_t(r)], groups[size_t(r - 1)]) << "row " << r;
+        }
+        grouped += groups[size_t(r)] >= 0;
+    }
+    EXPECT_EQ(grouped, 2 * (rows / 10));
+}
+
+TEST_F(DuplicateFinderTest, GroupIdIsOrderIndependent) {
+    QString id = DuplicateFinder::groupId({"/p/b.jpg", "/p/a.jpg"});
+    EXPECT_EQ(id, DuplicateFinder::groupId({"/p/a.jpg", "/p/b.jpg", "/p/c.jpg"}));
+    EXPECT_TRUE(id.startsWith("dup-"));
+    EXPECT_NE(id, DuplicateFinder::groupId({"/p/b.jpg", "/p/c.jpg"}));
+}
+
+TEST_F(DuplicateFinderTest, RunWritesGroupsInBackground) {
+    DuplicateFinder finder(fakeStages());
+    QSignalSpy finished(&finder, &DuplicateFinder::finished);
+
+    finder.start({"/d/0_0.jpg", "/d/0_1.jpg", "/d/3_0.jpg", "/d/3_1.jpg", "/d/3_2.jpg", "/d/6_0.jpg"});
+    ASSERT_TRUE(finished.wait(5000));
+
+    QList<QVariant> args = finished.takeFirst();
+    EXPECT_EQ(args[0].toInt(), 2) << "groups";
+    EXPECT_EQ(args[1].toInt(), 5) << "images in groups";
+    EXPECT_FALSE(args[2].toBool());
+    EXPECT_NE(embedThread, QThread::currentThread());
+
+    ASSERT_EQ(written.size(), 6) << "Every file is written so stale groups get cleared";
+    EXPECT_FALSE(written["0_0.jpg"].isEmpty());
+    EXPECT_EQ(written["0_0.jpg"], written["0_1.jpg"]);
+    EXPECT_EQ(written["3_0.jpg"], written["3_2.jpg"]);
+    EXPECT_NE(written["0_0.jpg"], written["3_0.jpg"]);
+    EXPECT_TRUE(written["6_0.jpg"].isEmpty());
+}
+
+TEST_F(DuplicateFinderTest, CachedEmbeddingsSkipClip) {
+    DuplicateFinder::Stages stages = fakeStages();
+    int embedCalls = 0;
+    auto embed = stages.embed;
+    stages.embed = [&embedCalls, embed](const std::vector<QImage>& images) {
+        ++embedCalls;
+        return embed(images);
+    };
+    stages.cached = [](const QString&) -> std::optional<std::vector<float>> {
+        return std::vector<float>{1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    };
+
+    DuplicateFinder finder(stages);
+    QSignalSpy finished(&finder, &DuplicateFinder::finished);
+    finder.start({"/d/a.jpg", "/d/b.jpg"});
+    ASSERT_TRUE(finished.wait(5000));
+    EXPECT_EQ(embedCalls, 0);
+    EXPECT_EQ(finished.takeFirst()[0].toInt(), 1);
+}
+
+TEST_F(DuplicateFinderTest, IdenticalFilesAreEmbeddedOnce) {
+    DuplicateFinder::Stages stages = fakeStages();
+    int embedded = 0;
+    auto embed = stages.embed;
+    stages.embed = [&embedded, embed](const std::vector<QImage>& images) {
+        embedded += int(images.size());
+        return embed(images);
+    };
+    stages.exactGroups = [](const QStringList&) {
+        return QList<QStringList>{{"/d/0_0.jpg", "/d/copy.jpg"}};
+    };
+    QStringList stored;
+    stages.store = [&stored](const QString& path, const std::vector<float>&) { stored << path; };
+
+    DuplicateFinder finder(stages);
+    QSignalSpy finished(&finder, &DuplicateFinder::finished);
+    finder.start({"/d/0_0.jpg", "/d/copy.jpg", "/d/6_0.jpg"});
+    ASSERT_TRUE(finished.wait(5000));
+
+    EXPECT_EQ(embedded, 2);
+    EXPECT_TRUE(stored.contains("/d/copy.jpg")) << "Copies get a stored embedding of their own";
+    EXPECT_EQ(finished.takeFirst()[1].toInt(), 2);
+    EXPECT_FALSE(written["copy.jpg"].isEmpty());
+    EXPECT_EQ(written["copy.jpg"], written["0_0.jpg"]);
+}
+
+// Files named "<cluster>_<n>_<base>-<flips>.jpg" hash to a random word per base
+// with the low <flips> bits flipped; "bad" files have no hash
+static QHash<QString, quint64> fakeHashes(const QStringList& paths) {
+    QHash<QString, quint64> out;
+    for (const QString& path : paths) {
+        QString tail = path.section('/', -1).section('_', 2, 2).section('.', 0, 0);
+        if (tail.isEmpty()) continue;
+        quint64 hash = std::mt19937_64(tail.section('-', 0, 0).toULongLong())();
+        int flips = tail.section('-', 1, 1).toInt();
+        out.insert(path, hash ^ ((quint64(1) << flips) - 1));
+    }
+    return out;
+}
+
+TEST_F(DuplicateFinderTest, HashPairsMatchBruteForce) {
+    QHash<QString, quint64> hashes = fakeHashes({"/d/0_0_1-0.jpg", "/d/0_0_1-5.jpg", "/d/0_0_1-9.jpg",
+                                                 "/d/0_0_2-0.jpg"});
+    std::vector<quint64> values(hashes.cbegin(), hashes.cend());
+    auto pairs = DuplicateFinder::hashPairs(values, DuplicateFinder::HASH_CANDIDATE_DISTANCE);
+
+    size_t expected = 0;
+    for (size_t a = 0; a < values.size(); ++a) {
+        for (size_t b = a + 1; b < values.size(); ++b) {
+            expected += std::bitset<64>(values[a] ^ values[b]).count() <= DuplicateFinder::HASH_CANDIDATE_DISTANCE;
+        }
+    }
+    EXPECT_EQ(pairs.size(), expected);
+    EXPECT_EQ(expected, 3u) << "The three versions of base 1 pair up; base 2 is far";
+    for (const auto& pair : pairs) {
+        EXPECT_EQ(pair.distance, int(std::bitset<64>(values[size_t(pair.a)] ^ values[size_t(pair.b)]).count()));
+    }
+}
+
+TEST_F(DuplicateFinderTest, HashesGroupWithoutClip) {
+    DuplicateFinder::Stages stages = fakeStages();
+    stages.embed = nullptr;
+    stages.perceptualHashes = fakeHashes;
+
+    DuplicateFinder finder(stages);
+    QSignalSpy finished(&finder, &DuplicateFinder::finished);
+    finder.start({"/d/0_0_1-0.jpg", "/d/0_0_1-3.jpg", "/d/0_0_1-10.jpg", "/d/0_0_2-0.jpg", "/d/bad.jpg"});
+    ASSERT_TRUE(finished.wait(5000));
+
+    QList<QVariant> args = finished.takeFirst();
+    EXPECT_EQ(args[0].toInt(), 1) << "groups";
+    EXPECT_EQ(args[1].toInt(), 2) << "images in groups";
+    EXPECT_FALSE(written["0_0_1-0.jpg"].isEmpty());
+    EXPECT_EQ(written["0_0_1-0.jpg"], written["0_0_1-3.jpg"]);
+    EXPECT_TRUE(written["0_0_1-10.jpg"].isEmpty()) << "Ambiguous without CLIP to confirm";
+    EXPECT_TRUE(written["0_0_2-0.jpg"].isEmpty());
+}
+
+TEST_F(DuplicateFinderTest, ClipConfirmsOnlyAmbiguousHashPairs) {
+    DuplicateFinder::Stages stages = fakeStages();
+    QStringList embedded;
+    auto embed = stages.embed;
+    stages.embed = [&embedded, embed](const std::vector<QImage>& images) {
+        for (const QImage& image : images) embedded << image.text("path").section('/', -1);
+        return embed(images);
+    };
+    stages.perceptualHashes = fakeHashes;
+
+    DuplicateFinder finder(stages);
+    QSignalSpy finished(&finder, &DuplicateFinder::finished);
+    finder.start({"/d/1_0_1-0.jpg", "/d/1_0_1-3.jpg",     // Near-identical hashes
+                  "/d/2_0_2-0.jpg", "/d/2_1_2-10.jpg",    // Ambiguous, same scene
+                  "/d/3_0_3-0.jpg", "/d/5_0_3-9.jpg",     // Ambiguous, different scenes
+                  "/d/4_0_4-0.jpg"});
+    ASSERT_TRUE(finished.wait(5000));
+
+    embedded.sort();
+    EXPECT_EQ(embedded, QStringList({"2_0_2-0.jpg", "2_1_2-10.jpg", "3_0_3-0.jpg", "5_0_3-9.jpg"}));
+    EXPECT_EQ(finished.takeFirst()[0].toInt(), 2);
+    EXPECT_EQ(written["1_0_1-0.jpg"], written["1_0_1-3.jpg"]);
+    EXPECT_EQ(written["2_0_2-0.jpg"], written["2_1_2-10.jpg"]);
+    EXPECT_FALSE(written["2_0_2-0.jpg"].isEmpty());
+    EXPECT_NE(written["1_0_1-0.jpg"], written["2_0_2-0.jpg"]);
+    EXPECT_TRUE(written["3_0_3-0.jpg"].isEmpty());
+    EXPECT_TRUE(written["5_0_3-9.jpg"].isEmpty());
+}
+
+TEST_F(DuplicateFinderTest, CancelSkipsWrites) {
+    DuplicateFinder::Stages stages = fakeStages();
+    auto embed = stages.embed;
+    stages.embed = [embed](const std::vector<QImage>& images) {
+        QThread::msleep(20);  // Slow CLIP
+        return embed(images);
+    };
+
+    DuplicateFinder finder(stages);
+    finder.setBatchSize(1);
+    QSignalSpy finished(&finder, &DuplicateFinder::finished);
+
+    QStringList files;
+    for (int i = 0; i < 500; ++i) files << QString("/d/%1_%2.jpg").arg(i % 8).arg(i % 5);
+    finder.start(files);
+    QThread::msleep(50);
+    finder.cancel();
+
+    ASSERT_TRUE(finished.wait(5000));
+    EXPECT_TRUE(finished.takeFirst()[2].toBool());
+    EXPECT_TRUE(written.isEmpty());
+    EXPECT_FALSE(finder.isRunning());
+}
@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include "core/EmbeddingStore.h"
+#include <QTemporaryDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+
+using namespace PhotoGuru;
+
+class EmbeddingStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(tempDir.isValid());
+        storeDir = tempDir.filePath("embeddings");
+        photoA = tempDir.filePath("a.jpg");
+        photoB = tempDir.filePath("b.jpg");
+        writePhoto(photoA, 64, Qt::green);
+        writePhoto(photoB, 64, Qt::blue);
+    }
+
+    void writePhoto(const QString& path, int size, QColor color) {
+        QImage image(size, size, QImage::Format_RGB32);
+        image.fill(color);
+        ASSERT_TRUE(image.save(path, "PNG"));
+    }
+
+    static std::vector<float> vec(float base) {
+        std::vector<float> v(DIM);
+        for (int i = 0; i < DIM; ++i) v[size_t(i)] = base + float(i);
+        return v;
+    }
+
+    static constexpr int DIM = 8;
+    QTemporaryDir tempDir;
+    QString storeDir;
+    QString photoA;
+    QString photoB;
+};
+
+TEST_F(EmbeddingStoreTest, InsertFindAndMissing) {
+    EmbeddingStore store;
+    ASSERT_TRUE(store.open(storeDir, "test-model", DIM));
+
+    EXPECT_FALSE(store.find(photoA));
+    EXPECT_EQ(store.missing({photoA, photoB}), QStringList({photoA, photoB}));
+
+    ASSERT_TRUE(store.insert(photoA, vec(1.0f)));
+    EXPECT_FALSE(store.insert(photoB, std::vector<float>(3)));  // Wrong dimension
+
+    auto found = store.find(photoA);
+    ASSERT_TRUE(found);
+    EXPECT_EQ(*found, vec(1.0f));
+    EXPECT_EQ(store.missing({photoA, photoB}), QStringList({photoB}));
+    EXPECT_EQ(store.liveCount(), 1);
+}
+
+TEST_F(EmbeddingStoreTest, RowsAreOneContiguousMatrix) {
+    EmbeddingStore store;
+    ASSERT_TRUE(store.open(storeDir, "test-model", DIM));
+    ASSERT_TRUE(store.insert(photoA, vec(0.0f)));
+    ASSERT_TRUE(store.insert(photoB, vec(100.0f)));
+
+    ASSERT_EQ(store.rowCount(), 2);
+    const EmbeddingStore::Matrix matrix = store.matrix();
+    ASSERT_TRUE(matrix);
+    ASSERT_EQ(matrix.rows, 2);
+    EXPECT_EQ(matrix.row(1), matrix.data + DIM);
+    EXPECT_FLOAT_EQ(matrix.data[DIM + 3], 103.0f);
+    EXPECT_EQ(store.pathOf(1), photoB);
+    EXPECT_EQ(store.idOf(photoB), 1);
+}
+
+TEST_F(EmbeddingStoreTest, PersistsAcrossReopen) {
+    {
+        EmbeddingStore store;
+        ASSERT_TRUE(store.open(storeDir, "test-model", DIM));
+        ASSERT_TRUE(store.insert(photoA, vec(1.0f)));
+        ASSERT_TRUE(store.insert(photoB, vec(2.0f)));
+    }
+
+    EmbeddingStore store;
+    ASSERT_TRUE(store.open(storeDir, "test-model", DIM));
+    EXPECT_EQ(store.liveCount(), 2);
+    EXPECT_EQ(*store.find(photoB), vec(2.0f));
+    EXPECT_TRUE(store.missing({photoA, photoB}).isEmpty());
+}
+
+TEST_F(EmbeddingStoreTest, ChangedFileSupersedesRow) {
+    EmbeddingStore store;
+    ASSERT_TRUE(store.open(storeDir, "test-model", DIM));
+    ASSERT_TRUE(store.insert(photoA, vec(1.0f)));
+
+    writePhoto(photoA, 200, Qt::white);
+    EXPECT_FALSE(store.find(photoA)) << "Changed file should not hit stale embedding";
+    EXPECT_EQ(store.missing({photoA}), QStringList({photoA}));
+
+    ASSERT_TRUE(store.insert(photoA, vec(5.0f)));
+    EXPECT_EQ(*store.find(photoA), vec(5.0f));
+    EXPECT_EQ(store.rowCount(), 2);
+    EXPECT_FALSE(store.isLive(0));
+    EXPECT_TRUE(store.isLive(1));
+    EXPECT_EQ(store.liveCount(), 1);
+}
+
+TEST_F(EmbeddingStoreTest, ModelChangeDiscardsStore) {
+    {
+        EmbeddingStore store;
+        ASSERT_TRUE(store.open(storeDir, "model-v1", DIM));
+        ASSERT_TRUE(store.insert(photoA, vec(1.0f)));
+    }
+    {
+        EmbeddingStore store;
+        ASSERT_TRUE(store.open(storeDir, "model-v1", DIM * 2));
+        EXPECT_EQ(store.rowCount(), 0) << "Dimension change must invalidate";
+    }
+
+    EmbeddingStore store;
+    ASSERT_TRUE(store.open(storeDir, "model-v2", DIM));
+    EXPECT_EQ(store.rowCount(), 0);
+    EXPECT_FALSE(store.find(photoA));
+}
+
+TEST_F(EmbeddingStoreTest, TornTailIsDiscarded) {
+    {
+        EmbeddingStore store;
+        ASSERT_TRUE(store.open(storeDir, "test-model", DIM));
+        ASSERT_TRUE(store.insert(photoA, vec(1.0f)));
+    }
+
+    // Crash after the matrix row landed but before its table record
+    {
+        QFile matrix(storeDir + "/embeddings.f32");
+        ASSERT_TRUE(matrix.open(QIODevice::Append));
+        matrix.write(QByteArray(DIM * sizeof(float) + 3, 'x'));
+        QFile table(storeDir + "/embeddings.ids");
+        ASSERT_TRUE(table.open(QIODevice::Append));
+        table.write(QByteArray(11, 'y'));
+    }
+
+    EmbeddingStore store;
+    ASSERT_TRUE(store.open(storeDir, "test-model", DIM));
+    EXPECT_EQ(store.rowCount(), 1);
+    EXPECT_EQ(*store.find(photoA), vec(1.0f));
+
+    // Appends continue on a clean row boundary
+    ASSERT_TRUE(store.insert(photoB, vec(2.0f)));
+    const EmbeddingStore::Matrix matrix = store.matrix();
+    ASSERT_EQ(matrix.rows, 2);
+    EXPECT_FLOAT_EQ(matrix.row(0)[0], 1.0f);
+    EXPECT_FLOAT_EQ(matrix.row(1)[0], 2.0f);
+}
+
+TEST_F(EmbeddingStoreTest, AppendsInTheReserveKeepTheMapping) {
+    EmbeddingStore store;
+    ASSERT_TRUE(store.open(storeDir, "test-model", DIM));
+    ASSERT_TRUE(store.insert(photoA, vec(1.0f)));
+    const EmbeddingStore::Matrix before = store.matrix();
+    ASSERT_EQ(before.rows, 1);
+
+    // The first append doubled the file, so the next row is already mapped
+    ASSERT_TRUE(store.insert(photoB, vec(2.0f)));
+    const EmbeddingStore::Matrix after = store.matrix();
+    ASSERT_EQ(after.rows, 2);
+    EXPECT_EQ(after.mapping, before.mapping);
+    EXPECT_FLOAT_EQ(after.row(1)[0], 2.0f);
+
+    // The reserve is trimmed on close: only whole rows are left on disk
+    store.close();
+    EXPECT_EQ(QFileInfo(storeDir + "/embeddings.f32").size(), 64 + 2 * DIM * qint64(sizeof(float)));
+}
+
+TEST_F(EmbeddingStoreTest, MostlySupersededStoreIsCompactedOnOpen) {
+    const int versions = EmbeddingStore::COMPACT_MIN_STALE_ROWS + 1;
+    EmbeddingStore::Matrix held;
+    quint64 storeId = 0;
+    {
+        EmbeddingStore store;
+        ASSERT_TRUE(store.open(storeDir, "test-model", DIM));
+        ASSERT_TRUE(store.insert(photoB, vec(2.0f)));
+        for (int mtime = 1; mtime <= versions; ++mtime) {
+            ASSERT_TRUE(store.insert(photoA, mtime, 100, vec(float(mtime))));
+        }
+        EXPECT_EQ(store.rowCount(), versions + 1);
+        held = store.matrix();
+        storeId = store.storeId();
+    }
+
+    EmbeddingStore store;
+    ASSERT_TRUE(store.open(storeDir, "test-model", DIM));
+    EXPECT_EQ(store.rowCount(), 2);
+    EXPECT_EQ(store.liveCount(), 2);
+    EXPECT_NE(store.storeId(), storeId) << "Row numbers changed, so derived indexes must rebuild";
+    EXPECT_EQ(*store.find(photoB), vec(2.0f));
+    const int a = store.idOf(photoA);
+    ASSERT_GE(a, 0);
+    EXPECT_EQ(store.keyOf(a).mtime, versions);
+    EXPECT_FLOAT_EQ(store.matrix().row(a)[0], float(versions));
+
+    // A Matrix taken before keeps the old rows readable
+    ASSERT_EQ(held.rows, versions + 1);
+    EXPECT_FLOAT_EQ(held.row(versions)[0], float(versions));
+}
@@ -0,0 +1,260 @@
+#include <gtest/gtest.h>
+#include "core/ExifFastReader.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QImage>
+#include <QtEndian>
+
+using namespace PhotoGuru;
+
+namespace {
+
+struct TiffTag {
+    quint16 tag;
+    quint16 type;
+    quint32 count;
+    QByteArray value;  // Already in the file's byte order
+};
+
+// IFD0 plus optional EXIF and GPS IFDs, values after the IFDs
+class TiffBuilder {
+public:
+    explicit TiffBuilder(bool little) : m_little(little) {}
+
+    QByteArray u16(quint16 v) const {
+        QByteArray b(2, '\0');
+        if (m_little) qToLittleEndian(v, b.data()); else qToBigEndian(v, b.data());
+        return b;
+    }
+    QByteArray u32(quint32 v) const {
+        QByteArray b(4, '\0');
+        if (m_little) qToLittleEndian(v, b.data()); else qToBigEndian(v, b.data());
+        return b;
+    }
+
+    TiffTag ascii(quint16 tag, const QByteArray& text) const {
+        return {tag, 2, quint32(text.size() + 1), text + '\0'};
+    }
+    TiffTag shortValue(quint16 tag, quint16 v) const { return {tag, 3, 1, u16(v)}; }
+    TiffTag rationals(quint16 tag, const QList<QPair<quint32, quint32>>& values, bool isSigned = false) const {
+        QByteArray bytes;
+        for (const auto& [num, den] : values) bytes += u32(num) + u32(den);
+        return {tag, quint16(isSigned ? 10 : 5), quint32(values.size()), bytes};
+    }
+    TiffTag undefined(quint16 tag, const QByteArray& bytes) const {
+        return {tag, 7, quint32(bytes.size()), bytes};
+    }
+
+    QByteArray build(QList<TiffTag> ifd0, const QList<TiffTag>& exif = {}, const QList<TiffTag>& gps = {}) const {
+        auto ifdSize = [](int entries) { return quint32(2 + 12 * entries + 4); };
+        const int ifd0Entries = int(ifd0.size()) + (exif.isEmpty() ? 0 : 1) + (gps.isEmpty() ? 0 : 1);
+        const quint32 exifAt = 8 + ifdSize(ifd0Entries);
+        const quint32 gpsAt = exifAt + (exif.isEmpty() ? 0 : ifdSize(int(exif.size())));
+        const quint32 dataAt = gpsAt + (gps.isEmpty() ? 0 : ifdSize(int(gps.size())));
+        if (!exif.isEmpty()) ifd0 << TiffTag{0x8769, 4, 1, u32(exifAt)};
+        if (!gps.isEmpty()) ifd0 << TiffTag{0x8825, 4, 1, u32(gpsAt)};
+
+        QByteArray out = m_little ? QByteArray("II*\0", 4) : QByteArray("MM\0*", 4);
+        out += u32(8);
+        QByteArray data;
+        auto writeIfd = [&](const QList<TiffTag>& tags) {
+            out += u16(quint16(tags.size()));
+            for (const TiffTag& t : tags) {
+                out += u16(t.tag) + u16(t.type) + u32(t.count);
+                if (t.value.size() <= 4) {
+                    out += t.value + QByteArray(4 - t.value.size(), '\0');
+                } else {
+                    out += u32(dataAt + quint32(data.size()));
+                    data += t.value;
+                    if (data.size() % 2) data += '\0';
+                }
+            }
+            out += u32(0);
+        };
+        writeIfd(ifd0);
+        if (!exif.isEmpty()) writeIfd(exif);
+        if (!gps.isEmpty()) writeIfd(gps);
+        return out + data;
+    }
+
+private:
+    bool m_little;
+};
+
+QByteArray be16(quint16 v) { QByteArray b(2, '\0'); qToBigEndian(v, b.data()); return b; }
+QByteArray be32(quint32 v) { QByteArray b(4, '\0'); qToBigEndian(v, b.data()); return b; }
+
+QByteArray jpegSegment(uchar marker, const QByteArray& payload) {
+    return QByteArray("\xFF", 1) + char(marker) + be16(quint16(payload.size() + 2)) + payload;
+}
+
+QByteArray jpeg(const QByteArray& tiff, const QByteArray& xmp = QByteArray(), const QByteArray& iptc = QByteArray()) {
+    QByteArray out("\xFF\xD8", 2);
+    out += jpegSegment(0xE0, QByteArray("JFIF\0\x01\x01\0\0\x01\0\x01\0\0", 14));
+    if (!tiff.isEmpty()) out += jpegSegment(0xE1, QByteArray("Exif\0\0", 6) + tiff);
+    if (!xmp.isEmpty()) out += jpegSegment(0xE1, QByteArray("http://ns.adobe.com/xap/1.0/\0", 29) + xmp);
+    if (!iptc.isEmpty()) out += jpegSegment(0xED, QByteArray("Photoshop 3.0\0", 14) + iptc);
+    out += jpegSegment(0xDA, QByteArray(10, '\0'));
+    out += QByteArray("\xFF\xD9", 2);
+    return out;
+}
+
+QByteArray box(const char* type, const QByteArray& body) {
+    return be32(quint32(body.size() + 8)) + QByteArray(type, 4) + body;
+}
+
+// ftyp, a meta box with one Exif item, and the item's data in mdat
+QByteArray heic(const QByteArray& tiff) {
+    const QByteArray ftyp = box("ftyp", QByteArray("heic") + be32(0) + "mif1" + "heic");
+    const QByteArray infe = box("infe", QByteArray("\x02\0\0\0", 4) + be16(1) + be16(0) + "Exif" + '\0');
+    const QByteArray iinf = box("iinf", QByteArray(4, '\0') + be16(1) + infe);
+    const QByteArray payload = be32(6) + QByteArray("Exif\0\0", 6) + tiff;
+
+    auto iloc = [&](quint32 offset) {
+        return box("iloc", QByteArray(4, '\0') + char(0x44) + char(0x00) + be16(1) +
+                           be16(1) + be16(0) + be16(1) + be32(offset) + be32(quint32(payload.size())));
+    };
+    const QByteArray hdlr = box("hdlr", QByteArray(8, '\0') + "pict" + QByteArray(13, '\0'));
+    auto meta = [&](quint32 offset) { return box("meta", QByteArray(4, '\0') + hdlr + iinf + iloc(offset)); };
+
+    const int metaSize = int(meta(0).size());
+    const quint32 offset = quint32(ftyp.size() + metaSize + 8);
+    return ftyp + meta(offset) + box("mdat", payload);
+}
+
+const QByteArray XMP_PACKET =
+    "<?xpacket begin=\"\xEF\xBB\xBF\" id=\"W5M0MpCehiHzreSzNTczkc9d\"?>"
+    "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\">"
+    "<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">"
+    "<rdf:Description rdf:about=\"\" xmlns:xmp=\"http://ns.adobe.com/xap/1.0/\""
+    " xmlns:dc=\"http://purl.org/dc/elements/1.1/\""
+    " xmlns:photoshop=\"http://ns.adobe.com/photoshop/1.0/\""
+    " xmp:Rating=\"4\" photoshop:City=\"Lisboa\" photoshop:Country=\"Portugal\">"
+    "<photoshop:Category>Travel</photoshop:Category>"
+    "<dc:title><rdf:Alt><rdf:li xml:lang=\"pt\">Rio</rdf:li>"
+    "<rdf:li xml:lang=\"x-default\">River &amp; bridge</rdf:li></rdf:Alt></dc:title>"
+    "<dc:description><rdf:Alt><rdf:li xml:lang=\"x-default\">Sunset over the Tagus</rdf:li></rdf:Alt></dc:description>"
+    "<dc:subject><rdf:Bag><rdf:li>sunset</rdf:li><rdf:li>bridge</rdf:li></rdf:Bag></dc:subject>"
+    "</rdf:Description></rdf:RDF></x:xmpmeta>"
+    "<?xpacket end=\"w\"?>";
+
+} // namespace
+
+class ExifFastReaderTest : public ::testing::Test {
+protected:
+    QByteArray cameraTiff(bool little) const {
+        TiffBuilder t(little);
+        return t.build(
+            {t.ascii(0x010F, "Canon"), t.ascii(0x0110, "Canon EOS R5")},
+            {t.rationals(0x829D, {{28, 10}}),                       // f/2.8
+             t.shortValue(0x8827, 400),
+             t.ascii(0x9003, "2023:07:14 18:30:05"),
+             t.ascii(0x9291, "42"),
+             t.rationals(0x9201, {{8, 1}}, true),                  // 1/256 s
+             t.rationals(0x920A, {{50, 1}}),
+             t.undefined(0x9286, QByteArray("ASCII\0\0\0", 8) +
+                         "PhotoGuru:{\"sharp\":0.9,\"qual\":0.75,\"faces\":2}")},
+            {t.ascii(1, "S"), t.rationals(2, {{33, 1}, {52, 1}, {3600, 100}}),
+             t.ascii(3, "W"), t.rationals(4, {{151, 1}, {12, 1}, {0, 1}})});
+    }
+
+    static void expectCameraFields(const PhotoMetadata& meta) {
+        EXPECT_EQ(meta.camera_make, "Canon");
+        EXPECT_EQ(meta.camera_model, "Canon EOS R5");
+        EXPECT_DOUBLE_EQ(meta.aperture, 2.8);
+        EXPECT_EQ(meta.iso, 400);
+        EXPECT_DOUBLE_EQ(meta.shutter_speed, 1.0 / 256.0);
+        EXPECT_DOUBLE_EQ(meta.focal_length, 50.0);
+        EXPECT_EQ(meta.datetime_original, QDateTime(QDate(2023, 7, 14), QTime(18, 30, 5, 420)));
+        EXPECT_NEAR(meta.gps_lat, -(33 + 52 / 60.0 + 36 / 3600.0), 1e-9);
+        EXPECT_NEAR(meta.gps_lon, -(151 + 12 / 60.0), 1e-9);
+        EXPECT_DOUBLE_EQ(meta.technical.sharpness_score, 0.9);
+        EXPECT_DOUBLE_EQ(meta.technical.overall_quality, 0.75);
+        EXPECT_EQ(meta.technical.face_count, 2);
+    }
+};
+
+TEST_F(ExifFastReaderTest, JpegExifAndXmp) {
+    auto meta = ExifFastReader::parse(jpeg(cameraTiff(true), XMP_PACKET), "/photos/IMG_0001.jpg");
+    ASSERT_TRUE(meta.has_value());
+    EXPECT_EQ(meta->filepath, "/photos/IMG_0001.jpg");
+    EXPECT_EQ(meta->filename, "IMG_0001.jpg");
+    expectCameraFields(*meta);
+
+    EXPECT_EQ(meta->rating, 4);
+    EXPECT_EQ(meta->llm_title, "River & bridge") << "x-default wins over the first alternative";
+    EXPECT_EQ(meta->llm_description, "Sunset over the Tagus");
+    EXPECT_EQ(meta->llm_keywords, (QStringList{"sunset", "bridge"}));
+    EXPECT_EQ(meta->llm_category, "Travel");
+    EXPECT_EQ(meta->location_name, "Lisboa, Portugal");
+    EXPECT_TRUE(meta->hasPhotoGuruMetadata());
+}
+
+TEST_F(ExifFastReaderTest, BigEndianTiffRaw) {
+    // NEF, CR2, DNG and ARW are TIFF files; Nikon's are big-endian
+    auto meta = ExifFastReader::parse(cameraTiff(false), "/photos/DSC_0001.NEF");
+    ASSERT_TRUE(meta.has_value());
+    expectCameraFields(*meta);
+    EXPECT_EQ(meta->rating, 0);
+}
+
+TEST_F(ExifFastReaderTest, TiffRatingAndEmbeddedXmp) {
+    TiffBuilder t(true);
+    auto meta = ExifFastReader::parse(t.build({t.shortValue(0x4746, 3)}), "/photos/a.dng");
+    ASSERT_TRUE(meta.has_value());
+    EXPECT_EQ(meta->rating, 3) << "EXIF rating when there is no XMP one";
+
+    meta = ExifFastReader::parse(t.build({t.shortValue(0x4746, 3), {0x02BC, 1, quint32(XMP_PACKET.size()), XMP_PACKET}}),
+                                 "/photos/a.dng");
+    ASSERT_TRUE(meta.has_value());
+    EXPECT_EQ(meta->rating, 4);
+    EXPECT_EQ(meta->llm_keywords.size(), 2);
+}
+
+TEST_F(ExifFastReaderTest, HeicExifItem) {
+    auto meta = ExifFastReader::parse(heic(cameraTiff(false)), "/photos/IMG_0002.HEIC");
+    ASSERT_TRUE(meta.has_value());
+    expectCameraFields(*meta);
+}
+
+TEST_F(ExifFastReaderTest, LeavesTheRestToExifTool) {
+    // Unknown containers
+    EXPECT_FALSE(ExifFastReader::parse(QByteArray("\x89PNG\r\n\x1a\n0000000000", 18), "/p/a.png").has_value());
+    EXPECT_FALSE(ExifFastReader::parse(QByteArray(), "/p/empty.jpg").has_value());
+    EXPECT_FALSE(ExifFastReader::parse(box("ftyp", QByteArray("qt  ") + be32(0)), "/p/a.mov").has_value());
+
+    // IPTC without XMP: only ExifTool reads those keywords and captions
+    EXPECT_FALSE(ExifFastReader::parse(jpeg(cameraTiff(true), QByteArray(), QByteArray(16, '\0')), "/p/b.jpg").has_value());
+    EXPECT_TRUE(ExifFastReader::parse(jpeg(cameraTiff(true), XMP_PACKET, QByteArray(16, '\0')), "/p/b.jpg").has_value());
+
+    // EXIF IFD pointing past the end
+    QByteArray broken = cameraTiff(true);
+    broken.truncate(broken.size() / 2);
+    EXPECT_FALSE(ExifFastReader::parse(jpeg(broken), "/p/c.jpg").has_value());
+}
+
+TEST_F(ExifFastReaderTest, ReadsMappedFile) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    // Qt writes no EXIF: the file is still read, with nothing but its name
+    const QString plain = dir.filePath("plain.jpg");
+    QImage image(16, 16, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    ASSERT_TRUE(image.save(plain, "JPEG"));
+    auto meta = ExifFastReader::read(plain);
+    ASSERT_TRUE(meta.has_value());
+    EXPECT_EQ(meta->filename, "plain.jpg");
+    EXPECT_FALSE(meta->datetime_original.isValid());
+
+    const QString tagged = dir.filePath("tagged.jpg");
+    QFile file(tagged);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write(jpeg(cameraTiff(true), XMP_PACKET));
+    file.close();
+    meta = ExifFastReader::read(tagged);
+    ASSERT_TRUE(meta.has_value());
+    expectCameraFields(*meta);
+
+    EXPECT_FALSE(ExifFastReader::read(dir.filePath("missing.jpg")).has_value());
+}
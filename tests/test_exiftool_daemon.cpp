@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "core/ExifToolDaemon.h"
 #include <QFile>
+#include <QFileInfo>
 #include <QTemporaryDir>
 #include <QImage>
 #include <QThread>
@@ -284,3 +285,79 @@ TEST_F(ExifToolDaemonTest, RapidStartStop) {
     
     SUCCEED() << "Handled rapid start/stop cycles";
 }
+
+TEST_F(ExifToolDaemonTest, PoolSizeIsBounded) {
+    ExifToolDaemon& daemon = ExifToolDaemon::instance();
+    int original = daemon.poolSize();
+    
+    EXPECT_GE(original, 1) << "Default pool should have at least one process";
+    
+    daemon.setPoolSize(0);
+    EXPECT_EQ(daemon.poolSize(), 1) << "Pool size should be clamped to 1";
+    
+    daemon.setPoolSize(1000);
+    EXPECT_LE(daemon.poolSize(), 8) << "Pool size should be capped";
+    
+    daemon.setPoolSize(original);
+}
+
+TEST_F(ExifToolDaemonTest, ConcurrentReadsDoNotMixResponses) {
+    ExifToolDaemon& daemon = ExifToolDaemon::instance();
+    daemon.setPoolSize(4);
+    ASSERT_TRUE(daemon.start());
+    
+    // One distinct file per thread
+    const int numThreads = 4;
+    QStringList paths;
+    for (int i = 0; i < numThreads; i++) {
+        QString path = tempDir->path() + QString("/pool_%1.jpg").arg(i);
+        QImage img(40, 40, QImage::Format_RGB32);
+        img.fill(Qt::green);
+        ASSERT_TRUE(img.save(path, "JPEG"));
+        paths << path;
+    }
+    
+    QVector<QThread*> threads;
+    for (int i = 0; i < numThreads; i++) {
+        QString path = paths[i];
+        QThread* thread = QThread::create([&daemon, path]() {
+            for (int j = 0; j < 5; j++) {
+                QString result = daemon.executeCommand({"-json", "-FileName", path});
+                EXPECT_TRUE(result.contains(QFileInfo(path).fileName()))
+                    << "Response should belong to " << path.toStdString();
+            }
+        });
+        threads.append(thread);
+        thread->start();
+    }
+    
+    for (QThread* thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+    
+    daemon.setPoolSize(QThread::idealThreadCount());
+}
+
+TEST_F(ExifToolDaemonTest, PipelinedBatchKeepsResponsesInOrder) {
+    ExifToolDaemon& daemon = ExifToolDaemon::instance();
+    ASSERT_TRUE(daemon.start());
+    
+    QStringList paths;
+    QStringList commands;
+    for (int i = 0; i < 6; i++) {
+        QString path = tempDir->path() + QString("/pipeline_%1.jpg").arg(i);
+        QImage img(30, 30, QImage::Format_RGB32);
+        img.fill(Qt::yellow);
+        ASSERT_TRUE(img.save(path, "JPEG"));
+        paths << path;
+        commands << QString("-FileName\n-s3\n%1").arg(path);
+    }
+    
+    QStringList results = daemon.executeBatch(commands);
+    ASSERT_EQ(results.size(), paths.size());
+    for (int i = 0; i < paths.size(); i++) {
+        EXPECT_EQ(results[i], QFileInfo(paths[i]).fileName())
+            << "Response " << i << " should match its own command";
+    }
+}
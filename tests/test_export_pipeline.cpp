@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include "core/ExportPipeline.h"
+#include <QDir>
+#include <QFile>
+#include <QImageReader>
+#include <QMutex>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+#include <atomic>
+
+using namespace PhotoGuru;
+
+class ExportPipelineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(dir.isValid());
+        ASSERT_TRUE(QDir().mkpath(dir.filePath("in")));
+        options.directory = dir.filePath("out");
+        options.longEdge = 400;
+    }
+
+    QString writeImage(const QString& name, const QSize& size = QSize(800, 600)) {
+        QImage image(size, QImage::Format_RGB32);
+        image.fill(Qt::darkGreen);
+        const QString path = dir.filePath("in/" + name);
+        EXPECT_TRUE(image.save(path, "PNG"));
+        return path;
+    }
+
+    // The real decode and encode; metadata copies only recorded (no ExifTool needed)
+    ExportPipeline::Stages stages() {
+        ExportPipeline::Stages stages = ExportPipeline::defaultStages();
+        stages.copyMetadata = [this](const QString& source, const QString& target) {
+            QMutexLocker locker(&mutex);
+            copied << source + " -> " + target;
+            return true;
+        };
+        return stages;
+    }
+
+    // Runs to the end; finished()'s arguments
+    QList<QVariant> run(ExportPipeline& exporter, const QStringList& files) {
+        QSignalSpy finished(&exporter, &ExportPipeline::finished);
+        EXPECT_TRUE(exporter.start(files, options));
+        EXPECT_TRUE(QTest::qWaitFor([&]() { return finished.count() > 0; }, 10000));
+        exporter.wait();
+        EXPECT_FALSE(exporter.isRunning());
+        return finished.isEmpty() ? QList<QVariant>() : finished.takeFirst();
+    }
+
+    QTemporaryDir dir;
+    ExportPipeline::Options options;
+    QMutex mutex;
+    QStringList copied;
+};
+
+TEST_F(ExportPipelineTest, ResizesDownToTheLongEdge) {
+    QImage landscape(4000, 3000, QImage::Format_RGB32);
+    EXPECT_EQ(ExportPipeline::resize(landscape, 2048).size(), QSize(2048, 1536));
+    QImage portrait(3000, 4000, QImage::Format_RGB32);
+    EXPECT_EQ(ExportPipeline::resize(portrait, 1000).size(), QSize(750, 1000));
+
+    // Never up, and 0 keeps the full size
+    EXPECT_EQ(ExportPipeline::resize(landscape, 8000).size(), landscape.size());
+    EXPECT_EQ(ExportPipeline::resize(landscape, 0).size(), landscape.size());
+}
+
+TEST_F(ExportPipelineTest, NamesTargetsUniquely) {
+    QDir().mkpath(options.directory);
+    QFile existing(options.directory + "/beach.jpg");
+    ASSERT_TRUE(existing.open(QIODevice::WriteOnly));
+    existing.close();
+
+    const QStringList targets = ExportPipeline::targetPaths(
+        {"/a/beach.png", "/b/beach.CR2", "/a/forest.heic", "/a/city.v2.jpg"}, options.directory, "jpg");
+    const QDir out(options.directory);
+    EXPECT_EQ(targets, QStringList({out.filePath("beach-1.jpg"), out.filePath("beach-2.jpg"),
+                                    out.filePath("forest.jpg"), out.filePath("city.v2.jpg")}));
+}
+
+TEST_F(ExportPipelineTest, ExportsResizedFilesWithTheirMetadata) {
+    const QStringList files{writeImage("a.png"), writeImage("b.png", QSize(300, 200)), writeImage("c.png")};
+    ExportPipeline exporter(stages());
+    QSignalSpy progress(&exporter, &ExportPipeline::progress);
+
+    const QList<QVariant> result = run(exporter, files);
+    ASSERT_EQ(result.size(), 3);
+    EXPECT_EQ(result[0].toInt(), 3);
+    EXPECT_EQ(result[1].toInt(), 0);
+    EXPECT_FALSE(result[2].toBool());
+    EXPECT_EQ(progress.count(), 3);
+
+    const QDir out(options.directory);
+    EXPECT_EQ(QImageReader(out.filePath("a.jpg")).size(), QSize(400, 300));
+    EXPECT_EQ(QImageReader(out.filePath("b.jpg")).size(), QSize(300, 200)) << "Not upscaled";
+    EXPECT_EQ(QImageReader(out.filePath("c.jpg")).format(), "jpeg");
+
+    copied.sort();
+    EXPECT_EQ(copied, QStringList({files[0] + " -> " + out.filePath("a.jpg"),
+                                   files[1] + " -> " + out.filePath("b.jpg"),
+                                   files[2] + " -> " + out.filePath("c.jpg")}));
+}
+
+TEST_F(ExportPipelineTest, CountsFailuresAndLeavesNoPartialFiles) {
+    QFile broken(dir.filePath("in/broken.png"));
+    ASSERT_TRUE(broken.open(QIODevice::WriteOnly));
+    broken.write("not an image");
+    broken.close();
+
+    ExportPipeline exporter(stages());
+    options.copyMetadata = false;
+    const QList<QVariant> result = run(exporter, {writeImage("good.png"), broken.fileName()});
+    ASSERT_EQ(result.size(), 3);
+    EXPECT_EQ(result[0].toInt(), 1);
+    EXPECT_EQ(result[1].toInt(), 1);
+    EXPECT_TRUE(copied.isEmpty());
+    EXPECT_TRUE(QFile::exists(options.directory + "/good.jpg"));
+    EXPECT_FALSE(QFile::exists(options.directory + "/broken.jpg"));
+}
+
+TEST_F(ExportPipelineTest, BoundsFilesInFlightAndCancels) {
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    ExportPipeline::Stages slow = stages();
+    slow.decode = [&](const QString&, const QSize&) {
+        const int now = ++running;
+        int seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+        QThread::msleep(20);
+        --running;
+        QImage image(64, 48, QImage::Format_RGB32);
+        image.fill(Qt::white);
+        return image;
+    };
+
+    QStringList files;
+    for (int i = 0; i < 6; ++i) files << dir.filePath(QString("in/%1.png").arg(i));
+    options.jobs = 2;
+    ExportPipeline bounded(slow);
+    QList<QVariant> result = run(bounded, files);
+    ASSERT_EQ(result.size(), 3);
+    EXPECT_EQ(result[0].toInt(), 6);
+    EXPECT_LE(peak.load(), 2);
+
+    // Cancelled: the files not started are dropped, and finished() still comes
+    files.clear();
+    for (int i = 0; i < 40; ++i) files << dir.filePath(QString("in/%1.png").arg(i));
+    options.directory = dir.filePath("cancelled");
+    options.jobs = 1;
+    ExportPipeline cancelled(slow);
+    QSignalSpy finished(&cancelled, &ExportPipeline::finished);
+    ASSERT_TRUE(cancelled.start(files, options));
+    EXPECT_FALSE(cancelled.start(files, options)) << "One run at a time";
+    cancelled.cancel();
+    EXPECT_TRUE(QTest::qWaitFor([&]() { return finished.count() > 0; }, 10000));
+    cancelled.wait();
+    result = finished.takeFirst();
+    EXPECT_LT(result[0].toInt(), 40);
+    EXPECT_TRUE(result[2].toBool());
+}
+
+TEST_F(ExportPipelineTest, RejectsWhatItCannotExport) {
+    ExportPipeline exporter(stages());
+    const QStringList files{writeImage("a.png")};
+    EXPECT_FALSE(exporter.start({}, options));
+
+    options.format = "bmp";
+    EXPECT_FALSE(exporter.start(files, options));
+
+    options.format = "jpg";
+    options.directory.clear();
+    EXPECT_FALSE(exporter.start(files, options));
+
+    EXPECT_TRUE(ExportPipeline::supportedFormats().contains("jpg"));
+}
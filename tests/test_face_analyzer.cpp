@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "ml/FaceAnalyzer.h"
+#include <vector>
+
+using namespace PhotoGuru;
+
+namespace {
+
+// Where ArcFace's crops put the landmarks (see FaceAnalyzer.cpp)
+const std::array<QPointF, 5> TEMPLATE = {
+    QPointF(38.2946, 51.6963), QPointF(73.5318, 51.5014), QPointF(56.0252, 71.7366),
+    QPointF(41.5493, 92.3655), QPointF(70.7299, 92.2041),
+};
+
+constexpr int CHANNELS = 5 + 15;
+
+// One detector output, channel-major: set(anchor, channel, value)
+struct Output {
+    explicit Output(int anchors) : anchors(anchors), data(size_t(CHANNELS) * anchors, 0.0f) {}
+    void face(int anchor, float cx, float cy, float w, float h, float score) {
+        set(anchor, 0, cx);
+        set(anchor, 1, cy);
+        set(anchor, 2, w);
+        set(anchor, 3, h);
+        set(anchor, 4, score);
+        for (int k = 0; k < 5; ++k) {
+            set(anchor, 5 + 3 * k, cx + k);
+            set(anchor, 6 + 3 * k, cy - k);
+        }
+    }
+    void set(int anchor, int channel, float value) { data[size_t(channel) * anchors + anchor] = value; }
+    int anchors;
+    std::vector<float> data;
+};
+
+FaceAnalyzer::Face faceAt(double x, double y, double edge, float score) {
+    FaceAnalyzer::Face face;
+    face.box = QRectF(x, y, edge, edge);
+    face.score = score;
+    return face;
+}
+
+} // namespace
+
+TEST(FaceAnalyzerTest, DecodesDetectionsAboveThreshold) {
+    Output output(4);
+    output.face(0, 100, 80, 40, 50, 0.6f);
+    output.face(1, 10, 10, 5, 5, 0.2f);  // Below threshold
+    output.face(3, 300, 200, 20, 20, 0.9f);
+
+    std::vector<FaceAnalyzer::Face> faces = FaceAnalyzer::decodeDetections(output.data.data(), 4, 0.5f);
+    ASSERT_EQ(faces.size(), 2u);
+
+    // Best first
+    EXPECT_FLOAT_EQ(faces[0].score, 0.9f);
+    EXPECT_EQ(faces[0].box, QRectF(290, 190, 20, 20));
+    EXPECT_FLOAT_EQ(faces[1].score, 0.6f);
+    EXPECT_EQ(faces[1].box, QRectF(80, 55, 40, 50));
+    EXPECT_EQ(faces[1].landmarks[0], QPointF(100, 80));
+    EXPECT_EQ(faces[1].landmarks[4], QPointF(104, 76));
+}
+
+TEST(FaceAnalyzerTest, SuppressesOverlapsAndCapsCount) {
+    std::vector<FaceAnalyzer::Face> faces = {
+        faceAt(0, 0, 100, 0.7f),
+        faceAt(5, 5, 100, 0.9f),     // Same face, scored higher
+        faceAt(500, 500, 50, 0.8f),
+        faceAt(900, 0, 50, 0.6f),
+    };
+
+    std::vector<FaceAnalyzer::Face> kept = FaceAnalyzer::suppress(faces, 0.4f, 32);
+    ASSERT_EQ(kept.size(), 3u);
+    EXPECT_FLOAT_EQ(kept[0].score, 0.9f);
+    EXPECT_FLOAT_EQ(kept[1].score, 0.8f);
+    EXPECT_FLOAT_EQ(kept[2].score, 0.6f);
+
+    EXPECT_EQ(FaceAnalyzer::suppress(faces, 0.4f, 2).size(), 2u);
+}
+
+TEST(FaceAnalyzerTest, AlignmentFitsLandmarksToTemplate) {
+    // The template itself needs no warp
+    QTransform identity = FaceAnalyzer::alignment(TEMPLATE, QRectF());
+    for (const QPointF& point : TEMPLATE) {
+        QPointF mapped = identity.map(point);
+        EXPECT_NEAR(mapped.x(), point.x(), 1e-6);
+        EXPECT_NEAR(mapped.y(), point.y(), 1e-6);
+    }
+
+    // A face three times as large, turned a quarter and moved, lands on it too
+    std::array<QPointF, 5> landmarks;
+    for (size_t k = 0; k < 5; ++k) {
+        landmarks[k] = QPointF(400 - 3 * TEMPLATE[k].y(), 250 + 3 * TEMPLATE[k].x());
+    }
+    QTransform aligned = FaceAnalyzer::alignment(landmarks, QRectF());
+    for (size_t k = 0; k < 5; ++k) {
+        QPointF mapped = aligned.map(landmarks[k]);
+        EXPECT_NEAR(mapped.x(), TEMPLATE[k].x(), 1e-6);
+        EXPECT_NEAR(mapped.y(), TEMPLATE[k].y(), 1e-6);
+    }
+}
+
+TEST(FaceAnalyzerTest, AlignmentFallsBackToTheBox) {
+    // Landmarks all in one place: the box fills the crop
+    std::array<QPointF, 5> collapsed;
+    collapsed.fill(QPointF(10, 10));
+    QTransform transform = FaceAnalyzer::alignment(collapsed, QRectF(100, 200, 56, 56));
+
+    EXPECT_EQ(transform.map(QPointF(128, 228)), QPointF(56, 56));
+    EXPECT_EQ(transform.map(QPointF(100, 200)), QPointF(0, 0));
+}
+
+TEST(FaceAnalyzerTest, AnalyzeWithoutModelsFails) {
+    FaceAnalyzer analyzer;
+    EXPECT_FALSE(analyzer.isInitialized());
+    EXPECT_TRUE(analyzer.analyze({QImage(64, 64, QImage::Format_RGB32)}).empty());
+    EXPECT_FALSE(analyzer.lastError().isEmpty());
+}
+
+TEST(FaceAnalyzerTest, BatchSizeIsClamped) {
+    FaceAnalyzer analyzer;
+    EXPECT_EQ(analyzer.batchSize(), FaceAnalyzer::DEFAULT_BATCH_SIZE);
+    analyzer.setBatchSize(0);
+    EXPECT_EQ(analyzer.batchSize(), 1);
+    analyzer.setBatchSize(1000);
+    EXPECT_EQ(analyzer.batchSize(), FaceAnalyzer::MAX_BATCH_SIZE);
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QSignalSpy>
+#include <QMutex>
+#include "ml/FaceIndexer.h"
+#include <cmath>
+
+using namespace PhotoGuru;
+
+class FaceIndexerTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    // Unit vector along `axis`, nudged towards `towards` by `amount`
+    static std::vector<float> direction(int axis, int towards = 0, float amount = 0.0f) {
+        std::vector<float> v(4, 0.0f);
+        v[size_t(axis)] = 1.0f;
+        v[size_t(towards)] += amount;
+        float norm = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3]);
+        for (float& x : v) x /= norm;
+        return v;
+    }
+
+    // One face per image; "bad" files fail to decode; "a" is already scanned
+    FaceIndexer::Stages fakeStages() {
+        FaceIndexer::Stages stages;
+        stages.decode = [this](const QString& path) {
+            QMutexLocker lock(&mutex);
+            decoded << path;
+            return path.startsWith("bad") ? QImage() : QImage(8, 8, QImage::Format_RGB32);
+        };
+        stages.analyze = [](const std::vector<QImage>& images) {
+            std::vector<std::vector<FaceAnalyzer::Face>> faces(images.size());
+            for (auto& found : faces) found.push_back(FaceAnalyzer::Face{QRectF(0.1, 0.1, 0.5, 0.5), 0.9f, {}, {}});
+            return faces;
+        };
+        stages.scanned = [](const QStringList& paths) {
+            QSet<QString> result;
+            if (paths.contains("a")) result.insert("a");
+            return result;
+        };
+        stages.store = [this](const QString& path, const std::vector<FaceAnalyzer::Face>& faces) {
+            QMutexLocker lock(&mutex);
+            stored.insert(path, int(faces.size()));
+            return true;
+        };
+        stages.cluster = [this]() {
+            clustered = true;
+            return QStringList{"b"};
+        };
+        stages.write = [this](const QStringList& paths) { written = paths; };
+        return stages;
+    }
+
+    QMutex mutex;
+    QStringList decoded;
+    QHash<QString, int> stored;
+    bool clustered = false;
+    QStringList written;
+};
+
+TEST_F(FaceIndexerTest, AssignsFacesToNearestPerson) {
+    std::vector<PhotoDatabase::Person> people;
+    std::vector<std::vector<float>> embeddings = {
+        direction(0), direction(1), direction(0, 2, 0.2f), direction(1, 3, 0.1f), direction(2),
+    };
+
+    std::vector<int> assigned = FaceIndexer::assignPeople(people, embeddings, 0.5f);
+    ASSERT_EQ(people.size(), 3u);
+    EXPECT_EQ(assigned, std::vector<int>({0, 1, 0, 1, 2}));
+    EXPECT_EQ(people[0].faces, 2);
+    EXPECT_EQ(people[2].faces, 1);
+    EXPECT_EQ(people[0].id, 0) << "New people have no catalog id yet";
+
+    // The centroid moved towards its second face and stays unit length
+    float norm = 0.0f;
+    for (float x : people[0].centroid) norm += x * x;
+    EXPECT_NEAR(norm, 1.0f, 1e-5f);
+    EXPECT_GT(people[0].centroid[2], 0.0f);
+}
+
+TEST_F(FaceIndexerTest, JoinsExistingPeopleAndSkipsOtherDimensions) {
+    std::vector<PhotoDatabase::Person> people = {
+        PhotoDatabase::Person{7, direction(3), 10},
+    };
+    std::vector<std::vector<float>> embeddings = {
+        direction(3, 0, 0.1f), {1.0f, 0.0f}, direction(0),
+    };
+
+    std::vector<int> assigned = FaceIndexer::assignPeople(people, embeddings, 0.5f);
+    EXPECT_EQ(assigned, std::vector<int>({0, -1, 1}));
+    EXPECT_EQ(people[0].id, 7);
+    EXPECT_EQ(people[0].faces, 11);
+    ASSERT_EQ(people.size(), 2u);
+}
+
+TEST_F(FaceIndexerTest, ScansOnlyUnscannedFilesThenClusters) {
+    FaceIndexer indexer(fakeStages());
+    indexer.setBatchSize(2);
+    indexer.setDecodeThreads(2);
+    QSignalSpy finished(&indexer, &FaceIndexer::finished);
+
+    indexer.start({"a", "b", "bad", "c", "d"});
+    ASSERT_TRUE(finished.wait(5000));
+    indexer.wait();
+
+    QList<QVariant> result = finished.takeFirst();
+    EXPECT_EQ(result[0].toInt(), 3);  // b, c, d
+    EXPECT_EQ(result[1].toInt(), 3);
+    EXPECT_EQ(result[2].toInt(), 1);
+    EXPECT_FALSE(result[3].toBool());
+
+    EXPECT_FALSE(decoded.contains("a"));
+    EXPECT_TRUE(decoded.contains("bad"));
+    EXPECT_EQ(stored.size(), 3);
+    EXPECT_FALSE(stored.contains("bad"));
+    EXPECT_TRUE(clustered);
+    EXPECT_EQ(written, QStringList({"b"}));
+}
+
+TEST_F(FaceIndexerTest, CancelledRunDoesNotCluster) {
+    FaceIndexer::Stages stages = fakeStages();
+    stages.scanned = nullptr;
+    FaceIndexer indexer(std::move(stages));
+    QSignalSpy finished(&indexer, &FaceIndexer::finished);
+
+    QStringList files;
+    for (int i = 0; i < 2000; ++i) files << QString("f%1").arg(i);
+    indexer.start(files);
+    indexer.cancel();
+    ASSERT_TRUE(finished.wait(5000));
+    indexer.wait();
+
+    EXPECT_TRUE(finished.takeFirst()[3].toBool());
+    EXPECT_FALSE(clustered);
+    EXPECT_TRUE(written.isEmpty());
+}
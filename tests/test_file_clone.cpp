@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QFileInfo>
+#include "core/FileClone.h"
+
+using namespace PhotoGuru;
+
+namespace {
+
+void writeFile(const QString& path, const QByteArray& data) {
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write(data);
+}
+
+QByteArray readFile(const QString& path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+} // namespace
+
+TEST(FileCloneTest, CopiesContent) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString source = dir.filePath("a.jpg");
+    const QByteArray data(3 * 1024 * 1024 + 17, 'x');
+    writeFile(source, data);
+
+    const QString copy = dir.filePath("b.jpg");
+    std::optional<FileClone::Method> method = FileClone::copy(source, copy);
+    ASSERT_TRUE(method.has_value());
+    EXPECT_EQ(readFile(copy), data);
+
+    // A clone is a copy: changing it leaves the original alone
+    writeFile(copy, "changed");
+    EXPECT_EQ(readFile(source), data);
+}
+
+TEST(FileCloneTest, NeverOverwrites) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    writeFile(dir.filePath("a.jpg"), "new");
+    writeFile(dir.filePath("b.jpg"), "old");
+
+    EXPECT_FALSE(FileClone::copy(dir.filePath("a.jpg"), dir.filePath("b.jpg")).has_value());
+    EXPECT_EQ(readFile(dir.filePath("b.jpg")), "old");
+    EXPECT_FALSE(FileClone::copy(dir.filePath("missing.jpg"), dir.filePath("c.jpg")).has_value());
+    EXPECT_FALSE(QFileInfo::exists(dir.filePath("c.jpg"))) << "No empty file left behind";
+}
+
+TEST(FileCloneTest, MovesFiles) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    writeFile(dir.filePath("a.jpg"), "data");
+
+    EXPECT_TRUE(FileClone::move(dir.filePath("a.jpg"), dir.filePath("b.jpg")));
+    EXPECT_FALSE(QFileInfo::exists(dir.filePath("a.jpg")));
+    EXPECT_EQ(readFile(dir.filePath("b.jpg")), "data");
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDir>
+#include "core/FileFingerprint.h"
+#include "core/PhotoDatabase.h"
+
+using namespace PhotoGuru;
+
+class FileFingerprintTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_dir.isValid());
+        ASSERT_TRUE(PhotoDatabase::instance().initialize(m_dir.filePath("catalog.db")));
+    }
+
+    void TearDown() override {
+        PhotoDatabase::instance().close();
+    }
+
+    QString write(const QString& name, const QByteArray& contents) {
+        QString path = m_dir.filePath(name);
+        QFile file(path);
+        file.open(QIODevice::WriteOnly);
+        file.write(contents);
+        return path;
+    }
+
+    // Larger than both samples, so the middle isn't hashed by quick()
+    static QByteArray photo(char fill) {
+        return QByteArray(int(3 * FileFingerprint::SAMPLE_BYTES), fill);
+    }
+
+    QTemporaryDir m_dir;
+};
+
+TEST_F(FileFingerprintTest, IdenticalFilesMatch) {
+    QString a = write("a.jpg", photo('x'));
+    QString b = write("b.jpg", photo('x'));
+    QString c = write("c.jpg", photo('y'));
+
+    FileFingerprint& fingerprint = FileFingerprint::instance();
+    EXPECT_FALSE(fingerprint.quick(a).isEmpty());
+    EXPECT_EQ(fingerprint.quick(a), fingerprint.quick(b));
+    EXPECT_EQ(fingerprint.full(a), fingerprint.full(b));
+    EXPECT_NE(fingerprint.quick(a), fingerprint.quick(c));
+    EXPECT_TRUE(fingerprint.quick(m_dir.filePath("missing.jpg")).isEmpty());
+}
+
+TEST_F(FileFingerprintTest, QuickHashSamplesHeadAndTail) {
+    QByteArray head = photo('x');
+    head[10] = 'h';
+    QByteArray tail = photo('x');
+    tail[tail.size() - 10] = 't';
+    QByteArray middle = photo('x');
+    middle[middle.size() / 2] = 'm';
+
+    QByteArray original = FileFingerprint::computeQuick(write("original.jpg", photo('x')));
+    EXPECT_NE(FileFingerprint::computeQuick(write("head.jpg", head)), original);
+    EXPECT_NE(FileFingerprint::computeQuick(write("tail.jpg", tail)), original);
+
+    QString edited = write("middle.jpg", middle);
+    EXPECT_EQ(FileFingerprint::computeQuick(edited), original) << "Only the samples are read";
+    EXPECT_NE(FileFingerprint::computeFull(edited), FileFingerprint::computeFull(m_dir.filePath("original.jpg")));
+}
+
+TEST_F(FileFingerprintTest, MovedFileIsFoundUnderItsOldPath) {
+    QString before = write("before.jpg", photo('x'));
+    FileFingerprint::instance().quick(before);
+
+    QString after = m_dir.filePath("after.jpg");
+    ASSERT_TRUE(QFile::rename(before, after));
+
+    QList<PhotoDatabase::Fingerprint> seen = FileFingerprint::instance().sameContent(after);
+    ASSERT_EQ(seen.size(), 1);
+    EXPECT_EQ(seen.first().path, QFileInfo(before).absoluteFilePath());
+    EXPECT_EQ(seen.first().size, 3 * FileFingerprint::SAMPLE_BYTES);
+}
+
+TEST_F(FileFingerprintTest, ExactDuplicatesComparesWholeFiles) {
+    QByteArray middle = photo('x');
+    middle[middle.size() / 2] = 'm';
+    QString a = write("a.jpg", photo('x'));
+    QString b = write("b.jpg", photo('x'));
+    QString edited = write("edited.jpg", middle);
+    QString other = write("other.jpg", photo('y'));
+    QString small = write("small.jpg", QByteArray("x"));
+
+    QList<QStringList> groups = FileFingerprint::instance().exactDuplicates({a, b, edited, other, small});
+    ASSERT_EQ(groups.size(), 1);
+    QStringList group = groups.first();
+    group.sort();
+    EXPECT_EQ(group, QStringList({a, b}));
+}
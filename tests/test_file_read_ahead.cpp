@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "core/FileReadAhead.h"
+#include <QFile>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTest>
+#include <atomic>
+
+using namespace PhotoGuru;
+
+class FileReadAheadTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(dir.isValid());
+        readAhead.setMode(FileReadAhead::Mode::Always);  // Temp dirs are local
+    }
+
+    QString write(const QString& name, const QByteArray& contents) {
+        const QString path = dir.filePath(name);
+        QFile file(path);
+        EXPECT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(contents);
+        return path;
+    }
+
+    QTemporaryDir dir;
+    FileReadAhead readAhead;
+};
+
+TEST_F(FileReadAheadTest, ReadsWholeFilesAcrossBlocks) {
+    QByteArray contents(int(FileReadAhead::BLOCK_SIZE + 12345), Qt::Uninitialized);
+    for (int i = 0; i < contents.size(); ++i) contents[i] = char(i * 7);
+    const QString path = write("large.bin", contents);
+
+    EXPECT_FALSE(readAhead.isBuffered(path));
+    EXPECT_TRUE(readAhead.buffered(path).isNull()) << "Never reads";
+    EXPECT_FALSE(readAhead.isBuffered(path));
+    EXPECT_EQ(readAhead.read(path), contents);
+    EXPECT_TRUE(readAhead.isBuffered(path));
+    EXPECT_EQ(readAhead.buffered(path), contents);
+    EXPECT_GE(readAhead.usedBytes(), FileReadAhead::BLOCK_SIZE);
+
+    EXPECT_TRUE(readAhead.read(dir.filePath("missing.bin")).isNull());
+}
+
+TEST_F(FileReadAheadTest, ChangedFilesAreReadAgain) {
+    const QString path = write("a.bin", "first");
+    EXPECT_EQ(readAhead.read(path), "first");
+
+    write("a.bin", "second, longer");
+    EXPECT_EQ(readAhead.read(path), "second, longer");
+}
+
+TEST_F(FileReadAheadTest, LeavesFilesItDoesNotBuffer) {
+    const QString path = write("a.bin", "contents");
+
+    readAhead.setMaxFileBytes(4);
+    EXPECT_TRUE(readAhead.read(path).isNull());
+    readAhead.setMaxFileBytes(FileReadAhead::DEFAULT_MAX_FILE_BYTES);
+
+    readAhead.setMode(FileReadAhead::Mode::Off);
+    EXPECT_TRUE(readAhead.read(path).isNull());
+
+    // Auto buffers network shares only
+    readAhead.setMode(FileReadAhead::Mode::Auto);
+    EXPECT_EQ(readAhead.read(path).isNull(), !readAhead.isNetworkPath(path));
+}
+
+TEST_F(FileReadAheadTest, ReadsAheadOfTheDecoders) {
+    QStringList paths;
+    for (int i = 0; i < 12; ++i) {
+        paths << write(QString("%1.bin").arg(i), QByteArray(1024, char('a' + i)));
+    }
+    readAhead.setDepth(6);
+
+    // Files the caller doesn't want are skipped
+    const QSet<QString> skipped{paths[1]};
+    std::atomic<int> asked{0};
+    readAhead.setUpcoming(paths, [&](const QString& path) {
+        ++asked;
+        return !skipped.contains(path);
+    });
+
+    for (int i : {0, 2, 3, 4, 5}) {
+        EXPECT_TRUE(QTest::qWaitFor([&]() { return readAhead.isBuffered(paths[i]); }, 5000)) << i;
+    }
+    EXPECT_EQ(readAhead.read(paths[3]), QByteArray(1024, 'd'));
+    EXPECT_FALSE(readAhead.isBuffered(paths[1]));
+    EXPECT_FALSE(readAhead.isBuffered(paths[6])) << "Past the depth";
+
+    readAhead.cancel();
+    EXPECT_TRUE(QTest::qWaitFor([&]() { return asked.load() == 6; }, 5000));
+}
+
+TEST_F(FileReadAheadTest, StopsAtHalfTheBudget) {
+    QStringList paths;
+    for (int i = 0; i < 4; ++i) {
+        paths << write(QString("%1.bin").arg(i), QByteArray(100 * 1024, 'x'));
+    }
+    readAhead.setMaxBytes(500 * 1024);
+
+    readAhead.setUpcoming(paths);
+    EXPECT_TRUE(QTest::qWaitFor([&]() { return readAhead.isBuffered(paths[0]); }, 5000));
+    QTest::qWait(100);
+
+    int buffered = 0;
+    for (const QString& path : paths) buffered += readAhead.isBuffered(path) ? 1 : 0;
+    EXPECT_EQ(buffered, 2);
+
+    // What the decoders ask for is read regardless
+    EXPECT_FALSE(readAhead.read(paths[3]).isNull());
+}
+
+TEST_F(FileReadAheadTest, RecognisesNetworkFileSystems) {
+    EXPECT_TRUE(FileReadAhead::isNetworkFileSystem("cifs"));
+    EXPECT_TRUE(FileReadAhead::isNetworkFileSystem("nfs4"));
+    EXPECT_TRUE(FileReadAhead::isNetworkFileSystem("smbfs"));
+    EXPECT_TRUE(FileReadAhead::isNetworkFileSystem("NFS"));
+    EXPECT_FALSE(FileReadAhead::isNetworkFileSystem("ext4"));
+    EXPECT_FALSE(FileReadAhead::isNetworkFileSystem("apfs"));
+    EXPECT_FALSE(FileReadAhead::isNetworkFileSystem(""));
+}
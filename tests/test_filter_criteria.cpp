@@ -121,3 +121,110 @@ TEST_F(FilterCriteriaTest, CombinedFilters) {
     EXPECT_TRUE(criteria.matches(perfectPhoto)) << "Should match photo passing all filters";
     EXPECT_FALSE(criteria.matches(partialPhoto)) << "Should not match photo failing any filter";
 }
+
+TEST_F(FilterCriteriaTest, NarrowerThan) {
+    FilterCriteria base;
+    base.minRating = 2;
+    base.cameras = QStringList{"canon"};
+    base.searchText = "sun";
+    
+    FilterCriteria tighter = base;
+    tighter.minRating = 4;
+    tighter.onlyWithFaces = true;
+    tighter.cameras = QStringList{"Canon EOS"};
+    tighter.searchText = "sunset beach";
+    
+    EXPECT_TRUE(tighter.isNarrowerThan(base));
+    EXPECT_FALSE(base.isNarrowerThan(tighter));
+    EXPECT_TRUE(base.isNarrowerThan(base)) << "Equal criteria are narrower both ways";
+    EXPECT_TRUE(base.isNarrowerThan(FilterCriteria())) << "Defaults match everything";
+    
+    FilterCriteria otherCamera = base;
+    otherCamera.cameras = QStringList{"nikon"};
+    EXPECT_FALSE(otherCamera.isNarrowerThan(base));
+    EXPECT_FALSE(base.isNarrowerThan(otherCamera));
+    
+    FilterCriteria caseSensitive = base;
+    caseSensitive.searchCaseSensitive = true;
+    EXPECT_TRUE(caseSensitive.isNarrowerThan(base));
+    EXPECT_FALSE(base.isNarrowerThan(caseSensitive));
+}
+
+TEST_F(FilterCriteriaTest, GeoRegionFilter) {
+    PhotoMetadata photo = createTestPhoto();  // San Francisco
+    PhotoMetadata noGPS = createTestPhoto();
+    noGPS.gps_lat = 0.0;
+    noGPS.gps_lon = 0.0;
+
+    FilterCriteria criteria;
+    criteria.geoBox = GeoBox{37.7, -122.5, 37.8, -122.3};
+    EXPECT_TRUE(criteria.matches(photo));
+    EXPECT_FALSE(criteria.matches(noGPS)) << "A region implies GPS";
+
+    criteria.geoRadius = GeoCircle{37.8199, -122.4783, 5000.0};  // Golden Gate, ~7 km away
+    EXPECT_FALSE(criteria.matches(photo)) << "Box and radius both have to hold";
+    criteria.geoRadius->radiusMeters = 10000.0;
+    EXPECT_TRUE(criteria.matches(photo));
+
+    FilterCriteria pacific;
+    pacific.geoBox = GeoBox{-20.0, 170.0, -10.0, -170.0};
+    PhotoMetadata fiji = createTestPhoto();
+    fiji.gps_lat = -17.7;
+    fiji.gps_lon = 178.0;
+    EXPECT_TRUE(pacific.matches(fiji)) << "Box across the antimeridian";
+    EXPECT_FALSE(pacific.matches(photo));
+}
+
+TEST_F(FilterCriteriaTest, GeoNarrowerThan) {
+    FilterCriteria city;
+    city.geoBox = GeoBox{37.6, -122.6, 37.9, -122.3};
+
+    FilterCriteria block;
+    block.geoBox = GeoBox{37.77, -122.42, 37.78, -122.41};
+    EXPECT_TRUE(block.isNarrowerThan(city));
+    EXPECT_FALSE(city.isNarrowerThan(block));
+
+    FilterCriteria gps;
+    gps.onlyWithGPS = true;
+    EXPECT_TRUE(block.isNarrowerThan(gps)) << "A region only matches geotagged photos";
+    EXPECT_FALSE(gps.isNarrowerThan(block));
+
+    FilterCriteria near;
+    near.geoRadius = GeoCircle{37.7749, -122.4194, 1000.0};
+    FilterCriteria far;
+    far.geoRadius = GeoCircle{37.7749, -122.4194, 20000.0};
+    EXPECT_TRUE(near.isNarrowerThan(far));
+    EXPECT_FALSE(far.isNarrowerThan(near));
+    EXPECT_TRUE(near.isNarrowerThan(city)) << "Circle inside the box";
+    EXPECT_FALSE(far.isNarrowerThan(city));
+    EXPECT_FALSE(block.isNarrowerThan(far)) << "Box in circle isn't checked";
+}
+
+TEST_F(FilterCriteriaTest, JsonRoundTrip) {
+    FilterCriteria criteria;
+    criteria.minRating = 5;
+    criteria.cameras = {"Fuji"};
+    criteria.scenes = {"landscape"};
+    criteria.startDate = QDateTime(QDate(2024, 1, 1), QTime(0, 0));
+    criteria.endDate = QDateTime(QDate(2024, 12, 31), QTime(23, 59, 59, 999));
+    criteria.geoRadius = GeoCircle{37.7749, -122.4194, 1000.0};
+    criteria.searchText = "sunset";
+
+    const FilterCriteria loaded = FilterCriteria::fromJson(criteria.toJson());
+    EXPECT_EQ(loaded.minRating, 5);
+    EXPECT_EQ(loaded.maxRating, 5);
+    EXPECT_EQ(loaded.cameras, QStringList{"Fuji"});
+    EXPECT_EQ(loaded.scenes, QStringList{"landscape"});
+    EXPECT_EQ(loaded.startDate, criteria.startDate);
+    EXPECT_EQ(loaded.endDate, criteria.endDate);
+    EXPECT_FALSE(loaded.geoBox.has_value());
+    ASSERT_TRUE(loaded.geoRadius.has_value());
+    EXPECT_DOUBLE_EQ(loaded.geoRadius->radiusMeters, 1000.0);
+    EXPECT_EQ(loaded.searchText, "sunset");
+
+    // Missing fields keep their defaults
+    const FilterCriteria empty = FilterCriteria::fromJson(QJsonObject());
+    EXPECT_EQ(empty.maxRating, 5);
+    EXPECT_EQ(empty.maxISO, 102400);
+    EXPECT_FALSE(empty.startDate.isValid());
+}
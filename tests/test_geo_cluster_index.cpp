@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include "core/GeoClusterIndex.h"
+#include <algorithm>
+
+using namespace PhotoGuru;
+
+class GeoClusterIndexTest : public ::testing::Test {
+protected:
+    // 100 photos around San Francisco, 50 around London
+    void SetUp() override {
+        for (int i = 0; i < 100; ++i) {
+            points.push_back({37.7749 + (i % 10) * 0.001, -122.4194 + (i / 10) * 0.001});
+        }
+        for (int i = 0; i < 50; ++i) {
+            points.push_back({51.5074 + (i % 5) * 0.001, -0.1278 + (i / 5) * 0.001});
+        }
+        index.build(points);
+    }
+
+    static int total(const std::vector<GeoClusterIndex::Cluster>& clusters) {
+        int count = 0;
+        for (const auto& cluster : clusters) count += cluster.count;
+        return count;
+    }
+
+    std::vector<GeoClusterIndex::Point> points;
+    GeoClusterIndex index;
+};
+
+TEST_F(GeoClusterIndexTest, WorldViewClustersEachCity) {
+    auto clusters = index.query(-85, -180, 85, 180, 2);
+    ASSERT_EQ(clusters.size(), 2u);
+    EXPECT_EQ(total(clusters), 150);
+
+    for (const auto& cluster : clusters) {
+        if (cluster.count == 100) {
+            EXPECT_NEAR(cluster.lat, 37.779, 0.01);
+            EXPECT_NEAR(cluster.lon, -122.415, 0.01);
+            EXPECT_LT(cluster.first, 100);
+        } else {
+            EXPECT_EQ(cluster.count, 50);
+            EXPECT_GE(cluster.first, 100);
+        }
+    }
+}
+
+TEST_F(GeoClusterIndexTest, ZoomingInSplitsAndViewportCrops) {
+    auto street = index.query(37.77, -122.43, 37.79, -122.40, 19);
+    EXPECT_EQ(total(street), 100) << "London is outside the viewport";
+    EXPECT_GT(street.size(), 50u) << "~100 m apart: mostly single photos at street level";
+
+    auto city = index.query(37.70, -122.50, 37.85, -122.35, 12);
+    EXPECT_EQ(total(city), 100);
+    EXPECT_LT(city.size(), street.size());
+
+    EXPECT_TRUE(index.query(-40, 100, -10, 150, 5).empty()) << "Nothing in Australia";
+}
+
+TEST_F(GeoClusterIndexTest, VisibilityMasksWithoutRebuilding) {
+    std::vector<bool> visible(points.size(), true);
+    for (int i = 0; i < 100; i += 2) visible[size_t(i)] = false;  // Half of San Francisco
+    for (int i = 100; i < 150; ++i) visible[size_t(i)] = false;   // All of London
+    index.setVisible(visible);
+
+    EXPECT_EQ(index.size(), 150);
+    EXPECT_EQ(index.visibleCount(), 50);
+    auto clusters = index.query(-85, -180, 85, 180, 2);
+    ASSERT_EQ(clusters.size(), 1u);
+    EXPECT_EQ(clusters[0].count, 50);
+    EXPECT_EQ(clusters[0].first % 2, 1) << "Representative is a visible photo";
+
+    std::vector<int> members = index.members(clusters[0], 10);
+    EXPECT_EQ(members.size(), 10u);
+    for (int member : members) EXPECT_TRUE(visible[size_t(member)]);
+
+    double south, west, north, east;
+    ASSERT_TRUE(index.bounds(&south, &west, &north, &east));
+    EXPECT_LT(north, 40.0) << "Hidden London is outside the bounds";
+}
+
+TEST_F(GeoClusterIndexTest, SkipsMissingAndInvalidCoordinates) {
+    GeoClusterIndex other;
+    other.build({{0.0, 0.0}, {999.0, -999.0}, {48.8566, 2.3522}});
+    EXPECT_EQ(other.size(), 1);
+
+    auto clusters = other.query(-85, -180, 85, 180, 0);
+    ASSERT_EQ(clusters.size(), 1u);
+    EXPECT_EQ(clusters[0].first, 2) << "Input indices survive the sort";
+
+    other.clear();
+    EXPECT_EQ(other.visibleCount(), 0);
+    EXPECT_TRUE(other.query(-85, -180, 85, 180, 0).empty());
+    double s, w, n, e;
+    EXPECT_FALSE(other.bounds(&s, &w, &n, &e));
+}
+
+TEST_F(GeoClusterIndexTest, WrappedViewportCoversTheWorld) {
+    auto clusters = index.query(-85, -250, 85, 110, 2);
+    EXPECT_EQ(total(clusters), 150);
+}
+
+TEST_F(GeoClusterIndexTest, RegionQueriesMatchAScan) {
+    std::vector<bool> visible(points.size(), true);
+    for (size_t i = 0; i < points.size(); i += 3) visible[i] = false;
+    index.setVisible(visible);
+
+    auto scan = [&](auto&& inside) {
+        std::vector<int> result;
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (visible[i] && inside(points[i])) result.push_back(int(i));
+        }
+        return result;
+    };
+    auto sorted = [](std::vector<int> v) {
+        std::sort(v.begin(), v.end());
+        return v;
+    };
+
+    GeoBox box{37.776, -122.418, 37.780, -122.414};
+    auto boxed = sorted(index.inBox(box));
+    EXPECT_FALSE(boxed.empty());
+    EXPECT_EQ(boxed, scan([&](const GeoClusterIndex::Point& p) { return box.contains(p.lat, p.lon); }));
+
+    GeoCircle circle{51.509, -0.126, 150.0};
+    auto near = sorted(index.withinRadius(circle));
+    EXPECT_FALSE(near.empty());
+    EXPECT_LT(near.size(), 50u);
+    EXPECT_EQ(near, scan([&](const GeoClusterIndex::Point& p) { return circle.contains(p.lat, p.lon); }));
+
+    auto london = scan([](const GeoClusterIndex::Point& p) { return p.lat > 50.0; });
+    EXPECT_EQ(sorted(index.withinRadius({51.509, -0.126, 2.0e6})), london)
+        << "Every visible London photo, no San Francisco one";
+}
+
+TEST_F(GeoClusterIndexTest, NearestVisiblePhoto) {
+    EXPECT_EQ(index.nearest(37.77491, -122.41941, 50.0), 0);
+    EXPECT_EQ(index.nearest(37.7749, -122.4194 + 0.00095, 500.0), 10);
+    EXPECT_EQ(index.nearest(37.7749, -122.4194 + 360.0, 50.0), 0) << "Clicks on a wrapped world copy";
+
+    // Far from anything: within a bound, nothing; unbounded, the closest city
+    EXPECT_EQ(index.nearest(45.0, -40.0, 10000.0), -1);
+    int closest = index.nearest(45.0, -10.0, 1.0e8);
+    EXPECT_GE(closest, 100) << "London is closer than San Francisco";
+
+    std::vector<bool> visible(points.size(), true);
+    visible[0] = false;
+    index.setVisible(visible);
+    EXPECT_NE(index.nearest(37.7749, -122.4194, 500.0), 0) << "Hidden photos are never picked";
+}
+
+TEST_F(GeoClusterIndexTest, BoxAcrossTheAntimeridian) {
+    GeoClusterIndex pacific;
+    pacific.build({{-17.7, 178.0}, {-17.8, -179.5}, {-17.9, 170.0}, {-17.6, -175.0}});
+
+    auto found = pacific.inBox({-18.0, 175.0, -17.0, -176.0});
+    std::sort(found.begin(), found.end());
+    EXPECT_EQ(found, (std::vector<int>{0, 1}));
+    EXPECT_EQ(pacific.withinRadius({-17.75, 179.9, 250000.0}).size(), 2u);
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QImage>
+#include <QTimeZone>
+#include "core/GoogleTakeoutImporter.h"
+
+using namespace PhotoGuru;
+
+class GoogleTakeoutImporterTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    void writeFile(const QString& path, const QByteArray& data) {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    }
+
+    void writeImage(const QString& path) {
+        QImage image(8, 8, QImage::Format_RGB32);
+        image.fill(Qt::blue);
+        ASSERT_TRUE(image.save(path));
+    }
+};
+
+TEST_F(GoogleTakeoutImporterTest, BuildsOneCombinedWrite) {
+    GoogleTakeoutParser::TakeoutMetadata metadata;
+    metadata.description = "Beach\nday";
+    metadata.people = {"Ana"};
+    metadata.albumNames = {"Trip"};
+    metadata.geoData = QGeoCoordinate(-22.9, -43.2);
+    metadata.locationName = "Rio, RJ, Brazil";
+    metadata.photoTakenTime = QDateTime(QDate(2020, 1, 2), QTime(3, 4, 5), QTimeZone::utc());
+
+    GoogleTakeoutImporter::ImportOptions options;
+    QStringList args = GoogleTakeoutImporter::buildTransaction("/p/a.jpg", metadata, options).arguments();
+
+    ASSERT_FALSE(args.isEmpty());
+    EXPECT_EQ(args.first(), "-overwrite_original");
+    EXPECT_EQ(args.last(), "/p/a.jpg");
+    EXPECT_TRUE(args.contains("-XMP:Description=Beach day")) << "Values stay on one line";
+    EXPECT_TRUE(args.contains("-IPTC:Keywords+=Ana"));
+    EXPECT_TRUE(args.contains("-IPTC:Keywords+=Album: Trip"));
+    EXPECT_TRUE(args.contains("-GPSLatitudeRef=S"));
+    EXPECT_TRUE(args.contains("-IPTC:Province-State=RJ"));
+    EXPECT_TRUE(args.contains("-DateTimeOriginal=2020:01:02 03:04:05"));
+
+    options.applyDescription = false;
+    options.applyPeopleAsKeywords = false;
+    options.applyAlbumsAsKeywords = false;
+    options.applyLocation = false;
+    options.applyDateTime = false;
+    EXPECT_TRUE(GoogleTakeoutImporter::buildTransaction("/p/a.jpg", metadata, options).isEmpty());
+}
+
+TEST_F(GoogleTakeoutImporterTest, ResumesFromJournal) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    writeImage(dir.filePath("a.jpg"));
+    writeImage(dir.filePath("b.jpg"));
+    // Timestamps only: nothing to write, so no ExifTool needed
+    writeFile(dir.filePath("a.jpg.json"), R"({"photoTakenTime": {"timestamp": "1577934245"}})");
+    writeFile(dir.filePath("b.json"), R"({"creationTime": {"timestamp": "1577934245"}})");
+
+    int lastDone = -1;
+    GoogleTakeoutImporter::ImportOptions options;
+    options.progress = [&lastDone](int done, int) {
+        lastDone = done;
+        return true;
+    };
+
+    auto first = GoogleTakeoutImporter::importDirectory(dir.path(), options);
+    EXPECT_EQ(first.totalImages, 2);
+    EXPECT_EQ(first.withJson, 2);
+    EXPECT_EQ(first.errors, 0);
+    EXPECT_EQ(lastDone, 2);
+    EXPECT_TRUE(QFile::exists(dir.filePath(GoogleTakeoutImporter::JOURNAL_FILE)));
+
+    auto second = GoogleTakeoutImporter::importDirectory(dir.path(), options);
+    EXPECT_EQ(second.skipped, 2);
+    EXPECT_EQ(second.withJson, 0);
+
+    options.resume = false;
+    auto third = GoogleTakeoutImporter::importDirectory(dir.path(), options);
+    EXPECT_EQ(third.skipped, 0);
+    EXPECT_EQ(third.withJson, 2);
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QFile>
+#include "core/GoogleTakeoutParser.h"
+
+using namespace PhotoGuru;
+
+namespace {
+
+void touch(const QString& path) {
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+}
+
+} // namespace
+
+TEST(GoogleTakeoutParserTest, CandidateNamesFollowTakeoutRules) {
+    using Index = GoogleTakeoutParser::SidecarIndex;
+
+    QStringList plain = Index::candidateNames("IMG_0001.jpg");
+    ASSERT_GE(plain.size(), 3);
+    EXPECT_EQ(plain[0], "IMG_0001.jpg.json");
+    EXPECT_EQ(plain[1], "IMG_0001.jpg.supplemental-metadata.json");
+    EXPECT_TRUE(plain.contains("IMG_0001.json"));
+
+    EXPECT_EQ(Index::candidateNames("IMG_0001(1).jpg").first(), "IMG_0001.jpg(1).json");
+    EXPECT_TRUE(Index::candidateNames("IMG_0001-edited.jpg").contains("IMG_0001.jpg.json"));
+
+    // 46 characters before ".json", the supplemental suffix cut short
+    QString longName = QString(40, 'a') + ".jpg";
+    QStringList truncated = Index::candidateNames(longName);
+    EXPECT_TRUE(truncated.contains(longName + ".s.json"));
+    for (const QString& name : truncated) {
+        EXPECT_LE(name.size() - 5, GoogleTakeoutParser::MAX_SIDECAR_STEM) << name.toStdString();
+    }
+}
+
+TEST(GoogleTakeoutParserTest, SidecarIndexResolvesFromOneListing) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    touch(dir.filePath("a.jpg.json"));
+    touch(dir.filePath("b.jpg.supplemental-metadata.json"));
+    touch(dir.filePath("c.jpg(2).json"));
+    touch(dir.filePath("d.json"));
+
+    GoogleTakeoutParser::SidecarIndex index(dir.path());
+    EXPECT_EQ(index.size(), 4);
+    EXPECT_EQ(index.findJsonForImage(dir.filePath("a.jpg")), dir.filePath("a.jpg.json"));
+    EXPECT_EQ(index.findJsonForImage(dir.filePath("a-edited.jpg")), dir.filePath("a.jpg.json"));
+    EXPECT_EQ(index.findJsonForImage(dir.filePath("b.jpg")), dir.filePath("b.jpg.supplemental-metadata.json"));
+    EXPECT_EQ(index.findJsonForImage(dir.filePath("c(2).jpg")), dir.filePath("c.jpg(2).json"));
+    EXPECT_EQ(index.findJsonForImage(dir.filePath("d.png")), dir.filePath("d.json"));
+    EXPECT_TRUE(index.findJsonForImage(dir.filePath("e.jpg")).isEmpty());
+
+    EXPECT_EQ(GoogleTakeoutParser::findJsonForImage(dir.filePath("b.jpg")),
+              dir.filePath("b.jpg.supplemental-metadata.json"));
+}
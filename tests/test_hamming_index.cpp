@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include "core/HammingIndex.h"
+#include "core/PerceptualHash.h"
+
+using namespace PhotoGuru;
+
+TEST(HammingIndexTest, MatchesBruteForce) {
+    std::mt19937_64 random(42);
+    std::vector<quint64> hashes;
+    for (int i = 0; i < 2000; ++i) {
+        // Clusters of near copies: a base hash with a few bits flipped
+        quint64 hash = i % 4 == 0 ? random() : hashes[size_t(i - i % 4)];
+        for (int flip = 0; flip < i % 4; ++flip) hash ^= quint64(1) << (random() % 64);
+        hashes.push_back(hash);
+    }
+
+    HammingIndex index;
+    for (quint64 hash : hashes) index.add(hash);
+    ASSERT_EQ(index.size(), 2000);
+
+    for (int query : {0, 5, 777, 1999}) {
+        for (int radius : {0, 3, 10}) {
+            std::vector<int> expected;
+            for (int id = 0; id < int(hashes.size()); ++id) {
+                if (PerceptualHash::distance(hashes[size_t(query)], hashes[size_t(id)]) <= radius) {
+                    expected.push_back(id);
+                }
+            }
+            std::vector<int> found;
+            for (const HammingIndex::Hit& hit : index.search(hashes[size_t(query)], radius)) {
+                EXPECT_EQ(hit.distance, PerceptualHash::distance(hashes[size_t(query)], hashes[size_t(hit.id)]));
+                found.push_back(hit.id);
+            }
+            std::sort(found.begin(), found.end());
+            EXPECT_EQ(found, expected) << "query " << query << " radius " << radius;
+        }
+    }
+}
+
+TEST(HammingIndexTest, KeepsIdenticalHashes) {
+    HammingIndex index;
+    EXPECT_TRUE(index.search(0, 64).empty());
+    index.add(7);
+    index.add(7);
+    index.add(7);
+    EXPECT_EQ(index.search(7, 0).size(), 3u);
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "ml/HnswIndex.h"
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cmath>
+#include <random>
+
+using namespace PhotoGuru;
+
+class HnswIndexTest : public ::testing::Test {
+protected:
+    // Clustered unit vectors - closer to real CLIP embeddings than uniform noise
+    void SetUp() override {
+        std::mt19937 rng(3);
+        std::normal_distribution<float> normal;
+        std::vector<float> centers(size_t(CLUSTERS) * DIM);
+        for (float& value : centers) value = normal(rng);
+
+        matrix.resize(size_t(ROWS) * DIM);
+        for (int r = 0; r < ROWS; ++r) {
+            int cluster = int(rng() % CLUSTERS);
+            makeUnit(centers.data() + cluster * DIM, rng, matrix.data() + size_t(r) * DIM);
+        }
+        for (int q = 0; q < QUERIES; ++q) {
+            std::vector<float> query(DIM);
+            makeUnit(centers.data() + int(rng() % CLUSTERS) * DIM, rng, query.data());
+            queries.push_back(std::move(query));
+        }
+    }
+
+    static void makeUnit(const float* center, std::mt19937& rng, float* out) {
+        std::normal_distribution<float> normal;
+        float norm = 0.0f;
+        for (int i = 0; i < DIM; ++i) {
+            out[i] = center[i] + 0.5f * normal(rng);
+            norm += out[i] * out[i];
+        }
+        norm = std::sqrt(norm);
+        for (int i = 0; i < DIM; ++i) out[i] /= norm;
+    }
+
+    HnswIndex::VectorSource source() {
+        return [this](int id) { return matrix.data() + size_t(id) * DIM; };
+    }
+
+    double recallAt10(const HnswIndex& index) {
+        int found = 0;
+        for (const auto& query : queries) {
+            auto exact = VectorSearch::exactSearch(query.data(), matrix.data(), ROWS, DIM, 10);
+            auto approx = index.search(query.data(), 10);
+            for (const auto& e : exact) {
+                for (const auto& a : approx) {
+                    if (a.id == e.id) { ++found; break; }
+                }
+            }
+        }
+        return double(found) / (10.0 * queries.size());
+    }
+
+    static constexpr int ROWS = 5000;
+    static constexpr int DIM = 64;
+    static constexpr int CLUSTERS = 100;
+    static constexpr int QUERIES = 50;
+    std::vector<float> matrix;
+    std::vector<std::vector<float>> queries;
+};
+
+TEST_F(HnswIndexTest, RecallAgainstExactSearch) {
+    HnswIndex index(DIM, source());
+    for (int i = 0; i < ROWS; ++i) index.add();
+    ASSERT_EQ(index.size(), ROWS);
+
+    index.setEfSearch(64);
+    QElapsedTimer timer;
+    timer.start();
+    double recall = recallAt10(index);
+    qDebug() << "[HNSW] recall@10:" << recall << "in" << timer.elapsed() << "ms (with exact baseline)";
+    EXPECT_GT(recall, 0.95);
+
+    // Knob: a tiny candidate list trades recall away
+    index.setEfSearch(1);
+    EXPECT_LE(recallAt10(index), recall);
+}
+
+TEST_F(HnswIndexTest, FindsItselfAndHonoursFilter) {
+    HnswIndex index(DIM, source());
+    for (int i = 0; i < ROWS; ++i) index.add();
+
+    const float* row = matrix.data() + 123 * DIM;
+    auto hits = index.search(row, 5);
+    ASSERT_FALSE(hits.empty());
+    EXPECT_EQ(hits[0].id, 123);
+    EXPECT_NEAR(hits[0].score, 1.0f, 1e-5f);
+
+    auto filtered = index.search(row, 5, [](int id) { return id != 123; });
+    for (const auto& hit : filtered) {
+        EXPECT_NE(hit.id, 123);
+    }
+}
+
+TEST_F(HnswIndexTest, SaveLoadAndGrowIncrementally) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    QString path = dir.filePath("graph.idx");
+
+    {
+        HnswIndex index(DIM, source());
+        for (int i = 0; i < ROWS / 2; ++i) index.add();
+        ASSERT_TRUE(index.save(path, 77));
+    }
+
+    HnswIndex other(DIM, source());
+    EXPECT_FALSE(other.load(path, 78)) << "Different tag must not load";
+    HnswIndex wrongDim(DIM * 2, source());
+    EXPECT_FALSE(wrongDim.load(path, 77));
+
+    HnswIndex index(DIM, source());
+    ASSERT_TRUE(index.load(path, 77));
+    EXPECT_EQ(index.size(), ROWS / 2);
+
+    // Continue where the saved graph stopped
+    while (index.size() < ROWS) index.add();
+    index.setEfSearch(64);
+    EXPECT_GT(recallAt10(index), 0.95);
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "core/ImageLoader.h"
+#include "core/FileReadAhead.h"
 #include <QImage>
+#include <QColor>
 #include <QTemporaryDir>
 #include <QFile>
 
@@ -30,6 +32,16 @@ TEST_F(ImageLoaderTest, SupportedExtensions) {
     EXPECT_TRUE(extensions.contains("*.heic")) << "Should support HEIC";
 }
 
+TEST_F(ImageLoaderTest, SupportedExtensionsMatchDetectFormat) {
+    QStringList extensions = loader->supportedExtensions();
+    EXPECT_TRUE(extensions.contains("*.JPG")) << "Upper case for case-sensitive filters";
+    EXPECT_TRUE(extensions.contains("*.srw")) << "Every RAW format detectFormat knows";
+    
+    for (const QString& ext : extensions) {
+        EXPECT_TRUE(loader->isSupported("photo" + ext.mid(1))) << ext.toStdString();
+    }
+}
+
 TEST_F(ImageLoaderTest, LoadNonExistentImage) {
     auto resultOpt = loader->load("/nonexistent/image.jpg");
     EXPECT_FALSE(resultOpt.has_value()) << "Should return empty optional for non-existent file";
@@ -52,3 +64,100 @@ TEST_F(ImageLoaderTest, SupportedFormats) {
     EXPECT_TRUE(hasPNG) << "Should support PNG format";
     EXPECT_TRUE(hasHEIC) << "Should support HEIC format";
 }
+
+TEST_F(ImageLoaderTest, RawPreviewRejectsNonRawFiles) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    
+    QString jpegPath = tempDir.path() + "/not_raw.jpg";
+    QImage img(64, 64, QImage::Format_RGB32);
+    img.fill(Qt::magenta);
+    ASSERT_TRUE(img.save(jpegPath, "JPEG"));
+    
+    EXPECT_FALSE(loader->loadRAWPreview(jpegPath).has_value())
+        << "LibRaw should not find a preview in a plain JPEG";
+    EXPECT_FALSE(loader->loadRAWPreview("/nonexistent/photo.cr2").has_value());
+}
+
+TEST_F(ImageLoaderTest, LoadHonorsMaxSize) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    
+    QString path = tempDir.path() + "/large.jpg";
+    QImage img(1600, 1200, QImage::Format_RGB32);
+    img.fill(Qt::darkGreen);
+    ASSERT_TRUE(img.save(path, "JPEG"));
+    
+    auto scaled = loader->load(path, QSize(400, 400));
+    ASSERT_TRUE(scaled.has_value());
+    EXPECT_LE(scaled->width(), 400);
+    EXPECT_LE(scaled->height(), 400);
+    EXPECT_EQ(scaled->width(), 400) << "Aspect ratio should be preserved";
+    
+    auto full = loader->load(path);
+    ASSERT_TRUE(full.has_value());
+    EXPECT_EQ(full->size(), QSize(1600, 1200)) << "No maxSize should decode full resolution";
+    
+    // Never upscale small images
+    auto small = loader->load(path, QSize(4000, 4000));
+    ASSERT_TRUE(small.has_value());
+    EXPECT_EQ(small->size(), QSize(1600, 1200));
+}
+
+TEST_F(ImageLoaderTest, LoadRegionKeepsFullResolution) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    
+    // Lossless, with a marker only the region contains
+    QString path = tempDir.path() + "/large.png";
+    QImage img(1200, 800, QImage::Format_RGB32);
+    img.fill(Qt::black);
+    img.setPixel(700, 500, qRgb(255, 0, 0));
+    ASSERT_TRUE(img.save(path, "PNG"));
+    
+    EXPECT_EQ(loader->getImageDimensions(path), QSize(1200, 800));
+    
+    auto region = loader->loadRegion(path, QRect(600, 400, 200, 150));
+    ASSERT_TRUE(region.has_value());
+    EXPECT_EQ(region->size(), QSize(200, 150));
+    EXPECT_EQ(QColor(region->pixel(100, 100)), QColor(Qt::red));
+    
+    // Clipped to the image
+    auto edge = loader->loadRegion(path, QRect(1100, 700, 400, 400));
+    ASSERT_TRUE(edge.has_value());
+    EXPECT_EQ(edge->size(), QSize(100, 100));
+    
+    EXPECT_FALSE(loader->loadRegion(path, QRect(2000, 2000, 10, 10)).has_value());
+}
+
+TEST_F(ImageLoaderTest, DecodesFromReadAheadBuffers) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    
+    QString path = tempDir.path() + "/buffered.png";
+    QImage img(300, 200, QImage::Format_RGB32);
+    img.fill(Qt::black);
+    img.setPixel(250, 150, qRgb(0, 0, 255));
+    ASSERT_TRUE(img.save(path, "PNG"));
+    
+    // As if on a share: the decoders get the bytes, not the path
+    FileReadAhead& readAhead = FileReadAhead::instance();
+    readAhead.setMode(FileReadAhead::Mode::Always);
+    
+    auto bounded = loader->load(path, QSize(150, 150));
+    ASSERT_TRUE(bounded.has_value());
+    EXPECT_EQ(bounded->size(), QSize(150, 100));
+    EXPECT_TRUE(readAhead.isBuffered(path));
+    
+    auto region = loader->loadRegion(path, QRect(200, 100, 100, 100));
+    ASSERT_TRUE(region.has_value());
+    EXPECT_EQ(QColor(region->pixel(50, 50)), QColor(Qt::blue));
+    
+    bool isFull = false;
+    auto preview = loader->loadPreview(path, QSize(1000, 1000), &isFull);
+    ASSERT_TRUE(preview.has_value());
+    EXPECT_TRUE(isFull);
+    
+    readAhead.setMode(FileReadAhead::Mode::Auto);
+    readAhead.clear();
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "ml/ImagePreprocessor.h"
+#include <QImage>
+#include <QColor>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cmath>
+#include <vector>
+
+using namespace PhotoGuru;
+
+namespace {
+
+const float CLIP_MEAN[3] = {0.48145466f, 0.4578275f, 0.40821073f};
+const float CLIP_STD[3] = {0.26862954f, 0.26130258f, 0.27577711f};
+
+// The previous ONNXInference::preprocessImage loop, kept as reference and baseline
+std::vector<float> legacyPreprocess(const QImage& image, int width, int height) {
+    QImage resized = image.scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    if (resized.format() != QImage::Format_RGB888) {
+        resized = resized.convertToFormat(QImage::Format_RGB888);
+    }
+
+    const int channels = 3;
+    std::vector<float> mean(CLIP_MEAN, CLIP_MEAN + 3);
+    std::vector<float> std(CLIP_STD, CLIP_STD + 3);
+    std::vector<float> tensor(channels * height * width);
+    for (int h = 0; h < height; ++h) {
+        const uchar* line = resized.constScanLine(h);
+        for (int w = 0; w < width; ++w) {
+            for (int c = 0; c < channels; ++c) {
+                float pixel = line[w * channels + c] / 255.0f;
+                if (c < static_cast<int>(mean.size()) && c < static_cast<int>(std.size())) {
+                    pixel = (pixel - mean[c]) / std[c];
+                }
+                tensor[c * height * width + h * width + w] = pixel;
+            }
+        }
+    }
+    return tensor;
+}
+
+QImage gradientImage(int width, int height) {
+    QImage image(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            image.setPixel(x, y, qRgb((x * 7) & 255, (y * 5) & 255, (x + y) & 255));
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+TEST(ImagePreprocessorTest, MatchesLegacyPreprocess) {
+    QImage image = gradientImage(301, 199);  // Odd sizes exercise the SIMD tails
+
+    std::vector<float> expected = legacyPreprocess(image, 224, 224);
+    std::vector<float> actual(3 * 224 * 224);
+    ASSERT_TRUE(ImagePreprocessor::toNormalizedCHW(image, 224, 224, CLIP_MEAN, CLIP_STD, actual.data()));
+
+    float maxError = 0.0f;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        maxError = std::max(maxError, std::abs(expected[i] - actual[i]));
+    }
+    EXPECT_LT(maxError, 1e-4f);
+}
+
+TEST(ImagePreprocessorTest, SimdMatchesScalarKernel) {
+    QImage image = gradientImage(37, 5);
+    float scale[3] = {0.5f, 1.0f / 255.0f, 2.0f};
+    float bias[3] = {-1.0f, 0.0f, 0.25f};
+
+    std::vector<float> simd(3 * 37 * 5);
+    std::vector<float> scalar(simd.size());
+    ImagePreprocessor::splitChannels(image, scale, bias, simd.data());
+    ImagePreprocessor::splitChannelsScalar(image, scale, bias, scalar.data());
+
+    for (size_t i = 0; i < simd.size(); ++i) {
+        EXPECT_NEAR(simd[i], scalar[i], 1e-5f) << "at " << i;
+    }
+}
+
+TEST(ImagePreprocessorTest, WithoutMeanIsUnitRange) {
+    QImage image(8, 8, QImage::Format_RGB32);
+    image.fill(QColor(255, 0, 51));
+
+    std::vector<float> tensor(3 * 8 * 8);
+    ASSERT_TRUE(ImagePreprocessor::toNormalizedCHW(image, 8, 8, nullptr, nullptr, tensor.data()));
+    EXPECT_FLOAT_EQ(tensor[0], 1.0f);
+    EXPECT_FLOAT_EQ(tensor[64], 0.0f);
+    EXPECT_NEAR(tensor[128], 0.2f, 1e-6f);
+
+    EXPECT_FALSE(ImagePreprocessor::toNormalizedCHW(QImage(), 8, 8, nullptr, nullptr, tensor.data()));
+}
+
+TEST(ImagePreprocessorTest, BenchmarkAgainstLegacy) {
+    QImage image = gradientImage(224, 224);  // Already at size: measures the kernel, not the resize
+    const int iterations = 200;
+
+    QElapsedTimer timer;
+    timer.start();
+    float checksum = 0.0f;
+    for (int i = 0; i < iterations; ++i) {
+        checksum += legacyPreprocess(image, 224, 224)[i];
+    }
+    qint64 legacyUs = timer.nsecsElapsed() / 1000;
+
+    std::vector<float> tensor(3 * 224 * 224);
+    timer.restart();
+    for (int i = 0; i < iterations; ++i) {
+        ImagePreprocessor::toNormalizedCHW(image, 224, 224, CLIP_MEAN, CLIP_STD, tensor.data());
+        checksum -= tensor[i];
+    }
+    qint64 fusedUs = timer.nsecsElapsed() / 1000;
+
+    qDebug() << "[Preprocess] legacy:" << legacyUs / iterations << "us/image, fused:"
+             << fusedUs / iterations << "us/image";
+    EXPECT_NEAR(checksum, 0.0f, 1e-2f);
+    // Generous bound so slow CI machines don't flake; typical is several times faster
+    EXPECT_LT(fusedUs, legacyUs * 2);
+}
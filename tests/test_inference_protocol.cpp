@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <QJsonObject>
+#include "ml/InferenceProtocol.h"
+
+using namespace PhotoGuru;
+
+TEST(InferenceProtocolTest, InfoRoundTrips) {
+    InferenceBackend::Info info;
+    info.clipVersion = "clip-vit-b32";
+    info.embeddingDim = 512;
+    info.clipInputSize = 336;
+    info.batchSize = 32;
+    info.vlmId = "qwen2-vl/mmproj";
+    info.captionBatchSize = 4;
+
+    InferenceBackend::Info decoded = InferenceProtocol::infoFromJson(InferenceProtocol::infoToJson(info));
+    EXPECT_EQ(decoded.clipVersion, info.clipVersion);
+    EXPECT_EQ(decoded.embeddingDim, 512);
+    EXPECT_EQ(decoded.clipInputSize, 336);
+    EXPECT_EQ(decoded.batchSize, 32);
+    EXPECT_EQ(decoded.vlmId, info.vlmId);
+    EXPECT_EQ(decoded.captionBatchSize, 4);
+}
+
+TEST(InferenceProtocolTest, InfoWithoutVlmHasNoCaptions) {
+    InferenceBackend::Info info;
+    info.clipVersion = "clip";
+    info.embeddingDim = 4;
+
+    InferenceBackend::Info decoded = InferenceProtocol::infoFromJson(InferenceProtocol::infoToJson(info));
+    EXPECT_TRUE(decoded.vlmId.isEmpty());
+    EXPECT_EQ(decoded.embeddingDim, 4);
+}
+
+TEST(InferenceProtocolTest, EmbeddingsRoundTripExactly) {
+    std::vector<std::optional<std::vector<float>>> embeddings = {
+        std::vector<float>{0.1f, -2.5f, 3.0e-7f, 1.0f},
+        std::nullopt,
+        std::vector<float>{},
+    };
+    auto decoded = InferenceProtocol::decodeEmbeddings(InferenceProtocol::encodeEmbeddings(embeddings));
+    ASSERT_EQ(decoded.size(), 3u);
+    ASSERT_TRUE(decoded[0]);
+    EXPECT_EQ(*decoded[0], *embeddings[0]);
+    EXPECT_FALSE(decoded[1]);
+}
+
+TEST(InferenceProtocolTest, CaptionsKeepNulls) {
+    std::vector<std::optional<QString>> captions = {QString("A dog on a beach"), std::nullopt, QString("Ünïcode")};
+    auto decoded = InferenceProtocol::decodeCaptions(InferenceProtocol::encodeCaptions(captions));
+    ASSERT_EQ(decoded.size(), 3u);
+    EXPECT_EQ(decoded[0], captions[0]);
+    EXPECT_FALSE(decoded[1]);
+    EXPECT_EQ(decoded[2], captions[2]);
+}
+
+TEST(InferenceProtocolTest, ImagesRoundTripAsJpeg) {
+    QImage image(32, 24, QImage::Format_RGB32);
+    image.fill(QColor(200, 40, 40));
+
+    std::vector<QImage> decoded = InferenceProtocol::decodeImages(InferenceProtocol::encodeImages({image, QImage()}));
+    ASSERT_EQ(decoded.size(), 2u);
+    ASSERT_FALSE(decoded[0].isNull());
+    EXPECT_EQ(decoded[0].size(), image.size());
+    QColor centre = decoded[0].pixelColor(16, 12);
+    EXPECT_NEAR(centre.red(), 200, 8);
+    EXPECT_NEAR(centre.green(), 40, 8);
+    EXPECT_TRUE(decoded[1].isNull());
+}
+
+TEST(InferenceProtocolTest, OptionsCarryTokensAndStops) {
+    LlamaVLM::GenerationOptions options;
+    options.maxTokens = 77;
+    options.stopSequences = {"\n\n", "###"};
+
+    QJsonObject request;
+    InferenceProtocol::optionsToJson(options, request);
+    LlamaVLM::GenerationOptions decoded = InferenceProtocol::optionsFromJson(request);
+    EXPECT_EQ(decoded.maxTokens, 77);
+    EXPECT_EQ(decoded.stopSequences, options.stopSequences);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDir>
+#include "core/LibraryScanner.h"
+
+using namespace PhotoGuru;
+
+class LibraryScannerTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+    
+    QString touch(const QString& relativePath) {
+        QString path = QDir(m_dir.path()).filePath(relativePath);
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QFile file(path);
+        file.open(QIODevice::WriteOnly);
+        return path;
+    }
+    
+    // Everything filesFound() delivered until finished()
+    QStringList scan(LibraryScanner& scanner, const QStringList& roots) {
+        QStringList found;
+        QObject::connect(&scanner, &LibraryScanner::filesFound,
+                         [&found](const QStringList& paths) { found += paths; });
+        QSignalSpy finished(&scanner, &LibraryScanner::finished);
+        scanner.start(roots);
+        if (finished.isEmpty()) {
+            EXPECT_TRUE(finished.wait(10000));
+        }
+        found.sort();
+        return found;
+    }
+    
+    QTemporaryDir m_dir;
+};
+
+TEST_F(LibraryScannerTest, FindsImagesInEverySubfolder) {
+    QStringList expected = {
+        touch("top.jpg"),
+        touch("2023/summer/IMG_0001.JPG"),
+        touch("2023/summer/IMG_0002.CR2"),
+        touch("2024/deep/er/still/photo.heic"),
+    };
+    touch("2023/notes.txt");
+    touch("2024/.hidden/skip.jpg");  // Hidden folders are not walked
+    expected.sort();
+    
+    LibraryScanner scanner;
+    EXPECT_EQ(scan(scanner, {m_dir.path()}), expected);
+    EXPECT_EQ(scanner.foundCount(), expected.size());
+    EXPECT_FALSE(scanner.isRunning());
+}
+
+TEST_F(LibraryScannerTest, OverlappingRootsAreWalkedOnce) {
+    QString a = touch("a/one.png");
+    QString b = touch("a/b/two.png");
+    
+    LibraryScanner scanner;
+    QStringList found = scan(scanner, {m_dir.path(), QDir(m_dir.path()).filePath("a/b")});
+    EXPECT_EQ(found, (QStringList{b, a}));
+}
+
+TEST_F(LibraryScannerTest, SymlinkedFoldersAreNotFollowed) {
+    QString photo = touch("real/photo.jpg");
+    QFile::link(QDir(m_dir.path()).filePath("real"), QDir(m_dir.path()).filePath("real/loop"));
+    
+    LibraryScanner scanner;
+    EXPECT_EQ(scan(scanner, {m_dir.path()}), QStringList{photo});
+}
+
+TEST_F(LibraryScannerTest, CancelReportsAndStops) {
+    for (int i = 0; i < 50; ++i) {
+        touch(QString("d%1/photo.jpg").arg(i));
+    }
+    
+    LibraryScanner scanner;
+    QSignalSpy finished(&scanner, &LibraryScanner::finished);
+    scanner.start({m_dir.path()});
+    scanner.cancel();
+    scanner.wait();
+    
+    ASSERT_EQ(finished.count(), 1);
+    EXPECT_TRUE(finished[0][1].toBool());
+    EXPECT_FALSE(scanner.isRunning());
+    scanner.cancel();
+    EXPECT_EQ(finished.count(), 1) << "Nothing left to cancel";
+}
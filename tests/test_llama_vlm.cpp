@@ -175,3 +175,55 @@ TEST_F(LlamaVLMTest, ErrorHandlingNullImage) {
     // Should handle gracefully
     EXPECT_FALSE(result.has_value());
 }
+
+TEST(LlamaVLMTokenStreamTest, StopSequenceEndsGenerationAndIsNotStreamed) {
+    QStringList pieces;
+    LlamaVLM::GenerationOptions options;
+    options.stopSequences = {"\n\n"};
+    options.onToken = [&pieces](const QString& piece) { pieces << piece; return true; };
+    
+    LlamaVLM::TokenStream stream(options);
+    EXPECT_TRUE(stream.append("A dog"));
+    EXPECT_TRUE(stream.append(" runs.\n"));
+    EXPECT_FALSE(stream.append("\nKeywords: dog"));
+    stream.finish();
+    
+    EXPECT_EQ(stream.text(), "A dog runs.");
+    EXPECT_EQ(pieces.join(QString()), "A dog runs.") << "Held-back newline never reaches the callback";
+}
+
+TEST(LlamaVLMTokenStreamTest, SplitUtf8IsHeldUntilComplete) {
+    QStringList pieces;
+    LlamaVLM::GenerationOptions options;
+    options.onToken = [&pieces](const QString& piece) { pieces << piece; return true; };
+    
+    const std::string cafe = "caf\xC3\xA9";
+    LlamaVLM::TokenStream stream(options);
+    stream.append(cafe.substr(0, 4));  // Ends inside "é"
+    stream.append(cafe.substr(4));
+    stream.finish();
+    
+    ASSERT_EQ(pieces.size(), 2);
+    EXPECT_EQ(pieces[0], "caf");
+    EXPECT_EQ(pieces[1], QString::fromUtf8("\xC3\xA9"));
+    EXPECT_EQ(stream.text(), QString::fromUtf8("caf\xC3\xA9"));
+}
+
+TEST(LlamaVLMTokenStreamTest, CallbackAndCancelStopEarly) {
+    LlamaVLM::GenerationOptions options;
+    int calls = 0;
+    options.onToken = [&calls](const QString&) { return ++calls < 2; };
+    
+    LlamaVLM::TokenStream stream(options);
+    EXPECT_TRUE(stream.append("one "));
+    EXPECT_FALSE(stream.append("two "));
+    EXPECT_FALSE(stream.append("three"));
+    EXPECT_EQ(stream.text(), "one two ");
+    
+    QAtomicInt cancel{1};
+    LlamaVLM::GenerationOptions cancelled;
+    cancelled.cancel = &cancel;
+    LlamaVLM::TokenStream other(cancelled);
+    EXPECT_FALSE(other.append("never"));
+    EXPECT_TRUE(other.text().isEmpty());
+}
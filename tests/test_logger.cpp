@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "core/Logger.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <thread>
+#include <vector>
+
+using namespace PhotoGuru;
+
+namespace {
+
+// Points the process-wide logger at a scratch file for each test
+class LoggerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_dir.isValid());
+        m_originalPath = Logger::instance().logFilePath();
+        m_path = m_dir.filePath("test.log");
+        ASSERT_TRUE(Logger::instance().setLogFile(m_path));
+    }
+    void TearDown() override {
+        Logger::instance().setLogLevel(Logger::DEBUG);
+        Logger::instance().setLogFile(m_originalPath);
+    }
+
+    QString contents() {
+        Logger::instance().flush();
+        QFile file(m_path);
+        return file.open(QIODevice::ReadOnly) ? QString::fromUtf8(file.readAll()) : QString();
+    }
+
+    QTemporaryDir m_dir;
+    QString m_originalPath;
+    QString m_path;
+};
+
+} // namespace
+
+TEST_F(LoggerTest, FlushWritesFormattedLines) {
+    LOG_WARNING("LoggerTest", "disk almost full");
+
+    QString log = contents();
+    EXPECT_TRUE(log.contains("[WARNING] [LoggerTest] disk almost full\n")) << qPrintable(log);
+    EXPECT_TRUE(log.startsWith("[20"));  // Timestamp first
+}
+
+TEST_F(LoggerTest, DisabledLevelSkipsBuildingTheMessage) {
+    Logger::instance().setLogLevel(Logger::INFO);
+    int built = 0;
+    auto message = [&built]() { built++; return QString("expensive"); };
+
+    LOG_DEBUG("LoggerTest", message());
+    LOG_INFO("LoggerTest", message());
+
+    EXPECT_EQ(built, 1);
+    EXPECT_FALSE(Logger::instance().isEnabled(Logger::DEBUG));
+    QString log = contents();
+    EXPECT_FALSE(log.contains("[DEBUG  ]"));
+    EXPECT_TRUE(log.contains("[INFO   ] [LoggerTest] expensive"));
+}
+
+TEST_F(LoggerTest, ConcurrentCallersAreAllWritten) {
+    constexpr int THREADS = 4;
+    constexpr int PER_THREAD = 1000;  // Together below QUEUE_CAPACITY: nothing dropped
+    const quint64 droppedBefore = Logger::instance().droppedMessages();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < PER_THREAD; i++) {
+                LOG_INFO("LoggerTest", QString("thread %1 line %2").arg(t).arg(i));
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    QString log = contents();
+    EXPECT_EQ(log.count("[LoggerTest] thread "), THREADS * PER_THREAD);
+    EXPECT_EQ(Logger::instance().droppedMessages(), droppedBefore);
+}
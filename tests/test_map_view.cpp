@@ -4,6 +4,9 @@
 #include <QApplication>
 #include <QTest>
 #include <QSignalSpy>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
 
 using namespace PhotoGuru;
 
@@ -214,3 +217,61 @@ TEST_F(MapViewTest, WebEngineView) {
     auto webViews = mapView->findChildren<QWebEngineView*>();
     EXPECT_GT(webViews.size(), 0) << "Should have QWebEngineView for map";
 }
+
+TEST_F(MapViewTest, FilterMasksPhotosInPlace) {
+    testPhotos[0].rating = 5;
+    mapView->loadPhotos(testPhotos);
+    EXPECT_EQ(mapView->photoCount(), 3);
+    EXPECT_EQ(mapView->visiblePhotoCount(), 3);
+
+    FilterCriteria criteria;
+    criteria.minRating = 4;
+    mapView->applyFilter(criteria);
+    EXPECT_EQ(mapView->visiblePhotoCount(), 1);
+
+    criteria.minRating = 0;
+    mapView->applyFilter(criteria);
+    EXPECT_EQ(mapView->visiblePhotoCount(), 3) << "A wider filter brings photos back";
+    EXPECT_EQ(mapView->photoCount(), 3);
+}
+
+TEST_F(MapViewTest, ClustersOnlyForTheViewport) {
+    QList<PhotoMetadata> photos = testPhotos;
+    for (int i = 0; i < 100; i++) {
+        PhotoMetadata photo;
+        photo.filepath = QString("/test/sf_%1.jpg").arg(i);
+        photo.gps_lat = 37.7749 + (i % 10) * 0.001;
+        photo.gps_lon = -122.4194 + (i / 10) * 0.001;
+        photos << photo;
+    }
+    mapView->loadPhotos(photos);
+
+    // World: one cluster per city
+    QJsonArray world = QJsonDocument::fromJson(mapView->clustersJson(-85, -180, 85, 180, 2).toUtf8()).array();
+    EXPECT_EQ(world.size(), 3);
+
+    // London alone, as a single photo with its popup fields
+    QJsonArray london = QJsonDocument::fromJson(
+        mapView->clustersJson(51.4, -0.3, 51.6, 0.1, 12).toUtf8()).array();
+    ASSERT_EQ(london.size(), 1);
+    QJsonObject photo = london[0].toObject();
+    EXPECT_EQ(photo["count"].toInt(), 1);
+    EXPECT_EQ(photo["filepath"].toString(), "/test/photo3.jpg");
+    EXPECT_EQ(photo["title"].toString(), "Big Ben");
+}
+
+TEST_F(MapViewTest, RegionAndNearestLookups) {
+    mapView->loadPhotos(testPhotos);
+
+    EXPECT_EQ(mapView->photosInBox({35.0, -125.0, 45.0, -70.0}).size(), 2) << "San Francisco and New York";
+    EXPECT_EQ(mapView->photosWithinRadius({51.5, -0.1, 10000.0}), QStringList{"/test/photo3.jpg"});
+
+    EXPECT_EQ(mapView->nearestPhoto(40.71, -74.0, 1000.0), "/test/photo2.jpg");
+    EXPECT_TRUE(mapView->nearestPhoto(0.0, -30.0, 1000.0).isEmpty());
+
+    FilterCriteria criteria;
+    criteria.geoRadius = GeoCircle{51.5, -0.1, 10000.0};
+    mapView->applyFilter(criteria);
+    EXPECT_EQ(mapView->visiblePhotoCount(), 1);
+    EXPECT_TRUE(mapView->nearestPhoto(40.71, -74.0, 1000.0).isEmpty()) << "Filtered-out photos aren't picked";
+}
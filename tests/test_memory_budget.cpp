@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "core/MemoryBudget.h"
+#include <QSignalSpy>
+
+using namespace PhotoGuru;
+
+namespace {
+
+constexpr qint64 MB = 1024 * 1024;
+
+MemoryBudget::Cache cache(const QString& name, double share, int priority) {
+    MemoryBudget::Cache result;
+    result.name = name;
+    result.share = share;
+    result.priority = priority;
+    return result;
+}
+
+} // namespace
+
+TEST(MemoryBudgetTest, SplitsTheTotalByShare) {
+    using B = MemoryBudget;
+    const std::vector<B::Cache> caches{cache("decoded", 0.6, 0), cache("tiles", 0.15, 1),
+                                       cache("thumbnails", 0.25, 2)};
+
+    auto limits = B::allocate(caches, {0, 0, 0}, 1000 * MB, B::Pressure::Normal);
+    ASSERT_EQ(limits.size(), 3u);
+    EXPECT_EQ(limits[0], 600 * MB);
+    EXPECT_EQ(limits[1], 150 * MB);
+    EXPECT_EQ(limits[2], 250 * MB);
+
+    // Shares are relative: they need not add up to 1
+    limits = B::allocate({cache("a", 2.0, 0), cache("b", 2.0, 0)}, {}, 100 * MB, B::Pressure::Normal);
+    EXPECT_EQ(limits, std::vector<qint64>({50 * MB, 50 * MB}));
+
+    EXPECT_EQ(B::allocate({cache("a", 0.0, 0)}, {}, 100 * MB, B::Pressure::Normal),
+              std::vector<qint64>({0}));
+    EXPECT_TRUE(B::allocate({}, {}, 100 * MB, B::Pressure::Normal).empty());
+}
+
+TEST(MemoryBudgetTest, PressureCutsTheLowestPriorityFirst) {
+    using B = MemoryBudget;
+    const std::vector<B::Cache> caches{cache("decoded", 0.6, 0), cache("tiles", 0.15, 1),
+                                       cache("thumbnails", 0.25, 2)};
+    const std::vector<qint64> full{600 * MB, 150 * MB, 250 * MB};
+
+    // Warning: half of 1000 MB; decoded images go first, then tiles
+    auto limits = B::allocate(caches, full, 1000 * MB, B::Pressure::Warning);
+    EXPECT_EQ(limits, std::vector<qint64>({100 * MB, 150 * MB, 250 * MB}));
+
+    // Critical: an eighth; only thumbnails are left
+    limits = B::allocate(caches, full, 1000 * MB, B::Pressure::Critical);
+    EXPECT_EQ(limits, std::vector<qint64>({0, 0, 125 * MB}));
+
+    // Caches that already fit keep what they hold, and may not grow
+    limits = B::allocate(caches, {50 * MB, 10 * MB, 20 * MB}, 1000 * MB, B::Pressure::Warning);
+    EXPECT_EQ(limits, std::vector<qint64>({50 * MB, 10 * MB, 20 * MB}));
+
+    // Equal priorities give back in order
+    limits = B::allocate({cache("a", 1.0, 0), cache("b", 1.0, 0)}, {500 * MB, 500 * MB}, 1000 * MB,
+                         B::Pressure::Warning);
+    EXPECT_EQ(limits, std::vector<qint64>({0, 500 * MB}));
+}
+
+TEST(MemoryBudgetTest, DefaultTotalStaysInBounds) {
+    const qint64 total = MemoryBudget::defaultTotal();
+    EXPECT_GE(total, MemoryBudget::MIN_TOTAL);
+    EXPECT_LE(total, MemoryBudget::MAX_TOTAL);
+    if (MemoryBudget::physicalMemory() <= 0) {
+        EXPECT_EQ(total, MemoryBudget::FALLBACK_TOTAL);
+    }
+}
+
+TEST(MemoryBudgetTest, RegisteredCachesFollowTheBudget) {
+    MemoryBudget budget;
+    budget.setTotal(400 * MB);
+    EXPECT_EQ(budget.total(), 400 * MB);
+
+    qint64 heldA = 300 * MB;
+    qint64 limitA = -1;
+    qint64 limitB = -1;
+    MemoryBudget::Cache a = cache("a", 1.0, 0);
+    a.usage = [&heldA]() { return heldA; };
+    a.setLimit = [&limitA](qint64 bytes) { limitA = bytes; };
+    const int idA = budget.addCache(a);
+    EXPECT_EQ(limitA, 400 * MB);
+
+    MemoryBudget::Cache b = cache("b", 1.0, 1);
+    b.usage = []() { return qint64(100) * MB; };
+    b.setLimit = [&limitB](qint64 bytes) { limitB = bytes; };
+    const int idB = budget.addCache(b);
+    EXPECT_NE(idA, idB);
+    EXPECT_EQ(limitA, 200 * MB);
+    EXPECT_EQ(limitB, 200 * MB);
+
+    auto usage = budget.usage();
+    ASSERT_EQ(usage.size(), 2u);
+    EXPECT_EQ(usage[0].name, "a");
+    EXPECT_EQ(usage[0].bytes, 300 * MB);
+    EXPECT_EQ(usage[0].limit, 200 * MB);
+
+    QSignalSpy spy(&budget, &MemoryBudget::pressureChanged);
+    budget.setPressure(MemoryBudget::Pressure::Warning);
+    EXPECT_EQ(spy.count(), 1);
+    EXPECT_EQ(budget.pressure(), MemoryBudget::Pressure::Warning);
+    EXPECT_EQ(limitA, 100 * MB);
+    EXPECT_EQ(limitB, 100 * MB);
+    budget.setPressure(MemoryBudget::Pressure::Warning);
+    EXPECT_EQ(spy.count(), 1);
+
+    // Back to normal: the caps go back up
+    budget.setPressure(MemoryBudget::Pressure::Normal);
+    EXPECT_EQ(spy.count(), 2);
+    EXPECT_EQ(limitA, 200 * MB);
+
+    budget.removeCache(idB);
+    EXPECT_EQ(limitA, 400 * MB);
+    EXPECT_EQ(budget.usage().size(), 1u);
+
+    budget.setTotal(0);
+    EXPECT_EQ(budget.total(), MemoryBudget::defaultTotal());
+    EXPECT_EQ(limitA, MemoryBudget::defaultTotal());
+}
+
+TEST(MemoryBudgetTest, NamesPressure) {
+    EXPECT_EQ(MemoryBudget::pressureName(MemoryBudget::Pressure::Normal), "normal");
+    EXPECT_EQ(MemoryBudget::pressureName(MemoryBudget::Pressure::Warning), "warning");
+    EXPECT_EQ(MemoryBudget::pressureName(MemoryBudget::Pressure::Critical), "critical");
+}
@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+#include "core/MetadataIndex.h"
+#include "core/FilterCriteria.h"
+#include "core/PhotoMetadata.h"
+#include <QElapsedTimer>
+
+using namespace PhotoGuru;
+
+class MetadataIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Small but varied library covering every filtered field
+        const QStringList makes = {"Canon", "Nikon", "SONY", ""};
+        const QStringList categories = {"Landscape", "Portrait", "Street", ""};
+        const QStringList scenes = {"beach", "city", "forest"};
+
+        for (int i = 0; i < 240; i++) {
+            PhotoMetadata photo;
+            photo.filepath = QString("/library/%1/IMG_%2.jpg").arg(i % 7).arg(i);
+            photo.filename = QString("IMG_%1.jpg").arg(i);
+            photo.camera_make = makes[i % makes.size()];
+            photo.camera_model = QString("Model %1").arg(i % 3);
+            photo.iso = (i % 5) * 400;
+            photo.aperture = (i % 6) * 1.4;
+            photo.focal_length = (i % 9) * 25.0;
+            photo.rating = i % 6;
+            photo.face_count = i % 4 == 0 ? 2 : 0;
+            photo.gps_lat = i % 3 == 0 ? 0.0 : 38.7 + (i % 13) * 0.01;
+            photo.gps_lon = i % 5 == 0 ? 0.0 : -9.1 - (i % 17) * 0.01;
+            photo.technical.overall_quality = (i % 10) / 10.0;
+            photo.technical.sharpness_score = ((i * 7) % 10) / 10.0;
+            photo.technical.aesthetic_score = ((i * 3) % 10) / 10.0;
+            photo.technical.is_best_in_burst = i % 2 == 0;
+            photo.technical.blur_detected = i % 7 == 0;
+            if (i % 11 == 0) photo.technical.duplicate_group = "dup1";
+            photo.llm_category = categories[i % categories.size()];
+            photo.llm_scene = scenes[i % scenes.size()];
+            photo.llm_title = i % 2 ? QString("Sunset over the Bay %1").arg(i) : QString();
+            photo.llm_description = i % 3 ? "Golden light and calm water" : "";
+            photo.llm_keywords = i % 4 ? QStringList{"Ocean", "sunset"} : QStringList{"city"};
+            photo.location_name = i % 5 ? "Lisboa" : "";
+            if (i % 8) {
+                photo.datetime_original = QDateTime(QDate(2020 + i % 4, 1 + i % 12, 1), QTime(10, 0));
+            }
+
+            photos.append(photo);
+            paths << photo.filepath;
+            index.upsert(photo);
+        }
+    }
+
+    QStringList expected(const FilterCriteria& criteria) const {
+        QStringList result;
+        for (const PhotoMetadata& photo : photos) {
+            if (criteria.matches(photo)) result << photo.filepath;
+        }
+        return result;
+    }
+
+    QList<PhotoMetadata> photos;
+    QStringList paths;
+    MetadataIndex index;
+};
+
+TEST_F(MetadataIndexTest, DefaultCriteriaMatchesEverything) {
+    FilterCriteria criteria;
+    EXPECT_EQ(index.size(), photos.size());
+    EXPECT_EQ(index.filter(criteria, paths), expected(criteria));
+}
+
+TEST_F(MetadataIndexTest, NumericFiltersMatchReference) {
+    FilterCriteria criteria;
+    criteria.minQuality = 0.3;
+    criteria.minSharpness = 0.2;
+    criteria.minRating = 2;
+    criteria.maxRating = 4;
+    criteria.minISO = 100;
+    criteria.maxISO = 1200;
+    criteria.minAperture = 2.0;
+    criteria.maxFocalLength = 150.0;
+    EXPECT_EQ(index.filter(criteria, paths), expected(criteria));
+}
+
+TEST_F(MetadataIndexTest, FlagFiltersMatchReference) {
+    FilterCriteria criteria;
+    criteria.onlyWithFaces = true;
+    criteria.onlyWithGPS = true;
+    criteria.excludeBlurry = true;
+    criteria.excludeDuplicates = true;
+    EXPECT_EQ(index.filter(criteria, paths), expected(criteria));
+
+    FilterCriteria burst;
+    burst.onlyBestInBurst = true;
+    EXPECT_EQ(index.filter(burst, paths), expected(burst));
+}
+
+TEST_F(MetadataIndexTest, GeoFiltersMatchReference) {
+    FilterCriteria box;
+    box.geoBox = GeoBox{38.72, -9.20, 38.78, -9.12};
+    QStringList boxed = index.filter(box, paths);
+    EXPECT_FALSE(boxed.isEmpty());
+    EXPECT_EQ(boxed, expected(box));
+
+    FilterCriteria radius;
+    radius.geoRadius = GeoCircle{38.75, -9.15, 4000.0};
+    QStringList near = index.filter(radius, paths);
+    EXPECT_FALSE(near.isEmpty());
+    EXPECT_LT(near.size(), paths.size() / 2);
+    EXPECT_EQ(near, expected(radius));
+
+    radius.geoBox = box.geoBox;
+    radius.minRating = 2;
+    EXPECT_EQ(index.filter(radius, paths), expected(radius));
+}
+
+TEST_F(MetadataIndexTest, StringFiltersMatchReference) {
+    FilterCriteria criteria;
+    criteria.cameras = QStringList{"sony", "nikon model 1"};
+    criteria.categories = QStringList{"Landscape", "Street"};
+    criteria.keywords = QStringList{"OCEAN"};
+    EXPECT_EQ(index.filter(criteria, paths), expected(criteria));
+
+    FilterCriteria scenes;
+    scenes.scenes = QStringList{"beach"};
+    EXPECT_EQ(index.filter(scenes, paths), expected(scenes));
+}
+
+TEST_F(MetadataIndexTest, DateRangeMatchesReference) {
+    FilterCriteria criteria;
+    criteria.startDate = QDateTime(QDate(2021, 3, 1), QTime(0, 0));
+    criteria.endDate = QDateTime(QDate(2022, 9, 1), QTime(0, 0));
+    EXPECT_EQ(index.filter(criteria, paths), expected(criteria));
+
+    FilterCriteria endOnly;
+    endOnly.endDate = QDateTime(QDate(2021, 6, 1), QTime(0, 0));
+    EXPECT_EQ(index.filter(endOnly, paths), expected(endOnly)) << "Undated photos pass an end-only range";
+}
+
+TEST_F(MetadataIndexTest, TextSearchMatchesReference) {
+    for (const QString& text : {QString("sunset bay"), QString("LISBOA"), QString("model 2"),
+                                QString("img_1"), QString("golden water"), QString("   ")}) {
+        FilterCriteria criteria;
+        criteria.searchText = text;
+        EXPECT_EQ(index.filter(criteria, paths), expected(criteria)) << text.toStdString();
+
+        criteria.searchCaseSensitive = true;
+        EXPECT_EQ(index.filter(criteria, paths), expected(criteria)) << text.toStdString() << " (case sensitive)";
+    }
+}
+
+TEST_F(MetadataIndexTest, UpsertReplacesRow) {
+    PhotoMetadata photo = photos.first();
+    photo.rating = 5;
+    photo.llm_title = "Replaced title";
+    index.upsert(photo);
+
+    EXPECT_EQ(index.size(), photos.size()) << "Same path must not add a row";
+
+    FilterCriteria criteria;
+    criteria.searchText = "replaced";
+    EXPECT_EQ(index.filter(criteria, paths), QStringList{photo.filepath});
+}
+
+TEST_F(MetadataIndexTest, SnapshotIsIndependent) {
+    MetadataIndex snapshot = index;
+
+    PhotoMetadata extra;
+    extra.filepath = "/library/extra.jpg";
+    extra.filename = "extra.jpg";
+    index.upsert(extra);
+
+    EXPECT_EQ(snapshot.size(), photos.size());
+    EXPECT_FALSE(snapshot.contains(extra.filepath));
+    EXPECT_TRUE(index.contains(extra.filepath));
+}
+
+TEST_F(MetadataIndexTest, CandidatesKeepOrderAndSkipUnknown) {
+    QStringList candidates = {paths[5], "/not/indexed.jpg", paths[1]};
+    EXPECT_EQ(index.filter(FilterCriteria(), candidates), (QStringList{paths[5], paths[1]}));
+}
+
+TEST_F(MetadataIndexTest, RefilterMatchesFullScan) {
+    FilterCriteria base;
+    base.minRating = 2;
+    base.searchText = "sun";
+    QStringList previous = index.filter(base, paths);
+
+    FilterCriteria narrower = base;
+    narrower.minRating = 4;
+    narrower.searchText = "sunset bay";
+    EXPECT_EQ(index.refilter(narrower, paths, base, previous), expected(narrower));
+
+    FilterCriteria wider = base;
+    wider.minRating = 0;
+    wider.searchText.clear();
+    EXPECT_EQ(index.refilter(wider, paths, base, previous), expected(wider));
+
+    FilterCriteria unrelated;
+    unrelated.categories = QStringList{"Street"};
+    EXPECT_EQ(index.refilter(unrelated, paths, base, previous), expected(unrelated));
+}
+
+TEST_F(MetadataIndexTest, RevisionChangesOnWrite) {
+    quint64 before = index.revision();
+    MetadataIndex snapshot = index;
+    EXPECT_EQ(snapshot.revision(), before);
+
+    index.upsert(photos.first());
+    EXPECT_NE(index.revision(), before);
+    EXPECT_EQ(snapshot.revision(), before);
+
+    index.clear();
+    EXPECT_NE(index.revision(), before);
+}
+
+TEST_F(MetadataIndexTest, LargeLibraryNumericScan) {
+    MetadataIndex large;
+    large.reserve(200000);
+    QStringList largePaths;
+    for (int i = 0; i < 200000; i++) {
+        PhotoMetadata photo = photos[i % photos.size()];
+        photo.filepath = QString("/big/%1.jpg").arg(i);
+        largePaths << photo.filepath;
+        large.upsert(photo);
+    }
+
+    FilterCriteria criteria;
+    criteria.minRating = 3;
+    criteria.onlyWithGPS = true;
+    criteria.cameras = QStringList{"canon"};
+
+    QElapsedTimer timer;
+    timer.start();
+    QStringList result = large.filter(criteria, largePaths);
+    qint64 elapsed = timer.elapsed();
+
+    EXPECT_FALSE(result.isEmpty());
+    // Generous bound so slow CI machines don't flake; typical is a few ms
+    EXPECT_LT(elapsed, 200) << "Columnar scan of 200k rows took " << elapsed << "ms";
+}
@@ -119,3 +119,21 @@ TEST_F(MetadataPanelTest, MetadataFieldWidgetsCreation) {
     // This is tested indirectly through loadMetadata working without crashes
     EXPECT_TRUE(true);
 }
+
+// Test that a field row can be refilled for another tag
+TEST_F(MetadataPanelTest, MetadataFieldWidgetReset) {
+    MetadataFieldWidget widget("EXIF:Make", "Canon", false);
+    int changes = 0;
+    QObject::connect(&widget, &MetadataFieldWidget::valueChanged, [&changes]() { changes++; });
+    
+    widget.reset("XMP:Description", QString(200, 'x'), false);
+    EXPECT_EQ(widget.key(), "XMP:Description");
+    EXPECT_EQ(widget.value(), QString(200, 'x'));
+    
+    // Back to a short value: the single-line editor shows it again
+    widget.reset("EXIF:Model", "EOS R5", true);
+    EXPECT_EQ(widget.key(), "EXIF:Model");
+    EXPECT_EQ(widget.value(), "EOS R5");
+    EXPECT_FALSE(widget.isModified());
+    EXPECT_EQ(changes, 0) << "Refilling a row is not an edit";
+}
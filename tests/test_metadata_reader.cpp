@@ -2,6 +2,9 @@
 #include "core/PhotoMetadata.h"
 #include <QFile>
 #include <QTemporaryDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonObject>
 
 using namespace PhotoGuru;
 
@@ -42,3 +45,127 @@ TEST_F(MetadataReaderTest, VerifyExifToolPath) {
         GTEST_SKIP() << "ExifTool not installed, skipping test";
     }
 }
+
+TEST_F(MetadataReaderTest, ReadManyReturnsOneEntryPerFile) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    
+    QStringList paths;
+    for (int i = 0; i < 5; i++) {
+        QString path = tempDir.path() + QString("/many_%1.jpg").arg(i);
+        QImage img(20, 20, QImage::Format_RGB32);
+        img.fill(Qt::cyan);
+        ASSERT_TRUE(img.save(path, "JPEG"));
+        paths << path;
+    }
+    
+    // Unreadable files are skipped without failing the chunk
+    paths << "/nonexistent/missing.jpg";
+    
+    std::vector<PhotoMetadata> results = MetadataReader::instance().readMany(paths);
+    ASSERT_EQ(results.size(), 5u);
+    
+    QStringList returned;
+    for (const PhotoMetadata& meta : results) {
+        returned << meta.filepath;
+    }
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(returned.contains(paths[i])) << "Missing " << paths[i].toStdString();
+    }
+}
+
+TEST_F(MetadataReaderTest, ReadManyEmptyList) {
+    EXPECT_TRUE(MetadataReader::instance().readMany({}).empty());
+}
+
+TEST_F(MetadataReaderTest, ReadCommonCoversEveryReadableFile) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    
+    // JPEGs parse in-process; the PNG goes to ExifTool
+    QStringList paths;
+    for (int i = 0; i < 3; i++) {
+        QString path = tempDir.path() + QString("/common_%1.jpg").arg(i);
+        QImage img(20, 20, QImage::Format_RGB32);
+        img.fill(Qt::green);
+        ASSERT_TRUE(img.save(path, "JPEG"));
+        paths << path;
+    }
+    QString png = tempDir.path() + "/common.png";
+    QImage img(20, 20, QImage::Format_RGB32);
+    img.fill(Qt::blue);
+    ASSERT_TRUE(img.save(png, "PNG"));
+    paths << png << "/nonexistent/missing.jpg";
+    
+    std::vector<PhotoMetadata> results = MetadataReader::instance().readCommon(paths);
+    QStringList returned;
+    for (const PhotoMetadata& meta : results) {
+        returned << meta.filepath;
+    }
+    for (int i = 0; i < 3; i++) {
+        EXPECT_TRUE(returned.contains(paths[i])) << "Missing " << paths[i].toStdString();
+    }
+    EXPECT_FALSE(returned.contains("/nonexistent/missing.jpg"));
+    
+    // Each carries the file version it was read from, fast reader or not
+    for (const PhotoMetadata& meta : results) {
+        QFileInfo info(meta.filepath);
+        EXPECT_EQ(meta.file_mtime, info.lastModified().toMSecsSinceEpoch()) << meta.filepath.toStdString();
+        EXPECT_EQ(meta.file_size, info.size()) << meta.filepath.toStdString();
+    }
+}
+
+TEST_F(MetadataReaderTest, TagArgumentsFollowFields) {
+    QStringList all = MetadataReader::tagArguments(MetadataReader::AllTags);
+    EXPECT_TRUE(all.contains("-a"));
+    
+    // Specific tags only, no dump of everything
+    QStringList rating = MetadataReader::tagArguments(MetadataReader::Rating);
+    EXPECT_FALSE(rating.contains("-a"));
+    EXPECT_TRUE(rating.contains("-Rating"));
+    EXPECT_FALSE(rating.contains("-Make"));
+    EXPECT_TRUE(rating.contains("-json"));
+    
+    QStringList filters = MetadataReader::tagArguments(MetadataReader::FilterSet);
+    EXPECT_FALSE(filters.contains("-a"));
+    for (const char* tag : {"-DateTimeOriginal", "-Make", "-ISO", "-Composite:GPSLatitude",
+                            "-Rating", "-Subject", "-City", "-UserComment"}) {
+        EXPECT_TRUE(filters.contains(tag)) << tag;
+    }
+}
+
+TEST_F(MetadataReaderTest, SidecarTagsWinOverTheImage) {
+    EXPECT_EQ(MetadataReader::sidecarPath("/photos/IMG_0001.CR3"), "/photos/IMG_0001.xmp");
+    EXPECT_EQ(MetadataReader::sidecarPath("/photos/trip.day1.NEF"), "/photos/trip.day1.xmp");
+    // The JPEG of a RAW+JPEG pair keeps clear of the RAW's sidecar
+    EXPECT_EQ(MetadataReader::sidecarPath("/photos/IMG_0001.JPG"), "/photos/IMG_0001.JPG.xmp");
+    
+    QJsonObject image{{"SourceFile", "/photos/IMG_0001.CR3"}, {"FileName", "IMG_0001.CR3"},
+                      {"Rating", 1}, {"Make", "Canon"}, {"Title", "Old"}};
+    QJsonObject sidecar{{"SourceFile", "/photos/IMG_0001.xmp"}, {"FileName", "IMG_0001.xmp"},
+                        {"Rating", 4}, {"Title", "New"}, {"State", "Cape"}};
+    QJsonObject merged = MetadataReader::mergeSidecar(image, sidecar);
+    EXPECT_EQ(merged["SourceFile"].toString(), "/photos/IMG_0001.CR3");
+    EXPECT_EQ(merged["FileName"].toString(), "IMG_0001.CR3");
+    EXPECT_EQ(merged["Rating"].toInt(), 4);
+    EXPECT_EQ(merged["Title"].toString(), "New");
+    EXPECT_EQ(merged["Make"].toString(), "Canon") << "Tags the sidecar doesn't have stay";
+    EXPECT_EQ(merged["Province-State"].toString(), "Cape");
+}
+
+TEST_F(MetadataReaderTest, ReadWithFieldMask) {
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    QString path = tempDir.path() + "/masked.jpg";
+    QImage img(20, 20, QImage::Format_RGB32);
+    img.fill(Qt::gray);
+    ASSERT_TRUE(img.save(path, "JPEG"));
+    
+    auto meta = MetadataReader::instance().read(path, MetadataReader::Rating);
+    if (!meta) {
+        GTEST_SKIP() << "ExifTool not available";
+    }
+    EXPECT_EQ(meta->filepath, path);
+    EXPECT_EQ(meta->filename, "masked.jpg");
+    EXPECT_EQ(meta->rating, 0);
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QFutureWatcher>
+#include <QSignalSpy>
+#include "core/MetadataService.h"
+
+using namespace PhotoGuru;
+
+class MetadataServiceTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    static PhotoMetadata makeMetadata(const QString& path, int rating) {
+        PhotoMetadata meta;
+        meta.filepath = path;
+        meta.rating = rating;
+        return meta;
+    }
+};
+
+TEST_F(MetadataServiceTest, CachedRequestIsReadyAtOnce) {
+    MetadataService service;
+    service.insert(makeMetadata("/photos/a.jpg", 4));
+
+    QFuture<MetadataService::Result> future = service.request("/photos/a.jpg");
+    ASSERT_TRUE(future.isFinished());
+    ASSERT_TRUE(future.result().has_value());
+    EXPECT_EQ(future.result()->rating, 4);
+    EXPECT_FALSE(service.isReading("/photos/a.jpg"));
+}
+
+TEST_F(MetadataServiceTest, SnapshotSharesCachedMetadata) {
+    MetadataService service;
+    service.insert(makeMetadata("/photos/a.jpg", 4));
+
+    PhotoHandle handle = service.handle("/photos/a.jpg");
+    ASSERT_TRUE(handle);
+    EXPECT_EQ(handle->rating, 4);
+    EXPECT_EQ(service.snapshot().value("/photos/a.jpg").get(), handle.get());
+    EXPECT_FALSE(service.handle("/photos/missing.jpg"));
+
+    // A write replaces the handle; holders of the old one keep what they saw
+    service.insert(makeMetadata("/photos/a.jpg", 1));
+    EXPECT_EQ(handle->rating, 4);
+    EXPECT_EQ(service.handle("/photos/a.jpg")->rating, 1);
+}
+
+TEST_F(MetadataServiceTest, RequestsForOneFileShareARead) {
+    MetadataService service;
+    const QString path = "/nonexistent/shared.jpg";
+
+    QFuture<MetadataService::Result> first = service.request(path);
+    QFuture<MetadataService::Result> second = service.request(path);
+    EXPECT_TRUE(service.isReading(path) || first.isFinished());
+
+    first.waitForFinished();
+    second.waitForFinished();
+    EXPECT_FALSE(first.result().has_value());
+    EXPECT_FALSE(second.result().has_value());
+    EXPECT_FALSE(service.isReading(path));
+    EXPECT_FALSE(service.cached(path).has_value());
+}
+
+TEST_F(MetadataServiceTest, PreloadReportsProgress) {
+    MetadataService service;
+    service.insert(makeMetadata("/nonexistent/known.jpg", 2));
+    QStringList paths = {"/nonexistent/known.jpg", "/nonexistent/b.jpg", "/nonexistent/c.jpg"};
+
+    QFutureWatcher<void> watcher;
+    QSignalSpy finished(&watcher, &QFutureWatcher<void>::finished);
+    watcher.setFuture(service.preload(paths));
+    ASSERT_TRUE(finished.wait(10000));
+
+    EXPECT_EQ(watcher.progressMaximum(), 3);
+    EXPECT_EQ(watcher.progressValue(), 3);
+    EXPECT_EQ(service.count(), 1);  // Unreadable files stay out of the cache
+}
+
+TEST_F(MetadataServiceTest, ClearDropsCacheAndPreload) {
+    MetadataService service;
+    service.insert(makeMetadata("/photos/a.jpg", 1));
+
+    QFuture<void> preload = service.preload({"/nonexistent/d.jpg"});
+    service.clear();
+    EXPECT_EQ(service.count(), 0);
+    preload.waitForFinished();
+    EXPECT_EQ(service.count(), 0);
+}
+
+TEST_F(MetadataServiceTest, WritesSignalCacheChangedOnce) {
+    MetadataService service;
+    QSignalSpy changed(&service, &MetadataService::cacheChanged);
+    
+    quint64 start = service.revision();
+    service.insert(makeMetadata("/photos/a.jpg", 1));
+    service.insert(makeMetadata("/photos/b.jpg", 2));
+    EXPECT_NE(service.revision(), start);
+    
+    ASSERT_TRUE(changed.wait(1000));
+    QCoreApplication::processEvents();
+    EXPECT_EQ(changed.count(), 1) << "Writes in one pass are coalesced";
+}
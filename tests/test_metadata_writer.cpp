@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include "core/BackupJournal.h"
 #include "core/MetadataWriter.h"
 #include "core/PhotoMetadata.h"
 #include <QFile>
@@ -194,6 +195,8 @@ TEST_F(MetadataWriterTest, WriteTechnicalMetadata) {
     tech.aesthetic_score = 0.75;
     tech.overall_quality = 0.86;
     tech.face_count = 2;
+    tech.blur_detected = true;
+    tech.highlights_clipped = true;
     
     EXPECT_TRUE(writer.writeTechnicalMetadata(testImagePath, tech));
     
@@ -203,6 +206,9 @@ TEST_F(MetadataWriterTest, WriteTechnicalMetadata) {
         EXPECT_NEAR(meta->technical.sharpness_score, tech.sharpness_score, 0.01);
         EXPECT_NEAR(meta->technical.aesthetic_score, tech.aesthetic_score, 0.01);
         EXPECT_EQ(meta->technical.face_count, tech.face_count);
+        EXPECT_TRUE(meta->technical.blur_detected);
+        EXPECT_TRUE(meta->technical.highlights_clipped);
+        EXPECT_FALSE(meta->technical.shadows_blocked);
     } else {
         GTEST_SKIP() << "Metadata read not yet implemented";
     }
@@ -282,10 +288,10 @@ TEST_F(MetadataWriterTest, CreateBackup) {
     // Create backup
     EXPECT_TRUE(writer.createBackup(testImagePath));
     
-    // Verify backup file exists (format: path/basename_backup.ext)
+    // Kept in the backup journal, not next to the image
+    EXPECT_TRUE(BackupJournal::instance().hasBackup(testImagePath));
     QFileInfo info(testImagePath);
-    QString backupPath = info.path() + "/" + info.baseName() + "_backup." + info.suffix();
-    EXPECT_TRUE(QFile::exists(backupPath));
+    EXPECT_FALSE(QFile::exists(info.path() + "/" + info.baseName() + "_backup." + info.suffix()));
 }
 
 TEST_F(MetadataWriterTest, RestoreFromBackup) {
@@ -300,3 +306,159 @@ TEST_F(MetadataWriterTest, RestoreFromBackup) {
     // Restore from backup
     EXPECT_TRUE(writer.restoreFromBackup(testImagePath));
 }
+
+TEST_F(MetadataWriterTest, TransactionCoalescesFields) {
+    MetadataWriter::Transaction transaction(testImagePath);
+    EXPECT_TRUE(transaction.isEmpty());
+    EXPECT_TRUE(transaction.arguments().isEmpty());
+
+    transaction.setTitle("First").setRating(3).setKeywords({"a"}).addKeywords({"b"});
+    transaction.setTitle("Second");
+
+    QStringList args = transaction.arguments();
+    EXPECT_EQ(args.first(), "-overwrite_original");
+    EXPECT_EQ(args.last(), testImagePath);
+    EXPECT_EQ(args.count("-overwrite_original"), 1) << "One command for every field";
+    EXPECT_TRUE(args.contains("-XMP:Title=Second"));
+    EXPECT_FALSE(args.contains("-XMP:Title=First")) << "Setting a field again replaces it";
+    EXPECT_TRUE(args.contains("-XMP:Rating=3"));
+
+    // Keyword clear comes before both additions
+    int clear = args.indexOf("-XMP:Subject=");
+    EXPECT_GE(clear, 0);
+    EXPECT_GT(args.indexOf("-XMP:Subject+=a"), clear);
+    EXPECT_GT(args.indexOf("-XMP:Subject+=b"), args.indexOf("-XMP:Subject+=a"));
+    EXPECT_EQ(transaction.fields().size(), 3);
+}
+
+TEST_F(MetadataWriterTest, CommitTransactionAndBatch) {
+    MetadataWriter& writer = MetadataWriter::instance();
+
+    MetadataWriter::Transaction transaction(testImagePath);
+    transaction.setTitle("Coalesced").setDescription("One write").setRating(5);
+    EXPECT_TRUE(writer.commit(transaction));
+    EXPECT_TRUE(writer.commit(MetadataWriter::Transaction(testImagePath))) << "Nothing to write";
+
+    QString second = tempDir->path() + "/test_batch_tx.jpg";
+    QImage img(50, 50, QImage::Format_RGB32);
+    img.fill(Qt::red);
+    ASSERT_TRUE(img.save(second, "JPEG"));
+
+    std::vector<bool> results = writer.commitBatch({
+        MetadataWriter::Transaction(testImagePath).setRating(2),
+        MetadataWriter::Transaction("/nonexistent/fake_image.jpg").setRating(2),
+        MetadataWriter::Transaction(second).setKeywords({"batch"})
+    });
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_TRUE(results[0]);
+    EXPECT_FALSE(results[1]);
+    EXPECT_TRUE(results[2]);
+}
+
+TEST_F(MetadataWriterTest, SidecarArgumentsHoldXmpOnly) {
+    using Mode = MetadataWriter::WriteMode;
+    const QString raw = tempDir->path() + "/IMG_0001.NEF";
+    const QString sidecar = tempDir->path() + "/IMG_0001.xmp";
+    EXPECT_EQ(MetadataReader::sidecarPath(raw), sidecar);
+    EXPECT_TRUE(MetadataWriter::usesSidecar(raw, Mode::RawSidecar));
+    EXPECT_FALSE(MetadataWriter::usesSidecar(testImagePath, Mode::RawSidecar));
+    EXPECT_FALSE(MetadataWriter::usesSidecar(raw, Mode::Embedded));
+
+    MetadataWriter::Transaction transaction(raw);
+    transaction.setRating(4).setTitle("Dunes").setGPS(-33.5, 18.25).addKeywords({"sand"});
+
+    // No sidecar yet: start one from the file's XMP
+    QStringList args = transaction.arguments(Mode::RawSidecar);
+    EXPECT_EQ(args.mid(0, 3), (QStringList{"-tagsFromFile", "@", "-xmp:all"}));
+    EXPECT_EQ(args.mid(args.size() - 3), (QStringList{"-o", sidecar, raw}));
+    EXPECT_TRUE(args.contains("-XMP:Rating=4"));
+    EXPECT_TRUE(args.contains("-XMP:Title=Dunes"));
+    EXPECT_TRUE(args.contains("-XMP:GPSLatitude=-33.500000"));
+    EXPECT_TRUE(args.contains("-XMP:Subject+=sand"));
+    for (const QString& arg : args) {
+        EXPECT_FALSE(arg.startsWith("-IPTC:")) << qPrintable(arg);
+        EXPECT_FALSE(arg.contains("Ref=")) << qPrintable(arg);
+    }
+
+    // An existing one is updated in place; the image is never named
+    QFile file(sidecar);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.close();
+    args = transaction.arguments(Mode::RawSidecar);
+    EXPECT_EQ(args.first(), "-overwrite_original");
+    EXPECT_EQ(args.last(), sidecar);
+    EXPECT_FALSE(args.contains(raw));
+}
+
+TEST_F(MetadataWriterTest, SidecarAssignmentMapsTags) {
+    EXPECT_EQ(MetadataWriter::sidecarAssignment("-XMP-photoshop:Category=Nature"), "-XMP-photoshop:Category=Nature");
+    EXPECT_EQ(MetadataWriter::sidecarAssignment("-IPTC:Keywords+=a"), QString());
+    EXPECT_EQ(MetadataWriter::sidecarAssignment("-GPSLatitudeRef=S"), QString());
+    EXPECT_EQ(MetadataWriter::sidecarAssignment("-DateTimeOriginal=2024:01:02 03:04:05"),
+              "-XMP:DateTimeOriginal=2024:01:02 03:04:05");
+    EXPECT_EQ(MetadataWriter::sidecarAssignment("-EXIF:UserComment=PhotoGuru:{}"), "-XMP:UserComment=PhotoGuru:{}");
+    EXPECT_EQ(MetadataWriter::sidecarAssignment("-Subject-=old"), "-XMP:Subject-=old");
+
+    for (auto mode : {MetadataWriter::WriteMode::Embedded, MetadataWriter::WriteMode::RawSidecar,
+                      MetadataWriter::WriteMode::Sidecar}) {
+        EXPECT_EQ(MetadataWriter::writeModeFromName(MetadataWriter::writeModeName(mode)), mode);
+    }
+    EXPECT_FALSE(MetadataWriter::writeModeFromName("elsewhere").has_value());
+
+    // Starting a sidecar from a file without XMP is not a failed write
+    EXPECT_TRUE(MetadataWriter::writeSucceeded("Warning: No writable tags set from /p/a.jpg\n    1 image files created"));
+    EXPECT_FALSE(MetadataWriter::writeSucceeded("Warning: Sorry, IPTC is not supported\n    0 image files updated"));
+}
+
+TEST_F(MetadataWriterTest, SidecarModeLeavesTheImageAlone) {
+    MetadataWriter& writer = MetadataWriter::instance();
+    const QByteArray before = [&]() {
+        QFile file(testImagePath);
+        file.open(QIODevice::ReadOnly);
+        return file.readAll();
+    }();
+
+    writer.setWriteMode(MetadataWriter::WriteMode::Sidecar);
+    const bool rated = writer.updateRating(testImagePath, 5);
+    const bool titled = writer.updateTitle(testImagePath, "From the sidecar");
+    writer.setWriteMode(MetadataWriter::WriteMode::Embedded);
+    ASSERT_TRUE(rated);
+    EXPECT_TRUE(titled) << "Second edit updates the existing sidecar";
+
+    QFile image(testImagePath);
+    ASSERT_TRUE(image.open(QIODevice::ReadOnly));
+    EXPECT_EQ(image.readAll(), before);
+    EXPECT_TRUE(QFileInfo::exists(MetadataReader::sidecarPath(testImagePath)));
+
+    auto metadata = MetadataReader::instance().read(testImagePath);
+    ASSERT_TRUE(metadata.has_value());
+    EXPECT_EQ(metadata->filepath, testImagePath);
+    EXPECT_EQ(metadata->rating, 5);
+    EXPECT_EQ(metadata->llm_title, "From the sidecar");
+}
+
+TEST_F(MetadataWriterTest, SidecarGoesWithTheFile) {
+    const QString raw = tempDir->path() + "/IMG_0002.NEF";
+    const QString renamed = tempDir->path() + "/Dunes.NEF";
+    QFile sidecar(MetadataReader::sidecarPath(raw));
+    ASSERT_TRUE(sidecar.open(QIODevice::WriteOnly));
+    sidecar.write("<x:xmpmeta/>");
+    sidecar.close();
+
+    EXPECT_TRUE(MetadataWriter::transferSidecar(raw, renamed, true));
+    EXPECT_FALSE(QFileInfo::exists(tempDir->path() + "/IMG_0002.xmp"));
+    EXPECT_TRUE(QFileInfo::exists(tempDir->path() + "/Dunes.xmp"));
+
+    // Copies keep the original's
+    const QString copy = tempDir->path() + "/copy.jpg";
+    QFile jpegSidecar(MetadataReader::sidecarPath(testImagePath));
+    ASSERT_TRUE(jpegSidecar.open(QIODevice::WriteOnly));
+    jpegSidecar.close();
+    EXPECT_TRUE(MetadataWriter::transferSidecar(testImagePath, copy, false));
+    EXPECT_TRUE(QFileInfo::exists(MetadataReader::sidecarPath(testImagePath)));
+    EXPECT_TRUE(QFileInfo::exists(copy + ".xmp"));
+
+    // Nothing to carry is not a failure
+    EXPECT_TRUE(MetadataWriter::transferSidecar(tempDir->path() + "/none.jpg",
+                                                tempDir->path() + "/other.jpg", true));
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QSignalSpy>
+#include <QThread>
+#include <QAtomicInt>
+#include "ml/ModelRegistry.h"
+
+using namespace PhotoGuru;
+
+namespace {
+
+struct FakeModel {
+    explicit FakeModel(QAtomicInt* alive) : alive(alive) { alive->ref(); }
+    ~FakeModel() { alive->deref(); }
+    QAtomicInt* alive;
+};
+
+} // namespace
+
+class ModelRegistryTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    // Registers `name` as a FakeModel of `ramBytes`; counts loads in `loads`
+    void add(const QString& name, qint64 ramBytes) {
+        registry.registerModel<FakeModel>(name,
+            [this, ramBytes](ModelRegistry::Footprint* footprint, QString*) {
+            loads.ref();
+            loadThread = QThread::currentThread();
+            footprint->ramBytes = ramBytes;
+            return std::make_unique<FakeModel>(&alive);
+        });
+    }
+
+    QAtomicInt alive{0};
+    QAtomicInt loads{0};
+    QThread* loadThread = nullptr;
+    ModelRegistry registry;  // Last: its models deref `alive` when destroyed
+};
+
+TEST_F(ModelRegistryTest, LoadsOnFirstAcquireAndShares) {
+    add("clip", 100);
+    EXPECT_TRUE(registry.contains("clip"));
+    EXPECT_FALSE(registry.isLoaded("clip")) << "Registering reads nothing";
+    EXPECT_EQ(alive.loadRelaxed(), 0);
+
+    auto first = registry.acquire<FakeModel>("clip");
+    auto second = registry.acquire<FakeModel>("clip");
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(loads.loadRelaxed(), 1);
+    EXPECT_EQ(registry.resident().ramBytes, 100);
+
+    EXPECT_FALSE(registry.acquire<FakeModel>("unknown"));
+}
+
+TEST_F(ModelRegistryTest, PreloadRunsInBackground) {
+    add("clip", 100);
+    QSignalSpy loaded(&registry, &ModelRegistry::modelLoaded);
+
+    // Not waitForFinished(): that may run a queued load on this thread
+    registry.preload("clip");
+    ASSERT_TRUE(loaded.count() == 1 || loaded.wait(2000));
+    EXPECT_EQ(loaded.takeFirst()[1].toBool(), true);
+    EXPECT_TRUE(registry.isLoaded("clip"));
+    EXPECT_NE(loadThread, QThread::currentThread());
+
+    registry.acquire<FakeModel>("clip");
+    EXPECT_EQ(loads.loadRelaxed(), 1) << "Acquire after preload does not load again";
+}
+
+TEST_F(ModelRegistryTest, BudgetUnloadsLeastRecentlyUsedIdleModel) {
+    registry.setBudget({250, 0});
+    add("a", 100);
+    add("b", 100);
+    add("c", 100);
+
+    registry.acquire<FakeModel>("a");  // Released right away
+    auto b = registry.acquire<FakeModel>("b");
+    registry.acquire<FakeModel>("c");
+
+    EXPECT_EQ(registry.loadedModels(), QStringList({"b", "c"}));
+    EXPECT_EQ(alive.loadRelaxed(), 2);
+    EXPECT_EQ(registry.resident().ramBytes, 200);
+
+    // b is held, so loading a again has to evict c
+    registry.acquire<FakeModel>("a");
+    EXPECT_EQ(registry.loadedModels(), QStringList({"a", "b"}));
+    EXPECT_FALSE(registry.unload("b")) << "Held models stay loaded";
+    b.reset();
+    EXPECT_TRUE(registry.unload("b"));
+    EXPECT_EQ(alive.loadRelaxed(), 1);
+}
+
+TEST_F(ModelRegistryTest, IdleModelsUnloadAfterTimeout) {
+    registry.setIdleTimeout(10);
+    add("held", 100);
+    add("idle", 100);
+
+    auto held = registry.acquire<FakeModel>("held");
+    registry.acquire<FakeModel>("idle");
+    QThread::msleep(30);
+    EXPECT_EQ(registry.unloadIdle(), 1);
+    EXPECT_EQ(registry.loadedModels(), QStringList({"held"}));
+
+    held.reset();
+    EXPECT_EQ(registry.unloadIdle(), 0) << "Idle time starts when the last handle goes";
+    QThread::msleep(30);
+    EXPECT_EQ(registry.unloadIdle(), 1);
+    EXPECT_EQ(alive.loadRelaxed(), 0);
+
+    EXPECT_TRUE(registry.acquire<FakeModel>("idle")) << "Unloaded models load again on demand";
+    EXPECT_EQ(loads.loadRelaxed(), 3);
+}
+
+TEST_F(ModelRegistryTest, FailedLoadReportsError) {
+    registry.registerModel<FakeModel>("broken", [](ModelRegistry::Footprint*, QString* error) {
+        *error = "missing weights";
+        return std::unique_ptr<FakeModel>();
+    });
+
+    EXPECT_FALSE(registry.acquire<FakeModel>("broken"));
+    EXPECT_FALSE(registry.isLoaded("broken"));
+    EXPECT_EQ(registry.lastError("broken"), "missing weights");
+}
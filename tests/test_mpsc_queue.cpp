@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "core/MpscQueue.h"
+#include <QString>
+#include <thread>
+#include <vector>
+
+using namespace PhotoGuru;
+
+TEST(MpscQueueTest, CapacityRoundsUpToAPowerOfTwo) {
+    EXPECT_EQ(MpscQueue<int>(5).capacity(), 8);
+    EXPECT_EQ(MpscQueue<int>(8).capacity(), 8);
+    EXPECT_EQ(MpscQueue<int>(0).capacity(), 2);
+}
+
+TEST(MpscQueueTest, PopsInPushOrder) {
+    MpscQueue<QString> queue(4);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop().has_value());
+
+    ASSERT_TRUE(queue.push("a"));
+    ASSERT_TRUE(queue.push("b"));
+    EXPECT_FALSE(queue.empty());
+    EXPECT_EQ(*queue.pop(), "a");
+    EXPECT_EQ(*queue.pop(), "b");
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.claimed(), 2u);
+    EXPECT_EQ(queue.popped(), 2u);
+}
+
+TEST(MpscQueueTest, FullQueueRejectsInsteadOfBlocking) {
+    MpscQueue<int> queue(4);
+    for (int i = 0; i < 4; i++) ASSERT_TRUE(queue.push(i));
+    EXPECT_FALSE(queue.push(4));
+
+    // A popped slot is reusable, around the ring
+    EXPECT_EQ(*queue.pop(), 0);
+    EXPECT_TRUE(queue.push(4));
+    for (int expected = 1; expected <= 4; expected++) EXPECT_EQ(*queue.pop(), expected);
+}
+
+TEST(MpscQueueTest, ConcurrentProducersDeliverEveryItemOnce) {
+    constexpr int PRODUCERS = 4;
+    constexpr int PER_PRODUCER = 20000;
+    MpscQueue<int> queue(256);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < PER_PRODUCER; i++) {
+                while (!queue.push(p * PER_PRODUCER + i)) std::this_thread::yield();
+            }
+        });
+    }
+
+    std::vector<int> seen(PRODUCERS * PER_PRODUCER, 0);
+    std::vector<int> lastFrom(PRODUCERS, -1);
+    int received = 0;
+    while (received < PRODUCERS * PER_PRODUCER) {
+        std::optional<int> item = queue.pop();
+        if (!item) {
+            std::this_thread::yield();
+            continue;
+        }
+        seen[*item]++;
+        // Each producer's own items stay in order
+        const int producer = *item / PER_PRODUCER;
+        EXPECT_GT(*item, lastFrom[producer]);
+        lastFrom[producer] = *item;
+        received++;
+    }
+    for (std::thread& producer : producers) producer.join();
+
+    EXPECT_TRUE(queue.empty());
+    for (int count : seen) ASSERT_EQ(count, 1);
+}
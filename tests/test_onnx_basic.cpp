@@ -2,6 +2,7 @@
 #include "ml/ONNXInference.h"
 #include <QImage>
 #include <QDir>
+#include <QTemporaryDir>
 #include <QDebug>
 #include <QColor>
 
@@ -95,3 +96,34 @@ TEST_F(ONNXBasicTest, DISABLED_CLIPXenovaInference) {
     
     qDebug() << "[TEST] CLIP output size:" << output.value().size();
 }
+
+TEST_F(ONNXBasicTest, DISABLED_SecondLoadComesFromTheCache) {
+    QTemporaryDir cache;
+    ASSERT_TRUE(cache.isValid());
+    ONNXInference::SessionConfig config;
+    config.cacheDirectory = cache.path();
+    const QString model = "/Users/wagnermontes/Documents/GitHub/photoguru/models/mobilenetv2-12.onnx";
+    
+    ONNXInference first;
+    ASSERT_TRUE(first.loadModel(model, config));
+    
+    // The benchmark's pick and, off CoreML, the optimized graph were saved
+    QDir entry(cache.path());
+    const QStringList entries = entry.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    ASSERT_EQ(entries.size(), 1);
+    entry.cd(entries.first());
+    EXPECT_TRUE(entry.exists("provider"));
+    
+    ONNXInference second;
+    ASSERT_TRUE(second.loadModel(model, config));
+    EXPECT_EQ(second.provider(), first.provider());
+    EXPECT_EQ(second.getOutputShape(), first.getOutputShape());
+}
+
+TEST(ONNXSessionConfigTest, ProviderNamesRoundTrip) {
+    for (auto provider : {ONNXInference::Provider::Auto, ONNXInference::Provider::CPU,
+                          ONNXInference::Provider::CoreML, ONNXInference::Provider::CUDA}) {
+        EXPECT_EQ(ONNXInference::providerFromName(ONNXInference::providerName(provider)), provider);
+    }
+    EXPECT_FALSE(ONNXInference::providerFromName("tpu").has_value());
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QBuffer>
+#include <QPainter>
+#include <QFileInfo>
+#include "core/PerceptualHash.h"
+#include "core/PhotoDatabase.h"
+
+using namespace PhotoGuru;
+
+namespace {
+
+// A scene with structure at several scales, different per seed
+QImage scene(int seed, const QSize& size = QSize(640, 480)) {
+    QImage image(size, QImage::Format_RGB32);
+    image.fill(QColor(40 + seed * 30 % 200, 90, 140));
+    QPainter painter(&image);
+    painter.setPen(Qt::NoPen);
+    for (int i = 0; i < 6; ++i) {
+        const int k = seed * 7 + i * 13;
+        painter.setBrush(QColor(k * 37 % 256, k * 91 % 256, k * 53 % 256));
+        painter.drawEllipse(QRectF((k * 29 % 80) / 100.0 * size.width(), (k * 17 % 80) / 100.0 * size.height(),
+                                   size.width() * (0.1 + (k % 5) / 10.0), size.height() * (0.1 + (k % 3) / 8.0)));
+    }
+    return image;
+}
+
+QImage recompressed(const QImage& image, int quality) {
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPEG", quality);
+    return QImage::fromData(jpeg, "JPEG");
+}
+
+} // namespace
+
+TEST(PerceptualHashTest, DistanceCountsDifferingBits) {
+    EXPECT_EQ(PerceptualHash::distance(0, 0), 0);
+    EXPECT_EQ(PerceptualHash::distance(0, ~quint64(0)), 64);
+    EXPECT_EQ(PerceptualHash::distance(0b1011, 0b0110), 3);
+}
+
+TEST(PerceptualHashTest, SurvivesResizeAndRecompression) {
+    const QImage original = scene(1);
+    const quint64 hash = PerceptualHash::compute(original);
+
+    EXPECT_EQ(PerceptualHash::compute(original), hash) << "Deterministic";
+    EXPECT_LE(PerceptualHash::distance(hash, PerceptualHash::compute(
+        original.scaled(160, 120, Qt::IgnoreAspectRatio, Qt::SmoothTransformation))), 4);
+    EXPECT_LE(PerceptualHash::distance(hash, PerceptualHash::compute(recompressed(original, 40))), 4);
+}
+
+TEST(PerceptualHashTest, DifferentScenesAreFarApart) {
+    const quint64 first = PerceptualHash::compute(scene(1));
+    for (int seed = 2; seed < 6; ++seed) {
+        EXPECT_GT(PerceptualHash::distance(first, PerceptualHash::compute(scene(seed))), 12) << seed;
+    }
+    EXPECT_EQ(PerceptualHash::compute(QImage()), 0u);
+}
+
+TEST(PerceptualHashTest, KeepsHashesInTheCatalog) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    ASSERT_TRUE(PhotoDatabase::instance().initialize(dir.filePath("catalog.db")));
+
+    const QString path = dir.filePath("a.png");
+    ASSERT_TRUE(scene(3).save(path));
+    const QString unreadable = dir.filePath("b.jpg");
+    QFile(unreadable).open(QIODevice::WriteOnly);
+
+    QHash<QString, quint64> hashes = PerceptualHash::instance().hashes({path, unreadable});
+    ASSERT_EQ(hashes.size(), 1);
+    EXPECT_LE(PerceptualHash::distance(hashes.value(path), PerceptualHash::compute(scene(3))), 4);
+    EXPECT_EQ(PhotoDatabase::instance().freshPerceptualHashes({path}).value(path), hashes.value(path));
+
+    // A recorded decode is what later lookups return
+    PerceptualHash::instance().record(path, scene(4));
+    EXPECT_EQ(PerceptualHash::instance().hash(path), PerceptualHash::compute(scene(4)));
+
+    PhotoDatabase::instance().close();
+}
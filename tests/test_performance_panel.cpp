@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <QApplication>
+#include <QCheckBox>
+#include <QThreadPool>
+#include <QTreeWidget>
+#include "../src/ui/PerformancePanel.h"
+#include "../src/core/Trace.h"
+
+using namespace PhotoGuru;
+
+class PerformancePanelTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QApplication(argc, argv);
+        }
+    }
+
+    void SetUp() override {
+        Trace::clear();
+        panel = new PerformancePanel();
+    }
+
+    void TearDown() override {
+        delete panel;
+        panel = nullptr;
+        Trace::setEnabled(false);
+        Trace::clear();
+    }
+
+    // Row `name` under the group titled `group`, or null
+    QTreeWidgetItem* find(const QString& group, const QString& name) {
+        QTreeWidget* tree = panel->findChild<QTreeWidget*>();
+        for (int i = 0; tree && i < tree->topLevelItemCount(); i++) {
+            QTreeWidgetItem* top = tree->topLevelItem(i);
+            if (top->text(0) != group) continue;
+            for (int j = 0; j < top->childCount(); j++) {
+                if (top->child(j)->text(0) == name) return top->child(j);
+            }
+        }
+        return nullptr;
+    }
+
+    PerformancePanel* panel = nullptr;
+};
+
+TEST_F(PerformancePanelTest, RecordTogglesTracing) {
+    QCheckBox* record = panel->findChild<QCheckBox*>();
+    ASSERT_NE(record, nullptr);
+    EXPECT_FALSE(record->isChecked());
+
+    record->setChecked(true);
+    EXPECT_TRUE(Trace::enabled());
+    record->setChecked(false);
+    EXPECT_FALSE(Trace::enabled());
+}
+
+TEST_F(PerformancePanelTest, ShowsStagesCachesAndQueues) {
+    Trace::setEnabled(true);
+    TraceMetric& stage = Trace::metric("paneltest.decode", TraceMetric::Timer);
+    for (int i = 0; i < 10; i++) stage.record(2000000);  // 2 ms
+    Trace::metric("paneltest.cache.hit", TraceMetric::Counter).add(9);
+    Trace::metric("paneltest.cache.miss", TraceMetric::Counter).add(1);
+    Trace::gauge(Trace::metric("paneltest.queued", TraceMetric::Gauge), 7);
+
+    panel->refresh();
+
+    QTreeWidgetItem* decode = find("Stages", "paneltest.decode");
+    ASSERT_NE(decode, nullptr);
+    EXPECT_TRUE(decode->text(2).endsWith("ms"));
+
+    QTreeWidgetItem* cache = find("Caches", "paneltest.cache");
+    ASSERT_NE(cache, nullptr);
+    EXPECT_EQ(cache->text(2), "90.0%");
+    EXPECT_EQ(cache->text(3), "9 / 10");
+
+    QTreeWidgetItem* queue = find("Queues", "paneltest.queued");
+    ASSERT_NE(queue, nullptr);
+    EXPECT_EQ(queue->text(2), "7");
+}
+
+TEST_F(PerformancePanelTest, ShowsWatchedPoolsAndProcessMemory) {
+    QThreadPool pool;
+    pool.setMaxThreadCount(3);
+    Trace::watchThreadPool("paneltest", &pool);
+    panel->refresh();
+
+    QTreeWidgetItem* row = find("Thread pools", "paneltest");
+    ASSERT_NE(row, nullptr);
+    EXPECT_EQ(row->text(2), "0 / 3");
+    EXPECT_NE(find("Memory", "Process"), nullptr);
+
+    // Unwatched pools drop out on the next refresh
+    Trace::unwatchThreadPool(&pool);
+    panel->refresh();
+    EXPECT_EQ(find("Thread pools", "paneltest"), nullptr);
+}
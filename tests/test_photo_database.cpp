@@ -2,7 +2,12 @@
 #include "core/PhotoDatabase.h"
 #include "core/PhotoMetadata.h"
 #include <QTemporaryDir>
+#include <QImage>
+#include <QFileInfo>
+#include <QDateTime>
 #include <QDebug>
+#include <QSqlDatabase>
+#include <QThread>
 
 using namespace PhotoGuru;
 
@@ -60,9 +65,391 @@ TEST_F(PhotoDatabaseTest, SingletonBehavior) {
     EXPECT_EQ(&db1, &db2) << "Should return same singleton instance";
 }
 
-// Note: Additional tests for addPhoto, searchByKeywords, etc. will be
-// added once PhotoDatabase implementation is complete (currently marked as TODO)
+TEST_F(PhotoDatabaseTest, StoreAndLoadRoundTrip) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    QString imagePath = tempDir->path() + "/catalog_test.jpg";
+    QImage img(32, 32, QImage::Format_RGB32);
+    img.fill(Qt::blue);
+    ASSERT_TRUE(img.save(imagePath, "JPEG"));
+    
+    PhotoMetadata meta;
+    meta.filepath = imagePath;
+    meta.filename = "catalog_test.jpg";
+    meta.camera_make = "Canon";
+    meta.iso = 400;
+    meta.rating = 4;
+    meta.datetime_original = QDateTime(QDate(2024, 5, 1), QTime(12, 30, 0, 420));
+    meta.sequence_number = 3;
+    meta.burst_id = "A1B2";
+    meta.llm_keywords = QStringList{"beach", "sunset"};
+    meta.technical.overall_quality = 0.8;
+    meta.skp_group_keys = QStringList{"group_1"};
+    
+    ASSERT_TRUE(db.storeMetadata(meta));
+    EXPECT_EQ(db.photoCount(), 1);
+    
+    auto loaded = db.cachedMetadata(imagePath);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->filepath, imagePath);
+    EXPECT_EQ(loaded->camera_make, "Canon");
+    EXPECT_EQ(loaded->iso, 400);
+    EXPECT_EQ(loaded->rating, 4);
+    EXPECT_EQ(loaded->datetime_original, meta.datetime_original) << "Milliseconds survive";
+    EXPECT_EQ(loaded->sequence_number, 3);
+    EXPECT_EQ(loaded->burst_id, "A1B2");
+    EXPECT_EQ(loaded->llm_keywords, meta.llm_keywords);
+    EXPECT_DOUBLE_EQ(loaded->technical.overall_quality, 0.8);
+    EXPECT_EQ(loaded->skp_group_keys, meta.skp_group_keys);
+}
+
+TEST_F(PhotoDatabaseTest, ChangedFileIsStale) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    QString imagePath = tempDir->path() + "/stale_test.jpg";
+    QImage img(32, 32, QImage::Format_RGB32);
+    img.fill(Qt::red);
+    ASSERT_TRUE(img.save(imagePath, "JPEG"));
+    
+    PhotoMetadata meta;
+    meta.filepath = imagePath;
+    ASSERT_TRUE(db.storeMetadata(meta));
+    ASSERT_TRUE(db.cachedMetadata(imagePath).has_value());
+    
+    // Rewrite with different size - catalog entry must no longer match
+    QImage bigger(256, 256, QImage::Format_RGB32);
+    bigger.fill(Qt::green);
+    ASSERT_TRUE(bigger.save(imagePath, "PNG"));
+    
+    EXPECT_FALSE(db.cachedMetadata(imagePath).has_value()) << "Modified file should need a fresh read";
+}
+
+TEST_F(PhotoDatabaseTest, ReadMetadataIsKeyedOnTheVersionRead) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    QString imagePath = tempDir->path() + "/versioned.jpg";
+    QImage img(32, 32, QImage::Format_RGB32);
+    img.fill(Qt::red);
+    ASSERT_TRUE(img.save(imagePath, "JPEG"));
+    QFileInfo info(imagePath);
+    
+    PhotoMetadata meta;
+    meta.filepath = imagePath;
+    meta.rating = 2;
+    EXPECT_TRUE(db.storeReadMetadata({meta}));
+    EXPECT_FALSE(db.cachedMetadata(imagePath).has_value()) << "Unversioned: not stored";
+    
+    // Read before a write that changed the file: stored, but stale
+    meta.file_mtime = info.lastModified().toMSecsSinceEpoch() - 1000;
+    meta.file_size = info.size();
+    ASSERT_TRUE(db.storeReadMetadata({meta}));
+    EXPECT_FALSE(db.cachedMetadata(imagePath).has_value()) << "Old tags under the new version";
+    
+    meta.file_mtime = info.lastModified().toMSecsSinceEpoch();
+    ASSERT_TRUE(db.storeReadMetadata({meta}));
+    auto loaded = db.cachedMetadata(imagePath);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->rating, 2);
+    EXPECT_EQ(loaded->file_mtime, meta.file_mtime);
+    EXPECT_EQ(loaded->file_size, meta.file_size);
+}
+
+TEST_F(PhotoDatabaseTest, LoadFreshMetadataSkipsUnknownFiles) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    QStringList paths;
+    QList<PhotoMetadata> metas;
+    for (int i = 0; i < 5; ++i) {
+        QString path = tempDir->path() + QString("/batch_%1.jpg").arg(i);
+        QImage img(16, 16, QImage::Format_RGB32);
+        img.fill(Qt::white);
+        ASSERT_TRUE(img.save(path, "JPEG"));
+        paths << path;
+        
+        // Only catalog the first three
+        if (i < 3) {
+            PhotoMetadata meta;
+            meta.filepath = path;
+            meta.rating = i;
+            metas << meta;
+        }
+    }
+    
+    ASSERT_TRUE(db.storeMetadataBatch(metas));
+    
+    auto fresh = db.loadFreshMetadata(paths);
+    EXPECT_EQ(fresh.size(), 3);
+    EXPECT_TRUE(fresh.contains(paths[2]));
+    EXPECT_FALSE(fresh.contains(paths[4]));
+    EXPECT_EQ(fresh.value(paths[1]).rating, 1);
+}
+
+TEST_F(PhotoDatabaseTest, PerceptualHashesFollowTheFileVersion) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    QString imagePath = tempDir->path() + "/hashed.jpg";
+    QImage img(16, 16, QImage::Format_RGB32);
+    img.fill(Qt::white);
+    ASSERT_TRUE(img.save(imagePath, "JPEG"));
+    QFileInfo info(imagePath);
+    
+    const quint64 hash = 0xF00DCAFE12345678ULL;  // High bit set: stored as a negative integer
+    ASSERT_TRUE(db.storePerceptualHash(imagePath, info.lastModified().toMSecsSinceEpoch(), info.size(), hash));
+    auto fresh = db.freshPerceptualHashes({imagePath, tempDir->path() + "/missing.jpg"});
+    ASSERT_EQ(fresh.size(), 1);
+    EXPECT_EQ(fresh.value(imagePath), hash);
+    
+    ASSERT_TRUE(db.storePerceptualHash(imagePath, info.lastModified().toMSecsSinceEpoch() - 1000, info.size(), hash));
+    EXPECT_TRUE(db.freshPerceptualHashes({imagePath}).isEmpty()) << "Hash of an older version";
+}
+
+TEST_F(PhotoDatabaseTest, PersistsAcrossReopen) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    QString imagePath = tempDir->path() + "/persist_test.jpg";
+    QImage img(16, 16, QImage::Format_RGB32);
+    img.fill(Qt::black);
+    ASSERT_TRUE(img.save(imagePath, "JPEG"));
+    
+    PhotoMetadata meta;
+    meta.filepath = imagePath;
+    meta.llm_title = "Persisted";
+    ASSERT_TRUE(db.storeMetadata(meta));
+    
+    db.close();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    auto loaded = db.cachedMetadata(imagePath);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->llm_title, "Persisted");
+}
+
+TEST_F(PhotoDatabaseTest, RemovePhoto) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    QString imagePath = tempDir->path() + "/remove_test.jpg";
+    QImage img(16, 16, QImage::Format_RGB32);
+    img.fill(Qt::gray);
+    ASSERT_TRUE(img.save(imagePath, "JPEG"));
+    
+    PhotoMetadata meta;
+    meta.filepath = imagePath;
+    ASSERT_TRUE(db.storeMetadata(meta));
+    ASSERT_EQ(db.photoCount(), 1);
+    
+    EXPECT_TRUE(db.removePhoto(imagePath));
+    EXPECT_EQ(db.photoCount(), 0);
+}
+
+TEST_F(PhotoDatabaseTest, SemanticKeyIndexFindsPhotosByKey) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    QList<PhotoMetadata> metas;
+    for (const QString& name : {"alice.jpg", "alice_bob.jpg", "bob.jpg"}) {
+        QString imagePath = tempDir->path() + "/" + name;
+        QImage img(16, 16, QImage::Format_RGB32);
+        img.fill(Qt::green);
+        ASSERT_TRUE(img.save(imagePath, "JPEG"));
+        PhotoMetadata meta;
+        meta.filepath = imagePath;
+        metas << meta;
+    }
+    metas[0].skp_person_keys = {SemanticKeyData{"person_alice", "anchor", {}}};
+    metas[0].skp_image_key = SemanticKeyData{"image_1", "composite", {}};
+    metas[1].skp_person_keys = {SemanticKeyData{"person_alice", "anchor", {}},
+                                SemanticKeyData{"person_bob", "anchor", {}}};
+    metas[1].skp_group_keys = QStringList{"group_trip"};
+    metas[2].skp_person_keys = {SemanticKeyData{"person_bob", "gate", {}}};
+    metas[2].skp_group_keys = QStringList{"group_trip"};
+    ASSERT_TRUE(db.storeMetadataBatch(metas));
+    
+    auto alice = db.photosWithKey("person_alice");
+    ASSERT_EQ(alice.size(), 2);
+    EXPECT_EQ(alice[0].path, metas[0].filepath);
+    EXPECT_EQ(alice[1].path, metas[1].filepath);
+    EXPECT_EQ(alice[0].kind, "person");
+    
+    auto trip = db.photosWithKey("group_trip");
+    ASSERT_EQ(trip.size(), 2);
+    EXPECT_EQ(trip[0].role, "link");
+    
+    // By role
+    auto bobAnchors = db.photosWithKey("person_bob", "anchor");
+    ASSERT_EQ(bobAnchors.size(), 1);
+    EXPECT_EQ(bobAnchors[0].path, metas[1].filepath);
+    EXPECT_TRUE(db.photosWithKey("unknown").isEmpty());
+    
+    // Re-storing a photo replaces its keys; removing it drops them
+    metas[0].skp_person_keys.clear();
+    ASSERT_TRUE(db.storeMetadata(metas[0]));
+    EXPECT_EQ(db.photosWithKey("person_alice").size(), 1);
+    EXPECT_TRUE(db.photosWithKey("image_1").isEmpty());
+    ASSERT_TRUE(db.removePhoto(metas[1].filepath));
+    EXPECT_TRUE(db.photosWithKey("person_alice").isEmpty());
+    EXPECT_EQ(db.photosWithKey("group_trip").size(), 1);
+}
+
+TEST_F(PhotoDatabaseTest, AnalysisJobResumesWhereItStopped) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    QStringList paths;
+    for (int i = 0; i < 3; ++i) {
+        QString path = tempDir->path() + QString("/job_%1.jpg").arg(i);
+        QImage img(16, 16, QImage::Format_RGB32);
+        img.fill(Qt::blue);
+        ASSERT_TRUE(img.save(path, "JPEG"));
+        paths << path;
+    }
+    
+    auto job = db.openAnalysisJob(tempDir->path(), paths, "clip:v1");
+    ASSERT_TRUE(job.has_value());
+    EXPECT_FALSE(job->resumed);
+    EXPECT_EQ(job->files.size(), 3);
+    EXPECT_EQ(job->files.value(paths[0]).stages, 0);
+    
+    // Stage bits: 1 embedded, 2 captioned, 4 written
+    EXPECT_TRUE(db.checkpointAnalysisFile(job->id, paths[0], 1));
+    EXPECT_TRUE(db.checkpointAnalysisFile(job->id, paths[0], 2, "A blue square"));
+    EXPECT_TRUE(db.checkpointAnalysisFile(job->id, paths[1], 7));
+    EXPECT_FALSE(db.checkpointAnalysisFile(job->id, tempDir->path() + "/missing.jpg", 1));
+    
+    // Interrupted: reopening (after a crash, too) resumes
+    db.close();
+    ASSERT_TRUE(db.initialize(dbPath));
+    auto resumed = db.openAnalysisJob(tempDir->path(), paths, "clip:v1");
+    ASSERT_TRUE(resumed.has_value());
+    EXPECT_EQ(resumed->id, job->id);
+    EXPECT_TRUE(resumed->resumed);
+    EXPECT_EQ(resumed->files.value(paths[0]).stages, 3);
+    EXPECT_EQ(resumed->files.value(paths[0]).caption, "A blue square");
+    EXPECT_EQ(resumed->files.value(paths[1]).stages, 7);
+    EXPECT_EQ(resumed->files.value(paths[2]).stages, 0);
+    
+    // A file changed since its checkpoint starts over
+    QImage bigger(64, 64, QImage::Format_RGB32);
+    bigger.fill(Qt::yellow);
+    ASSERT_TRUE(bigger.save(paths[1], "PNG"));
+    ASSERT_TRUE(db.finishAnalysisJob(job->id));
+    auto next = db.openAnalysisJob(tempDir->path(), paths, "clip:v1");
+    ASSERT_TRUE(next.has_value());
+    EXPECT_FALSE(next->resumed) << "The last run finished";
+    EXPECT_EQ(next->files.value(paths[1]).stages, 0);
+    EXPECT_EQ(next->files.value(paths[0]).stages, 3);
+    
+    // Another model's results do not count
+    auto upgraded = db.openAnalysisJob(tempDir->path(), paths, "clip:v2");
+    ASSERT_TRUE(upgraded.has_value());
+    EXPECT_EQ(upgraded->files.value(paths[0]).stages, 0);
+    EXPECT_TRUE(db.checkpointAnalysisFile(upgraded->id, paths[0], 7));
+    EXPECT_EQ(db.openAnalysisJob(tempDir->path(), paths, "clip:v2")->files.value(paths[0]).stages, 7);
+    
+    auto restarted = db.openAnalysisJob(tempDir->path(), paths, "clip:v2", true);
+    ASSERT_TRUE(restarted.has_value());
+    EXPECT_EQ(restarted->files.value(paths[0]).stages, 0);
+    EXPECT_TRUE(restarted->files.value(paths[0]).caption.isEmpty());
+}
 
+TEST_F(PhotoDatabaseTest, FacesGroupIntoPeopleKeys) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    QStringList paths;
+    QList<PhotoMetadata> metas;
+    for (const QString& name : {"two_faces.jpg", "one_face.jpg"}) {
+        QString imagePath = tempDir->path() + "/" + name;
+        QImage img(16, 16, QImage::Format_RGB32);
+        img.fill(Qt::red);
+        ASSERT_TRUE(img.save(imagePath, "JPEG"));
+        PhotoMetadata meta;
+        meta.filepath = imagePath;
+        meta.skp_person_keys = {SemanticKeyData{"person_tagged", "anchor", {}}};
+        metas << meta;
+        paths << imagePath;
+    }
+    ASSERT_TRUE(db.storeMetadataBatch(metas));
+    
+    auto face = [](const QString& path, std::vector<float> embedding) {
+        PhotoDatabase::Face f;
+        f.path = path;
+        f.box = QRectF(0.1, 0.2, 0.3, 0.4);
+        f.score = 0.9f;
+        f.embedding = std::move(embedding);
+        return f;
+    };
+    auto stamp = [](const QString& path) {
+        QFileInfo info(path);
+        return std::make_pair(info.lastModified().toMSecsSinceEpoch(), info.size());
+    };
+    auto [mtime0, size0] = stamp(paths[0]);
+    auto [mtime1, size1] = stamp(paths[1]);
+    ASSERT_TRUE(db.storeFaces(paths[0], mtime0, size0, {face(paths[0], {1, 0}), face(paths[0], {})}));
+    ASSERT_TRUE(db.storeFaces(paths[1], mtime1, size1, {face(paths[1], {0.8f, 0.6f})}));
+    
+    QHash<QString, int> counts = db.freshFaceCounts(paths);
+    EXPECT_EQ(counts.value(paths[0]), 2);
+    EXPECT_EQ(counts.value(paths[1]), 1);
+    
+    // Only faces with an embedding wait for a person
+    std::vector<PhotoDatabase::Face> unclustered = db.unclusteredFaces(10);
+    ASSERT_EQ(unclustered.size(), 2u);
+    EXPECT_EQ(unclustered[0].path, paths[0]);
+    EXPECT_EQ(unclustered[0].embedding, std::vector<float>({1, 0}));
+    EXPECT_NEAR(unclustered[1].box.height(), 0.4, 1e-6);
+    EXPECT_TRUE(db.people().empty());
+    
+    std::vector<PhotoDatabase::Person> people = {PhotoDatabase::Person{0, {0.95f, 0.3f}, 2}};
+    QHash<qint64, int> personOfFace{{unclustered[0].id, 0}, {unclustered[1].id, 0}};
+    ASSERT_TRUE(db.storePeople(people, personOfFace));
+    ASSERT_GT(people[0].id, 0);
+    EXPECT_TRUE(db.unclusteredFaces(10).empty());
+    ASSERT_EQ(db.people().size(), 1u);
+    EXPECT_EQ(db.people()[0].faces, 2);
+    
+    // The catalog rows pick up the face count and the person; other keys stay
+    ASSERT_TRUE(db.refreshFaceMetadata(paths));
+    const QString key = PhotoDatabase::personKey(people[0].id);
+    EXPECT_EQ(db.photosWithKey(key).size(), 2);
+    EXPECT_EQ(db.photosWithKey("person_tagged").size(), 2);
+    QHash<QString, PhotoMetadata> fresh = db.loadFreshMetadata(paths);
+    EXPECT_EQ(fresh.value(paths[0]).face_count, 2);
+    EXPECT_EQ(fresh.value(paths[0]).skp_person_keys.size(), 2u);
+    
+    // A changed file is scanned again
+    QImage bigger(64, 64, QImage::Format_RGB32);
+    bigger.fill(Qt::yellow);
+    ASSERT_TRUE(bigger.save(paths[1], "PNG"));
+    EXPECT_FALSE(db.freshFaceCounts(paths).contains(paths[1]));
+    
+    ASSERT_TRUE(db.removePhoto(paths[0]));
+    EXPECT_TRUE(db.freshFaceCounts(paths).isEmpty());
+    EXPECT_EQ(db.photosWithKey(key).size(), 1);
+}
+
+TEST_F(PhotoDatabaseTest, ThreadsThatFinishTakeTheirConnectionWith) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    const int connections = QSqlDatabase::connectionNames().size();
+
+    // Pool threads expire and new ones may reuse the address: each gets a working connection
+    for (int i = 0; i < 3; ++i) {
+        int count = -1;
+        QThread* thread = QThread::create([&]() { count = db.photoCount(); });
+        thread->start();
+        ASSERT_TRUE(thread->wait(5000));
+        delete thread;
+        EXPECT_EQ(count, 0) << i;
+        EXPECT_EQ(QSqlDatabase::connectionNames().size(), connections) << i;
+    }
+}
 
 TEST_F(PhotoDatabaseTest, InitializeInvalidPath) {
     PhotoDatabase& db = PhotoDatabase::instance();
@@ -74,3 +461,166 @@ TEST_F(PhotoDatabaseTest, InitializeInvalidPath) {
     // This test documents expected behavior
     SUCCEED() << "Documented: invalid path handling";
 }
+
+TEST_F(PhotoDatabaseTest, ChangeLogFollowsWritesAndRemovals) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    const QString id = db.catalogId();
+    EXPECT_FALSE(id.isEmpty());
+    
+    QString imagePath = tempDir->path() + "/logged.jpg";
+    QImage img(16, 16, QImage::Format_RGB32);
+    img.fill(Qt::red);
+    ASSERT_TRUE(img.save(imagePath, "JPEG"));
+    QFileInfo info(imagePath);
+    
+    PhotoMetadata meta;
+    meta.filepath = imagePath;
+    meta.llm_title = "Logged";
+    ASSERT_TRUE(db.storeMetadata(meta));
+    ASSERT_TRUE(db.storePerceptualHash(imagePath, info.lastModified().toMSecsSinceEpoch(), info.size(), 42));
+    
+    // One entry per path, however many writes it took
+    const qint64 stored = db.changeSequence();
+    auto changes = db.changesSince(0, 100);
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].seq, stored);
+    EXPECT_EQ(changes[0].path, imagePath);
+    EXPECT_FALSE(changes[0].metadata.isEmpty());
+    ASSERT_TRUE(changes[0].perceptualHash.has_value());
+    EXPECT_EQ(changes[0].perceptualHash->hash, 42u);
+    EXPECT_TRUE(db.changesSince(stored, 100).empty());
+    
+    ASSERT_TRUE(db.removePhoto(imagePath));
+    changes = db.changesSince(stored, 100);
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_GT(changes[0].seq, stored);
+    EXPECT_TRUE(changes[0].metadata.isEmpty());
+    EXPECT_TRUE(changes[0].removed);
+    
+    // Fingerprinting the path again doesn't bring the photo back
+    ASSERT_TRUE(db.storeFingerprint(PhotoDatabase::Fingerprint{imagePath, 1, 2, "quick", {}}));
+    changes = db.changesSince(stored, 100);
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_TRUE(changes[0].removed);
+    EXPECT_TRUE(changes[0].fingerprint.has_value());
+    
+    // Nor is a path that was only ever fingerprinted a removal
+    const QString fingerprinted = tempDir->path() + "/fingerprinted.jpg";
+    ASSERT_TRUE(db.storeFingerprint(PhotoDatabase::Fingerprint{fingerprinted, 1, 2, "quick", {}}));
+    changes = db.changesSince(db.changeSequence() - 1, 100);
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].path, fingerprinted);
+    EXPECT_FALSE(changes[0].removed);
+    
+    db.close();
+    ASSERT_TRUE(db.initialize(dbPath));
+    EXPECT_EQ(db.catalogId(), id);
+}
+
+TEST_F(PhotoDatabaseTest, AppliesChangesOfAnotherCatalog) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    QString imagePath = tempDir->path() + "/applied.jpg";
+    QImage img(16, 16, QImage::Format_RGB32);
+    img.fill(Qt::green);
+    ASSERT_TRUE(img.save(imagePath, "JPEG"));
+    
+    PhotoMetadata meta;
+    meta.filepath = imagePath;
+    meta.llm_title = "Applied";
+    ASSERT_TRUE(db.storeMetadata(meta));
+    std::vector<PhotoDatabase::CatalogRecord> records = db.changesSince(0, 100);
+    ASSERT_EQ(records.size(), 1u);
+    ASSERT_TRUE(db.removePhoto(imagePath));
+    ASSERT_FALSE(db.cachedMetadata(imagePath).has_value());
+    
+    ASSERT_TRUE(db.applyChanges(records));
+    auto loaded = db.cachedMetadata(imagePath);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->llm_title, "Applied");
+    
+    // Without metadata but not removed (a path only fingerprinted there): ours stays
+    records[0].metadata.clear();
+    ASSERT_TRUE(db.applyChanges(records));
+    EXPECT_EQ(db.photoCount(), 1);
+    
+    records[0].removed = true;
+    ASSERT_TRUE(db.applyChanges(records));
+    EXPECT_EQ(db.photoCount(), 0);
+}
+
+TEST_F(PhotoDatabaseTest, SyncCursorsPersist) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    EXPECT_FALSE(db.syncCursor("changes server").has_value());
+    
+    ASSERT_TRUE(db.setSyncCursor("changes server", PhotoDatabase::SyncCursor{"origin", 17}));
+    ASSERT_TRUE(db.setSyncCursor("changes server", PhotoDatabase::SyncCursor{"origin", 23}));
+    db.close();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    auto cursor = db.syncCursor("changes server");
+    ASSERT_TRUE(cursor.has_value());
+    EXPECT_EQ(cursor->origin, "origin");
+    EXPECT_EQ(cursor->position, 23);
+}
+
+TEST_F(PhotoDatabaseTest, SmartAlbumMembersFollowWrites) {
+    PhotoDatabase& db = PhotoDatabase::instance();
+    ASSERT_TRUE(db.initialize(dbPath));
+    
+    QStringList paths;
+    for (int i = 0; i < 3; ++i) {
+        QString imagePath = tempDir->path() + QString("/album_%1.jpg").arg(i);
+        QImage img(16, 16, QImage::Format_RGB32);
+        img.fill(Qt::blue);
+        ASSERT_TRUE(img.save(imagePath, "JPEG"));
+        PhotoMetadata meta;
+        meta.filepath = imagePath;
+        meta.rating = i == 0 ? 5 : 2;
+        ASSERT_TRUE(db.storeMetadata(meta));
+        paths << QFileInfo(imagePath).absoluteFilePath();
+    }
+    
+    // Existing photos are found when the album is created
+    FilterCriteria fiveStars;
+    fiveStars.minRating = 5;
+    auto id = db.createSmartAlbum("Five stars", fiveStars);
+    ASSERT_TRUE(id.has_value());
+    EXPECT_EQ(db.smartAlbumPhotos(*id), QStringList{paths[0]});
+    EXPECT_FALSE(db.createSmartAlbum("Five stars", FilterCriteria())) << "Names are unique";
+    
+    // Later writes join or leave it without another pass
+    PhotoMetadata rated;
+    rated.filepath = paths[1];
+    rated.rating = 5;
+    ASSERT_TRUE(db.storeMetadata(rated));
+    PhotoMetadata unrated;
+    unrated.filepath = paths[0];
+    unrated.rating = 1;
+    ASSERT_TRUE(db.storeMetadata(unrated));
+    EXPECT_EQ(db.smartAlbumPhotos(*id), QStringList{paths[1]});
+    
+    ASSERT_TRUE(db.removePhoto(paths[1]));
+    EXPECT_TRUE(db.smartAlbumPhotos(*id).isEmpty());
+    
+    // New criteria refill it
+    FilterCriteria twoStars;
+    twoStars.minRating = 2;
+    twoStars.maxRating = 2;
+    ASSERT_TRUE(db.updateSmartAlbum(*id, "Two stars", twoStars));
+    EXPECT_EQ(db.smartAlbumPhotos(*id), QStringList{paths[2]});
+    
+    auto albums = db.smartAlbums();
+    ASSERT_EQ(albums.size(), 1u);
+    EXPECT_EQ(albums[0].name, "Two stars");
+    EXPECT_EQ(albums[0].photos, 1);
+    EXPECT_EQ(albums[0].criteria.maxRating, 2);
+    
+    ASSERT_TRUE(db.removeSmartAlbum(*id));
+    EXPECT_TRUE(db.smartAlbums().empty());
+    EXPECT_TRUE(db.smartAlbumPhotos(*id).isEmpty());
+    EXPECT_EQ(db.photoCount(), 2) << "Photos stay";
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "core/PixelBuffer.h"
+
+using namespace PhotoGuru;
+
+TEST(PixelBufferTest, WrapFreesWithTheLastView) {
+    auto* data = new uchar[30 * 10 * 3]();
+    int released = 0;
+    QImage view;
+    {
+        PixelBuffer buffer = PixelBuffer::wrap(data, 30, 10, 90, QImage::Format_RGB888, [&]() {
+            delete[] data;
+            released++;
+        });
+        ASSERT_FALSE(buffer.isNull());
+        EXPECT_EQ(buffer.constBits(), data) << "Adopted, not copied";
+        EXPECT_TRUE(buffer.isPacked());
+        view = buffer.image();
+    }
+    EXPECT_EQ(released, 0) << "The QImage still holds the pixels";
+    EXPECT_EQ(view.constBits(), data);
+    view = QImage();
+    EXPECT_EQ(released, 1);
+}
+
+TEST(PixelBufferTest, MatViewsShareThePixels) {
+    QImage image(16, 8, QImage::Format_Grayscale8);
+    image.fill(7);
+    PixelBuffer buffer(image);
+
+    cv::Mat mat = buffer.mat();
+    EXPECT_EQ(mat.type(), CV_8UC1);
+    EXPECT_EQ(mat.cols, 16);
+    EXPECT_EQ(mat.rows, 8);
+    EXPECT_EQ(mat.data, image.constBits());
+    EXPECT_EQ(mat.at<uchar>(3, 5), 7);
+
+    EXPECT_EQ(PixelBuffer(image.convertToFormat(QImage::Format_RGB32)).mat().type(), CV_8UC4);
+    EXPECT_TRUE(PixelBuffer(QImage(8, 8, QImage::Format_Mono)).mat().empty());
+}
+
+TEST(PixelBufferTest, FromMatKeepsTheMatAlive) {
+    cv::Mat bgr(4, 6, CV_8UC3, cv::Scalar(255, 0, 0));  // Blue
+    const uchar* pixels = bgr.data;
+    QImage image = PixelBuffer::fromMat(bgr).image();
+    bgr.release();
+
+    ASSERT_FALSE(image.isNull());
+    EXPECT_EQ(image.constBits(), pixels) << "No copy of the Mat";
+    EXPECT_EQ(image.format(), QImage::Format_BGR888);
+    EXPECT_EQ(image.pixelColor(2, 1), QColor(Qt::blue));
+
+    EXPECT_TRUE(PixelBuffer::fromMat(cv::Mat(4, 4, CV_32FC1)).isNull());
+    EXPECT_TRUE(PixelBuffer::fromMat(cv::Mat()).isNull());
+}
+
+TEST(PixelBufferTest, PackedAndConvertedShareWhenTheyCan) {
+    QImage rgb(5, 3, QImage::Format_RGB888);  // 15 bytes per row, padded to 16
+    rgb.fill(Qt::red);
+    PixelBuffer buffer(rgb);
+    ASSERT_FALSE(buffer.isPacked());
+
+    PixelBuffer packed = buffer.packed();
+    EXPECT_TRUE(packed.isPacked());
+    EXPECT_EQ(packed.stride(), 15);
+    EXPECT_EQ(packed.image().pixelColor(4, 2), QColor(Qt::red));
+    EXPECT_EQ(packed.packed().constBits(), packed.constBits());
+
+    EXPECT_EQ(buffer.converted(QImage::Format_RGB888).constBits(), rgb.constBits());
+    EXPECT_EQ(buffer.converted(QImage::Format_RGB32).format(), QImage::Format_RGB32);
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QSignalSpy>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QThread>
+#include "ml/QualityAnalyzer.h"
+#include "core/PhotoMetadata.h"
+
+using namespace PhotoGuru;
+
+class QualityAnalyzerTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    // Mid-grey 8x8 checkerboard, the kind of detail a focused lens resolves
+    static QImage checkerboard(int size = 256) {
+        QImage image(size, size, QImage::Format_RGB32);
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                int level = ((x / 8 + y / 8) % 2) ? 170 : 90;
+                image.setPixel(x, y, qRgb(level, level, level));
+            }
+        }
+        return image;
+    }
+
+    // The same, smeared well past the checks
+    static QImage blurred(const QImage& image) {
+        QImage small = image.scaled(image.width() / 16, image.height() / 16,
+                                    Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        return small.scaled(image.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    static QImage filled(int level) {
+        QImage image(128, 128, QImage::Format_RGB32);
+        image.fill(qRgb(level, level, level));
+        return image;
+    }
+
+    // "<n>.jpg" decodes to the checkerboard, "bad_<n>.jpg" fails
+    QualityAnalyzer::Stages fakeStages() {
+        QualityAnalyzer::Stages stages;
+        stages.decode = [](const QString& path) {
+            return path.contains("bad_") ? QImage() : checkerboard(64);
+        };
+        stages.write = [this](const QList<QualityAnalyzer::Result>& results) {
+            QMutexLocker lock(&mutex);
+            batches << results.size();
+            for (const QualityAnalyzer::Result& result : results) written << result.path;
+            return std::vector<bool>(size_t(results.size()), true);
+        };
+        return stages;
+    }
+
+    QMutex mutex;
+    QStringList written;
+    QList<int> batches;
+};
+
+TEST_F(QualityAnalyzerTest, SharpDetailScoresAboveBlur) {
+    QualityAnalyzer::Scores sharp = QualityAnalyzer::measure(checkerboard());
+    QualityAnalyzer::Scores soft = QualityAnalyzer::measure(blurred(checkerboard()));
+
+    EXPECT_GT(sharp.sharpness, 0.5);
+    EXPECT_LT(soft.sharpness, 0.5);
+    EXPECT_FALSE(sharp.blurry);
+    EXPECT_TRUE(soft.blurry);
+    EXPECT_GT(sharp.laplacianVariance, soft.laplacianVariance);
+}
+
+TEST_F(QualityAnalyzerTest, HistogramFlagsClipping) {
+    QualityAnalyzer::Scores white = QualityAnalyzer::measure(filled(255));
+    QualityAnalyzer::Scores black = QualityAnalyzer::measure(filled(0));
+    QualityAnalyzer::Scores grey = QualityAnalyzer::measure(filled(128));
+
+    EXPECT_TRUE(white.highlightsClipped);
+    EXPECT_FALSE(white.shadowsBlocked);
+    EXPECT_TRUE(black.shadowsBlocked);
+    EXPECT_FALSE(black.highlightsClipped);
+    EXPECT_FALSE(grey.highlightsClipped || grey.shadowsBlocked);
+
+    EXPECT_GT(grey.exposure, 0.9);
+    EXPECT_LT(white.exposure, 0.1);
+    EXPECT_LT(black.exposure, 0.1);
+}
+
+TEST_F(QualityAnalyzerTest, ScoresFillTechnicalMetadata) {
+    QualityAnalyzer::Scores scores = QualityAnalyzer::measure(filled(255));
+    TechnicalMetadata technical;
+    technical.duplicate_group = "dup-1";
+    scores.applyTo(technical);
+
+    EXPECT_DOUBLE_EQ(technical.sharpness_score, scores.sharpness);
+    EXPECT_DOUBLE_EQ(technical.exposure_quality, scores.exposure);
+    EXPECT_TRUE(technical.blur_detected) << "A flat frame has no detail";
+    EXPECT_TRUE(technical.highlights_clipped);
+    EXPECT_EQ(technical.duplicate_group, "dup-1") << "Other fields are kept";
+    EXPECT_EQ(QualityAnalyzer::measure(QImage()).sharpness, 0.0);
+
+    scores = QualityAnalyzer::measure(checkerboard());
+    scores.applyTo(technical);
+    auto stored = QualityAnalyzer::Scores::fromTechnical(technical);
+    ASSERT_TRUE(stored.has_value());
+    EXPECT_DOUBLE_EQ(stored->sharpness, scores.sharpness);
+    EXPECT_EQ(stored->blurry, scores.blurry);
+    EXPECT_FALSE(QualityAnalyzer::Scores::fromTechnical(TechnicalMetadata()).has_value()) << "Never scored";
+}
+
+TEST_F(QualityAnalyzerTest, RunWritesInBatchesInBackground) {
+    QualityAnalyzer analyzer(fakeStages());
+    analyzer.setThreads(4);
+    QAtomicInt analyzed{0};
+    QObject::connect(&analyzer, &QualityAnalyzer::analyzed, &analyzer,
+                     [&analyzed](const QString&, const QualityAnalyzer::Scores&) { analyzed.ref(); },
+                     Qt::DirectConnection);
+    QSignalSpy finished(&analyzer, &QualityAnalyzer::finished);
+
+    QStringList files;
+    for (int i = 0; i < 120; ++i) files << QString("/d/%1.jpg").arg(i);
+    files << "/d/bad_0.jpg";
+    analyzer.start(files);
+    ASSERT_TRUE(finished.wait(10000));
+
+    QList<QVariant> args = finished.takeFirst();
+    EXPECT_EQ(args[0].toInt(), 120);
+    EXPECT_EQ(args[1].toInt(), 1);
+    EXPECT_FALSE(args[2].toBool());
+    EXPECT_FALSE(analyzer.isRunning());
+    EXPECT_EQ(analyzed.loadRelaxed(), 120);
+
+    written.sort();
+    EXPECT_EQ(written.size(), 120);
+    EXPECT_FALSE(written.contains("/d/bad_0.jpg"));
+    for (int size : batches) EXPECT_LE(size, QualityAnalyzer::WRITE_BATCH_SIZE);
+}
+
+TEST_F(QualityAnalyzerTest, CancelDropsUnwrittenResults) {
+    QualityAnalyzer::Stages stages = fakeStages();
+    auto decode = stages.decode;
+    stages.decode = [decode](const QString& path) {
+        QThread::msleep(5);  // Slow decode
+        return decode(path);
+    };
+
+    QualityAnalyzer analyzer(stages);
+    analyzer.setThreads(2);
+    QSignalSpy finished(&analyzer, &QualityAnalyzer::finished);
+
+    QStringList files;
+    for (int i = 0; i < 2000; ++i) files << QString("/d/%1.jpg").arg(i);
+    analyzer.start(files);
+    QThread::msleep(30);
+    analyzer.cancel();
+
+    ASSERT_TRUE(finished.wait(5000));
+    EXPECT_TRUE(finished.takeFirst()[2].toBool());
+    EXPECT_LT(written.size(), files.size());
+    EXPECT_EQ(written.size() % QualityAnalyzer::WRITE_BATCH_SIZE, 0) << "Only full batches were written";
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QMutex>
+#include "core/RatingWriteQueue.h"
+
+using namespace PhotoGuru;
+
+class RatingWriteQueueTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+    
+    // Records every batch; fails the paths in m_failing
+    RatingWriteQueue::Writer recorder() {
+        return [this](const QList<MetadataWriter::Transaction>& transactions) {
+            QMutexLocker locker(&m_mutex);
+            m_batches.append(transactions);
+            std::vector<bool> results;
+            for (const auto& tx : transactions) {
+                results.push_back(!m_failing.contains(tx.filePath()));
+            }
+            return results;
+        };
+    }
+    
+    QString journalPath() const { return m_dir.filePath("ratings.journal"); }
+    
+    QTemporaryDir m_dir;
+    QMutex m_mutex;
+    QList<QList<MetadataWriter::Transaction>> m_batches;
+    QStringList m_failing;
+};
+
+TEST_F(RatingWriteQueueTest, EditsOfOneFileAreWrittenOnce) {
+    RatingWriteQueue queue(journalPath(), recorder());
+    queue.enqueue("/photos/a.jpg", 2);
+    queue.enqueue("/photos/a.jpg", 4);
+    queue.enqueue("/photos/b.jpg", 1);
+    EXPECT_EQ(queue.pending("/photos/a.jpg"), 4);
+    EXPECT_TRUE(m_batches.isEmpty()) << "Nothing is written before the flush";
+    
+    queue.waitForFlushed();
+    ASSERT_EQ(m_batches.size(), 1);
+    ASSERT_EQ(m_batches[0].size(), 2);
+    for (const auto& tx : m_batches[0]) {
+        EXPECT_EQ(tx.fields(), QStringList{"rating"});
+        if (tx.filePath() == "/photos/a.jpg") {
+            EXPECT_TRUE(tx.arguments().join(' ').contains("Rating=4"));
+        }
+    }
+    EXPECT_EQ(queue.pendingCount(), 0);
+    EXPECT_FALSE(QFile::exists(journalPath())) << "Nothing left to replay";
+}
+
+TEST_F(RatingWriteQueueTest, JournalSurvivesRestart) {
+    {
+        RatingWriteQueue queue(journalPath(), recorder());
+        queue.enqueue("/photos/a.jpg", 3);
+        queue.enqueue("/photos/a.jpg", 5);
+    }  // Closed before the flush, as in a crash
+    EXPECT_TRUE(m_batches.isEmpty());
+    
+    RatingWriteQueue reopened(journalPath(), recorder());
+    EXPECT_EQ(reopened.pending("/photos/a.jpg"), 5);
+    reopened.waitForFlushed();
+    ASSERT_EQ(m_batches.size(), 1);
+    EXPECT_EQ(m_batches[0].size(), 1);
+}
+
+TEST_F(RatingWriteQueueTest, LargeQueuesAreSplitIntoBatches) {
+    RatingWriteQueue queue(QString(), recorder());
+    const int count = RatingWriteQueue::MAX_BATCH_SIZE + 10;
+    for (int i = 0; i < count; ++i) {
+        queue.enqueue(QString("/photos/%1.jpg").arg(i), i % 6);
+    }
+    queue.waitForFlushed();
+    
+    ASSERT_EQ(m_batches.size(), 2);
+    EXPECT_EQ(m_batches[0].size(), RatingWriteQueue::MAX_BATCH_SIZE);
+    EXPECT_EQ(m_batches[1].size(), 10);
+}
+
+TEST_F(RatingWriteQueueTest, FlushDelayBatchesAndFailuresAreReported) {
+    m_failing << "/photos/missing.jpg";
+    RatingWriteQueue queue(journalPath(), recorder());
+    queue.setFlushDelay(10);
+    QSignalSpy written(&queue, &RatingWriteQueue::written);
+    QSignalSpy failed(&queue, &RatingWriteQueue::writeFailed);
+    
+    queue.enqueue("/photos/a.jpg", 1);
+    queue.enqueue("/photos/missing.jpg", 2);
+    ASSERT_TRUE(written.wait(5000));
+    
+    ASSERT_EQ(failed.count(), 1);
+    EXPECT_EQ(failed[0][0].toStringList(), QStringList{"/photos/missing.jpg"});
+    EXPECT_EQ(written[0][0].toStringList(), QStringList{"/photos/a.jpg"});
+    EXPECT_FALSE(queue.pending("/photos/missing.jpg").has_value()) << "Failed edits are dropped";
+}
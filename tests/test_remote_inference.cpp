@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include "ml/InferenceServer.h"
+#include "ml/RemoteInference.h"
+
+using namespace PhotoGuru;
+
+namespace {
+
+// Embeds an image as its size, captions it with its width
+class FakeBackend : public InferenceBackend {
+public:
+    explicit FakeBackend(bool captions) : m_captions(captions) {}
+
+    Info info() const override {
+        Info info;
+        info.clipVersion = "fake-clip";
+        info.embeddingDim = 2;
+        info.batchSize = 8;
+        if (m_captions) info.vlmId = "fake-vlm";
+        return info;
+    }
+
+    std::vector<std::optional<std::vector<float>>> embed(const std::vector<QImage>& images) override {
+        std::vector<std::optional<std::vector<float>>> result;
+        for (const QImage& image : images) {
+            if (image.isNull()) result.push_back(std::nullopt);
+            else result.push_back(std::vector<float>{float(image.width()), float(image.height())});
+        }
+        return result;
+    }
+
+    std::vector<std::optional<QString>> caption(const std::vector<QImage>& images,
+                                                const LlamaVLM::GenerationOptions& options) override {
+        lastMaxTokens = options.maxTokens;
+        std::vector<std::optional<QString>> result;
+        for (const QImage& image : images) result.push_back(QString("%1 wide").arg(image.width()));
+        return result;
+    }
+
+    QString lastError() const override { return QString(); }
+
+    int lastMaxTokens = 0;
+
+private:
+    bool m_captions;
+};
+
+} // namespace
+
+class RemoteInferenceTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    void serve(bool captions, const QString& token = QString()) {
+        backend = std::make_unique<FakeBackend>(captions);
+        server = std::make_unique<InferenceServer>(backend.get());
+        server->setToken(token);
+        ASSERT_TRUE(server->listen(QHostAddress::LocalHost, 0)) << server->errorString().toStdString();
+    }
+
+    QUrl url() const {
+        return QUrl(QString("http://127.0.0.1:%1").arg(server->port()));
+    }
+
+    // The client blocks, the server answers on this thread: run the client elsewhere
+    template <typename F>
+    auto offThread(F&& call) {
+        QFutureWatcher<decltype(call())> watcher;
+        QEventLoop loop;
+        QObject::connect(&watcher, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit);
+        watcher.setFuture(QtConcurrent::run(std::forward<F>(call)));
+        if (!watcher.isFinished()) loop.exec();
+        return watcher.result();
+    }
+
+    QImage image(int width, int height) {
+        QImage result(width, height, QImage::Format_RGB32);
+        result.fill(Qt::blue);
+        return result;
+    }
+
+    std::unique_ptr<FakeBackend> backend;
+    std::unique_ptr<InferenceServer> server;
+};
+
+TEST_F(RemoteInferenceTest, ConnectsAndReadsInfo) {
+    serve(true);
+    RemoteInference client(url());
+    EXPECT_FALSE(client.isConnected());
+    ASSERT_TRUE(offThread([&]() { return client.connectToServer(); })) << client.lastError().toStdString();
+    EXPECT_TRUE(client.isConnected());
+
+    InferenceBackend::Info info = client.info();
+    EXPECT_EQ(info.clipVersion, "fake-clip");
+    EXPECT_EQ(info.embeddingDim, 2);
+    EXPECT_EQ(info.batchSize, 8);
+    EXPECT_EQ(info.vlmId, "fake-vlm");
+}
+
+TEST_F(RemoteInferenceTest, EmbedsBatchesInOrder) {
+    serve(false);
+    RemoteInference client(url());
+    ASSERT_TRUE(offThread([&]() { return client.connectToServer(); }));
+
+    auto embeddings = offThread([&]() { return client.embed({image(20, 10), QImage(), image(6, 4)}); });
+    ASSERT_EQ(embeddings.size(), 3u);
+    ASSERT_TRUE(embeddings[0]);
+    EXPECT_EQ(*embeddings[0], std::vector<float>({20.0f, 10.0f}));
+    EXPECT_FALSE(embeddings[1]);
+    ASSERT_TRUE(embeddings[2]);
+    EXPECT_EQ(*embeddings[2], std::vector<float>({6.0f, 4.0f}));
+}
+
+TEST_F(RemoteInferenceTest, CaptionsWithOptions) {
+    serve(true, "secret");
+    RemoteInference client(url(), "secret");
+    ASSERT_TRUE(offThread([&]() { return client.connectToServer(); }));
+
+    LlamaVLM::GenerationOptions options;
+    options.maxTokens = 33;
+    auto captions = offThread([&]() { return client.caption({image(40, 30), image(12, 12)}, options); });
+    ASSERT_EQ(captions.size(), 2u);
+    EXPECT_EQ(captions[0], QString("40 wide"));
+    EXPECT_EQ(captions[1], QString("12 wide"));
+    EXPECT_EQ(backend->lastMaxTokens, 33);
+}
+
+TEST_F(RemoteInferenceTest, RejectsWrongToken) {
+    serve(true, "secret");
+    RemoteInference client(url(), "guess");
+    EXPECT_FALSE(offThread([&]() { return client.connectToServer(); }));
+    EXPECT_FALSE(client.isConnected());
+    EXPECT_FALSE(client.lastError().isEmpty());
+}
+
+TEST_F(RemoteInferenceTest, CaptionsFailWithoutVlm) {
+    serve(false);
+    RemoteInference client(url());
+    ASSERT_TRUE(offThread([&]() { return client.connectToServer(); }));
+    EXPECT_TRUE(client.info().vlmId.isEmpty());
+
+    auto captions = offThread([&]() { return client.caption({image(8, 8)}, LlamaVLM::GenerationOptions()); });
+    ASSERT_EQ(captions.size(), 1u);
+    EXPECT_FALSE(captions[0]);
+    EXPECT_FALSE(client.lastError().isEmpty());
+}
+
+TEST_F(RemoteInferenceTest, UnreachableServerFails) {
+    RemoteInference client(QUrl("http://127.0.0.1:1"));
+    EXPECT_FALSE(client.connectToServer(1000));
+    EXPECT_FALSE(client.lastError().isEmpty());
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include "core/ResourceGovernor.h"
+#include <QSignalSpy>
+#include <QTest>
+#include <thread>
+
+using namespace PhotoGuru;
+
+namespace {
+
+ResourceGovernor::PowerState battery(int percent) {
+    ResourceGovernor::PowerState state;
+    state.onBattery = true;
+    state.batteryPercent = percent;
+    return state;
+}
+
+ResourceGovernor::PowerState hot(ResourceGovernor::Thermal thermal) {
+    ResourceGovernor::PowerState state;
+    state.thermal = thermal;
+    return state;
+}
+
+} // namespace
+
+TEST(ResourceGovernorTest, BalancedFollowsPowerAndThermalState) {
+    using G = ResourceGovernor;
+
+    G::Budget cool = G::compute(G::Balanced, G::PowerState(), false, 8);
+    EXPECT_EQ(cool.prefetchLimit, 8);
+    EXPECT_EQ(cool.ingestLimit, 7);
+    EXPECT_EQ(cool.aiLimit, 4);
+    EXPECT_DOUBLE_EQ(cool.batchScale, 1.0);
+    EXPECT_FALSE(cool.aiPaused);
+
+    G::Budget onBattery = G::compute(G::Balanced, battery(80), false, 8);
+    EXPECT_EQ(onBattery.ingestLimit, 4);
+    EXPECT_EQ(onBattery.aiLimit, 2);
+    EXPECT_DOUBLE_EQ(onBattery.batchScale, 0.5);
+    EXPECT_FALSE(onBattery.aiPaused);
+    EXPECT_EQ(G::compute(G::Balanced, hot(G::Thermal::Serious), false, 8), onBattery);
+    EXPECT_EQ(G::compute(G::Balanced, hot(G::Thermal::Fair), false, 8), cool);
+
+    G::Budget low = G::compute(G::Balanced, battery(10), false, 8);
+    EXPECT_EQ(low.ingestLimit, 1);
+    EXPECT_EQ(low.aiLimit, 1);
+    EXPECT_TRUE(low.aiPaused);
+    EXPECT_EQ(G::compute(G::Balanced, hot(G::Thermal::Critical), false, 8), low);
+}
+
+TEST(ResourceGovernorTest, ModesShiftTheBudget) {
+    using G = ResourceGovernor;
+
+    // Background behaves a step more cautious than the machine asks
+    EXPECT_EQ(G::compute(G::Background, G::PowerState(), false, 8),
+              G::compute(G::Balanced, battery(80), false, 8));
+    EXPECT_TRUE(G::compute(G::Background, battery(80), false, 8).aiPaused);
+
+    // Max throughput ignores the battery and backs off only when critical
+    G::Budget max = G::compute(G::MaxThroughput, battery(5), false, 8);
+    EXPECT_EQ(max.aiLimit, 7);
+    EXPECT_DOUBLE_EQ(max.batchScale, 1.0);
+    EXPECT_FALSE(max.aiPaused);
+    EXPECT_DOUBLE_EQ(G::compute(G::MaxThroughput, hot(G::Thermal::Critical), false, 8).batchScale, 0.5);
+}
+
+TEST(ResourceGovernorTest, UserActivityPausesAIAndHalvesIngest) {
+    using G = ResourceGovernor;
+    G::Budget active = G::compute(G::Balanced, G::PowerState(), true, 8);
+    EXPECT_TRUE(active.aiPaused);
+    EXPECT_EQ(active.ingestLimit, 3);
+    EXPECT_FALSE(G::compute(G::MaxThroughput, G::PowerState(), true, 8).aiPaused);
+}
+
+TEST(ResourceGovernorTest, AppliesTheBudgetToTheScheduler) {
+    TaskScheduler scheduler(8);
+    ResourceGovernor governor(scheduler);
+    QSignalSpy changed(&governor, &ResourceGovernor::budgetChanged);
+
+    governor.setPowerState(battery(60));
+    EXPECT_EQ(changed.count(), 1);
+    EXPECT_EQ(scheduler.classLimit(TaskScheduler::Prefetch), 4);
+    EXPECT_EQ(scheduler.classLimit(TaskScheduler::Ingest), 4);
+    EXPECT_EQ(scheduler.classLimit(TaskScheduler::AI), 2);
+    EXPECT_EQ(governor.scaledBatchSize(16), 8);
+    EXPECT_EQ(governor.scaledBatchSize(1), 1) << "Never below one";
+
+    governor.setPowerState(battery(60));
+    EXPECT_EQ(changed.count(), 1) << "Same state, no change";
+
+    governor.setMode(ResourceGovernor::MaxThroughput);
+    EXPECT_EQ(scheduler.classLimit(TaskScheduler::AI), 7);
+    EXPECT_EQ(governor.scaledBatchSize(16), 16);
+}
+
+TEST(ResourceGovernorTest, UserActivityHoldsThenReleases) {
+    TaskScheduler scheduler(4);
+    ResourceGovernor governor(scheduler);
+    ASSERT_FALSE(governor.aiPaused());
+
+    governor.noteUserActivity();
+    EXPECT_TRUE(governor.userActive());
+    EXPECT_TRUE(governor.aiPaused());
+
+    QTRY_VERIFY_WITH_TIMEOUT(!governor.aiPaused(), ResourceGovernor::ACTIVITY_HOLD_MS * 4);
+    EXPECT_FALSE(governor.userActive());
+}
+
+TEST(ResourceGovernorTest, PausedStagesWakeOnResumeOrCancel) {
+    TaskScheduler scheduler(4);
+    ResourceGovernor governor(scheduler);
+    governor.setPowerState(battery(5));
+    ASSERT_TRUE(governor.aiPaused());
+
+    QAtomicInt cancelled{0};
+    std::atomic<bool> returned{false};
+    std::thread stage([&]() {
+        governor.waitWhileAIPaused(cancelled);
+        returned = true;
+    });
+    QThread::msleep(50);
+    EXPECT_FALSE(returned);
+    cancelled.storeRelaxed(1);
+    stage.join();
+    EXPECT_TRUE(returned);
+
+    QAtomicInt running{0};
+    returned = false;
+    std::thread resumed([&]() {
+        governor.waitWhileAIPaused(running);
+        returned = true;
+    });
+    QThread::msleep(50);
+    EXPECT_FALSE(returned);
+    governor.setPowerState(ResourceGovernor::PowerState());
+    resumed.join();
+    EXPECT_TRUE(returned);
+}
+
+TEST(ResourceGovernorTest, ModeNamesRoundTrip) {
+    for (ResourceGovernor::Mode mode : {ResourceGovernor::Background, ResourceGovernor::Balanced,
+                                        ResourceGovernor::MaxThroughput}) {
+        EXPECT_EQ(ResourceGovernor::modeFromName(ResourceGovernor::modeName(mode)), mode);
+    }
+    EXPECT_FALSE(ResourceGovernor::modeFromName("turbo").has_value());
+}
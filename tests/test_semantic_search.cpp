@@ -110,3 +110,45 @@ TEST_F(SemanticSearchTest, SearchSpecialCharacters) {
     EXPECT_NO_THROW(searchWidget->performSearch("café"));
     EXPECT_NO_THROW(searchWidget->performSearch("北京"));
 }
+
+// Embedding search ranks photos and skips paths outside the current set
+TEST_F(SemanticSearchTest, EmbeddingSearchRanksResults) {
+    QList<PhotoMetadata> photos;
+    for (const char* path : {"/test/dog.jpg", "/test/cat.jpg"}) {
+        PhotoMetadata meta;
+        meta.filepath = path;
+        photos.append(meta);
+    }
+    searchWidget->setPhotos(photos);
+    
+    QString seenQuery;
+    searchWidget->setEmbeddingSearch([&seenQuery](const QString& query, int) {
+        seenQuery = query;
+        return std::vector<QPair<QString, float>>{
+            {"/other/dog.jpg", 0.4f}, {"/test/dog.jpg", 0.31f}, {"/test/cat.jpg", 0.22f}};
+    });
+    
+    QSignalSpy completed(searchWidget, &SemanticSearch::searchCompleted);
+    searchWidget->performSearch("a dog in the park");
+    ASSERT_EQ(completed.count(), 1);
+    EXPECT_EQ(completed.takeFirst()[0].toInt(), 2);
+    EXPECT_EQ(seenQuery, "a dog in the park");
+}
+
+// Without embedding hits the keyword scan still answers
+TEST_F(SemanticSearchTest, EmbeddingSearchFallsBackToKeywords) {
+    QList<PhotoMetadata> photos;
+    PhotoMetadata meta;
+    meta.filepath = "/test/beach.jpg";
+    meta.llm_title = "Beach Scene";
+    photos.append(meta);
+    searchWidget->setPhotos(photos);
+    searchWidget->setEmbeddingSearch([](const QString&, int) {
+        return std::vector<QPair<QString, float>>();
+    });
+    
+    QSignalSpy completed(searchWidget, &SemanticSearch::searchCompleted);
+    searchWidget->performSearch("beach");
+    ASSERT_EQ(completed.count(), 1);
+    EXPECT_EQ(completed.takeFirst()[0].toInt(), 1);
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include "core/SessionSnapshot.h"
+
+using namespace PhotoGuru;
+
+TEST(SessionSnapshotTest, RoundTrips) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    
+    SessionSnapshot snapshot;
+    snapshot.directory = "/photos/2024";
+    snapshot.files = {{"a.jpg", 1000, 10}, {"b.heic", 2000, 20}};
+    snapshot.sortOrder = 1;
+    snapshot.thumbnailSize = 220;
+    snapshot.currentFile = "/photos/2024/b.heic";
+    snapshot.scrollPosition = 480;
+    
+    const QString path = dir.filePath("session.bin");
+    ASSERT_TRUE(snapshot.save(path));
+    
+    std::optional<SessionSnapshot> loaded = SessionSnapshot::load(path);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->directory, snapshot.directory);
+    EXPECT_EQ(loaded->paths(), (QStringList{"/photos/2024/a.jpg", "/photos/2024/b.heic"}));
+    EXPECT_EQ(loaded->sortOrder, 1);
+    EXPECT_EQ(loaded->thumbnailSize, 220);
+    EXPECT_EQ(loaded->currentFile, snapshot.currentFile);
+    EXPECT_EQ(loaded->scrollPosition, 480);
+    
+    DirectoryWatcher::Listing listing = loaded->listing();
+    ASSERT_TRUE(listing.contains("/photos/2024/b.heic"));
+    EXPECT_EQ(listing.value("/photos/2024/b.heic"), (DirectoryWatcher::Entry{2000, 20}));
+}
+
+TEST(SessionSnapshotTest, FilesOfKeepsOrderAndSkipsUnlisted) {
+    DirectoryWatcher::Listing listing;
+    listing.insert("/d/a.jpg", {1, 1});
+    listing.insert("/d/b.jpg", {2, 2});
+    
+    QList<SessionSnapshot::File> files =
+        SessionSnapshot::filesOf("/d", {"/d/b.jpg", "/d/missing.jpg", "/d/a.jpg"}, listing);
+    ASSERT_EQ(files.size(), 2);
+    EXPECT_EQ(files[0].name, "b.jpg");
+    EXPECT_EQ(files[0].mtime, 2);
+    EXPECT_EQ(files[1].name, "a.jpg");
+}
+
+TEST(SessionSnapshotTest, RejectsMissingAndForeignFiles) {
+    QTemporaryDir dir;
+    EXPECT_FALSE(SessionSnapshot::load(dir.filePath("none.bin")).has_value());
+    
+    const QString garbage = dir.filePath("garbage.bin");
+    QFile file(garbage);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write("not a session snapshot at all");
+    file.close();
+    EXPECT_FALSE(SessionSnapshot::load(garbage).has_value());
+    
+    // Cut short after the header
+    SessionSnapshot snapshot;
+    snapshot.directory = "/d";
+    for (int i = 0; i < 100; i++) snapshot.files.append({QString("%1.jpg").arg(i), i, i});
+    const QString truncated = dir.filePath("truncated.bin");
+    ASSERT_TRUE(snapshot.save(truncated));
+    QFile::resize(truncated, QFileInfo(truncated).size() / 2);
+    EXPECT_FALSE(SessionSnapshot::load(truncated).has_value());
+}
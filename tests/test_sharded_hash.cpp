@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include "core/ShardedHash.h"
+#include <QString>
+#include <QThread>
+#include <vector>
+
+using namespace PhotoGuru;
+
+TEST(ShardedHashTest, InsertValueAndRemove) {
+    ShardedHash<QString, int> hash;
+    EXPECT_FALSE(hash.value("a").has_value());
+    
+    hash.insert("a", 1);
+    hash.insert("a", 2);
+    EXPECT_EQ(hash.value("a"), 2);
+    EXPECT_TRUE(hash.contains("a"));
+    EXPECT_EQ(hash.size(), 1);
+    
+    EXPECT_TRUE(hash.remove("a"));
+    EXPECT_FALSE(hash.remove("a"));
+    EXPECT_EQ(hash.size(), 0);
+}
+
+TEST(ShardedHashTest, BulkInsertAndSnapshot) {
+    ShardedHash<QString, int> hash;
+    QHash<QString, int> items;
+    for (int i = 0; i < 100; ++i) {
+        items.insert(QString::number(i), i);
+    }
+    hash.insert(items);
+    EXPECT_EQ(hash.size(), 100);
+    
+    QHash<QString, int> snapshot = hash.snapshot();
+    EXPECT_EQ(snapshot, items);
+    
+    hash.clear();
+    EXPECT_EQ(hash.size(), 0);
+    EXPECT_EQ(snapshot.size(), 100) << "Snapshot is a copy";
+}
+
+TEST(ShardedHashTest, RevisionChangesOnWrite) {
+    ShardedHash<QString, int> hash;
+    quint64 start = hash.revision();
+    hash.insert("a", 1);
+    EXPECT_NE(hash.revision(), start);
+    
+    quint64 afterInsert = hash.revision();
+    hash.value("a");
+    hash.snapshot();
+    EXPECT_EQ(hash.revision(), afterInsert) << "Reads leave it alone";
+    
+    hash.insert(QHash<QString, int>());
+    EXPECT_EQ(hash.revision(), afterInsert) << "Empty bulk insert writes nothing";
+}
+
+TEST(ShardedHashTest, ConcurrentWritersAndReaders) {
+    ShardedHash<QString, int> hash;
+    constexpr int WRITERS = 4;
+    constexpr int PER_WRITER = 500;
+    
+    std::vector<QThread*> threads;
+    for (int w = 0; w < WRITERS; ++w) {
+        threads.push_back(QThread::create([&hash, w]() {
+            for (int i = 0; i < PER_WRITER; ++i) {
+                hash.insert(QString("%1-%2").arg(w).arg(i), i);
+            }
+        }));
+    }
+    threads.push_back(QThread::create([&hash]() {
+        for (int i = 0; i < 200; ++i) {
+            QHash<QString, int> snapshot = hash.snapshot();
+            for (auto it = snapshot.cbegin(); it != snapshot.cend(); ++it) {
+                ASSERT_EQ(hash.value(it.key()), it.value());
+            }
+        }
+    }));
+    for (QThread* thread : threads) thread->start();
+    for (QThread* thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+    
+    EXPECT_EQ(hash.size(), WRITERS * PER_WRITER);
+    EXPECT_EQ(hash.value("3-499"), 499);
+}
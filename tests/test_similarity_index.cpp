@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "ml/SimilarityIndex.h"
+#include "core/EmbeddingStore.h"
+#include <QTemporaryDir>
+#include <QFile>
+#include <cmath>
+
+using namespace PhotoGuru;
+
+class SimilarityIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(tempDir.isValid());
+        ASSERT_TRUE(store.open(tempDir.filePath("embeddings"), "test-model", DIM));
+    }
+
+    QString touch(const QString& name, const QByteArray& content = "x") {
+        QString path = tempDir.filePath(name);
+        QFile file(path);
+        EXPECT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(content);
+        return path;
+    }
+
+    static std::vector<float> axis(int i) {
+        std::vector<float> v(DIM, 0.0f);
+        v[size_t(i % DIM)] = 1.0f;
+        return v;
+    }
+
+    static constexpr int DIM = 4;
+    QTemporaryDir tempDir;
+    EmbeddingStore store;
+};
+
+TEST_F(SimilarityIndexTest, SmallStoreUsesExactScan) {
+    QString a = touch("a.jpg");
+    QString b = touch("b.jpg");
+    ASSERT_TRUE(store.insert(a, axis(0)));
+    ASSERT_TRUE(store.insert(b, axis(1)));
+
+    SimilarityIndex index(&store);
+    EXPECT_EQ(index.sync(), 0) << "No graph below the exact-search limit";
+
+    auto matches = index.findSimilar(axis(1), 1);
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].first, b);
+    EXPECT_FLOAT_EQ(matches[0].second, 1.0f);
+}
+
+TEST_F(SimilarityIndexTest, SupersededRowsAreSkipped) {
+    QString a = touch("a.jpg");
+    ASSERT_TRUE(store.insert(a, axis(2)));
+    touch("a.jpg", "changed content");  // New size -> new key
+    ASSERT_TRUE(store.insert(a, axis(3)));
+
+    SimilarityIndex index(&store);
+    auto hits = index.search(axis(2).data(), 5);
+    ASSERT_EQ(hits.size(), 1u) << "Only the live row is returned";
+    EXPECT_EQ(hits[0].id, 1);
+}
+
+TEST_F(SimilarityIndexTest, QuantizedScanMatchesFloatScan) {
+    // Near-duplicates a quantized score alone could misorder
+    std::vector<std::vector<float>> vectors;
+    for (int i = 0; i < 40; ++i) {
+        std::vector<float> v = {1.0f, 0.01f * float(i), 0.3f, -0.2f};
+        float norm = 0.0f;
+        for (float x : v) norm += x * x;
+        for (float& x : v) x /= std::sqrt(norm);
+        ASSERT_TRUE(store.insert(touch(QString("img%1.jpg").arg(i)), v));
+        vectors.push_back(v);
+    }
+
+    SimilarityIndex index(&store);
+    index.sync();
+    ASSERT_TRUE(store.insert(touch("late.jpg"), axis(3)));  // Appended after the sync: no codes yet
+
+    const std::vector<float>& query = vectors[17];
+    auto hits = index.search(query.data(), 5);
+    const EmbeddingStore::Matrix matrix = store.matrix();
+    auto exact = VectorSearch::exactSearch(query.data(), matrix.data, store.rowCount(), DIM, 5);
+    ASSERT_EQ(hits.size(), exact.size());
+    for (size_t i = 0; i < hits.size(); ++i) {
+        EXPECT_EQ(hits[i].id, exact[i].id) << "rank " << i;
+        EXPECT_FLOAT_EQ(hits[i].score, exact[i].score);
+    }
+    EXPECT_EQ(index.search(axis(3).data(), 1)[0].id, 40) << "Uncoded rows are still scanned";
+}
@@ -75,3 +75,15 @@ TEST_F(SKPBrowserTest, VariousFilePaths) {
     EXPECT_NO_THROW(browser->loadImageKeys("./local/image.jpg"));
     EXPECT_NO_THROW(browser->loadImageKeys("../parent/image.jpg"));
 }
+
+// Cached metadata is shown without reading the file
+TEST_F(SKPBrowserTest, LoadImageKeysFromCache) {
+    PhotoMetadata metadata;
+    metadata.filepath = "/test/cached.jpg";
+    metadata.skp_group_keys << "group:family";
+    browser->loadImageKeys(metadata.filepath, metadata);
+    
+    QTreeWidget* tree = browser->findChild<QTreeWidget*>();
+    ASSERT_NE(tree, nullptr);
+    EXPECT_EQ(tree->topLevelItemCount(), 1);
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "core/SortKeyTable.h"
+#include <QElapsedTimer>
+
+using namespace PhotoGuru;
+
+namespace {
+
+PhotoMetadata photo(const QString& path, const QDateTime& captured, double quality, int rating = 0) {
+    PhotoMetadata meta;
+    meta.filepath = path;
+    meta.datetime_original = captured;
+    meta.technical.overall_quality = quality;
+    meta.rating = rating;
+    return meta;
+}
+
+} // namespace
+
+TEST(SortKeyTableTest, NamesSortNaturallyAndIgnoreCase) {
+    EXPECT_LT(SortKeyTable::nameKey("IMG_2.jpg"), SortKeyTable::nameKey("IMG_10.jpg"));
+    EXPECT_EQ(SortKeyTable::nameKey("img_007.JPG"), SortKeyTable::nameKey("IMG_7.jpg"));
+    EXPECT_LT(SortKeyTable::nameKey("a.jpg"), SortKeyTable::nameKey("B.jpg"));
+    
+    SortKeyTable table;
+    QStringList paths = {"/d/IMG_10.jpg", "/d/b.jpg", "/d/IMG_2.jpg", "/d/A.jpg"};
+    table.sort(paths, SortOrder::ByName);
+    EXPECT_EQ(paths, (QStringList{"/d/A.jpg", "/d/b.jpg", "/d/IMG_2.jpg", "/d/IMG_10.jpg"}));
+}
+
+TEST(SortKeyTableTest, SortsByListedDateAndSizeWithoutTheFiles) {
+    // None of these exist: the keys come from the listing alone
+    DirectoryWatcher::Listing listing;
+    listing.insert("/nowhere/a.jpg", {1000, 30});
+    listing.insert("/nowhere/b.jpg", {3000, 10});
+    listing.insert("/nowhere/c.jpg", {2000, 30});
+    SortKeyTable table;
+    table.setFileInfo(listing);
+    
+    QStringList paths = {"/nowhere/a.jpg", "/nowhere/b.jpg", "/nowhere/c.jpg"};
+    table.sort(paths, SortOrder::ByDate);
+    EXPECT_EQ(paths, (QStringList{"/nowhere/b.jpg", "/nowhere/c.jpg", "/nowhere/a.jpg"}));
+    
+    table.sort(paths, SortOrder::BySize);
+    EXPECT_EQ(paths, (QStringList{"/nowhere/a.jpg", "/nowhere/c.jpg", "/nowhere/b.jpg"}))
+        << "Equal sizes stay in name order";
+}
+
+TEST(SortKeyTableTest, SortsByCaptureQualityAndRating) {
+    SortKeyTable table;
+    table.setFileInfo("/d/old.jpg", 5000, 1);
+    table.setFileInfo("/d/new.jpg", 1000, 1);
+    table.setFileInfo("/d/nodate.jpg", 3000, 1);
+    const QDateTime base(QDate(2024, 6, 1), QTime(12, 0));
+    table.setMetadata(photo("/d/old.jpg", base, 0.9, 1));
+    table.setMetadata(photo("/d/new.jpg", base.addDays(1), 0.2, 5));
+    table.setMetadata(photo("/d/nodate.jpg", QDateTime(), 0.0, 3));
+    
+    QStringList paths = {"/d/nodate.jpg", "/d/new.jpg", "/d/old.jpg"};
+    table.sort(paths, SortOrder::ByCaptureDate);
+    EXPECT_EQ(paths, (QStringList{"/d/new.jpg", "/d/old.jpg", "/d/nodate.jpg"}))
+        << "Without a capture time the file date stands in";
+    
+    table.sort(paths, SortOrder::ByQuality);
+    EXPECT_EQ(paths, (QStringList{"/d/old.jpg", "/d/new.jpg", "/d/nodate.jpg"})) << "Unanalyzed last";
+    
+    table.sort(paths, SortOrder::ByRating);
+    EXPECT_EQ(paths, (QStringList{"/d/new.jpg", "/d/nodate.jpg", "/d/old.jpg"}));
+}
+
+TEST(SortKeyTableTest, RemoveKeepsTheOtherRows) {
+    SortKeyTable table;
+    table.setFileInfo("/d/a.jpg", 1, 1);
+    table.setFileInfo("/d/b.jpg", 2, 2);
+    table.setFileInfo("/d/c.jpg", 3, 3);
+    table.remove({"/d/a.jpg", "/d/missing.jpg"});
+    EXPECT_EQ(table.size(), 2);
+    EXPECT_FALSE(table.contains("/d/a.jpg"));
+    
+    QStringList paths = {"/d/b.jpg", "/d/c.jpg"};
+    table.sort(paths, SortOrder::BySize);
+    EXPECT_EQ(paths, (QStringList{"/d/c.jpg", "/d/b.jpg"}));
+}
+
+TEST(SortKeyTableTest, ResortingALargeFolderIsCheap) {
+    SortKeyTable table;
+    QStringList paths;
+    for (int i = 0; i < 100000; i++) {
+        const QString path = QString("/library/IMG_%1.jpg").arg((i * 7919) % 100000);
+        table.setFileInfo(path, i, (i * 31) % 5000);
+        paths << path;
+    }
+    table.sort(paths, SortOrder::ByName);  // Name keys are built on first sight
+    
+    QElapsedTimer timer;
+    timer.start();
+    table.sort(paths, SortOrder::BySize);
+    table.sort(paths, SortOrder::ByDate);
+    EXPECT_LT(timer.elapsed(), 2000) << "No stat() per comparison";
+    EXPECT_EQ(paths.first(), "/library/IMG_" + QString::number((99999 * 7919) % 100000) + ".jpg");
+}
@@ -0,0 +1,277 @@
+#include <gtest/gtest.h>
+#include "core/TaskScheduler.h"
+#include <QMutex>
+#include <QSemaphore>
+#include <QSet>
+#include <QStringList>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+
+using namespace PhotoGuru;
+
+namespace {
+
+// Occupies one worker until release(), so later tasks pile up in the queues
+class Blocker {
+public:
+    explicit Blocker(TaskGroup& group) {
+        group.start([this]() {
+            m_started.release();
+            m_gate.acquire();
+        });
+        m_started.acquire();
+    }
+    void release() { m_gate.release(); }
+
+private:
+    QSemaphore m_started;
+    QSemaphore m_gate;
+};
+
+class Recorder {
+public:
+    std::function<void()> task(const QString& name) {
+        return [this, name]() {
+            QMutexLocker locker(&m_mutex);
+            m_order << name;
+        };
+    }
+    QStringList order() {
+        QMutexLocker locker(&m_mutex);
+        return m_order;
+    }
+
+private:
+    QMutex m_mutex;
+    QStringList m_order;
+};
+
+} // namespace
+
+TEST(TaskSchedulerTest, MostUrgentClassRunsFirst) {
+    TaskScheduler scheduler(1);
+    TaskGroup group(TaskScheduler::Interactive, scheduler);
+    Recorder recorder;
+
+    Blocker blocker(group);
+    group.start(recorder.task("ai"), TaskScheduler::AI);
+    group.start(recorder.task("ingest"), TaskScheduler::Ingest);
+    group.start(recorder.task("prefetch"), TaskScheduler::Prefetch);
+    group.start(recorder.task("interactive"), TaskScheduler::Interactive);
+    blocker.release();
+    group.waitForDone();
+
+    EXPECT_EQ(recorder.order(), QStringList({"interactive", "prefetch", "ingest", "ai"}));
+}
+
+TEST(TaskSchedulerTest, HigherRankFirstThenSubmissionOrder) {
+    TaskScheduler scheduler(1);
+    TaskGroup group(TaskScheduler::Prefetch, scheduler);
+    Recorder recorder;
+
+    Blocker blocker(group);
+    group.start(recorder.task("a0"), TaskScheduler::Prefetch, 0);
+    group.start(recorder.task("b5"), TaskScheduler::Prefetch, 5);
+    group.start(recorder.task("c1"), TaskScheduler::Prefetch, 1);
+    group.start(recorder.task("d5"), TaskScheduler::Prefetch, 5);
+    blocker.release();
+    group.waitForDone();
+
+    EXPECT_EQ(recorder.order(), QStringList({"b5", "d5", "c1", "a0"}));
+}
+
+TEST(TaskSchedulerTest, TryTakeReturnsTasksThatHaveNotStarted) {
+    TaskScheduler scheduler(1);
+    TaskGroup group(TaskScheduler::Interactive, scheduler);
+    std::atomic<bool> ran{false};
+    QRunnable* task = QRunnable::create([&ran]() { ran = true; });
+    task->setAutoDelete(false);
+
+    Blocker blocker(group);
+    group.start(task);
+    EXPECT_EQ(group.queuedCount(), 1);
+    EXPECT_TRUE(group.tryTake(task));
+    EXPECT_FALSE(group.tryTake(task)) << "Already taken";
+    EXPECT_EQ(group.queuedCount(), 0);
+    blocker.release();
+    group.waitForDone();
+
+    EXPECT_FALSE(ran);
+    delete task;
+}
+
+TEST(TaskSchedulerTest, ClearDropsOnlyTheGroupsQueuedTasks) {
+    TaskScheduler scheduler(1);
+    TaskGroup group(TaskScheduler::Ingest, scheduler);
+    TaskGroup other(TaskScheduler::Ingest, scheduler);
+    std::atomic<int> ran{0};
+
+    Blocker blocker(group);
+    for (int i = 0; i < 5; i++) group.start([&ran]() { ran++; });
+    other.start([&ran]() { ran += 100; });
+    group.clear();
+    blocker.release();
+    group.waitForDone();
+    other.waitForDone();
+
+    EXPECT_EQ(ran.load(), 100);
+}
+
+TEST(TaskSchedulerTest, MaxConcurrencyCapsTheGroup) {
+    TaskScheduler scheduler(4);
+    TaskGroup group(TaskScheduler::Interactive, scheduler);
+    group.setMaxConcurrency(2);
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    std::atomic<int> ran{0};
+
+    for (int i = 0; i < 20; i++) {
+        group.start([&]() {
+            const int now = ++running;
+            int previous = peak.load();
+            while (now > previous && !peak.compare_exchange_weak(previous, now)) {}
+            QThread::msleep(2);
+            running--;
+            ran++;
+        });
+    }
+    group.waitForDone();
+
+    EXPECT_EQ(ran.load(), 20);
+    EXPECT_LE(peak.load(), 2);
+}
+
+TEST(TaskSchedulerTest, RaisingTheCapWakesEveryWorkerItFrees) {
+    TaskScheduler scheduler(4);
+    TaskGroup group(TaskScheduler::Interactive, scheduler);
+    group.setMaxConcurrency(1);
+    QSemaphore started;
+    QSemaphore gate;
+    for (int i = 0; i < 4; i++) {
+        group.start([&]() {
+            started.release();
+            gate.acquire();
+        });
+    }
+    ASSERT_TRUE(started.tryAcquire(1, 5000));
+    EXPECT_FALSE(started.tryAcquire(1, 50));
+
+    // The idle workers sleep without a timeout: the raise itself must wake them all
+    group.setMaxConcurrency(4);
+    EXPECT_TRUE(started.tryAcquire(3, 5000));
+
+    gate.release(4);
+    group.waitForDone();
+}
+
+TEST(TaskSchedulerTest, ClassLimitLeavesWorkersForInteractiveWork) {
+    TaskScheduler scheduler(3);
+    scheduler.setClassLimit(TaskScheduler::Ingest, 1);
+    EXPECT_EQ(scheduler.classLimit(TaskScheduler::Ingest), 1);
+
+    TaskGroup bulk(TaskScheduler::Ingest, scheduler);
+    QSemaphore bulkStarted;
+    QSemaphore gate;
+    for (int i = 0; i < 4; i++) {
+        bulk.start([&]() {
+            bulkStarted.release();
+            gate.acquire();
+        });
+    }
+    ASSERT_TRUE(bulkStarted.tryAcquire(1, 5000));
+
+    // Bulk work is stuck, yet an interactive task gets a worker at once
+    TaskGroup interactive(TaskScheduler::Interactive, scheduler);
+    QSemaphore interactiveRan;
+    interactive.start([&]() { interactiveRan.release(); });
+    EXPECT_TRUE(interactiveRan.tryAcquire(1, 5000));
+    EXPECT_EQ(scheduler.activeCount(TaskScheduler::Ingest), 1);
+    EXPECT_FALSE(bulkStarted.tryAcquire(1, 50)) << "A second bulk task ran past the limit";
+
+    gate.release(4);
+    bulk.waitForDone();
+}
+
+TEST(TaskSchedulerTest, CancelledTokenDropsQueuedTasks) {
+    TaskScheduler scheduler(1);
+    TaskGroup group(TaskScheduler::Ingest, scheduler);
+    CancellationToken token = CancellationToken::create();
+    std::atomic<int> ran{0};
+
+    Blocker blocker(group);
+    for (int i = 0; i < 5; i++) {
+        group.start([&ran]() { ran++; }, TaskScheduler::Ingest, 0, token);
+    }
+    group.start([&ran]() { ran += 100; });  // Not tied to the token
+    token.cancel();
+    EXPECT_TRUE(token.isCancelled());
+    blocker.release();
+    group.waitForDone();
+
+    EXPECT_EQ(ran.load(), 100);
+    EXPECT_FALSE(CancellationToken().isCancelled());
+}
+
+TEST(TaskSchedulerTest, RunReportsTheResultAndCancelsWhenDropped) {
+    TaskScheduler scheduler(1);
+    TaskGroup group(TaskScheduler::Interactive, scheduler);
+
+    QFuture<int> answer = group.run(TaskScheduler::Interactive, []() { return 42; });
+    answer.waitForFinished();
+    ASSERT_FALSE(answer.isCanceled());
+    EXPECT_EQ(answer.result(), 42);
+
+    Blocker blocker(group);
+    QFuture<int> dropped = group.run(TaskScheduler::Prefetch, []() { return 7; });
+    group.clear();
+    blocker.release();
+    group.waitForDone();
+    dropped.waitForFinished();
+    EXPECT_TRUE(dropped.isCanceled());
+}
+
+TEST(TaskSchedulerTest, IdleWorkersStealSubtasks) {
+    TaskScheduler scheduler(4);
+    TaskGroup group(TaskScheduler::Ingest, scheduler);
+    QMutex mutex;
+    QSet<Qt::HANDLE> threads;
+
+    // Subtasks land on the parent's own deque; the others must steal them
+    group.start([&]() {
+        for (int i = 0; i < 12; i++) {
+            group.start([&]() {
+                QThread::msleep(10);
+                QMutexLocker locker(&mutex);
+                threads.insert(QThread::currentThreadId());
+            });
+        }
+        QThread::msleep(50);
+    });
+    group.waitForDone();
+
+    EXPECT_GT(threads.size(), 1);
+    EXPECT_EQ(scheduler.queuedCount(), 0);
+    EXPECT_EQ(scheduler.activeCount(), 0);
+}
+
+TEST(TaskSchedulerTest, WaitingOnAWorkerRunsTheGroupsTasks) {
+    // One worker: a task that blocked on its subtasks would hold it forever
+    TaskScheduler scheduler(1);
+    TaskGroup outer(TaskScheduler::AI, scheduler);
+    std::atomic<int> ran{0};
+
+    outer.start([&]() {
+        TaskGroup inner(TaskScheduler::AI, scheduler);
+        for (int i = 0; i < 8; i++) {
+            inner.start([&]() { ran.fetch_add(1); });
+        }
+        inner.waitForDone();
+        EXPECT_EQ(ran.load(), 8);
+    });
+    outer.waitForDone();
+
+    EXPECT_EQ(ran.load(), 8);
+    EXPECT_EQ(scheduler.queuedCount(), 0);
+    EXPECT_EQ(scheduler.activeCount(), 0);
+}
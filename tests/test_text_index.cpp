@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include "core/TextIndex.h"
+#include "core/PhotoMetadata.h"
+
+using namespace PhotoGuru;
+
+namespace {
+
+std::vector<int> rowsOf(const std::vector<quint64>& keys) {
+    std::vector<int> rows;
+    for (quint64 key : keys) {
+        int row = TextIndex::rowOf(key);
+        if (rows.empty() || rows.back() != row) rows.push_back(row);
+    }
+    return rows;
+}
+
+} // namespace
+
+TEST(TextIndexTest, TermMatchesInsideToken) {
+    TextIndex index;
+    index.setDocument(0, {"sunset over the bay"});
+    index.setDocument(1, {"morning fog"});
+
+    EXPECT_EQ(rowsOf(index.findAll({"unse"})), std::vector<int>{0});
+    EXPECT_EQ(rowsOf(index.findAll({"fog"})), std::vector<int>{1});
+    EXPECT_TRUE(index.findAll({"xyz"}).empty());
+    EXPECT_TRUE(index.findAll({}).empty());
+}
+
+TEST(TextIndexTest, FieldsAreLowercased) {
+    TextIndex index;
+    index.setDocument(0, {"Golden Light"});
+    EXPECT_EQ(rowsOf(index.findAll({"golden"})), std::vector<int>{0});
+}
+
+TEST(TextIndexTest, AllTermsMustShareAField) {
+    TextIndex index;
+    index.setDocument(0, {"sunset beach", "city"});
+    index.setDocument(1, {"sunset", "beach"});
+
+    std::vector<quint64> keys = index.findAll({"sunset", "beach"});
+    ASSERT_EQ(keys.size(), 1u);
+    EXPECT_EQ(keys.front(), TextIndex::makeKey(0, 0));
+}
+
+TEST(TextIndexTest, ReplaceAndRemoveDocument) {
+    TextIndex index;
+    index.setDocument(0, {"old title"});
+    index.setDocument(0, {"new title"});
+
+    EXPECT_TRUE(index.findAll({"old"}).empty());
+    EXPECT_EQ(rowsOf(index.findAll({"new"})), std::vector<int>{0});
+
+    index.removeDocument(0);
+    EXPECT_TRUE(index.findAll({"title"}).empty());
+}
+
+TEST(TextIndexTest, DocumentFieldsUseSlots) {
+    PhotoMetadata photo;
+    photo.filename = "trip/IMG_42.jpg";
+    photo.llm_title = "Harbour";
+    photo.camera_make = "Canon";
+    photo.camera_model = "R5";
+    photo.llm_keywords = {"boats", "Lisboa"};
+
+    QStringList fields = TextIndex::documentFields(photo);
+    EXPECT_EQ(fields.value(TextIndex::TitleSlot), "Harbour");
+    EXPECT_EQ(fields.value(TextIndex::CameraSlot), "Canon R5");
+    EXPECT_EQ(fields.value(TextIndex::FilenameSlot), "IMG_42.jpg");
+
+    TextIndex index;
+    index.setDocument(3, fields);
+    std::vector<quint64> keys = index.findAll({"lisb"});
+    ASSERT_EQ(keys.size(), 1u);
+    EXPECT_EQ(TextIndex::rowOf(keys.front()), 3);
+    EXPECT_EQ(TextIndex::slotOf(keys.front()), TextIndex::FirstKeywordSlot + 1);
+}
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include "core/ThumbnailCache.h"
 #include <QPixmap>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFileInfo>
 
 using namespace PhotoGuru;
 
@@ -33,3 +36,103 @@ TEST_F(ThumbnailCacheTest, CacheSize) {
     EXPECT_EQ(thumb1.width(), 128) << "First thumbnail should be 128px";
     EXPECT_EQ(thumb2.width(), 256) << "Second thumbnail should be 256px";
 }
+
+TEST_F(ThumbnailCacheTest, MemoryTierHitAfterLoad) {
+    cache->clear();
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath("memory.png");
+    QImage image(100, 80, QImage::Format_RGB32);
+    image.fill(Qt::darkCyan);
+    ASSERT_TRUE(image.save(path));
+    EXPECT_TRUE(cache->cachedImage(path, QSize(64, 64)).isNull());
+    
+    QImage first = cache->thumbnailImage(path, QSize(64, 64));
+    QImage cached = cache->cachedImage(path, QSize(64, 64));
+    ASSERT_FALSE(cached.isNull()) << "Second lookup should hit the memory tier";
+    EXPECT_EQ(cached.size(), first.size());
+    
+    // Different size is a different entry
+    EXPECT_TRUE(cache->cachedImage(path, QSize(32, 32)).isNull());
+}
+
+TEST_F(ThumbnailCacheTest, PlaceholderIsNotCached) {
+    cache->clear();
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath("late.png");
+    
+    // Not there yet (share not mounted, copy under way): placeholder, not kept
+    EXPECT_FALSE(cache->thumbnailImage(path, QSize(64, 64)).isNull());
+    EXPECT_TRUE(cache->cachedImage(path, QSize(64, 64)).isNull());
+    
+    QImage image(100, 80, QImage::Format_RGB32);
+    image.fill(Qt::white);
+    ASSERT_TRUE(image.save(path));
+    const QImage thumbnail = cache->thumbnailImage(path, QSize(64, 64));
+    EXPECT_EQ(thumbnail.pixelColor(thumbnail.width() / 2, thumbnail.height() / 2), QColor(Qt::white));
+}
+
+TEST_F(ThumbnailCacheTest, RequestThumbnailEmitsReady) {
+    QSignalSpy spy(cache, &ThumbnailCache::thumbnailReady);
+    cache->requestThumbnail("/test/async.jpg", QSize(48, 48));
+    
+    ASSERT_TRUE(spy.count() > 0 || spy.wait(5000));
+    QList<QVariant> args = spy.takeFirst();
+    EXPECT_EQ(args.at(0).toString(), "/test/async.jpg");
+    EXPECT_EQ(args.at(1).toSize(), QSize(48, 48));
+    EXPECT_EQ(args.at(2).value<QImage>().width(), 48);
+}
+
+TEST_F(ThumbnailCacheTest, MemoryBudget) {
+    qint64 original = cache->memoryBudget();
+    cache->setMemoryBudget(8 * 1024 * 1024);
+    EXPECT_EQ(cache->memoryBudget(), 8 * 1024 * 1024);
+    cache->setMemoryBudget(original);
+}
+
+TEST_F(ThumbnailCacheTest, OfferedFrameServesRequestedSizes) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    QString path = dir.filePath("offered.png");
+    QImage file(200, 100, QImage::Format_RGB32);
+    file.fill(Qt::red);
+    ASSERT_TRUE(file.save(path));
+
+    cache->thumbnailImage("/test/sized.jpg", QSize(40, 40));  // A view asks for 40x40
+
+    // Another stage already decoded the file; the thumbnail comes from its frame
+    QImage frame(200, 100, QImage::Format_RGB32);
+    frame.fill(Qt::blue);
+    cache->offer(path, frame);
+
+    QImage thumbnail = cache->thumbnailImage(path, QSize(40, 40));
+    ASSERT_EQ(thumbnail.size(), QSize(40, 40));
+    EXPECT_EQ(thumbnail.pixelColor(20, 20), QColor(Qt::blue)) << "Not decoded again";
+
+    // Too small to serve a size without upscaling
+    cache->thumbnailImage("/test/sized.jpg", QSize(300, 300));
+    cache->offer(path, frame);
+    EXPECT_EQ(cache->thumbnailImage(path, QSize(300, 300)).pixelColor(150, 150), QColor(Qt::red));
+}
+
+TEST_F(ThumbnailCacheTest, DiskLocationMovesThePack) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    QString path = dir.filePath("disk.png");
+    QImage file(120, 80, QImage::Format_RGB32);
+    file.fill(Qt::green);
+    ASSERT_TRUE(file.save(path));
+
+    const QString pack = dir.filePath("cache/thumbnails.pack");
+    ASSERT_TRUE(cache->setDiskLocation(pack));
+    ASSERT_FALSE(cache->thumbnailImage(path, QSize(32, 32)).isNull());
+    EXPECT_TRUE(QFileInfo::exists(pack));
+
+    // Reopening the pack clears the memory tier
+    ASSERT_TRUE(cache->setDiskLocation(pack));
+    EXPECT_TRUE(cache->cachedImage(path, QSize(32, 32)).isNull());
+    EXPECT_EQ(cache->thumbnailImage(path, QSize(32, 32)).pixelColor(16, 16), QColor(Qt::green));
+
+    EXPECT_TRUE(cache->setDiskLocation(ThumbnailCache::defaultDiskLocation()));
+}
@@ -4,6 +4,8 @@
 #include <QSignalSpy>
 #include <QThreadPool>
 #include "../src/ui/ThumbnailGrid.h"
+#include "core/ThumbnailCache.h"
+#include <QDeadlineTimer>
 
 using namespace PhotoGuru;
 
@@ -25,6 +27,7 @@ protected:
         // Clear cache and wait for async tasks before deleting
         if (grid) {
             QThreadPool::globalInstance()->waitForDone();
+            ThumbnailCache::instance().clear();
             delete grid;
             grid = nullptr;
         }
@@ -125,3 +128,79 @@ TEST_F(ThumbnailGridTest, ClearByEmptyList) {
     QStringList empty;
     EXPECT_NO_THROW(grid->setImages(empty));
 }
+
+// Model reflects the image list and selection maps back to paths
+TEST_F(ThumbnailGridTest, SelectedFilesFromModel) {
+    QStringList images;
+    images << "/test/b.jpg" << "/test/a.jpg" << "/test/c.jpg";
+    grid->setImages(images);
+    
+    EXPECT_EQ(grid->count(), 3);
+    
+    grid->selectImage(0);
+    QStringList selected = grid->selectedFiles();
+    ASSERT_EQ(selected.size(), 1);
+    EXPECT_EQ(selected.first(), "/test/a.jpg") << "Sorted by name by default";
+}
+
+// Current index is exposed through the model for the delegate
+TEST_F(ThumbnailGridTest, CurrentIndexRole) {
+    QStringList images;
+    images << "/test/1.jpg" << "/test/2.jpg";
+    grid->setImages(images);
+    
+    grid->setCurrentIndex(1);
+    EXPECT_TRUE(grid->model()->index(1, 0).data(Qt::UserRole + 2).toBool());
+    EXPECT_FALSE(grid->model()->index(0, 0).data(Qt::UserRole + 2).toBool());
+}
+
+// Only the visible range + prefetch is requested, not the whole folder
+TEST_F(ThumbnailGridTest, HugeListOnlyLoadsVisibleRange) {
+    QStringList images;
+    for (int i = 0; i < 50000; i++) {
+        images << QString("/virtualized/img%1.jpg").arg(i, 5, 10, QChar('0'));
+    }
+    
+    grid->resize(600, 300);
+    grid->setImages(images);
+    EXPECT_EQ(grid->count(), 50000);
+    
+    ThumbnailCache& cache = ThumbnailCache::instance();
+    QSize size(grid->thumbnailSize(), grid->thumbnailSize());
+    
+    // First cell eventually lands in the memory tier (error placeholder for a missing file)
+    QDeadlineTimer deadline(5000);
+    while (cache.cachedImage(images.first(), size).isNull() && !deadline.hasExpired()) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+    }
+    EXPECT_FALSE(cache.cachedImage(images.first(), size).isNull());
+    
+    // Far end of the list was never requested
+    EXPECT_TRUE(cache.cachedImage(images.last(), size).isNull());
+    EXPECT_LT(grid->pendingRequestCount(), 1000);
+}
+
+// Filter changes arrive as row inserts/removes; surviving rows keep selection
+TEST_F(ThumbnailGridTest, UpdateImagesAppliesRowDiff) {
+    QStringList images;
+    images << "/test/a.jpg" << "/test/b.jpg" << "/test/c.jpg" << "/test/d.jpg";
+    grid->setImages(images);
+    grid->selectImage(2);  // c.jpg
+    
+    QSignalSpy resets(grid->model(), &QAbstractItemModel::modelReset);
+    QSignalSpy removed(grid->model(), &QAbstractItemModel::rowsRemoved);
+    QSignalSpy inserted(grid->model(), &QAbstractItemModel::rowsInserted);
+    
+    grid->updateImages(QStringList{"/test/c.jpg", "/test/a.jpg"});
+    EXPECT_EQ(grid->count(), 2);
+    EXPECT_EQ(resets.count(), 0);
+    EXPECT_EQ(removed.count(), 2) << "b and d are separate runs";
+    EXPECT_EQ(grid->selectedFiles(), QStringList{"/test/c.jpg"});
+    
+    grid->updateImages(images);
+    EXPECT_EQ(grid->count(), 4);
+    EXPECT_EQ(resets.count(), 0);
+    EXPECT_EQ(inserted.count(), 2);
+    EXPECT_EQ(grid->model()->index(1, 0).data(Qt::UserRole).toString(), "/test/b.jpg");
+    EXPECT_EQ(grid->selectedFiles(), QStringList{"/test/c.jpg"});
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include "ui/ThumbnailScheduler.h"
+#include "ui/ThumbnailModel.h"
+#include "core/ThumbnailCache.h"
+#include <QStringList>
+
+using namespace PhotoGuru;
+
+class ThumbnailSchedulerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        QStringList paths;
+        for (int i = 0; i < 1000; i++) {
+            paths << QString("/scheduler/%1/img%2.jpg").arg(testCounter).arg(i);
+        }
+        testCounter++;
+        model.setPaths(paths);
+        scheduler = new ThumbnailScheduler(&model);
+        scheduler->setThumbnailSize(QSize(96, 96));
+    }
+
+    void TearDown() override {
+        delete scheduler;
+        ThumbnailCache::instance().clear();
+    }
+
+    ThumbnailModel model;
+    ThumbnailScheduler* scheduler = nullptr;
+    static inline int testCounter = 0;
+};
+
+TEST_F(ThumbnailSchedulerTest, InitialWindowIsSymmetric) {
+    scheduler->updateWindow(100, 109);
+
+    EXPECT_EQ(scheduler->scrollDirection(), 0);
+    EXPECT_EQ(scheduler->priorityOf(105), ThumbnailScheduler::VisiblePriority);
+    EXPECT_EQ(scheduler->priorityOf(115), ThumbnailScheduler::AheadPriority);
+    EXPECT_EQ(scheduler->priorityOf(95), ThumbnailScheduler::AheadPriority);
+    EXPECT_EQ(scheduler->priorityOf(125), -1) << "Beyond one screen of prefetch";
+    EXPECT_EQ(scheduler->pendingCount(), 30);
+}
+
+TEST_F(ThumbnailSchedulerTest, ScrollingDownLeansPrefetchForward) {
+    scheduler->updateWindow(100, 109);
+    scheduler->updateWindow(110, 119);
+
+    EXPECT_EQ(scheduler->scrollDirection(), 1);
+    EXPECT_EQ(scheduler->priorityOf(115), ThumbnailScheduler::VisiblePriority)
+        << "Prefetched row scrolled into view is promoted";
+    EXPECT_EQ(scheduler->priorityOf(130), ThumbnailScheduler::AheadPriority);
+    EXPECT_EQ(scheduler->priorityOf(107), ThumbnailScheduler::BehindPriority)
+        << "Rows just passed are demoted";
+    EXPECT_EQ(scheduler->priorityOf(95), -1) << "Stale rows far behind are cancelled";
+    EXPECT_EQ(scheduler->priorityOf(139), ThumbnailScheduler::AheadPriority);
+    EXPECT_EQ(scheduler->priorityOf(140), -1);
+}
+
+TEST_F(ThumbnailSchedulerTest, ScrollingUpLeansPrefetchBackward) {
+    scheduler->updateWindow(500, 509);
+    scheduler->updateWindow(490, 499);
+
+    EXPECT_EQ(scheduler->scrollDirection(), -1);
+    EXPECT_EQ(scheduler->priorityOf(475), ThumbnailScheduler::AheadPriority);
+    EXPECT_EQ(scheduler->priorityOf(502), ThumbnailScheduler::BehindPriority);
+    EXPECT_EQ(scheduler->priorityOf(510), -1);
+}
+
+TEST_F(ThumbnailSchedulerTest, CancelAllResetsState) {
+    scheduler->updateWindow(0, 9);
+    scheduler->updateWindow(10, 19);
+    ASSERT_GT(scheduler->pendingCount(), 0);
+
+    scheduler->cancelAll();
+    EXPECT_EQ(scheduler->pendingCount(), 0);
+    EXPECT_EQ(scheduler->scrollDirection(), 0);
+}
+
+TEST_F(ThumbnailSchedulerTest, DeliveredRowIsNoLongerPending) {
+    scheduler->updateWindow(0, 9);
+    ASSERT_EQ(scheduler->priorityOf(3), ThumbnailScheduler::VisiblePriority);
+
+    scheduler->delivered(3);
+    EXPECT_EQ(scheduler->priorityOf(3), -1);
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include "core/ThumbnailStore.h"
+#include <QTemporaryDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QDir>
+#include <QImage>
+
+using namespace PhotoGuru;
+
+class ThumbnailStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(tempDir.isValid());
+        packPath = tempDir.filePath("thumbnails.pack");
+        sourcePath = tempDir.filePath("source.jpg");
+
+        QImage source(64, 48, QImage::Format_RGB32);
+        source.fill(Qt::green);
+        ASSERT_TRUE(source.save(sourcePath, "JPEG"));
+    }
+
+    QImage makeThumbnail(int size, QColor color) {
+        QImage thumb(size, size, QImage::Format_RGB32);
+        thumb.fill(color);
+        return thumb;
+    }
+
+    QTemporaryDir tempDir;
+    QString packPath;
+    QString sourcePath;
+};
+
+TEST_F(ThumbnailStoreTest, InsertAndFind) {
+    ThumbnailStore store;
+    ASSERT_TRUE(store.open(packPath));
+
+    ThumbnailStore::Key key = ThumbnailStore::makeKey(sourcePath, QSize(32, 32));
+    EXPECT_TRUE(store.find(key).isNull());
+
+    ASSERT_TRUE(store.insert(key, makeThumbnail(32, Qt::red)));
+    QImage found = store.find(key);
+    ASSERT_FALSE(found.isNull());
+    EXPECT_EQ(found.size(), QSize(32, 32));
+    EXPECT_EQ(found.pixelColor(10, 10), QColor(Qt::red));
+    EXPECT_EQ(store.count(), 1);
+}
+
+TEST_F(ThumbnailStoreTest, PersistsAcrossReopen) {
+    ThumbnailStore::Key small = ThumbnailStore::makeKey(sourcePath, QSize(16, 16));
+    ThumbnailStore::Key large = ThumbnailStore::makeKey(sourcePath, QSize(40, 40));
+
+    {
+        ThumbnailStore store;
+        ASSERT_TRUE(store.open(packPath));
+        ASSERT_TRUE(store.insert(small, makeThumbnail(16, Qt::blue)));
+        ASSERT_TRUE(store.insert(large, makeThumbnail(40, Qt::yellow)));
+    }
+
+    ThumbnailStore store;
+    ASSERT_TRUE(store.open(packPath));
+    EXPECT_EQ(store.count(), 2);
+    EXPECT_EQ(store.find(small).pixelColor(0, 0), QColor(Qt::blue));
+    EXPECT_EQ(store.find(large).pixelColor(39, 39), QColor(Qt::yellow));
+}
+
+TEST_F(ThumbnailStoreTest, KeyUsesFullPath) {
+    // Same file name in different folders must not collide
+    QString otherDir = tempDir.filePath("other");
+    ASSERT_TRUE(QDir().mkpath(otherDir));
+    QString otherPath = otherDir + "/source.jpg";
+    ASSERT_TRUE(QFile::copy(sourcePath, otherPath));
+
+    ThumbnailStore::Key a = ThumbnailStore::makeKey(sourcePath, QSize(32, 32));
+    ThumbnailStore::Key b = ThumbnailStore::makeKey(otherPath, QSize(32, 32));
+    EXPECT_FALSE(a == b);
+}
+
+TEST_F(ThumbnailStoreTest, ModifiedSourceMisses) {
+    ThumbnailStore store;
+    ASSERT_TRUE(store.open(packPath));
+
+    ThumbnailStore::Key before = ThumbnailStore::makeKey(sourcePath, QSize(32, 32));
+    ASSERT_TRUE(store.insert(before, makeThumbnail(32, Qt::red)));
+
+    // Rewrite with different content/size
+    QImage bigger(200, 150, QImage::Format_RGB32);
+    bigger.fill(Qt::white);
+    ASSERT_TRUE(bigger.save(sourcePath, "PNG"));
+
+    ThumbnailStore::Key after = ThumbnailStore::makeKey(sourcePath, QSize(32, 32));
+    EXPECT_TRUE(store.find(after).isNull()) << "Changed source should not hit stale entry";
+}
+
+TEST_F(ThumbnailStoreTest, TornTailIsDiscarded) {
+    ThumbnailStore::Key key = ThumbnailStore::makeKey(sourcePath, QSize(24, 24));
+    qint64 goodSize = 0;
+    {
+        ThumbnailStore store;
+        ASSERT_TRUE(store.open(packPath));
+        ASSERT_TRUE(store.insert(key, makeThumbnail(24, Qt::cyan)));
+        goodSize = store.packSize();
+    }
+
+    // Simulate a crash mid-append
+    {
+        QFile file(packPath);
+        ASSERT_TRUE(file.open(QIODevice::Append));
+        file.write(QByteArray(37, 'x'));
+    }
+
+    ThumbnailStore store;
+    ASSERT_TRUE(store.open(packPath));
+    EXPECT_EQ(store.count(), 1);
+    EXPECT_EQ(store.packSize(), goodSize);
+    EXPECT_EQ(store.find(key).pixelColor(5, 5), QColor(Qt::cyan));
+}
+
+TEST_F(ThumbnailStoreTest, GarbageFileIsReset) {
+    {
+        QFile file(packPath);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write("not a thumbnail pack at all");
+    }
+
+    ThumbnailStore store;
+    ASSERT_TRUE(store.open(packPath));
+    EXPECT_EQ(store.count(), 0);
+
+    ThumbnailStore::Key key = ThumbnailStore::makeKey(sourcePath, QSize(8, 8));
+    EXPECT_TRUE(store.insert(key, makeThumbnail(8, Qt::black)));
+    EXPECT_FALSE(store.find(key).isNull());
+}
+
+TEST_F(ThumbnailStoreTest, ImagesOutliveCloseAndReopen) {
+    ThumbnailStore store;
+    ASSERT_TRUE(store.open(packPath));
+
+    // Appends between lookups: each find() after one may need the file mapped again
+    QList<QImage> found;
+    for (int i = 0; i < 20; ++i) {
+        ThumbnailStore::Key key = ThumbnailStore::makeKey(sourcePath, QSize(32 + i, 32 + i));
+        ASSERT_TRUE(store.insert(key, makeThumbnail(32 + i, QColor(i * 10, 0, 0))));
+        found << store.find(key);
+        ASSERT_FALSE(found.last().isNull());
+    }
+
+    // The images keep their mappings through close() and open() of another pack
+    store.close();
+    ASSERT_TRUE(store.open(tempDir.filePath("other.pack")));
+    for (int i = 0; i < found.size(); ++i) {
+        EXPECT_EQ(found[i].pixelColor(4, 4), QColor(i * 10, 0, 0)) << i;
+    }
+}
+
+TEST_F(ThumbnailStoreTest, CloseTrimsTheReserve) {
+    qint64 packSize = 0;
+    {
+        ThumbnailStore store;
+        ASSERT_TRUE(store.open(packPath));
+        for (int i = 0; i < 5; ++i) {
+            ASSERT_TRUE(store.insert(ThumbnailStore::makeKey(sourcePath, QSize(16 + i, 16 + i)),
+                                     makeThumbnail(16 + i, Qt::blue)));
+        }
+        packSize = store.packSize();
+    }
+    EXPECT_EQ(QFileInfo(packPath).size(), packSize);
+
+    ThumbnailStore store;
+    ASSERT_TRUE(store.open(packPath));
+    EXPECT_EQ(store.count(), 5);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <QCoreApplication>
+#include <QSignalSpy>
+#include <QImage>
+#include "core/TilePyramid.h"
+
+using namespace PhotoGuru;
+
+class TilePyramidTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            int argc = 0;
+            char** argv = nullptr;
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    static QImage makeImage(int width, int height) {
+        QImage image(width, height, QImage::Format_RGB32);
+        image.fill(Qt::blue);
+        return image;
+    }
+
+    // Waits until `spy` has seen `level`
+    static bool waitFor(QSignalSpy& spy, int level) {
+        for (int attempt = 0; attempt < 50; ++attempt) {
+            for (const QList<QVariant>& args : spy) {
+                if (args[0].toInt() == level) return true;
+            }
+            spy.wait(100);
+        }
+        return false;
+    }
+};
+
+TEST_F(TilePyramidTest, HalvesUntilOneTile) {
+    TilePyramid pyramid;
+    EXPECT_TRUE(pyramid.isNull());
+
+    pyramid.setImage(makeImage(1000, 600));
+    ASSERT_EQ(pyramid.levelCount(), 3);
+    EXPECT_EQ(pyramid.levelSize(0), QSize(1000, 600));
+    EXPECT_EQ(pyramid.levelSize(1), QSize(500, 300));
+    EXPECT_EQ(pyramid.levelSize(2), QSize(250, 150));
+
+    // Partial last column and row
+    EXPECT_EQ(pyramid.columns(0), 4);
+    EXPECT_EQ(pyramid.rows(0), 3);
+    EXPECT_EQ(pyramid.tileRect(0, 3, 2), QRect(768, 512, 232, 88));
+}
+
+TEST_F(TilePyramidTest, PicksCoarsestLevelAboveZoom) {
+    TilePyramid pyramid;
+    pyramid.setImage(makeImage(1000, 600));
+
+    EXPECT_EQ(pyramid.levelForZoom(2.0), 0);
+    EXPECT_EQ(pyramid.levelForZoom(1.0), 0);
+    EXPECT_EQ(pyramid.levelForZoom(0.6), 0);
+    EXPECT_EQ(pyramid.levelForZoom(0.5), 1);
+    EXPECT_EQ(pyramid.levelForZoom(0.3), 1);
+    EXPECT_EQ(pyramid.levelForZoom(0.1), 2);
+}
+
+TEST_F(TilePyramidTest, BuildsLevelsInBackground) {
+    TilePyramid pyramid;
+    pyramid.setImage(makeImage(1000, 600));
+    QSignalSpy ready(&pyramid, &TilePyramid::levelReady);
+
+    EXPECT_TRUE(pyramid.isLevelReady(0));
+    EXPECT_FALSE(pyramid.isLevelReady(2));
+    EXPECT_TRUE(pyramid.tile(2, 0, 0).isNull());
+    EXPECT_EQ(pyramid.nearestReadyLevel(2), 0);
+
+    pyramid.requestLevel(2);
+    ASSERT_TRUE(waitFor(ready, 2));
+    EXPECT_TRUE(pyramid.isLevelReady(1));
+    EXPECT_EQ(pyramid.nearestReadyLevel(2), 2);
+    EXPECT_EQ(pyramid.tile(2, 0, 0).size(), QSize(250, 150));
+    EXPECT_EQ(pyramid.tile(0, 3, 2).size(), QSize(232, 88));
+    EXPECT_EQ(pyramid.cachedTiles(), 2);
+}
+
+TEST_F(TilePyramidTest, NewImageDropsStaleLevels) {
+    TilePyramid pyramid;
+    pyramid.setImage(makeImage(1000, 600));
+    pyramid.requestLevel(2);
+    pyramid.setImage(makeImage(300, 200));
+
+    QSignalSpy ready(&pyramid, &TilePyramid::levelReady);
+    pyramid.requestLevel(1);
+    ASSERT_TRUE(waitFor(ready, 1));
+    EXPECT_EQ(pyramid.levelCount(), 2);
+    EXPECT_EQ(pyramid.tile(1, 0, 0).size(), QSize(150, 100));
+    EXPECT_EQ(ready.count(), 1);  // Nothing from the first image
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include "core/TimelineIndex.h"
+#include "core/PhotoMetadata.h"
+#include <QElapsedTimer>
+
+using namespace PhotoGuru;
+
+class TimelineIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        add("/p/a.jpg", QDateTime(QDate(2023, 7, 14), QTime(10, 0)), "beach");
+        add("/p/b.jpg", QDateTime(QDate(2023, 7, 14), QTime(10, 5)), "beach");
+        add("/p/c.jpg", QDateTime(QDate(2023, 7, 14), QTime(18, 0)), "");
+        add("/p/d.jpg", QDateTime(QDate(2023, 7, 15), QTime(9, 0)), "beach");
+        add("/p/e.jpg", QDateTime(QDate(2023, 12, 31), QTime(23, 30)), "");
+        add("/p/f.jpg", QDateTime(QDate(2024, 1, 1), QTime(0, 10)), "party");
+        add("/p/undated.jpg", QDateTime(), "");
+    }
+
+    PhotoMetadata& add(const QString& path, const QDateTime& time, const QString& group) {
+        PhotoMetadata photo;
+        photo.filepath = path;
+        photo.datetime_original = time;
+        photo.group_id = group;
+        photos[path] = photo;
+        index.upsert(photo);
+        return photos[path];
+    }
+
+    static QList<QDate> dates(const QVector<TimelineIndex::Bucket>& buckets) {
+        QList<QDate> result;
+        for (const auto& bucket : buckets) result << bucket.date;
+        return result;
+    }
+
+    QHash<QString, PhotoMetadata> photos;
+    TimelineIndex index;
+};
+
+TEST_F(TimelineIndexTest, BucketsPerLevelNewestFirst) {
+    EXPECT_EQ(index.size(), 7);
+    EXPECT_EQ(index.undatedCount(), 1);
+
+    auto years = index.buckets(TimelineIndex::Level::Year);
+    ASSERT_EQ(years.size(), 2);
+    EXPECT_EQ(years[0].date, QDate(2024, 1, 1));
+    EXPECT_EQ(years[0].count, 1);
+    EXPECT_EQ(years[1].count, 5);
+    EXPECT_EQ(years[1].visible, 5);
+    EXPECT_EQ(years[1].start, QDateTime(QDate(2023, 7, 14), QTime(10, 0)));
+    EXPECT_EQ(years[1].end, QDateTime(QDate(2023, 12, 31), QTime(23, 30)));
+
+    EXPECT_EQ(dates(index.buckets(TimelineIndex::Level::Month)),
+              (QList<QDate>{QDate(2024, 1, 1), QDate(2023, 12, 1), QDate(2023, 7, 1)}));
+    EXPECT_EQ(dates(index.buckets(TimelineIndex::Level::Day)),
+              (QList<QDate>{QDate(2024, 1, 1), QDate(2023, 12, 31), QDate(2023, 7, 15), QDate(2023, 7, 14)}));
+
+    // Two events on the 14th: the ungrouped evening photo, then the morning at the beach
+    auto events = index.buckets(TimelineIndex::Level::Event, QDate(2023, 7, 14), QDate(2023, 7, 14));
+    ASSERT_EQ(events.size(), 2);
+    EXPECT_EQ(events[0].event, "");
+    EXPECT_EQ(events[1].event, "beach");
+    EXPECT_EQ(events[1].count, 2);
+    EXPECT_EQ(events[1].start.secsTo(events[1].end), 300);
+}
+
+TEST_F(TimelineIndexTest, ChildrenAndPhotos) {
+    auto years = index.buckets(TimelineIndex::Level::Year);
+    ASSERT_EQ(years.size(), 2);
+    auto months = index.children(years[1]);
+    EXPECT_EQ(dates(months), (QList<QDate>{QDate(2023, 12, 1), QDate(2023, 7, 1)}));
+
+    auto days = index.children(months[1]);
+    ASSERT_EQ(days.size(), 2);
+    EXPECT_EQ(index.photos(days[1]), (QStringList{"/p/a.jpg", "/p/b.jpg", "/p/c.jpg"}))
+        << "A day's photos in capture order across its events";
+
+    auto events = index.children(days[1]);
+    ASSERT_EQ(events.size(), 2);
+    EXPECT_EQ(index.photos(events[1]), (QStringList{"/p/a.jpg", "/p/b.jpg"}));
+    EXPECT_TRUE(index.children(events[1]).isEmpty());
+
+    EXPECT_EQ(index.photos(years[1]).size(), 5);
+}
+
+TEST_F(TimelineIndexTest, UpsertMovesAndRemoveDrops) {
+    // Non-time edits leave the buckets alone
+    quint64 revision = index.revision();
+    PhotoMetadata rated = photos["/p/a.jpg"];
+    rated.rating = 5;
+    index.upsert(rated);
+    EXPECT_EQ(index.revision(), revision);
+
+    PhotoMetadata moved = photos["/p/c.jpg"];
+    moved.datetime_original = QDateTime(QDate(2024, 1, 1), QTime(12, 0));
+    index.upsert(moved);
+    EXPECT_NE(index.revision(), revision);
+
+    auto years = index.buckets(TimelineIndex::Level::Year);
+    ASSERT_EQ(years.size(), 2);
+    EXPECT_EQ(years[0].count, 2);
+    EXPECT_EQ(years[1].count, 4);
+    EXPECT_EQ(years[0].end, moved.datetime_original);
+
+    index.remove("/p/e.jpg");
+    EXPECT_EQ(dates(index.buckets(TimelineIndex::Level::Month)),
+              (QList<QDate>{QDate(2024, 1, 1), QDate(2023, 7, 1)})) << "Empty December is gone";
+
+    index.remove("/p/undated.jpg");
+    EXPECT_EQ(index.undatedCount(), 0);
+    EXPECT_EQ(index.size(), 5);
+
+    index.clear();
+    EXPECT_TRUE(index.buckets(TimelineIndex::Level::Year).isEmpty());
+}
+
+TEST_F(TimelineIndexTest, FilterMasksBucketsInPlace) {
+    index.setVisible({"/p/b.jpg", "/p/e.jpg"});
+
+    auto years = index.buckets(TimelineIndex::Level::Year);
+    ASSERT_EQ(years.size(), 1) << "2024 has nothing visible";
+    EXPECT_EQ(years[0].count, 5);
+    EXPECT_EQ(years[0].visible, 2);
+    EXPECT_EQ(years[0].start, QDateTime(QDate(2023, 7, 14), QTime(10, 5)));
+    EXPECT_EQ(index.photos(years[0]), (QStringList{"/p/b.jpg", "/p/e.jpg"}));
+
+    auto events = index.buckets(TimelineIndex::Level::Event, QDate(2023, 7, 14), QDate(2023, 7, 14));
+    ASSERT_EQ(events.size(), 1);
+    EXPECT_EQ(events[0].event, "beach");
+    EXPECT_EQ(events[0].start, events[0].end);
+
+    // Photos added while filtered show up until the next filter result
+    add("/p/g.jpg", QDateTime(QDate(2024, 2, 1), QTime(8, 0)), "");
+    EXPECT_EQ(index.buckets(TimelineIndex::Level::Year).size(), 2);
+
+    index.clearFilter();
+    years = index.buckets(TimelineIndex::Level::Year);
+    ASSERT_EQ(years.size(), 2);
+    EXPECT_EQ(years[0].visible, 2);
+    EXPECT_EQ(years[1].visible, 5);
+}
+
+TEST_F(TimelineIndexTest, DateRangeSelectsOverlappingBuckets) {
+    EXPECT_EQ(index.buckets(TimelineIndex::Level::Day, QDate(2023, 7, 1), QDate(2023, 7, 31)).size(), 2);
+    EXPECT_EQ(index.buckets(TimelineIndex::Level::Month, QDate(2023, 12, 15), QDate(2024, 1, 15)).size(), 2);
+    EXPECT_EQ(index.buckets(TimelineIndex::Level::Year, QDate(2024, 6, 1)).size(), 1);
+    EXPECT_TRUE(index.buckets(TimelineIndex::Level::Day, QDate(2024, 1, 2), QDate(2023, 1, 1)).isEmpty());
+}
+
+TEST_F(TimelineIndexTest, TenYearsScrubsByBucket) {
+    TimelineIndex large;
+    const QDate first(2015, 1, 1);
+    int count = 0;
+    for (int day = 0; day < 3653; day++) {
+        for (int i = 0; i < 10; i++) {
+            PhotoMetadata photo;
+            photo.filepath = QString("/big/%1.jpg").arg(count++);
+            photo.datetime_original = QDateTime(first.addDays(day), QTime(9 + i, 0));
+            photo.group_id = i < 5 ? "morning" : "";
+            large.upsert(photo);
+        }
+    }
+    EXPECT_EQ(large.size(), 36530);
+
+    QElapsedTimer timer;
+    timer.start();
+    auto years = large.buckets(TimelineIndex::Level::Year);
+    auto months = large.buckets(TimelineIndex::Level::Month, QDate(2020, 1, 1), QDate(2020, 12, 31));
+    qint64 elapsed = timer.elapsed();
+
+    EXPECT_EQ(years.size(), 10);
+    EXPECT_EQ(months.size(), 12);
+    EXPECT_EQ(months[0].count, 310);
+    // Generous bound so slow CI machines don't flake; typical is well under 1 ms
+    EXPECT_LT(elapsed, 50) << "Year and month buckets took " << elapsed << "ms";
+}
@@ -4,6 +4,10 @@
 #include <QApplication>
 #include <QTest>
 #include <QSignalSpy>
+#include <QMouseEvent>
+#include <QAbstractScrollArea>
+#include <QDeadlineTimer>
+#include "core/ThumbnailCache.h"
 
 using namespace PhotoGuru;
 
@@ -166,7 +170,7 @@ TEST_F(TimelineViewTest, EventDuration) {
     group.event_type = "vacation";
     group.start_time = QDateTime::currentDateTime();
     group.end_time = group.start_time.addSecs(3600 * 4);  // 4 hours
-    group.photos = burstPhotos;
+    group.photos = {0, 1, 2};
     group.duration_minutes = 240;
     
     EXPECT_EQ(group.duration_minutes, 240) << "Event duration should be calculated";
@@ -247,25 +251,135 @@ TEST_F(TimelineViewTest, MultiYearTimeline) {
     SUCCEED() << "Should display multi-year timeline with year headers";
 }
 
-TEST_F(TimelineViewTest, TimelineGroupWidget) {
-    // Test TimelineGroupWidget component
-    TimelineGroup group;
-    group.group_id = "test_group";
-    group.event_type = "test";
-    group.summary = "Test event";
-    group.start_time = QDateTime::currentDateTime();
-    group.end_time = group.start_time.addSecs(3600);
-    group.photos = testPhotos;
-    group.duration_minutes = 60;
-    
-    TimelineGroupWidget* widget = new TimelineGroupWidget(group);
-    EXPECT_NE(widget, nullptr) << "TimelineGroupWidget should be created";
-    
-    delete widget;
+TEST_F(TimelineViewTest, TimelineDelegate) {
+    // Cards are painted by TimelineDelegate; more photos, taller card
+    TimelineModel model;
+    QList<PhotoMetadata> photos = testPhotos;
+    for (PhotoMetadata& photo : photos) photo.group_id = "small";
+    for (int i = 0; i < 9; i++) {
+        PhotoMetadata photo;
+        photo.filepath = QString("/test/large_%1.jpg").arg(i);
+        photo.group_id = "large";
+        photo.datetime_original = testPhotos[0].datetime_original.addDays(-3).addSecs(i * 60);
+        photos << photo;
+    }
+    model.setPhotos(makePhotoHandles(photos));
+    ASSERT_EQ(model.rowCount(), 2);
+
+    TimelineDelegate delegate;
+    QStyleOptionViewItem option;
+    QSize small = delegate.sizeHint(option, model.index(0));
+    QSize large = delegate.sizeHint(option, model.index(1));
+    EXPECT_GT(small.height(), 0);
+    EXPECT_GT(large.height(), small.height()) << "A \"+N more\" bar below six previews";
 }
 
 TEST_F(TimelineViewTest, ScrollArea) {
     // TimelineView should have scroll area
-    auto scrollAreas = timelineView->findChildren<QScrollArea*>();
-    EXPECT_GT(scrollAreas.size(), 0) << "Should have QScrollArea for scrolling";
+    auto scrollAreas = timelineView->findChildren<QAbstractScrollArea*>();
+    EXPECT_GT(scrollAreas.size(), 0) << "Should have a scrolling list view";
+}
+
+TEST_F(TimelineViewTest, GroupsReferToPhotosByIndex) {
+    QList<PhotoMetadata> photos = testPhotos + burstPhotos;
+    photos[0].group_id = "morning";
+    photos[1].group_id = "morning";
+    photos[0].group_context["event_type"] = "walk";
+    photos[0].group_context["summary"] = "Early walk";
+    for (int i = 5; i < 8; i++) photos[i].group_id = "burst";
+    
+    timelineView->loadPhotos(photos);
+    ASSERT_EQ(timelineView->groupCount(), 3);
+    
+    // Newest first: the burst is a day later than everything else
+    const TimelineModel* model = timelineView->model();
+    EXPECT_EQ(model->group(0).group_id, "burst");
+    EXPECT_EQ(model->group(0).photos, (QVector<int>{5, 6, 7}));
+    EXPECT_EQ(model->group(0).duration_minutes, 0);
+    
+    int morning = model->group(1).group_id == "morning" ? 1 : 2;
+    EXPECT_EQ(model->group(morning).photos, (QVector<int>{0, 1}));
+    EXPECT_EQ(model->group(morning).event_type, "walk");
+    EXPECT_EQ(model->group(morning).duration_minutes, 60);
+    EXPECT_EQ(model->index(morning).data(TimelineModel::SummaryRole).toString(), "Early walk");
+    EXPECT_EQ(model->group(3 - morning).group_id, "ungrouped");
+    EXPECT_EQ(model->photo(model->group(3 - morning).photos.first()).filepath, "/test/photo_2.jpg");
+}
+
+TEST_F(TimelineViewTest, HoldsCatalogHandlesWithoutCopying) {
+    QList<PhotoHandle> handles = makePhotoHandles(testPhotos);
+    timelineView->loadPhotos(handles);
+    
+    // The model's photos are the catalog's objects, not copies of them
+    const TimelineModel* model = timelineView->model();
+    for (int i = 0; i < handles.size(); i++) {
+        EXPECT_EQ(&model->photo(i), handles[i].get());
+    }
+}
+
+TEST_F(TimelineViewTest, NoWidgetsPerGroup) {
+    timelineView->loadPhotos(testPhotos);
+    int widgets = timelineView->findChildren<QWidget*>().size();
+    
+    QList<PhotoMetadata> many;
+    for (int i = 0; i < 2000; i++) {
+        PhotoMetadata photo;
+        photo.filepath = QString("/test/many_%1.jpg").arg(i);
+        photo.group_id = QString("group_%1").arg(i / 4);
+        photo.datetime_original = QDateTime(QDate(2020, 1, 1), QTime(12, 0)).addSecs(i * 600);
+        many << photo;
+    }
+    timelineView->loadPhotos(many);
+    EXPECT_EQ(timelineView->groupCount(), 500);
+    EXPECT_EQ(timelineView->findChildren<QWidget*>().size(), widgets);
+}
+
+// Only cards on screen (+ prefetch) request their previews
+TEST_F(TimelineViewTest, OnlyVisibleCardsRequestThumbnails) {
+    QList<PhotoMetadata> many;
+    for (int i = 0; i < 3000; i++) {
+        PhotoMetadata photo;
+        photo.filepath = QString("/virtualized/timeline_%1.jpg").arg(i, 4, 10, QChar('0'));
+        photo.group_id = QString("group_%1").arg(i / 3, 4, 10, QChar('0'));
+        photo.datetime_original = QDateTime(QDate(2020, 1, 1), QTime(12, 0)).addSecs(-i * 3600);
+        many << photo;
+    }
+    
+    timelineView->resize(600, 400);
+    timelineView->loadPhotos(many);
+    
+    ThumbnailCache& cache = ThumbnailCache::instance();
+    const QSize size(TimelineModel::THUMBNAIL_SIZE, TimelineModel::THUMBNAIL_SIZE);
+    
+    // Newest card's first preview lands in the memory tier (error placeholder for a missing file)
+    QDeadlineTimer deadline(5000);
+    while (cache.cachedImage(many.first().filepath, size).isNull() && !deadline.hasExpired()) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+    }
+    EXPECT_FALSE(cache.cachedImage(many.first().filepath, size).isNull());
+    
+    // Oldest card was never requested
+    EXPECT_TRUE(cache.cachedImage(many.last().filepath, size).isNull());
+    EXPECT_LT(timelineView->pendingThumbnailCount(), 100);
+}
+
+TEST_F(TimelineViewTest, PreviewClickSelectsPhoto) {
+    TimelineModel model;
+    model.setPhotos(makePhotoHandles(testPhotos));
+    TimelineDelegate delegate;
+    QSignalSpy photos(&delegate, &TimelineDelegate::photoClicked);
+    QSignalSpy groups(&delegate, &TimelineDelegate::groupClicked);
+    
+    QStyleOptionViewItem option;
+    option.rect = QRect(QPoint(0, 0), delegate.sizeHint(option, model.index(0)));
+    
+    // First preview sits at the card's top-left below the header; bottom-left is empty space
+    for (int y = 0; y < option.rect.height() && photos.isEmpty(); y += 4) {
+        QMouseEvent click(QEvent::MouseButtonRelease, QPointF(40, y), QPointF(40, y),
+                          Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+        delegate.editorEvent(&click, &model, option, model.index(0));
+    }
+    ASSERT_EQ(photos.count(), 1);
+    EXPECT_EQ(photos.first().first().toString(), model.previewPaths(0).first());
+    EXPECT_EQ(groups.count(), 0) << "Every photo is previewed, so there is no \"more\" bar";
 }
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include "core/Trace.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QSet>
+#include <thread>
+
+using namespace PhotoGuru;
+
+namespace {
+
+// Tracing is process-wide; every test starts enabled and empty, and
+// leaves it off for the rest of the suite
+class TraceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        Trace::clear();
+        Trace::setEnabled(true);
+    }
+    void TearDown() override {
+        Trace::setEnabled(false);
+        Trace::clear();
+    }
+
+    static QJsonArray events() {
+        return QJsonDocument::fromJson(Trace::chromeTrace()).object()["traceEvents"].toArray();
+    }
+};
+
+} // namespace
+
+TEST_F(TraceTest, MetricIsCreatedOncePerName) {
+    TraceMetric& a = Trace::metric("test.once", TraceMetric::Counter);
+    TraceMetric& b = Trace::metric("test.once", TraceMetric::Counter);
+    EXPECT_EQ(&a, &b);
+}
+
+TEST_F(TraceTest, TimerPercentilesFollowTheSamples) {
+    TraceMetric& timer = Trace::metric("test.percentiles", TraceMetric::Timer);
+    for (int i = 0; i < 99; i++) timer.record(1000000);   // 1 ms
+    timer.record(100000000);                               // 100 ms
+
+    EXPECT_EQ(timer.count(), 100);
+    EXPECT_NEAR(timer.percentileMs(50), 1.0, 0.125);
+    EXPECT_NEAR(timer.percentileMs(99), 1.0, 0.125);
+    EXPECT_NEAR(timer.percentileMs(100), 100.0, 12.5);
+
+    QJsonObject json = timer.toJson();
+    EXPECT_EQ(json["kind"].toString(), "timer");
+    EXPECT_NEAR(json["max_ms"].toDouble(), 100.0, 1e-9);
+}
+
+TEST_F(TraceTest, HitAndMissCountersGiveARatio) {
+    Trace::metric("test.cache.hit", TraceMetric::Counter).add(3);
+    Trace::metric("test.cache.miss", TraceMetric::Counter).add(1);
+
+    QJsonObject metrics = Trace::metrics();
+    EXPECT_EQ(metrics["test.cache.hit"].toObject()["value"].toInt(), 3);
+    EXPECT_DOUBLE_EQ(metrics["test.cache.hit_ratio"].toDouble(), 0.75);
+}
+
+TEST_F(TraceTest, GaugeKeepsLastValueAndHighWaterMark) {
+    TraceMetric& gauge = Trace::metric("test.queue", TraceMetric::Gauge);
+    Trace::gauge(gauge, 5);
+    Trace::gauge(gauge, 2);
+
+    EXPECT_EQ(gauge.value(), 2);
+    EXPECT_EQ(gauge.toJson()["max"].toInt(), 5);
+}
+
+TEST_F(TraceTest, ScopesBecomeCompleteEventsPerThread) {
+    TraceMetric& metric = Trace::metric("test.scope", TraceMetric::Timer);
+    { TraceScope scope(metric); }
+    std::thread([&metric]() { TraceScope scope(metric); }).join();
+
+    EXPECT_EQ(metric.count(), 2);
+
+    QSet<int> threads;
+    int spans = 0;
+    for (const QJsonValue& value : events()) {
+        QJsonObject event = value.toObject();
+        if (event["ph"].toString() == "X" && event["name"].toString() == "test.scope") {
+            EXPECT_EQ(event["cat"].toString(), "test");
+            EXPECT_GE(event["dur"].toDouble(), 0.0);
+            threads << event["tid"].toInt();
+            spans++;
+        }
+    }
+    EXPECT_EQ(spans, 2);
+    EXPECT_EQ(threads.size(), 2);
+}
+
+TEST_F(TraceTest, RingKeepsTheNewestEvents) {
+    TraceMetric& metric = Trace::metric("test.ring", TraceMetric::Timer);
+    for (int i = 0; i < Trace::RING_CAPACITY + 10; i++) Trace::span(metric, Trace::now(), i);
+
+    int spans = 0;
+    double smallest = -1;
+    for (const QJsonValue& value : events()) {
+        QJsonObject event = value.toObject();
+        if (event["name"].toString() != "test.ring") continue;
+        if (smallest < 0 || event["dur"].toDouble() < smallest) smallest = event["dur"].toDouble();
+        spans++;
+    }
+    EXPECT_EQ(spans, Trace::RING_CAPACITY);
+    EXPECT_NEAR(smallest, 10 / 1000.0, 1e-9);  // The first ten were overwritten
+}
+
+TEST_F(TraceTest, DisabledScopesRecordNothing) {
+    Trace::setEnabled(false);
+    TraceMetric& metric = Trace::metric("test.disabled", TraceMetric::Timer);
+    { TraceScope scope(metric); }
+
+    EXPECT_EQ(metric.count(), 0);
+    for (const QJsonValue& value : events()) {
+        EXPECT_NE(value.toObject()["name"].toString(), "test.disabled");
+    }
+}
+
+TEST_F(TraceTest, WritesLoadableTraceFile) {
+    { TraceScope scope(Trace::metric("test.file", TraceMetric::Timer)); }
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+    const QString path = dir.filePath("trace.json");
+    ASSERT_TRUE(Trace::writeChromeTrace(path));
+
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    ASSERT_EQ(error.error, QJsonParseError::NoError) << qPrintable(error.errorString());
+    EXPECT_TRUE(doc.object()["metrics"].toObject().contains("test.file"));
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "ml/VectorSearch.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace PhotoGuru;
+
+namespace {
+
+std::vector<float> randomUnitRows(int rows, int dim, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal;
+    std::vector<float> matrix(size_t(rows) * size_t(dim));
+    for (int r = 0; r < rows; ++r) {
+        float* row = matrix.data() + size_t(r) * size_t(dim);
+        float norm = 0.0f;
+        for (int i = 0; i < dim; ++i) {
+            row[i] = normal(rng);
+            norm += row[i] * row[i];
+        }
+        norm = std::sqrt(norm);
+        for (int i = 0; i < dim; ++i) row[i] /= norm;
+    }
+    return matrix;
+}
+
+} // namespace
+
+TEST(VectorSearchTest, DotMatchesScalar) {
+    std::vector<float> data = randomUnitRows(2, 515, 7);  // Odd size exercises the tail
+    for (int dim : {1, 3, 16, 31, 64, 512, 515}) {
+        EXPECT_NEAR(VectorSearch::dot(data.data(), data.data() + 515, dim),
+                    VectorSearch::dotScalar(data.data(), data.data() + 515, dim), 1e-5f)
+            << "dim " << dim;
+    }
+}
+
+TEST(VectorSearchTest, TopKIsPartialSelection) {
+    std::vector<float> scores = {0.1f, 0.9f, 0.5f, 0.9f, -0.2f, 0.7f};
+
+    auto hits = VectorSearch::topK(scores.data(), int(scores.size()), 3);
+    ASSERT_EQ(hits.size(), 3u);
+    EXPECT_EQ(hits[0].id, 1);  // Tie keeps the lower id first
+    EXPECT_EQ(hits[1].id, 3);
+    EXPECT_EQ(hits[2].id, 5);
+    EXPECT_FLOAT_EQ(hits[2].score, 0.7f);
+
+    EXPECT_EQ(VectorSearch::topK(scores.data(), int(scores.size()), 10).size(), scores.size());
+    EXPECT_TRUE(VectorSearch::topK(scores.data(), int(scores.size()), 0).empty());
+}
+
+TEST(VectorSearchTest, ExactSearchMatchesFullSort) {
+    const int rows = 2000, dim = 64;
+    std::vector<float> matrix = randomUnitRows(rows, dim, 11);
+    const float* query = matrix.data() + 42 * dim;
+
+    auto hits = VectorSearch::exactSearch(query, matrix.data(), rows, dim, 10);
+
+    std::vector<std::pair<float, int>> all;
+    for (int r = 0; r < rows; ++r) {
+        all.emplace_back(VectorSearch::dotScalar(query, matrix.data() + r * dim, dim), r);
+    }
+    std::sort(all.begin(), all.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    ASSERT_EQ(hits.size(), 10u);
+    EXPECT_EQ(hits[0].id, 42);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(hits[size_t(i)].id, all[size_t(i)].second) << "rank " << i;
+    }
+}
+
+TEST(VectorSearchTest, Int8DotMatchesScalar) {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> code(-127, 127);
+    for (int dim : {1, 15, 16, 33, 64, 512, 515}) {
+        const int rows = 7;  // One block of four and a tail
+        std::vector<int8_t> codes(size_t(rows + 1) * size_t(dim));
+        for (int8_t& c : codes) c = int8_t(code(rng));
+        const int8_t* query = codes.data() + size_t(rows) * size_t(dim);
+
+        std::vector<float> scales(static_cast<size_t>(rows), 0.5f);
+        std::vector<float> scores(static_cast<size_t>(rows));
+        VectorSearch::dotRowsInt8(query, 2.0f, codes.data(), scales.data(), rows, dim, scores.data());
+        for (int r = 0; r < rows; ++r) {
+            const int32_t expected = VectorSearch::dotInt8Scalar(query, codes.data() + size_t(r) * dim, dim);
+            EXPECT_EQ(VectorSearch::dotInt8(query, codes.data() + size_t(r) * dim, dim), expected)
+                << "dim " << dim << " row " << r;
+            EXPECT_FLOAT_EQ(scores[size_t(r)], float(expected)) << "dim " << dim << " row " << r;
+        }
+    }
+}
+
+TEST(VectorSearchTest, QuantizedScanRescoresToExactOrder) {
+    const int rows = 2000, dim = 512;
+    std::vector<float> matrix = randomUnitRows(rows, dim, 13);
+    std::vector<int8_t> codes(size_t(rows) * size_t(dim));
+    std::vector<float> scales(static_cast<size_t>(rows));
+    for (int r = 0; r < rows; ++r) {
+        scales[size_t(r)] = VectorSearch::quantize(matrix.data() + size_t(r) * dim, dim,
+                                                   codes.data() + size_t(r) * dim);
+    }
+    const float* query = matrix.data() + 7 * dim;
+    const int8_t* queryCodes = codes.data() + 7 * dim;
+
+    std::vector<float> approx(static_cast<size_t>(rows));
+    VectorSearch::dotRowsInt8(queryCodes, scales[7], codes.data(), scales.data(), rows, dim, approx.data());
+    for (int r = 0; r < rows; ++r) {
+        EXPECT_NEAR(approx[size_t(r)], VectorSearch::dotScalar(query, matrix.data() + size_t(r) * dim, dim), 0.02f);
+    }
+
+    auto candidates = VectorSearch::topK(approx.data(), rows, 40);
+    auto hits = VectorSearch::rescore(query, matrix.data(), dim, candidates, 10);
+    auto exact = VectorSearch::exactSearch(query, matrix.data(), rows, dim, 10);
+    ASSERT_EQ(hits.size(), 10u);
+    for (size_t i = 0; i < hits.size(); ++i) {
+        EXPECT_EQ(hits[i].id, exact[i].id) << "rank " << i;
+        EXPECT_FLOAT_EQ(hits[i].score, exact[i].score);
+    }
+
+    std::vector<int8_t> zeros(static_cast<size_t>(dim));
+    std::vector<float> zero(size_t(dim), 0.0f);
+    EXPECT_EQ(VectorSearch::quantize(zero.data(), dim, zeros.data()), 0.0f);
+}
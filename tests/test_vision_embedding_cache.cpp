@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include "ml/VisionEmbeddingCache.h"
+#include <QTemporaryDir>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+
+using namespace PhotoGuru;
+
+class VisionEmbeddingCacheTest : public ::testing::Test {
+protected:
+    static QImage image(QColor color) {
+        QImage rgb(16, 12, QImage::Format_RGB888);
+        rgb.fill(color);
+        return rgb;
+    }
+
+    static std::vector<float> embedding(size_t floats, float base) {
+        std::vector<float> v(floats);
+        for (size_t i = 0; i < floats; ++i) v[i] = base + float(i);
+        return v;
+    }
+
+    QTemporaryDir tempDir;
+};
+
+TEST_F(VisionEmbeddingCacheTest, ImageKeyFollowsPixels) {
+    QByteArray red = VisionEmbeddingCache::imageKey(image(Qt::red));
+    EXPECT_EQ(red, VisionEmbeddingCache::imageKey(image(Qt::red)));
+    EXPECT_NE(red, VisionEmbeddingCache::imageKey(image(Qt::blue)));
+
+    QImage edited = image(Qt::red);
+    edited.setPixelColor(3, 4, Qt::green);
+    EXPECT_NE(red, VisionEmbeddingCache::imageKey(edited));
+}
+
+TEST_F(VisionEmbeddingCacheTest, MemoryHitAndLruEviction) {
+    // Room for two entries of 256 KB
+    VisionEmbeddingCache cache(qint64(600) * 1024);
+    const size_t floats = 64 * 1024;
+
+    cache.insert("a", embedding(floats, 1.0f));
+    cache.insert("b", embedding(floats, 2.0f));
+    ASSERT_TRUE(cache.find("a").has_value());  // a is now most recent
+    cache.insert("c", embedding(floats, 3.0f));
+
+    EXPECT_EQ(cache.count(), 2);
+    EXPECT_FALSE(cache.find("b").has_value());
+    auto a = cache.find("a");
+    ASSERT_TRUE(a.has_value());
+    EXPECT_EQ(*a, embedding(floats, 1.0f));
+}
+
+TEST_F(VisionEmbeddingCacheTest, DiskEntriesSurviveRestart) {
+    ASSERT_TRUE(tempDir.isValid());
+    {
+        VisionEmbeddingCache cache;
+        cache.setModelId("mmproj-a");
+        cache.setDiskDirectory(tempDir.path());
+        cache.insert("key", embedding(32, 5.0f));
+    }
+
+    VisionEmbeddingCache reopened;
+    reopened.setModelId("mmproj-a");
+    reopened.setDiskDirectory(tempDir.path());
+    auto stored = reopened.find("key");
+    ASSERT_TRUE(stored.has_value());
+    EXPECT_EQ(*stored, embedding(32, 5.0f));
+
+    reopened.setModelId("mmproj-b");
+    EXPECT_EQ(reopened.count(), 0) << "Switching projector drops the memory tier";
+    EXPECT_FALSE(reopened.find("key").has_value()) << "Other projector's outputs are not reused";
+}
+
+TEST_F(VisionEmbeddingCacheTest, TruncatedDiskEntryIsDiscarded) {
+    ASSERT_TRUE(tempDir.isValid());
+    VisionEmbeddingCache cache;
+    cache.setModelId("m");
+    cache.setDiskDirectory(tempDir.path());
+    cache.insert("key", embedding(32, 1.0f));
+
+    QString path = tempDir.filePath("m/key.emb");
+    QFile file(path);
+    ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+    ASSERT_TRUE(file.resize(file.size() - 8));
+    file.close();
+
+    VisionEmbeddingCache reopened;
+    reopened.setModelId("m");
+    reopened.setDiskDirectory(tempDir.path());
+    EXPECT_FALSE(reopened.find("key").has_value());
+    EXPECT_FALSE(QFile::exists(path));
+}